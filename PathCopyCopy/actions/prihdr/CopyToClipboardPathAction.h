@@ -33,18 +33,29 @@ namespace PCC
         //
         // CopyToClipboardPathAction
         //
-        // Path action that copies all paths to the clipboard.
+        // Path action that copies all paths to the clipboard. Can optionally
+        // copy paths in multiple formats at once (text, HTML links and files).
         //
         class CopyToClipboardPathAction final : public PCC::PathAction
         {
         public:
-                                    CopyToClipboardPathAction() = default;
+            explicit                CopyToClipboardPathAction(const bool p_MultipleFormats = false);
                                     CopyToClipboardPathAction(const CopyToClipboardPathAction&) = delete;
             CopyToClipboardPathAction&
                                     operator=(const CopyToClipboardPathAction&) = delete;
 
             virtual void            Act(const std::wstring& p_Paths,
                                         const HWND          p_hWnd) const override;
+            virtual void            ActOnWrittenPaths(const WStringV&               p_vPaths,
+                                                      const std::wstring::size_type p_PathsSize,
+                                                      const PathsWriter&            p_PathsWriter,
+                                                      const HWND                    p_hWnd) const override;
+            virtual void            ActLater(const PathsProducer& p_PathsProducer,
+                                             const HWND           p_hWnd) const override;
+            virtual bool            CanFailVisibly() const override;
+
+        private:
+            bool                    m_MultipleFormats;  // Whether to copy paths in HTML and file formats as well as text.
         };
 
         //
@@ -24,6 +24,7 @@
 #include <PathAction.h>
 
 #include <exception>
+#include <string>
 
 
 namespace PCC
@@ -38,18 +39,60 @@ namespace PCC
         class LaunchExecutablePathAction final : public PCC::PathAction
         {
         public:
-                                    LaunchExecutablePathAction(const std::wstring& p_Executable,
-                                                               const bool          p_UseFilelist);
+            // Possible encodings of filelists. Values are stored in pipelines, don't change them.
+            enum class FilelistEncoding {
+                Ansi    = 0,    // Encoded using the system's ANSI code page
+                UTF8    = 1,    // Encoded in UTF-8, without BOM
+                UTF16LE = 2,    // Encoded in UTF-16LE, with BOM
+            };
+
+            // Possible ways to deliver filelists to the executable. Values are stored in pipelines, don't change them.
+            enum class FilelistDelivery {
+                TempFile    = 0,    // Filelist is written to a temporary file whose path is passed as argument
+                StdinPipe   = 1,    // Filelist is written to the executable's standard input through a pipe
+            };
+
+            // Possible endpoints used to send paths to a running instance of the executable. Values are stored in pipelines, don't change them.
+            enum class InstanceEndpoint {
+                None        = 0,    // Always launch a new instance of the executable
+                NamedPipe   = 1,    // Paths are written to a named pipe opened by the running instance
+                WindowClass = 2,    // Paths are sent via WM_COPYDATA to a window of the running instance, identified by class name
+            };
+
+                                    LaunchExecutablePathAction(const std::wstring&    p_Executable,
+                                                               const bool             p_UseFilelist,
+                                                               const FilelistEncoding p_FilelistEncoding = FilelistEncoding::Ansi,
+                                                               const FilelistDelivery p_FilelistDelivery = FilelistDelivery::TempFile,
+                                                               const size_t           p_MaxParallelBatches = 0,
+                                                               const InstanceEndpoint p_InstanceEndpoint = InstanceEndpoint::None,
+                                                               const std::wstring&    p_InstanceEndpointName = std::wstring());
                                     LaunchExecutablePathAction(const LaunchExecutablePathAction&) = delete;
             LaunchExecutablePathAction&
                                     operator=(const LaunchExecutablePathAction&) = delete;
 
             virtual void            Act(const std::wstring& p_Paths,
                                         const HWND          p_hWnd) const override;
+            virtual void            ActOnWrittenPaths(const WStringV&               p_vPaths,
+                                                      const std::wstring::size_type p_PathsSize,
+                                                      const PathsWriter&            p_PathsWriter,
+                                                      const HWND                    p_hWnd) const override;
 
         private:
-            std::wstring            m_Executable;   // Name of executable to launch.
-            bool                    m_UseFilelist;  // Whether to use a filelist.txt file instead of passing paths directly.
+            std::wstring            m_Executable;       // Name of executable to launch.
+            bool                    m_UseFilelist;      // Whether to use a filelist.txt file instead of passing paths directly.
+            FilelistEncoding        m_FilelistEncoding; // Encoding of filelist, if used.
+            FilelistDelivery        m_FilelistDelivery; // How filelist is delivered to the executable, if used.
+            size_t                  m_MaxParallelBatches;
+                                                        // Max number of batches to run at once when splitting paths in batches (0 to disable).
+            InstanceEndpoint        m_InstanceEndpoint; // Endpoint used to send paths to a running instance, if any.
+            std::wstring            m_InstanceEndpointName;
+                                                        // Name of pipe or window class used to reach a running instance.
+
+            std::wstring            WriteFilelist(const std::wstring& p_Paths) const;
+            void                    LaunchWithStdinPipe(const std::wstring& p_Paths) const;
+            void                    LaunchInBatches(const WStringV& p_vPaths) const;
+            bool                    SendToRunningInstance(const std::wstring& p_Paths,
+                                                          const HWND          p_hWnd) const;
         };
 
         //
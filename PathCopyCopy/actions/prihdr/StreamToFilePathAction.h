@@ -0,0 +1,83 @@
+// StreamToFilePathAction.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include <LaunchExecutablePathAction.h>
+#include <PathAction.h>
+
+#include <exception>
+#include <string>
+
+
+namespace PCC
+{
+    namespace Actions
+    {
+        //
+        // StreamToFilePathAction
+        //
+        // Path action that writes paths to a file, one per line. Meant for very
+        // large selections, for which the clipboard is a poor destination: paths
+        // are encoded and written sequentially through a fixed-size buffer, so
+        // they are never bundled in a single string. If no output file is
+        // specified, the user is asked to choose one.
+        //
+        class StreamToFilePathAction final : public PCC::PathAction
+        {
+        public:
+            typedef LaunchExecutablePathAction::FilelistEncoding OutputEncoding;
+
+                                    StreamToFilePathAction(const std::wstring&  p_OutputFile,
+                                                           const OutputEncoding p_Encoding);
+                                    StreamToFilePathAction(const StreamToFilePathAction&) = delete;
+            StreamToFilePathAction& operator=(const StreamToFilePathAction&) = delete;
+
+            virtual void            Act(const std::wstring& p_Paths,
+                                        const HWND          p_hWnd) const override;
+            virtual void            ActOnWrittenPaths(const WStringV&               p_vPaths,
+                                                      const std::wstring::size_type p_PathsSize,
+                                                      const PathsWriter&            p_PathsWriter,
+                                                      const HWND                    p_hWnd) const override;
+
+        private:
+            std::wstring            m_OutputFile;       // Path of file to write to; if empty, user chooses one.
+            OutputEncoding          m_Encoding;         // Encoding of output file.
+
+            bool                    GetOutputFile(const HWND p_hWnd,
+                                                  std::wstring& p_rOutputFile) const;
+        };
+
+        //
+        // StreamToFileException
+        //
+        // Exception thrown when an error occurs while writing paths to a file.
+        //
+        class StreamToFileException : public std::exception
+        {
+        public:
+            virtual const char*     what() const override;
+        };
+
+    } // namespace Actions
+
+} // namespace PCC
@@ -22,18 +22,292 @@
 #include <stdafx.h>
 #include <CopyToClipboardPathAction.h>
 
-#include <StClipboard.h>
+#include <ClipboardRenderWindow.h>
+#include <ClipboardWriter.h>
 #include <StGlobalBlock.h>
 #include <StGlobalLock.h>
+#include <StringUtils.h>
 
+#include <stdio.h>
 #include <string.h>
+#include <wchar.h>
 #include <windows.h>
 
 
+namespace
+{
+    const wchar_t* const    HTML_CLIPBOARD_FORMAT_NAME  = L"HTML Format";   // Name of the registered CF_HTML clipboard format.
+
+    // Header of CF_HTML data. Offsets are always formatted with 10 digits,
+    // so the header's size does not depend on their values.
+    const char* const       HTML_HEADER_FORMAT          = "Version:0.9\r\n"
+                                                          "StartHTML:%010u\r\n"
+                                                          "EndHTML:%010u\r\n"
+                                                          "StartFragment:%010u\r\n"
+                                                          "EndFragment:%010u\r\n";
+    const char* const       HTML_PREFIX                 = "<html>\r\n<body>\r\n<!--StartFragment-->";
+    const char* const       HTML_SUFFIX                 = "<!--EndFragment-->\r\n</body>\r\n</html>";
+    const wchar_t* const    HTML_LINKS_SEPARATOR        = L"<br>\r\n";     // Separator between links in CF_HTML data.
+
+    //
+    // Writes paths in a new global memory block, followed by a null character.
+    //
+    // @param p_PathsSize Number of characters that will be written.
+    // @param p_PathsWriter Function that writes exactly p_PathsSize
+    //                      characters in the buffer it is given.
+    // @return Handle of memory block. Caller assumes ownership.
+    //
+    HANDLE WritePathsInBlock(const std::wstring::size_type p_PathsSize,
+                             const PCC::PathAction::PathsWriter& p_PathsWriter)
+    {
+        // Allocate global block to store text.
+        const size_t blockNumElements = p_PathsSize + 1;
+        const size_t blockSize = blockNumElements * sizeof(wchar_t);
+        StGlobalBlock memBlock(GMEM_MOVEABLE, blockSize);
+        if (memBlock.Get() == NULL) {
+            throw PCC::Actions::CopyToClipboardException();
+        }
+
+        // Lock block and write text in it.
+        {
+            StGlobalLock lockBlock(memBlock.Get());
+            wchar_t* pBlock = static_cast<wchar_t*>(lockBlock.GetPtr());
+            if (pBlock == nullptr) {
+                throw PCC::Actions::CopyToClipboardException();
+            }
+
+            p_PathsWriter(pBlock);
+            pBlock[p_PathsSize] = L'\0';
+        }
+
+        return memBlock.Release();
+    }
+
+    //
+    // Checks if the given path is a file system path, e.g. a path that
+    // starts with a drive letter or a UNC path.
+    //
+    // @param p_Path Path to check.
+    // @return true if p_Path is a file system path.
+    //
+    bool IsFileSystemPath(const std::wstring& p_Path)
+    {
+        const bool isDrivePath = p_Path.size() >= 3 && ::iswalpha(p_Path[0]) && p_Path[1] == L':' &&
+                                 (p_Path[2] == L'\\' || p_Path[2] == L'/');
+        const bool isUNCPath = p_Path.size() >= 3 && p_Path[0] == L'\\' && p_Path[1] == L'\\';
+        return isDrivePath || isUNCPath;
+    }
+
+    //
+    // Escapes characters that have special meaning in HTML.
+    //
+    // @param p_Text Text to escape.
+    // @return Escaped text.
+    //
+    std::wstring EscapeHTML(const std::wstring& p_Text)
+    {
+        std::wstring escaped;
+        escaped.reserve(p_Text.size());
+        for (const wchar_t curChar : p_Text) {
+            switch (curChar) {
+                case L'&':  escaped += L"&amp;";    break;
+                case L'<':  escaped += L"&lt;";     break;
+                case L'>':  escaped += L"&gt;";     break;
+                case L'"':  escaped += L"&quot;";   break;
+                default:    escaped.push_back(curChar); break;
+            }
+        }
+        return escaped;
+    }
+
+    //
+    // Returns the URL to use in a link to the given path. File system paths
+    // are turned into file: URLs; other paths are assumed to be URLs already.
+    //
+    // @param p_Path Path to link to.
+    // @return URL of link.
+    //
+    std::wstring GetLinkURL(const std::wstring& p_Path)
+    {
+        std::wstring url;
+        if (IsFileSystemPath(p_Path)) {
+            url = p_Path;
+            StringUtils::ReplaceChar(url, L'\\', L'/');
+            StringUtils::EncodeURICharacters(url, StringUtils::EncodeParam::All);
+            url.insert(0, url[0] == L'/' ? L"file:" : L"file:///");
+        } else {
+            url = p_Path;
+        }
+        return url;
+    }
+
+    //
+    // Writes the given paths as links in a new global memory block, using
+    // the CF_HTML clipboard format.
+    //
+    // @param p_vPaths Paths to write.
+    // @return Handle of memory block, or NULL if it could not be created.
+    //         Caller assumes ownership.
+    //
+    HANDLE WriteHTMLLinksInBlock(const PCC::WStringV& p_vPaths)
+    {
+        // Build the HTML fragment containing links, then convert it to UTF-8.
+        std::wstring fragment;
+        for (const std::wstring& path : p_vPaths) {
+            if (!fragment.empty()) {
+                fragment += HTML_LINKS_SEPARATOR;
+            }
+            fragment += L"<a href=\"";
+            fragment += EscapeHTML(GetLinkURL(path));
+            fragment += L"\">";
+            fragment += EscapeHTML(path);
+            fragment += L"</a>";
+        }
+        std::string utf8Fragment;
+        if (!fragment.empty()) {
+            const int fragmentSize = static_cast<int>(fragment.size());
+            const int utf8Size = ::WideCharToMultiByte(CP_UTF8, 0, fragment.c_str(), fragmentSize,
+                                                       nullptr, 0, nullptr, nullptr);
+            if (utf8Size <= 0) {
+                return NULL;
+            }
+            utf8Fragment.resize(static_cast<size_t>(utf8Size));
+            ::WideCharToMultiByte(CP_UTF8, 0, fragment.c_str(), fragmentSize,
+                                  &*utf8Fragment.begin(), utf8Size, nullptr, nullptr);
+        }
+
+        // Compute offsets of each part. Header size is constant, see HTML_HEADER_FORMAT.
+        char header[256];
+        const int headerSize = ::sprintf_s(header, HTML_HEADER_FORMAT, 0U, 0U, 0U, 0U);
+        const size_t prefixSize = ::strlen(HTML_PREFIX);
+        const size_t suffixSize = ::strlen(HTML_SUFFIX);
+        const size_t startHTML = static_cast<size_t>(headerSize);
+        const size_t startFragment = startHTML + prefixSize;
+        const size_t endFragment = startFragment + utf8Fragment.size();
+        const size_t endHTML = endFragment + suffixSize;
+        ::sprintf_s(header, HTML_HEADER_FORMAT, static_cast<unsigned int>(startHTML), static_cast<unsigned int>(endHTML),
+                    static_cast<unsigned int>(startFragment), static_cast<unsigned int>(endFragment));
+
+        // Write everything in a global block, followed by a null character.
+        StGlobalBlock memBlock(GMEM_MOVEABLE, endHTML + 1);
+        bool written = false;
+        if (memBlock.Get() != NULL) {
+            StGlobalLock lockBlock(memBlock.Get());
+            char* pBlock = static_cast<char*>(lockBlock.GetPtr());
+            if (pBlock != nullptr) {
+                ::memcpy(pBlock, header, startHTML);
+                ::memcpy(pBlock + startHTML, HTML_PREFIX, prefixSize);
+                ::memcpy(pBlock + startFragment, utf8Fragment.data(), utf8Fragment.size());
+                ::memcpy(pBlock + endFragment, HTML_SUFFIX, suffixSize);
+                pBlock[endHTML] = '\0';
+                written = true;
+            }
+        }
+        return written ? memBlock.Release() : NULL;
+    }
+
+    //
+    // Writes the given file paths in a new global memory block, using
+    // the CF_HDROP clipboard format.
+    //
+    // @param p_vPaths File paths to write.
+    // @return Handle of memory block, or NULL if it could not be created.
+    //         Caller assumes ownership.
+    //
+    HANDLE WriteDropFilesInBlock(const PCC::WStringV& p_vPaths)
+    {
+        // Files are stored after the DROPFILES header as a list
+        // of null-terminated strings ending with an empty string.
+        size_t filesSize = 1;
+        for (const std::wstring& path : p_vPaths) {
+            filesSize += path.size() + 1;
+        }
+        StGlobalBlock memBlock(GMEM_MOVEABLE | GMEM_ZEROINIT, sizeof(DROPFILES) + filesSize * sizeof(wchar_t));
+        bool written = false;
+        if (memBlock.Get() != NULL) {
+            StGlobalLock lockBlock(memBlock.Get());
+            DROPFILES* pDropFiles = static_cast<DROPFILES*>(lockBlock.GetPtr());
+            if (pDropFiles != nullptr) {
+                pDropFiles->pFiles = sizeof(DROPFILES);
+                pDropFiles->fWide = TRUE;
+                wchar_t* pOut = reinterpret_cast<wchar_t*>(pDropFiles + 1);
+                for (const std::wstring& path : p_vPaths) {
+                    ::wmemcpy(pOut, path.c_str(), path.size() + 1);
+                    pOut += path.size() + 1;
+                }
+                *pOut = L'\0';
+                written = true;
+            }
+        }
+        return written ? memBlock.Release() : NULL;
+    }
+
+    //
+    // RenderPathAction
+    //
+    // Path action used to render paths when they are requested from the
+    // clipboard. Writes paths in a global memory block and keeps it.
+    //
+    class RenderPathAction final : public PCC::PathAction
+    {
+    public:
+                                RenderPathAction()
+                                    : PCC::PathAction(),
+                                      m_Block(NULL)
+                                {
+                                }
+                                RenderPathAction(const RenderPathAction&) = delete;
+        RenderPathAction&       operator=(const RenderPathAction&) = delete;
+
+        virtual void            Act(const std::wstring& p_Paths,
+                                    const HWND          p_hWnd) const override
+                                {
+                                    ActOnWrittenPaths(PCC::WStringV(), p_Paths.size(), [&p_Paths](wchar_t* const p_pBuffer) {
+                                        ::wmemcpy(p_pBuffer, p_Paths.c_str(), p_Paths.size());
+                                    }, p_hWnd);
+                                }
+
+        virtual void            ActOnWrittenPaths(const PCC::WStringV&          /*p_vPaths*/,
+                                                  const std::wstring::size_type p_PathsSize,
+                                                  const PathsWriter&            p_PathsWriter,
+                                                  const HWND                    /*p_hWnd*/) const override
+                                {
+                                    m_Block.Acquire(WritePathsInBlock(p_PathsSize, p_PathsWriter));
+                                }
+
+                                //
+                                // Releases ownership of the memory block containing the paths.
+                                //
+                                // @return Handle of memory block, or NULL if paths were not
+                                //         rendered. Caller assumes ownership.
+                                //
+        HANDLE                  ReleaseBlock()
+                                {
+                                    return m_Block.Release();
+                                }
+
+    private:
+        mutable StGlobalBlock   m_Block;    // Memory block containing rendered paths.
+    };
+
+} // anonymous namespace
+
 namespace PCC
 {
     namespace Actions
     {
+        //
+        // Constructor.
+        //
+        // @param p_MultipleFormats Whether to copy paths in HTML and file formats
+        //                          in addition to text.
+        //
+        CopyToClipboardPathAction::CopyToClipboardPathAction(const bool p_MultipleFormats /*= false*/)
+            : PCC::PathAction(),
+              m_MultipleFormats(p_MultipleFormats)
+        {
+        }
+
         //
         // Copies the given paths to the clipboard.
         //
@@ -44,48 +318,112 @@ namespace PCC
         void CopyToClipboardPathAction::Act(const std::wstring& p_Paths,
                                             const HWND          p_hWnd) const
         {
-            // Now store the copied paths in the clipboard.
-            StClipboard acquireClipboard(p_hWnd);
-            if (!acquireClipboard.InitResult()) {
-                throw CopyToClipboardException();
-            }
-
-            // Allocate global block to store text.
-            const size_t blockNumElements = p_Paths.size() + 1;
-            const size_t blockSize = blockNumElements * sizeof(wchar_t);
-            StGlobalBlock memBlock(GMEM_MOVEABLE, blockSize);
-            if (memBlock.Get() == NULL) {
-                throw CopyToClipboardException();
-            }
+            ActOnWrittenPaths(WStringV(), p_Paths.size(), [&p_Paths](wchar_t* const p_pBuffer) {
+                ::wmemcpy(p_pBuffer, p_Paths.c_str(), p_Paths.size());
+            }, p_hWnd);
+        }
 
-            // Lock block and copy text in it.
-            {
-                StGlobalLock lockBlock(memBlock.Get());
-                void* pBlock = lockBlock.GetPtr();
-                if (pBlock == nullptr) {
-                    throw CopyToClipboardException();
-                }
+        //
+        // Copies paths written by the given function to the clipboard.
+        // Paths are written directly in the memory block given to the
+        // clipboard, so they don't need to be copied.
+        //
+        // If we copy multiple formats, the individual paths are also copied
+        // as HTML links and, if they are all file system paths, as files.
+        //
+        // @param p_vPaths Individual paths, as returned by the plugin.
+        // @param p_PathsSize Number of characters that will be written,
+        //                    excluding any terminating null character.
+        // @param p_PathsWriter Function that writes exactly p_PathsSize
+        //                      characters in the buffer it is given.
+        // @param p_hWnd Parent window handle, if needed.
+        //
+        void CopyToClipboardPathAction::ActOnWrittenPaths(const WStringV&               p_vPaths,
+                                                          const std::wstring::size_type p_PathsSize,
+                                                          const PathsWriter&            p_PathsWriter,
+                                                          const HWND                    p_hWnd) const
+        {
+            // Write paths in a global block.
+            StGlobalBlock memBlock(WritePathsInBlock(p_PathsSize, p_PathsWriter));
 
-                errno_t copyErr = ::wcscpy_s(static_cast<wchar_t*>(pBlock),
-                                             blockNumElements,
-                                             p_Paths.c_str());
-                if (copyErr != 0) {
-                    // Could not copy data in block.
-                    throw CopyToClipboardException();
+            // Write other formats from the same paths if needed.
+            StGlobalBlock htmlBlock(NULL);
+            StGlobalBlock dropFilesBlock(NULL);
+            StGlobalBlock fileNameBlock(NULL);
+            if (m_MultipleFormats && !p_vPaths.empty()) {
+                htmlBlock.Acquire(WriteHTMLLinksInBlock(p_vPaths));
+                if (std::all_of(p_vPaths.cbegin(), p_vPaths.cend(), &IsFileSystemPath)) {
+                    dropFilesBlock.Acquire(WriteDropFilesInBlock(p_vPaths));
+                    const std::wstring& firstPath = p_vPaths.front();
+                    try {
+                        fileNameBlock.Acquire(WritePathsInBlock(firstPath.size(), [&firstPath](wchar_t* const p_pBuffer) {
+                            ::wmemcpy(p_pBuffer, firstPath.c_str(), firstPath.size());
+                        }));
+                    } catch (const CopyToClipboardException&) {
+                        // Optional format, skip it.
+                    }
                 }
             }
 
-            // Save data in clipboard.
-            HANDLE hSavedData = ::SetClipboardData(CF_UNICODETEXT, memBlock.Get());
-            if (hSavedData != NULL) {
-                // Clipboard now owns the data, avoid freeing it.
-                memBlock.Release();
-            } else {
-                // Could not save clipboard data.
+            // Now store the paths in the clipboard. We open it only once the paths
+            // are written so that we don't hold it while they are being formatted.
+            // If another application holds the clipboard, paths are stored later
+            // from a worker thread so that we don't block the shell.
+            ClipboardWriter::DataV vData;
+            vData.push_back({ CF_UNICODETEXT, memBlock.Release() });
+            if (htmlBlock.Get() != NULL) {
+                vData.push_back({ ::RegisterClipboardFormatW(HTML_CLIPBOARD_FORMAT_NAME), htmlBlock.Release() });
+            }
+            if (dropFilesBlock.Get() != NULL) {
+                vData.push_back({ CF_HDROP, dropFilesBlock.Release() });
+            }
+            if (fileNameBlock.Get() != NULL) {
+                vData.push_back({ ::RegisterClipboardFormatW(CFSTR_FILENAMEW), fileNameBlock.Release() });
+            }
+            if (!ClipboardWriter::Publish(p_hWnd, vData)) {
                 throw CopyToClipboardException();
             }
         }
 
+        //
+        // Announces paths in the clipboard without computing them. Paths will
+        // only be computed if an application requests them, for instance when
+        // the user pastes. This uses delayed clipboard rendering.
+        // Only text can be rendered later, so when copying multiple
+        // formats, paths are copied immediately.
+        //
+        // @param p_PathsProducer Function that computes paths and passes them to
+        //                        the ActOnWrittenPaths method of the action it is given.
+        // @param p_hWnd Parent window handle, if needed.
+        //
+        void CopyToClipboardPathAction::ActLater(const PathsProducer& p_PathsProducer,
+                                                 const HWND           p_hWnd) const
+        {
+            auto renderPaths = [p_PathsProducer]() -> HANDLE {
+                RenderPathAction renderAction;
+                p_PathsProducer(renderAction, NULL);
+                return renderAction.ReleaseBlock();
+            };
+            // Drop pending publications so that they don't replace the announced paths.
+            ClipboardWriter::CancelPending();
+            if (m_MultipleFormats || !ClipboardRenderWindow::Create(CF_UNICODETEXT, renderPaths)) {
+                // Can't use delayed rendering, copy paths immediately.
+                p_PathsProducer(*this, p_hWnd);
+            }
+        }
+
+        //
+        // Checks whether the action can fail in a way the user needs to know
+        // about. Failing to copy to the clipboard is never reported to the
+        // user, so the copy can be performed by another process.
+        //
+        // @return Always false.
+        //
+        bool CopyToClipboardPathAction::CanFailVisibly() const
+        {
+            return false;
+        }
+
         //
         // Returns a textual description of the exception.
         //
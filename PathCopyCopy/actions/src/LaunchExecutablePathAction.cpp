@@ -21,10 +21,359 @@
 
 #include <stdafx.h>
 #include <LaunchExecutablePathAction.h>
+#include <StCoInitialize.h>
 
-#include <fstream>
-#include <memory>
+#include <algorithm>
+#include <cwchar>
+#include <string>
+#include <thread>
+#include <vector>
 
+#include <atlbase.h>
+#include <windows.h>
+
+
+namespace
+{
+    const size_t    FILELIST_CHUNK_SIZE         = 16384;    // Number of characters converted and written at once in filelists.
+    const size_t    MAX_BYTES_PER_CHAR          = 4;        // Maximum number of bytes needed to convert one character to a multibyte code page.
+    const wchar_t   UTF16_BOM                   = L'\xFEFF';
+    const size_t    MAX_COMMAND_LINE_SIZE       = 32767;    // Maximum size of a command line passed to CreateProcess, including terminating null.
+    const DWORD     RUNNING_INSTANCE_TIMEOUT_MS = 1000;     // Time to wait for a running instance to accept paths before launching a new one.
+    const wchar_t* const
+                    NAMED_PIPE_PREFIX           = L"\\\\.\\pipe\\";  // Prefix of named pipe names.
+    const DWORD     EXTENDED_STARTUPINFO_FLAG   = 0x00080000;   // EXTENDED_STARTUPINFO_PRESENT
+    const DWORD_PTR HANDLE_LIST_ATTRIBUTE       = 0x00020002;   // PROC_THREAD_ATTRIBUTE_HANDLE_LIST
+
+    // Process thread attribute list functions we load dynamically, along with
+    // the extended startup info structure. They are declared here because
+    // winbase.h only declares them when targeting Windows Vista.
+    typedef struct _ProcThreadAttributeList* ProcThreadAttributeListP;
+    typedef BOOL (WINAPI *InitializeProcThreadAttributeListFunc)(ProcThreadAttributeListP, DWORD, DWORD, PSIZE_T);
+    typedef BOOL (WINAPI *UpdateProcThreadAttributeFunc)(ProcThreadAttributeListP, DWORD, DWORD_PTR, PVOID, SIZE_T, PVOID, PSIZE_T);
+    typedef void (WINAPI *DeleteProcThreadAttributeListFunc)(ProcThreadAttributeListP);
+    struct StartupInfoEx {
+        STARTUPINFOW                StartupInfo;    // Regular startup info.
+        ProcThreadAttributeListP    pAttributeList; // Additional attributes of new process.
+    };
+
+    //
+    // Writes data to a file, throwing if it can't be written entirely.
+    //
+    // @param p_hFile Handle of file to write to.
+    // @param p_pData Data to write.
+    // @param p_DataSize Size of data to write, in bytes.
+    //
+    void WriteToFile(HANDLE const p_hFile,
+                     const void* const p_pData,
+                     const DWORD p_DataSize)
+    {
+        DWORD written = 0;
+        if (::WriteFile(p_hFile, p_pData, p_DataSize, &written, nullptr) == FALSE || written != p_DataSize) {
+            throw PCC::Actions::LaunchExecutableException();
+        }
+    }
+
+    //
+    // Writes paths to a filelist file or pipe, using the given encoding.
+    // Paths are converted and written in chunks, so that we don't need
+    // another copy of them.
+    //
+    // @param p_hOutput Handle of file or pipe to write to.
+    // @param p_Paths Path or paths to write, pre-bundled in a single string.
+    // @param p_Encoding Encoding of filelist.
+    //
+    void WriteFilelistContent(HANDLE const p_hOutput,
+                              const std::wstring& p_Paths,
+                              const PCC::Actions::LaunchExecutablePathAction::FilelistEncoding p_Encoding)
+    {
+        typedef PCC::Actions::LaunchExecutablePathAction::FilelistEncoding FilelistEncoding;
+
+        const bool isUTF16 = p_Encoding == FilelistEncoding::UTF16LE;
+        const UINT codePage = p_Encoding == FilelistEncoding::UTF8 ? CP_UTF8 : CP_ACP;
+        std::vector<char> vBuffer;
+        if (isUTF16) {
+            WriteToFile(p_hOutput, &UTF16_BOM, sizeof(UTF16_BOM));
+        } else {
+            vBuffer.resize(FILELIST_CHUNK_SIZE * MAX_BYTES_PER_CHAR);
+        }
+
+        std::wstring::size_type pos = 0;
+        while (pos < p_Paths.size()) {
+            // Do not split surrogate pairs between chunks, otherwise they can't be converted.
+            std::wstring::size_type chunkSize = (std::min)(FILELIST_CHUNK_SIZE, p_Paths.size() - pos);
+            if (pos + chunkSize < p_Paths.size() && IS_HIGH_SURROGATE(p_Paths[pos + chunkSize - 1])) {
+                --chunkSize;
+            }
+            const wchar_t* const pChunk = p_Paths.c_str() + pos;
+            if (isUTF16) {
+                WriteToFile(p_hOutput, pChunk, static_cast<DWORD>(chunkSize * sizeof(wchar_t)));
+            } else {
+                const int convertedSize = ::WideCharToMultiByte(codePage, 0, pChunk, static_cast<int>(chunkSize),
+                                                                vBuffer.data(), static_cast<int>(vBuffer.size()),
+                                                                nullptr, nullptr);
+                if (convertedSize == 0) {
+                    throw PCC::Actions::LaunchExecutableException();
+                }
+                WriteToFile(p_hOutput, vBuffer.data(), static_cast<DWORD>(convertedSize));
+            }
+            pos += chunkSize;
+        }
+    }
+
+    //
+    // Writes paths to a file or pipe on a worker thread, which closes it when
+    // done. Used when writing could block until another process reads the data.
+    //
+    // @param p_rhOutput Handle of file or pipe to write to. The worker thread
+    //                   takes ownership of it; upon return, it is detached.
+    // @param p_Paths Path or paths to write, pre-bundled in a single string.
+    // @param p_Encoding Encoding of filelist.
+    //
+    void WriteFilelistContentInBackground(ATL::CHandle& p_rhOutput,
+                                          const std::wstring& p_Paths,
+                                          const PCC::Actions::LaunchExecutablePathAction::FilelistEncoding p_Encoding)
+    {
+        typedef PCC::Actions::LaunchExecutablePathAction::FilelistEncoding FilelistEncoding;
+
+        auto writePaths = [](HANDLE const p_hOutput, const std::wstring& p_PathsToWrite,
+                             const FilelistEncoding p_EncodingToUse) {
+            try {
+                WriteFilelistContent(p_hOutput, p_PathsToWrite, p_EncodingToUse);
+            } catch (...) {
+                // Reader probably exited without reading everything.
+            }
+            ::CloseHandle(p_hOutput);
+            ATL::_pAtlModule->Unlock();
+        };
+
+        // The worker thread can outlive our caller, so make sure
+        // our DLL is not unloaded before it completes.
+        HANDLE const hOutput = p_rhOutput.Detach();
+        ATL::_pAtlModule->Lock();
+        try {
+            std::thread(writePaths, hOutput, p_Paths, p_Encoding).detach();
+        } catch (...) {
+            // Could not start thread, write paths ourselves.
+            writePaths(hOutput, p_Paths, p_Encoding);
+        }
+    }
+
+    //
+    // Appends an argument to a command line, adding quotes if needed. Quotes and
+    // backslashes are escaped so that the argument is parsed back by the launched
+    // executable exactly as given (see CommandLineToArgvW). Arguments that are
+    // already quoted (for example by the "Surround with quotes" option) are
+    // appended as-is, like when paths are passed to a single executable.
+    //
+    // @param p_rCommandLine Command line to append to.
+    // @param p_Argument Argument to append.
+    //
+    void AppendCommandLineArgument(std::wstring& p_rCommandLine,
+                                   const std::wstring& p_Argument)
+    {
+        if (!p_rCommandLine.empty()) {
+            p_rCommandLine.push_back(L' ');
+        }
+        const bool alreadyQuoted = p_Argument.size() >= 2 && p_Argument.front() == L'"' && p_Argument.back() == L'"' &&
+                                   p_Argument.find(L'"', 1) == p_Argument.size() - 1;
+        if (alreadyQuoted || (!p_Argument.empty() && p_Argument.find_first_of(L" \t\"") == std::wstring::npos)) {
+            p_rCommandLine += p_Argument;
+        } else {
+            p_rCommandLine.push_back(L'"');
+            std::wstring::size_type backslashes = 0;
+            for (const wchar_t c : p_Argument) {
+                if (c == L'\\') {
+                    ++backslashes;
+                } else {
+                    if (c == L'"') {
+                        // Backslashes preceding a quote must be escaped, as well as the quote.
+                        p_rCommandLine.append(backslashes + 1, L'\\');
+                    }
+                    backslashes = 0;
+                }
+                p_rCommandLine.push_back(c);
+            }
+            // Backslashes preceding the closing quote must also be escaped.
+            p_rCommandLine.append(backslashes, L'\\');
+            p_rCommandLine.push_back(L'"');
+        }
+    }
+
+    //
+    // Splits paths in batches, each fitting in a command line used to launch
+    // the given executable. A path that doesn't fit in a command line by itself
+    // gets its own batch; launching it will fail, but the other batches will work.
+    //
+    // @param p_Executable Executable that will be launched with each batch.
+    // @param p_vPaths Paths to split.
+    // @return Arguments to pass to the executable, one string per batch.
+    //
+    PCC::WStringV SplitInBatches(const std::wstring& p_Executable,
+                                 const PCC::WStringV& p_vPaths)
+    {
+        // Executable might be resolved to a longer path or launched through
+        // an interpreter, so leave some room for that.
+        std::wstring executable;
+        AppendCommandLineArgument(executable, p_Executable);
+        const size_t maxArgumentsSize = MAX_COMMAND_LINE_SIZE - (std::min)(executable.size() + MAX_PATH + 1,
+                                                                            MAX_COMMAND_LINE_SIZE / 2);
+
+        PCC::WStringV vBatches;
+        std::wstring arguments;
+        std::wstring argument;
+        for (const std::wstring& path : p_vPaths) {
+            argument.clear();
+            AppendCommandLineArgument(argument, path);
+            if (!arguments.empty() && arguments.size() + 1 + argument.size() >= maxArgumentsSize) {
+                vBatches.push_back(arguments);
+                arguments.clear();
+            }
+            if (!arguments.empty()) {
+                arguments.push_back(L' ');
+            }
+            arguments += argument;
+        }
+        if (!arguments.empty()) {
+            vBatches.push_back(arguments);
+        }
+        return vBatches;
+    }
+
+    //
+    // Launches the executable once per batch of arguments, with a maximum number
+    // of processes running at once. Does not return until all processes are started
+    // and all but the last batch of running processes have exited.
+    //
+    // The executable is launched through ShellExecuteExW, so that it is resolved
+    // like when paths are passed to a single executable (App Paths, file
+    // associations, scripts without extension, etc.). COM must be initialized.
+    //
+    // @param p_Executable Executable to launch.
+    // @param p_vBatches Arguments to pass to the executable, one string per batch.
+    // @param p_MaxParallelBatches Max number of processes to run at once.
+    //
+    void RunBatches(const std::wstring& p_Executable,
+                    const PCC::WStringV& p_vBatches,
+                    const size_t p_MaxParallelBatches)
+    {
+        // WaitForMultipleObjects has a limit on the number of handles it can wait for.
+        const size_t maxRunning = (std::min)((std::max)(p_MaxParallelBatches, static_cast<size_t>(1)),
+                                             static_cast<size_t>(MAXIMUM_WAIT_OBJECTS));
+        std::vector<HANDLE> vhRunning;
+        vhRunning.reserve(maxRunning);
+        try {
+            for (const std::wstring& arguments : p_vBatches) {
+                // Wait for a slot to be available before launching this batch.
+                if (vhRunning.size() == maxRunning) {
+                    const DWORD res = ::WaitForMultipleObjects(static_cast<DWORD>(vhRunning.size()),
+                                                               vhRunning.data(), FALSE, INFINITE);
+                    if (res >= WAIT_OBJECT_0 + vhRunning.size()) {
+                        throw PCC::Actions::LaunchExecutableException();
+                    }
+                    const size_t exited = res - WAIT_OBJECT_0;
+                    ::CloseHandle(vhRunning[exited]);
+                    vhRunning.erase(vhRunning.begin() + exited);
+                }
+
+                SHELLEXECUTEINFOW execInfo = { 0 };
+                execInfo.cbSize = sizeof(execInfo);
+                execInfo.fMask = SEE_MASK_NOCLOSEPROCESS | SEE_MASK_NOASYNC | SEE_MASK_FLAG_NO_UI;
+                execInfo.lpFile = p_Executable.c_str();
+                execInfo.lpParameters = arguments.c_str();
+                execInfo.nShow = SW_SHOWDEFAULT;
+                if (::ShellExecuteExW(&execInfo) == FALSE) {
+                    throw PCC::Actions::LaunchExecutableException();
+                }
+
+                // No process handle is returned if the launch was handled by
+                // an existing process (via DDE for instance); nothing to wait for.
+                if (execInfo.hProcess != NULL) {
+                    vhRunning.push_back(execInfo.hProcess);
+                }
+            }
+        } catch (...) {
+            for (HANDLE hProcess : vhRunning) {
+                ::CloseHandle(hProcess);
+            }
+            throw;
+        }
+        for (HANDLE hProcess : vhRunning) {
+            ::CloseHandle(hProcess);
+        }
+    }
+
+
+    //
+    // Launches a process with its standard input redirected to the given handle.
+    // On Windows Vista and later, the process only inherits that handle, so that
+    // handles made inheritable by other threads of the host process don't leak
+    // into it. On Windows XP, the process inherits all inheritable handles.
+    //
+    // @param p_rCommandLine Command line to launch. Can be modified by CreateProcessW.
+    // @param p_hStdInput Inheritable handle to use as standard input.
+    // @param p_rProcessInfo Where to store information about the new process.
+    // @return true if process was launched.
+    //
+    bool CreateProcessWithStdInput(std::wstring&        p_rCommandLine,
+                                   HANDLE const         p_hStdInput,
+                                   PROCESS_INFORMATION& p_rProcessInfo)
+    {
+        HMODULE hKernel32 = ::GetModuleHandleW(L"kernel32.dll");
+        InitializeProcThreadAttributeListFunc pInitializeProcThreadAttributeList = nullptr;
+        UpdateProcThreadAttributeFunc pUpdateProcThreadAttribute = nullptr;
+        DeleteProcThreadAttributeListFunc pDeleteProcThreadAttributeList = nullptr;
+        if (hKernel32 != NULL) {
+            pInitializeProcThreadAttributeList = reinterpret_cast<InitializeProcThreadAttributeListFunc>(
+                ::GetProcAddress(hKernel32, "InitializeProcThreadAttributeList"));
+            pUpdateProcThreadAttribute = reinterpret_cast<UpdateProcThreadAttributeFunc>(
+                ::GetProcAddress(hKernel32, "UpdateProcThreadAttribute"));
+            pDeleteProcThreadAttributeList = reinterpret_cast<DeleteProcThreadAttributeListFunc>(
+                ::GetProcAddress(hKernel32, "DeleteProcThreadAttributeList"));
+        }
+
+        if (pInitializeProcThreadAttributeList != nullptr && pUpdateProcThreadAttribute != nullptr &&
+            pDeleteProcThreadAttributeList != nullptr) {
+
+            // Only the pipe is passed: standard output and error handles would
+            // have to be listed too, and a shell extension has none to share anyway.
+            SIZE_T attributeListSize = 0;
+            pInitializeProcThreadAttributeList(nullptr, 1, 0, &attributeListSize);
+            std::vector<BYTE> vAttributeList(attributeListSize);
+            auto pAttributeList = reinterpret_cast<ProcThreadAttributeListP>(vAttributeList.data());
+            if (attributeListSize == 0 ||
+                pInitializeProcThreadAttributeList(pAttributeList, 1, 0, &attributeListSize) == FALSE) {
+                return false;
+            }
+            HANDLE hInherited = p_hStdInput;
+            bool launched = false;
+            if (pUpdateProcThreadAttribute(pAttributeList, 0, HANDLE_LIST_ATTRIBUTE, &hInherited,
+                                           sizeof(hInherited), nullptr, nullptr) != FALSE) {
+                StartupInfoEx startupInfoEx = { 0 };
+                startupInfoEx.StartupInfo.cb = sizeof(startupInfoEx);
+                startupInfoEx.StartupInfo.dwFlags = STARTF_USESTDHANDLES;
+                startupInfoEx.StartupInfo.hStdInput = p_hStdInput;
+                startupInfoEx.pAttributeList = pAttributeList;
+                launched = ::CreateProcessW(nullptr, &*p_rCommandLine.begin(), nullptr, nullptr, TRUE,
+                                            EXTENDED_STARTUPINFO_FLAG, nullptr, nullptr,
+                                            &startupInfoEx.StartupInfo, &p_rProcessInfo) != FALSE;
+            }
+            pDeleteProcThreadAttributeList(pAttributeList);
+            return launched;
+        }
+
+        // Windows XP: no way to restrict inherited handles.
+        STARTUPINFOW startupInfo = { 0 };
+        startupInfo.cb = sizeof(startupInfo);
+        startupInfo.dwFlags = STARTF_USESTDHANDLES;
+        startupInfo.hStdInput = p_hStdInput;
+        startupInfo.hStdOutput = ::GetStdHandle(STD_OUTPUT_HANDLE);
+        startupInfo.hStdError = ::GetStdHandle(STD_ERROR_HANDLE);
+        return ::CreateProcessW(nullptr, &*p_rCommandLine.begin(), nullptr, nullptr, TRUE, 0,
+                                nullptr, nullptr, &startupInfo, &p_rProcessInfo) != FALSE;
+    }
+
+} // anonymous namespace
 
 namespace PCC
 {
@@ -35,12 +384,31 @@ namespace PCC
         //
         // @param p_Executable Name of executable to launch.
         // @param p_UseFilelist Whether to use a filelist to launch executable instead of passing paths directly.
+        // @param p_FilelistEncoding Encoding to use for the filelist, if used.
+        // @param p_FilelistDelivery How to deliver the filelist to the executable, if used.
+        // @param p_MaxParallelBatches If non-zero, paths are split in batches that each fit in a
+        //                             command line and the executable is launched once per batch,
+        //                             with at most this number of batches running at once.
+        //                             Does not apply when using a filelist.
+        // @param p_InstanceEndpoint Endpoint used to send paths to a running instance of the
+        //                           executable. If it can't be reached, the executable is launched.
+        // @param p_InstanceEndpointName Name of pipe or window class used to reach a running instance.
         //
-        LaunchExecutablePathAction::LaunchExecutablePathAction(const std::wstring& p_Executable,
-                                                               const bool          p_UseFilelist)
+        LaunchExecutablePathAction::LaunchExecutablePathAction(const std::wstring&    p_Executable,
+                                                               const bool             p_UseFilelist,
+                                                               const FilelistEncoding p_FilelistEncoding /*= FilelistEncoding::Ansi*/,
+                                                               const FilelistDelivery p_FilelistDelivery /*= FilelistDelivery::TempFile*/,
+                                                               const size_t           p_MaxParallelBatches /*= 0*/,
+                                                               const InstanceEndpoint p_InstanceEndpoint /*= InstanceEndpoint::None*/,
+                                                               const std::wstring&    p_InstanceEndpointName /*= std::wstring()*/)
             : PCC::PathAction(),
               m_Executable(p_Executable),
-              m_UseFilelist(p_UseFilelist)
+              m_UseFilelist(p_UseFilelist),
+              m_FilelistEncoding(p_FilelistEncoding),
+              m_FilelistDelivery(p_FilelistDelivery),
+              m_MaxParallelBatches(p_MaxParallelBatches),
+              m_InstanceEndpoint(p_InstanceEndpoint),
+              m_InstanceEndpointName(p_InstanceEndpointName)
         {
         }
         
@@ -54,34 +422,220 @@ namespace PCC
         void LaunchExecutablePathAction::Act(const std::wstring& p_Paths,
                                              const HWND          p_hWnd) const
         {
-            std::wstring arguments = p_Paths;
-            if (m_UseFilelist) {
-                wchar_t tempDirPath[MAX_PATH + 1];
-                if (::GetTempPathW(sizeof(tempDirPath) / sizeof(wchar_t), tempDirPath) == 0) {
-                    throw LaunchExecutableException();
+            if (SendToRunningInstance(p_Paths, p_hWnd)) {
+                // Paths were handed to a running instance, no need to launch a new one.
+            } else if (m_UseFilelist && m_FilelistDelivery == FilelistDelivery::StdinPipe) {
+                LaunchWithStdinPipe(p_Paths);
+            } else {
+                std::wstring arguments;
+                if (m_UseFilelist) {
+                    arguments = WriteFilelist(p_Paths);
+                } else {
+                    arguments = p_Paths;
                 }
 
-                wchar_t tempFilePath[MAX_PATH + 1];
-                if (::GetTempFileNameW(tempDirPath, L"pcc", 0, tempFilePath) == 0) {
+                auto res = reinterpret_cast<size_t>(::ShellExecuteW(p_hWnd, nullptr, m_Executable.c_str(), arguments.c_str(), nullptr, SW_SHOWDEFAULT));
+                if (res <= 32) {
                     throw LaunchExecutableException();
                 }
+            }
+        }
 
-                int reqdBufferSize = ::WideCharToMultiByte(CP_ACP, 0, p_Paths.c_str(), -1, nullptr, 0, nullptr, nullptr);
-                auto buffer = std::make_unique<char[]>(reqdBufferSize);
-                int convertRetVal = ::WideCharToMultiByte(CP_ACP, 0, p_Paths.c_str(), -1, buffer.get(), reqdBufferSize, nullptr, nullptr);
-                if (convertRetVal == 0) {
-                    throw LaunchExecutableException();
+        //
+        // Performs the action on paths written by the given function. When
+        // splitting paths in batches, we use the individual paths instead
+        // to build command lines, thus the paths writer is not used.
+        //
+        // @param p_vPaths Individual paths, as returned by the plugin.
+        // @param p_PathsSize Number of characters that will be written.
+        // @param p_PathsWriter Function that writes paths in a buffer.
+        // @param p_hWnd Parent window handle, if needed.
+        //
+        void LaunchExecutablePathAction::ActOnWrittenPaths(const WStringV&               p_vPaths,
+                                                           const std::wstring::size_type p_PathsSize,
+                                                           const PathsWriter&            p_PathsWriter,
+                                                           const HWND                    p_hWnd) const
+        {
+            if (m_MaxParallelBatches != 0 && !m_UseFilelist && !p_vPaths.empty()) {
+                // A running instance gets all paths at once, so try it first.
+                bool sent = false;
+                if (m_InstanceEndpoint != InstanceEndpoint::None) {
+                    std::wstring paths(p_PathsSize, L'\0');
+                    if (p_PathsSize != 0) {
+                        p_PathsWriter(&*paths.begin());
+                    }
+                    sent = SendToRunningInstance(paths, p_hWnd);
                 }
+                if (!sent) {
+                    LaunchInBatches(p_vPaths);
+                }
+            } else {
+                PathAction::ActOnWrittenPaths(p_vPaths, p_PathsSize, p_PathsWriter, p_hWnd);
+            }
+        }
+
+        //
+        // Writes paths to a new temporary filelist file.
+        //
+        // @param p_Paths Path or paths to write, pre-bundled in a single string.
+        // @return Path to filelist file.
+        //
+        std::wstring LaunchExecutablePathAction::WriteFilelist(const std::wstring& p_Paths) const
+        {
+            wchar_t tempDirPath[MAX_PATH + 1];
+            if (::GetTempPathW(sizeof(tempDirPath) / sizeof(wchar_t), tempDirPath) == 0) {
+                throw LaunchExecutableException();
+            }
 
-                std::ofstream of(tempFilePath, std::ios::out | std::ios::binary);
-                of.write(buffer.get(), convertRetVal - 1);
-                arguments = tempFilePath;
+            wchar_t tempFilePath[MAX_PATH + 1];
+            if (::GetTempFileNameW(tempDirPath, L"pcc", 0, tempFilePath) == 0) {
+                throw LaunchExecutableException();
             }
 
-            auto res = reinterpret_cast<size_t>(::ShellExecuteW(p_hWnd, nullptr, m_Executable.c_str(), arguments.c_str(), nullptr, SW_SHOWDEFAULT));
-            if (res <= 32) {
+            // Filelist is written once then read by the executable, so hint the system
+            // that it won't live long and will be accessed sequentially.
+            HANDLE hFile = ::CreateFileW(tempFilePath, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                                         FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+            if (hFile == INVALID_HANDLE_VALUE) {
                 throw LaunchExecutableException();
             }
+            ATL::CHandle hFilelist(hFile);
+
+            WriteFilelistContent(hFilelist, p_Paths, m_FilelistEncoding);
+
+            return tempFilePath;
+        }
+
+        //
+        // Launches executable with its standard input connected to a pipe,
+        // then writes paths in the pipe. This avoids writing a filelist to disk.
+        // Paths are written by a worker thread, since writing blocks until
+        // the executable reads them.
+        //
+        // @param p_Paths Path or paths to write, pre-bundled in a single string.
+        //
+        void LaunchExecutablePathAction::LaunchWithStdinPipe(const std::wstring& p_Paths) const
+        {
+            // Create pipe. Only the read end is inherited by the executable.
+            SECURITY_ATTRIBUTES pipeAttributes = { 0 };
+            pipeAttributes.nLength = sizeof(pipeAttributes);
+            pipeAttributes.bInheritHandle = TRUE;
+            HANDLE hRead = NULL, hWrite = NULL;
+            if (::CreatePipe(&hRead, &hWrite, &pipeAttributes, 0) == FALSE) {
+                throw LaunchExecutableException();
+            }
+            ATL::CHandle hPipeRead(hRead);
+            ATL::CHandle hPipeWrite(hWrite);
+            if (::SetHandleInformation(hPipeWrite, HANDLE_FLAG_INHERIT, 0) == FALSE) {
+                throw LaunchExecutableException();
+            }
+
+            // Launch executable with the pipe as standard input.
+            std::wstring commandLine = L"\"" + m_Executable + L"\"";
+            PROCESS_INFORMATION processInfo = { 0 };
+            if (!CreateProcessWithStdInput(commandLine, hPipeRead, processInfo)) {
+                throw LaunchExecutableException();
+            }
+            ::CloseHandle(processInfo.hThread);
+            ::CloseHandle(processInfo.hProcess);
+
+            // Executable has its own copy of the read end now. We need to close
+            // ours so that writes fail if the executable exits without reading.
+            hPipeRead.Close();
+
+            // Write paths in the pipe on a worker thread, since the executable might take time to read them.
+            WriteFilelistContentInBackground(hPipeWrite, p_Paths, m_FilelistEncoding);
+        }
+
+        //
+        // Attempts to send paths to a running instance of the executable,
+        // through the endpoint configured for this action.
+        //
+        // For named pipes, paths are written using the filelist encoding
+        // and the pipe is closed afterwards. For windows, paths are sent
+        // via WM_COPYDATA as a null-terminated UTF-16 string; the window
+        // must return TRUE to accept them.
+        //
+        // @param p_Paths Path or paths to send, pre-bundled in a single string.
+        // @param p_hWnd Parent window handle, passed along with WM_COPYDATA.
+        // @return true if paths were sent to a running instance, false if
+        //         no instance could be reached and we need to launch one.
+        //
+        bool LaunchExecutablePathAction::SendToRunningInstance(const std::wstring& p_Paths,
+                                                               const HWND          p_hWnd) const
+        {
+            bool sent = false;
+            if (m_InstanceEndpoint == InstanceEndpoint::NamedPipe && !m_InstanceEndpointName.empty()) {
+                // Accept names with or without the pipe prefix.
+                std::wstring pipeName = m_InstanceEndpointName;
+                if (pipeName.compare(0, std::wcslen(NAMED_PIPE_PREFIX), NAMED_PIPE_PREFIX) != 0) {
+                    pipeName.insert(0, NAMED_PIPE_PREFIX);
+                }
+
+                // If all pipe instances are busy, wait a bit for one to be available.
+                HANDLE hPipe = ::CreateFileW(pipeName.c_str(), GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, 0, nullptr);
+                if (hPipe == INVALID_HANDLE_VALUE && ::GetLastError() == ERROR_PIPE_BUSY &&
+                    ::WaitNamedPipeW(pipeName.c_str(), RUNNING_INSTANCE_TIMEOUT_MS) != FALSE) {
+
+                    hPipe = ::CreateFileW(pipeName.c_str(), GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, 0, nullptr);
+                }
+                if (hPipe != INVALID_HANDLE_VALUE) {
+                    ATL::CHandle hInstancePipe(hPipe);
+                    WriteFilelistContentInBackground(hInstancePipe, p_Paths, m_FilelistEncoding);
+                    sent = true;
+                }
+            } else if (m_InstanceEndpoint == InstanceEndpoint::WindowClass && !m_InstanceEndpointName.empty()) {
+                HWND hInstanceWnd = ::FindWindowW(m_InstanceEndpointName.c_str(), nullptr);
+                if (hInstanceWnd != nullptr) {
+                    COPYDATASTRUCT copyData = { 0 };
+                    copyData.cbData = static_cast<DWORD>((p_Paths.size() + 1) * sizeof(wchar_t));
+                    copyData.lpData = const_cast<wchar_t*>(p_Paths.c_str());
+                    DWORD_PTR accepted = FALSE;
+                    sent = ::SendMessageTimeoutW(hInstanceWnd, WM_COPYDATA, reinterpret_cast<WPARAM>(p_hWnd),
+                                                 reinterpret_cast<LPARAM>(&copyData), SMTO_ABORTIFHUNG,
+                                                 RUNNING_INSTANCE_TIMEOUT_MS, &accepted) != 0 && accepted != FALSE;
+                }
+            }
+            return sent;
+        }
+
+        //
+        // Launches executable once per batch of paths, each batch fitting in
+        // a command line. Each path is passed as a separate argument, quoted
+        // as needed. Batches are launched by a worker thread, since it
+        // needs to wait for batches to finish to limit how many run at once.
+        //
+        // @param p_vPaths Paths to pass to the executable.
+        //
+        void LaunchExecutablePathAction::LaunchInBatches(const WStringV& p_vPaths) const
+        {
+            WStringV vBatches = SplitInBatches(m_Executable, p_vPaths);
+
+            // If everything fits in one batch, launch it right away so that errors can be reported.
+            if (vBatches.size() == 1) {
+                RunBatches(m_Executable, vBatches, 1);
+            } else {
+                auto runBatches = [](const std::wstring& p_Executable, const WStringV& p_vBatchArguments,
+                                     const size_t p_MaxParallelBatches) {
+                    try {
+                        StCoInitialize coInit(COINIT_APARTMENTTHREADED | COINIT_DISABLE_OLE1DDE);
+                        RunBatches(p_Executable, p_vBatchArguments, p_MaxParallelBatches);
+                    } catch (...) {
+                        // Can't report errors from worker thread, remaining batches are skipped.
+                    }
+                    ATL::_pAtlModule->Unlock();
+                };
+
+                // The worker thread can outlive our caller, so make sure
+                // our DLL is not unloaded before it completes.
+                ATL::_pAtlModule->Lock();
+                try {
+                    std::thread(runBatches, m_Executable, std::move(vBatches), m_MaxParallelBatches).detach();
+                } catch (...) {
+                    ATL::_pAtlModule->Unlock();
+                    throw LaunchExecutableException();
+                }
+            }
         }
 
         //
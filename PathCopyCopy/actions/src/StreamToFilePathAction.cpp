@@ -0,0 +1,311 @@
+// StreamToFilePathAction.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <stdafx.h>
+#include <StreamToFilePathAction.h>
+
+#include <algorithm>
+#include <cwchar>
+#include <string>
+#include <vector>
+
+#include <atlbase.h>
+#include <shobjidl.h>
+#include <windows.h>
+
+
+namespace
+{
+    const size_t    OUTPUT_CHUNK_SIZE           = 32768;    // Number of characters buffered before being converted and written.
+    const size_t    MAX_BYTES_PER_CHAR          = 4;        // Maximum number of bytes needed to convert one character to a multibyte code page.
+    const wchar_t   UTF16_BOM                   = L'\xFEFF';
+    const wchar_t   OUTPUT_LINE_SEPARATOR[]     = L"\r\n";  // Separator written after each path.
+    const wchar_t   OUTPUT_FILE_EXTENSION[]     = L"txt";   // Default extension of files chosen by the user.
+
+    //
+    // BufferedFileWriter
+    //
+    // Writes text to a file sequentially through a fixed-size buffer,
+    // converting it to the output encoding one buffer at a time.
+    //
+    class BufferedFileWriter final
+    {
+    public:
+        typedef PCC::Actions::StreamToFilePathAction::OutputEncoding OutputEncoding;
+
+        //
+        // Constructor. Writes the BOM if the encoding needs one.
+        //
+        // @param p_hFile Handle of file to write to.
+        // @param p_Encoding Encoding of output file.
+        //
+        BufferedFileWriter(HANDLE const p_hFile,
+                           const OutputEncoding p_Encoding)
+            : m_hFile(p_hFile),
+              m_IsUTF16(p_Encoding == OutputEncoding::UTF16LE),
+              m_CodePage(p_Encoding == OutputEncoding::UTF8 ? CP_UTF8 : CP_ACP),
+              m_vBuffer(),
+              m_vConverted()
+        {
+            m_vBuffer.reserve(OUTPUT_CHUNK_SIZE);
+            if (m_IsUTF16) {
+                WriteToFile(&UTF16_BOM, sizeof(UTF16_BOM));
+            } else {
+                m_vConverted.resize(OUTPUT_CHUNK_SIZE * MAX_BYTES_PER_CHAR);
+            }
+        }
+
+        BufferedFileWriter(const BufferedFileWriter&) = delete;
+        BufferedFileWriter& operator=(const BufferedFileWriter&) = delete;
+
+        //
+        // Writes text to the file, flushing the buffer as it fills up.
+        //
+        // @param p_pText Text to write.
+        // @param p_Size Number of characters to write.
+        //
+        void Write(const wchar_t* p_pText,
+                   size_t p_Size)
+        {
+            while (p_Size != 0) {
+                const size_t copySize = (std::min)(p_Size, OUTPUT_CHUNK_SIZE - m_vBuffer.size());
+                m_vBuffer.insert(m_vBuffer.end(), p_pText, p_pText + copySize);
+                p_pText += copySize;
+                p_Size -= copySize;
+                if (m_vBuffer.size() == OUTPUT_CHUNK_SIZE) {
+                    Flush(false);
+                }
+            }
+        }
+
+        //
+        // Converts and writes buffered text to the file.
+        //
+        // @param p_Final Whether this is the last flush. Otherwise, a trailing high
+        //                surrogate is kept for the next flush, since it can't be
+        //                converted without the character that follows it.
+        //
+        void Flush(const bool p_Final)
+        {
+            size_t flushSize = m_vBuffer.size();
+            if (!p_Final && flushSize != 0 && IS_HIGH_SURROGATE(m_vBuffer[flushSize - 1])) {
+                --flushSize;
+            }
+            if (flushSize != 0) {
+                if (m_IsUTF16) {
+                    WriteToFile(m_vBuffer.data(), static_cast<DWORD>(flushSize * sizeof(wchar_t)));
+                } else {
+                    const int convertedSize = ::WideCharToMultiByte(m_CodePage, 0, m_vBuffer.data(), static_cast<int>(flushSize),
+                                                                    m_vConverted.data(), static_cast<int>(m_vConverted.size()),
+                                                                    nullptr, nullptr);
+                    if (convertedSize == 0) {
+                        throw PCC::Actions::StreamToFileException();
+                    }
+                    WriteToFile(m_vConverted.data(), static_cast<DWORD>(convertedSize));
+                }
+                m_vBuffer.erase(m_vBuffer.begin(), m_vBuffer.begin() + flushSize);
+            }
+        }
+
+    private:
+        HANDLE              m_hFile;        // Handle of file to write to.
+        bool                m_IsUTF16;      // Whether text is written as UTF-16LE.
+        UINT                m_CodePage;     // Code page to convert text to, if not UTF-16LE.
+        std::vector<wchar_t>
+                            m_vBuffer;      // Text not written yet.
+        std::vector<char>   m_vConverted;   // Buffer used to convert text, if not UTF-16LE.
+
+        //
+        // Writes data to the file, throwing if it can't be written entirely.
+        //
+        // @param p_pData Data to write.
+        // @param p_DataSize Size of data to write, in bytes.
+        //
+        void WriteToFile(const void* const p_pData,
+                         const DWORD p_DataSize)
+        {
+            DWORD written = 0;
+            if (::WriteFile(m_hFile, p_pData, p_DataSize, &written, nullptr) == FALSE || written != p_DataSize) {
+                throw PCC::Actions::StreamToFileException();
+            }
+        }
+    };
+
+    //
+    // Creates the output file, replacing it if it exists.
+    //
+    // @param p_OutputFile Path of file to create.
+    // @param p_rhFile Where to store the handle of the file.
+    //
+    void CreateOutputFile(const std::wstring& p_OutputFile,
+                          ATL::CHandle& p_rhFile)
+    {
+        // File is written sequentially, so hint the system.
+        HANDLE hFile = ::CreateFileW(p_OutputFile.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                                     FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (hFile == INVALID_HANDLE_VALUE) {
+            throw PCC::Actions::StreamToFileException();
+        }
+        p_rhFile.Attach(hFile);
+    }
+
+} // anonymous namespace
+
+namespace PCC
+{
+    namespace Actions
+    {
+        //
+        // Constructor.
+        //
+        // @param p_OutputFile Path of file to write paths to. Environment variables
+        //                     are expanded. If empty, user is asked to choose a file.
+        // @param p_Encoding Encoding of output file.
+        //
+        StreamToFilePathAction::StreamToFilePathAction(const std::wstring&  p_OutputFile,
+                                                       const OutputEncoding p_Encoding)
+            : PCC::PathAction(),
+              m_OutputFile(p_OutputFile),
+              m_Encoding(p_Encoding)
+        {
+        }
+
+        //
+        // Writes paths to the output file as-is.
+        //
+        // @param p_Paths Path or paths to write, pre-bundled in a single string.
+        // @param p_hWnd Parent window handle, used when asking the user for a file.
+        //
+        void StreamToFilePathAction::Act(const std::wstring& p_Paths,
+                                         const HWND          p_hWnd) const
+        {
+            std::wstring outputFile;
+            if (GetOutputFile(p_hWnd, outputFile)) {
+                ATL::CHandle hFile;
+                CreateOutputFile(outputFile, hFile);
+                BufferedFileWriter writer(hFile, m_Encoding);
+                writer.Write(p_Paths.c_str(), p_Paths.size());
+                writer.Flush(true);
+            }
+        }
+
+        //
+        // Writes individual paths to the output file, one per line. The paths
+        // writer is not used, so that paths are never bundled in a single string;
+        // paths are copied in our buffer and written as it fills up instead.
+        // Paths are only bundled if individual paths are not available.
+        //
+        // @param p_vPaths Individual paths, as returned by the plugin.
+        // @param p_PathsSize Number of characters that will be written by p_PathsWriter.
+        // @param p_PathsWriter Function that writes paths in a buffer.
+        // @param p_hWnd Parent window handle, used when asking the user for a file.
+        //
+        void StreamToFilePathAction::ActOnWrittenPaths(const WStringV&               p_vPaths,
+                                                       const std::wstring::size_type p_PathsSize,
+                                                       const PathsWriter&            p_PathsWriter,
+                                                       const HWND                    p_hWnd) const
+        {
+            if (!p_vPaths.empty()) {
+                std::wstring outputFile;
+                if (GetOutputFile(p_hWnd, outputFile)) {
+                    ATL::CHandle hFile;
+                    CreateOutputFile(outputFile, hFile);
+                    BufferedFileWriter writer(hFile, m_Encoding);
+                    const size_t separatorSize = std::wcslen(OUTPUT_LINE_SEPARATOR);
+                    for (const std::wstring& path : p_vPaths) {
+                        writer.Write(path.c_str(), path.size());
+                        writer.Write(OUTPUT_LINE_SEPARATOR, separatorSize);
+                    }
+                    writer.Flush(true);
+                }
+            } else {
+                PathAction::ActOnWrittenPaths(p_vPaths, p_PathsSize, p_PathsWriter, p_hWnd);
+            }
+        }
+
+        //
+        // Determines the path of the file to write to. If we have no output
+        // file, asks the user to choose one.
+        //
+        // @param p_hWnd Parent window handle, used when asking the user for a file.
+        // @param p_rOutputFile Where to store the path of the output file.
+        // @return true if we have an output file, false if the user cancelled.
+        //
+        bool StreamToFilePathAction::GetOutputFile(const HWND p_hWnd,
+                                                   std::wstring& p_rOutputFile) const
+        {
+            bool hasOutputFile = false;
+            p_rOutputFile.clear();
+
+            if (!m_OutputFile.empty()) {
+                const DWORD expandedSize = ::ExpandEnvironmentStringsW(m_OutputFile.c_str(), nullptr, 0);
+                if (expandedSize == 0) {
+                    throw StreamToFileException();
+                }
+                std::vector<wchar_t> vExpanded(expandedSize);
+                if (::ExpandEnvironmentStringsW(m_OutputFile.c_str(), vExpanded.data(), expandedSize) == 0) {
+                    throw StreamToFileException();
+                }
+                p_rOutputFile = vExpanded.data();
+                hasOutputFile = true;
+            } else {
+                ATL::CComPtr<IFileSaveDialog> spSaveDialog;
+                if (FAILED(spSaveDialog.CoCreateInstance(CLSID_FileSaveDialog))) {
+                    throw StreamToFileException();
+                }
+                const COMDLG_FILTERSPEC fileTypes[] = {
+                    { L"Text files (*.txt)",    L"*.txt" },
+                    { L"All files (*.*)",       L"*.*"   },
+                };
+                spSaveDialog->SetFileTypes(static_cast<UINT>(sizeof(fileTypes) / sizeof(fileTypes[0])), fileTypes);
+                spSaveDialog->SetDefaultExtension(OUTPUT_FILE_EXTENSION);
+                const HRESULT hRes = spSaveDialog->Show(p_hWnd);
+                if (SUCCEEDED(hRes)) {
+                    ATL::CComPtr<IShellItem> spItem;
+                    LPWSTR pFilePath = nullptr;
+                    if (FAILED(spSaveDialog->GetResult(&spItem)) || FAILED(spItem->GetDisplayName(SIGDN_FILESYSPATH, &pFilePath))) {
+                        throw StreamToFileException();
+                    }
+                    p_rOutputFile = pFilePath;
+                    ::CoTaskMemFree(pFilePath);
+                    hasOutputFile = true;
+                } else if (hRes != HRESULT_FROM_WIN32(ERROR_CANCELLED)) {
+                    throw StreamToFileException();
+                }
+            }
+
+            return hasOutputFile;
+        }
+
+        //
+        // Returns a textual description of the exception.
+        //
+        // @return Exception textual description.
+        //
+        const char* StreamToFileException::what() const
+        {
+            return "StreamToFileException";
+        }
+
+    } // namespace Actions
+
+} // namespace PCC
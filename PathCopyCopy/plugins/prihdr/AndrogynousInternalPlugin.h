@@ -44,7 +44,7 @@ namespace PCC
             AndrogynousInternalPlugin&
                                     operator=(const AndrogynousInternalPlugin&) = delete;
 
-            virtual std::wstring    Description() const override;
+            virtual std::wstring    Description(const ConversionContext& p_Context) const override;
 
         protected:
             ATL::CStringW           m_AndrogynousDescriptionString;     // String containing plugin androgynous description.
@@ -58,9 +58,10 @@ namespace PCC
                                     // If this method returns true, the plugin's androgynous description
                                     // is used. If it returns false, its normal description is used.
                                     //
+                                    // @param p_Context Context in which the plugin is used.
                                     // @return true to use androgynous description, false to use normal description.
                                     //
-            virtual bool            IsAndrogynous() const = 0;
+            virtual bool            IsAndrogynous(const ConversionContext& p_Context) const = 0;
         };
 
     } // namespace Plugins
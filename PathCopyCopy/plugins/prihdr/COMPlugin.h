@@ -21,10 +21,14 @@
 
 #pragma once
 
+#include <COMPluginHostMessage.h>
 #include <PathCopyCopy_i.h>
 #include <Plugin.h>
 
 #include <exception>
+#include <map>
+#include <mutex>
+#include <string>
 
 #include <atlcomcli.h>
 
@@ -33,44 +37,127 @@ namespace PCC
 {
     namespace Plugins
     {
+        //
+        // COMPluginEnabledScope
+        //
+        // Scope of the results returned by a COM plugin's Enabled method
+        // (see IPathCopyCopyPluginStateScope). Values match those of the interface.
+        //
+        enum class COMPluginEnabledScope : ULONG
+        {
+            File        = 0,    // Result depends on the selected file; never cached.
+            Folder      = 1,    // Result only depends on the parent folder.
+            Extension   = 2,    // Result only depends on the file extension.
+            Always      = 3,    // Result never changes.
+        };
+
+        //
+        // COMPluginMetadata
+        //
+        // Metadata of a COM plugin used to build menus.
+        //
+        struct COMPluginMetadata
+        {
+            std::wstring            m_Description;      // Plugin description.
+            ULONG                   m_GroupId;          // ID of plugin group, or 0 if not supported.
+            ULONG                   m_GroupPosition;    // Position of plugin in its group, or 0 if not supported.
+            std::wstring            m_IconFile;         // Path to plugin icon file, or empty if not specified.
+            bool                    m_UseDefaultIcon;   // Whether to use default icon for plugin.
+            COMPluginEnabledScope   m_EnabledScope;     // Scope of results of plugin's Enabled method.
+            bool                    m_FreeThreaded;     // Whether plugin can be called from multiple threads at once.
+            ULONG                   m_PathCacheTimeToLive;
+                                                        // Time during which plugin's paths can be reused, in milliseconds (0 if never).
+
+                                    COMPluginMetadata();
+        };
+
         //
         // COMPlugin
         //
         // Plugin that wraps a COM plugin implementation.
+        // Metadata used to build menus (description, group info and icon)
+        // is either fetched once upon construction or provided by the caller
+        // (usually from a cache); in the latter case, the COM plugin instance
+        // is only created when it is actually needed.
+        //
+        // An isolated plugin is not loaded in our process; instead, all calls
+        // are forwarded to the COM plugin host (see COMPluginHost).
+        //
+        // If the plugin declares the scope of its enabled state (see
+        // COMPluginEnabledScope), results of Enabled are remembered for the
+        // lifetime of the instance, which is usually pooled (see COMPluginPool).
+        //
+        // Paths returned by the plugin are only cached between operations (see
+        // PathResultCache) if the plugin allows it (see IPathCopyCopyPluginPathCaching).
+        //
+        // If the plugin declares itself free-threaded (see IPathCopyCopyPluginThreading),
+        // large selections are converted in parallel by calling it from worker
+        // threads, without marshalling. Isolated plugins are always called serially.
         //
         class COMPlugin final : public Plugin
         {
         public:
-            explicit                COMPlugin(const CLSID& p_CLSID);
+            explicit                COMPlugin(const CLSID& p_CLSID,
+                                              const bool p_Isolated = false);
+                                    COMPlugin(const CLSID& p_CLSID,
+                                              const COMPluginMetadata& p_Metadata,
+                                              const bool p_Isolated = false);
                                     COMPlugin(const COMPlugin&) = delete;
             COMPlugin&              operator=(const COMPlugin&) = delete;
 
             virtual const GUID&     Id() const override;
             ULONG                   GroupId() const;
             ULONG                   GroupPosition() const;
+            const COMPluginMetadata& GetMetadata() const;
+            bool                    Isolated() const;
 
-            virtual std::wstring    Description() const override;
+            virtual std::wstring    Description(const ConversionContext& p_Context) const override;
             virtual std::wstring    HelpText() const override;
             virtual std::wstring    IconFile() const override;
             virtual bool            UseDefaultIcon() const override;
             virtual bool            Enabled(const std::wstring& p_ParentPath,
-                                            const std::wstring& p_File) const override;
+                                            const std::wstring& p_File,
+                                            const ConversionContext& p_Context) const override;
 
-            virtual std::wstring    GetPath(const std::wstring& p_File) const override;
+            virtual std::wstring    GetPath(const std::wstring& p_File,
+                                            const ConversionContext& p_Context) const override;
+            virtual WStringV        GetPaths(const FilesV& p_vFiles,
+                                             const ConversionContext& p_Context) const override;
 
             virtual bool            CanDropRedundantWords() const override;
+            virtual PluginCost      CostClass(const ConversionContext& p_Context) const override;
+            virtual bool            CanGetPathsConcurrently(const ConversionContext& p_Context) const override;
+            virtual DWORD           PathCacheTimeToLive(const ConversionContext& p_Context) const override;
 
         private:
             GUID                    m_Id;               // Unique plugin ID.
-            ATL::CComPtr<IPathCopyCopyPlugin>
-                                    m_cpPlugin;         // Pointer to COM plugin implementation.
-            ATL::CComQIPtr<IPathCopyCopyPluginGroupInfo>
+            mutable ATL::CComPtr<IPathCopyCopyPlugin>
+                                    m_cpPlugin;         // Pointer to COM plugin implementation. NULL until activated.
+            mutable ATL::CComQIPtr<IPathCopyCopyPluginGroupInfo>
                                     m_cpPluginGroup;    // Reference to grouping interface implementation. Can be NULL.
-            ATL::CComQIPtr<IPathCopyCopyPluginStateInfo>
+            mutable ATL::CComQIPtr<IPathCopyCopyPluginStateInfo>
                                     m_cpPluginState;    // Reference to state changing interface implementation. Can be NULL.
-            ATL::CComQIPtr<IPathCopyCopyPluginIconInfo>
+            mutable ATL::CComQIPtr<IPathCopyCopyPluginIconInfo>
                                     m_cpPluginIcon;     // Reference to icon interface implementation. Can be NULL.
-            std::wstring            m_Description;      // Plugin description.
+            mutable ATL::CComQIPtr<IPathCopyCopyPluginBatch>
+                                    m_cpPluginBatch;    // Reference to batch interface implementation. Can be NULL.
+            mutable HRESULT         m_ActivationResult; // Result of plugin activation, or S_FALSE if not attempted yet.
+            COMPluginMetadata       m_Metadata;         // Plugin metadata used to build menus.
+            bool                    m_Isolated;         // Whether plugin is loaded in the COM plugin host.
+            mutable std::map<std::wstring, bool>
+                                    m_mEnabledStates;   // Cached results of Enabled, per scope key.
+            mutable std::mutex      m_EnabledLock;      // Lock protecting m_mEnabledStates.
+
+            HRESULT                 Activate() const;
+            bool                    GetEnabledScopeKey(const std::wstring& p_ParentPath,
+                                                       const std::wstring& p_File,
+                                                       std::wstring& p_rKey) const;
+            bool                    QueryEnabled(const std::wstring& p_ParentPath,
+                                                 const std::wstring& p_File,
+                                                 bool& p_rEnabled) const;
+            COMPluginHostMessage    NewHostRequest(const COMPluginHostMessage::Command p_Command) const;
+            static COMPluginHostMessage
+                                    CallHost(const COMPluginHostMessage& p_Request);
         };
 
         //
@@ -83,6 +170,8 @@ namespace PCC
         public:
             explicit                COMPluginError(const HRESULT p_Result);
 
+            HRESULT                 Result() const;
+
             virtual const char*     what() const override;
 
         private:
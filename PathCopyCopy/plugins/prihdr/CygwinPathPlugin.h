@@ -36,6 +36,9 @@ namespace PCC
         //
         // D:\Windows\Notepad.exe   =>   /cygdrive/d/Windows/Notepad.exe
         //
+        // If Cygwin is installed, its mount table (including the cygdrive
+        // prefix and the mounts listed in /etc/fstab) is used instead.
+        //
         // For more info about Cygwin, see http://www.cygwin.com/
         //
         class CygwinPathPlugin : public UnixPathPlugin
@@ -47,7 +50,10 @@ namespace PCC
 
             virtual const GUID&     Id() const override;
 
-            virtual std::wstring    GetPath(const std::wstring& p_File) const override;
+            virtual std::wstring    GetPath(const std::wstring& p_File,
+                                            const ConversionContext& p_Context) const override;
+            virtual WStringV        GetPaths(const FilesV& p_vFiles,
+                                             const ConversionContext& p_Context) const override;
         };
 
     } // namespace Plugins
@@ -46,7 +46,7 @@ namespace PCC
             virtual bool            CanDropRedundantWords() const override;
 
         protected:
-            virtual bool            IsAndrogynous() const override;
+            virtual bool            IsAndrogynous(const ConversionContext& p_Context) const override;
         };
 
     } // namespace Plugins
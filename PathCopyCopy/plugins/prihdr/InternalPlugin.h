@@ -23,7 +23,9 @@
 
 #include <Plugin.h>
 
+#include <mutex>
 #include <string>
+#include <unordered_map>
 
 #include <atlstr.h>
 
@@ -45,15 +47,27 @@ namespace PCC
                                     InternalPlugin(const InternalPlugin&) = delete;
             InternalPlugin&         operator=(const InternalPlugin&) = delete;
 
-            virtual std::wstring    Description() const override;
+            virtual std::wstring    Description(const ConversionContext& p_Context) const override;
             virtual std::wstring    HelpText() const override;
 
+            virtual PluginCost      CostClass(const ConversionContext& p_Context) const override;
+
         protected:
             ATL::CStringW           m_DescriptionString;    // String containing plugin description.
             ATL::CStringW           m_HelpTextString;       // String containing plugin help text.
 
                                     InternalPlugin(const unsigned short p_DescriptionStringResourceID,
                                                    const unsigned short p_HelpTextStringResourceID);
+
+            static const ATL::CStringW&
+                                    GetResourceString(const unsigned short p_StringResourceID);
+
+        private:
+            typedef std::unordered_map<unsigned short, ATL::CStringW>
+                                    ResourceStringM;        // Map of resource strings, per resource ID.
+
+            static ResourceStringM  s_mResourceStrings;     // Resource strings loaded so far by any internal plugin.
+            static std::mutex       s_ResourceStringsLock;  // Lock to protect the static map.
         };
 
     } // namespace Plugins
@@ -44,15 +44,23 @@ namespace PCC
             virtual const GUID&     Id() const override;
 
             virtual bool            Enabled(const std::wstring& p_ParentPath,
-                                            const std::wstring& p_File) const override;
-
-            virtual std::wstring    GetPath(const std::wstring& p_File) const override;
+                                            const std::wstring& p_File,
+                                            const ConversionContext& p_Context) const override;
 
         protected:
                                     InternetPathPlugin(const unsigned short p_DescriptionStringResourceID,
                                                        const unsigned short p_HelpTextStringResourceID);
 
-            virtual bool            IsAndrogynous() const override;
+            virtual bool            IsAndrogynous(const ConversionContext& p_Context) const override;
+
+            virtual std::wstring    GetUNCPath(const std::wstring& p_File,
+                                               UNCPathResolver& p_rResolver,
+                                               const ConversionContext& p_Context) const override;
+
+            static std::wstring     BuildURI(const std::wstring& p_Path,
+                                             const wchar_t* const p_pLocalPrefix,
+                                             const wchar_t* const p_pNetworkPrefix,
+                                             const WStringWStringUM* const p_pServerAliases);
         };
 
     } // namespace Plugins
@@ -45,10 +45,11 @@ namespace PCC
 
             virtual const GUID&     Id() const override;
 
-            virtual std::wstring    GetPath(const std::wstring& p_File) const override;
+            virtual std::wstring    GetPath(const std::wstring& p_File,
+                                            const ConversionContext& p_Context) const override;
 
         protected:
-            virtual bool            IsAndrogynous() const override;
+            virtual bool            IsAndrogynous(const ConversionContext& p_Context) const override;
         };
 
     } // namespace Plugins
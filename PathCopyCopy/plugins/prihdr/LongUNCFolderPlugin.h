@@ -23,6 +23,7 @@
 
 #include "LongPathPlugin.h"
 #include <PathCopyCopySettings.h>
+#include <UNCPathResolver.h>
 
 
 namespace PCC
@@ -48,19 +49,31 @@ namespace PCC
             virtual const GUID&     Id() const override;
 
             virtual bool            Enabled(const std::wstring& p_ParentPath,
-                                            const std::wstring& p_File) const override;
+                                            const std::wstring& p_File,
+                                            const ConversionContext& p_Context) const override;
 
-            virtual std::wstring    GetPath(const std::wstring& p_File) const override;
+            virtual std::wstring    GetPath(const std::wstring& p_File,
+                                            const ConversionContext& p_Context) const override;
+            virtual WStringV        GetPaths(const FilesV& p_vFiles,
+                                             const ConversionContext& p_Context) const override;
+
+            virtual PluginCost      CostClass(const ConversionContext& p_Context) const override;
 
         protected:
                                     LongUNCFolderPlugin(const unsigned short p_DescriptionStringResourceID,
                                                         const unsigned short p_AndrogynousDescriptionStringResourceID,
                                                         const unsigned short p_HelpTextStringResourceID);
 
-            virtual bool            IsAndrogynous() const override;
+            virtual bool            IsAndrogynous(const ConversionContext& p_Context) const override;
+
+            virtual std::wstring    GetUNCPath(const std::wstring& p_File,
+                                               UNCPathResolver& p_rResolver,
+                                               const ConversionContext& p_Context) const;
 
             bool                    InternalGetPath(std::wstring& p_rPath,
-                                                    const bool p_ExtractFolder) const;
+                                                    const bool p_ExtractFolder,
+                                                    UNCPathResolver& p_rResolver,
+                                                    const ConversionContext& p_Context) const;
         };
 
     } // namespace Plugins
@@ -36,6 +36,9 @@ namespace PCC
         //
         // D:\Windows\Notepad.exe   =>   /d/Windows/Notepad.exe
         //
+        // If MSYS2 is installed, its mount table (including the cygdrive
+        // prefix and the mounts listed in /etc/fstab) is used instead.
+        //
         class MSYSPathPlugin : public UnixPathPlugin
         {
         public:
@@ -45,7 +48,10 @@ namespace PCC
 
             virtual const GUID&     Id() const override;
 
-            virtual std::wstring    GetPath(const std::wstring& p_File) const override;
+            virtual std::wstring    GetPath(const std::wstring& p_File,
+                                            const ConversionContext& p_Context) const override;
+            virtual WStringV        GetPaths(const FilesV& p_vFiles,
+                                             const ConversionContext& p_Context) const override;
         };
 
     } // namespace Plugins
@@ -0,0 +1,72 @@
+// OneDriveURLPlugin.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include "InternalPlugin.h"
+
+#include <PrefixMap.h>
+
+
+namespace PCC
+{
+    namespace Plugins
+    {
+        //
+        // OneDriveURLPlugin
+        //
+        // Plugin that returns the web URL of a file/folder synchronized
+        // with OneDrive or SharePoint, like this:
+        //
+        // C:\Users\me\OneDrive - Contoso\Docs\Plan.docx   =>
+        // https://contoso-my.sharepoint.com/personal/me_contoso_com/Documents/Docs/Plan.docx
+        //
+        // Sync roots are cached by OneDriveSyncRootCache, so conversions
+        // are in-memory string rewrites. The plugin is only enabled for
+        // files located under a sync root.
+        //
+        class OneDriveURLPlugin : public InternalPlugin
+        {
+        public:
+                                    OneDriveURLPlugin();
+                                    OneDriveURLPlugin(const OneDriveURLPlugin&) = delete;
+            OneDriveURLPlugin&      operator=(const OneDriveURLPlugin&) = delete;
+
+            virtual const GUID&     Id() const override;
+
+            virtual bool            Enabled(const std::wstring& p_ParentPath,
+                                            const std::wstring& p_File,
+                                            const ConversionContext& p_Context) const override;
+            virtual std::wstring    GetPath(const std::wstring& p_File,
+                                            const ConversionContext& p_Context) const override;
+            virtual WStringV        GetPaths(const FilesV& p_vFiles,
+                                             const ConversionContext& p_Context) const override;
+            virtual PluginCost      CostClass(const ConversionContext& p_Context) const override;
+
+        private:
+            static bool             ConvertPath(std::wstring& p_rPath,
+                                                const PrefixMap& p_SyncRoots);
+        };
+
+    } // namespace Plugins
+
+} // namespace PCC
@@ -42,31 +42,45 @@ namespace PCC
                                                        const std::wstring& p_PluginDescription,
                                                        const std::wstring& p_PluginIconFile,
                                                        const bool p_UseDefaultIcon,
+                                                       const std::wstring& p_MenuFolder,
                                                        const std::wstring& p_EncodedElements);
                                         PipelinePlugin(const PipelinePlugin&) = delete;
             PipelinePlugin&             operator=(const PipelinePlugin&) = delete;
 
             virtual const GUID&         Id() const override;
 
-            virtual std::wstring        Description() const override;
+            virtual std::wstring        Description(const ConversionContext& p_Context) const override;
             virtual std::wstring        IconFile() const override;
             virtual bool                UseDefaultIcon() const override;
+            virtual std::wstring        MenuFolder() const override;
             virtual bool                Enabled(const std::wstring& p_ParentPath,
-                                                const std::wstring& p_File) const override;
+                                                const std::wstring& p_File,
+                                                const ConversionContext& p_Context) const override;
 
-            virtual std::wstring        GetPath(const std::wstring& p_File) const override;
+            virtual std::wstring        GetPath(const std::wstring& p_File,
+                                                const ConversionContext& p_Context) const override;
+            virtual WStringV            GetPaths(const FilesV& p_vFiles,
+                                                 const ConversionContext& p_Context) const override;
             virtual std::wstring        PathsSeparator() const override;
+            virtual ExportFormat        GetExportFormat() const override;
 
             virtual PCC::PathActionSP   Action() const override;
 
+            virtual PluginCost          CostClass(const ConversionContext& p_Context) const override;
+            virtual DWORD               PathCacheTimeToLive(const ConversionContext& p_Context) const override;
             virtual bool                CanDropRedundantWords() const override;
+            virtual void                GetReferencedPlugins(GUIDV& p_rvPluginIds) const override;
 
         private:
             GUID                        m_Id;               // Plugin ID.
             std::wstring                m_Description;      // Plugin description.
             std::wstring                m_IconFile;         // Plugin icon file.
             bool                        m_UseDefaultIcon;   // Whether to use default icon for plugin.
+            std::wstring                m_MenuFolder;       // Name of nested submenu containing plugin, if any.
             PipelineSP                  m_spPipeline;       // Pipeline to execute on each path received.
+            PCC::PathActionSP           m_spAction;         // Action to perform on paths; immutable, so it is reused.
+
+            PCC::PathActionSP           CreateAction() const;
         };
 
     } // namespace Plugins
@@ -0,0 +1,70 @@
+// RepositoryPathPlugin.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include "InternalPlugin.h"
+
+
+namespace PCC
+{
+    namespace Plugins
+    {
+        //
+        // RepositoryPathPlugin
+        //
+        // Plugin that returns the path of a file/folder relative to the
+        // root of its enclosing repository (or project), like this:
+        //
+        // C:\Dev\MyProject\src\main.cpp   =>   src/main.cpp
+        //
+        // Roots are identified by the markers listed in the settings (like
+        // a .git folder) and cached by RepositoryRootCache. The plugin is
+        // only enabled for files located in a repository.
+        //
+        class RepositoryPathPlugin : public InternalPlugin
+        {
+        public:
+                                    RepositoryPathPlugin();
+                                    RepositoryPathPlugin(const RepositoryPathPlugin&) = delete;
+            RepositoryPathPlugin&   operator=(const RepositoryPathPlugin&) = delete;
+
+            virtual const GUID&     Id() const override;
+
+            virtual bool            Enabled(const std::wstring& p_ParentPath,
+                                            const std::wstring& p_File,
+                                            const ConversionContext& p_Context) const override;
+            virtual std::wstring    GetPath(const std::wstring& p_File,
+                                            const ConversionContext& p_Context) const override;
+            virtual WStringV        GetPaths(const FilesV& p_vFiles,
+                                             const ConversionContext& p_Context) const override;
+
+        private:
+            static std::wstring     GetRoot(const std::wstring& p_Parent,
+                                            const ConversionContext& p_Context);
+            static std::wstring     GetRelativePath(const std::wstring& p_File,
+                                                    const std::wstring& p_Root);
+        };
+
+    } // namespace Plugins
+
+} // namespace PCC
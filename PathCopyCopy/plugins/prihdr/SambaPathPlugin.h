@@ -34,6 +34,9 @@ namespace PCC
         // Plugin that returns path of a file/folder in Samba format, like
         // smb://path/to/file
         //
+        // Names of Windows servers can be replaced by their Samba aliases
+        // (see Settings::GetSambaServerAliases).
+        //
         class SambaPathPlugin : public InternetPathPlugin
         {
         public:
@@ -43,7 +46,10 @@ namespace PCC
 
             virtual const GUID&     Id() const override;
 
-            virtual std::wstring    GetPath(const std::wstring& p_File) const override;
+        protected:
+            virtual std::wstring    GetUNCPath(const std::wstring& p_File,
+                                               UNCPathResolver& p_rResolver,
+                                               const ConversionContext& p_Context) const override;
         };
 
     } // namespace Plugins
@@ -43,7 +43,9 @@ namespace PCC
 
             virtual const GUID&     Id() const override;
 
-            virtual std::wstring    GetPath(const std::wstring& p_File) const override;
+            virtual std::wstring    GetPath(const std::wstring& p_File,
+                                            const ConversionContext& p_Context) const override;
+            virtual PluginCost      CostClass(const ConversionContext& p_Context) const override;
         };
 
     } // namespace Plugins
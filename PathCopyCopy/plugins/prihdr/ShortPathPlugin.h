@@ -45,14 +45,18 @@ namespace PCC
 
             virtual const GUID&     Id() const override;
 
-            virtual std::wstring    GetPath(const std::wstring& p_File) const override;
+            virtual bool            Enabled(const std::wstring& p_ParentPath,
+                                            const std::wstring& p_File,
+                                            const ConversionContext& p_Context) const override;
+            virtual std::wstring    GetPath(const std::wstring& p_File,
+                                            const ConversionContext& p_Context) const override;
 
         protected:
                                     ShortPathPlugin(const unsigned short p_DescriptionStringResourceID,
                                                     const unsigned short p_AndrogynousDescriptionStringResourceID,
                                                     const unsigned short p_HelpTextStringResourceID);
 
-            virtual bool            IsAndrogynous() const override;
+            virtual bool            IsAndrogynous(const ConversionContext& p_Context) const override;
         };
 
     } // namespace Plugins
@@ -46,10 +46,12 @@ namespace PCC
 
             virtual const GUID&     Id() const override;
 
-            virtual std::wstring    GetPath(const std::wstring& p_File) const override;
-
         protected:
-            virtual bool            IsAndrogynous() const override;
+            virtual bool            IsAndrogynous(const ConversionContext& p_Context) const override;
+
+            virtual std::wstring    GetUNCPath(const std::wstring& p_File,
+                                               UNCPathResolver& p_rResolver,
+                                               const ConversionContext& p_Context) const override;
         };
 
     } // namespace Plugins
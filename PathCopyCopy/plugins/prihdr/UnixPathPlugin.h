@@ -22,6 +22,7 @@
 #pragma once
 
 #include "LongPathPlugin.h"
+#include "PosixMountTable.h"
 
 
 namespace PCC
@@ -43,13 +44,20 @@ namespace PCC
 
             virtual const GUID&     Id() const override;
 
-            virtual std::wstring    GetPath(const std::wstring& p_File) const override;
+            virtual std::wstring    GetPath(const std::wstring& p_File,
+                                            const ConversionContext& p_Context) const override;
 
         protected:
                                     UnixPathPlugin(const unsigned short p_DescriptionStringResourceID,
                                                    const unsigned short p_HelpTextStringResourceID);
 
-            virtual bool            IsAndrogynous() const override;
+            virtual bool            IsAndrogynous(const ConversionContext& p_Context) const override;
+
+            std::wstring            GetUnixPath(const std::wstring& p_File,
+                                                const ConversionContext& p_Context,
+                                                const wchar_t* const p_pDrivePrefix,
+                                                const bool p_EscapeSpaces,
+                                                const PosixMountTable* const p_pMountTable = nullptr) const;
         };
 
     } // namespace Plugins
@@ -37,6 +37,9 @@ namespace PCC
         //
         // D:\Windows\Notepad.exe   =>   /mnt/d/Windows/Notepad.exe
         //
+        // If the default distribution mounts drives elsewhere than /mnt
+        // (see automount.root in wsl.conf), that root is used instead.
+        //
         class WSLPathPlugin : public UnixPathPlugin
         {
         public:
@@ -46,7 +49,10 @@ namespace PCC
 
             virtual const GUID&     Id() const override;
 
-            virtual std::wstring    GetPath(const std::wstring& p_File) const override;
+            virtual std::wstring    GetPath(const std::wstring& p_File,
+                                            const ConversionContext& p_Context) const override;
+            virtual WStringV        GetPaths(const FilesV& p_vFiles,
+                                             const ConversionContext& p_Context) const override;
         };
 
     } // namespace Plugins
@@ -31,13 +31,14 @@ namespace PCC
         //
         // Returns plugin description, depending on whether it is androgynous or not.
         //
+        // @param p_Context Context in which the plugin is used.
         // @return Plugin description, taken from resources.
         //
-        std::wstring AndrogynousInternalPlugin::Description() const
+        std::wstring AndrogynousInternalPlugin::Description(const ConversionContext& p_Context) const
         {
             // Return description depending on whether plugin is androgynous.
-            return IsAndrogynous() ? (LPCWSTR) m_AndrogynousDescriptionString
-                                   : InternalPlugin::Description();
+            return IsAndrogynous(p_Context) ? (LPCWSTR) m_AndrogynousDescriptionString
+                                            : InternalPlugin::Description(p_Context);
         }
 
         //
@@ -51,7 +52,7 @@ namespace PCC
                                                              const unsigned short p_AndrogynousDescriptionStringResourceID,
                                                              const unsigned short p_HelpTextStringResourceID)
             : InternalPlugin(p_DescriptionStringResourceID, p_HelpTextStringResourceID),
-              m_AndrogynousDescriptionString(MAKEINTRESOURCEW(p_AndrogynousDescriptionStringResourceID))
+              m_AndrogynousDescriptionString(GetResourceString(p_AndrogynousDescriptionStringResourceID))
         {
         }
 
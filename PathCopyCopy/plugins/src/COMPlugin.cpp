@@ -21,39 +21,101 @@
 
 #include <stdafx.h>
 #include <COMPlugin.h>
+#include <COMPluginHost.h>
+#include <PathResultCache.h>
+#include <PerformanceCounters.h>
+#include <StCoInitialize.h>
+#include <Trace.h>
 
+#include <atlsafe.h>
+
+
+namespace
+{
+    // Maximum number of results of Enabled cached per plugin. When reached, cache is cleared.
+    const size_t    MAX_CACHED_ENABLED_STATES   = 256;
+
+    //
+    // Validates an enabled scope returned by a COM plugin.
+    //
+    // @param p_Scope Scope returned by the plugin.
+    // @return Scope, or PCC::Plugins::COMPluginEnabledScope::File if unknown.
+    //
+    PCC::Plugins::COMPluginEnabledScope ToEnabledScope(const ULONG p_Scope)
+    {
+        return p_Scope <= static_cast<ULONG>(PCC::Plugins::COMPluginEnabledScope::Always)
+            ? static_cast<PCC::Plugins::COMPluginEnabledScope>(p_Scope)
+            : PCC::Plugins::COMPluginEnabledScope::File;
+    }
+
+} // anonymous namespace
 
 namespace PCC
 {
     namespace Plugins
     {
+        //
+        // Default constructor for metadata.
+        //
+        COMPluginMetadata::COMPluginMetadata()
+            : m_Description(),
+              m_GroupId(0),
+              m_GroupPosition(0),
+              m_IconFile(),
+              m_UseDefaultIcon(false),
+              m_EnabledScope(COMPluginEnabledScope::File),
+              m_FreeThreaded(false),
+              m_PathCacheTimeToLive(0)
+        {
+        }
+
         //
         // Constructor. Will create an instance of the COM plugin.
         //
         // @param p_CLSID ID of COM co-class that implements the plugin.
+        // @param p_Isolated Whether to load plugin in the COM plugin host
+        //                   instead of in our process.
         //
-        COMPlugin::COMPlugin(const CLSID& p_CLSID)
+        COMPlugin::COMPlugin(const CLSID& p_CLSID,
+                             const bool p_Isolated /*= false*/)
             : Plugin(),
               m_Id(p_CLSID),
               m_cpPlugin(),
               m_cpPluginGroup(),
               m_cpPluginState(),
               m_cpPluginIcon(),
-              m_Description()
+              m_cpPluginBatch(),
+              m_ActivationResult(S_FALSE),
+              m_Metadata(),
+              m_Isolated(p_Isolated),
+              m_mEnabledStates(),
+              m_EnabledLock()
         {
+            if (m_Isolated) {
+                // Ask the host for the metadata; this makes sure the plugin works.
+                COMPluginHostMessage response = CallHost(NewHostRequest(COMPluginHostMessage::GetMetadata));
+                DWORD useDefaultIcon = 0, enabledScope = 0;
+                if (!response.ReadString(m_Metadata.m_Description) ||
+                    !response.ReadDWORD(m_Metadata.m_GroupId) ||
+                    !response.ReadDWORD(m_Metadata.m_GroupPosition) ||
+                    !response.ReadString(m_Metadata.m_IconFile) ||
+                    !response.ReadDWORD(useDefaultIcon) ||
+                    !response.ReadDWORD(enabledScope) ||
+                    !response.ReadDWORD(m_Metadata.m_PathCacheTimeToLive) ||
+                    m_Metadata.m_Description.empty()) {
+
+                    throw COMPluginError(E_UNEXPECTED);
+                }
+                m_Metadata.m_UseDefaultIcon = useDefaultIcon != 0;
+                m_Metadata.m_EnabledScope = ToEnabledScope(enabledScope);
+                return;
+            }
+
             // Immediately create the plugin instance and make sure it works.
-            HRESULT hRes = m_cpPlugin.CoCreateInstance(p_CLSID);
+            HRESULT hRes = Activate();
             if (FAILED(hRes)) {
                 throw COMPluginError(hRes);
             }
-            if (m_cpPlugin == NULL) {
-                throw COMPluginError(E_FAIL);
-            }
-
-            // Immediately query for other interface implementations. This can fail.
-            m_cpPluginGroup = m_cpPlugin;
-            m_cpPluginState = m_cpPlugin;
-            m_cpPluginIcon = m_cpPlugin;
 
             // Immediately get plugin description. It must work and return a non-empty string.
             ATL::CComBSTR bstrDescription;
@@ -64,7 +126,77 @@ namespace PCC
             if (bstrDescription == NULL || bstrDescription.Length() == 0) {
                 throw COMPluginError(E_UNEXPECTED);
             }
-            m_Description = bstrDescription.m_str;
+            m_Metadata.m_Description = bstrDescription.m_str;
+
+            // Fetch group, icon, state scope and caching info now as well, since these will be
+            // needed every time a menu is built. These calls can fail; keep defaults if so.
+            if (m_cpPluginGroup != NULL) {
+                ULONG groupId = 0, groupPos = 0;
+                if (SUCCEEDED(m_cpPluginGroup->get_GroupId(&groupId))) {
+                    m_Metadata.m_GroupId = groupId;
+                }
+                if (SUCCEEDED(m_cpPluginGroup->get_GroupPosition(&groupPos))) {
+                    m_Metadata.m_GroupPosition = groupPos;
+                }
+            }
+            if (m_cpPluginIcon != NULL) {
+                ATL::CComBSTR bstrIconFile;
+                if (SUCCEEDED(m_cpPluginIcon->get_IconFile(&bstrIconFile)) && bstrIconFile != NULL) {
+                    m_Metadata.m_IconFile = bstrIconFile.m_str;
+                }
+                VARIANT_BOOL useDefaultVar = VARIANT_FALSE;
+                if (SUCCEEDED(m_cpPluginIcon->get_UseDefaultIcon(&useDefaultVar))) {
+                    m_Metadata.m_UseDefaultIcon = useDefaultVar != VARIANT_FALSE;
+                }
+            }
+            ATL::CComQIPtr<IPathCopyCopyPluginStateScope> cpPluginStateScope(m_cpPlugin);
+            if (m_cpPluginState != NULL && cpPluginStateScope != NULL) {
+                ULONG enabledScope = 0;
+                if (SUCCEEDED(cpPluginStateScope->get_EnabledScope(&enabledScope))) {
+                    m_Metadata.m_EnabledScope = ToEnabledScope(enabledScope);
+                }
+            }
+            ATL::CComQIPtr<IPathCopyCopyPluginThreading> cpPluginThreading(m_cpPlugin);
+            if (cpPluginThreading != NULL) {
+                VARIANT_BOOL freeThreadedVar = VARIANT_FALSE;
+                if (SUCCEEDED(cpPluginThreading->get_FreeThreaded(&freeThreadedVar))) {
+                    m_Metadata.m_FreeThreaded = freeThreadedVar != VARIANT_FALSE;
+                }
+            }
+            ATL::CComQIPtr<IPathCopyCopyPluginPathCaching> cpPluginPathCaching(m_cpPlugin);
+            if (cpPluginPathCaching != NULL) {
+                ULONG timeToLive = 0;
+                if (SUCCEEDED(cpPluginPathCaching->get_PathCacheTimeToLive(&timeToLive))) {
+                    m_Metadata.m_PathCacheTimeToLive = timeToLive;
+                }
+            }
+        }
+
+        //
+        // Constructor with known metadata. The COM plugin instance will only
+        // be created when it is actually needed, e.g. to compute a path.
+        //
+        // @param p_CLSID ID of COM co-class that implements the plugin.
+        // @param p_Metadata Plugin metadata, usually fetched from a cache.
+        // @param p_Isolated Whether to load plugin in the COM plugin host
+        //                   instead of in our process.
+        //
+        COMPlugin::COMPlugin(const CLSID& p_CLSID,
+                             const COMPluginMetadata& p_Metadata,
+                             const bool p_Isolated /*= false*/)
+            : Plugin(),
+              m_Id(p_CLSID),
+              m_cpPlugin(),
+              m_cpPluginGroup(),
+              m_cpPluginState(),
+              m_cpPluginIcon(),
+              m_cpPluginBatch(),
+              m_ActivationResult(S_FALSE),
+              m_Metadata(p_Metadata),
+              m_Isolated(p_Isolated),
+              m_mEnabledStates(),
+              m_EnabledLock()
+        {
         }
 
         //
@@ -85,15 +217,8 @@ namespace PCC
         //
         ULONG COMPlugin::GroupId() const
         {
-            ULONG groupId = 0;
-            if (m_cpPluginGroup != NULL) {
-                ULONG groupId2;
-                HRESULT hRes = m_cpPluginGroup->get_GroupId(&groupId2);
-                if (SUCCEEDED(hRes)) {
-                    groupId = groupId2;
-                }
-            }
-            return groupId;
+            // Return cached group ID.
+            return m_Metadata.m_GroupId;
         }
 
         //
@@ -104,26 +229,41 @@ namespace PCC
         //
         ULONG COMPlugin::GroupPosition() const
         {
-            ULONG groupPos = 0;
-            if (m_cpPluginGroup != NULL) {
-                ULONG groupPos2;
-                HRESULT hRes = m_cpPluginGroup->get_GroupPosition(&groupPos2);
-                if (SUCCEEDED(hRes)) {
-                    groupPos = groupPos2;
-                }
-            }
-            return groupPos;
+            // Return cached group position.
+            return m_Metadata.m_GroupPosition;
+        }
+
+        //
+        // Returns the metadata of the plugin used to build menus.
+        //
+        // @return Plugin metadata.
+        //
+        const COMPluginMetadata& COMPlugin::GetMetadata() const
+        {
+            return m_Metadata;
+        }
+
+        //
+        // Checks if the plugin is loaded in the COM plugin host
+        // instead of in our process.
+        //
+        // @return true if plugin is isolated.
+        //
+        bool COMPlugin::Isolated() const
+        {
+            return m_Isolated;
         }
 
         //
         // Returns the plugin description.
         //
+        // @param p_Context Context in which the plugin is used.
         // @return Plugin description.
         //
-        std::wstring COMPlugin::Description() const
+        std::wstring COMPlugin::Description(const ConversionContext& /*p_Context*/) const
         {
             // Return cached description.
-            return m_Description;
+            return m_Metadata.m_Description;
         }
 
         //
@@ -135,10 +275,21 @@ namespace PCC
         {
             // Get plugin help text. If it doesn't work, no worry.
             std::wstring helpText;
-            ATL::CComBSTR bstrHelpText;
-            HRESULT hRes = m_cpPlugin->get_HelpText(&bstrHelpText);
-            if (SUCCEEDED(hRes) && bstrHelpText != NULL && bstrHelpText.Length() > 0) {
-                helpText = bstrHelpText.m_str;
+            if (m_Isolated) {
+                try {
+                    COMPluginHostMessage response = CallHost(NewHostRequest(COMPluginHostMessage::GetHelpText));
+                    if (!response.ReadString(helpText)) {
+                        helpText.clear();
+                    }
+                } catch (const COMPluginError&) {
+                    helpText.clear();
+                }
+            } else if (SUCCEEDED(Activate())) {
+                ATL::CComBSTR bstrHelpText;
+                HRESULT hRes = m_cpPlugin->get_HelpText(&bstrHelpText);
+                if (SUCCEEDED(hRes) && bstrHelpText != NULL && bstrHelpText.Length() > 0) {
+                    helpText = bstrHelpText.m_str;
+                }
             }
 
             // Return help text or an empty string.
@@ -152,17 +303,8 @@ namespace PCC
         //
         std::wstring COMPlugin::IconFile() const
         {
-            // Check if plugin supports specifying an icon. Otherwise return an empty string.
-            std::wstring iconFile;
-            if (m_cpPluginIcon != NULL) {
-                // Ask plugin for an icon file path.
-                ATL::CComBSTR bstrIconFile;
-                HRESULT hRes = m_cpPluginIcon->get_IconFile(&bstrIconFile);
-                if (SUCCEEDED(hRes) && bstrIconFile != NULL) {
-                    iconFile = bstrIconFile.m_str;
-                }
-            }
-            return iconFile;
+            // Return cached icon file.
+            return m_Metadata.m_IconFile;
         }
 
         //
@@ -172,40 +314,43 @@ namespace PCC
         //
         bool COMPlugin::UseDefaultIcon() const
         {
-            // Check if plugin supports specifying an icon. Otherwise return false.
-            bool useDefault = false;
-            if (m_cpPluginIcon != NULL) {
-                // Ask plugin whether to use default icon.
-                VARIANT_BOOL useDefaultVar = VARIANT_FALSE;
-                HRESULT hRes = m_cpPluginIcon->get_UseDefaultIcon(&useDefaultVar);
-                if (SUCCEEDED(hRes)) {
-                    useDefault = useDefaultVar != VARIANT_FALSE;
-                }
-            }
-            return useDefault;
+            // Return cached value.
+            return m_Metadata.m_UseDefaultIcon;
         }
 
         //
         // Returns whether plugin should be enabled in the contextual menu.
+        // If the plugin declared the scope of its state, a previous result
+        // for the same scope is reused instead of calling the plugin.
         //
         // @param p_ParentPath Path of the parent directory of files that
         //                     triggered the contextual menu.
         // @param p_File Path of one file that was selected.
+        // @param p_Context Context in which the plugin is used.
         // @return Whether plugin should be enabled or not in the contextual menu.
         //
         bool COMPlugin::Enabled(const std::wstring& p_ParentPath,
-                                const std::wstring& p_File) const
+                                const std::wstring& p_File,
+                                const ConversionContext& /*p_Context*/) const
         {
-            // Check if plugin supports state changes. Otherwise assume it is enabled.
-            bool enabled = true;
-            if (m_cpPluginState != NULL) {
-                // Ask plugin if it should be enabled. If an error
-                // code is returned, do not enable the plugin.
-                ATL::CComBSTR bstrParentPath(p_ParentPath.c_str());
-                ATL::CComBSTR bstrFile(p_File.c_str());
-                VARIANT_BOOL bEnabled = VARIANT_FALSE;
-                HRESULT hRes = m_cpPluginState->Enabled(bstrParentPath, bstrFile, &bEnabled);
-                enabled = SUCCEEDED(hRes) && hRes != S_FALSE && bEnabled != VARIANT_FALSE;
+            std::wstring scopeKey;
+            const bool cacheable = GetEnabledScopeKey(p_ParentPath, p_File, scopeKey);
+            if (cacheable) {
+                std::lock_guard<std::mutex> lock(m_EnabledLock);
+                auto it = m_mEnabledStates.find(scopeKey);
+                if (it != m_mEnabledStates.end()) {
+                    return it->second;
+                }
+            }
+
+            // Only cache actual answers from the plugin, not errors calling it.
+            bool enabled = false;
+            if (QueryEnabled(p_ParentPath, p_File, enabled) && cacheable) {
+                std::lock_guard<std::mutex> lock(m_EnabledLock);
+                if (m_mEnabledStates.size() >= MAX_CACHED_ENABLED_STATES) {
+                    m_mEnabledStates.clear();
+                }
+                m_mEnabledStates.emplace(scopeKey, enabled);
             }
             return enabled;
         }
@@ -214,15 +359,32 @@ namespace PCC
         // Transforms the given path using the plugin.
         //
         // @param p_File Full path to file.
+        // @param p_Context Context of the conversion.
         // @return Transformed path.
         //
-        std::wstring COMPlugin::GetPath(const std::wstring& p_File) const
+        std::wstring COMPlugin::GetPath(const std::wstring& p_File,
+                                        const ConversionContext& p_Context) const
         {
+            // Isolated plugins use the same host request for one or many files.
+            if (m_Isolated) {
+                return GetPaths(FilesV(1, p_File), p_Context).front();
+            }
+
+            // Make sure plugin instance exists.
+            HRESULT hRes = Activate();
+            if (FAILED(hRes)) {
+                throw COMPluginError(hRes);
+            }
+
+            // Free-threaded plugins can be called from worker threads that have not
+            // entered an apartment yet; join the MTA if so. This has no effect otherwise.
+            StCoInitialize coInitialize(COINIT_MULTITHREADED);
+
             // Call method and make sure it works.
             // Note that it is legal for the method to return NULL or an empty string.
             ATL::CComBSTR bstrPath(p_File.c_str());
             ATL::CComBSTR bstrNewPath;
-            HRESULT hRes = m_cpPlugin->GetPath(bstrPath, &bstrNewPath);
+            hRes = m_cpPlugin->GetPath(bstrPath, &bstrNewPath);
             if (FAILED(hRes)) {
                 throw COMPluginError(hRes);
             }
@@ -235,6 +397,93 @@ namespace PCC
             return newPath;
         }
 
+        //
+        // Transforms the given paths using the plugin. If the plugin supports
+        // batch transformations, all paths are transformed in a single call,
+        // which avoids the overhead of one call per file (especially for
+        // out-of-process or .NET plugins). Otherwise, calls GetPath for each file.
+        //
+        // @param p_vFiles Full paths to files.
+        // @param p_Context Context of the conversion.
+        // @return Transformed paths, in the same order.
+        //
+        WStringV COMPlugin::GetPaths(const FilesV& p_vFiles,
+                                     const ConversionContext& p_Context) const
+        {
+            // For isolated plugins, send all files to the host in a single request.
+            if (m_Isolated) {
+                COMPluginHostMessage request = NewHostRequest(COMPluginHostMessage::GetPaths);
+                request.WriteDWORD(static_cast<DWORD>(p_vFiles.size()));
+                for (const std::wstring& file : p_vFiles) {
+                    request.WriteString(file);
+                }
+                COMPluginHostMessage response = CallHost(request);
+                WStringV vPaths;
+                DWORD numPaths = 0;
+                if (!response.ReadDWORD(numPaths) || numPaths != p_vFiles.size()) {
+                    throw COMPluginError(E_UNEXPECTED);
+                }
+                vPaths.resize(numPaths);
+                for (std::wstring& path : vPaths) {
+                    if (!response.ReadString(path)) {
+                        throw COMPluginError(E_UNEXPECTED);
+                    }
+                }
+                return vPaths;
+            }
+
+            // Make sure plugin instance exists.
+            HRESULT hRes = Activate();
+            if (FAILED(hRes)) {
+                throw COMPluginError(hRes);
+            }
+            if (m_cpPluginBatch == NULL || p_vFiles.size() < 2) {
+                return Plugin::GetPaths(p_vFiles, p_Context);
+            }
+            StCoInitialize coInitialize(COINIT_MULTITHREADED);
+
+            // Pack all paths in an array and call batch method.
+            ATL::CComSafeArray<BSTR> saPaths(static_cast<ULONG>(p_vFiles.size()));
+            for (size_t i = 0; i < p_vFiles.size(); ++i) {
+                hRes = saPaths.SetAt(static_cast<LONG>(i), ATL::CComBSTR(p_vFiles[i].c_str()).Detach(), FALSE);
+                if (FAILED(hRes)) {
+                    throw COMPluginError(hRes);
+                }
+            }
+            SAFEARRAY* pNewPaths = nullptr;
+            hRes = m_cpPluginBatch->GetPaths(saPaths, &pNewPaths);
+            if (hRes == E_NOTIMPL) {
+                return Plugin::GetPaths(p_vFiles, p_Context);
+            }
+            if (FAILED(hRes)) {
+                throw COMPluginError(hRes);
+            }
+            ATL::CComSafeArray<BSTR> saNewPaths;
+            if (pNewPaths == nullptr || FAILED(saNewPaths.Attach(pNewPaths))) {
+                if (pNewPaths != nullptr) {
+                    ::SafeArrayDestroy(pNewPaths);
+                }
+                throw COMPluginError(E_UNEXPECTED);
+            }
+            if (saNewPaths.GetCount() != p_vFiles.size()) {
+                throw COMPluginError(E_UNEXPECTED);
+            }
+
+            // Unpack new paths, reusing the original paths if not provided.
+            WStringV vPaths;
+            vPaths.reserve(p_vFiles.size());
+            const LONG lowerBound = saNewPaths.GetLowerBound();
+            for (size_t i = 0; i < p_vFiles.size(); ++i) {
+                BSTR bstrNewPath = saNewPaths.GetAt(lowerBound + static_cast<LONG>(i));
+                if (bstrNewPath != NULL && ::SysStringLen(bstrNewPath) > 0) {
+                    vPaths.emplace_back(bstrNewPath, ::SysStringLen(bstrNewPath));
+                } else {
+                    vPaths.push_back(p_vFiles[i]);
+                }
+            }
+            return vPaths;
+        }
+
         //
         // Called by Path Copy Copy to know if it should honor the
         // "Drop redundant words" setting for this plugin. In our
@@ -249,6 +498,206 @@ namespace PCC
             return false;
         }
 
+        //
+        // Returns the class of cost of the work performed by this plugin.
+        // Calling a COM plugin can be expensive, especially when it is
+        // isolated. Unless it is free-threaded, it is also called serially
+        // (see CanGetPathsConcurrently).
+        //
+        // @param p_Context Context in which the plugin is used.
+        // @return PluginCost::External.
+        //
+        PluginCost COMPlugin::CostClass(const ConversionContext& /*p_Context*/) const
+        {
+            return PluginCost::External;
+        }
+
+        //
+        // Checks if Path Copy Copy can call GetPaths from multiple threads at
+        // once on this plugin. This is only possible if the plugin declared
+        // itself free-threaded and is loaded in our process. In that case, the
+        // plugin instance is created right away on the calling thread, so
+        // that worker threads can share it.
+        //
+        // @param p_Context Context in which the plugin is used.
+        // @return true if GetPaths can be called concurrently.
+        //
+        bool COMPlugin::CanGetPathsConcurrently(const ConversionContext& /*p_Context*/) const
+        {
+            return !m_Isolated && m_Metadata.m_FreeThreaded && SUCCEEDED(Activate());
+        }
+
+        //
+        // Returns for how long paths returned by this plugin can be cached.
+        // We can't know whether the plugin's paths depend on anything other
+        // than the file, so they are only cached if the plugin asked for it
+        // (see IPathCopyCopyPluginPathCaching), and never for long.
+        //
+        // @param p_Context Context in which the plugin is used.
+        // @return Time during which paths can be cached, in milliseconds.
+        //
+        DWORD COMPlugin::PathCacheTimeToLive(const ConversionContext& /*p_Context*/) const
+        {
+            return (std::min)(static_cast<DWORD>(m_Metadata.m_PathCacheTimeToLive),
+                              PathResultCache::COM_PLUGIN_PATHS_TIME_TO_LIVE);
+        }
+
+        //
+        // Creates the COM plugin instance if it hasn't been attempted yet.
+        // The result of the first attempt is remembered.
+        //
+        // @return Result of the activation.
+        //
+        HRESULT COMPlugin::Activate() const
+        {
+            if (m_ActivationResult == S_FALSE) {
+                StTraceEvent traceEvent(L"COMPlugin::Activate", &m_Id);
+                m_ActivationResult = m_cpPlugin.CoCreateInstance(m_Id);
+                if (SUCCEEDED(m_ActivationResult) && m_cpPlugin == NULL) {
+                    m_ActivationResult = E_FAIL;
+                }
+                if (SUCCEEDED(m_ActivationResult)) {
+                    // Query for other interface implementations. This can fail.
+                    m_ActivationResult = S_OK;
+                    m_cpPluginGroup = m_cpPlugin;
+                    m_cpPluginState = m_cpPlugin;
+                    m_cpPluginIcon = m_cpPlugin;
+                    m_cpPluginBatch = m_cpPlugin;
+                }
+            }
+            return m_ActivationResult;
+        }
+
+        //
+        // Computes the key identifying the scope of the plugin's enabled state
+        // for the given file, according to the scope declared by the plugin.
+        // Keys are case-insensitive since they are based on paths.
+        //
+        // @param p_ParentPath Path of the parent directory of the file.
+        // @param p_File Path of the file.
+        // @param p_rKey Where to store the scope key.
+        // @return true if results of Enabled can be cached using the key.
+        //
+        bool COMPlugin::GetEnabledScopeKey(const std::wstring& p_ParentPath,
+                                           const std::wstring& p_File,
+                                           std::wstring& p_rKey) const
+        {
+            switch (m_Metadata.m_EnabledScope) {
+                case COMPluginEnabledScope::Folder: {
+                    p_rKey = p_ParentPath;
+                    break;
+                }
+                case COMPluginEnabledScope::Extension: {
+                    // Files without an extension (including folders) share an empty key.
+                    const std::wstring::size_type dotPos = p_File.find_last_of(L"\\/.");
+                    if (dotPos != std::wstring::npos && p_File[dotPos] == L'.') {
+                        p_rKey = p_File.substr(dotPos);
+                    } else {
+                        p_rKey.clear();
+                    }
+                    break;
+                }
+                case COMPluginEnabledScope::Always: {
+                    p_rKey.clear();
+                    break;
+                }
+                default: {
+                    return false;
+                }
+            }
+            if (!p_rKey.empty()) {
+                ::CharLowerBuffW(&*p_rKey.begin(), static_cast<DWORD>(p_rKey.size()));
+            }
+            return true;
+        }
+
+        //
+        // Asks the plugin (or the COM plugin host) whether it should be enabled.
+        //
+        // @param p_ParentPath Path of the parent directory of files that
+        //                     triggered the contextual menu.
+        // @param p_File Path of one file that was selected.
+        // @param p_rEnabled Where to store whether plugin should be enabled.
+        //                   Set to false if plugin could not be called.
+        // @return true if the plugin was called, false if an error occurred
+        //         before the plugin could answer.
+        //
+        bool COMPlugin::QueryEnabled(const std::wstring& p_ParentPath,
+                                     const std::wstring& p_File,
+                                     bool& p_rEnabled) const
+        {
+            p_rEnabled = false;
+
+            // For isolated plugins, ask the host. Errors mean plugin is not enabled.
+            if (m_Isolated) {
+                DWORD enabled = 0;
+                try {
+                    COMPluginHostMessage request = NewHostRequest(COMPluginHostMessage::Enabled);
+                    request.WriteString(p_ParentPath).WriteString(p_File);
+                    COMPluginHostMessage response = CallHost(request);
+                    if (!response.ReadDWORD(enabled)) {
+                        return false;
+                    }
+                } catch (const COMPluginError&) {
+                    return false;
+                }
+                p_rEnabled = enabled != 0;
+                return true;
+            }
+
+            // If plugin cannot be activated, it cannot be used so do not enable it.
+            if (FAILED(Activate())) {
+                return false;
+            }
+
+            // Check if plugin supports state changes. Otherwise assume it is enabled.
+            p_rEnabled = true;
+            if (m_cpPluginState != NULL) {
+                // Ask plugin if it should be enabled. If an error
+                // code is returned, do not enable the plugin.
+                ATL::CComBSTR bstrParentPath(p_ParentPath.c_str());
+                ATL::CComBSTR bstrFile(p_File.c_str());
+                VARIANT_BOOL bEnabled = VARIANT_FALSE;
+                HRESULT hRes = m_cpPluginState->Enabled(bstrParentPath, bstrFile, &bEnabled);
+                p_rEnabled = SUCCEEDED(hRes) && hRes != S_FALSE && bEnabled != VARIANT_FALSE;
+            }
+            return true;
+        }
+
+        //
+        // Creates a new request for the COM plugin host for this plugin.
+        //
+        // @param p_Command Command to execute. Arguments can be added afterwards.
+        // @return New request.
+        //
+        COMPluginHostMessage COMPlugin::NewHostRequest(const COMPluginHostMessage::Command p_Command) const
+        {
+            COMPluginHostMessage request;
+            request.WriteDWORD(p_Command).WriteGUID(m_Id);
+            return request;
+        }
+
+        //
+        // Sends a request to the COM plugin host and checks the result code
+        // at the start of the response.
+        //
+        // @param p_Request Request to send.
+        // @return Response, positioned after the result code.
+        // @throw COMPluginError If the request could not be executed.
+        //
+        COMPluginHostMessage COMPlugin::CallHost(const COMPluginHostMessage& p_Request)
+        {
+            COMPluginHostMessage response = COMPluginHost::Call(p_Request);
+            DWORD result = 0;
+            if (!response.ReadDWORD(result)) {
+                throw COMPluginError(E_UNEXPECTED);
+            }
+            if (FAILED(static_cast<HRESULT>(result))) {
+                throw COMPluginError(static_cast<HRESULT>(result));
+            }
+            return response;
+        }
+
         //
         // Constructor with HRESULT.
         //
@@ -258,6 +707,17 @@ namespace PCC
             : std::exception(),
               m_Result(p_Result)
         {
+            PerformanceCounters::COMPluginFailed();
+        }
+
+        //
+        // Returns the result of the COM call that went wrong.
+        //
+        // @return Result of COM call.
+        //
+        HRESULT COMPluginError::Result() const
+        {
+            return m_Result;
         }
 
         //
@@ -23,8 +23,6 @@
 #include <CygwinPathPlugin.h>
 #include <resource.h>
 
-#include <sstream>
-
 
 namespace
 {
@@ -63,25 +61,36 @@ namespace PCC
         // Returns the Cygwin path of the specified file.
         //
         // @param p_File File path.
+        // @param p_Context Context of the conversion.
         // @return File path in Cygwin format (/cygdrive/c/...)
         //
-        std::wstring CygwinPathPlugin::GetPath(const std::wstring& p_File) const
+        std::wstring CygwinPathPlugin::GetPath(const std::wstring& p_File,
+                                               const ConversionContext& p_Context) const
         {
-            // Call parent to get Unix path.
-            std::wstring path = UnixPathPlugin::GetPath(p_File);
+            // Use Cygwin's mount table if installed, otherwise replace
+            // the drive letter with /cygdrive/letter.
+            const PosixMountTable::PosixMountTableSP spMountTable = PosixMountTable::Get(PosixMountTable::Environment::Cygwin);
+            return GetUnixPath(p_File, p_Context, CYGDRIVE_PREFIX, false, spMountTable.get());
+        }
 
-            // Check if the file begins with a drive letter. If so,
-            // remove the drive letter and replace it with /cygdrive/letter.
-            if (path.size() >= 3 && path[1] == L':') {
-                std::wstringstream newPathSS;
-                newPathSS << CYGDRIVE_PREFIX                            // The Cygwin prefix
-                          << static_cast<wchar_t>(::towlower(path[0]))  // Drive letter
-                          << path.substr(2);                            // Rest of the path, including the slash after that : we had.
-                path = newPathSS.str();
+        //
+        // Returns the Cygwin paths of the specified files. The mount table
+        // is only fetched once for all files.
+        //
+        // @param p_vFiles File paths.
+        // @param p_Context Context of the conversion.
+        // @return File paths in Cygwin format.
+        //
+        WStringV CygwinPathPlugin::GetPaths(const FilesV& p_vFiles,
+                                            const ConversionContext& p_Context) const
+        {
+            const PosixMountTable::PosixMountTableSP spMountTable = PosixMountTable::Get(PosixMountTable::Environment::Cygwin);
+            WStringV vPaths;
+            vPaths.reserve(p_vFiles.size());
+            for (const std::wstring& file : p_vFiles) {
+                vPaths.push_back(GetUnixPath(file, p_Context, CYGDRIVE_PREFIX, false, spMountTable.get()));
             }
-
-            // Return modified path.
-            return path;
+            return vPaths;
         }
 
     } // namespace Plugins
@@ -71,9 +71,10 @@ namespace PCC
         //
         // Determines if this plugin is androgynous. In our case, it never is.
         //
+        // @param p_Context Context in which the plugin is used.
         // @return true to use androgynous description, false to use normal description.
         //
-        bool DefaultPlugin::IsAndrogynous() const
+        bool DefaultPlugin::IsAndrogynous(const ConversionContext& /*p_Context*/) const
         {
             return false;
         }
@@ -27,12 +27,17 @@ namespace PCC
 {
     namespace Plugins
     {
+        // Static members
+        InternalPlugin::ResourceStringM     InternalPlugin::s_mResourceStrings;
+        std::mutex                          InternalPlugin::s_ResourceStringsLock;
+
         //
         // Returns plugin description.
         //
+        // @param p_Context Context in which the plugin is used.
         // @return Plugin description, taken from resources.
         //
-        std::wstring InternalPlugin::Description() const
+        std::wstring InternalPlugin::Description(const ConversionContext& /*p_Context*/) const
         {
             return (LPCWSTR) m_DescriptionString;
         }
@@ -47,6 +52,20 @@ namespace PCC
             return (LPCWSTR) m_HelpTextString;
         }
 
+        //
+        // Returns the class of cost of the work performed by this plugin.
+        // Internal plugins only use stateless Win32 primitives and settings
+        // reads, so they can all be used concurrently; most of them query
+        // the file system. Plugins doing more or less work override this.
+        //
+        // @param p_Context Context in which the plugin is used.
+        // @return PluginCost::FileSystem.
+        //
+        PluginCost InternalPlugin::CostClass(const ConversionContext& /*p_Context*/) const
+        {
+            return PluginCost::FileSystem;
+        }
+
         //
         // Constructor.
         //
@@ -56,9 +75,30 @@ namespace PCC
         InternalPlugin::InternalPlugin(const unsigned short p_DescriptionStringResourceID,
                                        const unsigned short p_HelpTextStringResourceID)
             : Plugin(),
-              m_DescriptionString(MAKEINTRESOURCEW(p_DescriptionStringResourceID)),
-              m_HelpTextString(MAKEINTRESOURCEW(p_HelpTextStringResourceID))
+              m_DescriptionString(GetResourceString(p_DescriptionStringResourceID)),
+              m_HelpTextString(GetResourceString(p_HelpTextStringResourceID))
+        {
+        }
+
+        //
+        // Returns a string taken from resources. Each string is loaded
+        // only once per process; since built-in plugins are created anew
+        // for every plugins snapshot, this avoids loading the same strings
+        // from resources over and over. Copying the returned string is
+        // cheap, since ATL strings share their buffer until modified.
+        //
+        // @param p_StringResourceID ID of string resource to load.
+        // @return Reference to the string; remains valid until the process exits.
+        //
+        const ATL::CStringW& InternalPlugin::GetResourceString(const unsigned short p_StringResourceID)
         {
+            std::lock_guard<std::mutex> lock(s_ResourceStringsLock);
+            auto it = s_mResourceStrings.find(p_StringResourceID);
+            if (it == s_mResourceStrings.end()) {
+                it = s_mResourceStrings.emplace(p_StringResourceID,
+                                                ATL::CStringW(MAKEINTRESOURCEW(p_StringResourceID))).first;
+            }
+            return it->second;
         }
 
     } // namespace Plugins
@@ -23,18 +23,29 @@
 #include <stdafx.h>
 #include <InternetPathPlugin.h>
 #include <resource.h>
+#include <StringUtils.h>
 
-#include <algorithm>
-#include <sstream>
+#include <cwchar>
 
 
 namespace
 {
-    const std::wstring  NETWORK_SHARE_PREFIX    = L"\\\\";      // Prefix of string for network share paths
-    const std::wstring  FILE_URI_PREFIX         = L"file:///";  // Prefix of file URI paths
-    const std::wstring  NETWORK_FILE_URI_PREFIX = L"file://";   // Prefix of network file URI paths
-    const std::wstring  WHITESPACE_TO_ESCAPE    = L"\t\r ";     // Whitespace to escape in internet paths
-    const std::wstring  WHITESPACE_ESCAPE_SEQ   = L"%20";       // Escape sequence to use instead of whitespace
+    const wchar_t       NETWORK_SHARE_PREFIX[]      = L"\\\\";      // Prefix of string for network share paths
+    const wchar_t       FILE_URI_PREFIX[]           = L"file:///";  // Prefix of file URI paths
+    const wchar_t       NETWORK_FILE_URI_PREFIX[]   = L"file://";   // Prefix of network file URI paths
+    const wchar_t       WHITESPACE_TO_ESCAPE[]      = L"\t\r ";     // Whitespace to escape in internet paths
+    const wchar_t       WHITESPACE_ESCAPE_SEQ[]     = L"%20";       // Escape sequence to use instead of whitespace
+
+    //
+    // Checks if a character is whitespace that must be escaped in internet paths.
+    //
+    // @param p_Char Character to check.
+    // @return true if p_Char must be escaped.
+    //
+    bool IsWhitespaceToEscape(const wchar_t p_Char)
+    {
+        return std::wmemchr(WHITESPACE_TO_ESCAPE, p_Char, StringUtils::LiteralLength(WHITESPACE_TO_ESCAPE)) != nullptr;
+    }
 
     // Plugin unique ID: {8F2ADCCC-9693-407d-9300-FCCB9A12B982}
     const GUID          INTERNET_PATH_PLUGIN_ID = { 0x8f2adccc, 0x9693, 0x407d, { 0x93, 0x0, 0xfc, 0xcb, 0x9a, 0x12, 0xb9, 0x82 } };
@@ -71,10 +82,12 @@ namespace PCC
         //
         // @param p_ParentPath Path of parent directory; unused.
         // @param p_File Path of one file selected; unused.
+        // @param p_Context Context in which the plugin is used.
         // @return always true to tell PCC to enable our plugin.
         //
         bool InternetPathPlugin::Enabled(const std::wstring& /*p_ParentPath*/,
-                                         const std::wstring& /*p_File*/) const
+                                         const std::wstring& /*p_File*/,
+                                         const ConversionContext& /*p_Context*/) const
         {
             return true;
         }
@@ -83,40 +96,17 @@ namespace PCC
         // Returns the path of the specified file in file URI format
         //
         // @param p_File File path.
+        // @param p_rResolver Resolver used to perform network lookups.
+        // @param p_Context Context of the conversion.
         // @return Internet (e.g., URI) path.
         //
-        std::wstring InternetPathPlugin::GetPath(const std::wstring& p_File) const
+        std::wstring InternetPathPlugin::GetUNCPath(const std::wstring& p_File,
+                                                    UNCPathResolver& p_rResolver,
+                                                    const ConversionContext& p_Context) const
         {
-            // First call inherited version to get the path.
-            std::wstring path = LongUNCPathPlugin::GetPath(p_File);
-
-            // There are two possible formats we use. For local files, we use
-            // C:\path\to\file -> file://C:/path/to/file
-            // For network shares, we use
-            // \\computer\share\path\to\file -> file://computer/share/path/to/file
-            if (path.find(NETWORK_SHARE_PREFIX) == 0) {
-                path = NETWORK_FILE_URI_PREFIX + path.replace(0, NETWORK_SHARE_PREFIX.size(), L"");
-            } else {
-                path = FILE_URI_PREFIX + path;
-            }
-
-            // Now switch backslashes to slashes.
-            std::replace(path.begin(), path.end(), L'\\', L'/');
-
-            // Switch whitespace for %20.
-            std::wstringstream newPathSS;
-            std::wstring::size_type oldPos = 0, whitespacePos = path.find_first_of(WHITESPACE_TO_ESCAPE);
-            while (whitespacePos != std::wstring::npos) {
-                newPathSS << path.substr(oldPos, whitespacePos - oldPos) << WHITESPACE_ESCAPE_SEQ;
-                oldPos = whitespacePos + 1;
-                whitespacePos = path.find_first_of(WHITESPACE_TO_ESCAPE, oldPos);
-            }
-            if (oldPos < path.size()) {
-                newPathSS << path.substr(oldPos, path.size() - oldPos);
-            }
-            path = newPathSS.str();
-
-            return path;
+            // First call inherited version to get the path, then convert it to a file URI.
+            return BuildURI(LongUNCPathPlugin::GetUNCPath(p_File, p_rResolver, p_Context),
+                            FILE_URI_PREFIX, NETWORK_FILE_URI_PREFIX, nullptr);
         }
 
         //
@@ -131,12 +121,91 @@ namespace PCC
         {
         }
 
+        //
+        // Builds the URI of a path. There are two possible formats we use.
+        // For local files, we use (for file URIs)
+        // C:\path\to\file -> file:///C:/path/to/file
+        // For network shares, we use
+        // \\computer\share\path\to\file -> file://computer/share/path/to/file
+        //
+        // Backslashes are switched to slashes, whitespace is escaped and the
+        // name of the server is replaced by its alias (if any) while copying
+        // the path, so the URI is built in a single pass and a single
+        // allocation. Other characters are encoded later if needed, along with
+        // the paths of other plugins (see the EncodeParam setting).
+        //
+        // @param p_Path Long path, or UNC path if the file is on a network share.
+        // @param p_pLocalPrefix Prefix of URIs of local files, like "file:///".
+        // @param p_pNetworkPrefix Prefix of URIs of network files, like "file://".
+        // @param p_pServerAliases Optional aliases to use instead of server names,
+        //                         per lowercase server name. Can be nullptr.
+        // @return URI of p_Path.
+        //
+        std::wstring InternetPathPlugin::BuildURI(const std::wstring& p_Path,
+                                                  const wchar_t* const p_pLocalPrefix,
+                                                  const wchar_t* const p_pNetworkPrefix,
+                                                  const WStringWStringUM* const p_pServerAliases)
+        {
+            const bool isNetworkPath = p_Path.compare(0, StringUtils::LiteralLength(NETWORK_SHARE_PREFIX), NETWORK_SHARE_PREFIX) == 0;
+            const wchar_t* const pPrefix = isNetworkPath ? p_pNetworkPrefix : p_pLocalPrefix;
+            const std::wstring::size_type prefixSize = std::wcslen(pPrefix);
+            std::wstring::size_type start = isNetworkPath ? StringUtils::LiteralLength(NETWORK_SHARE_PREFIX) : 0;
+
+            // Look for an alias for the server; if found, skip the server name.
+            const std::wstring* pServerAlias = nullptr;
+            if (isNetworkPath && p_pServerAliases != nullptr && !p_pServerAliases->empty()) {
+                std::wstring::size_type serverEnd = p_Path.find(L'\\', start);
+                if (serverEnd == std::wstring::npos) {
+                    serverEnd = p_Path.size();
+                }
+                if (serverEnd != start) {
+                    std::wstring server(p_Path, start, serverEnd - start);
+                    ::CharLowerBuffW(&*server.begin(), static_cast<DWORD>(server.size()));
+                    const auto aliasIt = p_pServerAliases->find(server);
+                    if (aliasIt != p_pServerAliases->end()) {
+                        pServerAlias = &aliasIt->second;
+                        start = serverEnd;
+                    }
+                }
+            }
+
+            // Compute the size of the URI first so that we can allocate only once.
+            std::wstring::size_type uriSize = prefixSize + p_Path.size() - start;
+            if (pServerAlias != nullptr) {
+                uriSize += pServerAlias->size();
+            }
+            for (std::wstring::size_type i = start; i < p_Path.size(); ++i) {
+                if (IsWhitespaceToEscape(p_Path[i])) {
+                    uriSize += StringUtils::LiteralLength(WHITESPACE_ESCAPE_SEQ) - 1;
+                }
+            }
+
+            std::wstring uri;
+            uri.reserve(uriSize);
+            uri.append(pPrefix, prefixSize);
+            if (pServerAlias != nullptr) {
+                uri.append(*pServerAlias);
+            }
+            for (std::wstring::size_type i = start; i < p_Path.size(); ++i) {
+                const wchar_t c = p_Path[i];
+                if (c == L'\\') {
+                    uri.push_back(L'/');
+                } else if (IsWhitespaceToEscape(c)) {
+                    uri.append(WHITESPACE_ESCAPE_SEQ, StringUtils::LiteralLength(WHITESPACE_ESCAPE_SEQ));
+                } else {
+                    uri.push_back(c);
+                }
+            }
+            return uri;
+        }
+
         //
         // Determines if this plugin is androgynous. In our case, it never is.
         //
+        // @param p_Context Context in which the plugin is used.
         // @return true to use androgynous description, false to use normal description.
         //
-        bool InternetPathPlugin::IsAndrogynous() const
+        bool InternetPathPlugin::IsAndrogynous(const ConversionContext& /*p_Context*/) const
         {
             return false;
         }
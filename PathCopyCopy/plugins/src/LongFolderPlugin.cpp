@@ -24,6 +24,7 @@
 #include <PathCopyCopySettings.h>
 #include <PluginUtils.h>
 #include <resource.h>
+#include <SettingsSnapshot.h>
 #include <ShortFolderPlugin.h>
 
 #include <assert.h>
@@ -58,14 +59,17 @@ namespace PCC
         // Returns the long path of the specified file's parent directory.
         //
         // @param p_File File path.
+        // @param p_Context Context of the conversion.
         // @return Long path of parent directory.
         //
-        std::wstring LongFolderPlugin::GetPath(const std::wstring& p_File) const
+        std::wstring LongFolderPlugin::GetPath(const std::wstring& p_File,
+                                               const ConversionContext& p_Context) const
         {
-            assert(m_pSettings != nullptr);
+            const SettingsSnapshot* const pSettings = p_Context.GetSettingsSnapshot();
+            assert(pSettings != nullptr);
 
             // Call parent to get the long path.
-            std::wstring longPath = LongPathPlugin::GetPath(p_File);
+            std::wstring longPath = LongPathPlugin::GetPath(p_File, p_Context);
 
             // If parent appended a separator, remove it here so that we
             // can properly extract parent folder.
@@ -78,7 +82,7 @@ namespace PCC
 
             // If settings instructs us to append separator for directories, append one,
             // since this plugin always returns directory paths.
-            if (m_pSettings != nullptr && m_pSettings->GetAppendSeparatorForDirectories()) {
+            if (pSettings != nullptr && pSettings->GetAppendSeparatorForDirectories()) {
                 longPath += L"\\";
             }
 
@@ -89,15 +93,17 @@ namespace PCC
         // Determines if this plugin is androgynous. It is considered androgynous
         // if the short folder plugin is not shown according to settings.
         //
+        // @param p_Context Context in which the plugin is used.
         // @return true to use androgynous description, false to use normal description.
         //
-        bool LongFolderPlugin::IsAndrogynous() const
+        bool LongFolderPlugin::IsAndrogynous(const ConversionContext& p_Context) const
         {
-            assert(m_pSettings != nullptr);
+            const Settings* const pSettings = p_Context.GetSettings();
+            assert(pSettings != nullptr);
 
-            return m_pSettings != nullptr &&
-                   m_pSettings->GetDropRedundantWords() &&
-                   !PluginUtils::IsPluginShown(*m_pSettings, ShortFolderPlugin::ID);
+            return pSettings != nullptr &&
+                   pSettings->GetDropRedundantWords() &&
+                   !pSettings->IsPluginShown(ShortFolderPlugin::ID);
         }
 
     } // namespace Plugins
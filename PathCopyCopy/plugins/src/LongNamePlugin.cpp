@@ -58,12 +58,14 @@ namespace PCC
         // Returns the long name of the specified file.
         //
         // @param p_File File path.
+        // @param p_Context Context of the conversion.
         // @return Long file name.
         //
-        std::wstring LongNamePlugin::GetPath(const std::wstring& p_File) const
+        std::wstring LongNamePlugin::GetPath(const std::wstring& p_File,
+                                             const ConversionContext& p_Context) const
         {
             // Call parent to get the long path.
-            std::wstring longPath = LongPathPlugin::GetPath(p_File);
+            std::wstring longPath = LongPathPlugin::GetPath(p_File, p_Context);
 
             // Get the last part, the file name.
             size_t lastDelimiterPos = longPath.find_last_of(L"/\\");
@@ -80,15 +82,17 @@ namespace PCC
         // Determines if this plugin is androgynous. It is considered androgynous
         // if the short name plugin is not shown according to settings.
         //
+        // @param p_Context Context in which the plugin is used.
         // @return true to use androgynous description, false to use normal description.
         //
-        bool LongNamePlugin::IsAndrogynous() const
+        bool LongNamePlugin::IsAndrogynous(const ConversionContext& p_Context) const
         {
-            assert(m_pSettings != nullptr);
+            const Settings* const pSettings = p_Context.GetSettings();
+            assert(pSettings != nullptr);
 
-            return m_pSettings != nullptr &&
-                   m_pSettings->GetDropRedundantWords() &&
-                   !PluginUtils::IsPluginShown(*m_pSettings, ShortNamePlugin::ID);
+            return pSettings != nullptr &&
+                   pSettings->GetDropRedundantWords() &&
+                   !pSettings->IsPluginShown(ShortNamePlugin::ID);
         }
 
     } // namespace Plugins
@@ -24,6 +24,7 @@
 #include <PathCopyCopySettings.h>
 #include <PluginUtils.h>
 #include <resource.h>
+#include <SettingsSnapshot.h>
 #include <ShortPathPlugin.h>
 
 #include <assert.h>
@@ -58,24 +59,21 @@ namespace PCC
         // Returns the long path of the specified file.
         //
         // @param p_File File path.
+        // @param p_Context Context of the conversion.
         // @return Long path.
         //
-        std::wstring LongPathPlugin::GetPath(const std::wstring& p_File) const
+        std::wstring LongPathPlugin::GetPath(const std::wstring& p_File,
+                                             const ConversionContext& p_Context) const
         {
-            assert(m_pSettings != nullptr);
+            const SettingsSnapshot* const pSettings = p_Context.GetSettingsSnapshot();
+            assert(pSettings != nullptr);
 
-            std::wstring path(p_File);
-            if (!path.empty()) {
-                wchar_t longPath[MAX_PATH + 1];
-                DWORD copied = ::GetLongPathNameW(p_File.c_str(),
-                                                  longPath,
-                                                  sizeof(longPath) / sizeof(wchar_t));
-                if (copied != 0) {
-                    path.assign(longPath, copied);
-                }
+            std::wstring path;
+            if (!p_File.empty()) {
+                path = PluginUtils::GetLongPath(p_File, p_Context.GetMetadataCache());
 
                 // Append separator if needed.
-                if (m_pSettings != nullptr && m_pSettings->GetAppendSeparatorForDirectories() && PluginUtils::IsDirectory(path)) {
+                if (pSettings != nullptr && pSettings->GetAppendSeparatorForDirectories() && PluginUtils::IsDirectory(path, p_Context.GetMetadataCache())) {
                     path += L"\\";
                 }
             }
@@ -100,15 +98,17 @@ namespace PCC
         // Determines if this plugin is androgynous. It is considered androgynous
         // if the short path plugin is not shown according to settings.
         //
+        // @param p_Context Context in which the plugin is used.
         // @return true to use androgynous description, false to use normal description.
         //
-        bool LongPathPlugin::IsAndrogynous() const
+        bool LongPathPlugin::IsAndrogynous(const ConversionContext& p_Context) const
         {
-            assert(m_pSettings != nullptr);
+            const Settings* const pSettings = p_Context.GetSettings();
+            assert(pSettings != nullptr);
 
-            return m_pSettings != nullptr &&
-                   m_pSettings->GetDropRedundantWords() &&
-                   !PluginUtils::IsPluginShown(*m_pSettings, ShortPathPlugin::ID);
+            return pSettings != nullptr &&
+                   pSettings->GetDropRedundantWords() &&
+                   !pSettings->IsPluginShown(ShortPathPlugin::ID);
         }
 
     } // namespace Plugins
@@ -23,6 +23,7 @@
 #include <LongUNCFolderPlugin.h>
 #include <PluginUtils.h>
 #include <resource.h>
+#include <SettingsSnapshot.h>
 #include <ShortUNCFolderPlugin.h>
 
 #include <assert.h>
@@ -58,27 +59,64 @@ namespace PCC
         // menu. For UNC plugins, we only enable the item if there is a valid share.
         //
         // @param p_ParentPath Path of the parent folder of items being acted upon.
+        // @param p_Context Context in which the plugin is used.
         // @return true if the plugin should be enabled, false otherwise.
         //
         bool LongUNCFolderPlugin::Enabled(const std::wstring& p_ParentPath,
-                                          const std::wstring& /*p_File*/) const
+                                          const std::wstring& /*p_File*/,
+                                          const ConversionContext& p_Context) const
         {
             // Call method to get the path and check if there was a valid share.
+            UNCPathResolver resolver(p_Context.GetMetadataCache());
             std::wstring path(p_ParentPath);
-            return InternalGetPath(path, false);
+            return InternalGetPath(path, false, resolver, p_Context);
         }
 
         //
         // Returns the long UNC path of the specified file's parent directory.
         //
         // @param p_File File path.
+        // @param p_Context Context of the conversion.
         // @return UNC path of parent if file has one, otherwise its long path.
         //
-        std::wstring LongUNCFolderPlugin::GetPath(const std::wstring& p_File) const
+        std::wstring LongUNCFolderPlugin::GetPath(const std::wstring& p_File,
+                                                  const ConversionContext& p_Context) const
         {
-            std::wstring path(p_File);
-            InternalGetPath(path, true);
-            return path;
+            UNCPathResolver resolver(p_Context.GetMetadataCache());
+            return GetUNCPath(p_File, resolver, p_Context);
+        }
+
+        //
+        // Returns the long UNC paths of the specified files' parent directories.
+        // Network lookups are shared between all files.
+        //
+        // @param p_vFiles File paths.
+        // @param p_Context Context of the conversion.
+        // @return UNC paths of parents of files that have one, otherwise their long paths.
+        //
+        WStringV LongUNCFolderPlugin::GetPaths(const FilesV& p_vFiles,
+                                               const ConversionContext& p_Context) const
+        {
+            UNCPathResolver resolver(p_Context.GetMetadataCache());
+            WStringV vPaths;
+            vPaths.reserve(p_vFiles.size());
+            for (const std::wstring& file : p_vFiles) {
+                vPaths.push_back(GetUNCPath(file, resolver, p_Context));
+            }
+            return vPaths;
+        }
+
+        //
+        // Returns the class of cost of the work performed by this plugin.
+        // UNC paths depend on the network configuration, so they are
+        // only cached for a short time (see Plugin::PathCacheTimeToLive).
+        //
+        // @param p_Context Context in which the plugin is used.
+        // @return PluginCost::Network.
+        //
+        PluginCost LongUNCFolderPlugin::CostClass(const ConversionContext& /*p_Context*/) const
+        {
+            return PluginCost::Network;
         }
 
         //
@@ -99,15 +137,35 @@ namespace PCC
         // Determines if this plugin is androgynous. It is considered androgynous
         // if the short UNC folder plugin is not shown according to settings.
         //
+        // @param p_Context Context in which the plugin is used.
         // @return true to use androgynous description, false to use normal description.
         //
-        bool LongUNCFolderPlugin::IsAndrogynous() const
+        bool LongUNCFolderPlugin::IsAndrogynous(const ConversionContext& p_Context) const
         {
-            assert(m_pSettings != nullptr);
+            const Settings* const pSettings = p_Context.GetSettings();
+            assert(pSettings != nullptr);
 
-            return m_pSettings != nullptr &&
-                   m_pSettings->GetDropRedundantWords() &&
-                   !PluginUtils::IsPluginShown(*m_pSettings, ShortUNCFolderPlugin::ID);
+            return pSettings != nullptr &&
+                   pSettings->GetDropRedundantWords() &&
+                   !pSettings->IsPluginShown(ShortUNCFolderPlugin::ID);
+        }
+
+        //
+        // Returns the long UNC path of the specified file's parent directory,
+        // using the given resolver to perform network lookups.
+        //
+        // @param p_File File path.
+        // @param p_rResolver Resolver used to perform network lookups.
+        // @param p_Context Context of the conversion.
+        // @return UNC path of parent if file has one, otherwise its long path.
+        //
+        std::wstring LongUNCFolderPlugin::GetUNCPath(const std::wstring& p_File,
+                                                     UNCPathResolver& p_rResolver,
+                                                     const ConversionContext& p_Context) const
+        {
+            std::wstring path(p_File);
+            InternalGetPath(path, true, p_rResolver, p_Context);
+            return path;
         }
 
         //
@@ -117,12 +175,17 @@ namespace PCC
         // @param p_ExtractFolder Whether to extract folder before looking for UNC
         //                        paths. If this is set to false, the caller is
         //                        expected to have performed the task already.
+        // @param p_rResolver Resolver used to perform network lookups.
+        // @param p_Context Context of the conversion.
         // @return true if the file's parent directory has a valid UNC path, false otherwise.
         //
         bool LongUNCFolderPlugin::InternalGetPath(std::wstring& p_rPath,
-                                                  const bool p_ExtractFolder) const
+                                                  const bool p_ExtractFolder,
+                                                  UNCPathResolver& p_rResolver,
+                                                  const ConversionContext& p_Context) const
         {
-            assert(m_pSettings != nullptr);
+            const SettingsSnapshot* const pSettings = p_Context.GetSettingsSnapshot();
+            assert(pSettings != nullptr);
 
             // We need to first get the long path, extract the parent
             // then look for shares with that parent, since the fact that a folder
@@ -130,7 +193,7 @@ namespace PCC
             bool converted = false;
 
             // Get parent's path.
-            p_rPath = LongPathPlugin::GetPath(p_rPath);
+            p_rPath = LongPathPlugin::GetPath(p_rPath, p_Context);
 
             // If parent appended a separator, remove it since it can mess with the
             // detection functions below.
@@ -140,36 +203,23 @@ namespace PCC
 
             if ((!p_ExtractFolder) || PluginUtils::ExtractFolderFromPath(p_rPath)) {
                 // Got the parent path, check if this is already an UNC path.
+                const bool resolveDFS = pSettings != nullptr ? pSettings->GetResolveDFSPaths() : false;
                 converted = PluginUtils::IsUNCPath(p_rPath);
-                if (!converted) {
-                    // Try to get path on mapped network drive.
-                    std::wstring newPath = p_rPath;
-                    converted = PluginUtils::GetMappedDriveFilePath(newPath);
-
-                    // If it wasn't on a mapped drive, check if it's in a network share.
-                    const bool useHiddenShares = m_pSettings != nullptr ? m_pSettings->GetUseHiddenShares() : false;
-                    if (!converted) {
-                        converted = PluginUtils::GetNetworkShareFilePath(newPath, useHiddenShares);
-                    }
-
-                    // If it wasn't in a defined network share, use a hidden drive share if we're allowed.
-                    if (!converted && useHiddenShares) {
-                        converted = PluginUtils::GetHiddenDriveShareFilePath(newPath);
-                    }
-
-                    // If we got a path and we must use FQDN, convert it.
-                    const bool useFQDN = m_pSettings != nullptr ? m_pSettings->GetUseFQDN() : false;
-                    if (converted && useFQDN) {
-                        PluginUtils::ConvertUNCHostToFQDN(newPath);
-                    }
+                if (converted && resolveDFS) {
+                    // Already a UNC path, but it could be in a DFS namespace.
+                    p_rResolver.ResolveDFSPath(p_rPath);
+                } else if (!converted) {
+                    // Look for a mapped network drive or a network share. The resolver
+                    // memoizes results, so files in the same folder only convert it once.
+                    const bool useHiddenShares = pSettings != nullptr ? pSettings->GetUseHiddenShares() : false;
+                    const bool useFQDN = pSettings != nullptr ? pSettings->GetUseFQDN() : false;
+                    converted = p_rResolver.ConvertToUNCPath(p_rPath, useHiddenShares, useFQDN, resolveDFS);
 
                     // If we got a UNC path, use it, otherwise keep the long path.
                     if (converted) {
-                        p_rPath = newPath;
-
                         // If settings instructs us to append separator for directories, append one,
                         // since this plugin always returns directory paths.
-                        if (m_pSettings != nullptr && m_pSettings->GetAppendSeparatorForDirectories()) {
+                        if (pSettings != nullptr && pSettings->GetAppendSeparatorForDirectories()) {
                             p_rPath += L"\\";
                         }
                     }
@@ -21,8 +21,10 @@
 
 #include <stdafx.h>
 #include <LongUNCPathPlugin.h>
+#include <FileMetadataCache.h>
 #include <PluginUtils.h>
 #include <resource.h>
+#include <SettingsSnapshot.h>
 #include <ShortUNCPathPlugin.h>
 
 #include <assert.h>
@@ -58,27 +60,64 @@ namespace PCC
         // menu. For UNC plugins, we only enable the item if there is a valid share.
         //
         // @param p_ParentPath Path of the parent folder of items being acted upon.
+        // @param p_Context Context in which the plugin is used.
         // @return true if the plugin should be enabled, false otherwise.
         //
         bool LongUNCPathPlugin::Enabled(const std::wstring& /*p_ParentPath*/,
-                                        const std::wstring& p_File) const
+                                        const std::wstring& p_File,
+                                        const ConversionContext& p_Context) const
         {
             // Call method to get the path and check if there was a valid share.
+            UNCPathResolver resolver(p_Context.GetMetadataCache());
             std::wstring path(p_File);
-            return InternalGetPath(path);
+            return InternalGetPath(path, resolver, p_Context);
         }
 
         //
         // Returns the long UNC path of the specified file.
         //
         // @param p_File File path.
+        // @param p_Context Context of the conversion.
         // @return UNC path if file has one, otherwise its long path.
         //
-        std::wstring LongUNCPathPlugin::GetPath(const std::wstring& p_File) const
+        std::wstring LongUNCPathPlugin::GetPath(const std::wstring& p_File,
+                                                const ConversionContext& p_Context) const
         {
-            std::wstring path(p_File);
-            InternalGetPath(path);
-            return path;
+            UNCPathResolver resolver(p_Context.GetMetadataCache());
+            return GetUNCPath(p_File, resolver, p_Context);
+        }
+
+        //
+        // Returns the long UNC paths of the specified files. Network lookups
+        // are shared between all files.
+        //
+        // @param p_vFiles File paths.
+        // @param p_Context Context of the conversion.
+        // @return UNC paths of files that have one, otherwise their long paths.
+        //
+        WStringV LongUNCPathPlugin::GetPaths(const FilesV& p_vFiles,
+                                             const ConversionContext& p_Context) const
+        {
+            UNCPathResolver resolver(p_Context.GetMetadataCache());
+            WStringV vPaths;
+            vPaths.reserve(p_vFiles.size());
+            for (const std::wstring& file : p_vFiles) {
+                vPaths.push_back(GetUNCPath(file, resolver, p_Context));
+            }
+            return vPaths;
+        }
+
+        //
+        // Returns the class of cost of the work performed by this plugin.
+        // UNC paths depend on the network configuration, so they are
+        // only cached for a short time (see Plugin::PathCacheTimeToLive).
+        //
+        // @param p_Context Context in which the plugin is used.
+        // @return PluginCost::Network.
+        //
+        PluginCost LongUNCPathPlugin::CostClass(const ConversionContext& /*p_Context*/) const
+        {
+            return PluginCost::Network;
         }
 
         //
@@ -99,29 +138,54 @@ namespace PCC
         // Determines if this plugin is androgynous. It is considered androgynous
         // if the short UNC path plugin is not shown according to settings.
         //
+        // @param p_Context Context in which the plugin is used.
         // @return true to use androgynous description, false to use normal description.
         //
-        bool LongUNCPathPlugin::IsAndrogynous() const
+        bool LongUNCPathPlugin::IsAndrogynous(const ConversionContext& p_Context) const
         {
-            assert(m_pSettings != nullptr);
+            const Settings* const pSettings = p_Context.GetSettings();
+            assert(pSettings != nullptr);
 
-            return m_pSettings != nullptr &&
-                   m_pSettings->GetDropRedundantWords() &&
-                   !PluginUtils::IsPluginShown(*m_pSettings, ShortUNCPathPlugin::ID);
+            return pSettings != nullptr &&
+                   pSettings->GetDropRedundantWords() &&
+                   !pSettings->IsPluginShown(ShortUNCPathPlugin::ID);
+        }
+
+        //
+        // Returns the long UNC path of the specified file, using the given
+        // resolver to perform network lookups.
+        //
+        // @param p_File File path.
+        // @param p_rResolver Resolver used to perform network lookups.
+        // @param p_Context Context of the conversion.
+        // @return UNC path if file has one, otherwise its long path.
+        //
+        std::wstring LongUNCPathPlugin::GetUNCPath(const std::wstring& p_File,
+                                                   UNCPathResolver& p_rResolver,
+                                                   const ConversionContext& p_Context) const
+        {
+            std::wstring path(p_File);
+            InternalGetPath(path, p_rResolver, p_Context);
+            return path;
         }
 
         //
         // Returns the long UNC path of the specified file.
         //
         // @param p_File File path on input, UNC path if it has one on output.
+        // @param p_rResolver Resolver used to perform network lookups.
+        // @param p_Context Context of the conversion.
         // @return true if the path returned is a UNC path, false otherwise.
         //
-        bool LongUNCPathPlugin::InternalGetPath(std::wstring& p_rPath) const
+        bool LongUNCPathPlugin::InternalGetPath(std::wstring& p_rPath,
+                                                UNCPathResolver& p_rResolver,
+                                                const ConversionContext& p_Context) const
         {
-            assert(m_pSettings != nullptr);
+            const SettingsSnapshot* const pSettings = p_Context.GetSettingsSnapshot();
+            assert(pSettings != nullptr);
 
             // Call parent to get long path.
-            p_rPath = LongPathPlugin::GetPath(p_rPath);
+            p_rPath = LongPathPlugin::GetPath(p_rPath, p_Context);
 
             // If parent appended a separator, remove it since it can mess with the
             // detection functions below.
@@ -130,32 +194,31 @@ namespace PCC
                 p_rPath = p_rPath.substr(0, p_rPath.size() - 1);
             }
 
-            // Check if it already was an UNC path.
-            bool converted = PluginUtils::IsUNCPath(p_rPath);
-            if (!converted) {
-                // Try to get path on mapped network drive.
-                std::wstring newPath = p_rPath;
-                converted = PluginUtils::GetMappedDriveFilePath(newPath);
-
-                // If it wasn't on a mapped drive, check if it's in a network share.
-                const bool useHiddenShares = m_pSettings != nullptr ? m_pSettings->GetUseHiddenShares() : false;
+            // Other plugins might have resolved this path already during this operation.
+            const bool resolveDFS = pSettings != nullptr ? pSettings->GetResolveDFSPaths() : false;
+            const bool useHiddenShares = pSettings != nullptr ? pSettings->GetUseHiddenShares() : false;
+            const bool useFQDN = pSettings != nullptr ? pSettings->GetUseFQDN() : false;
+            const DWORD uncFlags = (useHiddenShares ? FileMetadataCache::UNC_USE_HIDDEN_SHARES : 0) |
+                                   (useFQDN ? FileMetadataCache::UNC_USE_FQDN : 0) |
+                                   (resolveDFS ? FileMetadataCache::UNC_RESOLVE_DFS : 0);
+            FileMetadataCache* const pMetadataCache = p_Context.GetMetadataCache();
+            bool converted = false;
+            if (pMetadataCache == nullptr || !pMetadataCache->GetUNCPath(p_rPath, uncFlags, p_rPath, converted)) {
+                const std::wstring longPath(p_rPath);
+
+                // Check if it already was an UNC path.
+                converted = PluginUtils::IsUNCPath(p_rPath);
                 if (!converted) {
-                    converted = PluginUtils::GetNetworkShareFilePath(newPath, useHiddenShares);
-                }
-
-                // If it wasn't in a defined network share, use a hidden drive share if we're allowed.
-                if (!converted && useHiddenShares) {
-                    converted = PluginUtils::GetHiddenDriveShareFilePath(newPath);
-                }
-
-                // If we got a path and we must use FQDN, convert it.
-                const bool useFQDN = m_pSettings != nullptr ? m_pSettings->GetUseFQDN() : false;
-                if (converted && useFQDN) {
-                    PluginUtils::ConvertUNCHostToFQDN(newPath);
+                    // Look for a mapped network drive or a network share. The resolver
+                    // reuses the result of the parent directory for files in the same folder.
+                    converted = p_rResolver.ConvertToUNCPath(p_rPath, useHiddenShares, useFQDN, resolveDFS);
+                } else if (resolveDFS) {
+                    // Already a UNC path, but it could be in a DFS namespace.
+                    p_rResolver.ResolveDFSPath(p_rPath);
                 }
 
-                if (converted) {
-                    p_rPath = newPath;
+                if (pMetadataCache != nullptr) {
+                    pMetadataCache->SetUNCPath(longPath, uncFlags, p_rPath, converted);
                 }
             }
 
@@ -21,11 +21,8 @@
 
 #include <stdafx.h>
 #include <MSYSPathPlugin.h>
-#include <StringUtils.h>
 #include <resource.h>
 
-#include <sstream>
-
 
 namespace
 {
@@ -61,28 +58,36 @@ namespace PCC
         // Returns the MSYS/MSYS2 path of the specified file.
         //
         // @param p_File File path.
+        // @param p_Context Context of the conversion.
         // @return File path in MSYS/MSYS2 format (/c/...)
         //
-        std::wstring MSYSPathPlugin::GetPath(const std::wstring& p_File) const
+        std::wstring MSYSPathPlugin::GetPath(const std::wstring& p_File,
+                                             const ConversionContext& p_Context) const
         {
-            // Call parent to get Unix path.
-            std::wstring path = UnixPathPlugin::GetPath(p_File);
+            // Use MSYS2's mount table if installed, otherwise replace the drive letter
+            // with /letter. Spaces are escaped bash-style, so this works without quotes.
+            const PosixMountTable::PosixMountTableSP spMountTable = PosixMountTable::Get(PosixMountTable::Environment::MSYS);
+            return GetUnixPath(p_File, p_Context, L"/", true, spMountTable.get());
+        }
 
-            // Check if the file begins with a drive letter. If so,
-            // remove the drive letter and replace it with /letter.
-            if (path.size() >= 3 && path[1] == L':') {
-                std::wstringstream newPathSS;
-                newPathSS << L"/"                                       // The prefix
-                          << static_cast<wchar_t>(::towlower(path[0]))  // Drive letter
-                          << path.substr(2);                            // Rest of the path, including the slash after that : we had.
-                path = newPathSS.str();
+        //
+        // Returns the MSYS/MSYS2 paths of the specified files. The mount table
+        // is only fetched once for all files.
+        //
+        // @param p_vFiles File paths.
+        // @param p_Context Context of the conversion.
+        // @return File paths in MSYS/MSYS2 format.
+        //
+        WStringV MSYSPathPlugin::GetPaths(const FilesV& p_vFiles,
+                                          const ConversionContext& p_Context) const
+        {
+            const PosixMountTable::PosixMountTableSP spMountTable = PosixMountTable::Get(PosixMountTable::Environment::MSYS);
+            WStringV vPaths;
+            vPaths.reserve(p_vFiles.size());
+            for (const std::wstring& file : p_vFiles) {
+                vPaths.push_back(GetUnixPath(file, p_Context, L"/", true, spMountTable.get()));
             }
-
-            // Escape spaces bash-style. This works without quotes.
-            StringUtils::ReplaceAll(path, L" ", L"\\ ");
-
-            // Return modified path.
-            return path;
+            return vPaths;
         }
 
     } // namespace Plugins
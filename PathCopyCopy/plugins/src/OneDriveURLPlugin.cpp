@@ -0,0 +1,152 @@
+// OneDriveURLPlugin.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <stdafx.h>
+#include <OneDriveURLPlugin.h>
+#include <OneDriveSyncRootCache.h>
+#include <resource.h>
+#include <StringUtils.h>
+
+
+namespace
+{
+    // Plugin unique ID: {D97DA1A7-2660-40CD-AD2F-257B7740CAE1}
+    const GUID ONEDRIVE_URL_PLUGIN_ID = { 0xd97da1a7, 0x2660, 0x40cd, { 0xad, 0x2f, 0x25, 0x7b, 0x77, 0x40, 0xca, 0xe1 } };
+
+} // anonymous namespace
+
+
+namespace PCC
+{
+    namespace Plugins
+    {
+        //
+        // Constructor.
+        //
+        OneDriveURLPlugin::OneDriveURLPlugin()
+            : InternalPlugin(IDS_ONEDRIVE_URL_PLUGIN_DESCRIPTION, IDS_ONEDRIVE_URL_PLUGIN_HINT)
+        {
+        }
+
+        //
+        // Returns the plugin's unique identifier.
+        //
+        // @return Unique identifier.
+        //
+        const GUID& OneDriveURLPlugin::Id() const
+        {
+            return ONEDRIVE_URL_PLUGIN_ID;
+        }
+
+        //
+        // Determines if the plugin should be enabled or not in the contextual menu.
+        // We are only enabled for files located under a OneDrive sync root.
+        //
+        // @param p_ParentPath Path of parent directory; unused.
+        // @param p_File Path of one file selected.
+        // @param p_Context Context in which the plugin is used; unused.
+        // @return true if p_File has a OneDrive URL.
+        //
+        bool OneDriveURLPlugin::Enabled(const std::wstring& /*p_ParentPath*/,
+                                        const std::wstring& p_File,
+                                        const ConversionContext& /*p_Context*/) const
+        {
+            std::wstring path(p_File);
+            return ConvertPath(path, *OneDriveSyncRootCache::GetSyncRoots());
+        }
+
+        //
+        // Returns the OneDrive URL of the specified file.
+        //
+        // @param p_File File path.
+        // @param p_Context Context of the conversion; unused.
+        // @return OneDrive URL if file is under a sync root, otherwise its path.
+        //
+        std::wstring OneDriveURLPlugin::GetPath(const std::wstring& p_File,
+                                                const ConversionContext& /*p_Context*/) const
+        {
+            std::wstring path(p_File);
+            ConvertPath(path, *OneDriveSyncRootCache::GetSyncRoots());
+            return path;
+        }
+
+        //
+        // Returns the OneDrive URLs of the specified files. Sync roots
+        // are only fetched once for all files.
+        //
+        // @param p_vFiles File paths.
+        // @param p_Context Context of the conversion; unused.
+        // @return OneDrive URLs of files that have one, otherwise their paths.
+        //
+        WStringV OneDriveURLPlugin::GetPaths(const FilesV& p_vFiles,
+                                             const ConversionContext& /*p_Context*/) const
+        {
+            const PrefixMap::PrefixMapSP spSyncRoots = OneDriveSyncRootCache::GetSyncRoots();
+            WStringV vPaths(p_vFiles);
+            for (std::wstring& path : vPaths) {
+                ConvertPath(path, *spSyncRoots);
+            }
+            return vPaths;
+        }
+
+        //
+        // Returns the cost class of this plugin. Since sync roots are cached,
+        // we only manipulate strings.
+        //
+        // @param p_Context Context of the conversion; unused.
+        // @return PluginCost::Pure.
+        //
+        PluginCost OneDriveURLPlugin::CostClass(const ConversionContext& /*p_Context*/) const
+        {
+            return PluginCost::Pure;
+        }
+
+        //
+        // Converts a path to its OneDrive URL by replacing its sync root
+        // with the corresponding URL, then converting the rest of the path.
+        //
+        // @param p_rPath Path to convert (in-place). Left untouched if it
+        //                is not under a sync root.
+        // @param p_SyncRoots Sync roots mapped to their URLs.
+        // @return true if the path was converted.
+        //
+        bool OneDriveURLPlugin::ConvertPath(std::wstring& p_rPath,
+                                            const PrefixMap& p_SyncRoots)
+        {
+            // Sync roots end with a backslash; append one so that a sync root itself matches.
+            std::wstring url(p_rPath);
+            url += L'\\';
+            std::wstring::size_type urlLength = 0;
+            const bool found = p_SyncRoots.Apply(url, urlLength);
+            if (found) {
+                std::wstring relativePath = url.substr(urlLength, url.size() - urlLength - 1);
+                StringUtils::ReplaceChar(relativePath, L'\\', L'/');
+                StringUtils::EncodeURICharacters(relativePath, StringUtils::EncodeParam::All);
+                url.replace(urlLength, std::wstring::npos, relativePath);
+                p_rPath.swap(url);
+            }
+            return found;
+        }
+
+    } // namespace Plugins
+
+} // namespace PCC
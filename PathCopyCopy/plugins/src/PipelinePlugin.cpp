@@ -22,8 +22,14 @@
 #include <stdafx.h>
 #include <PipelinePlugin.h>
 #include <PluginPipeline.h>
+#include <PluginPipelineCache.h>
 #include <PluginPipelineDecoder.h>
+#include <PathResultCache.h>
+#include <CopyToClipboardPathAction.h>
 #include <LaunchExecutablePathAction.h>
+#include <StreamToFilePathAction.h>
+
+#include <algorithm>
 
 #include <assert.h>
 
@@ -39,27 +45,35 @@ namespace PCC
         // @param p_PluginDescription Description of the pipeline plugin.
         // @param p_PluginIconFile Path to icon file for plugin, or an empty string.
         // @param p_UseDefaultIcon Whether to use the default icon for this plugin.
+        // @param p_MenuFolder Name of nested submenu in which to display plugin, or an empty string.
         // @param p_EncodedElements String containing encoded pipeline elements.
         //
         PipelinePlugin::PipelinePlugin(const GUID& p_PluginId,
                                        const std::wstring& p_PluginDescription,
                                        const std::wstring& p_PluginIconFile,
                                        const bool p_UseDefaultIcon,
+                                       const std::wstring& p_MenuFolder,
                                        const std::wstring& p_EncodedElements)
             : Plugin(),
               m_Id(p_PluginId),
               m_Description(p_PluginDescription),
               m_IconFile(p_PluginIconFile),
               m_UseDefaultIcon(p_UseDefaultIcon),
-              m_spPipeline()
+              m_MenuFolder(p_MenuFolder),
+              m_spPipeline(),
+              m_spAction()
         {
-            // Try decoding the encoded pipeline. If that fails, we'll
-            // keep the plugin alive but it will be disabled.
+            // Try decoding the encoded pipeline (or fetching it from the cache
+            // if it's already been decoded). If that fails, we'll keep the
+            // plugin alive but it will be disabled.
             try {
-                m_spPipeline = std::make_shared<Pipeline>(p_EncodedElements);
+                m_spPipeline = PipelineCache::GetPipeline(p_EncodedElements);
             } catch (const InvalidPipelineException&) {
                 assert(m_spPipeline == nullptr);
             }
+
+            // Path actions are immutable, so create ours right away.
+            m_spAction = CreateAction();
         }
 
         //
@@ -76,9 +90,10 @@ namespace PCC
         // Returns a description of the pipeline plugin, to be used to display it
         // in the contextual menu.
         //
+        // @param p_Context Context in which the plugin is used.
         // @return Plugin description.
         //
-        std::wstring PipelinePlugin::Description() const
+        std::wstring PipelinePlugin::Description(const ConversionContext& /*p_Context*/) const
         {
             return m_Description;
         }
@@ -103,6 +118,16 @@ namespace PCC
             return m_UseDefaultIcon;
         }
 
+        //
+        // Returns the name of the nested submenu in which to display this plugin.
+        //
+        // @return Name of nested submenu, or an empty string if not in one.
+        //
+        std::wstring PipelinePlugin::MenuFolder() const
+        {
+            return m_MenuFolder;
+        }
+
         //
         // Checks whether the plugin should be enabled or not in the contextual menu.
         // In our case, if we failed to decode our pipeline or if the pipeline complains,
@@ -110,29 +135,52 @@ namespace PCC
         //
         // @param p_ParentPath Path of the parent folder of all files; unused.
         // @param p_File Path of one selected file; unused.
+        // @param p_Context Context in which the plugin is used.
         //
         bool PipelinePlugin::Enabled(const std::wstring& p_ParentPath,
-                                     const std::wstring& p_File) const
+                                     const std::wstring& p_File,
+                                     const ConversionContext& p_Context) const
         {
             return m_spPipeline != nullptr &&
-                   m_spPipeline->ShouldBeEnabledFor(p_ParentPath, p_File, m_pPluginProvider);
+                   m_spPipeline->ShouldBeEnabledFor(p_ParentPath, p_File, p_Context);
         }
 
         //
         // Modifies a path using all elements in our pipeline.
         //
         // @param p_File Path of file to modify.
+        // @param p_Context Context of the conversion.
         // @return Modified path.
         //
-        std::wstring PipelinePlugin::GetPath(const std::wstring& p_File) const
+        std::wstring PipelinePlugin::GetPath(const std::wstring& p_File,
+                                             const ConversionContext& p_Context) const
         {
             std::wstring modifiedPath(p_File);
             if (m_spPipeline != nullptr) {
-                m_spPipeline->ModifyPath(modifiedPath, m_pPluginProvider);
+                m_spPipeline->ModifyPath(modifiedPath, p_Context);
             }
             return modifiedPath;
         }
 
+        //
+        // Modifies multiple paths using all elements in our pipeline. Each
+        // element is applied to all paths before moving on to the next one
+        // (see Pipeline::ModifyPaths).
+        //
+        // @param p_vFiles Paths of files to modify.
+        // @param p_Context Context of the conversion.
+        // @return Modified paths, in the same order as p_vFiles.
+        //
+        WStringV PipelinePlugin::GetPaths(const FilesV& p_vFiles,
+                                          const ConversionContext& p_Context) const
+        {
+            WStringV vModifiedPaths(p_vFiles.cbegin(), p_vFiles.cend());
+            if (m_spPipeline != nullptr) {
+                m_spPipeline->ModifyPaths(vModifiedPaths, p_Context);
+            }
+            return vModifiedPaths;
+        }
+
         //
         // Returns the separator to use between each path when using this plugin.
         // The default value is the empty string, which instructs PCC to use the
@@ -145,34 +193,137 @@ namespace PCC
             // This is stored in pipeline options.
             std::wstring separator;
             if (m_spPipeline != nullptr) {
-                PipelineOptions options;
-                m_spPipeline->ModifyOptions(options);
-                separator = options.GetPathsSeparator();
+                separator = m_spPipeline->Options().GetPathsSeparator();
             }
             return separator;
         }
 
+        //
+        // Returns the format in which paths should be exported along
+        // with the metadata of their files, if any.
+        //
+        // @return Export format, or ExportFormat::None to output paths as-is.
+        //
+        ExportFormat PipelinePlugin::GetExportFormat() const
+        {
+            // This is stored in pipeline options.
+            return m_spPipeline != nullptr ? m_spPipeline->Options().GetExportFormat() : ExportFormat::None;
+        }
+
         //
         // Returns the action to perform on the path or paths when using this plugin.
         //
         // @return Path action instance to use.
         //
         PCC::PathActionSP PipelinePlugin::Action() const
+        {
+            return m_spAction;
+        }
+
+        //
+        // Called by Path Copy Copy to know if it should honor the
+        // "Drop redundant words" setting for this plugin. In our
+        // case, the plugin description has been set by the user
+        // so we never want to modify it.
+        //
+        // @return Always false to indicate PCC should not drop
+        //         redundant words like "copy" from plugin's description.
+        //
+        bool PipelinePlugin::CanDropRedundantWords() const
+        {
+            return false;
+        }
+
+        //
+        // Returns the class of cost of the work performed by this plugin,
+        // which is derived from the elements of our pipeline. Pipelines
+        // that do not apply other plugins only manipulate strings.
+        //
+        // @param p_Context Context in which the plugin is used.
+        // @return Plugin's cost class.
+        //
+        PluginCost PipelinePlugin::CostClass(const ConversionContext& p_Context) const
+        {
+            return m_spPipeline != nullptr ? m_spPipeline->CostClass(p_Context) : PluginCost::Pure;
+        }
+
+        //
+        // Returns for how long paths returned by this plugin can be cached.
+        // If our pipeline asks to memoize paths, they are kept until settings
+        // change (or the cache entry expires); otherwise, this depends on
+        // the cost of our pipeline (see Plugin::PathCacheTimeToLive).
+        //
+        // @param p_Context Context in which the plugin is used.
+        // @return Time during which paths can be cached, in milliseconds.
+        //
+        DWORD PipelinePlugin::PathCacheTimeToLive(const ConversionContext& p_Context) const
+        {
+            DWORD timeToLive = Plugin::PathCacheTimeToLive(p_Context);
+            if (m_spPipeline != nullptr && m_spPipeline->Options().GetMemoizePaths()) {
+                timeToLive = (std::max)(timeToLive, PathResultCache::MEMOIZED_PATHS_TIME_TO_LIVE);
+            }
+            return timeToLive;
+        }
+
+        //
+        // Adds the IDs of other plugins referenced by our pipeline
+        // to the given vector.
+        //
+        // @param p_rvPluginIds Where to add referenced plugin IDs.
+        //
+        void PipelinePlugin::GetReferencedPlugins(GUIDV& p_rvPluginIds) const
+        {
+            if (m_spPipeline != nullptr) {
+                m_spPipeline->GetReferencedPlugins(p_rvPluginIds);
+            }
+        }
+
+        //
+        // Creates the action to perform on the path or paths when using this plugin,
+        // according to pipeline options. Called once when the plugin is created.
+        //
+        // @return New path action instance.
+        //
+        PCC::PathActionSP PipelinePlugin::CreateAction() const
         {
             // Pipeline options can modify the behavior.
             std::wstring executable;
             bool useFilelist = false;
+            auto filelistEncoding = PCC::Actions::LaunchExecutablePathAction::FilelistEncoding::Ansi;
+            auto filelistDelivery = PCC::Actions::LaunchExecutablePathAction::FilelistDelivery::TempFile;
+            bool copyMultipleFormats = false;
+            size_t maxParallelBatches = 0;
+            auto instanceEndpoint = PCC::Actions::LaunchExecutablePathAction::InstanceEndpoint::None;
+            std::wstring instanceEndpointName;
+            bool streamToFile = false;
+            std::wstring outputFile;
+            auto outputFileEncoding = PCC::Actions::LaunchExecutablePathAction::FilelistEncoding::UTF8;
             if (m_spPipeline != nullptr) {
-                PipelineOptions options;
-                m_spPipeline->ModifyOptions(options);
+                const PipelineOptions& options = m_spPipeline->Options();
                 executable = options.GetExecutable();
                 useFilelist = options.GetUseFilelist();
+                filelistEncoding = options.GetFilelistEncoding();
+                filelistDelivery = options.GetFilelistDelivery();
+                copyMultipleFormats = options.GetCopyMultipleFormats();
+                maxParallelBatches = options.GetMaxParallelBatches();
+                instanceEndpoint = options.GetInstanceEndpoint();
+                instanceEndpointName = options.GetInstanceEndpointName();
+                streamToFile = options.GetStreamToFile();
+                outputFile = options.GetOutputFile();
+                outputFileEncoding = options.GetOutputFileEncoding();
             }
             
             PCC::PathActionSP spAction;
             if (!executable.empty()) {
                 // Launch executable with paths as argument
-                spAction = std::make_shared<PCC::Actions::LaunchExecutablePathAction>(executable, useFilelist);
+                spAction = std::make_shared<PCC::Actions::LaunchExecutablePathAction>(executable, useFilelist,
+                    filelistEncoding, filelistDelivery, maxParallelBatches, instanceEndpoint, instanceEndpointName);
+            } else if (streamToFile) {
+                // Write paths to a file
+                spAction = std::make_shared<PCC::Actions::StreamToFilePathAction>(outputFile, outputFileEncoding);
+            } else if (copyMultipleFormats) {
+                // Copy paths to clipboard in multiple formats at once
+                spAction = std::make_shared<PCC::Actions::CopyToClipboardPathAction>(true);
             } else {
                 // Use default behavior.
                 spAction = Plugin::Action();
@@ -181,20 +332,6 @@ namespace PCC
             return spAction;
         }
 
-        //
-        // Called by Path Copy Copy to know if it should honor the
-        // "Drop redundant words" setting for this plugin. In our
-        // case, the plugin description has been set by the user
-        // so we never want to modify it.
-        //
-        // @return Always false to indicate PCC should not drop
-        //         redundant words like "copy" from plugin's description.
-        //
-        bool PipelinePlugin::CanDropRedundantWords() const
-        {
-            return false;
-        }
-
     } // namespace Plugins
 
 } // namespace PCC
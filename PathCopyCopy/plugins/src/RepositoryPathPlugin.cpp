@@ -0,0 +1,172 @@
+// RepositoryPathPlugin.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <stdafx.h>
+#include <RepositoryPathPlugin.h>
+#include <PluginUtils.h>
+#include <RepositoryRootCache.h>
+#include <resource.h>
+#include <SettingsSnapshot.h>
+#include <StringUtils.h>
+
+#include <assert.h>
+
+
+namespace
+{
+    // Plugin unique ID: {7D1CEF53-4459-4FC9-885F-AB4D21CE762B}
+    const GUID REPOSITORY_PATH_PLUGIN_ID = { 0x7d1cef53, 0x4459, 0x4fc9, { 0x88, 0x5f, 0xab, 0x4d, 0x21, 0xce, 0x76, 0x2b } };
+
+} // anonymous namespace
+
+
+namespace PCC
+{
+    namespace Plugins
+    {
+        //
+        // Constructor.
+        //
+        RepositoryPathPlugin::RepositoryPathPlugin()
+            : InternalPlugin(IDS_REPOSITORY_PATH_PLUGIN_DESCRIPTION, IDS_REPOSITORY_PATH_PLUGIN_HINT)
+        {
+        }
+
+        //
+        // Returns the plugin's unique identifier.
+        //
+        // @return Unique identifier.
+        //
+        const GUID& RepositoryPathPlugin::Id() const
+        {
+            return REPOSITORY_PATH_PLUGIN_ID;
+        }
+
+        //
+        // Determines if the plugin should be enabled or not in the contextual menu.
+        // We are only enabled for files located in a repository.
+        //
+        // @param p_ParentPath Path of parent directory; unused.
+        // @param p_File Path of one file selected.
+        // @param p_Context Context in which the plugin is used.
+        // @return true if p_File is in a repository.
+        //
+        bool RepositoryPathPlugin::Enabled(const std::wstring& /*p_ParentPath*/,
+                                           const std::wstring& p_File,
+                                           const ConversionContext& p_Context) const
+        {
+            std::wstring parent(p_File);
+            return PluginUtils::ExtractFolderFromPath(parent) && !GetRoot(parent, p_Context).empty();
+        }
+
+        //
+        // Returns the path of the specified file relative to its repository root.
+        //
+        // @param p_File File path.
+        // @param p_Context Context of the conversion.
+        // @return Relative path if file is in a repository, otherwise its path.
+        //
+        std::wstring RepositoryPathPlugin::GetPath(const std::wstring& p_File,
+                                                   const ConversionContext& p_Context) const
+        {
+            std::wstring parent(p_File);
+            if (!PluginUtils::ExtractFolderFromPath(parent)) {
+                return p_File;
+            }
+            return GetRelativePath(p_File, GetRoot(parent, p_Context));
+        }
+
+        //
+        // Returns the paths of the specified files relative to their repository
+        // roots. Files are usually sorted by directory, so the root of a directory
+        // is only looked up once for all consecutive files it contains.
+        //
+        // @param p_vFiles File paths.
+        // @param p_Context Context of the conversion.
+        // @return Relative paths of files in a repository, otherwise their paths.
+        //
+        WStringV RepositoryPathPlugin::GetPaths(const FilesV& p_vFiles,
+                                                const ConversionContext& p_Context) const
+        {
+            WStringV vPaths;
+            vPaths.reserve(p_vFiles.size());
+            std::wstring lastParent, lastRoot;
+            bool hasLastParent = false;
+            for (const std::wstring& file : p_vFiles) {
+                std::wstring parent(file);
+                if (!PluginUtils::ExtractFolderFromPath(parent)) {
+                    vPaths.push_back(file);
+                    continue;
+                }
+                if (!hasLastParent || ::_wcsicmp(parent.c_str(), lastParent.c_str()) != 0) {
+                    lastRoot = GetRoot(parent, p_Context);
+                    lastParent.swap(parent);
+                    hasLastParent = true;
+                }
+                vPaths.push_back(GetRelativePath(file, lastRoot));
+            }
+            return vPaths;
+        }
+
+        //
+        // Returns the root of the repository enclosing a directory.
+        //
+        // @param p_Parent Path of directory.
+        // @param p_Context Context of the conversion.
+        // @return Path of repository root, or an empty string if there is none.
+        //
+        std::wstring RepositoryPathPlugin::GetRoot(const std::wstring& p_Parent,
+                                                   const ConversionContext& p_Context)
+        {
+            const SettingsSnapshot* const pSettings = p_Context.GetSettingsSnapshot();
+            assert(pSettings != nullptr);
+
+            std::wstring root;
+            if (pSettings != nullptr) {
+                root = RepositoryRootCache::GetRepositoryRoot(p_Parent, pSettings->GetProjectRootMarkers());
+            }
+            return root;
+        }
+
+        //
+        // Returns the path of a file relative to a repository root,
+        // using forward slashes like version control tools do.
+        //
+        // @param p_File File path.
+        // @param p_Root Path of the root of the repository enclosing p_File,
+        //               or an empty string if there is none.
+        // @return Relative path, or p_File if p_Root is empty.
+        //
+        std::wstring RepositoryPathPlugin::GetRelativePath(const std::wstring& p_File,
+                                                           const std::wstring& p_Root)
+        {
+            if (p_Root.empty() || p_File.size() <= p_Root.size() + 1) {
+                return p_File;
+            }
+            std::wstring relativePath = p_File.substr(p_Root.size() + 1);
+            StringUtils::ReplaceChar(relativePath, L'\\', L'/');
+            return relativePath;
+        }
+
+    } // namespace Plugins
+
+} // namespace PCC
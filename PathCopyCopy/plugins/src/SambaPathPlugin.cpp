@@ -23,12 +23,13 @@
 #include <stdafx.h>
 #include <SambaPathPlugin.h>
 #include <resource.h>
+#include <SettingsSnapshot.h>
 
 
 namespace
 {
-    const std::wstring  FILE_URI_PREFIX         = L"file://";   // Prefix of file URI paths
-    const std::wstring  SAMBA_URI_PREFIX        = L"smb://";    // Prefix of Samba paths
+    const wchar_t       SAMBA_URI_PREFIX[]          = L"smb:///";   // Prefix of Samba paths of local files
+    const wchar_t       NETWORK_SAMBA_URI_PREFIX[]  = L"smb://";    // Prefix of Samba paths of network files
 
     // Plugin unique ID: {7DA6A4A2-AE54-40E0-9910-EBD9EF3F017E}
     const GUID          SAMBA_PATH_PLUGIN_ID = { 0x7da6a4a2, 0xae54, 0x40e0, { 0x99, 0x10, 0xeb, 0xd9, 0xef, 0x3f, 0x1, 0x7e } };
@@ -62,20 +63,20 @@ namespace PCC
         // Returns the path of the specified file in Samba format
         //
         // @param p_File File path.
+        // @param p_rResolver Resolver used to perform network lookups.
+        // @param p_Context Context of the conversion.
         // @return Samba path.
         //
-        std::wstring SambaPathPlugin::GetPath(const std::wstring& p_File) const
+        std::wstring SambaPathPlugin::GetUNCPath(const std::wstring& p_File,
+                                                 UNCPathResolver& p_rResolver,
+                                                 const ConversionContext& p_Context) const
         {
-            // First call inherited version to get the Internet path.
-            std::wstring path = InternetPathPlugin::GetPath(p_File);
-
-            // The Internet path plugin did almost all the job for us.
-            // All we have to do is replace the prefix.
-            if (path.find(FILE_URI_PREFIX) == 0) {
-                path = SAMBA_URI_PREFIX + path.replace(0, FILE_URI_PREFIX.size(), L"");
-            }
-
-            return path;
+            // Build the Samba path directly from the UNC path instead of converting
+            // the file URI, replacing server names with their aliases on the way.
+            const SettingsSnapshot* const pSettings = p_Context.GetSettingsSnapshot();
+            return BuildURI(LongUNCPathPlugin::GetUNCPath(p_File, p_rResolver, p_Context),
+                            SAMBA_URI_PREFIX, NETWORK_SAMBA_URI_PREFIX,
+                            pSettings != nullptr ? &pSettings->GetSambaServerAliases() : nullptr);
         }
 
     } // namespace Plugins
@@ -58,13 +58,27 @@ namespace PCC
         // This sample plugin simply returns the file path as-is.
         //
         // @param p_File File path.
+        // @param p_Context Context of the conversion.
         // @return File path itself.
         //
-        std::wstring SamplePlugin::GetPath(const std::wstring& p_File) const
+        std::wstring SamplePlugin::GetPath(const std::wstring& p_File,
+                                           const ConversionContext& /*p_Context*/) const
         {
             return p_File;
         }
 
+        //
+        // Returns the class of cost of the work performed by this plugin.
+        // Since we return paths as-is, we don't do anything expensive.
+        //
+        // @param p_Context Context in which the plugin is used.
+        // @return PluginCost::Pure.
+        //
+        PluginCost SamplePlugin::CostClass(const ConversionContext& /*p_Context*/) const
+        {
+            return PluginCost::Pure;
+        }
+
     } // namespace Plugins
 
 } // namespace PCC
@@ -58,12 +58,14 @@ namespace PCC
         // Returns the short name of the specified file.
         //
         // @param p_File File path.
+        // @param p_Context Context of the conversion.
         // @return Short file name.
         //
-        std::wstring ShortNamePlugin::GetPath(const std::wstring& p_File) const
+        std::wstring ShortNamePlugin::GetPath(const std::wstring& p_File,
+                                              const ConversionContext& p_Context) const
         {
             // Call parent to get the short path.
-            std::wstring shortPath = ShortPathPlugin::GetPath(p_File);
+            std::wstring shortPath = ShortPathPlugin::GetPath(p_File, p_Context);
 
             // Get the last part, the file name.
             size_t lastDelimiterPos = shortPath.find_last_of(L"/\\");
@@ -80,15 +82,17 @@ namespace PCC
         // Determines if this plugin is androgynous. It is considered androgynous
         // if the long name plugin is not shown according to settings.
         //
+        // @param p_Context Context in which the plugin is used.
         // @return true to use androgynous description, false to use normal description.
         //
-        bool ShortNamePlugin::IsAndrogynous() const
+        bool ShortNamePlugin::IsAndrogynous(const ConversionContext& p_Context) const
         {
-            assert(m_pSettings != nullptr);
+            const Settings* const pSettings = p_Context.GetSettings();
+            assert(pSettings != nullptr);
 
-            return m_pSettings != nullptr &&
-                   m_pSettings->GetDropRedundantWords() &&
-                   !PluginUtils::IsPluginShown(*m_pSettings, LongNamePlugin::ID);
+            return pSettings != nullptr &&
+                   pSettings->GetDropRedundantWords() &&
+                   !pSettings->IsPluginShown(LongNamePlugin::ID);
         }
 
     } // namespace Plugins
@@ -25,6 +25,8 @@
 #include <PathCopyCopySettings.h>
 #include <PluginUtils.h>
 #include <resource.h>
+#include <SettingsSnapshot.h>
+#include <ShortNameSupportCache.h>
 
 #include <assert.h>
 
@@ -54,28 +56,45 @@ namespace PCC
             return ID;
         }
 
+        //
+        // Determines if the plugin should be enabled in the contextual menu.
+        // If the settings say so, the plugin is disabled for files on volumes
+        // that have no short names (see ShortNameSupportCache).
+        //
+        // @param p_ParentPath Path of the parent folder of items being acted upon.
+        // @param p_File Path of the file or folder being acted upon.
+        // @param p_Context Context in which the plugin is used.
+        // @return true if the plugin should be enabled, false otherwise.
+        //
+        bool ShortPathPlugin::Enabled(const std::wstring& /*p_ParentPath*/,
+                                      const std::wstring& p_File,
+                                      const ConversionContext& p_Context) const
+        {
+            const SettingsSnapshot* const pSettings = p_Context.GetSettingsSnapshot();
+            return pSettings == nullptr ||
+                   !pSettings->GetDisableShortNamesIfUnsupported() ||
+                   ShortNameSupportCache::MayHaveShortNames(p_File);
+        }
+
         //
         // Returns the short path of the specified file.
         //
         // @param p_File File path.
+        // @param p_Context Context of the conversion.
         // @return Short path.
         //
-        std::wstring ShortPathPlugin::GetPath(const std::wstring& p_File) const
+        std::wstring ShortPathPlugin::GetPath(const std::wstring& p_File,
+                                              const ConversionContext& p_Context) const
         {
-            assert(m_pSettings != nullptr);
+            const SettingsSnapshot* const pSettings = p_Context.GetSettingsSnapshot();
+            assert(pSettings != nullptr);
 
-            std::wstring path(p_File);
-            if (!path.empty()) {
-                wchar_t shortPath[MAX_PATH + 1];
-                DWORD copied = ::GetShortPathNameW(p_File.c_str(),
-                                                   shortPath,
-                                                   sizeof(shortPath) / sizeof(wchar_t));
-                if (copied != 0) {
-                    path.assign(shortPath, copied);
-                }
+            std::wstring path;
+            if (!p_File.empty()) {
+                path = PluginUtils::GetShortPath(p_File, p_Context.GetMetadataCache());
 
                 // Append separator if needed.
-                if (m_pSettings != nullptr && m_pSettings->GetAppendSeparatorForDirectories() && PluginUtils::IsDirectory(path)) {
+                if (pSettings != nullptr && pSettings->GetAppendSeparatorForDirectories() && PluginUtils::IsDirectory(path, p_Context.GetMetadataCache())) {
                     path += L"\\";
                 }
             }
@@ -100,15 +119,17 @@ namespace PCC
         // Determines if this plugin is androgynous. It is considered androgynous
         // if the long path plugin is not shown according to settings.
         //
+        // @param p_Context Context in which the plugin is used.
         // @return true to use androgynous description, false to use normal description.
         //
-        bool ShortPathPlugin::IsAndrogynous() const
+        bool ShortPathPlugin::IsAndrogynous(const ConversionContext& p_Context) const
         {
-            assert(m_pSettings != nullptr);
+            const Settings* const pSettings = p_Context.GetSettings();
+            assert(pSettings != nullptr);
 
-            return m_pSettings != nullptr &&
-                   m_pSettings->GetDropRedundantWords() &&
-                   !PluginUtils::IsPluginShown(*m_pSettings, LongPathPlugin::ID);
+            return pSettings != nullptr &&
+                   pSettings->GetDropRedundantWords() &&
+                   !pSettings->IsPluginShown(LongPathPlugin::ID);
         }
 
     } // namespace Plugins
@@ -56,22 +56,20 @@ namespace PCC
         // Returns the short UNC path of the specified file's parent directory.
         //
         // @param p_File File path.
+        // @param p_rResolver Resolver used to perform network lookups.
+        // @param p_Context Context of the conversion.
         // @return UNC path of parent if file has one, otherwise its short path.
         //
-        std::wstring ShortUNCFolderPlugin::GetPath(const std::wstring& p_File) const
+        std::wstring ShortUNCFolderPlugin::GetUNCPath(const std::wstring& p_File,
+                                                      UNCPathResolver& p_rResolver,
+                                                      const ConversionContext& p_Context) const
         {
             // First call inherited to get a long path.
-            std::wstring path = LongUNCFolderPlugin::GetPath(p_File);
+            std::wstring path = LongUNCFolderPlugin::GetUNCPath(p_File, p_rResolver, p_Context);
 
             // Now ask for a short version and return it.
             if (!path.empty()) {
-                wchar_t shortPath[MAX_PATH + 1];
-                DWORD copied = ::GetShortPathNameW(path.c_str(),
-                                                   shortPath,
-                                                   sizeof(shortPath) / sizeof(wchar_t));
-                if (copied != 0) {
-                    path.assign(shortPath, copied);
-                }
+                path = PluginUtils::GetShortPath(path, p_Context.GetMetadataCache());
             }
             return path;
         }
@@ -80,15 +78,17 @@ namespace PCC
         // Determines if this plugin is androgynous. It is considered androgynous
         // if the long UNC folder plugin is not shown according to settings.
         //
+        // @param p_Context Context in which the plugin is used.
         // @return true to use androgynous description, false to use normal description.
         //
-        bool ShortUNCFolderPlugin::IsAndrogynous() const
+        bool ShortUNCFolderPlugin::IsAndrogynous(const ConversionContext& p_Context) const
         {
-            assert(m_pSettings != nullptr);
+            const Settings* const pSettings = p_Context.GetSettings();
+            assert(pSettings != nullptr);
 
-            return m_pSettings != nullptr &&
-                   m_pSettings->GetDropRedundantWords() &&
-                   !PluginUtils::IsPluginShown(*m_pSettings, LongUNCFolderPlugin::ID);
+            return pSettings != nullptr &&
+                   pSettings->GetDropRedundantWords() &&
+                   !pSettings->IsPluginShown(LongUNCFolderPlugin::ID);
         }
 
     } // namespace Plugins
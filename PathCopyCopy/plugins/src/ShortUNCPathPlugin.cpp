@@ -56,22 +56,20 @@ namespace PCC
         // Returns the short UNC path of the specified file.
         //
         // @param p_File File path.
+        // @param p_rResolver Resolver used to perform network lookups.
+        // @param p_Context Context of the conversion.
         // @return Short UNC path.
         //
-        std::wstring ShortUNCPathPlugin::GetPath(const std::wstring& p_File) const
+        std::wstring ShortUNCPathPlugin::GetUNCPath(const std::wstring& p_File,
+                                                    UNCPathResolver& p_rResolver,
+                                                    const ConversionContext& p_Context) const
         {
             // First call inherited to get a long path.
-            std::wstring path = LongUNCPathPlugin::GetPath(p_File);
+            std::wstring path = LongUNCPathPlugin::GetUNCPath(p_File, p_rResolver, p_Context);
 
             // Now ask for a short version and return it.
             if (!path.empty()) {
-                wchar_t shortPath[MAX_PATH + 1];
-                DWORD copied = ::GetShortPathNameW(path.c_str(),
-                                                   shortPath,
-                                                   sizeof(shortPath) / sizeof(wchar_t));
-                if (copied != 0) {
-                    path.assign(shortPath, copied);
-                }
+                path = PluginUtils::GetShortPath(path, p_Context.GetMetadataCache());
             }
             return path;
         }
@@ -80,15 +78,17 @@ namespace PCC
         // Determines if this plugin is androgynous. It is considered androgynous
         // if the long UNC path plugin is not shown according to settings.
         //
+        // @param p_Context Context in which the plugin is used.
         // @return true to use androgynous description, false to use normal description.
         //
-        bool ShortUNCPathPlugin::IsAndrogynous() const
+        bool ShortUNCPathPlugin::IsAndrogynous(const ConversionContext& p_Context) const
         {
-            assert(m_pSettings != nullptr);
+            const Settings* const pSettings = p_Context.GetSettings();
+            assert(pSettings != nullptr);
 
-            return m_pSettings != nullptr &&
-                   m_pSettings->GetDropRedundantWords() &&
-                   !PluginUtils::IsPluginShown(*m_pSettings, LongUNCPathPlugin::ID);
+            return pSettings != nullptr &&
+                   pSettings->GetDropRedundantWords() &&
+                   !pSettings->IsPluginShown(LongUNCPathPlugin::ID);
         }
 
     } // namespace Plugins
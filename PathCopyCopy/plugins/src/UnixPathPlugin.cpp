@@ -21,9 +21,12 @@
 
 #include <stdafx.h>
 #include <UnixPathPlugin.h>
+#include <StringUtils.h>
 #include <resource.h>
 
 #include <algorithm>
+#include <cwchar>
+#include <cwctype>
 
 
 namespace
@@ -60,16 +63,13 @@ namespace PCC
         // Returns the Unix path of the specified file.
         //
         // @param p_File File path.
+        // @param p_Context Context of the conversion.
         // @return File path with backslashes replaced by forward slashes.
         //
-        std::wstring UnixPathPlugin::GetPath(const std::wstring& p_File) const
+        std::wstring UnixPathPlugin::GetPath(const std::wstring& p_File,
+                                             const ConversionContext& p_Context) const
         {
-            // Call parent to get long path.
-            std::wstring path = LongPathPlugin::GetPath(p_File);
-
-            // Replace all backslashes with forward slashes and return the path.
-            std::replace(path.begin(), path.end(), L'\\', L'/');
-            return path;
+            return GetUnixPath(p_File, p_Context, nullptr, false);
         }
 
         //
@@ -87,13 +87,72 @@ namespace PCC
         //
         // Determines if this plugin is androgynous. In our case, it never is.
         //
+        // @param p_Context Context in which the plugin is used.
         // @return true to use androgynous description, false to use normal description.
         //
-        bool UnixPathPlugin::IsAndrogynous() const
+        bool UnixPathPlugin::IsAndrogynous(const ConversionContext& /*p_Context*/) const
         {
             return false;
         }
 
+        //
+        // Converts the long path of a file to a Unix-style path. This is shared
+        // by the plugins deriving from us, so that the path is converted in a
+        // single pass with at most one allocation.
+        //
+        // @param p_File File path.
+        // @param p_Context Context of the conversion.
+        // @param p_pDrivePrefix If set, a leading drive letter like "C:" is replaced
+        //                       by this prefix followed by the lowercase drive letter.
+        // @param p_EscapeSpaces Whether to escape spaces bash-style ("\ ").
+        // @param p_pMountTable If set, the path is first converted using this mount
+        //                      table; p_pDrivePrefix is only used if no mount matches.
+        // @return Unix-style path.
+        //
+        std::wstring UnixPathPlugin::GetUnixPath(const std::wstring& p_File,
+                                                 const ConversionContext& p_Context,
+                                                 const wchar_t* const p_pDrivePrefix,
+                                                 const bool p_EscapeSpaces,
+                                                 const PosixMountTable* const p_pMountTable /*= nullptr*/) const
+        {
+            // Call parent to get long path.
+            std::wstring path = LongPathPlugin::GetPath(p_File, p_Context);
+
+            // If a mount point matches, the rest of the path still needs its backslashes replaced.
+            const bool mounted = p_pMountTable != nullptr && p_pMountTable->Apply(path);
+            const bool replaceDrive = !mounted && p_pDrivePrefix != nullptr && path.size() >= 3 && path[1] == L':';
+            const std::wstring::size_type numSpaces = p_EscapeSpaces
+                ? static_cast<std::wstring::size_type>(std::count(path.cbegin(), path.cend(), L' '))
+                : 0;
+            if (!replaceDrive && numSpaces == 0) {
+                // Only need to replace backslashes with forward slashes, do it in-place.
+                StringUtils::ReplaceChar(path, L'\\', L'/');
+                return path;
+            }
+
+            // Compute the size of the result so that we can build it in a single allocation.
+            const std::wstring::size_type prefixSize = replaceDrive ? std::wcslen(p_pDrivePrefix) + 1 : 0;
+            const std::wstring::size_type start = replaceDrive ? 2 : 0;
+            std::wstring unixPath;
+            unixPath.reserve(prefixSize + path.size() - start + numSpaces);
+            if (replaceDrive) {
+                unixPath.append(p_pDrivePrefix);
+                unixPath.push_back(static_cast<wchar_t>(::towlower(path[0])));
+            }
+            for (auto it = path.cbegin() + start; it != path.cend(); ++it) {
+                const wchar_t c = *it;
+                if (c == L'\\') {
+                    unixPath.push_back(L'/');
+                } else {
+                    if (c == L' ' && p_EscapeSpaces) {
+                        unixPath.push_back(L'\\');
+                    }
+                    unixPath.push_back(c);
+                }
+            }
+            return unixPath;
+        }
+
     } // namespace Plugins
 
 } // namespace PCC
@@ -21,17 +21,12 @@
 
 #include <stdafx.h>
 #include <WSLPathPlugin.h>
-#include <StringUtils.h>
 #include <resource.h>
-
-#include <sstream>
+#include <WSLMountRootCache.h>
 
 
 namespace
 {
-    // Strings used to build a WSL path.
-    const wchar_t MNT_PREFIX[]   = L"/mnt/";
-
     // Plugin unique ID: {BD574871-5DF9-4B64-83D1-2AF9C0C17F66}
     const GUID WSL_PATH_PLUGIN_ID = { 0xbd574871, 0x5df9, 0x4b64, { 0x83, 0xd1, 0x2a, 0xf9, 0xc0, 0xc1, 0x7f, 0x66 } };
 
@@ -64,28 +59,35 @@ namespace PCC
         // Returns the WSL path of the specified file.
         //
         // @param p_File File path.
+        // @param p_Context Context of the conversion.
         // @return File path in WSL format (/mnt/c/...)
         //
-        std::wstring WSLPathPlugin::GetPath(const std::wstring& p_File) const
+        std::wstring WSLPathPlugin::GetPath(const std::wstring& p_File,
+                                            const ConversionContext& p_Context) const
         {
-            // Call parent to get Unix path.
-            std::wstring path = UnixPathPlugin::GetPath(p_File);
+            // Replace the drive letter with <mount root>/letter and escape spaces bash-style.
+            // This works without quotes.
+            return GetUnixPath(p_File, p_Context, WSLMountRootCache::GetMountRoot().c_str(), true);
+        }
 
-            // Check if the file begins with a drive letter. If so,
-            // remove the drive letter and replace it with /mnt/letter.
-            if (path.size() >= 3 && path[1] == L':') {
-                std::wstringstream newPathSS;
-                newPathSS << MNT_PREFIX                                 // The mnt prefix
-                          << static_cast<wchar_t>(::towlower(path[0]))  // Drive letter
-                          << path.substr(2);                            // Rest of the path, including the slash after that : we had.
-                path = newPathSS.str();
+        //
+        // Returns the WSL paths of the specified files. The mount root
+        // is only fetched once for all files.
+        //
+        // @param p_vFiles File paths.
+        // @param p_Context Context of the conversion.
+        // @return File paths in WSL format.
+        //
+        WStringV WSLPathPlugin::GetPaths(const FilesV& p_vFiles,
+                                         const ConversionContext& p_Context) const
+        {
+            const std::wstring mountRoot = WSLMountRootCache::GetMountRoot();
+            WStringV vPaths;
+            vPaths.reserve(p_vFiles.size());
+            for (const std::wstring& file : p_vFiles) {
+                vPaths.push_back(GetUnixPath(file, p_Context, mountRoot.c_str(), true));
             }
-
-            // Escape spaces bash-style. This works without quotes.
-            StringUtils::ReplaceAll(path, L" ", L"\\ ");
-
-            // Return modified path.
-            return path;
+            return vPaths;
         }
 
     } // namespace Plugins
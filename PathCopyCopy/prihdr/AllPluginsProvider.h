@@ -22,14 +22,21 @@
 #pragma once
 
 #include "Plugin.h"
+#include "PluginDependencyGraph.h"
 #include "PluginProvider.h"
 
+#include <memory>
+#include <mutex>
+#include <string>
+
 
 namespace PCC
 {
     //
     // Object to access plugins found in a set of all plugins.
-    // Only stores a reference to the set.
+    // Only stores a reference to the set. References between plugins
+    // are resolved once, the first time a plugin is requested
+    // (see PluginDependencyGraph).
     //
     class AllPluginsProvider : public PluginProvider
     {
@@ -40,9 +47,21 @@ namespace PCC
                         operator=(const AllPluginsProvider&) = delete;
 
         virtual PluginSP GetPlugin(const GUID& p_PluginId) const override;
+        virtual bool    GetPathWithPlugin(const GUID& p_PluginId,
+                                          std::wstring& p_rPath,
+                                          const ConversionContext& p_Context) const override;
+
+        void            ClearCachedPaths() const;
 
     private:
         const PluginSPS& m_sspAllPlugins;   // Set containing all plugins. We do not assume ownership.
+        mutable std::unique_ptr<PluginDependencyGraph>
+                        m_upGraph;          // Graph of references between plugins, created on first use.
+        mutable std::once_flag
+                        m_GraphInit;        // Flag used to create m_upGraph only once.
+
+        const PluginDependencyGraph&
+                        GetGraph() const;
     };
 
 } // namespace PCC
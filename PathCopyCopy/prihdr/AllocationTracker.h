@@ -0,0 +1,175 @@
+// AllocationTracker.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+
+#include <windows.h>
+
+
+namespace PCC
+{
+    //
+    // AllocationTracker
+    //
+    // Counts heap allocations performed by our module, to measure the heap
+    // churn we cause in the processes that load us. Allocations are only
+    // counted in instrumented builds, where PCC_TRACK_ALLOCATIONS is defined
+    // (build with /p:PCCTrackAllocations=true); the global operator new is
+    // then replaced to update our counters. In other builds, Enabled returns
+    // false and nothing is counted.
+    //
+    // Counters are shared by all threads, so that allocations performed by
+    // worker threads on behalf of an operation are accounted for; operations
+    // should therefore be measured in an otherwise idle process.
+    //
+    // Allocations are also totaled per phase of our operations: each traced
+    // scope (see StTraceEvent) records the allocations performed while it
+    // was active using StAllocationScope.
+    //
+    class AllocationTracker final
+    {
+    public:
+        // Allocations counted at some point in time, or between two points in time.
+        struct Counts {
+            ULONGLONG   m_Allocations;  // Number of allocations.
+            ULONGLONG   m_Bytes;        // Number of bytes allocated.
+        };
+
+        // Totals of allocations performed in one phase.
+        struct PhaseTotals {
+            const wchar_t*
+                        m_pName;        // Name of phase; a literal string.
+            ULONGLONG   m_Calls;        // Number of times the phase was performed.
+            Counts      m_Counts;       // Allocations performed during all calls.
+        };
+
+        // Callback used to enumerate phase totals.
+        typedef void (*PhaseTotalsProc)(const PhaseTotals& p_Totals,
+                                        void* p_pContext);
+
+                        AllocationTracker() = delete;
+                        ~AllocationTracker() = delete;
+
+                        //
+                        // Checks if allocations are counted in this build.
+                        //
+                        // @return true if PCC_TRACK_ALLOCATIONS is defined.
+                        //
+        static bool     Enabled()
+                        {
+#ifdef PCC_TRACK_ALLOCATIONS
+                            return true;
+#else
+                            return false;
+#endif
+                        }
+
+                        //
+                        // Records an allocation. Called by our operator new.
+                        //
+                        // @param p_Size Number of bytes allocated.
+                        //
+        static void     Count(const size_t p_Size)
+                        {
+                            s_Allocations.fetch_add(1, std::memory_order_relaxed);
+                            s_Bytes.fetch_add(p_Size, std::memory_order_relaxed);
+                        }
+
+        static Counts   Current();
+        static void     RecordPhase(const wchar_t* const p_pName,
+                                    const Counts& p_Counts);
+        static void     EnumPhases(PhaseTotalsProc const p_pProc,
+                                   void* const p_pContext,
+                                   const bool p_Reset);
+
+    private:
+        // Maximum number of phases that can be totaled.
+        static const size_t
+                        MAX_PHASES = 64;
+
+        static std::atomic<ULONGLONG>
+                        s_Allocations;          // Number of allocations performed since the module was loaded.
+        static std::atomic<ULONGLONG>
+                        s_Bytes;                // Number of bytes allocated since the module was loaded.
+        static PhaseTotals
+                        s_aPhases[MAX_PHASES];  // Totals of phases; fixed-size so that recording does not allocate.
+        static size_t   s_NumPhases;            // Number of phases in s_aPhases.
+        static std::mutex
+                        s_PhasesLock;           // Lock protecting s_aPhases and s_NumPhases.
+    };
+
+    //
+    // StAllocationScope
+    //
+    // Stack-based class that records the allocations performed while a
+    // scope is active in the totals of a phase (see AllocationTracker).
+    // Does nothing in builds where allocations are not counted.
+    //
+    class StAllocationScope final
+    {
+    public:
+#ifdef PCC_TRACK_ALLOCATIONS
+                        //
+                        // Constructor. Starts counting allocations.
+                        //
+                        // @param p_pName Name of phase; must be a literal string.
+                        //
+        explicit        StAllocationScope(const wchar_t* const p_pName)
+                            : m_pName(p_pName),
+                              m_Start(AllocationTracker::Current())
+                        {
+                        }
+
+                        //
+                        // Destructor. Records allocations performed in the scope.
+                        //
+                        ~StAllocationScope()
+                        {
+                            const AllocationTracker::Counts end = AllocationTracker::Current();
+                            const AllocationTracker::Counts counts = { end.m_Allocations - m_Start.m_Allocations,
+                                                                       end.m_Bytes - m_Start.m_Bytes };
+                            AllocationTracker::RecordPhase(m_pName, counts);
+                        }
+#else
+        explicit        StAllocationScope(const wchar_t* const /*p_pName*/)
+                        {
+                        }
+#endif
+
+                        //
+                        // Copying not supported.
+                        //
+                        StAllocationScope(const StAllocationScope&) = delete;
+        StAllocationScope&
+                        operator=(const StAllocationScope&) = delete;
+
+#ifdef PCC_TRACK_ALLOCATIONS
+    private:
+        const wchar_t*  m_pName;            // Name of phase.
+        AllocationTracker::Counts
+                        m_Start;            // Allocations counted when scope started.
+#endif
+    };
+
+} // namespace PCC
@@ -0,0 +1,72 @@
+// COMPluginHost.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include "COMPluginHostMessage.h"
+
+#include <mutex>
+#include <vector>
+
+#include <atlbase.h>
+#include <windows.h>
+
+
+namespace PCC
+{
+    //
+    // COMPluginHost
+    //
+    // Client for the COM plugin host, a persistent process (the COM plugin
+    // executor launched in host mode) that loads COM plugins outside of
+    // Explorer. Requests are sent over a named pipe; if the host does not
+    // answer in time, it is killed so that a hung plugin cannot freeze the
+    // shell. The host is started on first use and restarted as needed.
+    //
+    class COMPluginHost final
+    {
+    public:
+                        COMPluginHost() = delete;
+                        ~COMPluginHost() = delete;
+
+        static COMPluginHostMessage
+                        Call(const COMPluginHostMessage& p_Request);
+
+    private:
+        static ATL::CHandle
+                        s_hProcess;             // Handle to the host process.
+        static ATL::CHandle
+                        s_hPipe;                // Handle to our end of the pipe connected to the host.
+        static std::mutex
+                        s_Lock;                 // Lock serializing requests to the host.
+
+        static HRESULT  Start();
+        static void     Stop();
+        static HRESULT  Transact(const COMPluginHostMessage& p_Request,
+                                 std::vector<BYTE>& p_rvResponse);
+        static HRESULT  CompleteIO(const BOOL p_Result,
+                                   OVERLAPPED& p_rOverlapped,
+                                   const DWORD p_Timeout,
+                                   DWORD& p_rBytes);
+    };
+
+} // namespace PCC
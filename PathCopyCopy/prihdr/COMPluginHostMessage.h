@@ -0,0 +1,240 @@
+// COMPluginHostMessage.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <string.h>
+#include <windows.h>
+
+
+//
+// COMPluginHostMessage
+//
+// Message exchanged over the named pipe between Path Copy Copy and the
+// COM plugin host process. Each message is sent as a single pipe message
+// and contains a sequence of DWORDs, GUIDs and strings, read back in the
+// same order they were written.
+//
+// Requests start with a command and the ID of the plugin to use, followed
+// by arguments. Responses start with an HRESULT, followed by results
+// if it succeeded. See Command for details.
+//
+class COMPluginHostMessage final
+{
+public:
+                        //
+                        // Commands supported by the COM plugin host.
+                        //
+    enum Command : DWORD {
+        // Args: none. Results: description, group ID, group position, icon file, use default icon.
+        GetMetadata     = 1,
+
+        // Args: none. Results: help text.
+        GetHelpText     = 2,
+
+        // Args: parent path, file. Results: enabled (0 or 1).
+        Enabled         = 3,
+
+        // Args: number of files, files. Results: number of paths, paths.
+        GetPaths        = 4,
+    };
+
+                        //
+                        // Name of the command-line switch used to launch the COM plugin
+                        // executor in host mode. Must be followed by the pipe name.
+                        //
+    static const wchar_t* HostSwitch()
+                        {
+                            return L"/host";
+                        }
+
+                        //
+                        // Constructor for an empty message.
+                        //
+                        COMPluginHostMessage()
+                            : m_vData(),
+                              m_ReadPos(0)
+                        {
+                        }
+
+                        //
+                        // Constructor for a message received over the pipe.
+                        //
+                        // @param p_vData Message data.
+                        //
+    explicit            COMPluginHostMessage(std::vector<BYTE>&& p_vData)
+                            : m_vData(std::move(p_vData)),
+                              m_ReadPos(0)
+                        {
+                        }
+
+                        //
+                        // Returns the message data to send over the pipe.
+                        //
+                        // @return Message data.
+                        //
+    const std::vector<BYTE>& Data() const
+                        {
+                            return m_vData;
+                        }
+
+                        //
+                        // Appends a DWORD to the message.
+                        //
+                        // @param p_Value Value to append.
+                        // @return Reference to this, for chaining.
+                        //
+    COMPluginHostMessage& WriteDWORD(const DWORD p_Value)
+                        {
+                            return WriteBytes(&p_Value, sizeof(p_Value));
+                        }
+
+                        //
+                        // Appends a GUID to the message.
+                        //
+                        // @param p_Value Value to append.
+                        // @return Reference to this, for chaining.
+                        //
+    COMPluginHostMessage& WriteGUID(const GUID& p_Value)
+                        {
+                            return WriteBytes(&p_Value, sizeof(p_Value));
+                        }
+
+                        //
+                        // Appends a string to the message.
+                        //
+                        // @param p_pValue Pointer to string to append.
+                        // @param p_Length Length of string, in characters.
+                        // @return Reference to this, for chaining.
+                        //
+    COMPluginHostMessage& WriteString(const wchar_t* const p_pValue,
+                                      const DWORD p_Length)
+                        {
+                            WriteDWORD(p_Length);
+                            return WriteBytes(p_pValue, p_Length * sizeof(wchar_t));
+                        }
+
+                        //
+                        // Appends a string to the message.
+                        //
+                        // @param p_Value String to append.
+                        // @return Reference to this, for chaining.
+                        //
+    COMPluginHostMessage& WriteString(const std::wstring& p_Value)
+                        {
+                            return WriteString(p_Value.c_str(), static_cast<DWORD>(p_Value.size()));
+                        }
+
+                        //
+                        // Appends the content of another message to this message.
+                        //
+                        // @param p_Other Message whose content to append.
+                        // @return Reference to this, for chaining.
+                        //
+    COMPluginHostMessage& Append(const COMPluginHostMessage& p_Other)
+                        {
+                            m_vData.insert(m_vData.end(), p_Other.m_vData.cbegin(), p_Other.m_vData.cend());
+                            return *this;
+                        }
+
+                        //
+                        // Reads the next DWORD in the message.
+                        //
+                        // @param p_rValue Where to store value.
+                        // @return true if value was read, false if message is too short.
+                        //
+    bool                ReadDWORD(DWORD& p_rValue)
+                        {
+                            return ReadBytes(&p_rValue, sizeof(p_rValue));
+                        }
+
+                        //
+                        // Reads the next GUID in the message.
+                        //
+                        // @param p_rValue Where to store value.
+                        // @return true if value was read, false if message is too short.
+                        //
+    bool                ReadGUID(GUID& p_rValue)
+                        {
+                            return ReadBytes(&p_rValue, sizeof(p_rValue));
+                        }
+
+                        //
+                        // Reads the next string in the message.
+                        //
+                        // @param p_rValue Where to store value.
+                        // @return true if value was read, false if message is too short.
+                        //
+    bool                ReadString(std::wstring& p_rValue)
+                        {
+                            DWORD length = 0;
+                            bool read = ReadDWORD(length) && length <= (m_vData.size() - m_ReadPos) / sizeof(wchar_t);
+                            if (read) {
+                                p_rValue.assign(length, L'\0');
+                                read = length == 0 || ReadBytes(&*p_rValue.begin(), length * sizeof(wchar_t));
+                            }
+                            return read;
+                        }
+
+private:
+    std::vector<BYTE>   m_vData;        // Message data.
+    size_t              m_ReadPos;      // Position of next value to read in m_vData.
+
+                        //
+                        // Appends raw bytes to the message.
+                        //
+                        // @param p_pBytes Pointer to bytes to append.
+                        // @param p_Size Number of bytes to append.
+                        // @return Reference to this, for chaining.
+                        //
+    COMPluginHostMessage& WriteBytes(const void* const p_pBytes,
+                                     const size_t p_Size)
+                        {
+                            const BYTE* const pBytes = static_cast<const BYTE*>(p_pBytes);
+                            m_vData.insert(m_vData.end(), pBytes, pBytes + p_Size);
+                            return *this;
+                        }
+
+                        //
+                        // Reads raw bytes from the message.
+                        //
+                        // @param p_pBytes Where to store bytes.
+                        // @param p_Size Number of bytes to read.
+                        // @return true if bytes were read, false if message is too short.
+                        //
+    bool                ReadBytes(void* const p_pBytes,
+                                  const size_t p_Size)
+                        {
+                            bool read = p_Size <= m_vData.size() - m_ReadPos;
+                            if (read) {
+                                if (p_Size != 0) {
+                                    ::memcpy(p_pBytes, &m_vData[m_ReadPos], p_Size);
+                                }
+                                m_ReadPos += p_Size;
+                            }
+                            return read;
+                        }
+};
@@ -0,0 +1,73 @@
+// COMPluginMetadataCache.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include "COMPlugin.h"
+
+#include <windows.h>
+
+
+namespace PCC
+{
+    //
+    // COMPluginMetadataCache
+    //
+    // Persistent cache of COM plugin metadata (description, group info
+    // and icon). Using cached metadata allows building menus without
+    // activating COM plugins, which can be expensive, especially for
+    // out-of-process or .NET plugins.
+    //
+    // Cached metadata is stored per-user in the registry. It is only
+    // considered valid as long as the plugin's COM registration and
+    // server file have not changed since it was cached.
+    //
+    // Plugins that fail to activate are also remembered, along with
+    // the error, so that they are not activated again (which can take
+    // a while, for example if the server is missing) until their
+    // registration changes.
+    //
+    class COMPluginMetadataCache final
+    {
+    public:
+                        COMPluginMetadataCache() = delete;
+                        ~COMPluginMetadataCache() = delete;
+
+        static bool     Get(const CLSID& p_CLSID,
+                            Plugins::COMPluginMetadata& p_rMetadata);
+        static void     Update(const CLSID& p_CLSID,
+                               const Plugins::COMPluginMetadata& p_Metadata);
+        static void     Refresh(const CLSID& p_CLSID);
+        static void     Remove(const CLSID& p_CLSID);
+
+        static bool     GetFailure(const CLSID& p_CLSID,
+                                   HRESULT& p_rResult);
+        static void     SetFailure(const CLSID& p_CLSID,
+                                   const HRESULT p_Result);
+
+    private:
+        static bool     GetStamps(const CLSID& p_CLSID,
+                                  ULONGLONG& p_rRegistrationStamp,
+                                  ULONGLONG& p_rServerStamp);
+    };
+
+} // namespace PCC
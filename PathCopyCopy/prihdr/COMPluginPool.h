@@ -0,0 +1,95 @@
+// COMPluginPool.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include "MeasuredMutex.h"
+#include "PathCopyCopyPrivateTypes.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <atlbase.h>
+#include <windows.h>
+
+
+namespace PCC
+{
+    // Forward declaration
+    namespace Plugins
+    {
+        class COMPlugin;
+    }
+
+    //
+    // COMPluginPool
+    //
+    // Per-thread pool of COM plugin instances. Creating COM plugins can be
+    // expensive, especially for out-of-process or .NET plugins, so instances
+    // are created lazily and reused as long as the thread that created them
+    // is alive, even after settings change.
+    //
+    // Because COM plugin instances are bound to the apartment that created them,
+    // a separate pool is kept for every thread.
+    //
+    class COMPluginPool final
+    {
+    public:
+        typedef std::shared_ptr<Plugins::COMPlugin> COMPluginSP;
+
+                        COMPluginPool() = delete;
+                        ~COMPluginPool() = delete;
+
+        static COMPluginSP
+                        GetPlugin(const CLSID& p_CLSID,
+                                  const bool p_Reusable,
+                                  const bool p_Isolated);
+        static void     KeepOnly(const CLSIDV& p_vCLSIDs);
+        static void     ReleaseUnused();
+
+    private:
+        // Map of pooled plugins, per CLSID.
+        typedef std::map<CLSID, COMPluginSP, CLSIDLess> COMPluginSPM;
+
+        // Vector of plugins to release.
+        typedef std::vector<COMPluginSP> COMPluginSPV;
+
+        // Pool of plugins created by a specific thread.
+        struct ThreadPool {
+            ATL::CHandle    m_hOwnerThread;     // Handle to the thread that created the plugins.
+            COMPluginSPM    m_mspPlugins;       // Plugins created by that thread.
+        };
+        typedef std::map<DWORD, ThreadPool> ThreadPoolM;
+
+        static ThreadPoolM
+                        s_mPools;               // Pools of plugins, per thread ID.
+        static MeasuredMutex
+                        s_Lock;                 // Lock protecting the pools.
+
+        static ThreadPool&
+                        GetThreadPool();
+        static void     DropExitedThreadPools(COMPluginSPV& p_rvspToRelease);
+    };
+
+} // namespace PCC
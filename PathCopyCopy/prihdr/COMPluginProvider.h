@@ -42,6 +42,9 @@ namespace PCC
         // @return CLSIDs of registered COM plugins.
         //
         virtual CLSIDV  GetCOMPlugins() const = 0;
+
+        virtual bool    CanReuseCOMPlugin(const CLSID& p_CLSID) const;
+        virtual bool    ShouldIsolateCOMPlugin(const CLSID& p_CLSID) const;
     };
 
 } // namespace PCC
@@ -0,0 +1,70 @@
+// CacheManager.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include <mutex>
+
+#include <atlbase.h>
+#include <windows.h>
+
+
+namespace PCC
+{
+    //
+    // CacheManager
+    //
+    // Static class that bounds the lifetime of our process-wide caches. Since
+    // the shell can keep our DLL loaded long after the last contextual menu
+    // has been shown, caches are trimmed once no menu has been requested for
+    // a while: menu icons (and GDI+), compiled regexes, COM plugins that can
+    // be released from any thread and network lookups. Caches are also trimmed
+    // when the system signals that memory is low.
+    //
+    // Trimmed caches are filled again on demand, so trimming only costs time
+    // on the next menu. Monitoring runs on a thread pool timer, which does not
+    // keep our DLL loaded; it must be stopped before the DLL is unloaded.
+    //
+    class CacheManager final
+    {
+    public:
+                        CacheManager() = delete;
+                        ~CacheManager() = delete;
+
+        static void     NotifyActivity();
+        static void     Trim();
+        static void     Stop();
+
+    private:
+        static HANDLE   s_hTimer;           // Timer checking if caches should be trimmed, if started.
+        static ATL::CHandle
+                        s_hLowMemory;       // Low memory resource notification, if created.
+        static DWORD    s_LastActivityTime; // Tick count of the last activity.
+        static bool     s_Trimmed;          // Whether caches have been trimmed since the last activity.
+        static std::mutex
+                        s_Lock;             // Lock protecting static members.
+
+        static void CALLBACK
+                        OnTimer(PVOID p_pContext,
+                                BOOLEAN p_TimedOut);
+    };
+
+} // namespace PCC
@@ -0,0 +1,58 @@
+// CachePrewarmer.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include <mutex>
+
+
+namespace PCC
+{
+    //
+    // CachePrewarmer
+    //
+    // Static class that fills process-wide caches in the background, so that
+    // the first contextual menu shown after the shell starts is as fast as the
+    // following ones. This loads the settings snapshot shared between processes,
+    // activates COM plugins (which loads their DLLs and their cached metadata),
+    // decodes menu icons and builds the network share index.
+    //
+    // Prewarming is done at most once per process, on a low-priority thread.
+    // It can be turned off in the settings.
+    //
+    class CachePrewarmer final
+    {
+    public:
+                        CachePrewarmer() = delete;
+                        ~CachePrewarmer() = delete;
+
+        static void     Start();
+
+    private:
+        static bool     s_Started;      // Whether prewarming has been started in this process.
+        static std::mutex
+                        s_Lock;         // Lock protecting s_Started.
+
+        static void     Prewarm();
+    };
+
+} // namespace PCC
@@ -0,0 +1,71 @@
+// ClipboardRenderWindow.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include <functional>
+
+#include <windows.h>
+
+
+namespace PCC
+{
+    //
+    // ClipboardRenderWindow
+    //
+    // Hidden window that owns the clipboard to provide data using delayed
+    // rendering. The data is only rendered if an application actually
+    // requests it, for instance when the user pastes.
+    //
+    // Windows are created on the calling thread, which must process messages.
+    // Each window destroys itself when it loses clipboard ownership.
+    //
+    class ClipboardRenderWindow final
+    {
+    public:
+        // Function that renders clipboard data in a memory block allocated
+        // via GlobalAlloc. Returns NULL if data cannot be rendered.
+        typedef std::function<HANDLE()> Renderer;
+
+                        ClipboardRenderWindow() = delete;
+                        ~ClipboardRenderWindow() = delete;
+
+        static bool     Create(const UINT p_Format,
+                               const Renderer& p_Renderer);
+
+    private:
+        // Information stored in each window.
+        struct State {
+            UINT        m_Format;       // Clipboard format rendered by the window.
+            Renderer    m_Renderer;     // Function used to render data.
+        };
+
+        static bool     RegisterWindowClass();
+        static void     Render(const State& p_State);
+        static LRESULT CALLBACK
+                        WindowProc(HWND p_hWnd,
+                                   UINT p_Msg,
+                                   WPARAM p_wParam,
+                                   LPARAM p_lParam);
+    };
+
+} // namespace PCC
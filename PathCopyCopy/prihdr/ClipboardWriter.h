@@ -0,0 +1,75 @@
+// ClipboardWriter.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include <windows.h>
+
+
+namespace PCC
+{
+    //
+    // ClipboardWriter
+    //
+    // Stores data in the clipboard without blocking the caller. Other
+    // applications (like clipboard managers or remote desktop clipboard
+    // sync) often hold the clipboard for a short time; if it cannot be
+    // opened right away, data is published from a worker thread that
+    // retries with an exponential backoff for a bounded time.
+    //
+    // If data is published while a previous publication is still pending,
+    // the previous data is dropped so that it does not overwrite the new one.
+    //
+    class ClipboardWriter final
+    {
+    public:
+        // Data to store in the clipboard in a given format.
+        struct Data {
+            UINT        m_Format;       // Clipboard format. Data with format 0 is skipped.
+            HANDLE      m_hData;        // Memory block allocated via GlobalAlloc.
+        };
+        typedef std::vector<Data> DataV;
+
+                        ClipboardWriter() = delete;
+                        ~ClipboardWriter() = delete;
+
+        static bool     Publish(const HWND p_hOwnerWnd,
+                                DataV& p_rvData);
+        static void     CancelPending();
+
+    private:
+        static std::atomic<unsigned long>
+                        s_Generation;       // Incremented for every publication; pending ones stop when it changes.
+
+        static bool     TryPublish(const HWND p_hOwnerWnd,
+                                   DataV& p_rvData,
+                                   const unsigned long* const p_pGeneration,
+                                   bool& p_rPublished);
+        static void     PublishWithRetry(DataV p_vData,
+                                         const unsigned long p_Generation);
+        static void     FreeData(DataV& p_rvData);
+    };
+
+} // namespace PCC
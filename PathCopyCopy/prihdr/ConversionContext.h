@@ -0,0 +1,84 @@
+// ConversionContext.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include "PathCopyCopyPrivateTypes.h"
+
+#include <string>
+
+#include <windows.h>
+
+
+namespace PCC
+{
+    //
+    // ConversionContext
+    //
+    // Immutable object passed to plugins when they compute paths. Gives access
+    // to the objects plugins need that depend on the current operation, like
+    // the settings and the provider used to look up other plugins. Plugins do
+    // not store this state themselves, so the same plugin instances can be used
+    // with different contexts, even concurrently.
+    //
+    // Plugins that convert paths should read settings through the settings
+    // snapshot when available, since it can be shared between threads; the
+    // Settings object is reserved for settings not found in the snapshot.
+    //
+    // Contexts used for a single operation on many files can also carry a
+    // FileMetadataCache shared by the plugins performing the operation.
+    //
+    // The objects referenced by the context are not owned by it; they must
+    // outlive it.
+    //
+    class ConversionContext final
+    {
+    public:
+                        ConversionContext();
+                        ConversionContext(const Settings* const p_pSettings,
+                                          const SettingsSnapshot* const p_pSettingsSnapshot,
+                                          const PluginProvider* const p_pPluginProvider);
+                        ConversionContext(const ConversionContext& p_Context,
+                                          FileMetadataCache* const p_pMetadataCache);
+
+        const Settings* GetSettings() const;
+        const SettingsSnapshot*
+                        GetSettingsSnapshot() const;
+        const PluginProvider*
+                        GetPluginProvider() const;
+        FileMetadataCache*
+                        GetMetadataCache() const;
+
+        bool            GetPathWithPlugin(const GUID& p_PluginId,
+                                          std::wstring& p_rPath) const;
+
+    private:
+        const Settings* m_pSettings;        // Optional object to access PCC settings.
+        const SettingsSnapshot*
+                        m_pSettingsSnapshot;// Optional immutable copy of settings used during conversions.
+        const PluginProvider*
+                        m_pPluginProvider;  // Optional object to access other plugins.
+        FileMetadataCache*
+                        m_pMetadataCache;   // Optional cache of file metadata for the current operation.
+    };
+
+} // namespace PCC
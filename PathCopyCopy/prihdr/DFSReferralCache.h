@@ -0,0 +1,79 @@
+// DFSReferralCache.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+
+#include <windows.h>
+
+
+namespace PCC
+{
+    //
+    // DFSReferralCache
+    //
+    // Process-wide cache of DFS referrals, used to resolve network paths in
+    // a DFS namespace to the network path of their target. Referrals are
+    // keyed by namespace root, link and directory, so that the DFS client is
+    // only queried once per directory for all files in it. Paths that are not
+    // in a DFS namespace are also cached, per namespace root. Entries are
+    // cached for the time to live of their referral, up to a maximum.
+    //
+    class DFSReferralCache final
+    {
+    public:
+                        DFSReferralCache() = delete;
+                        ~DFSReferralCache() = delete;
+
+        static bool     Resolve(std::wstring& p_rUNCPath);
+        static void     Flush();
+
+    private:
+        // Cached referral.
+        struct Entry {
+            std::wstring    m_Target;           // Network path of target, or empty if not in a DFS namespace.
+            std::wstring::size_type
+                            m_EntryPathSize;    // Size of the path of the DFS root or link replaced by m_Target.
+            bool            m_CoversSubpaths;   // Whether entry applies to all paths below its key, or only to its direct children.
+            DWORD           m_Timestamp;        // Tick count when referral was fetched.
+            DWORD           m_TimeToLive;       // Time during which entry can be used, in milliseconds.
+        };
+
+        // Map of cached referrals, per normalized path.
+        typedef std::map<std::wstring, Entry> EntryM;
+
+        static EntryM   s_mEntries;         // Cached referrals.
+        static std::mutex
+                        s_Lock;             // Lock protecting s_mEntries.
+
+        static bool     FindEntry(const std::wstring& p_Key,
+                                  const std::wstring::size_type p_RootSize,
+                                  Entry& p_rEntry);
+        static Entry    LookupEntry(const std::wstring& p_UNCPath,
+                                    const std::wstring& p_Key,
+                                    const std::wstring::size_type p_RootSize);
+    };
+
+} // namespace PCC
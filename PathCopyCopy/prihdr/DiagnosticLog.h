@@ -0,0 +1,115 @@
+// DiagnosticLog.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+
+#include <windows.h>
+
+
+namespace PCC
+{
+    //
+    // DiagnosticLog
+    //
+    // In-memory log of the events traced by our components (see Trace), for
+    // machines where an ETW session cannot be used. It is enabled by setting
+    // the DiagnosticLog value of the user's settings key to 1; the value is
+    // read when our objects are first requested. When disabled, recording
+    // costs a single atomic load.
+    //
+    // Events are recorded without locking in a fixed-size ring buffer: each
+    // writer claims a slot with an atomic increment. A thread pool timer
+    // periodically appends recorded events to a file in the user's local
+    // application data folder. If events are recorded faster than they are
+    // flushed, the oldest ones are dropped and their number is logged.
+    //
+    class DiagnosticLog final
+    {
+    public:
+                        DiagnosticLog() = delete;
+                        ~DiagnosticLog() = delete;
+
+        static void     Start();
+        static void     Stop();
+
+                        //
+                        // Checks if events should be recorded in the log.
+                        //
+                        // @return true if the log is enabled.
+                        //
+        static bool     Enabled()
+                        {
+                            return s_Enabled.load(std::memory_order_relaxed);
+                        }
+
+        static void     Record(const wchar_t* const p_pName,
+                               const GUID* const p_pId,
+                               const std::chrono::microseconds p_Duration,
+                               const size_t p_Count);
+
+    private:
+        // Number of events kept in the ring buffer.
+        static const size_t
+                        CAPACITY = 4096;
+
+        // Event recorded in the ring buffer.
+        struct Entry {
+            std::atomic<ULONGLONG>
+                        m_Sequence;     // Index of event + 1, or 0 while the entry is being written.
+            ULONGLONG   m_Time;         // Time of event, as a FILETIME.
+            DWORD       m_ThreadId;     // ID of thread that recorded the event.
+            const wchar_t*
+                        m_pName;        // Name of event; a literal string.
+            GUID        m_Id;           // ID of object the event is about.
+            bool        m_HasId;        // Whether m_Id has been specified.
+            long long   m_Duration;     // Duration of event, in microseconds.
+            size_t      m_Count;        // Number of items processed.
+        };
+
+        static Entry    s_Entries[CAPACITY];    // Ring buffer of events.
+        static std::atomic<ULONGLONG>
+                        s_NextEvent;            // Index of next event to record.
+        static std::atomic<bool>
+                        s_Enabled;              // Whether events should be recorded.
+        static bool     s_Started;              // Whether Start has read our setting since the last Stop.
+        static HANDLE   s_hTimer;               // Timer flushing events to the file, if started.
+        static std::mutex
+                        s_Lock;                 // Lock protecting s_Started and s_hTimer.
+        static ULONGLONG
+                        s_NextFlushed;          // Index of next event to write to the file.
+        static std::wstring
+                        s_FilePath;             // Path of log file.
+        static std::mutex
+                        s_FlushLock;            // Lock protecting s_NextFlushed and s_FilePath.
+
+        static void     Flush();
+
+        static void CALLBACK
+                        OnTimer(PVOID p_pContext,
+                                BOOLEAN p_TimedOut);
+    };
+
+} // namespace PCC
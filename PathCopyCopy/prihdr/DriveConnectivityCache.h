@@ -0,0 +1,82 @@
+// DriveConnectivityCache.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <windows.h>
+
+
+namespace PCC
+{
+    //
+    // DriveConnectivityCache
+    //
+    // Process-wide cache of the connectivity state of drives, per drive letter.
+    // Drives are probed on a worker thread (see NetworkEnvironment::IsDriveReachable);
+    // callers wait for probes for a short time only, so that a disconnected
+    // or slow mapped drive cannot stall the caller (usually Explorer's UI thread)
+    // every time one of its files is accessed. Drives that could not be probed
+    // in time are considered unreachable until the probe completes.
+    //
+    class DriveConnectivityCache final
+    {
+    public:
+                        DriveConnectivityCache() = delete;
+                        ~DriveConnectivityCache() = delete;
+
+        static bool     IsReachable(const std::wstring& p_Path);
+        static void     Flush();
+
+    private:
+        // Cached result of a probe.
+        struct Entry {
+            bool            m_Reachable;    // Whether drive was reachable.
+            DWORD           m_Timestamp;    // Tick count when probe completed.
+        };
+
+        // State of a probe in progress, shared with the worker thread.
+        struct PendingProbe {
+            std::condition_variable
+                            m_Completed;    // Signaled when probe completes.
+            bool            m_Done;         // Whether probe completed.
+        };
+        typedef std::shared_ptr<PendingProbe> PendingProbeSP;
+
+        typedef std::map<wchar_t, Entry> EntryM;
+        typedef std::map<wchar_t, PendingProbeSP> PendingProbeM;
+
+        static EntryM   s_mEntries;         // Cached probe results, per uppercase drive letter.
+        static PendingProbeM
+                        s_mspPendingProbes; // Probes in progress, per uppercase drive letter.
+        static std::mutex
+                        s_Lock;             // Lock protecting static members.
+
+        static void     Probe(const wchar_t p_Drive,
+                              const PendingProbeSP& p_spPendingProbe);
+    };
+
+} // namespace PCC
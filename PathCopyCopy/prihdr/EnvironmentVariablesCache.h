@@ -0,0 +1,76 @@
+// EnvironmentVariablesCache.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include "PrefixMap.h"
+
+#include <mutex>
+#include <string>
+
+#include <windows.h>
+
+
+namespace PCC
+{
+    //
+    // EnvironmentVariablesCache
+    //
+    // Process-wide cache of a PrefixMap replacing the values of environment
+    // variables containing paths with references to the variables, like this:
+    //
+    // C:\Users\bob\AppData\Roaming\   =>   %APPDATA%\
+    //
+    // The table is built from the process environment block. The shell
+    // reloads its environment block when it receives WM_SETTINGCHANGE
+    // after environment variables are modified, so instead of listening
+    // for the message ourselves, we check (at most once per second) if the
+    // block changed and build the table again if it did.
+    //
+    class EnvironmentVariablesCache final
+    {
+    public:
+                        EnvironmentVariablesCache() = delete;
+                        ~EnvironmentVariablesCache() = delete;
+
+        static PrefixMap::PrefixMapSP
+                        GetReversePrefixMap();
+
+    private:
+        static const DWORD
+                        CHECK_INTERVAL;     // Minimum time between two checks of the environment block, in milliseconds.
+
+        static PrefixMap::PrefixMapSP
+                        s_spPrefixMap;      // Cached table, or nullptr if never built.
+        static std::wstring
+                        s_Environment;      // Copy of environment block used to build s_spPrefixMap.
+        static DWORD    s_CheckTime;        // Tick count when the environment block was last checked.
+        static std::mutex
+                        s_Lock;             // Lock protecting static members.
+
+        static std::wstring
+                        ReadEnvironment();
+        static std::wstring
+                        BuildTable(const std::wstring& p_Environment);
+    };
+
+} // namespace PCC
@@ -0,0 +1,86 @@
+// FQDNCache.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <windows.h>
+
+
+namespace PCC
+{
+    //
+    // FQDNCache
+    //
+    // Process-wide cache of fully-qualified domain names (FQDNs), per host name.
+    // Lookups are performed on a worker thread; callers wait for them for a
+    // limited time only, so that a slow DNS server cannot stall the caller
+    // (usually Explorer's UI thread). Results, including failed lookups,
+    // are cached for a limited time. Once a caller has given up waiting for a
+    // lookup, the host name is used as-is without waiting until it completes.
+    //
+    class FQDNCache final
+    {
+    public:
+                        FQDNCache() = delete;
+                        ~FQDNCache() = delete;
+
+        static std::wstring
+                        GetFQDN(const std::wstring& p_Hostname);
+        static void     Flush();
+
+    private:
+        // Cached result of a lookup.
+        struct Entry {
+            std::wstring    m_FQDN;         // FQDN of host, or host name itself if lookup failed.
+            bool            m_Resolved;     // Whether lookup succeeded.
+            DWORD           m_Timestamp;    // Tick count when lookup completed.
+        };
+
+        // State of a lookup in progress, shared with the worker thread.
+        struct PendingLookup {
+            std::condition_variable
+                            m_Completed;    // Signaled when lookup completes.
+            bool            m_Done;         // Whether lookup completed.
+            bool            m_TimedOut;     // Whether a caller gave up waiting for the lookup.
+        };
+        typedef std::shared_ptr<PendingLookup> PendingLookupSP;
+
+        typedef std::map<std::wstring, Entry> EntryM;
+        typedef std::map<std::wstring, PendingLookupSP> PendingLookupM;
+
+        static EntryM   s_mEntries;         // Cached lookup results, per host name.
+        static PendingLookupM
+                        s_mspPendingLookups;// Lookups in progress, per host name.
+        static std::mutex
+                        s_Lock;             // Lock protecting static members.
+
+        static void     Lookup(const std::wstring& p_Hostname,
+                               const PendingLookupSP& p_spPendingLookup);
+    };
+
+} // namespace PCC
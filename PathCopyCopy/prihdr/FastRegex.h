@@ -0,0 +1,140 @@
+// FastRegex.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+
+namespace PCC
+{
+    //
+    // FastRegex
+    //
+    // Regular expression engine supporting a subset of the ECMAScript syntax,
+    // with the same semantics as std::wregex for that subset. Patterns are
+    // compiled once to a program that is then executed by a Pike VM, which
+    // simulates all possible matches in parallel instead of backtracking.
+    // This guarantees a matching time linear in the length of the input and
+    // avoids most allocations performed by std::regex_replace.
+    //
+    // Supported syntax: literals and escapes, character classes, ".", "^", "$",
+    // "\b", "\B", capturing and non-capturing groups, alternatives and greedy
+    // or lazy quantifiers. Backreferences, lookaheads and constructs on which
+    // implementations disagree (like repeating atoms that contain capturing
+    // groups or that can match an empty string) are not supported; patterns
+    // using them cause the constructor to throw std::regex_error with
+    // the error_complexity code. Callers can then use std::wregex instead.
+    //
+    // Once constructed, FastRegex objects are immutable and thread-safe.
+    //
+    class FastRegex final
+    {
+    public:
+                        FastRegex(const std::wstring& p_Regex,
+                                  const bool p_IgnoreCase);
+                        FastRegex(const FastRegex&) = delete;
+        FastRegex&      operator=(const FastRegex&) = delete;
+
+        bool            Search(const std::wstring& p_String) const;
+        std::wstring    Replace(const std::wstring& p_String,
+                                const std::wstring& p_Format) const;
+
+        static std::wstring
+                        GetRequiredLiteral(const std::wstring& p_Regex,
+                                           const bool p_IgnoreCase);
+        static bool     MayContainLiteral(const std::wstring& p_String,
+                                          const std::wstring& p_Literal,
+                                          const bool p_IgnoreCase);
+        static bool     HasNestedQuantifiers(const std::wstring& p_Regex);
+
+    private:
+        // Operation codes of program instructions.
+        enum class OpCode {
+            Char,                   // Matches m_Char (case-folded if ignoring case).
+            Any,                    // Matches any character except line terminators.
+            Class,                  // Matches character class at index m_Arg1.
+            Split,                  // Continues at m_Arg1, then at m_Arg2 (lower priority).
+            Jump,                   // Continues at m_Arg1.
+            Save,                   // Saves current position in capture slot m_Arg1.
+            AssertBegin,            // Matches at the beginning of the input.
+            AssertEnd,              // Matches at the end of the input.
+            WordBoundary,           // Matches at a word boundary.
+            NotWordBoundary,        // Matches anywhere but at a word boundary.
+            Match,                  // Successful match.
+        };
+
+        // A single program instruction.
+        struct Instruction {
+            OpCode      m_OpCode;   // Instruction operation code.
+            wchar_t     m_Char;     // Character to match, for OpCode::Char.
+            size_t      m_Arg1;     // First argument; see OpCode.
+            size_t      m_Arg2;     // Second argument; see OpCode.
+        };
+        typedef std::vector<Instruction> InstructionV;
+
+        // Character class, like [a-z\d].
+        struct CharClass {
+            std::vector<std::pair<wchar_t, wchar_t>>
+                        m_vRanges;  // Character ranges in the class, inclusive.
+            bool        m_Digits;   // Whether class includes \d.
+            bool        m_NotDigits;// Whether class includes \D.
+            bool        m_Words;    // Whether class includes \w.
+            bool        m_NotWords; // Whether class includes \W.
+            bool        m_Spaces;   // Whether class includes \s.
+            bool        m_NotSpaces;// Whether class includes \S.
+            bool        m_Negated;  // Whether class is negated, like [^a-z].
+
+            bool        Contains(const wchar_t p_Char) const;
+        };
+        typedef std::vector<CharClass> CharClassV;
+
+        // Capture slots of a match: begin and end positions of each group.
+        typedef std::vector<size_t> CaptureV;
+
+        class Compiler;
+        class Machine;
+
+        bool            m_IgnoreCase;   // Whether to ignore case when looking for matches.
+        InstructionV    m_vProgram;     // Compiled program.
+        CharClassV      m_vClasses;     // Character classes used by the program.
+        size_t          m_NumGroups;    // Number of capturing groups, including the whole match.
+        bool            m_AnchoredAtBegin;  // Whether all matches must begin at the start of the input.
+        std::wstring    m_FirstChars;   // If not empty, all matches must start with one of these characters.
+
+        bool            Matches(const Instruction& p_Instruction,
+                                const wchar_t p_Char) const;
+        void            AppendFormatted(const std::wstring& p_String,
+                                        const CaptureV& p_vCaptures,
+                                        const size_t p_PrefixBegin,
+                                        const std::wstring& p_Format,
+                                        std::wstring& p_rResult) const;
+
+        static bool     IsWordChar(const wchar_t p_Char);
+        static bool     IsSpaceChar(const wchar_t p_Char);
+        static bool     IsLineTerminator(const wchar_t p_Char);
+        static wchar_t  FoldCase(const wchar_t p_Char);
+    };
+
+} // namespace PCC
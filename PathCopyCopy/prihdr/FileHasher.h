@@ -0,0 +1,120 @@
+// FileHasher.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include <PathCopyCopyPrivateTypes.h>
+
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <windows.h>
+
+
+namespace PCC
+{
+    //
+    // FileHasher
+    //
+    // Computes the SHA-256 hashes of the contents of files using BCrypt.
+    // Files are read sequentially with overlapped, unbuffered I/O: while one
+    // chunk of data is being hashed, the next one is already being read, so
+    // that hashing large files proceeds at the speed of the disk. When many
+    // files are hashed, they are spread between threads of our ThreadPool;
+    // the calling thread also takes part in the work so that it never waits
+    // for workers that are busy with other tasks.
+    //
+    // If the files are large, a progress dialog is shown while they are
+    // being hashed. If the user cancels it, FileHashingCancelledException
+    // is thrown.
+    //
+    // BCrypt is loaded dynamically since it is only available on Vista and
+    // up; on older systems, files cannot be hashed.
+    //
+    class FileHasher final
+    {
+    public:
+                        FileHasher() = delete;
+                        ~FileHasher() = delete;
+
+        static void     HashFiles(const WStringV& p_vFiles,
+                                  WStringV& p_rvHashes);
+
+    private:
+        // Entry points of BCrypt and handle to the SHA-256 algorithm provider.
+        struct Algorithm;
+
+        // Information about one call to HashFiles, shared with worker threads.
+        struct Job;
+        typedef std::shared_ptr<Job> JobSP;
+
+        // Function called after each chunk of data has been hashed.
+        typedef std::function<void()> ProgressCallback;
+
+        // Size of each chunk of data read from a file.
+        static const DWORD
+                        CHUNK_SIZE;
+
+        // Total size of files from which a progress dialog is shown.
+        static const ULONGLONG
+                        PROGRESS_MIN_BYTES;
+
+        // Minimum delay between two updates of the progress dialog, in milliseconds.
+        static const DWORD
+                        PROGRESS_INTERVAL;
+
+        // Maximum number of worker threads helping the calling thread.
+        static const size_t
+                        MAX_HELPERS;
+
+        static Algorithm
+                        s_Algorithm;        // BCrypt entry points, loaded on first use.
+        static std::once_flag
+                        s_AlgorithmInit;    // Flag used to load s_Algorithm only once.
+
+        static const Algorithm*
+                        GetAlgorithm();
+
+        static void     HashJobFiles(const Algorithm& p_Algorithm,
+                                     Job& p_rJob,
+                                     const ProgressCallback& p_OnProgress);
+        static std::wstring
+                        HashFile(const Algorithm& p_Algorithm,
+                                 const std::wstring& p_File,
+                                 Job& p_rJob,
+                                 const ProgressCallback& p_OnProgress);
+        static HANDLE   OpenFile(const std::wstring& p_File);
+    };
+
+    //
+    // Exception type thrown when the user cancels hashing files.
+    //
+    class FileHashingCancelledException : public std::exception
+    {
+    public:
+        virtual const char*
+                        what() const override;
+    };
+
+} // namespace PCC
@@ -0,0 +1,177 @@
+// FileMetadataCache.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include "FileSelection.h"
+#include "PathCopyCopyPrivateTypes.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+
+#include <windows.h>
+
+
+namespace PCC
+{
+    //
+    // FileMetadataCache
+    //
+    // Cache of file metadata (long name, short name, attributes, size and
+    // timestamps) used while performing a single operation on many files, like
+    // copying their paths.
+    // The path of each parent directory is converted once; afterwards, only
+    // the name of each file needs to be queried, instead of having each plugin
+    // resolve each component of each path separately.
+    //
+    // If the files of the operation are known in advance, they can be passed to
+    // Prefetch; parent directories containing many of them are then enumerated
+    // once, keeping only the metadata of those files.
+    //
+    // The cache also keeps the UNC paths resolved by UNC-based plugins, since
+    // several plugins (UNC, Internet, Samba, etc.) derive their paths from
+    // the same UNC path; it is then only resolved once per operation.
+    //
+    // A cache is created for an operation and passed to plugins through the
+    // ConversionContext (see ConversionContext::GetMetadataCache); it can be
+    // used by multiple threads at once. Paths that are not simple
+    // absolute paths (relative paths, extended-length paths, paths exceeding
+    // MAX_PATH, etc.) are not cached; callers must query them normally.
+    //
+    class FileMetadataCache final
+    {
+    public:
+        // Flags describing how UNC paths are resolved (see GetUNCPath).
+        static const DWORD  UNC_USE_HIDDEN_SHARES   = 0x1;
+        static const DWORD  UNC_USE_FQDN            = 0x2;
+        static const DWORD  UNC_RESOLVE_DFS         = 0x4;
+
+        // Metadata of a file or directory (see GetFileInfo).
+        struct FileInfo {
+            DWORD           m_Attributes;       // File attributes.
+            ULONGLONG       m_Size;             // Size of file, in bytes; 0 for directories.
+            FILETIME        m_CreationTime;     // Time file was created.
+            FILETIME        m_LastAccessTime;   // Time file was last accessed.
+            FILETIME        m_LastWriteTime;    // Time file was last modified.
+        };
+
+                        FileMetadataCache();
+                        FileMetadataCache(const FileMetadataCache&) = delete;
+        FileMetadataCache&
+                        operator=(const FileMetadataCache&) = delete;
+
+        void            Prefetch(const FilesV& p_vFiles);
+        void            Prefetch(const FileSelection& p_Files);
+
+        bool            GetLongPath(const std::wstring& p_Path,
+                                    std::wstring& p_rLongPath);
+        bool            GetShortPath(const std::wstring& p_Path,
+                                     std::wstring& p_rShortPath);
+        bool            GetAttributes(const std::wstring& p_Path,
+                                      DWORD& p_rAttributes);
+        bool            GetFileInfo(const std::wstring& p_Path,
+                                    FileInfo& p_rInfo);
+        bool            GetUNCPath(const std::wstring& p_LongPath,
+                                   const DWORD p_Flags,
+                                   std::wstring& p_rUNCPath,
+                                   bool& p_rConverted);
+        void            SetUNCPath(const std::wstring& p_LongPath,
+                                   const DWORD p_Flags,
+                                   const std::wstring& p_UNCPath,
+                                   const bool p_Converted);
+
+    private:
+        // Metadata of a single directory entry.
+        struct Entry {
+            std::wstring    m_LongName;     // Long name of entry.
+            std::wstring    m_ShortName;    // Short (8.3) name of entry; same as m_LongName if there is none.
+            FileInfo        m_Info;         // Entry attributes, size and timestamps.
+        };
+
+        // Comparator for file names; like the file system, it is case-insensitive.
+        struct NameLess {
+            bool        operator()(const std::wstring& p_Name1,
+                                   const std::wstring& p_Name2) const;
+        };
+
+        // Map of directory entries, per long and short names.
+        typedef std::map<std::wstring, Entry, NameLess> EntryM;
+
+        // Set of file names.
+        typedef std::set<std::wstring, NameLess> NameS;
+
+        // Map of converted directory paths, per original path (case-sensitive,
+        // since converted paths keep the case of the parts that are not converted).
+        typedef std::map<std::wstring, std::wstring> ConvertedPathM;
+
+        // Metadata of entries in a directory.
+        struct Directory {
+            EntryM          m_mEntries;         // Entries of the directory known so far.
+            NameS           m_sMissingNames;    // Names known not to exist in the directory.
+            ConvertedPathM  m_mLongPaths;       // Long paths of directory (empty if conversion failed).
+            ConvertedPathM  m_mShortPaths;      // Short paths of directory (empty if conversion failed).
+        };
+        typedef std::shared_ptr<Directory> DirectorySP;
+
+        // Map of directories, per path. Converted paths of a directory point to the same object.
+        typedef std::map<std::wstring, DirectorySP, NameLess> DirectorySPM;
+
+        // Map of file names, per directory path.
+        typedef std::map<std::wstring, NameS, NameLess> NameSM;
+
+        // UNC path resolved for a long path.
+        struct UNCPath {
+            std::wstring    m_Path;         // Resolved path; same as long path if it has no UNC path.
+            bool            m_Converted;    // Whether the path was converted to a UNC path.
+        };
+
+        // Map of resolved UNC paths, per resolution flags and long path.
+        typedef std::map<std::pair<DWORD, std::wstring>, UNCPath> UNCPathM;
+
+        DirectorySPM    m_mspDirectories;   // Directories known so far.
+        UNCPathM        m_mUNCPaths;        // UNC paths resolved so far.
+        std::mutex      m_Lock;             // Lock protecting the directories and UNC paths.
+
+        Directory*      FindEntry(const std::wstring& p_Path,
+                                  std::wstring& p_rDirectoryPath,
+                                  const Entry*& p_rpEntry);
+        void            PrefetchDirectories(const NameSM& p_msNamesPerDirectory);
+        bool            ConvertPath(const std::wstring& p_Path,
+                                    const bool p_Long,
+                                    std::wstring& p_rConvertedPath);
+        static void     EnumerateDirectory(const std::wstring& p_DirectoryPath,
+                                           const NameS& p_sNames,
+                                           Directory& p_rDirectory);
+        static void     AddEntry(const WIN32_FIND_DATAW& p_FindData,
+                                 Directory& p_rDirectory);
+        static void     SplitPath(const std::wstring& p_Path,
+                                  std::wstring& p_rDirectoryPath,
+                                  std::wstring& p_rName);
+        static std::wstring
+                        JoinPath(const std::wstring& p_DirectoryPath,
+                                 const std::wstring& p_Name);
+    };
+
+} // namespace PCC
@@ -0,0 +1,94 @@
+// FileSelection.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include "PathCopyCopyPrivateTypes.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+namespace PCC
+{
+    //
+    // FileSelection
+    //
+    // Compact list of files selected in the Shell. Instead of allocating a
+    // string per file, all files are stored in a single buffer, along with
+    // the offset of each file in it. Since selected files usually share the
+    // same parent directory, that parent is stored only once and the buffer
+    // only contains the rest of each path, typically the file name. If a file
+    // that does not start with the parent is added, the parent is folded back
+    // in all files and full paths are stored from then on.
+    //
+    // File paths are not stored as strings, so they are returned by value;
+    // use GetFiles to fetch files in batches to pass to plugins.
+    //
+    // Selections coming from search results or libraries can contain files
+    // from many directories. Code that performs work per parent directory can
+    // call GetDirectoryGroups once to partition the selection.
+    //
+    class FileSelection final
+    {
+    public:
+        // Files of the selection sharing the same parent directory.
+        struct DirectoryGroup {
+            std::wstring    m_Parent;       // Parent directory, with trailing backslash; empty for files without one.
+            std::vector<size_t>
+                            m_vIndexes;     // Indexes of files in the selection, in selection order.
+        };
+        typedef std::vector<DirectoryGroup> DirectoryGroupV;
+
+                        FileSelection();
+        explicit        FileSelection(const FilesV& p_vFiles);
+
+        size_t          Size() const;
+        bool            Empty() const;
+
+        void            Reserve(const size_t p_FileCount);
+        void            Add(const wchar_t* const p_pFile,
+                            const size_t p_Length);
+        void            Add(const std::wstring& p_File);
+        void            Compact();
+        void            Swap(FileSelection& p_rOther);
+
+        std::wstring    GetFile(const size_t p_Index) const;
+        void            GetFile(const size_t p_Index,
+                                std::wstring& p_rFile) const;
+        void            GetFiles(const size_t p_First,
+                                 const size_t p_Count,
+                                 FilesV& p_rvFiles) const;
+        FilesV          GetAllFiles() const;
+        DirectoryGroupV GetDirectoryGroups() const;
+
+    private:
+        std::wstring    m_Parent;       // Parent directory shared by all files, with trailing backslash; empty if none.
+        std::vector<wchar_t>
+                        m_vBuffer;      // Rest of each file path after the parent, one after the other, without terminators.
+        std::vector<size_t>
+                        m_vOffsets;     // Offset of each file in m_vBuffer.
+
+        void            FoldParent();
+    };
+
+} // namespace PCC
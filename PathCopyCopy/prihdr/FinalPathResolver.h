@@ -0,0 +1,83 @@
+// FinalPathResolver.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include "PathCopyCopyPrivateTypes.h"
+
+#include <map>
+#include <string>
+
+#include <windows.h>
+
+
+namespace PCC
+{
+    //
+    // FinalPathResolver
+    //
+    // Helper used to resolve paths containing reparse points (junctions,
+    // mount points, symbolic links) to their final path when converting
+    // many paths at once.
+    //
+    // Each path is resolved one component at a time; only components that
+    // are reparse points are opened to fetch their target. Resolved prefixes
+    // are memoized, so the parent directory shared by the files of a
+    // selection is only resolved once.
+    //
+    // This class is not thread-safe; it is meant to be used for a single batch.
+    //
+    class FinalPathResolver final
+    {
+    public:
+    explicit            FinalPathResolver(FileMetadataCache* const p_pMetadataCache);
+                        FinalPathResolver(const FinalPathResolver&) = delete;
+        FinalPathResolver&
+                        operator=(const FinalPathResolver&) = delete;
+
+        bool            Resolve(std::wstring& p_rPath);
+
+    private:
+        // Comparator for paths; like the file system, it is case-insensitive.
+        struct PathLess {
+            bool        operator()(const std::wstring& p_Path1,
+                                   const std::wstring& p_Path2) const;
+        };
+
+        // Map of resolved paths, per original path.
+        typedef std::map<std::wstring, std::wstring, PathLess> ResolvedPathM;
+
+        ResolvedPathM   m_mResolvedPaths;   // Cache of resolved paths per original path.
+        FileMetadataCache*
+                        m_pMetadataCache;   // Optional cache of file metadata of the current operation.
+
+        const std::wstring&
+                        GetResolvedPath(const std::wstring& p_Path,
+                                        const std::wstring::size_type p_RootSize);
+
+        static std::wstring::size_type
+                        GetRootSize(const std::wstring& p_Path);
+        bool            IsReparsePoint(const std::wstring& p_Path) const;
+        static bool     GetFinalPath(const std::wstring& p_Path,
+                                     std::wstring& p_rFinalPath);
+    };
+
+} // namespace PCC
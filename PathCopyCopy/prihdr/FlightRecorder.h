@@ -0,0 +1,146 @@
+// FlightRecorder.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <windows.h>
+
+
+namespace PCC
+{
+    //
+    // FlightRecorder
+    //
+    // Process-wide recorder of the phases of our slowest operations, to
+    // diagnose menus that were slow once but cannot be reproduced. While an
+    // operation is recorded (see StFlightRecording), the duration of every
+    // traced event (see Trace) is added to its phases: snapshot creation, COM
+    // plugin activation, Enabled, previews, icons, conversion, clipboard, etc.
+    // Events of all threads are included, so phases can overlap.
+    //
+    // The last MAX_RECORDINGS operations are kept in memory. Operations that
+    // take longer than SLOW_OPERATION_THRESHOLD are captured; captures are saved
+    // in the registry in the background when Save is called, so that the settings
+    // app can display and export them. Only the last MAX_CAPTURES captures are kept.
+    //
+    class FlightRecorder final
+    {
+    public:
+        // Operations that can be recorded.
+        enum class Operation {
+            Menu,       // Building the contextual menu.
+            Invoke,     // Invoking a command of the contextual menu.
+        };
+
+        static const size_t
+                        MAX_RECORDINGS;             // Maximum number of operations kept in memory.
+        static const size_t
+                        MAX_CAPTURES;               // Maximum number of slow operations kept in the registry.
+        static const std::chrono::milliseconds
+                        SLOW_OPERATION_THRESHOLD;   // Duration from which an operation is captured.
+
+                        FlightRecorder() = delete;
+                        ~FlightRecorder() = delete;
+
+                        //
+                        // Checks if an operation is being recorded.
+                        //
+                        // @return true if traced events should be recorded.
+                        //
+        static bool     Recording()
+                        {
+                            return s_ActiveCount.load(std::memory_order_relaxed) != 0;
+                        }
+
+        static void     RecordPhase(const wchar_t* const p_pName,
+                                    const std::chrono::microseconds p_Duration);
+        static void     Save();
+
+    private:
+        friend class StFlightRecording;
+
+        // Cumulative duration of one phase of an operation.
+        struct Phase {
+            const wchar_t*
+                        m_pName;        // Name of traced event; a literal string.
+            long long   m_Duration;     // Total duration of events, in microseconds.
+            DWORD       m_Count;        // Number of events.
+        };
+
+        // Recording of one operation.
+        struct Recording {
+            Operation   m_Operation;    // Operation recorded.
+            FILETIME    m_StartTime;    // Time at which operation started.
+            long long   m_Duration;     // Duration of operation, in microseconds.
+            std::vector<Phase>
+                        m_vPhases;      // Phases of the operation, in order of first appearance.
+        };
+        typedef std::shared_ptr<Recording> RecordingSP;
+
+        static std::vector<RecordingSP>
+                        s_vspActive;    // Operations being recorded.
+        static std::deque<RecordingSP>
+                        s_dqspRecent;   // Last operations recorded.
+        static std::vector<RecordingSP>
+                        s_vspCaptures;  // Slow operations not saved yet.
+        static std::atomic<long>
+                        s_ActiveCount;  // Number of operations being recorded.
+        static std::mutex
+                        s_Lock;         // Lock protecting the recordings.
+
+        static RecordingSP
+                        Begin(const Operation p_Operation);
+        static void     End(const RecordingSP& p_spRecording,
+                            const std::chrono::microseconds p_Duration);
+        static void     SaveToRegistry(const std::vector<RecordingSP>& p_vspCaptures);
+    };
+
+    //
+    // StFlightRecording
+    //
+    // Stack-based class that records an operation with FlightRecorder for
+    // the duration of a scope.
+    //
+    class StFlightRecording final
+    {
+    public:
+        explicit        StFlightRecording(const FlightRecorder::Operation p_Operation);
+                        StFlightRecording(const StFlightRecording&) = delete;
+        StFlightRecording&
+                        operator=(const StFlightRecording&) = delete;
+                        ~StFlightRecording();
+
+    private:
+        FlightRecorder::RecordingSP
+                        m_spRecording;  // Recording of our operation; null if it could not be started.
+        std::chrono::steady_clock::time_point
+                        m_Start;        // Start of operation.
+    };
+
+} // namespace PCC
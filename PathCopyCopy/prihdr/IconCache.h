@@ -0,0 +1,133 @@
+// IconCache.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include "MeasuredMutex.h"
+#include "StGdiplusStartup.h"
+#include "StImage.h"
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+#include <windows.h>
+
+
+namespace PCC
+{
+    //
+    // IconCache
+    //
+    // Process-wide cache of bitmaps used for icons in menus. Since the shell
+    // creates a new extension instance every time a contextual menu is shown,
+    // this avoids decoding the same icons again and again. Icons loaded from
+    // files are reloaded if the file is modified.
+    //
+    // Returned images are reference-counted, so they remain valid even if
+    // the cache drops them (for example, because the file changed).
+    //
+    // Icons are decoded at their native size. Since the shell does not scale
+    // menu icons itself and AlphaBlend only offers a low-quality stretch, the
+    // cache also keeps copies of icons scaled once with a high-quality filter
+    // to the size used by menus at each DPI (see GetScaledIcon).
+    //
+    // GDI+ is initialized once when the first icon is decoded and is kept
+    // initialized until Release is called.
+    //
+    // Since icons are looked up whenever a menu is built but rarely loaded,
+    // cached icons are kept in immutable maps that are read without locking.
+    // Icons are loaded with the lock held, then published by swapping in
+    // an updated copy of the map.
+    //
+    class IconCache final
+    {
+    public:
+        // Shared pointer to a Win32 image wrapper.
+        typedef std::shared_ptr<StImage> StImageSP;
+
+                        IconCache() = delete;
+                        ~IconCache() = delete;
+
+        static StImageSP
+                        GetPCCIcon();
+        static StImageSP
+                        GetIconForIconFile(const std::wstring& p_IconFile);
+        static StImageSP
+                        GetScaledIcon(const StImageSP& p_spIcon,
+                                      const int p_Width,
+                                      const int p_Height);
+        static void     Release();
+
+    private:
+        // Cached icon loaded from a file.
+        struct IconFile {
+            StImageSP   m_spImage;          // Icon image, or nullptr if it could not be loaded.
+            FILETIME    m_LastWriteTime;    // Last write time of file when icon was loaded.
+        };
+        typedef std::map<std::wstring, IconFile> IconFileM;
+        typedef std::shared_ptr<const IconFileM> IconFileMSP;
+
+        // Cached copy of an icon scaled to a given size.
+        struct ScaledIcon {
+            std::weak_ptr<StImage>
+                        m_wpSource;         // Icon that was scaled; used to detect if it was released.
+            StImageSP   m_spImage;          // Scaled icon image, or nullptr if it could not be scaled.
+        };
+        typedef std::tuple<const StImage*, int, int> ScaledIconKey;
+        typedef std::map<ScaledIconKey, ScaledIcon> ScaledIconM;
+        typedef std::shared_ptr<const ScaledIconM> ScaledIconMSP;
+
+        static StImageSP
+                        s_spPCCIcon;        // PCC icon, once loaded; only accessed atomically.
+        static std::atomic<bool>
+                        s_PCCIconLoaded;    // Whether we tried to load the PCC icon.
+        static IconFileMSP
+                        s_spIconFiles;      // Icons loaded from files, per lowercase file path; only accessed atomically.
+        static ScaledIconMSP
+                        s_spScaledIcons;    // Scaled icons, per source icon and size; only accessed atomically.
+        static std::unique_ptr<StGdiplusStartup>
+                        s_upGdiplusStartup; // GDI+ session used to decode icons, once started.
+        static MeasuredMutex
+                        s_Lock;             // Lock held while loading icons and publishing them.
+
+        static bool     FindIconFile(const IconFileMSP& p_spIconFiles,
+                                     const std::wstring& p_LowerIconFile,
+                                     const FILETIME& p_LastWriteTime,
+                                     StImageSP& p_rspImage);
+        static bool     FindScaledIcon(const ScaledIconMSP& p_spScaledIcons,
+                                       const ScaledIconKey& p_Key,
+                                       const StImageSP& p_spIcon,
+                                       StImageSP& p_rspImage);
+        static StImageSP
+                        DecodeBitmap(IStream* const p_pStream);
+        static StImageSP
+                        ScaleBitmap(HBITMAP const p_hBitmap,
+                                    const int p_Width,
+                                    const int p_Height);
+        static bool     StartGdiplus();
+    };
+
+} // namespace PCC
@@ -0,0 +1,71 @@
+// LiteralReplacer.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+
+namespace PCC
+{
+    //
+    // LiteralReplacer
+    //
+    // Object that replaces all instances of a literal string in other strings
+    // with a replacement value. Everything that can be computed in advance
+    // (like the skip table used to search for long values) is computed once
+    // by the constructor, and replacements are performed in a single pass
+    // over the string, building the output only once.
+    //
+    // Long values are searched using the Boyer-Moore-Horspool algorithm;
+    // shorter ones use a simple scan, which is faster for them.
+    //
+    class LiteralReplacer final
+    {
+    public:
+                        LiteralReplacer(const std::wstring& p_OldValue,
+                                        const std::wstring& p_NewValue,
+                                        const bool p_IgnoreCase);
+
+        void            ReplaceAll(std::wstring& p_rString) const;
+
+        static wchar_t  FoldCase(const wchar_t p_Char);
+
+    private:
+        // Size of the Boyer-Moore-Horspool skip table. Characters are
+        // mapped to entries using their lower bits.
+        static const size_t
+                        SKIP_TABLE_SIZE = 256;
+
+        std::wstring    m_OldValue;         // Value to replace; case-folded if m_IgnoreCase is true.
+        std::wstring    m_NewValue;         // Replacement value.
+        bool            m_IgnoreCase;       // Whether to ignore case when looking for m_OldValue.
+        std::vector<size_t>
+                        m_vSkips;           // Boyer-Moore-Horspool skip table; empty if not needed.
+
+        std::wstring::size_type
+                        Find(const std::wstring& p_String,
+                             const std::wstring::size_type p_From) const;
+    };
+
+} // namespace PCC
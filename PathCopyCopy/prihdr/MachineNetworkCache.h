@@ -0,0 +1,95 @@
+// MachineNetworkCache.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include "NetworkEnvironment.h"
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <atlbase.h>
+#include <windows.h>
+
+
+namespace PCC
+{
+    //
+    // MachineNetworkCache
+    //
+    // Optional cache of network info shared by all sessions of the computer,
+    // for terminal servers where each session's Explorer would otherwise
+    // enumerate the same shares.
+    //
+    // A single writer process (see Run) publishes the local computer's shares
+    // in a global shared memory section that sessions can only read. It is
+    // hosted by rundll32 (see RunMachineNetworkCacheW) and must run as an
+    // account allowed to create global objects, e.g. as a scheduled task
+    // started at boot as SYSTEM.
+    //
+    // Sessions cannot ask the writer to look anything up: since it runs with
+    // its own account, it could otherwise be made to authenticate to hosts
+    // chosen by any user and publish what it sees to all sessions. FQDNs and
+    // DFS referrals are thus always looked up by each session.
+    //
+    // Published shares are only used if the shares registry key hasn't changed
+    // since they were enumerated. Stale data left by a writer that died thus
+    // expires.
+    //
+    class MachineNetworkCache final
+    {
+    public:
+                        MachineNetworkCache() = delete;
+                        ~MachineNetworkCache() = delete;
+
+        static bool     GetShares(const FILETIME& p_SharesWriteTime,
+                                  NetworkEnvironment::ShareInfoV& p_rvShares);
+
+        static void     Run();
+        static bool     Stop();
+
+    private:
+        struct SharedHeader;
+
+        static ATL::CHandle
+                        s_hMapping;         // Handle to shared memory section, if opened.
+        static const SharedHeader*
+                        s_pHeader;          // Mapped view of shared memory section, if opened.
+        static DWORD    s_LastOpenAttempt;  // Tick count when we last tried to open the section.
+        static LONG     s_Sequence;         // Sequence number of section when we last read it.
+        static bool     s_HasShares;        // Whether s_vShares has been published.
+        static FILETIME s_SharesWriteTime;  // Last write time of shares key when shares were enumerated.
+        static NetworkEnvironment::ShareInfoV
+                        s_vShares;          // Published shares.
+        static std::mutex
+                        s_Lock;             // Lock protecting static members.
+
+        static bool     Refresh();
+        static void     Publish(SharedHeader* const p_pHeader,
+                                const bool p_HasShares,
+                                const FILETIME& p_SharesWriteTime,
+                                const NetworkEnvironment::ShareInfoV& p_vShares);
+        static bool     Parse(const std::vector<BYTE>& p_vData,
+                              NetworkEnvironment::ShareInfoV& p_rvShares);
+    };
+
+} // namespace PCC
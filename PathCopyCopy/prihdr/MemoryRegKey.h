@@ -0,0 +1,109 @@
+// MemoryRegKey.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include "RegKey.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <windows.h>
+
+
+//
+// MemoryRegKey
+//
+// Registry key that lives entirely in memory. Can be used in place of a real
+// key to benchmark code reading settings without hitting the registry.
+//
+// Subkeys are also stored in memory and can be accessed via GetSubKey;
+// since they have no handle, the m_hParent of their SubkeyInfo is NULL.
+// Likewise, the m_hKey of ValueInfos returned by GetValues is NULL.
+//
+// Only built in benchmark builds, where PCC_BENCHMARKS is defined.
+//
+class MemoryRegKey final : public RegKey
+{
+public:
+                        MemoryRegKey();
+                        MemoryRegKey(const MemoryRegKey&) = delete;
+    MemoryRegKey&       operator=(const MemoryRegKey&) = delete;
+
+    virtual bool        Valid() const override;
+
+    virtual long        QueryDWORDValue(const wchar_t* const p_pValueName,
+                                        DWORD& p_rValue) const override;
+    virtual long        QueryQWORDValue(const wchar_t* const p_pValueName,
+                                        ULONGLONG& p_rValue) const override;
+    virtual long        QueryGUIDValue(const wchar_t* const p_pValueName,
+                                       GUID& p_rValue) const override;
+    virtual long        QueryValue(const wchar_t* const p_pValueName,
+                                   DWORD* const p_pValueType,
+                                   void* const p_pValue,
+                                   DWORD* const p_pValueSize) const override;
+
+    virtual void        GetValues(ValueInfoV& p_rvValues) const override;
+    virtual void        GetSubKeys(SubkeyInfoV& p_rvSubkeys) const override;
+
+    virtual long        SetDWORDValue(const wchar_t* const p_pValueName,
+                                      const DWORD p_Value) override;
+    virtual long        SetQWORDValue(const wchar_t* const p_pValueName,
+                                      const ULONGLONG p_Value) override;
+    virtual long        SetGUIDValue(const wchar_t* const p_pValueName,
+                                     const GUID& p_Value) override;
+    virtual long        SetStringValue(const wchar_t* const p_pValueName,
+                                       const wchar_t* const p_pValue) override;
+
+    virtual long        DeleteValue(const wchar_t* const p_pValueName) override;
+
+    long                SetValue(const wchar_t* const p_pValueName,
+                                 const DWORD p_ValueType,
+                                 const void* const p_pValue,
+                                 const DWORD p_ValueSize);
+
+    MemoryRegKey&       CreateSubKey(const wchar_t* const p_pKeyName);
+    MemoryRegKey*       GetSubKey(const wchar_t* const p_pKeyName) const;
+
+private:
+    // Data of a single registry value.
+    struct ValueData {
+        DWORD           m_Type;         // Type of value (REG_DWORD, REG_SZ, etc.)
+        std::vector<BYTE>
+                        m_vData;        // Raw value data.
+    };
+
+    // Comparator for value and key names; like the registry, it is case-insensitive.
+    struct NameLess {
+        bool            operator()(const std::wstring& p_Name1,
+                                   const std::wstring& p_Name2) const;
+    };
+
+    typedef std::map<std::wstring, ValueData, NameLess> ValueDataM;
+    typedef std::map<std::wstring, std::unique_ptr<MemoryRegKey>, NameLess> SubKeyM;
+
+    ValueDataM          m_mValues;      // Values of the key, by name.
+    SubKeyM             m_mupSubKeys;   // Subkeys of the key, by name.
+
+    const ValueData*    FindValue(const wchar_t* const p_pValueName) const;
+};
@@ -0,0 +1,98 @@
+// MenuTemplateCache.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include "MeasuredMutex.h"
+#include "PathCopyCopyPrivateTypes.h"
+
+#include <chrono>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include <windows.h>
+
+
+namespace PCC
+{
+    //
+    // MenuTemplateCache
+    //
+    // Process-wide cache of the information computed while building our
+    // contextual menu: plugins' enabled states and the paths of the first
+    // selected file used as preview captions. The shell often builds the
+    // menu several times for the same selection (ribbon, menu bar, switching
+    // to the full menu in Windows 11, etc.), each time with a new extension
+    // instance; later builds can then simply insert menu items again.
+    //
+    // Entries are keyed by the selection (first file and number of files)
+    // and by the settings generation, and expire after TIME_TO_LIVE. Plugins
+    // are identified by ID since each thread has its own plugins snapshot.
+    //
+    class MenuTemplateCache final
+    {
+    public:
+        // Map of plugins' enabled states, per plugin ID.
+        typedef std::map<GUID, bool, GUIDLess> PluginEnabledM;
+
+        // Map of paths of the first selected file, per plugin ID.
+        typedef std::map<GUID, std::wstring, GUIDLess> PluginPathM;
+
+        static const size_t
+                        MAX_TEMPLATES;      // Maximum number of menu templates kept.
+        static const std::chrono::milliseconds
+                        TIME_TO_LIVE;       // Time after which a menu template expires.
+
+                        MenuTemplateCache() = delete;
+                        ~MenuTemplateCache() = delete;
+
+        static bool     Get(const std::wstring& p_FirstFile,
+                            const UINT p_FileCount,
+                            const ULONG p_Generation,
+                            PluginEnabledM& p_rmEnabled,
+                            PluginPathM& p_rmFirstFilePaths);
+        static void     Update(const std::wstring& p_FirstFile,
+                               const UINT p_FileCount,
+                               const ULONG p_Generation,
+                               const PluginEnabledM& p_mEnabled,
+                               const PluginPathM& p_mFirstFilePaths);
+
+    private:
+        // Information computed for a menu.
+        struct MenuTemplate {
+            std::wstring    m_FirstFile;        // First selected file.
+            UINT            m_FileCount;        // Number of selected files.
+            ULONG           m_Generation;       // Settings generation.
+            std::chrono::steady_clock::time_point
+                            m_Expiration;       // Time after which template cannot be used.
+            PluginEnabledM  m_mEnabled;         // Plugins' enabled states.
+            PluginPathM     m_mFirstFilePaths;  // Paths of first selected file, per plugin.
+        };
+
+        static std::deque<MenuTemplate>
+                        s_dqTemplates;      // Menu templates, most recent first.
+        static MeasuredMutex
+                        s_Lock;             // Lock protecting the templates.
+    };
+
+} // namespace PCC
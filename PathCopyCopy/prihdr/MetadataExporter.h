@@ -0,0 +1,69 @@
+// MetadataExporter.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include <PathCopyCopyPrivateTypes.h>
+
+#include <string>
+
+#include <windows.h>
+
+
+namespace PCC
+{
+    //
+    // MetadataExporter
+    //
+    // Formats paths computed by a plugin as structured records that include
+    // the size, timestamps and attributes of their files, in CSV or JSON
+    // format. Metadata is fetched through the FileMetadataCache, so parent
+    // directories containing many of the files are enumerated only once
+    // instead of querying each file.
+    //
+    // Records are meant to be joined with the separator returned by
+    // RecordsSeparator; the CSV header row or the JSON array delimiters
+    // are included in the first and last records.
+    //
+    class MetadataExporter final
+    {
+    public:
+                        MetadataExporter() = delete;
+                        ~MetadataExporter() = delete;
+
+        static WStringV FormatRecords(const ExportFormat p_Format,
+                                      const FilesV& p_vFiles,
+                                      const WStringV& p_vPaths);
+        static std::wstring
+                        RecordsSeparator(const ExportFormat p_Format);
+
+    private:
+        static void     AppendCSVField(std::wstring& p_rRecord,
+                                       const std::wstring& p_Value);
+        static void     AppendJSONString(std::wstring& p_rRecord,
+                                         const std::wstring& p_Value);
+        static std::wstring
+                        FormatTime(const FILETIME& p_Time);
+        static std::wstring
+                        FormatAttributes(const DWORD p_Attributes);
+    };
+
+} // namespace PCC
@@ -0,0 +1,152 @@
+// NetworkEnvironment.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <windows.h>
+
+
+namespace PCC
+{
+    class NetworkEnvironment;
+    typedef std::shared_ptr<NetworkEnvironment> NetworkEnvironmentSP;  // Shared pointer to a network environment.
+
+    //
+    // NetworkEnvironment
+    //
+    // Abstract interface to the network services used to convert paths to
+    // network paths: mapped drives, shares of the local computer, DNS and DFS.
+    // The current environment is the real one by default, but it can be
+    // replaced by a simulated one to measure conversions reproducibly.
+    //
+    class NetworkEnvironment
+    {
+    public:
+        // Info about a network share of the local computer.
+        struct ShareInfo {
+            std::wstring    m_Name;         // Name of share.
+            std::wstring    m_Path;         // Local path of share.
+
+                            ShareInfo();
+                            ShareInfo(const std::wstring& p_Name,
+                                      const std::wstring& p_Path);
+        };
+        typedef std::vector<ShareInfo> ShareInfoV;
+
+        // Info about a DFS referral.
+        struct DFSReferral {
+            std::wstring    m_EntryPath;    // Path of DFS root or link (ex: \\domain\Namespace\Link).
+            std::wstring    m_Target;       // Network path of the active target (ex: \\server\share).
+            DWORD           m_TimeToLive;   // Time during which referral can be cached, in seconds.
+
+                            DFSReferral();
+        };
+
+        virtual             ~NetworkEnvironment();
+
+                            //
+                            // Fetches the network path of a file on a mapped network drive,
+                            // like WNetGetUniversalName.
+                            //
+                            // @param p_FilePath Local file path.
+                            // @param p_rUniversalName Upon success, will contain the network path.
+                            // @return NO_ERROR if successful, otherwise a Win32 error code.
+                            //
+        virtual DWORD       GetUniversalName(const std::wstring& p_FilePath,
+                                             std::wstring& p_rUniversalName) = 0;
+
+                            //
+                            // Enumerates the network shares of the local computer.
+                            //
+                            // @param p_rvShares Upon success, will contain the shares.
+                            // @return true if shares could be enumerated.
+                            //
+        virtual bool        GetShares(ShareInfoV& p_rvShares) = 0;
+
+                            //
+                            // Checks whether the network shares of the local computer
+                            // have changed since GetShares was last called.
+                            //
+                            // @return true if shares have changed or if it cannot be determined.
+                            //
+        virtual bool        SharesChanged() = 0;
+
+                            //
+                            // Looks up the fully-qualified domain name (FQDN) of a host.
+                            // This can block for a long time if the DNS server is slow.
+                            //
+                            // @param p_Hostname Host name.
+                            // @param p_rFQDN Upon success, will contain the FQDN of the host.
+                            // @return true if the lookup succeeded.
+                            //
+        virtual bool        GetFQDN(const std::wstring& p_Hostname,
+                                    std::wstring& p_rFQDN) = 0;
+
+                            //
+                            // Fetches the DFS referral of a network path, like NetDfsGetClientInfo.
+                            // This requires a round trip to the DFS server if the DFS client
+                            // does not know the path yet.
+                            //
+                            // @param p_UNCPath Network path.
+                            // @param p_rReferral Upon success, will contain the referral of the
+                            //                    DFS root or link containing the path.
+                            // @return true if the path is in a DFS namespace.
+                            //
+        virtual bool        GetDFSReferral(const std::wstring& p_UNCPath,
+                                           DFSReferral& p_rReferral) = 0;
+
+                            //
+                            // Returns the name of the local computer.
+                            //
+                            // @return Name of local computer, or an empty string if unknown.
+                            //
+        virtual std::wstring
+                            GetLocalComputerName() = 0;
+
+                            //
+                            // Checks whether a drive can currently be accessed. For network
+                            // drives that are disconnected or slow, this can block until
+                            // the network times out.
+                            //
+                            // @param p_Drive Drive letter.
+                            // @return true if drive is reachable or is not a network drive.
+                            //
+        virtual bool        IsDriveReachable(const wchar_t p_Drive) = 0;
+
+        static NetworkEnvironmentSP
+                            Current();
+        static void         SetCurrent(const NetworkEnvironmentSP& p_spEnvironment);
+
+    protected:
+                            NetworkEnvironment() = default;
+                            NetworkEnvironment(const NetworkEnvironment&) = delete;
+        NetworkEnvironment& operator=(const NetworkEnvironment&) = delete;
+
+    private:
+        static NetworkEnvironmentSP
+                            s_spCurrent;    // Current network environment; only accessed atomically.
+    };
+
+} // namespace PCC
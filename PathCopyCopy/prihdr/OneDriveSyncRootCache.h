@@ -0,0 +1,74 @@
+// OneDriveSyncRootCache.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include <PrefixMap.h>
+
+#include <mutex>
+#include <string>
+
+#include <atlbase.h>
+#include <windows.h>
+
+
+namespace PCC
+{
+    //
+    // OneDriveSyncRootCache
+    //
+    // Process-wide cache of the folders synchronized by OneDrive (including
+    // SharePoint libraries), mapping each local sync root to its web URL.
+    // Sync roots are read from the SyncEngines\Providers\OneDrive registry
+    // key of the current user and stored in a PrefixMap, so that converting
+    // a path is a simple in-memory lookup.
+    //
+    // The registry key is watched for changes: sync roots are loaded again
+    // on the next call after a change is signaled. If the key does not exist
+    // (OneDrive has never been configured), we check again periodically.
+    //
+    class OneDriveSyncRootCache final
+    {
+    public:
+                        OneDriveSyncRootCache() = delete;
+                        ~OneDriveSyncRootCache() = delete;
+
+        static PrefixMap::PrefixMapSP
+                        GetSyncRoots();
+
+    private:
+        static PrefixMap::PrefixMapSP
+                        s_spSyncRoots;      // Sync roots mapped to their URLs, or nullptr if never loaded.
+        static ATL::CRegKey
+                        s_ProvidersKey;     // OneDrive providers key, opened for notification.
+        static ATL::CHandle
+                        s_hChangeEvent;     // Event signaled when the providers key changes.
+        static bool     s_Watching;         // Whether change notifications are armed on s_ProvidersKey.
+        static DWORD    s_LoadTime;         // Tick count when sync roots were last loaded.
+        static std::mutex
+                        s_Lock;             // Lock protecting static members.
+
+        static bool     NeedsReload();
+        static void     Load();
+    };
+
+} // namespace PCC
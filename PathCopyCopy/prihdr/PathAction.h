@@ -21,6 +21,11 @@
 
 #pragma once
 
+#include "PathCopyCopyPrivateTypes.h"
+
+#include <functional>
+#include <string>
+
 #include <windows.h>
 
 
@@ -36,6 +41,14 @@ namespace PCC
     class PathAction
     {
     public:
+        // Function that writes paths in a buffer. The buffer is large enough
+        // to hold the number of characters passed to ActOnWrittenPaths.
+        typedef std::function<void(wchar_t* const p_pBuffer)> PathsWriter;
+
+        // Function that computes paths and passes them to the ActOnWrittenPaths
+        // method of the given action. Used to act on paths later (see ActLater).
+        typedef std::function<void(const PathAction& p_Action, const HWND p_hWnd)> PathsProducer;
+
                         PathAction(const PathAction&) = delete;
         PathAction&     operator=(const PathAction&) = delete;
         virtual         ~PathAction();
@@ -51,6 +64,14 @@ namespace PCC
         virtual void    Act(const std::wstring& p_Paths,
                             const HWND          p_hWnd) const = 0;
 
+        virtual void    ActOnWrittenPaths(const WStringV&               p_vPaths,
+                                          const std::wstring::size_type p_PathsSize,
+                                          const PathsWriter&            p_PathsWriter,
+                                          const HWND                    p_hWnd) const;
+        virtual void    ActLater(const PathsProducer& p_PathsProducer,
+                                 const HWND           p_hWnd) const;
+        virtual bool    CanFailVisibly() const;
+
     protected:
                         PathAction() = default;
     };
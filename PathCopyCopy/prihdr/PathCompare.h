@@ -0,0 +1,61 @@
+// PathCompare.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include <string>
+
+
+namespace PCC
+{
+    //
+    // PathCompare
+    //
+    // Static class containing helper methods to compare paths the way the
+    // file system does: ordinally, ignoring case (like CompareStringOrdinal
+    // with bIgnoreCase set to TRUE). Used for prefix-based path rewrites.
+    //
+    // Since most paths contain only ASCII characters, comparisons process
+    // blocks of ASCII characters using SSE2 when available, falling back
+    // to folding characters one by one when non-ASCII characters are found.
+    //
+    class PathCompare final
+    {
+    public:
+        // Comparator ordering paths ordinally, ignoring case.
+        struct Less {
+            bool        operator()(const std::wstring& p_Path1,
+                                   const std::wstring& p_Path2) const;
+        };
+
+                        PathCompare() = delete;
+                        ~PathCompare() = delete;
+
+        static bool     StartsWith(const std::wstring& p_Path,
+                                   const std::wstring& p_Prefix);
+        static bool     Equal(const wchar_t* const p_pPath1,
+                              const wchar_t* const p_pPath2,
+                              const std::wstring::size_type p_Length);
+
+        static wchar_t  FoldCase(const wchar_t p_Char);
+    };
+
+} // namespace PCC
@@ -0,0 +1,120 @@
+// PathCopyCopyBenchmarks.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include <windows.h>
+
+
+//
+// Functions used by PathCopyCopyBenchmarks to measure the DLL. They are only
+// built and exported in benchmark builds, made by building PathCopyCopy.vcxproj
+// with /p:PCCBenchmarks=true, which defines PCC_BENCHMARKS.
+//
+extern "C"
+{
+    //
+    // Callback invoked by RunBenchmarksW for each benchmark result.
+    //
+    // @param p_pBenchmarkName Name of benchmark that was run.
+    // @param p_CorpusSize Number of paths in the corpus used.
+    // @param p_Microseconds Time taken to process the entire corpus, in microseconds.
+    // @param p_Allocations Number of heap allocations performed while processing
+    //                      the corpus, or -1 if allocations are not counted in this build.
+    // @param p_AllocatedBytes Number of bytes allocated while processing the corpus,
+    //                         or -1 if allocations are not counted in this build.
+    // @param p_pContext Context passed to RunBenchmarksW.
+    //
+    typedef void (CALLBACK* PCCBENCHMARKRESULTPROC)(LPCWSTR p_pBenchmarkName,
+                                                    ULONG p_CorpusSize,
+                                                    double p_Microseconds,
+                                                    LONGLONG p_Allocations,
+                                                    LONGLONG p_AllocatedBytes,
+                                                    LPVOID p_pContext);
+
+    //
+    // Callback invoked by GenerateCorpusW for each generated path.
+    //
+    // @param p_pPath Generated path.
+    // @param p_pContext Context passed to GenerateCorpusW.
+    //
+    typedef void (CALLBACK* PCCCORPUSPATHPROC)(LPCWSTR p_pPath,
+                                               LPVOID p_pContext);
+
+    //
+    // Callback invoked by GetAllocationPhasesW for each phase of our operations.
+    //
+    // @param p_pPhaseName Name of phase, as traced by the PCC DLL.
+    // @param p_Calls Number of times the phase was performed.
+    // @param p_Allocations Number of heap allocations performed during all calls.
+    // @param p_AllocatedBytes Number of bytes allocated during all calls.
+    // @param p_pContext Context passed to GetAllocationPhasesW.
+    //
+    typedef void (CALLBACK* PCCALLOCATIONPHASEPROC)(LPCWSTR p_pPhaseName,
+                                                    ULONGLONG p_Calls,
+                                                    ULONGLONG p_Allocations,
+                                                    ULONGLONG p_AllocatedBytes,
+                                                    LPVOID p_pContext);
+
+    //
+    // Callback invoked by GetLockStatisticsW for each lock shared by our objects.
+    //
+    // @param p_pLockName Name of lock, as registered by the PCC DLL.
+    // @param p_Acquisitions Number of times the lock was acquired.
+    // @param p_Contentions Number of acquisitions that had to wait for another thread.
+    // @param p_WaitMicroseconds Total time spent waiting for the lock, in microseconds.
+    // @param p_MaxWaitMicroseconds Longest wait for the lock, in microseconds.
+    // @param p_pContext Context passed to GetLockStatisticsW.
+    //
+    typedef void (CALLBACK* PCCLOCKSTATISTICSPROC)(LPCWSTR p_pLockName,
+                                                   ULONGLONG p_Acquisitions,
+                                                   ULONGLONG p_Contentions,
+                                                   ULONGLONG p_WaitMicroseconds,
+                                                   ULONGLONG p_MaxWaitMicroseconds,
+                                                   LPVOID p_pContext);
+
+    HRESULT WINAPI RunBenchmarksW(LPCWSTR p_pFilter,
+                                  const ULONG* p_pCorpusSizes,
+                                  ULONG p_NumCorpusSizes,
+                                  PCCBENCHMARKRESULTPROC p_pResultProc,
+                                  LPVOID p_pContext);
+
+    HRESULT WINAPI RunCorpusBenchmarksW(LPCWSTR p_pCorpusName,
+                                        LPCWSTR p_pFilter,
+                                        const ULONG* p_pCorpusSizes,
+                                        ULONG p_NumCorpusSizes,
+                                        PCCBENCHMARKRESULTPROC p_pResultProc,
+                                        LPVOID p_pContext);
+
+    HRESULT WINAPI GenerateCorpusW(LPCWSTR p_pCorpusName,
+                                   ULONG p_Size,
+                                   PCCCORPUSPATHPROC p_pPathProc,
+                                   LPVOID p_pContext);
+
+    HRESULT WINAPI GetAllocationPhasesW(PCCALLOCATIONPHASEPROC p_pPhaseProc,
+                                        LPVOID p_pContext,
+                                        BOOL p_Reset);
+
+    HRESULT WINAPI GetLockStatisticsW(PCCLOCKSTATISTICSPROC p_pStatisticsProc,
+                                      LPVOID p_pContext,
+                                      BOOL p_Reset);
+};
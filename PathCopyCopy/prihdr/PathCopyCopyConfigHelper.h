@@ -22,6 +22,7 @@
 #pragma once
 
 #include <PathCopyCopy_i.h>
+#include "ConversionContext.h"
 #include "PathCopyCopyPrivateTypes.h"
 #include "Plugin.h"
 #include "resource.h"
@@ -75,6 +76,8 @@ private:
     PCC::PluginSPS      m_sspAllPlugins;            // Set containing all plugins.
     PCC::PluginProviderSP
                         m_spPluginProvider;         // Object to access other plugins.
+    PCC::ConversionContext
+                        m_Context;                  // Context referencing settings and plugin provider.
     PCC::PluginSPV      m_vspPlugins;               // Plugins accessible through this helper.
 
     void                Initialize();
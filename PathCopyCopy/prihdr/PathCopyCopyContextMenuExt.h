@@ -22,6 +22,8 @@
 #pragma once
 
 #include <PathCopyCopy_i.h>
+#include "FileSelection.h"
+#include "MeasuredMutex.h"
 #include "PathCopyCopyPrivateTypes.h"
 #include "Plugin.h"
 #include "resource.h"
@@ -29,11 +31,16 @@
 
 #include <cl/optional.h>
 
+#include <bitset>
+#include <chrono>
+#include <cwchar>
+#include <functional>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <string>
-#include <utility>
+#include <unordered_set>
+#include <vector>
 
 #include <atlbase.h>
 #include <atlcom.h>
@@ -55,13 +62,14 @@ class ATL_NO_VTABLE CPathCopyCopyContextMenuExt :
     public IPathCopyCopyContextMenuExt,
 #endif // PCC_NO_CONTEXT_MENU_EXT2
     public IShellExtInit,
-    public IContextMenu
+    public IContextMenu3
 {
 public:
     CPathCopyCopyContextMenuExt();
     ~CPathCopyCopyContextMenuExt();
 
-    DECLARE_REGISTRY_RESOURCEID(IDR_PATHCOPYCOPYCONTEXTMENUEXT)
+    // Registered by PathCopyCopyLoader, which creates us when a menu is built.
+    DECLARE_NO_REGISTRY()
 
     DECLARE_NOT_AGGREGATABLE(CPathCopyCopyContextMenuExt)
 
@@ -72,6 +80,8 @@ public:
 #endif // PCC_NO_CONTEXT_MENU_EXT2
         COM_INTERFACE_ENTRY(IShellExtInit)
         COM_INTERFACE_ENTRY(IContextMenu)
+        COM_INTERFACE_ENTRY(IContextMenu2)
+        COM_INTERFACE_ENTRY(IContextMenu3)
     END_COM_MAP()
 
     DECLARE_PROTECT_FINAL_CONSTRUCT()
@@ -106,22 +116,52 @@ public:
     STDMETHOD(GetCommandString)(UINT_PTR p_CmdId, UINT p_Flags, UINT* p_pReserved,
                                 LPSTR p_pBuffer, UINT p_BufferSize);
 
+    // IContextMenu2 methods
+    STDMETHOD(HandleMenuMsg)(UINT p_Msg, WPARAM p_wParam, LPARAM p_lParam);
+
+    // IContextMenu3 methods
+    STDMETHOD(HandleMenuMsg2)(UINT p_Msg, WPARAM p_wParam, LPARAM p_lParam, LRESULT* p_pResult);
+
+    // Methods used by CPathCopyCopyExplorerCommand
+    HRESULT             InitializeWithFiles(const PCC::FilesV& p_vFiles);
+    HRESULT             ActOnFilesWithPlugin(const GUID& p_PluginId,
+                                             HWND p_hWnd);
+
 private:
-    typedef std::map<UINT_PTR, PCC::PluginSP>               CmdIdPluginM;   // Map of plugins by command ID.
+    typedef std::map<PCC::PluginSP, bool>                   PluginEnabledM; // Map of plugins' enabled states.
+    typedef std::map<PCC::PluginSP, std::wstring>           PluginPathM;    // Map of paths computed by plugins.
 
-    typedef std::pair<CPathCopyCopyContextMenuExt*, HMENU>  ExtToMenuPair;  // Pairing an extension instance to an HMENU.
-    typedef std::vector<ExtToMenuPair>                      ExtToMenuPairV; // Vector mapping extension instances to HMENUs.
+    typedef std::function<void(const PCC::WStringV& p_vPaths,
+                               const PCC::PathAction& p_Action,
+                               const HWND p_hWnd)>          PathsActor;     // Function passing computed paths to an action.
+
+    typedef std::unordered_set<HMENU>                       HMenuS;         // Set of menu handles.
+    typedef std::bitset<WCHAR_MAX + 1>                      ShortcutBitset; // Set of menu shortcuts, one bit per (lowercase) character.
 
     typedef std::shared_ptr<StImage>                        StImageSP;      // Shared pointer to a Win32 image wrapper.
     typedef std::map<std::wstring, StImageSP>               IconFilesM;     // Map of shared points to Win32 image wrappers, per icon file.
+    typedef std::map<UINT, std::wstring>                    ItemIconFileM;  // Map of icon files, per menu item ID.
+
+    // Nested submenu whose items are only added when it is opened.
+    struct NestedSubMenu {
+        PCC::PluginSPV      m_vspPlugins;   // Plugins to add to the submenu.
+        std::vector<UINT>   m_vCmdIds;      // Command IDs reserved for those plugins, in the same order.
+    };
+    typedef std::map<HMENU, NestedSubMenu>                  NestedSubMenuM; // Map of nested submenus not populated yet, per menu handle.
+
+    struct MenuPrefetch;
+    typedef std::shared_ptr<MenuPrefetch>                   MenuPrefetchSP;             // Shared pointer to a menu prefetch.
+    struct SpeculativeConversion;
+    typedef std::shared_ptr<SpeculativeConversion>          SpeculativeConversionSP;    // Shared pointer to a speculative conversion.
 
     PCC::SettingsSP     m_spSettings;               // Object to access program settings.
-    PCC::PluginSPV      m_vspPluginsInDefaultOrder; // Vector of all plugins in default order.
-    PCC::PluginSPS      m_sspAllPlugins;            // Set containing all plugins.
-    PCC::PluginProviderSP
-                        m_spPluginProvider;         // Plugin provider object.
+    PCC::PluginsSnapshotSP
+                        m_spPluginsSnapshot;        // Snapshot of all plugins, shared between instances.
 
-    PCC::FilesV         m_vFiles;                   // Files selected in Shell.
+    PCC::FileSelection  m_Files;                    // Files selected in Shell; only the first one until GetSelectedFiles is called.
+    UINT                m_FileCount;                // Number of files selected in Shell.
+    ATL::CComPtr<IDataObject>
+                        m_spDataObject;             // Data object containing the selected files, kept to extract them later.
     std::wstring        m_ParentPath;               // Path of the parent directory of all files selected.
 
     cl::optional<UINT_PTR>
@@ -130,14 +170,38 @@ private:
                         m_SubMenuCmdId;             // ID of the menu item that opens our submenu.
     cl::optional<UINT_PTR>
                         m_SettingsCmdId;            // ID of the menu item that triggers the options.
-    CmdIdPluginM        m_mPluginsByCmdId;          // Map storing plugins by their command IDs.
+    cl::optional<std::chrono::steady_clock::time_point>
+                        m_MenuDeadline;             // Time after which building the menu exceeds its time budget, if any.
+    bool                m_MenuBudgetExceeded;       // Whether building the menu exceeded its time budget.
+    HMENU               m_hPreviewSubMenu;          // Submenu whose items' previews have not been computed yet.
+    std::vector<UINT_PTR>
+                        m_vPreviewCmdIds;           // IDs of submenu items whose previews have not been computed yet.
+    NestedSubMenuM      m_mNestedSubMenus;          // Nested submenus of our submenu that have not been populated yet.
+    PCC::PluginSPV      m_vspPluginsByCmdOffset;    // Plugins indexed by command ID offset from m_FirstCmdId (nullptr if not a plugin).
+    PluginEnabledM      m_mPluginsEnabled;          // Map storing whether plugins are enabled in the menu.
+    PluginPathM         m_mFirstFilePaths;          // Map storing path of first file computed by each plugin.
+    ShortcutBitset      m_UsedShortcuts;            // Shortcuts already used in the main menu.
 
+    ItemIconFileM       m_mIconFilesByItemId;       // Icon files of menu items that have an icon (empty for the PCC icon).
     StImageSP           m_spPCCIcon;                // Holds the PCC icon that can be used in menus.
     IconFilesM          m_mspIcons;                 // Map of icons per icon file.
+    IconFilesM          m_mspScaledIcons;           // Icons scaled to the size used by the menu, per icon file (empty for the PCC icon).
+    HMENU               m_hModifiedMenu;            // Menu modified by this instance, if any.
+    MenuPrefetchSP      m_spMenuPrefetch;           // Prefetch of information needed by the menu, started when initialized.
+    SpeculativeConversionSP
+                        m_spSpeculativeConversion;  // Conversion of selected files started once the menu is built, if any.
+    PCC::FileMetadataCache*
+                        m_pMenuMetadataCache;       // Cache of file metadata used while the menu is built, if any.
 
-    static ExtToMenuPairV
-                        s_vExtToMenus;              // Static map keeping track of which extensions modified which menu.
-    static std::mutex   s_ExtToMenusLock;           // Lock to protect the static map.
+    static HMenuS       s_sModifiedMenus;           // Static set keeping track of menus modified by any instance.
+    static PCC::MeasuredMutex
+                        s_ModifiedMenusLock;        // Lock to protect the static set.
+    static GUID         s_LastUsedPluginId;         // ID of plugin last used by any instance; GUID_NULL if none.
+    static PCC::MeasuredMutex
+                        s_LastUsedPluginLock;       // Lock to protect the last used plugin ID.
+    static __time64_t   s_NextUpdateCheck;          // Time at which next update check is due; 0 if not loaded yet.
+    static bool         s_UpdateCheckPending;       // Whether an update check task is pending in the thread pool.
+    static std::mutex   s_UpdateCheckLock;          // Lock to protect the update check time and pending flag.
 
     PCC::Settings&      GetSettings();
 
@@ -157,18 +221,53 @@ private:
                                         const bool p_ComputeShortcut,
                                         UINT& p_rCmdId,
                                         UINT& p_rPosition);
-    std::wstring        GetMenuCaptionWithShortcut(HMENU const p_hMenu,
-                                                   const std::wstring& p_Caption) const;
+    HRESULT             GetHelpText(const UINT_PTR p_CmdOffset,
+                                    std::wstring& p_rHelpText) const;
+    PCC::PluginSP       GetPluginByCmdOffset(const UINT_PTR p_CmdOffset) const;
+    bool                MenuBudgetExceeded();
+    void                EvaluatePluginsEnabled(const PCC::PluginSPV& p_vspPlugins);
+    std::wstring        GetPreviewCaption(const PCC::PluginSP& p_spPlugin);
+    void                UpdatePreviewCaptions();
+    void                PopulateNestedSubMenu(HMENU const p_hSubMenu);
+    void                ScanMenuShortcuts(HMENU const p_hMenu);
+    void                MarkMenuShortcutUsed(const std::wstring& p_Caption);
+    std::wstring        GetMenuCaptionWithShortcut(const std::wstring& p_Caption) const;
 
-    HBITMAP             GetPCCIcon();
-    HBITMAP             GetIconForIconFile(const std::wstring& p_IconFile);
+    StImageSP           GetPCCIcon();
+    StImageSP           GetIconForIconFile(const std::wstring& p_IconFile);
+    HBITMAP             GetMenuIcon(const std::wstring& p_IconFile,
+                                    const SIZE& p_IconSize);
+    static SIZE         GetMenuIconSize(HDC const p_hDC);
+    static void         DrawMenuIcon(HDC const p_hDC,
+                                     const RECT& p_Rect,
+                                     const SIZE& p_IconSize,
+                                     HBITMAP const p_hIconBitmap);
 
+    const std::wstring& GetFirstFilePath(const PCC::PluginSP& p_spPlugin);
+    const PCC::FileSelection&
+                        GetSelectedFiles();
+    PCC::ConversionContext
+                        GetConversionContext() const;
     HRESULT             ActOnFiles(const PCC::PluginSP& p_spPlugin,
                                    HWND p_hWnd);
-    void                AddQuotes(std::wstring& p_rName,
-                                  const bool p_Optional) const;
+    void                ActOnFilesInBackground(const PCC::PluginSP& p_spPlugin,
+                                               const PCC::PathActionSP& p_spAction,
+                                               const PathsActor& p_ActOnPaths,
+                                               HWND p_hWnd);
+    bool                ActOnFilesWithCtrlKeyPlugin();
+    void                StartMenuPrefetch();
+    void                ConsumePrefetchedEnabledStates();
+    void                CancelMenuPrefetch();
+    void                LoadMenuTemplate();
+    void                StoreMenuTemplate() const;
+    void                StartSpeculativeConversion();
+    bool                ConsumeSpeculativeConversion(const PCC::PluginSP& p_spPlugin,
+                                                     PCC::WStringV& p_rvPaths);
+    void                CancelSpeculativeConversion();
+    static bool         NeedQuotes(const std::wstring& p_Name,
+                                   const bool p_Optional);
 
-    void                RemoveFromExtToMenu();
+    void                RemoveFromModifiedMenus();
     void                CheckForUpdates();
 };
 
@@ -22,8 +22,11 @@
 #pragma once
 
 #include "PathCopyCopy_i.h"
+#include "PathCopyCopyPrivateTypes.h"
 #include "resource.h"
 
+#include <cl/optional.h>
+
 #include <string>
 
 #include <atlbase.h>
@@ -36,6 +39,9 @@
 //
 // Shell data handler that will provide a textual representation of any file/folder
 // being dragged and dropped containing the path of that file/folder.
+// The shell creates one instance per file through IPersistFile and offers no way
+// to initialize a data handler for a whole selection, so paths cannot be computed
+// for all files at once; each instance caches the path of its own file instead.
 // Currently in a "proof-of-concept" stage; it doesn't prove anything yet :)
 //
 class ATL_NO_VTABLE CPathCopyCopyDataHandler :
@@ -48,7 +54,8 @@ class ATL_NO_VTABLE CPathCopyCopyDataHandler :
 public:
 	CPathCopyCopyDataHandler();
 
-    DECLARE_REGISTRY_RESOURCEID(IDR_PATHCOPYCOPYDATAHANDLER)
+    // Registered by PathCopyCopyLoader, which creates us when data is requested.
+    DECLARE_NO_REGISTRY()
 
     DECLARE_NOT_AGGREGATABLE(CPathCopyCopyDataHandler)
 
@@ -93,7 +100,14 @@ public:
     STDMETHOD(EnumDAdvise)(IEnumSTATDATA **ppenumAdvise);
 
 private:
-    std::wstring        m_FileName;     // Name of file to act upon (only one).
+    std::wstring        m_FileName;             // Name of file to act upon (only one).
+    PCC::PluginsSnapshotSP
+                        m_spPluginsSnapshot;    // Snapshot of all plugins, owning the settings used by our plugin.
+    PCC::PluginSP       m_spDefaultPlugin;      // Default plugin used to compute path, created when first needed.
+    cl::optional<std::wstring>
+                        m_Path;                 // Path of file computed by the default plugin, once computed.
+
+    const std::wstring& GetPath();
 };
 
 OBJECT_ENTRY_AUTO(__uuidof(PathCopyCopyDataHandler), CPathCopyCopyDataHandler)
@@ -0,0 +1,124 @@
+// PathCopyCopyExplorerCommand.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include <PathCopyCopy_i.h>
+#include "PathCopyCopyPrivateTypes.h"
+#include "resource.h"
+
+#include <string>
+
+#include <atlbase.h>
+#include <atlcom.h>
+#include <shobjidl.h>
+#include <windows.h>
+
+
+//
+// CPathCopyCopyExplorerCommand
+//
+// Explorer command that can be used to add Path Copy Copy to the modern
+// contextual menu of Windows 11. It has one sub-command per plugin that is
+// displayed in our submenu; these are enumerated only when the shell needs
+// them. Actions are delegated to CPathCopyCopyContextMenuExt.
+//
+// Note: interfaces used here require Windows 7 headers; see the .cpp file.
+//
+class ATL_NO_VTABLE CPathCopyCopyExplorerCommand :
+    public ATL::CComObjectRootEx<ATL::CComSingleThreadModel>,
+    public ATL::CComCoClass<CPathCopyCopyExplorerCommand, &CLSID_PathCopyCopyExplorerCommand>,
+    public IPathCopyCopyExplorerCommand,
+    public IExplorerCommand
+{
+public:
+    CPathCopyCopyExplorerCommand();
+
+    DECLARE_REGISTRY_RESOURCEID(IDR_PATHCOPYCOPYEXPLORERCOMMAND)
+
+    DECLARE_NOT_AGGREGATABLE(CPathCopyCopyExplorerCommand)
+
+    BEGIN_COM_MAP(CPathCopyCopyExplorerCommand)
+        COM_INTERFACE_ENTRY(IPathCopyCopyExplorerCommand)
+        COM_INTERFACE_ENTRY(IExplorerCommand)
+    END_COM_MAP()
+
+    DECLARE_PROTECT_FINAL_CONSTRUCT()
+
+    HRESULT FinalConstruct()
+    {
+        return S_OK;
+    }
+
+    void FinalRelease()
+    {
+    }
+
+public:
+    // IExplorerCommand methods
+    STDMETHOD(GetTitle)(IShellItemArray* p_pItems, LPWSTR* p_ppName);
+    STDMETHOD(GetIcon)(IShellItemArray* p_pItems, LPWSTR* p_ppIcon);
+    STDMETHOD(GetToolTip)(IShellItemArray* p_pItems, LPWSTR* p_ppInfoTip);
+    STDMETHOD(GetCanonicalName)(GUID* p_pCommandName);
+    STDMETHOD(GetState)(IShellItemArray* p_pItems, BOOL p_OkToBeSlow, EXPCMDSTATE* p_pCmdState);
+    STDMETHOD(Invoke)(IShellItemArray* p_pItems, IBindCtx* p_pBindCtx);
+    STDMETHOD(GetFlags)(EXPCMDFLAGS* p_pFlags);
+    STDMETHOD(EnumSubCommands)(IEnumExplorerCommand** p_ppEnum);
+};
+
+//
+// CPathCopyCopyExplorerSubCommand
+//
+// Explorer sub-command for a single plugin (or a separator). Created by
+// CPathCopyCopyExplorerCommand when the shell enumerates its sub-commands.
+//
+class ATL_NO_VTABLE CPathCopyCopyExplorerSubCommand :
+    public ATL::CComObjectRootEx<ATL::CComSingleThreadModel>,
+    public IExplorerCommand
+{
+public:
+    CPathCopyCopyExplorerSubCommand();
+
+    BEGIN_COM_MAP(CPathCopyCopyExplorerSubCommand)
+        COM_INTERFACE_ENTRY(IExplorerCommand)
+    END_COM_MAP()
+
+    void                SetPlugin(const PCC::PluginsSnapshotSP& p_spPluginsSnapshot,
+                                  const PCC::PluginSP& p_spPlugin);
+
+    // IExplorerCommand methods
+    STDMETHOD(GetTitle)(IShellItemArray* p_pItems, LPWSTR* p_ppName);
+    STDMETHOD(GetIcon)(IShellItemArray* p_pItems, LPWSTR* p_ppIcon);
+    STDMETHOD(GetToolTip)(IShellItemArray* p_pItems, LPWSTR* p_ppInfoTip);
+    STDMETHOD(GetCanonicalName)(GUID* p_pCommandName);
+    STDMETHOD(GetState)(IShellItemArray* p_pItems, BOOL p_OkToBeSlow, EXPCMDSTATE* p_pCmdState);
+    STDMETHOD(Invoke)(IShellItemArray* p_pItems, IBindCtx* p_pBindCtx);
+    STDMETHOD(GetFlags)(EXPCMDFLAGS* p_pFlags);
+    STDMETHOD(EnumSubCommands)(IEnumExplorerCommand** p_ppEnum);
+
+private:
+    PCC::PluginsSnapshotSP
+                        m_spPluginsSnapshot;        // Snapshot owning our plugin and its settings.
+    PCC::PluginSP       m_spPlugin;                 // Plugin invoked by this sub-command.
+};
+
+OBJECT_ENTRY_AUTO(__uuidof(PathCopyCopyExplorerCommand), CPathCopyCopyExplorerCommand)
@@ -47,11 +47,21 @@ namespace PCC
         static PluginSPV GetPluginsInDefaultOrder(const COMPluginProvider* const p_pCOMPluginProvider,
                                                   const PipelinePluginProvider* const p_pPipelinePluginProvider,
                                                   const bool p_IncludeTempPipelinePlugins);
+        static PluginSPS GetPluginWithReferencedPlugins(const GUID& p_PluginId,
+                                                        const COMPluginProvider* const p_pCOMPluginProvider,
+                                                        const PipelinePluginProvider* const p_pPipelinePluginProvider,
+                                                        const bool p_IncludeTempPipelinePlugins);
 
         static PluginSPV OrderPluginsToDisplay(const PluginSPS& p_sspAllPlugins,
                                                const GUIDV& p_vPluginDisplayOrder,
                                                const GUIDV* const p_pvKnownPlugins,
                                                const PluginSPV* const p_pvspPluginsInDefaultOrder);
+        static PluginSPV OrderPluginsToDisplayWithUnknownPlugins(const PluginSPS& p_sspAllPlugins,
+                                                                 const GUIDV& p_vPluginDisplayOrder,
+                                                                 const GUIDV* const p_pvUnknownPlugins,
+                                                                 const PluginSPV* const p_pvspPluginsInDefaultOrder);
+        static GUIDV    GetUnknownPlugins(const PluginSPS& p_sspAllPlugins,
+                                          const GUIDV& p_vKnownPlugins);
 
     private:
         // Reference to a COM plugin.
@@ -74,6 +84,8 @@ namespace PCC
 
         static void     GetCOMPlugins(const COMPluginProvider& p_COMPluginProvider,
                                       PluginSPV& p_rvspPlugins);
+        static void     PrefetchCOMPluginMetadata(const COMPluginProvider& p_COMPluginProvider,
+                                                  const CLSIDV& p_vPluginCLSIDs);
         static void     GetPipelinePlugins(const PipelinePluginProvider& p_PipelinePluginProvider,
                                            const bool p_IncludeTempPipelinePlugins,
                                            PluginSPV& p_rvspPlugins);
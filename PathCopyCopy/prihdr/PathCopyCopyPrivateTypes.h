@@ -28,6 +28,8 @@
 #include <memory>
 #include <set>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <string.h>
@@ -43,6 +45,10 @@ namespace PCC
     class PipelineElement;
     class Pipeline;
     class Settings;
+    class SettingsSnapshot;
+    class PluginsSnapshot;
+    class ConversionContext;
+    class FileMetadataCache;
 
     // Interface forward declarations.
     class PluginProvider;
@@ -82,10 +88,47 @@ namespace PCC
     typedef GUIDV                               CLSIDV;                 // Vector of class IDs (e.g. GUIDs).
     typedef GUIDS                               CLSIDS;                 // Set of class IDs (e.g. GUIDs).
     typedef std::vector<uint32_t>               UInt32V;                // Vector of 32-bit unsigned integers.
+    typedef std::unordered_map<std::wstring, std::wstring>
+                                                WStringWStringUM;       // Hash map of strings, per string.
+    typedef std::vector<std::pair<GUID, std::wstring>>
+                                                GUIDWStringPairV;       // Vector of strings paired with GUIDs.
 
     typedef WStringV                            FilesV;                 // Vector of file paths.
 
+    //
+    // Classes of cost of the work performed by plugins to compute paths,
+    // from the cheapest to the most expensive. Used to decide how to
+    // schedule plugins and whether their results are worth caching.
+    //
+    enum class PluginCost {
+        Pure,               // Only manipulates strings.
+        FileSystem,         // Queries the local file system.
+        Network,            // Queries the network.
+        External,           // Calls code we don't control (e.g. COM plugins); cost is unknown.
+    };
+
+    //
+    // Formats in which paths can be exported along with the metadata
+    // of their files, instead of being output as-is (see MetadataExporter).
+    //
+    enum class ExportFormat {
+        None        = 0,    // Paths are output as-is.
+        CSV         = 1,    // One comma-separated record per file, after a header row.
+        JSON        = 2,    // Array of objects, one per file.
+    };
+
+    //
+    // Unicode normalization forms that can be applied to paths (see
+    // UnicodeNormalizer). Values match those of the Win32 NORM_FORM enum.
+    //
+    enum class NormalizationForm {
+        NFC         = 1,    // Canonical composition (used by most Linux tools).
+        NFD         = 2,    // Canonical decomposition (used by macOS file systems).
+    };
+
     typedef std::shared_ptr<PluginProvider>     PluginProviderSP;       // Shared pointer to an object to access plugins.
+    typedef std::shared_ptr<const PluginsSnapshot>
+                                                PluginsSnapshotSP;      // Shared pointer to an immutable snapshot of all plugins.
 
 } // namespace PCC
 
@@ -34,6 +34,14 @@ extern "C"
                                         HINSTANCE p_hDllInstance,
                                         LPWSTR p_pCmdLine,
                                         int p_ShowCmd);
+    void CALLBACK GetPathsWithPluginW(HWND p_hWnd,
+                                      HINSTANCE p_hDllInstance,
+                                      LPWSTR p_pCmdLine,
+                                      int p_ShowCmd);
+    void CALLBACK RegGetPathsWithPluginW(HWND p_hWnd,
+                                         HINSTANCE p_hDllInstance,
+                                         LPWSTR p_pCmdLine,
+                                         int p_ShowCmd);
     void CALLBACK ApplyGlobalRevisionsW(HWND p_hWnd,
                                         HINSTANCE p_hDllInstance,
                                         LPWSTR p_pCmdLine,
@@ -42,4 +50,23 @@ extern "C"
                                       HINSTANCE p_hDllInstance,
                                       LPWSTR p_pCmdLine,
                                       int p_ShowCmd);
+    void CALLBACK RunResidentServiceW(HWND p_hWnd,
+                                      HINSTANCE p_hDllInstance,
+                                      LPWSTR p_pCmdLine,
+                                      int p_ShowCmd);
+    void CALLBACK RunMachineNetworkCacheW(HWND p_hWnd,
+                                          HINSTANCE p_hDllInstance,
+                                          LPWSTR p_pCmdLine,
+                                          int p_ShowCmd);
+    HRESULT WINAPI GetPathsWithPipelineW(LPCWSTR p_pEncodedElements,
+                                         LPCWSTR p_pPaths,
+                                         BSTR* p_pResults);
+    HRESULT WINAPI ProfilePipelineW(LPCWSTR p_pEncodedElements,
+                                    LPCWSTR p_pPaths,
+                                    UINT p_Iterations,
+                                    BSTR* p_pResults);
+    HRESULT WINAPI ConvertPathStreamW(LPCWSTR p_pPlugin,
+                                      HANDLE p_hInput,
+                                      HANDLE p_hOutput,
+                                      LPCWSTR p_pSeparator);
 };
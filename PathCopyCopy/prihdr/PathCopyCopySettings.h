@@ -27,6 +27,7 @@
 #include "PipelinePluginProvider.h"
 #include "Plugin.h"
 #include "RegKey.h"
+#include "RegKeySnapshot.h"
 #include "StringUtils.h"
 #include "UserOverrideableRegKey.h"
 
@@ -36,6 +37,7 @@
 #include <exception>
 #include <functional>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -50,6 +52,8 @@ namespace PCC
     // Class used to access the PathCopyCopy settings, be it per-user or globals.
     //
     // This class is not thread-safe. Each thread should create its own copy.
+    // To share settings with worker threads converting paths, use an immutable
+    // SettingsSnapshot instead.
     //
     class Settings final : public COMPluginProvider,
                            public PipelinePluginProvider
@@ -59,6 +63,12 @@ namespace PCC
                         Settings(const Settings&) = delete;
         Settings&       operator=(const Settings&) = delete;
 
+        void            Snapshot();
+#ifdef PCC_BENCHMARKS
+        void            UseKeysForReading(const RegKey& p_UserKey,
+                                          const RegKey& p_IconsKey);
+#endif // PCC_BENCHMARKS
+
         bool            GetUseHiddenShares() const;
         bool            GetUseFQDN() const;
         bool            GetAddQuotesAroundPaths() const;
@@ -74,20 +84,39 @@ namespace PCC
         bool            GetDropRedundantWords() const;
         bool            GetAlwaysShowSubmenu() const;
         std::wstring    GetPathsSeparator() const;
+        DWORD           GetMenuTimeBudget() const;
+        bool            GetPrewarmCaches() const;
+        bool            GetCacheConvertedPaths() const;
+        bool            GetResolveDFSPaths() const;
+        bool            GetDisableShortNamesIfUnsupported() const;
+        WStringV        GetProjectRootMarkers() const;
+        WStringWStringUM
+                        GetSambaServerAliases() const;
         bool            GetCtrlKeyPlugin(GUID& p_rPluginId) const;
         bool            GetMainMenuPluginDisplayOrder(GUIDV& p_rvPluginIds) const;
         bool            GetSubmenuPluginDisplayOrder(GUIDV& p_rvPluginIds) const;
         bool            GetKnownPlugins(GUIDV& p_rvPluginIds) const;
+        bool            GetHotkeys(GUIDV& p_rvPluginIds,
+                                   UInt32V& p_rvHotkeys) const;
 
         bool            NeedsUpdateCheck() const;
+        __time64_t      GetNextUpdateCheckTime() const;
         void            SetLastUpdateCheckNow();
 
         cl::optional<std::wstring>
                         GetIconFileForPlugin(const CLSID& p_PluginId) const;
+        GUIDWStringPairV
+                        GetIconFilesForPlugins() const;
 
         bool            GetEditingDisabled() const;
 
+        ULONGLONG       GetGeneration() const;
+
+        bool            IsPluginShown(const GUID& p_PluginId) const;
+
         virtual CLSIDV  GetCOMPlugins() const override;
+        virtual bool    CanReuseCOMPlugin(const CLSID& p_CLSID) const override;
+        virtual bool    ShouldIsolateCOMPlugin(const CLSID& p_CLSID) const override;
         bool            RegisterCOMPlugin(const CLSID& p_CLSID,
                                           const bool p_User);
         bool            UnregisterCOMPlugin(const CLSID& p_CLSID,
@@ -112,8 +141,23 @@ namespace PCC
         AtlRegKey       m_GlobalPluginsKey;         // PCC global plugins registry key.
         bool            m_GlobalPluginsKeyReadOnly; // Whether the global plugins key is read-only.
         mutable bool    m_Revised;                  // Whether settings have been revised.
+        std::unique_ptr<RegKeySnapshot>
+                        m_upUserKeySnapshot;        // Snapshot of PCC user settings, if any.
+        std::unique_ptr<RegKeySnapshot>
+                        m_upIconsKeySnapshot;       // Snapshot of PCC default plugin icons, if any.
+        const RegKey*   m_pUserKeyForReading;       // Key to read PCC user settings from instead of the registry, if any (benchmarks only).
+        const RegKey*   m_pIconsKeyForReading;      // Key to read PCC default plugin icons from instead of the registry, if any (benchmarks only).
+        mutable std::unique_ptr<GUIDS>
+                        m_upShownPlugins;           // Plugins shown in menus according to snapshot, if computed.
 
         void            Revise() const;
+        const RegKey&   GetUserKeyForReading() const;
+        const RegKey&   GetIconsKeyForReading() const;
+        bool            IsCOMPluginInList(const wchar_t* const p_pValueName,
+                                          const CLSID& p_CLSID) const;
+        bool            GetPluginIds(const wchar_t* const p_pValueName,
+                                     const wchar_t* const p_pPackedValueName,
+                                     GUIDV& p_rvPluginIds) const;
 
         static std::wstring
                         GetCOMPluginInfo(const CLSID& p_CLSID);
@@ -122,6 +166,19 @@ namespace PCC
         static void     GetPipelinePlugins(const RegKey& p_PipelinePluginsKey,
                                            PluginSPV& p_rvspPlugins,
                                            const bool p_AddSeparator);
+        static void     GetPipelinePlugins(const UserOverrideableRegKey& p_PipelinePluginsKey,
+                                           PluginSPV& p_rvspPlugins,
+                                           const bool p_AddSeparator);
+        static void     LoadPipelinePlugins(const RegKey& p_PipelinePluginsKey,
+                                            PluginSPV& p_rvspPipelinePlugins);
+        static bool     LoadPackedPipelinePlugins(const RegKey& p_PipelinePluginsKey,
+                                                  PluginSPV& p_rvspPipelinePlugins);
+        static void     LoadLegacyPipelinePlugins(const RegKey& p_PipelinePluginsKey,
+                                                  PluginSPV& p_rvspPipelinePlugins);
+        static void     AddPipelinePlugins(const RegKey& p_PipelinePluginsKey,
+                                           PluginSPV& p_rvspPipelinePlugins,
+                                           PluginSPV& p_rvspPlugins,
+                                           const bool p_AddSeparator);
 
         // Helper to apply revisions to the settings
         class Reviser final
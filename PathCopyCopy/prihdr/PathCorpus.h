@@ -0,0 +1,81 @@
+// PathCorpus.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include "PathCopyCopyPrivateTypes.h"
+
+#include <random>
+#include <string>
+
+#include <windows.h>
+
+
+namespace PCC
+{
+    //
+    // PathCorpus
+    //
+    // Static class generating synthetic sets of paths whose shapes follow those
+    // found on real machines: deep build trees, paths longer than MAX_PATH,
+    // international and right-to-left names, names with characters that need
+    // escaping, mapped drives and UNC roots, and large flat folders. Used by
+    // benchmarks and by the end-to-end harness so that all measurements are
+    // performed against the same inputs.
+    //
+    // Corpora are generated deterministically from a fixed seed, so a given
+    // corpus name and size always produce the same paths. Paths do not exist.
+    // The DLL only contains this class in benchmark builds (PCC_BENCHMARKS);
+    // other programs get corpora through GenerateCorpusW.
+    //
+    class PathCorpus final
+    {
+    public:
+        // Kinds of corpora that can be generated.
+        enum class Kind {
+            Mixed,          // Mix of all other kinds, in proportions typical of a workstation.
+            BuildTree,      // Files deep in source and build output trees.
+            LongPaths,      // Paths longer than MAX_PATH.
+            International,  // Names in various scripts, including right-to-left ones.
+            SpecialChars,   // Names with spaces, ampersands, percent signs, etc.
+            NetworkRoots,   // Paths on mapped drives and UNC shares.
+            FlatFolder,     // Files in a single folder.
+        };
+
+                        PathCorpus() = delete;
+                        ~PathCorpus() = delete;
+
+        static bool     KindFromName(const wchar_t* const p_pName,
+                                     Kind& p_rKind);
+        static FilesV   Generate(const Kind p_Kind,
+                                 const ULONG p_Size);
+
+    private:
+        typedef std::mt19937 Generator;
+
+        static std::wstring
+                        GeneratePath(const Kind p_Kind,
+                                     const ULONG p_Index,
+                                     Generator& p_rGenerator);
+    };
+
+} // namespace PCC
@@ -0,0 +1,131 @@
+// PathResultCache.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include "MeasuredMutex.h"
+#include "PathCopyCopyPrivateTypes.h"
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <atlbase.h>
+#include <windows.h>
+
+
+namespace PCC
+{
+    //
+    // PathResultCache
+    //
+    // Bounded cache of paths converted by plugins, shared between all our
+    // processes of the same user and session through a shared memory section.
+    // Entries are keyed by plugin ID, input path and settings generation (see
+    // Settings::GetGeneration), so that they are invalidated whenever settings
+    // change. Only plugins that return a non-zero Plugin::PathCacheTimeToLive
+    // are cached; entries expire after that time. When the cache is full, the
+    // least recently used entry is replaced.
+    //
+    // This allows repeated conversions of the same files, even from different
+    // Explorer windows or processes, to skip network lookups and COM calls.
+    //
+    class PathResultCache final
+    {
+    public:
+        // Time to live of paths that depend on the network configuration, in milliseconds.
+        static const DWORD  NETWORK_PATHS_TIME_TO_LIVE      = 30 * 1000;
+
+        // Maximum time to live of paths returned by COM plugins that allow it, in milliseconds.
+        static const DWORD  COM_PLUGIN_PATHS_TIME_TO_LIVE   = 5 * 60 * 1000;
+
+        // Time to live of paths returned by pipelines that memoize them, in milliseconds.
+        static const DWORD  MEMOIZED_PATHS_TIME_TO_LIVE     = 60 * 60 * 1000;
+
+                        PathResultCache() = delete;
+                        ~PathResultCache() = delete;
+
+        static ULONGLONG
+                        GetGeneration(const Plugin& p_Plugin,
+                                      const ConversionContext& p_Context,
+                                      const size_t p_NumFiles);
+        static void     Lookup(const GUID& p_PluginId,
+                               const ULONGLONG p_Generation,
+                               const FilesV& p_vFiles,
+                               WStringV& p_rvPaths,
+                               std::vector<bool>& p_rvFound);
+        static void     Store(const GUID& p_PluginId,
+                              const ULONGLONG p_Generation,
+                              const DWORD p_TimeToLive,
+                              const FilesV& p_vFiles,
+                              const WStringV& p_vPaths);
+        static void     Flush();
+        static void     SetSuspended(const bool p_Suspended);
+
+    private:
+        struct SharedCacheHeader;
+        struct SharedCacheEntry;
+
+        //
+        // Helper that acquires exclusive access to the shared cache
+        // upon construction and releases it upon destruction.
+        //
+        class StSharedCacheLock final
+        {
+        public:
+                        StSharedCacheLock();
+                        StSharedCacheLock(const StSharedCacheLock&) = delete;
+            StSharedCacheLock&
+                        operator=(const StSharedCacheLock&) = delete;
+                        ~StSharedCacheLock();
+
+            SharedCacheHeader*
+                        GetHeader() const;
+
+        private:
+            SharedCacheHeader*
+                        m_pHeader;          // Header of shared cache, or nullptr if not acquired.
+            HANDLE      m_hMutex;           // Mutex protecting the shared cache, if acquired.
+        };
+
+        static ATL::CHandle
+                        s_hMapping;         // Handle to shared memory section storing the cache.
+        static ATL::CHandle
+                        s_hMutex;           // Handle to mutex protecting the shared cache.
+        static void*    s_pView;            // Mapped view of the shared memory section.
+        static bool     s_Opened;           // Whether we attempted to open the shared cache.
+        static bool     s_Suspended;        // Whether cache is suspended (see SetSuspended).
+        static MeasuredMutex
+                        s_Lock;             // Lock protecting static members.
+
+        static SharedCacheHeader*
+                        OpenSharedCache(HANDLE& p_rhMutex);
+        static SharedCacheEntry*
+                        FindEntry(SharedCacheHeader* const p_pHeader,
+                                  const GUID& p_PluginId,
+                                  const ULONGLONG p_Generation,
+                                  const std::wstring& p_File,
+                                  const DWORD p_FileHash);
+        static DWORD    HashFile(const std::wstring& p_File);
+    };
+
+} // namespace PCC
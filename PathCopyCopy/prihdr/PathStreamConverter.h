@@ -0,0 +1,79 @@
+// PathStreamConverter.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include "PathCopyCopyPrivateTypes.h"
+
+#include <string>
+#include <vector>
+
+#include <windows.h>
+
+
+namespace PCC
+{
+    //
+    // PathStreamConverter
+    //
+    // Converts a stream of paths read from a file or pipe using a plugin and
+    // writes the results to another file or pipe as they are available, so
+    // that very large inputs can be converted without holding them in memory.
+    //
+    // Input paths are read one per line, in UTF-8 (with or without BOM) or in
+    // UTF-16 (with BOM); empty lines are ignored. Paths are converted in
+    // batches, each batch being converted in parallel when it's large enough
+    // (see PluginUtils::GetPathsInParallel). Results are written in UTF-8,
+    // unless the output is a console, each one followed by a separator.
+    //
+    class PathStreamConverter final
+    {
+    public:
+                        PathStreamConverter(const Plugin& p_Plugin,
+                                            const ConversionContext& p_Context,
+                                            HANDLE const p_hOutput,
+                                            const std::wstring& p_Separator);
+                        PathStreamConverter(const PathStreamConverter&) = delete;
+        PathStreamConverter&
+                        operator=(const PathStreamConverter&) = delete;
+
+        bool            Convert(HANDLE const p_hInput);
+
+        size_t          GetConvertedCount() const;
+
+    private:
+        const Plugin&   m_rPlugin;          // Plugin used to convert paths.
+        const ConversionContext&
+                        m_rContext;         // Context used to convert paths.
+        HANDLE          m_hOutput;          // Where to write converted paths.
+        std::wstring    m_Separator;        // Written after each converted path.
+        bool            m_ConsoleOutput;    // Whether m_hOutput is a console.
+        FilesV          m_vBatch;           // Paths read but not converted yet.
+        size_t          m_ConvertedCount;   // Number of paths converted so far.
+
+        void            AddLine(const wchar_t* const p_pLine,
+                                size_t p_Length);
+        bool            ConvertBatch();
+        bool            Write(const std::wstring& p_Text) const;
+    };
+
+} // namespace PCC
@@ -0,0 +1,84 @@
+// PerformanceCounters.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include <chrono>
+#include <mutex>
+
+#include <windows.h>
+
+
+namespace PCC
+{
+    //
+    // PerformanceCounters
+    //
+    // Publishes performance counters that can be collected through PDH (for
+    // example with perfmon or typeperf) to monitor our extension across a
+    // fleet of machines. Each process that loads us exposes an instance of
+    // our counter set; PDH aggregates them in the _Total instance.
+    //
+    // The provider is started the first time a counter is updated. On
+    // versions of Windows that do not support PerfLib V2 providers, or if
+    // our counters have not been registered with lodctr, updating counters
+    // does nothing.
+    //
+    class PerformanceCounters final
+    {
+    public:
+        // Caches whose hit rates are published.
+        enum class Cache {
+            PluginsSnapshot,    // Snapshot of plugins (see PluginsSnapshot).
+            ShareIndex,         // Index of local shares (see ShareIndex).
+            FQDN,               // Fully-qualified domain names (see FQDNCache).
+            PathResults,        // Results of plugins (see PathResultCache).
+        };
+
+                        PerformanceCounters() = delete;
+                        ~PerformanceCounters() = delete;
+
+        static void     Stop();
+
+        static void     MenuBuilt(const std::chrono::microseconds p_Duration);
+        static void     PathsConverted(const size_t p_Count);
+        static void     CacheLookup(const Cache p_Cache,
+                                    const bool p_Hit);
+        static void     COMPluginFailed();
+
+    private:
+        // Number of menu build durations used to compute percentiles.
+        static const size_t
+                        DURATION_SAMPLES = 128;
+
+        static std::once_flag
+                        s_StartFlag;                        // Flag used to start provider once.
+        static std::mutex
+                        s_DurationsLock;                    // Lock protecting menu build durations.
+        static ULONG    s_Durations[DURATION_SAMPLES];      // Ring buffer of recent menu build durations, in microseconds.
+        static size_t   s_NextDuration;                     // Index of next duration to record in s_Durations.
+        static size_t   s_NumDurations;                     // Number of durations recorded in s_Durations.
+
+        static bool     Started();
+        static void     Start();
+    };
+
+} // namespace PCC
@@ -21,11 +21,12 @@
 
 #pragma once
 
+#include "ConversionContext.h"
 #include "PathCopyCopyPrivateTypes.h"
+#include "PluginSet.h"
 
 #include <functional>
 #include <memory>
-#include <set>
 #include <string>
 #include <vector>
 #include <utility>
@@ -43,6 +44,11 @@ namespace PCC
     // will be used to add a menu items to the contextual menu shown
     // in Windows Explorer in the PCC submenu.
     //
+    // Plugins do not store any state that depends on the current operation;
+    // methods that need settings or access to other plugins receive them
+    // through a ConversionContext. This allows plugin instances to be shared
+    // between threads and contextual menu extension instances.
+    //
     class Plugin
     {
     public:
@@ -62,37 +68,43 @@ namespace PCC
                                     // Returns a description of the plugin. Used by PCC
                                     // as the caption for the plugin in the contextual menu.
                                     //
+                                    // @param p_Context Context in which the plugin is used.
                                     // @return Plugin description.
                                     //
-        virtual std::wstring        Description() const = 0;
+        virtual std::wstring        Description(const ConversionContext& p_Context) const = 0;
         virtual std::wstring        HelpText() const;
         virtual std::wstring        IconFile() const;
         virtual bool                UseDefaultIcon() const;
+        virtual std::wstring        MenuFolder() const;
         virtual bool                Enabled(const std::wstring& p_ParentPath,
-                                            const std::wstring& p_File) const;
+                                            const std::wstring& p_File,
+                                            const ConversionContext& p_Context) const;
 
                                     //
                                     // Returns the path of the given file, as determined
                                     // by the plugin's own path scheme.
                                     //
                                     // @param p_File Full path to the file to get the path for.
+                                    // @param p_Context Context of the conversion.
                                     // @return Path of the file according to plugin.
                                     //
-        virtual std::wstring        GetPath(const std::wstring& p_File) const = 0;
+        virtual std::wstring        GetPath(const std::wstring& p_File,
+                                            const ConversionContext& p_Context) const = 0;
+        virtual WStringV            GetPaths(const FilesV& p_vFiles,
+                                             const ConversionContext& p_Context) const;
         virtual std::wstring        PathsSeparator() const;
+        virtual ExportFormat        GetExportFormat() const;
 
         virtual PathActionSP        Action() const;
 
         virtual bool                IsSeparator() const;
         virtual bool                CanDropRedundantWords() const;
-
-        void                        SetSettings(const Settings* const p_pSettings);
-        void                        SetPluginProvider(const PluginProvider* const p_pPluginProvider);
+        virtual PluginCost          CostClass(const ConversionContext& p_Context) const;
+        virtual bool                CanGetPathsConcurrently(const ConversionContext& p_Context) const;
+        virtual DWORD               PathCacheTimeToLive(const ConversionContext& p_Context) const;
+        virtual void                GetReferencedPlugins(GUIDV& p_rvPluginIds) const;
 
     protected:
-        const Settings*             m_pSettings;        // Optional object to access PCC settings.
-        const PluginProvider*       m_pPluginProvider;  // Optional object to access other plugins.
-
                                     Plugin();
     };
 
@@ -103,6 +115,6 @@ namespace PCC
 
     // Containers for plugins stored in shared pointers.
     typedef std::vector<PluginSP>           PluginSPV;
-    typedef std::set<PluginSP, std::less<>> PluginSPS;
+    typedef PluginSet                       PluginSPS;
 
 } // namespace PCC
@@ -0,0 +1,96 @@
+// PluginDependencyGraph.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include "PathCopyCopyPrivateTypes.h"
+#include "Plugin.h"
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+namespace PCC
+{
+    //
+    // PluginDependencyGraph
+    //
+    // Graph of the references between a set of plugins (for example through
+    // ApplyPluginPipelineElement). The graph is resolved once when created:
+    // each plugin is bound to the plugins it references and plugins that are
+    // part of a reference cycle are detected so that they are never applied
+    // (they would recurse endlessly otherwise).
+    //
+    // When a plugin is referenced by more than one other plugin, the last path
+    // it computed is memoized so that plugins sharing it do not redo the work
+    // for the same input path.
+    //
+    class PluginDependencyGraph final
+    {
+    public:
+        explicit        PluginDependencyGraph(const PluginSPS& p_sspAllPlugins);
+                        PluginDependencyGraph(const PluginDependencyGraph&) = delete;
+        PluginDependencyGraph&
+                        operator=(const PluginDependencyGraph&) = delete;
+
+        PluginSP        GetPlugin(const GUID& p_PluginId) const;
+        bool            GetPath(const GUID& p_PluginId,
+                                std::wstring& p_rPath,
+                                const ConversionContext& p_Context) const;
+        void            ClearCachedPaths() const;
+
+    private:
+        // Node in the graph, representing one plugin.
+        struct Node {
+            PluginSP    m_spPlugin;             // Plugin represented by the node.
+            std::vector<Node*>
+                        m_vpReferences;         // Nodes of plugins referenced by this plugin.
+            size_t      m_ReferenceCount;       // Number of plugins referencing this plugin.
+            bool        m_InCycle;              // Whether plugin is part of a reference cycle.
+            int         m_Index;                // Index used while looking for cycles.
+            int         m_LowLink;              // Lowest index reachable, used while looking for cycles.
+            bool        m_OnStack;              // Whether node is on the stack while looking for cycles.
+            mutable bool
+                        m_HasCachedPath;        // Whether m_CachedInput and m_CachedOutput are set.
+            mutable std::wstring
+                        m_CachedInput;          // Last path passed to the plugin.
+            mutable std::wstring
+                        m_CachedOutput;         // Path returned by the plugin for m_CachedInput.
+
+                        Node();
+        };
+
+        // Map of nodes, per plugin ID.
+        typedef std::map<GUID, Node, GUIDLess> NodeM;
+
+        NodeM           m_mNodes;               // Nodes of the graph.
+        mutable std::mutex
+                        m_CacheLock;            // Lock protecting memoized paths.
+
+        static void     FindCycles(Node& p_rNode,
+                                   int& p_rNextIndex,
+                                   std::vector<Node*>& p_rvpStack);
+    };
+
+} // namespace PCC
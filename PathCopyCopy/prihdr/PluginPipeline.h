@@ -21,14 +21,19 @@
 
 #pragma once
 
+#include "ConversionContext.h"
 #include "PathCopyCopyPrivateTypes.h"
 #include "PluginProvider.h"
+#include <LaunchExecutablePathAction.h>
 
 #include <string>
+#include <vector>
 
 
 namespace PCC
 {
+    // Forward declarations
+    class GuardPipelineElement;
 
     //
     // PipelineOptions
@@ -50,10 +55,67 @@ namespace PCC
         bool            GetUseFilelist() const;
         void            SetUseFilelist(const bool p_UseFilelist);
 
+        Actions::LaunchExecutablePathAction::FilelistEncoding
+                        GetFilelistEncoding() const;
+        void            SetFilelistEncoding(const Actions::LaunchExecutablePathAction::FilelistEncoding p_FilelistEncoding);
+
+        Actions::LaunchExecutablePathAction::FilelistDelivery
+                        GetFilelistDelivery() const;
+        void            SetFilelistDelivery(const Actions::LaunchExecutablePathAction::FilelistDelivery p_FilelistDelivery);
+
+        bool            GetCopyMultipleFormats() const;
+        void            SetCopyMultipleFormats(const bool p_CopyMultipleFormats);
+
+        size_t          GetMaxParallelBatches() const;
+        void            SetMaxParallelBatches(const size_t p_MaxParallelBatches);
+
+        Actions::LaunchExecutablePathAction::InstanceEndpoint
+                        GetInstanceEndpoint() const;
+        const std::wstring&
+                        GetInstanceEndpointName() const;
+        void            SetInstanceEndpoint(const Actions::LaunchExecutablePathAction::InstanceEndpoint p_InstanceEndpoint,
+                                            const std::wstring& p_InstanceEndpointName);
+
+        bool            GetStreamToFile() const;
+        const std::wstring&
+                        GetOutputFile() const;
+        Actions::LaunchExecutablePathAction::FilelistEncoding
+                        GetOutputFileEncoding() const;
+        void            SetOutputFile(const std::wstring& p_OutputFile,
+                                      const Actions::LaunchExecutablePathAction::FilelistEncoding p_OutputFileEncoding);
+
+        ExportFormat    GetExportFormat() const;
+        void            SetExportFormat(const ExportFormat p_ExportFormat);
+
+        bool            GetMemoizePaths() const;
+        void            SetMemoizePaths(const bool p_MemoizePaths);
+
     private:
         std::wstring    m_PathsSeparator;       // Separator to use between multiple paths.
         std::wstring    m_Executable;           // Path to executable to start.
         bool            m_UseFilelist = false;  // Whether to launch executable with filelist instead of paths directly.
+        Actions::LaunchExecutablePathAction::FilelistEncoding
+                        m_FilelistEncoding = Actions::LaunchExecutablePathAction::FilelistEncoding::Ansi;
+                                                // Encoding of filelist, if used.
+        Actions::LaunchExecutablePathAction::FilelistDelivery
+                        m_FilelistDelivery = Actions::LaunchExecutablePathAction::FilelistDelivery::TempFile;
+                                                // How filelist is delivered to executable, if used.
+        bool            m_CopyMultipleFormats = false;
+                                                // Whether to copy paths to the clipboard in multiple formats.
+        size_t          m_MaxParallelBatches = 0;
+                                                // Max number of executable batches to run at once (0 to launch executable only once).
+        Actions::LaunchExecutablePathAction::InstanceEndpoint
+                        m_InstanceEndpoint = Actions::LaunchExecutablePathAction::InstanceEndpoint::None;
+                                                // Endpoint used to send paths to a running instance of executable, if any.
+        std::wstring    m_InstanceEndpointName; // Name of pipe or window class used to reach a running instance.
+        bool            m_StreamToFile = false; // Whether to write paths to a file instead of copying them.
+        std::wstring    m_OutputFile;           // Path of file to write paths to, if any (empty to let user choose).
+        Actions::LaunchExecutablePathAction::FilelistEncoding
+                        m_OutputFileEncoding = Actions::LaunchExecutablePathAction::FilelistEncoding::UTF8;
+                                                // Encoding of file to write paths to.
+        ExportFormat    m_ExportFormat = ExportFormat::None;
+                                                // Format used to export paths with their files' metadata, if any.
+        bool            m_MemoizePaths = false; // Whether paths returned by pipeline can be cached (see PathResultCache).
     };
 
     //
@@ -62,6 +124,12 @@ namespace PCC
     // Class representing a pipeline in which each element can apply
     // changes to a path. Meant to be used by custom path plugins.
     //
+    // Pipelines are immutable once created and can be shared between
+    // plugins and threads (see PipelineCache).
+    //
+    // Paths that fail a guard element skip the rest of the pipeline
+    // (see GuardPipelineElement).
+    //
     class Pipeline final
     {
     public:
@@ -71,15 +139,30 @@ namespace PCC
         Pipeline&       operator=(const Pipeline&) = delete;
 
         void            ModifyPath(std::wstring& p_rPath,
-                                   const PluginProvider* const p_pPluginProvider) const;
-        void            ModifyOptions(PipelineOptions& p_rOptions) const;
+                                   const ConversionContext& p_Context) const;
+        void            ModifyPaths(WStringV& p_rvPaths,
+                                    const ConversionContext& p_Context) const;
+        const PipelineOptions&
+                        Options() const;
         bool            ShouldBeEnabledFor(const std::wstring& p_ParentPath,
                                            const std::wstring& p_File,
-                                           const PluginProvider* const p_pPluginProvider) const;
+                                           const ConversionContext& p_Context) const;
+        void            GetReferencedPlugins(GUIDV& p_rvPluginIds) const;
+        PluginCost      CostClass(const ConversionContext& p_Context) const;
 
     private:
         PipelineElementSPV
                         m_vspElements;      // Elements in the pipeline.
+        PipelineOptions m_Options;          // Global options, as modified by all elements.
+        std::vector<const GuardPipelineElement*>
+                        m_vpGuards;         // Guard at each position in m_vspElements, or nullptr if element is not a guard.
+        bool            m_HasGuards;        // Whether pipeline contains any guard.
+
+        void            ComputeOptions();
+        void            FindGuards();
+        void            ModifyPaths(WStringV& p_rvPaths,
+                                    const size_t p_FirstElement,
+                                    const ConversionContext& p_Context) const;
     };
 
     //
@@ -97,11 +180,16 @@ namespace PCC
         virtual         ~PipelineElement();
 
         virtual void    ModifyPath(std::wstring& p_rPath,
-                                   const PluginProvider* const p_pPluginProvider) const = 0;
+                                   const ConversionContext& p_Context) const = 0;
+        virtual void    ModifyPaths(WStringV& p_rvPaths,
+                                    const ConversionContext& p_Context) const;
         virtual void    ModifyOptions(PipelineOptions& p_rOptions) const;
         virtual bool    ShouldBeEnabledFor(const std::wstring& p_ParentPath,
                                            const std::wstring& p_File,
-                                           const PluginProvider* const p_pPluginProvider) const;
+                                           const ConversionContext& p_Context) const;
+        virtual void    GetReferencedPlugins(GUIDV& p_rvPluginIds) const;
+        virtual PluginCost
+                        CostClass(const ConversionContext& p_Context) const;
     };
 
 } // namespace PCC
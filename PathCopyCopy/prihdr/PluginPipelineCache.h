@@ -0,0 +1,83 @@
+// PluginPipelineCache.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include "MeasuredMutex.h"
+#include "PathCopyCopyPrivateTypes.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+
+
+namespace PCC
+{
+    //
+    // PipelineCache
+    //
+    // Process-wide cache of decoded pipelines, keyed by their encoded string.
+    // Pipeline plugins with identical encoded pipelines share the same
+    // immutable Pipeline object, which is only decoded once as long as
+    // it is used by at least one plugin and as long as the settings haven't
+    // changed (see RegistryWatcher); pipeline elements can load data from
+    // the registry, which is thus reloaded when pipelines are decoded again.
+    //
+    // Encoded strings that fail to decode are also remembered until the
+    // settings change, so that broken pipelines are not decoded again
+    // every time a menu is built.
+    //
+    class PipelineCache final
+    {
+    public:
+                        PipelineCache() = delete;
+                        ~PipelineCache() = delete;
+
+        static PipelineSP
+                        GetPipeline(const std::wstring& p_EncodedElements);
+
+    private:
+        // Pipeline decoded from an encoded string.
+        struct CachedPipeline {
+            std::weak_ptr<Pipeline>
+                        m_wpPipeline;   // Decoded pipeline; not kept alive by the cache.
+            ULONG       m_Generation;   // Settings generation when pipeline was decoded.
+        };
+
+        // Map of decoded pipelines, per encoded string.
+        typedef std::map<std::wstring, CachedPipeline> PipelineM;
+
+        // Set of encoded strings that could not be decoded.
+        typedef std::set<std::wstring> EncodedElementsS;
+
+        static PipelineM
+                        s_mwpPipelines;         // Decoded pipelines that are still in use.
+        static EncodedElementsS
+                        s_sInvalidPipelines;    // Encoded strings that could not be decoded.
+        static ULONG    s_InvalidGeneration;    // Settings generation when s_sInvalidPipelines was last cleared.
+        static MeasuredMutex
+                        s_Lock;                 // Lock protecting the cache.
+    };
+
+} // namespace PCC
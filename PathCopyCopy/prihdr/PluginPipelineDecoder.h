@@ -45,34 +45,82 @@ namespace PCC
                                        PipelineElementSPV& p_rvspElements);
 
     private:
+        // Formats that can be used to encode pipelines.
+        enum class Format {
+            Text,       // Legacy format where all fields are stored as text.
+            Binary,     // Compact format where fields are stored as-is. Starts with a signature.
+        };
+
         static void     DecodePipelineElement(std::wstring::const_iterator& p_rElementIt,
                                               const std::wstring::const_iterator& p_ElementEnd,
+                                              const Format p_Format,
                                               PipelineElementSPV& p_rvspElements);
 
         static void     DecodeFindReplaceElement(std::wstring::const_iterator& p_rElementIt,
                                                  const std::wstring::const_iterator& p_ElementEnd,
+                                                 const Format p_Format,
+                                                 const bool p_IgnoreCase,
                                                  PipelineElementSP& p_rspElement);
         static void     DecodeRegexElement(std::wstring::const_iterator& p_rElementIt,
                                            const std::wstring::const_iterator& p_ElementEnd,
+                                           const Format p_Format,
                                            PipelineElementSP& p_rspElement);
+        static void     DecodePrefixMappingElement(std::wstring::const_iterator& p_rElementIt,
+                                                   const std::wstring::const_iterator& p_ElementEnd,
+                                                   const Format p_Format,
+                                                   PipelineElementSP& p_rspElement);
         static void     DecodeApplyPluginElement(std::wstring::const_iterator& p_rElementIt,
                                                  const std::wstring::const_iterator& p_ElementEnd,
+                                                 const Format p_Format,
                                                  PipelineElementSP& p_rspElement);
+        static void     DecodeTemplateElement(std::wstring::const_iterator& p_rElementIt,
+                                              const std::wstring::const_iterator& p_ElementEnd,
+                                              const Format p_Format,
+                                              PipelineElementSP& p_rspElement);
         static void     DecodePathsSeparatorElement(std::wstring::const_iterator& p_rElementIt,
                                                     const std::wstring::const_iterator& p_ElementEnd,
+                                                    const Format p_Format,
                                                     PipelineElementSP& p_rspElement);
+        static void     DecodeBatchExecutableElement(std::wstring::const_iterator& p_rElementIt,
+                                                     const std::wstring::const_iterator& p_ElementEnd,
+                                                     const Format p_Format,
+                                                     PipelineElementSP& p_rspElement);
+        static void     DecodeRunningInstanceElement(std::wstring::const_iterator& p_rElementIt,
+                                                     const std::wstring::const_iterator& p_ElementEnd,
+                                                     const Format p_Format,
+                                                     PipelineElementSP& p_rspElement);
+        static void     DecodeOutputFileElement(std::wstring::const_iterator& p_rElementIt,
+                                                const std::wstring::const_iterator& p_ElementEnd,
+                                                const Format p_Format,
+                                                PipelineElementSP& p_rspElement);
+        static void     DecodeExportMetadataElement(std::wstring::const_iterator& p_rElementIt,
+                                                    const std::wstring::const_iterator& p_ElementEnd,
+                                                    const Format p_Format,
+                                                    PipelineElementSP& p_rspElement);
+        static void     DecodeUnicodeNormalizationElement(std::wstring::const_iterator& p_rElementIt,
+                                                          const std::wstring::const_iterator& p_ElementEnd,
+                                                          const Format p_Format,
+                                                          PipelineElementSP& p_rspElement);
+        static void     DecodeGuardElement(std::wstring::const_iterator& p_rElementIt,
+                                           const std::wstring::const_iterator& p_ElementEnd,
+                                           const Format p_Format,
+                                           PipelineElementSP& p_rspElement);
         static void     DecodeExecutableElement(const wchar_t p_Code,
                                                 std::wstring::const_iterator& p_rElementIt,
                                                 const std::wstring::const_iterator& p_ElementEnd,
+                                                const Format p_Format,
                                                 PipelineElementSP& p_rspElement);
 
         static long     DecodePipelineInt(std::wstring::const_iterator& p_rElementIt,
-                                          const std::wstring::const_iterator& p_ElementEnd);
+                                          const std::wstring::const_iterator& p_ElementEnd,
+                                          const Format p_Format);
         static void     DecodePipelineString(std::wstring::const_iterator& p_rElementIt,
                                              const std::wstring::const_iterator& p_ElementEnd,
+                                             const Format p_Format,
                                              std::wstring& p_rString);
         static bool     DecodePipelineBool(std::wstring::const_iterator& p_rElementIt,
-                                           const std::wstring::const_iterator& p_ElementEnd);
+                                           const std::wstring::const_iterator& p_ElementEnd,
+                                           const Format p_Format);
     };
 
     //
@@ -21,11 +21,18 @@
 
 #pragma once
 
+#include <LiteralReplacer.h>
 #include <PluginPipeline.h>
+#include <PrefixMap.h>
+#include <RegexCache.h>
 
+#include <map>
 #include <memory>
+#include <mutex>
 #include <regex>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <windows.h>
 
@@ -46,7 +53,7 @@ namespace PCC
                         operator=(const QuotesPipelineElement&) = delete;
 
         virtual void    ModifyPath(std::wstring& p_rPath,
-                                   const PluginProvider* const p_pPluginProvider) const override;
+                                   const ConversionContext& p_Context) const override;
     };
 
     //
@@ -64,7 +71,7 @@ namespace PCC
                         operator=(const OptionalQuotesPipelineElement&) = delete;
 
         virtual void    ModifyPath(std::wstring& p_rPath,
-                                   const PluginProvider* const p_pPluginProvider) const override;
+                                   const ConversionContext& p_Context) const override;
     };
 
     //
@@ -82,7 +89,7 @@ namespace PCC
                         operator=(const EmailLinksPipelineElement&) = delete;
 
         virtual void    ModifyPath(std::wstring& p_rPath,
-                                   const PluginProvider* const p_pPluginProvider) const override;
+                                   const ConversionContext& p_Context) const override;
     };
 
     //
@@ -100,7 +107,7 @@ namespace PCC
                         operator=(const EncodeURIWhitespacePipelineElement&) = delete;
 
         virtual void    ModifyPath(std::wstring& p_rPath,
-                                   const PluginProvider* const p_pPluginProvider) const override;
+                                   const ConversionContext& p_Context) const override;
     };
 
     //
@@ -118,7 +125,7 @@ namespace PCC
                         operator=(const EncodeURICharsPipelineElement&) = delete;
 
         virtual void    ModifyPath(std::wstring& p_rPath,
-                                   const PluginProvider* const p_pPluginProvider) const override;
+                                   const ConversionContext& p_Context) const override;
     };
 
     //
@@ -136,7 +143,7 @@ namespace PCC
                         operator=(const BackToForwardSlashesPipelineElement&) = delete;
 
         virtual void    ModifyPath(std::wstring& p_rPath,
-                                   const PluginProvider* const p_pPluginProvider) const override;
+                                   const ConversionContext& p_Context) const override;
     };
 
     //
@@ -154,7 +161,7 @@ namespace PCC
                         operator=(const ForwardToBackslashesPipelineElement&) = delete;
 
         virtual void    ModifyPath(std::wstring& p_rPath,
-                                   const PluginProvider* const p_pPluginProvider) const override;
+                                   const ConversionContext& p_Context) const override;
     };
 
     //
@@ -171,30 +178,137 @@ namespace PCC
                         operator=(const RemoveFileExtPipelineElement&) = delete;
 
         virtual void    ModifyPath(std::wstring& p_rPath,
-                                   const PluginProvider* const p_pPluginProvider) const override;
+                                   const ConversionContext& p_Context) const override;
+    };
+
+    //
+    // FinalPathPipelineElement
+    //
+    // Pipeline element that resolves reparse points (junctions, mount points,
+    // symbolic links) found in a path to get the final path to the file.
+    // When modifying many paths, each directory is only resolved once.
+    //
+    class FinalPathPipelineElement : public PipelineElement
+    {
+    public:
+                        FinalPathPipelineElement();
+                        FinalPathPipelineElement(const FinalPathPipelineElement&) = delete;
+        FinalPathPipelineElement&
+                        operator=(const FinalPathPipelineElement&) = delete;
+
+        virtual void    ModifyPath(std::wstring& p_rPath,
+                                   const ConversionContext& p_Context) const override;
+        virtual void    ModifyPaths(WStringV& p_rvPaths,
+                                    const ConversionContext& p_Context) const override;
+        virtual PluginCost
+                        CostClass(const ConversionContext& p_Context) const override;
     };
 
     //
     // FindReplacePipelineElement
     //
     // Pipeline element that replaces all instances of one string
-    // in the path with another string.
+    // in the path with another string, optionally ignoring case.
     //
     class FindReplacePipelineElement : public PipelineElement
     {
     public:
                         FindReplacePipelineElement(const std::wstring& p_OldValue,
-                                                   const std::wstring& p_NewValue);
+                                                   const std::wstring& p_NewValue,
+                                                   const bool p_IgnoreCase = false);
                         FindReplacePipelineElement(const FindReplacePipelineElement&) = delete;
         FindReplacePipelineElement&
                         operator=(const FindReplacePipelineElement&) = delete;
 
         virtual void    ModifyPath(std::wstring& p_rPath,
-                                   const PluginProvider* const p_pPluginProvider) const override;
+                                   const ConversionContext& p_Context) const override;
+
+        const std::wstring&
+                        GetOldValue() const;
+        const std::wstring&
+                        GetNewValue() const;
+        bool            GetIgnoreCase() const;
 
     private:
         std::wstring    m_OldValue;     // Value to replace.
         std::wstring    m_NewValue;     // Replacement value.
+        bool            m_IgnoreCase;   // Whether to ignore case when looking for m_OldValue.
+        LiteralReplacer m_Replacer;     // Object performing the actual replacements.
+    };
+
+    //
+    // CharMapPipelineElement
+    //
+    // Pipeline element that replaces characters in the path according
+    // to a mapping table, in a single pass. Never decoded directly;
+    // created by PipelineOptimizer to fuse adjacent elements that each
+    // replace one character by another.
+    //
+    class CharMapPipelineElement : public PipelineElement
+    {
+    public:
+        // Map of replacement characters, per character to replace.
+        typedef std::map<wchar_t, wchar_t> CharM;
+
+        explicit        CharMapPipelineElement(const CharM& p_mCharMap);
+                        CharMapPipelineElement(const CharMapPipelineElement&) = delete;
+        CharMapPipelineElement&
+                        operator=(const CharMapPipelineElement&) = delete;
+
+        virtual void    ModifyPath(std::wstring& p_rPath,
+                                   const ConversionContext& p_Context) const override;
+
+    private:
+        wchar_t         m_AsciiChars[0x80];     // Replacement for each ASCII character.
+        CharM           m_mOtherChars;          // Replacements for non-ASCII characters.
+    };
+
+    //
+    // MultiFindReplacePipelineElement
+    //
+    // Pipeline element that replaces all instances of multiple strings
+    // in the path in a single pass, using an Aho-Corasick automaton.
+    // Never decoded directly; created by PipelineOptimizer to fuse
+    // adjacent FindReplacePipelineElements.
+    //
+    // Note: patterns must not share characters with each other, so that
+    // matches can never overlap. PipelineOptimizer guarantees this.
+    //
+    class MultiFindReplacePipelineElement : public PipelineElement
+    {
+    public:
+        // Pair of value to replace and replacement value.
+        typedef std::pair<std::wstring, std::wstring> FindReplacePair;
+        typedef std::vector<FindReplacePair> FindReplacePairV;
+
+        explicit        MultiFindReplacePipelineElement(const FindReplacePairV& p_vFindReplaces);
+                        MultiFindReplacePipelineElement(const MultiFindReplacePipelineElement&) = delete;
+        MultiFindReplacePipelineElement&
+                        operator=(const MultiFindReplacePipelineElement&) = delete;
+
+        virtual void    ModifyPath(std::wstring& p_rPath,
+                                   const ConversionContext& p_Context) const override;
+
+    private:
+        // State of the Aho-Corasick automaton.
+        struct State {
+            std::map<wchar_t, size_t>
+                        m_mTransitions;         // Next state, per character (trie edges only).
+            size_t      m_Failure;              // State to go to when no transition matches.
+            size_t      m_Depth;                // Length of the prefix represented by this state.
+            size_t      m_Pattern;              // Index of pattern ending here, or NO_PATTERN.
+        };
+        typedef std::vector<State> StateV;
+
+        static const size_t
+                        NO_PATTERN;             // Value of State::m_Pattern when no pattern ends at a state.
+
+        FindReplacePairV
+                        m_vFindReplaces;        // Values to replace and their replacement values.
+        StateV          m_vStates;              // States of the automaton; the first one is the root.
+
+        size_t          NextState(size_t p_State,
+                                  const wchar_t p_Char) const;
     };
 
     //
@@ -206,30 +320,205 @@ namespace PCC
     class RegexPipelineElement : public PipelineElement
     {
     public:
+        // Regex engines that can be used to perform lookups.
+        enum class Engine {
+            Standard    = 0,    // std::wregex
+            Fast        = 1,    // FastRegex, falling back to std::wregex if unsupported
+        };
+
                         RegexPipelineElement(const std::wstring& p_Regex,
                                              const std::wstring& p_Format,
-                                             const bool p_IgnoreCase);
+                                             const bool p_IgnoreCase,
+                                             const Engine p_Engine = Engine::Standard);
                         RegexPipelineElement(const RegexPipelineElement&) = delete;
         RegexPipelineElement&
                         operator=(const RegexPipelineElement&) = delete;
 
         virtual void    ModifyPath(std::wstring& p_rPath,
-                                   const PluginProvider* const p_pPluginProvider) const override;
+                                   const ConversionContext& p_Context) const override;
+        virtual void    ModifyPaths(WStringV& p_rvPaths,
+                                    const ConversionContext& p_Context) const override;
         virtual bool    ShouldBeEnabledFor(const std::wstring& p_ParentPath,
                                            const std::wstring& p_File,
-                                           const PluginProvider* const p_pPluginProvider) const override;
+                                           const ConversionContext& p_Context) const override;
 
     private:
         std::wstring    m_Regex;        // Regex to use to find matches.
         std::wstring    m_Format;       // Format of replacement string.
         bool            m_IgnoreCase;   // Whether to ignore case when looking for matches.
-        mutable std::unique_ptr<std::wregex>
-                        m_upRegex;      // Regex object to use to perform lookups.
-        mutable bool    m_RegexTested;  // true if we tried to create m_upRegex.
+        Engine          m_Engine;       // Regex engine to use.
+        std::wstring    m_RequiredLiteral;  // Literal that must be found in paths for the regex to match, if any.
+        mutable RegexCache::WRegexSP
+                        m_spRegex;      // Regex object to use to perform lookups. Shared via RegexCache.
+        mutable RegexCache::FastRegexSP
+                        m_spFastRegex;  // FastRegex object to use instead of m_spRegex, if supported.
+        mutable std::once_flag
+                        m_RegexInit;    // Flag used to fetch m_spRegex only once, even across threads.
 
         void            InitRegex() const;
     };
 
+    //
+    // PrefixMappingPipelineElement
+    //
+    // Pipeline element that replaces the longest prefix of the path
+    // found in a mapping table. The table can be stored in the element
+    // itself, in a file or in the registry (see PrefixMap).
+    //
+    class PrefixMappingPipelineElement : public PipelineElement
+    {
+    public:
+                        PrefixMappingPipelineElement(const PrefixMap::Source p_Source,
+                                                     const std::wstring& p_Table,
+                                                     const bool p_IgnoreCase);
+                        PrefixMappingPipelineElement(const PrefixMappingPipelineElement&) = delete;
+        PrefixMappingPipelineElement&
+                        operator=(const PrefixMappingPipelineElement&) = delete;
+
+        virtual void    ModifyPath(std::wstring& p_rPath,
+                                   const ConversionContext& p_Context) const override;
+        virtual void    ModifyPaths(WStringV& p_rvPaths,
+                                    const ConversionContext& p_Context) const override;
+
+    private:
+        PrefixMap::Source
+                        m_Source;       // Source of the mapping table.
+        std::wstring    m_Table;        // Table contents, or its location if not stored inline.
+        bool            m_IgnoreCase;   // Whether to ignore case when looking for prefixes.
+        mutable PrefixMap::PrefixMapSP
+                        m_spPrefixMap;  // Mapping table. Shared via PrefixMap::GetPrefixMap.
+        mutable std::once_flag
+                        m_PrefixMapInit;    // Flag used to load m_spPrefixMap only once, even across threads.
+
+        void            InitPrefixMap() const;
+    };
+
+    //
+    // EnvironmentVariablesPipelineElement
+    //
+    // Pipeline element that replaces the beginning of the path with the
+    // environment variable containing it, like %APPDATA%, to make the path
+    // portable across machines. The longest match wins, so a path under
+    // %APPDATA% is not replaced with %USERPROFILE% (see EnvironmentVariablesCache).
+    //
+    class EnvironmentVariablesPipelineElement : public PipelineElement
+    {
+    public:
+                        EnvironmentVariablesPipelineElement();
+                        EnvironmentVariablesPipelineElement(const EnvironmentVariablesPipelineElement&) = delete;
+        EnvironmentVariablesPipelineElement&
+                        operator=(const EnvironmentVariablesPipelineElement&) = delete;
+
+        virtual void    ModifyPath(std::wstring& p_rPath,
+                                   const ConversionContext& p_Context) const override;
+        virtual void    ModifyPaths(WStringV& p_rvPaths,
+                                    const ConversionContext& p_Context) const override;
+
+    private:
+        static void     ReplaceVariable(std::wstring& p_rPath,
+                                        const PrefixMap& p_PrefixMap);
+    };
+
+    //
+    // ContentHashPipelineElement
+    //
+    // Pipeline element that prepends the SHA-256 hash of the file's content
+    // to the path, in the format used by sha256sum: "<hash>  <path>". The
+    // file is read from the path as it is when it reaches the element, so
+    // the element must come after elements producing a path that can be
+    // opened on this computer. Paths of folders or of files that cannot
+    // be read are left unchanged. See FileHasher.
+    //
+    class ContentHashPipelineElement : public PipelineElement
+    {
+    public:
+                        ContentHashPipelineElement();
+                        ContentHashPipelineElement(const ContentHashPipelineElement&) = delete;
+        ContentHashPipelineElement&
+                        operator=(const ContentHashPipelineElement&) = delete;
+
+        virtual void    ModifyPath(std::wstring& p_rPath,
+                                   const ConversionContext& p_Context) const override;
+        virtual void    ModifyPaths(WStringV& p_rvPaths,
+                                    const ConversionContext& p_Context) const override;
+        virtual PluginCost
+                        CostClass(const ConversionContext& p_Context) const override;
+    };
+
+    //
+    // UnicodeNormalizationPipelineElement
+    //
+    // Pipeline element that converts the path to a Unicode normalization
+    // form (NFC or NFD), for servers that compare paths byte-per-byte like
+    // Samba on Linux. Paths containing only ASCII characters are returned
+    // as-is. See UnicodeNormalizer.
+    //
+    class UnicodeNormalizationPipelineElement : public PipelineElement
+    {
+    public:
+        explicit        UnicodeNormalizationPipelineElement(const NormalizationForm p_Form);
+                        UnicodeNormalizationPipelineElement(const UnicodeNormalizationPipelineElement&) = delete;
+        UnicodeNormalizationPipelineElement&
+                        operator=(const UnicodeNormalizationPipelineElement&) = delete;
+
+        virtual void    ModifyPath(std::wstring& p_rPath,
+                                   const ConversionContext& p_Context) const override;
+
+    private:
+        NormalizationForm
+                        m_Form;         // Normalization form to convert paths to.
+    };
+
+    //
+    // GuardPipelineElement
+    //
+    // Pipeline element that checks whether the path starts with or contains
+    // a literal value. Paths that fail the check skip the rest of the
+    // pipeline: they are either copied as they are at that point, or the
+    // plugin is disabled for them. The element itself never modifies paths;
+    // guards are handled by Pipeline.
+    //
+    // Note: the plugin can only be disabled by guards that are not preceded
+    // by other elements, since they are checked against the selected file.
+    //
+    class GuardPipelineElement : public PipelineElement
+    {
+    public:
+        // How paths are compared with the guard's value.
+        enum class Match {
+            Prefix      = 1,    // Path must start with value.
+            Contains    = 2,    // Path must contain value.
+        };
+
+        // What to do with paths that fail the check.
+        enum class Action {
+            Skip        = 1,    // Skip rest of pipeline; path is copied as-is.
+            Disable     = 2,    // Skip rest of pipeline and disable plugin.
+        };
+
+                        GuardPipelineElement(const std::wstring& p_Value,
+                                             const Match p_Match,
+                                             const bool p_IgnoreCase,
+                                             const Action p_Action);
+                        GuardPipelineElement(const GuardPipelineElement&) = delete;
+        GuardPipelineElement&
+                        operator=(const GuardPipelineElement&) = delete;
+
+        virtual void    ModifyPath(std::wstring& p_rPath,
+                                   const ConversionContext& p_Context) const override;
+        virtual void    ModifyPaths(WStringV& p_rvPaths,
+                                    const ConversionContext& p_Context) const override;
+
+        bool            Passes(const std::wstring& p_Path) const;
+        Action          GetAction() const;
+
+    private:
+        std::wstring    m_Value;        // Value to look for in paths.
+        Match           m_Match;        // How to look for m_Value.
+        bool            m_IgnoreCase;   // Whether to ignore case when looking for m_Value.
+        Action          m_Action;       // What to do with paths that do not match.
+    };
+
     //
     // ApplyPluginPipelineElement
     //
@@ -245,15 +534,66 @@ namespace PCC
                         operator=(const ApplyPluginPipelineElement&) = delete;
 
         virtual void    ModifyPath(std::wstring& p_rPath,
-                                   const PluginProvider* const p_pPluginProvider) const override;
+                                   const ConversionContext& p_Context) const override;
         virtual bool    ShouldBeEnabledFor(const std::wstring& p_ParentPath,
                                            const std::wstring& p_File,
-                                           const PluginProvider* const p_pPluginProvider) const override;
+                                           const ConversionContext& p_Context) const override;
+        virtual void    GetReferencedPlugins(GUIDV& p_rvPluginIds) const override;
+        virtual PluginCost
+                        CostClass(const ConversionContext& p_Context) const override;
 
     private:
         GUID            m_PluginId;     // ID of plugin to apply.
     };
 
+    //
+    // TemplatePipelineElement
+    //
+    // Pipeline element that replaces the path with a format template
+    // combining literal text and the outputs of other plugins, for example
+    // "{plugin:<id1>} -> {plugin:<id2>}". {path} is replaced by the path
+    // as it was before the element; {{ and }} produce literal braces.
+    //
+    // The template is compiled once when the element is created. Each
+    // referenced plugin is applied only once per path, even if it is used
+    // by several placeholders.
+    //
+    class TemplatePipelineElement : public PipelineElement
+    {
+    public:
+        explicit        TemplatePipelineElement(const std::wstring& p_Template);
+                        TemplatePipelineElement(const TemplatePipelineElement&) = delete;
+        TemplatePipelineElement&
+                        operator=(const TemplatePipelineElement&) = delete;
+
+        virtual void    ModifyPath(std::wstring& p_rPath,
+                                   const ConversionContext& p_Context) const override;
+        virtual bool    ShouldBeEnabledFor(const std::wstring& p_ParentPath,
+                                           const std::wstring& p_File,
+                                           const ConversionContext& p_Context) const override;
+        virtual void    GetReferencedPlugins(GUIDV& p_rvPluginIds) const override;
+        virtual PluginCost
+                        CostClass(const ConversionContext& p_Context) const override;
+
+    private:
+        // Index of placeholder used for the path before the element.
+        static const size_t
+                        PATH_PLACEHOLDER = static_cast<size_t>(-1);
+
+        // Part of a compiled template.
+        struct Part {
+            std::wstring    m_Literal;      // Literal text to output before the placeholder.
+            size_t          m_Placeholder;  // Index of plugin in m_vPluginIds, or PATH_PLACEHOLDER.
+        };
+
+        GUIDV           m_vPluginIds;   // IDs of plugins referenced by the template, without duplicates.
+        std::vector<Part>
+                        m_vParts;       // Parts of the compiled template.
+        std::wstring    m_Suffix;       // Literal text found after the last placeholder.
+
+        void            Compile(const std::wstring& p_Template);
+    };
+
     //
     // PathsSeparatorPipelineElement
     //
@@ -269,7 +609,7 @@ namespace PCC
                         operator=(const PathsSeparatorPipelineElement&) = delete;
 
         virtual void    ModifyPath(std::wstring& p_rPath,
-                                   const PluginProvider* const p_pPluginProvider) const override;
+                                   const ConversionContext& p_Context) const override;
         virtual void    ModifyOptions(PipelineOptions& p_rOptions) const override;
 
     private:
@@ -292,7 +632,7 @@ namespace PCC
                         operator=(const ExecutablePipelineElement&) = delete;
 
         virtual void    ModifyPath(std::wstring& p_rPath,
-                                   const PluginProvider* const p_pPluginProvider) const override;
+                                   const ConversionContext& p_Context) const override;
         virtual void    ModifyOptions(PipelineOptions& p_rOptions) const override;
 
     private:
@@ -309,12 +649,165 @@ namespace PCC
     class ExecutableWithFilelistPipelineElement : public ExecutablePipelineElement
     {
     public:
-        explicit        ExecutableWithFilelistPipelineElement(const std::wstring& p_Executable);
+        typedef Actions::LaunchExecutablePathAction::FilelistEncoding FilelistEncoding;
+        typedef Actions::LaunchExecutablePathAction::FilelistDelivery FilelistDelivery;
+
+        explicit        ExecutableWithFilelistPipelineElement(const std::wstring& p_Executable,
+                                                              const FilelistEncoding p_FilelistEncoding = FilelistEncoding::Ansi,
+                                                              const FilelistDelivery p_FilelistDelivery = FilelistDelivery::TempFile);
                         ExecutableWithFilelistPipelineElement(const ExecutableWithFilelistPipelineElement&) = delete;
         ExecutableWithFilelistPipelineElement&
                         operator=(const ExecutableWithFilelistPipelineElement&) = delete;
 
         virtual void    ModifyOptions(PipelineOptions& p_rOptions) const override;
+
+    private:
+        FilelistEncoding
+                        m_FilelistEncoding; // Encoding of filelist.
+        FilelistDelivery
+                        m_FilelistDelivery; // How filelist is delivered to executable.
+    };
+
+    //
+    // CopyMultipleFormatsPipelineElement
+    //
+    // Pipeline element that does not modify the path but instructs
+    // Path Copy Copy to copy paths to the clipboard in multiple formats
+    // at once (text, HTML links and files).
+    //
+    class CopyMultipleFormatsPipelineElement : public PipelineElement
+    {
+    public:
+                        CopyMultipleFormatsPipelineElement();
+                        CopyMultipleFormatsPipelineElement(const CopyMultipleFormatsPipelineElement&) = delete;
+        CopyMultipleFormatsPipelineElement&
+                        operator=(const CopyMultipleFormatsPipelineElement&) = delete;
+
+        virtual void    ModifyPath(std::wstring& p_rPath,
+                                   const ConversionContext& p_Context) const override;
+        virtual void    ModifyOptions(PipelineOptions& p_rOptions) const override;
+    };
+
+    //
+    // MemoizePipelineElement
+    //
+    // Pipeline element that does not modify the path but instructs
+    // Path Copy Copy to cache the paths returned by the pipeline and
+    // reuse them for the same files until settings change. Only meant
+    // for pipelines whose result depends solely on the input path.
+    //
+    class MemoizePipelineElement : public PipelineElement
+    {
+    public:
+                        MemoizePipelineElement();
+                        MemoizePipelineElement(const MemoizePipelineElement&) = delete;
+        MemoizePipelineElement&
+                        operator=(const MemoizePipelineElement&) = delete;
+
+        virtual void    ModifyPath(std::wstring& p_rPath,
+                                   const ConversionContext& p_Context) const override;
+        virtual void    ModifyOptions(PipelineOptions& p_rOptions) const override;
+    };
+
+    //
+    // BatchExecutablePipelineElement
+    //
+    // Pipeline element that does not modify the path but instructs
+    // Path Copy Copy to split paths in batches that fit on a command line
+    // when launching an executable, launching it once per batch.
+    //
+    class BatchExecutablePipelineElement : public PipelineElement
+    {
+    public:
+        explicit        BatchExecutablePipelineElement(const size_t p_MaxParallelBatches);
+                        BatchExecutablePipelineElement(const BatchExecutablePipelineElement&) = delete;
+        BatchExecutablePipelineElement&
+                        operator=(const BatchExecutablePipelineElement&) = delete;
+
+        virtual void    ModifyPath(std::wstring& p_rPath,
+                                   const ConversionContext& p_Context) const override;
+        virtual void    ModifyOptions(PipelineOptions& p_rOptions) const override;
+
+    private:
+        size_t          m_MaxParallelBatches;   // Max number of batches to run at once.
+    };
+
+    //
+    // RunningInstancePipelineElement
+    //
+    // Pipeline element that does not modify the path but instructs
+    // Path Copy Copy to send paths to a running instance of the executable
+    // to launch, if it can be reached, instead of launching a new one.
+    //
+    class RunningInstancePipelineElement : public PipelineElement
+    {
+    public:
+        typedef Actions::LaunchExecutablePathAction::InstanceEndpoint InstanceEndpoint;
+
+                        RunningInstancePipelineElement(const InstanceEndpoint p_Endpoint,
+                                                       const std::wstring& p_EndpointName);
+                        RunningInstancePipelineElement(const RunningInstancePipelineElement&) = delete;
+        RunningInstancePipelineElement&
+                        operator=(const RunningInstancePipelineElement&) = delete;
+
+        virtual void    ModifyPath(std::wstring& p_rPath,
+                                   const ConversionContext& p_Context) const override;
+        virtual void    ModifyOptions(PipelineOptions& p_rOptions) const override;
+
+    private:
+        InstanceEndpoint
+                        m_Endpoint;             // Type of endpoint used to reach running instance.
+        std::wstring    m_EndpointName;         // Name of pipe or window class of running instance.
+    };
+
+    //
+    // OutputFilePipelineElement
+    //
+    // Pipeline element that does not modify the path but instructs
+    // Path Copy Copy to write paths to a file instead of copying them
+    // to the clipboard. Meant for very large selections.
+    //
+    class OutputFilePipelineElement : public PipelineElement
+    {
+    public:
+        typedef Actions::LaunchExecutablePathAction::FilelistEncoding OutputEncoding;
+
+                        OutputFilePipelineElement(const std::wstring& p_OutputFile,
+                                                  const OutputEncoding p_Encoding);
+                        OutputFilePipelineElement(const OutputFilePipelineElement&) = delete;
+        OutputFilePipelineElement&
+                        operator=(const OutputFilePipelineElement&) = delete;
+
+        virtual void    ModifyPath(std::wstring& p_rPath,
+                                   const ConversionContext& p_Context) const override;
+        virtual void    ModifyOptions(PipelineOptions& p_rOptions) const override;
+
+    private:
+        std::wstring    m_OutputFile;           // Path of file to write paths to (empty to let user choose).
+        OutputEncoding  m_Encoding;             // Encoding of output file.
+    };
+
+    //
+    // ExportMetadataPipelineElement
+    //
+    // Pipeline element that does not modify the path but instructs
+    // Path Copy Copy to output paths as CSV or JSON records including
+    // the size, timestamps and attributes of their files.
+    //
+    class ExportMetadataPipelineElement : public PipelineElement
+    {
+    public:
+        explicit        ExportMetadataPipelineElement(const ExportFormat p_Format);
+                        ExportMetadataPipelineElement(const ExportMetadataPipelineElement&) = delete;
+        ExportMetadataPipelineElement&
+                        operator=(const ExportMetadataPipelineElement&) = delete;
+
+        virtual void    ModifyPath(std::wstring& p_rPath,
+                                   const ConversionContext& p_Context) const override;
+        virtual void    ModifyOptions(PipelineOptions& p_rOptions) const override;
+
+    private:
+        ExportFormat    m_Format;               // Format of exported records.
     };
 
 } // namespace PCC
@@ -0,0 +1,57 @@
+// PluginPipelineOptimizer.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include "PathCopyCopyPrivateTypes.h"
+
+
+namespace PCC
+{
+    //
+    // PipelineOptimizer
+    //
+    // Utility class that rewrites a decoded pipeline to make it faster
+    // to execute, without changing its semantics. Adjacent elements that
+    // each replace a character with another are fused into a single
+    // table-driven pass and adjacent literal find/replace elements that
+    // cannot interact with each other are fused into a single multi-pattern
+    // replacement.
+    //
+    class PipelineOptimizer final
+    {
+    public:
+                        PipelineOptimizer() = delete;
+                        ~PipelineOptimizer() = delete;
+
+        static void     OptimizePipeline(PipelineElementSPV& p_rvspElements);
+
+    private:
+        static void     FlushCharMaps(PipelineElementSPV& p_rvspPending,
+                                      PipelineElementSPV& p_rvspElements);
+        static void     FlushFindReplaces(PipelineElementSPV& p_rvspPending,
+                                          PipelineElementSPV& p_rvspElements);
+        static bool     CanFuseFindReplace(const PipelineElementSPV& p_vspPending,
+                                           const PipelineElementSP& p_spElement);
+    };
+
+} // namespace PCC
@@ -23,6 +23,8 @@
 
 #include "PathCopyCopyPrivateTypes.h"
 
+#include <string>
+
 
 namespace PCC
 {
@@ -37,6 +39,9 @@ namespace PCC
         virtual         ~PluginProvider();
 
         virtual PluginSP GetPlugin(const GUID& p_PluginId) const = 0;
+        virtual bool    GetPathWithPlugin(const GUID& p_PluginId,
+                                          std::wstring& p_rPath,
+                                          const ConversionContext& p_Context) const;
     };
 
 } // namespace PCC
@@ -40,8 +40,9 @@ namespace PCC
         PluginSeparator&            operator=(const PluginSeparator&) = delete;
 
         virtual const GUID&         Id() const override;
-        virtual std::wstring        Description() const override;
-        virtual std::wstring        GetPath(const std::wstring& p_File) const override;
+        virtual std::wstring        Description(const ConversionContext& p_Context) const override;
+        virtual std::wstring        GetPath(const std::wstring& p_File,
+                                            const ConversionContext& p_Context) const override;
         virtual bool                IsSeparator() const override;
     };
 
@@ -0,0 +1,103 @@
+// PluginSet.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include "PathCopyCopyPrivateTypes.h"
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include <windows.h>
+
+
+namespace PCC
+{
+    //
+    // PluginSet
+    //
+    // Set of plugins stored in shared pointers, ordered by plugin ID. Plugins are
+    // stored contiguously in a sorted vector, so lookups by ID are binary searches
+    // without pointer chasing and building the set performs a single allocation.
+    // Offers the subset of the std::set interface used with plugins; like std::set,
+    // inserting a plugin whose ID is already in the set has no effect.
+    //
+    class PluginSet final
+    {
+    public:
+        typedef std::vector<PluginSP>::const_iterator const_iterator;
+        typedef const_iterator iterator;
+
+                        PluginSet();
+
+                        //
+                        // Constructor with a range of plugins.
+                        //
+                        // @param p_First Beginning of range of plugins.
+                        // @param p_Last End of range of plugins.
+                        //
+                        template<typename InputIt>
+                        PluginSet(InputIt p_First,
+                                  InputIt p_Last)
+                            : m_vspPlugins(p_First, p_Last)
+                        {
+                            Normalize();
+                        }
+
+        const_iterator  begin() const;
+        const_iterator  end() const;
+        const_iterator  cbegin() const;
+        const_iterator  cend() const;
+        size_t          size() const;
+        bool            empty() const;
+
+        const_iterator  find(const GUID& p_PluginId) const;
+        const_iterator  find(const PluginSP& p_spPlugin) const;
+
+        std::pair<const_iterator, bool>
+                        insert(const PluginSP& p_spPlugin);
+
+                        //
+                        // Inserts a range of plugins in the set. Plugins whose
+                        // ID is already in the set are ignored.
+                        //
+                        // @param p_First Beginning of range of plugins.
+                        // @param p_Last End of range of plugins.
+                        //
+                        template<typename InputIt>
+        void            insert(InputIt p_First,
+                               InputIt p_Last)
+                        {
+                            m_vspPlugins.insert(m_vspPlugins.end(), p_First, p_Last);
+                            Normalize();
+                        }
+
+        void            clear();
+
+    private:
+        std::vector<PluginSP>
+                        m_vspPlugins;       // Plugins, sorted by ID.
+
+        void            Normalize();
+    };
+
+} // namespace PCC
@@ -0,0 +1,158 @@
+// PluginStatistics.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include "PathCopyCopyPrivateTypes.h"
+
+#include <chrono>
+#include <map>
+#include <mutex>
+
+#include <atlbase.h>
+#include <windows.h>
+
+
+namespace PCC
+{
+    //
+    // PluginStatistics
+    //
+    // Process-wide record of how long plugins take to determine if they are
+    // enabled and to compute paths, and of how often they fail. Statistics are
+    // accumulated in memory and merged in the registry in the background when
+    // Save is called, so that the settings app can show which plugins are slow. For each plugin,
+    // the registry keeps call and failure counts along with the durations of
+    // the last MAX_SAMPLES calls, from which percentiles can be computed,
+    // and how often its paths were found in the PathResultCache.
+    // We also count how often building the contextual menu exceeds its
+    // time budget.
+    //
+    class PluginStatistics final
+    {
+    public:
+        // Plugin operations for which we keep statistics.
+        enum class Operation {
+            Enabled,
+            GetPath,
+        };
+
+        static const size_t
+                        MAX_SAMPLES;        // Maximum number of durations kept per plugin and operation.
+
+                        PluginStatistics() = delete;
+                        ~PluginStatistics() = delete;
+
+                        //
+                        // Calls a plugin operation and records its duration. If the operation
+                        // throws an exception, it is recorded as a failure and rethrown.
+                        //
+                        // @param p_PluginId ID of plugin performing the operation.
+                        // @param p_Operation Operation performed.
+                        // @param p_Func Function that performs the operation.
+                        // @param p_Count Number of items processed by the operation (for
+                        //                example, number of paths computed). The recorded
+                        //                duration is the average duration per item.
+                        // @return Result of p_Func.
+                        //
+        template<typename F>
+        static auto     Measure(const GUID& p_PluginId,
+                                const Operation p_Operation,
+                                F p_Func,
+                                const size_t p_Count = 1) -> decltype(p_Func())
+                        {
+                            const auto start = std::chrono::steady_clock::now();
+                            try {
+                                auto result = p_Func();
+                                Record(p_PluginId, p_Operation, std::chrono::duration_cast<std::chrono::microseconds>(
+                                    std::chrono::steady_clock::now() - start), p_Count, false);
+                                return result;
+                            } catch (...) {
+                                Record(p_PluginId, p_Operation, std::chrono::duration_cast<std::chrono::microseconds>(
+                                    std::chrono::steady_clock::now() - start), p_Count, true);
+                                throw;
+                            }
+                        }
+
+        static void     Record(const GUID& p_PluginId,
+                               const Operation p_Operation,
+                               const std::chrono::microseconds p_Duration,
+                               const size_t p_Count,
+                               const bool p_Failed);
+        static void     RecordPathCacheLookups(const GUID& p_PluginId,
+                                               const size_t p_Hits,
+                                               const size_t p_Misses);
+        static void     RecordMenu(const bool p_BudgetExceeded);
+        static void     Save();
+
+    private:
+        // Statistics recorded for one operation of a plugin.
+        struct OperationStatistics {
+            DWORD       m_Count;            // Number of calls.
+            DWORD       m_Failures;         // Number of calls that failed.
+            UInt32V     m_vDurations;       // Durations of calls, in microseconds.
+
+                        OperationStatistics()
+                            : m_Count(0), m_Failures(0), m_vDurations() { }
+        };
+
+        // Statistics recorded for a plugin.
+        struct Statistics {
+            OperationStatistics
+                        m_Enabled;          // Statistics of calls to Enabled.
+            OperationStatistics
+                        m_GetPath;          // Statistics of calls to GetPath.
+            DWORD       m_PathCacheHits;    // Number of paths found in the PathResultCache.
+            DWORD       m_PathCacheMisses;  // Number of paths looked up in the PathResultCache but not found.
+
+                        Statistics()
+                            : m_Enabled(), m_GetPath(), m_PathCacheHits(0), m_PathCacheMisses(0) { }
+        };
+        typedef std::map<GUID, Statistics, GUIDLess> StatisticsM;
+
+        // Statistics waiting to be merged in the registry.
+        struct PendingStatistics {
+            StatisticsM m_mStatistics;      // Statistics per plugin ID.
+            DWORD       m_MenuCount;        // Number of menus built.
+            DWORD       m_MenuBudgetExceededCount;  // Number of menus that exceeded their time budget.
+
+                        PendingStatistics()
+                            : m_mStatistics(), m_MenuCount(0), m_MenuBudgetExceededCount(0) { }
+        };
+
+        static StatisticsM
+                        s_mStatistics;      // Statistics not saved yet, per plugin ID.
+        static DWORD    s_MenuCount;        // Number of menus built since last save.
+        static DWORD    s_MenuBudgetExceededCount;  // Number of menus that exceeded their time budget since last save.
+        static std::mutex
+                        s_Lock;             // Lock protecting the statistics.
+
+        static void     SaveToRegistry(const PendingStatistics& p_Pending);
+        static void     SaveOperation(ATL::CRegKey& p_rKey,
+                                      const wchar_t* const p_pPrefix,
+                                      const OperationStatistics& p_Statistics);
+        static void     SaveCounter(ATL::CRegKey& p_rKey,
+                                    const wchar_t* const p_pName,
+                                    const DWORD p_Count);
+    };
+
+} // namespace PCC
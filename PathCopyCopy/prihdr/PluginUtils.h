@@ -23,11 +23,13 @@
 
 #include "PathCopyCopyPrivateTypes.h"
 #include "RegKey.h"
+#include "ShareIndex.h"
 
+#include <map>
 #include <mutex>
-#include <regex>
 #include <string>
 
+#include <atlbase.h>
 #include <windows.h>
 
 
@@ -44,27 +46,48 @@ namespace PCC
                         PluginUtils() = delete;
                         ~PluginUtils() = delete;
 
-        static bool     IsDirectory(const std::wstring& p_Path);
+        static bool     IsDirectory(const std::wstring& p_Path,
+                                    FileMetadataCache* const p_pMetadataCache);
 
         static bool     ExtractFolderFromPath(std::wstring& p_rPath);
 
+        static std::wstring
+                        GetShortPath(const std::wstring& p_Path,
+                                     FileMetadataCache* const p_pMetadataCache);
+        static std::wstring
+                        GetLongPath(const std::wstring& p_Path,
+                                    FileMetadataCache* const p_pMetadataCache);
+        static std::wstring
+                        GetDroppedFile(HDROP const p_hDrop,
+                                       const UINT p_Index);
+
         static bool     IsUNCPath(const std::wstring& p_FilePath);
         static bool     GetMappedDriveFilePath(std::wstring& p_rFilePath);
         static bool     GetNetworkShareFilePath(std::wstring& p_rFilePath,
                                                 const bool p_UseHiddenShares);
         static bool     GetHiddenDriveShareFilePath(std::wstring& p_rFilePath);
-        static void     ConvertUNCHostToFQDN(std::wstring& p_rFilePath);
         static const std::wstring&
                         GetLocalComputerName();
+        static std::wstring
+                        GetCurrentUserSid();
+        static std::wstring
+                        GetProcessUserSid(HANDLE p_hProcess);
+        static void     FlushNetworkCaches();
+        static void     PrewarmNetworkCaches();
 
         static long     ReadRegistryStringValue(const RegKey& p_Key,
                                                 const wchar_t* const p_pValueName,
                                                 std::wstring& p_rValue);
+        static long     ReadRegistryBinaryStringValue(const RegKey& p_Key,
+                                                      const wchar_t* const p_pValueName,
+                                                      std::wstring& p_rValue);
+        static bool     ReadText(HANDLE const p_hInput,
+                                 std::wstring& p_rText);
 
         static std::wstring
                         GetMultiStringLineBeginningWith(const std::wstring& p_MultiStringValue,
                                                         const std::wstring& p_Prefix);
-        static GUIDV    StringToPluginIds(std::wstring& p_rPluginIdsAsString,
+        static GUIDV    StringToPluginIds(const std::wstring& p_PluginIdsAsString,
                                           const wchar_t p_Separator);
         static UInt32V  StringToUInt32s(std::wstring& p_rUInt32sAsString,
                                         const wchar_t p_Separator);
@@ -75,17 +98,45 @@ namespace PCC
                         UInt32sToString(const UInt32V& p_vUInt32s,
                                         const wchar_t p_Separator);
 
-        static bool     IsPluginShown(const Settings& p_Settings,
-                                      const GUID& p_PluginId);
+        static GUIDS    GetShownPlugins(const Settings& p_Settings);
+
+        static std::wstring
+                        GetPathCached(const Plugin& p_Plugin,
+                                      const std::wstring& p_File,
+                                      const ConversionContext& p_Context);
+        static WStringV GetPathsInParallel(const Plugin& p_Plugin,
+                                           const FilesV& p_vFiles,
+                                           const ConversionContext& p_Context);
 
     private:
+        // Cached network path of the root of a mapped drive.
+        struct DriveUNCRoot {
+            std::wstring    m_UNCRoot;      // Network path of drive root, or empty if drive is not mapped.
+            DWORD           m_Timestamp;    // Tick count when network path was looked up.
+        };
+        typedef std::map<wchar_t, DriveUNCRoot> DriveUNCRootM;
+
         static std::mutex
                         s_Lock;                     // Mutex to protect member access.
         static std::wstring
                         s_ComputerName;             // Name of local computer.
         static bool     s_HasComputerName;          // Whether we have precomputed the computer name.
-        static std::wregex
-                        s_HiddenDriveShareRegex;    // Regex used to perform conversion of hidden drive shares.
+        static ShareIndexSP
+                        s_spShareIndex;             // Index of network shares of the local computer; only accessed atomically.
+        static std::mutex
+                        s_ShareIndexLock;           // Mutex held while rebuilding the index of network shares.
+        static std::mutex
+                        s_DrivesLock;               // Mutex to protect mapped drives info.
+        static DriveUNCRootM
+                        s_mDriveUNCRoots;           // Cached network paths of mapped drives, per drive letter.
+        static DWORD    s_LogicalDrives;            // Logical drives bitmask when s_mDriveUNCRoots was last validated.
+
+        static bool     GetMappedDriveUNCRoot(const wchar_t p_Drive,
+                                              std::wstring& p_rUNCRoot);
+        static bool     GetUniversalName(std::wstring& p_rFilePath);
+
+        static ShareIndexSP
+                        GetShareIndex();
     };
 
 } // namespace PCC
@@ -0,0 +1,139 @@
+// PluginsSnapshot.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include "AllPluginsProvider.h"
+#include "ConversionContext.h"
+#include "MeasuredMutex.h"
+#include "PathCopyCopyPrivateTypes.h"
+#include "Plugin.h"
+#include "SettingsSnapshot.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <atlbase.h>
+#include <windows.h>
+
+
+namespace PCC
+{
+    //
+    // PluginsSnapshot
+    //
+    // Immutable snapshot of all PCC plugins, along with the settings and plugin
+    // provider objects to use with them (see GetConversionContext) and the
+    // plugins to display in the menus. Snapshots are cached process-wide and
+    // shared by all contextual menu extension instances; the cache is
+    // invalidated when the PathCopyCopy registry keys change (see RegistryWatcher).
+    //
+    // Because COM plugin instances are bound to the apartment that created them
+    // and because Settings is not thread-safe, a separate snapshot is cached for
+    // every thread that requests one. The SettingsSnapshot it contains, however,
+    // is immutable and can be used by worker threads converting paths. Since a
+    // thread's cached snapshot is only replaced by that thread, it is found
+    // through a thread-local slot without locking.
+    //
+    class PluginsSnapshot final : public std::enable_shared_from_this<PluginsSnapshot>
+    {
+    public:
+        static PluginsSnapshotSP
+                        Get();
+        static PluginsSnapshotSP
+                        GetForPlugin(const GUID& p_PluginId);
+        static void     ReleaseUnused();
+
+        explicit        PluginsSnapshot(const ULONG p_Generation);
+                        PluginsSnapshot(const ULONG p_Generation,
+                                        const GUID& p_PluginId);
+                        PluginsSnapshot(const PluginsSnapshot&) = delete;
+        PluginsSnapshot&
+                        operator=(const PluginsSnapshot&) = delete;
+
+        ULONG           GetGeneration() const;
+        Settings&       GetSettings() const;
+        const SettingsSnapshot&
+                        GetSettingsSnapshot() const;
+        const PluginSPV&
+                        GetPluginsInDefaultOrder() const;
+        const PluginSPS&
+                        GetAllPlugins() const;
+        const PluginProvider&
+                        GetPluginProvider() const;
+        const ConversionContext&
+                        GetConversionContext() const;
+        const GUIDV*    GetMainMenuPluginIds() const;
+        const PluginSPV&
+                        GetMainMenuPlugins() const;
+        const PluginSPV&
+                        GetSubmenuPlugins() const;
+        const std::wstring&
+                        GetHelpText(const Plugin& p_Plugin) const;
+
+        void            ClearCachedPaths() const;
+
+    private:
+        // Map of cached snapshots, per thread ID.
+        typedef std::map<DWORD, PluginsSnapshotSP> PluginsSnapshotM;
+
+        // Map of plugin help texts, per plugin ID.
+        typedef std::map<GUID, std::wstring, GUIDLess> HelpTextM;
+
+        ULONG           m_Generation;               // Generation of the settings at the time of creation.
+        ATL::CHandle    m_hOwnerThread;             // Handle to the thread that created this snapshot.
+        SettingsSP      m_spSettings;               // Settings object used with the plugins.
+        std::unique_ptr<const SettingsSnapshot>
+                        m_upSettingsSnapshot;       // Immutable copy of settings used during conversions.
+        PluginSPV       m_vspPluginsInDefaultOrder; // Vector of all plugins in default order.
+        PluginSPS       m_sspAllPlugins;            // Set containing all plugins.
+        AllPluginsProvider
+                        m_PluginProvider;           // Plugin provider wrapping our set of all plugins.
+        ConversionContext
+                        m_Context;                  // Context referencing our settings, settings snapshot and plugin provider.
+        bool            m_HasMainMenuPluginIds;     // Whether main menu plugins have been specified in the settings.
+        GUIDV           m_vMainMenuPluginIds;       // IDs of plugins to display in the main menu, as specified in the settings.
+        PluginSPV       m_vspMainMenuPlugins;       // Plugins to display in the main menu, in display order.
+        PluginSPV       m_vspSubmenuPlugins;        // Plugins to display in the submenu, in display order.
+        mutable HelpTextM
+                        m_mHelpTexts;               // Help texts of plugins, fetched when first needed.
+        mutable std::mutex
+                        m_HelpTextsLock;            // Lock protecting m_mHelpTexts.
+
+        static PluginsSnapshotM
+                        s_mspSnapshots;             // Cached snapshots, per thread ID.
+        static MeasuredMutex
+                        s_Lock;                     // Lock protecting the static members.
+
+                        PluginsSnapshot(const ULONG p_Generation,
+                                        const GUID* const p_pPluginId);
+
+        void            OrderPluginsToDisplay();
+
+        static PluginsSnapshotSP
+                        GetCached(ULONG& p_rGeneration);
+        static void     DropExitedThreadSnapshots(PluginsSnapshotM& p_rmspDropped);
+    };
+
+} // namespace PCC
@@ -0,0 +1,100 @@
+// PosixMountTable.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include "PrefixMap.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <windows.h>
+
+
+namespace PCC
+{
+    //
+    // PosixMountTable
+    //
+    // Immutable table of the mount points of a Cygwin or MSYS2 installation,
+    // used to convert Windows paths to the POSIX paths seen in that environment.
+    // Contains the mounts listed in the installation's /etc/fstab, the implicit
+    // mounts of the installation's root, /usr/bin and /usr/lib and the
+    // cygdrive mounts of all drive letters. Windows paths are looked up in
+    // a PrefixMap, so conversions take a time proportional to the path length.
+    //
+    // Tables are cached process-wide by Get; the cache checks periodically if
+    // the installation or its fstab changed and reloads the table if needed.
+    //
+    class PosixMountTable final
+    {
+    public:
+        // Environments that have mount tables.
+        enum class Environment {
+            Cygwin      = 0,
+            MSYS        = 1,
+        };
+
+        // Shared pointer to an immutable mount table.
+        typedef std::shared_ptr<const PosixMountTable> PosixMountTableSP;
+
+                        PosixMountTable(const std::wstring& p_RootDir,
+                                        const std::wstring& p_Fstab,
+                                        const std::wstring& p_DefaultCygdrivePrefix);
+                        PosixMountTable(const PosixMountTable&) = delete;
+        PosixMountTable&
+                        operator=(const PosixMountTable&) = delete;
+
+        bool            Apply(std::wstring& p_rPath) const;
+
+        static PosixMountTableSP
+                        Get(const Environment p_Environment);
+
+    private:
+        // Cached mount table of an environment.
+        struct Entry {
+            PosixMountTableSP
+                        m_spTable;          // Mount table, or nullptr if environment is not installed.
+            std::wstring
+                        m_RootDir;          // Root directory of the installation.
+            FILETIME    m_FstabTime;        // Last write time of fstab, or zero if not found.
+            DWORD       m_Timestamp;        // Tick count when entry was last validated.
+        };
+        typedef std::map<Environment, Entry> EntryM;
+
+        PrefixMap       m_Mounts;           // POSIX path of mount points, per Windows path.
+
+        static std::wstring
+                        BuildTable(const std::wstring& p_RootDir,
+                                   const std::wstring& p_Fstab,
+                                   const std::wstring& p_DefaultCygdrivePrefix);
+        static std::wstring
+                        FindRootDir(const Environment p_Environment);
+
+        static EntryM   s_mEntries;         // Cached mount tables, per environment.
+        static std::mutex
+                        s_Lock;             // Lock protecting the cache.
+    };
+
+} // namespace PCC
@@ -0,0 +1,127 @@
+// PrefixMap.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include "PathCopyCopyPrivateTypes.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+
+namespace PCC
+{
+    //
+    // PrefixMap
+    //
+    // Immutable table mapping path prefixes to replacement values. When
+    // applied to a path, replaces the longest prefix found in the table.
+    // Prefixes are stored in a trie, so lookups take a time proportional
+    // to the path's length, regardless of the number of entries.
+    //
+    // Tables are stored as text, one entry per line. Each line contains
+    // a prefix and its replacement, separated by a tab. Empty lines and
+    // lines starting with a semicolon are ignored. If a prefix appears
+    // more than once, its first replacement is used.
+    //
+    // Tables loaded from files or from the registry can be fetched via
+    // GetPrefixMap, which caches them process-wide so that they are loaded
+    // only once and shared between pipeline elements, plugins and threads.
+    // Tables are kept in the cache as long as they are in use, so they are
+    // loaded again when pipelines are. Tables stored in the registry are also
+    // loaded again when the settings change (see RegistryWatcher).
+    //
+    class PrefixMap final
+    {
+    public:
+        // Possible sources of a table.
+        enum class Source {
+            Inline      = 0,    // Table contents are stored directly in the pipeline.
+            File        = 1,    // Table is stored in a text file.
+            Registry    = 2,    // Table is stored in a string value in the PrefixMappings registry key.
+        };
+
+        // Shared pointer to an immutable prefix map.
+        typedef std::shared_ptr<const PrefixMap> PrefixMapSP;
+
+                        PrefixMap(const std::wstring& p_Table,
+                                  const bool p_IgnoreCase);
+                        PrefixMap(const PrefixMap&) = delete;
+        PrefixMap&      operator=(const PrefixMap&) = delete;
+
+        bool            Apply(std::wstring& p_rPath) const;
+        bool            Apply(std::wstring& p_rPath,
+                              std::wstring::size_type& p_rReplacementLength) const;
+
+        static PrefixMapSP
+                        GetPrefixMap(const Source p_Source,
+                                     const std::wstring& p_Table,
+                                     const bool p_IgnoreCase);
+
+    private:
+        // Node of the trie storing prefixes.
+        struct Node {
+            std::map<wchar_t, size_t>
+                        m_mChildren;        // Index of child node, per character.
+            size_t      m_Replacement;      // Index of replacement of prefix ending here, or NO_REPLACEMENT.
+        };
+        typedef std::vector<Node> NodeV;
+
+        // Key identifying a cached table: source, location and whether to ignore case.
+        typedef std::tuple<Source, std::wstring, bool> PrefixMapKey;
+
+        // Table cached in memory.
+        struct CachedPrefixMap {
+            std::weak_ptr<const PrefixMap>
+                        m_wpPrefixMap;      // Cached table; not kept alive by the cache.
+            ULONG       m_Generation;       // Settings generation when table was loaded from the registry, or 0.
+        };
+
+        // Map of cached tables, per key.
+        typedef std::map<PrefixMapKey, CachedPrefixMap> PrefixMapM;
+
+        static const size_t
+                        NO_REPLACEMENT;     // Value of Node::m_Replacement when no prefix ends at a node.
+
+        NodeV           m_vNodes;           // Nodes of the trie; the first one is the root.
+        WStringV        m_vReplacements;    // Replacement values, indexed by Node::m_Replacement.
+        bool            m_IgnoreCase;       // Whether to ignore case when looking for prefixes.
+
+        void            AddPrefix(const std::wstring& p_Prefix,
+                                  const std::wstring& p_Replacement);
+        wchar_t         GetKeyChar(const wchar_t p_Char) const;
+
+        static bool     ReadTable(const Source p_Source,
+                                  const std::wstring& p_Location,
+                                  std::wstring& p_rTable);
+
+        static PrefixMapM
+                        s_mspPrefixMaps;    // Cached tables loaded from files or from the registry.
+        static std::mutex
+                        s_Lock;             // Lock protecting the cache.
+    };
+
+} // namespace PCC
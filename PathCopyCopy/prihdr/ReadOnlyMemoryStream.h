@@ -0,0 +1,78 @@
+// ReadOnlyMemoryStream.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include <atlbase.h>
+#include <atlcom.h>
+#include <objidl.h>
+#include <windows.h>
+
+
+namespace PCC
+{
+    //
+    // ReadOnlyMemoryStream
+    //
+    // Read-only IStream implementation over a block of memory that it does
+    // not own, like a locked resource. Unlike CreateStreamOnHGlobal or
+    // SHCreateMemStream, the data is not copied, so the memory must remain
+    // valid for the lifetime of the stream.
+    //
+    class ATL_NO_VTABLE ReadOnlyMemoryStream :
+        public ATL::CComObjectRootEx<ATL::CComMultiThreadModel>,
+        public IStream
+    {
+    public:
+                        ReadOnlyMemoryStream();
+
+        BEGIN_COM_MAP(ReadOnlyMemoryStream)
+            COM_INTERFACE_ENTRY(IStream)
+            COM_INTERFACE_ENTRY(ISequentialStream)
+        END_COM_MAP()
+
+        static HRESULT  Create(const void* const p_pData,
+                               const ULONG p_Size,
+                               IStream** const p_ppStream);
+
+        // ISequentialStream methods
+        STDMETHOD(Read)(void* p_pBuffer, ULONG p_Size, ULONG* p_pRead);
+        STDMETHOD(Write)(const void* p_pBuffer, ULONG p_Size, ULONG* p_pWritten);
+
+        // IStream methods
+        STDMETHOD(Seek)(LARGE_INTEGER p_Move, DWORD p_Origin, ULARGE_INTEGER* p_pNewPosition);
+        STDMETHOD(SetSize)(ULARGE_INTEGER p_NewSize);
+        STDMETHOD(CopyTo)(IStream* p_pStream, ULARGE_INTEGER p_Size, ULARGE_INTEGER* p_pRead, ULARGE_INTEGER* p_pWritten);
+        STDMETHOD(Commit)(DWORD p_Flags);
+        STDMETHOD(Revert)();
+        STDMETHOD(LockRegion)(ULARGE_INTEGER p_Offset, ULARGE_INTEGER p_Size, DWORD p_LockType);
+        STDMETHOD(UnlockRegion)(ULARGE_INTEGER p_Offset, ULARGE_INTEGER p_Size, DWORD p_LockType);
+        STDMETHOD(Stat)(STATSTG* p_pStatStg, DWORD p_StatFlag);
+        STDMETHOD(Clone)(IStream** p_ppStream);
+
+    private:
+        const BYTE*     m_pData;        // Pointer to memory block.
+        ULONG           m_Size;         // Size of memory block, in bytes.
+        ULONG           m_Position;     // Current position in memory block.
+    };
+
+} // namespace PCC
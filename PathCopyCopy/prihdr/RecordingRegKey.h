@@ -0,0 +1,102 @@
+// RecordingRegKey.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include "RegKey.h"
+
+#include <atomic>
+
+#include <windows.h>
+
+
+//
+// RecordingRegKey
+//
+// Wrapper for another registry key that counts calls made to each of its
+// operations before forwarding them. Can be used to measure how many
+// registry round trips are needed to perform a task, for example
+// reading all settings needed to show our contextual menu. Like
+// MemoryRegKey, it is only built when PCC_BENCHMARKS is defined.
+//
+class RecordingRegKey final : public RegKey
+{
+public:
+    // Operations that are recorded.
+    enum class Operation {
+        Valid,
+        QueryDWORDValue,
+        QueryQWORDValue,
+        QueryGUIDValue,
+        QueryValue,
+        GetValues,
+        GetSubKeys,
+        SetDWORDValue,
+        SetQWORDValue,
+        SetGUIDValue,
+        SetStringValue,
+        DeleteValue,
+        Max,
+    };
+
+    explicit            RecordingRegKey(RegKey& p_rKey);
+                        RecordingRegKey(const RecordingRegKey&) = delete;
+    RecordingRegKey&    operator=(const RecordingRegKey&) = delete;
+
+    unsigned long       GetCallCount(const Operation p_Operation) const;
+    unsigned long       GetQueryCount() const;
+    unsigned long       GetTotalCallCount() const;
+    void                ResetCallCounts();
+
+    virtual bool        Valid() const override;
+
+    virtual long        QueryDWORDValue(const wchar_t* const p_pValueName,
+                                        DWORD& p_rValue) const override;
+    virtual long        QueryQWORDValue(const wchar_t* const p_pValueName,
+                                        ULONGLONG& p_rValue) const override;
+    virtual long        QueryGUIDValue(const wchar_t* const p_pValueName,
+                                       GUID& p_rValue) const override;
+    virtual long        QueryValue(const wchar_t* const p_pValueName,
+                                   DWORD* const p_pValueType,
+                                   void* const p_pValue,
+                                   DWORD* const p_pValueSize) const override;
+
+    virtual void        GetValues(ValueInfoV& p_rvValues) const override;
+    virtual void        GetSubKeys(SubkeyInfoV& p_rvSubkeys) const override;
+
+    virtual long        SetDWORDValue(const wchar_t* const p_pValueName,
+                                      const DWORD p_Value) override;
+    virtual long        SetQWORDValue(const wchar_t* const p_pValueName,
+                                      const ULONGLONG p_Value) override;
+    virtual long        SetGUIDValue(const wchar_t* const p_pValueName,
+                                     const GUID& p_Value) override;
+    virtual long        SetStringValue(const wchar_t* const p_pValueName,
+                                       const wchar_t* const p_pValue) override;
+
+    virtual long        DeleteValue(const wchar_t* const p_pValueName) override;
+
+private:
+    RegKey&             m_rKey;         // Key we forward calls to.
+    mutable std::atomic<unsigned long>
+                        m_aCallCounts[static_cast<size_t>(Operation::Max)];     // Number of calls per operation.
+
+    void                Record(const Operation p_Operation) const;
+};
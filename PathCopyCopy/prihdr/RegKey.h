@@ -51,10 +51,12 @@ public:
     struct SubkeyInfo {
         HKEY            m_hParent;      // Parent of this subkey.
         std::wstring    m_KeyName;      // Name of the subkey.
+        FILETIME        m_LastWriteTime;// Last write time of the subkey, or zero if unknown.
 
                         SubkeyInfo();
                         SubkeyInfo(HKEY const p_hParent,
-                                   const wchar_t* const p_pKeyName);
+                                   const wchar_t* const p_pKeyName,
+                                   const FILETIME& p_LastWriteTime = FILETIME());
     };
     typedef std::vector<SubkeyInfo> SubkeyInfoV;
 
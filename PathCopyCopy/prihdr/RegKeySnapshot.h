@@ -0,0 +1,134 @@
+// RegKeySnapshot.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include "RegKey.h"
+#include "UserOverrideableRegKey.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <windows.h>
+
+
+//
+// RegKeySnapshot
+//
+// Read-only, in-memory copy of the values of a UserOverrideableRegKey.
+// All values of the user and global keys are loaded at once upon construction
+// by enumerating each key, so subsequent reads do not hit the registry.
+// Values in HKCU override those found in HKLM, like in the original key.
+//
+// Changes to the registry after construction are not reflected; attempts
+// to modify values through this object fail with ERROR_ACCESS_DENIED.
+//
+// If a shared name is given, the snapshot is also stored in a named shared
+// memory section, so that other processes of the same user and session can
+// load it without enumerating the keys, as long as the keys' last write
+// times haven't changed since the snapshot was stored. It is also persisted
+// to a file in the user's local application data folder, so that it survives
+// when all processes exit (e.g. when Explorer is restarted or at next logon);
+// the file is only used if both the keys and our DLL haven't changed since.
+//
+class RegKeySnapshot final : public RegKey
+{
+public:
+    explicit            RegKeySnapshot(const UserOverrideableRegKey& p_Key,
+                                       const wchar_t* const p_pSharedName = nullptr);
+                        RegKeySnapshot(const RegKeySnapshot&) = delete;
+    RegKeySnapshot&     operator=(const RegKeySnapshot&) = delete;
+
+    virtual bool        Valid() const override;
+    bool                Locked() const;
+
+    virtual long        QueryDWORDValue(const wchar_t* const p_pValueName,
+                                        DWORD& p_rValue) const override;
+    virtual long        QueryQWORDValue(const wchar_t* const p_pValueName,
+                                        ULONGLONG& p_rValue) const override;
+    virtual long        QueryGUIDValue(const wchar_t* const p_pValueName,
+                                       GUID& p_rValue) const override;
+    virtual long        QueryValue(const wchar_t* const p_pValueName,
+                                   DWORD* const p_pValueType,
+                                   void* const p_pValue,
+                                   DWORD* const p_pValueSize) const override;
+
+    virtual void        GetValues(ValueInfoV& p_rvValues) const override;
+    virtual void        GetSubKeys(SubkeyInfoV& p_rvSubkeys) const override;
+
+    virtual long        SetDWORDValue(const wchar_t* const p_pValueName,
+                                      const DWORD p_Value) override;
+    virtual long        SetQWORDValue(const wchar_t* const p_pValueName,
+                                      const ULONGLONG p_Value) override;
+    virtual long        SetGUIDValue(const wchar_t* const p_pValueName,
+                                     const GUID& p_Value) override;
+    virtual long        SetStringValue(const wchar_t* const p_pValueName,
+                                       const wchar_t* const p_pValue) override;
+
+    virtual long        DeleteValue(const wchar_t* const p_pValueName) override;
+
+private:
+    // Data of a single registry value.
+    struct ValueData {
+        HKEY            m_hKey;         // Key containing the value.
+        DWORD           m_Type;         // Type of value (REG_DWORD, REG_SZ, etc.)
+        std::vector<BYTE>
+                        m_vData;        // Raw value data.
+    };
+
+    // Comparator for value names; like the registry, it is case-insensitive.
+    struct ValueNameLess {
+        bool            operator()(const std::wstring& p_Name1,
+                                   const std::wstring& p_Name2) const;
+    };
+
+    typedef std::map<std::wstring, ValueData, ValueNameLess> ValueDataM;
+
+    // Last write times of the source keys, used to validate shared and persisted snapshots.
+    struct KeyStamp {
+        FILETIME        m_UserKeyWriteTime;     // Last write time of user key.
+        FILETIME        m_GlobalKeyWriteTime;   // Last write time of global key (zero if it doesn't exist).
+    };
+
+    const UserOverrideableRegKey&
+                        m_Key;          // Key we're a snapshot of; used for subkeys.
+    ValueDataM          m_mValues;      // Values of the key, by name.
+    bool                m_Valid;        // Whether source key was valid.
+    bool                m_Locked;       // Whether source key was locked.
+
+    void                LoadValues(HKEY const p_hKey);
+    KeyStamp            GetKeyStamp() const;
+    bool                LoadShared(const wchar_t* const p_pSharedName,
+                                   const KeyStamp& p_Stamp);
+    void                SaveShared(const wchar_t* const p_pSharedName,
+                                   const KeyStamp& p_Stamp) const;
+    bool                LoadPersisted(const wchar_t* const p_pSharedName,
+                                      const KeyStamp& p_Stamp);
+    void                SavePersisted(const wchar_t* const p_pSharedName,
+                                      const KeyStamp& p_Stamp) const;
+    std::vector<BYTE>   SerializeValues() const;
+    bool                ParseValues(const BYTE* const p_pData,
+                                    const size_t p_DataSize,
+                                    ValueDataM& p_rmValues) const;
+    const ValueData*    FindValue(const wchar_t* const p_pValueName) const;
+};
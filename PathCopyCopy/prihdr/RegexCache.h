@@ -0,0 +1,85 @@
+// RegexCache.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include <FastRegex.h>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <regex>
+#include <string>
+#include <utility>
+
+
+namespace PCC
+{
+    //
+    // RegexCache
+    //
+    // Process-wide cache of compiled regular expressions, keyed by pattern
+    // and case sensitivity. Compiled regexes are immutable and can be shared
+    // between pipeline elements, plugins and threads. Regexes compiled with
+    // std::wregex and FastRegex are cached separately.
+    //
+    // To bound memory usage when patterns keep changing, each cache is cleared
+    // when it grows too large. It can also be cleared explicitly when idle
+    // (see CacheManager).
+    //
+    class RegexCache final
+    {
+    public:
+        // Shared pointer to an immutable compiled regex.
+        typedef std::shared_ptr<const std::wregex> WRegexSP;
+
+        // Shared pointer to an immutable compiled FastRegex.
+        typedef std::shared_ptr<const FastRegex> FastRegexSP;
+
+                        RegexCache() = delete;
+                        ~RegexCache() = delete;
+
+        static WRegexSP GetRegex(const std::wstring& p_Regex,
+                                 const bool p_IgnoreCase);
+        static FastRegexSP
+                        GetFastRegex(const std::wstring& p_Regex,
+                                     const bool p_IgnoreCase);
+        static void     Clear();
+
+    private:
+        // Key identifying a compiled regex: pattern and whether to ignore case.
+        typedef std::pair<std::wstring, bool> RegexKey;
+
+        // Map of compiled regexes, per key. Invalid regexes are stored as nullptr.
+        typedef std::map<RegexKey, WRegexSP> RegexM;
+
+        // Map of compiled FastRegexes, per key. Unsupported regexes are stored as nullptr.
+        typedef std::map<RegexKey, FastRegexSP> FastRegexM;
+
+        static RegexM   s_mspRegexes;   // Compiled regexes.
+        static FastRegexM
+                        s_mspFastRegexes;   // Compiled FastRegexes.
+        static std::mutex
+                        s_Lock;         // Lock protecting the caches.
+    };
+
+} // namespace PCC
@@ -0,0 +1,102 @@
+// RegistryWatcher.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+
+#include <atlbase.h>
+#include <windows.h>
+
+
+namespace PCC
+{
+    //
+    // RegistryWatcher
+    //
+    // Process-wide watcher of the PathCopyCopy registry keys. It maintains a
+    // generation number that is incremented whenever settings, pipeline plugins,
+    // COM plugin registrations or plugin icons change, in HKCU or in HKLM.
+    // Only the values of the settings keys themselves and the subkeys storing
+    // settings (see WATCHED_SUBKEYS) are watched; other subkeys, like the ones
+    // where runtime data is written, do not affect the generation. Runtime data
+    // should be stored under the PathCopyCopyCache key anyway.
+    // Caches derived from the settings can remember the generation at the time
+    // they were filled and compare it with GetGeneration to know if they
+    // are stale, instead of reading the registry again.
+    //
+    // Changes are awaited in the thread pool. Bursts of changes (like when the
+    // settings application saves many values at once) are debounced: the
+    // generation is incremented on the first change, then at most once per
+    // debounce delay until changes stop.
+    //
+    // If changes cannot be watched, the generation is incremented on every
+    // call to GetGeneration, so caches never return stale data.
+    //
+    class RegistryWatcher final
+    {
+    public:
+                        RegistryWatcher() = delete;
+                        ~RegistryWatcher() = delete;
+
+        static ULONG    GetGeneration();
+        static void     Stop();
+
+    private:
+        // Number of subkeys of the settings keys that are watched.
+        static const size_t
+                        WATCHED_SUBKEY_COUNT = 5;
+
+        static ATL::CRegKey
+                        s_UserKey;          // PCC per-user settings key, opened for notification.
+        static ATL::CRegKey
+                        s_GlobalKey;        // PCC global settings key, opened for notification.
+        static ATL::CRegKey
+                        s_aUserSubkeys[WATCHED_SUBKEY_COUNT];   // Watched subkeys of s_UserKey, if they exist.
+        static ATL::CRegKey
+                        s_aGlobalSubkeys[WATCHED_SUBKEY_COUNT]; // Watched subkeys of s_GlobalKey, if they exist.
+        static ATL::CHandle
+                        s_hChangeEvent;     // Event signaled when one of the settings keys changes.
+        static HANDLE   s_hWait;            // Thread pool wait on s_hChangeEvent, if registered.
+        static HANDLE   s_hDebounceTimer;   // Timer incrementing the generation after a burst, if pending.
+        static DWORD    s_LastChangeTime;   // Tick count when generation was last incremented because of a change.
+        static std::atomic<bool>
+                        s_Watching;         // Whether change notifications are currently armed.
+        static std::atomic<ULONG>
+                        s_Generation;       // Current settings generation; incremented on changes.
+        static std::mutex
+                        s_Lock;             // Lock protecting static members.
+
+        static bool     StartWatching();
+        static bool     ArmNotifications();
+        static bool     ArmSubkeyNotifications(const ATL::CRegKey& p_ParentKey,
+                                               const wchar_t* const p_pSubkeyName,
+                                               ATL::CRegKey& p_rSubkey);
+        static void CALLBACK
+                        OnChange(PVOID p_pContext,
+                                 BOOLEAN p_TimedOut);
+        static void CALLBACK
+                        OnDebounceElapsed(PVOID p_pContext,
+                                          BOOLEAN p_TimedOut);
+    };
+
+} // namespace PCC
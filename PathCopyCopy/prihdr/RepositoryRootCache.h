@@ -0,0 +1,86 @@
+// RepositoryRootCache.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include "PathCompare.h"
+#include "PathCopyCopyPrivateTypes.h"
+
+#include <map>
+#include <mutex>
+#include <string>
+
+#include <windows.h>
+
+
+namespace PCC
+{
+    //
+    // RepositoryRootCache
+    //
+    // Process-wide cache of the roots of the repositories (or projects)
+    // enclosing directories. A root is found by walking up parent directories
+    // until one contains one of the root markers (see
+    // Settings::GetProjectRootMarkers), like a ".git" folder.
+    //
+    // Since walking up directories can mean many round trips on network
+    // drives, the result is cached for every directory visited, so that
+    // other directories in the same repository only walk up until they
+    // find a cached ancestor. Entries expire after a short time, so that
+    // repositories created or deleted in the meantime are noticed.
+    //
+    class RepositoryRootCache final
+    {
+    public:
+                        RepositoryRootCache() = delete;
+                        ~RepositoryRootCache() = delete;
+
+        static std::wstring
+                        GetRepositoryRoot(const std::wstring& p_Directory,
+                                          const WStringV& p_vMarkers);
+
+    private:
+        // Cached root of a directory.
+        struct Entry {
+            std::wstring    m_Root;         // Root of enclosing repository, or empty if there is none.
+            DWORD           m_Timestamp;    // Tick count when entry was cached.
+        };
+        typedef std::map<std::wstring, Entry, PathCompare::Less> EntryM;
+
+        static const DWORD
+                        TIME_TO_LIVE;       // Time after which an entry expires, in milliseconds.
+        static const size_t
+                        MAX_ENTRIES;        // Number of entries above which expired entries are pruned.
+
+        static EntryM   s_mEntries;         // Cached roots, per directory.
+        static WStringV s_vMarkers;         // Root markers used to find cached roots.
+        static std::mutex
+                        s_Lock;             // Lock protecting static members.
+
+        static void     GetAncestors(const std::wstring& p_Directory,
+                                     WStringV& p_rvAncestors);
+        static bool     HasMarker(const std::wstring& p_Directory,
+                                  const WStringV& p_vMarkers);
+        static void     Prune(const DWORD p_Now);
+    };
+
+} // namespace PCC
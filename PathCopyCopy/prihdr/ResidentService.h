@@ -0,0 +1,101 @@
+// ResidentService.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include "PathCopyCopyPrivateTypes.h"
+
+#include <string>
+
+#include <atlbase.h>
+#include <windows.h>
+
+
+class COMPluginHostMessage;
+
+namespace PCC
+{
+    //
+    // ResidentService
+    //
+    // Optional per-user process that stays resident in the background so that
+    // our caches (settings, plugins, share index, FQDNs, etc.) are always warm.
+    // It is hosted by rundll32 (see RunResidentServiceW) and started at logon
+    // once installed.
+    //
+    // While it runs, the shell extension forwards the work of copying paths
+    // to it through a named pipe instead of doing it in the shell's process
+    // (see Forward). It also registers global hotkeys that apply plugins to
+    // the files selected in the active Explorer window (see
+    // Settings::GetHotkeys).
+    //
+    class ResidentService final
+    {
+    public:
+                        ResidentService() = delete;
+                        ~ResidentService() = delete;
+
+        static bool     Forward(const GUID& p_PluginId,
+                                const FilesV& p_vFiles);
+
+        static void     Run();
+        static bool     Stop();
+        static bool     Install(const bool p_Install);
+
+    private:
+        //
+        // Commands that can be sent to the service. Requests are encoded using
+        // COMPluginHostMessage and start with the command. Responses contain
+        // a single HRESULT, sent as soon as the request has been accepted.
+        //
+        enum Command : DWORD {
+            // Args: plugin ID, number of files, files.
+            CopyPaths   = 1,
+
+            // Args: none.
+            Quit        = 2,
+        };
+
+        static bool     s_Running;          // Whether the service is running in this process.
+
+        static std::wstring
+                        GetPipeName();
+        static std::wstring
+                        GetRunCommand();
+        static HRESULT  SendRequest(const COMPluginHostMessage& p_Request);
+        static bool     IsServerTrusted(HANDLE p_hPipe);
+        static Command  ReceiveRequest(HANDLE p_hPipe,
+                                       HANDLE p_hEvent,
+                                       GUID& p_rPluginId,
+                                       FilesV& p_rvFiles);
+        static HRESULT  CompleteIO(HANDLE p_hPipe,
+                                   const BOOL p_Result,
+                                   OVERLAPPED& p_rOverlapped,
+                                   const DWORD p_Timeout,
+                                   DWORD& p_rBytes);
+        static void     RegisterHotkeys(GUIDV& p_rvPluginIds);
+        static void     UnregisterHotkeys(const GUIDV& p_vPluginIds);
+        static bool     GetExplorerSelection(HWND& p_rhWnd,
+                                             ATL::CComPtr<IDataObject>& p_rspDataObject);
+    };
+
+} // namespace PCC
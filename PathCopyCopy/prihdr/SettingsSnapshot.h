@@ -0,0 +1,100 @@
+// SettingsSnapshot.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include "PathCopyCopyPrivateTypes.h"
+#include "StringUtils.h"
+
+#include <string>
+
+#include <windows.h>
+
+#include <cl/optional.h>
+
+
+namespace PCC
+{
+    //
+    // SettingsSnapshot
+    //
+    // Immutable copy of the settings read by plugins while they convert paths
+    // and by actions when they assemble the results. All values are read from
+    // a Settings object at once upon construction; afterwards, the snapshot
+    // never touches the registry and can be shared between threads.
+    //
+    // Settings remains the object used to read other settings and to modify
+    // them. Plugins can access the snapshot through the ConversionContext.
+    //
+    class SettingsSnapshot final
+    {
+    public:
+        explicit        SettingsSnapshot(const Settings& p_Settings);
+                        SettingsSnapshot(const SettingsSnapshot&) = default;
+        SettingsSnapshot&
+                        operator=(const SettingsSnapshot&) = delete;
+
+        bool            GetUseHiddenShares() const;
+        bool            GetUseFQDN() const;
+        bool            GetAddQuotesAroundPaths() const;
+        bool            GetAreQuotesOptional() const;
+        bool            GetMakePathsIntoEmailLinks() const;
+        StringUtils::EncodeParam
+                        GetEncodeParam() const;
+        bool            GetAppendSeparatorForDirectories() const;
+        bool            GetDropRedundantWords() const;
+        const std::wstring&
+                        GetPathsSeparator() const;
+        bool            GetCacheConvertedPaths() const;
+        bool            GetResolveDFSPaths() const;
+        bool            GetDisableShortNamesIfUnsupported() const;
+        const WStringV& GetProjectRootMarkers() const;
+        const WStringWStringUM&
+                        GetSambaServerAliases() const;
+        cl::optional<std::wstring>
+                        GetIconFileForPlugin(const CLSID& p_PluginId) const;
+        ULONGLONG       GetGeneration() const;
+
+    private:
+        const bool      m_UseHiddenShares;                  // See Settings::GetUseHiddenShares.
+        const bool      m_UseFQDN;                          // See Settings::GetUseFQDN.
+        const bool      m_AddQuotesAroundPaths;             // See Settings::GetAddQuotesAroundPaths.
+        const bool      m_AreQuotesOptional;                // See Settings::GetAreQuotesOptional.
+        const bool      m_MakePathsIntoEmailLinks;          // See Settings::GetMakePathsIntoEmailLinks.
+        const StringUtils::EncodeParam
+                        m_EncodeParam;                      // See Settings::GetEncodeParam.
+        const bool      m_AppendSeparatorForDirectories;    // See Settings::GetAppendSeparatorForDirectories.
+        const bool      m_DropRedundantWords;               // See Settings::GetDropRedundantWords.
+        const std::wstring
+                        m_PathsSeparator;                   // See Settings::GetPathsSeparator.
+        const bool      m_CacheConvertedPaths;              // See Settings::GetCacheConvertedPaths.
+        const bool      m_ResolveDFSPaths;                  // See Settings::GetResolveDFSPaths.
+        const bool      m_DisableShortNamesIfUnsupported;   // See Settings::GetDisableShortNamesIfUnsupported.
+        const WStringV  m_vProjectRootMarkers;              // See Settings::GetProjectRootMarkers.
+        const WStringWStringUM
+                        m_mSambaServerAliases;              // See Settings::GetSambaServerAliases.
+        const GUIDWStringPairV
+                        m_vPluginIconFiles;                 // See Settings::GetIconFilesForPlugins.
+        const ULONGLONG m_Generation;                       // See Settings::GetGeneration.
+    };
+
+} // namespace PCC
@@ -0,0 +1,84 @@
+// ShareIndex.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include "NetworkEnvironment.h"
+#include "PathCompare.h"
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+
+#include <windows.h>
+
+
+namespace PCC
+{
+    //
+    // ShareIndex
+    //
+    // Immutable index of the network shares of the local computer, built from
+    // the shares enumerated by the NetworkEnvironment. Allows finding the share
+    // containing a given path with a longest-prefix lookup instead of scanning
+    // all shares. Like in the file system, share paths are matched ignoring case.
+    //
+    class ShareIndex final
+    {
+    public:
+        explicit        ShareIndex(const NetworkEnvironment::ShareInfoV& p_vShares);
+                        ShareIndex(const ShareIndex&) = delete;
+        ShareIndex&     operator=(const ShareIndex&) = delete;
+
+        bool            FindShare(const std::wstring& p_FilePath,
+                                  const bool p_UseHiddenShares,
+                                  std::wstring& p_rSharePath,
+                                  std::wstring& p_rShareName) const;
+
+    private:
+        // Map of share names, per share path (ignoring case).
+        typedef std::map<std::wstring, std::wstring, PathCompare::Less> ShareNameM;
+
+        // Set of share path lengths, longest first.
+        typedef std::set<std::wstring::size_type, std::greater<std::wstring::size_type>> PathLengthS;
+
+        // Shares of a given kind, indexed by path.
+        struct Shares {
+            ShareNameM  m_mShareNames;      // Share names, per share path.
+            PathLengthS m_sPathLengths;     // Lengths of all share paths, longest first.
+
+            void        Add(const std::wstring& p_SharePath,
+                            const std::wstring& p_ShareName);
+            bool        Find(const std::wstring& p_FilePath,
+                             std::wstring& p_rSharePath,
+                             std::wstring& p_rShareName) const;
+        };
+
+        Shares          m_AllShares;        // All shares, including hidden ones.
+        Shares          m_VisibleShares;    // Shares that are not hidden.
+    };
+
+    typedef std::shared_ptr<const ShareIndex> ShareIndexSP;  // Shared pointer to an immutable share index.
+
+} // namespace PCC
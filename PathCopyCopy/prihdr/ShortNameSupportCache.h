@@ -0,0 +1,84 @@
+// ShortNameSupportCache.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+
+#include <windows.h>
+
+
+namespace PCC
+{
+    //
+    // ShortNameSupportCache
+    //
+    // Process-wide cache of whether volumes have short (8.3) names, per volume
+    // root (drive root or network share). Used to avoid calling GetShortPathNameW
+    // for files on volumes that have no short names, since each call is a round
+    // trip for network volumes.
+    //
+    // Support is first detected from the volume's file system. For file systems
+    // on which short name generation can be disabled (like NTFS), it is then
+    // learned from conversions: once enough long names have been found without
+    // short names, and no short name has been found, the volume is considered
+    // not to have any for a while.
+    //
+    class ShortNameSupportCache final
+    {
+    public:
+                        ShortNameSupportCache() = delete;
+                        ~ShortNameSupportCache() = delete;
+
+        static bool     MayHaveShortNames(const std::wstring& p_Path);
+        static void     RecordConversion(const std::wstring& p_Path,
+                                         const std::wstring& p_ShortPath);
+        static void     Flush();
+
+    private:
+        // Whether a volume has short names.
+        enum class Support {
+            Unknown,                    // Not determined yet; learned from conversions.
+            Supported,                  // Volume has short names.
+            Unsupported,                // Volume has no short names.
+        };
+
+        // Cached info about a volume.
+        struct Entry {
+            Support         m_Support;          // Whether volume has short names.
+            ULONG           m_LongNamesCount;   // Number of long names found without short names so far.
+            DWORD           m_Timestamp;        // Tick count when support was determined.
+        };
+
+        typedef std::map<std::wstring, Entry> EntryM;
+
+        static EntryM   s_mEntries;     // Cached info, per lowercase volume root.
+        static std::mutex
+                        s_Lock;         // Lock protecting static members.
+
+        static bool     GetVolumeRoot(const std::wstring& p_Path,
+                                      std::wstring& p_rVolumeRoot);
+        static Support  DetectSupport(const std::wstring& p_VolumeRoot);
+    };
+
+} // namespace PCC
@@ -0,0 +1,120 @@
+// SimulatedNetworkEnvironment.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include "NetworkEnvironment.h"
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <windows.h>
+
+
+namespace PCC
+{
+    //
+    // SimulatedNetworkEnvironment
+    //
+    // Network environment that simulates mapped drives, local shares, DNS and DFS
+    // with configurable latency, so that the performance of UNC conversions
+    // can be measured reproducibly (see PathCopyCopyBenchmarks.cpp).
+    //
+    // The environment must be configured before it is installed with
+    // NetworkEnvironment::SetCurrent; after that, only its counters change.
+    // Only available when PCC_BENCHMARKS is defined.
+    //
+    class SimulatedNetworkEnvironment final : public NetworkEnvironment
+    {
+    public:
+        // Operations that can be simulated.
+        enum class Operation {
+            UniversalName,      // GetUniversalName
+            Shares,             // GetShares
+            FQDN,               // GetFQDN
+            DFSReferral,        // GetDFSReferral
+            Max,
+        };
+
+        // How DNS lookups behave.
+        enum class DNSBehavior {
+            Resolve,            // Lookups succeed; host names are suffixed with the DNS suffix.
+            Fail,               // All lookups fail.
+        };
+
+                        SimulatedNetworkEnvironment();
+
+        void            SetLatency(const Operation p_Operation,
+                                   const std::chrono::microseconds& p_Latency);
+        void            AddMappedDrive(const wchar_t p_Drive,
+                                       const std::wstring& p_UNCRoot);
+        void            AddShare(const std::wstring& p_Name,
+                                 const std::wstring& p_Path);
+        void            AddGeneratedShares(const size_t p_Count,
+                                           const std::wstring& p_RootPath);
+        void            SetDNSBehavior(const DNSBehavior p_Behavior,
+                                       const std::wstring& p_DNSSuffix);
+        void            AddDFSLink(const std::wstring& p_EntryPath,
+                                   const std::wstring& p_Target);
+        void            SetLocalComputerName(const std::wstring& p_ComputerName);
+        void            SetSharesChanged(const bool p_Changed);
+
+        unsigned long   GetCallCount(const Operation p_Operation) const;
+
+        virtual DWORD   GetUniversalName(const std::wstring& p_FilePath,
+                                         std::wstring& p_rUniversalName) override;
+        virtual bool    GetShares(ShareInfoV& p_rvShares) override;
+        virtual bool    SharesChanged() override;
+        virtual bool    GetFQDN(const std::wstring& p_Hostname,
+                                std::wstring& p_rFQDN) override;
+        virtual bool    GetDFSReferral(const std::wstring& p_UNCPath,
+                                       DFSReferral& p_rReferral) override;
+        virtual std::wstring
+                        GetLocalComputerName() override;
+        virtual bool    IsDriveReachable(const wchar_t p_Drive) override;
+
+    private:
+        // Map of network paths of mapped drive roots, per (uppercase) drive letter.
+        typedef std::map<wchar_t, std::wstring> DriveUNCRootM;
+
+        // Vector of DFS referrals.
+        typedef std::vector<DFSReferral> DFSReferralV;
+
+        std::chrono::microseconds
+                        m_aLatencies[static_cast<size_t>(Operation::Max)];  // Simulated latency of each operation.
+        std::atomic<unsigned long>
+                        m_aCallCounts[static_cast<size_t>(Operation::Max)]; // Number of calls to each operation.
+        DriveUNCRootM   m_mDriveUNCRoots;       // Simulated mapped drives.
+        ShareInfoV      m_vShares;              // Simulated shares of the local computer.
+        DNSBehavior     m_DNSBehavior;          // How simulated DNS lookups behave.
+        std::wstring    m_DNSSuffix;            // Suffix appended to host names by successful DNS lookups.
+        DFSReferralV    m_vDFSLinks;            // Simulated DFS roots and links.
+        std::wstring    m_ComputerName;         // Simulated name of the local computer.
+        std::atomic<bool>
+                        m_SharesChanged;        // Whether SharesChanged returns true.
+
+        void            Call(const Operation p_Operation);
+    };
+
+} // namespace PCC
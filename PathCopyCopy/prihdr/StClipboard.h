@@ -27,8 +27,8 @@
 //
 // StClipboard
 //
-// Stack-based class that opens and empties the clipboard when created
-// and takes care of closing the clipboard when destroyed.
+// Stack-based class that opens and (usually) empties the clipboard when
+// created and takes care of closing the clipboard when destroyed.
 //
 class StClipboard final
 {
@@ -41,12 +41,15 @@ public:
                         // false, use the Windows API GetLastError to know what happened.
                         //
                         // @param p_hOwnerWnd Handle of window that will become the clipboard owner.
+                        // @param p_Empty Whether to empty the clipboard. If false, the caller
+                        //                must call EmptyClipboard before storing data.
                         //
-    explicit            StClipboard(HWND p_hOwnerWnd)
+    explicit            StClipboard(HWND p_hOwnerWnd,
+                                    const bool p_Empty = true)
                             : m_Opened(::OpenClipboard(p_hOwnerWnd) != FALSE),
                               m_Result(m_Opened)
                         {
-                            if (m_Result) {
+                            if (m_Result && p_Empty) {
                                 m_Result = (::EmptyClipboard() != FALSE);
                             }
                         }
@@ -42,9 +42,27 @@ public:
                         StringUtils() = delete;
                         ~StringUtils() = delete;
 
+    //
+    // Returns the length of a string literal or constant character array,
+    // excluding its terminating null. Computed at compile time.
+    //
+    // @param p_String String literal.
+    // @return Length of p_String.
+    //
+    template<size_t N>
+    static constexpr size_t
+                        LiteralLength(const wchar_t (&/*p_String*/)[N])
+    {
+        return N - 1;
+    }
+
     static void         ReplaceAll(std::wstring& p_rString,
                                    const std::wstring& p_OldValue,
                                    const std::wstring& p_NewValue);
+    static void         ReplaceChar(std::wstring& p_rString,
+                                    const wchar_t p_OldChar,
+                                    const wchar_t p_NewChar);
+    static bool         IsASCII(const std::wstring& p_String);
     static void         Split(std::wstring& p_rString,
                               const wchar_t p_Separator,
                               PCC::WStringV& p_rParts);
@@ -0,0 +1,77 @@
+// SystemNetworkEnvironment.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include "NetworkEnvironment.h"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+
+#include <atlbase.h>
+#include <windows.h>
+
+
+namespace PCC
+{
+    //
+    // SystemNetworkEnvironment
+    //
+    // Real network environment, using WNetGetUniversalName, NetShareEnum (or
+    // the Lanmanserver shares registry key), Winsock, NetDfsGetClientInfo
+    // and WNetGetConnection. Shares published by the MachineNetworkCache are
+    // used instead of enumerating them, if available.
+    //
+    class SystemNetworkEnvironment final : public NetworkEnvironment
+    {
+    public:
+        explicit        SystemNetworkEnvironment(const bool p_UseMachineCache = true);
+
+        virtual DWORD   GetUniversalName(const std::wstring& p_FilePath,
+                                         std::wstring& p_rUniversalName) override;
+        virtual bool    GetShares(ShareInfoV& p_rvShares) override;
+        bool            GetShares(ShareInfoV& p_rvShares,
+                                  FILETIME& p_rSharesWriteTime);
+        virtual bool    SharesChanged() override;
+        virtual bool    GetFQDN(const std::wstring& p_Hostname,
+                                std::wstring& p_rFQDN) override;
+        virtual bool    GetDFSReferral(const std::wstring& p_UNCPath,
+                                       DFSReferral& p_rReferral) override;
+        virtual std::wstring
+                        GetLocalComputerName() override;
+        virtual bool    IsDriveReachable(const wchar_t p_Drive) override;
+
+    private:
+        bool            m_UseMachineCache;      // Whether to use info published by the MachineNetworkCache.
+        ATL::CRegKey    m_SharesKey;            // Registry key storing network shares, opened for notification.
+        ATL::CHandle    m_hSharesChangeEvent;   // Event signaled when network shares change; never closed once created.
+        std::atomic<bool>
+                        m_WatchingShares;       // Whether m_hSharesChangeEvent is armed to detect changes.
+        std::mutex      m_SharesLock;           // Lock protecting shares members, except m_WatchingShares.
+        bool            m_WinsockStarted;       // Whether Winsock has been initialized.
+        std::mutex      m_WinsockLock;          // Lock protecting m_WinsockStarted.
+
+        bool            EnumerateShares(ShareInfoV& p_rvShares);
+        bool            ReadRegistryShares(ShareInfoV& p_rvShares);
+    };
+
+} // namespace PCC
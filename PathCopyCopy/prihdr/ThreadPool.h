@@ -0,0 +1,129 @@
+// ThreadPool.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace PCC
+{
+    //
+    // ThreadPool
+    //
+    // Process-wide pool of worker threads used to run background tasks of the
+    // contextual menu extension, like prefetching the menu's information or
+    // evaluating plugins' enabled states. Worker threads are started when the
+    // first task is submitted.
+    //
+    // Each worker has its own queue per priority; submitted tasks are spread
+    // between workers, and idle workers steal tasks from the others' queues.
+    // Tasks with a higher priority are always picked first. Tasks that have
+    // been cancelled before they start are skipped.
+    //
+    // Our DLL is locked while tasks are pending, so that it cannot be unloaded
+    // before they complete. Once it can be, Stop must be called to end worker
+    // threads; they will be started again if another task is submitted.
+    //
+    class ThreadPool final
+    {
+    public:
+        // Possible priorities of tasks.
+        enum class Priority {
+            High        = 0,    // Task is needed right away, e.g. to build the menu.
+            Normal      = 1,    // Task will probably be needed soon.
+            Low         = 2,    // Task might not be needed at all.
+        };
+
+        //
+        // Task
+        //
+        // Handle to a task submitted to the pool.
+        //
+        class Task final
+        {
+        public:
+                        Task(const Task&) = delete;
+            Task&       operator=(const Task&) = delete;
+
+            void        Cancel();
+            bool        Cancelled() const;
+
+        private:
+            friend class ThreadPool;
+
+            std::function<void()>
+                        m_Function;         // Function to run; cleared once the task is done.
+            std::atomic<bool>
+                        m_Cancelled;        // Whether the task has been cancelled.
+
+            explicit    Task(const std::function<void()>& p_Function);
+        };
+        typedef std::shared_ptr<Task> TaskSP;
+
+                        ThreadPool() = delete;
+                        ~ThreadPool() = delete;
+
+        static TaskSP   Submit(const std::function<void()>& p_Function,
+                               const Priority p_Priority = Priority::Normal);
+        static void     Stop();
+
+    private:
+        // Number of possible task priorities.
+        static const size_t
+                        PRIORITY_COUNT = 3;
+
+        // Queues of a worker thread, one per priority.
+        struct Worker {
+            std::deque<TaskSP>
+                        m_dqspTasks[PRIORITY_COUNT];    // Tasks waiting to run.
+            std::mutex  m_Lock;                         // Lock protecting m_dqspTasks.
+        };
+        typedef std::vector<std::unique_ptr<Worker>> WorkerUPV;
+
+        static WorkerUPV
+                        s_vupWorkers;       // Queues of worker threads.
+        static std::vector<std::thread>
+                        s_vThreads;         // Worker threads, if started.
+        static std::atomic<size_t>
+                        s_NextWorker;       // Index of worker to use for the next submitted task.
+        static size_t   s_PendingTasks;     // Number of tasks in queues not yet claimed by a worker.
+        static bool     s_Stopping;         // Whether worker threads must exit.
+        static std::mutex
+                        s_Lock;             // Lock protecting s_PendingTasks and s_Stopping.
+        static std::condition_variable
+                        s_TaskPending;      // Signaled when a task is submitted or when stopping.
+        static std::mutex
+                        s_StartStopLock;    // Lock protecting s_vupWorkers and s_vThreads.
+
+        static void     Run(const size_t p_WorkerIndex);
+        static TaskSP   TakeTask(const size_t p_WorkerIndex);
+        static void     RunTask(const TaskSP& p_spTask);
+    };
+
+} // namespace PCC
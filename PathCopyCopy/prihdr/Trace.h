@@ -0,0 +1,171 @@
+// Trace.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include <AllocationTracker.h>
+#include <DiagnosticLog.h>
+#include <FlightRecorder.h>
+
+#include <atomic>
+#include <chrono>
+
+#include <windows.h>
+
+
+namespace PCC
+{
+    //
+    // Trace
+    //
+    // Writes ETW events that can be collected on production machines (with
+    // tools like WPR or xperf) to profile Path Copy Copy in WPA. Events are
+    // strings written by our provider (see PROVIDER_ID) containing the name
+    // of the traced operation, its duration and a count of items processed.
+    //
+    // ETW functions are loaded dynamically since they are not available on
+    // Windows XP. Events are only formatted when a trace session is listening.
+    //
+    // Events are also recorded in the diagnostic log when it is enabled
+    // (see DiagnosticLog), for machines where ETW cannot be used, and in the
+    // phases of operations being recorded (see FlightRecorder).
+    //
+    class Trace final
+    {
+    public:
+        static const GUID
+                        PROVIDER_ID;        // ID of our ETW provider: {B0D0CAE2-5CF5-42BC-A59B-B71EC8670DC9}
+
+                        Trace() = delete;
+                        ~Trace() = delete;
+
+        static void     Register();
+        static void     Unregister();
+
+                        //
+                        // Checks if a trace session is listening to our events,
+                        // if the diagnostic log is enabled or if an operation
+                        // is being recorded.
+                        //
+                        // @return true if events should be written.
+                        //
+        static bool     Enabled()
+                        {
+                            return s_Enabled.load(std::memory_order_relaxed) || DiagnosticLog::Enabled() || FlightRecorder::Recording();
+                        }
+
+        static void     WriteEvent(const wchar_t* const p_pName,
+                                   const GUID* const p_pId,
+                                   const std::chrono::microseconds p_Duration,
+                                   const size_t p_Count);
+
+    private:
+        static std::atomic<bool>
+                        s_Enabled;          // Whether a trace session is listening to our events.
+
+        static void NTAPI
+                        EnableCallback(LPCGUID p_pSourceId,
+                                       ULONG p_IsEnabled,
+                                       UCHAR p_Level,
+                                       ULONGLONG p_MatchAnyKeyword,
+                                       ULONGLONG p_MatchAllKeyword,
+                                       PVOID p_pFilterData,
+                                       PVOID p_pCallbackContext);
+    };
+
+    //
+    // StTraceEvent
+    //
+    // Stack-based class that measures the duration of a scope and writes
+    // a trace event when it goes out of scope. Does nothing if no trace
+    // session is listening to our events, the diagnostic log is disabled
+    // and no operation is being recorded when it is created.
+    //
+    // In instrumented builds, allocations performed in the scope are also
+    // added to the totals of the event's phase (see AllocationTracker).
+    //
+    class StTraceEvent final
+    {
+    public:
+                        //
+                        // Constructor. Starts measuring the duration of the event.
+                        //
+                        // @param p_pName Name of event; must be a literal string.
+                        // @param p_pId Optional ID of the object the event is about
+                        //              (like a plugin); copied if specified.
+                        //
+        explicit        StTraceEvent(const wchar_t* const p_pName,
+                                     const GUID* const p_pId = nullptr)
+                            : m_pName(p_pName),
+                              m_Id(p_pId != nullptr ? *p_pId : GUID_NULL),
+                              m_HasId(p_pId != nullptr),
+                              m_Count(0),
+                              m_Enabled(Trace::Enabled()),
+                              m_Start(),
+                              m_AllocationScope(p_pName)
+                        {
+                            if (m_Enabled) {
+                                m_Start = std::chrono::steady_clock::now();
+                            }
+                        }
+
+                        //
+                        // Copying not supported.
+                        //
+                        StTraceEvent(const StTraceEvent&) = delete;
+        StTraceEvent&   operator=(const StTraceEvent&) = delete;
+
+                        //
+                        // Destructor. Writes the event with its duration.
+                        //
+                        ~StTraceEvent()
+                        {
+                            if (m_Enabled) {
+                                Trace::WriteEvent(m_pName, m_HasId ? &m_Id : nullptr,
+                                    std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_Start),
+                                    m_Count);
+                            }
+                        }
+
+                        //
+                        // Sets the number of items processed during the event.
+                        //
+                        // @param p_Count Number of items.
+                        //
+        void            SetCount(const size_t p_Count)
+                        {
+                            m_Count = p_Count;
+                        }
+
+    private:
+        const wchar_t*  m_pName;            // Name of event.
+        GUID            m_Id;               // ID of object the event is about.
+        bool            m_HasId;            // Whether m_Id has been specified.
+        size_t          m_Count;            // Number of items processed.
+        bool            m_Enabled;          // Whether event will be written.
+        std::chrono::steady_clock::time_point
+                        m_Start;            // Start of event.
+        StAllocationScope
+                        m_AllocationScope;  // Scope counting allocations of event's phase.
+    };
+
+} // namespace PCC
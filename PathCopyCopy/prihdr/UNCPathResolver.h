@@ -0,0 +1,91 @@
+// UNCPathResolver.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include "PathCopyCopyPrivateTypes.h"
+
+#include <map>
+#include <string>
+
+#include <windows.h>
+
+
+namespace PCC
+{
+    //
+    // UNCPathResolver
+    //
+    // Helper used to convert paths to UNC paths when converting many paths at
+    // once. FQDN lookups are performed once per distinct host and reused
+    // for all other paths. (Mapped drives are cached by PluginUtils and
+    // DFS referrals by DFSReferralCache.)
+    //
+    // Converted paths are also memoized. Since the files of a selection usually
+    // share the same parent directory, the parent of each file is converted
+    // only once; the UNC path of each file is formed by appending its name.
+    // The metadata cache of the operation, if any, is used to check whether
+    // each file can reuse its parent's UNC path.
+    //
+    // This class is not thread-safe; it is meant to be used for a single batch.
+    //
+    class UNCPathResolver final
+    {
+    public:
+    explicit            UNCPathResolver(FileMetadataCache* const p_pMetadataCache);
+                        UNCPathResolver(const UNCPathResolver&) = delete;
+        UNCPathResolver&
+                        operator=(const UNCPathResolver&) = delete;
+
+        bool            ConvertToUNCPath(std::wstring& p_rFilePath,
+                                         const bool p_UseHiddenShares,
+                                         const bool p_UseFQDN,
+                                         const bool p_ResolveDFS);
+        void            ConvertUNCHostToFQDN(std::wstring& p_rFilePath);
+        bool            ResolveDFSPath(std::wstring& p_rUNCPath);
+
+    private:
+        // Result of the conversion of a path.
+        struct UNCPath {
+            std::wstring    m_Path;         // UNC path, if m_Converted is set.
+            bool            m_Converted;    // Whether path has a UNC path.
+        };
+
+        // Map of fully-qualified domain names, per host name.
+        typedef std::map<std::wstring, std::wstring> HostFQDNM;
+
+        // Map of converted paths, per local path.
+        typedef std::map<std::wstring, UNCPath> UNCPathM;
+
+        HostFQDNM       m_mHostFQDNs;       // Cache of FQDNs per host.
+        UNCPathM        m_mUNCPaths;        // Cache of converted paths per local path.
+        FileMetadataCache*
+                        m_pMetadataCache;   // Optional cache of file metadata of the current operation.
+
+        const UNCPath&  GetUNCPath(const std::wstring& p_FilePath,
+                                   const bool p_UseHiddenShares,
+                                   const bool p_UseFQDN,
+                                   const bool p_ResolveDFS);
+        bool            CanReuseParent(const std::wstring& p_FilePath) const;
+    };
+
+} // namespace PCC
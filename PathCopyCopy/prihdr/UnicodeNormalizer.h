@@ -0,0 +1,69 @@
+// UnicodeNormalizer.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include "PathCopyCopyPrivateTypes.h"
+
+#include <mutex>
+#include <string>
+
+#include <windows.h>
+
+
+namespace PCC
+{
+    //
+    // UnicodeNormalizer
+    //
+    // Static class used to convert strings to a Unicode normalization form,
+    // so that paths containing accented characters can be compared by tools
+    // that do not normalize them themselves (like Samba or WSL on Linux).
+    //
+    // Normalization uses NormalizeString, which is loaded on first use since
+    // it is not available on all versions of Windows we support. Strings
+    // containing only ASCII characters are already normalized in all forms;
+    // they are detected with a vectorized check and returned as-is without
+    // calling NormalizeString, since this is the case of most paths.
+    //
+    class UnicodeNormalizer final
+    {
+    public:
+                        UnicodeNormalizer() = delete;
+                        ~UnicodeNormalizer() = delete;
+
+        static bool     Normalize(std::wstring& p_rString,
+                                  const NormalizationForm p_Form);
+
+    private:
+        // Signature of NormalizeString.
+        typedef int (WINAPI* NormalizeStringFunc)(int, LPCWSTR, int, LPWSTR, int);
+
+        static NormalizeStringFunc
+                        s_pNormalizeString;     // Pointer to NormalizeString, if available.
+        static std::once_flag
+                        s_NormalizeStringInit;  // Flag used to load NormalizeString once.
+
+        static NormalizeStringFunc
+                        GetNormalizeString();
+    };
+
+} // namespace PCC
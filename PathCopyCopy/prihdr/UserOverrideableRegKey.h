@@ -24,6 +24,8 @@
 #include "AtlRegKey.h"
 #include "RegKey.h"
 
+#include <cl/optional.h>
+
 
 //
 // UserOverrideableRegKey
@@ -31,6 +33,9 @@
 // Wrapper for a registry key that exists in both CURRENT_USER and LOCAL_MACHINE.
 // Values in HKCU will override those found in HKLM.
 //
+// Whether the user key is locked is only read once, the first time it's needed;
+// this saves querying HKLM every time a value is read.
+//
 class UserOverrideableRegKey final : public RegKey
 {
 public:
@@ -42,8 +47,8 @@ public:
 
     virtual bool        Valid() const override;
     bool                Locked() const;
-    const RegKey&       GetGlobalKey() const;
-    const RegKey&       GetUserKey() const;
+    const AtlRegKey&    GetGlobalKey() const;
+    const AtlRegKey&    GetUserKey() const;
 
     virtual long        QueryDWORDValue(const wchar_t* const p_pValueName,
                                         DWORD& p_rValue) const override;
@@ -73,4 +78,6 @@ public:
 private:
     AtlRegKey           m_GlobalKey;       // Wrapper for the global key in HKLM.
     AtlRegKey           m_UserKey;         // Wrapper for user key in HKCU.
+    mutable cl::optional<bool>
+                        m_Locked;          // Whether user key is locked, once read.
 };
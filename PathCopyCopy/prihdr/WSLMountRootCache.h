@@ -0,0 +1,81 @@
+// WSLMountRootCache.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include <windows.h>
+
+
+namespace PCC
+{
+    //
+    // WSLMountRootCache
+    //
+    // Process-wide cache of the root under which WSL (Windows Subsystem for
+    // Linux) mounts Windows drives in the default distribution. This is
+    // "/mnt/" unless the distribution's /etc/wsl.conf specifies another
+    // "root" in its [automount] section.
+    //
+    // Reading wsl.conf through \\wsl$ can be slow, since it might need to
+    // start the distribution, so it is read on a worker thread. Callers only
+    // wait for it for a limited time the first time; after that, the cached
+    // root is returned right away and refreshed in the background once it
+    // gets old, if wsl.conf has changed.
+    //
+    class WSLMountRootCache final
+    {
+    public:
+                        WSLMountRootCache() = delete;
+                        ~WSLMountRootCache() = delete;
+
+        static std::wstring
+                        GetMountRoot();
+
+    private:
+        // Cached mount root of a distribution.
+        struct Entry {
+            std::wstring    m_MountRoot;    // Mount root, ending with a slash.
+            FILETIME        m_ConfTime;     // Last write time of wsl.conf, or zero if not found.
+            DWORD           m_Timestamp;    // Tick count when entry was last validated.
+            bool            m_Refreshing;   // Whether a refresh is in progress on a worker thread.
+        };
+        typedef std::map<std::wstring, Entry> EntryM;
+
+        static EntryM   s_mEntries;         // Cached mount roots, per distribution name.
+        static std::mutex
+                        s_Lock;             // Lock protecting static members.
+        static std::condition_variable
+                        s_Refreshed;        // Signaled when a refresh completes.
+
+        static std::wstring
+                        GetDefaultDistribution();
+        static void     Refresh(const std::wstring& p_Distribution);
+        static std::wstring
+                        ParseWSLConf(const std::wstring& p_Contents);
+    };
+
+} // namespace PCC
@@ -34,6 +34,16 @@
 
 //#define PCC_NO_CONTEXT_MENU_EXT2    // For testing purposes only
 
+// Limit the number of steps std::wregex can perform for a single match. This bounds
+// the time taken by badly-written regexes in pipeline plugins; when the limit is
+// reached, std::regex_error is thrown and RegexPipelineElement leaves the path as-is.
+// Must be defined before <regex> is included. The default is 10000000 steps.
+#define _REGEX_MAX_COMPLEXITY_COUNT 1000000L
+
+// Winsock 2 headers must be included before windows.h
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
 #include <atlbase.h>
 #include <atlcom.h>
 #include <atlctl.h>
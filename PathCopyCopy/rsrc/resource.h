@@ -54,9 +54,16 @@
 #define IDS_SAMBA_PATH_PLUGIN_HINT      148
 #define IDS_MSYS_PATH_PLUGIN_DESCRIPTION 149
 #define IDS_MSYS_PATH_PLUGIN_HINT       150
-#define IDR_PATHCOPYCOPYCONTEXTMENUEXT  201
-#define IDR_PATHCOPYCOPYDATAHANDLER     202
+#define IDS_PROGRESS_TITLE              151
+#define IDS_PROGRESS_COMPUTING_PATHS    152
+#define IDS_PROGRESS_CANCELLING         153
+#define IDS_ONEDRIVE_URL_PLUGIN_DESCRIPTION 154
+#define IDS_ONEDRIVE_URL_PLUGIN_HINT    155
+#define IDS_REPOSITORY_PATH_PLUGIN_DESCRIPTION 156
+#define IDS_REPOSITORY_PATH_PLUGIN_HINT 157
+#define IDS_PROGRESS_HASHING_FILES      158
 #define IDR_PATHCOPYCOPYCONFIGHELPER    203
+#define IDR_PATHCOPYCOPYEXPLORERCOMMAND 204
 #define IDB_PCCICON2                    207
 
 // Next default values for new objects
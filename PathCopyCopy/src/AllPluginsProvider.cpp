@@ -33,20 +33,62 @@ namespace PCC
     //
     AllPluginsProvider::AllPluginsProvider(const PluginSPS& p_sspAllPlugins)
         : PluginProvider(),
-          m_sspAllPlugins(p_sspAllPlugins)
+          m_sspAllPlugins(p_sspAllPlugins),
+          m_upGraph(),
+          m_GraphInit()
     {
     }
 
     //
-    // Looks for a specific plugin by ID.
+    // Looks for a specific plugin by ID. Plugins that are part of a
+    // reference cycle are not returned, since using them would recurse endlessly.
     //
     // @param p_PluginId ID of plugin to look for.
     // @return Plugin with the given ID, or nullptr if no such plugin was found.
     //
     PluginSP AllPluginsProvider::GetPlugin(const GUID& p_PluginId) const
     {
-        auto it = m_sspAllPlugins.find(p_PluginId);
-        return it != m_sspAllPlugins.end() ? *it : nullptr;
+        return GetGraph().GetPlugin(p_PluginId);
+    }
+
+    //
+    // Applies a specific plugin to a path, memoizing the result if the plugin
+    // is shared by multiple plugins.
+    //
+    // @param p_PluginId ID of plugin to apply.
+    // @param p_rPath Path to modify (in-place).
+    // @param p_Context Context in which to apply the plugin.
+    // @return true if the plugin was found and applied.
+    //
+    bool AllPluginsProvider::GetPathWithPlugin(const GUID& p_PluginId,
+                                               std::wstring& p_rPath,
+                                               const ConversionContext& p_Context) const
+    {
+        return GetGraph().GetPath(p_PluginId, p_rPath, p_Context);
+    }
+
+    //
+    // Forgets all paths memoized by GetPathWithPlugin. Should be called
+    // before converting a new set of files.
+    //
+    void AllPluginsProvider::ClearCachedPaths() const
+    {
+        GetGraph().ClearCachedPaths();
+    }
+
+    //
+    // Returns the graph of references between our plugins, creating it
+    // if needed. This is done lazily because the set of plugins might be
+    // filled after we are constructed.
+    //
+    // @return Plugin dependency graph.
+    //
+    const PluginDependencyGraph& AllPluginsProvider::GetGraph() const
+    {
+        std::call_once(m_GraphInit, [this]() {
+            m_upGraph = std::make_unique<PluginDependencyGraph>(m_sspAllPlugins);
+        });
+        return *m_upGraph;
     }
 
 } // namespace PCC
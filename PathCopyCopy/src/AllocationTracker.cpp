@@ -0,0 +1,168 @@
+// AllocationTracker.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <stdafx.h>
+#include <AllocationTracker.h>
+
+#include <cstdlib>
+#include <cwchar>
+#include <new>
+
+
+namespace PCC
+{
+    // Static members of AllocationTracker
+    std::atomic<ULONGLONG>          AllocationTracker::s_Allocations(0);
+    std::atomic<ULONGLONG>          AllocationTracker::s_Bytes(0);
+    AllocationTracker::PhaseTotals  AllocationTracker::s_aPhases[AllocationTracker::MAX_PHASES];
+    size_t                          AllocationTracker::s_NumPhases = 0;
+    std::mutex                      AllocationTracker::s_PhasesLock;
+
+    //
+    // Returns the allocations counted since the module was loaded.
+    // Subtract two results to get the allocations performed in-between.
+    //
+    // @return Current counts; always 0 if allocations are not counted.
+    //
+    AllocationTracker::Counts AllocationTracker::Current()
+    {
+        const Counts counts = { s_Allocations.load(std::memory_order_relaxed),
+                                s_Bytes.load(std::memory_order_relaxed) };
+        return counts;
+    }
+
+    //
+    // Adds allocations performed during one call of a phase to its totals.
+    // If too many phases have been recorded, the phase is ignored.
+    //
+    // @param p_pName Name of phase; must be a literal string.
+    // @param p_Counts Allocations performed during the call.
+    //
+    void AllocationTracker::RecordPhase(const wchar_t* const p_pName,
+                                        const Counts& p_Counts)
+    {
+        std::lock_guard<std::mutex> lock(s_PhasesLock);
+        size_t i = 0;
+        while (i < s_NumPhases && std::wcscmp(s_aPhases[i].m_pName, p_pName) != 0) {
+            ++i;
+        }
+        if (i == s_NumPhases && s_NumPhases < MAX_PHASES) {
+            s_aPhases[i].m_pName = p_pName;
+            s_aPhases[i].m_Calls = 0;
+            s_aPhases[i].m_Counts.m_Allocations = 0;
+            s_aPhases[i].m_Counts.m_Bytes = 0;
+            ++s_NumPhases;
+        }
+        if (i < s_NumPhases) {
+            ++s_aPhases[i].m_Calls;
+            s_aPhases[i].m_Counts.m_Allocations += p_Counts.m_Allocations;
+            s_aPhases[i].m_Counts.m_Bytes += p_Counts.m_Bytes;
+        }
+    }
+
+    //
+    // Enumerates the totals of all phases recorded so far.
+    //
+    // @param p_pProc Callback invoked for each phase. Must not record phases.
+    // @param p_pContext Context passed to p_pProc.
+    // @param p_Reset Whether to clear the totals after enumerating them.
+    //
+    void AllocationTracker::EnumPhases(PhaseTotalsProc const p_pProc,
+                                       void* const p_pContext,
+                                       const bool p_Reset)
+    {
+        std::lock_guard<std::mutex> lock(s_PhasesLock);
+        for (size_t i = 0; i < s_NumPhases; ++i) {
+            p_pProc(s_aPhases[i], p_pContext);
+        }
+        if (p_Reset) {
+            s_NumPhases = 0;
+        }
+    }
+
+} // namespace PCC
+
+#ifdef PCC_TRACK_ALLOCATIONS
+
+//
+// Replacements for the global allocation functions, used to count the
+// allocations performed by our module. They only affect our module, not
+// the process that loaded us.
+//
+
+void* operator new(size_t p_Size)
+{
+    PCC::AllocationTracker::Count(p_Size);
+    void* const pMemory = std::malloc(p_Size != 0 ? p_Size : 1);
+    if (pMemory == nullptr) {
+        throw std::bad_alloc();
+    }
+    return pMemory;
+}
+
+void* operator new[](size_t p_Size)
+{
+    return operator new(p_Size);
+}
+
+void* operator new(size_t p_Size, const std::nothrow_t&) noexcept
+{
+    PCC::AllocationTracker::Count(p_Size);
+    return std::malloc(p_Size != 0 ? p_Size : 1);
+}
+
+void* operator new[](size_t p_Size, const std::nothrow_t& p_NoThrow) noexcept
+{
+    return operator new(p_Size, p_NoThrow);
+}
+
+void operator delete(void* p_pMemory) noexcept
+{
+    std::free(p_pMemory);
+}
+
+void operator delete[](void* p_pMemory) noexcept
+{
+    std::free(p_pMemory);
+}
+
+void operator delete(void* p_pMemory, size_t) noexcept
+{
+    std::free(p_pMemory);
+}
+
+void operator delete[](void* p_pMemory, size_t) noexcept
+{
+    std::free(p_pMemory);
+}
+
+void operator delete(void* p_pMemory, const std::nothrow_t&) noexcept
+{
+    std::free(p_pMemory);
+}
+
+void operator delete[](void* p_pMemory, const std::nothrow_t&) noexcept
+{
+    std::free(p_pMemory);
+}
+
+#endif // PCC_TRACK_ALLOCATIONS
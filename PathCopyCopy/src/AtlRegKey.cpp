@@ -192,9 +192,10 @@ void AtlRegKey::GetSubKeys(SubkeyInfoV& p_rvSubkeys) const
     LONG res = ERROR_SUCCESS;
     for (DWORD index = 0; res == ERROR_SUCCESS; ++index) {
         DWORD subkeyNameSize = 256;
-        res = m_Key.EnumKey(index, subkeyName, &subkeyNameSize);
+        FILETIME lastWriteTime = { 0 };
+        res = m_Key.EnumKey(index, subkeyName, &subkeyNameSize, &lastWriteTime);
         if (res == ERROR_SUCCESS) {
-            p_rvSubkeys.emplace_back(m_Key.m_hKey, subkeyName);
+            p_rvSubkeys.emplace_back(m_Key.m_hKey, subkeyName, lastWriteTime);
         }
     }
 }
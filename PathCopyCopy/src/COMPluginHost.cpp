@@ -0,0 +1,264 @@
+// COMPluginHost.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <stdafx.h>
+#include <COMPluginHost.h>
+#include <COMPlugin.h>
+
+#include <sstream>
+#include <string>
+
+
+// Image base is provided by the linker. We can use it to locate our DLL. See Start().
+EXTERN_C IMAGE_DOS_HEADER __ImageBase;
+
+namespace
+{
+    // Name of the COM plugin executor program, located beside our DLL.
+#ifndef _WIN64
+    const wchar_t* const    EXECUTOR_FILE_NAME      = L"PathCopyCopyCOMPluginExecutor32.exe";
+#else
+    const wchar_t* const    EXECUTOR_FILE_NAME      = L"PathCopyCopyCOMPluginExecutor64.exe";
+#endif
+
+    // Prefix of the name of pipes used to communicate with the host.
+    // Process ID and a timestamp are appended to make it unique.
+    const wchar_t* const    PIPE_NAME_PREFIX        = L"\\\\.\\pipe\\PathCopyCopy.COMPluginHost.";
+
+    // Size of pipe buffers and of chunks used to read responses.
+    const DWORD             PIPE_BUFFER_SIZE        = 64 * 1024;
+
+    // Timeouts, in milliseconds. The startup timeout is longer because
+    // the host might need to load the .NET runtime for some plugins.
+    const DWORD             STARTUP_TIMEOUT         = 10000;
+    const DWORD             REQUEST_TIMEOUT         = 5000;
+
+} // anonymous namespace
+
+namespace PCC
+{
+    ATL::CHandle    COMPluginHost::s_hProcess;
+    ATL::CHandle    COMPluginHost::s_hPipe;
+    std::mutex      COMPluginHost::s_Lock;
+
+    //
+    // Sends a request to the COM plugin host and waits for its response.
+    // Starts the host if it is not running.
+    //
+    // @param p_Request Request to send. See COMPluginHostMessage for format.
+    // @return Response received from the host.
+    // @throw Plugins::COMPluginError If the host could not be reached or did not answer in time.
+    //
+    COMPluginHostMessage COMPluginHost::Call(const COMPluginHostMessage& p_Request)
+    {
+        std::lock_guard<std::mutex> lock(s_Lock);
+
+        // Start host if it's not running, or if it has exited (e.g. because a plugin crashed it).
+        HRESULT hRes = S_OK;
+        if (s_hProcess == NULL || ::WaitForSingleObject(s_hProcess, 0) != WAIT_TIMEOUT) {
+            Stop();
+            hRes = Start();
+        }
+
+        std::vector<BYTE> vResponse;
+        if (SUCCEEDED(hRes)) {
+            hRes = Transact(p_Request, vResponse);
+            if (FAILED(hRes)) {
+                // Host is hung or broken; get rid of it, it'll be restarted on next call.
+                Stop();
+            }
+        }
+        if (FAILED(hRes)) {
+            throw Plugins::COMPluginError(hRes);
+        }
+
+        return COMPluginHostMessage(std::move(vResponse));
+    }
+
+    //
+    // Starts the host process and waits for it to connect to our pipe.
+    // Must be called with the lock held.
+    //
+    // @return Result code.
+    //
+    HRESULT COMPluginHost::Start()
+    {
+        // Find path to executor program using the ImageBase trick. See SettingsApp::Launch().
+        wchar_t dllPath[MAX_PATH + 1];
+        DWORD siz = ::GetModuleFileNameW((HINSTANCE)&__ImageBase, dllPath, MAX_PATH + 1);
+        if (siz == 0) {
+            return HRESULT_FROM_WIN32(::GetLastError());
+        }
+        std::wstring executorPath(dllPath);
+        std::wstring::size_type delimPos = executorPath.find_last_of(L"/\\");
+        if (delimPos != std::wstring::npos) {
+            executorPath.erase(delimPos);
+        }
+        executorPath += L"\\";
+        executorPath += EXECUTOR_FILE_NAME;
+
+        // Create a unique pipe. Only one instance is allowed so that nobody else can connect to it.
+        std::wostringstream pipeNameStream;
+        pipeNameStream << PIPE_NAME_PREFIX << ::GetCurrentProcessId() << L'.' << ::GetTickCount();
+        const std::wstring pipeName = pipeNameStream.str();
+        HANDLE hPipe = ::CreateNamedPipeW(pipeName.c_str(),
+                                          PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED | FILE_FLAG_FIRST_PIPE_INSTANCE,
+                                          PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE | PIPE_WAIT,
+                                          1, PIPE_BUFFER_SIZE, PIPE_BUFFER_SIZE, 0, nullptr);
+        if (hPipe == INVALID_HANDLE_VALUE) {
+            return HRESULT_FROM_WIN32(::GetLastError());
+        }
+        s_hPipe.Attach(hPipe);
+
+        // Launch host process.
+        std::wstring cmdLine = L"\"" + executorPath + L"\" " + COMPluginHostMessage::HostSwitch() + L" " + pipeName;
+        std::vector<wchar_t> vCmdLine(cmdLine.cbegin(), cmdLine.cend());
+        vCmdLine.push_back(L'\0');
+        STARTUPINFOW startupInfo = { 0 };
+        startupInfo.cb = sizeof(startupInfo);
+        PROCESS_INFORMATION processInfo = { 0 };
+        if (!::CreateProcessW(executorPath.c_str(), &*vCmdLine.begin(), nullptr, nullptr, FALSE,
+                              CREATE_NO_WINDOW, nullptr, nullptr, &startupInfo, &processInfo)) {
+            HRESULT hRes = HRESULT_FROM_WIN32(::GetLastError());
+            Stop();
+            return hRes;
+        }
+        ::CloseHandle(processInfo.hThread);
+        s_hProcess.Attach(processInfo.hProcess);
+
+        // Wait for host to connect, giving up if it exits before then.
+        ATL::CHandle hEvent(::CreateEventW(nullptr, TRUE, FALSE, nullptr));
+        OVERLAPPED overlapped = { 0 };
+        overlapped.hEvent = hEvent;
+        DWORD error = ::ConnectNamedPipe(s_hPipe, &overlapped) ? ERROR_SUCCESS : ::GetLastError();
+        if (error == ERROR_IO_PENDING) {
+            HANDLE handles[] = { hEvent, s_hProcess };
+            DWORD bytes = 0;
+            const DWORD wait = ::WaitForMultipleObjects(2, handles, FALSE, STARTUP_TIMEOUT);
+            if (wait == WAIT_OBJECT_0) {
+                error = ::GetOverlappedResult(s_hPipe, &overlapped, &bytes, FALSE) ? ERROR_SUCCESS : ::GetLastError();
+            } else {
+                ::CancelIo(s_hPipe);
+                ::GetOverlappedResult(s_hPipe, &overlapped, &bytes, TRUE);
+                error = wait == WAIT_TIMEOUT ? ERROR_TIMEOUT : ERROR_BROKEN_PIPE;
+            }
+        } else if (error == ERROR_PIPE_CONNECTED) {
+            error = ERROR_SUCCESS;
+        }
+        if (error != ERROR_SUCCESS) {
+            Stop();
+        }
+        return HRESULT_FROM_WIN32(error);
+    }
+
+    //
+    // Disconnects from the host process, killing it if it's still running.
+    // Must be called with the lock held.
+    //
+    void COMPluginHost::Stop()
+    {
+        s_hPipe.Close();
+        if (s_hProcess != NULL) {
+            if (::WaitForSingleObject(s_hProcess, 0) == WAIT_TIMEOUT) {
+                ::TerminateProcess(s_hProcess, static_cast<UINT>(-1));
+            }
+            s_hProcess.Close();
+        }
+    }
+
+    //
+    // Sends a request to the host and reads its response.
+    // Must be called with the lock held.
+    //
+    // @param p_Request Request to send.
+    // @param p_rvResponse Where to store response data.
+    // @return Result code.
+    //
+    HRESULT COMPluginHost::Transact(const COMPluginHostMessage& p_Request,
+                                    std::vector<BYTE>& p_rvResponse)
+    {
+        ATL::CHandle hEvent(::CreateEventW(nullptr, TRUE, FALSE, nullptr));
+        if (hEvent == NULL) {
+            return HRESULT_FROM_WIN32(::GetLastError());
+        }
+
+        // Send request as a single message.
+        const std::vector<BYTE>& vRequest = p_Request.Data();
+        OVERLAPPED overlapped = { 0 };
+        overlapped.hEvent = hEvent;
+        DWORD bytes = 0;
+        HRESULT hRes = CompleteIO(::WriteFile(s_hPipe, vRequest.data(), static_cast<DWORD>(vRequest.size()),
+                                              nullptr, &overlapped),
+                                  overlapped, REQUEST_TIMEOUT, bytes);
+
+        // Read response, which can be larger than our buffer.
+        p_rvResponse.clear();
+        while (SUCCEEDED(hRes) || hRes == HRESULT_FROM_WIN32(ERROR_MORE_DATA)) {
+            const size_t offset = p_rvResponse.size();
+            p_rvResponse.resize(offset + PIPE_BUFFER_SIZE);
+            ::ResetEvent(hEvent);
+            overlapped = OVERLAPPED();
+            overlapped.hEvent = hEvent;
+            bytes = 0;
+            hRes = CompleteIO(::ReadFile(s_hPipe, &p_rvResponse[offset], PIPE_BUFFER_SIZE, nullptr, &overlapped),
+                              overlapped, REQUEST_TIMEOUT, bytes);
+            p_rvResponse.resize(offset + bytes);
+            if (SUCCEEDED(hRes)) {
+                break;
+            }
+        }
+
+        return hRes;
+    }
+
+    //
+    // Waits for an overlapped I/O operation on the pipe to complete.
+    // If it doesn't complete in time, it is cancelled.
+    //
+    // @param p_Result Result of the ReadFile/WriteFile call that started the operation.
+    // @param p_rOverlapped OVERLAPPED structure used to start the operation.
+    // @param p_Timeout Timeout, in milliseconds.
+    // @param p_rBytes Where to store the number of bytes transferred.
+    // @return Result code. For reads, returns HRESULT_FROM_WIN32(ERROR_MORE_DATA)
+    //         if message has more data to read.
+    //
+    HRESULT COMPluginHost::CompleteIO(const BOOL p_Result,
+                                      OVERLAPPED& p_rOverlapped,
+                                      const DWORD p_Timeout,
+                                      DWORD& p_rBytes)
+    {
+        const DWORD error = p_Result ? ERROR_SUCCESS : ::GetLastError();
+        if (error != ERROR_SUCCESS && error != ERROR_IO_PENDING && error != ERROR_MORE_DATA) {
+            return HRESULT_FROM_WIN32(error);
+        }
+        if (::WaitForSingleObject(p_rOverlapped.hEvent, p_Timeout) != WAIT_OBJECT_0) {
+            ::CancelIo(s_hPipe);
+            ::GetOverlappedResult(s_hPipe, &p_rOverlapped, &p_rBytes, TRUE);
+            return HRESULT_FROM_WIN32(ERROR_TIMEOUT);
+        }
+        if (!::GetOverlappedResult(s_hPipe, &p_rOverlapped, &p_rBytes, FALSE)) {
+            return HRESULT_FROM_WIN32(::GetLastError());
+        }
+        return S_OK;
+    }
+
+} // namespace PCC
@@ -0,0 +1,369 @@
+// COMPluginMetadataCache.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <stdafx.h>
+#include <COMPluginMetadataCache.h>
+#include <StOleStr.h>
+#include <StringUtils.h>
+
+#include <string>
+#include <vector>
+
+#include <atlbase.h>
+
+
+namespace
+{
+    // Key where COM plugin metadata is cached. It is not a subkey of the settings
+    // key on purpose, so that updating the cache does not invalidate plugins snapshots.
+    const wchar_t* const    PCC_COM_PLUGINS_CACHE_KEY   = L"Software\\clechasseur\\PathCopyCopyCache\\COMPlugins";
+
+    // Registry keys and values describing COM servers.
+    const wchar_t* const    CLSID_KEY_PREFIX            = L"CLSID\\";
+    const wchar_t* const    INPROC_SERVER_SUBKEY        = L"\\InprocServer32";
+    const wchar_t* const    LOCAL_SERVER_SUBKEY         = L"\\LocalServer32";
+    const wchar_t* const    CODE_BASE_VALUE             = L"CodeBase";
+    const wchar_t* const    FILE_URI_PREFIX             = L"file:///";
+
+    // Values stored in a plugin's cache key.
+    const wchar_t* const    CACHE_DESCRIPTION           = L"Description";
+    const wchar_t* const    CACHE_GROUP_ID              = L"GroupId";
+    const wchar_t* const    CACHE_GROUP_POSITION        = L"GroupPosition";
+    const wchar_t* const    CACHE_ICON_FILE             = L"IconFile";
+    const wchar_t* const    CACHE_USE_DEFAULT_ICON      = L"UseDefaultIcon";
+    const wchar_t* const    CACHE_ENABLED_SCOPE         = L"EnabledScope";
+    const wchar_t* const    CACHE_FREE_THREADED         = L"FreeThreaded";
+    const wchar_t* const    CACHE_PATH_CACHE_TTL        = L"PathCacheTimeToLive";
+    const wchar_t* const    CACHE_REGISTRATION_STAMP    = L"RegistrationStamp";
+    const wchar_t* const    CACHE_SERVER_STAMP          = L"ServerStamp";
+    const wchar_t* const    CACHE_FAILURE               = L"Failure";
+
+    //
+    // Reads a string value from a registry key.
+    //
+    // @param p_rKey Key to read from.
+    // @param p_pValueName Name of value to read.
+    // @param p_rValue Where to store the value.
+    // @return true if the value was read successfully.
+    //
+    bool QueryString(ATL::CRegKey& p_rKey,
+                     const wchar_t* const p_pValueName,
+                     std::wstring& p_rValue)
+    {
+        ULONG chars = 0;
+        bool found = p_rKey.QueryStringValue(p_pValueName, nullptr, &chars) == ERROR_SUCCESS;
+        if (found) {
+            std::vector<wchar_t> vBuffer(chars + 1, L'\0');
+            chars = static_cast<ULONG>(vBuffer.size());
+            found = p_rKey.QueryStringValue(p_pValueName, &*vBuffer.begin(), &chars) == ERROR_SUCCESS;
+            if (found) {
+                p_rValue = &*vBuffer.begin();
+            }
+        }
+        return found;
+    }
+
+    //
+    // Converts a FILETIME to a single 64-bit value.
+    //
+    // @param p_FileTime File time to convert.
+    // @return File time as a 64-bit value.
+    //
+    ULONGLONG FileTimeToStamp(const FILETIME& p_FileTime)
+    {
+        ULARGE_INTEGER stamp;
+        stamp.LowPart = p_FileTime.dwLowDateTime;
+        stamp.HighPart = p_FileTime.dwHighDateTime;
+        return stamp.QuadPart;
+    }
+
+    //
+    // Returns the path of the cache key of a COM plugin, relative to HKCU.
+    //
+    // @param p_CLSID ID of COM plugin.
+    // @param p_rKeyPath Where to store the key path.
+    // @return true if path could be computed.
+    //
+    bool GetCacheKeyPath(const CLSID& p_CLSID,
+                         std::wstring& p_rKeyPath)
+    {
+        StOleStr clsidAsString;
+        bool success = SUCCEEDED(::StringFromCLSID(p_CLSID, &clsidAsString));
+        if (success) {
+            p_rKeyPath = PCC_COM_PLUGINS_CACHE_KEY;
+            p_rKeyPath += L"\\";
+            p_rKeyPath += clsidAsString.Get();
+        }
+        return success;
+    }
+
+} // anonymous namespace
+
+namespace PCC
+{
+    //
+    // Fetches cached metadata of a COM plugin, if it is still valid.
+    //
+    // @param p_CLSID ID of COM plugin.
+    // @param p_rMetadata Where to store metadata if found.
+    // @return true if valid metadata was found in the cache.
+    //
+    bool COMPluginMetadataCache::Get(const CLSID& p_CLSID,
+                                     Plugins::COMPluginMetadata& p_rMetadata)
+    {
+        bool found = false;
+
+        std::wstring keyPath;
+        ULONGLONG registrationStamp = 0, serverStamp = 0;
+        if (GetCacheKeyPath(p_CLSID, keyPath) && GetStamps(p_CLSID, registrationStamp, serverStamp)) {
+            ATL::CRegKey key;
+            if (key.Open(HKEY_CURRENT_USER, keyPath.c_str(), KEY_READ) == ERROR_SUCCESS) {
+                ULONGLONG cachedRegistrationStamp = 0, cachedServerStamp = 0;
+                Plugins::COMPluginMetadata metadata;
+                DWORD groupId = 0, groupPos = 0, useDefaultIcon = 0, enabledScope = 0, freeThreaded = 0, pathCacheTimeToLive = 0;
+                found = key.QueryQWORDValue(CACHE_REGISTRATION_STAMP, cachedRegistrationStamp) == ERROR_SUCCESS &&
+                        key.QueryQWORDValue(CACHE_SERVER_STAMP, cachedServerStamp) == ERROR_SUCCESS &&
+                        cachedRegistrationStamp == registrationStamp &&
+                        cachedServerStamp == serverStamp &&
+                        QueryString(key, CACHE_DESCRIPTION, metadata.m_Description) &&
+                        !metadata.m_Description.empty() &&
+                        key.QueryDWORDValue(CACHE_GROUP_ID, groupId) == ERROR_SUCCESS &&
+                        key.QueryDWORDValue(CACHE_GROUP_POSITION, groupPos) == ERROR_SUCCESS &&
+                        QueryString(key, CACHE_ICON_FILE, metadata.m_IconFile) &&
+                        key.QueryDWORDValue(CACHE_USE_DEFAULT_ICON, useDefaultIcon) == ERROR_SUCCESS &&
+                        key.QueryDWORDValue(CACHE_ENABLED_SCOPE, enabledScope) == ERROR_SUCCESS &&
+                        enabledScope <= static_cast<DWORD>(Plugins::COMPluginEnabledScope::Always) &&
+                        key.QueryDWORDValue(CACHE_FREE_THREADED, freeThreaded) == ERROR_SUCCESS &&
+                        key.QueryDWORDValue(CACHE_PATH_CACHE_TTL, pathCacheTimeToLive) == ERROR_SUCCESS;
+                if (found) {
+                    metadata.m_GroupId = groupId;
+                    metadata.m_GroupPosition = groupPos;
+                    metadata.m_UseDefaultIcon = useDefaultIcon != 0;
+                    metadata.m_EnabledScope = static_cast<Plugins::COMPluginEnabledScope>(enabledScope);
+                    metadata.m_FreeThreaded = freeThreaded != 0;
+                    metadata.m_PathCacheTimeToLive = pathCacheTimeToLive;
+                    p_rMetadata = metadata;
+                }
+            }
+        }
+
+        return found;
+    }
+
+    //
+    // Stores metadata of a COM plugin in the cache. Should be called
+    // with metadata fetched from an actual instance of the plugin.
+    //
+    // @param p_CLSID ID of COM plugin.
+    // @param p_Metadata Plugin metadata.
+    //
+    void COMPluginMetadataCache::Update(const CLSID& p_CLSID,
+                                        const Plugins::COMPluginMetadata& p_Metadata)
+    {
+        std::wstring keyPath;
+        ULONGLONG registrationStamp = 0, serverStamp = 0;
+        if (GetCacheKeyPath(p_CLSID, keyPath) && GetStamps(p_CLSID, registrationStamp, serverStamp)) {
+            ATL::CRegKey key;
+            if (key.Create(HKEY_CURRENT_USER, keyPath.c_str(), REG_NONE,
+                           REG_OPTION_NON_VOLATILE, KEY_READ | KEY_WRITE) == ERROR_SUCCESS) {
+                // Write stamps last so that a partially-written entry is never considered valid.
+                key.DeleteValue(CACHE_REGISTRATION_STAMP);
+                key.DeleteValue(CACHE_FAILURE);
+                key.SetStringValue(CACHE_DESCRIPTION, p_Metadata.m_Description.c_str());
+                key.SetDWORDValue(CACHE_GROUP_ID, p_Metadata.m_GroupId);
+                key.SetDWORDValue(CACHE_GROUP_POSITION, p_Metadata.m_GroupPosition);
+                key.SetStringValue(CACHE_ICON_FILE, p_Metadata.m_IconFile.c_str());
+                key.SetDWORDValue(CACHE_USE_DEFAULT_ICON, p_Metadata.m_UseDefaultIcon ? 1 : 0);
+                key.SetDWORDValue(CACHE_ENABLED_SCOPE, static_cast<DWORD>(p_Metadata.m_EnabledScope));
+                key.SetDWORDValue(CACHE_FREE_THREADED, p_Metadata.m_FreeThreaded ? 1 : 0);
+                key.SetDWORDValue(CACHE_PATH_CACHE_TTL, p_Metadata.m_PathCacheTimeToLive);
+                key.SetQWORDValue(CACHE_SERVER_STAMP, serverStamp);
+                key.SetQWORDValue(CACHE_REGISTRATION_STAMP, registrationStamp);
+            }
+        }
+    }
+
+    //
+    // Refreshes cached metadata of a COM plugin by creating an instance
+    // of the plugin. If the plugin cannot be created, its cached metadata
+    // is removed instead.
+    //
+    // @param p_CLSID ID of COM plugin.
+    //
+    void COMPluginMetadataCache::Refresh(const CLSID& p_CLSID)
+    {
+        try {
+            Plugins::COMPlugin plugin(p_CLSID);
+            Update(p_CLSID, plugin.GetMetadata());
+        } catch (const Plugins::COMPluginError&) {
+            Remove(p_CLSID);
+        }
+    }
+
+    //
+    // Removes cached metadata of a COM plugin.
+    //
+    // @param p_CLSID ID of COM plugin.
+    //
+    void COMPluginMetadataCache::Remove(const CLSID& p_CLSID)
+    {
+        StOleStr clsidAsString;
+        if (SUCCEEDED(::StringFromCLSID(p_CLSID, &clsidAsString))) {
+            ATL::CRegKey key;
+            if (key.Open(HKEY_CURRENT_USER, PCC_COM_PLUGINS_CACHE_KEY, KEY_READ | KEY_WRITE) == ERROR_SUCCESS) {
+                key.DeleteSubKey(clsidAsString.Get());
+            }
+        }
+    }
+
+    //
+    // Checks if a COM plugin is known to fail activation with its current
+    // registration (see SetFailure).
+    //
+    // @param p_CLSID ID of COM plugin.
+    // @param p_rResult Where to store the error returned when the plugin
+    //                  was last activated, if it is known to fail.
+    // @return true if plugin is known to fail activation.
+    //
+    bool COMPluginMetadataCache::GetFailure(const CLSID& p_CLSID,
+                                            HRESULT& p_rResult)
+    {
+        bool found = false;
+
+        std::wstring keyPath;
+        ULONGLONG registrationStamp = 0, serverStamp = 0;
+        if (GetCacheKeyPath(p_CLSID, keyPath) && GetStamps(p_CLSID, registrationStamp, serverStamp)) {
+            ATL::CRegKey key;
+            if (key.Open(HKEY_CURRENT_USER, keyPath.c_str(), KEY_READ) == ERROR_SUCCESS) {
+                ULONGLONG cachedRegistrationStamp = 0, cachedServerStamp = 0;
+                DWORD failure = 0;
+                found = key.QueryDWORDValue(CACHE_FAILURE, failure) == ERROR_SUCCESS &&
+                        key.QueryQWORDValue(CACHE_REGISTRATION_STAMP, cachedRegistrationStamp) == ERROR_SUCCESS &&
+                        key.QueryQWORDValue(CACHE_SERVER_STAMP, cachedServerStamp) == ERROR_SUCCESS &&
+                        cachedRegistrationStamp == registrationStamp &&
+                        cachedServerStamp == serverStamp;
+                if (found) {
+                    p_rResult = static_cast<HRESULT>(failure);
+                }
+            }
+        }
+
+        return found;
+    }
+
+    //
+    // Records that a COM plugin failed activation. Its cached metadata, if any,
+    // is replaced by the error; it will be ignored once the plugin's registration
+    // or server file changes.
+    //
+    // @param p_CLSID ID of COM plugin.
+    // @param p_Result Error returned when activating the plugin.
+    //
+    void COMPluginMetadataCache::SetFailure(const CLSID& p_CLSID,
+                                            const HRESULT p_Result)
+    {
+        std::wstring keyPath;
+        ULONGLONG registrationStamp = 0, serverStamp = 0;
+        if (GetCacheKeyPath(p_CLSID, keyPath) && GetStamps(p_CLSID, registrationStamp, serverStamp)) {
+            Remove(p_CLSID);
+            ATL::CRegKey key;
+            if (key.Create(HKEY_CURRENT_USER, keyPath.c_str(), REG_NONE,
+                           REG_OPTION_NON_VOLATILE, KEY_READ | KEY_WRITE) == ERROR_SUCCESS) {
+                key.SetDWORDValue(CACHE_FAILURE, static_cast<DWORD>(p_Result));
+                key.SetQWORDValue(CACHE_SERVER_STAMP, serverStamp);
+                key.SetQWORDValue(CACHE_REGISTRATION_STAMP, registrationStamp);
+            }
+        }
+    }
+
+    //
+    // Computes stamps identifying the current registration of a COM plugin.
+    // The registration stamp is the last write time of the plugin's server
+    // registry key; the server stamp is the last write time of the server file
+    // (or 0 if it cannot be found). If any of those change, cached metadata
+    // for the plugin is no longer considered valid.
+    //
+    // @param p_CLSID ID of COM plugin.
+    // @param p_rRegistrationStamp Where to store registration stamp.
+    // @param p_rServerStamp Where to store server stamp.
+    // @return true if stamps could be computed, e.g. if plugin is registered.
+    //
+    bool COMPluginMetadataCache::GetStamps(const CLSID& p_CLSID,
+                                           ULONGLONG& p_rRegistrationStamp,
+                                           ULONGLONG& p_rServerStamp)
+    {
+        StOleStr clsidAsString;
+        if (FAILED(::StringFromCLSID(p_CLSID, &clsidAsString))) {
+            return false;
+        }
+        std::wstring clsidKeyPath(CLSID_KEY_PREFIX);
+        clsidKeyPath += clsidAsString.Get();
+
+        // Look for an in-process server first, then for a local server.
+        ATL::CRegKey serverKey;
+        bool inProc = serverKey.Open(HKEY_CLASSES_ROOT, (clsidKeyPath + INPROC_SERVER_SUBKEY).c_str(),
+                                     KEY_READ) == ERROR_SUCCESS;
+        if (!inProc && serverKey.Open(HKEY_CLASSES_ROOT, (clsidKeyPath + LOCAL_SERVER_SUBKEY).c_str(),
+                                      KEY_READ) != ERROR_SUCCESS) {
+            return false;
+        }
+        FILETIME keyWriteTime = { 0 };
+        if (::RegQueryInfoKeyW(serverKey, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+                               nullptr, nullptr, nullptr, nullptr, &keyWriteTime) != ERROR_SUCCESS) {
+            return false;
+        }
+        p_rRegistrationStamp = FileTimeToStamp(keyWriteTime);
+
+        // Find server file. For .NET plugins, the in-process server is the runtime;
+        // in such a case, use the assembly's code base when available. For local servers,
+        // the value is a command line that can include arguments.
+        std::wstring serverPath;
+        if (inProc && QueryString(serverKey, CODE_BASE_VALUE, serverPath) &&
+            serverPath.compare(0, ::wcslen(FILE_URI_PREFIX), FILE_URI_PREFIX) == 0) {
+
+            serverPath.erase(0, ::wcslen(FILE_URI_PREFIX));
+            StringUtils::ReplaceChar(serverPath, L'/', L'\\');
+        } else if (!QueryString(serverKey, nullptr, serverPath)) {
+            serverPath.clear();
+        } else if (!inProc) {
+            if (!serverPath.empty() && serverPath.front() == L'"') {
+                std::wstring::size_type closingQuotePos = serverPath.find(L'"', 1);
+                serverPath = serverPath.substr(1, closingQuotePos != std::wstring::npos
+                                                  ? closingQuotePos - 1 : std::wstring::npos);
+            } else {
+                serverPath = serverPath.substr(0, serverPath.find(L' '));
+            }
+        }
+        wchar_t expandedPath[MAX_PATH + 1] = { 0 };
+        DWORD expandedSize = ::ExpandEnvironmentStringsW(serverPath.c_str(), expandedPath, MAX_PATH + 1);
+        if (expandedSize > 0 && expandedSize <= MAX_PATH + 1) {
+            serverPath = expandedPath;
+        }
+
+        WIN32_FILE_ATTRIBUTE_DATA fileData = { 0 };
+        p_rServerStamp = !serverPath.empty() && ::GetFileAttributesExW(serverPath.c_str(), GetFileExInfoStandard, &fileData)
+                       ? FileTimeToStamp(fileData.ftLastWriteTime) : 0;
+
+        return true;
+    }
+
+} // namespace PCC
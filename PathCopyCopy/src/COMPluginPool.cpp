@@ -0,0 +1,197 @@
+// COMPluginPool.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <stdafx.h>
+#include <COMPluginPool.h>
+#include <COMPlugin.h>
+#include <COMPluginMetadataCache.h>
+
+#include <algorithm>
+
+
+namespace PCC
+{
+    COMPluginPool::ThreadPoolM  COMPluginPool::s_mPools;
+    MeasuredMutex               COMPluginPool::s_Lock(L"COMPluginPool::s_Lock");
+
+    //
+    // Returns an instance of a COM plugin for the current thread. If a
+    // pooled instance exists, it is reused; otherwise, a new one is created.
+    // New instances use cached metadata when valid, in which case the actual
+    // COM plugin is only created when needed; otherwise, it is created right
+    // away and its metadata is cached for next time. Plugins that failed to
+    // be created are not retried until their registration changes.
+    //
+    // @param p_CLSID ID of COM co-class that implements the plugin.
+    // @param p_Reusable Whether the plugin can be reused. If false, a new
+    //                   instance is always created and is not pooled.
+    // @param p_Isolated Whether the plugin should be loaded in the COM plugin
+    //                   host process instead of in our process.
+    // @return Plugin instance.
+    // @throw Plugins::COMPluginError If the plugin could not be created.
+    //
+    COMPluginPool::COMPluginSP COMPluginPool::GetPlugin(const CLSID& p_CLSID,
+                                                        const bool p_Reusable,
+                                                        const bool p_Isolated)
+    {
+        if (p_Reusable) {
+            std::lock_guard<MeasuredMutex> lock(s_Lock);
+            ThreadPool& rPool = GetThreadPool();
+            auto it = rPool.m_mspPlugins.find(p_CLSID);
+            if (it != rPool.m_mspPlugins.end() && it->second->Isolated() == p_Isolated) {
+                return it->second;
+            }
+        }
+
+        // Create the plugin outside the lock, since this can take a while.
+        // Since pools are per-thread, nobody else can create it for us meanwhile.
+        COMPluginSP spPlugin;
+        Plugins::COMPluginMetadata metadata;
+        HRESULT failure = S_OK;
+        if (COMPluginMetadataCache::Get(p_CLSID, metadata)) {
+            spPlugin = std::make_shared<Plugins::COMPlugin>(p_CLSID, metadata, p_Isolated);
+        } else if (COMPluginMetadataCache::GetFailure(p_CLSID, failure)) {
+            throw Plugins::COMPluginError(failure);
+        } else {
+            try {
+                spPlugin = std::make_shared<Plugins::COMPlugin>(p_CLSID, p_Isolated);
+            } catch (const Plugins::COMPluginError& error) {
+                COMPluginMetadataCache::SetFailure(p_CLSID, error.Result());
+                throw;
+            }
+            COMPluginMetadataCache::Update(p_CLSID, spPlugin->GetMetadata());
+        }
+        std::lock_guard<MeasuredMutex> lock(s_Lock);
+        ThreadPool& rPool = GetThreadPool();
+        if (p_Reusable) {
+            rPool.m_mspPlugins[p_CLSID] = spPlugin;
+        } else {
+            rPool.m_mspPlugins.erase(p_CLSID);
+        }
+        return spPlugin;
+    }
+
+    //
+    // Releases all plugins pooled for the current thread except those specified.
+    // Used to release plugins that are no longer registered.
+    //
+    // @param p_vCLSIDs IDs of plugins to keep in the pool.
+    //
+    void COMPluginPool::KeepOnly(const CLSIDV& p_vCLSIDs)
+    {
+        // Move plugins to release out of the pool so that they are released outside the lock.
+        COMPluginSPM mspToRelease;
+        {
+            std::lock_guard<MeasuredMutex> lock(s_Lock);
+            ThreadPool& rPool = GetThreadPool();
+            for (auto it = rPool.m_mspPlugins.begin(); it != rPool.m_mspPlugins.end(); ) {
+                if (std::find_if(p_vCLSIDs.cbegin(), p_vCLSIDs.cend(), [&](const CLSID& p_CLSID) {
+                                    return CLSIDEqualTo()(p_CLSID, it->first);
+                                 }) == p_vCLSIDs.cend()) {
+                    mspToRelease.insert(*it);
+                    it = rPool.m_mspPlugins.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+    }
+
+    //
+    // Releases pooled plugins that can safely be released from any thread:
+    // pools of threads that have exited, and isolated plugins, which are
+    // not bound to our apartments since they live in the COM plugin host.
+    // Other plugins are kept, since they must be released by the thread
+    // that created them. Used to trim our memory usage when idle.
+    //
+    void COMPluginPool::ReleaseUnused()
+    {
+        // Move plugins to release out of the pools so that they are released outside the lock.
+        COMPluginSPV vspToRelease;
+        {
+            std::lock_guard<MeasuredMutex> lock(s_Lock);
+            DropExitedThreadPools(vspToRelease);
+            for (auto& rPoolPair : s_mPools) {
+                COMPluginSPM& rmspPlugins = rPoolPair.second.m_mspPlugins;
+                for (auto it = rmspPlugins.begin(); it != rmspPlugins.end(); ) {
+                    if (it->second->Isolated()) {
+                        vspToRelease.push_back(std::move(it->second));
+                        it = rmspPlugins.erase(it);
+                    } else {
+                        ++it;
+                    }
+                }
+            }
+        }
+    }
+
+    //
+    // Returns the pool of plugins for the current thread, creating it if needed.
+    // Also drops pools of threads that have since exited. Must be called with
+    // the lock held.
+    //
+    // @return Reference to the current thread's pool.
+    //
+    COMPluginPool::ThreadPool& COMPluginPool::GetThreadPool()
+    {
+        const DWORD threadId = ::GetCurrentThreadId();
+        auto it = s_mPools.find(threadId);
+        if (it == s_mPools.end()) {
+            // Drop pools created by threads that have since exited.
+            COMPluginSPV vspToRelease;
+            DropExitedThreadPools(vspToRelease);
+
+            // Keep a handle to the owner thread. As long as we hold it, the
+            // thread's ID cannot be reused by the system.
+            ThreadPool& rPool = s_mPools[threadId];
+            HANDLE hOwnerThread = NULL;
+            if (::DuplicateHandle(::GetCurrentProcess(), ::GetCurrentThread(), ::GetCurrentProcess(),
+                                  &hOwnerThread, SYNCHRONIZE, FALSE, 0)) {
+                rPool.m_hOwnerThread.Attach(hOwnerThread);
+            }
+            return rPool;
+        }
+        return it->second;
+    }
+
+    //
+    // Drops pools created by threads that have since exited. Must be called
+    // with the lock held.
+    //
+    // @param p_rvspToRelease Where to move plugins of the dropped pools,
+    //                        so that the caller can release them outside the lock.
+    //
+    void COMPluginPool::DropExitedThreadPools(COMPluginSPV& p_rvspToRelease)
+    {
+        for (auto it = s_mPools.begin(); it != s_mPools.end(); ) {
+            if (::WaitForSingleObject(it->second.m_hOwnerThread, 0) != WAIT_TIMEOUT) {
+                for (auto& rPluginPair : it->second.m_mspPlugins) {
+                    p_rvspToRelease.push_back(std::move(rPluginPair.second));
+                }
+                it = s_mPools.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+} // namespace PCC
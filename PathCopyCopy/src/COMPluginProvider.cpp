@@ -32,4 +32,28 @@ namespace PCC
     {
     }
 
+    //
+    // Checks whether an instance of a COM plugin can be reused once
+    // created. By default, all plugins can be reused.
+    //
+    // @param p_CLSID ID of COM plugin.
+    // @return true if plugin instances can be reused.
+    //
+    bool COMPluginProvider::CanReuseCOMPlugin(const CLSID& /*p_CLSID*/) const
+    {
+        return true;
+    }
+
+    //
+    // Checks whether a COM plugin should be loaded in the COM plugin host
+    // process instead of in our process. By default, no plugin is isolated.
+    //
+    // @param p_CLSID ID of COM plugin.
+    // @return true if plugin should be isolated.
+    //
+    bool COMPluginProvider::ShouldIsolateCOMPlugin(const CLSID& /*p_CLSID*/) const
+    {
+        return false;
+    }
+
 } // namespace PCC
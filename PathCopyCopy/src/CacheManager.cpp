@@ -0,0 +1,147 @@
+// CacheManager.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <stdafx.h>
+#include <CacheManager.h>
+#include <COMPluginPool.h>
+#include <DFSReferralCache.h>
+#include <FQDNCache.h>
+#include <IconCache.h>
+#include <PluginsSnapshot.h>
+#include <RegexCache.h>
+
+
+namespace
+{
+    const DWORD     CHECK_PERIOD_MS     = 60 * 1000;        // Delay between two checks of whether caches should be trimmed.
+    const DWORD     IDLE_TRIM_DELAY_MS  = 10 * 60 * 1000;   // Inactivity delay after which caches are trimmed.
+
+} // anonymous namespace
+
+namespace PCC
+{
+    // Static members of CacheManager
+    HANDLE          CacheManager::s_hTimer = NULL;
+    ATL::CHandle    CacheManager::s_hLowMemory;
+    DWORD           CacheManager::s_LastActivityTime = 0;
+    bool            CacheManager::s_Trimmed = false;
+    std::mutex      CacheManager::s_Lock;
+
+    //
+    // Records that our caches are being used, which delays idle trimming.
+    // Starts monitoring if it isn't started yet. Called whenever the shell
+    // requests one of our menu objects.
+    //
+    void CacheManager::NotifyActivity()
+    {
+        std::lock_guard<std::mutex> lock(s_Lock);
+        s_LastActivityTime = ::GetTickCount();
+        s_Trimmed = false;
+
+        if (s_hLowMemory == NULL) {
+            // If this fails, we'll only trim when idle.
+            s_hLowMemory.Attach(::CreateMemoryResourceNotification(LowMemoryResourceNotification));
+        }
+        if (s_hTimer == NULL && !::CreateTimerQueueTimer(&s_hTimer, NULL, &CacheManager::OnTimer, nullptr,
+                                                         CHECK_PERIOD_MS, CHECK_PERIOD_MS, WT_EXECUTEDEFAULT)) {
+
+            // Caches will simply not be trimmed.
+            s_hTimer = NULL;
+        }
+    }
+
+    //
+    // Releases cached data that can be released safely from any thread.
+    // Caches bound to other threads (like COM plugins created by threads
+    // that are still alive) are left alone. Everything that's released
+    // will be cached again when next needed.
+    //
+    void CacheManager::Trim()
+    {
+        IconCache::Release();
+        RegexCache::Clear();
+        PluginsSnapshot::ReleaseUnused();
+        COMPluginPool::ReleaseUnused();
+        FQDNCache::Flush();
+        DFSReferralCache::Flush();
+    }
+
+    //
+    // Stops monitoring and releases our resources. Must be called before
+    // our DLL is unloaded, since the timer could otherwise call into it.
+    // Monitoring will resume on the next call to NotifyActivity.
+    //
+    void CacheManager::Stop()
+    {
+        // Delete timer outside the lock, since callbacks need it.
+        HANDLE hTimer = NULL;
+        {
+            std::lock_guard<std::mutex> lock(s_Lock);
+            hTimer = s_hTimer;
+            s_hTimer = NULL;
+        }
+        if (hTimer != NULL) {
+            ::DeleteTimerQueueTimer(NULL, hTimer, INVALID_HANDLE_VALUE);
+        }
+
+        // Close notification, unless we started monitoring again in the meantime.
+        std::lock_guard<std::mutex> lock(s_Lock);
+        if (s_hTimer == NULL) {
+            s_hLowMemory.Close();
+        }
+    }
+
+    //
+    // Called periodically by the thread pool. Trims caches if they haven't
+    // been used for a while or if memory is low.
+    //
+    // @param p_pContext Unused.
+    // @param p_TimedOut Unused; always TRUE for timers.
+    //
+    void CALLBACK CacheManager::OnTimer(PVOID /*p_pContext*/,
+                                        BOOLEAN /*p_TimedOut*/)
+    {
+        bool trim = false;
+        {
+            std::lock_guard<std::mutex> lock(s_Lock);
+            if (s_hTimer == NULL) {
+                // We're being stopped.
+                return;
+            }
+
+            BOOL lowMemory = FALSE;
+            if (s_hLowMemory != NULL && ::QueryMemoryResourceNotification(s_hLowMemory, &lowMemory) && lowMemory) {
+                trim = true;
+            } else if (!s_Trimmed && ::GetTickCount() - s_LastActivityTime >= IDLE_TRIM_DELAY_MS) {
+                trim = true;
+            }
+            if (trim) {
+                s_Trimmed = true;
+            }
+        }
+
+        // Trim outside the lock so that activity is not blocked meanwhile.
+        if (trim) {
+            Trim();
+        }
+    }
+
+} // namespace PCC
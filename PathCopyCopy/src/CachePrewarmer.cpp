@@ -0,0 +1,117 @@
+// CachePrewarmer.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+
+#include <stdafx.h>
+#include <CachePrewarmer.h>
+#include <dllmain.h>
+#include <IconCache.h>
+#include <PathCopyCopySettings.h>
+#include <Plugin.h>
+#include <PluginsSnapshot.h>
+#include <PluginUtils.h>
+#include <StCoInitialize.h>
+
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <windows.h>
+
+
+namespace PCC
+{
+    // Static members
+    bool        CachePrewarmer::s_Started = false;
+    std::mutex  CachePrewarmer::s_Lock;
+
+    //
+    // Starts prewarming caches in the background, unless it has already been
+    // started in this process. Returns immediately.
+    //
+    void CachePrewarmer::Start()
+    {
+        {
+            std::lock_guard<std::mutex> lock(s_Lock);
+            if (s_Started) {
+                return;
+            }
+            s_Started = true;
+        }
+
+        // The thread can outlive the objects we create, so make sure our DLL
+        // is not unloaded before it completes.
+        _AtlModule.Lock();
+        try {
+            std::thread(&CachePrewarmer::Prewarm).detach();
+        } catch (...) {
+            // Could not start the thread; caches will be filled on first use.
+            _AtlModule.Unlock();
+        }
+    }
+
+    //
+    // Prewarms caches. Called on a background thread.
+    //
+    void CachePrewarmer::Prewarm()
+    {
+        // We're not in a hurry; let the shell do its thing first.
+        ::SetThreadPriority(::GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+
+        try {
+            // COM plugins need an apartment. It must outlive the plugins we create.
+            StCoInitialize coInitialize;
+
+            if (Settings().GetPrewarmCaches()) {
+                // Create plugins in a snapshot that is not cached: snapshots are bound
+                // to the thread that creates them, so this one can't be used by the shell.
+                // Creating it fills the caches shared by all snapshots, however.
+                const std::unique_ptr<PluginsSnapshot> upSnapshot = std::make_unique<PluginsSnapshot>(0);
+                const SettingsSnapshot& rSettings = upSnapshot->GetSettingsSnapshot();
+
+                // Decode the icons that will be shown in menus and scale them to the system size.
+                const int iconWidth = ::GetSystemMetrics(SM_CXSMICON);
+                const int iconHeight = ::GetSystemMetrics(SM_CYSMICON);
+                IconCache::GetScaledIcon(IconCache::GetPCCIcon(), iconWidth, iconHeight);
+                for (const PluginSP& spPlugin : upSnapshot->GetPluginsInDefaultOrder()) {
+                    if (!spPlugin->IsSeparator() && !spPlugin->UseDefaultIcon()) {
+                        std::wstring iconFile = spPlugin->IconFile();
+                        if (iconFile.empty()) {
+                            iconFile = rSettings.GetIconFileForPlugin(spPlugin->Id()).value_or(std::wstring());
+                        }
+                        if (!iconFile.empty()) {
+                            IconCache::GetScaledIcon(IconCache::GetIconForIconFile(iconFile), iconWidth, iconHeight);
+                        }
+                    }
+                }
+
+                // Load network information used by plugins that compute network paths.
+                PluginUtils::PrewarmNetworkCaches();
+            }
+        } catch (...) {
+            // Prewarming is optional; caches will be filled on first use.
+        }
+
+        _AtlModule.Unlock();
+    }
+
+} // namespace PCC
@@ -0,0 +1,170 @@
+// ClipboardRenderWindow.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <stdafx.h>
+#include <ClipboardRenderWindow.h>
+#include <dllmain.h>
+#include <StClipboard.h>
+
+#include <memory>
+
+
+namespace
+{
+    const wchar_t* const    RENDER_WINDOW_CLASS_NAME    = L"PathCopyCopyClipboardRenderWindow";  // Class name of clipboard render windows.
+
+} // anonymous namespace
+
+namespace PCC
+{
+    //
+    // Creates a hidden window on the calling thread and gives it ownership
+    // of the clipboard, announcing data in the given format without
+    // rendering it.
+    //
+    // @param p_Format Clipboard format to provide.
+    // @param p_Renderer Function used to render data, if requested.
+    // @return true if clipboard data was announced successfully.
+    //
+    bool ClipboardRenderWindow::Create(const UINT p_Format,
+                                       const Renderer& p_Renderer)
+    {
+        if (!RegisterWindowClass()) {
+            return false;
+        }
+
+        HWND hWnd = ::CreateWindowExW(0, RENDER_WINDOW_CLASS_NAME, L"", 0, 0, 0, 0, 0, HWND_MESSAGE,
+                                      NULL, CPathCopyCopyModule::HInstance(), nullptr);
+        if (hWnd == NULL) {
+            return false;
+        }
+
+        // Windows can outlive the caller, so make sure our DLL is not unloaded
+        // before they are destroyed. The lock is released in WM_NCDESTROY.
+        std::unique_ptr<State> upState(new State { p_Format, p_Renderer });
+        _AtlModule.Lock();
+        ::SetWindowLongPtrW(hWnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(upState.release()));
+
+        // Acquire clipboard and announce our format. This will cause the previous
+        // clipboard owner to lose ownership, even if it was another of our windows.
+        bool announced = false;
+        {
+            StClipboard acquireClipboard(hWnd);
+            if (acquireClipboard.InitResult()) {
+                // When announcing data, SetClipboardData returns NULL even on success.
+                ::SetLastError(ERROR_SUCCESS);
+                announced = ::SetClipboardData(p_Format, NULL) != NULL || ::GetLastError() == ERROR_SUCCESS;
+            }
+        }
+        if (!announced) {
+            ::DestroyWindow(hWnd);
+        }
+        return announced;
+    }
+
+    //
+    // Registers the class of our windows, if it's not already registered.
+    //
+    // @return true if class is registered.
+    //
+    bool ClipboardRenderWindow::RegisterWindowClass()
+    {
+        WNDCLASSEXW windowClass = { 0 };
+        windowClass.cbSize = sizeof(windowClass);
+        windowClass.lpfnWndProc = &ClipboardRenderWindow::WindowProc;
+        windowClass.hInstance = CPathCopyCopyModule::HInstance();
+        windowClass.lpszClassName = RENDER_WINDOW_CLASS_NAME;
+        return ::RegisterClassExW(&windowClass) != 0 || ::GetLastError() == ERROR_CLASS_ALREADY_EXISTS;
+    }
+
+    //
+    // Renders the data of a window and puts it in the clipboard.
+    // The clipboard must be open and owned by the window.
+    //
+    // @param p_State State of the window.
+    //
+    void ClipboardRenderWindow::Render(const State& p_State)
+    {
+        HANDLE hData = NULL;
+        try {
+            hData = p_State.m_Renderer();
+        } catch (...) {
+            // Leave data unrendered.
+        }
+        if (hData != NULL && ::SetClipboardData(p_State.m_Format, hData) == NULL) {
+            // Clipboard did not take ownership of the data.
+            ::GlobalFree(hData);
+        }
+    }
+
+    //
+    // Window procedure of our windows.
+    //
+    // @param p_hWnd Window handle.
+    // @param p_Msg Message to process.
+    // @param p_wParam Message parameter.
+    // @param p_lParam Message parameter.
+    // @return Result of message processing.
+    //
+    LRESULT CALLBACK ClipboardRenderWindow::WindowProc(HWND p_hWnd,
+                                                       UINT p_Msg,
+                                                       WPARAM p_wParam,
+                                                       LPARAM p_lParam)
+    {
+        State* pState = reinterpret_cast<State*>(::GetWindowLongPtrW(p_hWnd, GWLP_USERDATA));
+        switch (p_Msg) {
+            case WM_RENDERFORMAT: {
+                // An application needs our data. Clipboard is already open.
+                if (pState != nullptr && static_cast<UINT>(p_wParam) == pState->m_Format) {
+                    Render(*pState);
+                }
+                return 0;
+            }
+            case WM_RENDERALLFORMATS: {
+                // We're being destroyed while still owning the clipboard;
+                // render data now so that it remains available.
+                if (pState != nullptr && ::OpenClipboard(p_hWnd)) {
+                    if (::GetClipboardOwner() == p_hWnd) {
+                        Render(*pState);
+                    }
+                    ::CloseClipboard();
+                }
+                return 0;
+            }
+            case WM_DESTROYCLIPBOARD: {
+                // Another window took ownership of the clipboard; we're no longer needed.
+                ::PostMessageW(p_hWnd, WM_CLOSE, 0, 0);
+                return 0;
+            }
+            case WM_NCDESTROY: {
+                if (pState != nullptr) {
+                    ::SetWindowLongPtrW(p_hWnd, GWLP_USERDATA, 0);
+                    delete pState;
+                    _AtlModule.Unlock();
+                }
+                break;
+            }
+        }
+        return ::DefWindowProcW(p_hWnd, p_Msg, p_wParam, p_lParam);
+    }
+
+} // namespace PCC
@@ -0,0 +1,209 @@
+// ClipboardWriter.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <stdafx.h>
+#include <ClipboardWriter.h>
+#include <dllmain.h>
+#include <StClipboard.h>
+#include <Trace.h>
+
+#include <thread>
+
+
+namespace
+{
+    // Delay before the first retry, in milliseconds. Doubled after every attempt.
+    const DWORD     INITIAL_RETRY_DELAY_MS  = 10;
+
+    // Maximum delay between two attempts, in milliseconds.
+    const DWORD     MAX_RETRY_DELAY_MS      = 500;
+
+    // Number of retries before giving up (about 2.5 seconds in total).
+    const int       MAX_RETRIES             = 10;
+
+} // anonymous namespace
+
+namespace PCC
+{
+    // Static members of ClipboardWriter
+    std::atomic<unsigned long>  ClipboardWriter::s_Generation(0);
+
+    //
+    // Stores data in the clipboard. If the clipboard cannot be opened right
+    // away, data is published later from a worker thread and this returns
+    // immediately.
+    //
+    // @param p_hOwnerWnd Window that will own the clipboard if data can be stored
+    //                    right away. Can be NULL.
+    // @param p_rvData Data to store, in order. The first data is the main format;
+    //                 if it cannot be stored, the others are not stored either.
+    //                 Upon exit, the vector will be empty, since we assume
+    //                 ownership of all memory blocks.
+    // @return true if data was stored or will be stored later, false if
+    //         the clipboard was available but data could not be stored.
+    //
+    bool ClipboardWriter::Publish(const HWND p_hOwnerWnd,
+                                  DataV& p_rvData)
+    {
+        StTraceEvent traceEvent(L"ClipboardWriter::Publish");
+        const unsigned long generation = ++s_Generation;
+        if (p_rvData.empty()) {
+            return true;
+        }
+
+        // Try right away first; most of the time, the clipboard is available.
+        bool published = false;
+        if (TryPublish(p_hOwnerWnd, p_rvData, nullptr, published)) {
+            return published;
+        }
+
+        // Clipboard is busy: retry from a worker thread. The thread can
+        // outlive our caller, so make sure our DLL is not unloaded before it completes.
+        DataV vData;
+        vData.swap(p_rvData);
+        ATL::_pAtlModule->Lock();
+        try {
+            std::thread(&ClipboardWriter::PublishWithRetry, vData, generation).detach();
+        } catch (...) {
+            ATL::_pAtlModule->Unlock();
+            FreeData(vData);
+            return false;
+        }
+        return true;
+    }
+
+    //
+    // Drops the data of any pending publication. Must be called before
+    // storing data in the clipboard by other means (for instance using
+    // delayed rendering), so that pending data does not overwrite it.
+    //
+    void ClipboardWriter::CancelPending()
+    {
+        ++s_Generation;
+    }
+
+    //
+    // Tries to open the clipboard and store data in it.
+    //
+    // @param p_hOwnerWnd Window that will own the clipboard. Can be NULL.
+    // @param p_rvData Data to store. If the clipboard can be opened,
+    //                 we assume ownership of all memory blocks and
+    //                 the vector will be empty upon exit.
+    // @param p_pGeneration Value of s_Generation for this publication, if
+    //                      it's pending. If another publication superseded
+    //                      it by the time the clipboard is opened, the
+    //                      clipboard is left untouched. Can be nullptr.
+    // @param p_rPublished Upon exit, if the clipboard could be opened,
+    //                     will indicate whether the main data was stored.
+    // @return true if the clipboard could be opened.
+    //
+    bool ClipboardWriter::TryPublish(const HWND p_hOwnerWnd,
+                                     DataV& p_rvData,
+                                     const unsigned long* const p_pGeneration,
+                                     bool& p_rPublished)
+    {
+        // Opening the clipboard can take a while if it's busy, so make
+        // sure we're still current before emptying it.
+        StClipboard acquireClipboard(p_hOwnerWnd, false);
+        if (!acquireClipboard.InitResult()) {
+            return false;
+        }
+        if (p_pGeneration != nullptr && s_Generation != *p_pGeneration) {
+            p_rPublished = false;
+            FreeData(p_rvData);
+            return true;
+        }
+        if (!::EmptyClipboard()) {
+            return false;
+        }
+
+        p_rPublished = true;
+        for (Data& data : p_rvData) {
+            if (p_rPublished && data.m_Format != 0 && data.m_hData != NULL &&
+                ::SetClipboardData(data.m_Format, data.m_hData) != NULL) {
+
+                // Clipboard now owns the data, avoid freeing it.
+                data.m_hData = NULL;
+            } else if (&data == &p_rvData.front()) {
+                // Main format could not be stored; skip the others.
+                p_rPublished = false;
+            }
+        }
+        FreeData(p_rvData);
+        return true;
+    }
+
+    //
+    // Body of the worker thread publishing data when the clipboard is busy.
+    // Retries with an exponential backoff until data is stored, until we
+    // give up or until another publication supersedes this one.
+    //
+    // @param p_vData Data to store. We assume ownership of all memory blocks.
+    // @param p_Generation Value of s_Generation for this publication.
+    //
+    void ClipboardWriter::PublishWithRetry(DataV p_vData,
+                                           const unsigned long p_Generation)
+    {
+        // The clipboard needs an owner window for SetClipboardData to succeed.
+        // Data remains in the clipboard once the window is destroyed.
+        HWND hWnd = ::CreateWindowExW(0, L"STATIC", L"", 0, 0, 0, 0, 0, HWND_MESSAGE,
+                                      NULL, CPathCopyCopyModule::HInstance(), nullptr);
+        DWORD delay = INITIAL_RETRY_DELAY_MS;
+        bool opened = false;
+        for (int retry = 0; !opened && retry < MAX_RETRIES && s_Generation == p_Generation; ++retry) {
+            ::Sleep(delay);
+            delay = (std::min)(delay * 2, MAX_RETRY_DELAY_MS);
+            if (s_Generation == p_Generation) {
+                bool published = false;
+                opened = TryPublish(hWnd, p_vData, &p_Generation, published);
+            }
+        }
+        if (!opened) {
+            FreeData(p_vData);
+            if (s_Generation == p_Generation) {
+                // We gave up; let the user know the paths were not copied.
+                ::MessageBeep(MB_ICONWARNING);
+            }
+        }
+        if (hWnd != NULL) {
+            ::DestroyWindow(hWnd);
+        }
+
+        ATL::_pAtlModule->Unlock();
+    }
+
+    //
+    // Frees the memory blocks of data that was not stored in the clipboard.
+    //
+    // @param p_rvData Data to free. Upon exit, will be empty.
+    //
+    void ClipboardWriter::FreeData(DataV& p_rvData)
+    {
+        for (const Data& data : p_rvData) {
+            if (data.m_hData != NULL) {
+                ::GlobalFree(data.m_hData);
+            }
+        }
+        p_rvData.clear();
+    }
+
+} // namespace PCC
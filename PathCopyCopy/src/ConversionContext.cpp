@@ -0,0 +1,129 @@
+// ConversionContext.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+
+#include <stdafx.h>
+#include <ConversionContext.h>
+#include <PluginProvider.h>
+
+
+namespace PCC
+{
+    //
+    // Default constructor. Creates a context without settings or plugin provider.
+    //
+    ConversionContext::ConversionContext()
+        : m_pSettings(nullptr),
+          m_pSettingsSnapshot(nullptr),
+          m_pPluginProvider(nullptr),
+          m_pMetadataCache(nullptr)
+    {
+    }
+
+    //
+    // Constructor.
+    //
+    // @param p_pSettings Optional object to access PCC settings.
+    // @param p_pSettingsSnapshot Optional snapshot of settings used during conversions.
+    // @param p_pPluginProvider Optional object to access other plugins.
+    //
+    ConversionContext::ConversionContext(const Settings* const p_pSettings,
+                                         const SettingsSnapshot* const p_pSettingsSnapshot,
+                                         const PluginProvider* const p_pPluginProvider)
+        : m_pSettings(p_pSettings),
+          m_pSettingsSnapshot(p_pSettingsSnapshot),
+          m_pPluginProvider(p_pPluginProvider),
+          m_pMetadataCache(nullptr)
+    {
+    }
+
+    //
+    // Constructor for a context used for a single operation. Copies another
+    // context, adding a cache of file metadata shared by plugins.
+    //
+    // @param p_Context Context to copy.
+    // @param p_pMetadataCache Optional cache of file metadata for the operation.
+    //
+    ConversionContext::ConversionContext(const ConversionContext& p_Context,
+                                         FileMetadataCache* const p_pMetadataCache)
+        : m_pSettings(p_Context.m_pSettings),
+          m_pSettingsSnapshot(p_Context.m_pSettingsSnapshot),
+          m_pPluginProvider(p_Context.m_pPluginProvider),
+          m_pMetadataCache(p_pMetadataCache)
+    {
+    }
+
+    //
+    // Returns the object to access PCC settings.
+    //
+    // @return Settings object, or nullptr if there is none.
+    //
+    const Settings* ConversionContext::GetSettings() const
+    {
+        return m_pSettings;
+    }
+
+    //
+    // Returns the immutable copy of settings used during conversions.
+    //
+    // @return Settings snapshot, or nullptr if there is none.
+    //
+    const SettingsSnapshot* ConversionContext::GetSettingsSnapshot() const
+    {
+        return m_pSettingsSnapshot;
+    }
+
+    //
+    // Returns the object to access other plugins.
+    //
+    // @return Plugin provider, or nullptr if there is none.
+    //
+    const PluginProvider* ConversionContext::GetPluginProvider() const
+    {
+        return m_pPluginProvider;
+    }
+
+    //
+    // Returns the cache of file metadata of the current operation.
+    //
+    // @return Metadata cache, or nullptr if there is none.
+    //
+    FileMetadataCache* ConversionContext::GetMetadataCache() const
+    {
+        return m_pMetadataCache;
+    }
+
+    //
+    // Uses the plugin provider to compute the path of a file with the plugin
+    // of the given ID, in this context.
+    //
+    // @param p_PluginId ID of plugin to use.
+    // @param p_rPath Path to modify in-place.
+    // @return true if plugin was found and used, false otherwise.
+    //
+    bool ConversionContext::GetPathWithPlugin(const GUID& p_PluginId,
+                                              std::wstring& p_rPath) const
+    {
+        return m_pPluginProvider != nullptr && m_pPluginProvider->GetPathWithPlugin(p_PluginId, p_rPath, *this);
+    }
+
+} // namespace PCC
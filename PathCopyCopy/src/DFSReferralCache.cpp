@@ -0,0 +1,247 @@
+// DFSReferralCache.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <stdafx.h>
+#include <DFSReferralCache.h>
+#include <NetworkEnvironment.h>
+
+#include <cwctype>
+
+
+namespace
+{
+    // Maximum time during which referrals are cached, in milliseconds.
+    const DWORD     MAX_REFERRAL_TTL_MS     = 10 * 60 * 1000;
+
+    // Time during which paths that are not in a DFS namespace are cached, in milliseconds.
+    const DWORD     NOT_DFS_TTL_MS          = 60 * 1000;
+
+    // Number of cached entries above which expired entries are purged.
+    const size_t    MAX_ENTRIES             = 4096;
+
+    //
+    // Returns the size of the beginning of a normalized network path
+    // containing a given number of components. The leading "\\" is
+    // not a component: \\server\share has two components.
+    //
+    // @param p_Key Normalized network path.
+    // @param p_Components Number of components.
+    // @return Size of the components, or std::wstring::npos if p_Key
+    //         does not have that many components.
+    //
+    std::wstring::size_type ComponentsSize(const std::wstring& p_Key,
+                                           const size_t p_Components)
+    {
+        std::wstring::size_type size = 1;
+        for (size_t i = 0; i < p_Components; ++i) {
+            if (size >= p_Key.size()) {
+                return std::wstring::npos;
+            }
+            size = p_Key.find(L'\\', size + 1);
+            if (size == std::wstring::npos) {
+                size = p_Key.size();
+            }
+        }
+        return size;
+    }
+
+} // anonymous namespace
+
+namespace PCC
+{
+    // Static members of DFSReferralCache
+    DFSReferralCache::EntryM    DFSReferralCache::s_mEntries;
+    std::mutex                  DFSReferralCache::s_Lock;
+
+    //
+    // Resolves a network path in a DFS namespace to the network path of its
+    // target. If the path's directory, DFS link or namespace root has not
+    // been seen recently, the DFS client is queried; this can require a
+    // round trip to the DFS server.
+    //
+    // @param p_rUNCPath Network path, without trailing separator. Upon exit,
+    //                   will contain the path on the DFS target, if any.
+    // @return true if the path was in a DFS namespace and was resolved.
+    //
+    bool DFSReferralCache::Resolve(std::wstring& p_rUNCPath)
+    {
+        if (p_rUNCPath.size() < 3 || p_rUNCPath.compare(0, 2, L"\\\\") != 0) {
+            return false;
+        }
+
+        // Keys are uppercase paths with backslashes only, so that all spellings match.
+        std::wstring key(p_rUNCPath);
+        for (wchar_t& c : key) {
+            c = c == L'/' ? L'\\' : static_cast<wchar_t>(std::towupper(c));
+        }
+        while (key.size() > 2 && key.back() == L'\\') {
+            key.pop_back();
+        }
+        const std::wstring::size_type rootSize = ComponentsSize(key, 2);
+        if (rootSize == std::wstring::npos || key[rootSize - 1] == L'\\') {
+            // Not a \\server\share path.
+            return false;
+        }
+
+        Entry entry;
+        bool found = false;
+        {
+            std::lock_guard<std::mutex> lock(s_Lock);
+            found = FindEntry(key, rootSize, entry);
+        }
+        if (!found) {
+            entry = LookupEntry(p_rUNCPath, key, rootSize);
+        }
+
+        const bool resolved = !entry.m_Target.empty() && entry.m_EntryPathSize <= p_rUNCPath.size();
+        if (resolved) {
+            std::wstring targetPath;
+            targetPath.reserve(entry.m_Target.size() + p_rUNCPath.size() - entry.m_EntryPathSize);
+            targetPath.append(entry.m_Target).append(p_rUNCPath, entry.m_EntryPathSize, std::wstring::npos);
+            p_rUNCPath = std::move(targetPath);
+        }
+        return resolved;
+    }
+
+    //
+    // Flushes all cached referrals.
+    //
+    void DFSReferralCache::Flush()
+    {
+        std::lock_guard<std::mutex> lock(s_Lock);
+        s_mEntries.clear();
+    }
+
+    //
+    // Looks for a cached entry applying to a path, starting with the path
+    // itself and walking up to its namespace root. Entries of DFS links
+    // apply to all paths below them (links cannot be nested); entries of
+    // namespace roots and directories only apply to their direct children,
+    // since other paths could be below a link we haven't seen yet.
+    // Expired entries are removed along the way.
+    //
+    // Must be called with s_Lock held.
+    //
+    // @param p_Key Normalized path.
+    // @param p_RootSize Size of the namespace root in p_Key.
+    // @param p_rEntry Upon success, will contain the entry found.
+    // @return true if an entry was found.
+    //
+    bool DFSReferralCache::FindEntry(const std::wstring& p_Key,
+                                     const std::wstring::size_type p_RootSize,
+                                     Entry& p_rEntry)
+    {
+        const DWORD now = ::GetTickCount();
+        const std::wstring::size_type parentSize = p_Key.find_last_of(L'\\');
+        std::wstring::size_type size = p_Key.size();
+        for (;;) {
+            auto it = s_mEntries.find(p_Key.substr(0, size));
+            if (it != s_mEntries.end()) {
+                if (now - it->second.m_Timestamp >= it->second.m_TimeToLive) {
+                    s_mEntries.erase(it);
+                } else if (it->second.m_CoversSubpaths || size == p_Key.size() || size == parentSize) {
+                    p_rEntry = it->second;
+                    return true;
+                }
+            }
+            if (size <= p_RootSize) {
+                return false;
+            }
+            size = p_Key.rfind(L'\\', size - 1);
+        }
+    }
+
+    //
+    // Queries the DFS client for the referral of a path and caches the
+    // result, both for the DFS root or link returned and for the path's
+    // parent directory.
+    //
+    // @param p_UNCPath Network path.
+    // @param p_Key Normalized p_UNCPath.
+    // @param p_RootSize Size of the namespace root in p_Key.
+    // @return Entry for p_UNCPath.
+    //
+    DFSReferralCache::Entry DFSReferralCache::LookupEntry(const std::wstring& p_UNCPath,
+                                                          const std::wstring& p_Key,
+                                                          const std::wstring::size_type p_RootSize)
+    {
+        // Query outside of the lock, since this can block on the network.
+        NetworkEnvironment::DFSReferral referral;
+        Entry entry;
+        entry.m_Target.clear();
+        entry.m_EntryPathSize = p_RootSize;
+        entry.m_CoversSubpaths = true;
+        entry.m_TimeToLive = NOT_DFS_TTL_MS;
+        if (NetworkEnvironment::Current()->GetDFSReferral(p_UNCPath, referral)) {
+            // The entry path can use another spelling of the host name (ex: the FQDN of
+            // the domain), so find its size in our path by counting its components.
+            size_t components = 0;
+            std::wstring::size_type pos = referral.m_EntryPath.find_first_not_of(L"\\/");
+            while (pos != std::wstring::npos) {
+                ++components;
+                pos = referral.m_EntryPath.find_first_of(L"\\/", pos);
+                if (pos != std::wstring::npos) {
+                    pos = referral.m_EntryPath.find_first_not_of(L"\\/", pos);
+                }
+            }
+            const std::wstring::size_type entryPathSize = ComponentsSize(p_Key, components);
+            if (components >= 2 && entryPathSize != std::wstring::npos && !referral.m_Target.empty()) {
+                entry.m_Target = referral.m_Target;
+                while (entry.m_Target.size() > 2 && entry.m_Target.back() == L'\\') {
+                    entry.m_Target.pop_back();
+                }
+                entry.m_EntryPathSize = entryPathSize;
+                entry.m_CoversSubpaths = entryPathSize > p_RootSize;
+                entry.m_TimeToLive = referral.m_TimeToLive != 0 && referral.m_TimeToLive < MAX_REFERRAL_TTL_MS / 1000
+                    ? referral.m_TimeToLive * 1000
+                    : MAX_REFERRAL_TTL_MS;
+            }
+        }
+        entry.m_Timestamp = ::GetTickCount();
+
+        std::lock_guard<std::mutex> lock(s_Lock);
+        if (s_mEntries.size() >= MAX_ENTRIES) {
+            // Purge expired entries. If all are still valid, start over.
+            for (auto it = s_mEntries.begin(); it != s_mEntries.end(); ) {
+                if (entry.m_Timestamp - it->second.m_Timestamp >= it->second.m_TimeToLive) {
+                    it = s_mEntries.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            if (s_mEntries.size() >= MAX_ENTRIES) {
+                s_mEntries.clear();
+            }
+        }
+        s_mEntries[p_Key.substr(0, entry.m_EntryPathSize)] = entry;
+
+        // Also cache the entry for the parent directory, so that its other files
+        // don't query the DFS client again.
+        const std::wstring::size_type parentSize = p_Key.find_last_of(L'\\');
+        if (parentSize > entry.m_EntryPathSize && !entry.m_CoversSubpaths) {
+            s_mEntries[p_Key.substr(0, parentSize)] = entry;
+        }
+
+        return entry;
+    }
+
+} // namespace PCC
@@ -0,0 +1,249 @@
+// DiagnosticLog.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <stdafx.h>
+#include <DiagnosticLog.h>
+
+#include <cstdio>
+
+
+namespace
+{
+    const wchar_t* const    SETTINGS_KEY            = L"Software\\clechasseur\\PathCopyCopy";  // Key storing user settings.
+    const wchar_t* const    DIAGNOSTIC_LOG_VALUE    = L"DiagnosticLog";     // Value enabling the log; a DWORD.
+    const wchar_t* const    LOG_FOLDER_NAME         = L"PathCopyCopy";      // Name of folder storing log file, in local app data.
+    const wchar_t* const    LOG_FILE_NAME           = L"DiagnosticLog.txt"; // Name of log file.
+    const DWORD             FLUSH_PERIOD_MS         = 1000;                 // Delay between two flushes of events to the log file.
+
+} // anonymous namespace
+
+namespace PCC
+{
+    // Static members of DiagnosticLog
+    DiagnosticLog::Entry    DiagnosticLog::s_Entries[DiagnosticLog::CAPACITY];
+    std::atomic<ULONGLONG>  DiagnosticLog::s_NextEvent(0);
+    std::atomic<bool>       DiagnosticLog::s_Enabled(false);
+    bool                    DiagnosticLog::s_Started = false;
+    HANDLE                  DiagnosticLog::s_hTimer = NULL;
+    std::mutex              DiagnosticLog::s_Lock;
+    ULONGLONG               DiagnosticLog::s_NextFlushed = 0;
+    std::wstring            DiagnosticLog::s_FilePath;
+    std::mutex              DiagnosticLog::s_FlushLock;
+
+    //
+    // Reads our setting and starts recording events if the log is enabled.
+    // The setting is only read once until Stop is called. Called whenever
+    // the shell requests one of our objects.
+    //
+    void DiagnosticLog::Start()
+    {
+        std::lock_guard<std::mutex> lock(s_Lock);
+        if (s_Started) {
+            return;
+        }
+        s_Started = true;
+
+        ATL::CRegKey key;
+        DWORD enabled = 0;
+        if (key.Open(HKEY_CURRENT_USER, SETTINGS_KEY, KEY_READ) != ERROR_SUCCESS ||
+            key.QueryDWORDValue(DIAGNOSTIC_LOG_VALUE, enabled) != ERROR_SUCCESS ||
+            enabled == 0) {
+
+            return;
+        }
+
+        // Find where to store our log file. If we can't, the log stays disabled.
+        wchar_t appDataPath[MAX_PATH + 1];
+        if (FAILED(::SHGetFolderPathW(nullptr, CSIDL_LOCAL_APPDATA | CSIDL_FLAG_CREATE,
+                                      nullptr, SHGFP_TYPE_CURRENT, appDataPath))) {
+            return;
+        }
+        std::wstring filePath = appDataPath;
+        filePath += L'\\';
+        filePath += LOG_FOLDER_NAME;
+        if (!::CreateDirectoryW(filePath.c_str(), nullptr) && ::GetLastError() != ERROR_ALREADY_EXISTS) {
+            return;
+        }
+        filePath += L'\\';
+        filePath += LOG_FILE_NAME;
+        {
+            std::lock_guard<std::mutex> flushLock(s_FlushLock);
+            s_FilePath.swap(filePath);
+        }
+
+        if (::CreateTimerQueueTimer(&s_hTimer, NULL, &DiagnosticLog::OnTimer, nullptr,
+                                    FLUSH_PERIOD_MS, FLUSH_PERIOD_MS, WT_EXECUTEDEFAULT)) {
+            s_Enabled = true;
+        } else {
+            s_hTimer = NULL;
+        }
+    }
+
+    //
+    // Stops recording events and flushes those that were recorded. Must be
+    // called before our DLL is unloaded, since the timer could otherwise call
+    // into it. Our setting will be read again on the next call to Start.
+    //
+    void DiagnosticLog::Stop()
+    {
+        // Delete timer outside the lock so that Start isn't blocked while the timer completes.
+        HANDLE hTimer = NULL;
+        {
+            std::lock_guard<std::mutex> lock(s_Lock);
+            s_Enabled = false;
+            s_Started = false;
+            hTimer = s_hTimer;
+            s_hTimer = NULL;
+        }
+        if (hTimer != NULL) {
+            ::DeleteTimerQueueTimer(NULL, hTimer, INVALID_HANDLE_VALUE);
+            Flush();
+        }
+    }
+
+    //
+    // Records an event in the ring buffer. Should only be called if Enabled
+    // returns true; Trace::WriteEvent does this automatically. Does not block.
+    //
+    // @param p_pName Name of event; must be a literal string.
+    // @param p_pId Optional ID of object the event is about (like a plugin).
+    // @param p_Duration Duration of event.
+    // @param p_Count Number of items processed during event.
+    //
+    void DiagnosticLog::Record(const wchar_t* const p_pName,
+                               const GUID* const p_pId,
+                               const std::chrono::microseconds p_Duration,
+                               const size_t p_Count)
+    {
+        FILETIME now;
+        ::GetSystemTimeAsFileTime(&now);
+
+        // Claim a slot and mark it as being written, so that it is not flushed meanwhile.
+        const ULONGLONG index = s_NextEvent.fetch_add(1, std::memory_order_relaxed);
+        Entry& entry = s_Entries[index % CAPACITY];
+        entry.m_Sequence.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        entry.m_Time = (static_cast<ULONGLONG>(now.dwHighDateTime) << 32) | now.dwLowDateTime;
+        entry.m_ThreadId = ::GetCurrentThreadId();
+        entry.m_pName = p_pName;
+        entry.m_Id = p_pId != nullptr ? *p_pId : GUID_NULL;
+        entry.m_HasId = p_pId != nullptr;
+        entry.m_Duration = static_cast<long long>(p_Duration.count());
+        entry.m_Count = p_Count;
+
+        entry.m_Sequence.store(index + 1, std::memory_order_release);
+    }
+
+    //
+    // Appends events recorded since the last flush to the log file. Events
+    // still being written are left for the next flush; events overwritten
+    // before they could be flushed are counted as dropped.
+    //
+    void DiagnosticLog::Flush()
+    {
+        std::lock_guard<std::mutex> lock(s_FlushLock);
+        const ULONGLONG nextEvent = s_NextEvent.load(std::memory_order_acquire);
+        ULONGLONG dropped = 0;
+        if (nextEvent - s_NextFlushed > CAPACITY) {
+            dropped = nextEvent - CAPACITY - s_NextFlushed;
+            s_NextFlushed = nextEvent - CAPACITY;
+        }
+
+        const DWORD processId = ::GetCurrentProcessId();
+        std::string text;
+        char line[512];
+        for (; s_NextFlushed < nextEvent; ++s_NextFlushed) {
+            // Copy the entry, then make sure it wasn't modified while we did.
+            const Entry& entry = s_Entries[s_NextFlushed % CAPACITY];
+            const ULONGLONG sequence = entry.m_Sequence.load(std::memory_order_acquire);
+            if (sequence == 0 || sequence < s_NextFlushed + 1) {
+                // Event is still being written.
+                break;
+            }
+            const ULONGLONG time = entry.m_Time;
+            const DWORD threadId = entry.m_ThreadId;
+            const wchar_t* const pName = entry.m_pName;
+            const GUID id = entry.m_Id;
+            const bool hasId = entry.m_HasId;
+            const long long duration = entry.m_Duration;
+            const size_t count = entry.m_Count;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence != s_NextFlushed + 1 || entry.m_Sequence.load(std::memory_order_relaxed) != sequence) {
+                // Event was overwritten by a newer one.
+                ++dropped;
+                continue;
+            }
+
+            FILETIME fileTime;
+            fileTime.dwLowDateTime = static_cast<DWORD>(time);
+            fileTime.dwHighDateTime = static_cast<DWORD>(time >> 32);
+            SYSTEMTIME systemTime = { 0 };
+            ::FileTimeToSystemTime(&fileTime, &systemTime);
+            wchar_t idString[40] = { 0 };
+            if (hasId) {
+                ::StringFromGUID2(id, idString, sizeof(idString) / sizeof(wchar_t));
+            }
+            const int lineSize = std::snprintf(line, sizeof(line),
+                "%04u-%02u-%02uT%02u:%02u:%02u.%03uZ pid=%lu tid=%lu %ls%s%ls duration_us=%lld count=%llu\r\n",
+                systemTime.wYear, systemTime.wMonth, systemTime.wDay,
+                systemTime.wHour, systemTime.wMinute, systemTime.wSecond, systemTime.wMilliseconds,
+                processId, threadId, pName, hasId ? " id=" : "", idString,
+                duration, static_cast<unsigned long long>(count));
+            if (lineSize > 0) {
+                text.append(line, (std::min)(static_cast<size_t>(lineSize), sizeof(line) - 1));
+            }
+        }
+        if (dropped != 0) {
+            const int lineSize = std::snprintf(line, sizeof(line), "pid=%lu dropped=%llu\r\n",
+                                               processId, dropped);
+            if (lineSize > 0) {
+                text.append(line, static_cast<size_t>(lineSize));
+            }
+        }
+
+        // Append to the file, which can be shared by many processes (Explorer, file dialogs, etc.)
+        if (!text.empty() && !s_FilePath.empty()) {
+            ATL::CHandle file(::CreateFileW(s_FilePath.c_str(), FILE_APPEND_DATA, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                                            nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL));
+            if (file != INVALID_HANDLE_VALUE) {
+                DWORD written = 0;
+                ::WriteFile(file, text.data(), static_cast<DWORD>(text.size()), &written, nullptr);
+            } else {
+                file.Detach();
+            }
+        }
+    }
+
+    //
+    // Called periodically by the thread pool to flush recorded events.
+    //
+    // @param p_pContext Unused.
+    // @param p_TimedOut Unused; always TRUE for timers.
+    //
+    void CALLBACK DiagnosticLog::OnTimer(PVOID /*p_pContext*/,
+                                         BOOLEAN /*p_TimedOut*/)
+    {
+        Flush();
+    }
+
+} // namespace PCC
@@ -0,0 +1,151 @@
+// DriveConnectivityCache.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <stdafx.h>
+#include <DriveConnectivityCache.h>
+#include <NetworkEnvironment.h>
+
+#include <chrono>
+#include <cwctype>
+#include <thread>
+
+
+namespace
+{
+    // Time to wait for a probe before considering the drive unreachable, in milliseconds.
+    // The probe continues in the background and its result will be used next time.
+    const DWORD     PROBE_TIMEOUT_MS    = 250;
+
+    // Time during which reachable drives are cached, in milliseconds.
+    const DWORD     REACHABLE_TTL_MS    = 30 * 1000;
+
+    // Time during which unreachable drives are cached, in milliseconds.
+    const DWORD     UNREACHABLE_TTL_MS  = 10 * 1000;
+
+} // anonymous namespace
+
+namespace PCC
+{
+    // Static members of DriveConnectivityCache
+    DriveConnectivityCache::EntryM          DriveConnectivityCache::s_mEntries;
+    DriveConnectivityCache::PendingProbeM   DriveConnectivityCache::s_mspPendingProbes;
+    std::mutex                              DriveConnectivityCache::s_Lock;
+
+    //
+    // Checks whether the drive of the given path can currently be accessed.
+    // If the state of the drive is not cached, a probe is started and we wait
+    // for it for a short time. If the probe takes too long, the drive is
+    // considered unreachable, so that callers can use the path as-is instead
+    // of blocking on the network.
+    //
+    // @param p_Path Path to check. Paths that do not start with a drive
+    //               letter are always considered reachable.
+    // @return true if drive of path is reachable.
+    //
+    bool DriveConnectivityCache::IsReachable(const std::wstring& p_Path)
+    {
+        if (p_Path.size() < 2 || p_Path[1] != L':' || !std::iswalpha(p_Path[0])) {
+            return true;
+        }
+        const wchar_t drive = static_cast<wchar_t>(std::towupper(p_Path[0]));
+
+        std::unique_lock<std::mutex> lock(s_Lock);
+
+        // Check if we have a recent result for this drive.
+        auto it = s_mEntries.find(drive);
+        if (it != s_mEntries.end()) {
+            const DWORD ttl = it->second.m_Reachable ? REACHABLE_TTL_MS : UNREACHABLE_TTL_MS;
+            if (::GetTickCount() - it->second.m_Timestamp < ttl) {
+                return it->second.m_Reachable;
+            }
+            s_mEntries.erase(it);
+        }
+
+        // Join a probe in progress for this drive or start a new one.
+        PendingProbeSP spPendingProbe;
+        auto pendingIt = s_mspPendingProbes.find(drive);
+        if (pendingIt != s_mspPendingProbes.end()) {
+            spPendingProbe = pendingIt->second;
+        } else {
+            spPendingProbe = std::make_shared<PendingProbe>();
+            spPendingProbe->m_Done = false;
+            s_mspPendingProbes.emplace(drive, spPendingProbe);
+
+            // The worker thread can outlive our caller, so make sure
+            // our DLL is not unloaded before it completes.
+            ATL::_pAtlModule->Lock();
+            try {
+                std::thread(&DriveConnectivityCache::Probe, drive, spPendingProbe).detach();
+            } catch (...) {
+                // Could not start the thread; don't risk blocking.
+                ATL::_pAtlModule->Unlock();
+                s_mspPendingProbes.erase(drive);
+                return true;
+            }
+        }
+
+        // Wait for the probe to complete, but not for too long.
+        bool reachable = false;
+        if (spPendingProbe->m_Completed.wait_for(lock, std::chrono::milliseconds(PROBE_TIMEOUT_MS),
+                                                 [&]() { return spPendingProbe->m_Done; })) {
+
+            it = s_mEntries.find(drive);
+            reachable = it != s_mEntries.end() && it->second.m_Reachable;
+        }
+        return reachable;
+    }
+
+    //
+    // Flushes all cached probe results. Probes in progress are not
+    // interrupted; their results will still be cached when they complete.
+    //
+    void DriveConnectivityCache::Flush()
+    {
+        std::lock_guard<std::mutex> lock(s_Lock);
+        s_mEntries.clear();
+    }
+
+    //
+    // Probes a drive to determine if it is reachable. Called on a worker thread.
+    // Upon completion, the result is cached and waiting callers are notified.
+    //
+    // @param p_Drive Uppercase drive letter.
+    // @param p_spPendingProbe Object used to notify callers.
+    //
+    void DriveConnectivityCache::Probe(const wchar_t p_Drive,
+                                       const PendingProbeSP& p_spPendingProbe)
+    {
+        Entry entry;
+        entry.m_Reachable = NetworkEnvironment::Current()->IsDriveReachable(p_Drive);
+        entry.m_Timestamp = ::GetTickCount();
+
+        {
+            std::lock_guard<std::mutex> lock(s_Lock);
+            s_mEntries[p_Drive] = entry;
+            s_mspPendingProbes.erase(p_Drive);
+            p_spPendingProbe->m_Done = true;
+        }
+        p_spPendingProbe->m_Completed.notify_all();
+
+        ATL::_pAtlModule->Unlock();
+    }
+
+} // namespace PCC
@@ -0,0 +1,150 @@
+// EnvironmentVariablesCache.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <stdafx.h>
+#include <EnvironmentVariablesCache.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include <cwchar>
+
+
+namespace
+{
+    //
+    // Checks if the value of an environment variable can be used in the
+    // table: it must be a single absolute path, deeper than a drive root.
+    //
+    // @param p_Value Value of environment variable, without trailing backslashes.
+    // @return true if p_Value can be replaced with a reference to its variable.
+    //
+    bool IsReplaceablePath(const std::wstring& p_Value)
+    {
+        const bool isDrivePath = p_Value.size() > 3 && p_Value[1] == L':' && p_Value[2] == L'\\';
+        const bool isUNCPath = p_Value.size() > 2 && p_Value[0] == L'\\' && p_Value[1] == L'\\';
+        return (isDrivePath || isUNCPath) && p_Value.find_first_of(L";%\t\r\n") == std::wstring::npos;
+    }
+
+} // anonymous namespace
+
+namespace PCC
+{
+    // Static members of EnvironmentVariablesCache
+    const DWORD             EnvironmentVariablesCache::CHECK_INTERVAL = 1000;
+    PrefixMap::PrefixMapSP  EnvironmentVariablesCache::s_spPrefixMap;
+    std::wstring            EnvironmentVariablesCache::s_Environment;
+    DWORD                   EnvironmentVariablesCache::s_CheckTime = 0;
+    std::mutex              EnvironmentVariablesCache::s_Lock;
+
+    //
+    // Returns a table replacing paths stored in environment variables with
+    // references to the variables. Each prefix ends with a backslash, so
+    // to replace a path that is exactly the value of a variable, append
+    // a backslash to it before applying the table.
+    //
+    // @return Prefix map; never nullptr, but can be empty.
+    //
+    PrefixMap::PrefixMapSP EnvironmentVariablesCache::GetReversePrefixMap()
+    {
+        std::lock_guard<std::mutex> lock(s_Lock);
+        const DWORD now = ::GetTickCount();
+        if (s_spPrefixMap == nullptr || now - s_CheckTime >= CHECK_INTERVAL) {
+            std::wstring environment = ReadEnvironment();
+            if (s_spPrefixMap == nullptr || environment != s_Environment) {
+                // Paths are case-insensitive on Windows.
+                s_spPrefixMap = std::make_shared<const PrefixMap>(BuildTable(environment), true);
+                s_Environment.swap(environment);
+            }
+            s_CheckTime = now;
+        }
+        return s_spPrefixMap;
+    }
+
+    //
+    // Returns a copy of the environment block of our process.
+    //
+    // @return Environment block: a series of null-terminated "name=value"
+    //         strings. Empty if it could not be read.
+    //
+    std::wstring EnvironmentVariablesCache::ReadEnvironment()
+    {
+        std::wstring environment;
+        wchar_t* const pBlock = ::GetEnvironmentStringsW();
+        if (pBlock != nullptr) {
+            const wchar_t* pEnd = pBlock;
+            while (*pEnd != L'\0') {
+                pEnd += std::wcslen(pEnd) + 1;
+            }
+            environment.assign(pBlock, pEnd);
+            ::FreeEnvironmentStringsW(pBlock);
+        }
+        return environment;
+    }
+
+    //
+    // Builds the contents of the table from an environment block. When many
+    // variables contain the same path, the one with the shortest name is used
+    // (e.g. %windir% over %SystemRoot%) so that the output is predictable.
+    //
+    // @param p_Environment Environment block (see ReadEnvironment).
+    // @return Table contents (see PrefixMap).
+    //
+    std::wstring EnvironmentVariablesCache::BuildTable(const std::wstring& p_Environment)
+    {
+        typedef std::pair<std::wstring, std::wstring> Variable;     // Name and value of a variable.
+        std::vector<Variable> vVariables;
+        std::wstring::size_type begin = 0;
+        while (begin < p_Environment.size()) {
+            std::wstring::size_type end = p_Environment.find(L'\0', begin);
+            if (end == std::wstring::npos) {
+                end = p_Environment.size();
+            }
+
+            // Variables starting with = are hidden ones storing current directories, like =C:.
+            const std::wstring::size_type equalPos = p_Environment.find(L'=', begin + 1);
+            if (p_Environment[begin] != L'=' && equalPos < end) {
+                std::wstring value = p_Environment.substr(equalPos + 1, end - equalPos - 1);
+                while (!value.empty() && value.back() == L'\\') {
+                    value.pop_back();
+                }
+                if (IsReplaceablePath(value)) {
+                    vVariables.emplace_back(p_Environment.substr(begin, equalPos - begin), std::move(value));
+                }
+            }
+            begin = end + 1;
+        }
+        std::sort(vVariables.begin(), vVariables.end(), [](const Variable& p_Var1, const Variable& p_Var2) {
+            return p_Var1.first.size() != p_Var2.first.size() ? p_Var1.first.size() < p_Var2.first.size()
+                                                              : ::_wcsicmp(p_Var1.first.c_str(), p_Var2.first.c_str()) < 0;
+        });
+
+        // PrefixMap uses the first replacement of prefixes appearing more than once.
+        std::wstring table;
+        for (const Variable& variable : vVariables) {
+            table += variable.second + L"\\\t%" + variable.first + L"%\\\n";
+        }
+        return table;
+    }
+
+} // namespace PCC
@@ -0,0 +1,165 @@
+// FQDNCache.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <stdafx.h>
+#include <FQDNCache.h>
+#include <NetworkEnvironment.h>
+#include <PerformanceCounters.h>
+
+#include <chrono>
+#include <thread>
+
+
+namespace
+{
+    // Time to wait for a lookup before giving up and using the host name as-is, in milliseconds.
+    // The lookup continues in the background and its result will be used next time.
+    const DWORD     LOOKUP_TIMEOUT_MS   = 1500;
+
+    // Time during which successful lookups are cached, in milliseconds.
+    const DWORD     RESOLVED_TTL_MS     = 10 * 60 * 1000;
+
+    // Time during which failed lookups are cached, in milliseconds.
+    const DWORD     FAILED_TTL_MS       = 60 * 1000;
+
+} // anonymous namespace
+
+namespace PCC
+{
+    // Static members of FQDNCache
+    FQDNCache::EntryM           FQDNCache::s_mEntries;
+    FQDNCache::PendingLookupM   FQDNCache::s_mspPendingLookups;
+    std::mutex                  FQDNCache::s_Lock;
+
+    //
+    // Returns the fully-qualified domain name (FQDN) of the given host.
+    // If the FQDN is not cached, a lookup is started and we wait for it for
+    // a limited time. If the lookup fails or takes too long, the host name
+    // is returned as-is. If a previous caller already timed out waiting for
+    // the same lookup, we return immediately instead of waiting again.
+    //
+    // @param p_Hostname Host name.
+    // @return FQDN of host, or p_Hostname if it could not be fetched in time.
+    //
+    std::wstring FQDNCache::GetFQDN(const std::wstring& p_Hostname)
+    {
+        std::unique_lock<std::mutex> lock(s_Lock);
+        std::wstring fqdn = p_Hostname;
+
+        // Check if we have a recent result for this host.
+        bool cached = false;
+        auto it = s_mEntries.find(p_Hostname);
+        if (it != s_mEntries.end()) {
+            const DWORD ttl = it->second.m_Resolved ? RESOLVED_TTL_MS : FAILED_TTL_MS;
+            if (::GetTickCount() - it->second.m_Timestamp < ttl) {
+                fqdn = it->second.m_FQDN;
+                cached = true;
+            } else {
+                s_mEntries.erase(it);
+            }
+        }
+        PerformanceCounters::CacheLookup(PerformanceCounters::Cache::FQDN, cached);
+        if (!cached) {
+            // Join a lookup in progress for this host or start a new one.
+            PendingLookupSP spPendingLookup;
+            auto pendingIt = s_mspPendingLookups.find(p_Hostname);
+            if (pendingIt != s_mspPendingLookups.end()) {
+                spPendingLookup = pendingIt->second;
+            } else {
+                spPendingLookup = std::make_shared<PendingLookup>();
+                spPendingLookup->m_Done = false;
+                spPendingLookup->m_TimedOut = false;
+                s_mspPendingLookups.emplace(p_Hostname, spPendingLookup);
+
+                // The worker thread can outlive our caller, so make sure
+                // our DLL is not unloaded before it completes.
+                ATL::_pAtlModule->Lock();
+                try {
+                    std::thread(&FQDNCache::Lookup, p_Hostname, spPendingLookup).detach();
+                } catch (...) {
+                    ATL::_pAtlModule->Unlock();
+                    s_mspPendingLookups.erase(p_Hostname);
+                    spPendingLookup.reset();
+                }
+            }
+
+            // Wait for the lookup to complete, but not for too long.
+            if (spPendingLookup != nullptr && !spPendingLookup->m_TimedOut) {
+                if (spPendingLookup->m_Completed.wait_for(lock, std::chrono::milliseconds(LOOKUP_TIMEOUT_MS),
+                                                          [&]() { return spPendingLookup->m_Done; })) {
+
+                    it = s_mEntries.find(p_Hostname);
+                    if (it != s_mEntries.end()) {
+                        fqdn = it->second.m_FQDN;
+                    }
+                } else {
+                    // Don't make other callers wait for this lookup again.
+                    spPendingLookup->m_TimedOut = true;
+                }
+            }
+        }
+        return fqdn;
+    }
+
+    //
+    // Flushes all cached lookup results. Lookups in progress are not
+    // interrupted; their results will still be cached when they complete.
+    //
+    void FQDNCache::Flush()
+    {
+        std::lock_guard<std::mutex> lock(s_Lock);
+        s_mEntries.clear();
+    }
+
+    //
+    // Performs a lookup for the FQDN of a host. Called on a worker thread.
+    // Upon completion, the result is cached and waiting callers are notified.
+    //
+    // @param p_Hostname Host name.
+    // @param p_spPendingLookup Object used to notify callers.
+    //
+    void FQDNCache::Lookup(const std::wstring& p_Hostname,
+                           const PendingLookupSP& p_spPendingLookup)
+    {
+        Entry entry;
+        entry.m_FQDN = p_Hostname;
+        entry.m_Resolved = false;
+
+        std::wstring fqdn;
+        if (NetworkEnvironment::Current()->GetFQDN(p_Hostname, fqdn)) {
+            entry.m_FQDN = fqdn;
+            entry.m_Resolved = true;
+        }
+        entry.m_Timestamp = ::GetTickCount();
+
+        {
+            std::lock_guard<std::mutex> lock(s_Lock);
+            s_mEntries[p_Hostname] = entry;
+            s_mspPendingLookups.erase(p_Hostname);
+            p_spPendingLookup->m_Done = true;
+        }
+        p_spPendingLookup->m_Completed.notify_all();
+
+        ATL::_pAtlModule->Unlock();
+    }
+
+} // namespace PCC
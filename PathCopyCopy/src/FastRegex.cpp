@@ -0,0 +1,1657 @@
+// FastRegex.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <stdafx.h>
+#include <FastRegex.h>
+
+#include <algorithm>
+#include <cwctype>
+#include <regex>
+#include <utility>
+
+#include <assert.h>
+
+
+namespace
+{
+    // Value used for positions that are not set, like unmatched captures.
+    const size_t    NO_POSITION         = static_cast<size_t>(-1);
+
+    // Value used as maximum number of repetitions for unbounded quantifiers.
+    const size_t    UNBOUNDED           = static_cast<size_t>(-1);
+
+    // Maximum number of repetitions allowed in a bounded quantifier.
+    const size_t    MAX_REPETITIONS     = 1000;
+
+    // Maximum number of instructions in a compiled program.
+    const size_t    MAX_PROGRAM_SIZE    = 10000;
+
+    // Maximum number of characters that can start a match for
+    // FastRegex to look for them before running its program.
+    const size_t    MAX_FIRST_CHARS     = 8;
+
+    //
+    // Throws an exception indicating that a regex uses syntax not
+    // supported by FastRegex. Such regexes might be valid std::wregex.
+    //
+    [[noreturn]] void ThrowUnsupported()
+    {
+        throw std::regex_error(std::regex_constants::error_complexity);
+    }
+
+    //
+    // Returns the value of an hexadecimal digit.
+    //
+    // @param p_Char Character to check.
+    // @return Value of the hexadecimal digit, or -1 if not a digit.
+    //
+    int HexDigitValue(const wchar_t p_Char)
+    {
+        int value = -1;
+        if (p_Char >= L'0' && p_Char <= L'9') {
+            value = p_Char - L'0';
+        } else if (p_Char >= L'a' && p_Char <= L'f') {
+            value = p_Char - L'a' + 10;
+        } else if (p_Char >= L'A' && p_Char <= L'F') {
+            value = p_Char - L'A' + 10;
+        }
+        return value;
+    }
+
+    //
+    // Skips the content of a character class in a regular expression.
+    //
+    // @param p_It Iterator pointing after the opening bracket of the class.
+    // @param p_End Iterator pointing to the end of the regex.
+    // @return Iterator pointing after the closing bracket of the class,
+    //         or p_End if the class is not closed.
+    //
+    std::wstring::const_iterator SkipCharClass(std::wstring::const_iterator p_It,
+                                               const std::wstring::const_iterator p_End)
+    {
+        while (p_It != p_End && *p_It != L']') {
+            if (*p_It++ == L'\\' && p_It != p_End) {
+                ++p_It;
+            }
+        }
+        if (p_It != p_End) {
+            ++p_It;
+        }
+        return p_It;
+    }
+
+} // anonymous namespace
+
+namespace PCC
+{
+    //
+    // FastRegex::Compiler
+    //
+    // Parses a regex pattern and compiles it into a FastRegex program.
+    // The pattern is first parsed into a tree of nodes, which is then
+    // used to emit instructions.
+    //
+    class FastRegex::Compiler final
+    {
+    public:
+                        Compiler(const std::wstring& p_Regex,
+                                 FastRegex& p_rRegex);
+                        Compiler(const Compiler&) = delete;
+        Compiler&       operator=(const Compiler&) = delete;
+
+        void            Compile();
+
+    private:
+        // Types of nodes in the parsed tree.
+        enum class NodeType {
+            Instruction,            // Single instruction; see m_Instruction.
+            Group,                  // Capturing group; see m_Group.
+            Concat,                 // Concatenation of all children.
+            Alternate,              // Alternative between all children.
+            Repeat,                 // Repetition of the only child.
+        };
+
+        // Node in the parsed tree.
+        struct Node;
+        typedef std::unique_ptr<Node> NodeUP;
+        struct Node {
+            NodeType    m_Type;             // Type of node.
+            Instruction m_Instruction;      // Instruction to emit, for NodeType::Instruction.
+            size_t      m_Group;            // Index of capturing group, for NodeType::Group.
+            size_t      m_Min;              // Minimum number of repetitions, for NodeType::Repeat.
+            size_t      m_Max;              // Maximum number of repetitions, for NodeType::Repeat.
+            bool        m_Greedy;           // Whether repetition is greedy, for NodeType::Repeat.
+            std::vector<NodeUP>
+                        m_vChildren;        // Child nodes.
+
+            explicit    Node(const NodeType p_Type);
+        };
+
+        const std::wstring&
+                        m_Regex;            // Pattern to compile.
+        FastRegex&      m_rRegex;           // Regex where to store compiled program.
+        size_t          m_Pos;              // Current parsing position in m_Regex.
+        size_t          m_NumGroups;        // Number of capturing groups parsed so far.
+
+        bool            AtEnd() const;
+        wchar_t         Peek() const;
+        bool            IsQuantifierNext() const;
+
+        NodeUP          ParseDisjunction();
+        NodeUP          ParseAlternative();
+        NodeUP          ParseTerm();
+        NodeUP          ParseAtom();
+        NodeUP          ParseQuantifier(NodeUP p_upAtom,
+                                        const size_t p_NumGroupsBefore);
+        NodeUP          ParseCharClass();
+        bool            ParseCharClassAtom(CharClass& p_rClass,
+                                           wchar_t& p_rChar);
+        bool            ParseCharEscape(wchar_t& p_rChar);
+        size_t          ParseNumber();
+
+        static bool     IsNullable(const Node& p_Node);
+
+        NodeUP          MakeInstruction(const OpCode p_OpCode,
+                                        const wchar_t p_Char = 0,
+                                        const size_t p_Arg1 = 0) const;
+        NodeUP          MakeBuiltinClass(const wchar_t p_Escape);
+
+        void            Analyze();
+        void            GetFirstInstructions(const bool p_StopAtBegin,
+                                             std::vector<size_t>& p_rvPcs,
+                                             bool& p_rReachesBegin) const;
+
+        void            Emit(const Node& p_Node);
+        size_t          EmitInstruction(const OpCode p_OpCode,
+                                        const wchar_t p_Char = 0,
+                                        const size_t p_Arg1 = 0,
+                                        const size_t p_Arg2 = 0);
+    };
+
+    //
+    // FastRegex::Machine
+    //
+    // Pike VM executing a FastRegex program over a specific string.
+    // Keeps track of all possible threads of execution in priority order,
+    // which yields the same leftmost match as a backtracking engine.
+    // Objects are meant to be used for a single operation on one thread;
+    // buffers are allocated once and reused for all searches.
+    //
+    class FastRegex::Machine final
+    {
+    public:
+                        Machine(const FastRegex& p_Regex,
+                                const std::wstring& p_String);
+                        Machine(const Machine&) = delete;
+        Machine&        operator=(const Machine&) = delete;
+
+        bool            Search(const size_t p_Start,
+                               const bool p_Anchored,
+                               const bool p_NotEmpty,
+                               CaptureV& p_rvCaptures);
+
+    private:
+        // List of threads of execution, in priority order.
+        struct ThreadList {
+            std::vector<size_t>
+                        m_vPcs;             // Program counter of each thread.
+            CaptureV    m_vCaptures;        // Capture slots of each thread, one after the other.
+            std::vector<size_t>
+                        m_vMarks;           // Generation in which each instruction was last added.
+            size_t      m_Generation;       // Current generation of the list.
+
+            void        Clear();
+        };
+
+        // Entry of the stack used when adding threads. If m_Slot is
+        // NO_POSITION, the entry is an instruction to visit; otherwise,
+        // it is a capture slot to restore to m_Value.
+        struct StackEntry {
+            size_t      m_Pc;               // Instruction to visit.
+            size_t      m_Slot;             // Capture slot to restore.
+            size_t      m_Value;            // Value to restore.
+        };
+
+        const FastRegex&
+                        m_Regex;            // Regex whose program we execute.
+        const std::wstring&
+                        m_String;           // String to search.
+        size_t          m_NumSlots;         // Number of capture slots per thread.
+        ThreadList      m_Lists[2];         // Current and next thread lists.
+        std::vector<StackEntry>
+                        m_vStack;           // Stack used when adding threads.
+        CaptureV        m_vCaptures;        // Captures of the thread being added.
+
+        void            AddThread(ThreadList& p_rList,
+                                  const size_t p_Pc,
+                                  const size_t p_Pos);
+        bool            IsWordBoundary(const size_t p_Pos) const;
+    };
+
+    //
+    // Node constructor.
+    //
+    // @param p_Type Type of node.
+    //
+    FastRegex::Compiler::Node::Node(const NodeType p_Type)
+        : m_Type(p_Type),
+          m_Instruction(),
+          m_Group(0),
+          m_Min(0),
+          m_Max(0),
+          m_Greedy(true),
+          m_vChildren()
+    {
+    }
+
+    //
+    // Constructor.
+    //
+    // @param p_Regex Pattern to compile.
+    // @param p_rRegex Regex where to store compiled program.
+    //
+    FastRegex::Compiler::Compiler(const std::wstring& p_Regex,
+                                  FastRegex& p_rRegex)
+        : m_Regex(p_Regex),
+          m_rRegex(p_rRegex),
+          m_Pos(0),
+          m_NumGroups(0)
+    {
+    }
+
+    //
+    // Parses the entire pattern and compiles it. The program saves the
+    // bounds of the whole match in the first two capture slots.
+    //
+    void FastRegex::Compiler::Compile()
+    {
+        NodeUP upRoot = ParseDisjunction();
+        if (!AtEnd()) {
+            // Only an unmatched closing parenthesis can stop parsing early.
+            throw std::regex_error(std::regex_constants::error_paren);
+        }
+
+        m_rRegex.m_NumGroups = m_NumGroups + 1;
+        m_rRegex.m_vProgram.clear();
+        EmitInstruction(OpCode::Save, 0, 0);
+        Emit(*upRoot);
+        EmitInstruction(OpCode::Save, 0, 1);
+        EmitInstruction(OpCode::Match);
+
+        Analyze();
+    }
+
+    //
+    // Analyzes the compiled program to find how matches can start,
+    // which allows the Machine to skip positions quickly.
+    //
+    void FastRegex::Compiler::Analyze()
+    {
+        // If all paths go through a "^" before consuming anything, matches can only
+        // start at the beginning of input.
+        std::vector<size_t> vFirstPcs;
+        bool reachesBegin = false;
+        GetFirstInstructions(true, vFirstPcs, reachesBegin);
+        m_rRegex.m_AnchoredAtBegin = reachesBegin && vFirstPcs.empty();
+
+        // If all paths start by matching a literal character, matches can only
+        // start at such characters. When ignoring case, we cannot easily list all
+        // characters that fold to the same value, so we skip this.
+        m_rRegex.m_FirstChars.clear();
+        if (!m_rRegex.m_IgnoreCase) {
+            GetFirstInstructions(false, vFirstPcs, reachesBegin);
+            std::wstring firstChars;
+            for (const size_t pc : vFirstPcs) {
+                const Instruction& instruction = m_rRegex.m_vProgram[pc];
+                if (instruction.m_OpCode != OpCode::Char) {
+                    firstChars.clear();
+                    break;
+                }
+                if (firstChars.find(instruction.m_Char) == std::wstring::npos) {
+                    firstChars.push_back(instruction.m_Char);
+                }
+            }
+            if (firstChars.size() <= MAX_FIRST_CHARS) {
+                m_rRegex.m_FirstChars = std::move(firstChars);
+            }
+        }
+    }
+
+    //
+    // Finds all instructions that can be executed first by the program
+    // and that either consume a character or match.
+    //
+    // @param p_StopAtBegin Whether to stop following paths at "^" assertions.
+    // @param p_rvPcs Where to store the instructions found.
+    // @param p_rReachesBegin Where to store whether a "^" assertion was found.
+    //
+    void FastRegex::Compiler::GetFirstInstructions(const bool p_StopAtBegin,
+                                                   std::vector<size_t>& p_rvPcs,
+                                                   bool& p_rReachesBegin) const
+    {
+        const InstructionV& vProgram = m_rRegex.m_vProgram;
+        std::vector<bool> vVisited(vProgram.size(), false);
+        std::vector<size_t> vStack(1, 0);
+        p_rvPcs.clear();
+        p_rReachesBegin = false;
+        while (!vStack.empty()) {
+            const size_t pc = vStack.back();
+            vStack.pop_back();
+            if (vVisited[pc]) {
+                continue;
+            }
+            vVisited[pc] = true;
+
+            const Instruction& instruction = vProgram[pc];
+            switch (instruction.m_OpCode) {
+                case OpCode::Jump: {
+                    vStack.push_back(instruction.m_Arg1);
+                    break;
+                }
+                case OpCode::Split: {
+                    vStack.push_back(instruction.m_Arg1);
+                    vStack.push_back(instruction.m_Arg2);
+                    break;
+                }
+                case OpCode::AssertBegin: {
+                    p_rReachesBegin = true;
+                    if (!p_StopAtBegin) {
+                        vStack.push_back(pc + 1);
+                    }
+                    break;
+                }
+                case OpCode::Save:
+                case OpCode::AssertEnd:
+                case OpCode::WordBoundary:
+                case OpCode::NotWordBoundary: {
+                    vStack.push_back(pc + 1);
+                    break;
+                }
+                default: {
+                    p_rvPcs.push_back(pc);
+                    break;
+                }
+            }
+        }
+    }
+
+    //
+    // Checks if we reached the end of the pattern.
+    //
+    // @return true if there is nothing left to parse.
+    //
+    bool FastRegex::Compiler::AtEnd() const
+    {
+        return m_Pos >= m_Regex.size();
+    }
+
+    //
+    // Returns the character at the current parsing position.
+    //
+    // @return Current character, or 0 if at end of pattern.
+    //
+    wchar_t FastRegex::Compiler::Peek() const
+    {
+        return !AtEnd() ? m_Regex[m_Pos] : L'\0';
+    }
+
+    //
+    // Checks if the next character in the pattern starts a quantifier.
+    //
+    // @return true if a quantifier follows.
+    //
+    bool FastRegex::Compiler::IsQuantifierNext() const
+    {
+        const wchar_t c = Peek();
+        return !AtEnd() && (c == L'*' || c == L'+' || c == L'?' || c == L'{');
+    }
+
+    //
+    // Parses alternatives separated by "|".
+    //
+    // @return Parsed node.
+    //
+    FastRegex::Compiler::NodeUP FastRegex::Compiler::ParseDisjunction()
+    {
+        NodeUP upNode = ParseAlternative();
+        if (Peek() == L'|' && !AtEnd()) {
+            NodeUP upAlternate(new Node(NodeType::Alternate));
+            upAlternate->m_vChildren.push_back(std::move(upNode));
+            while (Peek() == L'|' && !AtEnd()) {
+                ++m_Pos;
+                upAlternate->m_vChildren.push_back(ParseAlternative());
+            }
+            upNode = std::move(upAlternate);
+        }
+        return upNode;
+    }
+
+    //
+    // Parses a sequence of terms, up to the next "|" or ")".
+    //
+    // @return Parsed node.
+    //
+    FastRegex::Compiler::NodeUP FastRegex::Compiler::ParseAlternative()
+    {
+        NodeUP upConcat(new Node(NodeType::Concat));
+        while (!AtEnd() && Peek() != L'|' && Peek() != L')') {
+            upConcat->m_vChildren.push_back(ParseTerm());
+        }
+        return upConcat;
+    }
+
+    //
+    // Parses an assertion, or an atom followed by an optional quantifier.
+    //
+    // @return Parsed node.
+    //
+    FastRegex::Compiler::NodeUP FastRegex::Compiler::ParseTerm()
+    {
+        NodeUP upNode;
+        const wchar_t c = Peek();
+        if (c == L'^' || c == L'$') {
+            ++m_Pos;
+            upNode = MakeInstruction(c == L'^' ? OpCode::AssertBegin : OpCode::AssertEnd);
+        } else if (c == L'\\' && m_Pos + 1 < m_Regex.size() &&
+                   (m_Regex[m_Pos + 1] == L'b' || m_Regex[m_Pos + 1] == L'B')) {
+            upNode = MakeInstruction(m_Regex[m_Pos + 1] == L'b' ? OpCode::WordBoundary : OpCode::NotWordBoundary);
+            m_Pos += 2;
+        }
+        if (upNode != nullptr) {
+            // Quantified assertions are not worth supporting.
+            if (IsQuantifierNext()) {
+                ThrowUnsupported();
+            }
+        } else {
+            const size_t numGroupsBefore = m_NumGroups;
+            upNode = ParseQuantifier(ParseAtom(), numGroupsBefore);
+        }
+        return upNode;
+    }
+
+    //
+    // Parses a single atom: character, character class or group.
+    //
+    // @return Parsed node.
+    //
+    FastRegex::Compiler::NodeUP FastRegex::Compiler::ParseAtom()
+    {
+        NodeUP upNode;
+        const wchar_t c = m_Regex[m_Pos++];
+        switch (c) {
+            case L'.': {
+                upNode = MakeInstruction(OpCode::Any);
+                break;
+            }
+            case L'(': {
+                if (Peek() == L'?') {
+                    // Only non-capturing groups are supported, not lookaheads.
+                    if (m_Pos + 1 >= m_Regex.size() || m_Regex[m_Pos + 1] != L':') {
+                        ThrowUnsupported();
+                    }
+                    m_Pos += 2;
+                    upNode = ParseDisjunction();
+                } else {
+                    upNode.reset(new Node(NodeType::Group));
+                    upNode->m_Group = ++m_NumGroups;
+                    upNode->m_vChildren.push_back(ParseDisjunction());
+                }
+                if (AtEnd() || Peek() != L')') {
+                    throw std::regex_error(std::regex_constants::error_paren);
+                }
+                ++m_Pos;
+                break;
+            }
+            case L'[': {
+                upNode = ParseCharClass();
+                break;
+            }
+            case L'\\': {
+                if (AtEnd()) {
+                    throw std::regex_error(std::regex_constants::error_escape);
+                }
+                const wchar_t escape = Peek();
+                if (escape == L'd' || escape == L'D' || escape == L'w' ||
+                    escape == L'W' || escape == L's' || escape == L'S') {
+                    ++m_Pos;
+                    upNode = MakeBuiltinClass(escape);
+                } else {
+                    wchar_t escaped = 0;
+                    if (!ParseCharEscape(escaped)) {
+                        ThrowUnsupported();
+                    }
+                    upNode = MakeInstruction(OpCode::Char, escaped);
+                }
+                break;
+            }
+            case L'*':
+            case L'+':
+            case L'?': {
+                throw std::regex_error(std::regex_constants::error_badrepeat);
+            }
+            case L'{':
+            case L'}':
+            case L']': {
+                // Implementations differ on how to handle these.
+                ThrowUnsupported();
+            }
+            default: {
+                upNode = MakeInstruction(OpCode::Char, c);
+                break;
+            }
+        }
+        return upNode;
+    }
+
+    //
+    // Parses an optional quantifier following an atom.
+    //
+    // @param p_upAtom Atom that was just parsed.
+    // @param p_NumGroupsBefore Number of capturing groups parsed before p_upAtom.
+    // @return Parsed node; either a repetition of p_upAtom or p_upAtom itself.
+    //
+    FastRegex::Compiler::NodeUP FastRegex::Compiler::ParseQuantifier(NodeUP p_upAtom,
+                                                                     const size_t p_NumGroupsBefore)
+    {
+        if (!IsQuantifierNext()) {
+            return p_upAtom;
+        }
+
+        NodeUP upRepeat(new Node(NodeType::Repeat));
+        const wchar_t c = m_Regex[m_Pos++];
+        if (c == L'*') {
+            upRepeat->m_Min = 0;
+            upRepeat->m_Max = UNBOUNDED;
+        } else if (c == L'+') {
+            upRepeat->m_Min = 1;
+            upRepeat->m_Max = UNBOUNDED;
+        } else if (c == L'?') {
+            upRepeat->m_Min = 0;
+            upRepeat->m_Max = 1;
+        } else {
+            assert(c == L'{');
+            upRepeat->m_Min = ParseNumber();
+            upRepeat->m_Max = upRepeat->m_Min;
+            if (Peek() == L',' && !AtEnd()) {
+                ++m_Pos;
+                upRepeat->m_Max = (Peek() == L'}') ? UNBOUNDED : ParseNumber();
+            }
+            if (AtEnd() || Peek() != L'}') {
+                ThrowUnsupported();
+            }
+            ++m_Pos;
+            if (upRepeat->m_Max < upRepeat->m_Min) {
+                throw std::regex_error(std::regex_constants::error_badbrace);
+            }
+        }
+        if (Peek() == L'?' && !AtEnd()) {
+            ++m_Pos;
+            upRepeat->m_Greedy = false;
+        }
+        if (IsQuantifierNext()) {
+            ThrowUnsupported();
+        }
+
+        // Implementations disagree on how to handle captures in repeated atoms
+        // and iterations that match an empty string, so we don't support those.
+        if (upRepeat->m_Max > 1 && (m_NumGroups != p_NumGroupsBefore || IsNullable(*p_upAtom))) {
+            ThrowUnsupported();
+        }
+
+        upRepeat->m_vChildren.push_back(std::move(p_upAtom));
+        return upRepeat;
+    }
+
+    //
+    // Parses a character class, like [^a-z]. The opening bracket
+    // must already have been parsed.
+    //
+    // @return Parsed node.
+    //
+    FastRegex::Compiler::NodeUP FastRegex::Compiler::ParseCharClass()
+    {
+        CharClass charClass = { {}, false, false, false, false, false, false, false };
+        if (Peek() == L'^' && !AtEnd()) {
+            ++m_Pos;
+            charClass.m_Negated = true;
+        }
+        if (Peek() == L']') {
+            // Empty classes are handled differently by implementations.
+            ThrowUnsupported();
+        }
+        while (!AtEnd() && Peek() != L']') {
+            wchar_t first = 0;
+            if (ParseCharClassAtom(charClass, first)) {
+                wchar_t last = first;
+                if (Peek() == L'-' && m_Pos + 1 < m_Regex.size() && m_Regex[m_Pos + 1] != L']') {
+                    ++m_Pos;
+                    if (!ParseCharClassAtom(charClass, last)) {
+                        ThrowUnsupported();
+                    }
+                    if (last < first) {
+                        throw std::regex_error(std::regex_constants::error_range);
+                    }
+                }
+                charClass.m_vRanges.emplace_back(first, last);
+            } else if (Peek() == L'-' && m_Pos + 1 < m_Regex.size() && m_Regex[m_Pos + 1] != L']') {
+                // Range starting with a class escape, like [\d-z].
+                ThrowUnsupported();
+            }
+        }
+        if (AtEnd()) {
+            throw std::regex_error(std::regex_constants::error_brack);
+        }
+        ++m_Pos;
+
+        m_rRegex.m_vClasses.push_back(std::move(charClass));
+        return MakeInstruction(OpCode::Class, 0, m_rRegex.m_vClasses.size() - 1);
+    }
+
+    //
+    // Parses a single atom in a character class.
+    //
+    // @param p_rClass Class being parsed; class escapes are added directly to it.
+    // @param p_rChar Where to store the character if the atom is a single character.
+    // @return true if atom is a single character, false if it was a class escape.
+    //
+    bool FastRegex::Compiler::ParseCharClassAtom(CharClass& p_rClass,
+                                                 wchar_t& p_rChar)
+    {
+        bool isChar = true;
+        const wchar_t c = m_Regex[m_Pos++];
+        if (c != L'\\') {
+            p_rChar = c;
+        } else {
+            if (AtEnd()) {
+                throw std::regex_error(std::regex_constants::error_escape);
+            }
+            switch (Peek()) {
+                case L'd':  p_rClass.m_Digits = true;       isChar = false; break;
+                case L'D':  p_rClass.m_NotDigits = true;    isChar = false; break;
+                case L'w':  p_rClass.m_Words = true;        isChar = false; break;
+                case L'W':  p_rClass.m_NotWords = true;     isChar = false; break;
+                case L's':  p_rClass.m_Spaces = true;       isChar = false; break;
+                case L'S':  p_rClass.m_NotSpaces = true;    isChar = false; break;
+                case L'b':  p_rChar = L'\b';                break;  // In classes, \b means backspace.
+                case L'-':  p_rChar = L'-';                 break;
+                default: {
+                    if (!ParseCharEscape(p_rChar)) {
+                        ThrowUnsupported();
+                    }
+                    return true;
+                }
+            }
+            ++m_Pos;
+        }
+        return isChar;
+    }
+
+    //
+    // Parses a character escape. The backslash must already have been parsed.
+    //
+    // @param p_rChar Where to store the escaped character.
+    // @return true if escape was parsed, false if it is not supported.
+    //
+    bool FastRegex::Compiler::ParseCharEscape(wchar_t& p_rChar)
+    {
+        assert(!AtEnd());
+
+        bool parsed = true;
+        const wchar_t escape = m_Regex[m_Pos++];
+        switch (escape) {
+            case L't':  p_rChar = L'\t';    break;
+            case L'n':  p_rChar = L'\n';    break;
+            case L'v':  p_rChar = L'\v';    break;
+            case L'f':  p_rChar = L'\f';    break;
+            case L'r':  p_rChar = L'\r';    break;
+            case L'0': {
+                // \0 is only valid if not followed by other digits (backreferences / octal).
+                p_rChar = L'\0';
+                parsed = !(Peek() >= L'0' && Peek() <= L'9');
+                break;
+            }
+            case L'x':
+            case L'u': {
+                const size_t numDigits = (escape == L'x') ? 2 : 4;
+                if (m_Pos + numDigits > m_Regex.size()) {
+                    parsed = false;
+                } else {
+                    unsigned int value = 0;
+                    for (size_t i = 0; parsed && i < numDigits; ++i) {
+                        const int digit = HexDigitValue(m_Regex[m_Pos + i]);
+                        parsed = digit >= 0;
+                        value = value * 16 + static_cast<unsigned int>(digit);
+                    }
+                    p_rChar = static_cast<wchar_t>(value);
+                    m_Pos += numDigits;
+                }
+                break;
+            }
+            default: {
+                // Identity escapes are only supported for non-alphanumeric characters;
+                // others are backreferences, control escapes or invalid.
+                p_rChar = escape;
+                parsed = !std::iswalnum(escape) && escape != L'_';
+                break;
+            }
+        }
+        return parsed;
+    }
+
+    //
+    // Parses a decimal number in a quantifier.
+    //
+    // @return Number parsed.
+    //
+    size_t FastRegex::Compiler::ParseNumber()
+    {
+        size_t number = 0;
+        const size_t start = m_Pos;
+        while (!AtEnd() && Peek() >= L'0' && Peek() <= L'9') {
+            number = number * 10 + static_cast<size_t>(Peek() - L'0');
+            if (number > MAX_REPETITIONS) {
+                ThrowUnsupported();
+            }
+            ++m_Pos;
+        }
+        if (m_Pos == start) {
+            ThrowUnsupported();
+        }
+        return number;
+    }
+
+    //
+    // Checks if a node of the parsed tree can match an empty string.
+    //
+    // @param p_Node Node to check.
+    // @return true if p_Node can match without consuming characters.
+    //
+    bool FastRegex::Compiler::IsNullable(const Node& p_Node)
+    {
+        bool nullable = false;
+        switch (p_Node.m_Type) {
+            case NodeType::Instruction: {
+                const OpCode opCode = p_Node.m_Instruction.m_OpCode;
+                nullable = opCode != OpCode::Char && opCode != OpCode::Any && opCode != OpCode::Class;
+                break;
+            }
+            case NodeType::Group: {
+                nullable = IsNullable(*p_Node.m_vChildren.front());
+                break;
+            }
+            case NodeType::Concat: {
+                nullable = std::all_of(p_Node.m_vChildren.cbegin(), p_Node.m_vChildren.cend(),
+                                       [](const NodeUP& p_upChild) { return IsNullable(*p_upChild); });
+                break;
+            }
+            case NodeType::Alternate: {
+                nullable = std::any_of(p_Node.m_vChildren.cbegin(), p_Node.m_vChildren.cend(),
+                                       [](const NodeUP& p_upChild) { return IsNullable(*p_upChild); });
+                break;
+            }
+            case NodeType::Repeat: {
+                nullable = p_Node.m_Min == 0 || IsNullable(*p_Node.m_vChildren.front());
+                break;
+            }
+        }
+        return nullable;
+    }
+
+    //
+    // Creates a node emitting a single instruction.
+    //
+    // @param p_OpCode Instruction operation code.
+    // @param p_Char Character to match, for OpCode::Char.
+    // @param p_Arg1 First instruction argument.
+    // @return New node.
+    //
+    FastRegex::Compiler::NodeUP FastRegex::Compiler::MakeInstruction(const OpCode p_OpCode,
+                                                                     const wchar_t p_Char /*= 0*/,
+                                                                     const size_t p_Arg1 /*= 0*/) const
+    {
+        NodeUP upNode(new Node(NodeType::Instruction));
+        upNode->m_Instruction.m_OpCode = p_OpCode;
+        upNode->m_Instruction.m_Char = (p_OpCode == OpCode::Char && m_rRegex.m_IgnoreCase)
+            ? FoldCase(p_Char) : p_Char;
+        upNode->m_Instruction.m_Arg1 = p_Arg1;
+        upNode->m_Instruction.m_Arg2 = 0;
+        return upNode;
+    }
+
+    //
+    // Creates a node matching a builtin character class, like \d.
+    //
+    // @param p_Escape Character following the backslash.
+    // @return New node.
+    //
+    FastRegex::Compiler::NodeUP FastRegex::Compiler::MakeBuiltinClass(const wchar_t p_Escape)
+    {
+        CharClass charClass = { {}, false, false, false, false, false, false, false };
+        switch (p_Escape) {
+            case L'd':  charClass.m_Digits = true;      break;
+            case L'D':  charClass.m_NotDigits = true;   break;
+            case L'w':  charClass.m_Words = true;       break;
+            case L'W':  charClass.m_NotWords = true;    break;
+            case L's':  charClass.m_Spaces = true;      break;
+            case L'S':  charClass.m_NotSpaces = true;   break;
+            default:    assert(false);                  break;
+        }
+        m_rRegex.m_vClasses.push_back(std::move(charClass));
+        return MakeInstruction(OpCode::Class, 0, m_rRegex.m_vClasses.size() - 1);
+    }
+
+    //
+    // Emits the instructions for a node of the parsed tree.
+    //
+    // @param p_Node Node to emit.
+    //
+    void FastRegex::Compiler::Emit(const Node& p_Node)
+    {
+        switch (p_Node.m_Type) {
+            case NodeType::Instruction: {
+                const Instruction& instruction = p_Node.m_Instruction;
+                EmitInstruction(instruction.m_OpCode, instruction.m_Char, instruction.m_Arg1, instruction.m_Arg2);
+                break;
+            }
+            case NodeType::Group: {
+                EmitInstruction(OpCode::Save, 0, p_Node.m_Group * 2);
+                Emit(*p_Node.m_vChildren.front());
+                EmitInstruction(OpCode::Save, 0, p_Node.m_Group * 2 + 1);
+                break;
+            }
+            case NodeType::Concat: {
+                for (const NodeUP& upChild : p_Node.m_vChildren) {
+                    Emit(*upChild);
+                }
+                break;
+            }
+            case NodeType::Alternate: {
+                // Each alternative but the last is preceded by a split to the next one
+                // and followed by a jump to the end.
+                std::vector<size_t> vJumps;
+                for (size_t i = 0; i < p_Node.m_vChildren.size(); ++i) {
+                    if (i + 1 < p_Node.m_vChildren.size()) {
+                        const size_t split = EmitInstruction(OpCode::Split, 0, m_rRegex.m_vProgram.size() + 1);
+                        Emit(*p_Node.m_vChildren[i]);
+                        vJumps.push_back(EmitInstruction(OpCode::Jump));
+                        m_rRegex.m_vProgram[split].m_Arg2 = m_rRegex.m_vProgram.size();
+                    } else {
+                        Emit(*p_Node.m_vChildren[i]);
+                    }
+                }
+                for (const size_t jump : vJumps) {
+                    m_rRegex.m_vProgram[jump].m_Arg1 = m_rRegex.m_vProgram.size();
+                }
+                break;
+            }
+            case NodeType::Repeat: {
+                // Emit mandatory iterations first.
+                const Node& child = *p_Node.m_vChildren.front();
+                for (size_t i = 0; i < p_Node.m_Min; ++i) {
+                    Emit(child);
+                }
+
+                // Emit optional iterations, each preceded by a split to exit the repetition.
+                auto patchSplit = [&](const size_t p_Split, const size_t p_Exit) {
+                    Instruction& split = m_rRegex.m_vProgram[p_Split];
+                    split.m_Arg1 = p_Node.m_Greedy ? p_Split + 1 : p_Exit;
+                    split.m_Arg2 = p_Node.m_Greedy ? p_Exit : p_Split + 1;
+                };
+                if (p_Node.m_Max == UNBOUNDED) {
+                    const size_t split = EmitInstruction(OpCode::Split);
+                    Emit(child);
+                    EmitInstruction(OpCode::Jump, 0, split);
+                    patchSplit(split, m_rRegex.m_vProgram.size());
+                } else {
+                    std::vector<size_t> vSplits;
+                    for (size_t i = p_Node.m_Min; i < p_Node.m_Max; ++i) {
+                        vSplits.push_back(EmitInstruction(OpCode::Split));
+                        Emit(child);
+                    }
+                    for (const size_t split : vSplits) {
+                        patchSplit(split, m_rRegex.m_vProgram.size());
+                    }
+                }
+                break;
+            }
+        }
+    }
+
+    //
+    // Emits a single instruction at the end of the program.
+    //
+    // @param p_OpCode Instruction operation code.
+    // @param p_Char Character to match, for OpCode::Char.
+    // @param p_Arg1 First instruction argument.
+    // @param p_Arg2 Second instruction argument.
+    // @return Index of the new instruction in the program.
+    //
+    size_t FastRegex::Compiler::EmitInstruction(const OpCode p_OpCode,
+                                                const wchar_t p_Char /*= 0*/,
+                                                const size_t p_Arg1 /*= 0*/,
+                                                const size_t p_Arg2 /*= 0*/)
+    {
+        if (m_rRegex.m_vProgram.size() >= MAX_PROGRAM_SIZE) {
+            ThrowUnsupported();
+        }
+        m_rRegex.m_vProgram.push_back(Instruction { p_OpCode, p_Char, p_Arg1, p_Arg2 });
+        return m_rRegex.m_vProgram.size() - 1;
+    }
+
+    //
+    // Clears the list of threads, starting a new generation.
+    //
+    void FastRegex::Machine::ThreadList::Clear()
+    {
+        m_vPcs.clear();
+        ++m_Generation;
+    }
+
+    //
+    // Constructor.
+    //
+    // @param p_Regex Regex whose program to execute.
+    // @param p_String String to search. Must outlive the machine.
+    //
+    FastRegex::Machine::Machine(const FastRegex& p_Regex,
+                                const std::wstring& p_String)
+        : m_Regex(p_Regex),
+          m_String(p_String),
+          m_NumSlots(p_Regex.m_NumGroups * 2),
+          m_Lists(),
+          m_vStack(),
+          m_vCaptures(m_NumSlots, NO_POSITION)
+    {
+        const size_t programSize = m_Regex.m_vProgram.size();
+        for (ThreadList& list : m_Lists) {
+            list.m_vPcs.reserve(programSize);
+            list.m_vCaptures.resize(programSize * m_NumSlots);
+            list.m_vMarks.resize(programSize, 0);
+            list.m_Generation = 0;
+        }
+        m_vStack.reserve(programSize);
+    }
+
+    //
+    // Looks for the leftmost match in the string, starting at a given position.
+    //
+    // @param p_Start Position where to start looking.
+    // @param p_Anchored Whether the match must begin at p_Start.
+    // @param p_NotEmpty Whether to ignore empty matches.
+    // @param p_rvCaptures Where to store captures of the match, if found.
+    // @return true if a match was found.
+    //
+    bool FastRegex::Machine::Search(const size_t p_Start,
+                                    const bool p_Anchored,
+                                    const bool p_NotEmpty,
+                                    CaptureV& p_rvCaptures)
+    {
+        ThreadList* pCurList = &m_Lists[0];
+        ThreadList* pNextList = &m_Lists[1];
+        pCurList->Clear();
+
+        // Check if we can use what we know about the start of matches.
+        const size_t size = m_String.size();
+        bool anchored = p_Anchored;
+        if (m_Regex.m_AnchoredAtBegin) {
+            if (p_Start != 0) {
+                return false;
+            }
+            anchored = true;
+        }
+        const bool useFirstChars = !anchored && !m_Regex.m_FirstChars.empty();
+
+        bool matched = false;
+        for (size_t pos = p_Start; ; ++pos) {
+            // If there are no threads running, skip to the next possible start of match.
+            if (useFirstChars && !matched && pCurList->m_vPcs.empty()) {
+                pos = m_String.find_first_of(m_Regex.m_FirstChars, pos);
+                if (pos == std::wstring::npos) {
+                    break;
+                }
+            }
+
+            // Start a new thread at this position, at the lowest priority,
+            // unless we already found a match (later matches would not be leftmost).
+            if (!matched && (!anchored || pos == p_Start)) {
+                std::fill(m_vCaptures.begin(), m_vCaptures.end(), NO_POSITION);
+                AddThread(*pCurList, 0, pos);
+            }
+            if (pCurList->m_vPcs.empty() && (matched || anchored)) {
+                break;
+            }
+
+            pNextList->Clear();
+            for (size_t i = 0; i < pCurList->m_vPcs.size(); ++i) {
+                const Instruction& instruction = m_Regex.m_vProgram[pCurList->m_vPcs[i]];
+                const auto capturesIt = pCurList->m_vCaptures.cbegin() + i * m_NumSlots;
+                if (instruction.m_OpCode == OpCode::Match) {
+                    if (!p_NotEmpty || *capturesIt != pos) {
+                        // Found a match; lower-priority threads can be dropped.
+                        p_rvCaptures.assign(capturesIt, capturesIt + m_NumSlots);
+                        matched = true;
+                        break;
+                    }
+                } else if (pos < size && m_Regex.Matches(instruction, m_String[pos])) {
+                    std::copy(capturesIt, capturesIt + m_NumSlots, m_vCaptures.begin());
+                    AddThread(*pNextList, pCurList->m_vPcs[i] + 1, pos + 1);
+                }
+            }
+            if (pos >= size) {
+                break;
+            }
+            std::swap(pCurList, pNextList);
+        }
+        return matched;
+    }
+
+    //
+    // Adds a thread to a list, following all instructions that do not
+    // consume characters. Threads are added in priority order.
+    // Uses m_vCaptures as the captures of the thread to add.
+    //
+    // @param p_rList List where to add thread.
+    // @param p_Pc Instruction where the thread starts.
+    // @param p_Pos Position of the thread in the string.
+    //
+    void FastRegex::Machine::AddThread(ThreadList& p_rList,
+                                       const size_t p_Pc,
+                                       const size_t p_Pos)
+    {
+        // Instructions with a single successor are followed directly; the stack
+        // is only used for lower-priority branches and capture slots to restore.
+        m_vStack.clear();
+        size_t pc = p_Pc;
+        for (;;) {
+            bool follow = false;
+            if (p_rList.m_vMarks[pc] != p_rList.m_Generation) {
+                p_rList.m_vMarks[pc] = p_rList.m_Generation;
+
+                const Instruction& instruction = m_Regex.m_vProgram[pc];
+                switch (instruction.m_OpCode) {
+                    case OpCode::Jump: {
+                        pc = instruction.m_Arg1;
+                        follow = true;
+                        break;
+                    }
+                    case OpCode::Split: {
+                        m_vStack.push_back(StackEntry { instruction.m_Arg2, NO_POSITION, 0 });
+                        pc = instruction.m_Arg1;
+                        follow = true;
+                        break;
+                    }
+                    case OpCode::Save: {
+                        m_vStack.push_back(StackEntry { 0, instruction.m_Arg1, m_vCaptures[instruction.m_Arg1] });
+                        m_vCaptures[instruction.m_Arg1] = p_Pos;
+                        ++pc;
+                        follow = true;
+                        break;
+                    }
+                    case OpCode::AssertBegin: {
+                        follow = p_Pos == 0;
+                        ++pc;
+                        break;
+                    }
+                    case OpCode::AssertEnd: {
+                        follow = p_Pos == m_String.size();
+                        ++pc;
+                        break;
+                    }
+                    case OpCode::WordBoundary: {
+                        follow = IsWordBoundary(p_Pos);
+                        ++pc;
+                        break;
+                    }
+                    case OpCode::NotWordBoundary: {
+                        follow = !IsWordBoundary(p_Pos);
+                        ++pc;
+                        break;
+                    }
+                    default: {
+                        // Instruction consuming a character, or a match: add thread.
+                        const size_t index = p_rList.m_vPcs.size();
+                        p_rList.m_vPcs.push_back(pc);
+                        std::copy(m_vCaptures.cbegin(), m_vCaptures.cend(),
+                                  p_rList.m_vCaptures.begin() + index * m_NumSlots);
+                        break;
+                    }
+                }
+            }
+
+            if (!follow) {
+                // Restore captures and find next branch to follow, if any.
+                while (!m_vStack.empty() && m_vStack.back().m_Slot != NO_POSITION) {
+                    m_vCaptures[m_vStack.back().m_Slot] = m_vStack.back().m_Value;
+                    m_vStack.pop_back();
+                }
+                if (m_vStack.empty()) {
+                    break;
+                }
+                pc = m_vStack.back().m_Pc;
+                m_vStack.pop_back();
+            }
+        }
+    }
+
+    //
+    // Checks if there is a word boundary at a position in the string.
+    //
+    // @param p_Pos Position to check.
+    // @return true if characters before and after p_Pos are not both words or non-words.
+    //
+    bool FastRegex::Machine::IsWordBoundary(const size_t p_Pos) const
+    {
+        const bool wordBefore = p_Pos > 0 && IsWordChar(m_String[p_Pos - 1]);
+        const bool wordAfter = p_Pos < m_String.size() && IsWordChar(m_String[p_Pos]);
+        return wordBefore != wordAfter;
+    }
+
+    //
+    // Checks if a character class contains a character, without
+    // considering whether the class is negated.
+    //
+    // @param p_Char Character to check.
+    // @return true if p_Char is in the class.
+    //
+    bool FastRegex::CharClass::Contains(const wchar_t p_Char) const
+    {
+        bool contains = (m_Digits && std::iswdigit(p_Char)) ||
+                        (m_NotDigits && !std::iswdigit(p_Char)) ||
+                        (m_Words && IsWordChar(p_Char)) ||
+                        (m_NotWords && !IsWordChar(p_Char)) ||
+                        (m_Spaces && IsSpaceChar(p_Char)) ||
+                        (m_NotSpaces && !IsSpaceChar(p_Char));
+        for (auto it = m_vRanges.cbegin(); !contains && it != m_vRanges.cend(); ++it) {
+            contains = p_Char >= it->first && p_Char <= it->second;
+        }
+        return contains;
+    }
+
+    //
+    // Constructor. Compiles the regex.
+    //
+    // @param p_Regex Regular expression pattern (ECMAScript syntax).
+    // @param p_IgnoreCase Whether to ignore case when looking for matches.
+    // @throws std::regex_error If regex is invalid or is not supported.
+    //
+    FastRegex::FastRegex(const std::wstring& p_Regex,
+                         const bool p_IgnoreCase)
+        : m_IgnoreCase(p_IgnoreCase),
+          m_vProgram(),
+          m_vClasses(),
+          m_NumGroups(0),
+          m_AnchoredAtBegin(false),
+          m_FirstChars()
+    {
+        Compiler compiler(p_Regex, *this);
+        compiler.Compile();
+    }
+
+    //
+    // Checks if the regex matches anywhere in a string.
+    //
+    // @param p_String String to look into.
+    // @return true if there is at least one match.
+    //
+    bool FastRegex::Search(const std::wstring& p_String) const
+    {
+        Machine machine(*this, p_String);
+        CaptureV vCaptures;
+        return machine.Search(0, false, false, vCaptures);
+    }
+
+    //
+    // Replaces all matches of the regex in a string using a replacement
+    // format. Behaves like std::regex_replace with default flags.
+    //
+    // @param p_String String to modify.
+    // @param p_Format Format of replacement string, using ECMAScript rules.
+    // @return Modified string.
+    //
+    std::wstring FastRegex::Replace(const std::wstring& p_String,
+                                    const std::wstring& p_Format) const
+    {
+        Machine machine(*this, p_String);
+        CaptureV vCaptures;
+        std::wstring result;
+        result.reserve(p_String.size());
+
+        // Like std::regex_iterator, after an empty match we first look for a non-empty
+        // match at the same position, then for any match starting at the next position.
+        size_t copyFrom = 0, searchFrom = 0;
+        bool lastMatchEmpty = false;
+        for (;;) {
+            bool found = false;
+            if (lastMatchEmpty) {
+                found = machine.Search(searchFrom, true, true, vCaptures);
+                if (!found && searchFrom < p_String.size()) {
+                    found = machine.Search(++searchFrom, false, false, vCaptures);
+                }
+            } else {
+                found = machine.Search(searchFrom, false, false, vCaptures);
+            }
+            if (!found) {
+                break;
+            }
+
+            result.append(p_String, copyFrom, vCaptures[0] - copyFrom);
+            AppendFormatted(p_String, vCaptures, copyFrom, p_Format, result);
+            copyFrom = vCaptures[1];
+            searchFrom = vCaptures[1];
+            lastMatchEmpty = vCaptures[0] == vCaptures[1];
+        }
+        result.append(p_String, copyFrom, std::wstring::npos);
+        return result;
+    }
+
+    //
+    // Scans a regular expression to find a literal string that must be
+    // present in any string it matches. Strings that do not contain this
+    // literal can be skipped without running the regex at all.
+    //
+    // The scan is conservative: only literals found in the top-level sequence
+    // of the regex are considered and atoms that can be skipped or repeated
+    // separately split literals. The regex is not validated, so this can
+    // also be used for regexes not supported by FastRegex.
+    //
+    // @param p_Regex Regular expression to scan.
+    // @param p_IgnoreCase Whether the regex ignores case when looking for matches.
+    //                     If true, the literal only contains ASCII characters, in lowercase.
+    // @return Longest required literal found, or an empty string if none was found.
+    //
+    std::wstring FastRegex::GetRequiredLiteral(const std::wstring& p_Regex,
+                                               const bool p_IgnoreCase)
+    {
+        std::wstring longest, current;
+        auto endCurrent = [&]() {
+            if (current.size() > longest.size()) {
+                longest = current;
+            }
+            current.clear();
+        };
+
+        auto it = p_Regex.cbegin();
+        const auto end = p_Regex.cend();
+        while (it != end) {
+            const wchar_t c = *it++;
+            bool isLiteral = false;
+            wchar_t literal = c;
+            switch (c) {
+                case L'|': {
+                    // Alternatives at top level mean nothing is required.
+                    return std::wstring();
+                }
+                case L'(': {
+                    // Skip the whole group, it splits literals.
+                    size_t depth = 1;
+                    while (it != end && depth != 0) {
+                        const wchar_t g = *it++;
+                        if (g == L'\\') {
+                            if (it != end) {
+                                ++it;
+                            }
+                        } else if (g == L'[') {
+                            it = SkipCharClass(it, end);
+                        } else if (g == L'(') {
+                            ++depth;
+                        } else if (g == L')') {
+                            --depth;
+                        }
+                    }
+                    break;
+                }
+                case L'[': {
+                    it = SkipCharClass(it, end);
+                    break;
+                }
+                case L'\\': {
+                    if (it != end) {
+                        const wchar_t e = *it++;
+                        if ((e >= L'a' && e <= L'z') || (e >= L'A' && e <= L'Z') || (e >= L'0' && e <= L'9')) {
+                            // Character class, assertion or other special escape; skip its arguments.
+                            size_t toSkip = 0;
+                            if (e == L'c') {
+                                toSkip = 1;
+                            } else if (e == L'x') {
+                                toSkip = 2;
+                            } else if (e == L'u') {
+                                toSkip = 4;
+                            } else if (e >= L'0' && e <= L'9') {
+                                toSkip = static_cast<size_t>(std::find_if(it, end, [](const wchar_t d) {
+                                    return d < L'0' || d > L'9';
+                                }) - it);
+                            }
+                            it += (std::min)(toSkip, static_cast<size_t>(end - it));
+                        } else {
+                            isLiteral = true;
+                            literal = e;
+                        }
+                    }
+                    break;
+                }
+                case L'.':
+                case L'^':
+                case L'$':
+                case L')':
+                case L'?':
+                case L'*':
+                case L'+':
+                case L'{':
+                case L'}':
+                case L']': {
+                    break;
+                }
+                default: {
+                    isLiteral = true;
+                    break;
+                }
+            }
+
+            // Check if a quantifier applies to this atom.
+            bool optional = false, repeated = false;
+            if (it != end) {
+                if (*it == L'?' || *it == L'*') {
+                    optional = true;
+                    ++it;
+                } else if (*it == L'+') {
+                    repeated = true;
+                    ++it;
+                } else if (*it == L'{') {
+                    // Minimum count could be more than 0, but be conservative.
+                    optional = true;
+                    it = std::find(it, end, L'}');
+                    if (it != end) {
+                        ++it;
+                    }
+                }
+                if ((optional || repeated) && it != end && *it == L'?') {
+                    ++it;
+                }
+            }
+
+            if (isLiteral && !optional && (!p_IgnoreCase || literal < 0x80)) {
+                if (p_IgnoreCase && literal >= L'A' && literal <= L'Z') {
+                    literal = static_cast<wchar_t>(literal - L'A' + L'a');
+                }
+                current.push_back(literal);
+                if (repeated) {
+                    // Repeated literal can only be followed by itself.
+                    endCurrent();
+                    current.push_back(literal);
+                }
+            } else {
+                endCurrent();
+            }
+        }
+        endCurrent();
+
+        return longest;
+    }
+
+    //
+    // Checks if a string contains a literal returned by GetRequiredLiteral.
+    //
+    // @param p_String String to check.
+    // @param p_Literal Literal to look for.
+    // @param p_IgnoreCase Whether to ignore case when looking for the literal.
+    //                     Must be the same value as passed to GetRequiredLiteral.
+    // @return true if p_String could contain p_Literal.
+    //
+    bool FastRegex::MayContainLiteral(const std::wstring& p_String,
+                                      const std::wstring& p_Literal,
+                                      const bool p_IgnoreCase)
+    {
+        bool found;
+        if (!p_IgnoreCase) {
+            found = p_String.find(p_Literal) != std::wstring::npos;
+        } else {
+            // Depending on the locale, some non-ASCII characters could be
+            // case-folded to ASCII characters by regex engines, so consider
+            // that they match anything.
+            found = std::search(p_String.cbegin(), p_String.cend(),
+                                p_Literal.cbegin(), p_Literal.cend(),
+                                [](const wchar_t p_Char, const wchar_t p_LiteralChar) {
+                return p_Char >= 0x80 || FoldCase(p_Char) == p_LiteralChar;
+            }) != p_String.cend();
+        }
+        return found;
+    }
+
+    //
+    // Checks if a regular expression contains a repeated group that itself
+    // contains a repeated atom, like "(a+)*" or "(\w+\\)+". When matched by
+    // a backtracking engine like std::wregex, such patterns can take a time
+    // exponential in the length of the input if there is no match.
+    //
+    // @param p_Regex Regex pattern to check.
+    // @return true if p_Regex contains nested quantifiers.
+    //
+    bool FastRegex::HasNestedQuantifiers(const std::wstring& p_Regex)
+    {
+        // For each open group, whether it contains a quantifier. The first
+        // entry is for the top level and is never popped.
+        std::vector<bool> vGroupHasQuantifier(1, false);
+
+        // Whether the atom preceding the current position is a group containing a quantifier.
+        bool prevGroupHasQuantifier = false;
+
+        auto it = p_Regex.cbegin();
+        const auto end = p_Regex.cend();
+        while (it != end) {
+            const wchar_t c = *it++;
+            bool isQuantifier = false;
+            bool closedGroupHasQuantifier = false;
+            switch (c) {
+                case L'\\': {
+                    if (it != end) {
+                        ++it;
+                    }
+                    break;
+                }
+                case L'[': {
+                    it = SkipCharClass(it, end);
+                    break;
+                }
+                case L'(': {
+                    // Skip group modifiers like "?:", they are not quantifiers.
+                    if (it != end && *it == L'?') {
+                        ++it;
+                        if (it != end) {
+                            ++it;
+                        }
+                    }
+                    vGroupHasQuantifier.push_back(false);
+                    break;
+                }
+                case L')': {
+                    if (vGroupHasQuantifier.size() > 1) {
+                        closedGroupHasQuantifier = vGroupHasQuantifier.back();
+                        vGroupHasQuantifier.pop_back();
+                        if (closedGroupHasQuantifier) {
+                            vGroupHasQuantifier.back() = true;
+                        }
+                    }
+                    break;
+                }
+                case L'*':
+                case L'+': {
+                    isQuantifier = true;
+                    break;
+                }
+                case L'{': {
+                    // Only a quantifier if followed by a count; otherwise it's a literal brace.
+                    isQuantifier = it != end && *it >= L'0' && *it <= L'9';
+                    break;
+                }
+                default: {
+                    break;
+                }
+            }
+            if (isQuantifier) {
+                if (prevGroupHasQuantifier) {
+                    return true;
+                }
+                vGroupHasQuantifier.back() = true;
+            }
+            prevGroupHasQuantifier = closedGroupHasQuantifier;
+        }
+
+        return false;
+    }
+
+    //
+    // Checks if an instruction consuming a character matches a character.
+    //
+    // @param p_Instruction Instruction to check.
+    // @param p_Char Character to check.
+    // @return true if p_Char is matched by p_Instruction.
+    //
+    bool FastRegex::Matches(const Instruction& p_Instruction,
+                            const wchar_t p_Char) const
+    {
+        bool matches = false;
+        switch (p_Instruction.m_OpCode) {
+            case OpCode::Char: {
+                matches = (m_IgnoreCase ? FoldCase(p_Char) : p_Char) == p_Instruction.m_Char;
+                break;
+            }
+            case OpCode::Any: {
+                matches = !IsLineTerminator(p_Char);
+                break;
+            }
+            case OpCode::Class: {
+                const CharClass& charClass = m_vClasses[p_Instruction.m_Arg1];
+                matches = charClass.Contains(p_Char);
+                if (!matches && m_IgnoreCase) {
+                    matches = charClass.Contains(static_cast<wchar_t>(std::towlower(p_Char))) ||
+                              charClass.Contains(static_cast<wchar_t>(std::towupper(p_Char)));
+                }
+                matches = matches != charClass.m_Negated;
+                break;
+            }
+            default: {
+                break;
+            }
+        }
+        return matches;
+    }
+
+    //
+    // Appends the replacement string for a match to a result string.
+    //
+    // @param p_String String being modified.
+    // @param p_vCaptures Captures of the match.
+    // @param p_PrefixBegin Position of the end of the previous match (for $`).
+    // @param p_Format Format of replacement string.
+    // @param p_rResult Where to append the replacement string.
+    //
+    void FastRegex::AppendFormatted(const std::wstring& p_String,
+                                    const CaptureV& p_vCaptures,
+                                    const size_t p_PrefixBegin,
+                                    const std::wstring& p_Format,
+                                    std::wstring& p_rResult) const
+    {
+        auto appendGroup = [&](const size_t p_Group) {
+            const size_t begin = p_vCaptures[p_Group * 2];
+            const size_t end = p_vCaptures[p_Group * 2 + 1];
+            if (begin != NO_POSITION && end != NO_POSITION) {
+                p_rResult.append(p_String, begin, end - begin);
+            }
+        };
+
+        const size_t size = p_Format.size();
+        for (size_t i = 0; i < size; ++i) {
+            const wchar_t c = p_Format[i];
+            if (c != L'$' || i + 1 == size) {
+                p_rResult.push_back(c);
+                continue;
+            }
+            const wchar_t next = p_Format[++i];
+            if (next == L'$') {
+                p_rResult.push_back(L'$');
+            } else if (next == L'&') {
+                appendGroup(0);
+            } else if (next == L'`') {
+                p_rResult.append(p_String, p_PrefixBegin, p_vCaptures[0] - p_PrefixBegin);
+            } else if (next == L'\'') {
+                p_rResult.append(p_String, p_vCaptures[1], std::wstring::npos);
+            } else if (next >= L'0' && next <= L'9') {
+                size_t group = static_cast<size_t>(next - L'0');
+                if (i + 1 < size && p_Format[i + 1] >= L'0' && p_Format[i + 1] <= L'9') {
+                    group = group * 10 + static_cast<size_t>(p_Format[++i] - L'0');
+                }
+                if (group < m_NumGroups) {
+                    appendGroup(group);
+                }
+            } else {
+                p_rResult.push_back(L'$');
+                p_rResult.push_back(next);
+            }
+        }
+    }
+
+    //
+    // Checks if a character is a word character, for \w and \b.
+    //
+    // @param p_Char Character to check.
+    // @return true if p_Char is a word character.
+    //
+    bool FastRegex::IsWordChar(const wchar_t p_Char)
+    {
+        return p_Char == L'_' || std::iswalnum(p_Char);
+    }
+
+    //
+    // Checks if a character is a whitespace character, for \s.
+    //
+    // @param p_Char Character to check.
+    // @return true if p_Char is a whitespace character.
+    //
+    bool FastRegex::IsSpaceChar(const wchar_t p_Char)
+    {
+        return std::iswspace(p_Char) != 0;
+    }
+
+    //
+    // Checks if a character is a line terminator, which is not matched by ".".
+    //
+    // @param p_Char Character to check.
+    // @return true if p_Char is a line terminator.
+    //
+    bool FastRegex::IsLineTerminator(const wchar_t p_Char)
+    {
+        return p_Char == L'\n' || p_Char == L'\r' || p_Char == L'\x2028' || p_Char == L'\x2029';
+    }
+
+    //
+    // Folds the case of a character, for case-insensitive comparisons.
+    // Uses the same conversion as std::regex_traits.
+    //
+    // @param p_Char Character to fold.
+    // @return Case-folded character.
+    //
+    wchar_t FastRegex::FoldCase(const wchar_t p_Char)
+    {
+        return static_cast<wchar_t>(std::towlower(p_Char));
+    }
+
+} // namespace PCC
@@ -0,0 +1,417 @@
+// FileHasher.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <stdafx.h>
+#include <FileHasher.h>
+#include <ThreadPool.h>
+#include <resource.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+#include <atlbase.h>
+#include <shlobj.h>
+
+
+namespace
+{
+    // Signatures of the BCrypt functions we use, which are only available on Vista and up.
+    typedef LONG (WINAPI *BCryptOpenAlgorithmProviderFunc)(PVOID*, LPCWSTR, LPCWSTR, ULONG);
+    typedef LONG (WINAPI *BCryptCreateHashFunc)(PVOID, PVOID*, PUCHAR, ULONG, PUCHAR, ULONG, ULONG);
+    typedef LONG (WINAPI *BCryptHashDataFunc)(PVOID, PUCHAR, ULONG, ULONG);
+    typedef LONG (WINAPI *BCryptFinishHashFunc)(PVOID, PUCHAR, ULONG, ULONG);
+    typedef LONG (WINAPI *BCryptDestroyHashFunc)(PVOID);
+
+    const wchar_t       SHA256_ALGORITHM[]      = L"SHA256";    // ID of SHA-256 algorithm, BCRYPT_SHA256_ALGORITHM.
+    const ULONG         SHA256_HASH_SIZE        = 32;           // Size of a SHA-256 hash, in bytes.
+    const wchar_t       HEX_DIGITS[]            = L"0123456789abcdef";
+
+} // anonymous namespace
+
+namespace PCC
+{
+    //
+    // Entry points of BCrypt and handle to the SHA-256 algorithm provider.
+    // The provider is never closed since it can be used by any thread.
+    //
+    struct FileHasher::Algorithm {
+        BCryptCreateHashFunc
+                        m_pCreateHash;      // Pointer to BCryptCreateHash.
+        BCryptHashDataFunc
+                        m_pHashData;        // Pointer to BCryptHashData.
+        BCryptFinishHashFunc
+                        m_pFinishHash;      // Pointer to BCryptFinishHash.
+        BCryptDestroyHashFunc
+                        m_pDestroyHash;     // Pointer to BCryptDestroyHash.
+        PVOID           m_hAlgorithm;       // Handle to the SHA-256 algorithm provider, or nullptr if it could not be opened.
+    };
+
+    //
+    // Information about one call to HashFiles. It is shared with the tasks
+    // of worker threads helping the calling thread, which can start after
+    // the call is over; such tasks find no more files to hash and return.
+    //
+    struct FileHasher::Job {
+        WStringV        m_vFiles;           // Paths of files to hash.
+        WStringV        m_vHashes;          // Hashes of files, in the same order; empty if a file could not be hashed.
+        std::atomic<size_t>
+                        m_NextFile;         // Index of next file to hash.
+        std::atomic<ULONGLONG>
+                        m_BytesHashed;      // Number of bytes hashed so far, for progress.
+        std::atomic<bool>
+                        m_Cancelled;        // Whether the user has cancelled the job.
+        size_t          m_RunningHelpers;   // Number of worker threads currently helping.
+        std::mutex      m_Lock;             // Lock protecting m_RunningHelpers.
+        std::condition_variable
+                        m_HelperDone;       // Signaled when a worker thread stops helping.
+
+        explicit Job(const WStringV& p_vFiles)
+            : m_vFiles(p_vFiles),
+              m_vHashes(p_vFiles.size()),
+              m_NextFile(0),
+              m_BytesHashed(0),
+              m_Cancelled(false),
+              m_RunningHelpers(0),
+              m_Lock(),
+              m_HelperDone()
+        {
+        }
+    };
+
+    // Static members of FileHasher
+    const DWORD             FileHasher::CHUNK_SIZE = 1024 * 1024;
+    const ULONGLONG         FileHasher::PROGRESS_MIN_BYTES = 256ULL * 1024 * 1024;
+    const DWORD             FileHasher::PROGRESS_INTERVAL = 250;
+    const size_t            FileHasher::MAX_HELPERS = 3;
+    FileHasher::Algorithm   FileHasher::s_Algorithm = { nullptr, nullptr, nullptr, nullptr, nullptr };
+    std::once_flag          FileHasher::s_AlgorithmInit;
+
+    //
+    // Computes the SHA-256 hashes of the contents of files. Paths that
+    // are not files, or files that cannot be read, get an empty hash.
+    //
+    // @param p_vFiles Paths of files to hash.
+    // @param p_rvHashes Where to store the hashes, as lowercase hexadecimal
+    //                   strings, in the same order as p_vFiles.
+    // @throw FileHashingCancelledException If the user cancelled the operation.
+    //
+    void FileHasher::HashFiles(const WStringV& p_vFiles,
+                               WStringV& p_rvHashes)
+    {
+        p_rvHashes.clear();
+        const Algorithm* const pAlgorithm = GetAlgorithm();
+        if (pAlgorithm == nullptr) {
+            p_rvHashes.resize(p_vFiles.size());
+            return;
+        }
+
+        // Show progress only if hashing will take a while; this requires
+        // knowing the size of files first.
+        ULONGLONG totalBytes = 0;
+        for (const std::wstring& file : p_vFiles) {
+            WIN32_FILE_ATTRIBUTE_DATA data;
+            if (::GetFileAttributesExW(file.c_str(), GetFileExInfoStandard, &data) != FALSE &&
+                (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0) {
+
+                totalBytes += (static_cast<ULONGLONG>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+            }
+        }
+        ATL::CComPtr<IProgressDialog> spProgressDialog;
+        if (totalBytes >= PROGRESS_MIN_BYTES && SUCCEEDED(spProgressDialog.CoCreateInstance(CLSID_ProgressDialog))) {
+            spProgressDialog->SetTitle(ATL::CStringW(MAKEINTRESOURCEW(IDS_PROGRESS_TITLE)));
+            spProgressDialog->SetLine(1, ATL::CStringW(MAKEINTRESOURCEW(IDS_PROGRESS_HASHING_FILES)), FALSE, nullptr);
+            spProgressDialog->SetCancelMsg(ATL::CStringW(MAKEINTRESOURCEW(IDS_PROGRESS_CANCELLING)), nullptr);
+            if (FAILED(spProgressDialog->StartProgressDialog(::GetForegroundWindow(), nullptr,
+                                                             PROGDLG_NORMAL | PROGDLG_AUTOTIME, nullptr))) {
+                spProgressDialog.Release();
+            }
+        }
+
+        // Progress is reported by the calling thread only, since the
+        // progress dialog must be used from the thread that created it.
+        const JobSP spJob = std::make_shared<Job>(p_vFiles);
+        DWORD lastProgress = ::GetTickCount();
+        const ProgressCallback onProgress = [&]() {
+            const DWORD now = ::GetTickCount();
+            if (spProgressDialog != nullptr && now - lastProgress >= PROGRESS_INTERVAL) {
+                spProgressDialog->SetProgress64(spJob->m_BytesHashed.load(), totalBytes);
+                if (spProgressDialog->HasUserCancelled() != FALSE) {
+                    spJob->m_Cancelled = true;
+                }
+                lastProgress = now;
+            }
+        };
+
+        // Submit tasks to help us if there's more than one file. If worker
+        // threads are busy, we'll end up hashing all files ourselves.
+        size_t helperCount = p_vFiles.size() > 1 ? std::min(MAX_HELPERS, p_vFiles.size() - 1) : 0;
+        const unsigned int processorCount = std::thread::hardware_concurrency();
+        if (processorCount != 0) {
+            helperCount = std::min<size_t>(helperCount, processorCount - 1);
+        }
+        std::vector<ThreadPool::TaskSP> vspHelpers;
+        try {
+            for (size_t i = 0; i < helperCount; ++i) {
+                vspHelpers.push_back(ThreadPool::Submit([spJob, pAlgorithm]() {
+                    {
+                        std::lock_guard<std::mutex> lock(spJob->m_Lock);
+                        ++spJob->m_RunningHelpers;
+                    }
+                    try {
+                        HashJobFiles(*pAlgorithm, *spJob, ProgressCallback());
+                    } catch (...) {
+                        // Files we could not hash will keep an empty hash.
+                    }
+                    {
+                        std::lock_guard<std::mutex> lock(spJob->m_Lock);
+                        --spJob->m_RunningHelpers;
+                    }
+                    spJob->m_HelperDone.notify_all();
+                }, ThreadPool::Priority::High));
+            }
+            HashJobFiles(*pAlgorithm, *spJob, onProgress);
+        } catch (...) {
+            // Make sure helpers stop early; they keep a reference to the job.
+            spJob->m_Cancelled = true;
+            for (const ThreadPool::TaskSP& spHelper : vspHelpers) {
+                spHelper->Cancel();
+            }
+            if (spProgressDialog != nullptr) {
+                spProgressDialog->StopProgressDialog();
+            }
+            throw;
+        }
+
+        // All files have been claimed, so helpers that haven't started won't be needed.
+        // Wait for the others to finish hashing their files.
+        for (const ThreadPool::TaskSP& spHelper : vspHelpers) {
+            spHelper->Cancel();
+        }
+        {
+            std::unique_lock<std::mutex> lock(spJob->m_Lock);
+            while (spJob->m_RunningHelpers != 0) {
+                spJob->m_HelperDone.wait_for(lock, std::chrono::milliseconds(PROGRESS_INTERVAL));
+                lock.unlock();
+                onProgress();
+                lock.lock();
+            }
+        }
+        if (spProgressDialog != nullptr) {
+            spProgressDialog->StopProgressDialog();
+        }
+
+        if (spJob->m_Cancelled) {
+            throw FileHashingCancelledException();
+        }
+        p_rvHashes.swap(spJob->m_vHashes);
+    }
+
+    //
+    // Loads BCrypt and opens the SHA-256 algorithm provider on first use.
+    //
+    // @return Algorithm to use, or nullptr if BCrypt is not available.
+    //
+    const FileHasher::Algorithm* FileHasher::GetAlgorithm()
+    {
+        std::call_once(s_AlgorithmInit, []() {
+            // The library is never freed since the provider is kept until we're unloaded.
+            HMODULE hBCrypt = ::LoadLibraryW(L"bcrypt.dll");
+            if (hBCrypt != NULL) {
+                auto pOpenAlgorithmProvider = reinterpret_cast<BCryptOpenAlgorithmProviderFunc>(
+                    ::GetProcAddress(hBCrypt, "BCryptOpenAlgorithmProvider"));
+                s_Algorithm.m_pCreateHash = reinterpret_cast<BCryptCreateHashFunc>(
+                    ::GetProcAddress(hBCrypt, "BCryptCreateHash"));
+                s_Algorithm.m_pHashData = reinterpret_cast<BCryptHashDataFunc>(
+                    ::GetProcAddress(hBCrypt, "BCryptHashData"));
+                s_Algorithm.m_pFinishHash = reinterpret_cast<BCryptFinishHashFunc>(
+                    ::GetProcAddress(hBCrypt, "BCryptFinishHash"));
+                s_Algorithm.m_pDestroyHash = reinterpret_cast<BCryptDestroyHashFunc>(
+                    ::GetProcAddress(hBCrypt, "BCryptDestroyHash"));
+                if (pOpenAlgorithmProvider != nullptr && s_Algorithm.m_pCreateHash != nullptr &&
+                    s_Algorithm.m_pHashData != nullptr && s_Algorithm.m_pFinishHash != nullptr &&
+                    s_Algorithm.m_pDestroyHash != nullptr) {
+
+                    PVOID hAlgorithm = nullptr;
+                    if (pOpenAlgorithmProvider(&hAlgorithm, SHA256_ALGORITHM, nullptr, 0) >= 0) {
+                        s_Algorithm.m_hAlgorithm = hAlgorithm;
+                    }
+                }
+            }
+        });
+        return s_Algorithm.m_hAlgorithm != nullptr ? &s_Algorithm : nullptr;
+    }
+
+    //
+    // Hashes files of a job until there are none left to claim or
+    // until the job is cancelled.
+    //
+    // @param p_Algorithm Algorithm to use to hash files.
+    // @param p_rJob Job whose files to hash.
+    // @param p_OnProgress Function to call after hashing each chunk of data; can be empty.
+    //
+    void FileHasher::HashJobFiles(const Algorithm& p_Algorithm,
+                                  Job& p_rJob,
+                                  const ProgressCallback& p_OnProgress)
+    {
+        while (!p_rJob.m_Cancelled) {
+            const size_t i = p_rJob.m_NextFile++;
+            if (i >= p_rJob.m_vFiles.size()) {
+                break;
+            }
+            p_rJob.m_vHashes[i] = HashFile(p_Algorithm, p_rJob.m_vFiles[i], p_rJob, p_OnProgress);
+        }
+    }
+
+    //
+    // Computes the SHA-256 hash of the content of one file. Two buffers are
+    // used so that the next chunk of the file is read while the current one
+    // is being hashed.
+    //
+    // @param p_Algorithm Algorithm to use to hash the file.
+    // @param p_File Path of file to hash.
+    // @param p_rJob Job the file belongs to, used to report progress and check for cancellation.
+    // @param p_OnProgress Function to call after hashing each chunk of data; can be empty.
+    // @return Hash of file, as a lowercase hexadecimal string. Empty if the
+    //         file could not be read or if the job was cancelled.
+    //
+    std::wstring FileHasher::HashFile(const Algorithm& p_Algorithm,
+                                      const std::wstring& p_File,
+                                      Job& p_rJob,
+                                      const ProgressCallback& p_OnProgress)
+    {
+        std::wstring hash;
+        HANDLE hFile = OpenFile(p_File);
+        if (hFile == INVALID_HANDLE_VALUE) {
+            return hash;
+        }
+
+        // Unbuffered reads need sector-aligned buffers; VirtualAlloc returns page-aligned memory.
+        LARGE_INTEGER fileSize;
+        BYTE* const pBuffers = static_cast<BYTE*>(::VirtualAlloc(nullptr, 2 * CHUNK_SIZE, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+        HANDLE hEvents[2] = { ::CreateEventW(nullptr, TRUE, FALSE, nullptr), ::CreateEventW(nullptr, TRUE, FALSE, nullptr) };
+        PVOID hHash = nullptr;
+        if (::GetFileSizeEx(hFile, &fileSize) != FALSE && pBuffers != nullptr &&
+            hEvents[0] != NULL && hEvents[1] != NULL &&
+            p_Algorithm.m_pCreateHash(p_Algorithm.m_hAlgorithm, &hHash, nullptr, 0, nullptr, 0, 0) >= 0) {
+
+            const ULONGLONG size = static_cast<ULONGLONG>(fileSize.QuadPart);
+            OVERLAPPED overlapped[2];
+            bool pending[2] = { false, false };
+            auto startRead = [&](const int p_Buffer, const ULONGLONG p_Offset) {
+                ::ZeroMemory(&overlapped[p_Buffer], sizeof(OVERLAPPED));
+                overlapped[p_Buffer].Offset = static_cast<DWORD>(p_Offset);
+                overlapped[p_Buffer].OffsetHigh = static_cast<DWORD>(p_Offset >> 32);
+                overlapped[p_Buffer].hEvent = hEvents[p_Buffer];
+                pending[p_Buffer] = ::ReadFile(hFile, pBuffers + p_Buffer * CHUNK_SIZE, CHUNK_SIZE, nullptr, &overlapped[p_Buffer]) != FALSE ||
+                                    ::GetLastError() == ERROR_IO_PENDING;
+                return pending[p_Buffer];
+            };
+
+            // Read the whole file, hashing each chunk while reading the next one.
+            bool ok = size == 0 || startRead(0, 0);
+            int current = 0;
+            for (ULONGLONG offset = 0; ok && offset < size; offset += CHUNK_SIZE, current = 1 - current) {
+                DWORD read = 0;
+                ok = ::GetOverlappedResult(hFile, &overlapped[current], &read, TRUE) != FALSE;
+                pending[current] = false;
+                ok = ok && read == std::min<ULONGLONG>(CHUNK_SIZE, size - offset);
+                if (ok && offset + CHUNK_SIZE < size) {
+                    ok = startRead(1 - current, offset + CHUNK_SIZE);
+                }
+                ok = ok && p_Algorithm.m_pHashData(hHash, pBuffers + current * CHUNK_SIZE, read, 0) >= 0;
+                p_rJob.m_BytesHashed += read;
+                if (p_OnProgress) {
+                    p_OnProgress();
+                }
+                ok = ok && !p_rJob.m_Cancelled;
+            }
+
+            // If we stopped early, a read could still be pending; it must complete before we free its buffer.
+            // Reads have all been started by this thread, so CancelIo can stop them.
+            if (pending[0] || pending[1]) {
+                ::CancelIo(hFile);
+                for (int i = 0; i < 2; ++i) {
+                    if (pending[i]) {
+                        DWORD read = 0;
+                        ::GetOverlappedResult(hFile, &overlapped[i], &read, TRUE);
+                    }
+                }
+            }
+
+            BYTE digest[SHA256_HASH_SIZE];
+            if (ok && p_Algorithm.m_pFinishHash(hHash, digest, SHA256_HASH_SIZE, 0) >= 0) {
+                hash.reserve(2 * SHA256_HASH_SIZE);
+                for (const BYTE b : digest) {
+                    hash.push_back(HEX_DIGITS[b >> 4]);
+                    hash.push_back(HEX_DIGITS[b & 0xF]);
+                }
+            }
+            p_Algorithm.m_pDestroyHash(hHash);
+        }
+
+        for (HANDLE hEvent : hEvents) {
+            if (hEvent != NULL) {
+                ::CloseHandle(hEvent);
+            }
+        }
+        if (pBuffers != nullptr) {
+            ::VirtualFree(pBuffers, 0, MEM_RELEASE);
+        }
+        ::CloseHandle(hFile);
+        return hash;
+    }
+
+    //
+    // Opens a file to read its content sequentially with overlapped,
+    // unbuffered I/O. If the file system does not support unbuffered I/O,
+    // the file is opened with buffering.
+    //
+    // @param p_File Path of file to open.
+    // @return Handle to file, or INVALID_HANDLE_VALUE if it could not be
+    //         opened or is a directory.
+    //
+    HANDLE FileHasher::OpenFile(const std::wstring& p_File)
+    {
+        const DWORD flags = FILE_FLAG_OVERLAPPED | FILE_FLAG_SEQUENTIAL_SCAN;
+        HANDLE hFile = ::CreateFileW(p_File.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                                     nullptr, OPEN_EXISTING, flags | FILE_FLAG_NO_BUFFERING, NULL);
+        if (hFile == INVALID_HANDLE_VALUE && ::GetLastError() == ERROR_INVALID_PARAMETER) {
+            hFile = ::CreateFileW(p_File.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                                  nullptr, OPEN_EXISTING, flags, NULL);
+        }
+        return hFile;
+    }
+
+    //
+    // Returns a textual description of the exception.
+    //
+    // @return Exception textual description.
+    //
+    const char* FileHashingCancelledException::what() const
+    {
+        return "FileHashingCancelledException";
+    }
+
+} // namespace PCC
@@ -0,0 +1,529 @@
+// FileMetadataCache.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <stdafx.h>
+#include <FileMetadataCache.h>
+#include <DriveConnectivityCache.h>
+
+#include <cwchar>
+
+
+namespace
+{
+    // Flag to use larger buffers when enumerating directories. Not defined in
+    // the headers we target since it is only supported on Windows 7 and later.
+    const DWORD         FIND_FIRST_EX_LARGE_FETCH_FLAG  = 2;
+
+    // Minimum number of files of a directory that must be prefetched for the
+    // directory to be enumerated. For fewer files, querying them one by one is
+    // cheaper than enumerating a potentially large directory.
+    const size_t        MIN_PREFETCHED_FILES_PER_DIRECTORY  = 16;
+
+    // Signature of Win32 functions converting a path, like GetLongPathNameW.
+    typedef DWORD (WINAPI *PathConversionFunc)(LPCWSTR, LPWSTR, DWORD);
+
+    //
+    // Checks if a path can be cached. Only absolute paths shorter than
+    // MAX_PATH with a drive letter or a UNC share are supported, and
+    // they must not contain relative components or wildcards.
+    //
+    // @param p_Path Path to check.
+    // @return true if path can be cached.
+    //
+    bool IsCacheablePath(const std::wstring& p_Path)
+    {
+        if (p_Path.size() < 4 || p_Path.size() >= MAX_PATH || p_Path.back() == L'\\' ||
+            p_Path.find_first_of(L"/*?") != std::wstring::npos) {
+
+            return false;
+        }
+
+        std::wstring::size_type nameStart = 0;
+        if (p_Path[1] == L':' && p_Path[2] == L'\\') {
+            // Path starting with a drive letter.
+            nameStart = 3;
+        } else if (p_Path[0] == L'\\' && p_Path[1] == L'\\' && p_Path[2] != L'?' && p_Path[2] != L'.') {
+            // UNC path; there must be a name after the share.
+            const std::wstring::size_type shareStart = p_Path.find(L'\\', 2);
+            const std::wstring::size_type shareEnd = shareStart != std::wstring::npos ? p_Path.find(L'\\', shareStart + 1)
+                                                                                      : std::wstring::npos;
+            if (shareStart == 2 || shareEnd == std::wstring::npos || shareEnd == shareStart + 1) {
+                return false;
+            }
+            nameStart = shareEnd + 1;
+        } else {
+            return false;
+        }
+
+        // Check each component for relative components or empty names.
+        while (nameStart <= p_Path.size()) {
+            std::wstring::size_type nameEnd = p_Path.find(L'\\', nameStart);
+            if (nameEnd == std::wstring::npos) {
+                nameEnd = p_Path.size();
+            }
+            const std::wstring::size_type nameSize = nameEnd - nameStart;
+            if (nameSize == 0 ||
+                (nameSize == 1 && p_Path[nameStart] == L'.') ||
+                (nameSize == 2 && p_Path[nameStart] == L'.' && p_Path[nameStart + 1] == L'.')) {
+
+                return false;
+            }
+            nameStart = nameEnd + 1;
+        }
+        return true;
+    }
+
+    //
+    // Converts the path of a directory using a Win32 function like GetLongPathNameW.
+    // Since only paths shorter than MAX_PATH are cached, no dynamic buffer is needed.
+    //
+    // @param p_pFunc Function used to convert the path.
+    // @param p_DirectoryPath Path to convert.
+    // @return Converted path, or an empty string if it could not be converted.
+    //
+    std::wstring ConvertDirectoryPath(PathConversionFunc const p_pFunc,
+                                      const std::wstring& p_DirectoryPath)
+    {
+        wchar_t buffer[MAX_PATH + 1];
+        const DWORD copied = p_pFunc(p_DirectoryPath.c_str(), buffer, sizeof(buffer) / sizeof(wchar_t));
+        return copied != 0 && copied < sizeof(buffer) / sizeof(wchar_t) ? std::wstring(buffer, copied)
+                                                                        : std::wstring();
+    }
+
+} // anonymous namespace
+
+namespace PCC
+{
+    //
+    // Constructor.
+    //
+    FileMetadataCache::FileMetadataCache()
+        : m_mspDirectories(),
+          m_mUNCPaths(),
+          m_Lock()
+    {
+    }
+
+    //
+    // Prefetches the metadata of the files of an operation. Each parent directory
+    // containing enough of the files is enumerated once, keeping only the metadata
+    // of those files. Files in other directories will be queried individually.
+    //
+    // @param p_vFiles Files of the operation.
+    //
+    void FileMetadataCache::Prefetch(const FilesV& p_vFiles)
+    {
+        // Group files per parent directory.
+        NameSM msNamesPerDirectory;
+        std::wstring directoryPath, name;
+        for (const std::wstring& file : p_vFiles) {
+            if (IsCacheablePath(file)) {
+                SplitPath(file, directoryPath, name);
+                msNamesPerDirectory[directoryPath].insert(std::move(name));
+            }
+        }
+        PrefetchDirectories(msNamesPerDirectory);
+    }
+
+    //
+    // Prefetches the metadata of the files of an operation, stored in a selection.
+    // Works like the version accepting a vector of files, but uses the selection's
+    // partitioning per parent directory; directories that cannot contain enough
+    // files to be enumerated are skipped without looking at their files.
+    //
+    // @param p_Files Files of the operation.
+    //
+    void FileMetadataCache::Prefetch(const FileSelection& p_Files)
+    {
+        NameSM msNamesPerDirectory;
+        std::wstring file, directoryPath, name;
+        for (const FileSelection::DirectoryGroup& group : p_Files.GetDirectoryGroups()) {
+            if (group.m_vIndexes.size() >= MIN_PREFETCHED_FILES_PER_DIRECTORY) {
+                NameS* psNames = nullptr;
+                for (const size_t index : group.m_vIndexes) {
+                    p_Files.GetFile(index, file);
+                    if (IsCacheablePath(file)) {
+                        SplitPath(file, directoryPath, name);
+                        if (psNames == nullptr) {
+                            psNames = &msNamesPerDirectory[directoryPath];
+                        }
+                        psNames->insert(std::move(name));
+                    }
+                }
+            }
+        }
+        PrefetchDirectories(msNamesPerDirectory);
+    }
+
+    //
+    // Enumerates directories containing enough of the files of an operation,
+    // keeping only the metadata of those files. Directories already known are skipped,
+    // as well as directories on drives that are unreachable (see DriveConnectivityCache).
+    //
+    // @param p_msNamesPerDirectory Names of the files of the operation, per parent directory.
+    //
+    void FileMetadataCache::PrefetchDirectories(const NameSM& p_msNamesPerDirectory)
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        for (const auto& namesPerDirectory : p_msNamesPerDirectory) {
+            if (namesPerDirectory.second.size() >= MIN_PREFETCHED_FILES_PER_DIRECTORY &&
+                m_mspDirectories.find(namesPerDirectory.first) == m_mspDirectories.end() &&
+                DriveConnectivityCache::IsReachable(namesPerDirectory.first)) {
+
+                auto spDirectory = std::make_shared<Directory>();
+                EnumerateDirectory(namesPerDirectory.first, namesPerDirectory.second, *spDirectory);
+                m_mspDirectories.emplace(namesPerDirectory.first, spDirectory);
+            }
+        }
+    }
+
+    //
+    // Returns the long version of a path (without 8.3 names), like GetLongPathNameW.
+    //
+    // @param p_Path Path to convert.
+    // @param p_rLongPath Where to store the long path.
+    // @return true if path was found in the cache, false if it must be converted normally.
+    //
+    bool FileMetadataCache::GetLongPath(const std::wstring& p_Path,
+                                        std::wstring& p_rLongPath)
+    {
+        return ConvertPath(p_Path, true, p_rLongPath);
+    }
+
+    //
+    // Returns the short version of a path (using 8.3 names), like GetShortPathNameW.
+    //
+    // @param p_Path Path to convert.
+    // @param p_rShortPath Where to store the short path.
+    // @return true if path was found in the cache, false if it must be converted normally.
+    //
+    bool FileMetadataCache::GetShortPath(const std::wstring& p_Path,
+                                         std::wstring& p_rShortPath)
+    {
+        return ConvertPath(p_Path, false, p_rShortPath);
+    }
+
+    //
+    // Returns the attributes of a file or directory, like GetFileAttributesW.
+    //
+    // @param p_Path Path of file or directory.
+    // @param p_rAttributes Where to store the attributes.
+    // @return true if path was found in the cache, false if it must be queried normally.
+    //
+    bool FileMetadataCache::GetAttributes(const std::wstring& p_Path,
+                                          DWORD& p_rAttributes)
+    {
+        if (!IsCacheablePath(p_Path)) {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(m_Lock);
+        std::wstring directoryPath;
+        const Entry* pEntry = nullptr;
+        if (FindEntry(p_Path, directoryPath, pEntry) == nullptr) {
+            return false;
+        }
+        p_rAttributes = pEntry->m_Info.m_Attributes;
+        return true;
+    }
+
+    //
+    // Returns the attributes, size and timestamps of a file or directory,
+    // like GetFileAttributesExW. When the files of an operation have been
+    // prefetched, this needs no query per file.
+    //
+    // @param p_Path Path of file or directory.
+    // @param p_rInfo Where to store the metadata.
+    // @return true if path was found in the cache, false if it must be queried normally.
+    //
+    bool FileMetadataCache::GetFileInfo(const std::wstring& p_Path,
+                                        FileInfo& p_rInfo)
+    {
+        if (!IsCacheablePath(p_Path)) {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(m_Lock);
+        std::wstring directoryPath;
+        const Entry* pEntry = nullptr;
+        if (FindEntry(p_Path, directoryPath, pEntry) == nullptr) {
+            return false;
+        }
+        p_rInfo = pEntry->m_Info;
+        return true;
+    }
+
+    //
+    // Returns the UNC path resolved for a long path during this operation, if any.
+    //
+    // @param p_LongPath Long path, without trailing separator.
+    // @param p_Flags Flags used to resolve the UNC path (see UNC_USE_HIDDEN_SHARES, etc.)
+    // @param p_rUNCPath Where to store the resolved path.
+    // @param p_rConverted Where to store whether the path was converted to a UNC path.
+    // @return true if path was found in the cache, false if it must be resolved normally.
+    //
+    bool FileMetadataCache::GetUNCPath(const std::wstring& p_LongPath,
+                                       const DWORD p_Flags,
+                                       std::wstring& p_rUNCPath,
+                                       bool& p_rConverted)
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        auto it = m_mUNCPaths.find(std::make_pair(p_Flags, p_LongPath));
+        if (it == m_mUNCPaths.end()) {
+            return false;
+        }
+        p_rUNCPath = it->second.m_Path;
+        p_rConverted = it->second.m_Converted;
+        return true;
+    }
+
+    //
+    // Stores the UNC path resolved for a long path, so that other
+    // plugins can reuse it during this operation.
+    //
+    // @param p_LongPath Long path, without trailing separator.
+    // @param p_Flags Flags used to resolve the UNC path (see UNC_USE_HIDDEN_SHARES, etc.)
+    // @param p_UNCPath Resolved path.
+    // @param p_Converted Whether the path was converted to a UNC path.
+    //
+    void FileMetadataCache::SetUNCPath(const std::wstring& p_LongPath,
+                                       const DWORD p_Flags,
+                                       const std::wstring& p_UNCPath,
+                                       const bool p_Converted)
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        UNCPath& rUNCPath = m_mUNCPaths[std::make_pair(p_Flags, p_LongPath)];
+        rUNCPath.m_Path = p_UNCPath;
+        rUNCPath.m_Converted = p_Converted;
+    }
+
+    //
+    // Case-insensitive comparison of file names.
+    //
+    // @param p_Name1 First name to compare.
+    // @param p_Name2 Second name to compare.
+    // @return true if p_Name1 is less than p_Name2.
+    //
+    bool FileMetadataCache::NameLess::operator()(const std::wstring& p_Name1,
+                                                 const std::wstring& p_Name2) const
+    {
+        return ::_wcsicmp(p_Name1.c_str(), p_Name2.c_str()) < 0;
+    }
+
+    //
+    // Finds the entry of a path in the cache. If it's not there, the path
+    // is queried and the result is cached. Must be called with the lock held.
+    //
+    // @param p_Path Path to look for. Must be cacheable.
+    // @param p_rDirectoryPath Where to store the path of the parent directory.
+    // @param p_rpEntry Where to store a pointer to the entry, if found.
+    // @return Parent directory, or nullptr if the entry was not found.
+    //
+    FileMetadataCache::Directory* FileMetadataCache::FindEntry(const std::wstring& p_Path,
+                                                               std::wstring& p_rDirectoryPath,
+                                                               const Entry*& p_rpEntry)
+    {
+        std::wstring name;
+        SplitPath(p_Path, p_rDirectoryPath, name);
+
+        auto dirIt = m_mspDirectories.find(p_rDirectoryPath);
+        if (dirIt == m_mspDirectories.end()) {
+            dirIt = m_mspDirectories.emplace(p_rDirectoryPath, std::make_shared<Directory>()).first;
+        }
+        Directory& rDirectory = *dirIt->second;
+
+        // Look for our entry. If we don't know it yet, query only this entry; its
+        // directory's path will be converted once for all entries.
+        auto entryIt = rDirectory.m_mEntries.find(name);
+        if (entryIt == rDirectory.m_mEntries.end()) {
+            if (rDirectory.m_sMissingNames.find(name) != rDirectory.m_sMissingNames.end()) {
+                return nullptr;
+            }
+            WIN32_FIND_DATAW findData;
+            HANDLE hFind = ::FindFirstFileExW(p_Path.c_str(), FindExInfoStandard, &findData,
+                                              FindExSearchNameMatch, nullptr, 0);
+            if (hFind == INVALID_HANDLE_VALUE) {
+                rDirectory.m_sMissingNames.insert(std::move(name));
+                return nullptr;
+            }
+            ::FindClose(hFind);
+            AddEntry(findData, rDirectory);
+            entryIt = rDirectory.m_mEntries.find(name);
+            if (entryIt == rDirectory.m_mEntries.end()) {
+                return nullptr;
+            }
+        }
+
+        p_rpEntry = &entryIt->second;
+        return &rDirectory;
+    }
+
+    //
+    // Converts a path to its long or short version using the cache.
+    //
+    // @param p_Path Path to convert.
+    // @param p_Long Whether to return the long (true) or short (false) version.
+    // @param p_rConvertedPath Where to store the converted path.
+    // @return true if path was found in the cache, false if it must be converted normally.
+    //
+    bool FileMetadataCache::ConvertPath(const std::wstring& p_Path,
+                                        const bool p_Long,
+                                        std::wstring& p_rConvertedPath)
+    {
+        if (!IsCacheablePath(p_Path)) {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(m_Lock);
+        std::wstring directoryPath;
+        const Entry* pEntry = nullptr;
+        Directory* pDirectory = FindEntry(p_Path, directoryPath, pEntry);
+        if (pDirectory == nullptr) {
+            return false;
+        }
+
+        // Convert the directory path once.
+        ConvertedPathM& mConvertedPaths = p_Long ? pDirectory->m_mLongPaths : pDirectory->m_mShortPaths;
+        auto convertedIt = mConvertedPaths.find(directoryPath);
+        if (convertedIt == mConvertedPaths.end()) {
+            std::wstring convertedDirectoryPath = ConvertDirectoryPath(p_Long ? &::GetLongPathNameW : &::GetShortPathNameW,
+                                                                       directoryPath);
+
+            // If the converted path is different, files will probably be looked up through it
+            // afterwards (for instance, to check if the long path is a directory), so record it too.
+            if (!convertedDirectoryPath.empty() && m_mspDirectories.find(convertedDirectoryPath) == m_mspDirectories.end()) {
+                auto dirIt = m_mspDirectories.find(directoryPath);
+                m_mspDirectories.emplace(convertedDirectoryPath, dirIt->second);
+            }
+            convertedIt = mConvertedPaths.emplace(directoryPath, std::move(convertedDirectoryPath)).first;
+        }
+        if (convertedIt->second.empty()) {
+            return false;
+        }
+
+        p_rConvertedPath = JoinPath(convertedIt->second, p_Long ? pEntry->m_LongName : pEntry->m_ShortName);
+        return true;
+    }
+
+    //
+    // Enumerates a directory to fetch the metadata of some of its entries.
+    // Entries that are not found are recorded as missing, unless the
+    // directory could not be enumerated.
+    //
+    // @param p_DirectoryPath Path of directory to enumerate.
+    // @param p_sNames Names of entries to keep (long or short names).
+    // @param p_rDirectory Where to store the metadata of the entries.
+    //
+    void FileMetadataCache::EnumerateDirectory(const std::wstring& p_DirectoryPath,
+                                               const NameS& p_sNames,
+                                               Directory& p_rDirectory)
+    {
+        // Short names are needed, so we can't use FindExInfoBasic.
+        const std::wstring pattern = JoinPath(p_DirectoryPath, L"*");
+        WIN32_FIND_DATAW findData;
+        HANDLE hFind = ::FindFirstFileExW(pattern.c_str(), FindExInfoStandard, &findData,
+                                          FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH_FLAG);
+        if (hFind == INVALID_HANDLE_VALUE && ::GetLastError() == ERROR_INVALID_PARAMETER) {
+            // Large fetch is not supported on this OS.
+            hFind = ::FindFirstFileExW(pattern.c_str(), FindExInfoStandard, &findData,
+                                       FindExSearchNameMatch, nullptr, 0);
+        }
+        if (hFind != INVALID_HANDLE_VALUE) {
+            do {
+                if (p_sNames.find(findData.cFileName) != p_sNames.end() ||
+                    (findData.cAlternateFileName[0] != L'\0' && p_sNames.find(findData.cAlternateFileName) != p_sNames.end())) {
+
+                    AddEntry(findData, p_rDirectory);
+                }
+            } while (::FindNextFileW(hFind, &findData));
+            ::FindClose(hFind);
+
+            for (const std::wstring& name : p_sNames) {
+                if (p_rDirectory.m_mEntries.find(name) == p_rDirectory.m_mEntries.end()) {
+                    p_rDirectory.m_sMissingNames.insert(name);
+                }
+            }
+        }
+    }
+
+    //
+    // Adds an entry to a directory, under its long and short names.
+    //
+    // @param p_FindData Information about the entry, as returned by FindFirstFileExW.
+    // @param p_rDirectory Directory to add the entry to.
+    //
+    void FileMetadataCache::AddEntry(const WIN32_FIND_DATAW& p_FindData,
+                                     Directory& p_rDirectory)
+    {
+        Entry entry;
+        entry.m_LongName = p_FindData.cFileName;
+        entry.m_ShortName = p_FindData.cAlternateFileName[0] != L'\0' ? p_FindData.cAlternateFileName
+                                                                      : p_FindData.cFileName;
+        entry.m_Info.m_Attributes = p_FindData.dwFileAttributes;
+        entry.m_Info.m_Size = (static_cast<ULONGLONG>(p_FindData.nFileSizeHigh) << 32) | p_FindData.nFileSizeLow;
+        entry.m_Info.m_CreationTime = p_FindData.ftCreationTime;
+        entry.m_Info.m_LastAccessTime = p_FindData.ftLastAccessTime;
+        entry.m_Info.m_LastWriteTime = p_FindData.ftLastWriteTime;
+        if (::_wcsicmp(entry.m_ShortName.c_str(), entry.m_LongName.c_str()) != 0) {
+            p_rDirectory.m_mEntries.emplace(entry.m_ShortName, entry);
+        }
+        p_rDirectory.m_mEntries.emplace(entry.m_LongName, std::move(entry));
+    }
+
+    //
+    // Splits a path in its parent directory and name. The separator is kept
+    // for drive roots, so that they are valid paths.
+    //
+    // @param p_Path Path to split. Must be cacheable.
+    // @param p_rDirectoryPath Where to store the path of the parent directory.
+    // @param p_rName Where to store the name.
+    //
+    void FileMetadataCache::SplitPath(const std::wstring& p_Path,
+                                      std::wstring& p_rDirectoryPath,
+                                      std::wstring& p_rName)
+    {
+        const std::wstring::size_type lastDelimPos = p_Path.rfind(L'\\');
+        p_rDirectoryPath.assign(p_Path, 0, lastDelimPos <= 2 ? lastDelimPos + 1 : lastDelimPos);
+        p_rName.assign(p_Path, lastDelimPos + 1, std::wstring::npos);
+    }
+
+    //
+    // Appends a name to the path of a directory.
+    //
+    // @param p_DirectoryPath Path of directory. Can end with a separator.
+    // @param p_Name Name to append.
+    // @return Combined path.
+    //
+    std::wstring FileMetadataCache::JoinPath(const std::wstring& p_DirectoryPath,
+                                             const std::wstring& p_Name)
+    {
+        std::wstring path;
+        path.reserve(p_DirectoryPath.size() + 1 + p_Name.size());
+        path = p_DirectoryPath;
+        if (!path.empty() && path.back() != L'\\') {
+            path += L'\\';
+        }
+        path += p_Name;
+        return path;
+    }
+
+} // namespace PCC
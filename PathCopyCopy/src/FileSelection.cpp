@@ -0,0 +1,286 @@
+// FileSelection.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <stdafx.h>
+#include <FileSelection.h>
+
+#include <algorithm>
+#include <cwchar>
+#include <map>
+
+
+namespace PCC
+{
+    //
+    // Default constructor. Creates an empty selection.
+    //
+    FileSelection::FileSelection()
+        : m_Parent(),
+          m_vBuffer(),
+          m_vOffsets()
+    {
+    }
+
+    //
+    // Constructor with files.
+    //
+    // @param p_vFiles Files to add to the selection.
+    //
+    FileSelection::FileSelection(const FilesV& p_vFiles)
+        : FileSelection()
+    {
+        Reserve(p_vFiles.size());
+        for (const std::wstring& file : p_vFiles) {
+            Add(file);
+        }
+        Compact();
+    }
+
+    //
+    // Returns the number of files in the selection.
+    //
+    // @return Number of files.
+    //
+    size_t FileSelection::Size() const
+    {
+        return m_vOffsets.size();
+    }
+
+    //
+    // Checks if the selection is empty.
+    //
+    // @return true if there are no files in the selection.
+    //
+    bool FileSelection::Empty() const
+    {
+        return m_vOffsets.empty();
+    }
+
+    //
+    // Prepares the selection to receive files.
+    //
+    // @param p_FileCount Number of files that will be added.
+    //
+    void FileSelection::Reserve(const size_t p_FileCount)
+    {
+        m_vOffsets.reserve(p_FileCount);
+    }
+
+    //
+    // Adds a file at the end of the selection.
+    //
+    // @param p_pFile Path of file to add; does not need to be null-terminated.
+    // @param p_Length Length of path, in characters.
+    //
+    void FileSelection::Add(const wchar_t* const p_pFile,
+                            const size_t p_Length)
+    {
+        size_t skipped = 0;
+        if (m_vOffsets.empty()) {
+            // First file: use its parent as the shared parent.
+            m_Parent.clear();
+            m_vBuffer.clear();
+            const wchar_t* const pEnd = p_pFile + p_Length;
+            const wchar_t* const pLastSep = std::find(std::reverse_iterator<const wchar_t*>(pEnd),
+                                                      std::reverse_iterator<const wchar_t*>(p_pFile),
+                                                      L'\\').base();
+            if (pLastSep != p_pFile) {
+                m_Parent.assign(p_pFile, pLastSep);
+                skipped = m_Parent.size();
+            }
+        } else if (!m_Parent.empty()) {
+            if (p_Length >= m_Parent.size() && std::wmemcmp(p_pFile, m_Parent.c_str(), m_Parent.size()) == 0) {
+                skipped = m_Parent.size();
+            } else {
+                FoldParent();
+            }
+        }
+        m_vOffsets.push_back(m_vBuffer.size());
+        m_vBuffer.insert(m_vBuffer.end(), p_pFile + skipped, p_pFile + p_Length);
+    }
+
+    //
+    // Adds a file at the end of the selection.
+    //
+    // @param p_File Path of file to add.
+    //
+    void FileSelection::Add(const std::wstring& p_File)
+    {
+        Add(p_File.c_str(), p_File.size());
+    }
+
+    //
+    // Releases memory reserved for files that have not been added.
+    // Call this once all files have been added, if the selection is kept.
+    //
+    void FileSelection::Compact()
+    {
+        m_vBuffer.shrink_to_fit();
+        m_vOffsets.shrink_to_fit();
+    }
+
+    //
+    // Swaps the content of this selection with another one.
+    //
+    // @param p_rOther Other selection.
+    //
+    void FileSelection::Swap(FileSelection& p_rOther)
+    {
+        m_Parent.swap(p_rOther.m_Parent);
+        m_vBuffer.swap(p_rOther.m_vBuffer);
+        m_vOffsets.swap(p_rOther.m_vOffsets);
+    }
+
+    //
+    // Returns the path of a file in the selection.
+    //
+    // @param p_Index Index of file; must be lower than Size().
+    // @return File path.
+    //
+    std::wstring FileSelection::GetFile(const size_t p_Index) const
+    {
+        std::wstring file;
+        GetFile(p_Index, file);
+        return file;
+    }
+
+    //
+    // Returns the path of a file in the selection. Use this version
+    // when looping through files to reuse the string's memory.
+    //
+    // @param p_Index Index of file; must be lower than Size().
+    // @param p_rFile Where to store the file path.
+    //
+    void FileSelection::GetFile(const size_t p_Index,
+                                std::wstring& p_rFile) const
+    {
+        assert(p_Index < m_vOffsets.size());
+        const size_t begin = m_vOffsets[p_Index];
+        const size_t end = p_Index + 1 < m_vOffsets.size() ? m_vOffsets[p_Index + 1] : m_vBuffer.size();
+        p_rFile.assign(m_Parent);
+        p_rFile.append(m_vBuffer.data() + begin, end - begin);
+    }
+
+    //
+    // Returns the paths of a range of files in the selection.
+    //
+    // @param p_First Index of first file to return.
+    // @param p_Count Maximum number of files to return. Fewer files are
+    //                returned if the selection ends before that.
+    // @param p_rvFiles Where to store the file paths. Existing content is replaced.
+    //
+    void FileSelection::GetFiles(const size_t p_First,
+                                 const size_t p_Count,
+                                 FilesV& p_rvFiles) const
+    {
+        const size_t last = p_First < m_vOffsets.size()
+            ? p_First + (std::min)(p_Count, m_vOffsets.size() - p_First) : p_First;
+        p_rvFiles.resize(last - p_First);
+        for (size_t i = p_First; i < last; ++i) {
+            GetFile(i, p_rvFiles[i - p_First]);
+        }
+    }
+
+    //
+    // Returns the paths of all files in the selection.
+    //
+    // @return File paths.
+    //
+    FilesV FileSelection::GetAllFiles() const
+    {
+        FilesV vFiles;
+        GetFiles(0, m_vOffsets.size(), vFiles);
+        return vFiles;
+    }
+
+    //
+    // Partitions the selection in groups of files sharing the same parent
+    // directory. Groups are returned in the order in which their first file
+    // appears in the selection, and files keep their selection order in each
+    // group, so that results computed per group can be put back in order.
+    // Parent directories are compared without case, like the file system does.
+    //
+    // @return Groups of files per parent directory.
+    //
+    FileSelection::DirectoryGroupV FileSelection::GetDirectoryGroups() const
+    {
+        // Comparator for parent directories; case-insensitive.
+        struct ParentLess {
+            bool operator()(const std::wstring& p_Parent1,
+                            const std::wstring& p_Parent2) const
+            {
+                return ::_wcsicmp(p_Parent1.c_str(), p_Parent2.c_str()) < 0;
+            }
+        };
+
+        DirectoryGroupV vGroups;
+        std::map<std::wstring, size_t, ParentLess> mGroupIndexes;
+        std::wstring parent;
+        for (size_t i = 0; i < m_vOffsets.size(); ++i) {
+            // Parent is the shared parent plus whatever precedes the last separator in the rest of the path.
+            const wchar_t* const pBegin = m_vBuffer.data() + m_vOffsets[i];
+            const wchar_t* const pEnd = m_vBuffer.data() + (i + 1 < m_vOffsets.size() ? m_vOffsets[i + 1] : m_vBuffer.size());
+            const wchar_t* const pLastSep = std::find(std::reverse_iterator<const wchar_t*>(pEnd),
+                                                      std::reverse_iterator<const wchar_t*>(pBegin),
+                                                      L'\\').base();
+            parent.assign(m_Parent);
+            parent.append(pBegin, pLastSep);
+
+            // Files of the same directory are usually next to each other, so check the last group first.
+            size_t groupIndex = vGroups.size();
+            if (!vGroups.empty() && ::_wcsicmp(vGroups.back().m_Parent.c_str(), parent.c_str()) == 0) {
+                groupIndex = vGroups.size() - 1;
+            } else {
+                auto indexIt = mGroupIndexes.find(parent);
+                if (indexIt != mGroupIndexes.end()) {
+                    groupIndex = indexIt->second;
+                } else {
+                    mGroupIndexes.emplace(parent, groupIndex);
+                    vGroups.emplace_back();
+                    vGroups.back().m_Parent = parent;
+                }
+            }
+            vGroups[groupIndex].m_vIndexes.push_back(i);
+        }
+        return vGroups;
+    }
+
+    //
+    // Folds the shared parent back in all files. Called when a file that
+    // is not in the shared parent is added; full paths are stored afterwards.
+    //
+    void FileSelection::FoldParent()
+    {
+        std::vector<wchar_t> vBuffer;
+        vBuffer.reserve(m_vBuffer.size() + m_vOffsets.size() * m_Parent.size());
+        for (size_t i = 0; i < m_vOffsets.size(); ++i) {
+            const size_t begin = m_vOffsets[i];
+            const size_t end = i + 1 < m_vOffsets.size() ? m_vOffsets[i + 1] : m_vBuffer.size();
+            m_vOffsets[i] = vBuffer.size();
+            vBuffer.insert(vBuffer.end(), m_Parent.cbegin(), m_Parent.cend());
+            vBuffer.insert(vBuffer.end(), m_vBuffer.cbegin() + begin, m_vBuffer.cbegin() + end);
+        }
+        m_vBuffer.swap(vBuffer);
+        m_Parent.clear();
+    }
+
+} // namespace PCC
@@ -0,0 +1,237 @@
+// FinalPathResolver.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <stdafx.h>
+#include <FinalPathResolver.h>
+#include <DriveConnectivityCache.h>
+#include <FileMetadataCache.h>
+#include <StringUtils.h>
+
+#include <memory>
+
+
+namespace
+{
+    // Signature of GetFinalPathNameByHandleW, which is only available on Vista and up.
+    typedef DWORD (WINAPI *GetFinalPathNameByHandleWFunc)(HANDLE, LPWSTR, DWORD, DWORD);
+
+    // Flags passed to GetFinalPathNameByHandleW: FILE_NAME_NORMALIZED | VOLUME_NAME_DOS.
+    // These are not defined when targeting Windows XP.
+    const DWORD         FINAL_PATH_FLAGS            = 0x0;
+
+    const wchar_t       EXTENDED_LENGTH_PREFIX[]        = L"\\\\?\\";     // Prefix of extended-length paths, returned by GetFinalPathNameByHandleW.
+    const wchar_t       EXTENDED_LENGTH_UNC_PREFIX[]    = L"\\\\?\\UNC\\";  // Prefix of extended-length UNC paths.
+    const wchar_t       UNC_PREFIX[]                    = L"\\\\";          // Prefix of UNC paths.
+
+} // anonymous namespace
+
+namespace PCC
+{
+    //
+    // Constructor.
+    //
+    // @param p_pMetadataCache Optional cache of file metadata of the current operation.
+    //
+    FinalPathResolver::FinalPathResolver(FileMetadataCache* const p_pMetadataCache)
+        : m_mResolvedPaths(),
+          m_pMetadataCache(p_pMetadataCache)
+    {
+    }
+
+    //
+    // Resolves any reparse point found in the given path to its target,
+    // returning the final path to the file. Paths that are not absolute
+    // or that are on a drive that cannot be reached are left untouched.
+    //
+    // @param p_rPath Path to resolve. Upon exit, will contain the final path.
+    // @return true if path contained reparse points and was modified.
+    //
+    bool FinalPathResolver::Resolve(std::wstring& p_rPath)
+    {
+        const std::wstring::size_type rootSize = GetRootSize(p_rPath);
+        if (rootSize == 0 || !DriveConnectivityCache::IsReachable(p_rPath)) {
+            return false;
+        }
+
+        const std::wstring& finalPath = GetResolvedPath(p_rPath, rootSize);
+        const bool resolved = finalPath != p_rPath;
+        if (resolved) {
+            p_rPath = finalPath;
+        }
+        return resolved;
+    }
+
+    //
+    // Case-insensitive comparison of paths.
+    //
+    // @param p_Path1 First path to compare.
+    // @param p_Path2 Second path to compare.
+    // @return true if p_Path1 is less than p_Path2.
+    //
+    bool FinalPathResolver::PathLess::operator()(const std::wstring& p_Path1,
+                                                 const std::wstring& p_Path2) const
+    {
+        return ::_wcsicmp(p_Path1.c_str(), p_Path2.c_str()) < 0;
+    }
+
+    //
+    // Returns the resolved version of a path, resolving it if this hasn't
+    // been done yet. The parent directory is resolved first (recursively),
+    // then the last component is resolved only if it is a reparse point.
+    //
+    // @param p_Path Absolute path to resolve.
+    // @param p_RootSize Size of the root part of p_Path (see GetRootSize).
+    // @return Resolved path.
+    //
+    const std::wstring& FinalPathResolver::GetResolvedPath(const std::wstring& p_Path,
+                                                           const std::wstring::size_type p_RootSize)
+    {
+        auto it = m_mResolvedPaths.find(p_Path);
+        if (it == m_mResolvedPaths.end()) {
+            std::wstring resolvedPath;
+            const auto delimPos = p_Path.find_last_of(L"\\/");
+            if (p_Path.size() <= p_RootSize || delimPos == std::wstring::npos || delimPos < p_RootSize) {
+                // Root of a drive or share; nothing to resolve.
+                resolvedPath = p_Path;
+            } else {
+                // Resolve parent directory and append last component to it.
+                resolvedPath = GetResolvedPath(p_Path.substr(0, delimPos), p_RootSize);
+                if (resolvedPath.empty() || (resolvedPath.back() != L'\\' && resolvedPath.back() != L'/')) {
+                    resolvedPath += p_Path[delimPos];
+                }
+                resolvedPath.append(p_Path, delimPos + 1, std::wstring::npos);
+
+                // If this component is a reparse point, fetch its target.
+                if (delimPos + 1 < p_Path.size() && IsReparsePoint(resolvedPath)) {
+                    std::wstring finalPath;
+                    if (GetFinalPath(resolvedPath, finalPath)) {
+                        resolvedPath = finalPath;
+                    }
+                }
+            }
+
+            it = m_mResolvedPaths.emplace(p_Path, resolvedPath).first;
+        }
+        return it->second;
+    }
+
+    //
+    // Returns the size of the root part of a path, e.g. "C:" or "\\server\share".
+    //
+    // @param p_Path Path to check.
+    // @return Size of root part, or 0 if path is not an absolute path.
+    //
+    std::wstring::size_type FinalPathResolver::GetRootSize(const std::wstring& p_Path)
+    {
+        std::wstring::size_type rootSize = 0;
+        if (p_Path.size() >= 3 && p_Path[1] == L':' && (p_Path[2] == L'\\' || p_Path[2] == L'/')) {
+            rootSize = 2;
+        } else if (p_Path.size() > 2 && p_Path.compare(0, 2, L"\\\\") == 0 && p_Path[2] != L'?' && p_Path[2] != L'.') {
+            const auto serverDelimPos = p_Path.find_first_of(L"\\/", 2);
+            if (serverDelimPos != std::wstring::npos && serverDelimPos > 2) {
+                const auto shareDelimPos = p_Path.find_first_of(L"\\/", serverDelimPos + 1);
+                if (shareDelimPos == std::wstring::npos) {
+                    rootSize = p_Path.size();
+                } else if (shareDelimPos > serverDelimPos + 1) {
+                    rootSize = shareDelimPos;
+                }
+            }
+        }
+        return rootSize;
+    }
+
+    //
+    // Checks if the given path points to a reparse point. Uses the metadata
+    // cache of the current operation if possible to avoid hitting the disk.
+    //
+    // @param p_Path Path to check.
+    // @return true if p_Path is a reparse point.
+    //
+    bool FinalPathResolver::IsReparsePoint(const std::wstring& p_Path) const
+    {
+        DWORD attribs = INVALID_FILE_ATTRIBUTES;
+        if (m_pMetadataCache == nullptr || !m_pMetadataCache->GetAttributes(p_Path, attribs)) {
+            attribs = ::GetFileAttributesW(p_Path.c_str());
+        }
+        return attribs != INVALID_FILE_ATTRIBUTES &&
+               (attribs & FILE_ATTRIBUTE_REPARSE_POINT) == FILE_ATTRIBUTE_REPARSE_POINT;
+    }
+
+    //
+    // Opens the given reparse point and fetches the final path of its target.
+    // GetFinalPathNameByHandleW is loaded dynamically since it is not
+    // available on Windows XP; on that OS, this always fails.
+    //
+    // @param p_Path Path of reparse point.
+    // @param p_rFinalPath Where to store the final path, without long path prefix.
+    // @return true if final path was fetched.
+    //
+    bool FinalPathResolver::GetFinalPath(const std::wstring& p_Path,
+                                         std::wstring& p_rFinalPath)
+    {
+        GetFinalPathNameByHandleWFunc pGetFinalPathNameByHandleW = nullptr;
+        HMODULE hKernel32 = ::GetModuleHandleW(L"kernel32.dll");
+        if (hKernel32 != NULL) {
+            pGetFinalPathNameByHandleW = reinterpret_cast<GetFinalPathNameByHandleWFunc>(
+                ::GetProcAddress(hKernel32, "GetFinalPathNameByHandleW"));
+        }
+        if (pGetFinalPathNameByHandleW == nullptr) {
+            return false;
+        }
+
+        bool fetched = false;
+        HANDLE hFile = ::CreateFileW(p_Path.c_str(), FILE_READ_ATTRIBUTES,
+                                     FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                     nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, NULL);
+        if (hFile != INVALID_HANDLE_VALUE) {
+            // Try with a buffer on the stack first since most paths are short.
+            // If it's too small, the function returns the required size.
+            std::wstring finalPath;
+            wchar_t buffer[MAX_PATH + 1];
+            DWORD copied = pGetFinalPathNameByHandleW(hFile, buffer, sizeof(buffer) / sizeof(wchar_t), FINAL_PATH_FLAGS);
+            if (copied != 0 && copied < sizeof(buffer) / sizeof(wchar_t)) {
+                finalPath.assign(buffer, copied);
+                fetched = true;
+            } else if (copied != 0) {
+                const DWORD requiredSize = copied;
+                finalPath.resize(requiredSize);
+                copied = pGetFinalPathNameByHandleW(hFile, &*finalPath.begin(), requiredSize, FINAL_PATH_FLAGS);
+                if (copied != 0 && copied < requiredSize) {
+                    finalPath.resize(copied);
+                    fetched = true;
+                }
+            }
+
+            // Remove the extended-length prefix.
+            if (fetched) {
+                if (finalPath.compare(0, StringUtils::LiteralLength(EXTENDED_LENGTH_UNC_PREFIX), EXTENDED_LENGTH_UNC_PREFIX) == 0) {
+                    finalPath.replace(0, StringUtils::LiteralLength(EXTENDED_LENGTH_UNC_PREFIX), UNC_PREFIX);
+                } else if (finalPath.compare(0, StringUtils::LiteralLength(EXTENDED_LENGTH_PREFIX), EXTENDED_LENGTH_PREFIX) == 0) {
+                    finalPath.erase(0, StringUtils::LiteralLength(EXTENDED_LENGTH_PREFIX));
+                }
+                p_rFinalPath.swap(finalPath);
+            }
+            ::CloseHandle(hFile);
+        }
+        return fetched;
+    }
+
+} // namespace PCC
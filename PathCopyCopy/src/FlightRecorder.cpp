@@ -0,0 +1,249 @@
+// FlightRecorder.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <stdafx.h>
+#include <FlightRecorder.h>
+#include <ThreadPool.h>
+
+#include <algorithm>
+#include <cwchar>
+#include <memory>
+#include <string>
+
+
+namespace
+{
+    // Captures are stored outside of our settings key, since changes to that key
+    // are watched and invalidate all cached settings (see RegistryWatcher).
+    const wchar_t* const    PCC_SLOW_OPERATIONS_KEY = L"Software\\clechasseur\\PathCopyCopyCache\\SlowOperations";
+
+    const wchar_t* const    OPERATION_VALUE         = L"Operation"; // Value storing the name of the captured operation.
+    const wchar_t* const    DURATION_VALUE          = L"Duration";  // Value storing the duration of the operation, in microseconds.
+    const wchar_t* const    PHASES_VALUE            = L"Phases";    // Value storing the phases of the operation, one per line: name, microseconds and count separated by tabs.
+
+    const wchar_t* const    MENU_OPERATION_NAME     = L"Menu";      // Name of Operation::Menu in the registry.
+    const wchar_t* const    INVOKE_OPERATION_NAME   = L"Invoke";    // Name of Operation::Invoke in the registry.
+
+    const size_t            MAX_KEY_NAME_SIZE       = 256;          // Max size of a capture's key name.
+
+} // anonymous namespace
+
+namespace PCC
+{
+    // Static members of FlightRecorder
+    const size_t                                FlightRecorder::MAX_RECORDINGS = 16;
+    const size_t                                FlightRecorder::MAX_CAPTURES = 20;
+    const std::chrono::milliseconds             FlightRecorder::SLOW_OPERATION_THRESHOLD(500);
+    std::vector<FlightRecorder::RecordingSP>    FlightRecorder::s_vspActive;
+    std::deque<FlightRecorder::RecordingSP>     FlightRecorder::s_dqspRecent;
+    std::vector<FlightRecorder::RecordingSP>    FlightRecorder::s_vspCaptures;
+    std::atomic<long>                           FlightRecorder::s_ActiveCount(0);
+    std::mutex                                  FlightRecorder::s_Lock;
+
+    //
+    // Adds the duration of a traced event to the phases of all operations
+    // being recorded. Should only be called if Recording returns true;
+    // Trace::WriteEvent does this automatically. Never throws.
+    //
+    // @param p_pName Name of event; must be a literal string.
+    // @param p_Duration Duration of event.
+    //
+    void FlightRecorder::RecordPhase(const wchar_t* const p_pName,
+                                     const std::chrono::microseconds p_Duration)
+    {
+        try {
+            std::lock_guard<std::mutex> lock(s_Lock);
+            for (const RecordingSP& spRecording : s_vspActive) {
+                auto it = std::find_if(spRecording->m_vPhases.begin(), spRecording->m_vPhases.end(), [&](const Phase& p_Phase) {
+                    return p_Phase.m_pName == p_pName || std::wcscmp(p_Phase.m_pName, p_pName) == 0;
+                });
+                if (it != spRecording->m_vPhases.end()) {
+                    it->m_Duration += p_Duration.count();
+                    ++it->m_Count;
+                } else {
+                    Phase phase = { p_pName, p_Duration.count(), 1 };
+                    spRecording->m_vPhases.push_back(phase);
+                }
+            }
+        } catch (...) {
+            // Recordings are not worth failing for.
+        }
+    }
+
+    //
+    // Saves captured slow operations in the registry. The registry is updated
+    // by a low-priority task of the ThreadPool so that the caller, usually the
+    // shell's UI thread, does not wait for it. Never throws.
+    //
+    void FlightRecorder::Save()
+    {
+        try {
+            auto spvspCaptures = std::make_shared<std::vector<RecordingSP>>();
+            {
+                std::lock_guard<std::mutex> lock(s_Lock);
+                spvspCaptures->swap(s_vspCaptures);
+            }
+            if (!spvspCaptures->empty()) {
+                ThreadPool::Submit([spvspCaptures]() {
+                    SaveToRegistry(*spvspCaptures);
+                }, ThreadPool::Priority::Low);
+            }
+        } catch (...) {
+            // Recordings are not worth failing for.
+        }
+    }
+
+    //
+    // Saves captured slow operations in the registry, dropping the oldest
+    // captures if there are too many. Never throws.
+    //
+    // @param p_vspCaptures Captures to save.
+    //
+    void FlightRecorder::SaveToRegistry(const std::vector<RecordingSP>& p_vspCaptures)
+    {
+        try {
+            ATL::CRegKey slowOperationsKey;
+            if (slowOperationsKey.Create(HKEY_CURRENT_USER, PCC_SLOW_OPERATIONS_KEY) != ERROR_SUCCESS) {
+                return;
+            }
+            for (const RecordingSP& spCapture : p_vspCaptures) {
+                // Name capture keys after their start time so that they sort chronologically.
+                wchar_t keyName[MAX_KEY_NAME_SIZE];
+                std::swprintf(keyName, MAX_KEY_NAME_SIZE, L"%08lX%08lX-%lu",
+                              spCapture->m_StartTime.dwHighDateTime, spCapture->m_StartTime.dwLowDateTime,
+                              ::GetCurrentProcessId());
+                ATL::CRegKey captureKey;
+                if (captureKey.Create(slowOperationsKey, keyName) == ERROR_SUCCESS) {
+                    std::wstring phases;
+                    for (const Phase& phase : spCapture->m_vPhases) {
+                        phases += phase.m_pName;
+                        phases += L'\t';
+                        phases += std::to_wstring(phase.m_Duration);
+                        phases += L'\t';
+                        phases += std::to_wstring(phase.m_Count);
+                        phases += L'\0';
+                    }
+                    phases += L'\0';
+                    captureKey.SetStringValue(OPERATION_VALUE, spCapture->m_Operation == Operation::Menu
+                                                               ? MENU_OPERATION_NAME : INVOKE_OPERATION_NAME);
+                    captureKey.SetQWORDValue(DURATION_VALUE, static_cast<ULONGLONG>(spCapture->m_Duration));
+                    captureKey.SetMultiStringValue(PHASES_VALUE, phases.c_str());
+                }
+            }
+
+            // Only keep the last captures.
+            std::vector<std::wstring> vKeyNames;
+            wchar_t keyName[MAX_KEY_NAME_SIZE];
+            DWORD keyNameSize = MAX_KEY_NAME_SIZE;
+            for (DWORD i = 0; slowOperationsKey.EnumKey(i, keyName, &keyNameSize) == ERROR_SUCCESS; ++i) {
+                vKeyNames.emplace_back(keyName, keyNameSize);
+                keyNameSize = MAX_KEY_NAME_SIZE;
+            }
+            if (vKeyNames.size() > MAX_CAPTURES) {
+                std::sort(vKeyNames.begin(), vKeyNames.end());
+                for (size_t i = 0; i < vKeyNames.size() - MAX_CAPTURES; ++i) {
+                    slowOperationsKey.DeleteSubKey(vKeyNames[i].c_str());
+                }
+            }
+        } catch (...) {
+            // Recordings are not worth failing for.
+        }
+    }
+
+    //
+    // Starts recording an operation. Called by StFlightRecording.
+    //
+    // @param p_Operation Operation to record.
+    // @return Recording of the operation.
+    //
+    FlightRecorder::RecordingSP FlightRecorder::Begin(const Operation p_Operation)
+    {
+        auto spRecording = std::make_shared<Recording>();
+        spRecording->m_Operation = p_Operation;
+        ::GetSystemTimeAsFileTime(&spRecording->m_StartTime);
+        spRecording->m_Duration = 0;
+
+        std::lock_guard<std::mutex> lock(s_Lock);
+        s_vspActive.push_back(spRecording);
+        ++s_ActiveCount;
+        return spRecording;
+    }
+
+    //
+    // Stops recording an operation, keeps it with the recent ones and
+    // captures it if it was slow. Called by StFlightRecording.
+    //
+    // @param p_spRecording Recording of the operation.
+    // @param p_Duration Duration of the operation.
+    //
+    void FlightRecorder::End(const RecordingSP& p_spRecording,
+                             const std::chrono::microseconds p_Duration)
+    {
+        std::lock_guard<std::mutex> lock(s_Lock);
+        s_vspActive.erase(std::remove(s_vspActive.begin(), s_vspActive.end(), p_spRecording), s_vspActive.end());
+        --s_ActiveCount;
+
+        p_spRecording->m_Duration = p_Duration.count();
+        s_dqspRecent.push_back(p_spRecording);
+        if (s_dqspRecent.size() > MAX_RECORDINGS) {
+            s_dqspRecent.pop_front();
+        }
+        if (p_Duration >= SLOW_OPERATION_THRESHOLD) {
+            s_vspCaptures.push_back(p_spRecording);
+            if (s_vspCaptures.size() > MAX_CAPTURES) {
+                s_vspCaptures.erase(s_vspCaptures.begin());
+            }
+        }
+    }
+
+    //
+    // Constructor. Starts recording the operation.
+    //
+    // @param p_Operation Operation to record.
+    //
+    StFlightRecording::StFlightRecording(const FlightRecorder::Operation p_Operation)
+        : m_spRecording(),
+          m_Start(std::chrono::steady_clock::now())
+    {
+        try {
+            m_spRecording = FlightRecorder::Begin(p_Operation);
+        } catch (...) {
+            // Operation will not be recorded.
+        }
+    }
+
+    //
+    // Destructor. Stops recording the operation.
+    //
+    StFlightRecording::~StFlightRecording()
+    {
+        if (m_spRecording != nullptr) {
+            try {
+                FlightRecorder::End(m_spRecording, std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - m_Start));
+            } catch (...) {
+                // Recording is lost.
+            }
+        }
+    }
+
+} // namespace PCC
@@ -0,0 +1,383 @@
+// IconCache.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <stdafx.h>
+#include <IconCache.h>
+#include <dllmain.h>
+#include <ReadOnlyMemoryStream.h>
+#include <Trace.h>
+
+#include <vector>
+
+#include <gdiplus.h>
+
+
+namespace PCC
+{
+    // Static members of IconCache
+    IconCache::StImageSP    IconCache::s_spPCCIcon;
+    std::atomic<bool>       IconCache::s_PCCIconLoaded(false);
+    IconCache::IconFileMSP  IconCache::s_spIconFiles;
+    IconCache::ScaledIconMSP
+                            IconCache::s_spScaledIcons;
+    std::unique_ptr<StGdiplusStartup>
+                            IconCache::s_upGdiplusStartup;
+    MeasuredMutex           IconCache::s_Lock(L"IconCache::s_Lock");
+
+    //
+    // Returns the bitmap containing the Path Copy Copy icon
+    // that can be used for contextual menu items, loading it if necessary.
+    //
+    // @return Image containing the icon, or nullptr if loading failed.
+    //
+    IconCache::StImageSP IconCache::GetPCCIcon()
+    {
+        StImageSP spIcon = std::atomic_load(&s_spPCCIcon);
+        if (spIcon != nullptr || s_PCCIconLoaded) {
+            return spIcon;
+        }
+
+        // Load on first call.
+        std::lock_guard<MeasuredMutex> lock(s_Lock);
+        if (!s_PCCIconLoaded) {
+            StTraceEvent traceEvent(L"IconCache::LoadPCCIcon");
+
+            // Load PNG resource.
+            HRSRC hPngRsrcInfo = ::FindResourceW(CPathCopyCopyModule::HInstance(), MAKEINTRESOURCEW(IDB_PCCICON2), L"PNG");
+            if (hPngRsrcInfo != NULL) {
+                HGLOBAL hPngRsrc = ::LoadResource(CPathCopyCopyModule::HInstance(), hPngRsrcInfo);
+                DWORD pngSize = ::SizeofResource(CPathCopyCopyModule::HInstance(), hPngRsrcInfo);
+                if (hPngRsrc != NULL && pngSize != 0) {
+                    const void* pPngData = ::LockResource(hPngRsrc);
+                    if (pPngData != nullptr) {
+                        // Create a read-only IStream directly over the resource data to be able to
+                        // pass it to GDI+. Resource data remains valid as long as our DLL is loaded.
+                        ATL::CComPtr<IStream> cpPngStream;
+                        if (SUCCEEDED(ReadOnlyMemoryStream::Create(pPngData, pngSize, &cpPngStream))) {
+                            std::atomic_store(&s_spPCCIcon, DecodeBitmap(cpPngStream));
+                        }
+                    }
+                }
+            }
+            s_PCCIconLoaded = true;
+        }
+
+        return std::atomic_load(&s_spPCCIcon);
+    }
+
+    //
+    // Given the path to an icon file, returns a bitmap for that icon if possible.
+    // The icon is reloaded if the file has been modified since it was last loaded.
+    //
+    // @param p_IconFile Path to icon file.
+    // @return Image containing the icon, or nullptr if an error occured.
+    //
+    IconCache::StImageSP IconCache::GetIconForIconFile(const std::wstring& p_IconFile)
+    {
+        StImageSP spImage;
+        if (!p_IconFile.empty()) {
+            // Paths are case-insensitive, so our map contains lowercase paths.
+            std::wstring lowerIconFile(p_IconFile);
+            ::CharLowerBuffW(&*lowerIconFile.begin(), static_cast<DWORD>(lowerIconFile.size()));
+
+            // Get the last write time of the file to see if our cached icon is still valid.
+            FILETIME lastWriteTime = { 0 };
+            WIN32_FILE_ATTRIBUTE_DATA fileAttributes;
+            if (::GetFileAttributesExW(p_IconFile.c_str(), GetFileExInfoStandard, &fileAttributes) != FALSE) {
+                lastWriteTime = fileAttributes.ftLastWriteTime;
+            }
+
+            // Look for an icon we loaded previously without locking.
+            if (!FindIconFile(std::atomic_load(&s_spIconFiles), lowerIconFile, lastWriteTime, spImage)) {
+                // Check again with the lock held, in case another thread loaded it meanwhile.
+                std::lock_guard<MeasuredMutex> lock(s_Lock);
+                IconFileMSP spIconFiles = std::atomic_load(&s_spIconFiles);
+                if (!FindIconFile(spIconFiles, lowerIconFile, lastWriteTime, spImage)) {
+                    // This icon file hasn't been loaded yet or was modified, load it now.
+                    StTraceEvent traceEvent(L"IconCache::LoadIconFile");
+                    // First attempt to open the file on disk and get an IStream for it.
+                    ATL::CComPtr<IStream> cpIconFileStream;
+                    if (SUCCEEDED(::SHCreateStreamOnFileEx(p_IconFile.c_str(), STGM_READ | STGM_SHARE_DENY_WRITE | STGM_DIRECT,
+                                                           FILE_ATTRIBUTE_NORMAL, FALSE, nullptr, &cpIconFileStream))) {
+                        spImage = DecodeBitmap(cpIconFileStream);
+                    }
+
+                    // Publish it in a new map, even if it failed, so that we don't try again until the file changes.
+                    std::shared_ptr<IconFileM> spNewIconFiles = spIconFiles != nullptr
+                        ? std::make_shared<IconFileM>(*spIconFiles)
+                        : std::make_shared<IconFileM>();
+                    IconFile& rIconFile = (*spNewIconFiles)[lowerIconFile];
+                    rIconFile.m_spImage = spImage;
+                    rIconFile.m_LastWriteTime = lastWriteTime;
+                    std::atomic_store(&s_spIconFiles, IconFileMSP(std::move(spNewIconFiles)));
+                }
+            }
+        }
+        return spImage;
+    }
+
+    //
+    // Returns a copy of an icon scaled to the given size. Scaled copies are
+    // produced once per icon and size with a high-quality filter, so that
+    // menus can simply blit them when they are painted. Copies are dropped
+    // once their source icon has been released.
+    //
+    // @param p_spIcon Icon to scale, as returned by GetPCCIcon or GetIconForIconFile.
+    // @param p_Width Width of scaled icon, in pixels.
+    // @param p_Height Height of scaled icon, in pixels.
+    // @return Image containing the scaled icon, or nullptr if scaling failed.
+    //         If the icon already has the given size, it is returned as-is.
+    //
+    IconCache::StImageSP IconCache::GetScaledIcon(const StImageSP& p_spIcon,
+                                                  const int p_Width,
+                                                  const int p_Height)
+    {
+        StImageSP spImage;
+        BITMAP bitmapInfo;
+        if (p_spIcon != nullptr && p_Width > 0 && p_Height > 0 &&
+            ::GetObjectW(p_spIcon->GetBitmap(), sizeof(bitmapInfo), &bitmapInfo) != 0) {
+
+            if (bitmapInfo.bmWidth == p_Width && bitmapInfo.bmHeight == p_Height) {
+                spImage = p_spIcon;
+            } else {
+                // Look for a copy we scaled previously without locking.
+                const ScaledIconKey key(p_spIcon.get(), p_Width, p_Height);
+                if (!FindScaledIcon(std::atomic_load(&s_spScaledIcons), key, p_spIcon, spImage)) {
+                    // Check again with the lock held, in case another thread scaled it meanwhile.
+                    std::lock_guard<MeasuredMutex> lock(s_Lock);
+                    ScaledIconMSP spScaledIcons = std::atomic_load(&s_spScaledIcons);
+                    if (!FindScaledIcon(spScaledIcons, key, p_spIcon, spImage)) {
+                        StTraceEvent traceEvent(L"IconCache::ScaleIcon");
+                        spImage = ScaleBitmap(p_spIcon->GetBitmap(), p_Width, p_Height);
+
+                        // Publish it in a new map, even if it failed, so that we don't try again.
+                        // Drop copies of icons that were released; their address could be reused.
+                        std::shared_ptr<ScaledIconM> spNewScaledIcons = std::make_shared<ScaledIconM>();
+                        if (spScaledIcons != nullptr) {
+                            for (const auto& scaledIconPair : *spScaledIcons) {
+                                if (!scaledIconPair.second.m_wpSource.expired()) {
+                                    spNewScaledIcons->insert(scaledIconPair);
+                                }
+                            }
+                        }
+                        ScaledIcon& rScaledIcon = (*spNewScaledIcons)[key];
+                        rScaledIcon.m_wpSource = p_spIcon;
+                        rScaledIcon.m_spImage = spImage;
+                        std::atomic_store(&s_spScaledIcons, ScaledIconMSP(std::move(spNewScaledIcons)));
+                    }
+                }
+            }
+        }
+        return spImage;
+    }
+
+    //
+    // Releases all cached icons and shuts down GDI+ if it was initialized.
+    // Called when the DLL is about to be unloaded or when our caches are
+    // trimmed (see CacheManager); if icons are requested afterwards, they
+    // will be loaded again.
+    //
+    void IconCache::Release()
+    {
+        std::lock_guard<MeasuredMutex> lock(s_Lock);
+
+        // Reset the flag first so that GetPCCIcon reloads the icon if it sees it's gone.
+        s_PCCIconLoaded = false;
+        std::atomic_store(&s_spPCCIcon, StImageSP());
+        std::atomic_store(&s_spIconFiles, IconFileMSP());
+        std::atomic_store(&s_spScaledIcons, ScaledIconMSP());
+        s_upGdiplusStartup.reset();
+    }
+
+    //
+    // Looks for an icon loaded from a file in a published map of icons.
+    //
+    // @param p_spIconFiles Map of icons loaded from files; can be nullptr.
+    // @param p_LowerIconFile Lowercase path to icon file.
+    // @param p_LastWriteTime Current last write time of file.
+    // @param p_rspImage Where to store the icon if found; can be nullptr
+    //                   if we failed to load the icon previously.
+    // @return true if the icon was found and the file hasn't changed since.
+    //
+    bool IconCache::FindIconFile(const IconFileMSP& p_spIconFiles,
+                                 const std::wstring& p_LowerIconFile,
+                                 const FILETIME& p_LastWriteTime,
+                                 StImageSP& p_rspImage)
+    {
+        bool found = false;
+        if (p_spIconFiles != nullptr) {
+            auto it = p_spIconFiles->find(p_LowerIconFile);
+            if (it != p_spIconFiles->end() && ::CompareFileTime(&it->second.m_LastWriteTime, &p_LastWriteTime) == 0) {
+                p_rspImage = it->second.m_spImage;
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    //
+    // Looks for a scaled copy of an icon in a published map of scaled icons.
+    //
+    // @param p_spScaledIcons Map of scaled icons; can be nullptr.
+    // @param p_Key Key of scaled icon.
+    // @param p_spIcon Icon that was scaled.
+    // @param p_rspImage Where to store the scaled icon if found; can be nullptr
+    //                   if we failed to scale the icon previously.
+    // @return true if the scaled icon was found.
+    //
+    bool IconCache::FindScaledIcon(const ScaledIconMSP& p_spScaledIcons,
+                                   const ScaledIconKey& p_Key,
+                                   const StImageSP& p_spIcon,
+                                   StImageSP& p_rspImage)
+    {
+        bool found = false;
+        if (p_spScaledIcons != nullptr) {
+            auto it = p_spScaledIcons->find(p_Key);
+            if (it != p_spScaledIcons->end() && it->second.m_wpSource.lock() == p_spIcon) {
+                p_rspImage = it->second.m_spImage;
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    //
+    // Loads a bitmap from a stream containing image data, using GDI+.
+    // Must be called with s_Lock held.
+    //
+    // @param p_pStream Stream containing image data.
+    // @return Image containing the bitmap, or nullptr if loading failed.
+    //
+    IconCache::StImageSP IconCache::DecodeBitmap(IStream* const p_pStream)
+    {
+        StImageSP spImage;
+
+        if (StartGdiplus()) {
+            // Extract HBITMAP using GDI+.
+            HBITMAP hBitmap = NULL;
+            Gdiplus::Bitmap bitmap(p_pStream, FALSE);
+            if (bitmap.GetHBITMAP(Gdiplus::Color(), &hBitmap) == Gdiplus::Ok) {
+                spImage = std::make_shared<StImage>(hBitmap, IMAGE_BITMAP, false);
+                if (spImage->GetLoadResult() != ERROR_SUCCESS) {
+                    spImage.reset();
+                }
+            }
+        }
+
+        return spImage;
+    }
+
+    //
+    // Scales a bitmap to the given size using GDI+'s high-quality bicubic
+    // filter. The source bitmap must contain 32bpp premultiplied pixels,
+    // like those produced by DecodeBitmap; so does the scaled bitmap,
+    // which is a DIB section that can be passed directly to AlphaBlend.
+    // Must be called with s_Lock held.
+    //
+    // @param p_hBitmap Bitmap to scale.
+    // @param p_Width Width of scaled bitmap, in pixels.
+    // @param p_Height Height of scaled bitmap, in pixels.
+    // @return Image containing the scaled bitmap, or nullptr if scaling failed.
+    //
+    IconCache::StImageSP IconCache::ScaleBitmap(HBITMAP const p_hBitmap,
+                                                const int p_Width,
+                                                const int p_Height)
+    {
+        StImageSP spImage;
+
+        BITMAP sourceInfo;
+        if (StartGdiplus() && ::GetObjectW(p_hBitmap, sizeof(sourceInfo), &sourceInfo) != 0 &&
+            sourceInfo.bmWidth > 0 && sourceInfo.bmHeight > 0) {
+
+            // Fetch source pixels as top-down 32bpp rows.
+            BITMAPINFO bitmapInfo = { 0 };
+            bitmapInfo.bmiHeader.biSize = sizeof(bitmapInfo.bmiHeader);
+            bitmapInfo.bmiHeader.biWidth = sourceInfo.bmWidth;
+            bitmapInfo.bmiHeader.biHeight = -sourceInfo.bmHeight;
+            bitmapInfo.bmiHeader.biPlanes = 1;
+            bitmapInfo.bmiHeader.biBitCount = 32;
+            bitmapInfo.bmiHeader.biCompression = BI_RGB;
+            std::vector<BYTE> vSourcePixels(static_cast<size_t>(sourceInfo.bmWidth) * sourceInfo.bmHeight * 4);
+            HDC hScreenDC = ::GetDC(NULL);
+            if (hScreenDC != NULL) {
+                HBITMAP hScaledBitmap = NULL;
+                void* pScaledPixels = nullptr;
+                if (::GetDIBits(hScreenDC, p_hBitmap, 0, static_cast<UINT>(sourceInfo.bmHeight), &vSourcePixels[0],
+                                &bitmapInfo, DIB_RGB_COLORS) == sourceInfo.bmHeight) {
+
+                    bitmapInfo.bmiHeader.biWidth = p_Width;
+                    bitmapInfo.bmiHeader.biHeight = -p_Height;
+                    hScaledBitmap = ::CreateDIBSection(hScreenDC, &bitmapInfo, DIB_RGB_COLORS, &pScaledPixels, NULL, 0);
+                }
+                ::ReleaseDC(NULL, hScreenDC);
+
+                if (hScaledBitmap != NULL) {
+                    // Wrap both pixel buffers in GDI+ bitmaps so that GDI+ draws directly in our DIB section.
+                    Gdiplus::Status status;
+                    {
+                        Gdiplus::Bitmap sourceBitmap(sourceInfo.bmWidth, sourceInfo.bmHeight, sourceInfo.bmWidth * 4,
+                                                     PixelFormat32bppPARGB, &vSourcePixels[0]);
+                        Gdiplus::Bitmap scaledBitmap(p_Width, p_Height, p_Width * 4,
+                                                     PixelFormat32bppPARGB, static_cast<BYTE*>(pScaledPixels));
+                        Gdiplus::Graphics graphics(&scaledBitmap);
+                        graphics.SetCompositingMode(Gdiplus::CompositingModeSourceCopy);
+                        graphics.SetInterpolationMode(Gdiplus::InterpolationModeHighQualityBicubic);
+                        graphics.SetPixelOffsetMode(Gdiplus::PixelOffsetModeHighQuality);
+
+                        // Mirror pixels at the edges so that the filter does not blend them with transparency.
+                        Gdiplus::ImageAttributes attributes;
+                        attributes.SetWrapMode(Gdiplus::WrapModeTileFlipXY);
+                        status = graphics.DrawImage(&sourceBitmap, Gdiplus::Rect(0, 0, p_Width, p_Height),
+                                                    0, 0, sourceInfo.bmWidth, sourceInfo.bmHeight,
+                                                    Gdiplus::UnitPixel, &attributes);
+                    }
+                    if (status == Gdiplus::Ok) {
+                        spImage = std::make_shared<StImage>(hScaledBitmap, IMAGE_BITMAP, false);
+                        if (spImage->GetLoadResult() != ERROR_SUCCESS) {
+                            spImage.reset();
+                        }
+                    } else {
+                        ::DeleteObject(hScaledBitmap);
+                    }
+                }
+            }
+        }
+
+        return spImage;
+    }
+
+    //
+    // Initializes GDI+ to be able to use its calls, since shell doesn't do it.
+    // We only do this once, since starting GDI+ is costly.
+    // Must be called with s_Lock held.
+    //
+    // @return true if GDI+ is initialized.
+    //
+    bool IconCache::StartGdiplus()
+    {
+        if (s_upGdiplusStartup == nullptr) {
+            s_upGdiplusStartup = std::make_unique<StGdiplusStartup>();
+        }
+        return s_upGdiplusStartup->Started();
+    }
+
+} // namespace PCC
@@ -0,0 +1,165 @@
+// LiteralReplacer.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <stdafx.h>
+#include <LiteralReplacer.h>
+
+#include <algorithm>
+#include <utility>
+
+#include <assert.h>
+
+
+namespace
+{
+    // Minimum length of values to search using Boyer-Moore-Horspool.
+    // Below this, the skip table doesn't pay for itself.
+    const std::wstring::size_type   BMH_MIN_LENGTH  = 4;
+
+} // anonymous namespace
+
+namespace PCC
+{
+    //
+    // Constructor.
+    //
+    // @param p_OldValue Value to replace. If empty, nothing will be replaced.
+    // @param p_NewValue Replacement value.
+    // @param p_IgnoreCase Whether to ignore case when looking for p_OldValue.
+    //
+    LiteralReplacer::LiteralReplacer(const std::wstring& p_OldValue,
+                                     const std::wstring& p_NewValue,
+                                     const bool p_IgnoreCase)
+        : m_OldValue(p_OldValue),
+          m_NewValue(p_NewValue),
+          m_IgnoreCase(p_IgnoreCase),
+          m_vSkips()
+    {
+        if (m_IgnoreCase) {
+            std::transform(m_OldValue.begin(), m_OldValue.end(), m_OldValue.begin(), &FoldCase);
+        }
+
+        // Build skip table for long values. Each entry contains the distance
+        // from the last occurrence of a character (other than the last one)
+        // to the end of the value; characters not in the value can skip it entirely.
+        const std::wstring::size_type oldSize = m_OldValue.size();
+        if (oldSize >= BMH_MIN_LENGTH) {
+            m_vSkips.assign(SKIP_TABLE_SIZE, oldSize);
+            for (std::wstring::size_type i = 0; i + 1 < oldSize; ++i) {
+                m_vSkips[m_OldValue[i] % SKIP_TABLE_SIZE] = oldSize - 1 - i;
+            }
+        }
+    }
+
+    //
+    // Replaces all instances of our old value in the given string
+    // with our new value.
+    //
+    // @param p_rString String to modify (in-place).
+    //
+    void LiteralReplacer::ReplaceAll(std::wstring& p_rString) const
+    {
+        if (m_OldValue.empty() || p_rString.size() < m_OldValue.size()) {
+            return;
+        }
+
+        // When ignoring case, search in a case-folded copy; since folding
+        // does not change the length, positions are the same in both strings.
+        std::wstring foldedString;
+        if (m_IgnoreCase) {
+            foldedString.resize(p_rString.size());
+            std::transform(p_rString.cbegin(), p_rString.cend(), foldedString.begin(), &FoldCase);
+        }
+        const std::wstring& searchedString = m_IgnoreCase ? foldedString : p_rString;
+
+        std::wstring::size_type pos = Find(searchedString, 0);
+        if (pos != std::wstring::npos) {
+            std::wstring result;
+            if (m_NewValue.size() > m_OldValue.size()) {
+                result.reserve(p_rString.size() + (m_NewValue.size() - m_OldValue.size()) * 4);
+            } else {
+                result.reserve(p_rString.size());
+            }
+            std::wstring::size_type from = 0;
+            while (pos != std::wstring::npos) {
+                result.append(p_rString, from, pos - from);
+                result.append(m_NewValue);
+                from = pos + m_OldValue.size();
+                pos = Find(searchedString, from);
+            }
+            result.append(p_rString, from, std::wstring::npos);
+            p_rString = std::move(result);
+        }
+    }
+
+    //
+    // Folds the case of a character, for case-insensitive comparisons.
+    //
+    // @param p_Char Character to fold.
+    // @return Case-folded character.
+    //
+    wchar_t LiteralReplacer::FoldCase(const wchar_t p_Char)
+    {
+        wchar_t folded = p_Char;
+        if (p_Char < 0x80) {
+            if (p_Char >= L'a' && p_Char <= L'z') {
+                folded = static_cast<wchar_t>(p_Char - L'a' + L'A');
+            }
+        } else {
+            // Passing a single character to CharUpper converts it in the pointer value.
+            folded = static_cast<wchar_t>(reinterpret_cast<UINT_PTR>(
+                ::CharUpperW(reinterpret_cast<LPWSTR>(static_cast<UINT_PTR>(p_Char)))));
+        }
+        return folded;
+    }
+
+    //
+    // Looks for our old value in a string.
+    //
+    // @param p_String String to look into. Must be case-folded if we ignore case.
+    // @param p_From Position where to start looking.
+    // @return Position of the next instance of our old value, or npos if not found.
+    //
+    std::wstring::size_type LiteralReplacer::Find(const std::wstring& p_String,
+                                                  const std::wstring::size_type p_From) const
+    {
+        if (m_vSkips.empty()) {
+            return p_String.find(m_OldValue, p_From);
+        }
+
+        const std::wstring::size_type oldSize = m_OldValue.size();
+        const std::wstring::size_type size = p_String.size();
+        const wchar_t* const pString = p_String.c_str();
+        const wchar_t* const pOld = m_OldValue.c_str();
+        const wchar_t lastOldChar = pOld[oldSize - 1];
+        std::wstring::size_type pos = p_From;
+        while (pos + oldSize <= size) {
+            const wchar_t lastChar = pString[pos + oldSize - 1];
+            if (lastChar == lastOldChar && ::wmemcmp(pString + pos, pOld, oldSize - 1) == 0) {
+                return pos;
+            }
+            pos += m_vSkips[lastChar % SKIP_TABLE_SIZE];
+        }
+        return std::wstring::npos;
+    }
+
+} // namespace PCC
@@ -0,0 +1,410 @@
+// MachineNetworkCache.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <stdafx.h>
+#include <MachineNetworkCache.h>
+#include <SystemNetworkEnvironment.h>
+
+#include <aclapi.h>
+#include <sddl.h>
+#include <string.h>
+
+
+namespace
+{
+    // Names of the objects shared by the writer and sessions. They are created
+    // by the writer in the global namespace.
+    const wchar_t* const    SECTION_NAME            = L"Global\\PathCopyCopy.MachineNetworkCache";
+    const wchar_t* const    WRITER_MUTEX_NAME       = L"Global\\PathCopyCopy.MachineNetworkCache.Writer";
+    const wchar_t* const    QUIT_EVENT_NAME         = L"Global\\PathCopyCopy.MachineNetworkCache.Quit";
+
+    // Security descriptors of the shared objects. Sessions can read the section,
+    // but only the writer's account and administrators can do more.
+    const wchar_t* const    SECTION_SDDL            = L"D:(A;;GA;;;SY)(A;;GA;;;BA)(A;;GR;;;WD)";
+    const wchar_t* const    WRITER_SDDL             = L"D:(A;;GA;;;SY)(A;;GA;;;BA)";
+
+    // Size of the shared memory section and version of its format.
+    const DWORD             SECTION_SIZE            = 1024 * 1024;
+    const DWORD             FORMAT_VERSION          = 2;
+
+    // Time the writer waits before checking shares again, in milliseconds.
+    const DWORD             SHARES_CHECK_MS         = 5 * 1000;
+
+    // Minimum time between attempts to open the section when no writer runs, in milliseconds.
+    const DWORD             REOPEN_INTERVAL_MS      = 60 * 1000;
+
+    // Flags stored in the section's header.
+    const DWORD             SECTION_FLAG_HAS_SHARES = 0x1;
+
+    // Kinds of records stored in the section's data. Records of other kinds are ignored.
+    const DWORD             RECORD_SHARE            = 1;    // Strings: share name, share path.
+
+    //
+    // Header of a single record stored in the section's data.
+    // It is followed by its strings (without terminating nulls).
+    //
+    struct SharedRecord {
+        DWORD           m_Kind;             // One of the RECORD_* values.
+        DWORD           m_Sizes[2];         // Sizes of strings, in characters.
+    };
+
+    //
+    // Security attributes built from a security descriptor string.
+    //
+    struct SecurityAttributes {
+        SECURITY_ATTRIBUTES m_Attributes;   // Attributes; lpSecurityDescriptor is nullptr if invalid.
+
+                        explicit SecurityAttributes(const wchar_t* const p_pSDDL)
+                            : m_Attributes()
+                        {
+                            m_Attributes.nLength = sizeof(m_Attributes);
+                            if (!::ConvertStringSecurityDescriptorToSecurityDescriptorW(p_pSDDL, SDDL_REVISION_1,
+                                    &m_Attributes.lpSecurityDescriptor, nullptr)) {
+
+                                m_Attributes.lpSecurityDescriptor = nullptr;
+                            }
+                        }
+                        SecurityAttributes(const SecurityAttributes&) = delete;
+        SecurityAttributes& operator=(const SecurityAttributes&) = delete;
+                        ~SecurityAttributes()
+                        {
+                            if (m_Attributes.lpSecurityDescriptor != nullptr) {
+                                ::LocalFree(m_Attributes.lpSecurityDescriptor);
+                            }
+                        }
+    };
+
+    //
+    // Checks whether a shared object we created can be trusted. Any user can
+    // create mutexes and events in the global namespace, so if an object
+    // already existed, our security descriptor was ignored and the object
+    // might be controlled by someone else. Such objects are only trusted if
+    // they are owned by the local system or administrators.
+    //
+    // @param p_hObject Handle of object; NULL if it could not be created.
+    // @param p_AlreadyExisted Whether the object already existed when it was created.
+    // @return true if p_hObject is valid and can be trusted.
+    //
+    bool IsTrustedObject(const HANDLE p_hObject,
+                         const bool p_AlreadyExisted)
+    {
+        if (p_hObject == NULL) {
+            return false;
+        }
+        if (!p_AlreadyExisted) {
+            return true;
+        }
+
+        bool trusted = false;
+        PSID pOwner = nullptr;
+        PSECURITY_DESCRIPTOR pDescriptor = nullptr;
+        if (::GetSecurityInfo(p_hObject, SE_KERNEL_OBJECT, OWNER_SECURITY_INFORMATION,
+                              &pOwner, nullptr, nullptr, nullptr, &pDescriptor) == ERROR_SUCCESS) {
+
+            trusted = pOwner != nullptr && (::IsWellKnownSid(pOwner, WinLocalSystemSid) ||
+                                            ::IsWellKnownSid(pOwner, WinBuiltinAdministratorsSid));
+            ::LocalFree(pDescriptor);
+        }
+        return trusted;
+    }
+
+    //
+    // Appends a record to serialized section data, unless it would not fit.
+    //
+    // @param p_rvData Serialized data.
+    // @param p_Capacity Maximum size of serialized data, in bytes.
+    // @param p_Record Record header; sizes are filled from the strings.
+    // @param p_pStrings Strings of the record.
+    // @param p_NumStrings Number of strings; at most 2.
+    //
+    void AppendRecord(std::vector<BYTE>& p_rvData,
+                      const size_t p_Capacity,
+                      SharedRecord p_Record,
+                      const std::wstring* const p_pStrings[],
+                      const size_t p_NumStrings)
+    {
+        size_t recordSize = sizeof(SharedRecord);
+        for (size_t i = 0; i < p_NumStrings; ++i) {
+            p_Record.m_Sizes[i] = static_cast<DWORD>(p_pStrings[i]->size());
+            recordSize += p_pStrings[i]->size() * sizeof(wchar_t);
+        }
+        if (p_rvData.size() + recordSize <= p_Capacity) {
+            const BYTE* const pRecord = reinterpret_cast<const BYTE*>(&p_Record);
+            p_rvData.insert(p_rvData.end(), pRecord, pRecord + sizeof(SharedRecord));
+            for (size_t i = 0; i < p_NumStrings; ++i) {
+                const BYTE* const pChars = reinterpret_cast<const BYTE*>(p_pStrings[i]->c_str());
+                p_rvData.insert(p_rvData.end(), pChars, pChars + p_pStrings[i]->size() * sizeof(wchar_t));
+            }
+        }
+    }
+
+} // anonymous namespace
+
+namespace PCC
+{
+    //
+    // Content of the shared memory section. Its data, a sequence of
+    // records, follows immediately after.
+    //
+    struct MachineNetworkCache::SharedHeader {
+        volatile LONG   m_Sequence;         // Incremented before and after writes; odd while writing.
+        DWORD           m_FormatVersion;    // FORMAT_VERSION once data has been published.
+        DWORD           m_Flags;            // Combination of SECTION_FLAG_* values.
+        FILETIME        m_SharesWriteTime;  // Last write time of shares key when shares were enumerated.
+        DWORD           m_DataSize;         // Size of data following header, in bytes.
+    };
+
+    // Static members of MachineNetworkCache
+    ATL::CHandle                        MachineNetworkCache::s_hMapping;
+    const MachineNetworkCache::SharedHeader*
+                                        MachineNetworkCache::s_pHeader          = nullptr;
+    DWORD                               MachineNetworkCache::s_LastOpenAttempt  = 0;
+    LONG                                MachineNetworkCache::s_Sequence         = 0;
+    bool                                MachineNetworkCache::s_HasShares        = false;
+    FILETIME                            MachineNetworkCache::s_SharesWriteTime  = FILETIME();
+    NetworkEnvironment::ShareInfoV      MachineNetworkCache::s_vShares;
+    std::mutex                          MachineNetworkCache::s_Lock;
+
+    //
+    // Returns the shares of the local computer published by the writer,
+    // if they are up to date.
+    //
+    // @param p_SharesWriteTime Current last write time of the shares registry key.
+    // @param p_rvShares Upon success, will contain the shares.
+    // @return true if published shares were up to date and were returned.
+    //
+    bool MachineNetworkCache::GetShares(const FILETIME& p_SharesWriteTime,
+                                        NetworkEnvironment::ShareInfoV& p_rvShares)
+    {
+        std::lock_guard<std::mutex> lock(s_Lock);
+        const bool upToDate = Refresh() && s_HasShares &&
+                              s_SharesWriteTime.dwLowDateTime == p_SharesWriteTime.dwLowDateTime &&
+                              s_SharesWriteTime.dwHighDateTime == p_SharesWriteTime.dwHighDateTime;
+        if (upToDate) {
+            p_rvShares = s_vShares;
+        }
+        return upToDate;
+    }
+
+    //
+    // Runs the writer until it is stopped (see Stop). Does nothing if another
+    // writer is already running, if we are not allowed to create global
+    // objects or if the shared objects were created beforehand by an untrusted
+    // user. Shares are enumerated again whenever they change.
+    //
+    void MachineNetworkCache::Run()
+    {
+        SecurityAttributes writerAttributes(WRITER_SDDL);
+        SecurityAttributes sectionAttributes(SECTION_SDDL);
+        if (writerAttributes.m_Attributes.lpSecurityDescriptor == nullptr ||
+            sectionAttributes.m_Attributes.lpSecurityDescriptor == nullptr) {
+
+            return;
+        }
+
+        // Make sure we're the only writer. The mutex is released if we die,
+        // so that another writer can take over the section.
+        ATL::CHandle hWriterMutex(::CreateMutexW(&writerAttributes.m_Attributes, FALSE, WRITER_MUTEX_NAME));
+        if (!IsTrustedObject(hWriterMutex, ::GetLastError() == ERROR_ALREADY_EXISTS)) {
+            return;
+        }
+        const DWORD waitRes = ::WaitForSingleObject(hWriterMutex, 0);
+        if (waitRes != WAIT_OBJECT_0 && waitRes != WAIT_ABANDONED) {
+            return;
+        }
+
+        ATL::CHandle hQuitEvent(::CreateEventW(&writerAttributes.m_Attributes, TRUE, FALSE, QUIT_EVENT_NAME));
+        const bool quitEventTrusted = IsTrustedObject(hQuitEvent, ::GetLastError() == ERROR_ALREADY_EXISTS);
+        ATL::CHandle hMapping(::CreateFileMappingW(INVALID_HANDLE_VALUE, &sectionAttributes.m_Attributes,
+                                                   PAGE_READWRITE, 0, SECTION_SIZE, SECTION_NAME));
+        const bool mappingTrusted = IsTrustedObject(hMapping, ::GetLastError() == ERROR_ALREADY_EXISTS);
+        SharedHeader* const pHeader = mappingTrusted
+            ? static_cast<SharedHeader*>(::MapViewOfFile(hMapping, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, SECTION_SIZE))
+            : nullptr;
+        if (quitEventTrusted && pHeader != nullptr) {
+            ::ResetEvent(hQuitEvent);
+
+            // Our own enumerations must not be served from the section we publish.
+            SystemNetworkEnvironment environment(false);
+            bool hasShares = false;
+            FILETIME sharesWriteTime = FILETIME();
+            NetworkEnvironment::ShareInfoV vShares;
+            do {
+                bool changed = false;
+                if (environment.SharesChanged()) {
+                    hasShares = environment.GetShares(vShares, sharesWriteTime);
+                    changed = true;
+                }
+                if (changed || pHeader->m_FormatVersion != FORMAT_VERSION) {
+                    Publish(pHeader, hasShares, sharesWriteTime, vShares);
+                }
+            } while (::WaitForSingleObject(hQuitEvent, SHARES_CHECK_MS) == WAIT_TIMEOUT);
+        }
+
+        if (pHeader != nullptr) {
+            ::UnmapViewOfFile(pHeader);
+        }
+        ::ReleaseMutex(hWriterMutex);
+    }
+
+    //
+    // Stops the writer, if it is running.
+    //
+    // @return true if the writer was asked to stop.
+    //
+    bool MachineNetworkCache::Stop()
+    {
+        ATL::CHandle hQuitEvent(::OpenEventW(EVENT_MODIFY_STATE, FALSE, QUIT_EVENT_NAME));
+        return hQuitEvent != NULL && ::SetEvent(hQuitEvent) != FALSE;
+    }
+
+    //
+    // Opens the shared memory section if needed and reloads its content
+    // if it was published again since we last read it. If no writer runs,
+    // opening the section is attempted again at most every REOPEN_INTERVAL_MS.
+    //
+    // Must be called with s_Lock held.
+    //
+    // @return true if the section is open.
+    //
+    bool MachineNetworkCache::Refresh()
+    {
+        if (s_pHeader == nullptr) {
+            const DWORD now = ::GetTickCount();
+            if (s_LastOpenAttempt != 0 && now - s_LastOpenAttempt < REOPEN_INTERVAL_MS) {
+                return false;
+            }
+            s_LastOpenAttempt = now != 0 ? now : 1;
+            s_hMapping.Attach(::OpenFileMappingW(FILE_MAP_READ, FALSE, SECTION_NAME));
+            if (s_hMapping != NULL) {
+                s_pHeader = static_cast<const SharedHeader*>(::MapViewOfFile(s_hMapping, FILE_MAP_READ,
+                                                                              0, 0, SECTION_SIZE));
+            }
+            if (s_pHeader == nullptr) {
+                s_hMapping.Close();
+                return false;
+            }
+        }
+
+        // Copy the data locally, making sure it wasn't modified while we copied it.
+        // If the writer is publishing right now, keep using what we have.
+        const LONG sequence = s_pHeader->m_Sequence;
+        ::MemoryBarrier();
+        if (sequence == s_Sequence || (sequence & 1) != 0 || s_pHeader->m_FormatVersion != FORMAT_VERSION) {
+            return true;
+        }
+        const bool hasShares = (s_pHeader->m_Flags & SECTION_FLAG_HAS_SHARES) != 0;
+        const FILETIME sharesWriteTime = s_pHeader->m_SharesWriteTime;
+        const DWORD dataSize = (std::min)(s_pHeader->m_DataSize,
+                                          static_cast<DWORD>(SECTION_SIZE - sizeof(SharedHeader)));
+        std::vector<BYTE> vData(reinterpret_cast<const BYTE*>(s_pHeader + 1),
+                                reinterpret_cast<const BYTE*>(s_pHeader + 1) + dataSize);
+        ::MemoryBarrier();
+        if (s_pHeader->m_Sequence != sequence) {
+            return true;
+        }
+
+        NetworkEnvironment::ShareInfoV vShares;
+        if (Parse(vData, vShares)) {
+            s_Sequence = sequence;
+            s_HasShares = hasShares;
+            s_SharesWriteTime = sharesWriteTime;
+            s_vShares = std::move(vShares);
+        }
+        return true;
+    }
+
+    //
+    // Publishes network info in the shared memory section. Shares that do
+    // not fit in the section are skipped.
+    //
+    // @param p_pHeader Header of shared memory section.
+    // @param p_HasShares Whether shares could be enumerated.
+    // @param p_SharesWriteTime Last write time of shares key when shares were enumerated.
+    // @param p_vShares Shares of the local computer.
+    //
+    void MachineNetworkCache::Publish(SharedHeader* const p_pHeader,
+                                      const bool p_HasShares,
+                                      const FILETIME& p_SharesWriteTime,
+                                      const NetworkEnvironment::ShareInfoV& p_vShares)
+    {
+        // Serialize records first.
+        const size_t capacity = SECTION_SIZE - sizeof(SharedHeader);
+        std::vector<BYTE> vData;
+        for (const NetworkEnvironment::ShareInfo& share : p_vShares) {
+            SharedRecord record = SharedRecord();
+            record.m_Kind = RECORD_SHARE;
+            const std::wstring* const strings[] = { &share.m_Name, &share.m_Path };
+            AppendRecord(vData, capacity, record, strings, 2);
+        }
+
+        // We're the only writer, so we simply mark the section as being written.
+        ::InterlockedIncrement(&p_pHeader->m_Sequence);
+        p_pHeader->m_FormatVersion = FORMAT_VERSION;
+        p_pHeader->m_Flags = p_HasShares ? SECTION_FLAG_HAS_SHARES : 0;
+        p_pHeader->m_SharesWriteTime = p_SharesWriteTime;
+        p_pHeader->m_DataSize = static_cast<DWORD>(vData.size());
+        if (!vData.empty()) {
+            ::memcpy(p_pHeader + 1, vData.data(), vData.size());
+        }
+        ::InterlockedIncrement(&p_pHeader->m_Sequence);
+    }
+
+    //
+    // Parses data read from the shared memory section.
+    //
+    // @param p_vData Data following the section's header.
+    // @param p_rvShares Upon success, will contain the published shares.
+    // @return true if data was valid.
+    //
+    bool MachineNetworkCache::Parse(const std::vector<BYTE>& p_vData,
+                                    NetworkEnvironment::ShareInfoV& p_rvShares)
+    {
+        size_t offset = 0;
+        while (offset < p_vData.size()) {
+            SharedRecord record;
+            if (p_vData.size() - offset < sizeof(SharedRecord)) {
+                return false;
+            }
+            ::memcpy(&record, p_vData.data() + offset, sizeof(SharedRecord));
+            offset += sizeof(SharedRecord);
+
+            std::wstring strings[2];
+            for (size_t i = 0; i < 2; ++i) {
+                const size_t stringSize = static_cast<size_t>(record.m_Sizes[i]) * sizeof(wchar_t);
+                if (p_vData.size() - offset < stringSize) {
+                    return false;
+                }
+                strings[i].resize(record.m_Sizes[i]);
+                if (stringSize != 0) {
+                    ::memcpy(&strings[i][0], p_vData.data() + offset, stringSize);
+                }
+                offset += stringSize;
+            }
+
+            if (record.m_Kind == RECORD_SHARE) {
+                p_rvShares.emplace_back(strings[0], strings[1]);
+            }
+        }
+        return true;
+    }
+
+} // namespace PCC
@@ -0,0 +1,108 @@
+// MeasuredMutex.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <stdafx.h>
+#include <MeasuredMutex.h>
+
+
+namespace PCC
+{
+#ifdef PCC_BENCHMARKS
+    // Static members of MeasuredMutex
+    MeasuredMutex*          MeasuredMutex::s_apMutexes[MeasuredMutex::MAX_MUTEXES] = { nullptr };
+    std::atomic<size_t>     MeasuredMutex::s_NumMutexes(0);
+#endif // PCC_BENCHMARKS
+
+    //
+    // Constructor. In benchmark builds, registers the mutex so that its statistics
+    // can be enumerated. If too many mutexes are registered, the mutex still works
+    // but is not reported.
+    //
+    // @param p_pName Name of mutex, used when reporting statistics; must be a literal string.
+    //
+    MeasuredMutex::MeasuredMutex(const wchar_t* const p_pName)
+        : m_Mutex(),
+          m_pName(p_pName),
+          m_Acquisitions(0),
+          m_Contentions(0),
+          m_WaitMicroseconds(0),
+          m_MaxWaitMicroseconds(0)
+    {
+#ifdef PCC_BENCHMARKS
+        const size_t index = s_NumMutexes.fetch_add(1);
+        if (index < MAX_MUTEXES) {
+            s_apMutexes[index] = this;
+        }
+#endif // PCC_BENCHMARKS
+    }
+
+#ifdef PCC_BENCHMARKS
+    //
+    // Enumerates the statistics of all registered mutexes.
+    //
+    // @param p_pProc Callback invoked for each mutex.
+    // @param p_pContext Context passed to p_pProc.
+    // @param p_Reset Whether to clear statistics after enumerating them.
+    //                Acquisitions performed meanwhile might be lost.
+    //
+    void MeasuredMutex::EnumStatistics(StatisticsProc const p_pProc,
+                                       void* const p_pContext,
+                                       const bool p_Reset)
+    {
+        const size_t numMutexes = s_NumMutexes.load();
+        for (size_t i = 0; i < numMutexes && i < MAX_MUTEXES; ++i) {
+            MeasuredMutex* const pMutex = s_apMutexes[i];
+            if (pMutex != nullptr) {
+                const Statistics statistics = { pMutex->m_pName,
+                                                pMutex->m_Acquisitions.load(std::memory_order_relaxed),
+                                                pMutex->m_Contentions.load(std::memory_order_relaxed),
+                                                pMutex->m_WaitMicroseconds.load(std::memory_order_relaxed),
+                                                pMutex->m_MaxWaitMicroseconds.load(std::memory_order_relaxed) };
+                p_pProc(statistics, p_pContext);
+                if (p_Reset) {
+                    pMutex->m_Acquisitions.store(0, std::memory_order_relaxed);
+                    pMutex->m_Contentions.store(0, std::memory_order_relaxed);
+                    pMutex->m_WaitMicroseconds.store(0, std::memory_order_relaxed);
+                    pMutex->m_MaxWaitMicroseconds.store(0, std::memory_order_relaxed);
+                }
+            }
+        }
+    }
+
+    //
+    // Records a wait to acquire the mutex.
+    //
+    // @param p_Wait Time spent waiting.
+    //
+    void MeasuredMutex::RecordWait(const std::chrono::microseconds p_Wait)
+    {
+        const ULONGLONG wait = static_cast<ULONGLONG>(p_Wait.count());
+        m_Contentions.fetch_add(1, std::memory_order_relaxed);
+        m_WaitMicroseconds.fetch_add(wait, std::memory_order_relaxed);
+        ULONGLONG maxWait = m_MaxWaitMicroseconds.load(std::memory_order_relaxed);
+        while (wait > maxWait && !m_MaxWaitMicroseconds.compare_exchange_weak(maxWait, wait, std::memory_order_relaxed)) {
+            // maxWait now contains the longest wait recorded by another thread, retry.
+        }
+    }
+#endif // PCC_BENCHMARKS
+
+} // namespace PCC
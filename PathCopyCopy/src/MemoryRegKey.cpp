@@ -0,0 +1,342 @@
+// MemoryRegKey.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <stdafx.h>
+
+#ifdef PCC_BENCHMARKS
+
+#include <MemoryRegKey.h>
+
+#include <cwchar>
+
+
+//
+// Constructor. The key is initially empty.
+//
+MemoryRegKey::MemoryRegKey()
+    : RegKey(),
+      m_mValues(),
+      m_mupSubKeys()
+{
+}
+
+//
+// Checks if this key is valid. In-memory keys always are.
+//
+// @return true.
+//
+bool MemoryRegKey::Valid() const
+{
+    return true;
+}
+
+//
+// Tries to load a DWORD value from the key.
+//
+// @param p_pValueName Name of value to load.
+// @param p_rValue Where to store value.
+// @return Result code (ERROR_SUCCESS if it worked).
+//
+long MemoryRegKey::QueryDWORDValue(const wchar_t* const p_pValueName,
+                                   DWORD& p_rValue) const
+{
+    long res = ERROR_FILE_NOT_FOUND;
+    const ValueData* const pValue = FindValue(p_pValueName);
+    if (pValue != nullptr) {
+        if (pValue->m_Type == REG_DWORD && pValue->m_vData.size() == sizeof(DWORD)) {
+            ::memcpy(&p_rValue, pValue->m_vData.data(), sizeof(DWORD));
+            res = ERROR_SUCCESS;
+        } else {
+            res = ERROR_INVALID_DATA;
+        }
+    }
+    return res;
+}
+
+//
+// Tries to load a QWORD value from the key.
+//
+// @param p_pValueName Name of value to load.
+// @param p_rValue Where to store value.
+// @return Result code (ERROR_SUCCESS if it worked).
+//
+long MemoryRegKey::QueryQWORDValue(const wchar_t* const p_pValueName,
+                                   ULONGLONG& p_rValue) const
+{
+    long res = ERROR_FILE_NOT_FOUND;
+    const ValueData* const pValue = FindValue(p_pValueName);
+    if (pValue != nullptr) {
+        if (pValue->m_Type == REG_QWORD && pValue->m_vData.size() == sizeof(ULONGLONG)) {
+            ::memcpy(&p_rValue, pValue->m_vData.data(), sizeof(ULONGLONG));
+            res = ERROR_SUCCESS;
+        } else {
+            res = ERROR_INVALID_DATA;
+        }
+    }
+    return res;
+}
+
+//
+// Tries to load a GUID value from the key (stored as a string).
+//
+// @param p_pValueName Name of value to load.
+// @param p_rValue Where to store value.
+// @return Result code (ERROR_SUCCESS if it worked).
+//
+long MemoryRegKey::QueryGUIDValue(const wchar_t* const p_pValueName,
+                                  GUID& p_rValue) const
+{
+    long res = ERROR_FILE_NOT_FOUND;
+    const ValueData* const pValue = FindValue(p_pValueName);
+    if (pValue != nullptr) {
+        res = ERROR_INVALID_DATA;
+        if (pValue->m_Type == REG_SZ && (pValue->m_vData.size() % sizeof(wchar_t)) == 0) {
+            std::wstring guidAsString(reinterpret_cast<const wchar_t*>(pValue->m_vData.data()),
+                                      pValue->m_vData.size() / sizeof(wchar_t));
+            guidAsString.resize(::wcsnlen(guidAsString.c_str(), guidAsString.size()));
+            if (SUCCEEDED(::CLSIDFromString(guidAsString.c_str(), &p_rValue))) {
+                res = ERROR_SUCCESS;
+            }
+        }
+    }
+    return res;
+}
+
+//
+// Tries to load a value from the key.
+//
+// @param p_pValueName Name of value to load.
+// @param p_pValueType If set, will receive the type of value.
+// @param p_pValue Pointer to buffer where to store value. Can be null.
+// @param p_pValueSize Pointer to variable containing the size of p_pValue.
+//                     Upon exit, will contain the actual size of the
+//                     value copied to p_pValue. Can be null only if p_pValue is too.
+// @return Result code (ERROR_SUCCESS if it worked).
+//
+long MemoryRegKey::QueryValue(const wchar_t* const p_pValueName,
+                              DWORD* const p_pValueType,
+                              void* const p_pValue,
+                              DWORD* const p_pValueSize) const
+{
+    long res = ERROR_FILE_NOT_FOUND;
+    if (p_pValue != nullptr && p_pValueSize == nullptr) {
+        res = ERROR_INVALID_PARAMETER;
+    } else {
+        const ValueData* const pValue = FindValue(p_pValueName);
+        if (pValue != nullptr) {
+            const DWORD dataSize = static_cast<DWORD>(pValue->m_vData.size());
+            res = ERROR_SUCCESS;
+            if (p_pValue != nullptr) {
+                if (*p_pValueSize >= dataSize) {
+                    ::memcpy(p_pValue, pValue->m_vData.data(), dataSize);
+                } else {
+                    res = ERROR_MORE_DATA;
+                }
+            }
+            if (p_pValueType != nullptr) {
+                *p_pValueType = pValue->m_Type;
+            }
+            if (p_pValueSize != nullptr) {
+                *p_pValueSize = dataSize;
+            }
+        }
+    }
+    return res;
+}
+
+//
+// Returns a list of all values in the key.
+//
+// @param p_rvValues Where to store information about the values.
+//
+void MemoryRegKey::GetValues(ValueInfoV& p_rvValues) const
+{
+    p_rvValues.reserve(p_rvValues.size() + m_mValues.size());
+    for (const auto& nameAndValue : m_mValues) {
+        p_rvValues.emplace_back(NULL, nameAndValue.first.c_str());
+    }
+}
+
+//
+// Returns a list of all subkeys of the key. Use GetSubKey to access them.
+//
+// @param p_rvSubkeys Where to store information about the subkeys.
+//
+void MemoryRegKey::GetSubKeys(SubkeyInfoV& p_rvSubkeys) const
+{
+    p_rvSubkeys.reserve(p_rvSubkeys.size() + m_mupSubKeys.size());
+    for (const auto& nameAndSubKey : m_mupSubKeys) {
+        p_rvSubkeys.emplace_back(NULL, nameAndSubKey.first.c_str());
+    }
+}
+
+//
+// Saves a DWORD value in the key.
+//
+// @param p_pValueName Name of value to save.
+// @param p_pValue Value to save.
+// @return Result code (ERROR_SUCCESS if it worked).
+//
+long MemoryRegKey::SetDWORDValue(const wchar_t* const p_pValueName,
+                                 const DWORD p_Value)
+{
+    return SetValue(p_pValueName, REG_DWORD, &p_Value, sizeof(p_Value));
+}
+
+//
+// Saves a QWORD value in the key.
+//
+// @param p_pValueName Name of value to save.
+// @param p_pValue Value to save.
+// @return Result code (ERROR_SUCCESS if it worked).
+//
+long MemoryRegKey::SetQWORDValue(const wchar_t* const p_pValueName,
+                                 const ULONGLONG p_Value)
+{
+    return SetValue(p_pValueName, REG_QWORD, &p_Value, sizeof(p_Value));
+}
+
+//
+// Saves a GUID value in the key (as a string).
+//
+// @param p_pValueName Name of value to save.
+// @param p_pValue Value to save.
+// @return Result code (ERROR_SUCCESS if it worked).
+//
+long MemoryRegKey::SetGUIDValue(const wchar_t* const p_pValueName,
+                                const GUID& p_Value)
+{
+    wchar_t guidAsString[39];
+    long res = ERROR_INVALID_PARAMETER;
+    if (::StringFromGUID2(p_Value, guidAsString, ARRAYSIZE(guidAsString)) != 0) {
+        res = SetStringValue(p_pValueName, guidAsString);
+    }
+    return res;
+}
+
+//
+// Saves a string value in the key.
+//
+// @param p_pValueName Name of value to save.
+// @param p_pValue Value to save.
+// @return Result code (ERROR_SUCCESS if it worked).
+//
+long MemoryRegKey::SetStringValue(const wchar_t* const p_pValueName,
+                                  const wchar_t* const p_pValue)
+{
+    long res = ERROR_INVALID_PARAMETER;
+    if (p_pValue != nullptr) {
+        res = SetValue(p_pValueName, REG_SZ, p_pValue,
+                       static_cast<DWORD>((::wcslen(p_pValue) + 1) * sizeof(wchar_t)));
+    }
+    return res;
+}
+
+//
+// Deletes a value from the key.
+//
+// @param p_pValueName Name of value to delete.
+// @return Result code (ERROR_SUCCESS if it worked).
+//
+long MemoryRegKey::DeleteValue(const wchar_t* const p_pValueName)
+{
+    return m_mValues.erase(p_pValueName != nullptr ? p_pValueName : L"") != 0 ? ERROR_SUCCESS : ERROR_FILE_NOT_FOUND;
+}
+
+//
+// Saves a value of any type in the key. Useful for types that have
+// no specific setter, like REG_MULTI_SZ or REG_BINARY.
+//
+// @param p_pValueName Name of value to save.
+// @param p_ValueType Type of value (REG_DWORD, REG_SZ, etc.)
+// @param p_pValue Pointer to value data. Can be null only if p_ValueSize is 0.
+// @param p_ValueSize Size of value data, in bytes.
+// @return Result code (ERROR_SUCCESS if it worked).
+//
+long MemoryRegKey::SetValue(const wchar_t* const p_pValueName,
+                            const DWORD p_ValueType,
+                            const void* const p_pValue,
+                            const DWORD p_ValueSize)
+{
+    long res = ERROR_INVALID_PARAMETER;
+    if (p_pValue != nullptr || p_ValueSize == 0) {
+        ValueData& rValue = m_mValues[p_pValueName != nullptr ? p_pValueName : L""];
+        rValue.m_Type = p_ValueType;
+        const BYTE* const pData = static_cast<const BYTE*>(p_pValue);
+        rValue.m_vData.assign(pData, pData + p_ValueSize);
+        res = ERROR_SUCCESS;
+    }
+    return res;
+}
+
+//
+// Returns a subkey of this key, creating it if it doesn't exist.
+//
+// @param p_pKeyName Name of subkey.
+// @return Reference to subkey. Owned by this key.
+//
+MemoryRegKey& MemoryRegKey::CreateSubKey(const wchar_t* const p_pKeyName)
+{
+    std::unique_ptr<MemoryRegKey>& rupSubKey = m_mupSubKeys[p_pKeyName];
+    if (rupSubKey == nullptr) {
+        rupSubKey.reset(new MemoryRegKey());
+    }
+    return *rupSubKey;
+}
+
+//
+// Returns an existing subkey of this key.
+//
+// @param p_pKeyName Name of subkey.
+// @return Pointer to subkey, or nullptr if it doesn't exist. Owned by this key.
+//
+MemoryRegKey* MemoryRegKey::GetSubKey(const wchar_t* const p_pKeyName) const
+{
+    auto it = m_mupSubKeys.find(p_pKeyName);
+    return it != m_mupSubKeys.end() ? it->second.get() : nullptr;
+}
+
+//
+// Compares two value or key names without case sensitivity.
+//
+// @param p_Name1 First name to compare.
+// @param p_Name2 Second name to compare.
+// @return true if p_Name1 is before p_Name2.
+//
+bool MemoryRegKey::NameLess::operator()(const std::wstring& p_Name1,
+                                        const std::wstring& p_Name2) const
+{
+    return ::_wcsicmp(p_Name1.c_str(), p_Name2.c_str()) < 0;
+}
+
+//
+// Finds a value in the key.
+//
+// @param p_pValueName Name of value to find. If null, finds the default value.
+// @return Pointer to value data, or nullptr if value doesn't exist.
+//
+const MemoryRegKey::ValueData* MemoryRegKey::FindValue(const wchar_t* const p_pValueName) const
+{
+    auto it = m_mValues.find(p_pValueName != nullptr ? p_pValueName : L"");
+    return it != m_mValues.end() ? &it->second : nullptr;
+}
+
+#endif // PCC_BENCHMARKS
@@ -0,0 +1,122 @@
+// MenuTemplateCache.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <stdafx.h>
+#include <MenuTemplateCache.h>
+
+#include <algorithm>
+
+
+namespace PCC
+{
+    const size_t                    MenuTemplateCache::MAX_TEMPLATES    = 4;
+    const std::chrono::milliseconds MenuTemplateCache::TIME_TO_LIVE     = std::chrono::milliseconds(5000);
+
+    std::deque<MenuTemplateCache::MenuTemplate>
+                                    MenuTemplateCache::s_dqTemplates;
+    MeasuredMutex                   MenuTemplateCache::s_Lock(L"MenuTemplateCache::s_Lock");
+
+    //
+    // Fetches the information computed for a menu built for the same selection,
+    // if it has not expired. Information is added to the given maps; plugins
+    // already in the maps are left untouched.
+    //
+    // @param p_FirstFile First selected file.
+    // @param p_FileCount Number of selected files.
+    // @param p_Generation Settings generation (see PluginsSnapshot::GetGeneration).
+    // @param p_rmEnabled Where to add plugins' enabled states.
+    // @param p_rmFirstFilePaths Where to add paths of the first selected file.
+    // @return true if a menu template was found.
+    //
+    bool MenuTemplateCache::Get(const std::wstring& p_FirstFile,
+                                const UINT p_FileCount,
+                                const ULONG p_Generation,
+                                PluginEnabledM& p_rmEnabled,
+                                PluginPathM& p_rmFirstFilePaths)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        std::lock_guard<MeasuredMutex> lock(s_Lock);
+        auto it = std::find_if(s_dqTemplates.cbegin(), s_dqTemplates.cend(), [&](const MenuTemplate& p_Template) {
+            return p_Template.m_FileCount == p_FileCount &&
+                   p_Template.m_Generation == p_Generation &&
+                   p_Template.m_Expiration > now &&
+                   p_Template.m_FirstFile == p_FirstFile;
+        });
+        const bool found = it != s_dqTemplates.cend();
+        if (found) {
+            p_rmEnabled.insert(it->m_mEnabled.cbegin(), it->m_mEnabled.cend());
+            p_rmFirstFilePaths.insert(it->m_mFirstFilePaths.cbegin(), it->m_mFirstFilePaths.cend());
+        }
+        return found;
+    }
+
+    //
+    // Stores the information computed for a menu. If a template already exists
+    // for the same selection, the information is merged into it and it does not
+    // expire sooner than before; otherwise, a new template is created, replacing
+    // the oldest one if needed.
+    //
+    // @param p_FirstFile First selected file.
+    // @param p_FileCount Number of selected files.
+    // @param p_Generation Settings generation (see PluginsSnapshot::GetGeneration).
+    // @param p_mEnabled Plugins' enabled states.
+    // @param p_mFirstFilePaths Paths of the first selected file, per plugin.
+    //
+    void MenuTemplateCache::Update(const std::wstring& p_FirstFile,
+                                   const UINT p_FileCount,
+                                   const ULONG p_Generation,
+                                   const PluginEnabledM& p_mEnabled,
+                                   const PluginPathM& p_mFirstFilePaths)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        std::lock_guard<MeasuredMutex> lock(s_Lock);
+
+        // Drop expired templates first.
+        s_dqTemplates.erase(std::remove_if(s_dqTemplates.begin(), s_dqTemplates.end(), [&](const MenuTemplate& p_Template) {
+            return p_Template.m_Expiration <= now;
+        }), s_dqTemplates.end());
+
+        auto it = std::find_if(s_dqTemplates.begin(), s_dqTemplates.end(), [&](const MenuTemplate& p_Template) {
+            return p_Template.m_FileCount == p_FileCount &&
+                   p_Template.m_Generation == p_Generation &&
+                   p_Template.m_FirstFile == p_FirstFile;
+        });
+        if (it == s_dqTemplates.end()) {
+            if (s_dqTemplates.size() >= MAX_TEMPLATES) {
+                s_dqTemplates.pop_back();
+            }
+            MenuTemplate newTemplate;
+            newTemplate.m_FirstFile = p_FirstFile;
+            newTemplate.m_FileCount = p_FileCount;
+            newTemplate.m_Generation = p_Generation;
+            newTemplate.m_Expiration = now + TIME_TO_LIVE;
+            s_dqTemplates.push_front(std::move(newTemplate));
+            it = s_dqTemplates.begin();
+        }
+        for (const auto& enabled : p_mEnabled) {
+            it->m_mEnabled[enabled.first] = enabled.second;
+        }
+        for (const auto& path : p_mFirstFilePaths) {
+            it->m_mFirstFilePaths[path.first] = path.second;
+        }
+    }
+
+} // namespace PCC
@@ -0,0 +1,277 @@
+// MetadataExporter.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <stdafx.h>
+#include <MetadataExporter.h>
+#include <FileMetadataCache.h>
+
+#include <cwchar>
+#include <initializer_list>
+#include <memory>
+#include <utility>
+
+#include <assert.h>
+
+
+namespace
+{
+    const wchar_t   CSV_HEADER[]            = L"Path,Size,Created,Modified,Accessed,Attributes\r\n";
+    const wchar_t   CSV_SEPARATOR[]         = L"\r\n";
+    const wchar_t   JSON_ARRAY_START[]      = L"[\r\n  ";
+    const wchar_t   JSON_ARRAY_END[]        = L"\r\n]";
+    const wchar_t   JSON_SEPARATOR[]        = L",\r\n  ";
+    const wchar_t   JSON_NULL[]             = L"null";
+
+    // Letters used to represent file attributes, in the order they are output.
+    const struct {
+        DWORD       m_Attribute;
+        wchar_t     m_Letter;
+    } ATTRIBUTE_LETTERS[] = {
+        { FILE_ATTRIBUTE_READONLY,      L'R' },
+        { FILE_ATTRIBUTE_HIDDEN,        L'H' },
+        { FILE_ATTRIBUTE_SYSTEM,        L'S' },
+        { FILE_ATTRIBUTE_DIRECTORY,     L'D' },
+        { FILE_ATTRIBUTE_ARCHIVE,       L'A' },
+        { FILE_ATTRIBUTE_REPARSE_POINT, L'L' },
+        { FILE_ATTRIBUTE_COMPRESSED,    L'C' },
+        { FILE_ATTRIBUTE_ENCRYPTED,     L'E' },
+        { FILE_ATTRIBUTE_OFFLINE,       L'O' },
+    };
+
+} // anonymous namespace
+
+namespace PCC
+{
+    //
+    // Formats paths computed by a plugin as records including the metadata
+    // of their files. Records of files that cannot be found only contain
+    // their path; the size of directories is omitted.
+    //
+    // @param p_Format Format of records. If ExportFormat::None, paths are returned as-is.
+    // @param p_vFiles Files that were converted.
+    // @param p_vPaths Paths computed for the files, in the same order.
+    // @return Formatted records, in the same order. The first record includes
+    //         the CSV header or the start of the JSON array, while the last
+    //         one includes the end of the JSON array.
+    //
+    WStringV MetadataExporter::FormatRecords(const ExportFormat p_Format,
+                                             const FilesV& p_vFiles,
+                                             const WStringV& p_vPaths)
+    {
+        assert(p_vFiles.size() == p_vPaths.size());
+        if (p_Format == ExportFormat::None || p_vPaths.empty()) {
+            return p_vPaths;
+        }
+
+        // Prefetch metadata per parent directory.
+        FileMetadataCache metadataCache;
+        metadataCache.Prefetch(p_vFiles);
+
+        WStringV vRecords;
+        vRecords.reserve(p_vPaths.size());
+        std::wstring record;
+        for (size_t i = 0; i < p_vPaths.size(); ++i) {
+            FileMetadataCache::FileInfo info;
+            bool found = metadataCache.GetFileInfo(p_vFiles[i], info);
+            if (!found) {
+                // Paths that cannot be cached (e.g. longer than MAX_PATH) must be queried directly.
+                WIN32_FILE_ATTRIBUTE_DATA data;
+                found = ::GetFileAttributesExW(p_vFiles[i].c_str(), GetFileExInfoStandard, &data) != FALSE;
+                if (found) {
+                    info.m_Attributes = data.dwFileAttributes;
+                    info.m_Size = (static_cast<ULONGLONG>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+                    info.m_CreationTime = data.ftCreationTime;
+                    info.m_LastAccessTime = data.ftLastAccessTime;
+                    info.m_LastWriteTime = data.ftLastWriteTime;
+                }
+            }
+            const bool isFile = found && (info.m_Attributes & FILE_ATTRIBUTE_DIRECTORY) == 0;
+            const std::wstring size = isFile ? std::to_wstring(info.m_Size) : std::wstring();
+            const std::wstring created = found ? FormatTime(info.m_CreationTime) : std::wstring();
+            const std::wstring modified = found ? FormatTime(info.m_LastWriteTime) : std::wstring();
+            const std::wstring accessed = found ? FormatTime(info.m_LastAccessTime) : std::wstring();
+            const std::wstring attributes = found ? FormatAttributes(info.m_Attributes) : std::wstring();
+
+            record.clear();
+            if (p_Format == ExportFormat::CSV) {
+                if (i == 0) {
+                    record += CSV_HEADER;
+                }
+                AppendCSVField(record, p_vPaths[i]);
+                for (const std::wstring* pValue : { &size, &created, &modified, &accessed, &attributes }) {
+                    record += L',';
+                    AppendCSVField(record, *pValue);
+                }
+            } else {
+                if (i == 0) {
+                    record += JSON_ARRAY_START;
+                }
+                record += L"{\"path\": ";
+                AppendJSONString(record, p_vPaths[i]);
+                record += L", \"size\": ";
+                record += isFile ? size : JSON_NULL;
+                const std::pair<const wchar_t*, const std::wstring*> members[] = {
+                    { L", \"created\": ",       &created },
+                    { L", \"modified\": ",      &modified },
+                    { L", \"accessed\": ",      &accessed },
+                };
+                for (const auto& member : members) {
+                    record += member.first;
+                    if (!member.second->empty()) {
+                        AppendJSONString(record, *member.second);
+                    } else {
+                        record += JSON_NULL;
+                    }
+                }
+                record += L", \"attributes\": ";
+                if (found) {
+                    AppendJSONString(record, attributes);
+                } else {
+                    record += JSON_NULL;
+                }
+                record += L'}';
+                if (i + 1 == p_vPaths.size()) {
+                    record += JSON_ARRAY_END;
+                }
+            }
+            vRecords.push_back(record);
+        }
+        return vRecords;
+    }
+
+    //
+    // Returns the separator to use between records returned by FormatRecords.
+    //
+    // @param p_Format Format of records.
+    // @return Separator between records, or an empty string if p_Format is
+    //         ExportFormat::None, in which case the usual separator applies.
+    //
+    std::wstring MetadataExporter::RecordsSeparator(const ExportFormat p_Format)
+    {
+        switch (p_Format) {
+            case ExportFormat::CSV:
+                return CSV_SEPARATOR;
+            case ExportFormat::JSON:
+                return JSON_SEPARATOR;
+            default:
+                return std::wstring();
+        }
+    }
+
+    //
+    // Appends a field to a CSV record. The field is quoted if it contains
+    // characters that have a special meaning in CSV (see RFC 4180).
+    //
+    // @param p_rRecord Record to append to.
+    // @param p_Value Value of field.
+    //
+    void MetadataExporter::AppendCSVField(std::wstring& p_rRecord,
+                                          const std::wstring& p_Value)
+    {
+        if (p_Value.find_first_of(L",\"\r\n") == std::wstring::npos) {
+            p_rRecord += p_Value;
+        } else {
+            p_rRecord += L'"';
+            for (const wchar_t c : p_Value) {
+                if (c == L'"') {
+                    p_rRecord += L'"';
+                }
+                p_rRecord += c;
+            }
+            p_rRecord += L'"';
+        }
+    }
+
+    //
+    // Appends a string to a JSON record, quoted and escaped.
+    //
+    // @param p_rRecord Record to append to.
+    // @param p_Value String to append.
+    //
+    void MetadataExporter::AppendJSONString(std::wstring& p_rRecord,
+                                            const std::wstring& p_Value)
+    {
+        p_rRecord += L'"';
+        for (const wchar_t c : p_Value) {
+            switch (c) {
+                case L'"':  p_rRecord += L"\\\""; break;
+                case L'\\': p_rRecord += L"\\\\"; break;
+                case L'\n': p_rRecord += L"\\n"; break;
+                case L'\r': p_rRecord += L"\\r"; break;
+                case L'\t': p_rRecord += L"\\t"; break;
+                default: {
+                    if (c < L' ') {
+                        wchar_t escaped[7];
+                        ::swprintf_s(escaped, L"\\u%04x", static_cast<unsigned int>(c));
+                        p_rRecord += escaped;
+                    } else {
+                        p_rRecord += c;
+                    }
+                    break;
+                }
+            }
+        }
+        p_rRecord += L'"';
+    }
+
+    //
+    // Formats a file time in ISO 8601 format, in UTC.
+    //
+    // @param p_Time Time to format.
+    // @return Formatted time, like 2019-01-31T23:59:59Z, or an empty
+    //         string if the time is not set.
+    //
+    std::wstring MetadataExporter::FormatTime(const FILETIME& p_Time)
+    {
+        std::wstring formatted;
+        SYSTEMTIME systemTime;
+        if ((p_Time.dwLowDateTime != 0 || p_Time.dwHighDateTime != 0) &&
+            ::FileTimeToSystemTime(&p_Time, &systemTime) != FALSE) {
+
+            wchar_t buffer[32];
+            ::swprintf_s(buffer, L"%04u-%02u-%02uT%02u:%02u:%02uZ",
+                         systemTime.wYear, systemTime.wMonth, systemTime.wDay,
+                         systemTime.wHour, systemTime.wMinute, systemTime.wSecond);
+            formatted = buffer;
+        }
+        return formatted;
+    }
+
+    //
+    // Formats file attributes as a string of letters, like the attrib command:
+    // R (read-only), H (hidden), S (system), D (directory), A (archive),
+    // L (reparse point), C (compressed), E (encrypted) and O (offline).
+    //
+    // @param p_Attributes File attributes.
+    // @return Letters of attributes that are set.
+    //
+    std::wstring MetadataExporter::FormatAttributes(const DWORD p_Attributes)
+    {
+        std::wstring letters;
+        for (const auto& attributeLetter : ATTRIBUTE_LETTERS) {
+            if ((p_Attributes & attributeLetter.m_Attribute) != 0) {
+                letters += attributeLetter.m_Letter;
+            }
+        }
+        return letters;
+    }
+
+} // namespace PCC
@@ -0,0 +1,117 @@
+// NetworkEnvironment.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <stdafx.h>
+#include <NetworkEnvironment.h>
+#include <DFSReferralCache.h>
+#include <DriveConnectivityCache.h>
+#include <FQDNCache.h>
+#include <PathResultCache.h>
+#include <PluginUtils.h>
+#include <ShortNameSupportCache.h>
+#include <SystemNetworkEnvironment.h>
+
+
+namespace PCC
+{
+    // Static members of NetworkEnvironment
+    NetworkEnvironmentSP    NetworkEnvironment::s_spCurrent;
+
+    //
+    // Default constructor.
+    //
+    NetworkEnvironment::ShareInfo::ShareInfo()
+        : m_Name(),
+          m_Path()
+    {
+    }
+
+    //
+    // Constructor with share info.
+    //
+    // @param p_Name Name of share.
+    // @param p_Path Local path of share.
+    //
+    NetworkEnvironment::ShareInfo::ShareInfo(const std::wstring& p_Name,
+                                             const std::wstring& p_Path)
+        : m_Name(p_Name),
+          m_Path(p_Path)
+    {
+    }
+
+    //
+    // Default constructor.
+    //
+    NetworkEnvironment::DFSReferral::DFSReferral()
+        : m_EntryPath(),
+          m_Target(),
+          m_TimeToLive(0)
+    {
+    }
+
+    //
+    // Destructor.
+    //
+    NetworkEnvironment::~NetworkEnvironment()
+    {
+    }
+
+    //
+    // Returns the current network environment. If none has been set,
+    // the real network environment of the system is used. Called for
+    // most conversions, so the environment is read without locking.
+    //
+    // @return Current network environment.
+    //
+    NetworkEnvironmentSP NetworkEnvironment::Current()
+    {
+        NetworkEnvironmentSP spCurrent = std::atomic_load(&s_spCurrent);
+        if (spCurrent == nullptr) {
+            // If another thread beats us to it, spCurrent will be set to its environment.
+            NetworkEnvironmentSP spSystem = std::make_shared<SystemNetworkEnvironment>();
+            if (std::atomic_compare_exchange_strong(&s_spCurrent, &spCurrent, spSystem)) {
+                spCurrent = spSystem;
+            }
+        }
+        return spCurrent;
+    }
+
+    //
+    // Replaces the current network environment. Network info cached by
+    // PluginUtils, FQDNCache and DFSReferralCache is flushed, so this must not be called
+    // while paths are being converted. The PathResultCache shared with other
+    // processes is not used while a simulated environment is set.
+    //
+    // @param p_spEnvironment New network environment. If nullptr,
+    //                        the real network environment is restored.
+    //
+    void NetworkEnvironment::SetCurrent(const NetworkEnvironmentSP& p_spEnvironment)
+    {
+        std::atomic_store(&s_spCurrent, p_spEnvironment);
+        PluginUtils::FlushNetworkCaches();
+        FQDNCache::Flush();
+        DFSReferralCache::Flush();
+        DriveConnectivityCache::Flush();
+        ShortNameSupportCache::Flush();
+        PathResultCache::SetSuspended(p_spEnvironment != nullptr);
+    }
+
+} // namespace PCC
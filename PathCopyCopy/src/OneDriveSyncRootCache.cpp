@@ -0,0 +1,182 @@
+// OneDriveSyncRootCache.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <stdafx.h>
+#include <OneDriveSyncRootCache.h>
+#include <StringUtils.h>
+
+#include <vector>
+
+
+namespace
+{
+    // Registry key where OneDrive lists the folders it synchronizes, one subkey per sync root.
+    const wchar_t* const    ONEDRIVE_PROVIDERS_KEY  = L"Software\\SyncEngines\\Providers\\OneDrive";
+    const wchar_t* const    MOUNT_POINT_VALUE       = L"MountPoint";
+    const wchar_t* const    URL_NAMESPACE_VALUE     = L"UrlNamespace";
+
+    const DWORD             PROVIDERS_NOTIFY        = REG_NOTIFY_CHANGE_NAME | REG_NOTIFY_CHANGE_LAST_SET;
+
+    // Time after which we check again for the providers key if it could not be watched, in milliseconds.
+    const DWORD             RETRY_INTERVAL_MS       = 60 * 1000;
+
+    //
+    // Reads a string value from a registry key.
+    //
+    // @param p_rKey Key to read from.
+    // @param p_pValueName Name of value to read.
+    // @param p_rValue Where to store the value.
+    // @return true if the value was read successfully.
+    //
+    bool QueryString(ATL::CRegKey& p_rKey,
+                     const wchar_t* const p_pValueName,
+                     std::wstring& p_rValue)
+    {
+        ULONG chars = 0;
+        bool found = p_rKey.QueryStringValue(p_pValueName, nullptr, &chars) == ERROR_SUCCESS;
+        if (found) {
+            std::vector<wchar_t> vBuffer(chars + 1, L'\0');
+            chars = static_cast<ULONG>(vBuffer.size());
+            found = p_rKey.QueryStringValue(p_pValueName, &*vBuffer.begin(), &chars) == ERROR_SUCCESS;
+            if (found) {
+                p_rValue = &*vBuffer.begin();
+            }
+        }
+        return found;
+    }
+
+    //
+    // Reads a sync root from its subkey of the providers key and returns
+    // the corresponding PrefixMap table entry. The mount point is terminated
+    // with a backslash and the URL with a slash, so that the rest of a path
+    // can be appended to the URL after replacing the prefix.
+    //
+    // @param p_rProviderKey Subkey of the providers key describing the sync root.
+    // @return Table entry, including the line separator, or an empty string
+    //         if the subkey does not describe a valid sync root.
+    //
+    std::wstring ReadSyncRootEntry(ATL::CRegKey& p_rProviderKey)
+    {
+        std::wstring mountPoint, url;
+        if (!QueryString(p_rProviderKey, MOUNT_POINT_VALUE, mountPoint) || mountPoint.empty() ||
+            !QueryString(p_rProviderKey, URL_NAMESPACE_VALUE, url) || url.empty() ||
+            mountPoint.find_first_of(L"\t\r\n") != std::wstring::npos) {
+
+            return std::wstring();
+        }
+        if (mountPoint.back() != L'\\') {
+            mountPoint += L'\\';
+        }
+        if (url.back() != L'/') {
+            url += L'/';
+        }
+
+        // Whitespace is encoded here so that the table can't be broken by the URL.
+        StringUtils::EncodeURICharacters(url, StringUtils::EncodeParam::Whitespace);
+        return mountPoint + L'\t' + url + L'\n';
+    }
+
+} // anonymous namespace
+
+namespace PCC
+{
+    // Static members of OneDriveSyncRootCache
+    PrefixMap::PrefixMapSP  OneDriveSyncRootCache::s_spSyncRoots;
+    ATL::CRegKey            OneDriveSyncRootCache::s_ProvidersKey;
+    ATL::CHandle            OneDriveSyncRootCache::s_hChangeEvent;
+    bool                    OneDriveSyncRootCache::s_Watching = false;
+    DWORD                   OneDriveSyncRootCache::s_LoadTime = 0;
+    std::mutex              OneDriveSyncRootCache::s_Lock;
+
+    //
+    // Returns the OneDrive sync roots of the current user, mapped to their
+    // web URLs. Sync roots are loaded the first time and whenever the
+    // registry key listing them changes.
+    //
+    // @return Prefix map of sync roots; never nullptr, but can be empty.
+    //
+    PrefixMap::PrefixMapSP OneDriveSyncRootCache::GetSyncRoots()
+    {
+        std::lock_guard<std::mutex> lock(s_Lock);
+        if (NeedsReload()) {
+            Load();
+        }
+        return s_spSyncRoots;
+    }
+
+    //
+    // Checks if sync roots need to be loaded again. Must be called with
+    // the lock held.
+    //
+    // @return true if sync roots were never loaded, if the providers key
+    //         changed or if it couldn't be watched for a while.
+    //
+    bool OneDriveSyncRootCache::NeedsReload()
+    {
+        if (s_spSyncRoots == nullptr) {
+            return true;
+        }
+        if (s_Watching) {
+            // Event is auto-reset, so this also consumes the notification.
+            return ::WaitForSingleObject(s_hChangeEvent, 0) == WAIT_OBJECT_0;
+        }
+        return ::GetTickCount() - s_LoadTime >= RETRY_INTERVAL_MS;
+    }
+
+    //
+    // Loads sync roots from the registry. Change notifications are armed
+    // before reading so that changes made while we read are not missed.
+    // Must be called with the lock held.
+    //
+    // Note: notifications are tied to the calling thread; if it exits, the
+    // event will be signaled, which will simply cause sync roots to be reloaded.
+    //
+    void OneDriveSyncRootCache::Load()
+    {
+        if (s_hChangeEvent == NULL) {
+            s_hChangeEvent.Attach(::CreateEventW(nullptr, FALSE, FALSE, nullptr));
+        }
+
+        // Key is opened again each time in case it was deleted and recreated.
+        s_ProvidersKey.Close();
+        s_ProvidersKey.Open(HKEY_CURRENT_USER, ONEDRIVE_PROVIDERS_KEY, KEY_READ | KEY_NOTIFY);
+        s_Watching = s_hChangeEvent != NULL && s_ProvidersKey.m_hKey != NULL &&
+            s_ProvidersKey.NotifyChangeKeyValue(TRUE, PROVIDERS_NOTIFY, s_hChangeEvent) == ERROR_SUCCESS;
+
+        std::wstring table;
+        if (s_ProvidersKey.m_hKey != NULL) {
+            wchar_t providerName[MAX_PATH + 1];
+            DWORD nameSize = MAX_PATH + 1;
+            for (DWORD i = 0; s_ProvidersKey.EnumKey(i, providerName, &nameSize) == ERROR_SUCCESS; ++i, nameSize = MAX_PATH + 1) {
+                ATL::CRegKey providerKey;
+                if (providerKey.Open(s_ProvidersKey, providerName, KEY_READ) == ERROR_SUCCESS) {
+                    table += ReadSyncRootEntry(providerKey);
+                }
+            }
+        }
+
+        // Paths are case-insensitive on Windows.
+        s_spSyncRoots = std::make_shared<const PrefixMap>(table, true);
+        s_LoadTime = ::GetTickCount();
+    }
+
+} // namespace PCC
@@ -34,4 +34,63 @@ namespace PCC
     {
     }
 
+    //
+    // Performs the action on paths written by the given function. This
+    // allows actions to have the paths written directly where they need
+    // them instead of copying them from a string. The default implementation
+    // writes the paths in a string and calls Act.
+    //
+    // @param p_vPaths Individual paths, as returned by the plugin, before
+    //                 they are encoded, decorated and bundled together.
+    //                 Can be empty if paths are only available bundled.
+    // @param p_PathsSize Number of characters that will be written,
+    //                    excluding any terminating null character.
+    // @param p_PathsWriter Function that writes exactly p_PathsSize
+    //                      characters in the buffer it is given.
+    // @param p_hWnd Parent window handle, if needed.
+    //
+    void PathAction::ActOnWrittenPaths(const WStringV&               /*p_vPaths*/,
+                                       const std::wstring::size_type p_PathsSize,
+                                       const PathsWriter&            p_PathsWriter,
+                                       const HWND                    p_hWnd) const
+    {
+        std::wstring paths(p_PathsSize, L'\0');
+        if (p_PathsSize != 0) {
+            p_PathsWriter(&*paths.begin());
+        }
+        Act(paths, p_hWnd);
+    }
+
+    //
+    // Performs the action on paths that can be computed later, if the action
+    // is able to wait until they are actually needed. This can be used for
+    // large sets of paths, since computing paths can take time. The default
+    // implementation computes the paths immediately.
+    //
+    // @param p_PathsProducer Function that computes paths and passes them to
+    //                        the ActOnWrittenPaths method of the action it is
+    //                        given. Must remain valid even after the caller
+    //                        returns, since the action can keep it.
+    // @param p_hWnd Parent window handle, if needed.
+    //
+    void PathAction::ActLater(const PathsProducer& p_PathsProducer,
+                              const HWND           p_hWnd) const
+    {
+        p_PathsProducer(*this, p_hWnd);
+    }
+
+    //
+    // Checks whether the action can fail in a way the user needs to know
+    // about, for example by showing an error or by returning an error to
+    // the shell. Such actions must be performed by the process the user
+    // interacts with and can't be forwarded elsewhere (see ResidentService).
+    // The default implementation assumes that they can.
+    //
+    // @return true if the action can fail visibly.
+    //
+    bool PathAction::CanFailVisibly() const
+    {
+        return true;
+    }
+
 } // namespace PCC
@@ -0,0 +1,149 @@
+// PathCompare.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <stdafx.h>
+#include <PathCompare.h>
+
+#include <algorithm>
+
+#if defined(_M_IX86) || defined(_M_X64)
+#define PCC_PATH_COMPARE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+
+namespace
+{
+    const std::wstring::size_type   BLOCK_LENGTH    = 8;        // Number of characters compared at once using SSE2.
+    const wchar_t                   MAX_ASCII_CHAR  = 0x7F;     // Last ASCII character; others are folded one by one.
+
+} // anonymous namespace
+
+namespace PCC
+{
+    //
+    // Compares two paths ordinally, ignoring case.
+    //
+    // @param p_Path1 First path.
+    // @param p_Path2 Second path.
+    // @return true if p_Path1 should be ordered before p_Path2.
+    //
+    bool PathCompare::Less::operator()(const std::wstring& p_Path1,
+                                       const std::wstring& p_Path2) const
+    {
+        const std::wstring::size_type length = (std::min)(p_Path1.size(), p_Path2.size());
+        for (std::wstring::size_type i = 0; i < length; ++i) {
+            if (p_Path1[i] != p_Path2[i]) {
+                const wchar_t c1 = FoldCase(p_Path1[i]);
+                const wchar_t c2 = FoldCase(p_Path2[i]);
+                if (c1 != c2) {
+                    return c1 < c2;
+                }
+            }
+        }
+        return p_Path1.size() < p_Path2.size();
+    }
+
+    //
+    // Checks if a path starts with the given prefix, ignoring case.
+    //
+    // @param p_Path Path to check.
+    // @param p_Prefix Prefix to look for.
+    // @return true if p_Path starts with p_Prefix.
+    //
+    bool PathCompare::StartsWith(const std::wstring& p_Path,
+                                 const std::wstring& p_Prefix)
+    {
+        return p_Path.size() >= p_Prefix.size() && Equal(p_Path.c_str(), p_Prefix.c_str(), p_Prefix.size());
+    }
+
+    //
+    // Checks if two ranges of characters are equal, ignoring case.
+    //
+    // @param p_pPath1 Pointer to the first range of characters.
+    // @param p_pPath2 Pointer to the second range of characters.
+    // @param p_Length Number of characters to compare.
+    // @return true if both ranges are equal, ignoring case.
+    //
+    bool PathCompare::Equal(const wchar_t* const p_pPath1,
+                            const wchar_t* const p_pPath2,
+                            const std::wstring::size_type p_Length)
+    {
+        std::wstring::size_type i = 0;
+
+#ifdef PCC_PATH_COMPARE_SSE2
+        // Compare blocks as long as they only contain ASCII characters,
+        // which can be folded by clearing the case bit of lowercase letters.
+        const __m128i nonASCIIMask = _mm_set1_epi16(static_cast<short>(~MAX_ASCII_CHAR));
+        const __m128i beforeLowerA = _mm_set1_epi16(L'a' - 1);
+        const __m128i afterLowerZ = _mm_set1_epi16(L'z' + 1);
+        const __m128i caseBit = _mm_set1_epi16(L'a' - L'A');
+        const __m128i zero = _mm_setzero_si128();
+        for (; i + BLOCK_LENGTH <= p_Length; i += BLOCK_LENGTH) {
+            __m128i block1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p_pPath1 + i));
+            __m128i block2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p_pPath2 + i));
+            const __m128i nonASCII = _mm_and_si128(_mm_or_si128(block1, block2), nonASCIIMask);
+            if (_mm_movemask_epi8(_mm_cmpeq_epi16(nonASCII, zero)) != 0xFFFF) {
+                break;
+            }
+            const __m128i lower1 = _mm_and_si128(_mm_cmpgt_epi16(block1, beforeLowerA), _mm_cmplt_epi16(block1, afterLowerZ));
+            const __m128i lower2 = _mm_and_si128(_mm_cmpgt_epi16(block2, beforeLowerA), _mm_cmplt_epi16(block2, afterLowerZ));
+            block1 = _mm_sub_epi16(block1, _mm_and_si128(lower1, caseBit));
+            block2 = _mm_sub_epi16(block2, _mm_and_si128(lower2, caseBit));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi16(block1, block2)) != 0xFFFF) {
+                return false;
+            }
+        }
+#endif // PCC_PATH_COMPARE_SSE2
+
+        for (; i < p_Length; ++i) {
+            if (p_pPath1[i] != p_pPath2[i] && FoldCase(p_pPath1[i]) != FoldCase(p_pPath2[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //
+    // Folds the case of a character so that characters differing only
+    // by case can be compared. ASCII characters are handled directly;
+    // others use the system's uppercase mapping, which does not depend
+    // on the user's locale.
+    //
+    // @param p_Char Character to fold.
+    // @return Case-folded character.
+    //
+    wchar_t PathCompare::FoldCase(const wchar_t p_Char)
+    {
+        wchar_t folded = p_Char;
+        if (p_Char <= MAX_ASCII_CHAR) {
+            if (p_Char >= L'a' && p_Char <= L'z') {
+                folded = static_cast<wchar_t>(p_Char - L'a' + L'A');
+            }
+        } else {
+            // Passing a single character to CharUpper converts it in the pointer value.
+            folded = static_cast<wchar_t>(reinterpret_cast<UINT_PTR>(
+                ::CharUpperW(reinterpret_cast<LPWSTR>(static_cast<UINT_PTR>(p_Char)))));
+        }
+        return folded;
+    }
+
+} // namespace PCC
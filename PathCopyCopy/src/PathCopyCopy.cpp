@@ -22,7 +22,13 @@
 #include <stdafx.h>
 #include <dlldatax.h>
 #include <dllmain.h>
+#include <CacheManager.h>
+#include <CachePrewarmer.h>
+#include <DiagnosticLog.h>
+#include <IconCache.h>
 #include <PathCopyCopy_i.h>
+#include <RegistryWatcher.h>
+#include <ThreadPool.h>
 #include <resource.h>
 
 #include <string.h>
@@ -36,7 +42,16 @@ STDAPI DllCanUnloadNow(void)
     if (hr != S_OK)
         return hr;
 #endif
-    return _AtlModule.DllCanUnloadNow();
+    HRESULT hRes = _AtlModule.DllCanUnloadNow();
+    if (hRes == S_OK) {
+        // We might be unloaded; release resources that are kept for the lifetime of the process.
+        PCC::CacheManager::Stop();
+        PCC::IconCache::Release();
+        PCC::RegistryWatcher::Stop();
+        PCC::ThreadPool::Stop();
+        PCC::DiagnosticLog::Stop();
+    }
+    return hRes;
 }
 
 
@@ -47,7 +62,15 @@ STDAPI DllGetClassObject(REFCLSID rclsid, REFIID riid, LPVOID* ppv)
     if (PrxDllGetClassObject(rclsid, riid, ppv) == S_OK)
         return S_OK;
 #endif
-    return _AtlModule.DllGetClassObject(rclsid, riid, ppv);
+    PCC::DiagnosticLog::Start();
+    HRESULT hRes = _AtlModule.DllGetClassObject(rclsid, riid, ppv);
+    if (SUCCEEDED(hRes) && (::IsEqualCLSID(rclsid, CLSID_PathCopyCopyContextMenuExt) ||
+                            ::IsEqualCLSID(rclsid, CLSID_PathCopyCopyExplorerCommand))) {
+        // The shell will soon show our menu; fill our caches in the meantime.
+        PCC::CacheManager::NotifyActivity();
+        PCC::CachePrewarmer::Start();
+    }
+    return hRes;
 }
 
 
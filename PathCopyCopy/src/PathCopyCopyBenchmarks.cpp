@@ -0,0 +1,755 @@
+// PathCopyCopyBenchmarks.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <stdafx.h>
+
+#ifdef PCC_BENCHMARKS
+
+#include <PathCopyCopyBenchmarks.h>
+#include <AllocationTracker.h>
+#include <AllPluginsProvider.h>
+#include <DFSReferralCache.h>
+#include <FileMetadataCache.h>
+#include <LongPathPlugin.h>
+#include <LongUNCFolderPlugin.h>
+#include <LongUNCPathPlugin.h>
+#include <MeasuredMutex.h>
+#include <MemoryRegKey.h>
+#include <PathCopyCopyPluginsRegistry.h>
+#include <PathCopyCopySettings.h>
+#include <PathCorpus.h>
+#include <PluginPipelineDecoder.h>
+#include <PluginPipelineElements.h>
+#include <PluginUtils.h>
+#include <RecordingRegKey.h>
+#include <SettingsSnapshot.h>
+#include <ShortUNCFolderPlugin.h>
+#include <ShortUNCPathPlugin.h>
+#include <SimulatedNetworkEnvironment.h>
+#include <StCoInitialize.h>
+#include <StringUtils.h>
+#include <UNCPathResolver.h>
+
+#include <chrono>
+#include <functional>
+#include <sstream>
+
+
+namespace
+{
+    // Corpus sizes used when none are specified.
+    const ULONG             DEFAULT_CORPUS_SIZES[]  = { 10, 1000, 100000 };
+
+    //
+    // Simulated network environment used to benchmark UNC conversions.
+    // In all scenarios, D:, M: and Z: are mapped drives and C:\Users is shared.
+    //
+    struct NetworkScenario {
+        const wchar_t*  m_pName;                    // Name of scenario.
+        size_t          m_ShareCount;               // Number of additional shares on C:.
+        long long       m_UniversalNameLatencyUs;   // Latency of mapped drive lookups, in microseconds.
+        long long       m_FQDNLatencyUs;            // Latency of DNS lookups, in microseconds.
+        bool            m_DNSFails;                 // Whether DNS lookups fail.
+        bool            m_SharesChanging;           // Whether shares change before every lookup.
+    };
+    const NetworkScenario   NETWORK_SCENARIOS[]     = {
+        { L"FewShares",         10,     0,      0,      false,  false },
+        { L"ManyShares",        1000,   0,      0,      false,  false },
+        { L"SharesChanging",    1000,   0,      0,      false,  true  },
+        { L"SlowNetwork",       100,    1000,   50000,  false,  false },
+        { L"DNSFailure",        100,    0,      0,      true,   false },
+    };
+
+    // Plugins separator used in settings containing lists of plugin IDs.
+    const wchar_t           SETTINGS_PLUGINS_SEPARATOR  = L',';
+
+    //
+    // Returns the number of elements in a static array.
+    //
+    template<typename T, size_t N>
+    size_t ArraySize(T (&)[N])
+    {
+        return N;
+    }
+
+    //
+    // Returns a string encoded for use in an encoded pipeline (text format).
+    //
+    // @param p_String String to encode.
+    // @return Encoded string, prefixed by its size.
+    //
+    std::wstring EncodePipelineString(const std::wstring& p_String)
+    {
+        std::wstringstream wss;
+        wss.width(4);
+        wss.fill(L'0');
+        wss << p_String.size();
+        return wss.str() + p_String;
+    }
+
+    //
+    // BenchmarkRunner
+    //
+    // Runs benchmarks against a corpus and reports results to a callback.
+    //
+    class BenchmarkRunner final
+    {
+    public:
+        //
+        // Constructor.
+        //
+        // @param p_Filter Only benchmarks whose name contains this string are run.
+        //                 If empty, all benchmarks are run.
+        // @param p_pResultProc Callback to report results to.
+        // @param p_pContext Context to pass to p_pResultProc.
+        //
+                        BenchmarkRunner(const std::wstring& p_Filter,
+                                        PCCBENCHMARKRESULTPROC const p_pResultProc,
+                                        LPVOID const p_pContext)
+                            : m_Filter(p_Filter),
+                              m_pResultProc(p_pResultProc),
+                              m_pContext(p_pContext)
+                        {
+                        }
+
+        //
+        // Runs a benchmark, unless it is filtered out.
+        //
+        // @param p_Name Name of benchmark.
+        // @param p_vCorpus Corpus to use.
+        // @param p_Benchmark Function performing the benchmark on the entire corpus.
+        //
+        void            Run(const std::wstring& p_Name,
+                            const PCC::FilesV& p_vCorpus,
+                            const std::function<void(const PCC::FilesV&)>& p_Benchmark) const
+                        {
+                            if (m_Filter.empty() || p_Name.find(m_Filter) != std::wstring::npos) {
+                                const PCC::AllocationTracker::Counts startCounts = PCC::AllocationTracker::Current();
+                                const auto start = std::chrono::steady_clock::now();
+                                p_Benchmark(p_vCorpus);
+                                const std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+                                const PCC::AllocationTracker::Counts endCounts = PCC::AllocationTracker::Current();
+                                LONGLONG allocations = -1, allocatedBytes = -1;
+                                if (PCC::AllocationTracker::Enabled()) {
+                                    allocations = static_cast<LONGLONG>(endCounts.m_Allocations - startCounts.m_Allocations);
+                                    allocatedBytes = static_cast<LONGLONG>(endCounts.m_Bytes - startCounts.m_Bytes);
+                                }
+                                m_pResultProc(p_Name.c_str(), static_cast<ULONG>(p_vCorpus.size()), elapsed.count(),
+                                              allocations, allocatedBytes, m_pContext);
+                            }
+                        }
+
+        //
+        // Runs a benchmark that modifies one path at a time, unless it is filtered out.
+        // The time taken to copy paths before modifying them is included in the result;
+        // the "Baseline" benchmark measures it.
+        //
+        // @param p_Name Name of benchmark.
+        // @param p_vCorpus Corpus to use.
+        // @param p_Modifier Function modifying one path.
+        //
+        void            RunForEachPath(const std::wstring& p_Name,
+                                       const PCC::FilesV& p_vCorpus,
+                                       const std::function<void(std::wstring&)>& p_Modifier) const
+                        {
+                            Run(p_Name, p_vCorpus, [&](const PCC::FilesV& p_vFiles) {
+                                std::wstring path;
+                                for (const std::wstring& file : p_vFiles) {
+                                    path = file;
+                                    p_Modifier(path);
+                                }
+                            });
+                        }
+
+    private:
+        std::wstring    m_Filter;           // Filter for benchmark names.
+        PCCBENCHMARKRESULTPROC
+                        m_pResultProc;      // Callback to report results to.
+        LPVOID          m_pContext;         // Context to pass to callback.
+    };
+
+    //
+    // Mimics the way CPathCopyCopyContextMenuExt::ActOnFiles assembles the
+    // output of a plugin: paths are computed in parallel while caching file
+    // metadata, then quoted and joined in a single allocation.
+    //
+    // @param p_Plugin Plugin to use.
+    // @param p_vFiles Files to convert.
+    // @param p_Context Context of the conversion.
+    // @return Assembled output.
+    //
+    std::wstring AssemblePaths(const PCC::Plugin& p_Plugin,
+                               const PCC::FilesV& p_vFiles,
+                               const PCC::ConversionContext& p_Context)
+    {
+        const std::wstring pathsSeparator(L"\r\n");
+        PCC::WStringV vPaths;
+        {
+            PCC::FileMetadataCache metadataCache;
+            metadataCache.Prefetch(p_vFiles);
+            vPaths = PCC::PluginUtils::GetPathsInParallel(p_Plugin, p_vFiles,
+                                                          PCC::ConversionContext(p_Context, &metadataCache));
+        }
+
+        std::vector<bool> vNeedQuotes(vPaths.size(), false);
+        std::wstring::size_type size = 0;
+        for (size_t i = 0; i < vPaths.size(); ++i) {
+            vNeedQuotes[i] = vPaths[i].find(L' ') != std::wstring::npos;
+            if (size != 0) {
+                size += pathsSeparator.size();
+            }
+            size += vPaths[i].size() + (vNeedQuotes[i] ? 2 : 0);
+        }
+
+        std::wstring output;
+        output.reserve(size);
+        for (size_t i = 0; i < vPaths.size(); ++i) {
+            if (!output.empty()) {
+                output += pathsSeparator;
+            }
+            if (vNeedQuotes[i]) {
+                output += L'"';
+            }
+            output += vPaths[i];
+            if (vNeedQuotes[i]) {
+                output += L'"';
+            }
+        }
+        return output;
+    }
+
+    //
+    // Fills in-memory keys with typical user settings and plugin icons.
+    //
+    // @param p_vspPlugins Plugins to include in menus.
+    // @param p_rUserKey Key to fill with user settings.
+    // @param p_rIconsKey Key to fill with plugin icons.
+    //
+    void FillSettingsKeys(const PCC::PluginSPV& p_vspPlugins,
+                          MemoryRegKey& p_rUserKey,
+                          MemoryRegKey& p_rIconsKey)
+    {
+        PCC::GUIDV vPluginIds;
+        for (const PCC::PluginSP& spPlugin : p_vspPlugins) {
+            vPluginIds.push_back(spPlugin->Id());
+        }
+        const std::wstring pluginIds = PCC::PluginUtils::PluginIdsToString(vPluginIds, SETTINGS_PLUGINS_SEPARATOR);
+        const std::wstring mainMenuPluginIds = PCC::PluginUtils::PluginIdsToString(
+            PCC::GUIDV(vPluginIds.cbegin(), vPluginIds.cbegin() + (std::min)(vPluginIds.size(), size_t(2))),
+            SETTINGS_PLUGINS_SEPARATOR);
+
+        p_rUserKey.SetDWORDValue(L"AddQuotes", 1);
+        p_rUserKey.SetDWORDValue(L"UsePreviewMode", 1);
+        p_rUserKey.SetDWORDValue(L"DropRedundantWords", 1);
+        p_rUserKey.SetDWORDValue(L"UseIconForSubmenu", 1);
+        p_rUserKey.SetStringValue(L"EncodeParam", L"Whitespace");
+        p_rUserKey.SetStringValue(L"PathsSeparator", L"; ");
+        p_rUserKey.SetStringValue(L"KnownPlugins", pluginIds.c_str());
+        p_rUserKey.SetStringValue(L"SubmenuDisplayOrder", pluginIds.c_str());
+        p_rUserKey.SetStringValue(L"MainMenuDisplayOrder", mainMenuPluginIds.c_str());
+        p_rUserKey.SetStringValue(L"CtrlKeyPlugin", mainMenuPluginIds.c_str());
+
+        wchar_t guidBuffer[40]; // See StringFromGUID2 in MSDN
+        if (!vPluginIds.empty() && ::StringFromGUID2(vPluginIds.front(), guidBuffer, 40) != 0) {
+            p_rIconsKey.SetStringValue(guidBuffer, L"C:\\Icons\\Plugin.ico");
+        }
+    }
+
+    //
+    // Reads all settings needed to show our contextual menu, like
+    // CPathCopyCopyContextMenuExt does when the menu is opened.
+    //
+    // @param p_Settings Object to read settings from.
+    // @param p_vspPlugins Plugins shown in the menu.
+    //
+    void ReadMenuSettings(const PCC::Settings& p_Settings,
+                          const PCC::PluginSPV& p_vspPlugins)
+    {
+        GUID ctrlKeyPluginId;
+        PCC::GUIDV vPluginIds;
+        p_Settings.GetMenuTimeBudget();
+        p_Settings.GetEditingDisabled();
+        p_Settings.GetUseIconForDefaultPlugin();
+        p_Settings.GetUseIconForSubmenu();
+        p_Settings.GetUsePreviewMode();
+        p_Settings.GetUsePreviewModeInMainMenu();
+        p_Settings.GetDropRedundantWords();
+        p_Settings.GetAlwaysShowSubmenu();
+        p_Settings.GetKnownPlugins(vPluginIds);
+        p_Settings.GetCtrlKeyPlugin(ctrlKeyPluginId);
+        p_Settings.GetMainMenuPluginDisplayOrder(vPluginIds);
+        p_Settings.GetSubmenuPluginDisplayOrder(vPluginIds);
+        for (const PCC::PluginSP& spPlugin : p_vspPlugins) {
+            p_Settings.GetIconFileForPlugin(spPlugin->Id());
+        }
+        p_Settings.GetAddQuotesAroundPaths();
+        p_Settings.GetAreQuotesOptional();
+        p_Settings.GetMakePathsIntoEmailLinks();
+        p_Settings.GetEncodeParam();
+        p_Settings.GetPathsSeparator();
+    }
+
+    //
+    // Context passed to ReportAllocationPhase.
+    //
+    struct AllocationPhaseContext {
+        PCCALLOCATIONPHASEPROC  m_pPhaseProc;   // Callback to report phases to.
+        LPVOID                  m_pContext;     // Context to pass to m_pPhaseProc.
+    };
+
+    //
+    // Reports the allocation totals of a phase to the callback passed to
+    // GetAllocationPhasesW.
+    //
+    // @param p_Totals Totals of phase.
+    // @param p_pContext Pointer to an AllocationPhaseContext.
+    //
+    void ReportAllocationPhase(const PCC::AllocationTracker::PhaseTotals& p_Totals,
+                               void* p_pContext)
+    {
+        const AllocationPhaseContext* const pContext = static_cast<const AllocationPhaseContext*>(p_pContext);
+        pContext->m_pPhaseProc(p_Totals.m_pName, p_Totals.m_Calls, p_Totals.m_Counts.m_Allocations,
+                               p_Totals.m_Counts.m_Bytes, pContext->m_pContext);
+    }
+
+    //
+    // Context passed to ReportLockStatistics.
+    //
+    struct LockStatisticsContext {
+        PCCLOCKSTATISTICSPROC   m_pStatisticsProc;  // Callback to report statistics to.
+        LPVOID                  m_pContext;         // Context to pass to m_pStatisticsProc.
+    };
+
+    //
+    // Reports the statistics of a lock to the callback passed to GetLockStatisticsW.
+    //
+    // @param p_Statistics Statistics of lock.
+    // @param p_pContext Pointer to a LockStatisticsContext.
+    //
+    void ReportLockStatistics(const PCC::MeasuredMutex::Statistics& p_Statistics,
+                              void* p_pContext)
+    {
+        const LockStatisticsContext* const pContext = static_cast<const LockStatisticsContext*>(p_pContext);
+        pContext->m_pStatisticsProc(p_Statistics.m_pName, p_Statistics.m_Acquisitions, p_Statistics.m_Contentions,
+                                    p_Statistics.m_WaitMicroseconds, p_Statistics.m_MaxWaitMicroseconds,
+                                    pContext->m_pContext);
+    }
+
+    //
+    // Runs all benchmarks against a corpus.
+    //
+    // @param p_Runner Object used to run benchmarks.
+    // @param p_vCorpus Corpus to use.
+    // @param p_vspPlugins Built-in plugins to benchmark.
+    // @param p_Context Context giving access to settings and built-in plugins.
+    //
+    void RunBenchmarks(const BenchmarkRunner& p_Runner,
+                       const PCC::FilesV& p_vCorpus,
+                       const PCC::PluginSPV& p_vspPlugins,
+                       const PCC::ConversionContext& p_Context)
+    {
+        // Baseline: cost of copying each path, included in per-path benchmarks.
+        p_Runner.RunForEachPath(L"Baseline/CopyPath", p_vCorpus, [](std::wstring&) { });
+
+        // Built-in plugins.
+        for (const PCC::PluginSP& spPlugin : p_vspPlugins) {
+            const std::wstring description = spPlugin->Description(p_Context);
+            p_Runner.Run(L"Plugin/" + description + L"/GetPath", p_vCorpus, [&](const PCC::FilesV& p_vFiles) {
+                for (const std::wstring& file : p_vFiles) {
+                    spPlugin->GetPath(file, p_Context);
+                }
+            });
+            p_Runner.Run(L"ActOnFiles/" + description, p_vCorpus, [&](const PCC::FilesV& p_vFiles) {
+                AssemblePaths(*spPlugin, p_vFiles, p_Context);
+            });
+        }
+
+        // Pipeline elements. Elements that launch executables are not included,
+        // since their cost is dominated by the executables themselves.
+        PCC::CharMapPipelineElement::CharM mCharMap;
+        mCharMap[L'\\'] = L'/';
+        mCharMap[L' '] = L'_';
+        mCharMap[L'\u00e9'] = L'e';
+        PCC::MultiFindReplacePipelineElement::FindReplacePairV vFindReplaces;
+        vFindReplaces.emplace_back(L"Users", L"Home");
+        vFindReplaces.emplace_back(L"\\", L"/");
+        const std::pair<const wchar_t*, PCC::PipelineElementSP> elements[] = {
+            { L"Quotes",                std::make_shared<PCC::QuotesPipelineElement>() },
+            { L"OptionalQuotes",        std::make_shared<PCC::OptionalQuotesPipelineElement>() },
+            { L"EmailLinks",            std::make_shared<PCC::EmailLinksPipelineElement>() },
+            { L"EncodeURIWhitespace",   std::make_shared<PCC::EncodeURIWhitespacePipelineElement>() },
+            { L"EncodeURIChars",        std::make_shared<PCC::EncodeURICharsPipelineElement>() },
+            { L"BackToForwardSlashes",  std::make_shared<PCC::BackToForwardSlashesPipelineElement>() },
+            { L"ForwardToBackslashes",  std::make_shared<PCC::ForwardToBackslashesPipelineElement>() },
+            { L"RemoveFileExt",         std::make_shared<PCC::RemoveFileExtPipelineElement>() },
+            { L"FindReplace",           std::make_shared<PCC::FindReplacePipelineElement>(L"Documents", L"Docs") },
+            { L"FindReplaceIgnoreCase", std::make_shared<PCC::FindReplacePipelineElement>(L"documents", L"Docs", true) },
+            { L"CharMap",               std::make_shared<PCC::CharMapPipelineElement>(mCharMap) },
+            { L"MultiFindReplace",      std::make_shared<PCC::MultiFindReplacePipelineElement>(vFindReplaces) },
+            { L"Regex",                 std::make_shared<PCC::RegexPipelineElement>(L"^([A-Z]):\\\\(.*)$", L"/mnt/$1/$2", true) },
+            { L"RegexFast",             std::make_shared<PCC::RegexPipelineElement>(L"^([A-Z]):\\\\(.*)$", L"/mnt/$1/$2", true,
+                                                                                    PCC::RegexPipelineElement::Engine::Fast) },
+            { L"PrefixMapping",         std::make_shared<PCC::PrefixMappingPipelineElement>(PCC::PrefixMap::Source::Inline,
+                                                                                            L"C:\\Users\\\tH:\\\nD:\\\t\\\\nas\\d\\", true) },
+            { L"EnvironmentVariables",  std::make_shared<PCC::EnvironmentVariablesPipelineElement>() },
+            { L"ApplyPlugin",           std::make_shared<PCC::ApplyPluginPipelineElement>(PCC::Plugins::LongPathPlugin::ID) },
+            { L"Template",              std::make_shared<PCC::TemplatePipelineElement>(L"[{path}]({plugin:331A3B60-AF49-44F4-B30D-56ADFF6D25E8})") },
+            { L"PathsSeparator",        std::make_shared<PCC::PathsSeparatorPipelineElement>(L"; ") },
+            { L"CopyMultipleFormats",   std::make_shared<PCC::CopyMultipleFormatsPipelineElement>() },
+        };
+        for (const auto& element : elements) {
+            const PCC::PipelineElementSP& spElement = element.second;
+            p_Runner.RunForEachPath(std::wstring(L"PipelineElement/") + element.first + L"/ModifyPath", p_vCorpus,
+                [&](std::wstring& p_rPath) {
+                    spElement->ModifyPath(p_rPath, p_Context);
+                });
+        }
+
+        // Pipeline decoding. Each path decodes a pipeline, like creating one pipeline plugin per path would.
+        const std::pair<const wchar_t*, std::wstring> encodedPipelines[] = {
+            { L"Simple",    L"02\"\\" },
+            { L"Typical",   L"04\"?" + EncodePipelineString(L"C:\\Users") + EncodePipelineString(L"H:") + L"\\^0002" +
+                            EncodePipelineString(L"^H:(.*)$") + EncodePipelineString(L"~$1") + L"10001" },
+            { L"Long",      L"+" + EncodePipelineString(L"120") + [] {
+                                std::wstring elements;
+                                for (int i = 0; i < 40; ++i) {
+                                    elements += L"?" + EncodePipelineString(L"old" + std::to_wstring(i)) +
+                                                EncodePipelineString(L"new" + std::to_wstring(i));
+                                    elements += L"\\/";
+                                }
+                                return elements;
+                            }() },
+        };
+        for (const auto& encodedPipeline : encodedPipelines) {
+            const std::wstring& encodedElements = encodedPipeline.second;
+            p_Runner.Run(std::wstring(L"PipelineDecoder/DecodePipeline/") + encodedPipeline.first, p_vCorpus,
+                [&](const PCC::FilesV& p_vFiles) {
+                    for (size_t i = 0; i < p_vFiles.size(); ++i) {
+                        PCC::PipelineElementSPV vspElements;
+                        PCC::PipelineDecoder::DecodePipeline(encodedElements, vspElements);
+                    }
+                });
+        }
+
+        // UNC conversions, with simulated network environments.
+        const GUID uncPluginIds[] = {
+            PCC::Plugins::LongUNCPathPlugin::ID,
+            PCC::Plugins::ShortUNCPathPlugin::ID,
+            PCC::Plugins::LongUNCFolderPlugin::ID,
+            PCC::Plugins::ShortUNCFolderPlugin::ID,
+        };
+        for (const NetworkScenario& scenario : NETWORK_SCENARIOS) {
+            auto spEnvironment = std::make_shared<PCC::SimulatedNetworkEnvironment>();
+            spEnvironment->AddMappedDrive(L'D', L"\\\\fileserver\\data");
+            spEnvironment->AddMappedDrive(L'M', L"\\\\fileserver\\media");
+            spEnvironment->AddMappedDrive(L'Z', L"\\\\fileserver\\home");
+            spEnvironment->AddShare(L"Users", L"C:\\Users");
+            spEnvironment->AddGeneratedShares(scenario.m_ShareCount, L"C:\\Shares\\");
+            spEnvironment->SetLatency(PCC::SimulatedNetworkEnvironment::Operation::UniversalName,
+                                      std::chrono::microseconds(scenario.m_UniversalNameLatencyUs));
+            spEnvironment->SetLatency(PCC::SimulatedNetworkEnvironment::Operation::FQDN,
+                                      std::chrono::microseconds(scenario.m_FQDNLatencyUs));
+            if (scenario.m_DNSFails) {
+                spEnvironment->SetDNSBehavior(PCC::SimulatedNetworkEnvironment::DNSBehavior::Fail, L"");
+            }
+            spEnvironment->SetSharesChanged(scenario.m_SharesChanging);
+            PCC::NetworkEnvironment::SetCurrent(spEnvironment);
+
+            for (const GUID& pluginId : uncPluginIds) {
+                const PCC::PluginSP spPlugin = p_Context.GetPluginProvider()->GetPlugin(pluginId);
+                if (spPlugin != nullptr) {
+                    p_Runner.Run(std::wstring(L"Network/") + scenario.m_pName + L"/" + spPlugin->Description(p_Context), p_vCorpus,
+                        [&](const PCC::FilesV& p_vFiles) {
+                            AssemblePaths(*spPlugin, p_vFiles, p_Context);
+                        });
+                }
+            }
+        }
+
+        // DFS resolution, with D: mapped to a DFS link. Each corpus run is a single batch,
+        // like a selection; referrals are flushed beforehand so that the DFS client is queried.
+        {
+            auto spEnvironment = std::make_shared<PCC::SimulatedNetworkEnvironment>();
+            spEnvironment->AddMappedDrive(L'D', L"\\\\corp\\dfs\\data");
+            spEnvironment->AddDFSLink(L"\\\\corp\\dfs", L"\\\\dc1\\dfs");
+            spEnvironment->AddDFSLink(L"\\\\corp\\dfs\\data", L"\\\\fileserver\\data");
+            spEnvironment->SetLatency(PCC::SimulatedNetworkEnvironment::Operation::DFSReferral,
+                                      std::chrono::microseconds(1000));
+            PCC::NetworkEnvironment::SetCurrent(spEnvironment);
+            p_Runner.Run(L"Network/DFS/UNCPathResolver", p_vCorpus,
+                [](const PCC::FilesV& p_vFiles) {
+                    PCC::DFSReferralCache::Flush();
+                    PCC::UNCPathResolver resolver(nullptr);
+                    for (const std::wstring& file : p_vFiles) {
+                        std::wstring path(file);
+                        if (PCC::PluginUtils::IsUNCPath(path)) {
+                            resolver.ResolveDFSPath(path);
+                        } else {
+                            resolver.ConvertToUNCPath(path, false, false, true);
+                        }
+                    }
+                });
+        }
+        PCC::NetworkEnvironment::SetCurrent(nullptr);
+
+        // Settings read to show the contextual menu, from in-memory keys (one menu per path).
+        // Calls are recorded once beforehand to report the number of registry round trips;
+        // an actual registry key would need one round trip per query.
+        {
+            MemoryRegKey userKey;
+            MemoryRegKey iconsKey;
+            FillSettingsKeys(p_vspPlugins, userKey, iconsKey);
+            RecordingRegKey recordingUserKey(userKey);
+            RecordingRegKey recordingIconsKey(iconsKey);
+            PCC::Settings settings;
+            settings.UseKeysForReading(recordingUserKey, recordingIconsKey);
+            ReadMenuSettings(settings, p_vspPlugins);
+            const unsigned long queryCount = recordingUserKey.GetQueryCount() + recordingIconsKey.GetQueryCount();
+
+            settings.UseKeysForReading(userKey, iconsKey);
+            p_Runner.Run(L"Settings/ReadMenuSettings (" + std::to_wstring(queryCount) + L" queries)", p_vCorpus,
+                [&](const PCC::FilesV& p_vFiles) {
+                    for (size_t i = 0; i < p_vFiles.size(); ++i) {
+                        ReadMenuSettings(settings, p_vspPlugins);
+                    }
+                });
+        }
+
+        // Hidden drive share conversion, used by UNC plugins for local paths when hidden shares are enabled.
+        p_Runner.RunForEachPath(L"PluginUtils/GetHiddenDriveShareFilePath", p_vCorpus, [](std::wstring& p_rPath) {
+            PCC::PluginUtils::GetHiddenDriveShareFilePath(p_rPath);
+        });
+
+        // String utilities.
+        p_Runner.RunForEachPath(L"StringUtils/EncodeURICharacters/Whitespace", p_vCorpus, [](std::wstring& p_rPath) {
+            StringUtils::EncodeURICharacters(p_rPath, StringUtils::EncodeParam::Whitespace);
+        });
+        p_Runner.RunForEachPath(L"StringUtils/EncodeURICharacters/All", p_vCorpus, [](std::wstring& p_rPath) {
+            StringUtils::EncodeURICharacters(p_rPath, StringUtils::EncodeParam::All);
+        });
+        p_Runner.RunForEachPath(L"StringUtils/ReplaceAll", p_vCorpus, [](std::wstring& p_rPath) {
+            StringUtils::ReplaceAll(p_rPath, L"\\", L"\\\\");
+        });
+    }
+
+} // anonymous namespace
+
+//
+// RunBenchmarksW
+//
+// Function that can be called directly by a process that loaded the DLL
+// (like the PathCopyCopyBenchmarks tool) to measure the performance of
+// built-in plugins, pipeline elements, pipeline decoding and string
+// utilities against synthetic corpora of paths. Equivalent to calling
+// RunCorpusBenchmarksW with the mixed corpus.
+//
+// @param p_pFilter If non-empty, only benchmarks whose name contains
+//                  this string are run. Can be nullptr.
+// @param p_pCorpusSizes Sizes of corpora to use. If nullptr, default
+//                       sizes of 10, 1000 and 100000 paths are used.
+// @param p_NumCorpusSizes Number of elements in p_pCorpusSizes.
+// @param p_pResultProc Callback invoked for each benchmark result.
+// @param p_pContext Context passed to p_pResultProc.
+// @return S_OK if benchmarks were run, otherwise an error code.
+//
+HRESULT WINAPI RunBenchmarksW(LPCWSTR p_pFilter,
+                              const ULONG* p_pCorpusSizes,
+                              ULONG p_NumCorpusSizes,
+                              PCCBENCHMARKRESULTPROC p_pResultProc,
+                              LPVOID p_pContext)
+{
+    return RunCorpusBenchmarksW(nullptr, p_pFilter, p_pCorpusSizes, p_NumCorpusSizes, p_pResultProc, p_pContext);
+}
+
+//
+// RunCorpusBenchmarksW
+//
+// Function that can be called directly by a process that loaded the DLL
+// (like the PathCopyCopyBenchmarks tool) to measure the performance of
+// built-in plugins, pipeline elements, pipeline decoding and string
+// utilities against synthetic corpora of paths (see PathCorpus). The paths
+// do not need to exist. Built-in plugins use the current user's settings.
+// UNC conversions are also measured in simulated network environments,
+// and settings reads are measured against an in-memory registry.
+//
+// @param p_pCorpusName Name of kind of corpus to use (see PathCorpus::Kind).
+//                      If nullptr or empty, the mixed corpus is used.
+// @param p_pFilter If non-empty, only benchmarks whose name contains
+//                  this string are run. Can be nullptr.
+// @param p_pCorpusSizes Sizes of corpora to use. If nullptr, default
+//                       sizes of 10, 1000 and 100000 paths are used.
+// @param p_NumCorpusSizes Number of elements in p_pCorpusSizes.
+// @param p_pResultProc Callback invoked for each benchmark result.
+// @param p_pContext Context passed to p_pResultProc.
+// @return S_OK if benchmarks were run, otherwise an error code.
+//
+HRESULT WINAPI RunCorpusBenchmarksW(LPCWSTR p_pCorpusName,
+                                    LPCWSTR p_pFilter,
+                                    const ULONG* p_pCorpusSizes,
+                                    ULONG p_NumCorpusSizes,
+                                    PCCBENCHMARKRESULTPROC p_pResultProc,
+                                    LPVOID p_pContext)
+{
+    PCC::PathCorpus::Kind corpusKind = PCC::PathCorpus::Kind::Mixed;
+    if (p_pResultProc == nullptr || (p_pCorpusSizes == nullptr && p_NumCorpusSizes != 0) ||
+        (p_pCorpusName != nullptr && p_pCorpusName[0] != L'\0' && !PCC::PathCorpus::KindFromName(p_pCorpusName, corpusKind))) {
+
+        return E_INVALIDARG;
+    }
+    if (p_pCorpusSizes == nullptr) {
+        p_pCorpusSizes = DEFAULT_CORPUS_SIZES;
+        p_NumCorpusSizes = static_cast<ULONG>(ArraySize(DEFAULT_CORPUS_SIZES));
+    }
+
+    // Initialize COM like our other entry points, in case plugins need it.
+    StCoInitialize coInit;
+
+    HRESULT hRes = S_OK;
+    try {
+        // Load built-in plugins only, so that results do not depend on installed COM plugins.
+        PCC::Settings settings;
+        const PCC::PluginSPV vspAllPlugins = PCC::PluginsRegistry::GetPluginsInDefaultOrder(nullptr, nullptr, false);
+        const PCC::PluginSPS sspAllPlugins(vspAllPlugins.cbegin(), vspAllPlugins.cend());
+        PCC::AllPluginsProvider pluginProvider(sspAllPlugins);
+        const PCC::SettingsSnapshot settingsSnapshot(settings);
+        const PCC::ConversionContext context(&settings, &settingsSnapshot, &pluginProvider);
+        PCC::PluginSPV vspPlugins;
+        for (const PCC::PluginSP& spPlugin : vspAllPlugins) {
+            if (!spPlugin->IsSeparator()) {
+                vspPlugins.push_back(spPlugin);
+            }
+        }
+
+        const BenchmarkRunner runner(p_pFilter != nullptr ? p_pFilter : L"", p_pResultProc, p_pContext);
+        for (ULONG i = 0; i < p_NumCorpusSizes; ++i) {
+            RunBenchmarks(runner, PCC::PathCorpus::Generate(corpusKind, p_pCorpusSizes[i]), vspPlugins, context);
+        }
+    } catch (...) {
+        hRes = E_FAIL;
+    }
+
+    // Make sure the real network environment is restored, even if a benchmark failed.
+    PCC::NetworkEnvironment::SetCurrent(nullptr);
+
+    return hRes;
+}
+
+//
+// GenerateCorpusW
+//
+// Function that can be called directly by a process that loaded the DLL
+// (like the PathCopyCopyBenchmarks tool) to get the synthetic paths used
+// by RunCorpusBenchmarksW, so that other tools and tests can use the same
+// reproducible corpora (see PathCorpus).
+//
+// @param p_pCorpusName Name of kind of corpus to generate (see PathCorpus::Kind).
+//                      If nullptr or empty, the mixed corpus is generated.
+// @param p_Size Number of paths to generate.
+// @param p_pPathProc Callback invoked for each generated path, in order.
+// @param p_pContext Context passed to p_pPathProc.
+// @return S_OK if corpus was generated, E_INVALIDARG if corpus name is
+//         unknown, otherwise an error code.
+//
+HRESULT WINAPI GenerateCorpusW(LPCWSTR p_pCorpusName,
+                               ULONG p_Size,
+                               PCCCORPUSPATHPROC p_pPathProc,
+                               LPVOID p_pContext)
+{
+    PCC::PathCorpus::Kind corpusKind = PCC::PathCorpus::Kind::Mixed;
+    if (p_pPathProc == nullptr ||
+        (p_pCorpusName != nullptr && p_pCorpusName[0] != L'\0' && !PCC::PathCorpus::KindFromName(p_pCorpusName, corpusKind))) {
+
+        return E_INVALIDARG;
+    }
+
+    HRESULT hRes = S_OK;
+    try {
+        for (const std::wstring& path : PCC::PathCorpus::Generate(corpusKind, p_Size)) {
+            p_pPathProc(path.c_str(), p_pContext);
+        }
+    } catch (...) {
+        hRes = E_FAIL;
+    }
+    return hRes;
+}
+
+//
+// GetAllocationPhasesW
+//
+// Function that can be called directly by a process that loaded the DLL
+// (like the PathCopyCopyBenchmarks tool) to get the heap allocations
+// performed by each phase of our operations (see AllocationTracker), like
+// the phases of building our contextual menu or copying paths. Only
+// available in instrumented builds.
+//
+// @param p_pPhaseProc Callback invoked for each phase.
+// @param p_pContext Context passed to p_pPhaseProc.
+// @param p_Reset Whether to clear totals after reporting them, so that
+//                the next call only reports subsequent allocations.
+// @return S_OK if phases were reported, E_NOTIMPL if allocations are
+//         not counted in this build, otherwise an error code.
+//
+HRESULT WINAPI GetAllocationPhasesW(PCCALLOCATIONPHASEPROC p_pPhaseProc,
+                                    LPVOID p_pContext,
+                                    BOOL p_Reset)
+{
+    if (p_pPhaseProc == nullptr) {
+        return E_INVALIDARG;
+    }
+    if (!PCC::AllocationTracker::Enabled()) {
+        return E_NOTIMPL;
+    }
+
+    AllocationPhaseContext context = { p_pPhaseProc, p_pContext };
+    PCC::AllocationTracker::EnumPhases(&ReportAllocationPhase, &context, p_Reset != FALSE);
+    return S_OK;
+}
+
+//
+// GetLockStatisticsW
+//
+// Function that can be called directly by a process that loaded the DLL
+// (like the PathCopyCopyBenchmarks tool) to get how often threads had to
+// wait for the locks protecting caches shared by all our objects, and for
+// how long (see MeasuredMutex). Used to check that building menus on
+// several threads at once scales.
+//
+// @param p_pStatisticsProc Callback invoked for each lock.
+// @param p_pContext Context passed to p_pStatisticsProc.
+// @param p_Reset Whether to clear statistics after reporting them, so that
+//                the next call only reports subsequent acquisitions.
+// @return S_OK if statistics were reported, otherwise an error code.
+//
+HRESULT WINAPI GetLockStatisticsW(PCCLOCKSTATISTICSPROC p_pStatisticsProc,
+                                  LPVOID p_pContext,
+                                  BOOL p_Reset)
+{
+    if (p_pStatisticsProc == nullptr) {
+        return E_INVALIDARG;
+    }
+
+    LockStatisticsContext context = { p_pStatisticsProc, p_pContext };
+    PCC::MeasuredMutex::EnumStatistics(&ReportLockStatistics, &context, p_Reset != FALSE);
+    return S_OK;
+}
+
+#endif // PCC_BENCHMARKS
@@ -37,6 +37,7 @@ CPathCopyCopyConfigHelper::CPathCopyCopyConfigHelper()
     : m_spSettings(),
       m_sspAllPlugins(),
       m_spPluginProvider(),
+      m_Context(),
       m_vspPlugins()
 {
 }
@@ -84,7 +85,7 @@ STDMETHODIMP CPathCopyCopyConfigHelper::GetPluginInfo(ULONG p_Index, BSTR *p_ppI
         OLECHAR pluginId[40];
         if (::StringFromGUID2(spPlugin->Id(), pluginId, 40) != 0) {
             *p_ppId = ::SysAllocString(pluginId);
-            *p_ppDescription = ::SysAllocString(spPlugin->Description().c_str());
+            *p_ppDescription = ::SysAllocString(spPlugin->Description(m_Context).c_str());
             if (p_pIsSeparator != nullptr) {
                 *p_pIsSeparator = spPlugin->IsSeparator() ? VARIANT_TRUE : VARIANT_FALSE;
             }
@@ -112,6 +113,8 @@ void CPathCopyCopyConfigHelper::Initialize()
         m_vspPluginsInDefaultOrder = PCC::PluginsRegistry::GetPluginsInDefaultOrder(m_spSettings.get(), m_spSettings.get(), true);
         m_sspAllPlugins.insert(m_vspPluginsInDefaultOrder.cbegin(), m_vspPluginsInDefaultOrder.cend());
         m_spPluginProvider = std::make_shared<PCC::AllPluginsProvider>(m_sspAllPlugins);
+        // Plugins are only used here to get their descriptions, so no settings snapshot is needed.
+        m_Context = PCC::ConversionContext(m_spSettings.get(), nullptr, m_spPluginProvider.get());
         PCC::GUIDV vKnownPlugins, vSubmenuPluginDisplayOrder;
         const PCC::GUIDV* const pvKnownPlugins = m_spSettings->GetKnownPlugins(vKnownPlugins) ? &vKnownPlugins : nullptr;
         if (m_spSettings->GetSubmenuPluginDisplayOrder(vSubmenuPluginDisplayOrder)) {
@@ -121,11 +124,5 @@ void CPathCopyCopyConfigHelper::Initialize()
             // Submenu plugin display order unspecified, use default.
             m_vspPlugins = m_vspPluginsInDefaultOrder;
         }
-
-        // Provide each plugin with settings object and plugin provider, since some require this to work.
-        for (const PCC::PluginSP& spPlugin : m_vspPlugins) {
-            spPlugin->SetSettings(m_spSettings.get());
-            spPlugin->SetPluginProvider(m_spPluginProvider.get());
-        }
     }
 }
@@ -20,54 +20,377 @@
 // THE SOFTWARE.
 
 #include <stdafx.h>
-#include <AllPluginsProvider.h>
 #include <PathCopyCopyContextMenuExt.h>
 #include <DefaultPlugin.h>
 #include <dllmain.h>
-#include <PathCopyCopyPluginsRegistry.h>
+#include <FileMetadataCache.h>
+#include <FlightRecorder.h>
+#include <IconCache.h>
+#include <MenuTemplateCache.h>
+#include <MetadataExporter.h>
 #include <PathCopyCopySettings.h>
 #include <PathCopyCopySettingsApp.h>
+#include <PerformanceCounters.h>
+#include <PluginsSnapshot.h>
+#include <PluginStatistics.h>
 #include <PluginUtils.h>
 #include <PathAction.h>
-#include <StGdiplusStartup.h>
-#include <StGlobalBlock.h>
+#include <ResidentService.h>
+#include <StCoInitialize.h>
 #include <StGlobalLock.h>
 #include <StStgMedium.h>
+#include <ThreadPool.h>
+#include <Trace.h>
 
 #include <algorithm>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
 #include <functional>
-#include <set>
-
-#include <gdiplus.h>
+#include <iterator>
+#include <thread>
 
 namespace {
 
 const wchar_t   DEFAULT_PATHS_SEPARATOR[]   = L"\r\n";  // Default separator used between paths when copying multiple file names.
+const wchar_t   PREVIEW_ELLIPSIS[]          = L"...";   // Replaces the middle of paths too long to be displayed in preview mode.
+
+const DWORD     ENABLED_STATES_DEADLINE_MS  = 250;      // Maximum time to wait for plugins to determine if they are enabled when building menu.
+const size_t    MAX_ENABLED_STATES_TASKS    = 8;        // Maximum number of thread pool tasks used to determine if plugins are enabled.
+
+const size_t    ACT_LATER_MIN_FILES         = 1000;     // Minimum number of files for which actions can compute paths only when needed.
+const size_t    BACKGROUND_MIN_FILES        = 10000;    // Minimum number of files for which paths are computed on a worker thread, showing progress.
+const size_t    BACKGROUND_BATCH_SIZE       = 1024;     // Number of files converted on a worker thread between progress updates.
+
+const size_t    SPECULATIVE_BATCH_SIZE      = 1024;     // Number of files converted between checks for cancellation of a speculative conversion.
+
+const DWORD     MAX_ITEM_PATH_SIZE          = 32768;    // Maximum size of the path of a shell item, including terminating null.
+
+// Signatures of DPI functions available on Windows 10 version 1607 and later.
+typedef UINT (WINAPI* GetDpiForWindowFunc)(HWND);
+typedef int (WINAPI* GetSystemMetricsForDpiFunc)(int, UINT);
+
+// Signature of SHGetPathFromIDListEx, available on Windows Vista and later.
+typedef BOOL (WINAPI* SHGetPathFromIDListExFunc)(PCIDLIST_ABSOLUTE, PWSTR, DWORD, int);
+
+//
+// State of an evaluation of plugins' enabled states, shared with
+// worker threads. Worker threads can outlive the evaluation if
+// some plugins take too long, so everything they need is kept here.
+//
+struct EnabledStatesEvaluation
+{
+    PCC::PluginsSnapshotSP  m_spPluginsSnapshot;    // Snapshot owning settings used by plugins.
+    PCC::PluginSPV          m_vspPlugins;           // Plugins to evaluate on worker threads.
+    std::wstring            m_ParentPath;           // Parent path to pass to plugins.
+    std::wstring            m_File;                 // File to pass to plugins.
+    std::vector<cl::optional<bool>>
+                            m_vEnabled;             // Enabled states of plugins, once evaluated.
+    size_t                  m_NextPlugin;           // Index of next plugin to evaluate.
+    size_t                  m_Remaining;            // Number of plugins not evaluated yet.
+    std::mutex              m_Lock;                 // Lock protecting members.
+    std::condition_variable m_Completed;            // Signaled when all plugins have been evaluated.
+};
+
+//
+// Returns the file system path of a shell item. Where SHGetPathFromIDListEx
+// is available, the buffer is grown as needed so that paths longer than
+// MAX_PATH can be returned; otherwise, paths are limited to MAX_PATH.
+//
+// @param p_pItem ID list of the shell item.
+// @param p_rvBuffer Buffer in which to store the path. It is kept
+//                   between calls, so it is only grown when needed.
+// @return true if the item has a file system path.
+//
+bool GetPathFromIDList(PCIDLIST_ABSOLUTE const p_pItem,
+                       std::vector<wchar_t>& p_rvBuffer)
+{
+    static const SHGetPathFromIDListExFunc s_pSHGetPathFromIDListEx = []() {
+        HMODULE hShell32 = ::GetModuleHandleW(L"shell32.dll");
+        return hShell32 != NULL ? reinterpret_cast<SHGetPathFromIDListExFunc>(
+                                      ::GetProcAddress(hShell32, "SHGetPathFromIDListEx"))
+                                : nullptr;
+    }();
+
+    if (p_rvBuffer.size() < MAX_PATH + 1) {
+        p_rvBuffer.resize(MAX_PATH + 1);
+    }
+    if (s_pSHGetPathFromIDListEx == nullptr) {
+        return ::SHGetPathFromIDListW(p_pItem, p_rvBuffer.data()) != FALSE;
+    }
+    for (;;) {
+        // GPFIDL_DEFAULT: we want the file system path.
+        if (s_pSHGetPathFromIDListEx(p_pItem, p_rvBuffer.data(), static_cast<DWORD>(p_rvBuffer.size()), 0)) {
+            return true;
+        }
+        // The function does not say whether the buffer was too small, so grow it until
+        // it can hold the longest possible path; past that, the item has no path.
+        if (p_rvBuffer.size() >= MAX_ITEM_PATH_SIZE) {
+            return false;
+        }
+        p_rvBuffer.resize((std::min)(p_rvBuffer.size() * 2, static_cast<size_t>(MAX_ITEM_PATH_SIZE)));
+    }
+}
+
+//
+// Extracts selected files from the shell ID list (CIDA) of a data object.
+// This is cheaper than asking for an HDROP, since the shell does not need
+// to compute the paths of all files beforehand; we only resolve the paths
+// of the files we need.
+//
+// @param p_pDataObject Data object containing selected files.
+// @param p_MaxFiles Maximum number of files to extract.
+// @param p_rFiles Where to store extracted files.
+// @param p_rFileCount Where to store the total number of selected files.
+// @return true if files were extracted, false if the data object has no
+//         shell ID list or if some items have no file system path.
+//
+bool GetFilesFromShellIdList(IDataObject* const p_pDataObject,
+                             const UINT p_MaxFiles,
+                             PCC::FileSelection& p_rFiles,
+                             UINT& p_rFileCount)
+{
+    bool extracted = false;
+
+    StStgMedium stgMedium;
+    FORMATETC formatEtc = {static_cast<CLIPFORMAT>(::RegisterClipboardFormatW(CFSTR_SHELLIDLIST)),
+                           nullptr, DVASPECT_CONTENT, -1, TYMED_HGLOBAL};
+    if (formatEtc.cfFormat != 0 && SUCCEEDED(p_pDataObject->GetData(&formatEtc, &stgMedium))) {
+        const CIDA* pCida = static_cast<const CIDA*>(::GlobalLock(stgMedium.Get().hGlobal));
+        if (pCida != nullptr) {
+            if (pCida->cidl > 0) {
+                // First offset is the parent folder, followed by one offset per item.
+                const BYTE* pBase = reinterpret_cast<const BYTE*>(pCida);
+                PCIDLIST_ABSOLUTE pFolder = reinterpret_cast<PCIDLIST_ABSOLUTE>(pBase + pCida->aoffset[0]);
+                const UINT fileCount = (std::min)(static_cast<UINT>(pCida->cidl), p_MaxFiles);
+                PCC::FileSelection files;
+                files.Reserve(fileCount);
+                std::vector<wchar_t> vBuffer;
+                for (UINT i = 0; i < fileCount; ++i) {
+                    PCUIDLIST_RELATIVE pItem = reinterpret_cast<PCUIDLIST_RELATIVE>(pBase + pCida->aoffset[i + 1]);
+                    PIDLIST_ABSOLUTE pFullItem = ::ILCombine(pFolder, pItem);
+                    const bool hasPath = pFullItem != nullptr && GetPathFromIDList(pFullItem, vBuffer);
+                    ::ILFree(pFullItem);
+                    if (!hasPath) {
+                        break;
+                    }
+                    files.Add(vBuffer.data(), std::wcslen(vBuffer.data()));
+                }
+                if (files.Size() == fileCount) {
+                    files.Compact();
+                    p_rFiles.Swap(files);
+                    p_rFileCount = pCida->cidl;
+                    extracted = true;
+                }
+            }
+            ::GlobalUnlock(stgMedium.Get().hGlobal);
+        }
+    }
+
+    return extracted;
+}
+
+//
+// Extracts selected files directly from the DROPFILES structure of an HDROP.
+// Wide-character file names are stored one after the other in the block,
+// so they can be added to the selection without copying them first.
+//
+// @param p_hDrop Handle to the HDROP's memory block.
+// @param p_MaxFiles Maximum number of files to extract.
+// @param p_rFiles Where to store extracted files.
+// @param p_rFileCount Where to store the total number of selected files.
+// @return true if files were extracted, false if the block could not be
+//         parsed (for example if it contains ANSI file names).
+//
+bool ParseDropFiles(HGLOBAL const p_hDrop,
+                    const UINT p_MaxFiles,
+                    PCC::FileSelection& p_rFiles,
+                    UINT& p_rFileCount)
+{
+    bool parsed = false;
+
+    StGlobalLock lock(p_hDrop);
+    const DROPFILES* pDropFiles = static_cast<const DROPFILES*>(lock.GetPtr());
+    const SIZE_T blockSize = ::GlobalSize(p_hDrop);
+    if (pDropFiles != nullptr && blockSize >= sizeof(DROPFILES) &&
+        pDropFiles->fWide != FALSE && pDropFiles->pFiles <= blockSize) {
+
+        // File names are NUL-terminated and the list ends with an empty name.
+        // Never read past the end of the block, in case it is malformed.
+        const wchar_t* pName = reinterpret_cast<const wchar_t*>(
+            reinterpret_cast<const BYTE*>(pDropFiles) + pDropFiles->pFiles);
+        const wchar_t* const pEnd = reinterpret_cast<const wchar_t*>(
+            reinterpret_cast<const BYTE*>(pDropFiles) + blockSize);
+        PCC::FileSelection files;
+        UINT totalFileCount = 0;
+        bool terminated = false;
+        while (pName < pEnd) {
+            const size_t length = ::wcsnlen(pName, static_cast<size_t>(pEnd - pName));
+            if (length == 0 || pName + length == pEnd) {
+                terminated = length == 0;
+                break;
+            }
+            if (totalFileCount < p_MaxFiles) {
+                files.Add(pName, length);
+            }
+            ++totalFileCount;
+            pName += length + 1;
+        }
+        if (terminated) {
+            if (totalFileCount > 0) {
+                files.Compact();
+                p_rFiles.Swap(files);
+                p_rFileCount = totalFileCount;
+            }
+            parsed = true;
+        }
+    }
+
+    return parsed;
+}
+
+//
+// Extracts selected files from the HDROP of a data object.
+//
+// @param p_pDataObject Data object containing selected files.
+// @param p_MaxFiles Maximum number of files to extract.
+// @param p_rFiles Where to store extracted files.
+// @param p_rFileCount Where to store the total number of selected files.
+// @return true if files were extracted, false if the data object has no
+//         HDROP or if it contains no files.
+//
+bool GetFilesFromHDrop(IDataObject* const p_pDataObject,
+                       const UINT p_MaxFiles,
+                       PCC::FileSelection& p_rFiles,
+                       UINT& p_rFileCount)
+{
+    bool extracted = false;
+
+    StStgMedium stgMedium;
+    FORMATETC formatEtc = {CF_HDROP, nullptr, DVASPECT_CONTENT, -1, TYMED_HGLOBAL};
+    if (SUCCEEDED(p_pDataObject->GetData(&formatEtc, &stgMedium))) {
+        UINT totalFileCount = 0;
+        if (ParseDropFiles(stgMedium.Get().hGlobal, p_MaxFiles, p_rFiles, totalFileCount)) {
+            if (totalFileCount > 0) {
+                p_rFileCount = totalFileCount;
+                extracted = true;
+            }
+        } else {
+            // Fall back to letting the shell convert the file names, for example if they are ANSI.
+            HDROP hDrop = static_cast<HDROP>(stgMedium.Get().hGlobal);
+            totalFileCount = ::DragQueryFileW(hDrop, 0xFFFFFFFF, 0, 0);
+            if (totalFileCount > 0) {
+                const UINT fileCount = (std::min)(totalFileCount, p_MaxFiles);
+                PCC::FileSelection files;
+                files.Reserve(fileCount);
+                std::wstring buffer;
+                for (UINT i = 0; i < fileCount; ++i) {
+                    // Reuse a single buffer instead of allocating a string per file.
+                    const UINT size = ::DragQueryFileW(hDrop, i, nullptr, 0);
+                    if (size >= buffer.size()) {
+                        buffer.resize(size + 1);
+                    }
+                    const UINT copied = ::DragQueryFileW(hDrop, i, &*buffer.begin(), static_cast<UINT>(buffer.size()));
+                    files.Add(buffer.c_str(), copied);
+                }
+                files.Compact();
+                p_rFiles.Swap(files);
+                p_rFileCount = totalFileCount;
+                extracted = true;
+            }
+        }
+    }
+
+    return extracted;
+}
 
 }
 
 // CPathCopyCopyContextMenuExt
 
+//
+// State of the prefetch of information needed to build our menu, shared with
+// the worker thread computing it. The shell initializes us a little while
+// before asking us to populate the menu; we use that time to determine which
+// plugins are enabled and to compute previews. The worker thread can outlive
+// us if the menu is never shown, so everything it needs is kept here.
+//
+struct CPathCopyCopyContextMenuExt::MenuPrefetch
+{
+    PCC::PluginsSnapshotSP  m_spPluginsSnapshot;        // Snapshot owning settings used by plugins.
+    PCC::PluginSPV          m_vspPlugins;               // Plugins to evaluate; all of them can compute paths concurrently.
+    PCC::PluginSPV          m_vspPreviewPlugins;        // Plugins whose preview must be computed, if enabled.
+    std::wstring            m_ParentPath;               // Parent path to pass to plugins.
+    std::wstring            m_File;                     // File to pass to plugins.
+    PluginEnabledM          m_mPluginsEnabled;          // Enabled states of plugins evaluated so far.
+    PluginPathM             m_mFirstFilePaths;          // Previews computed so far.
+    bool                    m_EnabledStatesCompleted;   // Whether all plugins have been evaluated.
+    bool                    m_Cancelled;                // Whether the prefetch has been cancelled because it's not needed.
+    std::mutex              m_Lock;                     // Lock protecting members.
+    std::condition_variable m_EnabledStatesCompletedCond;   // Signaled when all plugins have been evaluated.
+    PCC::ThreadPool::TaskSP m_spTask;                   // Task computing the prefetch in the thread pool.
+};
+
+//
+// State of a speculative conversion of the selected files, shared with the
+// worker thread computing it. Once our menu is built, the user usually takes
+// a while to pick an item; we use that time to convert the files with the
+// plugin the user is most likely to pick. The worker thread can outlive us
+// if the conversion is cancelled, so everything it needs is kept here.
+//
+struct CPathCopyCopyContextMenuExt::SpeculativeConversion
+{
+    PCC::PluginsSnapshotSP  m_spPluginsSnapshot;    // Snapshot owning settings used by the plugin.
+    PCC::PluginSP           m_spPlugin;             // Plugin used to convert files.
+    PCC::FileSelection      m_Files;                // Files to convert.
+    PCC::WStringV           m_vPaths;               // Converted paths, once completed successfully.
+    bool                    m_Completed;            // Whether the conversion has completed (successfully or not).
+    bool                    m_Succeeded;            // Whether the conversion has completed successfully.
+    bool                    m_Cancelled;            // Whether the conversion has been cancelled because it's not needed.
+    std::mutex              m_Lock;                 // Lock protecting members.
+    std::condition_variable m_CompletedCond;        // Signaled when the conversion has completed.
+    PCC::ThreadPool::TaskSP m_spTask;               // Task performing the conversion in the thread pool.
+};
+
 // Static members
-CPathCopyCopyContextMenuExt::ExtToMenuPairV CPathCopyCopyContextMenuExt::s_vExtToMenus;
-std::mutex                                  CPathCopyCopyContextMenuExt::s_ExtToMenusLock;
+CPathCopyCopyContextMenuExt::HMenuS CPathCopyCopyContextMenuExt::s_sModifiedMenus;
+PCC::MeasuredMutex                  CPathCopyCopyContextMenuExt::s_ModifiedMenusLock(L"CPathCopyCopyContextMenuExt::s_ModifiedMenusLock");
+GUID                                CPathCopyCopyContextMenuExt::s_LastUsedPluginId = GUID_NULL;
+PCC::MeasuredMutex                  CPathCopyCopyContextMenuExt::s_LastUsedPluginLock(L"CPathCopyCopyContextMenuExt::s_LastUsedPluginLock");
+__time64_t                          CPathCopyCopyContextMenuExt::s_NextUpdateCheck = 0;
+bool                                CPathCopyCopyContextMenuExt::s_UpdateCheckPending = false;
+std::mutex                          CPathCopyCopyContextMenuExt::s_UpdateCheckLock;
 
 //
 // Constructor.
 //
 CPathCopyCopyContextMenuExt::CPathCopyCopyContextMenuExt()
     : m_spSettings(),
-      m_vspPluginsInDefaultOrder(),
-      m_sspAllPlugins(),
-      m_spPluginProvider(),
-      m_vFiles(),
+      m_spPluginsSnapshot(),
+      m_Files(),
+      m_FileCount(0),
+      m_spDataObject(),
       m_ParentPath(),
       m_FirstCmdId(),
       m_SubMenuCmdId(),
       m_SettingsCmdId(),
-      m_mPluginsByCmdId(),
+      m_MenuDeadline(),
+      m_MenuBudgetExceeded(false),
+      m_hPreviewSubMenu(NULL),
+      m_vPreviewCmdIds(),
+      m_mNestedSubMenus(),
+      m_vspPluginsByCmdOffset(),
+      m_mPluginsEnabled(),
+      m_mFirstFilePaths(),
+      m_UsedShortcuts(),
+      m_mIconFilesByItemId(),
       m_spPCCIcon(),
-      m_mspIcons()
+      m_mspIcons(),
+      m_mspScaledIcons(),
+      m_hModifiedMenu(NULL),
+      m_spMenuPrefetch(),
+      m_spSpeculativeConversion(),
+      m_pMenuMetadataCache(nullptr)
 {
 }
 
@@ -76,8 +399,12 @@ CPathCopyCopyContextMenuExt::CPathCopyCopyContextMenuExt()
 //
 CPathCopyCopyContextMenuExt::~CPathCopyCopyContextMenuExt()
 {
-    // Remove this instance from the map of instances modifying menus (if it's there).
-    RemoveFromExtToMenu();
+    // Remove the menu we modified from the set of modified menus (if it's there).
+    RemoveFromModifiedMenus();
+
+    // If the prefetch or a speculative conversion is still running, their results are no longer needed.
+    CancelMenuPrefetch();
+    CancelSpeculativeConversion();
 
     // Check for updates, but ONLY if settings were created. Otherwise, it means
     // that either COM object hasn't been used by the shell or it was used to register plugins.
@@ -85,6 +412,13 @@ CPathCopyCopyContextMenuExt::~CPathCopyCopyContextMenuExt()
     if (m_spSettings != nullptr) {
         CheckForUpdates();
     }
+
+    // Save plugin statistics in the background so that the settings app can display them.
+    // Statistics recorded by worker threads still running will be saved next time.
+    PCC::PluginStatistics::Save();
+
+    // Same for slow operations captured by the flight recorder.
+    PCC::FlightRecorder::Save();
 }
 
 //
@@ -208,51 +542,44 @@ STDMETHODIMP CPathCopyCopyContextMenuExt::Initialize(
     HKEY /*p_hKeyFileClass*/)
 {
     HRESULT hRes = S_OK;
+    PCC::StTraceEvent traceEvent(L"ContextMenuExt::Initialize");
 
     try {
         // Make sure we have a data object.
         if (p_pDataObject != nullptr) {
-            // Extract HDROP from data object.
-            StStgMedium stgMedium;
-            FORMATETC formatEtc = {CF_HDROP, nullptr, DVASPECT_CONTENT, -1, TYMED_HGLOBAL};
-            if (SUCCEEDED(p_pDataObject->GetData(&formatEtc, &stgMedium))) {
-                // Get number of files included in the selection.
-                UINT fileCount = ::DragQueryFileW(
-                    static_cast<HDROP>(stgMedium.Get().hGlobal), 0xFFFFFFFF, 0, 0);
-                if (fileCount > 0) {
-                    // Pre-allocate space in vector to store files.
-                    m_vFiles.reserve(fileCount);
-
-                    // Get each file in turn.
-                    wchar_t buffer[MAX_PATH + 1];
-                    for(UINT i = 0; i < fileCount; ++i) {
-                        UINT copiedCount = ::DragQueryFileW(static_cast<HDROP>(stgMedium.Get().hGlobal),
-                            i, buffer, sizeof(buffer) / sizeof(wchar_t));
-                        m_vFiles.push_back(std::wstring(buffer, copiedCount));
-                    }
-
-                    // Extract the parent path of the first file. We'll assume that all
-                    // files have the same parent. This might not be strictly true in all
-                    // cases (for example, in a custom shell view) but we're only using it
-                    // for validation purposes, so it's good enough.
-                    if (!m_vFiles.empty()) {
-                        m_ParentPath = m_vFiles.front();
-                        PCC::PluginUtils::ExtractFolderFromPath(m_ParentPath);
-                    }
-                } else {
-                    // It's difficult to display a menu item without files to act upon.
-                    hRes = E_FAIL;
+            // Only get the first file for now, since it's all we need to build
+            // the menu. Other files will be extracted from the data object
+            // if the user actually picks a command (see GetSelectedFiles).
+            // Prefer the shell ID list, which is cheaper to get than an HDROP.
+            UINT fileCount = 0;
+            if (GetFilesFromShellIdList(p_pDataObject, 1, m_Files, fileCount) ||
+                GetFilesFromHDrop(p_pDataObject, 1, m_Files, fileCount)) {
+
+                m_FileCount = fileCount;
+                if (fileCount > 1) {
+                    m_spDataObject = p_pDataObject;
                 }
+
+                // Extract the parent path of the first file. We'll assume that all
+                // files have the same parent. This might not be strictly true in all
+                // cases (for example, in a custom shell view) but we're only using it
+                // for validation purposes, so it's good enough.
+                m_ParentPath = m_Files.GetFile(0);
+                PCC::PluginUtils::ExtractFolderFromPath(m_ParentPath);
+            } else {
+                // It's difficult to display a menu item without files to act upon.
+                hRes = E_FAIL;
             }
         } else if (p_pFolderPIDL != nullptr) {
             // No data object, but maybe it's because user clicked on a folder's
             // background. Get the folder path from the ID list.
-            wchar_t buffer[MAX_PATH + 1];
-            if (::SHGetPathFromIDList(p_pFolderPIDL, buffer) != FALSE) {
-                m_vFiles.push_back(std::wstring(buffer));
+            std::vector<wchar_t> vBuffer;
+            if (GetPathFromIDList(p_pFolderPIDL, vBuffer)) {
+                m_Files.Add(vBuffer.data(), std::wcslen(vBuffer.data()));
+                m_FileCount = 1;
 
                 // Extract the parent path.
-                m_ParentPath = m_vFiles.front();
+                m_ParentPath = m_Files.GetFile(0);
                 PCC::PluginUtils::ExtractFolderFromPath(m_ParentPath);
             } else {
                 // Nothing like that either, problem.
@@ -261,10 +588,16 @@ STDMETHODIMP CPathCopyCopyContextMenuExt::Initialize(
         } else {
             hRes = E_POINTER;
         }
+
+        // Start computing what our menu will need while the shell prepares it.
+        if (SUCCEEDED(hRes)) {
+            StartMenuPrefetch();
+        }
     } catch (...) {
         hRes = E_UNEXPECTED;
     }
 
+    traceEvent.SetCount(m_FileCount);
     return hRes;
 }
 
@@ -290,6 +623,13 @@ STDMETHODIMP CPathCopyCopyContextMenuExt::QueryContextMenu(
     UINT p_Flags)
 {
     HRESULT hRes = S_OK;
+    const auto menuStart = std::chrono::steady_clock::now();
+    PCC::StFlightRecording flightRecording(PCC::FlightRecorder::Operation::Menu);
+    PCC::StTraceEvent traceEvent(L"ContextMenuExt::QueryContextMenu");
+
+    // Plugins computing previews all resolve the same file; cache its metadata.
+    PCC::FileMetadataCache metadataCache;
+    m_pMenuMetadataCache = &metadataCache;
 
     try {
         if (p_hMenu == NULL) {
@@ -298,204 +638,258 @@ STDMETHODIMP CPathCopyCopyContextMenuExt::QueryContextMenu(
             // Make sure this menu hasn't been modified by another instance.
             bool alreadyModified = false;
             {
-                std::lock_guard<std::mutex> lock(s_ExtToMenusLock);
-                ExtToMenuPairV::const_iterator it, end = s_vExtToMenus.end();
-                for (it = s_vExtToMenus.begin(); it != end; ++it) {
-                    if (it->second == p_hMenu) {
-                        // Modified already, bail out.
-                        alreadyModified = true;
-                        break;
-                    }
-                }
+                std::lock_guard<PCC::MeasuredMutex> lock(s_ModifiedMenusLock);
+                alreadyModified = s_sModifiedMenus.find(p_hMenu) != s_sModifiedMenus.end();
             }
 
             // Do not add items if the default action is chosen, if we have no files
             // or if menu has been modified by another instance.
-            if (m_vFiles.empty() || (p_Flags & CMF_DEFAULTONLY) != 0 || alreadyModified) {
+            if (m_Files.Empty() || (p_Flags & CMF_DEFAULTONLY) != 0 || alreadyModified) {
+                CancelMenuPrefetch();
                 hRes = E_FAIL;
             } else {
                 UINT cmdId = p_FirstCmdId;
                 UINT position = p_Index;
 
-                // Fetch reference to settings.
-                PCC::Settings& rSettings = GetSettings();
-
-                // Get all plugins in default order. Do not include temp pipeline plugins.
-                m_vspPluginsInDefaultOrder = PCC::PluginsRegistry::GetPluginsInDefaultOrder(&rSettings, &rSettings, false);
-
-                // Get set of all plugins from the above vector.
-                m_sspAllPlugins.insert(m_vspPluginsInDefaultOrder.cbegin(), m_vspPluginsInDefaultOrder.cend());
-
-                // Create plugin provider object wrapping our set of all plugins.
-                m_spPluginProvider = std::make_shared<PCC::AllPluginsProvider>(m_sspAllPlugins);
+                // Command IDs are allocated contiguously from the first one, so we can
+                // store our plugins in a vector indexed by offset from that first ID.
+                m_FirstCmdId = static_cast<UINT_PTR>(p_FirstCmdId);
+                m_vspPluginsByCmdOffset.clear();
+                m_mNestedSubMenus.clear();
 
-                // Provide each plugin with settings object and plugin provider, since some require this to work.
-                for (const PCC::PluginSP& spPlugin : m_sspAllPlugins) {
-                    spPlugin->SetSettings(&rSettings);
-                    spPlugin->SetPluginProvider(m_spPluginProvider.get());
-                }
+                // Find shortcuts already used in the menu once; we'll update them as we add items.
+                ScanMenuShortcuts(p_hMenu);
 
-                // Quick helper to create a default plugin if needed later.
-                auto createDefaultPlugin = [&]() {
-                    PCC::PluginSP spDefaultPlugin = std::make_shared<PCC::Plugins::DefaultPlugin>();
-                    spDefaultPlugin->SetSettings(&rSettings);
-                    spDefaultPlugin->SetPluginProvider(m_spPluginProvider.get());
-                    return spDefaultPlugin;
-                };
+                // Fetch reference to settings.
+                PCC::Settings& rSettings = GetSettings();
 
-                // Get a few setting values.
-                const bool useIconForDefaultPlugin = rSettings.GetUseIconForDefaultPlugin();
-                const bool usePreviewMode = rSettings.GetUsePreviewMode();
-                const bool usePreviewModeInMainMenu = rSettings.GetUsePreviewModeInMainMenu();
-                const bool dropRedundantWords = rSettings.GetDropRedundantWords();
-                const bool alwaysShowSubmenu = rSettings.GetAlwaysShowSubmenu();
-                PCC::GUIDV vKnownPlugins;
-                const PCC::GUIDV* const pvKnownPlugins = rSettings.GetKnownPlugins(vKnownPlugins) ? &vKnownPlugins : nullptr;
-                GUID ctrlKeyPluginId;
-                const GUID* const pCtrlKeyPluginId = rSettings.GetCtrlKeyPlugin(ctrlKeyPluginId) ? &ctrlKeyPluginId : nullptr;
-
-                // Check if user held down Ctrl key and we have a plugin to use when this happens.
-                if ((::GetKeyState(VK_CONTROL) & 0x8000) != 0 && pCtrlKeyPluginId != nullptr) {
-                    // Find plugin to use.
-                    auto pluginIt = m_sspAllPlugins.find(*pCtrlKeyPluginId);
-                    if (pluginIt != m_sspAllPlugins.end() && !(*pluginIt)->IsSeparator()) {
-                        ActOnFiles(*pluginIt, NULL);
-                    }
+                // Start the clock on our time budget. Once it's exceeded, we'll build
+                // the rest of the menu as fast as possible to avoid blocking the shell.
+                const DWORD menuTimeBudget = rSettings.GetMenuTimeBudget();
+                if (menuTimeBudget != 0) {
+                    m_MenuDeadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(menuTimeBudget);
                 }
 
-                // Add all plugins requested to the main menu.
-                PCC::GUIDV vPluginIds;
-                if (rSettings.GetMainMenuPluginDisplayOrder(vPluginIds)) {
-                    PCC::PluginSPV vspPlugins = PCC::PluginsRegistry::OrderPluginsToDisplay(
-                        m_sspAllPlugins, vPluginIds, pvKnownPlugins, &m_vspPluginsInDefaultOrder);
-                    if (!vPluginIds.empty()) {
-                        if (vPluginIds.size() != 1 || !::IsEqualGUID(vPluginIds.front(), PCC::Plugins::LongPathPlugin::ID)) {
-                            PCC::CLSIDV::const_iterator it, end = vPluginIds.end();
-                            for (it = vPluginIds.begin(); SUCCEEDED(hRes) && it != end; ++it) {
-                                hRes = AddPluginToMenu(*it, p_hMenu, useIconForDefaultPlugin, usePreviewModeInMainMenu, false, true, cmdId, position);
+                // If user held down Ctrl and we have a plugin to use when this happens,
+                // use it right away and skip building the menu entirely.
+                if (!ActOnFilesWithCtrlKeyPlugin()) {
+                    // Get snapshot of all plugins. This is cached and shared between instances.
+                    m_spPluginsSnapshot = PCC::PluginsSnapshot::Get();
+                    m_spPluginsSnapshot->ClearCachedPaths();
+
+                    // Fetch plugins' enabled states prefetched since we were initialized.
+                    ConsumePrefetchedEnabledStates();
+
+                    // Reuse what was computed if the menu was built recently for the same selection.
+                    LoadMenuTemplate();
+
+                    // Quick helper to create a default plugin if needed later.
+                    auto createDefaultPlugin = [&]() -> PCC::PluginSP {
+                        return std::make_shared<PCC::Plugins::DefaultPlugin>();
+                    };
+
+                    // Get a few setting values.
+                    const bool useIconForDefaultPlugin = rSettings.GetUseIconForDefaultPlugin();
+                    const bool usePreviewMode = rSettings.GetUsePreviewMode();
+                    const bool usePreviewModeInMainMenu = rSettings.GetUsePreviewModeInMainMenu();
+                    const bool dropRedundantWords = rSettings.GetDropRedundantWords();
+                    const bool alwaysShowSubmenu = rSettings.GetAlwaysShowSubmenu();
+
+                    // Add all plugins requested to the main menu. Plugins to display
+                    // have already been ordered by the snapshot.
+                    const PCC::GUIDV* const pvMainMenuPluginIds = m_spPluginsSnapshot->GetMainMenuPluginIds();
+                    if (pvMainMenuPluginIds != nullptr) {
+                        const PCC::GUIDV& vPluginIds = *pvMainMenuPluginIds;
+                        if (!vPluginIds.empty()) {
+                            if (vPluginIds.size() != 1 || !::IsEqualGUID(vPluginIds.front(), PCC::Plugins::LongPathPlugin::ID)) {
+                                EvaluatePluginsEnabled(m_spPluginsSnapshot->GetMainMenuPlugins());
+                                PCC::CLSIDV::const_iterator it, end = vPluginIds.end();
+                                for (it = vPluginIds.begin(); SUCCEEDED(hRes) && it != end; ++it) {
+                                    hRes = AddPluginToMenu(*it, p_hMenu, useIconForDefaultPlugin, usePreviewModeInMainMenu, false, true, cmdId, position);
+                                }
+                            } else {
+                                // Default plugin is specified, use our own instead.
+                                hRes = AddPluginToMenu(createDefaultPlugin(), p_hMenu, useIconForDefaultPlugin, usePreviewModeInMainMenu, false, true, cmdId, position);
                             }
-                        } else {
-                            // Default plugin is specified, use our own instead.
-                            hRes = AddPluginToMenu(createDefaultPlugin(), p_hMenu, useIconForDefaultPlugin, usePreviewModeInMainMenu, false, true, cmdId, position);
                         }
+                    } else {
+                        // No setting specified for items in the main menu. Add our default plugin.
+                        hRes = AddPluginToMenu(createDefaultPlugin(), p_hMenu, useIconForDefaultPlugin, usePreviewModeInMainMenu, false, true, cmdId, position);
                     }
-                } else {
-                    // No setting specified for items in the main menu. Add our default plugin.
-                    hRes = AddPluginToMenu(createDefaultPlugin(), p_hMenu, useIconForDefaultPlugin, usePreviewModeInMainMenu, false, true, cmdId, position);
-                }
 
-                // Create sub-menu to populate it with the other plugins.
-                // If we don't always show the submenu, user needs to ask
-                // for extended verbs to get it (by holding Shift).
-                if (SUCCEEDED(hRes) && cmdId <= p_LastCmdId && (alwaysShowSubmenu || (p_Flags & CMF_EXTENDEDVERBS) != 0)) {
-                    HMENU hSubMenu = ::CreatePopupMenu();
-                    try {
-                        // Fetch list of plugins to display in the submenu.
-                        PCC::PluginSPV vspPlugins;
-                        const PCC::PluginSPV* pvspPlugins = nullptr;
-                        vPluginIds.clear();
-                        rSettings.GetSubmenuPluginDisplayOrder(vPluginIds);
-                        if (!vPluginIds.empty()) {
-                            vspPlugins = PCC::PluginsRegistry::OrderPluginsToDisplay(m_sspAllPlugins, vPluginIds,
-                                pvKnownPlugins, &m_vspPluginsInDefaultOrder);
-                            pvspPlugins = &vspPlugins;
-                        } else {
-                            // No plugin specified, use all plugins in default order.
-                            pvspPlugins = &m_vspPluginsInDefaultOrder;
-                        }
+                    // Create sub-menu to populate it with the other plugins.
+                    // If we don't always show the submenu, user needs to ask
+                    // for extended verbs to get it (by holding Shift).
+                    if (SUCCEEDED(hRes) && cmdId <= p_LastCmdId && (alwaysShowSubmenu || (p_Flags & CMF_EXTENDEDVERBS) != 0)) {
+                        HMENU hSubMenu = ::CreatePopupMenu();
+                        try {
+                            // Fetch list of plugins to display in the submenu.
+                            const PCC::PluginSPV* const pvspPlugins = &m_spPluginsSnapshot->GetSubmenuPlugins();
+
+                            // Plugins displayed in nested submenus are only evaluated when their submenu is opened.
+                            PCC::PluginSPV vspVisiblePlugins;
+                            vspVisiblePlugins.reserve(pvspPlugins->size());
+                            std::copy_if(pvspPlugins->cbegin(), pvspPlugins->cend(), std::back_inserter(vspVisiblePlugins),
+                                         [](const PCC::PluginSP& p_spPlugin) { return p_spPlugin->MenuFolder().empty(); });
+
+                            // Determine which plugins are enabled, then iterate plugins and try to add them to the submenu.
+                            EvaluatePluginsEnabled(vspVisiblePlugins);
+                            UINT subPosition = 0;
+                            std::map<std::wstring, HMENU> mhNestedSubMenus;
+                            PCC::PluginSPV::const_iterator it, end = pvspPlugins->cend();
+                            bool prevWasSeparator = true;
+                            for (it = pvspPlugins->cbegin(); SUCCEEDED(hRes) && cmdId <= p_LastCmdId && it != end; ++it) {
+                                // Try to insert this plugin in the menu.
+                                const PCC::PluginSP& spPlugin = *it;
+                                const std::wstring menuFolder = !spPlugin->IsSeparator() ? spPlugin->MenuFolder() : std::wstring();
+                                if (!menuFolder.empty()) {
+                                    // Plugin goes in a nested submenu, created where its first plugin would have been.
+                                    auto nestedIt = mhNestedSubMenus.find(menuFolder);
+                                    if (nestedIt == mhNestedSubMenus.end()) {
+                                        HMENU hNestedSubMenu = ::CreatePopupMenu();
+                                        MENUITEMINFOW menuItemInfo;
+                                        menuItemInfo.cbSize = sizeof(MENUITEMINFOW);
+                                        menuItemInfo.fMask = MIIM_FTYPE | MIIM_STRING | MIIM_SUBMENU;
+                                        menuItemInfo.fType = MFT_STRING;
+                                        menuItemInfo.hSubMenu = hNestedSubMenu;
+                                        menuItemInfo.dwTypeData = const_cast<LPWSTR>(menuFolder.c_str());
+                                        if (hNestedSubMenu != NULL && ::InsertMenuItemW(hSubMenu, subPosition, TRUE, &menuItemInfo)) {
+                                            nestedIt = mhNestedSubMenus.emplace(menuFolder, hNestedSubMenu).first;
+                                            ++subPosition;
+                                        } else {
+                                            if (hNestedSubMenu != NULL) {
+                                                ::DestroyMenu(hNestedSubMenu);
+                                            }
+                                            hRes = E_FAIL;
+                                        }
+                                    }
 
-                        // Iterate plugins and try to add them to the submenu.
-                        UINT subPosition = 0;
-                        PCC::PluginSPV::const_iterator it, end = pvspPlugins->cend();
-                        bool prevWasSeparator = true;
-                        for (it = pvspPlugins->cbegin(); SUCCEEDED(hRes) && cmdId <= p_LastCmdId && it != end; ++it) {
-                            // Try to insert this plugin in the menu.
-                            const PCC::PluginSP& spPlugin = *it;
-                            if (!spPlugin->IsSeparator()) {
-                                hRes = AddPluginToMenu(spPlugin, hSubMenu, false, usePreviewMode, dropRedundantWords, false, cmdId, subPosition);
-                                prevWasSeparator = false;
-                            } else {
-                                // This is a proxy to insert a separator.
-                                // Note: there's a chance that we may double up the separators
-                                // if not all plugins are shown in the submenu. Avoid this if possible.
+                                    // Reserve a command ID for the plugin; its item will be added when the submenu is opened.
+                                    if (SUCCEEDED(hRes)) {
+                                        NestedSubMenu& rNestedSubMenu = m_mNestedSubMenus[nestedIt->second];
+                                        rNestedSubMenu.m_vspPlugins.push_back(spPlugin);
+                                        rNestedSubMenu.m_vCmdIds.push_back(cmdId);
+                                        const size_t cmdOffset = static_cast<size_t>(cmdId - *m_FirstCmdId);
+                                        if (m_vspPluginsByCmdOffset.size() <= cmdOffset) {
+                                            m_vspPluginsByCmdOffset.resize(cmdOffset + 1);
+                                        }
+                                        m_vspPluginsByCmdOffset[cmdOffset] = spPlugin;
+                                        ++cmdId;
+                                    }
+                                    prevWasSeparator = false;
+                                } else if (!spPlugin->IsSeparator()) {
+                                    // If preview mode is used, only compute previews when the submenu is about to be shown.
+                                    const UINT pluginCmdId = cmdId;
+                                    hRes = AddPluginToMenu(spPlugin, hSubMenu, false, false, dropRedundantWords, false, cmdId, subPosition);
+                                    if (SUCCEEDED(hRes) && usePreviewMode && !MenuBudgetExceeded()) {
+                                        m_vPreviewCmdIds.push_back(static_cast<UINT_PTR>(pluginCmdId));
+                                    }
+                                    prevWasSeparator = false;
+                                } else {
+                                    // This is a proxy to insert a separator.
+                                    // Note: there's a chance that we may double up the separators
+                                    // if not all plugins are shown in the submenu. Avoid this if possible.
+                                    if (!prevWasSeparator) {
+                                        if (::InsertMenuW(hSubMenu, subPosition, MF_BYPOSITION | MF_SEPARATOR, 0, 0)) {
+                                            ++subPosition;
+                                            // No need to increment cmdId.
+                                        } else {
+                                            hRes = E_FAIL;
+                                        }
+                                        prevWasSeparator = true;
+                                    }
+                                }
+                            }
+
+                            // Add item to open the settings app, unless editing
+                            // the settings has been locked out by the administrator.
+                            if (SUCCEEDED(hRes) && cmdId <= p_LastCmdId && !rSettings.GetEditingDisabled()) {
                                 if (!prevWasSeparator) {
                                     if (::InsertMenuW(hSubMenu, subPosition, MF_BYPOSITION | MF_SEPARATOR, 0, 0)) {
                                         ++subPosition;
-                                        // No need to increment cmdId.
                                     } else {
                                         hRes = E_FAIL;
                                     }
-                                    prevWasSeparator = true;
+                                }
+                                if (SUCCEEDED(hRes)) {
+                                    ATL::CStringW settingsCaption(MAKEINTRESOURCEW(IDS_PCC_SETTINGS_DESCRIPTION));
+                                    if (::InsertMenuW(hSubMenu, subPosition, MF_BYPOSITION | MF_STRING, cmdId, settingsCaption)) {
+                                        m_SettingsCmdId = static_cast<UINT_PTR>(cmdId);
+                                        ++cmdId;
+                                        ++subPosition;
+                                    } else {
+                                        hRes = E_FAIL;
+                                    }
                                 }
                             }
+                        } catch (...) {
+                            ::DestroyMenu(hSubMenu);
+                            throw;
                         }
 
-                        // Add item to open the settings app, unless editing
-                        // the settings has been locked out by the administrator.
-                        if (SUCCEEDED(hRes) && cmdId <= p_LastCmdId && !rSettings.GetEditingDisabled()) {
-                            if (!prevWasSeparator) {
-                                if (::InsertMenuW(hSubMenu, subPosition, MF_BYPOSITION | MF_SEPARATOR, 0, 0)) {
-                                    ++subPosition;
-                                } else {
-                                    hRes = E_FAIL;
-                                }
+                        if (SUCCEEDED(hRes) && ::GetMenuItemCount(hSubMenu) > 0) {
+                            // Submenu was populated. Add it to the contextual menu.
+                            std::wstring subMenuCaption = GetMenuCaptionWithShortcut((LPCWSTR) ATL::CStringW(MAKEINTRESOURCEW(IDS_PATH_COPY_MENU_ITEM)));
+                            PCCDEBUGCODE(subMenuCaption += L" (DEBUG)");
+                            MENUITEMINFOW menuItemInfo;
+                            menuItemInfo.cbSize = sizeof(MENUITEMINFOW);
+                            menuItemInfo.fMask = MIIM_FTYPE | MIIM_ID | MIIM_STRING | MIIM_SUBMENU;
+                            menuItemInfo.fType = MFT_STRING;
+                            menuItemInfo.wID = cmdId;
+                            menuItemInfo.hSubMenu = hSubMenu;
+                            menuItemInfo.dwTypeData = &*subMenuCaption.begin();
+                            if (rSettings.GetUseIconForSubmenu()) {
+                                // Add an icon next to the submenu. It will be drawn when needed. Depending on
+                                // the version of Windows, the item will be identified by command ID or submenu handle.
+                                menuItemInfo.fMask |= MIIM_BITMAP;
+                                menuItemInfo.hbmpItem = HBMMENU_CALLBACK;
+                                m_mIconFilesByItemId[cmdId] = std::wstring();
+                                m_mIconFilesByItemId[static_cast<UINT>(reinterpret_cast<UINT_PTR>(hSubMenu))] = std::wstring();
                             }
-                            if (SUCCEEDED(hRes)) {
-                                ATL::CStringW settingsCaption(MAKEINTRESOURCEW(IDS_PCC_SETTINGS_DESCRIPTION));
-                                if (::InsertMenuW(hSubMenu, subPosition, MF_BYPOSITION | MF_STRING, cmdId, settingsCaption)) {
-                                    m_SettingsCmdId = static_cast<UINT_PTR>(cmdId);
-                                    ++cmdId;
-                                    ++subPosition;
-                                } else {
-                                    hRes = E_FAIL;
+                            if (::InsertMenuItemW(p_hMenu, position, TRUE, &menuItemInfo)) {
+                                if (!m_vPreviewCmdIds.empty()) {
+                                    m_hPreviewSubMenu = hSubMenu;
                                 }
+                                m_SubMenuCmdId = static_cast<UINT_PTR>(cmdId);
+                                ++cmdId;
+                                ++position;
+                            } else {
+                                hRes = E_FAIL;
                             }
                         }
-                    } catch (...) {
-                        ::DestroyMenu(hSubMenu);
-                        throw;
-                    }
 
-                    if (SUCCEEDED(hRes) && ::GetMenuItemCount(hSubMenu) > 0) {
-                        // Submenu was populated. Add it to the contextual menu.
-                        std::wstring subMenuCaption = GetMenuCaptionWithShortcut(p_hMenu, (LPCWSTR) ATL::CStringW(MAKEINTRESOURCEW(IDS_PATH_COPY_MENU_ITEM)));
-                        PCCDEBUGCODE(subMenuCaption += L" (DEBUG)");
-                        MENUITEMINFOW menuItemInfo;
-                        menuItemInfo.cbSize = sizeof(MENUITEMINFOW);
-                        menuItemInfo.fMask = MIIM_FTYPE | MIIM_ID | MIIM_STRING | MIIM_SUBMENU;
-                        menuItemInfo.fType = MFT_STRING;
-                        menuItemInfo.wID = cmdId;
-                        menuItemInfo.hSubMenu = hSubMenu;
-                        menuItemInfo.dwTypeData = &*subMenuCaption.begin();
-                        if (rSettings.GetUseIconForSubmenu()) {
-                            // Add an icon next to the submenu.
-                            HBITMAP hIconBitmap = GetPCCIcon();
-                            if (hIconBitmap != NULL) {
-                                menuItemInfo.fMask |= MIIM_BITMAP;
-                                menuItemInfo.hbmpItem = hIconBitmap;
-                            }
-                        }
-                        if (::InsertMenuItemW(p_hMenu, position, TRUE, &menuItemInfo)) {
-                            m_SubMenuCmdId = static_cast<UINT_PTR>(cmdId);
-                            ++cmdId;
-                            ++position;
-                        } else {
-                            hRes = E_FAIL;
+                        if (FAILED(hRes)) {
+                            ::DestroyMenu(hSubMenu);
                         }
                     }
 
-                    if (FAILED(hRes)) {
-                        ::DestroyMenu(hSubMenu);
-                    }
+                    // Keep track of how often we exceed our time budget.
+                    PCC::PluginStatistics::RecordMenu(MenuBudgetExceeded());
                 }
 
                 if (SUCCEEDED(hRes)) {
                     // Strange return value requirement... see MSDN for details.
                     hRes = MAKE_HRESULT(SEVERITY_SUCCESS, 0, cmdId - p_FirstCmdId + 1);
+                    traceEvent.SetCount(cmdId - p_FirstCmdId);
+                    PCC::PerformanceCounters::MenuBuilt(std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - menuStart));
+
+                    // Mark this menu as modified so that other instances leave it alone.
+                    RemoveFromModifiedMenus();
+                    {
+                        std::lock_guard<PCC::MeasuredMutex> lock(s_ModifiedMenusLock);
+                        if (s_sModifiedMenus.insert(p_hMenu).second) {
+                            m_hModifiedMenu = p_hMenu;
+                        }
+                    }
+
+                    // Keep what we computed in case the shell builds the menu again for the same selection.
+                    if (m_spPluginsSnapshot != nullptr) {
+                        StoreMenuTemplate();
+                    }
 
-                    // Mark us as being the instance that modified this menu.
-                    std::lock_guard<std::mutex> lock(s_ExtToMenusLock);
-                    s_vExtToMenus.emplace_back(this, p_hMenu);
+                    // Use the time the user takes to pick an item to convert the selected files.
+                    StartSpeculativeConversion();
                 }
             }
         }
@@ -503,6 +897,7 @@ STDMETHODIMP CPathCopyCopyContextMenuExt::QueryContextMenu(
         hRes = E_UNEXPECTED;
     }
 
+    m_pMenuMetadataCache = nullptr;
     return hRes;
 }
 
@@ -519,6 +914,7 @@ STDMETHODIMP CPathCopyCopyContextMenuExt::InvokeCommand(
     CMINVOKECOMMANDINFO* p_pCommandInfo)
 {
     HRESULT hRes = S_OK;
+    PCC::StFlightRecording flightRecording(PCC::FlightRecorder::Operation::Invoke);
 
     try {
         if ((p_pCommandInfo == nullptr) || (p_pCommandInfo->cbSize < sizeof(CMINVOKECOMMANDINFO))) {
@@ -535,8 +931,8 @@ STDMETHODIMP CPathCopyCopyContextMenuExt::InvokeCommand(
             } else {
                 // Check which command it is that is invoked.
                 UINT_PTR cmdId = cmdOffset + *m_FirstCmdId;
-                CmdIdPluginM::const_iterator itId = m_mPluginsByCmdId.find(cmdId);
-                if (itId == m_mPluginsByCmdId.end()) {
+                PCC::PluginSP spPlugin = GetPluginByCmdOffset(cmdOffset);
+                if (spPlugin == nullptr) {
                     // This is not a recognized plugin command ID.
                     if (m_SettingsCmdId.has_value() && *m_SettingsCmdId == cmdId) {
                         PCC::SettingsApp().Launch();
@@ -547,9 +943,6 @@ STDMETHODIMP CPathCopyCopyContextMenuExt::InvokeCommand(
                         hRes = E_FAIL;
                     }
                 } else {
-                    // Fetch plugin reference for this command ID.
-                    PCC::PluginSP spPlugin = itId->second;
-
                     // Act on the files using the plugin.
                     hRes = ActOnFiles(spPlugin, p_pCommandInfo->hwnd);
                 }
@@ -595,7 +988,7 @@ STDMETHODIMP CPathCopyCopyContextMenuExt::GetCommandString(
             // We need to validate command ID.
             hRes = S_FALSE;
             if (m_FirstCmdId.has_value()) {
-                if ((m_mPluginsByCmdId.find(*m_FirstCmdId + p_CmdId) != m_mPluginsByCmdId.end()) ||
+                if ((GetPluginByCmdOffset(p_CmdId) != nullptr) ||
                     (m_SettingsCmdId.has_value() && (*m_FirstCmdId + p_CmdId) == *m_SettingsCmdId)) {
 
                     // Either it's a plugin or a special menu item.
@@ -603,58 +996,29 @@ STDMETHODIMP CPathCopyCopyContextMenuExt::GetCommandString(
                 }
             }
         } else if (p_Flags == GCS_HELPTEXTA) {
-            // Call this method to get the Unicode version.
-            std::unique_ptr<wchar_t[]> upwBuffer(new wchar_t[p_BufferSize]);
-            hRes = this->GetCommandString(p_CmdId,
-                                          GCS_HELPTEXTW,
-                                          p_pReserved,
-                                          reinterpret_cast<LPSTR>(upwBuffer.get()),
-                                          p_BufferSize);
-            if (SUCCEEDED(hRes)) {
-                // Convert it to a single-byte string and return it.
-                ATL::CStringA aBuffer(upwBuffer.get());
-                if (::strcpy_s(p_pBuffer, p_BufferSize, aBuffer) == 0) {
-                    hRes = S_OK;
+            // Convert the Unicode help text directly in the caller's buffer.
+            std::wstring helpText;
+            hRes = p_pBuffer != 0 ? GetHelpText(p_CmdId, helpText) : E_INVALIDARG;
+            if (SUCCEEDED(hRes) && p_BufferSize > 0) {
+                int converted = 0;
+                if (!helpText.empty()) {
+                    converted = ::WideCharToMultiByte(CP_ACP, 0, helpText.c_str(), static_cast<int>(helpText.size()),
+                                                      p_pBuffer, static_cast<int>(p_BufferSize - 1), nullptr, nullptr);
+                }
+                if (converted > 0 || helpText.empty()) {
+                    p_pBuffer[converted] = '\0';
                 } else {
                     hRes = E_FAIL;
                 }
+            } else if (SUCCEEDED(hRes)) {
+                hRes = E_FAIL;
             }
         } else if (p_Flags == GCS_HELPTEXTW) {
             // A Unicode help string is requested.
-            if (p_pBuffer != 0) {
-                // Try finding the plugin that handles this command ID.
-                CmdIdPluginM::const_iterator it = m_mPluginsByCmdId.end();
-                if (m_FirstCmdId.has_value()) {
-                    it = m_mPluginsByCmdId.find(*m_FirstCmdId + p_CmdId);
-                }
-                if (it != m_mPluginsByCmdId.end()) {
-                    // Found the plugin, ask for its help text.
-                    std::wstring helpText = it->second->HelpText();
-
-                    // Return help text.
-                    if (::wcscpy_s((LPWSTR) p_pBuffer, p_BufferSize, helpText.c_str()) != 0) {
-                        hRes = E_FAIL;
-                    }
-                } else {
-                    // Check for non-plugin menu items.
-                    if (m_FirstCmdId.has_value() && m_SubMenuCmdId.has_value() && (*m_FirstCmdId + p_CmdId) == *m_SubMenuCmdId) {
-                        // The sub-menu itself.
-                        ATL::CStringW subMenuHint(MAKEINTRESOURCEW(IDS_PATH_COPY_HINT));
-                        if (::wcscpy_s((LPWSTR) p_pBuffer, p_BufferSize, subMenuHint) != 0) {
-                            hRes = E_FAIL;
-                        }
-                    } else if (m_FirstCmdId.has_value() && m_SettingsCmdId.has_value() && (*m_FirstCmdId + p_CmdId) == *m_SettingsCmdId) {
-                        // The item to open the settings application.
-                        ATL::CStringW settingsHint(MAKEINTRESOURCEW(IDS_PCC_SETTINGS_HINT));
-                        if (::wcscpy_s((LPWSTR) p_pBuffer, p_BufferSize, settingsHint) != 0) {
-                            hRes = E_FAIL;
-                        }
-                    } else {
-                        hRes = E_INVALIDARG;
-                    }
-                }
-            } else {
-                hRes = E_INVALIDARG;
+            std::wstring helpText;
+            hRes = p_pBuffer != 0 ? GetHelpText(p_CmdId, helpText) : E_INVALIDARG;
+            if (SUCCEEDED(hRes) && ::wcscpy_s((LPWSTR) p_pBuffer, p_BufferSize, helpText.c_str()) != 0) {
+                hRes = E_FAIL;
             }
         } else {
             // Unknown, unsupported flag.
@@ -668,124 +1032,653 @@ STDMETHODIMP CPathCopyCopyContextMenuExt::GetCommandString(
 }
 
 //
-// Returns a reference to the object used to access user settings.
-// The object is created on the first call.
+// IContextMenu2::HandleMenuMsg
 //
-// @return Reference to settings object.
+// Invoked by the shell to let us handle messages related to our menu items.
+// Forwards to HandleMenuMsg2.
 //
-PCC::Settings& CPathCopyCopyContextMenuExt::GetSettings()
+// @param p_Msg Message to handle.
+// @param p_wParam Message WPARAM.
+// @param p_lParam Message LPARAM.
+// @return S_OK if successful, otherwise an error code.
+//
+STDMETHODIMP CPathCopyCopyContextMenuExt::HandleMenuMsg(
+    UINT p_Msg,
+    WPARAM p_wParam,
+    LPARAM p_lParam)
 {
-    // Create on first call.
-    if (m_spSettings == nullptr) {
-        m_spSettings = std::make_shared<PCC::Settings>();
-    }
-    return *m_spSettings;
+    LRESULT result = 0;
+    return HandleMenuMsg2(p_Msg, p_wParam, p_lParam, &result);
 }
 
 //
-// Adds a new item to the given menu (either the main contextual menu or
-// our submenu can be used) and assigns the given plugin to it. This will
-// be called multiple times by the QueryContextMenu method to fill in the
-// menu with all the items.
+// IContextMenu3::HandleMenuMsg2
 //
-// @param p_PluginId ID of plugin to add to the menu.
-// @param p_hMenu Handle of menu to add the item to.
-// @param p_UsePCCIcon Whether to use the PCC icon for this plugin.
-// @param p_UsePreviewMode Whether to use plugin result instead of
-//                         its description as caption in the menu.
-// @param p_DropRedundantWords Whether to drop redundant words in the plugin
-//                             description, like "copy".
-// @param p_ComputeShortcut Whether to compute the best shortcut for
-//                          the menu item according to existing menu items.
-// @param p_rCmdId Command ID to use for the item. Upon return, this
-//                 will be incremented to the next command ID to use.
-// @param p_rPosition Position where to insert the item in the menu.
-//                    Upon return, this will be incremented to the
-//                    next position to use.
-// @return Error code, or S_OK if the item was added to the menu.
+// Invoked by the shell to let us handle messages related to our menu items.
+// We use this to compute preview captions of submenu items only when
+// the submenu is about to be displayed, and to draw our items' icons
+// so that they are only loaded when actually displayed.
 //
-HRESULT CPathCopyCopyContextMenuExt::AddPluginToMenu(const GUID& p_PluginId,
-                                                     HMENU const p_hMenu,
-                                                     const bool p_UsePCCIcon,
-                                                     const bool p_UsePreviewMode,
-                                                     const bool p_DropRedundantWords,
-                                                     const bool p_ComputeShortcut,
-                                                     UINT& p_rCmdId,
-                                                     UINT& p_rPosition)
+// @param p_Msg Message to handle.
+// @param p_wParam Message WPARAM.
+// @param p_lParam Message LPARAM.
+// @param p_pResult Where to store the message result; can be nullptr.
+// @return S_OK if successful, otherwise an error code.
+//
+STDMETHODIMP CPathCopyCopyContextMenuExt::HandleMenuMsg2(
+    UINT p_Msg,
+    WPARAM p_wParam,
+    LPARAM p_lParam,
+    LRESULT* p_pResult)
 {
-    // Look for the plugin in the set of all plugins.
-    auto pluginIt = m_sspAllPlugins.find(p_PluginId);
+    HRESULT hRes = S_OK;
 
-    // If we have a plugin, continue.
-    HRESULT hRes = E_INVALIDARG;
-    if (pluginIt != m_sspAllPlugins.end()) {
-        hRes = AddPluginToMenu(*pluginIt, p_hMenu, p_UsePCCIcon, p_UsePreviewMode,
-            p_DropRedundantWords, p_ComputeShortcut, p_rCmdId, p_rPosition);
+    try {
+        LRESULT result = 0;
+        switch (p_Msg) {
+            case WM_INITMENUPOPUP: {
+                if (m_hPreviewSubMenu != NULL && reinterpret_cast<HMENU>(p_wParam) == m_hPreviewSubMenu) {
+                    UpdatePreviewCaptions();
+                } else if (m_mNestedSubMenus.find(reinterpret_cast<HMENU>(p_wParam)) != m_mNestedSubMenus.end()) {
+                    PopulateNestedSubMenu(reinterpret_cast<HMENU>(p_wParam));
+                }
+                break;
+            }
+            case WM_MEASUREITEM: {
+                // Provide size of the icon of one of our items.
+                MEASUREITEMSTRUCT* pMeasureItem = reinterpret_cast<MEASUREITEMSTRUCT*>(p_lParam);
+                if (pMeasureItem != nullptr && pMeasureItem->CtlType == ODT_MENU &&
+                    m_mIconFilesByItemId.find(pMeasureItem->itemID) != m_mIconFilesByItemId.end()) {
+
+                    pMeasureItem->itemWidth = static_cast<UINT>(::GetSystemMetrics(SM_CXSMICON));
+                    pMeasureItem->itemHeight = static_cast<UINT>(::GetSystemMetrics(SM_CYSMICON));
+                    result = TRUE;
+                }
+                break;
+            }
+            case WM_DRAWITEM: {
+                // Draw the icon of one of our items, loading it if needed.
+                DRAWITEMSTRUCT* pDrawItem = reinterpret_cast<DRAWITEMSTRUCT*>(p_lParam);
+                if (pDrawItem != nullptr && pDrawItem->CtlType == ODT_MENU) {
+                    auto iconIt = m_mIconFilesByItemId.find(pDrawItem->itemID);
+                    if (iconIt != m_mIconFilesByItemId.end()) {
+                        const SIZE iconSize = GetMenuIconSize(pDrawItem->hDC);
+                        HBITMAP hIconBitmap = GetMenuIcon(iconIt->second, iconSize);
+                        if (hIconBitmap != NULL) {
+                            DrawMenuIcon(pDrawItem->hDC, pDrawItem->rcItem, iconSize, hIconBitmap);
+                        }
+                        result = TRUE;
+                    }
+                }
+                break;
+            }
+        }
+        if (p_pResult != nullptr) {
+            *p_pResult = result;
+        }
+    } catch (...) {
+        hRes = E_UNEXPECTED;
     }
 
     return hRes;
 }
 
 //
-// Adds a new item to the given menu (either the main contextual menu or
-// our submenu can be used) and assigns the given plugin to it. This will
-// be called multiple times by the QueryContextMenu method to fill in the
-// menu with all the items.
+// Initializes the extension with files selected in the Shell. This is used
+// by the Explorer command, which gets files from a shell item array instead
+// of a data object.
 //
-// @param p_spPlugin Plugin to add to the menu.
-// @param p_hMenu Handle of menu to add the item to.
-// @param p_UsePCCIcon Whether to use the PCC icon for this plugin.
-// @param p_UsePreviewMode Whether to use plugin result instead of
-//                         its description as caption in the menu.
-// @param p_DropRedundantWords Whether to drop redundant words in the plugin
-//                             description, like "copy".
-// @param p_ComputeShortcut Whether to compute the best shortcut for
-//                          the menu item according to existing menu items.
-// @param p_rCmdId Command ID to use for the item. Upon return, this
-//                 will be incremented to the next command ID to use.
-// @param p_rPosition Position where to insert the item in the menu.
-//                    Upon return, this will be incremented to the
-//                    next position to use.
-// @return Error code, or S_OK if the item was added to the menu.
+// @param p_vFiles Files selected in the Shell.
+// @return S_OK if successful, otherwise an error code.
 //
-HRESULT CPathCopyCopyContextMenuExt::AddPluginToMenu(const PCC::PluginSP& p_spPlugin,
-                                                     HMENU const p_hMenu,
-                                                     const bool p_UsePCCIcon,
-                                                     const bool p_UsePreviewMode,
-                                                     const bool p_DropRedundantWords,
-                                                     const bool p_ComputeShortcut,
-                                                     UINT& p_rCmdId,
-                                                     UINT& p_rPosition)
+HRESULT CPathCopyCopyContextMenuExt::InitializeWithFiles(const PCC::FilesV& p_vFiles)
 {
     HRESULT hRes = S_OK;
 
-    // Check if plugin should be enabled.
-    const bool enabled = p_spPlugin->Enabled(m_ParentPath, m_vFiles.front());
-
-    // Compile info about the menu item using the plugin object.
-    std::wstring description;
-    if (p_UsePreviewMode && enabled) { // Disabled plugins don't work so can't use preview mode.
-        description = p_spPlugin->GetPath(m_vFiles.front());
-        // Let's limit the size of menu items if possible.
-        if (description.size() > MAX_PATH) {
-            description.resize(MAX_PATH);
-        }
-        // If path contains ampersands, they will be treated as shortcuts.
-        // We have to double them.
-        StringUtils::ReplaceAll(description, L"&", L"&&");
-    } else {
-        description = p_spPlugin->Description();
-        if (p_DropRedundantWords && p_spPlugin->CanDropRedundantWords()) {
-            ATL::CStringW redundantCopy(MAKEINTRESOURCEW(IDS_REDUNDANT_WORD_COPY));
-            if (description.size() >= static_cast<std::wstring::size_type>(redundantCopy.GetLength()) &&
-                ::_wcsnicmp(description.c_str(), (LPCWSTR) redundantCopy, static_cast<size_t>(redundantCopy.GetLength())) == 0) {
-
-                // The description starts with "Copy ", drop it.
-                description.erase(0, static_cast<std::wstring::size_type>(redundantCopy.GetLength()));
-            }
-        }
-        if (p_ComputeShortcut) {
-            description = GetMenuCaptionWithShortcut(p_hMenu, description);
+    try {
+        if (!p_vFiles.empty()) {
+            m_Files = PCC::FileSelection(p_vFiles);
+            m_FileCount = static_cast<UINT>(p_vFiles.size());
+            m_spDataObject.Release();
+            m_ParentPath = m_Files.GetFile(0);
+            PCC::PluginUtils::ExtractFolderFromPath(m_ParentPath);
+        } else {
+            hRes = E_INVALIDARG;
+        }
+    } catch (...) {
+        hRes = E_UNEXPECTED;
+    }
+
+    return hRes;
+}
+
+//
+// Performs the default action of a plugin on the files we were initialized
+// with. This is used by the Explorer command when the user picks a plugin.
+//
+// @param p_PluginId ID of plugin to apply.
+// @param p_hWnd Handle to parent window, that can be used for
+//               message boxes, etc.
+// @return Result code.
+//
+HRESULT CPathCopyCopyContextMenuExt::ActOnFilesWithPlugin(const GUID& p_PluginId,
+                                                          HWND p_hWnd)
+{
+    HRESULT hRes = E_INVALIDARG;
+
+    try {
+        if (m_spPluginsSnapshot == nullptr) {
+            m_spPluginsSnapshot = PCC::PluginsSnapshot::Get();
+        }
+        const PCC::PluginSPS& sspAllPlugins = m_spPluginsSnapshot->GetAllPlugins();
+        auto pluginIt = sspAllPlugins.find(p_PluginId);
+        if (pluginIt != sspAllPlugins.end() && !(*pluginIt)->IsSeparator() && !m_Files.Empty()) {
+            hRes = ActOnFiles(*pluginIt, p_hWnd);
+        }
+    } catch (...) {
+        hRes = E_UNEXPECTED;
+    }
+
+    return hRes;
+}
+
+//
+// Checks if the user held down the Ctrl key while opening the menu and we
+// have a plugin to use when this happens. If so, uses that plugin on the
+// files right away. Unless plugins are already loaded, only that plugin and
+// the plugins it references are loaded, since the menu won't be built.
+//
+// @return true if the Ctrl key plugin has been used.
+//
+bool CPathCopyCopyContextMenuExt::ActOnFilesWithCtrlKeyPlugin()
+{
+    bool acted = false;
+
+    GUID ctrlKeyPluginId;
+    if ((::GetKeyState(VK_CONTROL) & 0x8000) != 0 && GetSettings().GetCtrlKeyPlugin(ctrlKeyPluginId)) {
+        PCC::PluginsSnapshotSP spPluginsSnapshot = PCC::PluginsSnapshot::GetForPlugin(ctrlKeyPluginId);
+        const PCC::PluginSPS& sspAllPlugins = spPluginsSnapshot->GetAllPlugins();
+        auto pluginIt = sspAllPlugins.find(ctrlKeyPluginId);
+        if (pluginIt != sspAllPlugins.end() && !(*pluginIt)->IsSeparator()) {
+            m_spPluginsSnapshot = spPluginsSnapshot;
+            m_spPluginsSnapshot->ClearCachedPaths();
+            ActOnFiles(*pluginIt, NULL);
+            acted = true;
+        }
+    }
+
+    return acted;
+}
+
+//
+// Starts prefetching the information our menu will need on a worker thread:
+// network information used by plugins computing network paths, the enabled
+// states of plugins that can be evaluated concurrently and, if preview mode
+// is used, their previews. QueryContextMenu and GetFirstFilePath then use
+// whatever has been computed by the time they need it. Nothing is prefetched
+// if the user holds down Ctrl to use the Ctrl key plugin, or if prewarming
+// caches has been turned off in the settings.
+//
+void CPathCopyCopyContextMenuExt::StartMenuPrefetch()
+{
+    CancelMenuPrefetch();
+    PCC::Settings& rSettings = GetSettings();
+    GUID ctrlKeyPluginId;
+    if (m_Files.Empty() || !rSettings.GetPrewarmCaches() ||
+        ((::GetKeyState(VK_CONTROL) & 0x8000) != 0 && rSettings.GetCtrlKeyPlugin(ctrlKeyPluginId))) {
+
+        return;
+    }
+
+    auto spPrefetch = std::make_shared<MenuPrefetch>();
+    spPrefetch->m_spPluginsSnapshot = PCC::PluginsSnapshot::Get();
+    spPrefetch->m_ParentPath = m_ParentPath;
+    spPrefetch->m_File = m_Files.GetFile(0);
+    spPrefetch->m_EnabledStatesCompleted = false;
+    spPrefetch->m_Cancelled = false;
+    auto addPlugins = [&](const PCC::PluginSPV& p_vspPlugins, const bool p_ComputePreviews, const bool p_SkipNested) {
+        for (const PCC::PluginSP& spPlugin : p_vspPlugins) {
+            if (!spPlugin->IsSeparator() && (!p_SkipNested || spPlugin->MenuFolder().empty()) &&
+                spPlugin->CanGetPathsConcurrently(spPrefetch->m_spPluginsSnapshot->GetConversionContext())) {
+
+                spPrefetch->m_vspPlugins.push_back(spPlugin);
+                if (p_ComputePreviews) {
+                    spPrefetch->m_vspPreviewPlugins.push_back(spPlugin);
+                }
+            }
+        }
+    };
+    addPlugins(spPrefetch->m_spPluginsSnapshot->GetMainMenuPlugins(), rSettings.GetUsePreviewModeInMainMenu(), false);
+    // Plugins in nested submenus are only evaluated if their submenu is opened.
+    addPlugins(spPrefetch->m_spPluginsSnapshot->GetSubmenuPlugins(), rSettings.GetUsePreviewMode(), true);
+
+    auto prefetch = [](const MenuPrefetchSP p_spPrefetch) {
+        try {
+            PCC::StTraceEvent traceEvent(L"ContextMenuExt::MenuPrefetch");
+            traceEvent.SetCount(p_spPrefetch->m_vspPlugins.size());
+            const PCC::ConversionContext& context = p_spPrefetch->m_spPluginsSnapshot->GetConversionContext();
+
+            // Load network information and the mapping of the file's drive, if any.
+            PCC::PluginUtils::PrewarmNetworkCaches();
+            std::wstring mappedFile = p_spPrefetch->m_File;
+            PCC::PluginUtils::GetMappedDriveFilePath(mappedFile);
+
+            auto cancelled = [&]() {
+                std::lock_guard<std::mutex> lock(p_spPrefetch->m_Lock);
+                return p_spPrefetch->m_Cancelled;
+            };
+            for (const PCC::PluginSP& spPlugin : p_spPrefetch->m_vspPlugins) {
+                if (cancelled()) {
+                    break;
+                }
+                bool enabled = false;
+                try {
+                    PCC::StTraceEvent pluginTraceEvent(L"Plugin::Enabled", &spPlugin->Id());
+                    enabled = PCC::PluginStatistics::Measure(spPlugin->Id(), PCC::PluginStatistics::Operation::Enabled, [&]() {
+                        return spPlugin->Enabled(p_spPrefetch->m_ParentPath, p_spPrefetch->m_File, context);
+                    });
+                } catch (...) {
+                    // Consider plugin disabled if it cannot tell.
+                }
+                std::lock_guard<std::mutex> lock(p_spPrefetch->m_Lock);
+                p_spPrefetch->m_mPluginsEnabled.emplace(spPlugin, enabled);
+            }
+            {
+                std::lock_guard<std::mutex> lock(p_spPrefetch->m_Lock);
+                p_spPrefetch->m_EnabledStatesCompleted = true;
+                p_spPrefetch->m_EnabledStatesCompletedCond.notify_all();
+            }
+
+            // Disabled plugins don't work so can't use preview mode.
+            for (const PCC::PluginSP& spPlugin : p_spPrefetch->m_vspPreviewPlugins) {
+                bool enabled = false;
+                {
+                    std::lock_guard<std::mutex> lock(p_spPrefetch->m_Lock);
+                    if (p_spPrefetch->m_Cancelled) {
+                        break;
+                    }
+                    auto enabledIt = p_spPrefetch->m_mPluginsEnabled.find(spPlugin);
+                    enabled = enabledIt != p_spPrefetch->m_mPluginsEnabled.end() && enabledIt->second;
+                }
+                if (enabled) {
+                    PCC::StTraceEvent pluginTraceEvent(L"Plugin::GetPath", &spPlugin->Id());
+                    pluginTraceEvent.SetCount(1);
+                    std::wstring path = PCC::PluginStatistics::Measure(spPlugin->Id(), PCC::PluginStatistics::Operation::GetPath, [&]() {
+                        return PCC::PluginUtils::GetPathCached(*spPlugin, p_spPrefetch->m_File, context);
+                    });
+                    std::lock_guard<std::mutex> lock(p_spPrefetch->m_Lock);
+                    p_spPrefetch->m_mFirstFilePaths.emplace(spPlugin, std::move(path));
+                }
+            }
+        } catch (...) {
+            // Prefetching is optional; the menu will compute what's missing.
+        }
+        {
+            std::lock_guard<std::mutex> lock(p_spPrefetch->m_Lock);
+            p_spPrefetch->m_EnabledStatesCompleted = true;
+            p_spPrefetch->m_EnabledStatesCompletedCond.notify_all();
+        }
+    };
+
+    try {
+        spPrefetch->m_spTask = PCC::ThreadPool::Submit(std::bind(prefetch, spPrefetch), PCC::ThreadPool::Priority::Normal);
+        m_spMenuPrefetch = spPrefetch;
+    } catch (...) {
+        // Menu will compute everything itself.
+    }
+}
+
+//
+// Fetches the enabled states of plugins evaluated by our prefetch and stores
+// them in m_mPluginsEnabled. If the prefetch is still evaluating plugins, waits
+// for it, but not past our deadline for evaluating plugins; plugins it has not
+// evaluated by then will be evaluated by EvaluatePluginsEnabled.
+//
+void CPathCopyCopyContextMenuExt::ConsumePrefetchedEnabledStates()
+{
+    if (m_spMenuPrefetch != nullptr) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(ENABLED_STATES_DEADLINE_MS);
+        if (m_MenuDeadline.has_value()) {
+            deadline = (std::min)(deadline, *m_MenuDeadline);
+        }
+        std::unique_lock<std::mutex> lock(m_spMenuPrefetch->m_Lock);
+        m_spMenuPrefetch->m_EnabledStatesCompletedCond.wait_until(lock, deadline, [&]() {
+            return m_spMenuPrefetch->m_EnabledStatesCompleted;
+        });
+        m_mPluginsEnabled.insert(m_spMenuPrefetch->m_mPluginsEnabled.cbegin(), m_spMenuPrefetch->m_mPluginsEnabled.cend());
+    }
+}
+
+//
+// Fetches the enabled states of plugins and the previews computed when our
+// menu was last built for the same selection, if recently enough, and stores
+// them in m_mPluginsEnabled and m_mFirstFilePaths. Information already there
+// is left untouched. See MenuTemplateCache for details.
+//
+void CPathCopyCopyContextMenuExt::LoadMenuTemplate()
+{
+    PCC::MenuTemplateCache::PluginEnabledM mEnabled;
+    PCC::MenuTemplateCache::PluginPathM mFirstFilePaths;
+    if (PCC::MenuTemplateCache::Get(m_Files.GetFile(0), m_FileCount, m_spPluginsSnapshot->GetGeneration(), mEnabled, mFirstFilePaths)) {
+        // Templates identify plugins by ID; map them back to our snapshot's plugins.
+        for (const PCC::PluginSP& spPlugin : m_spPluginsSnapshot->GetAllPlugins()) {
+            if (!spPlugin->IsSeparator()) {
+                auto enabledIt = mEnabled.find(spPlugin->Id());
+                if (enabledIt != mEnabled.end()) {
+                    m_mPluginsEnabled.emplace(spPlugin, enabledIt->second);
+                }
+                auto pathIt = mFirstFilePaths.find(spPlugin->Id());
+                if (pathIt != mFirstFilePaths.end()) {
+                    m_mFirstFilePaths.emplace(spPlugin, pathIt->second);
+                }
+            }
+        }
+    }
+}
+
+//
+// Stores the enabled states of plugins and the previews computed so far in
+// the menu template cache, so that they can be reused if the shell builds
+// our menu again for the same selection.
+//
+void CPathCopyCopyContextMenuExt::StoreMenuTemplate() const
+{
+    PCC::MenuTemplateCache::PluginEnabledM mEnabled;
+    for (const auto& enabled : m_mPluginsEnabled) {
+        mEnabled.emplace(enabled.first->Id(), enabled.second);
+    }
+    PCC::MenuTemplateCache::PluginPathM mFirstFilePaths;
+    for (const auto& path : m_mFirstFilePaths) {
+        mFirstFilePaths.emplace(path.first->Id(), path.second);
+    }
+    PCC::MenuTemplateCache::Update(m_Files.GetFile(0), m_FileCount, m_spPluginsSnapshot->GetGeneration(), mEnabled, mFirstFilePaths);
+}
+
+//
+// Cancels our prefetch, if any. The worker thread will stop once it is done
+// with the plugin it's currently evaluating.
+//
+void CPathCopyCopyContextMenuExt::CancelMenuPrefetch()
+{
+    if (m_spMenuPrefetch != nullptr) {
+        std::lock_guard<std::mutex> lock(m_spMenuPrefetch->m_Lock);
+        m_spMenuPrefetch->m_Cancelled = true;
+        if (m_spMenuPrefetch->m_spTask != nullptr) {
+            m_spMenuPrefetch->m_spTask->Cancel();
+        }
+    }
+    m_spMenuPrefetch.reset();
+}
+
+//
+// Starts converting the selected files on a worker thread with the plugin
+// the user is most likely to pick in our menu: the plugin last used, if it's
+// in the menu, otherwise the first plugin of the menu. If that plugin is then
+// picked, ActOnFiles uses the converted paths instead of computing them.
+// Only large selections are converted, since the path of single files has
+// usually been computed for previews already. Plugins that cannot compute
+// paths concurrently are skipped, since they must be used on this thread.
+//
+void CPathCopyCopyContextMenuExt::StartSpeculativeConversion()
+{
+    CancelSpeculativeConversion();
+    if (m_FileCount <= 1 || m_vspPluginsByCmdOffset.empty() || MenuBudgetExceeded()) {
+        return;
+    }
+
+    GUID lastUsedPluginId;
+    {
+        std::lock_guard<PCC::MeasuredMutex> lock(s_LastUsedPluginLock);
+        lastUsedPluginId = s_LastUsedPluginId;
+    }
+    PCC::PluginSP spPlugin;
+    for (const PCC::PluginSP& spMenuPlugin : m_vspPluginsByCmdOffset) {
+        if (spMenuPlugin != nullptr) {
+            if (spPlugin == nullptr) {
+                spPlugin = spMenuPlugin;
+            }
+            if (::IsEqualGUID(spMenuPlugin->Id(), lastUsedPluginId)) {
+                spPlugin = spMenuPlugin;
+                break;
+            }
+        }
+    }
+    auto enabledIt = m_mPluginsEnabled.find(spPlugin);
+    if (spPlugin == nullptr || !spPlugin->CanGetPathsConcurrently(GetConversionContext()) ||
+        (enabledIt != m_mPluginsEnabled.end() && !enabledIt->second)) {
+
+        return;
+    }
+
+    auto spConversion = std::make_shared<SpeculativeConversion>();
+    spConversion->m_spPluginsSnapshot = m_spPluginsSnapshot;
+    spConversion->m_spPlugin = spPlugin;
+    spConversion->m_Files = GetSelectedFiles();
+    spConversion->m_Completed = false;
+    spConversion->m_Succeeded = false;
+    spConversion->m_Cancelled = false;
+
+    // Files are converted in batches so that we can stop early if the conversion is cancelled.
+    auto convert = [](const SpeculativeConversionSP p_spConversion) {
+        PCC::WStringV vPaths;
+        bool succeeded = false;
+        try {
+            PCC::StTraceEvent traceEvent(L"ContextMenuExt::SpeculativeConversion", &p_spConversion->m_spPlugin->Id());
+            traceEvent.SetCount(p_spConversion->m_Files.Size());
+            PCC::FileMetadataCache metadataCache;
+            metadataCache.Prefetch(p_spConversion->m_Files);
+            const PCC::ConversionContext context(p_spConversion->m_spPluginsSnapshot->GetConversionContext(), &metadataCache);
+            const PCC::FileSelection& files = p_spConversion->m_Files;
+            vPaths.reserve(files.Size());
+            PCC::FilesV vBatch;
+            bool cancelled = false;
+            for (size_t first = 0; !cancelled && first < files.Size(); first += SPECULATIVE_BATCH_SIZE) {
+                files.GetFiles(first, SPECULATIVE_BATCH_SIZE, vBatch);
+                PCC::WStringV vBatchPaths = PCC::PluginUtils::GetPathsInParallel(*p_spConversion->m_spPlugin, vBatch, context);
+                if (vBatchPaths.size() != vBatch.size()) {
+                    break;
+                }
+                vPaths.insert(vPaths.end(), vBatchPaths.begin(), vBatchPaths.end());
+                std::lock_guard<std::mutex> lock(p_spConversion->m_Lock);
+                cancelled = p_spConversion->m_Cancelled;
+            }
+            succeeded = !cancelled && vPaths.size() == files.Size();
+        } catch (...) {
+            // Paths will be computed again if the plugin is picked.
+        }
+        {
+            std::lock_guard<std::mutex> lock(p_spConversion->m_Lock);
+            if (succeeded) {
+                p_spConversion->m_vPaths.swap(vPaths);
+            }
+            p_spConversion->m_Succeeded = succeeded;
+            p_spConversion->m_Completed = true;
+            p_spConversion->m_CompletedCond.notify_all();
+        }
+    };
+
+    try {
+        spConversion->m_spTask = PCC::ThreadPool::Submit(std::bind(convert, spConversion), PCC::ThreadPool::Priority::Low);
+        m_spSpeculativeConversion = spConversion;
+    } catch (...) {
+        // Files will be converted if the plugin is picked.
+    }
+}
+
+//
+// Fetches the paths computed by our speculative conversion, if it's been
+// started with the given plugin. If the conversion is still running, waits
+// for it to complete, since it's ahead of any conversion we could start now.
+// If another plugin is given, the speculative conversion is cancelled.
+//
+// @param p_spPlugin Plugin picked by the user.
+// @param p_rvPaths Where to store the converted paths.
+// @return true if paths were stored in p_rvPaths.
+//
+bool CPathCopyCopyContextMenuExt::ConsumeSpeculativeConversion(const PCC::PluginSP& p_spPlugin,
+                                                               PCC::WStringV& p_rvPaths)
+{
+    bool consumed = false;
+    if (m_spSpeculativeConversion != nullptr && p_spPlugin != nullptr &&
+        m_spSpeculativeConversion->m_spPlugin == p_spPlugin) {
+
+        SpeculativeConversionSP spConversion;
+        spConversion.swap(m_spSpeculativeConversion);
+        PCC::StTraceEvent traceEvent(L"ContextMenuExt::ConsumeSpeculativeConversion", &p_spPlugin->Id());
+        std::unique_lock<std::mutex> lock(spConversion->m_Lock);
+        spConversion->m_CompletedCond.wait(lock, [&]() { return spConversion->m_Completed; });
+        if (spConversion->m_Succeeded) {
+            p_rvPaths.swap(spConversion->m_vPaths);
+            consumed = true;
+        }
+    } else {
+        CancelSpeculativeConversion();
+    }
+    return consumed;
+}
+
+//
+// Cancels our speculative conversion, if any. The worker thread
+// will stop converting files once it completes its current batch.
+//
+void CPathCopyCopyContextMenuExt::CancelSpeculativeConversion()
+{
+    if (m_spSpeculativeConversion != nullptr) {
+        std::lock_guard<std::mutex> lock(m_spSpeculativeConversion->m_Lock);
+        m_spSpeculativeConversion->m_Cancelled = true;
+        if (m_spSpeculativeConversion->m_spTask != nullptr) {
+            m_spSpeculativeConversion->m_spTask->Cancel();
+        }
+    }
+    m_spSpeculativeConversion.reset();
+}
+
+//
+// Returns a reference to the object used to access user settings.
+// The object is created on the first call.
+//
+// @return Reference to settings object.
+//
+PCC::Settings& CPathCopyCopyContextMenuExt::GetSettings()
+{
+    // Create on first call. Since we read many settings while our menu is
+    // used, load them all at once instead of querying the registry for each one.
+    if (m_spSettings == nullptr) {
+        m_spSettings = std::make_shared<PCC::Settings>();
+        m_spSettings->Snapshot();
+    }
+    return *m_spSettings;
+}
+
+//
+// Adds a new item to the given menu (either the main contextual menu or
+// our submenu can be used) and assigns the given plugin to it. This will
+// be called multiple times by the QueryContextMenu method to fill in the
+// menu with all the items.
+//
+// @param p_PluginId ID of plugin to add to the menu.
+// @param p_hMenu Handle of menu to add the item to.
+// @param p_UsePCCIcon Whether to use the PCC icon for this plugin.
+// @param p_UsePreviewMode Whether to use plugin result instead of
+//                         its description as caption in the menu.
+// @param p_DropRedundantWords Whether to drop redundant words in the plugin
+//                             description, like "copy".
+// @param p_ComputeShortcut Whether to compute the best shortcut for
+//                          the menu item according to existing menu items.
+// @param p_rCmdId Command ID to use for the item. Upon return, this
+//                 will be incremented to the next command ID to use.
+// @param p_rPosition Position where to insert the item in the menu.
+//                    Upon return, this will be incremented to the
+//                    next position to use.
+// @return Error code, or S_OK if the item was added to the menu.
+//
+HRESULT CPathCopyCopyContextMenuExt::AddPluginToMenu(const GUID& p_PluginId,
+                                                     HMENU const p_hMenu,
+                                                     const bool p_UsePCCIcon,
+                                                     const bool p_UsePreviewMode,
+                                                     const bool p_DropRedundantWords,
+                                                     const bool p_ComputeShortcut,
+                                                     UINT& p_rCmdId,
+                                                     UINT& p_rPosition)
+{
+    // Look for the plugin in the set of all plugins.
+    const PCC::PluginSPS& sspAllPlugins = m_spPluginsSnapshot->GetAllPlugins();
+    auto pluginIt = sspAllPlugins.find(p_PluginId);
+
+    // If we have a plugin, continue.
+    HRESULT hRes = E_INVALIDARG;
+    if (pluginIt != sspAllPlugins.end()) {
+        hRes = AddPluginToMenu(*pluginIt, p_hMenu, p_UsePCCIcon, p_UsePreviewMode,
+            p_DropRedundantWords, p_ComputeShortcut, p_rCmdId, p_rPosition);
+    }
+
+    return hRes;
+}
+
+//
+// Adds a new item to the given menu (either the main contextual menu or
+// our submenu can be used) and assigns the given plugin to it. This will
+// be called multiple times by the QueryContextMenu method to fill in the
+// menu with all the items.
+//
+// @param p_spPlugin Plugin to add to the menu.
+// @param p_hMenu Handle of menu to add the item to.
+// @param p_UsePCCIcon Whether to use the PCC icon for this plugin.
+// @param p_UsePreviewMode Whether to use plugin result instead of
+//                         its description as caption in the menu.
+// @param p_DropRedundantWords Whether to drop redundant words in the plugin
+//                             description, like "copy".
+// @param p_ComputeShortcut Whether to compute the best shortcut for
+//                          the menu item according to existing menu items.
+// @param p_rCmdId Command ID to use for the item. Upon return, this
+//                 will be incremented to the next command ID to use.
+// @param p_rPosition Position where to insert the item in the menu.
+//                    Upon return, this will be incremented to the
+//                    next position to use.
+// @return Error code, or S_OK if the item was added to the menu.
+//
+HRESULT CPathCopyCopyContextMenuExt::AddPluginToMenu(const PCC::PluginSP& p_spPlugin,
+                                                     HMENU const p_hMenu,
+                                                     const bool p_UsePCCIcon,
+                                                     const bool p_UsePreviewMode,
+                                                     const bool p_DropRedundantWords,
+                                                     const bool p_ComputeShortcut,
+                                                     UINT& p_rCmdId,
+                                                     UINT& p_rPosition)
+{
+    HRESULT hRes = S_OK;
+
+    // Check if plugin should be enabled. This has usually been evaluated beforehand.
+    // If we're out of time, assume the plugin is enabled rather than asking it.
+    bool enabled = true;
+    auto enabledIt = m_mPluginsEnabled.find(p_spPlugin);
+    if (enabledIt != m_mPluginsEnabled.end()) {
+        enabled = enabledIt->second;
+    } else if (!MenuBudgetExceeded()) {
+        PCC::StTraceEvent traceEvent(L"Plugin::Enabled", &p_spPlugin->Id());
+        enabled = PCC::PluginStatistics::Measure(p_spPlugin->Id(), PCC::PluginStatistics::Operation::Enabled, [&]() {
+            return p_spPlugin->Enabled(m_ParentPath, m_Files.GetFile(0), GetConversionContext());
+        });
+    }
+
+    // Compile info about the menu item using the plugin object.
+    // Previews are skipped if we're out of time, since computing paths can be slow.
+    std::wstring description;
+    if (p_UsePreviewMode && enabled && !MenuBudgetExceeded()) { // Disabled plugins don't work so can't use preview mode.
+        description = GetPreviewCaption(p_spPlugin);
+    } else {
+        description = p_spPlugin->Description(GetConversionContext());
+        if (p_DropRedundantWords && p_spPlugin->CanDropRedundantWords()) {
+            ATL::CStringW redundantCopy(MAKEINTRESOURCEW(IDS_REDUNDANT_WORD_COPY));
+            if (description.size() >= static_cast<std::wstring::size_type>(redundantCopy.GetLength()) &&
+                ::_wcsnicmp(description.c_str(), (LPCWSTR) redundantCopy, static_cast<size_t>(redundantCopy.GetLength())) == 0) {
+
+                // The description starts with "Copy ", drop it.
+                description.erase(0, static_cast<std::wstring::size_type>(redundantCopy.GetLength()));
+            }
+        }
+        if (p_ComputeShortcut) {
+            description = GetMenuCaptionWithShortcut(description);
         }
     }
     MENUITEMINFOW menuItemInfo;
@@ -795,35 +1688,41 @@ HRESULT CPathCopyCopyContextMenuExt::AddPluginToMenu(const PCC::PluginSP& p_spPl
     menuItemInfo.fState = enabled ? MFS_ENABLED : MFS_DISABLED;
     menuItemInfo.wID = p_rCmdId;
     menuItemInfo.dwTypeData = const_cast<LPWSTR>(description.c_str());
-    HBITMAP hIconBitmap = NULL;
+    // Determine which icon to use, if any (an empty icon file means the PCC icon).
+    // Icons are not loaded now; they will be when the item is drawn (see HandleMenuMsg2).
+    // If we're out of time, skip icon files since loading them can be slow.
+    cl::optional<std::wstring> iconFile;
     if (p_UsePCCIcon || p_spPlugin->UseDefaultIcon()) {
-        hIconBitmap = GetPCCIcon();
-    } else {
-        std::wstring iconFile = p_spPlugin->IconFile();
-        if (!iconFile.empty()) {
-            hIconBitmap = GetIconForIconFile(iconFile);
+        iconFile = std::wstring();
+    } else if (!MenuBudgetExceeded()) {
+        std::wstring pluginIconFile = p_spPlugin->IconFile();
+        if (!pluginIconFile.empty()) {
+            iconFile = pluginIconFile;
         } else {
-            auto possibleIconFile = GetSettings().GetIconFileForPlugin(p_spPlugin->Id());
-            if (possibleIconFile.has_value()) {
-                if (possibleIconFile->empty()) {
-                    hIconBitmap = GetPCCIcon();
-                } else {
-                    hIconBitmap = GetIconForIconFile(*possibleIconFile);
-                }
-            }
+            iconFile = m_spPluginsSnapshot != nullptr
+                ? m_spPluginsSnapshot->GetSettingsSnapshot().GetIconFileForPlugin(p_spPlugin->Id())
+                : GetSettings().GetIconFileForPlugin(p_spPlugin->Id());
         }
     }
-    if (hIconBitmap != NULL) {
+    if (iconFile.has_value()) {
         menuItemInfo.fMask |= MIIM_BITMAP;
-        menuItemInfo.hbmpItem = hIconBitmap;
+        menuItemInfo.hbmpItem = HBMMENU_CALLBACK;
+        m_mIconFilesByItemId[p_rCmdId] = *iconFile;
     }
 
     // Insert the item in the menu.
     if (::InsertMenuItemW(p_hMenu, p_rPosition, TRUE, &menuItemInfo)) {
-        m_mPluginsByCmdId[p_rCmdId] = p_spPlugin;
+        if (p_ComputeShortcut && enabled) {
+            MarkMenuShortcutUsed(description);
+        }
         if (!m_FirstCmdId.has_value()) {
             m_FirstCmdId = static_cast<UINT_PTR>(p_rCmdId);
         }
+        const size_t cmdOffset = static_cast<size_t>(p_rCmdId - *m_FirstCmdId);
+        if (m_vspPluginsByCmdOffset.size() <= cmdOffset) {
+            m_vspPluginsByCmdOffset.resize(cmdOffset + 1);
+        }
+        m_vspPluginsByCmdOffset[cmdOffset] = p_spPlugin;
         ++p_rCmdId;
         ++p_rPosition;
     } else {
@@ -834,17 +1733,284 @@ HRESULT CPathCopyCopyContextMenuExt::AddPluginToMenu(const PCC::PluginSP& p_spPl
 }
 
 //
-// Returns a caption usable for a menu item, with the first shortcut available.
+// Returns the help text to display for a menu command. For plugins, help
+// texts are cached by the plugins snapshot, since the shell asks for them
+// every time the user hovers over a menu item.
+//
+// @param p_CmdOffset Offset of the command ID, relative to our first command ID.
+// @param p_rHelpText Where to store the help text.
+// @return S_OK if successful, E_INVALIDARG if command is not one of ours.
+//
+HRESULT CPathCopyCopyContextMenuExt::GetHelpText(const UINT_PTR p_CmdOffset,
+                                                 std::wstring& p_rHelpText) const
+{
+    HRESULT hRes = S_OK;
+
+    // Try finding the plugin that handles this command ID.
+    PCC::PluginSP spPlugin = GetPluginByCmdOffset(p_CmdOffset);
+    if (spPlugin != nullptr) {
+        p_rHelpText = m_spPluginsSnapshot != nullptr ? m_spPluginsSnapshot->GetHelpText(*spPlugin)
+                                                     : spPlugin->HelpText();
+    } else if (m_FirstCmdId.has_value() && m_SubMenuCmdId.has_value() && (*m_FirstCmdId + p_CmdOffset) == *m_SubMenuCmdId) {
+        // The sub-menu itself.
+        p_rHelpText = ATL::CStringW(MAKEINTRESOURCEW(IDS_PATH_COPY_HINT));
+    } else if (m_FirstCmdId.has_value() && m_SettingsCmdId.has_value() && (*m_FirstCmdId + p_CmdOffset) == *m_SettingsCmdId) {
+        // The item to open the settings application.
+        p_rHelpText = ATL::CStringW(MAKEINTRESOURCEW(IDS_PCC_SETTINGS_HINT));
+    } else {
+        hRes = E_INVALIDARG;
+    }
+
+    return hRes;
+}
+
+//
+// Returns the plugin associated with a menu command.
+//
+// @param p_CmdOffset Offset of the command ID, relative to our first command ID.
+// @return Plugin associated with that command, or nullptr if command is not a plugin.
+//
+PCC::PluginSP CPathCopyCopyContextMenuExt::GetPluginByCmdOffset(const UINT_PTR p_CmdOffset) const
+{
+    PCC::PluginSP spPlugin;
+    if (p_CmdOffset < m_vspPluginsByCmdOffset.size()) {
+        spPlugin = m_vspPluginsByCmdOffset[p_CmdOffset];
+    }
+    return spPlugin;
+}
+
+//
+// Checks whether building the menu has exceeded its time budget. Once
+// this returns true, it will keep returning true for the rest of the build.
+//
+// @return true if we're out of time and should degrade the menu.
+//
+bool CPathCopyCopyContextMenuExt::MenuBudgetExceeded()
+{
+    if (!m_MenuBudgetExceeded && m_MenuDeadline.has_value() && std::chrono::steady_clock::now() >= *m_MenuDeadline) {
+        PCC::StTraceEvent traceEvent(L"ContextMenuExt::MenuBudgetExceeded");
+        m_MenuBudgetExceeded = true;
+    }
+    return m_MenuBudgetExceeded;
+}
+
+//
+// Determines which of the given plugins should be enabled in the menu and
+// stores the results in m_mPluginsEnabled. Plugins can take a while to
+// determine this (for example, UNC plugins need to query the network),
+// so plugins that support it are evaluated concurrently on worker threads.
+// Plugins that do not reply before a deadline are assumed to be enabled,
+// so that a single slow plugin cannot block the menu. Plugins are not
+// evaluated at all once the menu's time budget has been exceeded.
+//
+// @param p_vspPlugins Plugins to evaluate. Separators are skipped.
+//
+void CPathCopyCopyContextMenuExt::EvaluatePluginsEnabled(const PCC::PluginSPV& p_vspPlugins)
+{
+    if (MenuBudgetExceeded()) {
+        return;
+    }
+
+    // Split plugins between those that can be evaluated on worker threads and the others.
+    // Plugins that only manipulate strings are cheaper to evaluate than to hand off.
+    const PCC::ConversionContext context = GetConversionContext();
+    auto spEvaluation = std::make_shared<EnabledStatesEvaluation>();
+    PCC::PluginSPV vspLocalPlugins;
+    for (const PCC::PluginSP& spPlugin : p_vspPlugins) {
+        if (!spPlugin->IsSeparator() && m_mPluginsEnabled.find(spPlugin) == m_mPluginsEnabled.end()) {
+            if (spPlugin->CanGetPathsConcurrently(context) && spPlugin->CostClass(context) != PCC::PluginCost::Pure) {
+                spEvaluation->m_vspPlugins.push_back(spPlugin);
+            } else {
+                vspLocalPlugins.push_back(spPlugin);
+            }
+        }
+    }
+
+    // Submit tasks to the thread pool to evaluate concurrent plugins.
+    if (!spEvaluation->m_vspPlugins.empty()) {
+        spEvaluation->m_spPluginsSnapshot = m_spPluginsSnapshot;
+        spEvaluation->m_ParentPath = m_ParentPath;
+        spEvaluation->m_File = m_Files.GetFile(0);
+        spEvaluation->m_vEnabled.resize(spEvaluation->m_vspPlugins.size());
+        spEvaluation->m_NextPlugin = 0;
+        spEvaluation->m_Remaining = spEvaluation->m_vspPlugins.size();
+
+        auto evaluatePlugins = [](const std::shared_ptr<EnabledStatesEvaluation> p_spEvaluation) {
+            std::unique_lock<std::mutex> lock(p_spEvaluation->m_Lock);
+            while (p_spEvaluation->m_NextPlugin < p_spEvaluation->m_vspPlugins.size()) {
+                const size_t pluginIndex = p_spEvaluation->m_NextPlugin++;
+                lock.unlock();
+                bool enabled = false;
+                try {
+                    const PCC::PluginSP& spPlugin = p_spEvaluation->m_vspPlugins[pluginIndex];
+                    PCC::StTraceEvent traceEvent(L"Plugin::Enabled", &spPlugin->Id());
+                    enabled = PCC::PluginStatistics::Measure(spPlugin->Id(), PCC::PluginStatistics::Operation::Enabled, [&]() {
+                        return spPlugin->Enabled(p_spEvaluation->m_ParentPath, p_spEvaluation->m_File,
+                                                 p_spEvaluation->m_spPluginsSnapshot->GetConversionContext());
+                    });
+                } catch (...) {
+                    // Consider plugin disabled if it cannot tell.
+                }
+                lock.lock();
+                p_spEvaluation->m_vEnabled[pluginIndex] = enabled;
+                if (--p_spEvaluation->m_Remaining == 0) {
+                    p_spEvaluation->m_Completed.notify_all();
+                }
+            }
+        };
+        const size_t numTasks = (std::min)(spEvaluation->m_vspPlugins.size(), MAX_ENABLED_STATES_TASKS);
+        for (size_t i = 0; i < numTasks; ++i) {
+            try {
+                PCC::ThreadPool::Submit(std::bind(evaluatePlugins, spEvaluation), PCC::ThreadPool::Priority::High);
+            } catch (...) {
+                if (i == 0) {
+                    // Could not submit any task, evaluate all plugins on this thread.
+                    vspLocalPlugins.insert(vspLocalPlugins.end(), spEvaluation->m_vspPlugins.cbegin(),
+                                           spEvaluation->m_vspPlugins.cend());
+                    spEvaluation->m_vspPlugins.clear();
+                }
+                break;
+            }
+        }
+    }
+
+    // Evaluate other plugins on this thread while worker threads are running.
+    // Stop early if we run out of time; remaining plugins will be assumed enabled.
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(ENABLED_STATES_DEADLINE_MS);
+    if (m_MenuDeadline.has_value()) {
+        deadline = (std::min)(deadline, *m_MenuDeadline);
+    }
+    for (const PCC::PluginSP& spPlugin : vspLocalPlugins) {
+        if (MenuBudgetExceeded()) {
+            break;
+        }
+        PCC::StTraceEvent traceEvent(L"Plugin::Enabled", &spPlugin->Id());
+        m_mPluginsEnabled.emplace(spPlugin, PCC::PluginStatistics::Measure(spPlugin->Id(), PCC::PluginStatistics::Operation::Enabled, [&]() {
+            return spPlugin->Enabled(m_ParentPath, m_Files.GetFile(0), GetConversionContext());
+        }));
+    }
+
+    // Wait for worker threads, but not past the deadline. Plugins not evaluated in time are assumed enabled.
+    if (!spEvaluation->m_vspPlugins.empty()) {
+        std::unique_lock<std::mutex> lock(spEvaluation->m_Lock);
+        spEvaluation->m_Completed.wait_until(lock, deadline, [&]() { return spEvaluation->m_Remaining == 0; });
+        for (size_t i = 0; i < spEvaluation->m_vspPlugins.size(); ++i) {
+            m_mPluginsEnabled.emplace(spEvaluation->m_vspPlugins[i], spEvaluation->m_vEnabled[i].value_or(true));
+        }
+    }
+}
+
+//
+// Returns the caption to use for a plugin's menu item in preview mode.
+//
+// @param p_spPlugin Plugin to get the caption for.
+// @return Path of first selected file according to plugin, usable as caption.
+//
+std::wstring CPathCopyCopyContextMenuExt::GetPreviewCaption(const PCC::PluginSP& p_spPlugin)
+{
+    std::wstring caption = GetFirstFilePath(p_spPlugin);
+    // Let's limit the size of menu items if possible. We elide the middle
+    // of long paths so that the file name at the end remains visible.
+    if (caption.size() > MAX_PATH) {
+        std::wstring::size_type headSize = MAX_PATH / 2;
+        std::wstring::size_type tailPos = caption.size() - (MAX_PATH - headSize - std::wcslen(PREVIEW_ELLIPSIS));
+        if (IS_HIGH_SURROGATE(caption[headSize - 1])) {
+            --headSize;
+        }
+        if (IS_LOW_SURROGATE(caption[tailPos])) {
+            ++tailPos;
+        }
+        caption.replace(headSize, tailPos - headSize, PREVIEW_ELLIPSIS);
+    }
+    // If path contains ampersands, they will be treated as shortcuts.
+    // We have to double them.
+    StringUtils::ReplaceAll(caption, L"&", L"&&");
+    return caption;
+}
+
+//
+// Replaces the captions of submenu items whose previews have been
+// deferred with their preview captions. Called when the submenu is
+// about to be displayed.
+//
+void CPathCopyCopyContextMenuExt::UpdatePreviewCaptions()
+{
+    // Only do this once; clear members first in case something throws.
+    HMENU hSubMenu = m_hPreviewSubMenu;
+    std::vector<UINT_PTR> vPreviewCmdIds;
+    vPreviewCmdIds.swap(m_vPreviewCmdIds);
+    m_hPreviewSubMenu = NULL;
+
+    for (const UINT_PTR cmdId : vPreviewCmdIds) {
+        // Disabled plugins don't work so can't use preview mode.
+        PCC::PluginSP spPlugin = GetPluginByCmdOffset(cmdId - *m_FirstCmdId);
+        const UINT state = ::GetMenuState(hSubMenu, static_cast<UINT>(cmdId), MF_BYCOMMAND);
+        if (spPlugin != nullptr && state != static_cast<UINT>(-1) && (state & (MF_DISABLED | MF_GRAYED)) == 0) {
+            std::wstring caption = GetPreviewCaption(spPlugin);
+            MENUITEMINFOW menuItemInfo;
+            menuItemInfo.cbSize = sizeof(MENUITEMINFOW);
+            menuItemInfo.fMask = MIIM_STRING;
+            menuItemInfo.dwTypeData = const_cast<LPWSTR>(caption.c_str());
+            ::SetMenuItemInfoW(hSubMenu, static_cast<UINT>(cmdId), FALSE, &menuItemInfo);
+        }
+    }
+
+    // Previews computed here will be useful if the menu is built again.
+    if (!vPreviewCmdIds.empty()) {
+        StoreMenuTemplate();
+    }
+}
+
+//
+// Adds the items of a nested submenu, using the command IDs reserved for
+// them when the menu was built. Called when the nested submenu is about to
+// be displayed, so that the cost of building the menu only depends on the
+// plugins that are actually visible. The nested submenu gets its own time budget.
+//
+// @param p_hSubMenu Handle of nested submenu to populate.
+//
+void CPathCopyCopyContextMenuExt::PopulateNestedSubMenu(HMENU const p_hSubMenu)
+{
+    // Only do this once; remove submenu from the map first in case something throws.
+    auto nestedIt = m_mNestedSubMenus.find(p_hSubMenu);
+    if (nestedIt == m_mNestedSubMenus.end()) {
+        return;
+    }
+    NestedSubMenu nestedSubMenu = std::move(nestedIt->second);
+    m_mNestedSubMenus.erase(nestedIt);
+    PCC::StTraceEvent traceEvent(L"ContextMenuExt::PopulateNestedSubMenu");
+    traceEvent.SetCount(nestedSubMenu.m_vspPlugins.size());
+
+    PCC::Settings& rSettings = GetSettings();
+    const DWORD menuTimeBudget = rSettings.GetMenuTimeBudget();
+    m_MenuBudgetExceeded = false;
+    if (menuTimeBudget != 0) {
+        m_MenuDeadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(menuTimeBudget);
+    }
+    const bool usePreviewMode = rSettings.GetUsePreviewMode();
+    const bool dropRedundantWords = rSettings.GetDropRedundantWords();
+
+    EvaluatePluginsEnabled(nestedSubMenu.m_vspPlugins);
+    UINT position = 0;
+    for (size_t i = 0; i < nestedSubMenu.m_vspPlugins.size(); ++i) {
+        UINT cmdId = nestedSubMenu.m_vCmdIds[i];
+        if (FAILED(AddPluginToMenu(nestedSubMenu.m_vspPlugins[i], p_hSubMenu, false, usePreviewMode,
+                                   dropRedundantWords, false, cmdId, position))) {
+            break;
+        }
+    }
+}
+
+//
+// Scans the given menu and records which shortcuts are already used by its
+// items. This is done once per menu; GetMenuCaptionWithShortcut then uses
+// the result and MarkMenuShortcutUsed updates it as we add our own items.
 //
 // @param p_hMenu Handle to main menu.
-// @param p_Caption Caption to add a shortcut to.
-// @return Caption for the menu item.
 //
-std::wstring CPathCopyCopyContextMenuExt::GetMenuCaptionWithShortcut(HMENU const p_hMenu,
-                                                                     const std::wstring& p_Caption) const
+void CPathCopyCopyContextMenuExt::ScanMenuShortcuts(HMENU const p_hMenu)
 {
-    // Scan provided menu and build a set of already-used shortcuts.
-    std::set<wchar_t> shortcuts;
+    m_UsedShortcuts.reset();
     int itemsCount = ::GetMenuItemCount(p_hMenu);
     for (int i = 0; i < itemsCount; ++i) {
         wchar_t buffer[1000];
@@ -854,24 +2020,43 @@ std::wstring CPathCopyCopyContextMenuExt::GetMenuCaptionWithShortcut(HMENU const
         menuItemInfo.dwTypeData = buffer;
         menuItemInfo.cch = sizeof(buffer) / sizeof(wchar_t);
         if (::GetMenuItemInfoW(p_hMenu, i, TRUE, &menuItemInfo) && (menuItemInfo.fState & MFS_DISABLED) == 0) {
-            std::wstring menuItemCaption = menuItemInfo.dwTypeData;
-            auto shortcutCharIdx = menuItemCaption.find(L'&');
-            if (shortcutCharIdx != std::wstring::npos && shortcutCharIdx < (menuItemCaption.size() - 1)) {
-                shortcuts.insert(::towlower(menuItemCaption[shortcutCharIdx + 1]));
-            }
+            MarkMenuShortcutUsed(menuItemInfo.dwTypeData);
         }
     }
+}
+
+//
+// Records the shortcut of a menu item caption, if any, as being used.
+//
+// @param p_Caption Caption of menu item.
+//
+void CPathCopyCopyContextMenuExt::MarkMenuShortcutUsed(const std::wstring& p_Caption)
+{
+    auto shortcutCharIdx = p_Caption.find(L'&');
+    if (shortcutCharIdx != std::wstring::npos && shortcutCharIdx < (p_Caption.size() - 1)) {
+        m_UsedShortcuts.set(static_cast<size_t>(::towlower(p_Caption[shortcutCharIdx + 1])));
+    }
+}
 
+//
+// Returns a caption usable for a menu item, with the first shortcut available
+// in the main menu. ScanMenuShortcuts must have been called beforehand.
+//
+// @param p_Caption Caption to add a shortcut to.
+// @return Caption for the menu item.
+//
+std::wstring CPathCopyCopyContextMenuExt::GetMenuCaptionWithShortcut(const std::wstring& p_Caption) const
+{
     // Check if the caption already has a shortcut. If it's available, keep it.
     std::wstring caption = p_Caption;
     auto idx = caption.find(L'&');
-    if (idx == std::wstring::npos || idx == (caption.size() - 1) || shortcuts.find(::towlower(caption[idx + 1])) != shortcuts.end()) {
+    if (idx == std::wstring::npos || idx == (caption.size() - 1) || m_UsedShortcuts.test(static_cast<size_t>(::towlower(caption[idx + 1])))) {
         // No caption or can't use this caption.
         StringUtils::ReplaceAll(caption, L"&", L"");
 
         // Scan our caption and select first available shortcut.
         for (auto it = caption.begin(); it != caption.end(); ++it) {
-            if (::iswalpha(*it) && shortcuts.find(::towlower(*it)) == shortcuts.end()) {
+            if (::iswalpha(*it) && !m_UsedShortcuts.test(static_cast<size_t>(::towlower(*it)))) {
                 caption.insert(it, L'&');
                 break;
             }
@@ -882,116 +2067,208 @@ std::wstring CPathCopyCopyContextMenuExt::GetMenuCaptionWithShortcut(HMENU const
 }
 
 //
-// Returns a handle to the bitmap containing the Path Copy Copy icon
+// Returns the image containing the Path Copy Copy icon
 // that can be used for contextual menu items, loading it if necessary.
 //
-// @return Handle of bitmap containing the icon. Will be NULL if loading failed.
+// @return Image containing the icon. Will be nullptr if loading failed.
 //
-HBITMAP CPathCopyCopyContextMenuExt::GetPCCIcon()
+CPathCopyCopyContextMenuExt::StImageSP CPathCopyCopyContextMenuExt::GetPCCIcon()
 {
-    // Load on first call.
+    // Fetch on first call. The icon is loaded once per process and shared between instances.
     if (m_spPCCIcon == nullptr) {
-        // Load PNG resource.
-        HRSRC hPngRsrcInfo = ::FindResourceW(CPathCopyCopyModule::HInstance(), MAKEINTRESOURCEW(IDB_PCCICON2), L"PNG");
-        if (hPngRsrcInfo != NULL) {
-            HGLOBAL hPngRsrc = ::LoadResource(CPathCopyCopyModule::HInstance(), hPngRsrcInfo);
-            DWORD pngSize = ::SizeofResource(CPathCopyCopyModule::HInstance(), hPngRsrcInfo);
-            if (hPngRsrc != NULL && pngSize != 0) {
-                void* pPngData = ::LockResource(hPngRsrc);
-                if (pPngData != nullptr) {
-                    // Store PNG data in a global block of memory.
-                    StGlobalBlock globalPngData(GMEM_MOVEABLE, pngSize);
-                    if (globalPngData.Get() != NULL) {
-                        StGlobalLock pngLock(globalPngData.Get());
-                        if (pngLock.GetPtr() != nullptr) {
-                            ::memcpy(pngLock.GetPtr(), pPngData, pngSize);
-                        } else {
-                            globalPngData.Acquire(NULL);
-                        }
-                    }
-                    if (globalPngData.Get() != NULL) {
-                        // Create IStream object on this HGLOBAL to be able to pass it to GDI+.
-                        ATL::CComPtr<IStream> cpPngStream;
-                        if (SUCCEEDED(::CreateStreamOnHGlobal(globalPngData.Get(), FALSE, &cpPngStream))) {
-                            // Init GDI+ to be able to use its calls, since shell doesn't do it.
-                            StGdiplusStartup gdiPlusStartup;
-                            if (gdiPlusStartup.Started()) {
-                                // Extract HBITMAP using GDI+.
-                                HBITMAP hPngBitmap = NULL;
-                                Gdiplus::Bitmap pngBitmap(cpPngStream, FALSE);
-                                if (pngBitmap.GetHBITMAP(Gdiplus::Color(), &hPngBitmap) == Gdiplus::Ok) {
-                                    // We have HBITMAP, save it in our member.
-                                    m_spPCCIcon = std::make_shared<StImage>(hPngBitmap, IMAGE_BITMAP, false);
-                                }
-                            }
-                        }
-                    }
-                }
-            }
-        }
+        m_spPCCIcon = PCC::IconCache::GetPCCIcon();
     }
-    return (m_spPCCIcon != nullptr && m_spPCCIcon->GetLoadResult() == ERROR_SUCCESS) ? m_spPCCIcon->GetBitmap() : NULL;
+    return m_spPCCIcon;
 }
 
 //
-// Given the path to an icon file, returns a handle to a Win32 bitmap for that icon
-// if possible. If an empty string is passed, the method simply returns NULL.
+// Given the path to an icon file, returns an image for that icon if possible.
+// If an empty string is passed, the method simply returns nullptr.
 //
 // @param p_IconFile Path to icon file. Can be empty.
-// @return Handle to icon bitmap, or NULL if p_IconFile was empty or if an error occured.
+// @return Icon image, or nullptr if p_IconFile was empty or if an error occured.
 //
-HBITMAP CPathCopyCopyContextMenuExt::GetIconForIconFile(const std::wstring& p_IconFile)
+CPathCopyCopyContextMenuExt::StImageSP CPathCopyCopyContextMenuExt::GetIconForIconFile(const std::wstring& p_IconFile)
 {
     // Assume we'll fail to locate an icon.
-    HBITMAP hIconBitmap = NULL;
+    StImageSP spIconImage;
 
     // Check if icon file was specified.
     if (!p_IconFile.empty()) {
-        // First look for icon in our map, in case we've previously loaded it.
-        // The map contains lowercase paths, so we need to convert ours.
-        std::wstring lowerIconFile;
-        const std::locale ourLocale("");
-        lowerIconFile.resize(p_IconFile.size());
-        std::transform(p_IconFile.cbegin(), p_IconFile.cend(), lowerIconFile.begin(),
-            [&](wchar_t p_Char) { return std::tolower(p_Char, ourLocale); });
-        IconFilesM::const_iterator foundIconFile = m_mspIcons.find(lowerIconFile);
-        if (foundIconFile != m_mspIcons.cend()) {
-            // We loaded this bitmap previously, return it again.
-            const StImage& loadedImage = *foundIconFile->second;
-            if (loadedImage.GetLoadResult() == ERROR_SUCCESS) {
-                hIconBitmap = loadedImage.GetBitmap();
-            }
-        } else {
-            // This icon file hasn't been loaded yet, load it now and insert it in the map.
-            // First attempt to open the file on disk and get an IStream for it.
-            ATL::CComPtr<IStream> cpIconFileStream;
-            if (SUCCEEDED(::SHCreateStreamOnFileEx(p_IconFile.c_str(), STGM_READ | STGM_SHARE_DENY_WRITE | STGM_DIRECT,
-                                                   FILE_ATTRIBUTE_NORMAL, FALSE, nullptr, &cpIconFileStream))) {
-                // Successfully got stream for the icon, attempt to get a bitmap for it.
-
-                // Init GDI+ to be able to use its calls, since shell doesn't do it.
-                StGdiplusStartup gdiPlusStartup;
-                if (gdiPlusStartup.Started()) {
-                    // Extract HBITMAP using GDI+.
-                    HBITMAP hFileBitmap = NULL;
-                    Gdiplus::Bitmap fileBitmap(cpIconFileStream, FALSE);
-                    if (fileBitmap.GetHBITMAP(Gdiplus::Color(), &hFileBitmap) == Gdiplus::Ok) {
-                        // We have HBITMAP, save it in the map.
-                        auto insertRes = m_mspIcons.insert(std::make_pair(lowerIconFile,
-                            StImageSP(new StImage(hFileBitmap, IMAGE_BITMAP, false))));
-                        const StImage& loadedImage = *insertRes.first->second;
-                        if (loadedImage.GetLoadResult() == ERROR_SUCCESS) {
-                            hIconBitmap = loadedImage.GetBitmap();
-                        }
-                    }
-                }
+        // First look for icon in our map, in case we've previously fetched it.
+        // Otherwise fetch it from the process-wide cache and keep a reference
+        // to it so that it remains valid while our menu is displayed.
+        IconFilesM::const_iterator foundIconFile = m_mspIcons.find(p_IconFile);
+        if (foundIconFile == m_mspIcons.cend()) {
+            StImageSP spIcon = PCC::IconCache::GetIconForIconFile(p_IconFile);
+            if (spIcon != nullptr) {
+                foundIconFile = m_mspIcons.emplace(p_IconFile, spIcon).first;
             }
         }
+        if (foundIconFile != m_mspIcons.cend()) {
+            spIconImage = foundIconFile->second;
+        }
+    }
+
+    return spIconImage;
+}
+
+//
+// Returns a handle to the bitmap to draw for a menu item's icon, scaled
+// to the given size. Scaled icons are cached by IconCache, so icons are
+// only scaled once per size instead of every time the menu is painted.
+// If the icon cannot be scaled, it is returned at its native size.
+//
+// @param p_IconFile Path to icon file, or an empty string for the PCC icon.
+// @param p_IconSize Size of icon in menu, in pixels. See GetMenuIconSize.
+// @return Handle to icon bitmap, or NULL if the icon could not be loaded.
+//
+HBITMAP CPathCopyCopyContextMenuExt::GetMenuIcon(const std::wstring& p_IconFile,
+                                                 const SIZE& p_IconSize)
+{
+    HBITMAP hIconBitmap = NULL;
+
+    StImageSP spIcon = p_IconFile.empty() ? GetPCCIcon() : GetIconForIconFile(p_IconFile);
+    if (spIcon != nullptr) {
+        // Keep a reference to the scaled icon so that it remains valid while our menu is displayed.
+        // It only needs to be fetched again if the menu moves to a monitor with a different DPI.
+        StImageSP& rspScaledIcon = m_mspScaledIcons[p_IconFile];
+        BITMAP bitmapInfo;
+        if (rspScaledIcon == nullptr ||
+            ::GetObjectW(rspScaledIcon->GetBitmap(), sizeof(bitmapInfo), &bitmapInfo) == 0 ||
+            bitmapInfo.bmWidth != p_IconSize.cx || bitmapInfo.bmHeight != p_IconSize.cy) {
+
+            rspScaledIcon = PCC::IconCache::GetScaledIcon(spIcon, p_IconSize.cx, p_IconSize.cy);
+        }
+        hIconBitmap = (rspScaledIcon != nullptr ? rspScaledIcon : spIcon)->GetBitmap();
     }
 
     return hIconBitmap;
 }
 
+//
+// Returns the size of icons in a menu drawn in the given device context.
+// On Windows 10 version 1607 and later, this is the size of small icons at
+// the DPI of the menu's window, which can differ from the system DPI on
+// systems with multiple monitors. Otherwise, the system size is used.
+//
+// @param p_hDC Device context of menu.
+// @return Size of icons, in pixels.
+//
+SIZE CPathCopyCopyContextMenuExt::GetMenuIconSize(HDC const p_hDC)
+{
+    SIZE iconSize = { ::GetSystemMetrics(SM_CXSMICON), ::GetSystemMetrics(SM_CYSMICON) };
+
+    HMODULE hUser32 = ::GetModuleHandleW(L"user32.dll");
+    HWND hMenuWnd = ::WindowFromDC(p_hDC);
+    if (hUser32 != NULL && hMenuWnd != NULL) {
+        auto pGetDpiForWindow = reinterpret_cast<GetDpiForWindowFunc>(
+            ::GetProcAddress(hUser32, "GetDpiForWindow"));
+        auto pGetSystemMetricsForDpi = reinterpret_cast<GetSystemMetricsForDpiFunc>(
+            ::GetProcAddress(hUser32, "GetSystemMetricsForDpi"));
+        if (pGetDpiForWindow != nullptr && pGetSystemMetricsForDpi != nullptr) {
+            const UINT dpi = pGetDpiForWindow(hMenuWnd);
+            if (dpi != 0) {
+                iconSize.cx = pGetSystemMetricsForDpi(SM_CXSMICON, dpi);
+                iconSize.cy = pGetSystemMetricsForDpi(SM_CYSMICON, dpi);
+            }
+        }
+    }
+
+    return iconSize;
+}
+
+//
+// Draws the icon of a menu item, centered vertically in the given rectangle.
+// If the bitmap does not already have the given size, it is stretched.
+//
+// @param p_hDC Device context to draw into.
+// @param p_Rect Rectangle reserved for the icon.
+// @param p_IconSize Size of icon to draw, in pixels.
+// @param p_hIconBitmap Bitmap containing the icon, with premultiplied alpha channel.
+//
+void CPathCopyCopyContextMenuExt::DrawMenuIcon(HDC const p_hDC,
+                                               const RECT& p_Rect,
+                                               const SIZE& p_IconSize,
+                                               HBITMAP const p_hIconBitmap)
+{
+    BITMAP bitmapInfo;
+    if (::GetObjectW(p_hIconBitmap, sizeof(bitmapInfo), &bitmapInfo) != 0) {
+        HDC hMemDC = ::CreateCompatibleDC(p_hDC);
+        if (hMemDC != NULL) {
+            HGDIOBJ hOldBitmap = ::SelectObject(hMemDC, p_hIconBitmap);
+            const int top = p_Rect.top + ((p_Rect.bottom - p_Rect.top) - p_IconSize.cy) / 2;
+            BLENDFUNCTION blendFunc = { AC_SRC_OVER, 0, 255, AC_SRC_ALPHA };
+            ::AlphaBlend(p_hDC, p_Rect.left, top, p_IconSize.cx, p_IconSize.cy,
+                         hMemDC, 0, 0, bitmapInfo.bmWidth, bitmapInfo.bmHeight, blendFunc);
+            ::SelectObject(hMemDC, hOldBitmap);
+            ::DeleteDC(hMemDC);
+        }
+    }
+}
+
+//
+// Returns the path of the first selected file according to the given plugin.
+// The path is computed only once per plugin and reused afterwards, since it
+// is needed both for preview mode and when the plugin is invoked.
+//
+// @param p_spPlugin Plugin to use to compute the path.
+// @return Path of first selected file according to plugin.
+//
+const std::wstring& CPathCopyCopyContextMenuExt::GetFirstFilePath(const PCC::PluginSP& p_spPlugin)
+{
+    auto it = m_mFirstFilePaths.find(p_spPlugin);
+    if (it == m_mFirstFilePaths.end() && m_spMenuPrefetch != nullptr) {
+        // Path might have been prefetched since we were initialized.
+        std::lock_guard<std::mutex> lock(m_spMenuPrefetch->m_Lock);
+        auto prefetchedIt = m_spMenuPrefetch->m_mFirstFilePaths.find(p_spPlugin);
+        if (prefetchedIt != m_spMenuPrefetch->m_mFirstFilePaths.end()) {
+            it = m_mFirstFilePaths.insert(*prefetchedIt).first;
+        }
+    }
+    if (it == m_mFirstFilePaths.end()) {
+        PCC::StTraceEvent traceEvent(L"Plugin::GetPath", &p_spPlugin->Id());
+        traceEvent.SetCount(1);
+        it = m_mFirstFilePaths.emplace(p_spPlugin, PCC::PluginStatistics::Measure(p_spPlugin->Id(), PCC::PluginStatistics::Operation::GetPath, [&]() {
+            return PCC::PluginUtils::GetPathCached(*p_spPlugin, m_Files.GetFile(0), GetConversionContext());
+        })).first;
+    }
+    return it->second;
+}
+
+//
+// Returns all files selected in the Shell. Only the first file is extracted
+// when we're initialized; the others are extracted the first time this is
+// called, since it's only needed when a command is actually invoked.
+//
+// @return Files selected in Shell.
+//
+const PCC::FileSelection& CPathCopyCopyContextMenuExt::GetSelectedFiles()
+{
+    if (m_spDataObject != nullptr) {
+        // If we can't get the files, we'll stick with the first one.
+        UINT fileCount = 0;
+        if (GetFilesFromShellIdList(m_spDataObject, UINT_MAX, m_Files, fileCount) ||
+            GetFilesFromHDrop(m_spDataObject, UINT_MAX, m_Files, fileCount)) {
+
+            m_FileCount = fileCount;
+        }
+        m_spDataObject.Release();
+    }
+    return m_Files;
+}
+
+//
+// Returns the context to use to call plugins. While the menu is built,
+// the context includes the cache of file metadata used by previews.
+//
+// @return Conversion context.
+//
+PCC::ConversionContext CPathCopyCopyContextMenuExt::GetConversionContext() const
+{
+    return PCC::ConversionContext(m_spPluginsSnapshot->GetConversionContext(), m_pMenuMetadataCache);
+}
+
 //
 // Performs the plugin's default action on our saved files.
 // Call this when user picks a plugin from the menu, for instance.
@@ -1005,49 +2282,157 @@ HRESULT CPathCopyCopyContextMenuExt::ActOnFiles(const PCC::PluginSP& p_spPlugin,
                                                 HWND p_hWnd)
 {
     HRESULT hRes = E_FAIL;
+    PCC::StTraceEvent traceEvent(L"ContextMenuExt::ActOnFiles", p_spPlugin != nullptr ? &p_spPlugin->Id() : nullptr);
+    traceEvent.SetCount(m_FileCount);
 
+    // Previews are no longer needed once the user has picked a plugin.
+    CancelMenuPrefetch();
+
+    // Remember which plugin is used so that we can convert files with it speculatively next time.
     if (p_spPlugin != nullptr) {
-        // Loop through files and compute filenames using plugin.
-        bool addQuotes = GetSettings().GetAddQuotesAroundPaths();
-        bool areQuotesOptional = GetSettings().GetAreQuotesOptional();
-        bool makeEmailLinks = GetSettings().GetMakePathsIntoEmailLinks();
-        StringUtils::EncodeParam encodeParam = GetSettings().GetEncodeParam();
-        std::wstring pathsSeparator = p_spPlugin->PathsSeparator();
+        std::lock_guard<PCC::MeasuredMutex> lock(s_LastUsedPluginLock);
+        s_LastUsedPluginId = p_spPlugin->Id();
+    }
+
+    // Paths of large selections might have been computed while the menu was shown.
+    PCC::WStringV vPrecomputedPaths;
+    const bool speculated = ConsumeSpeculativeConversion(p_spPlugin, vPrecomputedPaths);
+
+    // Requests are acknowledged before they are processed, so only actions
+    // whose failures go unnoticed can be forwarded to the resident service.
+    if (p_spPlugin != nullptr && !speculated && !p_spPlugin->Action()->CanFailVisibly() &&
+        PCC::ResidentService::Forward(p_spPlugin->Id(), GetSelectedFiles().GetAllFiles())) {
+
+        // The resident service will copy the paths for us, using its warm caches.
+        hRes = S_OK;
+    } else if (p_spPlugin != nullptr) {
+        // Loop through files and compute filenames using plugin. Formatting options
+        // come from the snapshot, which reads them from the registry only once.
+        // Paths exported with their files' metadata are not quoted and use their own separator.
+        const PCC::SettingsSnapshot& settingsSnapshot = m_spPluginsSnapshot->GetSettingsSnapshot();
+        const PCC::ExportFormat exportFormat = p_spPlugin->GetExportFormat();
+        const bool addQuotes = exportFormat == PCC::ExportFormat::None && settingsSnapshot.GetAddQuotesAroundPaths();
+        const bool areQuotesOptional = settingsSnapshot.GetAreQuotesOptional();
+        const bool makeEmailLinks = exportFormat == PCC::ExportFormat::None && settingsSnapshot.GetMakePathsIntoEmailLinks();
+        const StringUtils::EncodeParam encodeParam = settingsSnapshot.GetEncodeParam();
+        std::wstring pathsSeparator = exportFormat != PCC::ExportFormat::None ? PCC::MetadataExporter::RecordsSeparator(exportFormat)
+                                                                               : p_spPlugin->PathsSeparator();
         if (pathsSeparator.empty()) {
-            pathsSeparator = GetSettings().GetPathsSeparator();
+            pathsSeparator = settingsSnapshot.GetPathsSeparator();
             if (pathsSeparator.empty()) {
                 pathsSeparator = DEFAULT_PATHS_SEPARATOR;
             }
         }
-        std::wstring newFiles;
-        PCC::FilesV::const_iterator it, end = m_vFiles.end();
-        for (it = m_vFiles.begin(); it != end; ++it) {
-            // Ask plugin to compute filename using its scheme and save it.
-            const std::wstring& oldName = *it;
-            if (!newFiles.empty()) {
-                newFiles += pathsSeparator;
+
+        // If a single file is selected, its path might have been computed for preview mode already.
+        if (m_FileCount == 1 && !speculated) {
+            vPrecomputedPaths.push_back(GetFirstFilePath(p_spPlugin));
+        }
+
+        // Functions that pass paths to an action: actOnPaths formats paths computed by the
+        // plugin, while producePaths computes them first. The action might call them after
+        // we're gone, so they keep copies of everything they need, including the plugins
+        // snapshot that owns the settings used by plugins.
+        PCC::PluginsSnapshotSP spPluginsSnapshot = m_spPluginsSnapshot;
+        const PCC::PluginSP spPlugin = p_spPlugin;
+        const PCC::FileSelection files = GetSelectedFiles();
+        auto actOnPaths = [=](const PCC::WStringV& p_vNewNames, const PCC::PathAction& p_Action, const HWND p_hActionWnd) {
+            // Encode filenames if needed. We keep the filenames as returned by the plugin,
+            // since the action might need them (for instance, to copy them as files).
+            PCC::WStringV vEncodedNames;
+            if (encodeParam != StringUtils::EncodeParam::None) {
+                vEncodedNames = p_vNewNames;
+                for (std::wstring& encodedName : vEncodedNames) {
+                    StringUtils::EncodeURICharacters(encodedName, encodeParam);
+                }
             }
-            if (makeEmailLinks) {
-                newFiles += L"<";
+            const PCC::WStringV& vConvertedNames = vEncodedNames.empty() ? p_vNewNames : vEncodedNames;
+
+            // If requested, turn paths into records including the metadata of their files.
+            PCC::WStringV vRecords;
+            if (exportFormat != PCC::ExportFormat::None) {
+                vRecords = PCC::MetadataExporter::FormatRecords(exportFormat, files.GetAllFiles(), vConvertedNames);
             }
-            std::wstring newName = p_spPlugin->GetPath(oldName);
-            StringUtils::EncodeURICharacters(newName, encodeParam);
-            if (addQuotes) {
-                AddQuotes(newName, areQuotesOptional);
+            const PCC::WStringV& vOutNames = vRecords.empty() ? vConvertedNames : vRecords;
+
+            // First pass: compute the size of the output so that
+            // we can assemble it in a single allocation.
+            std::vector<bool> vNeedQuotes(vOutNames.size(), false);
+            std::wstring::size_type newFilesSize = 0;
+            for (size_t i = 0; i < vOutNames.size(); ++i) {
+                const std::wstring& newName = vOutNames[i];
+                vNeedQuotes[i] = addQuotes && NeedQuotes(newName, areQuotesOptional);
+                if (newFilesSize != 0) {
+                    newFilesSize += pathsSeparator.size();
+                }
+                newFilesSize += newName.size() + (vNeedQuotes[i] ? 2 : 0) + (makeEmailLinks ? 2 : 0);
             }
-            newFiles += newName;
-            if (makeEmailLinks) {
-                newFiles += L">";
+
+            // Second pass: write everything in the output. The action tells us where
+            // to write it, so that it can avoid copying the output (for instance,
+            // the clipboard action has it written directly in the clipboard's block).
+            auto writePaths = [&](wchar_t* const p_pBuffer) {
+                wchar_t* pOut = p_pBuffer;
+                auto write = [&pOut](const std::wstring& p_Part) {
+                    std::wmemcpy(pOut, p_Part.c_str(), p_Part.size());
+                    pOut += p_Part.size();
+                };
+                for (size_t i = 0; i < vOutNames.size(); ++i) {
+                    if (pOut != p_pBuffer) {
+                        write(pathsSeparator);
+                    }
+                    if (makeEmailLinks) {
+                        *pOut++ = L'<';
+                    }
+                    if (vNeedQuotes[i]) {
+                        *pOut++ = L'"';
+                    }
+                    write(vOutNames[i]);
+                    if (vNeedQuotes[i]) {
+                        *pOut++ = L'"';
+                    }
+                    if (makeEmailLinks) {
+                        *pOut++ = L'>';
+                    }
+                }
+                assert(static_cast<std::wstring::size_type>(pOut - p_pBuffer) == newFilesSize);
+            };
+            p_Action.ActOnWrittenPaths(p_vNewNames, newFilesSize, writePaths, p_hActionWnd);
+        };
+        auto producePaths = [=](const PCC::PathAction& p_Action, const HWND p_hActionWnd) {
+            // Ask plugin to compute filenames using its scheme, all at once
+            // so that it can share work between files. Large selections
+            // are converted in parallel if the plugin supports it.
+            // File metadata is prefetched per parent directory while doing so,
+            // so that plugins chained through pipelines don't query each file.
+            PCC::WStringV vNewNames = vPrecomputedPaths;
+            if (vNewNames.empty()) {
+                const PCC::FilesV vFiles = files.GetAllFiles();
+                PCC::FileMetadataCache metadataCache;
+                metadataCache.Prefetch(vFiles);
+                vNewNames = PCC::PluginUtils::GetPathsInParallel(*spPlugin, vFiles,
+                                                                 PCC::ConversionContext(spPluginsSnapshot->GetConversionContext(), &metadataCache));
             }
-        }
+            actOnPaths(vNewNames, p_Action, p_hActionWnd);
+        };
 
         // Get action to perform on the filenames.
         PCC::PathActionSP spAction = p_spPlugin->Action();
         assert(spAction != nullptr);
 
-        // Use the action to perform whatever is needed.
+        // Use the action to perform whatever is needed. For huge selections, compute
+        // paths on a worker thread so that the user can follow progress and cancel.
+        // For large selections, let the action compute paths only when needed (e.g. when pasted).
         try {
-            spAction->Act(newFiles, p_hWnd);
+            if (vPrecomputedPaths.empty() && m_FileCount >= BACKGROUND_MIN_FILES &&
+                p_spPlugin->CanGetPathsConcurrently(GetConversionContext())) {
+
+                ActOnFilesInBackground(p_spPlugin, spAction, actOnPaths, p_hWnd);
+            } else if (m_FileCount >= ACT_LATER_MIN_FILES) {
+                spAction->ActLater(producePaths, p_hWnd);
+            } else {
+                producePaths(*spAction, p_hWnd);
+            }
             hRes = S_OK;
         } catch (...) {
             assert(hRes == E_FAIL);
@@ -1058,51 +2443,167 @@ HRESULT CPathCopyCopyContextMenuExt::ActOnFiles(const PCC::PluginSP& p_spPlugin,
 }
 
 //
-// Add quotes around the given file name.
+// Computes the paths of our saved files on a worker thread, then passes them
+// to an action. Used for huge selections, which can take minutes to convert
+// (for example to UNC paths): a progress dialog is shown meanwhile, and if
+// the user cancels it, we stop after the current batch of files and the
+// action is not performed. Plugin must be able to compute paths concurrently.
+//
+// @param p_spPlugin Plugin to use to compute paths.
+// @param p_spAction Action to perform on the paths.
+// @param p_ActOnPaths Function passing computed paths to the action.
+// @param p_hWnd Handle to parent window, used for the progress dialog.
+//
+void CPathCopyCopyContextMenuExt::ActOnFilesInBackground(const PCC::PluginSP& p_spPlugin,
+                                                         const PCC::PathActionSP& p_spAction,
+                                                         const PathsActor& p_ActOnPaths,
+                                                         HWND p_hWnd)
+{
+    PCC::PluginsSnapshotSP spPluginsSnapshot = m_spPluginsSnapshot;
+    const PCC::FileSelection files = GetSelectedFiles();
+    std::wstring description = p_spPlugin->Description(GetConversionContext());
+    StringUtils::ReplaceAll(description, L"&", L"");
+    auto actInBackground = [=]() {
+        try {
+            // The progress dialog is a COM object that needs an apartment.
+            StCoInitialize coInitialize;
+            PCC::StTraceEvent traceEvent(L"ContextMenuExt::ActOnFilesInBackground", &p_spPlugin->Id());
+            traceEvent.SetCount(files.Size());
+
+            // Show progress if possible; otherwise convert files silently.
+            ATL::CComPtr<IProgressDialog> spProgressDialog;
+            if (SUCCEEDED(spProgressDialog.CoCreateInstance(CLSID_ProgressDialog))) {
+                spProgressDialog->SetTitle(ATL::CStringW(MAKEINTRESOURCEW(IDS_PROGRESS_TITLE)));
+                spProgressDialog->SetLine(1, ATL::CStringW(MAKEINTRESOURCEW(IDS_PROGRESS_COMPUTING_PATHS)), FALSE, nullptr);
+                spProgressDialog->SetLine(2, description.c_str(), FALSE, nullptr);
+                spProgressDialog->SetCancelMsg(ATL::CStringW(MAKEINTRESOURCEW(IDS_PROGRESS_CANCELLING)), nullptr);
+                if (FAILED(spProgressDialog->StartProgressDialog(p_hWnd, nullptr, PROGDLG_NORMAL | PROGDLG_AUTOTIME, nullptr))) {
+                    spProgressDialog.Release();
+                }
+            }
+
+            // Convert files in batches so that we can report progress and stop early if cancelled.
+            PCC::WStringV vNewNames;
+            vNewNames.reserve(files.Size());
+            bool cancelled = false;
+            {
+                PCC::FileMetadataCache metadataCache;
+                metadataCache.Prefetch(files);
+                const PCC::ConversionContext context(spPluginsSnapshot->GetConversionContext(), &metadataCache);
+                PCC::FilesV vBatch;
+                for (size_t first = 0; !cancelled && first < files.Size(); first += BACKGROUND_BATCH_SIZE) {
+                    files.GetFiles(first, BACKGROUND_BATCH_SIZE, vBatch);
+                    const size_t last = first + vBatch.size();
+                    PCC::WStringV vBatchPaths = PCC::PluginUtils::GetPathsInParallel(*p_spPlugin, vBatch, context);
+                    if (vBatchPaths.size() != vBatch.size()) {
+                        cancelled = true;
+                        break;
+                    }
+                    vNewNames.insert(vNewNames.end(), vBatchPaths.begin(), vBatchPaths.end());
+                    if (spProgressDialog != nullptr) {
+                        spProgressDialog->SetProgress64(last, files.Size());
+                        cancelled = spProgressDialog->HasUserCancelled() != FALSE;
+                    }
+                }
+            }
+            if (spProgressDialog != nullptr) {
+                spProgressDialog->StopProgressDialog();
+            }
+
+            if (!cancelled) {
+                p_ActOnPaths(vNewNames, *p_spAction, p_hWnd);
+            }
+        } catch (...) {
+            // Nothing we can do; there's no one to report the error to.
+        }
+        _AtlModule.Unlock();
+    };
+
+    // Worker thread can outlive us, so make sure our DLL is not unloaded before it completes.
+    _AtlModule.Lock();
+    try {
+        std::thread(actInBackground).detach();
+    } catch (...) {
+        _AtlModule.Unlock();
+        throw;
+    }
+}
+
+//
+// Checks if quotes must be added around the given file name.
 //
-// @param p_rName File name to add quotes to. Will be modified in place.
+// @param p_Name File name to check.
 // @param p_Optional Whether quotes are optional, e.g. should only be
 //                   added if there are spaces in the path.
+// @return true if quotes must be added around the file name.
 //
-void CPathCopyCopyContextMenuExt::AddQuotes(std::wstring& p_rName,
-                                            const bool p_Optional) const
+bool CPathCopyCopyContextMenuExt::NeedQuotes(const std::wstring& p_Name,
+                                             const bool p_Optional)
 {
     bool needToAddQuotes = true;
     if (p_Optional) {
-        needToAddQuotes = p_rName.find(' ') != std::wstring::npos;
-    }
-    if (needToAddQuotes) {
-        p_rName = L"\"" + p_rName + L"\"";
+        needToAddQuotes = p_Name.find(' ') != std::wstring::npos;
     }
+    return needToAddQuotes;
 }
 
 //
-// Scans the vector keeping tracks of instances modifying menus
-// and removes any reference to this instance from it.
+// Removes the menu modified by this instance, if any, from the
+// set keeping track of menus modified by all instances.
 //
-void CPathCopyCopyContextMenuExt::RemoveFromExtToMenu()
+void CPathCopyCopyContextMenuExt::RemoveFromModifiedMenus()
 {
-    std::lock_guard<std::mutex> lock(s_ExtToMenusLock);
-    ExtToMenuPairV::iterator it, end = s_vExtToMenus.end();
-    for (it = s_vExtToMenus.begin(); it != end; ++it) {
-        if (it->first == this) {
-            s_vExtToMenus.erase(it);
-            break;
-        }
+    if (m_hModifiedMenu != NULL) {
+        std::lock_guard<PCC::MeasuredMutex> lock(s_ModifiedMenusLock);
+        s_sModifiedMenus.erase(m_hModifiedMenu);
+        m_hModifiedMenu = NULL;
     }
 }
 
 //
-// Checks for software updates if needed.
+// Checks for software updates if needed. The time of the next check is kept
+// in memory, so this is free until it is due; settings are then read and the
+// settings app launched in the thread pool, so as not to block the shell.
 //
 void CPathCopyCopyContextMenuExt::CheckForUpdates()
 {
-    // See if we're due for an update check.
-    if (GetSettings().NeedsUpdateCheck()) {
-        // Mark the last update check as now so that we don't check too often.
-        GetSettings().SetLastUpdateCheckNow();
+    __time64_t now;
+    ::_time64(&now);
+    {
+        std::lock_guard<std::mutex> lock(s_UpdateCheckLock);
+        if (s_UpdateCheckPending || (s_NextUpdateCheck != 0 && now < s_NextUpdateCheck)) {
+            return;
+        }
+        s_UpdateCheckPending = true;
+    }
 
-        // Launch the settings app. It will handle the check.
-        PCC::SettingsApp().Launch(PCC::SettingsApp::Options().WithUpdateCheck());
+    auto checkForUpdates = []() {
+        __time64_t nextUpdateCheck = _MAX__TIME64_T;
+        try {
+            // Use our own settings object since we are not on the shell's thread.
+            // The settings app needs an apartment to be launched.
+            StCoInitialize coInitialize;
+            PCC::Settings settings;
+            if (settings.NeedsUpdateCheck()) {
+                // Mark the last update check as now so that we don't check too often.
+                settings.SetLastUpdateCheckNow();
+
+                // Launch the settings app. It will handle the check.
+                PCC::SettingsApp().Launch(PCC::SettingsApp::Options().WithUpdateCheck());
+            }
+            nextUpdateCheck = settings.GetNextUpdateCheckTime();
+        } catch (...) {
+            // Don't try again in this process.
+        }
+
+        std::lock_guard<std::mutex> lock(s_UpdateCheckLock);
+        s_NextUpdateCheck = nextUpdateCheck;
+        s_UpdateCheckPending = false;
+    };
+    try {
+        PCC::ThreadPool::Submit(checkForUpdates, PCC::ThreadPool::Priority::Low);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(s_UpdateCheckLock);
+        s_UpdateCheckPending = false;
     }
 }
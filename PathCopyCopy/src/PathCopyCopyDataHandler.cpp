@@ -22,14 +22,12 @@
 #include <stdafx.h>
 #include <PathCopyCopyDataHandler.h>
 #include <DefaultPlugin.h>
+#include <PluginsSnapshot.h>
 #include <StGlobalBlock.h>
 #include <StGlobalLock.h>
+#include <Trace.h>
 
-#include <fstream>
-#include <sstream>
-
-// Uncomment this to enable logging in this class.
-//#define PCC_DATA_HANDLER_LOGGING
+#include <memory>
 
 
 // CPathCopyCopyContextMenuExt
@@ -38,7 +36,10 @@
 // Constructor.
 //
 CPathCopyCopyDataHandler::CPathCopyCopyDataHandler()
-    : m_FileName()
+    : m_FileName(),
+      m_spPluginsSnapshot(),
+      m_spDefaultPlugin(),
+      m_Path()
 {
 }
 
@@ -68,9 +69,11 @@ STDMETHODIMP CPathCopyCopyDataHandler::Load(
     HRESULT hRes = S_OK;
     try {
         m_FileName = pszFileName;
+        m_Path.reset();
     } catch (...) {
         hRes = E_UNEXPECTED;
         m_FileName.clear();
+        m_Path.reset();
     }
     return hRes;
 }
@@ -137,52 +140,30 @@ STDMETHODIMP CPathCopyCopyDataHandler::GetData(
     FORMATETC *pformatetcIn,
     STGMEDIUM *pmedium)
 {
-#ifdef PCC_DATA_HANDLER_LOGGING
-    GUID filg;
-    ::CoCreateGuid(&filg);
-    OLECHAR filn[256];
-    ::StringFromGUID2(filg, filn, 256);
-    std::wstringstream fils;
-    fils << L"C:\\" << filn << L".txt";
-    std::wstring filns = fils.str();
-    std::wofstream fil(ATL::CW2A(filns.c_str()));
-#endif // PCC_DATA_HANDLER_LOGGING
-
+    PCC::StTraceEvent traceEvent(L"DataHandler::GetData");
     HRESULT hRes = E_INVALIDARG;
     if (pformatetcIn != nullptr && pmedium != nullptr) {
         try {
             // Make sure we support this particular format. Since
             // we only support one combination, we'll call QueryGetData.
             hRes = this->QueryGetData(pformatetcIn);
-#ifdef PCC_DATA_HANDLER_LOGGING
-            fil << L"QueryGetDataResult: 0x" << std::hex << hRes << std::endl;
-#endif // PCC_DATA_HANDLER_LOGGING
             if (SUCCEEDED(hRes)) {
                 // It's the format we support.
 
                 // First get the path of the file using the default plugin.
-                std::wstring newPath = PCC::Plugins::DefaultPlugin().GetPath(m_FileName);
-#ifdef PCC_DATA_HANDLER_LOGGING
-                fil << L"Filename: " << m_FileName << std::endl
-                    << L"New path: " << newPath << std::endl;
-#endif // PCC_DATA_HANDLER_LOGGING
+                // It is computed only once, since we're usually asked repeatedly.
+                const std::wstring& newPath = GetPath();
 
                 // Allocate an HGLOBAL to store the string.
                 const SIZE_T memSizeInBytes = (newPath.size() + 1) * sizeof(wchar_t);
                 StGlobalBlock globalBlock(GHND, memSizeInBytes);
                 if (globalBlock.Get() == NULL) {
-#ifdef PCC_DATA_HANDLER_LOGGING
-                    fil << L"GlobalAlloc failed!" << std::endl;
-#endif // PCC_DATA_HANDLER_LOGGING
                     hRes = STG_E_MEDIUMFULL;
                 } else {
                     // Lock the handle to access the memory and copy the path.
                     StGlobalLock rawBlock(globalBlock.Get());
                     void* pBlock = rawBlock.GetPtr();
                     if (pBlock == nullptr) {
-#ifdef PCC_DATA_HANDLER_LOGGING
-                        fil << L"GlobalLock failed!" << std::endl;
-#endif // PCC_DATA_HANDLER_LOGGING
                         hRes = STG_E_MEDIUMFULL;
                     } else {
                         ::memcpy(pBlock, newPath.c_str(), memSizeInBytes);
@@ -321,3 +302,23 @@ STDMETHODIMP CPathCopyCopyDataHandler::EnumDAdvise(
 {
     return E_NOTIMPL;
 }
+
+//
+// Returns the path of our file as computed by the default plugin.
+// The plugin is created the first time it is needed and used in the
+// context of the current plugins snapshot, and the path is cached.
+//
+// @return Path of file according to the default plugin.
+//
+const std::wstring& CPathCopyCopyDataHandler::GetPath()
+{
+    if (!m_Path.has_value()) {
+        if (m_spDefaultPlugin == nullptr) {
+            m_spPluginsSnapshot = PCC::PluginsSnapshot::Get();
+            m_spDefaultPlugin = std::make_shared<PCC::Plugins::DefaultPlugin>();
+        }
+        const PCC::ConversionContext& context = m_spPluginsSnapshot->GetConversionContext();
+        m_Path = m_spDefaultPlugin->GetPath(m_FileName, context);
+    }
+    return *m_Path;
+}
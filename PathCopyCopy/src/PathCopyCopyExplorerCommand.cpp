@@ -0,0 +1,579 @@
+// PathCopyCopyExplorerCommand.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+// Interfaces used by Explorer commands (IExplorerCommand, IShellItemArray, etc.)
+// are only declared by the SDK when targeting Windows 7 or later. This file thus
+// does not use the precompiled header, so that it can raise the target version.
+// These interfaces are only called through their vtables, so this does not add
+// imports that would prevent the DLL from loading on earlier versions of Windows.
+#define WINVER          0x0601
+#define _WIN32_WINNT    0x0601
+#define _WIN32_IE       0x0800
+
+#include <stdafx.h>
+#include <PathCopyCopyExplorerCommand.h>
+#include <PathCopyCopyContextMenuExt.h>
+#include <Plugin.h>
+#include <PluginsSnapshot.h>
+#include <PluginStatistics.h>
+#include <PluginUtils.h>
+
+#include <cwchar>
+#include <vector>
+
+
+namespace
+{
+    // Enumerator of Explorer sub-commands.
+    typedef ATL::CComEnum<IEnumExplorerCommand, &__uuidof(IEnumExplorerCommand),
+                          IExplorerCommand*, ATL::_CopyInterface<IExplorerCommand>> ExplorerCommandEnum;
+
+    //
+    // Returns a copy of a string allocated with CoTaskMemAlloc,
+    // as expected by Explorer command methods.
+    //
+    // @param p_String String to copy.
+    // @param p_ppString Where to store the copy.
+    // @return S_OK if successful, otherwise an error code.
+    //
+    HRESULT CopyString(const std::wstring& p_String,
+                       LPWSTR* const p_ppString)
+    {
+        HRESULT hRes = E_POINTER;
+        if (p_ppString != nullptr) {
+            *p_ppString = static_cast<LPWSTR>(::CoTaskMemAlloc((p_String.size() + 1) * sizeof(wchar_t)));
+            if (*p_ppString != nullptr) {
+                std::wmemcpy(*p_ppString, p_String.c_str(), p_String.size() + 1);
+                hRes = S_OK;
+            } else {
+                hRes = E_OUTOFMEMORY;
+            }
+        }
+        return hRes;
+    }
+
+    //
+    // Extracts the file system paths of items in a shell item array.
+    //
+    // @param p_pItems Shell item array.
+    // @param p_MaxFiles Maximum number of files to extract.
+    // @param p_rvFiles Where to store the files.
+    // @return true if files were extracted, false if array is empty
+    //         or if some items have no file system path.
+    //
+    bool GetFilesFromItems(IShellItemArray* const p_pItems,
+                           const DWORD p_MaxFiles,
+                           PCC::FilesV& p_rvFiles)
+    {
+        bool extracted = false;
+
+        DWORD itemCount = 0;
+        if (p_pItems != nullptr && SUCCEEDED(p_pItems->GetCount(&itemCount)) && itemCount > 0) {
+            itemCount = (std::min)(itemCount, p_MaxFiles);
+            PCC::FilesV vFiles;
+            vFiles.reserve(itemCount);
+            for (DWORD i = 0; i < itemCount; ++i) {
+                ATL::CComPtr<IShellItem> spItem;
+                LPWSTR pPath = nullptr;
+                if (FAILED(p_pItems->GetItemAt(i, &spItem)) || FAILED(spItem->GetDisplayName(SIGDN_FILESYSPATH, &pPath))) {
+                    break;
+                }
+                try {
+                    vFiles.push_back(pPath);
+                } catch (...) {
+                    ::CoTaskMemFree(pPath);
+                    throw;
+                }
+                ::CoTaskMemFree(pPath);
+            }
+            if (vFiles.size() == itemCount) {
+                p_rvFiles.swap(vFiles);
+                extracted = true;
+            }
+        }
+
+        return extracted;
+    }
+
+} // anonymous namespace
+
+// CPathCopyCopyExplorerCommand
+
+//
+// Constructor.
+//
+CPathCopyCopyExplorerCommand::CPathCopyCopyExplorerCommand()
+{
+}
+
+//
+// IExplorerCommand::GetTitle
+//
+// Returns the title of our command, e.g. the caption of our submenu.
+//
+// @param p_pItems Selected items; unused.
+// @param p_ppName Where to store the title.
+// @return S_OK if successful, otherwise an error code.
+//
+STDMETHODIMP CPathCopyCopyExplorerCommand::GetTitle(IShellItemArray* /*p_pItems*/,
+                                                    LPWSTR* p_ppName)
+{
+    HRESULT hRes = S_OK;
+    try {
+        std::wstring title = (LPCWSTR) ATL::CStringW(MAKEINTRESOURCEW(IDS_PATH_COPY_MENU_ITEM));
+        PCCDEBUGCODE(title += L" (DEBUG)");
+        hRes = CopyString(title, p_ppName);
+    } catch (...) {
+        hRes = E_UNEXPECTED;
+    }
+    return hRes;
+}
+
+//
+// IExplorerCommand::GetIcon
+//
+// Returns the icon of our command. Not supported.
+//
+// @param p_pItems Selected items; unused.
+// @param p_ppIcon Where to store the icon resource string.
+// @return E_NOTIMPL.
+//
+STDMETHODIMP CPathCopyCopyExplorerCommand::GetIcon(IShellItemArray* /*p_pItems*/,
+                                                   LPWSTR* p_ppIcon)
+{
+    if (p_ppIcon != nullptr) {
+        *p_ppIcon = nullptr;
+    }
+    return E_NOTIMPL;
+}
+
+//
+// IExplorerCommand::GetToolTip
+//
+// Returns the tooltip of our command.
+//
+// @param p_pItems Selected items; unused.
+// @param p_ppInfoTip Where to store the tooltip.
+// @return S_OK if successful, otherwise an error code.
+//
+STDMETHODIMP CPathCopyCopyExplorerCommand::GetToolTip(IShellItemArray* /*p_pItems*/,
+                                                      LPWSTR* p_ppInfoTip)
+{
+    HRESULT hRes = S_OK;
+    try {
+        hRes = CopyString((LPCWSTR) ATL::CStringW(MAKEINTRESOURCEW(IDS_PATH_COPY_HINT)), p_ppInfoTip);
+    } catch (...) {
+        hRes = E_UNEXPECTED;
+    }
+    return hRes;
+}
+
+//
+// IExplorerCommand::GetCanonicalName
+//
+// Returns the GUID identifying our command.
+//
+// @param p_pCommandName Where to store the GUID.
+// @return S_OK if successful, otherwise an error code.
+//
+STDMETHODIMP CPathCopyCopyExplorerCommand::GetCanonicalName(GUID* p_pCommandName)
+{
+    HRESULT hRes = E_POINTER;
+    if (p_pCommandName != nullptr) {
+        *p_pCommandName = CLSID_PathCopyCopyExplorerCommand;
+        hRes = S_OK;
+    }
+    return hRes;
+}
+
+//
+// IExplorerCommand::GetState
+//
+// Returns the state of our command. We're always enabled; the state of
+// each plugin is determined by its sub-command.
+//
+// @param p_pItems Selected items; unused.
+// @param p_OkToBeSlow Whether we can perform slow operations; unused.
+// @param p_pCmdState Where to store the state.
+// @return S_OK if successful, otherwise an error code.
+//
+STDMETHODIMP CPathCopyCopyExplorerCommand::GetState(IShellItemArray* /*p_pItems*/,
+                                                    BOOL /*p_OkToBeSlow*/,
+                                                    EXPCMDSTATE* p_pCmdState)
+{
+    HRESULT hRes = E_POINTER;
+    if (p_pCmdState != nullptr) {
+        *p_pCmdState = ECS_ENABLED;
+        hRes = S_OK;
+    }
+    return hRes;
+}
+
+//
+// IExplorerCommand::Invoke
+//
+// Invokes our command. Not supported since we only have sub-commands.
+//
+// @param p_pItems Selected items; unused.
+// @param p_pBindCtx Bind context; unused.
+// @return E_NOTIMPL.
+//
+STDMETHODIMP CPathCopyCopyExplorerCommand::Invoke(IShellItemArray* /*p_pItems*/,
+                                                  IBindCtx* /*p_pBindCtx*/)
+{
+    return E_NOTIMPL;
+}
+
+//
+// IExplorerCommand::GetFlags
+//
+// Returns flags of our command.
+//
+// @param p_pFlags Where to store the flags.
+// @return S_OK if successful, otherwise an error code.
+//
+STDMETHODIMP CPathCopyCopyExplorerCommand::GetFlags(EXPCMDFLAGS* p_pFlags)
+{
+    HRESULT hRes = E_POINTER;
+    if (p_pFlags != nullptr) {
+        *p_pFlags = ECF_HASSUBCOMMANDS;
+        hRes = S_OK;
+    }
+    return hRes;
+}
+
+//
+// IExplorerCommand::EnumSubCommands
+//
+// Returns an enumerator of our sub-commands, one per plugin displayed
+// in our submenu. Called by the shell only when our submenu is opened.
+//
+// @param p_ppEnum Where to store the enumerator.
+// @return S_OK if successful, otherwise an error code.
+//
+STDMETHODIMP CPathCopyCopyExplorerCommand::EnumSubCommands(IEnumExplorerCommand** p_ppEnum)
+{
+    HRESULT hRes = E_POINTER;
+
+    if (p_ppEnum != nullptr) {
+        *p_ppEnum = nullptr;
+        try {
+            // Get plugins to display in the submenu, like the contextual menu extension.
+            PCC::PluginsSnapshotSP spPluginsSnapshot = PCC::PluginsSnapshot::Get();
+            const PCC::PluginSPV* const pvspPlugins = &spPluginsSnapshot->GetSubmenuPlugins();
+
+            // Create a sub-command for each plugin, avoiding doubled-up separators.
+            std::vector<ATL::CComPtr<IExplorerCommand>> vspSubCommands;
+            bool prevWasSeparator = true;
+            hRes = S_OK;
+            for (auto it = pvspPlugins->cbegin(); SUCCEEDED(hRes) && it != pvspPlugins->cend(); ++it) {
+                const PCC::PluginSP& spPlugin = *it;
+                if (!spPlugin->IsSeparator() || !prevWasSeparator) {
+                    ATL::CComObject<CPathCopyCopyExplorerSubCommand>* pSubCommand = nullptr;
+                    hRes = ATL::CComObject<CPathCopyCopyExplorerSubCommand>::CreateInstance(&pSubCommand);
+                    if (SUCCEEDED(hRes)) {
+                        ATL::CComPtr<IExplorerCommand> spSubCommand(pSubCommand);
+                        pSubCommand->SetPlugin(spPluginsSnapshot, spPlugin);
+                        vspSubCommands.push_back(spSubCommand);
+                    }
+                    prevWasSeparator = spPlugin->IsSeparator();
+                }
+            }
+            if (SUCCEEDED(hRes) && prevWasSeparator && !vspSubCommands.empty()) {
+                vspSubCommands.pop_back();
+            }
+
+            // Create enumerator that will keep its own copy of the sub-commands.
+            ATL::CComObject<ExplorerCommandEnum>* pEnum = nullptr;
+            if (SUCCEEDED(hRes)) {
+                hRes = ATL::CComObject<ExplorerCommandEnum>::CreateInstance(&pEnum);
+            }
+            if (SUCCEEDED(hRes)) {
+                ATL::CComPtr<IEnumExplorerCommand> spEnum(pEnum);
+                std::vector<IExplorerCommand*> vpSubCommands;
+                vpSubCommands.reserve(vspSubCommands.size());
+                for (const auto& spSubCommand : vspSubCommands) {
+                    vpSubCommands.push_back(spSubCommand);
+                }
+                IExplorerCommand** const ppBegin = vpSubCommands.empty() ? nullptr : &vpSubCommands.front();
+                hRes = pEnum->Init(ppBegin, ppBegin + vpSubCommands.size(), nullptr, ATL::AtlFlagCopy);
+                if (SUCCEEDED(hRes)) {
+                    *p_ppEnum = spEnum.Detach();
+                }
+            }
+        } catch (...) {
+            hRes = E_UNEXPECTED;
+        }
+    }
+
+    return hRes;
+}
+
+// CPathCopyCopyExplorerSubCommand
+
+//
+// Constructor.
+//
+CPathCopyCopyExplorerSubCommand::CPathCopyCopyExplorerSubCommand()
+    : m_spPluginsSnapshot(),
+      m_spPlugin()
+{
+}
+
+//
+// Sets the plugin invoked by this sub-command. Must be called right after creation.
+//
+// @param p_spPluginsSnapshot Snapshot owning the plugin.
+// @param p_spPlugin Plugin to invoke; can be a separator.
+//
+void CPathCopyCopyExplorerSubCommand::SetPlugin(const PCC::PluginsSnapshotSP& p_spPluginsSnapshot,
+                                                const PCC::PluginSP& p_spPlugin)
+{
+    m_spPluginsSnapshot = p_spPluginsSnapshot;
+    m_spPlugin = p_spPlugin;
+}
+
+//
+// IExplorerCommand::GetTitle
+//
+// Returns the title of our sub-command, e.g. the plugin description.
+//
+// @param p_pItems Selected items; unused.
+// @param p_ppName Where to store the title.
+// @return S_OK if successful, otherwise an error code.
+//
+STDMETHODIMP CPathCopyCopyExplorerSubCommand::GetTitle(IShellItemArray* /*p_pItems*/,
+                                                       LPWSTR* p_ppName)
+{
+    HRESULT hRes = E_UNEXPECTED;
+    try {
+        if (m_spPlugin != nullptr) {
+            hRes = CopyString(m_spPlugin->Description(m_spPluginsSnapshot->GetConversionContext()), p_ppName);
+        }
+    } catch (...) {
+        hRes = E_UNEXPECTED;
+    }
+    return hRes;
+}
+
+//
+// IExplorerCommand::GetIcon
+//
+// Returns the icon of our sub-command, if the plugin has an icon file.
+//
+// @param p_pItems Selected items; unused.
+// @param p_ppIcon Where to store the icon resource string.
+// @return S_OK if successful, E_NOTIMPL if plugin has no icon, otherwise an error code.
+//
+STDMETHODIMP CPathCopyCopyExplorerSubCommand::GetIcon(IShellItemArray* /*p_pItems*/,
+                                                      LPWSTR* p_ppIcon)
+{
+    HRESULT hRes = E_NOTIMPL;
+    if (p_ppIcon != nullptr) {
+        *p_ppIcon = nullptr;
+    }
+    try {
+        if (m_spPlugin != nullptr) {
+            const std::wstring iconFile = m_spPlugin->IconFile();
+            if (!iconFile.empty()) {
+                hRes = CopyString(iconFile, p_ppIcon);
+            }
+        }
+    } catch (...) {
+        hRes = E_UNEXPECTED;
+    }
+    return hRes;
+}
+
+//
+// IExplorerCommand::GetToolTip
+//
+// Returns the tooltip of our sub-command, e.g. the plugin help text.
+//
+// @param p_pItems Selected items; unused.
+// @param p_ppInfoTip Where to store the tooltip.
+// @return S_OK if successful, E_NOTIMPL if plugin has no help text, otherwise an error code.
+//
+STDMETHODIMP CPathCopyCopyExplorerSubCommand::GetToolTip(IShellItemArray* /*p_pItems*/,
+                                                         LPWSTR* p_ppInfoTip)
+{
+    HRESULT hRes = E_NOTIMPL;
+    if (p_ppInfoTip != nullptr) {
+        *p_ppInfoTip = nullptr;
+    }
+    try {
+        if (m_spPlugin != nullptr) {
+            // Help texts are cached by the snapshot, since they're requested on every hover.
+            const std::wstring helpText = m_spPluginsSnapshot != nullptr
+                                        ? m_spPluginsSnapshot->GetHelpText(*m_spPlugin)
+                                        : m_spPlugin->HelpText();
+            if (!helpText.empty()) {
+                hRes = CopyString(helpText, p_ppInfoTip);
+            }
+        }
+    } catch (...) {
+        hRes = E_UNEXPECTED;
+    }
+    return hRes;
+}
+
+//
+// IExplorerCommand::GetCanonicalName
+//
+// Returns the GUID identifying our sub-command, e.g. the plugin ID.
+//
+// @param p_pCommandName Where to store the GUID.
+// @return S_OK if successful, otherwise an error code.
+//
+STDMETHODIMP CPathCopyCopyExplorerSubCommand::GetCanonicalName(GUID* p_pCommandName)
+{
+    HRESULT hRes = E_POINTER;
+    if (p_pCommandName != nullptr) {
+        hRes = E_UNEXPECTED;
+        if (m_spPlugin != nullptr) {
+            *p_pCommandName = m_spPlugin->Id();
+            hRes = S_OK;
+        }
+    }
+    return hRes;
+}
+
+//
+// IExplorerCommand::GetState
+//
+// Returns the state of our sub-command. Since plugins might need to perform
+// slow operations to determine if they are enabled (like looking up network
+// shares), we ask the shell to call us again when it's ok to be slow.
+//
+// @param p_pItems Selected items.
+// @param p_OkToBeSlow Whether we can perform slow operations.
+// @param p_pCmdState Where to store the state.
+// @return S_OK if successful, E_PENDING if we need to be slow,
+//         otherwise an error code.
+//
+STDMETHODIMP CPathCopyCopyExplorerSubCommand::GetState(IShellItemArray* p_pItems,
+                                                       BOOL p_OkToBeSlow,
+                                                       EXPCMDSTATE* p_pCmdState)
+{
+    HRESULT hRes = E_POINTER;
+
+    if (p_pCmdState != nullptr) {
+        try {
+            if (m_spPlugin == nullptr) {
+                hRes = E_UNEXPECTED;
+            } else if (m_spPlugin->IsSeparator()) {
+                *p_pCmdState = ECS_ENABLED;
+                hRes = S_OK;
+            } else if (p_OkToBeSlow == FALSE) {
+                hRes = E_PENDING;
+            } else {
+                // Plugins are only asked about the first file, like in the contextual menu.
+                PCC::FilesV vFiles;
+                if (GetFilesFromItems(p_pItems, 1, vFiles)) {
+                    std::wstring parentPath = vFiles.front();
+                    PCC::PluginUtils::ExtractFolderFromPath(parentPath);
+                    const bool enabled = PCC::PluginStatistics::Measure(m_spPlugin->Id(), PCC::PluginStatistics::Operation::Enabled, [&]() {
+                        return m_spPlugin->Enabled(parentPath, vFiles.front(), m_spPluginsSnapshot->GetConversionContext());
+                    });
+                    *p_pCmdState = enabled ? ECS_ENABLED : ECS_DISABLED;
+                } else {
+                    *p_pCmdState = ECS_HIDDEN;
+                }
+                hRes = S_OK;
+            }
+        } catch (...) {
+            hRes = E_UNEXPECTED;
+        }
+    }
+
+    return hRes;
+}
+
+//
+// IExplorerCommand::Invoke
+//
+// Invokes our sub-command by performing the plugin's action on selected
+// items. This is delegated to the contextual menu extension.
+//
+// @param p_pItems Selected items.
+// @param p_pBindCtx Bind context; unused.
+// @return S_OK if successful, otherwise an error code.
+//
+STDMETHODIMP CPathCopyCopyExplorerSubCommand::Invoke(IShellItemArray* p_pItems,
+                                                     IBindCtx* /*p_pBindCtx*/)
+{
+    HRESULT hRes = E_INVALIDARG;
+
+    try {
+        PCC::FilesV vFiles;
+        if (m_spPlugin != nullptr && !m_spPlugin->IsSeparator() && GetFilesFromItems(p_pItems, MAXDWORD, vFiles)) {
+            ATL::CComObject<CPathCopyCopyContextMenuExt>* pContextMenuExt = nullptr;
+            hRes = ATL::CComObject<CPathCopyCopyContextMenuExt>::CreateInstance(&pContextMenuExt);
+            if (SUCCEEDED(hRes)) {
+                ATL::CComPtr<IContextMenu> spContextMenuExt(pContextMenuExt);
+                hRes = pContextMenuExt->InitializeWithFiles(vFiles);
+                if (SUCCEEDED(hRes)) {
+                    hRes = pContextMenuExt->ActOnFilesWithPlugin(m_spPlugin->Id(), NULL);
+                }
+            }
+        }
+    } catch (...) {
+        hRes = E_UNEXPECTED;
+    }
+
+    return hRes;
+}
+
+//
+// IExplorerCommand::GetFlags
+//
+// Returns flags of our sub-command.
+//
+// @param p_pFlags Where to store the flags.
+// @return S_OK if successful, otherwise an error code.
+//
+STDMETHODIMP CPathCopyCopyExplorerSubCommand::GetFlags(EXPCMDFLAGS* p_pFlags)
+{
+    HRESULT hRes = E_POINTER;
+    if (p_pFlags != nullptr) {
+        *p_pFlags = m_spPlugin != nullptr && m_spPlugin->IsSeparator() ? ECF_ISSEPARATOR : ECF_DEFAULT;
+        hRes = S_OK;
+    }
+    return hRes;
+}
+
+//
+// IExplorerCommand::EnumSubCommands
+//
+// Returns an enumerator of sub-commands. Not supported since
+// plugins do not have sub-commands.
+//
+// @param p_ppEnum Where to store the enumerator.
+// @return E_NOTIMPL.
+//
+STDMETHODIMP CPathCopyCopyExplorerSubCommand::EnumSubCommands(IEnumExplorerCommand** p_ppEnum)
+{
+    if (p_ppEnum != nullptr) {
+        *p_ppEnum = nullptr;
+    }
+    return E_NOTIMPL;
+}
@@ -21,8 +21,13 @@
 
 #include <stdafx.h>
 #include <PathCopyCopyPluginsRegistry.h>
+#include <COMPluginMetadataCache.h>
+#include <COMPluginPool.h>
 #include <PathCopyCopySettings.h>
 #include <PluginSeparator.h>
+#include <StCoInitialize.h>
+#include <ThreadPool.h>
+#include <Trace.h>
 
 #include <CygwinPathPlugin.h>
 #include <InternetPathPlugin.h>
@@ -40,11 +45,64 @@
 #include <UnixPathPlugin.h>
 #include <WSLPathPlugin.h>
 #include <MSYSPathPlugin.h>
+#include <OneDriveURLPlugin.h>
+#include <RepositoryPathPlugin.h>
 
 #include <algorithm>
+#include <condition_variable>
+#include <functional>
 #include <iterator>
+#include <mutex>
+#include <string>
 #include <utility>
 
+#include <atlbase.h>
+
+
+namespace
+{
+    // Maximum number of COM plugins activated in parallel when building the plugins list.
+    const size_t            MAX_COM_PLUGIN_ACTIVATION_TASKS = 8;
+
+    // Registry keys and values describing COM servers.
+    const wchar_t* const    CLSID_KEY_PREFIX                = L"CLSID\\";
+    const wchar_t* const    INPROC_SERVER_SUBKEY            = L"\\InprocServer32";
+    const wchar_t* const    THREADING_MODEL_VALUE           = L"ThreadingModel";
+
+    //
+    // Checks if a COM plugin can be activated on a worker thread in the
+    // multi-threaded apartment. This is the case for out-of-process servers
+    // and for in-process servers whose threading model supports the MTA;
+    // in-process servers that require an STA would be created in a separate
+    // apartment by COM anyway, which would not save any time.
+    //
+    // @param p_CLSID ID of COM plugin.
+    // @return true if plugin can be activated on a worker thread.
+    //
+    bool CanActivateInMTA(const CLSID& p_CLSID)
+    {
+        wchar_t clsidAsString[64] = { 0 };
+        if (::StringFromGUID2(p_CLSID, clsidAsString, _countof(clsidAsString)) == 0) {
+            return false;
+        }
+        std::wstring inProcKeyPath(CLSID_KEY_PREFIX);
+        inProcKeyPath += clsidAsString;
+        inProcKeyPath += INPROC_SERVER_SUBKEY;
+
+        ATL::CRegKey inProcKey;
+        if (inProcKey.Open(HKEY_CLASSES_ROOT, inProcKeyPath.c_str(), KEY_READ) != ERROR_SUCCESS) {
+            // Not an in-process server (or not registered at all, in which case activation fails fast).
+            return true;
+        }
+        wchar_t threadingModel[32] = { 0 };
+        ULONG chars = _countof(threadingModel);
+        return inProcKey.QueryStringValue(THREADING_MODEL_VALUE, threadingModel, &chars) == ERROR_SUCCESS &&
+               (::_wcsicmp(threadingModel, L"Both") == 0 ||
+                ::_wcsicmp(threadingModel, L"Free") == 0 ||
+                ::_wcsicmp(threadingModel, L"Neutral") == 0);
+    }
+
+} // anonymous namespace
 
 namespace PCC
 {
@@ -65,6 +123,7 @@ namespace PCC
                                                         const bool p_IncludeTempPipelinePlugins)
     {
         PluginSPV vspPlugins;
+        StTraceEvent traceEvent(L"PluginsRegistry::GetPluginsInDefaultOrder");
         
         // Default plugins
         GetDefaultPlugins(vspPlugins);
@@ -79,9 +138,86 @@ namespace PCC
             GetPipelinePlugins(*p_pPipelinePluginProvider, p_IncludeTempPipelinePlugins, vspPlugins);
         }
 
+        traceEvent.SetCount(vspPlugins.size());
         return vspPlugins;
     }
 
+    //
+    // Returns a specific plugin along with all plugins it references, directly
+    // or indirectly (for example through ApplyPluginPipelineElement). This is
+    // useful when a single plugin needs to be invoked: COM plugins that are
+    // not needed are never created.
+    //
+    // @param p_PluginId ID of plugin to return.
+    // @param p_pCOMPluginProvider Optional object to acces COM plugins. If nullptr, COM plugins
+    //                             will not be included in the returned set.
+    // @param p_pPipelinePluginProvider Optional object to access pipeline plugins. If nullptr,
+    //                                  pipeline plugins will not be included in the returned set.
+    // @param p_IncludeTempPipelinePlugins Whether to also consider temporary pipeline plugins.
+    //                                     Ignored if p_pPipelinePluginProvider is nullptr.
+    // @return Set containing the plugin and all plugins it references. Will not contain
+    //         the requested plugin if it could not be found.
+    //
+    PluginSPS PluginsRegistry::GetPluginWithReferencedPlugins(const GUID& p_PluginId,
+                                                              const COMPluginProvider* const p_pCOMPluginProvider,
+                                                              const PipelinePluginProvider* const p_pPipelinePluginProvider,
+                                                              const bool p_IncludeTempPipelinePlugins)
+    {
+        // Default and pipeline plugins are cheap to create, so load them all.
+        PluginSPV vspCandidates;
+        GetDefaultPlugins(vspCandidates);
+        if (p_pPipelinePluginProvider != nullptr) {
+            p_pPipelinePluginProvider->GetPipelinePlugins(vspCandidates);
+            if (p_IncludeTempPipelinePlugins) {
+                p_pPipelinePluginProvider->GetTempPipelinePlugins(vspCandidates);
+            }
+        }
+        PluginSPS sspCandidates;
+        for (const PluginSP& spCandidate : vspCandidates) {
+            if (!spCandidate->IsSeparator()) {
+                sspCandidates.insert(spCandidate);
+            }
+        }
+
+        // COM plugins will only be created if they are needed.
+        CLSIDS sCOMPluginCLSIDs;
+        if (p_pCOMPluginProvider != nullptr) {
+            const CLSIDV vCOMPluginCLSIDs = p_pCOMPluginProvider->GetCOMPlugins();
+            sCOMPluginCLSIDs.insert(vCOMPluginCLSIDs.cbegin(), vCOMPluginCLSIDs.cend());
+        }
+
+        // Load the requested plugin, then everything it references.
+        // Plugins already loaded are skipped, which protects against cycles.
+        PluginSPS sspPlugins;
+        GUIDV vPendingIds(1, p_PluginId);
+        while (!vPendingIds.empty()) {
+            const GUID pluginId = vPendingIds.back();
+            vPendingIds.pop_back();
+            if (sspPlugins.find(pluginId) != sspPlugins.end()) {
+                continue;
+            }
+
+            PluginSP spPlugin;
+            auto candidateIt = sspCandidates.find(pluginId);
+            if (candidateIt != sspCandidates.end()) {
+                spPlugin = *candidateIt;
+            } else if (sCOMPluginCLSIDs.find(pluginId) != sCOMPluginCLSIDs.end()) {
+                try {
+                    spPlugin = COMPluginPool::GetPlugin(pluginId, p_pCOMPluginProvider->CanReuseCOMPlugin(pluginId),
+                                                        p_pCOMPluginProvider->ShouldIsolateCOMPlugin(pluginId));
+                } catch (const Plugins::COMPluginError&) {
+                    // The plugin is not functional, simply skip it.
+                }
+            }
+            if (spPlugin != nullptr) {
+                sspPlugins.insert(spPlugin);
+                spPlugin->GetReferencedPlugins(vPendingIds);
+            }
+        }
+
+        return sspPlugins;
+    }
+
     //
     // Given a vector of plugin IDs that specifies a plugin display order,
     // orders plugins found in a set of all plugins and returns a vector of
@@ -102,9 +238,40 @@ namespace PCC
                                                      const GUIDV& p_vPluginDisplayOrder,
                                                      const GUIDV* const p_pvKnownPlugins,
                                                      const PluginSPV* const p_pvspPluginsInDefaultOrder)
+    {
+        GUIDV vUnknownPlugins;
+        if (p_pvKnownPlugins != nullptr) {
+            vUnknownPlugins = GetUnknownPlugins(p_sspAllPlugins, *p_pvKnownPlugins);
+        }
+        return OrderPluginsToDisplayWithUnknownPlugins(p_sspAllPlugins, p_vPluginDisplayOrder,
+                                                       p_pvKnownPlugins != nullptr ? &vUnknownPlugins : nullptr,
+                                                       p_pvspPluginsInDefaultOrder);
+    }
+
+    //
+    // Same as OrderPluginsToDisplay, but using a list of unknown plugins that
+    // has already been computed via GetUnknownPlugins. Useful when ordering
+    // several lists of plugins using the same known plugins.
+    //
+    // @param p_sspAllPlugins Set containing all plugins.
+    // @param p_vPluginDisplayOrder Vector of plugin IDs specifying display order.
+    // @param p_pvUnknownPlugins Optional sorted list of unknown plugins, as returned
+    //                           by GetUnknownPlugins. If set, these plugins will be
+    //                           added at the end of the plugins to display.
+    // @param p_pvspPluginsInDefaultOrder Optional list of plugins in default order.
+    //                                    If set, should correspond to the default
+    //                                    way to display plugins in p_sspAllPlugins.
+    //                                    Ignored if p_pvUnknownPlugins is nullptr.
+    // @return Vector of plugins in the order they should be displayed.
+    //
+    PluginSPV PluginsRegistry::OrderPluginsToDisplayWithUnknownPlugins(const PluginSPS& p_sspAllPlugins,
+                                                                       const GUIDV& p_vPluginDisplayOrder,
+                                                                       const GUIDV* const p_pvUnknownPlugins,
+                                                                       const PluginSPV* const p_pvspPluginsInDefaultOrder)
     {
         // First generate list of plugins from display order.
         PluginSPV vspPlugins;
+        vspPlugins.reserve(p_vPluginDisplayOrder.size());
         for (const GUID& pluginId : p_vPluginDisplayOrder) {
             auto it = p_sspAllPlugins.find(pluginId);
             if (it != p_sspAllPlugins.end()) {
@@ -112,60 +279,42 @@ namespace PCC
             }
         }
 
-        // If we have a list of known plugins, add all unknown plugins
-        // after those specified in the display order.
-        if (p_pvKnownPlugins != nullptr) {
-            // Sort known plugins to be able to perform a set difference.
-            GUIDV vKnownPlugins(*p_pvKnownPlugins);
+        // If we have a list of unknown plugins, add them after
+        // those specified in the display order.
+        if (p_pvUnknownPlugins != nullptr && !p_pvUnknownPlugins->empty()) {
+            const GUIDV& vUnknownPlugins = *p_pvUnknownPlugins;
             GUIDLess guidLess;
-            std::sort(vKnownPlugins.begin(), vKnownPlugins.end(), guidLess);
 
-            // Create vector of plugin IDs for all plugins.
-            GUIDV vAllPlugins;
-            vAllPlugins.reserve(p_sspAllPlugins.size());
-            for (const PluginSP& spPlugin : p_sspAllPlugins) {
-                vAllPlugins.push_back(spPlugin->Id());
+            // Add a separator if needed, then add unknown plugins to the returned vector.
+            if (!vspPlugins.empty() && !vspPlugins.back()->IsSeparator()) {
+                vspPlugins.push_back(std::make_shared<PluginSeparator>());
             }
+            if (p_pvspPluginsInDefaultOrder != nullptr) {
+                // We know how to display plugins in default order: scan that
+                // list and add all unknown plugins. This will probably help
+                // display them in correct order.
+                auto defEnd = p_pvspPluginsInDefaultOrder->cend();
+                for (auto defIt = p_pvspPluginsInDefaultOrder->cbegin(); defIt != defEnd; ++defIt) {
+                    if (std::binary_search(vUnknownPlugins.cbegin(), vUnknownPlugins.cend(), (*defIt)->Id(), guidLess)) {
+                        // This is an unknown plugin, add it.
+                        vspPlugins.push_back(*defIt);
 
-            // Substract known plugins from list of all plugins to find unknown plugins.
-            GUIDV vUnknownPlugins;
-            std::set_difference(vAllPlugins.cbegin(), vAllPlugins.cend(),
-                                vKnownPlugins.cbegin(), vKnownPlugins.cend(),
-                                std::inserter(vUnknownPlugins, vUnknownPlugins.end()),
-                                guidLess);
-            if (!vUnknownPlugins.empty()) {
-                // We have unknown plugins. Add a separator if needed, then add them
-                // to the returned vector.
-                if (!vspPlugins.empty() && !vspPlugins.back()->IsSeparator()) {
-                    vspPlugins.push_back(std::make_shared<PluginSeparator>());
-                }
-                if (p_pvspPluginsInDefaultOrder != nullptr) {
-                    // We know how to display plugins in default order: scan that
-                    // list and add all unknown plugins. This will probably help
-                    // display them in correct order.
-                    auto defEnd = p_pvspPluginsInDefaultOrder->cend();
-                    for (auto defIt = p_pvspPluginsInDefaultOrder->cbegin(); defIt != defEnd; ++defIt) {
-                        if (std::binary_search(vUnknownPlugins.cbegin(), vUnknownPlugins.cend(), (*defIt)->Id(), guidLess)) {
-                            // This is an unknown plugin, add it.
-                            vspPlugins.push_back(*defIt);
-
-                            // If it's followed by a separator, add it also. This takes care
-                            // of preserving COM plugin grouping.
-                            auto defNext(defIt);
-                            ++defNext;
-                            if (defNext != defEnd && (*defNext)->IsSeparator()) {
-                                vspPlugins.push_back(*defNext);
-                            }
+                        // If it's followed by a separator, add it also. This takes care
+                        // of preserving COM plugin grouping.
+                        auto defNext(defIt);
+                        ++defNext;
+                        if (defNext != defEnd && (*defNext)->IsSeparator()) {
+                            vspPlugins.push_back(*defNext);
                         }
                     }
-                } else {
-                    // No info on how to display plugins, simply add them in
-                    // a possibly-random order.
-                    for (const GUID& unknownPluginId : vUnknownPlugins) {
-                        auto it = p_sspAllPlugins.find(unknownPluginId);
-                        if (it != p_sspAllPlugins.end()) {
-                            vspPlugins.push_back(*it);
-                        }
+                }
+            } else {
+                // No info on how to display plugins, simply add them in
+                // a possibly-random order.
+                for (const GUID& unknownPluginId : vUnknownPlugins) {
+                    auto it = p_sspAllPlugins.find(unknownPluginId);
+                    if (it != p_sspAllPlugins.end()) {
+                        vspPlugins.push_back(*it);
                     }
                 }
             }
@@ -175,6 +324,38 @@ namespace PCC
         return vspPlugins;
     }
 
+    //
+    // Given a list of known plugins, returns the IDs of all plugins in a set
+    // of all plugins that are not in that list.
+    //
+    // @param p_sspAllPlugins Set containing all plugins.
+    // @param p_vKnownPlugins List of known plugins.
+    // @return Sorted vector of IDs of unknown plugins.
+    //
+    GUIDV PluginsRegistry::GetUnknownPlugins(const PluginSPS& p_sspAllPlugins,
+                                             const GUIDV& p_vKnownPlugins)
+    {
+        // Sort known plugins to be able to perform a set difference.
+        GUIDV vKnownPlugins(p_vKnownPlugins);
+        GUIDLess guidLess;
+        std::sort(vKnownPlugins.begin(), vKnownPlugins.end(), guidLess);
+
+        // Create vector of plugin IDs for all plugins.
+        GUIDV vAllPlugins;
+        vAllPlugins.reserve(p_sspAllPlugins.size());
+        for (const PluginSP& spPlugin : p_sspAllPlugins) {
+            vAllPlugins.push_back(spPlugin->Id());
+        }
+
+        // Substract known plugins from list of all plugins to find unknown plugins.
+        GUIDV vUnknownPlugins;
+        std::set_difference(vAllPlugins.cbegin(), vAllPlugins.cend(),
+                            vKnownPlugins.cbegin(), vKnownPlugins.cend(),
+                            std::inserter(vUnknownPlugins, vUnknownPlugins.end()),
+                            guidLess);
+        return vUnknownPlugins;
+    }
+
     //
     // Returns all default (e.g. built-in) plugins in the default order.
     //
@@ -212,6 +393,7 @@ namespace PCC
         p_rvspPlugins.push_back(spSeparator);
         p_rvspPlugins.push_back(std::make_shared<Plugins::InternetPathPlugin>());
         p_rvspPlugins.push_back(std::make_shared<Plugins::SambaPathPlugin>());
+        p_rvspPlugins.push_back(std::make_shared<Plugins::OneDriveURLPlugin>());
 
         // *NIX plugins
         p_rvspPlugins.push_back(spSeparator);
@@ -219,6 +401,10 @@ namespace PCC
         p_rvspPlugins.push_back(std::make_shared<Plugins::CygwinPathPlugin>());
         p_rvspPlugins.push_back(std::make_shared<Plugins::WSLPathPlugin>());
         p_rvspPlugins.push_back(std::make_shared<Plugins::MSYSPathPlugin>());
+
+        // Repository plugins
+        p_rvspPlugins.push_back(spSeparator);
+        p_rvspPlugins.push_back(std::make_shared<Plugins::RepositoryPathPlugin>());
     }
 
     //
@@ -233,14 +419,22 @@ namespace PCC
     {
         // Get list of COM plugins from settings.
         CLSIDV vPluginCLSIDs = p_COMPluginProvider.GetCOMPlugins();
+
+        // Release pooled plugins that are no longer registered.
+        COMPluginPool::KeepOnly(vPluginCLSIDs);
         if (!vPluginCLSIDs.empty()) {
+            // Activate plugins that have no cached metadata in parallel first, so that
+            // the loop below can create them from their cached metadata.
+            PrefetchCOMPluginMetadata(p_COMPluginProvider, vPluginCLSIDs);
+
             // Load list of plugins by creating the COM objects and store group IDs and positions.
             COMPluginInfoV vCOMPluginInfos;
             for (const CLSID& clsid : vPluginCLSIDs) {
                 try {
                     COMPluginInfo pluginInfo;
                     pluginInfo.m_CLSID = clsid;
-                    pluginInfo.m_spPlugin = std::make_shared<Plugins::COMPlugin>(clsid);
+                    pluginInfo.m_spPlugin = COMPluginPool::GetPlugin(clsid, p_COMPluginProvider.CanReuseCOMPlugin(clsid),
+                                                                     p_COMPluginProvider.ShouldIsolateCOMPlugin(clsid));
                     pluginInfo.m_GroupId = pluginInfo.m_spPlugin->GroupId();
                     pluginInfo.m_GroupPosition = pluginInfo.m_spPlugin->GroupPosition();
 
@@ -275,6 +469,89 @@ namespace PCC
         }
     }
 
+    //
+    // Makes sure metadata of the given COM plugins is cached. Plugins that
+    // have no valid cached metadata (or recorded failure) are activated in
+    // parallel on worker threads, where their metadata is cached before
+    // they are released; plugins can then be created from cached metadata
+    // on the calling thread and will only be activated there when used.
+    // Plugins that cannot be activated in the multi-threaded apartment
+    // are skipped and will be activated by the caller as usual.
+    //
+    // @param p_COMPluginProvider Object to access registered COM plugins.
+    // @param p_vPluginCLSIDs IDs of COM plugins.
+    //
+    void PluginsRegistry::PrefetchCOMPluginMetadata(const COMPluginProvider& p_COMPluginProvider,
+                                                    const CLSIDV& p_vPluginCLSIDs)
+    {
+        // Shared state of the activation tasks.
+        struct Activation {
+            std::vector<std::pair<CLSID, bool>>
+                                    m_vPlugins;     // Plugins to activate, along with whether they are isolated.
+            size_t                  m_NextPlugin;   // Index of next plugin to activate.
+            size_t                  m_Remaining;    // Number of tasks still running.
+            std::mutex              m_Lock;         // Lock protecting the state.
+            std::condition_variable m_Completed;    // Signaled when all tasks are done.
+        };
+        auto spActivation = std::make_shared<Activation>();
+        spActivation->m_NextPlugin = 0;
+        spActivation->m_Remaining = 0;
+        for (const CLSID& clsid : p_vPluginCLSIDs) {
+            Plugins::COMPluginMetadata metadata;
+            HRESULT failure = S_OK;
+            if (!COMPluginMetadataCache::Get(clsid, metadata) &&
+                !COMPluginMetadataCache::GetFailure(clsid, failure)) {
+
+                const bool isolated = p_COMPluginProvider.ShouldIsolateCOMPlugin(clsid);
+                if (isolated || CanActivateInMTA(clsid)) {
+                    spActivation->m_vPlugins.emplace_back(clsid, isolated);
+                }
+            }
+        }
+
+        // Activating a single plugin on a worker thread would not save any time.
+        if (spActivation->m_vPlugins.size() < 2) {
+            return;
+        }
+        StTraceEvent traceEvent(L"PluginsRegistry::PrefetchCOMPluginMetadata");
+        traceEvent.SetCount(spActivation->m_vPlugins.size());
+
+        auto activatePlugins = [](const std::shared_ptr<Activation>& p_spActivation) {
+            StCoInitialize coInit(COINIT_MULTITHREADED);
+            std::unique_lock<std::mutex> lock(p_spActivation->m_Lock);
+            while (p_spActivation->m_NextPlugin < p_spActivation->m_vPlugins.size()) {
+                const auto plugin = p_spActivation->m_vPlugins[p_spActivation->m_NextPlugin++];
+                lock.unlock();
+                if (SUCCEEDED(coInit.GetInitResult())) {
+                    try {
+                        Plugins::COMPlugin comPlugin(plugin.first, plugin.second);
+                        COMPluginMetadataCache::Update(plugin.first, comPlugin.GetMetadata());
+                    } catch (const Plugins::COMPluginError& error) {
+                        COMPluginMetadataCache::SetFailure(plugin.first, error.Result());
+                    }
+                }
+                lock.lock();
+            }
+            if (--p_spActivation->m_Remaining == 0) {
+                p_spActivation->m_Completed.notify_all();
+            }
+        };
+        const size_t numTasks = (std::min)(spActivation->m_vPlugins.size(), MAX_COM_PLUGIN_ACTIVATION_TASKS);
+        for (size_t i = 0; i < numTasks; ++i) {
+            std::lock_guard<std::mutex> lock(spActivation->m_Lock);
+            try {
+                ThreadPool::Submit(std::bind(activatePlugins, spActivation), ThreadPool::Priority::High);
+                ++spActivation->m_Remaining;
+            } catch (...) {
+                // Could not submit task; plugins not activated will be activated by the caller.
+                break;
+            }
+        }
+
+        std::unique_lock<std::mutex> lock(spActivation->m_Lock);
+        spActivation->m_Completed.wait(lock, [&]() { return spActivation->m_Remaining == 0; });
+    }
+
     //
     // Adds all pipeline plugins to the given vector.
     //
@@ -22,13 +22,31 @@
 #include <stdafx.h>
 #include <AllPluginsProvider.h>
 #include <AtlRegKey.h>
+#include <MachineNetworkCache.h>
+#include <MetadataExporter.h>
 #include <PathCopyCopyRunDll32EntryPoints.h>
 #include <PathCopyCopyPluginsRegistry.h>
 #include <PathCopyCopySettings.h>
+#include <PathStreamConverter.h>
+#include <PipelinePlugin.h>
+#include <PluginPipeline.h>
+#include <PluginPipelineDecoder.h>
+#include <PluginPipelineElements.h>
+#include <PluginUtils.h>
+#include <PluginsSnapshot.h>
+#include <ResidentService.h>
+#include <SettingsSnapshot.h>
 #include <StClipboard.h>
 #include <StCoInitialize.h>
 #include <StGlobalBlock.h>
 #include <StGlobalLock.h>
+#include <StringUtils.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
+#include <crtdbg.h>
 
 
 namespace
@@ -36,8 +54,237 @@ namespace
     // Separator used in the rundll32 command-line.
     const wchar_t   RUNDLL32_CMDLINE_SEPARATOR  = L',';
 
+    // Separator used between paths passed to/returned by GetPathsWithPipelineW.
+    const wchar_t   PIPELINE_PATHS_SEPARATOR    = L'\n';
+
     // Registry key in HKEY_CURRENT_USER where to output rundll32 results.
-    const wchar_t   PCC_RUNDLL32_OUTPUT_KEY[]   = L"Software\\clechasseur\\PathCopyCopy\\Rundll32Output";
+    const wchar_t   PCC_RUNDLL32_OUTPUT_KEY[]   = L"Software\\clechasseur\\PathCopyCopyCache\\Rundll32Output";
+
+    // File list name used to read the list of files to convert from stdin.
+    const wchar_t   STDIN_FILE_LIST[]           = L"-";
+
+    // Default separator used between paths when converting multiple files.
+    const wchar_t   DEFAULT_PATHS_SEPARATOR[]   = L"\r\n";
+
+    // Separator used between the fields of each element returned by ProfilePipelineW.
+    const wchar_t   PROFILE_FIELDS_SEPARATOR    = L'\t';
+
+#if defined(PCC_BENCHMARKS) && defined(_DEBUG)
+    // ID of thread whose allocations are counted by CountAllocations.
+    std::atomic<DWORD>  g_ProfiledThreadId(0);
+
+    // Number of allocations performed by the profiled thread.
+    long long           g_ProfiledAllocations = 0;
+
+    //
+    // CRT allocation hook that counts the allocations performed
+    // by the thread profiling a pipeline (see ProfilePipelineW).
+    //
+    // @param p_AllocType Type of operation.
+    // @param p_BlockType Type of memory block.
+    // @return TRUE to let the operation proceed.
+    //
+    int __cdecl CountAllocations(int p_AllocType,
+                                 void* /*p_pUserData*/,
+                                 size_t /*p_Size*/,
+                                 int p_BlockType,
+                                 long /*p_RequestNumber*/,
+                                 const unsigned char* /*p_pFileName*/,
+                                 int /*p_LineNumber*/)
+    {
+        if ((p_AllocType == _HOOK_ALLOC || p_AllocType == _HOOK_REALLOC) && p_BlockType != _CRT_BLOCK &&
+            ::GetCurrentThreadId() == g_ProfiledThreadId.load(std::memory_order_relaxed)) {
+
+            ++g_ProfiledAllocations;
+        }
+        return TRUE;
+    }
+
+    //
+    // Stack-based class that counts the allocations performed by
+    // the current thread using CountAllocations while it exists.
+    //
+    class StAllocationCounter final
+    {
+    public:
+        StAllocationCounter()
+            : m_pPreviousHook(nullptr)
+        {
+            g_ProfiledAllocations = 0;
+            g_ProfiledThreadId = ::GetCurrentThreadId();
+            m_pPreviousHook = _CrtSetAllocHook(&CountAllocations);
+        }
+        StAllocationCounter(const StAllocationCounter&) = delete;
+        StAllocationCounter& operator=(const StAllocationCounter&) = delete;
+        ~StAllocationCounter()
+        {
+            _CrtSetAllocHook(m_pPreviousHook);
+            g_ProfiledThreadId = 0;
+        }
+
+    private:
+        _CRT_ALLOC_HOOK m_pPreviousHook;    // Hook installed before ours.
+    };
+#endif // PCC_BENCHMARKS && _DEBUG
+
+    //
+    // Reads a list of files to convert, one per line. The list can be stored
+    // in UTF-8 or in UTF-16 (with BOM). Empty lines are ignored.
+    //
+    // @param p_FileList Path to the file containing the list, or "-" to read
+    //                   the list from the standard input.
+    // @param p_rvFiles Where to store the files read.
+    // @return true if the list could be read.
+    //
+    bool ReadFileList(const std::wstring& p_FileList,
+                      PCC::FilesV& p_rvFiles)
+    {
+        p_rvFiles.clear();
+
+        // Open the list file or use stdin.
+        ATL::CHandle hListFile;
+        HANDLE hInput = NULL;
+        if (p_FileList == STDIN_FILE_LIST) {
+            hInput = ::GetStdHandle(STD_INPUT_HANDLE);
+        } else {
+            HANDLE hFile = ::CreateFileW(p_FileList.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                         OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+            if (hFile != INVALID_HANDLE_VALUE) {
+                hListFile.Attach(hFile);
+                hInput = hListFile;
+            }
+        }
+        if (hInput == NULL || hInput == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+
+        // Read all data and convert it to a wide string.
+        std::wstring list;
+        if (!PCC::PluginUtils::ReadText(hInput, list)) {
+            return false;
+        }
+
+        // Split in lines, skipping empty lines.
+        PCC::WStringV vLines;
+        StringUtils::Split(list, L'\n', vLines);
+        for (std::wstring& line : vLines) {
+            if (!line.empty() && line.back() == L'\r') {
+                line.pop_back();
+            }
+            if (!line.empty()) {
+                p_rvFiles.push_back(std::move(line));
+            }
+        }
+        return true;
+    }
+
+    //
+    // Converts a list of files using the given plugin and joins the resulting
+    // paths. Plugins needed are loaded only once for the entire list.
+    //
+    // @param p_PluginId ID of plugin to use.
+    // @param p_vFiles Files to convert.
+    // @param p_rResult Where to store the resulting paths, joined using the
+    //                  plugin's paths separator.
+    // @return true if files were converted.
+    //
+    bool GetPathsWithPlugin(const CLSID& p_PluginId,
+                            const PCC::FilesV& p_vFiles,
+                            std::wstring& p_rResult)
+    {
+        p_rResult.clear();
+
+        PCC::Settings settings;
+        settings.Snapshot();
+        PCC::PluginSPS sspAllPlugins = PCC::PluginsRegistry::GetPluginWithReferencedPlugins(p_PluginId, &settings, &settings, true);
+        PCC::AllPluginsProvider pluginProvider(sspAllPlugins);
+        const PCC::SettingsSnapshot settingsSnapshot(settings);
+        const PCC::ConversionContext context(&settings, &settingsSnapshot, &pluginProvider);
+        auto it = sspAllPlugins.find(p_PluginId);
+        if (it == sspAllPlugins.end()) {
+            return false;
+        }
+
+        // Convert all files at once so that the plugin can share work between them.
+        const PCC::PluginSP& spPlugin = *it;
+        const PCC::ExportFormat exportFormat = spPlugin->GetExportFormat();
+        std::wstring pathsSeparator = exportFormat != PCC::ExportFormat::None ? PCC::MetadataExporter::RecordsSeparator(exportFormat)
+                                                                               : spPlugin->PathsSeparator();
+        if (pathsSeparator.empty()) {
+            pathsSeparator = settings.GetPathsSeparator();
+            if (pathsSeparator.empty()) {
+                pathsSeparator = DEFAULT_PATHS_SEPARATOR;
+            }
+        }
+        const PCC::WStringV vPaths = PCC::MetadataExporter::FormatRecords(exportFormat, p_vFiles,
+            PCC::PluginUtils::GetPathsInParallel(*spPlugin, p_vFiles, context));
+        for (auto pathIt = vPaths.cbegin(); pathIt != vPaths.cend(); ++pathIt) {
+            if (pathIt != vPaths.cbegin()) {
+                p_rResult += pathsSeparator;
+            }
+            p_rResult += *pathIt;
+        }
+        return true;
+    }
+
+    //
+    // Copies the given text to the clipboard.
+    //
+    // @param p_hWnd Window handle to use when opening the clipboard.
+    // @param p_Text Text to copy.
+    //
+    void CopyTextToClipboard(HWND const p_hWnd,
+                             const std::wstring& p_Text)
+    {
+        StClipboard acquireClipboard(p_hWnd);
+        if (acquireClipboard.InitResult()) {
+            // Allocate global block to store text.
+            const size_t blockNumElements = p_Text.size() + 1;
+            const size_t blockSize = blockNumElements * sizeof(wchar_t);
+            StGlobalBlock memBlock(GMEM_MOVEABLE, blockSize);
+            if (memBlock.Get() != NULL) {
+                // Lock block and copy text in it.
+                bool copied = false;
+                {
+                    StGlobalLock lockBlock(memBlock.Get());
+                    void* pBlock = lockBlock.GetPtr();
+                    if (pBlock != nullptr) {
+                        errno_t copyErr = ::wcscpy_s(static_cast<wchar_t*>(pBlock),
+                                                     blockNumElements,
+                                                     p_Text.c_str());
+                        copied = copyErr == 0;
+                    }
+                }
+
+                if (copied) {
+                    // Save data in clipboard.
+                    HANDLE hSavedData = ::SetClipboardData(CF_UNICODETEXT, memBlock.Get());
+                    if (hSavedData != NULL) {
+                        // Clipboard now owns the data, avoid freeing it.
+                        memBlock.Release();
+                    }
+                }
+            }
+        }
+    }
+
+    //
+    // Saves the given text to a registry value in the rundll32 output key.
+    // Nothing is saved if either the text or the value name is empty.
+    //
+    // @param p_ValueName Name of registry value to save to.
+    // @param p_Text Text to save.
+    //
+    void SaveTextToRegistry(const std::wstring& p_ValueName,
+                            const std::wstring& p_Text)
+    {
+        if (!p_Text.empty() && !p_ValueName.empty()) {
+            AtlRegKey outputKey(HKEY_CURRENT_USER, PCC_RUNDLL32_OUTPUT_KEY, true, KEY_SET_VALUE);
+            if (outputKey.Valid()) {
+                outputKey.SetStringValue(p_ValueName.c_str(), p_Text.c_str());
+            }
+        }
+    }
 
 } // anonymous namespace
 
@@ -77,18 +324,16 @@ void CALLBACK GetPathWithPluginW(HWND p_hWnd,
             CLSID pluginId = { 0 };
             if (SUCCEEDED(::CLSIDFromString(&*cmdLine.begin(), &pluginId))) {
                 PCC::Settings settings;
-                PCC::PluginSPV vspPlugins = PCC::PluginsRegistry::GetPluginsInDefaultOrder(&settings, &settings, true);
-                PCC::PluginSPS sspAllPlugins(vspPlugins.cbegin(), vspPlugins.cend());
+                settings.Snapshot();
+                PCC::PluginSPS sspAllPlugins = PCC::PluginsRegistry::GetPluginWithReferencedPlugins(pluginId, &settings, &settings, true);
                 PCC::AllPluginsProvider pluginProvider(sspAllPlugins);
-                for (const PCC::PluginSP& spPlugin : sspAllPlugins) {
-                    spPlugin->SetSettings(&settings);
-                    spPlugin->SetPluginProvider(&pluginProvider);
-                }
+                const PCC::SettingsSnapshot settingsSnapshot(settings);
+                const PCC::ConversionContext context(&settings, &settingsSnapshot, &pluginProvider);
                 auto it = sspAllPlugins.find(pluginId);
                 if (it != sspAllPlugins.end()) {
                     // We got a plugin, now call its GetPath method.
                     const PCC::PluginSP& spPlugin = *it;
-                    resultingPath = spPlugin->GetPath(std::wstring(cmdLine.begin() + sepPos + 1, cmdLine.end()));
+                    resultingPath = spPlugin->GetPath(std::wstring(cmdLine.begin() + sepPos + 1, cmdLine.end()), context);
                 }
             }
         }
@@ -98,36 +343,7 @@ void CALLBACK GetPathWithPluginW(HWND p_hWnd,
     }
 
     // Copy resulting path to the clipboard.
-    StClipboard acquireClipboard(p_hWnd);
-    if (acquireClipboard.InitResult()) {
-        // Allocate global block to store text.
-        const size_t blockNumElements = resultingPath.size() + 1;
-        const size_t blockSize = blockNumElements * sizeof(wchar_t);
-        StGlobalBlock memBlock(GMEM_MOVEABLE, blockSize);
-        if (memBlock.Get() != NULL) {
-            // Lock block and copy text in it.
-            bool copied = false;
-            {
-                StGlobalLock lockBlock(memBlock.Get());
-                void* pBlock = lockBlock.GetPtr();
-                if (pBlock != nullptr) {
-                    errno_t copyErr = ::wcscpy_s(static_cast<wchar_t*>(pBlock),
-                                                 blockNumElements,
-                                                 resultingPath.c_str());
-                    copied = copyErr == 0;
-                }
-            }
-
-            if (copied) {
-                // Save data in clipboard.
-                HANDLE hSavedData = ::SetClipboardData(CF_UNICODETEXT, memBlock.Get());
-                if (hSavedData != NULL) {
-                    // Clipboard now owns the data, avoid freeing it.
-                    memBlock.Release();
-                }
-            }
-        }
-    }
+    CopyTextToClipboard(p_hWnd, resultingPath);
 }
 
 //
@@ -142,7 +358,7 @@ void CALLBACK GetPathWithPluginW(HWND p_hWnd,
 //
 // The resulting path will be saved in the specified registry value in
 //
-// HKEY_CURRENT_USER\Software\clechasseur\PathCopyCopy\Rundll32Output
+// HKEY_CURRENT_USER\Software\clechasseur\PathCopyCopyCache\Rundll32Output
 //
 // p_hWnd         - Window handle to use as parent for our windows.
 // p_hDllInstance - Instance handle for our DLL; ignored.
@@ -171,13 +387,11 @@ void CALLBACK RegGetPathWithPluginW(HWND /*p_hWnd*/,
             CLSID pluginId = { 0 };
             if (SUCCEEDED(::CLSIDFromString(&*cmdLine.begin(), &pluginId))) {
                 PCC::Settings settings;
-                PCC::PluginSPV vspPlugins = PCC::PluginsRegistry::GetPluginsInDefaultOrder(&settings, &settings, true);
-                PCC::PluginSPS sspAllPlugins(vspPlugins.cbegin(), vspPlugins.cend());
+                settings.Snapshot();
+                PCC::PluginSPS sspAllPlugins = PCC::PluginsRegistry::GetPluginWithReferencedPlugins(pluginId, &settings, &settings, true);
                 PCC::AllPluginsProvider pluginProvider(sspAllPlugins);
-                for (const PCC::PluginSP& spPlugin : sspAllPlugins) {
-                    spPlugin->SetSettings(&settings);
-                    spPlugin->SetPluginProvider(&pluginProvider);
-                }
+                const PCC::SettingsSnapshot settingsSnapshot(settings);
+                const PCC::ConversionContext context(&settings, &settingsSnapshot, &pluginProvider);
                 auto it = sspAllPlugins.find(pluginId);
                 if (it != sspAllPlugins.end()) {
                     // Separate the value name from the path.
@@ -187,7 +401,7 @@ void CALLBACK RegGetPathWithPluginW(HWND /*p_hWnd*/,
                         // Extract registry value name and call GetPath method on plugin.
                         regValueName.assign(cmdLine.begin(), cmdLine.begin() + sepPos);
                         const PCC::PluginSP& spPlugin = *it;
-                        resultingPath = spPlugin->GetPath(std::wstring(cmdLine.begin() + sepPos + 1, cmdLine.end()));
+                        resultingPath = spPlugin->GetPath(std::wstring(cmdLine.begin() + sepPos + 1, cmdLine.end()), context);
                     }
                 }
             }
@@ -199,12 +413,122 @@ void CALLBACK RegGetPathWithPluginW(HWND /*p_hWnd*/,
     }
 
     // Save resulting path to the registry.
-    if (!resultingPath.empty() && !regValueName.empty()) {
-        AtlRegKey outputKey(HKEY_CURRENT_USER, PCC_RUNDLL32_OUTPUT_KEY, true, KEY_SET_VALUE);
-        if (outputKey.Valid()) {
-            outputKey.SetStringValue(regValueName.c_str(), resultingPath.c_str());
+    SaveTextToRegistry(regValueName, resultingPath);
+}
+
+//
+// GetPathsWithPluginW
+//
+// Function that can be called with rundll32.exe to invoke a specific
+// plugin on a list of files and save the resulting paths in the clipboard.
+// Plugins are only loaded once for the entire list. The command-line must
+// first contain the plugin's GUID followed by the path to a file containing
+// the list of files to convert (one per line), separated by a comma. If the
+// list path is "-", the list is read from the standard input. Call like this:
+//
+// rundll32.exe path\to\PCCxx.dll,GetPathsWithPlugin {guid},path\to\list.txt
+//
+// p_hWnd         - Window handle to use as parent for our windows.
+// p_hDllInstance - Instance handle for our DLL; ignored.
+// p_pCmdLine     - Command-line passed to rundll32.
+// p_ShowCmd      - How to show any window; ignored.
+//
+void CALLBACK GetPathsWithPluginW(HWND p_hWnd,
+                                  HINSTANCE /*p_hDllInstance*/,
+                                  LPWSTR p_pCmdLine,
+                                  int /*p_ShowCmd*/)
+{
+    // Initialize COM so that COM plugins can work.
+    StCoInitialize coInit;
+
+    // Assume we won't be able to convert the paths.
+    std::wstring resultingPaths;
+
+    try {
+        // Parse command-line and separate the guid from the list path.
+        std::wstring cmdLine(p_pCmdLine);
+        std::wstring::size_type sepPos = cmdLine.find(RUNDLL32_CMDLINE_SEPARATOR);
+        if (sepPos != std::wstring::npos) {
+            cmdLine[sepPos] = L'\0';
+            CLSID pluginId = { 0 };
+            PCC::FilesV vFiles;
+            if (SUCCEEDED(::CLSIDFromString(&*cmdLine.begin(), &pluginId)) &&
+                ReadFileList(std::wstring(cmdLine.begin() + sepPos + 1, cmdLine.end()), vFiles)) {
+
+                GetPathsWithPlugin(pluginId, vFiles, resultingPaths);
+            }
         }
+    } catch (...) {
+        // Assume plugin won't work.
+        resultingPaths.clear();
     }
+
+    // Copy resulting paths to the clipboard.
+    CopyTextToClipboard(p_hWnd, resultingPaths);
+}
+
+//
+// RegGetPathsWithPluginW
+//
+// Function that can be called with rundll32.exe to invoke a specific
+// plugin on a list of files and save the resulting paths to a registry value.
+// Plugins are only loaded once for the entire list. The command-line must
+// first contain the plugin's GUID, then the value name, then the path to a
+// file containing the list of files to convert (one per line), all separated
+// by commas. If the list path is "-", the list is read from the standard
+// input. Call like this:
+//
+// rundll32.exe path\to\PCCxx.dll,RegGetPathsWithPlugin {guid},reg_value_name,path\to\list.txt
+//
+// The resulting paths will be saved in the specified registry value in
+//
+// HKEY_CURRENT_USER\Software\clechasseur\PathCopyCopyCache\Rundll32Output
+//
+// p_hWnd         - Window handle to use as parent for our windows.
+// p_hDllInstance - Instance handle for our DLL; ignored.
+// p_pCmdLine     - Command-line passed to rundll32.
+// p_ShowCmd      - How to show any window; ignored.
+//
+void CALLBACK RegGetPathsWithPluginW(HWND /*p_hWnd*/,
+                                     HINSTANCE /*p_hDllInstance*/,
+                                     LPWSTR p_pCmdLine,
+                                     int /*p_ShowCmd*/)
+{
+    // Initialize COM so that COM plugins can work.
+    StCoInitialize coInit;
+
+    // Assume we won't be able to convert the paths.
+    std::wstring resultingPaths;
+    std::wstring regValueName;
+
+    try {
+        // Parse command-line and separate the guid from the value name and the list path.
+        std::wstring cmdLine(p_pCmdLine);
+        std::wstring::size_type sepPos = cmdLine.find(RUNDLL32_CMDLINE_SEPARATOR);
+        if (sepPos != std::wstring::npos) {
+            cmdLine[sepPos] = L'\0';
+            CLSID pluginId = { 0 };
+            if (SUCCEEDED(::CLSIDFromString(&*cmdLine.begin(), &pluginId))) {
+                // Separate the value name from the list path.
+                cmdLine.erase(cmdLine.begin(), cmdLine.begin() + sepPos + 1);
+                sepPos = cmdLine.find(RUNDLL32_CMDLINE_SEPARATOR);
+                PCC::FilesV vFiles;
+                if (sepPos != std::wstring::npos &&
+                    ReadFileList(std::wstring(cmdLine.begin() + sepPos + 1, cmdLine.end()), vFiles)) {
+
+                    regValueName.assign(cmdLine.begin(), cmdLine.begin() + sepPos);
+                    GetPathsWithPlugin(pluginId, vFiles, resultingPaths);
+                }
+            }
+        }
+    } catch (...) {
+        // Assume plugin won't work.
+        resultingPaths.clear();
+        regValueName.clear();
+    }
+
+    // Save resulting paths to the registry.
+    SaveTextToRegistry(regValueName, resultingPaths);
 }
 
 //
@@ -258,3 +582,329 @@ void CALLBACK ApplyUserRevisionsW(HWND /*p_hWnd*/,
         // Can't do much, don't crash rundll32.
     }
 }
+
+//
+// RunResidentServiceW
+//
+// Function that can be called with rundll32.exe to run the resident service
+// (see PCC::ResidentService) or to install/uninstall it so that it is started
+// when the current user logs on. Call like this:
+//
+// rundll32.exe path\to\PCCxx.dll,RunResidentServiceW [/install|/uninstall|/stop]
+//
+// Without arguments, runs the service until it is stopped. /install also
+// starts the service; /uninstall also stops it.
+//
+// p_hWnd         - Window handle to use as parent for our windows; ignored.
+// p_hDllInstance - Instance handle for our DLL; ignored.
+// p_pCmdLine     - Command-line passed to rundll32.
+// p_ShowCmd      - How to show any window; ignored.
+//
+void CALLBACK RunResidentServiceW(HWND /*p_hWnd*/,
+                                  HINSTANCE /*p_hDllInstance*/,
+                                  LPWSTR p_pCmdLine,
+                                  int /*p_ShowCmd*/)
+{
+    try {
+        const wchar_t* pArg = p_pCmdLine != nullptr ? p_pCmdLine : L"";
+        pArg += ::wcsspn(pArg, L" \t");
+        if (*pArg == L'\0') {
+            PCC::ResidentService::Run();
+        } else if (::_wcsicmp(pArg, L"/install") == 0) {
+            if (PCC::ResidentService::Install(true)) {
+                PCC::ResidentService::Run();
+            }
+        } else if (::_wcsicmp(pArg, L"/uninstall") == 0) {
+            PCC::ResidentService::Install(false);
+            PCC::ResidentService::Stop();
+        } else if (::_wcsicmp(pArg, L"/stop") == 0) {
+            PCC::ResidentService::Stop();
+        }
+    } catch (...) {
+        // Can't do much, don't crash rundll32.
+    }
+}
+
+//
+// RunMachineNetworkCacheW
+//
+// Function that can be called with rundll32.exe to run the writer of the
+// network info shared by all sessions of the computer (see
+// PCC::MachineNetworkCache), or to stop it. Call like this:
+//
+// rundll32.exe path\to\PCCxx.dll,RunMachineNetworkCacheW [/stop]
+//
+// Without arguments, runs the writer until it is stopped. It must run as an
+// account allowed to create global objects; for example, on a terminal server:
+//
+// schtasks /create /tn PathCopyCopyMachineNetworkCache /sc onstart /ru SYSTEM
+//          /tr "rundll32.exe path\to\PCCxx.dll,RunMachineNetworkCacheW"
+//
+// p_hWnd         - Window handle to use as parent for our windows; ignored.
+// p_hDllInstance - Instance handle for our DLL; ignored.
+// p_pCmdLine     - Command-line passed to rundll32.
+// p_ShowCmd      - How to show any window; ignored.
+//
+void CALLBACK RunMachineNetworkCacheW(HWND /*p_hWnd*/,
+                                      HINSTANCE /*p_hDllInstance*/,
+                                      LPWSTR p_pCmdLine,
+                                      int /*p_ShowCmd*/)
+{
+    try {
+        const wchar_t* pArg = p_pCmdLine != nullptr ? p_pCmdLine : L"";
+        pArg += ::wcsspn(pArg, L" \t");
+        if (*pArg == L'\0') {
+            PCC::MachineNetworkCache::Run();
+        } else if (::_wcsicmp(pArg, L"/stop") == 0) {
+            PCC::MachineNetworkCache::Stop();
+        }
+    } catch (...) {
+        // Can't do much, don't crash rundll32.
+    }
+}
+
+//
+// GetPathsWithPipelineW
+//
+// Function that can be called directly by a process that loaded the DLL
+// (like the settings application) to evaluate a pipeline against a batch
+// of paths in-process. The pipeline does not need to be saved in the
+// registry; it is decoded from the given encoded elements and bound to
+// the current plugins snapshot so that elements referring to other plugins
+// work as usual.
+//
+// @param p_pEncodedElements Encoded pipeline elements, as stored in the registry.
+// @param p_pPaths Paths to convert, separated by newlines.
+// @param p_pResults Where to store the converted paths, separated by newlines
+//                   and in the same order as p_pPaths. Caller must free the
+//                   string using SysFreeString.
+// @return S_OK if paths were converted, otherwise an error code.
+//
+HRESULT WINAPI GetPathsWithPipelineW(LPCWSTR p_pEncodedElements,
+                                     LPCWSTR p_pPaths,
+                                     BSTR* p_pResults)
+{
+    if (p_pEncodedElements == nullptr || p_pPaths == nullptr || p_pResults == nullptr) {
+        return E_INVALIDARG;
+    }
+    *p_pResults = nullptr;
+
+    // Initialize COM so that COM plugins can work.
+    StCoInitialize coInit;
+
+    HRESULT hRes = S_OK;
+    try {
+        // Create a temporary pipeline plugin used in the context of the current snapshot.
+        PCC::PluginsSnapshotSP spSnapshot = PCC::PluginsSnapshot::Get();
+        spSnapshot->ClearCachedPaths();
+        PCC::Plugins::PipelinePlugin pipelinePlugin(GUID_NULL, std::wstring(), std::wstring(),
+                                                    false, p_pEncodedElements);
+        const PCC::ConversionContext& context = spSnapshot->GetConversionContext();
+
+        // Convert each path and join the results.
+        std::wstring paths(p_pPaths);
+        PCC::WStringV vPaths;
+        StringUtils::Split(paths, PIPELINE_PATHS_SEPARATOR, vPaths);
+        std::wstring results;
+        for (auto it = vPaths.cbegin(); it != vPaths.cend(); ++it) {
+            if (it != vPaths.cbegin()) {
+                results += PIPELINE_PATHS_SEPARATOR;
+            }
+            results += pipelinePlugin.GetPath(*it, context);
+        }
+
+        *p_pResults = ::SysAllocStringLen(results.c_str(), static_cast<UINT>(results.size()));
+        if (*p_pResults == nullptr) {
+            hRes = E_OUTOFMEMORY;
+        }
+    } catch (...) {
+        // Assume pipeline won't work.
+        hRes = E_FAIL;
+    }
+
+    return hRes;
+}
+
+//
+// ProfilePipelineW
+//
+// Function that can be called directly by a process that loaded the DLL
+// (like the settings application) to measure the time spent in each element
+// of a pipeline. Like GetPathsWithPipelineW, the pipeline is decoded from
+// the given encoded elements and bound to the current plugins snapshot, but
+// it is not optimized, so that each result matches an element as edited
+// by the user. Each path is converted by all elements the given number of
+// times.
+//
+// Allocations can only be counted in debug benchmark builds, where the CRT
+// supports allocation hooks; in other builds, their count is reported as -1.
+//
+// @param p_pEncodedElements Encoded pipeline elements, as stored in the registry.
+// @param p_pPaths Sample paths to convert, separated by newlines.
+// @param p_Iterations Number of times to convert each path.
+// @param p_pResults Where to store the results, one line per element separated
+//                   by newlines. Each line contains the total time spent in the
+//                   element, in microseconds, and the number of allocations it
+//                   performed, separated by a tab. Caller must free the string
+//                   using SysFreeString.
+// @return S_OK if pipeline was profiled, otherwise an error code.
+//
+HRESULT WINAPI ProfilePipelineW(LPCWSTR p_pEncodedElements,
+                                LPCWSTR p_pPaths,
+                                UINT p_Iterations,
+                                BSTR* p_pResults)
+{
+    if (p_pEncodedElements == nullptr || p_pPaths == nullptr || p_Iterations == 0 || p_pResults == nullptr) {
+        return E_INVALIDARG;
+    }
+    *p_pResults = nullptr;
+
+    // Initialize COM so that COM plugins can work.
+    StCoInitialize coInit;
+
+    HRESULT hRes = S_OK;
+    try {
+        // Decode elements without optimizing them, then bind them to the current snapshot.
+        PCC::PipelineElementSPV vspElements;
+        PCC::PipelineDecoder::DecodePipeline(p_pEncodedElements, vspElements);
+        PCC::PluginsSnapshotSP spSnapshot = PCC::PluginsSnapshot::Get();
+        spSnapshot->ClearCachedPaths();
+        const PCC::ConversionContext& context = spSnapshot->GetConversionContext();
+
+        std::wstring paths(p_pPaths);
+        PCC::WStringV vPaths;
+        StringUtils::Split(paths, PIPELINE_PATHS_SEPARATOR, vPaths);
+
+        std::vector<const PCC::GuardPipelineElement*> vpGuards;
+        for (const PCC::PipelineElementSP& spElement : vspElements) {
+            vpGuards.push_back(dynamic_cast<const PCC::GuardPipelineElement*>(spElement.get()));
+        }
+
+        // Convert each path, measuring time spent in each element.
+        std::vector<std::chrono::steady_clock::duration> vDurations(vspElements.size());
+        std::vector<long long> vAllocations(vspElements.size(), -1);
+#if defined(PCC_BENCHMARKS) && defined(_DEBUG)
+        std::fill(vAllocations.begin(), vAllocations.end(), 0);
+        StAllocationCounter allocationCounter;
+#endif
+        for (UINT iteration = 0; iteration < p_Iterations; ++iteration) {
+            for (const std::wstring& path : vPaths) {
+                std::wstring modifiedPath(path);
+                bool guarded = false;
+                for (size_t i = 0; !guarded && i < vspElements.size(); ++i) {
+#if defined(PCC_BENCHMARKS) && defined(_DEBUG)
+                    const long long allocationsBefore = g_ProfiledAllocations;
+#endif
+                    const auto start = std::chrono::steady_clock::now();
+                    if (vpGuards[i] != nullptr) {
+                        // Like in Pipeline, paths failing a guard skip the following elements.
+                        guarded = !vpGuards[i]->Passes(modifiedPath);
+                    } else {
+                        vspElements[i]->ModifyPath(modifiedPath, context);
+                    }
+                    vDurations[i] += std::chrono::steady_clock::now() - start;
+#if defined(PCC_BENCHMARKS) && defined(_DEBUG)
+                    vAllocations[i] += g_ProfiledAllocations - allocationsBefore;
+#endif
+                }
+            }
+        }
+
+        // Return one line per element.
+        std::wstring results;
+        for (size_t i = 0; i < vspElements.size(); ++i) {
+            if (i != 0) {
+                results += PIPELINE_PATHS_SEPARATOR;
+            }
+            results += std::to_wstring(std::chrono::duration_cast<std::chrono::microseconds>(vDurations[i]).count());
+            results += PROFILE_FIELDS_SEPARATOR;
+            results += std::to_wstring(vAllocations[i]);
+        }
+
+        *p_pResults = ::SysAllocStringLen(results.c_str(), static_cast<UINT>(results.size()));
+        if (*p_pResults == nullptr) {
+            hRes = E_OUTOFMEMORY;
+        }
+    } catch (...) {
+        // Assume pipeline won't work.
+        hRes = E_FAIL;
+    }
+
+    return hRes;
+}
+
+//
+// ConvertPathStreamW
+//
+// Function that can be called directly by a process that loaded the DLL
+// (like pcc.exe) to convert a stream of paths using a plugin. Paths are
+// read one per line from the input and results are written to the output
+// as they are available (see PCC::PathStreamConverter).
+//
+// @param p_pPlugin ID of plugin to use, with or without braces, or its
+//                  description as shown in the contextual menu (case-insensitive,
+//                  without accelerator markers).
+// @param p_hInput Handle of file or pipe to read paths from.
+// @param p_hOutput Handle of file, pipe or console where to write converted paths.
+// @param p_pSeparator Separator to write after each converted path. If nullptr,
+//                     each path is followed by a CRLF.
+// @return S_OK if all paths were converted, HRESULT_FROM_WIN32(ERROR_NOT_FOUND)
+//         if plugin could not be found, otherwise an error code.
+//
+HRESULT WINAPI ConvertPathStreamW(LPCWSTR p_pPlugin,
+                                  HANDLE p_hInput,
+                                  HANDLE p_hOutput,
+                                  LPCWSTR p_pSeparator)
+{
+    if (p_pPlugin == nullptr || p_hInput == NULL || p_hInput == INVALID_HANDLE_VALUE ||
+        p_hOutput == NULL || p_hOutput == INVALID_HANDLE_VALUE) {
+
+        return E_INVALIDARG;
+    }
+
+    // Initialize COM so that COM plugins can work.
+    StCoInitialize coInit;
+
+    HRESULT hRes = S_OK;
+    try {
+        // Look for plugin by ID first. If we have one, only load what it needs.
+        std::wstring pluginIdAsString(p_pPlugin);
+        if (!pluginIdAsString.empty() && pluginIdAsString.front() != L'{') {
+            pluginIdAsString = L"{" + pluginIdAsString + L"}";
+        }
+        CLSID pluginId = GUID_NULL;
+        PCC::PluginsSnapshotSP spSnapshot;
+        PCC::PluginSP spPlugin;
+        if (SUCCEEDED(::CLSIDFromString(pluginIdAsString.c_str(), &pluginId))) {
+            spSnapshot = PCC::PluginsSnapshot::GetForPlugin(pluginId);
+            auto it = spSnapshot->GetAllPlugins().find(pluginId);
+            if (it != spSnapshot->GetAllPlugins().end()) {
+                spPlugin = *it;
+            }
+        } else {
+            spSnapshot = PCC::PluginsSnapshot::Get();
+            for (const PCC::PluginSP& spCandidate : spSnapshot->GetAllPlugins()) {
+                std::wstring description = spCandidate->Description(spSnapshot->GetConversionContext());
+                description.erase(std::remove(description.begin(), description.end(), L'&'), description.end());
+                if (!spCandidate->IsSeparator() && ::_wcsicmp(description.c_str(), p_pPlugin) == 0) {
+                    spPlugin = spCandidate;
+                    break;
+                }
+            }
+        }
+
+        if (spPlugin != nullptr && !spPlugin->IsSeparator()) {
+            spSnapshot->ClearCachedPaths();
+            PCC::PathStreamConverter converter(*spPlugin, spSnapshot->GetConversionContext(), p_hOutput,
+                                               p_pSeparator != nullptr ? p_pSeparator : DEFAULT_PATHS_SEPARATOR);
+            hRes = converter.Convert(p_hInput) ? S_OK : HRESULT_FROM_WIN32(ERROR_WRITE_FAULT);
+        } else {
+            hRes = HRESULT_FROM_WIN32(ERROR_NOT_FOUND);
+        }
+    } catch (...) {
+        // Assume plugin won't work.
+        hRes = E_FAIL;
+    }
+
+    return hRes;
+}
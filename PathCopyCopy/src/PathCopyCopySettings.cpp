@@ -22,6 +22,7 @@
 #include <stdafx.h>
 #include <PathCopyCopySettings.h>
 
+#include <COMPluginMetadataCache.h>
 #include <PathCopyCopy_i.h>
 #include <PathCopyCopyPluginsRegistry.h>
 #include <PipelinePlugin.h>
@@ -31,6 +32,7 @@
 #include <StOleStr.h>
 
 #include <algorithm>
+#include <iterator>
 #include <sstream>
 
 #include <assert.h>
@@ -50,8 +52,13 @@ namespace
     const wchar_t* const    PCC_PIPELINE_PLUGINS_KEY                        = L"Software\\clechasseur\\PathCopyCopy\\PipelinePlugins";
     const wchar_t* const    PCC_TEMP_PIPELINE_PLUGINS_KEY                   = L"Software\\clechasseur\\PathCopyCopy\\TempPipelinePlugins";
 
+    // Names of snapshots of the PCC settings shared between processes.
+    const wchar_t* const    SHARED_SNAPSHOT_SETTINGS                        = L"Settings";
+    const wchar_t* const    SHARED_SNAPSHOT_ICONS                           = L"Icons";
+
     // Values used for PCC settings.
     const wchar_t* const    SETTING_REVISIONS                               = L"Revisions";
+    const wchar_t* const    SETTING_REVISED_UP_TO                           = L"RevisedUpTo";
     const wchar_t* const    SETTING_USE_HIDDEN_SHARES                       = L"UseHiddenShares";
     const wchar_t* const    SETTING_USE_FQDN                                = L"UseFQDN";
     const wchar_t* const    SETTING_ADD_QUOTES                              = L"AddQuotes";
@@ -66,14 +73,30 @@ namespace
     const wchar_t* const    SETTING_DROP_REDUNDANT_WORDS                    = L"DropRedundantWords";
     const wchar_t* const    SETTING_ALWAYS_SHOW_SUBMENU                     = L"AlwaysShowSubmenu";
     const wchar_t* const    SETTING_PATHS_SEPARATOR                         = L"PathsSeparator";
+    const wchar_t* const    SETTING_MENU_TIME_BUDGET                        = L"MenuTimeBudget";
+    const wchar_t* const    SETTING_PREWARM_CACHES                          = L"PrewarmCaches";
+    const wchar_t* const    SETTING_CACHE_CONVERTED_PATHS                   = L"CacheConvertedPaths";
+    const wchar_t* const    SETTING_RESOLVE_DFS_PATHS                       = L"ResolveDFSPaths";
+    const wchar_t* const    SETTING_DISABLE_UNSUPPORTED_SHORT_NAMES         = L"DisableShortNamesIfUnsupported";
+    const wchar_t* const    SETTING_PROJECT_ROOT_MARKERS                    = L"ProjectRootMarkers";
+    const wchar_t* const    SETTING_SAMBA_SERVER_ALIASES                    = L"SambaServerAliases";
     const wchar_t* const    SETTING_CTRL_KEY_PLUGIN                         = L"CtrlKeyPlugin";
+    const wchar_t* const    SETTING_HOTKEY_PLUGINS                          = L"HotkeyPlugins";
+    const wchar_t* const    SETTING_HOTKEYS                                 = L"Hotkeys";
     const wchar_t* const    SETTING_MAIN_MENU_PLUGIN_DISPLAY_ORDER          = L"MainMenuDisplayOrder";
     const wchar_t* const    SETTING_SUBMENU_PLUGIN_DISPLAY_ORDER            = L"SubmenuDisplayOrder";
     const wchar_t* const    SETTING_UI_PLUGIN_DISPLAY_ORDER                 = L"UIDisplayOrder";
     const wchar_t* const    SETTING_KNOWN_PLUGINS                           = L"KnownPlugins";
+    const wchar_t* const    SETTING_MAIN_MENU_PLUGIN_DISPLAY_ORDER_PACKED   = L"MainMenuDisplayOrderPacked";
+    const wchar_t* const    SETTING_SUBMENU_PLUGIN_DISPLAY_ORDER_PACKED     = L"SubmenuDisplayOrderPacked";
+    const wchar_t* const    SETTING_KNOWN_PLUGINS_PACKED                    = L"KnownPluginsPacked";
+    const wchar_t* const    SETTING_NON_REUSABLE_COM_PLUGINS                = L"NonReusableCOMPlugins";
+    const wchar_t* const    SETTING_ISOLATED_COM_PLUGINS                    = L"IsolatedCOMPlugins";
     const wchar_t* const    SETTING_PIPELINE_DESCRIPTION                    = L"Description";
     const wchar_t* const    SETTING_PIPELINE_ICON_FILE                      = L"IconFile";
+    const wchar_t* const    SETTING_PIPELINE_MENU_FOLDER                    = L"Folder";
     const wchar_t* const    SETTING_PIPELINE_DISPLAY_ORDER                  = L"DisplayOrder";
+    const wchar_t* const    SETTING_PIPELINE_PACKED_PLUGINS                 = L"PackedPlugins";
     const wchar_t* const    SETTING_LAST_UPDATE_CHECK                       = L"LastUpdateCheck";
     const wchar_t* const    SETTING_UPDATE_INTERVAL                         = L"UpdateInterval";
     const wchar_t* const    SETTING_DISABLE_SOFTWARE_UPDATE                 = L"DisableSoftwareUpdate";
@@ -104,20 +127,84 @@ namespace
     const bool              SETTING_DROP_REDUNDANT_WORDS_DEFAULT            = false;
     const bool              SETTING_ALWAYS_SHOW_SUBMENU_DEFAULT             = true;
     const wchar_t* const    SETTING_PATHS_SEPARATOR_DEFAULT                 = L"";
+    const DWORD             SETTING_MENU_TIME_BUDGET_DEFAULT                = 50;           // In milliseconds.
+    const bool              SETTING_PREWARM_CACHES_DEFAULT                  = true;
+    const bool              SETTING_CACHE_CONVERTED_PATHS_DEFAULT           = true;
+    const bool              SETTING_RESOLVE_DFS_PATHS_DEFAULT               = false;
+    const bool              SETTING_DISABLE_UNSUPPORTED_SHORT_NAMES_DEFAULT = false;
+    const wchar_t* const    SETTING_PROJECT_ROOT_MARKERS_DEFAULT            = L".git,.hg,.svn";
     const double            SETTING_UPDATE_INTERVAL_DEFAULT                 = 604800.0;     // One week, in seconds.
     const bool              SETTING_DISABLE_SOFTWARE_UPDATE_DEFAULT         = false;
 
+    // Latest revision applied to the settings. Must match the latest revision in Reviser::CreateRevisionFuncMap.
+    const DWORD             LATEST_SETTINGS_REVISION                        = 201707061ul;
+
     // Constants used to parse data.
     const wchar_t           PLUGINS_SEPARATOR                               = L',';
     const wchar_t           REVISIONS_SEPARATOR                             = L',';
+    const wchar_t           PROJECT_ROOT_MARKERS_SEPARATOR                  = L',';
+    const wchar_t           SAMBA_SERVER_ALIASES_SEPARATOR                  = L',';
+    const wchar_t           SAMBA_SERVER_ALIAS_VALUE_SEPARATOR              = L'=';
 
     // Constants used to generate plugin info for the UI.
     const wchar_t           INFO_GROUP_INFO_SEPARATOR                       = L',';
     const wchar_t           INFO_DESCRIPTION_SEPARATOR                      = L'|';
 
+    // Constants used to decode packed pipeline plugins. Values with older
+    // signatures have no stamp and are thus ignored, since we can't tell
+    // if they are up to date.
+    const wchar_t           PACKED_PIPELINE_PLUGINS_SIGNATURE_WITH_STAMP    = L'\x0003';
+
     // Constants used for icons.
     const wchar_t* const    DEFAULT_ICON_MARKER_STRING                      = L"default";
 
+    //
+    // Computes the hash of a list of plugin IDs stored as a string, using
+    // 32-bit FNV-1a on each character. Packed lists of plugin IDs store
+    // the hash of their string counterpart so that we can make sure they
+    // are up to date. Must match the C# code in "UserSettings.cs".
+    //
+    // @param p_PluginIdsAsString String containing plugin IDs.
+    // @return Hash of p_PluginIdsAsString.
+    //
+    DWORD HashPluginIdsString(const std::wstring& p_PluginIdsAsString)
+    {
+        DWORD hash = 2166136261ul;
+        for (const wchar_t c : p_PluginIdsAsString) {
+            hash = (hash ^ static_cast<DWORD>(c)) * 16777619ul;
+        }
+        return hash;
+    }
+
+    //
+    // Computes the stamp of the pipeline plugins stored as subkeys of a registry
+    // key: their number and the most recent of their last write times, the
+    // latter stored as two DWORDs (low part first). Packed pipeline plugins
+    // store the stamp of the subkeys when they were packed, so that we can
+    // make sure they are up to date. Must match the C# code in "UserSettings.cs".
+    //
+    // @param p_PipelinePluginsKey Registry key containing pipeline plugins.
+    // @param p_rStamp Upon return, will contain the stamp (three DWORDs).
+    //
+    void ComputePipelinePluginsStamp(const RegKey& p_PipelinePluginsKey,
+                                     DWORD (&p_rStamp)[3])
+    {
+        RegKey::SubkeyInfoV vSubkeyInfos;
+        p_PipelinePluginsKey.GetSubKeys(vSubkeyInfos);
+        ULARGE_INTEGER lastWriteTime = { 0 };
+        for (const auto& subkeyInfo : vSubkeyInfos) {
+            ULARGE_INTEGER subkeyLastWriteTime;
+            subkeyLastWriteTime.LowPart = subkeyInfo.m_LastWriteTime.dwLowDateTime;
+            subkeyLastWriteTime.HighPart = subkeyInfo.m_LastWriteTime.dwHighDateTime;
+            if (subkeyLastWriteTime.QuadPart > lastWriteTime.QuadPart) {
+                lastWriteTime = subkeyLastWriteTime;
+            }
+        }
+        p_rStamp[0] = static_cast<DWORD>(vSubkeyInfos.size());
+        p_rStamp[1] = lastWriteTime.LowPart;
+        p_rStamp[2] = lastWriteTime.HighPart;
+    }
+
     //
     // Predicate used to sort pipeline plugins according to their sort order.
     // Uses an ID vector of ordered plugin IDs to know whether two plugins
@@ -192,7 +279,12 @@ namespace PCC
           m_UserPluginsKey(),
           m_GlobalPluginsKey(),
           m_GlobalPluginsKeyReadOnly(false),
-          m_Revised(false)
+          m_Revised(false),
+          m_upUserKeySnapshot(),
+          m_upIconsKeySnapshot(),
+          m_pUserKeyForReading(nullptr),
+          m_pIconsKeyForReading(nullptr),
+          m_upShownPlugins()
     {
         // Open user plugins key.
         m_UserPluginsKey.Open(HKEY_CURRENT_USER, PCC_PLUGINS_KEY, true);
@@ -207,6 +299,46 @@ namespace PCC
         }
     }
 
+    //
+    // Loads all values of the settings and icons keys in memory at once, instead of
+    // querying the registry for each setting. Subsequent reads will return these
+    // values, until settings are modified through this object. This is useful when
+    // reading many settings in a short time, like when our contextual menu is shown.
+    //
+    // Snapshots are shared with other processes of the same user, so if settings
+    // haven't changed since another process loaded them, we don't need to read them.
+    //
+    void Settings::Snapshot()
+    {
+        // Revise first, since this could change the settings.
+        Revise();
+
+        m_upUserKeySnapshot.reset(new RegKeySnapshot(m_UserKey, SHARED_SNAPSHOT_SETTINGS));
+        m_upIconsKeySnapshot.reset(new RegKeySnapshot(m_IconsKey, SHARED_SNAPSHOT_ICONS));
+        m_upShownPlugins.reset();
+    }
+
+#ifdef PCC_BENCHMARKS
+    //
+    // Reads user settings and plugin icons from the given keys instead of
+    // the registry. Settings read from these keys are not revised. This can
+    // be used to measure or benchmark settings access without touching the
+    // registry, for example with an in-memory key. COM and pipeline plugins
+    // are still read from the registry.
+    //
+    // @param p_UserKey Key to read user settings from. Must outlive this object.
+    // @param p_IconsKey Key to read plugin icons from. Must outlive this object.
+    //
+    void Settings::UseKeysForReading(const RegKey& p_UserKey,
+                                     const RegKey& p_IconsKey)
+    {
+        m_Revised = true;
+        m_pUserKeyForReading = &p_UserKey;
+        m_pIconsKeyForReading = &p_IconsKey;
+        m_upShownPlugins.reset();
+    }
+#endif // PCC_BENCHMARKS
+
     //
     // Checks whether user wants to consider hidden shares when
     // returning paths for the UNC plugins.
@@ -221,7 +353,7 @@ namespace PCC
         // Check if value exists. If so, read it, otherwise use default value.
         bool useHiddenShares = SETTING_USE_HIDDEN_SHARES_DEFAULT;
         DWORD regUseHiddenShares = 0;
-        if (m_UserKey.QueryDWORDValue(SETTING_USE_HIDDEN_SHARES, regUseHiddenShares) == ERROR_SUCCESS) {
+        if (GetUserKeyForReading().QueryDWORDValue(SETTING_USE_HIDDEN_SHARES, regUseHiddenShares) == ERROR_SUCCESS) {
             useHiddenShares = regUseHiddenShares != 0;
         }
         return useHiddenShares;
@@ -241,7 +373,7 @@ namespace PCC
         // Check if value exists. If so, read it, otherwise use default value.
         bool useFQDN = SETTING_USE_FQDN_DEFAULT;
         DWORD regUseFQDN = 0;
-        if (m_UserKey.QueryDWORDValue(SETTING_USE_FQDN, regUseFQDN) == ERROR_SUCCESS) {
+        if (GetUserKeyForReading().QueryDWORDValue(SETTING_USE_FQDN, regUseFQDN) == ERROR_SUCCESS) {
             useFQDN = regUseFQDN != 0;
         }
         return useFQDN;
@@ -261,7 +393,7 @@ namespace PCC
         // Check if value exists. If so, read it, otherwise use default value.
         bool addQuotes = SETTING_ADD_QUOTES_DEFAULT;
         DWORD regAddQuotes = 0;
-        if (m_UserKey.QueryDWORDValue(SETTING_ADD_QUOTES, regAddQuotes) == ERROR_SUCCESS) {
+        if (GetUserKeyForReading().QueryDWORDValue(SETTING_ADD_QUOTES, regAddQuotes) == ERROR_SUCCESS) {
             addQuotes = regAddQuotes != 0;
         }
         return addQuotes;
@@ -282,7 +414,7 @@ namespace PCC
         // Check if value exists. If so, read it, otherwise use default value.
         bool areQuotesOptional = SETTING_ARE_QUOTES_OPTIONAL_DEFAULT;
         DWORD regAreQuotesOptional = 0;
-        if (m_UserKey.QueryDWORDValue(SETTING_ARE_QUOTES_OPTIONAL, regAreQuotesOptional) == ERROR_SUCCESS) {
+        if (GetUserKeyForReading().QueryDWORDValue(SETTING_ARE_QUOTES_OPTIONAL, regAreQuotesOptional) == ERROR_SUCCESS) {
             areQuotesOptional = regAreQuotesOptional != 0;
         }
         return areQuotesOptional;
@@ -302,7 +434,7 @@ namespace PCC
         // Check if value exists. If so, read it, otherwise use default value.
         bool makeEmailLinks = SETTING_MAKE_EMAIL_LINKS_DEFAULT;
         DWORD regMakeEmailLinks = 0;
-        if (m_UserKey.QueryDWORDValue(SETTING_MAKE_EMAIL_LINKS, regMakeEmailLinks) == ERROR_SUCCESS) {
+        if (GetUserKeyForReading().QueryDWORDValue(SETTING_MAKE_EMAIL_LINKS, regMakeEmailLinks) == ERROR_SUCCESS) {
             makeEmailLinks = regMakeEmailLinks != 0;
         }
         return makeEmailLinks;
@@ -320,7 +452,7 @@ namespace PCC
         Revise();
 
         std::wstring encodeParamStr;
-        if (PluginUtils::ReadRegistryStringValue(m_UserKey, SETTING_ENCODE_PARAM, encodeParamStr) != ERROR_SUCCESS) {
+        if (PluginUtils::ReadRegistryStringValue(GetUserKeyForReading(), SETTING_ENCODE_PARAM, encodeParamStr) != ERROR_SUCCESS) {
             encodeParamStr = SETTING_ENCODE_PARAM_DEFAULT;
         }
         StringUtils::EncodeParam encodeParam = StringUtils::EncodeParam::None;
@@ -349,7 +481,7 @@ namespace PCC
         // Check if value exists. If so, read it, otherwise use default value.
         bool appendSep = SETTING_APPEND_SEPARATOR_FOR_DIRECTORIES_DEFAULT;
         DWORD regAppendSep = 0;
-        if (m_UserKey.QueryDWORDValue(SETTING_APPEND_SEPARATOR_FOR_DIRECTORIES, regAppendSep) == ERROR_SUCCESS) {
+        if (GetUserKeyForReading().QueryDWORDValue(SETTING_APPEND_SEPARATOR_FOR_DIRECTORIES, regAppendSep) == ERROR_SUCCESS) {
             appendSep = regAppendSep != 0;
         }
         return appendSep;
@@ -369,7 +501,7 @@ namespace PCC
         // Check if value exists. If so, read it, otherwise use default value.
         bool useIcon = SETTING_USE_ICON_FOR_DEFAULT_PLUGIN_DEFAULT;
         DWORD regUseIcon = 0;
-        if (m_UserKey.QueryDWORDValue(SETTING_USE_ICON_FOR_DEFAULT_PLUGIN, regUseIcon) == ERROR_SUCCESS) {
+        if (GetUserKeyForReading().QueryDWORDValue(SETTING_USE_ICON_FOR_DEFAULT_PLUGIN, regUseIcon) == ERROR_SUCCESS) {
             useIcon = regUseIcon != 0;
         }
         return useIcon;
@@ -388,7 +520,7 @@ namespace PCC
         // Check if value exists. If so, read it, otherwise use default value.
         bool useIcon = SETTING_USE_ICON_FOR_SUBMENU_DEFAULT;
         DWORD regUseIcon = 0;
-        if (m_UserKey.QueryDWORDValue(SETTING_USE_ICON_FOR_SUBMENU, regUseIcon) == ERROR_SUCCESS) {
+        if (GetUserKeyForReading().QueryDWORDValue(SETTING_USE_ICON_FOR_SUBMENU, regUseIcon) == ERROR_SUCCESS) {
             useIcon = regUseIcon != 0;
         }
         return useIcon;
@@ -408,7 +540,7 @@ namespace PCC
         // Check if value exists. If so, read it, otherwise use default value.
         bool previewMode = SETTING_USE_PREVIEW_MODE_DEFAULT;
         DWORD regPreviewMode = 0;
-        if (m_UserKey.QueryDWORDValue(SETTING_USE_PREVIEW_MODE, regPreviewMode) == ERROR_SUCCESS) {
+        if (GetUserKeyForReading().QueryDWORDValue(SETTING_USE_PREVIEW_MODE, regPreviewMode) == ERROR_SUCCESS) {
             previewMode = regPreviewMode != 0;
         }
         return previewMode;
@@ -428,7 +560,7 @@ namespace PCC
         // Check if value exists. If so, read it, otherwise use default value.
         bool previewModeInMainMenu = SETTING_USE_PREVIEW_MODE_IN_MAIN_MENU_DEFAULT;
         DWORD regPreviewModeInMainMenu = 0;
-        if (m_UserKey.QueryDWORDValue(SETTING_USE_PREVIEW_MODE_IN_MAIN_MENU, regPreviewModeInMainMenu) == ERROR_SUCCESS) {
+        if (GetUserKeyForReading().QueryDWORDValue(SETTING_USE_PREVIEW_MODE_IN_MAIN_MENU, regPreviewModeInMainMenu) == ERROR_SUCCESS) {
             previewModeInMainMenu = regPreviewModeInMainMenu != 0;
         }
         return previewModeInMainMenu;
@@ -447,7 +579,7 @@ namespace PCC
         // Check if value exists. If so, read it, otherwise use default value.
         bool dropRedundantWords = SETTING_DROP_REDUNDANT_WORDS_DEFAULT;
         DWORD regDropRedundantWords = 0;
-        if (m_UserKey.QueryDWORDValue(SETTING_DROP_REDUNDANT_WORDS, regDropRedundantWords) == ERROR_SUCCESS) {
+        if (GetUserKeyForReading().QueryDWORDValue(SETTING_DROP_REDUNDANT_WORDS, regDropRedundantWords) == ERROR_SUCCESS) {
             dropRedundantWords = regDropRedundantWords != 0;
         }
         return dropRedundantWords;
@@ -467,7 +599,7 @@ namespace PCC
         // Check if value exists. If so, read it, otherwise use default value.
         bool alwaysShowSubmenu = SETTING_ALWAYS_SHOW_SUBMENU_DEFAULT;
         DWORD regAlwaysShowSubmenu = 0;
-        if (m_UserKey.QueryDWORDValue(SETTING_ALWAYS_SHOW_SUBMENU, regAlwaysShowSubmenu) == ERROR_SUCCESS) {
+        if (GetUserKeyForReading().QueryDWORDValue(SETTING_ALWAYS_SHOW_SUBMENU, regAlwaysShowSubmenu) == ERROR_SUCCESS) {
             alwaysShowSubmenu = regAlwaysShowSubmenu != 0;
         }
         return alwaysShowSubmenu;
@@ -485,12 +617,209 @@ namespace PCC
         Revise();
 
         std::wstring pathsSeparator;
-        if (PluginUtils::ReadRegistryStringValue(m_UserKey, SETTING_PATHS_SEPARATOR, pathsSeparator) != ERROR_SUCCESS) {
+        if (PluginUtils::ReadRegistryStringValue(GetUserKeyForReading(), SETTING_PATHS_SEPARATOR, pathsSeparator) != ERROR_SUCCESS) {
             pathsSeparator.clear();
         }
         return pathsSeparator;
     }
 
+    //
+    // Returns the time we can spend building the contextual menu before
+    // degrading it (skipping previews, icons, etc.) to avoid blocking
+    // the shell for too long.
+    //
+    // @return Time budget for building the menu, in milliseconds,
+    //         or 0 if building the menu is not time-limited.
+    //
+    DWORD Settings::GetMenuTimeBudget() const
+    {
+        // Perform late-revising.
+        Revise();
+
+        // Check if value exists. If so, read it, otherwise use default value.
+        DWORD menuTimeBudget = SETTING_MENU_TIME_BUDGET_DEFAULT;
+        DWORD regMenuTimeBudget = 0;
+        if (GetUserKeyForReading().QueryDWORDValue(SETTING_MENU_TIME_BUDGET, regMenuTimeBudget) == ERROR_SUCCESS) {
+            menuTimeBudget = regMenuTimeBudget;
+        }
+        return menuTimeBudget;
+    }
+
+    //
+    // Checks whether we should fill our caches in the background when our
+    // DLL is loaded, so that the first contextual menu is shown faster.
+    //
+    // @return true to prewarm caches.
+    //
+    bool Settings::GetPrewarmCaches() const
+    {
+        // Perform late-revising.
+        Revise();
+
+        // Check if value exists. If so, read it, otherwise use default value.
+        bool prewarmCaches = SETTING_PREWARM_CACHES_DEFAULT;
+        DWORD regPrewarmCaches = 0;
+        if (GetUserKeyForReading().QueryDWORDValue(SETTING_PREWARM_CACHES, regPrewarmCaches) == ERROR_SUCCESS) {
+            prewarmCaches = regPrewarmCaches != 0;
+        }
+        return prewarmCaches;
+    }
+
+    //
+    // Checks whether paths converted by plugins whose results are expensive to
+    // compute (like UNC and COM plugins) can be cached and shared between our
+    // processes for a short time. See PathResultCache.
+    //
+    // @return true to cache converted paths.
+    //
+    bool Settings::GetCacheConvertedPaths() const
+    {
+        // Perform late-revising.
+        Revise();
+
+        // Check if value exists. If so, read it, otherwise use default value.
+        bool cacheConvertedPaths = SETTING_CACHE_CONVERTED_PATHS_DEFAULT;
+        DWORD regCacheConvertedPaths = 0;
+        if (GetUserKeyForReading().QueryDWORDValue(SETTING_CACHE_CONVERTED_PATHS, regCacheConvertedPaths) == ERROR_SUCCESS) {
+            cacheConvertedPaths = regCacheConvertedPaths != 0;
+        }
+        return cacheConvertedPaths;
+    }
+
+    //
+    // Checks whether UNC paths in a DFS namespace should be resolved to the
+    // network path of their target, like \\server\share\Folder instead of
+    // \\domain\Namespace\Folder. See DFSReferralCache.
+    //
+    // @return true to resolve DFS paths.
+    //
+    bool Settings::GetResolveDFSPaths() const
+    {
+        // Perform late-revising.
+        Revise();
+
+        // Check if value exists. If so, read it, otherwise use default value.
+        bool resolveDFSPaths = SETTING_RESOLVE_DFS_PATHS_DEFAULT;
+        DWORD regResolveDFSPaths = 0;
+        if (GetUserKeyForReading().QueryDWORDValue(SETTING_RESOLVE_DFS_PATHS, regResolveDFSPaths) == ERROR_SUCCESS) {
+            resolveDFSPaths = regResolveDFSPaths != 0;
+        }
+        return resolveDFSPaths;
+    }
+
+    //
+    // Checks whether plugins returning short paths should be disabled in the
+    // contextual menu for files on volumes that have no short names.
+    // See ShortNameSupportCache.
+    //
+    // @return true to disable short path plugins when short names are not supported.
+    //
+    bool Settings::GetDisableShortNamesIfUnsupported() const
+    {
+        // Perform late-revising.
+        Revise();
+
+        // Check if value exists. If so, read it, otherwise use default value.
+        bool disableShortNamesIfUnsupported = SETTING_DISABLE_UNSUPPORTED_SHORT_NAMES_DEFAULT;
+        DWORD regDisableShortNamesIfUnsupported = 0;
+        if (GetUserKeyForReading().QueryDWORDValue(SETTING_DISABLE_UNSUPPORTED_SHORT_NAMES,
+                                                   regDisableShortNamesIfUnsupported) == ERROR_SUCCESS) {
+
+            disableShortNamesIfUnsupported = regDisableShortNamesIfUnsupported != 0;
+        }
+        return disableShortNamesIfUnsupported;
+    }
+
+    //
+    // Returns the names of the files or folders marking the root of a
+    // repository or project, like ".git". Used by the repository path
+    // plugin (see RepositoryRootCache).
+    //
+    // @return Names of root markers.
+    //
+    WStringV Settings::GetProjectRootMarkers() const
+    {
+        // Perform late-revising.
+        Revise();
+
+        std::wstring markers;
+        if (PluginUtils::ReadRegistryStringValue(GetUserKeyForReading(), SETTING_PROJECT_ROOT_MARKERS, markers) != ERROR_SUCCESS) {
+            markers = SETTING_PROJECT_ROOT_MARKERS_DEFAULT;
+        }
+        WStringV vMarkers;
+        StringUtils::Split(markers, PROJECT_ROOT_MARKERS_SEPARATOR, vMarkers);
+        return vMarkers;
+    }
+
+    //
+    // Returns the aliases to use instead of the names of Windows servers in
+    // Samba paths, like "fileserver=fs.example.com". Entries are separated
+    // by commas; entries without an alias are ignored. Server names are
+    // returned in lowercase, since they are not case-sensitive.
+    //
+    // @return Map of aliases, per lowercase server name.
+    //
+    WStringWStringUM Settings::GetSambaServerAliases() const
+    {
+        // Perform late-revising.
+        Revise();
+
+        WStringWStringUM mAliases;
+        std::wstring aliases;
+        if (PluginUtils::ReadRegistryStringValue(GetUserKeyForReading(), SETTING_SAMBA_SERVER_ALIASES, aliases) == ERROR_SUCCESS) {
+            WStringV vEntries;
+            StringUtils::Split(aliases, SAMBA_SERVER_ALIASES_SEPARATOR, vEntries);
+            for (std::wstring& entry : vEntries) {
+                const std::wstring::size_type separatorPos = entry.find(SAMBA_SERVER_ALIAS_VALUE_SEPARATOR);
+                if (separatorPos != 0 && separatorPos != std::wstring::npos && separatorPos + 1 < entry.size()) {
+                    std::wstring server(entry, 0, separatorPos);
+                    ::CharLowerBuffW(&*server.begin(), static_cast<DWORD>(server.size()));
+                    mAliases.emplace(std::move(server), entry.substr(separatorPos + 1));
+                }
+            }
+        }
+        return mAliases;
+    }
+
+    //
+    // Returns a value identifying the current state of the settings, computed
+    // from the last write times of all our registry keys. It changes whenever
+    // settings or plugins are modified, by any process, so it can be used to
+    // validate data derived from the settings that is shared between processes.
+    //
+    // @return Settings generation, or 0 if settings are read from custom keys
+    //         (see UseKeysForReading) and thus have no generation.
+    //
+    ULONGLONG Settings::GetGeneration() const
+    {
+        if (m_pUserKeyForReading != nullptr) {
+            return 0;
+        }
+
+        // Mix the keys' last write times using FNV-1a.
+        ULONGLONG generation = 14695981039346656037ull;
+        const HKEY hKeys[] = {
+            m_UserKey.GetUserKey().GetHKEY(),
+            m_UserKey.GetGlobalKey().GetHKEY(),
+            m_PipelinePluginsKey.GetUserKey().GetHKEY(),
+            m_PipelinePluginsKey.GetGlobalKey().GetHKEY(),
+            m_UserPluginsKey.GetHKEY(),
+            m_GlobalPluginsKey.GetHKEY(),
+        };
+        for (HKEY const hKey : hKeys) {
+            FILETIME lastWriteTime = FILETIME();
+            if (hKey != NULL) {
+                ::RegQueryInfoKeyW(hKey, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+                                   nullptr, nullptr, nullptr, nullptr, &lastWriteTime);
+            }
+            const BYTE* const pBytes = reinterpret_cast<const BYTE*>(&lastWriteTime);
+            for (size_t i = 0; i < sizeof(lastWriteTime); ++i) {
+                generation = (generation ^ pBytes[i]) * 1099511628211ull;
+            }
+        }
+        return generation != 0 ? generation : 1;
+    }
+
     //
     // Returns the plugin to use when user opens the contextual menu
     // while holding down the Ctrl key.
@@ -507,7 +836,7 @@ namespace PCC
 
         bool hasPluginId = false;
         std::wstring pluginAsString;
-        if (PluginUtils::ReadRegistryStringValue(m_UserKey, SETTING_CTRL_KEY_PLUGIN, pluginAsString) == ERROR_SUCCESS) {
+        if (PluginUtils::ReadRegistryStringValue(GetUserKeyForReading(), SETTING_CTRL_KEY_PLUGIN, pluginAsString) == ERROR_SUCCESS) {
             GUIDV vPluginIds = PluginUtils::StringToPluginIds(pluginAsString, PLUGINS_SEPARATOR);
             if (vPluginIds.size() == 1) {
                 p_rPluginId = vPluginIds.front();
@@ -530,15 +859,7 @@ namespace PCC
         // Perform late-revising.
         Revise();
 
-        std::wstring pluginsAsString;
-        bool hasValues = PluginUtils::ReadRegistryStringValue(m_UserKey, SETTING_MAIN_MENU_PLUGIN_DISPLAY_ORDER, pluginsAsString) == ERROR_SUCCESS;
-        if (hasValues) {
-            p_rvPluginIds.clear();
-            if (!pluginsAsString.empty()) {
-                p_rvPluginIds = PluginUtils::StringToPluginIds(pluginsAsString, PLUGINS_SEPARATOR);
-            }
-        }
-        return hasValues;
+        return GetPluginIds(SETTING_MAIN_MENU_PLUGIN_DISPLAY_ORDER, SETTING_MAIN_MENU_PLUGIN_DISPLAY_ORDER_PACKED, p_rvPluginIds);
     }
 
     //
@@ -554,15 +875,7 @@ namespace PCC
         // Perform late-revising.
         Revise();
 
-        std::wstring pluginsAsString;
-        bool hasValues = PluginUtils::ReadRegistryStringValue(m_UserKey, SETTING_SUBMENU_PLUGIN_DISPLAY_ORDER, pluginsAsString) == ERROR_SUCCESS;
-        if (hasValues) {
-            p_rvPluginIds.clear();
-            if (!pluginsAsString.empty()) {
-                p_rvPluginIds = PluginUtils::StringToPluginIds(pluginsAsString, PLUGINS_SEPARATOR);
-            }
-        }
-        return hasValues;
+        return GetPluginIds(SETTING_SUBMENU_PLUGIN_DISPLAY_ORDER, SETTING_SUBMENU_PLUGIN_DISPLAY_ORDER_PACKED, p_rvPluginIds);
     }
 
     //
@@ -579,15 +892,42 @@ namespace PCC
         // Perform late-revising.
         Revise();
 
-        std::wstring pluginsAsString;
-        bool hasValues = PluginUtils::ReadRegistryStringValue(m_UserKey, SETTING_KNOWN_PLUGINS, pluginsAsString) == ERROR_SUCCESS;
-        if (hasValues) {
-            p_rvPluginIds.clear();
-            if (!pluginsAsString.empty()) {
-                p_rvPluginIds = PluginUtils::StringToPluginIds(pluginsAsString, PLUGINS_SEPARATOR);
-            }
+        return GetPluginIds(SETTING_KNOWN_PLUGINS, SETTING_KNOWN_PLUGINS_PACKED, p_rvPluginIds);
+    }
+
+    //
+    // Returns the global hotkeys registered by the resident service (see
+    // ResidentService) along with the plugins they invoke on the current
+    // Explorer selection. Each hotkey is stored as a virtual-key code in
+    // its low byte and a combination of MOD_* flags in its second byte.
+    //
+    // @param p_rvPluginIds Where to store the IDs of the plugins to invoke.
+    // @param p_rvHotkeys Where to store the hotkeys; each one matches the
+    //                    plugin at the same index in p_rvPluginIds.
+    // @return true if at least one hotkey is defined.
+    //
+    bool Settings::GetHotkeys(GUIDV& p_rvPluginIds,
+                              UInt32V& p_rvHotkeys) const
+    {
+        // Perform late-revising.
+        Revise();
+
+        p_rvPluginIds.clear();
+        p_rvHotkeys.clear();
+        std::wstring pluginsAsString, hotkeysAsString;
+        if (PluginUtils::ReadRegistryStringValue(GetUserKeyForReading(), SETTING_HOTKEY_PLUGINS, pluginsAsString) == ERROR_SUCCESS &&
+            PluginUtils::ReadRegistryStringValue(GetUserKeyForReading(), SETTING_HOTKEYS, hotkeysAsString) == ERROR_SUCCESS &&
+            !pluginsAsString.empty() && !hotkeysAsString.empty()) {
+
+            p_rvPluginIds = PluginUtils::StringToPluginIds(pluginsAsString, PLUGINS_SEPARATOR);
+            p_rvHotkeys = PluginUtils::StringToUInt32s(hotkeysAsString, PLUGINS_SEPARATOR);
+
+            // Ignore any trailing element not matched in the other list.
+            const size_t count = (std::min)(p_rvPluginIds.size(), p_rvHotkeys.size());
+            p_rvPluginIds.resize(count);
+            p_rvHotkeys.resize(count);
         }
-        return hasValues;
+        return !p_rvPluginIds.empty();
     }
 
     //
@@ -596,44 +936,55 @@ namespace PCC
     // @return true if an update check is needed.
     //
     bool Settings::NeedsUpdateCheck() const
+    {
+        // Get current time.
+        __time64_t now;
+        ::_time64(&now);
+
+        return now >= GetNextUpdateCheckTime();
+    }
+
+    //
+    // Returns the time at which the next software update check will be due,
+    // according to the last time we did one.
+    //
+    // @return Time of next update check, or _MAX__TIME64_T if software update is disabled.
+    //
+    __time64_t Settings::GetNextUpdateCheckTime() const
     {
         // Perform late-revising.
         Revise();
 
-        bool needsUpdate = false;
+        __time64_t nextUpdateCheck = _MAX__TIME64_T;
 
         // Check if software update is disabled.
         bool updateDisabled = SETTING_DISABLE_SOFTWARE_UPDATE_DEFAULT;
         DWORD storedUpdateDisabled = 0;
-        if (m_UserKey.QueryDWORDValue(SETTING_DISABLE_SOFTWARE_UPDATE, storedUpdateDisabled) == ERROR_SUCCESS) {
+        if (GetUserKeyForReading().QueryDWORDValue(SETTING_DISABLE_SOFTWARE_UPDATE, storedUpdateDisabled) == ERROR_SUCCESS) {
             updateDisabled = storedUpdateDisabled != 0;
         }
         if (!updateDisabled) {
             // Get last time it was performed. If we don't have info on that, assume that it's been a hell of a while.
             __time64_t lastUpdateCheck;
             ULONGLONG storedLastUpdate = 0;
-            if (m_UserKey.QueryQWORDValue(SETTING_LAST_UPDATE_CHECK, storedLastUpdate) == ERROR_SUCCESS) {
+            if (GetUserKeyForReading().QueryQWORDValue(SETTING_LAST_UPDATE_CHECK, storedLastUpdate) == ERROR_SUCCESS) {
                 lastUpdateCheck = static_cast<__time64_t>(storedLastUpdate);
             } else {
                 lastUpdateCheck = 0;
             }
 
-            // Get current time.
-            __time64_t now;
-            ::_time64(&now);
-
             // Get update interval.
             double updateInterval = SETTING_UPDATE_INTERVAL_DEFAULT;
             DWORD storedUpdateInterval = 0;
-            if (m_UserKey.QueryDWORDValue(SETTING_UPDATE_INTERVAL, storedUpdateInterval) == ERROR_SUCCESS) {
+            if (GetUserKeyForReading().QueryDWORDValue(SETTING_UPDATE_INTERVAL, storedUpdateInterval) == ERROR_SUCCESS) {
                 updateInterval = static_cast<double>(storedUpdateInterval);
             }
 
-            // Compare and check if enough time has passed.
-            needsUpdate = ::_difftime64(now, lastUpdateCheck) >= updateInterval;
+            // Next check is due once enough time has passed.
+            nextUpdateCheck = lastUpdateCheck + static_cast<__time64_t>(updateInterval);
         }
 
-        return needsUpdate;
+        return nextUpdateCheck;
     }
 
     //
@@ -648,6 +999,10 @@ namespace PCC
         __time64_t now;
         ::_time64(&now);
         m_UserKey.SetQWORDValue(SETTING_LAST_UPDATE_CHECK, static_cast<ULONGLONG>(now));
+
+        // Our snapshot, if any, is now out of date.
+        m_upUserKeySnapshot.reset();
+        m_upShownPlugins.reset();
     }
 
     //
@@ -672,7 +1027,7 @@ namespace PCC
         if (SUCCEEDED(hRes)) {
             // Look for a value for this plugin in the icons key.
             std::wstring iconFile;
-            if (PluginUtils::ReadRegistryStringValue(m_IconsKey, pluginIdAsString, iconFile) == ERROR_SUCCESS) {
+            if (PluginUtils::ReadRegistryStringValue(GetIconsKeyForReading(), pluginIdAsString, iconFile) == ERROR_SUCCESS) {
                 // Check if it's the marker value pointing to the default icon.
                 if (iconFile == DEFAULT_ICON_MARKER_STRING) {
                     // Return an empty string to note this.
@@ -689,6 +1044,43 @@ namespace PCC
         return resultingIconFile;
     }
 
+    //
+    // Reads the whole Icons key at once and returns the icon files of all plugins
+    // found in it, as GetIconFileForPlugin would return them. This is faster than
+    // calling GetIconFileForPlugin for each plugin shown in a menu.
+    //
+    // @return Icon files of plugins, per plugin ID, sorted by ID (see GUIDLess).
+    //         Plugins that use the default icon are paired with an empty string.
+    //
+    GUIDWStringPairV Settings::GetIconFilesForPlugins() const
+    {
+        // Perform late-revising.
+        Revise();
+
+        GUIDWStringPairV vIconFiles;
+        const RegKey& iconsKey = GetIconsKeyForReading();
+        RegKey::ValueInfoV vValues;
+        iconsKey.GetValues(vValues);
+        vIconFiles.reserve(vValues.size());
+        for (const auto& valueInfo : vValues) {
+            CLSID pluginId;
+            std::wstring iconFile;
+            if (SUCCEEDED(::CLSIDFromString(valueInfo.m_ValueName.c_str(), &pluginId)) &&
+                PluginUtils::ReadRegistryStringValue(iconsKey, valueInfo.m_ValueName.c_str(), iconFile) == ERROR_SUCCESS) {
+
+                if (iconFile == DEFAULT_ICON_MARKER_STRING) {
+                    iconFile.clear();
+                }
+                vIconFiles.emplace_back(pluginId, std::move(iconFile));
+            }
+        }
+        std::sort(vIconFiles.begin(), vIconFiles.end(), [](const GUIDWStringPairV::value_type& p_Left,
+                                                           const GUIDWStringPairV::value_type& p_Right) {
+            return GUIDLess()(p_Left.first, p_Right.first);
+        });
+        return vIconFiles;
+    }
+
     //
     // Checks whether the administrator has disabled editing of the
     // settings by the settings app.
@@ -698,7 +1090,35 @@ namespace PCC
     bool Settings::GetEditingDisabled() const
     {
         // No need to revise for this because this cannot change.
-        return m_UserKey.Locked();
+        return m_upUserKeySnapshot != nullptr ? m_upUserKeySnapshot->Locked() : m_UserKey.Locked();
+    }
+
+    //
+    // Checks if a specific plugin is shown at all in our contextual menu,
+    // whether in the main menu or in the submenu.
+    //
+    // Computing the set of shown plugins can require loading all plugins,
+    // so if we have a snapshot of the settings, the set is computed once and
+    // reused until the snapshot changes.
+    //
+    // @param p_PluginId ID of plugin to look for.
+    // @return true if the plugin is displayed.
+    //
+    bool Settings::IsPluginShown(const GUID& p_PluginId) const
+    {
+        // Perform late-revising.
+        Revise();
+
+        if (m_upShownPlugins != nullptr) {
+            return m_upShownPlugins->find(p_PluginId) != m_upShownPlugins->end();
+        }
+
+        GUIDS sShownPlugins = PluginUtils::GetShownPlugins(*this);
+        const bool shown = sShownPlugins.find(p_PluginId) != sShownPlugins.end();
+        if (m_upUserKeySnapshot != nullptr || m_pUserKeyForReading != nullptr) {
+            m_upShownPlugins.reset(new GUIDS(std::move(sShownPlugins)));
+        }
+        return shown;
     }
 
     //
@@ -726,6 +1146,37 @@ namespace PCC
         return vPluginIds;
     }
 
+    //
+    // Checks whether an instance of a COM plugin can be reused once created.
+    // Plugins can be excluded by listing them in the NonReusableCOMPlugins setting.
+    //
+    // @param p_CLSID ID of COM plugin.
+    // @return true if plugin instances can be reused.
+    //
+    bool Settings::CanReuseCOMPlugin(const CLSID& p_CLSID) const
+    {
+        // Perform late-revising.
+        Revise();
+
+        return !IsCOMPluginInList(SETTING_NON_REUSABLE_COM_PLUGINS, p_CLSID);
+    }
+
+    //
+    // Checks whether a COM plugin should be loaded in the COM plugin host process
+    // instead of in Explorer. Plugins can be isolated by listing them in the
+    // IsolatedCOMPlugins setting.
+    //
+    // @param p_CLSID ID of COM plugin.
+    // @return true if plugin should be isolated.
+    //
+    bool Settings::ShouldIsolateCOMPlugin(const CLSID& p_CLSID) const
+    {
+        // Perform late-revising.
+        Revise();
+
+        return IsCOMPluginInList(SETTING_ISOLATED_COM_PLUGINS, p_CLSID);
+    }
+
     //
     // Registers a plugin in the Path Copy Copy registry so that it is used in the contextual menu.
     //
@@ -755,9 +1206,13 @@ namespace PCC
                     // Register plugin.
                     rKey.SetStringValue(clsidAsString.Get(), GetCOMPluginInfo(p_CLSID).c_str());
 
-                    // We successfully registered.
+                    // We successfully registered. This could change the default plugins.
                     registered = true;
+                    m_upShownPlugins.reset();
                 }
+
+                // Cache plugin metadata now so that menus can be built without creating the plugin.
+                COMPluginMetadataCache::Refresh(p_CLSID);
             } else {
                 throw SettingsException(static_cast<LONG>(hRes));
             }
@@ -791,6 +1246,11 @@ namespace PCC
             if (SUCCEEDED(hRes)) {
                 // Unregister the plugin and check if it worked in one swoop.
                 unregistered = rKey.DeleteValue(clsidAsString.Get()) == ERROR_SUCCESS;
+                COMPluginMetadataCache::Remove(p_CLSID);
+                if (unregistered) {
+                    // This could change the default plugins.
+                    m_upShownPlugins.reset();
+                }
             } else {
                 throw SettingsException(static_cast<LONG>(hRes));
             }
@@ -865,6 +1325,106 @@ namespace PCC
         }
     }
 
+    //
+    // Reads a list of plugin IDs stored in a user settings value. The list is
+    // stored as a string, but can also be stored in a packed binary value
+    // alongside it, which is used if it is up-to-date to avoid parsing.
+    //
+    // @param p_pValueName Name of value containing the list as a string.
+    // @param p_pPackedValueName Name of value containing the packed list.
+    // @param p_rvPluginIds Upon return, will contain a list of plugin IDs.
+    //                      If the method returns false, this list is untouched.
+    // @return true if the list was found in the settings and copied to p_rvPluginIds.
+    //
+    bool Settings::GetPluginIds(const wchar_t* const p_pValueName,
+                                const wchar_t* const p_pPackedValueName,
+                                GUIDV& p_rvPluginIds) const
+    {
+        std::wstring pluginsAsString;
+        bool hasValues = PluginUtils::ReadRegistryStringValue(GetUserKeyForReading(), p_pValueName, pluginsAsString) == ERROR_SUCCESS;
+        if (hasValues) {
+            p_rvPluginIds.clear();
+            if (!pluginsAsString.empty()) {
+                // The packed value is a binary value containing characters stored like this
+                // (ints are stored as two characters, low 16 bits first, like in binary pipelines):
+                //
+                // <hash of string value (see HashPluginIdsString)><plugin ID, as 8 characters>...
+                //
+                // If the string value was modified without updating the packed value
+                // (for example by an older version of the settings app), the hash won't match.
+                const size_t guidChars = sizeof(GUID) / sizeof(wchar_t);
+                std::wstring packed;
+                if (PluginUtils::ReadRegistryBinaryStringValue(GetUserKeyForReading(), p_pPackedValueName, packed) == ERROR_SUCCESS &&
+                    packed.size() >= 2 && (packed.size() - 2) % guidChars == 0 &&
+                    (static_cast<DWORD>(packed[0]) | (static_cast<DWORD>(packed[1]) << 16)) == HashPluginIdsString(pluginsAsString)) {
+
+                    p_rvPluginIds.resize((packed.size() - 2) / guidChars);
+                    if (!p_rvPluginIds.empty()) {
+                        ::memcpy(&*p_rvPluginIds.begin(), &packed[2], p_rvPluginIds.size() * sizeof(GUID));
+                    }
+                } else {
+                    p_rvPluginIds = PluginUtils::StringToPluginIds(pluginsAsString, PLUGINS_SEPARATOR);
+                }
+            }
+        }
+        return hasValues;
+    }
+
+    //
+    // Returns the registry key to use to read user settings. If we have
+    // a snapshot of the settings, it is used, otherwise the actual key is.
+    // Keys passed to UseKeysForReading have precedence over both.
+    //
+    // @return Registry key to read user settings from.
+    //
+    const RegKey& Settings::GetUserKeyForReading() const
+    {
+        if (m_pUserKeyForReading != nullptr) {
+            return *m_pUserKeyForReading;
+        }
+        return m_upUserKeySnapshot != nullptr ? static_cast<const RegKey&>(*m_upUserKeySnapshot)
+                                              : static_cast<const RegKey&>(m_UserKey);
+    }
+
+    //
+    // Returns the registry key to use to read plugin icons. If we have
+    // a snapshot of the icons, it is used, otherwise the actual key is.
+    // Keys passed to UseKeysForReading have precedence over both.
+    //
+    // @return Registry key to read plugin icons from.
+    //
+    const RegKey& Settings::GetIconsKeyForReading() const
+    {
+        if (m_pIconsKeyForReading != nullptr) {
+            return *m_pIconsKeyForReading;
+        }
+        return m_upIconsKeySnapshot != nullptr ? static_cast<const RegKey&>(*m_upIconsKeySnapshot)
+                                               : static_cast<const RegKey&>(m_IconsKey);
+    }
+
+    //
+    // Checks if a COM plugin is listed in a setting containing a list of plugin IDs.
+    //
+    // @param p_pValueName Name of setting value containing the list.
+    // @param p_CLSID ID of COM plugin.
+    // @return true if plugin is in the list.
+    //
+    bool Settings::IsCOMPluginInList(const wchar_t* const p_pValueName,
+                                     const CLSID& p_CLSID) const
+    {
+        bool inList = false;
+        std::wstring pluginsAsString;
+        if (PluginUtils::ReadRegistryStringValue(GetUserKeyForReading(), p_pValueName, pluginsAsString) == ERROR_SUCCESS &&
+            !pluginsAsString.empty()) {
+
+            GUIDV vPluginIds = PluginUtils::StringToPluginIds(pluginsAsString, PLUGINS_SEPARATOR);
+            inList = std::find_if(vPluginIds.cbegin(), vPluginIds.cend(), [&](const GUID& p_PluginId) {
+                return ::IsEqualGUID(p_PluginId, p_CLSID) != FALSE;
+            }) != vPluginIds.cend();
+        }
+        return inList;
+    }
+
     //
     // Returns the info to write in the value for a registered
     // COM plugin. This info is no longer used by the UI, but left
@@ -947,21 +1507,198 @@ namespace PCC
     void Settings::GetPipelinePlugins(const RegKey& p_PipelinePluginsKey,
                                       PluginSPV& p_rvspPlugins,
                                       const bool p_AddSeparator)
+    {
+        PluginSPV vspPipelinePlugins;
+        LoadPipelinePlugins(p_PipelinePluginsKey, vspPipelinePlugins);
+        AddPipelinePlugins(p_PipelinePluginsKey, vspPipelinePlugins, p_rvspPlugins, p_AddSeparator);
+    }
+
+    //
+    // Static method that loads pipeline plugins found in the given user-overrideable
+    // pipeline plugins registry key. The user and global keys are loaded separately,
+    // so that each one can use the packed format when available.
+    //
+    // @param p_PipelinePluginsKey Registry key containing pipeline plugins to load.
+    // @param p_rvspPlugins Where to save all pipeline plugins.
+    // @param p_AddSeparator Whether to add a separator before pipeline plugins if
+    //                       p_rvspPlugins already contains plugins.
+    //
+    void Settings::GetPipelinePlugins(const UserOverrideableRegKey& p_PipelinePluginsKey,
+                                      PluginSPV& p_rvspPlugins,
+                                      const bool p_AddSeparator)
+    {
+        // Load user plugins first; they override global plugins with the same ID.
+        PluginSPV vspPipelinePlugins;
+        if (p_PipelinePluginsKey.GetUserKey().Valid() && !p_PipelinePluginsKey.Locked()) {
+            LoadPipelinePlugins(p_PipelinePluginsKey.GetUserKey(), vspPipelinePlugins);
+        }
+        if (p_PipelinePluginsKey.GetGlobalKey().Valid()) {
+            PluginSPV vspGlobalPipelinePlugins;
+            LoadPipelinePlugins(p_PipelinePluginsKey.GetGlobalKey(), vspGlobalPipelinePlugins);
+            const size_t userPluginCount = vspPipelinePlugins.size();
+            for (PluginSP& spGlobalPlugin : vspGlobalPipelinePlugins) {
+                auto userEnd = vspPipelinePlugins.cbegin() + userPluginCount;
+                auto userIt = std::find_if(vspPipelinePlugins.cbegin(), userEnd, [&](const PluginSP& p_spUserPlugin) {
+                    return ::IsEqualGUID(p_spUserPlugin->Id(), spGlobalPlugin->Id()) != FALSE;
+                });
+                if (userIt == userEnd) {
+                    vspPipelinePlugins.push_back(std::move(spGlobalPlugin));
+                }
+            }
+        }
+        AddPipelinePlugins(p_PipelinePluginsKey, vspPipelinePlugins, p_rvspPlugins, p_AddSeparator);
+    }
+
+    //
+    // Static method that loads pipeline plugins stored in the given registry key,
+    // in no particular order. Plugins are loaded from the packed value written
+    // by the settings app if present, otherwise from the legacy per-plugin subkeys.
+    //
+    // @param p_PipelinePluginsKey Registry key containing pipeline plugins to load.
+    // @param p_rvspPipelinePlugins Where to save loaded pipeline plugins.
+    //
+    void Settings::LoadPipelinePlugins(const RegKey& p_PipelinePluginsKey,
+                                       PluginSPV& p_rvspPipelinePlugins)
+    {
+        if (!LoadPackedPipelinePlugins(p_PipelinePluginsKey, p_rvspPipelinePlugins)) {
+            LoadLegacyPipelinePlugins(p_PipelinePluginsKey, p_rvspPipelinePlugins);
+        }
+    }
+
+    //
+    // Static method that loads pipeline plugins from the packed value stored in
+    // the given registry key. The packed value contains all pipeline plugins
+    // saved in that key, so it can be read in one registry call. It is only
+    // used if the subkeys storing the plugins haven't changed since it was
+    // written (for example by an older version of the settings app or by
+    // revisions); checking this only requires enumerating the subkeys,
+    // not opening them.
+    //
+    // @param p_PipelinePluginsKey Registry key containing pipeline plugins to load.
+    // @param p_rvspPipelinePlugins Where to save loaded pipeline plugins.
+    // @return true if the packed value was found and valid. If false, nothing
+    //         is added to p_rvspPipelinePlugins.
+    //
+    bool Settings::LoadPackedPipelinePlugins(const RegKey& p_PipelinePluginsKey,
+                                             PluginSPV& p_rvspPipelinePlugins)
+    {
+        // The packed value is a binary value containing characters stored like this
+        // (ints are stored as two characters, low 16 bits first, like in binary pipelines):
+        //
+        // <signature><subkey count><subkeys last write time, low part><... high part>
+        // <plugin count>
+        // <plugin ID, as 8 characters><description length><description>
+        //     <encoded elements length><encoded elements>
+        //     <has icon file (0 or 1)>[<icon file length><icon file>]
+        //     <folder length><folder>
+        // ...
+        //
+        // The stamp (subkey count and last write time) is computed by ComputePipelinePluginsStamp.
+        std::wstring packed;
+        if (PluginUtils::ReadRegistryBinaryStringValue(p_PipelinePluginsKey, SETTING_PIPELINE_PACKED_PLUGINS, packed) != ERROR_SUCCESS ||
+            packed.empty() || packed.front() != PACKED_PIPELINE_PLUGINS_SIGNATURE_WITH_STAMP) {
+
+            return false;
+        }
+
+        auto it = packed.cbegin() + 1;
+        const auto end = packed.cend();
+        auto readInt = [&](DWORD& p_rValue) -> bool {
+            if (end - it < 2) {
+                return false;
+            }
+            p_rValue = static_cast<DWORD>(*it) | (static_cast<DWORD>(*(it + 1)) << 16);
+            it += 2;
+            return true;
+        };
+        auto readString = [&](std::wstring& p_rValue) -> bool {
+            DWORD length = 0;
+            if (!readInt(length) || static_cast<DWORD>(end - it) < length) {
+                return false;
+            }
+            p_rValue.assign(it, it + length);
+            it += length;
+            return true;
+        };
+        auto readGUID = [&](GUID& p_rValue) -> bool {
+            const size_t guidChars = sizeof(GUID) / sizeof(wchar_t);
+            if (static_cast<size_t>(end - it) < guidChars) {
+                return false;
+            }
+            ::memcpy(&p_rValue, &*it, sizeof(GUID));
+            it += guidChars;
+            return true;
+        };
+
+        DWORD packedStamp[3] = { 0 }, stamp[3] = { 0 };
+        if (!readInt(packedStamp[0]) || !readInt(packedStamp[1]) || !readInt(packedStamp[2])) {
+            return false;
+        }
+        ComputePipelinePluginsStamp(p_PipelinePluginsKey, stamp);
+        if (!std::equal(std::begin(stamp), std::end(stamp), std::begin(packedStamp))) {
+            // Subkeys were modified since the packed value was written; it's stale.
+            return false;
+        }
+
+        DWORD pluginCount = 0;
+        if (!readInt(pluginCount)) {
+            return false;
+        }
+        PluginSPV vspPipelinePlugins;
+        vspPipelinePlugins.reserve((std::min)(static_cast<size_t>(pluginCount), packed.size()));
+        for (DWORD i = 0; i < pluginCount; ++i) {
+            GUID pluginId = { 0 };
+            std::wstring description, encodedElements, iconFile, menuFolder;
+            bool hasIconFile = false;
+            bool valid = readGUID(pluginId) && readString(description) && readString(encodedElements) && it != end;
+            if (valid) {
+                hasIconFile = *it++ != L'\0';
+                if (hasIconFile) {
+                    valid = readString(iconFile);
+                }
+            }
+            if (valid) {
+                valid = readString(menuFolder);
+            }
+            if (!valid) {
+                // Packed value is corrupted, fall back to the legacy layout.
+                return false;
+            }
+
+            // An empty icon file indicates that we want to use the default icon.
+            vspPipelinePlugins.push_back(std::make_shared<PCC::Plugins::PipelinePlugin>(
+                pluginId, description, iconFile, hasIconFile && iconFile.empty(), menuFolder, encodedElements));
+        }
+
+        std::move(vspPipelinePlugins.begin(), vspPipelinePlugins.end(), std::back_inserter(p_rvspPipelinePlugins));
+        return true;
+    }
+
+    //
+    // Static method that loads pipeline plugins stored as subkeys of the given
+    // registry key. This is the legacy layout, used when the packed value is absent.
+    //
+    // @param p_PipelinePluginsKey Registry key containing pipeline plugins to load.
+    // @param p_rvspPipelinePlugins Where to save loaded pipeline plugins.
+    //
+    void Settings::LoadLegacyPipelinePlugins(const RegKey& p_PipelinePluginsKey,
+                                             PluginSPV& p_rvspPipelinePlugins)
     {
         // Pipeline plugins are stored in the registry in this way:
         //
         // clechasseur\PathCopyCopy
         // \- <pipeline plugins key>
         //    |   val DisplayOrder = <guid>,<guid>...
+        //    |   val PackedPlugins = <optional packed plugins, see LoadPackedPipelinePlugins>
         //    \- <guid>
-        //    |     val '' = <encoded pipeline>
+        //    |     val '' = <encoded pipeline, as a string or binary value>
         //    |     val Description = <description>
         //    |     val IconFile = <optional path to icon file>
+        //    |     val Folder = <optional name of nested submenu>
         //    \- <guid>
         //          ...
         //
         // We'll need to enumerate the subkeys of the pipeline plugins key to find plugins.
-        PluginSPV vspPipelinePlugins;
         RegKey::SubkeyInfoV vSubkeyInfos;
         p_PipelinePluginsKey.GetSubKeys(vSubkeyInfos);
         for (const auto& subkeyInfo : vSubkeyInfos) {
@@ -970,7 +1707,7 @@ namespace PCC
             if (::CLSIDFromString(const_cast<wchar_t*>(subkeyInfo.m_KeyName.c_str()), &pluginId) == S_OK) {
                 // Get values for the pipeline encoded elements as well as the plugin description
                 // and its optional icon file.
-                std::wstring encodedElements, description, iconFile;
+                std::wstring encodedElements, description, iconFile, menuFolder;
                 bool useDefaultIcon = false;
                 AtlRegKey pluginKey;
                 LONG res = pluginKey.Open(subkeyInfo.m_hParent, subkeyInfo.m_KeyName.c_str(), false, KEY_QUERY_VALUE);
@@ -979,6 +1716,10 @@ namespace PCC
                 }
                 if (res == ERROR_SUCCESS) {
                     res = PluginUtils::ReadRegistryStringValue(pluginKey, nullptr, encodedElements);
+                    if (res == ERROR_INVALID_DATATYPE) {
+                        // Pipeline might be encoded in binary format.
+                        res = PluginUtils::ReadRegistryBinaryStringValue(pluginKey, nullptr, encodedElements);
+                    }
                 }
                 if (res == ERROR_SUCCESS) {
                     // Icon file is optional. If not found, we're not displaying any icon.
@@ -987,15 +1728,37 @@ namespace PCC
                         // This indicates that we want to use the default icon.
                         useDefaultIcon = true;
                     }
+
+                    // Folder is optional too. If not found, plugin is not in a nested submenu.
+                    if (PluginUtils::ReadRegistryStringValue(pluginKey, SETTING_PIPELINE_MENU_FOLDER, menuFolder) != ERROR_SUCCESS) {
+                        menuFolder.clear();
+                    }
                 }
                 if (res == ERROR_SUCCESS) {
                     // We have all the info we need, create the plugin and add it to the temp list.
-                    vspPipelinePlugins.push_back(std::make_shared<PCC::Plugins::PipelinePlugin>(
-                        pluginId, description, iconFile, useDefaultIcon, encodedElements));
+                    p_rvspPipelinePlugins.push_back(std::make_shared<PCC::Plugins::PipelinePlugin>(
+                        pluginId, description, iconFile, useDefaultIcon, menuFolder, encodedElements));
                 }
             }
         }
+    }
 
+    //
+    // Static method that sorts loaded pipeline plugins according to the display
+    // order stored in the given registry key, then adds them to a vector of plugins.
+    //
+    // @param p_PipelinePluginsKey Registry key containing pipeline plugins.
+    // @param p_rvspPipelinePlugins Pipeline plugins loaded from p_PipelinePluginsKey.
+    //                              Will be moved to p_rvspPlugins.
+    // @param p_rvspPlugins Where to save all pipeline plugins.
+    // @param p_AddSeparator Whether to add a separator before pipeline plugins if
+    //                       p_rvspPlugins already contains plugins.
+    //
+    void Settings::AddPipelinePlugins(const RegKey& p_PipelinePluginsKey,
+                                      PluginSPV& p_rvspPipelinePlugins,
+                                      PluginSPV& p_rvspPlugins,
+                                      const bool p_AddSeparator)
+    {
         // Get value containing the display order. If found, we'll have to reorder the
         // pipeline plugins according to this value.
         std::wstring displayOrder;
@@ -1006,17 +1769,18 @@ namespace PCC
 
             // Sort plugins using our special predicate that will order them properly.
             PipelinePluginLess lessPredicate(vOrderedPluginIds);
-            std::sort(vspPipelinePlugins.begin(), vspPipelinePlugins.end(), lessPredicate);
+            std::sort(p_rvspPipelinePlugins.begin(), p_rvspPipelinePlugins.end(), lessPredicate);
         }
 
         // If we have pipeline plugins, insert them in the provided return vector.
         // Add a separator as appropriate.
-        if (!vspPipelinePlugins.empty() && p_AddSeparator &&
+        if (!p_rvspPipelinePlugins.empty() && p_AddSeparator &&
             !p_rvspPlugins.empty() && !p_rvspPlugins.back()->IsSeparator()) {
 
             p_rvspPlugins.push_back(std::make_shared<PluginSeparator>());
         }
-        std::move(vspPipelinePlugins.begin(), vspPipelinePlugins.end(), std::back_inserter(p_rvspPlugins));
+        std::move(p_rvspPipelinePlugins.begin(), p_rvspPipelinePlugins.end(), std::back_inserter(p_rvspPlugins));
+        p_rvspPipelinePlugins.clear();
     }
 
     //
@@ -1049,6 +1813,15 @@ namespace PCC
         } _resetIsRevisingAtEndOfScope;
 #endif // _DEBUG
 
+        // Check if settings have already been fully revised up to our latest revision.
+        // If so, we can skip building the revision map and parsing applied revisions.
+        DWORD revisedUpTo = 0;
+        if (p_rUserKey.QueryDWORDValue(SETTING_REVISED_UP_TO, revisedUpTo) == ERROR_SUCCESS &&
+            revisedUpTo >= LATEST_SETTINGS_REVISION) {
+
+            return;
+        }
+
         // Create bean to store revise info.
         ReviseInfo reviseInfo(p_rUserKey, p_rPipelinePluginsKey, p_COMPluginProvider);
 
@@ -1082,6 +1855,9 @@ namespace PCC
             std::wstring newRevisionsAsString = PluginUtils::UInt32sToString(vNewRevisions, REVISIONS_SEPARATOR);
             p_rUserKey.SetStringValue(SETTING_REVISIONS, newRevisionsAsString.c_str());
         }
+
+        // Remember that all revisions have been applied so that we can skip this next time.
+        p_rUserKey.SetDWORDValue(SETTING_REVISED_UP_TO, LATEST_SETTINGS_REVISION);
     }
 
     //
@@ -1101,8 +1877,9 @@ namespace PCC
         mRevisions.emplace(201601054ul, &ApplyInitialKnownPlugins201601054);
         mRevisions.emplace(201707061ul, &ApplyInitialUIPluginDisplayOrder201707061);
 
-        // Add any new revisions here.
-        
+        // Add any new revisions here. Don't forget to update LATEST_SETTINGS_REVISION.
+
+        assert(mRevisions.rbegin()->first == LATEST_SETTINGS_REVISION);
         return mRevisions;
     }
 
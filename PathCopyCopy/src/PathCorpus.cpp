@@ -0,0 +1,349 @@
+// PathCorpus.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <stdafx.h>
+
+#ifdef PCC_BENCHMARKS
+
+#include <PathCorpus.h>
+
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+
+
+namespace
+{
+    // Seed used to generate corpora. Fixed so that results can be compared between runs.
+    const unsigned int      CORPUS_SEED             = 0x50434342u;
+
+    // Names of corpus kinds, in the order of PathCorpus::Kind.
+    const wchar_t* const    KIND_NAMES[]            = {
+        L"Mixed",
+        L"BuildTree",
+        L"LongPaths",
+        L"International",
+        L"SpecialChars",
+        L"NetworkRoots",
+        L"FlatFolder",
+    };
+
+    // Proportions of each kind of path in the mixed corpus, in the order of
+    // PathCorpus::Kind, starting at BuildTree.
+    const double            MIXED_KIND_WEIGHTS[]    = { 30.0, 5.0, 15.0, 15.0, 25.0, 10.0 };
+
+    // Folder and file names used in all kinds of paths.
+    const wchar_t* const    COMMON_FOLDERS[]        = {
+        L"Users",
+        L"clechasseur",
+        L"Documents",
+        L"Program Files (x86)",
+        L"Desktop",
+        L"Projects",
+        L"a",
+        L"2019",
+    };
+    const wchar_t* const    COMMON_FILES[]          = {
+        L"File.txt",
+        L"README",
+        L"archive.tar.gz",
+        L"Report.docx",
+        L"main.cpp",
+        L"Budget.xlsx",
+    };
+
+    // Roots, folder and file names of build trees.
+    const wchar_t* const    BUILD_ROOTS[]           = {
+        L"C:\\src\\",
+        L"D:\\dev\\",
+        L"C:\\Users\\clechasseur\\source\\repos\\",
+    };
+    const wchar_t* const    BUILD_FOLDERS[]         = {
+        L"src",
+        L"build",
+        L"obj",
+        L"x64",
+        L"Release",
+        L"Debug",
+        L"intermediate",
+        L"CMakeFiles",
+        L"node_modules",
+        L"@babel",
+        L"lib",
+        L"include",
+        L"generated",
+        L"packages",
+        L"net472",
+        L"bin",
+        L"tests",
+        L"PathCopyCopy.dir",
+    };
+    const wchar_t* const    BUILD_FILES[]           = {
+        L"main.cpp",
+        L"stdafx.h",
+        L"PathCopyCopy.pdb",
+        L"index.js",
+        L"package.json",
+        L"CMakeCache.txt",
+        L"Program.cs",
+        L"module.obj",
+        L"libcore.a",
+        L"Makefile",
+        L"PathCopyCopy.tlog",
+    };
+
+    // Roots and folder names of long paths.
+    const wchar_t* const    LONG_ROOTS[]            = {
+        L"C:\\",
+        L"\\\\server\\share\\",
+        L"\\\\?\\C:\\",
+    };
+    const wchar_t* const    LONG_FOLDERS[]          = {
+        L"A folder name that is long enough to push some generated paths past MAX_PATH",
+        L"Archived projects from the previous fiscal year",
+        L"Subfolder",
+        L"Copy of Copy of Final version (2)",
+        L"node_modules",
+    };
+
+    // Folder and file names in various scripts, including right-to-left ones
+    // and names using combining characters or surrogate pairs.
+    const wchar_t* const    INTERNATIONAL_FOLDERS[] = {
+        L"R\u00e9sum\u00e9s & lettres",
+        L"Re\u0301sume\u0301s (d\u00e9compos\u00e9)",
+        L"\u65e5\u672c\u8a9e\u306e\u30d5\u30a9\u30eb\u30c0",
+        L"\u0420\u0430\u0431\u043e\u0447\u0438\u0439 \u0441\u0442\u043e\u043b",
+        L"\u05de\u05e1\u05de\u05db\u05d9\u05dd",
+        L"\u0627\u0644\u0645\u0633\u062a\u0646\u062f\u0627\u062a",
+        L"Project \u05e4\u05e8\u05d5\u05d9\u05e7\u05d8 2019",
+        L"\u0388\u03b3\u03b3\u03c1\u03b1\u03c6\u03b1",
+        L"\ubb38\uc11c",
+        L"Emoji \xD83D\xDCC1 folder",
+    };
+    const wchar_t* const    INTERNATIONAL_FILES[]   = {
+        L"Rapport trimestriel \u00e9t\u00e9.docx",
+        L"\u5199\u771f.jpeg",
+        L"\u05d3\u05d5\u05d7.pdf",
+        L"\u062a\u0642\u0631\u064a\u0631.txt",
+        L"\u041e\u0442\u0447\u0451\u0442.xlsx",
+        L"\xD83D\xDE00.png",
+    };
+
+    // Folder and file names with characters that need special care when quoted,
+    // encoded or passed on a command line, like those in the Testing folder.
+    const wchar_t* const    SPECIAL_FOLDERS[]       = {
+        L"Folder with spaces in its name",
+        L"Folder with a .txt in its name",
+        L"R&D",
+        L"100% #done",
+        L"Budget (2019) [final]",
+        L"It's here",
+        L"semi;colon, comma",
+        L"caret^and~tilde",
+        L"a  double  space",
+        L"%USERPROFILE%",
+    };
+    const wchar_t* const    SPECIAL_FILES[]         = {
+        L"File with an ampersand (&) in its name.txt",
+        L"File with a \u00b3 in its name.txt",
+        L"File with nothing special in its name.txt",
+        L"Test.test a test",
+        L"50% off!.pdf",
+        L"=equals+plus.csv",
+        L"file with no extension",
+    };
+
+    // Roots of paths on mapped drives and network shares.
+    const wchar_t* const    NETWORK_ROOTS[]         = {
+        L"Z:\\",
+        L"M:\\",
+        L"\\\\server\\share\\",
+        L"\\\\fileserver.corp.example.com\\Departments\\",
+        L"\\\\server\\c$\\",
+        L"\\\\nas01\\home$\\clechasseur\\",
+        L"\\\\?\\UNC\\server\\share\\",
+    };
+
+    // Folder and extensions of files in the flat folder.
+    const wchar_t* const    FLAT_FOLDER             = L"C:\\Users\\clechasseur\\Pictures\\Camera Roll\\";
+    const wchar_t* const    FLAT_EXTENSIONS[]       = {
+        L".jpg",
+        L".png",
+        L".heic",
+        L".mp4",
+    };
+
+    //
+    // Picks a random element in a static array.
+    //
+    // @param p_Array Array to pick from.
+    // @param p_rGenerator Random number generator to use.
+    // @return Picked element.
+    //
+    template<typename T, size_t N, typename Generator>
+    const T& Pick(const T (&p_Array)[N],
+                  Generator& p_rGenerator)
+    {
+        return p_Array[std::uniform_int_distribution<size_t>(0, N - 1)(p_rGenerator)];
+    }
+
+    //
+    // Appends random folders to a path.
+    //
+    // @param p_rPath Path to append to.
+    // @param p_Folders Array of folder names to pick from.
+    // @param p_MinDepth Minimum number of folders to append.
+    // @param p_MaxDepth Maximum number of folders to append.
+    // @param p_rGenerator Random number generator to use.
+    //
+    template<size_t N, typename Generator>
+    void AppendFolders(std::wstring& p_rPath,
+                       const wchar_t* const (&p_Folders)[N],
+                       const size_t p_MinDepth,
+                       const size_t p_MaxDepth,
+                       Generator& p_rGenerator)
+    {
+        const size_t depth = std::uniform_int_distribution<size_t>(p_MinDepth, p_MaxDepth)(p_rGenerator);
+        for (size_t d = 0; d < depth; ++d) {
+            p_rPath += Pick(p_Folders, p_rGenerator);
+            p_rPath += L'\\';
+        }
+    }
+
+} // anonymous namespace
+
+namespace PCC
+{
+    //
+    // Returns the kind of corpus with the given name.
+    //
+    // @param p_pName Name of corpus kind, like "BuildTree". Case-insensitive.
+    // @param p_rKind Where to store the corpus kind.
+    // @return true if name was recognized.
+    //
+    bool PathCorpus::KindFromName(const wchar_t* const p_pName,
+                                  Kind& p_rKind)
+    {
+        bool found = false;
+        for (size_t i = 0; !found && p_pName != nullptr && i < ARRAYSIZE(KIND_NAMES); ++i) {
+            found = _wcsicmp(p_pName, KIND_NAMES[i]) == 0;
+            if (found) {
+                p_rKind = static_cast<Kind>(i);
+            }
+        }
+        return found;
+    }
+
+    //
+    // Generates a corpus of paths. A given kind and size always produce
+    // the same paths, and smaller corpora are prefixes of larger ones.
+    //
+    // @param p_Kind Kind of corpus to generate.
+    // @param p_Size Number of paths to generate.
+    // @return Generated paths.
+    //
+    FilesV PathCorpus::Generate(const Kind p_Kind,
+                                const ULONG p_Size)
+    {
+        Generator generator(CORPUS_SEED + static_cast<unsigned int>(p_Kind));
+        std::discrete_distribution<int> mixedDistribution(std::begin(MIXED_KIND_WEIGHTS), std::end(MIXED_KIND_WEIGHTS));
+
+        FilesV vFiles;
+        vFiles.reserve(p_Size);
+        for (ULONG i = 0; i < p_Size; ++i) {
+            const Kind kind = p_Kind == Kind::Mixed
+                ? static_cast<Kind>(static_cast<int>(Kind::BuildTree) + mixedDistribution(generator))
+                : p_Kind;
+            vFiles.push_back(GeneratePath(kind, i, generator));
+        }
+        return vFiles;
+    }
+
+    //
+    // Generates one path of a corpus.
+    //
+    // @param p_Kind Kind of path to generate. Cannot be Kind::Mixed.
+    // @param p_Index Index of path in the corpus.
+    // @param p_rGenerator Random number generator to use.
+    // @return Generated path.
+    //
+    std::wstring PathCorpus::GeneratePath(const Kind p_Kind,
+                                          const ULONG p_Index,
+                                          Generator& p_rGenerator)
+    {
+        std::wstring path;
+        switch (p_Kind) {
+            case Kind::BuildTree: {
+                path = Pick(BUILD_ROOTS, p_rGenerator);
+                AppendFolders(path, BUILD_FOLDERS, 4, 16, p_rGenerator);
+                path += Pick(BUILD_FILES, p_rGenerator);
+                break;
+            }
+            case Kind::LongPaths: {
+                // Go past MAX_PATH by a random margin, up to a few hundred characters.
+                path = Pick(LONG_ROOTS, p_rGenerator);
+                const size_t minLength = MAX_PATH + std::uniform_int_distribution<size_t>(0, 500)(p_rGenerator);
+                while (path.size() < minLength) {
+                    path += Pick(LONG_FOLDERS, p_rGenerator);
+                    path += L'\\';
+                }
+                path += Pick(COMMON_FILES, p_rGenerator);
+                break;
+            }
+            case Kind::International: {
+                path = L"C:\\Users\\";
+                AppendFolders(path, INTERNATIONAL_FOLDERS, 1, 6, p_rGenerator);
+                path += Pick(INTERNATIONAL_FILES, p_rGenerator);
+                break;
+            }
+            case Kind::SpecialChars: {
+                path = L"C:\\";
+                AppendFolders(path, SPECIAL_FOLDERS, 1, 6, p_rGenerator);
+                path += Pick(SPECIAL_FILES, p_rGenerator);
+                break;
+            }
+            case Kind::NetworkRoots: {
+                path = Pick(NETWORK_ROOTS, p_rGenerator);
+                AppendFolders(path, COMMON_FOLDERS, 0, 6, p_rGenerator);
+                path += Pick(COMMON_FILES, p_rGenerator);
+                break;
+            }
+            case Kind::FlatFolder: {
+                std::wstringstream wss;
+                wss << FLAT_FOLDER << L"IMG_" << std::setw(6) << std::setfill(L'0') << p_Index
+                    << Pick(FLAT_EXTENSIONS, p_rGenerator);
+                path = wss.str();
+                break;
+            }
+            default: {
+                path = L"C:\\";
+                AppendFolders(path, COMMON_FOLDERS, 0, 12, p_rGenerator);
+                path += Pick(COMMON_FILES, p_rGenerator);
+                break;
+            }
+        }
+        return path;
+    }
+
+} // namespace PCC
+
+#endif // PCC_BENCHMARKS
@@ -0,0 +1,374 @@
+// PathResultCache.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+
+#include <stdafx.h>
+#include <PathResultCache.h>
+#include <Plugin.h>
+#include <PluginUtils.h>
+#include <SettingsSnapshot.h>
+
+#include <string.h>
+#include <wchar.h>
+
+
+namespace
+{
+    // Prefix of the names of the shared memory section storing the cache and
+    // of the mutex protecting it. Both are created in the session namespace
+    // and are per-user.
+    const wchar_t* const    SHARED_CACHE_NAME_PREFIX    = L"Local\\PathCopyCopy.PathResultCache.";
+    const wchar_t* const    SHARED_CACHE_MUTEX_SUFFIX   = L".Lock";
+
+    // Number of entries in the cache.
+    const size_t            ENTRY_COUNT                 = 128;
+
+    // Maximum number of characters stored in an entry, for input and output paths combined.
+    // Longer paths are not cached.
+    const size_t            MAX_ENTRY_CHARS             = 1000;
+
+    // Time to wait for exclusive access to the cache, in milliseconds. If another
+    // process holds it longer than that, we simply do without the cache.
+    const DWORD             LOCK_TIMEOUT_MS             = 50;
+
+} // anonymous namespace
+
+namespace PCC
+{
+    //
+    // Single entry of the shared cache. The input path is stored first
+    // in m_Chars, followed by the output path (without terminating nulls).
+    //
+    struct PathResultCache::SharedCacheEntry {
+        GUID            m_PluginId;                 // ID of plugin that converted the path.
+        ULONGLONG       m_Generation;               // Settings generation when path was converted.
+        DWORD           m_FileHash;                 // Hash of input path; see HashFile.
+        DWORD           m_LastUsed;                 // Value of cache clock when entry was last used; 0 if entry is free.
+        DWORD           m_Timestamp;                // Tick count when entry was stored.
+        DWORD           m_TimeToLive;               // Time during which entry is valid, in milliseconds.
+        DWORD           m_FileSize;                 // Size of input path, in characters.
+        DWORD           m_PathSize;                 // Size of output path, in characters.
+        wchar_t         m_Chars[MAX_ENTRY_CHARS];   // Input and output paths.
+    };
+
+    //
+    // Content of the shared memory section storing the cache.
+    //
+    struct PathResultCache::SharedCacheHeader {
+        DWORD           m_Clock;                    // Incremented every time an entry is used.
+        SharedCacheEntry
+                        m_Entries[ENTRY_COUNT];     // Cache entries.
+    };
+
+    // Static members of PathResultCache
+    ATL::CHandle    PathResultCache::s_hMapping;
+    ATL::CHandle    PathResultCache::s_hMutex;
+    void*           PathResultCache::s_pView        = nullptr;
+    bool            PathResultCache::s_Opened       = false;
+    bool            PathResultCache::s_Suspended    = false;
+    MeasuredMutex   PathResultCache::s_Lock(L"PathResultCache::s_Lock");
+
+    //
+    // Determines if paths converted by a plugin can be looked up in the cache
+    // and, if so, returns the settings generation to use as part of the key.
+    // Paths are not cached if the plugin doesn't support it, if user disabled
+    // it in the settings or if there are too many files to convert at once
+    // (they would simply push all other entries out of the cache).
+    //
+    // @param p_Plugin Plugin used to convert paths.
+    // @param p_Context Context of the conversion.
+    // @param p_NumFiles Number of files to convert.
+    // @return Settings generation to use, or 0 if paths must not be cached.
+    //
+    ULONGLONG PathResultCache::GetGeneration(const Plugin& p_Plugin,
+                                             const ConversionContext& p_Context,
+                                             const size_t p_NumFiles)
+    {
+        {
+            std::lock_guard<MeasuredMutex> lock(s_Lock);
+            if (s_Suspended) {
+                return 0;
+            }
+        }
+        const SettingsSnapshot* const pSettings = p_Context.GetSettingsSnapshot();
+        if (p_NumFiles == 0 || p_NumFiles > ENTRY_COUNT || p_Plugin.PathCacheTimeToLive(p_Context) == 0 ||
+            pSettings == nullptr || !pSettings->GetCacheConvertedPaths()) {
+
+            return 0;
+        }
+        return pSettings->GetGeneration();
+    }
+
+    //
+    // Looks for cached paths of the given files.
+    //
+    // @param p_PluginId ID of plugin used to convert paths.
+    // @param p_Generation Settings generation returned by GetGeneration.
+    // @param p_vFiles Files to look for.
+    // @param p_rvPaths Upon return, will contain the cached paths of files
+    //                  found in the cache, in the same order as p_vFiles.
+    // @param p_rvFound Upon return, will indicate which files were found.
+    //
+    void PathResultCache::Lookup(const GUID& p_PluginId,
+                                 const ULONGLONG p_Generation,
+                                 const FilesV& p_vFiles,
+                                 WStringV& p_rvPaths,
+                                 std::vector<bool>& p_rvFound)
+    {
+        p_rvPaths.assign(p_vFiles.size(), std::wstring());
+        p_rvFound.assign(p_vFiles.size(), false);
+
+        StSharedCacheLock lock;
+        SharedCacheHeader* const pHeader = lock.GetHeader();
+        if (pHeader != nullptr) {
+            const DWORD now = ::GetTickCount();
+            for (size_t i = 0; i < p_vFiles.size(); ++i) {
+                SharedCacheEntry* const pEntry = FindEntry(pHeader, p_PluginId, p_Generation,
+                                                           p_vFiles[i], HashFile(p_vFiles[i]));
+                if (pEntry != nullptr) {
+                    if (now - pEntry->m_Timestamp < pEntry->m_TimeToLive) {
+                        p_rvPaths[i].assign(pEntry->m_Chars + pEntry->m_FileSize, pEntry->m_PathSize);
+                        p_rvFound[i] = true;
+                        if (++pHeader->m_Clock == 0) {
+                            ++pHeader->m_Clock;
+                        }
+                        pEntry->m_LastUsed = pHeader->m_Clock;
+                    } else {
+                        // Expired, free entry.
+                        pEntry->m_LastUsed = 0;
+                    }
+                }
+            }
+        }
+    }
+
+    //
+    // Stores converted paths in the cache. Paths too long to fit in an
+    // entry are skipped.
+    //
+    // @param p_PluginId ID of plugin used to convert paths.
+    // @param p_Generation Settings generation returned by GetGeneration.
+    // @param p_TimeToLive Time during which paths are valid, in milliseconds.
+    // @param p_vFiles Input files.
+    // @param p_vPaths Paths of files, in the same order as p_vFiles.
+    //
+    void PathResultCache::Store(const GUID& p_PluginId,
+                                const ULONGLONG p_Generation,
+                                const DWORD p_TimeToLive,
+                                const FilesV& p_vFiles,
+                                const WStringV& p_vPaths)
+    {
+        StSharedCacheLock lock;
+        SharedCacheHeader* const pHeader = lock.GetHeader();
+        if (pHeader != nullptr && p_vFiles.size() == p_vPaths.size()) {
+            const DWORD now = ::GetTickCount();
+            for (size_t i = 0; i < p_vFiles.size(); ++i) {
+                const std::wstring& file = p_vFiles[i];
+                const std::wstring& path = p_vPaths[i];
+                if (file.size() + path.size() > MAX_ENTRY_CHARS) {
+                    continue;
+                }
+
+                // Reuse entry for this file if it exists, otherwise pick a free
+                // or expired entry, or replace the least recently used one.
+                const DWORD fileHash = HashFile(file);
+                SharedCacheEntry* pEntry = FindEntry(pHeader, p_PluginId, p_Generation, file, fileHash);
+                if (pEntry == nullptr) {
+                    for (SharedCacheEntry& rEntry : pHeader->m_Entries) {
+                        if (rEntry.m_LastUsed == 0 || now - rEntry.m_Timestamp >= rEntry.m_TimeToLive) {
+                            pEntry = &rEntry;
+                            break;
+                        }
+                        if (pEntry == nullptr || rEntry.m_LastUsed < pEntry->m_LastUsed) {
+                            pEntry = &rEntry;
+                        }
+                    }
+                }
+
+                pEntry->m_PluginId = p_PluginId;
+                pEntry->m_Generation = p_Generation;
+                pEntry->m_FileHash = fileHash;
+                pEntry->m_Timestamp = now;
+                pEntry->m_TimeToLive = p_TimeToLive;
+                pEntry->m_FileSize = static_cast<DWORD>(file.size());
+                pEntry->m_PathSize = static_cast<DWORD>(path.size());
+                ::wmemcpy(pEntry->m_Chars, file.c_str(), file.size());
+                ::wmemcpy(pEntry->m_Chars + file.size(), path.c_str(), path.size());
+                if (++pHeader->m_Clock == 0) {
+                    ++pHeader->m_Clock;
+                }
+                pEntry->m_LastUsed = pHeader->m_Clock;
+            }
+        }
+    }
+
+    //
+    // Flushes all cached paths, for all our processes. Called when the
+    // network environment changes, since paths might not be valid anymore.
+    //
+    void PathResultCache::Flush()
+    {
+        StSharedCacheLock lock;
+        SharedCacheHeader* const pHeader = lock.GetHeader();
+        if (pHeader != nullptr) {
+            for (SharedCacheEntry& rEntry : pHeader->m_Entries) {
+                rEntry.m_LastUsed = 0;
+            }
+        }
+    }
+
+    //
+    // Suspends or resumes use of the cache in this process. The cache is
+    // suspended while a simulated network environment is used, since its
+    // paths must not be shared with other processes (see NetworkEnvironment).
+    //
+    // @param p_Suspended Whether to suspend use of the cache.
+    //
+    void PathResultCache::SetSuspended(const bool p_Suspended)
+    {
+        std::lock_guard<MeasuredMutex> lock(s_Lock);
+        s_Suspended = p_Suspended;
+    }
+
+    //
+    // Returns the content of the shared memory section storing the cache,
+    // opening it if it hasn't been attempted yet.
+    //
+    // @param p_rhMutex Upon success, will contain handle to mutex protecting the cache.
+    // @return Pointer to shared cache, or nullptr if it is not available.
+    //
+    PathResultCache::SharedCacheHeader* PathResultCache::OpenSharedCache(HANDLE& p_rhMutex)
+    {
+        std::lock_guard<MeasuredMutex> lock(s_Lock);
+        if (!s_Opened) {
+            const std::wstring userSid = PluginUtils::GetCurrentUserSid();
+            if (!userSid.empty()) {
+                std::wstring sectionName = SHARED_CACHE_NAME_PREFIX;
+                sectionName += userSid;
+                std::wstring mutexName = sectionName;
+                mutexName += SHARED_CACHE_MUTEX_SUFFIX;
+                s_hMutex.Attach(::CreateMutexW(nullptr, FALSE, mutexName.c_str()));
+                s_hMapping.Attach(::CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                                       0, sizeof(SharedCacheHeader), sectionName.c_str()));
+                if (s_hMutex != NULL && s_hMapping != NULL) {
+                    s_pView = ::MapViewOfFile(s_hMapping, FILE_MAP_READ | FILE_MAP_WRITE,
+                                              0, 0, sizeof(SharedCacheHeader));
+                }
+            }
+            s_Opened = true;
+        }
+        if (s_pView == nullptr || s_Suspended) {
+            return nullptr;
+        }
+        p_rhMutex = s_hMutex;
+        return static_cast<SharedCacheHeader*>(s_pView);
+    }
+
+    //
+    // Looks for the cache entry storing the path of a file.
+    //
+    // @param p_pHeader Shared cache. Must be locked.
+    // @param p_PluginId ID of plugin used to convert paths.
+    // @param p_Generation Settings generation.
+    // @param p_File File to look for.
+    // @param p_FileHash Hash of p_File; see HashFile.
+    // @return Pointer to entry, or nullptr if file is not found.
+    //
+    PathResultCache::SharedCacheEntry* PathResultCache::FindEntry(SharedCacheHeader* const p_pHeader,
+                                                                  const GUID& p_PluginId,
+                                                                  const ULONGLONG p_Generation,
+                                                                  const std::wstring& p_File,
+                                                                  const DWORD p_FileHash)
+    {
+        for (SharedCacheEntry& rEntry : p_pHeader->m_Entries) {
+            if (rEntry.m_LastUsed != 0 && rEntry.m_FileHash == p_FileHash &&
+                rEntry.m_Generation == p_Generation && rEntry.m_FileSize == p_File.size() &&
+                rEntry.m_FileSize + rEntry.m_PathSize <= MAX_ENTRY_CHARS &&
+                ::IsEqualGUID(rEntry.m_PluginId, p_PluginId) &&
+                ::wmemcmp(rEntry.m_Chars, p_File.c_str(), p_File.size()) == 0) {
+
+                return &rEntry;
+            }
+        }
+        return nullptr;
+    }
+
+    //
+    // Computes a hash of a file path, used to quickly skip cache
+    // entries that do not match when looking for a file.
+    //
+    // @param p_File File path.
+    // @return Hash of p_File (FNV-1a).
+    //
+    DWORD PathResultCache::HashFile(const std::wstring& p_File)
+    {
+        DWORD hash = 2166136261ul;
+        for (const wchar_t c : p_File) {
+            hash = (hash ^ static_cast<DWORD>(c)) * 16777619ul;
+        }
+        return hash;
+    }
+
+    //
+    // Constructor. Acquires exclusive access to the shared cache. If the
+    // previous owner of the cache died while holding it, the cache could be
+    // inconsistent and is thus cleared.
+    //
+    PathResultCache::StSharedCacheLock::StSharedCacheLock()
+        : m_pHeader(nullptr),
+          m_hMutex(NULL)
+    {
+        HANDLE hMutex = NULL;
+        SharedCacheHeader* const pHeader = OpenSharedCache(hMutex);
+        if (pHeader != nullptr) {
+            const DWORD res = ::WaitForSingleObject(hMutex, LOCK_TIMEOUT_MS);
+            if (res == WAIT_OBJECT_0 || res == WAIT_ABANDONED) {
+                if (res == WAIT_ABANDONED) {
+                    ::memset(pHeader, 0, sizeof(SharedCacheHeader));
+                }
+                m_pHeader = pHeader;
+                m_hMutex = hMutex;
+            }
+        }
+    }
+
+    //
+    // Destructor. Releases access to the shared cache.
+    //
+    PathResultCache::StSharedCacheLock::~StSharedCacheLock()
+    {
+        if (m_hMutex != NULL) {
+            ::ReleaseMutex(m_hMutex);
+        }
+    }
+
+    //
+    // Returns the shared cache, if it was acquired.
+    //
+    // @return Pointer to shared cache, or nullptr if it is not available.
+    //
+    PathResultCache::SharedCacheHeader* PathResultCache::StSharedCacheLock::GetHeader() const
+    {
+        return m_pHeader;
+    }
+
+} // namespace PCC
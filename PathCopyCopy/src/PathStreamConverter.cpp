@@ -0,0 +1,231 @@
+// PathStreamConverter.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <stdafx.h>
+#include <PathStreamConverter.h>
+#include <PluginUtils.h>
+
+#include <algorithm>
+
+
+namespace
+{
+    // Size of chunks read from the input, in bytes.
+    const DWORD     READ_CHUNK_SIZE     = 64 * 1024;
+
+    // Number of paths converted at once. Large enough to be converted
+    // in parallel, small enough to start writing results early.
+    const size_t    BATCH_SIZE          = 4096;
+
+} // anonymous namespace
+
+namespace PCC
+{
+    //
+    // Constructor.
+    //
+    // @param p_Plugin Plugin to use to convert paths.
+    // @param p_Context Context to use to convert paths.
+    // @param p_hOutput Handle of file, pipe or console where to write converted paths.
+    // @param p_Separator Separator to write after each converted path.
+    //
+    PathStreamConverter::PathStreamConverter(const Plugin& p_Plugin,
+                                             const ConversionContext& p_Context,
+                                             HANDLE const p_hOutput,
+                                             const std::wstring& p_Separator)
+        : m_rPlugin(p_Plugin),
+          m_rContext(p_Context),
+          m_hOutput(p_hOutput),
+          m_Separator(p_Separator),
+          m_ConsoleOutput(false),
+          m_vBatch(),
+          m_ConvertedCount(0)
+    {
+        DWORD consoleMode = 0;
+        m_ConsoleOutput = ::GetConsoleMode(p_hOutput, &consoleMode) != FALSE;
+        m_vBatch.reserve(BATCH_SIZE);
+    }
+
+    //
+    // Reads all paths from the input and converts them, writing results
+    // to the output along the way.
+    //
+    // @param p_hInput Handle of file or pipe to read paths from.
+    // @return true if all paths were converted and written.
+    //
+    bool PathStreamConverter::Convert(HANDLE const p_hInput)
+    {
+        std::vector<char> vData;
+        size_t lineStart = 0;
+        bool encodingKnown = false;
+        bool utf16 = false;
+        bool endOfInput = false;
+        while (!endOfInput) {
+            // Read next chunk, keeping the incomplete line from the previous one.
+            vData.erase(vData.begin(), vData.begin() + lineStart);
+            const size_t oldSize = vData.size();
+            vData.resize(oldSize + READ_CHUNK_SIZE);
+            DWORD read = 0;
+            if (!::ReadFile(p_hInput, &vData[oldSize], READ_CHUNK_SIZE, &read, nullptr)) {
+                // Broken pipes simply mean we've read everything.
+                read = 0;
+            }
+            vData.resize(oldSize + read);
+            endOfInput = read == 0;
+            lineStart = 0;
+
+            // Check for a BOM once we've read enough of the input.
+            if (!encodingKnown && (vData.size() >= 3 || endOfInput)) {
+                encodingKnown = true;
+                if (vData.size() >= 2 && static_cast<BYTE>(vData[0]) == 0xFF && static_cast<BYTE>(vData[1]) == 0xFE) {
+                    utf16 = true;
+                    lineStart = 2;
+                } else if (vData.size() >= 3 && static_cast<BYTE>(vData[0]) == 0xEF &&
+                           static_cast<BYTE>(vData[1]) == 0xBB && static_cast<BYTE>(vData[2]) == 0xBF) {
+                    lineStart = 3;
+                }
+            }
+            if (!encodingKnown) {
+                continue;
+            }
+
+            // Extract all complete lines. Newlines can't appear inside
+            // multi-byte characters, so we can look for them directly.
+            const size_t charSize = utf16 ? sizeof(wchar_t) : sizeof(char);
+            std::wstring line;
+            for (size_t i = lineStart; i + charSize <= vData.size(); i += charSize) {
+                const bool newline = utf16 ? *reinterpret_cast<const wchar_t*>(&vData[i]) == L'\n' : vData[i] == '\n';
+                const bool lastLine = endOfInput && i + 2 * charSize > vData.size();
+                if (newline || lastLine) {
+                    const size_t lineEnd = newline ? i : i + charSize;
+                    if (utf16) {
+                        AddLine(reinterpret_cast<const wchar_t*>(&vData[lineStart]), (lineEnd - lineStart) / charSize);
+                    } else if (lineEnd > lineStart) {
+                        const int lineSize = static_cast<int>(lineEnd - lineStart);
+                        const int textSize = ::MultiByteToWideChar(CP_UTF8, 0, &vData[lineStart], lineSize, nullptr, 0);
+                        if (textSize > 0) {
+                            line.resize(static_cast<size_t>(textSize));
+                            ::MultiByteToWideChar(CP_UTF8, 0, &vData[lineStart], lineSize, &*line.begin(), textSize);
+                            AddLine(line.c_str(), line.size());
+                        }
+                    }
+                    lineStart = i + charSize;
+                    if (m_vBatch.size() >= BATCH_SIZE && !ConvertBatch()) {
+                        return false;
+                    }
+                }
+            }
+        }
+
+        return ConvertBatch();
+    }
+
+    //
+    // Returns the number of paths converted so far.
+    //
+    // @return Number of converted paths.
+    //
+    size_t PathStreamConverter::GetConvertedCount() const
+    {
+        return m_ConvertedCount;
+    }
+
+    //
+    // Adds a line read from the input to the batch of paths to convert.
+    // Trailing carriage returns are removed and empty lines are ignored.
+    //
+    // @param p_pLine Pointer to beginning of line.
+    // @param p_Length Length of line, in characters.
+    //
+    void PathStreamConverter::AddLine(const wchar_t* const p_pLine,
+                                      size_t p_Length)
+    {
+        if (p_Length != 0 && p_pLine[p_Length - 1] == L'\r') {
+            --p_Length;
+        }
+        if (p_Length != 0) {
+            m_vBatch.emplace_back(p_pLine, p_Length);
+        }
+    }
+
+    //
+    // Converts the paths in the current batch and writes the results.
+    //
+    // @return true if results were written.
+    //
+    bool PathStreamConverter::ConvertBatch()
+    {
+        if (m_vBatch.empty()) {
+            return true;
+        }
+
+        const WStringV vPaths = PluginUtils::GetPathsInParallel(m_rPlugin, m_vBatch, m_rContext);
+        std::wstring::size_type size = 0;
+        for (const std::wstring& path : vPaths) {
+            size += path.size() + m_Separator.size();
+        }
+        std::wstring text;
+        text.reserve(size);
+        for (const std::wstring& path : vPaths) {
+            text += path;
+            text += m_Separator;
+        }
+
+        m_ConvertedCount += m_vBatch.size();
+        m_vBatch.clear();
+        return Write(text);
+    }
+
+    //
+    // Writes text to the output.
+    //
+    // @param p_Text Text to write.
+    // @return true if text was written.
+    //
+    bool PathStreamConverter::Write(const std::wstring& p_Text) const
+    {
+        if (p_Text.empty()) {
+            return true;
+        }
+
+        // Consoles need wide text to display it properly; everything else gets UTF-8.
+        DWORD written = 0;
+        if (m_ConsoleOutput) {
+            return ::WriteConsoleW(m_hOutput, p_Text.c_str(), static_cast<DWORD>(p_Text.size()), &written, nullptr) != FALSE;
+        }
+        const int textSize = static_cast<int>(p_Text.size());
+        const int dataSize = ::WideCharToMultiByte(CP_UTF8, 0, p_Text.c_str(), textSize, nullptr, 0, nullptr, nullptr);
+        if (dataSize <= 0) {
+            return false;
+        }
+        std::vector<char> vData(static_cast<size_t>(dataSize));
+        ::WideCharToMultiByte(CP_UTF8, 0, p_Text.c_str(), textSize, vData.data(), dataSize, nullptr, nullptr);
+        for (size_t offset = 0; offset < vData.size(); offset += written) {
+            written = 0;
+            if (!::WriteFile(m_hOutput, &vData[offset], static_cast<DWORD>(vData.size() - offset), &written, nullptr) || written == 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+} // namespace PCC
@@ -0,0 +1,325 @@
+// PerformanceCounters.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <stdafx.h>
+#include <PerformanceCounters.h>
+
+#include <algorithm>
+#include <climits>
+#include <cwchar>
+
+#include <winperf.h>
+
+
+namespace
+{
+    // {BB9700D1-2B24-4426-9741-DED9379AEE15}
+    const GUID  PROVIDER_ID     = { 0xbb9700d1, 0x2b24, 0x4426, { 0x97, 0x41, 0xde, 0xd9, 0x37, 0x9a, 0xee, 0x15 } };
+
+    // {435B7061-CD58-4F41-B888-0F85EC20A477}
+    const GUID  COUNTERSET_ID   = { 0x435b7061, 0xcd58, 0x4f41, { 0xb8, 0x88, 0x0f, 0x85, 0xec, 0x20, 0xa4, 0x77 } };
+
+    const ULONG INSTANCE_TYPE_MULTIPLE_AGGREGATE    = 6;    // Counter set has multiple instances aggregated by PDH (PERF_COUNTERSET_MULTI_AGGREGATE).
+    const ULONGLONG ATTRIB_NO_DISPLAYABLE           = 2;    // Counter is not displayed (PERF_ATTRIB_NO_DISPLAYABLE).
+
+    // IDs of our counters. Must match those in PathCopyCopyCounters.man.
+    enum CounterId : ULONG {
+        MENU_BUILDS = 1,
+        MENU_BUILD_TIME_P95,
+        CONVERSIONS,
+        PLUGINS_SNAPSHOT_HITS,
+        PLUGINS_SNAPSHOT_LOOKUPS,
+        SHARE_INDEX_HITS,
+        SHARE_INDEX_LOOKUPS,
+        FQDN_HITS,
+        FQDN_LOOKUPS,
+        PATH_RESULTS_HITS,
+        PATH_RESULTS_LOOKUPS,
+        COM_PLUGIN_FAILURES,
+        NUM_COUNTERS = COM_PLUGIN_FAILURES,
+    };
+
+    // Structures and signatures of PerfLib functions we load dynamically. They
+    // are declared here because perflib.h only declares them when targeting
+    // Windows Vista.
+    struct CounterSetInfo {
+        GUID        m_CounterSetGuid;
+        GUID        m_ProviderGuid;
+        ULONG       m_NumCounters;
+        ULONG       m_InstanceType;
+    };
+    struct CounterInfo {
+        ULONG       m_CounterId;
+        ULONG       m_Type;
+        ULONGLONG   m_Attrib;
+        ULONG       m_Size;
+        ULONG       m_DetailLevel;
+        LONG        m_Scale;
+        ULONG       m_Offset;
+    };
+    struct CounterSetInstance {
+        GUID        m_CounterSetGuid;
+        ULONG       m_Size;
+        ULONG       m_InstanceId;
+        ULONG       m_InstanceNameOffset;
+        ULONG       m_InstanceNameSize;
+    };
+    typedef ULONG (WINAPI *PerfLibRequestFunc)(ULONG, PVOID, ULONG);
+    typedef ULONG (WINAPI *PerfStartProviderFunc)(LPGUID, PerfLibRequestFunc, HANDLE*);
+    typedef ULONG (WINAPI *PerfStopProviderFunc)(HANDLE);
+    typedef ULONG (WINAPI *PerfSetCounterSetInfoFunc)(HANDLE, CounterSetInfo*, ULONG);
+    typedef CounterSetInstance* (WINAPI *PerfCreateInstanceFunc)(HANDLE, LPCGUID, PCWSTR, ULONG);
+    typedef ULONG (WINAPI *PerfDeleteInstanceFunc)(HANDLE, CounterSetInstance*);
+    typedef ULONG (WINAPI *PerfSetULongCounterValueFunc)(HANDLE, CounterSetInstance*, ULONG, ULONG);
+    typedef ULONG (WINAPI *PerfIncrementULongCounterValueFunc)(HANDLE, CounterSetInstance*, ULONG, ULONG);
+
+    // Template passed to PerfSetCounterSetInfo: counter set info followed by its counters.
+    struct CounterSetTemplate {
+        CounterSetInfo  m_Info;
+        CounterInfo     m_aCounters[NUM_COUNTERS];
+    };
+
+    HANDLE                              g_hProvider                         = NULL;     // Handle to our started provider.
+    CounterSetInstance*                 g_pInstance                         = nullptr;  // Instance of our counter set for this process.
+    PerfStopProviderFunc                g_pPerfStopProvider                 = nullptr;  // Pointer to PerfStopProvider, if available.
+    PerfDeleteInstanceFunc              g_pPerfDeleteInstance               = nullptr;  // Pointer to PerfDeleteInstance, if available.
+    PerfSetULongCounterValueFunc        g_pPerfSetULongCounterValue         = nullptr;  // Pointer to PerfSetULongCounterValue, if available.
+    PerfIncrementULongCounterValueFunc  g_pPerfIncrementULongCounterValue   = nullptr;  // Pointer to PerfIncrementULongCounterValue, if available.
+
+    //
+    // Fills the information of one of our counters in a counter set template.
+    //
+    // @param p_rTemplate Template to fill.
+    // @param p_Id ID of counter.
+    // @param p_Type Type of counter; one of the PERF_ counter types in winperf.h.
+    // @param p_Attrib Counter attributes.
+    //
+    void SetCounterInfo(CounterSetTemplate& p_rTemplate,
+                        const CounterId p_Id,
+                        const ULONG p_Type,
+                        const ULONGLONG p_Attrib = 0)
+    {
+        CounterInfo& rInfo = p_rTemplate.m_aCounters[p_Id - 1];
+        rInfo.m_CounterId = p_Id;
+        rInfo.m_Type = p_Type;
+        rInfo.m_Attrib = p_Attrib;
+        rInfo.m_Size = sizeof(ULONG);
+        rInfo.m_DetailLevel = PERF_DETAIL_NOVICE;
+        rInfo.m_Scale = 0;
+        rInfo.m_Offset = (p_Id - 1) * sizeof(ULONG);
+    }
+
+} // anonymous namespace
+
+namespace PCC
+{
+    // Static members of PerformanceCounters
+    std::once_flag  PerformanceCounters::s_StartFlag;
+    std::mutex      PerformanceCounters::s_DurationsLock;
+    ULONG           PerformanceCounters::s_Durations[PerformanceCounters::DURATION_SAMPLES] = { 0 };
+    size_t          PerformanceCounters::s_NextDuration = 0;
+    size_t          PerformanceCounters::s_NumDurations = 0;
+
+    //
+    // Stops our provider if it was started. Must be called before the DLL
+    // is unloaded.
+    //
+    void PerformanceCounters::Stop()
+    {
+        if (g_hProvider != NULL) {
+            if (g_pInstance != nullptr) {
+                g_pPerfDeleteInstance(g_hProvider, g_pInstance);
+                g_pInstance = nullptr;
+            }
+            g_pPerfStopProvider(g_hProvider);
+            g_hProvider = NULL;
+        }
+    }
+
+    //
+    // Records that a context menu has been built.
+    //
+    // @param p_Duration Time it took to build the menu.
+    //
+    void PerformanceCounters::MenuBuilt(const std::chrono::microseconds p_Duration)
+    {
+        if (Started()) {
+            g_pPerfIncrementULongCounterValue(g_hProvider, g_pInstance, MENU_BUILDS, 1);
+
+            // Compute the 95th percentile of recent durations. This is cheap
+            // compared to building a menu, so we do it every time instead
+            // of requiring a callback from PerfLib.
+            ULONG p95 = 0;
+            {
+                std::lock_guard<std::mutex> lock(s_DurationsLock);
+                s_Durations[s_NextDuration] = static_cast<ULONG>((std::min)(p_Duration.count(), static_cast<long long>(ULONG_MAX)));
+                s_NextDuration = (s_NextDuration + 1) % DURATION_SAMPLES;
+                s_NumDurations = (std::min)(s_NumDurations + 1, DURATION_SAMPLES);
+
+                ULONG durations[DURATION_SAMPLES];
+                std::copy(s_Durations, s_Durations + s_NumDurations, durations);
+                ULONG* pP95 = durations + (s_NumDurations * 95) / 100;
+                std::nth_element(durations, pP95, durations + s_NumDurations);
+                p95 = *pP95;
+            }
+            g_pPerfSetULongCounterValue(g_hProvider, g_pInstance, MENU_BUILD_TIME_P95, p95 / 1000);
+        }
+    }
+
+    //
+    // Records that paths have been converted by a plugin.
+    //
+    // @param p_Count Number of paths converted.
+    //
+    void PerformanceCounters::PathsConverted(const size_t p_Count)
+    {
+        if (p_Count != 0 && Started()) {
+            g_pPerfIncrementULongCounterValue(g_hProvider, g_pInstance, CONVERSIONS, static_cast<ULONG>(p_Count));
+        }
+    }
+
+    //
+    // Records a lookup in one of our caches.
+    //
+    // @param p_Cache Cache that was looked up.
+    // @param p_Hit Whether the cache contained what was looked up.
+    //
+    void PerformanceCounters::CacheLookup(const Cache p_Cache,
+                                          const bool p_Hit)
+    {
+        if (Started()) {
+            // Each hits counter is followed by its base counter.
+            ULONG hitsId = 0;
+            switch (p_Cache) {
+                case Cache::PluginsSnapshot:
+                    hitsId = PLUGINS_SNAPSHOT_HITS;
+                    break;
+                case Cache::ShareIndex:
+                    hitsId = SHARE_INDEX_HITS;
+                    break;
+                case Cache::FQDN:
+                    hitsId = FQDN_HITS;
+                    break;
+                case Cache::PathResults:
+                    hitsId = PATH_RESULTS_HITS;
+                    break;
+            }
+            if (hitsId != 0) {
+                if (p_Hit) {
+                    g_pPerfIncrementULongCounterValue(g_hProvider, g_pInstance, hitsId, 1);
+                }
+                g_pPerfIncrementULongCounterValue(g_hProvider, g_pInstance, hitsId + 1, 1);
+            }
+        }
+    }
+
+    //
+    // Records that a call to a COM plugin failed.
+    //
+    void PerformanceCounters::COMPluginFailed()
+    {
+        if (Started()) {
+            g_pPerfIncrementULongCounterValue(g_hProvider, g_pInstance, COM_PLUGIN_FAILURES, 1);
+        }
+    }
+
+    //
+    // Makes sure our provider has been started, if possible.
+    //
+    // @return true if counters can be updated.
+    //
+    bool PerformanceCounters::Started()
+    {
+        std::call_once(s_StartFlag, &PerformanceCounters::Start);
+        return g_pInstance != nullptr;
+    }
+
+    //
+    // Starts our provider and creates the instance of our counter set for
+    // this process. Called once by Started.
+    //
+    void PerformanceCounters::Start()
+    {
+        HMODULE hAdvapi32 = ::GetModuleHandleW(L"advapi32.dll");
+        if (hAdvapi32 != NULL) {
+            auto pPerfStartProvider = reinterpret_cast<PerfStartProviderFunc>(::GetProcAddress(hAdvapi32, "PerfStartProvider"));
+            auto pPerfStopProvider = reinterpret_cast<PerfStopProviderFunc>(::GetProcAddress(hAdvapi32, "PerfStopProvider"));
+            auto pPerfSetCounterSetInfo = reinterpret_cast<PerfSetCounterSetInfoFunc>(::GetProcAddress(hAdvapi32, "PerfSetCounterSetInfo"));
+            auto pPerfCreateInstance = reinterpret_cast<PerfCreateInstanceFunc>(::GetProcAddress(hAdvapi32, "PerfCreateInstance"));
+            auto pPerfDeleteInstance = reinterpret_cast<PerfDeleteInstanceFunc>(::GetProcAddress(hAdvapi32, "PerfDeleteInstance"));
+            auto pPerfSetULongCounterValue = reinterpret_cast<PerfSetULongCounterValueFunc>(::GetProcAddress(hAdvapi32, "PerfSetULongCounterValue"));
+            auto pPerfIncrementULongCounterValue = reinterpret_cast<PerfIncrementULongCounterValueFunc>(::GetProcAddress(hAdvapi32, "PerfIncrementULongCounterValue"));
+            if (pPerfStartProvider != nullptr && pPerfStopProvider != nullptr && pPerfSetCounterSetInfo != nullptr &&
+                pPerfCreateInstance != nullptr && pPerfDeleteInstance != nullptr &&
+                pPerfSetULongCounterValue != nullptr && pPerfIncrementULongCounterValue != nullptr) {
+
+                GUID providerId = PROVIDER_ID;
+                HANDLE hProvider = NULL;
+                if (pPerfStartProvider(&providerId, nullptr, &hProvider) == ERROR_SUCCESS) {
+                    CounterSetTemplate counterSetTemplate = { 0 };
+                    counterSetTemplate.m_Info.m_CounterSetGuid = COUNTERSET_ID;
+                    counterSetTemplate.m_Info.m_ProviderGuid = PROVIDER_ID;
+                    counterSetTemplate.m_Info.m_NumCounters = NUM_COUNTERS;
+                    counterSetTemplate.m_Info.m_InstanceType = INSTANCE_TYPE_MULTIPLE_AGGREGATE;
+                    SetCounterInfo(counterSetTemplate, MENU_BUILDS, PERF_COUNTER_COUNTER);
+                    SetCounterInfo(counterSetTemplate, MENU_BUILD_TIME_P95, PERF_COUNTER_RAWCOUNT);
+                    SetCounterInfo(counterSetTemplate, CONVERSIONS, PERF_COUNTER_COUNTER);
+                    SetCounterInfo(counterSetTemplate, PLUGINS_SNAPSHOT_HITS, PERF_SAMPLE_FRACTION);
+                    SetCounterInfo(counterSetTemplate, PLUGINS_SNAPSHOT_LOOKUPS, PERF_SAMPLE_BASE, ATTRIB_NO_DISPLAYABLE);
+                    SetCounterInfo(counterSetTemplate, SHARE_INDEX_HITS, PERF_SAMPLE_FRACTION);
+                    SetCounterInfo(counterSetTemplate, SHARE_INDEX_LOOKUPS, PERF_SAMPLE_BASE, ATTRIB_NO_DISPLAYABLE);
+                    SetCounterInfo(counterSetTemplate, FQDN_HITS, PERF_SAMPLE_FRACTION);
+                    SetCounterInfo(counterSetTemplate, FQDN_LOOKUPS, PERF_SAMPLE_BASE, ATTRIB_NO_DISPLAYABLE);
+                    SetCounterInfo(counterSetTemplate, PATH_RESULTS_HITS, PERF_SAMPLE_FRACTION);
+                    SetCounterInfo(counterSetTemplate, PATH_RESULTS_LOOKUPS, PERF_SAMPLE_BASE, ATTRIB_NO_DISPLAYABLE);
+                    SetCounterInfo(counterSetTemplate, COM_PLUGIN_FAILURES, PERF_COUNTER_COUNTER);
+
+                    // Name our instance after our host process so that Explorer can be told apart from other hosts.
+                    CounterSetInstance* pInstance = nullptr;
+                    if (pPerfSetCounterSetInfo(hProvider, &counterSetTemplate.m_Info, sizeof(counterSetTemplate)) == ERROR_SUCCESS) {
+                        wchar_t exePath[MAX_PATH + 1] = { 0 };
+                        ::GetModuleFileNameW(NULL, exePath, MAX_PATH);
+                        const wchar_t* pExeName = std::wcsrchr(exePath, L'\\');
+                        pExeName = pExeName != nullptr ? pExeName + 1 : exePath;
+                        const DWORD processId = ::GetCurrentProcessId();
+                        wchar_t instanceName[MAX_PATH + 16];
+                        if (std::swprintf(instanceName, sizeof(instanceName) / sizeof(wchar_t), L"%ls_%lu", pExeName, processId) > 0) {
+                            pInstance = pPerfCreateInstance(hProvider, &COUNTERSET_ID, instanceName, processId);
+                        }
+                    }
+
+                    if (pInstance != nullptr) {
+                        g_pPerfStopProvider = pPerfStopProvider;
+                        g_pPerfDeleteInstance = pPerfDeleteInstance;
+                        g_pPerfSetULongCounterValue = pPerfSetULongCounterValue;
+                        g_pPerfIncrementULongCounterValue = pPerfIncrementULongCounterValue;
+                        g_hProvider = hProvider;
+                        g_pInstance = pInstance;
+                    } else {
+                        pPerfStopProvider(hProvider);
+                    }
+                }
+            }
+        }
+    }
+
+} // namespace PCC
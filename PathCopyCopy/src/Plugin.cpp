@@ -23,6 +23,7 @@
 #include <Plugin.h>
 
 #include <CopyToClipboardPathAction.h>
+#include <PathResultCache.h>
 
 #include <assert.h>
 #include <string.h>
@@ -72,6 +73,18 @@ namespace PCC
         return false;
     }
 
+    //
+    // Returns the name of the nested submenu in which to display this plugin
+    // in the contextual menu. Nested submenus are only populated when opened.
+    // If not overridden, the plugin will be displayed directly in the submenu.
+    //
+    // @return Name of nested submenu, or an empty string if not in one.
+    //
+    std::wstring Plugin::MenuFolder() const
+    {
+        return L"";
+    }
+
     //
     // Returns whether the plugin should be enabled or not in the
     // contextual menu. If not overridden, it will always be enabled.
@@ -79,14 +92,36 @@ namespace PCC
     // @param p_ParentPath Path of the parent directory of files that
     //                     triggered the contextual menu.
     // @param p_File Path of one file that was selected.
+    // @param p_Context Context in which the plugin is used.
     // @return true if plugin should be enabled in contextual menu.
     //
     bool Plugin::Enabled(const std::wstring& /*p_ParentPath*/,
-                         const std::wstring& /*p_File*/) const
+                         const std::wstring& /*p_File*/,
+                         const ConversionContext& /*p_Context*/) const
     {
         return true;
     }
 
+    //
+    // Returns the paths of the given files, as determined by the plugin's
+    // own path scheme. The default implementation calls GetPath for each
+    // file; plugins that can share work between files should override this.
+    //
+    // @param p_vFiles Full paths to the files to get the paths for.
+    // @param p_Context Context of the conversion.
+    // @return Paths of the files according to plugin, in the same order.
+    //
+    WStringV Plugin::GetPaths(const FilesV& p_vFiles,
+                              const ConversionContext& p_Context) const
+    {
+        WStringV vPaths;
+        vPaths.reserve(p_vFiles.size());
+        for (const std::wstring& file : p_vFiles) {
+            vPaths.push_back(GetPath(file, p_Context));
+        }
+        return vPaths;
+    }
+
     //
     // Returns the separator to use between each path when using this plugin.
     // The default value is the empty string, which instructs PCC to use the
@@ -99,6 +134,18 @@ namespace PCC
         return L"";
     }
 
+    //
+    // Returns the format in which paths computed by this plugin should be
+    // exported along with the metadata of their files (see MetadataExporter).
+    // By default, paths are output as-is.
+    //
+    // @return Export format, or ExportFormat::None to output paths as-is.
+    //
+    ExportFormat Plugin::GetExportFormat() const
+    {
+        return ExportFormat::None;
+    }
+
     //
     // Returns the action to perform on the path or paths when using this plugin.
     // By default, this returns an action copying the path or paths to the clipboard.
@@ -135,35 +182,73 @@ namespace PCC
     }
 
     //
-    // Provides a pointer to the object that can be used to access PCC settings.
-    // Some plugins depend on this to work.
+    // Returns the class of cost of the work performed by this plugin to
+    // compute paths. This is used to decide whether the plugin can be used
+    // concurrently and whether its paths are cached (see CanGetPathsConcurrently
+    // and PathCacheTimeToLive), as well as how work is scheduled. The default
+    // implementation returns PluginCost::External, since we know nothing
+    // about the plugin; plugins should override this.
+    //
+    // @param p_Context Context in which the plugin is used.
+    // @return Plugin's cost class.
+    //
+    PluginCost Plugin::CostClass(const ConversionContext& /*p_Context*/) const
+    {
+        return PluginCost::External;
+    }
+
+    //
+    // Checks if Path Copy Copy can call GetPaths from multiple threads at
+    // once on this plugin, to convert large selections in parallel. The
+    // default implementation returns true unless the plugin calls external
+    // code (see CostClass), which might depend on thread-affine resources
+    // like COM objects.
+    //
+    // @param p_Context Context in which the plugin is used.
+    // @return true if GetPaths can be called concurrently.
+    //
+    bool Plugin::CanGetPathsConcurrently(const ConversionContext& p_Context) const
+    {
+        return CostClass(p_Context) != PluginCost::External;
+    }
+
+    //
+    // Returns for how long paths returned by this plugin can be cached and
+    // reused for the same files (see PathResultCache). Caching is only
+    // worthwhile for plugins that are expensive. The default implementation
+    // determines this from the plugin's cost class (see CostClass): paths
+    // that depend on the network are cached for a short time, and other
+    // paths are never cached. Paths computed by external code could depend
+    // on anything, so plugins calling such code must opt in themselves.
     //
-    // @param p_pSettings Pointer to settings object.
-    //                    Can be nullptr to remove an existing settings object.
+    // @param p_Context Context in which the plugin is used.
+    // @return Time during which paths can be cached, in milliseconds.
     //
-    void Plugin::SetSettings(const Settings* const p_pSettings)
+    DWORD Plugin::PathCacheTimeToLive(const ConversionContext& p_Context) const
     {
-        m_pSettings = p_pSettings;
+        switch (CostClass(p_Context)) {
+            case PluginCost::Network:
+                return PathResultCache::NETWORK_PATHS_TIME_TO_LIVE;
+            default:
+                return 0;
+        }
     }
 
     //
-    // Provides a pointer to an object that can be used to access other plugins.
-    // Some plugins depend on this to work.
+    // Adds the IDs of other plugins this plugin relies on to the given vector.
+    // This is used to load only the plugins needed when a single plugin is
+    // invoked. The default implementation does not add anything.
     //
-    // @param p_pPluginProvider Pointer to plugin provider.
-    //                          Can be nullptr to remove an existing provider.
+    // @param p_rvPluginIds Where to add referenced plugin IDs.
     //
-    void Plugin::SetPluginProvider(const PluginProvider* const p_pPluginProvider)
+    void Plugin::GetReferencedPlugins(GUIDV& /*p_rvPluginIds*/) const
     {
-        m_pPluginProvider = p_pPluginProvider;
     }
 
     //
     // Constructor.
     //
     Plugin::Plugin()
-        : m_pSettings(nullptr),
-          m_pPluginProvider(nullptr)
     {
     }
 
@@ -0,0 +1,215 @@
+// PluginDependencyGraph.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <stdafx.h>
+#include <PluginDependencyGraph.h>
+
+#include <algorithm>
+#include <utility>
+
+
+namespace PCC
+{
+    //
+    // Constructor. Resolves references between the given plugins and
+    // detects reference cycles.
+    //
+    // @param p_sspAllPlugins Set containing all plugins.
+    //
+    PluginDependencyGraph::PluginDependencyGraph(const PluginSPS& p_sspAllPlugins)
+        : m_mNodes(),
+          m_CacheLock()
+    {
+        // Create a node for every plugin.
+        for (const PluginSP& spPlugin : p_sspAllPlugins) {
+            if (!spPlugin->IsSeparator()) {
+                m_mNodes[spPlugin->Id()].m_spPlugin = spPlugin;
+            }
+        }
+
+        // Bind each node to the nodes of the plugins it references.
+        for (auto& nodePair : m_mNodes) {
+            Node& node = nodePair.second;
+            GUIDV vReferencedIds;
+            node.m_spPlugin->GetReferencedPlugins(vReferencedIds);
+            for (const GUID& referencedId : vReferencedIds) {
+                auto it = m_mNodes.find(referencedId);
+                if (it != m_mNodes.end()) {
+                    node.m_vpReferences.push_back(&it->second);
+                }
+            }
+            std::sort(node.m_vpReferences.begin(), node.m_vpReferences.end());
+            node.m_vpReferences.erase(std::unique(node.m_vpReferences.begin(), node.m_vpReferences.end()),
+                                      node.m_vpReferences.end());
+            for (Node* pReferencedNode : node.m_vpReferences) {
+                ++pReferencedNode->m_ReferenceCount;
+            }
+        }
+
+        // Look for cycles.
+        int nextIndex = 0;
+        std::vector<Node*> vpStack;
+        for (auto& nodePair : m_mNodes) {
+            if (nodePair.second.m_Index < 0) {
+                FindCycles(nodePair.second, nextIndex, vpStack);
+            }
+        }
+    }
+
+    //
+    // Returns a plugin by ID. Plugins that are part of a reference
+    // cycle are not returned.
+    //
+    // @param p_PluginId ID of plugin to look for.
+    // @return Plugin with the given ID, or nullptr if no such plugin
+    //         was found or if it is part of a reference cycle.
+    //
+    PluginSP PluginDependencyGraph::GetPlugin(const GUID& p_PluginId) const
+    {
+        auto it = m_mNodes.find(p_PluginId);
+        return it != m_mNodes.end() && !it->second.m_InCycle ? it->second.m_spPlugin : nullptr;
+    }
+
+    //
+    // Applies a plugin to a path. If the plugin is shared by multiple
+    // plugins and was last applied to the same path, the memoized
+    // result is returned instead.
+    //
+    // @param p_PluginId ID of plugin to apply.
+    // @param p_rPath Path to modify (in-place).
+    // @param p_Context Context in which to apply the plugin.
+    // @return true if the plugin was applied, false if it was not found
+    //         or if it is part of a reference cycle.
+    //
+    bool PluginDependencyGraph::GetPath(const GUID& p_PluginId,
+                                        std::wstring& p_rPath,
+                                        const ConversionContext& p_Context) const
+    {
+        auto it = m_mNodes.find(p_PluginId);
+        if (it == m_mNodes.end() || it->second.m_InCycle) {
+            return false;
+        }
+
+        const Node& node = it->second;
+        if (node.m_ReferenceCount > 1) {
+            {
+                std::lock_guard<std::mutex> lock(m_CacheLock);
+                if (node.m_HasCachedPath && node.m_CachedInput == p_rPath) {
+                    p_rPath = node.m_CachedOutput;
+                    return true;
+                }
+            }
+
+            // Do not hold the lock while applying the plugin, since it could
+            // itself apply other shared plugins.
+            std::wstring output = node.m_spPlugin->GetPath(p_rPath, p_Context);
+            {
+                std::lock_guard<std::mutex> lock(m_CacheLock);
+                node.m_CachedInput = p_rPath;
+                node.m_CachedOutput = output;
+                node.m_HasCachedPath = true;
+            }
+            p_rPath = std::move(output);
+        } else {
+            p_rPath = node.m_spPlugin->GetPath(p_rPath, p_Context);
+        }
+        return true;
+    }
+
+    //
+    // Forgets all memoized paths. Should be called before converting a new
+    // set of files, since the result of plugins can change over time
+    // (for example if drive mappings change).
+    //
+    void PluginDependencyGraph::ClearCachedPaths() const
+    {
+        std::lock_guard<std::mutex> lock(m_CacheLock);
+        for (const auto& nodePair : m_mNodes) {
+            const Node& node = nodePair.second;
+            node.m_HasCachedPath = false;
+            node.m_CachedInput.clear();
+            node.m_CachedOutput.clear();
+        }
+    }
+
+    //
+    // Looks for reference cycles starting at a given node, using Tarjan's
+    // strongly connected components algorithm. Nodes found in a component
+    // containing more than one node (or in a node referencing itself)
+    // are marked as being part of a cycle.
+    //
+    // @param p_rNode Node to start from.
+    // @param p_rNextIndex Next node index to assign.
+    // @param p_rvpStack Stack of nodes being visited.
+    //
+    void PluginDependencyGraph::FindCycles(Node& p_rNode,
+                                           int& p_rNextIndex,
+                                           std::vector<Node*>& p_rvpStack)
+    {
+        p_rNode.m_Index = p_rNextIndex;
+        p_rNode.m_LowLink = p_rNextIndex;
+        ++p_rNextIndex;
+        p_rvpStack.push_back(&p_rNode);
+        p_rNode.m_OnStack = true;
+
+        bool referencesItself = false;
+        for (Node* pReferencedNode : p_rNode.m_vpReferences) {
+            if (pReferencedNode == &p_rNode) {
+                referencesItself = true;
+            } else if (pReferencedNode->m_Index < 0) {
+                FindCycles(*pReferencedNode, p_rNextIndex, p_rvpStack);
+                p_rNode.m_LowLink = (std::min)(p_rNode.m_LowLink, pReferencedNode->m_LowLink);
+            } else if (pReferencedNode->m_OnStack) {
+                p_rNode.m_LowLink = (std::min)(p_rNode.m_LowLink, pReferencedNode->m_Index);
+            }
+        }
+
+        if (p_rNode.m_LowLink == p_rNode.m_Index) {
+            // This node is the root of a component; pop it from the stack.
+            auto rootIt = std::find(p_rvpStack.begin(), p_rvpStack.end(), &p_rNode);
+            const bool inCycle = referencesItself || (p_rvpStack.end() - rootIt) > 1;
+            for (auto it = rootIt; it != p_rvpStack.end(); ++it) {
+                (*it)->m_OnStack = false;
+                (*it)->m_InCycle = inCycle;
+            }
+            p_rvpStack.erase(rootIt, p_rvpStack.end());
+        }
+    }
+
+    //
+    // Node constructor.
+    //
+    PluginDependencyGraph::Node::Node()
+        : m_spPlugin(),
+          m_vpReferences(),
+          m_ReferenceCount(0),
+          m_InCycle(false),
+          m_Index(-1),
+          m_LowLink(-1),
+          m_OnStack(false),
+          m_HasCachedPath(false),
+          m_CachedInput(),
+          m_CachedOutput()
+    {
+    }
+
+} // namespace PCC
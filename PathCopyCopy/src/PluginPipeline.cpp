@@ -22,6 +22,10 @@
 #include <stdafx.h>
 #include <PluginPipeline.h>
 #include <PluginPipelineDecoder.h>
+#include <PluginPipelineElements.h>
+#include <PluginPipelineOptimizer.h>
+
+#include <algorithm>
 
 
 namespace PCC
@@ -92,77 +96,433 @@ namespace PCC
         m_UseFilelist = p_UseFilelist;
     }
 
+    //
+    // Returns the encoding to use for the filelist, if executable is launched with one.
+    //
+    // @return Encoding of filelist.
+    //
+    Actions::LaunchExecutablePathAction::FilelistEncoding PipelineOptions::GetFilelistEncoding() const
+    {
+        return m_FilelistEncoding;
+    }
+
+    //
+    // Sets the encoding to use for the filelist, if executable is launched with one.
+    //
+    // @param p_FilelistEncoding Encoding of filelist.
+    //
+    void PipelineOptions::SetFilelistEncoding(const Actions::LaunchExecutablePathAction::FilelistEncoding p_FilelistEncoding)
+    {
+        m_FilelistEncoding = p_FilelistEncoding;
+    }
+
+    //
+    // Returns how the filelist is delivered to the executable, if it is launched with one.
+    //
+    // @return Delivery method of filelist.
+    //
+    Actions::LaunchExecutablePathAction::FilelistDelivery PipelineOptions::GetFilelistDelivery() const
+    {
+        return m_FilelistDelivery;
+    }
+
+    //
+    // Sets how the filelist is delivered to the executable, if it is launched with one.
+    //
+    // @param p_FilelistDelivery Delivery method of filelist.
+    //
+    void PipelineOptions::SetFilelistDelivery(const Actions::LaunchExecutablePathAction::FilelistDelivery p_FilelistDelivery)
+    {
+        m_FilelistDelivery = p_FilelistDelivery;
+    }
+
+    //
+    // Returns whether to copy paths to the clipboard in multiple formats
+    // (text, HTML links and files) instead of text only.
+    //
+    // @return Whether to copy paths in multiple formats.
+    //
+    bool PipelineOptions::GetCopyMultipleFormats() const
+    {
+        return m_CopyMultipleFormats;
+    }
+
+    //
+    // Sets whether to copy paths to the clipboard in multiple formats
+    // (text, HTML links and files) instead of text only.
+    //
+    // @param p_CopyMultipleFormats true to copy paths in multiple formats.
+    //
+    void PipelineOptions::SetCopyMultipleFormats(const bool p_CopyMultipleFormats)
+    {
+        m_CopyMultipleFormats = p_CopyMultipleFormats;
+    }
+
+    //
+    // Returns the maximum number of batches to run at once when launching
+    // an executable with paths split in command-line-sized batches.
+    //
+    // @return Max number of batches to run at once, or 0 if paths are not
+    //         split in batches.
+    //
+    size_t PipelineOptions::GetMaxParallelBatches() const
+    {
+        return m_MaxParallelBatches;
+    }
+
+    //
+    // Sets the maximum number of batches to run at once when launching
+    // an executable with paths split in command-line-sized batches.
+    //
+    // @param p_MaxParallelBatches Max number of batches to run at once.
+    //                             Set to 0 to avoid splitting paths in batches.
+    //
+    void PipelineOptions::SetMaxParallelBatches(const size_t p_MaxParallelBatches)
+    {
+        m_MaxParallelBatches = p_MaxParallelBatches;
+    }
+
+    //
+    // Returns the type of endpoint used to send paths to a running instance
+    // of the executable instead of launching a new one.
+    //
+    // @return Type of endpoint, or InstanceEndpoint::None to always launch the executable.
+    //
+    Actions::LaunchExecutablePathAction::InstanceEndpoint PipelineOptions::GetInstanceEndpoint() const
+    {
+        return m_InstanceEndpoint;
+    }
+
+    //
+    // Returns the name of the endpoint used to send paths to a running
+    // instance of the executable (e.g. pipe name or window class name).
+    //
+    // @return Name of endpoint.
+    //
+    const std::wstring& PipelineOptions::GetInstanceEndpointName() const
+    {
+        return m_InstanceEndpointName;
+    }
+
+    //
+    // Sets the endpoint used to send paths to a running instance
+    // of the executable instead of launching a new one.
+    //
+    // @param p_InstanceEndpoint Type of endpoint.
+    // @param p_InstanceEndpointName Name of endpoint (e.g. pipe name or window class name).
+    //
+    void PipelineOptions::SetInstanceEndpoint(const Actions::LaunchExecutablePathAction::InstanceEndpoint p_InstanceEndpoint,
+                                              const std::wstring& p_InstanceEndpointName)
+    {
+        m_InstanceEndpoint = p_InstanceEndpoint;
+        m_InstanceEndpointName = p_InstanceEndpointName;
+    }
+
+    //
+    // Returns whether paths should be written to a file instead
+    // of being copied to the clipboard.
+    //
+    // @return true to write paths to a file (see GetOutputFile).
+    //
+    bool PipelineOptions::GetStreamToFile() const
+    {
+        return m_StreamToFile;
+    }
+
+    //
+    // Returns the path of the file to write paths to, if
+    // paths should be written to a file (see GetStreamToFile).
+    //
+    // @return Path of output file, or an empty string to let the user choose one.
+    //
+    const std::wstring& PipelineOptions::GetOutputFile() const
+    {
+        return m_OutputFile;
+    }
+
+    //
+    // Returns the encoding of the file to write paths to, if
+    // paths should be written to a file (see GetStreamToFile).
+    //
+    // @return Encoding of output file.
+    //
+    Actions::LaunchExecutablePathAction::FilelistEncoding PipelineOptions::GetOutputFileEncoding() const
+    {
+        return m_OutputFileEncoding;
+    }
+
+    //
+    // Specifies that paths should be written to a file
+    // instead of being copied to the clipboard.
+    //
+    // @param p_OutputFile Path of file to write paths to.
+    //                     Use an empty string to let the user choose one.
+    // @param p_OutputFileEncoding Encoding of output file.
+    //
+    void PipelineOptions::SetOutputFile(const std::wstring& p_OutputFile,
+                                        const Actions::LaunchExecutablePathAction::FilelistEncoding p_OutputFileEncoding)
+    {
+        m_StreamToFile = true;
+        m_OutputFile = p_OutputFile;
+        m_OutputFileEncoding = p_OutputFileEncoding;
+    }
+
+    //
+    // Returns the format in which paths should be exported along
+    // with the metadata of their files.
+    //
+    // @return Export format, or ExportFormat::None to output paths as-is.
+    //
+    ExportFormat PipelineOptions::GetExportFormat() const
+    {
+        return m_ExportFormat;
+    }
+
+    //
+    // Sets the format in which paths should be exported along
+    // with the metadata of their files (see MetadataExporter).
+    //
+    // @param p_ExportFormat Export format.
+    //
+    void PipelineOptions::SetExportFormat(const ExportFormat p_ExportFormat)
+    {
+        m_ExportFormat = p_ExportFormat;
+    }
+
+    //
+    // Returns whether paths returned by the pipeline can be cached and
+    // reused for the same files until settings change (see PathResultCache).
+    //
+    // @return Whether to memoize paths.
+    //
+    bool PipelineOptions::GetMemoizePaths() const
+    {
+        return m_MemoizePaths;
+    }
+
+    //
+    // Sets whether paths returned by the pipeline can be cached and
+    // reused for the same files until settings change.
+    //
+    // @param p_MemoizePaths true to memoize paths.
+    //
+    void PipelineOptions::SetMemoizePaths(const bool p_MemoizePaths)
+    {
+        m_MemoizePaths = p_MemoizePaths;
+    }
+
     //
     // Constructor with pre-built elements.
     //
     // @param p_vspElements List of elements in the pipeline.
     //
     Pipeline::Pipeline(const PipelineElementSPV& p_vspElements)
-        : m_vspElements(p_vspElements)
+        : m_vspElements(p_vspElements),
+          m_Options(),
+          m_vpGuards(),
+          m_HasGuards(false)
     {
+        ComputeOptions();
+        FindGuards();
     }
 
     //
     // Constructor with encoded pipeline. The pipeline is
-    // built by decoding the string. See PipelineDecoder.
+    // built by decoding the string, then optimized.
+    // See PipelineDecoder and PipelineOptimizer.
     //
     // @param p_EncodedElements Elements encoded in a string.
     //
     Pipeline::Pipeline(const std::wstring& p_EncodedElements)
-        : m_vspElements()
+        : m_vspElements(),
+          m_Options(),
+          m_vpGuards(),
+          m_HasGuards(false)
     {
         PipelineDecoder::DecodePipeline(p_EncodedElements, m_vspElements);
+        PipelineOptimizer::OptimizePipeline(m_vspElements);
+        ComputeOptions();
+        FindGuards();
     }
 
     //
-    // Modifies global pipeline options by successively applying all pipeline
-    // elements to it. Returns the final version of the pipeline options.
+    // Returns the global pipeline options, as modified by all pipeline elements.
+    // They are computed once when the pipeline is created.
     //
-    // @param p_rOptions Global pipeline options to modify.
+    // @return Global pipeline options.
     //
-    void Pipeline::ModifyOptions(PipelineOptions& p_rOptions) const
+    const PipelineOptions& Pipeline::Options() const
     {
-        for (const PipelineElementSP& spElement : m_vspElements) {
-            spElement->ModifyOptions(p_rOptions);
-        }
+        return m_Options;
     }
 
     //
     // Modifies a given path by successively applying all pipeline
-    // elements to it. Returns the final version of the path.
+    // elements to it, stopping at the first guard it fails.
+    // Returns the final version of the path.
     //
     // @param p_rPath Path to modify. Will be modified in-place.
-    // @param p_pPluginProvider Optional object to access plugins.
+    // @param p_Context Context of the conversion, used to access plugins.
     //
     void Pipeline::ModifyPath(std::wstring& p_rPath,
-                              const PluginProvider* const p_pPluginProvider) const
+                              const ConversionContext& p_Context) const
     {
-        for (const PipelineElementSP& spElement : m_vspElements) {
-            spElement->ModifyPath(p_rPath, p_pPluginProvider);
+        for (size_t i = 0; i < m_vspElements.size(); ++i) {
+            if (m_HasGuards && m_vpGuards[i] != nullptr && !m_vpGuards[i]->Passes(p_rPath)) {
+                break;
+            }
+            m_vspElements[i]->ModifyPath(p_rPath, p_Context);
+        }
+    }
+
+    //
+    // Modifies a batch of paths by applying each pipeline element to all
+    // paths before moving on to the next element. This allows elements to
+    // perform their setup only once per batch (see PipelineElement::ModifyPaths).
+    // Results are the same as calling ModifyPath on each path.
+    //
+    // @param p_rvPaths Paths to modify. Will be modified in-place.
+    // @param p_Context Context of the conversion, used to access plugins.
+    //
+    void Pipeline::ModifyPaths(WStringV& p_rvPaths,
+                               const ConversionContext& p_Context) const
+    {
+        if (!p_rvPaths.empty()) {
+            ModifyPaths(p_rvPaths, 0, p_Context);
         }
     }
 
     //
     // Checks if a plugin using this pipeline should be enabled or not.
-    // Any part of the pipeline that returns false for this will make the item disabled.
+    // Any part of the pipeline that returns false for this will make the item disabled,
+    // as will a guard that disables the item when the file does not match.
     //
     // @param p_ParentPath Path of the parent folder for the file to check.
     // @param p_File Path of file to use for the check.
-    // @param p_pPluginProvider Optional object to access plugins.
+    // @param p_Context Context of the conversion, used to access plugins.
     // @return false if pipeline says plugin should be disabled for this path.
     //
     bool Pipeline::ShouldBeEnabledFor(const std::wstring& p_ParentPath,
                                       const std::wstring& p_File,
-                                      const PluginProvider* const p_pPluginProvider) const
+                                      const ConversionContext& p_Context) const
     {
+        // Guards found before any other element can be checked against the file
+        // itself. If it fails one of them, the rest of the pipeline is skipped.
         bool enabled = true;
-        PipelineElementSPV::const_iterator it, end = m_vspElements.cend();
-        for (it = m_vspElements.cbegin(); enabled && it != end; ++it) {
-            enabled = (*it)->ShouldBeEnabledFor(p_ParentPath, p_File, p_pPluginProvider);
+        bool leadingGuards = m_HasGuards;
+        for (size_t i = 0; enabled && i < m_vspElements.size(); ++i) {
+            if (leadingGuards) {
+                const GuardPipelineElement* const pGuard = m_vpGuards[i];
+                if (pGuard == nullptr) {
+                    leadingGuards = false;
+                } else if (!pGuard->Passes(p_File)) {
+                    enabled = pGuard->GetAction() != GuardPipelineElement::Action::Disable;
+                    break;
+                }
+            }
+            enabled = m_vspElements[i]->ShouldBeEnabledFor(p_ParentPath, p_File, p_Context);
         }
         return enabled;
     }
 
+    //
+    // Adds the IDs of all plugins referenced by elements of this pipeline
+    // to the given vector. Used to know which other plugins must be loaded
+    // for a plugin using this pipeline to work.
+    //
+    // @param p_rvPluginIds Where to add referenced plugin IDs.
+    //
+    void Pipeline::GetReferencedPlugins(GUIDV& p_rvPluginIds) const
+    {
+        for (const PipelineElementSP& spElement : m_vspElements) {
+            spElement->GetReferencedPlugins(p_rvPluginIds);
+        }
+    }
+
+    //
+    // Returns the class of cost of the work performed by this pipeline to
+    // modify paths, which is the cost of its most expensive element.
+    //
+    // @param p_Context Context in which the pipeline is used, used to access plugins.
+    // @return Pipeline's cost class.
+    //
+    PluginCost Pipeline::CostClass(const ConversionContext& p_Context) const
+    {
+        PluginCost cost = PluginCost::Pure;
+        for (const PipelineElementSP& spElement : m_vspElements) {
+            cost = (std::max)(cost, spElement->CostClass(p_Context));
+        }
+        return cost;
+    }
+
+    //
+    // Computes global pipeline options by successively applying all
+    // pipeline elements to them. Called when the pipeline is created.
+    //
+    void Pipeline::ComputeOptions()
+    {
+        for (const PipelineElementSP& spElement : m_vspElements) {
+            spElement->ModifyOptions(m_Options);
+        }
+    }
+
+    //
+    // Finds the guard elements in the pipeline, so that paths can be checked
+    // against them without looking at the type of each element every time.
+    // Called when the pipeline is created.
+    //
+    void Pipeline::FindGuards()
+    {
+        m_vpGuards.reserve(m_vspElements.size());
+        for (const PipelineElementSP& spElement : m_vspElements) {
+            m_vpGuards.push_back(dynamic_cast<const GuardPipelineElement*>(spElement.get()));
+            m_HasGuards = m_HasGuards || m_vpGuards.back() != nullptr;
+        }
+    }
+
+    //
+    // Modifies a batch of paths by applying pipeline elements starting at
+    // the given one. When a guard is found, paths that fail it are left
+    // as-is and the other paths go through the rest of the pipeline.
+    //
+    // @param p_rvPaths Paths to modify. Will be modified in-place.
+    // @param p_FirstElement Index of first element to apply.
+    // @param p_Context Context of the conversion, used to access plugins.
+    //
+    void Pipeline::ModifyPaths(WStringV& p_rvPaths,
+                               const size_t p_FirstElement,
+                               const ConversionContext& p_Context) const
+    {
+        for (size_t i = p_FirstElement; i < m_vspElements.size(); ++i) {
+            const GuardPipelineElement* const pGuard = m_HasGuards ? m_vpGuards[i] : nullptr;
+            if (pGuard != nullptr) {
+                std::vector<size_t> vPassing;
+                for (size_t j = 0; j < p_rvPaths.size(); ++j) {
+                    if (pGuard->Passes(p_rvPaths[j])) {
+                        vPassing.push_back(j);
+                    }
+                }
+                if (vPassing.size() != p_rvPaths.size()) {
+                    // Some paths failed: apply the rest of the pipeline to the others only.
+                    if (!vPassing.empty()) {
+                        WStringV vPassingPaths;
+                        vPassingPaths.reserve(vPassing.size());
+                        for (size_t j : vPassing) {
+                            vPassingPaths.push_back(std::move(p_rvPaths[j]));
+                        }
+                        ModifyPaths(vPassingPaths, i + 1, p_Context);
+                        for (size_t j = 0; j < vPassing.size(); ++j) {
+                            p_rvPaths[vPassing[j]] = std::move(vPassingPaths[j]);
+                        }
+                    }
+                    break;
+                }
+            } else {
+                m_vspElements[i]->ModifyPaths(p_rvPaths, p_Context);
+            }
+        }
+    }
+
     //
     // Default constructor.
     //
@@ -177,6 +537,22 @@ namespace PCC
     {
     }
 
+    //
+    // Modifies a batch of paths. The default implementation calls ModifyPath
+    // for each path; elements can override this to perform work that doesn't
+    // depend on the path only once for the entire batch.
+    //
+    // @param p_rvPaths Paths to modify (in-place).
+    // @param p_Context Context of the conversion, used to access plugins.
+    //
+    void PipelineElement::ModifyPaths(WStringV& p_rvPaths,
+                                      const ConversionContext& p_Context) const
+    {
+        for (std::wstring& path : p_rvPaths) {
+            ModifyPath(path, p_Context);
+        }
+    }
+
     //
     // Modifies global pipeline options. Each element has the opportunity
     // to modify them when a path is modified.
@@ -193,14 +569,36 @@ namespace PCC
     //
     // @param p_ParentPath Path of the parent folder for the file to check.
     // @param p_File Path of file to use for the check.
-    // @param p_pPluginProvider Optional object to access plugins.
+    // @param p_Context Context of the conversion, used to access plugins.
     // @return false if pipeline element says plugin should be disabled for this path.
     //
     bool PipelineElement::ShouldBeEnabledFor(const std::wstring& /*p_ParentPath*/,
                                              const std::wstring& /*p_File*/,
-                                             const PluginProvider* const /*p_pPluginProvider*/) const
+                                             const ConversionContext& /*p_Context*/) const
     {
         return true;
     }
 
+    //
+    // Adds the IDs of all plugins referenced by this pipeline element to
+    // the given vector. By default, elements do not reference other plugins.
+    //
+    // @param p_rvPluginIds Where to add referenced plugin IDs.
+    //
+    void PipelineElement::GetReferencedPlugins(GUIDV& /*p_rvPluginIds*/) const
+    {
+    }
+
+    //
+    // Returns the class of cost of the work performed by this pipeline element
+    // to modify paths. By default, elements only manipulate strings.
+    //
+    // @param p_Context Context in which the element is used, used to access plugins.
+    // @return PluginCost::Pure.
+    //
+    PluginCost PipelineElement::CostClass(const ConversionContext& /*p_Context*/) const
+    {
+        return PluginCost::Pure;
+    }
+
 } // namespace PCC
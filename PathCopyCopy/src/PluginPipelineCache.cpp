@@ -0,0 +1,95 @@
+// PluginPipelineCache.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <stdafx.h>
+#include <PluginPipelineCache.h>
+#include <PluginPipeline.h>
+#include <PluginPipelineDecoder.h>
+#include <RegistryWatcher.h>
+
+
+namespace PCC
+{
+    // Static members of PipelineCache
+    PipelineCache::PipelineM    PipelineCache::s_mwpPipelines;
+    PipelineCache::EncodedElementsS
+                                PipelineCache::s_sInvalidPipelines;
+    ULONG                       PipelineCache::s_InvalidGeneration = 0;
+    MeasuredMutex               PipelineCache::s_Lock(L"PipelineCache::s_Lock");
+
+    //
+    // Returns the pipeline corresponding to the given encoded string. If a
+    // pipeline with the same encoded string is still in use and was decoded
+    // since settings last changed, it is returned; otherwise, the string is
+    // decoded and the new pipeline is cached. If the string could not be
+    // decoded since settings last changed, it is not decoded again.
+    //
+    // @param p_EncodedElements Elements encoded in a string.
+    // @return Decoded pipeline, shared with other users of the same string.
+    // @throw InvalidPipelineException If the encoded string is invalid.
+    //
+    PipelineSP PipelineCache::GetPipeline(const std::wstring& p_EncodedElements)
+    {
+        const ULONG generation = RegistryWatcher::GetGeneration();
+        std::lock_guard<MeasuredMutex> lock(s_Lock);
+
+        auto it = s_mwpPipelines.find(p_EncodedElements);
+        PipelineSP spPipeline;
+        if (it != s_mwpPipelines.end() && it->second.m_Generation == generation) {
+            spPipeline = it->second.m_wpPipeline.lock();
+        }
+        if (spPipeline == nullptr) {
+            // Check if we already know this pipeline is invalid.
+            if (s_InvalidGeneration != generation) {
+                s_sInvalidPipelines.clear();
+                s_InvalidGeneration = generation;
+            }
+            if (s_sInvalidPipelines.find(p_EncodedElements) != s_sInvalidPipelines.end()) {
+                throw InvalidPipelineException(p_EncodedElements);
+            }
+
+            // Not decoded yet (or not in use anymore). Decode it now; this will
+            // throw if the pipeline is invalid, in which case we remember it.
+            try {
+                spPipeline = std::make_shared<Pipeline>(p_EncodedElements);
+            } catch (const InvalidPipelineException&) {
+                s_sInvalidPipelines.insert(p_EncodedElements);
+                throw;
+            }
+
+            // Before caching it, drop pipelines that are not used anymore.
+            for (auto pruneIt = s_mwpPipelines.begin(); pruneIt != s_mwpPipelines.end(); ) {
+                if (pruneIt->second.m_wpPipeline.expired()) {
+                    pruneIt = s_mwpPipelines.erase(pruneIt);
+                } else {
+                    ++pruneIt;
+                }
+            }
+            CachedPipeline& rCachedPipeline = s_mwpPipelines[p_EncodedElements];
+            rCachedPipeline.m_wpPipeline = spPipeline;
+            rCachedPipeline.m_Generation = generation;
+        }
+
+        return spPipeline;
+    }
+
+} // namespace PCC
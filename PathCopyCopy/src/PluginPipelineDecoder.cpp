@@ -21,9 +21,12 @@
 
 #include <stdafx.h>
 #include <PluginPipelineDecoder.h>
+#include <FastRegex.h>
 #include <PluginPipelineElements.h>
+#include <Trace.h>
 
 #include <assert.h>
+#include <cwchar>
 #include <sstream>
 
 
@@ -40,15 +43,90 @@ namespace
     const wchar_t   ELEMENT_CODE_FORWARD_TO_BACKSLASHES     = L'/';
     const wchar_t   ELEMENT_CODE_REMOVE_EXT                 = L'.';
     const wchar_t   ELEMENT_CODE_FIND_REPLACE               = L'?';
+    const wchar_t   ELEMENT_CODE_FIND_REPLACE_IGNORE_CASE   = L'i';
     const wchar_t   ELEMENT_CODE_REGEX                      = L'^';
+    const wchar_t   ELEMENT_CODE_PREFIX_MAPPING             = L'm';
     const wchar_t   ELEMENT_CODE_APPLY_PLUGIN               = L'{';
     const wchar_t   ELEMENT_CODE_PATHS_SEPARATOR            = L',';
     const wchar_t   ELEMENT_CODE_EXECUTABLE                 = L'x';
     const wchar_t   ELEMENT_CODE_EXECUTABLE_WITH_FILELIST   = L'f';
+    const wchar_t   ELEMENT_CODE_EXECUTABLE_WITH_ENCODED_FILELIST
+                                                            = L'F';
+    const wchar_t   ELEMENT_CODE_COPY_MULTIPLE_FORMATS      = L'c';
+    const wchar_t   ELEMENT_CODE_BATCH_EXECUTABLE           = L'b';
+    const wchar_t   ELEMENT_CODE_RUNNING_INSTANCE           = L'r';
+    const wchar_t   ELEMENT_CODE_OUTPUT_FILE                = L'o';
+    const wchar_t   ELEMENT_CODE_FINAL_PATH                 = L'l';
+    const wchar_t   ELEMENT_CODE_TEMPLATE                   = L't';
+    const wchar_t   ELEMENT_CODE_ENVIRONMENT_VARIABLES      = L'v';
+    const wchar_t   ELEMENT_CODE_CONTENT_HASH               = L'h';
+    const wchar_t   ELEMENT_CODE_EXPORT_METADATA            = L'e';
+    const wchar_t   ELEMENT_CODE_UNICODE_NORMALIZATION      = L'n';
+    const wchar_t   ELEMENT_CODE_GUARD                      = L'g';
+    const wchar_t   ELEMENT_CODE_MEMOIZE                    = L'M';
+
+    // Text-encoded pipelines with more than 99 elements start with this character,
+    // followed by their number of elements encoded as a string.
+    const wchar_t   ELEMENT_COUNT_STRING_PREFIX             = L'+';
 
     // Version numbers used for regex elements.
     const long      REGEX_ELEMENT_INITIAL_VERSION           = 1;
-    const long      REGEX_ELEMENT_MAX_VERSION               = REGEX_ELEMENT_INITIAL_VERSION;
+    const long      REGEX_ELEMENT_ENGINE_VERSION            = 2;
+    const long      REGEX_ELEMENT_MAX_VERSION               = REGEX_ELEMENT_ENGINE_VERSION;
+
+    // Version numbers used for prefix mapping elements.
+    const long      PREFIX_MAPPING_ELEMENT_INITIAL_VERSION  = 1;
+    const long      PREFIX_MAPPING_ELEMENT_MAX_VERSION      = PREFIX_MAPPING_ELEMENT_INITIAL_VERSION;
+
+    // Version numbers used for template elements.
+    const long      TEMPLATE_ELEMENT_INITIAL_VERSION        = 1;
+    const long      TEMPLATE_ELEMENT_MAX_VERSION            = TEMPLATE_ELEMENT_INITIAL_VERSION;
+
+    // Version numbers used for executable with encoded filelist elements.
+    const long      ENCODED_FILELIST_ELEMENT_INITIAL_VERSION
+                                                            = 1;
+    const long      ENCODED_FILELIST_ELEMENT_DELIVERY_VERSION
+                                                            = 2;
+    const long      ENCODED_FILELIST_ELEMENT_MAX_VERSION    = ENCODED_FILELIST_ELEMENT_DELIVERY_VERSION;
+
+    // Version numbers used for batch executable elements.
+    const long      BATCH_EXECUTABLE_ELEMENT_INITIAL_VERSION
+                                                            = 1;
+    const long      BATCH_EXECUTABLE_ELEMENT_MAX_VERSION    = BATCH_EXECUTABLE_ELEMENT_INITIAL_VERSION;
+
+    // Version numbers used for running instance elements.
+    const long      RUNNING_INSTANCE_ELEMENT_INITIAL_VERSION
+                                                            = 1;
+    const long      RUNNING_INSTANCE_ELEMENT_MAX_VERSION    = RUNNING_INSTANCE_ELEMENT_INITIAL_VERSION;
+
+    // Version numbers used for output file elements.
+    const long      OUTPUT_FILE_ELEMENT_INITIAL_VERSION     = 1;
+    const long      OUTPUT_FILE_ELEMENT_MAX_VERSION         = OUTPUT_FILE_ELEMENT_INITIAL_VERSION;
+
+    // Version numbers used for export metadata elements.
+    const long      EXPORT_METADATA_ELEMENT_INITIAL_VERSION = 1;
+    const long      EXPORT_METADATA_ELEMENT_MAX_VERSION     = EXPORT_METADATA_ELEMENT_INITIAL_VERSION;
+
+    // Version numbers used for Unicode normalization elements.
+    const long      UNICODE_NORMALIZATION_ELEMENT_INITIAL_VERSION
+                                                            = 1;
+    const long      UNICODE_NORMALIZATION_ELEMENT_MAX_VERSION
+                                                            = UNICODE_NORMALIZATION_ELEMENT_INITIAL_VERSION;
+
+    // Version numbers used for guard elements.
+    const long      GUARD_ELEMENT_INITIAL_VERSION           = 1;
+    const long      GUARD_ELEMENT_MAX_VERSION               = GUARD_ELEMENT_INITIAL_VERSION;
+
+    // Pipelines encoded in binary format start with this character. Since text-encoded
+    // pipelines start with their number of elements, they can't start with it.
+    const wchar_t   BINARY_FORMAT_SIGNATURE                 = L'\x0001';
+
+    // Version numbers used for pipelines encoded in binary format.
+    const wchar_t   BINARY_FORMAT_INITIAL_VERSION           = 1;
+    const wchar_t   BINARY_FORMAT_MAX_VERSION               = BINARY_FORMAT_INITIAL_VERSION;
+
+    // Size of a GUID encoded in binary format, in characters.
+    const size_t    BINARY_GUID_SIZE                        = sizeof(GUID) / sizeof(wchar_t);
 
 } // anonymous namespace
 
@@ -58,23 +136,53 @@ namespace PCC
     // Decodes a series of elements that were encoded by the settings application
     // in a string and produces a list of corresponding pipeline element objects.
     //
+    // Pipelines can be encoded in text format (the legacy format, used when
+    // pipelines are stored in string registry values) or in binary format
+    // (used when pipelines are stored in binary registry values). In binary
+    // format, all fields are stored directly as characters, prefixed by their
+    // length when needed, which makes them faster to decode.
+    //
     // @param p_EncodedElements Elements encoded in a string.
     // @param p_rvspElements Where to store the resulting elements.
     //
     void PipelineDecoder::DecodePipeline(const std::wstring& p_EncodedElements,
                                          PipelineElementSPV& p_rvspElements)
     {
+        StTraceEvent traceEvent(L"PipelineDecoder::DecodePipeline");
         try {
-            // The first two characters are a string representation of the number
-            // of elements in the pipeline (99 being the maximum number of elements
-            // there can be). Read that using a string stream.
-            if (p_EncodedElements.size() < 2) {
-                throw InvalidPipelineException();
-            }
             std::wstring::const_iterator eIt = p_EncodedElements.begin();
             std::wstring::const_iterator eEnd = p_EncodedElements.end();
             size_t numElements = 0;
-            {
+            Format format = Format::Text;
+            if (eIt != eEnd && *eIt == BINARY_FORMAT_SIGNATURE) {
+                // Binary format: signature, format version, then number of elements.
+                ++eIt;
+                if (eIt == eEnd || *eIt++ > BINARY_FORMAT_MAX_VERSION) {
+                    throw InvalidPipelineException();
+                }
+                format = Format::Binary;
+                long binaryNumElements = DecodePipelineInt(eIt, eEnd, format);
+                if (binaryNumElements < 0) {
+                    throw InvalidPipelineException();
+                }
+                numElements = static_cast<size_t>(binaryNumElements);
+            } else if (eIt != eEnd && *eIt == ELEMENT_COUNT_STRING_PREFIX) {
+                // Pipelines with more elements than can fit in the two-character
+                // count below store their number of elements as a string instead.
+                ++eIt;
+                std::wstring numElementsString;
+                DecodePipelineString(eIt, eEnd, format, numElementsString);
+                if (numElementsString.empty() || numElementsString.find_first_not_of(L"0123456789") != std::wstring::npos) {
+                    throw InvalidPipelineException();
+                }
+                numElements = std::wcstoul(numElementsString.c_str(), nullptr, 10);
+            } else {
+                // The first two characters are a string representation of the number
+                // of elements in the pipeline (99 being the maximum number of elements
+                // there can be in this case). Read that using a string stream.
+                if (p_EncodedElements.size() < 2) {
+                    throw InvalidPipelineException();
+                }
                 std::wstringstream wss;
                 wss << *eIt++;
                 wss << *eIt++;
@@ -82,9 +190,17 @@ namespace PCC
                 wss >> numElements;
             }
 
+            // Each element needs at least one character for its code, so we can validate
+            // the number of elements before allocating room for all of them at once.
+            if (numElements > static_cast<size_t>(std::distance(eIt, eEnd))) {
+                throw InvalidPipelineException();
+            }
+            p_rvspElements.reserve(p_rvspElements.size() + numElements);
+            traceEvent.SetCount(numElements);
+
             // Loop to read the appropriate number of elements.
             for (size_t i = 0; i < numElements; ++i) {
-                DecodePipelineElement(eIt, eEnd, p_rvspElements);
+                DecodePipelineElement(eIt, eEnd, format, p_rvspElements);
             }
         } catch (const InvalidPipelineException&) {
             // Re-throw with the pipeline string.
@@ -100,10 +216,12 @@ namespace PCC
     //                     in the encoded string. After the method returns, the
     //                     iterator points just pass the element's data.
     // @param p_ElementEnd Iterator pointing at the end of the encoded string.
+    // @param p_Format Format of the encoded string.
     // @param p_rvspElements Where to store the new elements.
     //
     void PipelineDecoder::DecodePipelineElement(std::wstring::const_iterator& p_rElementIt,
                                                 const std::wstring::const_iterator& p_ElementEnd,
+                                                const Format p_Format,
                                                 PipelineElementSPV& p_rvspElements)
     {
         PipelineElementSP spElement;
@@ -148,25 +266,80 @@ namespace PCC
                 spElement = std::make_shared<RemoveFileExtPipelineElement>();
                 break;
             }
-            case ELEMENT_CODE_FIND_REPLACE: {
-                DecodeFindReplaceElement(p_rElementIt, p_ElementEnd, spElement);
+            case ELEMENT_CODE_FINAL_PATH: {
+                spElement = std::make_shared<FinalPathPipelineElement>();
+                break;
+            }
+            case ELEMENT_CODE_ENVIRONMENT_VARIABLES: {
+                spElement = std::make_shared<EnvironmentVariablesPipelineElement>();
+                break;
+            }
+            case ELEMENT_CODE_CONTENT_HASH: {
+                spElement = std::make_shared<ContentHashPipelineElement>();
+                break;
+            }
+            case ELEMENT_CODE_UNICODE_NORMALIZATION: {
+                DecodeUnicodeNormalizationElement(p_rElementIt, p_ElementEnd, p_Format, spElement);
+                break;
+            }
+            case ELEMENT_CODE_GUARD: {
+                DecodeGuardElement(p_rElementIt, p_ElementEnd, p_Format, spElement);
+                break;
+            }
+            case ELEMENT_CODE_FIND_REPLACE:
+            case ELEMENT_CODE_FIND_REPLACE_IGNORE_CASE: {
+                DecodeFindReplaceElement(p_rElementIt, p_ElementEnd, p_Format,
+                    code == ELEMENT_CODE_FIND_REPLACE_IGNORE_CASE, spElement);
                 break;
             }
             case ELEMENT_CODE_REGEX: {
-                DecodeRegexElement(p_rElementIt, p_ElementEnd, spElement);
+                DecodeRegexElement(p_rElementIt, p_ElementEnd, p_Format, spElement);
+                break;
+            }
+            case ELEMENT_CODE_PREFIX_MAPPING: {
+                DecodePrefixMappingElement(p_rElementIt, p_ElementEnd, p_Format, spElement);
                 break;
             }
             case ELEMENT_CODE_APPLY_PLUGIN: {
-                DecodeApplyPluginElement(p_rElementIt, p_ElementEnd, spElement);
+                DecodeApplyPluginElement(p_rElementIt, p_ElementEnd, p_Format, spElement);
+                break;
+            }
+            case ELEMENT_CODE_TEMPLATE: {
+                DecodeTemplateElement(p_rElementIt, p_ElementEnd, p_Format, spElement);
                 break;
             }
             case ELEMENT_CODE_PATHS_SEPARATOR: {
-                DecodePathsSeparatorElement(p_rElementIt, p_ElementEnd, spElement);
+                DecodePathsSeparatorElement(p_rElementIt, p_ElementEnd, p_Format, spElement);
                 break;
             }
             case ELEMENT_CODE_EXECUTABLE:
-            case ELEMENT_CODE_EXECUTABLE_WITH_FILELIST: {
-                DecodeExecutableElement(code, p_rElementIt, p_ElementEnd, spElement);
+            case ELEMENT_CODE_EXECUTABLE_WITH_FILELIST:
+            case ELEMENT_CODE_EXECUTABLE_WITH_ENCODED_FILELIST: {
+                DecodeExecutableElement(code, p_rElementIt, p_ElementEnd, p_Format, spElement);
+                break;
+            }
+            case ELEMENT_CODE_COPY_MULTIPLE_FORMATS: {
+                spElement = std::make_shared<CopyMultipleFormatsPipelineElement>();
+                break;
+            }
+            case ELEMENT_CODE_MEMOIZE: {
+                spElement = std::make_shared<MemoizePipelineElement>();
+                break;
+            }
+            case ELEMENT_CODE_BATCH_EXECUTABLE: {
+                DecodeBatchExecutableElement(p_rElementIt, p_ElementEnd, p_Format, spElement);
+                break;
+            }
+            case ELEMENT_CODE_RUNNING_INSTANCE: {
+                DecodeRunningInstanceElement(p_rElementIt, p_ElementEnd, p_Format, spElement);
+                break;
+            }
+            case ELEMENT_CODE_OUTPUT_FILE: {
+                DecodeOutputFileElement(p_rElementIt, p_ElementEnd, p_Format, spElement);
+                break;
+            }
+            case ELEMENT_CODE_EXPORT_METADATA: {
+                DecodeExportMetadataElement(p_rElementIt, p_ElementEnd, p_Format, spElement);
                 break;
             }
             default:
@@ -189,17 +362,21 @@ namespace PCC
     //                     encoded string. After the method returns, the iterator points
     //                     just past the pipeline element's data.
     // @param p_ElementEnd Iterator pointing at the end of the encoded string.
+    // @param p_Format Format of the encoded string.
+    // @param p_IgnoreCase Whether the element should ignore case.
     // @param p_rspElement Where to store the newly-created element.
     //
     void PipelineDecoder::DecodeFindReplaceElement(std::wstring::const_iterator& p_rElementIt,
                                                    const std::wstring::const_iterator& p_ElementEnd,
+                                                   const Format p_Format,
+                                                   const bool p_IgnoreCase,
                                                    PipelineElementSP& p_rspElement)
     {
         // This type of element contains an old and a new value.
         std::wstring oldValue, newValue;
-        DecodePipelineString(p_rElementIt, p_ElementEnd, oldValue);
-        DecodePipelineString(p_rElementIt, p_ElementEnd, newValue);
-        p_rspElement = std::make_shared<FindReplacePipelineElement>(oldValue, newValue);
+        DecodePipelineString(p_rElementIt, p_ElementEnd, p_Format, oldValue);
+        DecodePipelineString(p_rElementIt, p_ElementEnd, p_Format, newValue);
+        p_rspElement = std::make_shared<FindReplacePipelineElement>(oldValue, newValue, p_IgnoreCase);
     }
 
     //
@@ -209,15 +386,17 @@ namespace PCC
     //                     encoded string. After the method returns, the iterator points
     //                     just past the pipeline element's data.
     // @param p_ElementEnd Iterator pointing at the end of the encoded string.
+    // @param p_Format Format of the encoded string.
     // @param p_rspElement Where to store the newly-created element.
     //
     void PipelineDecoder::DecodeRegexElement(std::wstring::const_iterator& p_rElementIt,
                                              const std::wstring::const_iterator& p_ElementEnd,
+                                             const Format p_Format,
                                              PipelineElementSP& p_rspElement)
     {
         // The data starts by a version number. This is used in case we need to add
         // support for extra options in the future.
-        long version = DecodePipelineInt(p_rElementIt, p_ElementEnd);
+        long version = DecodePipelineInt(p_rElementIt, p_ElementEnd, p_Format);
 
         // Make sure it's a version we can support.
         if (version > REGEX_ELEMENT_MAX_VERSION) {
@@ -226,12 +405,65 @@ namespace PCC
 
         // Initial version: regex, format string and whether we should ignore case.
         std::wstring regex, format;
-        DecodePipelineString(p_rElementIt, p_ElementEnd, regex);
-        DecodePipelineString(p_rElementIt, p_ElementEnd, format);
-        bool ignoreCase = DecodePipelineBool(p_rElementIt, p_ElementEnd);
+        DecodePipelineString(p_rElementIt, p_ElementEnd, p_Format, regex);
+        DecodePipelineString(p_rElementIt, p_ElementEnd, p_Format, format);
+        bool ignoreCase = DecodePipelineBool(p_rElementIt, p_ElementEnd, p_Format);
+
+        // Engine version: regex engine to use.
+        auto engine = RegexPipelineElement::Engine::Standard;
+        if (version >= REGEX_ELEMENT_ENGINE_VERSION) {
+            long engineValue = DecodePipelineInt(p_rElementIt, p_ElementEnd, p_Format);
+            if (engineValue < static_cast<long>(RegexPipelineElement::Engine::Standard) ||
+                engineValue > static_cast<long>(RegexPipelineElement::Engine::Fast)) {
+                throw InvalidPipelineException();
+            }
+            engine = static_cast<RegexPipelineElement::Engine>(engineValue);
+        }
+
+        // Patterns with nested quantifiers can backtrack catastrophically with std::wregex.
+        // The fast engine has the same semantics but runs in linear time, so use it if possible.
+        if (engine == RegexPipelineElement::Engine::Standard && FastRegex::HasNestedQuantifiers(regex)) {
+            engine = RegexPipelineElement::Engine::Fast;
+        }
 
         // Create the element and return it.
-        p_rspElement = std::make_shared<RegexPipelineElement>(regex, format, ignoreCase);
+        p_rspElement = std::make_shared<RegexPipelineElement>(regex, format, ignoreCase, engine);
+    }
+
+    //
+    // Decodes a PrefixMappingPipelineElement found in an encoded string.
+    //
+    // @param p_rElementIt Iterator pointing at the beginning of the element data in the
+    //                     encoded string. After the method returns, the iterator points
+    //                     just past the pipeline element's data.
+    // @param p_ElementEnd Iterator pointing at the end of the encoded string.
+    // @param p_Format Format of the encoded string.
+    // @param p_rspElement Where to store the newly-created element.
+    //
+    void PipelineDecoder::DecodePrefixMappingElement(std::wstring::const_iterator& p_rElementIt,
+                                                     const std::wstring::const_iterator& p_ElementEnd,
+                                                     const Format p_Format,
+                                                     PipelineElementSP& p_rspElement)
+    {
+        // The data starts by a version number, like for regex elements.
+        long version = DecodePipelineInt(p_rElementIt, p_ElementEnd, p_Format);
+        if (version > PREFIX_MAPPING_ELEMENT_MAX_VERSION) {
+            throw InvalidPipelineException();
+        }
+
+        // Initial version: source of the table, table (or its location) and whether we should ignore case.
+        long sourceValue = DecodePipelineInt(p_rElementIt, p_ElementEnd, p_Format);
+        if (sourceValue < static_cast<long>(PrefixMap::Source::Inline) ||
+            sourceValue > static_cast<long>(PrefixMap::Source::Registry)) {
+            throw InvalidPipelineException();
+        }
+        std::wstring table;
+        DecodePipelineString(p_rElementIt, p_ElementEnd, p_Format, table);
+        bool ignoreCase = DecodePipelineBool(p_rElementIt, p_ElementEnd, p_Format);
+
+        // Create the element and return it.
+        p_rspElement = std::make_shared<PrefixMappingPipelineElement>(
+            static_cast<PrefixMap::Source>(sourceValue), table, ignoreCase);
     }
 
     //
@@ -241,13 +473,27 @@ namespace PCC
     //                     encoded string. After the method returns, the iterator points
     //                     just past the pipeline element's data.
     // @param p_ElementEnd Iterator pointing at the end of the encoded string.
+    // @param p_Format Format of the encoded string.
     // @param p_rspElement Where to store the newly-created element.
     //
     void PipelineDecoder::DecodeApplyPluginElement(std::wstring::const_iterator& p_rElementIt,
                                                    const std::wstring::const_iterator& p_ElementEnd,
+                                                   const Format p_Format,
                                                    PipelineElementSP& p_rspElement)
     {
-        // The element data is a string representation of the GUID of the plugin to apply.
+        // In binary format, the element data is the GUID of the plugin to apply, as-is.
+        if (p_Format == Format::Binary) {
+            if (std::distance(p_rElementIt, p_ElementEnd) < static_cast<ptrdiff_t>(BINARY_GUID_SIZE)) {
+                throw InvalidPipelineException();
+            }
+            GUID pluginGuid;
+            std::copy(p_rElementIt, p_rElementIt + BINARY_GUID_SIZE, reinterpret_cast<wchar_t*>(&pluginGuid));
+            p_rElementIt += BINARY_GUID_SIZE;
+            p_rspElement = std::make_shared<ApplyPluginPipelineElement>(pluginGuid);
+            return;
+        }
+
+        // In text format, the element data is a string representation of the GUID of the plugin to apply.
         // A guid has the following format: {1B4B1405-84CF-48CC-B373-42FAD7744258}
         if (std::distance(p_rElementIt, p_ElementEnd) < (GUIDSTRING_MAX - 1)) {
             throw InvalidPipelineException();
@@ -268,6 +514,36 @@ namespace PCC
         p_rspElement = std::make_shared<ApplyPluginPipelineElement>(pluginGuid);
     }
 
+    //
+    // Decodes a TemplatePipelineElement found in an encoded string.
+    // The template is compiled here, so that it's only done once.
+    //
+    // @param p_rElementIt Iterator pointing at the beginning of the element data in the
+    //                     encoded string. After the method returns, the iterator points
+    //                     just past the pipeline element's data.
+    // @param p_ElementEnd Iterator pointing at the end of the encoded string.
+    // @param p_Format Format of the encoded string.
+    // @param p_rspElement Where to store the newly-created element.
+    //
+    void PipelineDecoder::DecodeTemplateElement(std::wstring::const_iterator& p_rElementIt,
+                                                const std::wstring::const_iterator& p_ElementEnd,
+                                                const Format p_Format,
+                                                PipelineElementSP& p_rspElement)
+    {
+        // The data starts by a version number, like for regex elements.
+        long version = DecodePipelineInt(p_rElementIt, p_ElementEnd, p_Format);
+        if (version > TEMPLATE_ELEMENT_MAX_VERSION) {
+            throw InvalidPipelineException();
+        }
+
+        // Initial version: format template.
+        std::wstring templ;
+        DecodePipelineString(p_rElementIt, p_ElementEnd, p_Format, templ);
+
+        // Create the element, compiling the template, and return it.
+        p_rspElement = std::make_shared<TemplatePipelineElement>(templ);
+    }
+
     //
     // Decodes an PathsSeparatorPipelineElement found in an encoded string.
     //
@@ -275,41 +551,263 @@ namespace PCC
     //                     encoded string. After the method returns, the iterator points
     //                     just past the pipeline element's data.
     // @param p_ElementEnd Iterator pointing at the end of the encoded string.
+    // @param p_Format Format of the encoded string.
     // @param p_rspElement Where to store the newly-created element.
     //
     void PipelineDecoder::DecodePathsSeparatorElement(std::wstring::const_iterator& p_rElementIt,
                                                       const std::wstring::const_iterator& p_ElementEnd,
+                                                      const Format p_Format,
                                                       PipelineElementSP& p_rspElement)
     {
         // This type of element contains only the paths separator string.
         std::wstring pathsSeparator;
-        DecodePipelineString(p_rElementIt, p_ElementEnd, pathsSeparator);
+        DecodePipelineString(p_rElementIt, p_ElementEnd, p_Format, pathsSeparator);
         p_rspElement = std::make_shared<PathsSeparatorPipelineElement>(pathsSeparator);
     }
 
+    //
+    // Decodes a BatchExecutablePipelineElement found in an encoded string.
+    //
+    // @param p_rElementIt Iterator pointing at the beginning of the element data in the
+    //                     encoded string. After the method returns, the iterator points
+    //                     just past the pipeline element's data.
+    // @param p_ElementEnd Iterator pointing at the end of the encoded string.
+    // @param p_Format Format of the encoded string.
+    // @param p_rspElement Where to store the newly-created element.
+    //
+    void PipelineDecoder::DecodeBatchExecutableElement(std::wstring::const_iterator& p_rElementIt,
+                                                       const std::wstring::const_iterator& p_ElementEnd,
+                                                       const Format p_Format,
+                                                       PipelineElementSP& p_rspElement)
+    {
+        // This type of element contains a version number, followed by
+        // the max number of batches to run at once.
+        long version = DecodePipelineInt(p_rElementIt, p_ElementEnd, p_Format);
+        if (version > BATCH_EXECUTABLE_ELEMENT_MAX_VERSION) {
+            throw InvalidPipelineException();
+        }
+        long maxParallelBatches = DecodePipelineInt(p_rElementIt, p_ElementEnd, p_Format);
+        if (maxParallelBatches < 1) {
+            throw InvalidPipelineException();
+        }
+        p_rspElement = std::make_shared<BatchExecutablePipelineElement>(static_cast<size_t>(maxParallelBatches));
+    }
+
+    //
+    // Decodes a RunningInstancePipelineElement found in an encoded string.
+    //
+    // @param p_rElementIt Iterator pointing at the beginning of the element data in the
+    //                     encoded string. After the method returns, the iterator points
+    //                     just past the pipeline element's data.
+    // @param p_ElementEnd Iterator pointing at the end of the encoded string.
+    // @param p_Format Format of the encoded string.
+    // @param p_rspElement Where to store the newly-created element.
+    //
+    void PipelineDecoder::DecodeRunningInstanceElement(std::wstring::const_iterator& p_rElementIt,
+                                                       const std::wstring::const_iterator& p_ElementEnd,
+                                                       const Format p_Format,
+                                                       PipelineElementSP& p_rspElement)
+    {
+        // This type of element contains a version number, followed by
+        // the type of endpoint and its name.
+        typedef RunningInstancePipelineElement::InstanceEndpoint InstanceEndpoint;
+        long version = DecodePipelineInt(p_rElementIt, p_ElementEnd, p_Format);
+        if (version > RUNNING_INSTANCE_ELEMENT_MAX_VERSION) {
+            throw InvalidPipelineException();
+        }
+        long endpointValue = DecodePipelineInt(p_rElementIt, p_ElementEnd, p_Format);
+        if (endpointValue < static_cast<long>(InstanceEndpoint::NamedPipe) ||
+            endpointValue > static_cast<long>(InstanceEndpoint::WindowClass)) {
+            throw InvalidPipelineException();
+        }
+        std::wstring endpointName;
+        DecodePipelineString(p_rElementIt, p_ElementEnd, p_Format, endpointName);
+        p_rspElement = std::make_shared<RunningInstancePipelineElement>(static_cast<InstanceEndpoint>(endpointValue),
+                                                                        endpointName);
+    }
+
+    //
+    // Decodes an OutputFilePipelineElement found in an encoded string.
+    //
+    // @param p_rElementIt Iterator pointing at the beginning of the element data in the
+    //                     encoded string. After the method returns, the iterator points
+    //                     just past the pipeline element's data.
+    // @param p_ElementEnd Iterator pointing at the end of the encoded string.
+    // @param p_Format Format of the encoded string.
+    // @param p_rspElement Where to store the newly-created element.
+    //
+    void PipelineDecoder::DecodeOutputFileElement(std::wstring::const_iterator& p_rElementIt,
+                                                  const std::wstring::const_iterator& p_ElementEnd,
+                                                  const Format p_Format,
+                                                  PipelineElementSP& p_rspElement)
+    {
+        // This type of element contains a version number, followed by
+        // the encoding of the output file and its path.
+        typedef OutputFilePipelineElement::OutputEncoding OutputEncoding;
+        long version = DecodePipelineInt(p_rElementIt, p_ElementEnd, p_Format);
+        if (version > OUTPUT_FILE_ELEMENT_MAX_VERSION) {
+            throw InvalidPipelineException();
+        }
+        long encodingValue = DecodePipelineInt(p_rElementIt, p_ElementEnd, p_Format);
+        if (encodingValue < static_cast<long>(OutputEncoding::Ansi) ||
+            encodingValue > static_cast<long>(OutputEncoding::UTF16LE)) {
+            throw InvalidPipelineException();
+        }
+        std::wstring outputFile;
+        DecodePipelineString(p_rElementIt, p_ElementEnd, p_Format, outputFile);
+        p_rspElement = std::make_shared<OutputFilePipelineElement>(outputFile, static_cast<OutputEncoding>(encodingValue));
+    }
+
+    //
+    // Decodes an ExportMetadataPipelineElement found in an encoded string.
+    //
+    // @param p_rElementIt Iterator pointing at the beginning of the element data in the
+    //                     encoded string. After the method returns, the iterator points
+    //                     just past the pipeline element's data.
+    // @param p_ElementEnd Iterator pointing at the end of the encoded string.
+    // @param p_Format Format of the encoded string.
+    // @param p_rspElement Where to store the newly-created element.
+    //
+    void PipelineDecoder::DecodeExportMetadataElement(std::wstring::const_iterator& p_rElementIt,
+                                                      const std::wstring::const_iterator& p_ElementEnd,
+                                                      const Format p_Format,
+                                                      PipelineElementSP& p_rspElement)
+    {
+        // This type of element contains a version number, followed by the export format.
+        long version = DecodePipelineInt(p_rElementIt, p_ElementEnd, p_Format);
+        if (version > EXPORT_METADATA_ELEMENT_MAX_VERSION) {
+            throw InvalidPipelineException();
+        }
+        long formatValue = DecodePipelineInt(p_rElementIt, p_ElementEnd, p_Format);
+        if (formatValue < static_cast<long>(ExportFormat::CSV) ||
+            formatValue > static_cast<long>(ExportFormat::JSON)) {
+            throw InvalidPipelineException();
+        }
+        p_rspElement = std::make_shared<ExportMetadataPipelineElement>(static_cast<ExportFormat>(formatValue));
+    }
+
+    //
+    // Decodes a UnicodeNormalizationPipelineElement found in an encoded string.
+    //
+    // @param p_rElementIt Iterator pointing at the beginning of the element data in the
+    //                     encoded string. After the method returns, the iterator points
+    //                     just past the pipeline element's data.
+    // @param p_ElementEnd Iterator pointing at the end of the encoded string.
+    // @param p_Format Format of the encoded string.
+    // @param p_rspElement Where to store the newly-created element.
+    //
+    void PipelineDecoder::DecodeUnicodeNormalizationElement(std::wstring::const_iterator& p_rElementIt,
+                                                            const std::wstring::const_iterator& p_ElementEnd,
+                                                            const Format p_Format,
+                                                            PipelineElementSP& p_rspElement)
+    {
+        // This type of element contains a version number, followed by the normalization form.
+        long version = DecodePipelineInt(p_rElementIt, p_ElementEnd, p_Format);
+        if (version > UNICODE_NORMALIZATION_ELEMENT_MAX_VERSION) {
+            throw InvalidPipelineException();
+        }
+        long formValue = DecodePipelineInt(p_rElementIt, p_ElementEnd, p_Format);
+        if (formValue < static_cast<long>(NormalizationForm::NFC) ||
+            formValue > static_cast<long>(NormalizationForm::NFD)) {
+            throw InvalidPipelineException();
+        }
+        p_rspElement = std::make_shared<UnicodeNormalizationPipelineElement>(static_cast<NormalizationForm>(formValue));
+    }
+
+    //
+    // Decodes a GuardPipelineElement found in an encoded string.
+    //
+    // @param p_rElementIt Iterator pointing at the beginning of the element data in the
+    //                     encoded string. After the method returns, the iterator points
+    //                     just past the pipeline element's data.
+    // @param p_ElementEnd Iterator pointing at the end of the encoded string.
+    // @param p_Format Format of the encoded string.
+    // @param p_rspElement Where to store the newly-created element.
+    //
+    void PipelineDecoder::DecodeGuardElement(std::wstring::const_iterator& p_rElementIt,
+                                             const std::wstring::const_iterator& p_ElementEnd,
+                                             const Format p_Format,
+                                             PipelineElementSP& p_rspElement)
+    {
+        // This type of element contains a version number, followed by the value to look for,
+        // how to look for it, whether to ignore case and what to do with paths that don't match.
+        long version = DecodePipelineInt(p_rElementIt, p_ElementEnd, p_Format);
+        if (version > GUARD_ELEMENT_MAX_VERSION) {
+            throw InvalidPipelineException();
+        }
+        std::wstring value;
+        DecodePipelineString(p_rElementIt, p_ElementEnd, p_Format, value);
+        long matchValue = DecodePipelineInt(p_rElementIt, p_ElementEnd, p_Format);
+        if (matchValue < static_cast<long>(GuardPipelineElement::Match::Prefix) ||
+            matchValue > static_cast<long>(GuardPipelineElement::Match::Contains)) {
+            throw InvalidPipelineException();
+        }
+        bool ignoreCase = DecodePipelineBool(p_rElementIt, p_ElementEnd, p_Format);
+        long actionValue = DecodePipelineInt(p_rElementIt, p_ElementEnd, p_Format);
+        if (actionValue < static_cast<long>(GuardPipelineElement::Action::Skip) ||
+            actionValue > static_cast<long>(GuardPipelineElement::Action::Disable)) {
+            throw InvalidPipelineException();
+        }
+        p_rspElement = std::make_shared<GuardPipelineElement>(value,
+                                                              static_cast<GuardPipelineElement::Match>(matchValue),
+                                                              ignoreCase,
+                                                              static_cast<GuardPipelineElement::Action>(actionValue));
+    }
+
     //
     // Decodes an ExecutablePipelineElement or ExecutableWithFilelistPipelineElement
-    // found in an encoded string.
+    // found in an encoded string. Filelist elements using an encoding other than
+    // ANSI use a different code, so that older versions can still decode others.
     //
     // @param p_Code Element code.
     // @param p_rElementIt Iterator pointing at the beginning of the element data in the
     //                     encoded string. After the method returns, the iterator points
     //                     just past the pipeline element's data.
     // @param p_ElementEnd Iterator pointing at the end of the encoded string.
+    // @param p_Format Format of the encoded string.
     // @param p_rspElement Where to store the newly-created element.
     //
     void PipelineDecoder::DecodeExecutableElement(const wchar_t p_Code,
                                                   std::wstring::const_iterator& p_rElementIt,
                                                   const std::wstring::const_iterator& p_ElementEnd,
+                                                  const Format p_Format,
                                                   PipelineElementSP& p_rspElement)
     {
-        // This type of element contains only a string containing the path to the executable.
+        // Elements with encoded filelist start with a version number and the encoding.
+        // Starting with the delivery version, the encoding is followed by the delivery method.
+        typedef ExecutableWithFilelistPipelineElement::FilelistEncoding FilelistEncoding;
+        typedef ExecutableWithFilelistPipelineElement::FilelistDelivery FilelistDelivery;
+        FilelistEncoding encoding = FilelistEncoding::Ansi;
+        FilelistDelivery delivery = FilelistDelivery::TempFile;
+        if (p_Code == ELEMENT_CODE_EXECUTABLE_WITH_ENCODED_FILELIST) {
+            long version = DecodePipelineInt(p_rElementIt, p_ElementEnd, p_Format);
+            if (version > ENCODED_FILELIST_ELEMENT_MAX_VERSION) {
+                throw InvalidPipelineException();
+            }
+            long encodingValue = DecodePipelineInt(p_rElementIt, p_ElementEnd, p_Format);
+            if (encodingValue < static_cast<long>(FilelistEncoding::Ansi) ||
+                encodingValue > static_cast<long>(FilelistEncoding::UTF16LE)) {
+                throw InvalidPipelineException();
+            }
+            encoding = static_cast<FilelistEncoding>(encodingValue);
+            if (version >= ENCODED_FILELIST_ELEMENT_DELIVERY_VERSION) {
+                long deliveryValue = DecodePipelineInt(p_rElementIt, p_ElementEnd, p_Format);
+                if (deliveryValue < static_cast<long>(FilelistDelivery::TempFile) ||
+                    deliveryValue > static_cast<long>(FilelistDelivery::StdinPipe)) {
+                    throw InvalidPipelineException();
+                }
+                delivery = static_cast<FilelistDelivery>(deliveryValue);
+            }
+        }
+
+        // Then comes a string containing the path to the executable.
         std::wstring executable;
-        DecodePipelineString(p_rElementIt, p_ElementEnd, executable);
+        DecodePipelineString(p_rElementIt, p_ElementEnd, p_Format, executable);
         if (p_Code == ELEMENT_CODE_EXECUTABLE) {
             p_rspElement = std::make_shared<ExecutablePipelineElement>(executable);
-        } else if (p_Code == ELEMENT_CODE_EXECUTABLE_WITH_FILELIST) {
-            p_rspElement = std::make_shared<ExecutableWithFilelistPipelineElement>(executable);
+        } else if (p_Code == ELEMENT_CODE_EXECUTABLE_WITH_FILELIST ||
+                   p_Code == ELEMENT_CODE_EXECUTABLE_WITH_ENCODED_FILELIST) {
+            p_rspElement = std::make_shared<ExecutableWithFilelistPipelineElement>(executable, encoding, delivery);
         } else {
             throw InvalidPipelineException();
         }
@@ -322,12 +820,25 @@ namespace PCC
     //                     the encoded string. After the method returns, the iterator
     //                     points just past the integer data.
     // @param p_ElementEnd Iterator pointing at the end of the encoded string.
+    // @param p_Format Format of the encoded string.
     // @return The resulting integer value
     //
     long PipelineDecoder::DecodePipelineInt(std::wstring::const_iterator& p_rElementIt,
-                                            const std::wstring::const_iterator& p_ElementEnd)
+                                            const std::wstring::const_iterator& p_ElementEnd,
+                                            const Format p_Format)
     {
-        // Encoded as four consecutive characters corresponding the integer value.
+        // In binary format, encoded as two characters containing the low
+        // and high 16 bits of the 32-bit integer value.
+        if (p_Format == Format::Binary) {
+            if (std::distance(p_rElementIt, p_ElementEnd) < 2) {
+                throw InvalidPipelineException();
+            }
+            const uint32_t low = static_cast<uint16_t>(*p_rElementIt++);
+            const uint32_t high = static_cast<uint16_t>(*p_rElementIt++);
+            return static_cast<long>(static_cast<int32_t>(low | (high << 16)));
+        }
+
+        // In text format, encoded as four consecutive characters corresponding the integer value.
         if (std::distance(p_rElementIt, p_ElementEnd) < 4) {
             throw InvalidPipelineException();
         }
@@ -351,14 +862,20 @@ namespace PCC
     //                     the encoded string. After the method returns, the iterator
     //                     points just past the string data.
     // @param p_ElementEnd Iterator pointing at the end of the encoded string.
+    // @param p_Format Format of the encoded string.
     // @param p_rString Where to store the resulting string.
     //
     void PipelineDecoder::DecodePipelineString(std::wstring::const_iterator& p_rElementIt,
                                                const std::wstring::const_iterator& p_ElementEnd,
+                                               const Format p_Format,
                                                std::wstring& p_rString)
     {
         // First is encoded string size.
-        std::wstring::size_type stringSize = static_cast<std::wstring::size_type>(DecodePipelineInt(p_rElementIt, p_ElementEnd));
+        const long encodedStringSize = DecodePipelineInt(p_rElementIt, p_ElementEnd, p_Format);
+        if (encodedStringSize < 0) {
+            throw InvalidPipelineException();
+        }
+        std::wstring::size_type stringSize = static_cast<std::wstring::size_type>(encodedStringSize);
 
         // Now that we know the length of the string that is encoded, we simply
         // need to copy that much characters from the encoded string.
@@ -376,19 +893,23 @@ namespace PCC
     //                     the encoded string. After the method returns, the iterator
     //                     points just past the boolean data.
     // @param p_ElementEnd Iterator pointing at the end of the encoded string.
+    // @param p_Format Format of the encoded string.
     // @return Resulting boolean value.
     //
     bool PipelineDecoder::DecodePipelineBool(std::wstring::const_iterator& p_rElementIt,
-                                             const std::wstring::const_iterator& p_ElementEnd)
+                                             const std::wstring::const_iterator& p_ElementEnd,
+                                             const Format p_Format)
     {
-        // Boolean values are merely encoded as 0 or 1.
+        // Boolean values are merely encoded as 0 or 1 (as characters in text format).
+        const wchar_t falseValue = p_Format == Format::Binary ? L'\0' : L'0';
+        const wchar_t trueValue = p_Format == Format::Binary ? L'\x0001' : L'1';
         if (p_rElementIt == p_ElementEnd) {
             throw InvalidPipelineException();
         }
-        if (*p_rElementIt != L'0' && *p_rElementIt != L'1') {
+        if (*p_rElementIt != falseValue && *p_rElementIt != trueValue) {
             throw InvalidPipelineException();
         }
-        return (*p_rElementIt++ == L'1');
+        return (*p_rElementIt++ == trueValue);
     }
 
     //
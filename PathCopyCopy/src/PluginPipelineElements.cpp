@@ -21,10 +21,18 @@
 
 #include <stdafx.h>
 #include <PluginPipelineElements.h>
+#include <EnvironmentVariablesCache.h>
+#include <FastRegex.h>
+#include <FileHasher.h>
+#include <FinalPathResolver.h>
 #include <Plugin.h>
+#include <PluginPipelineDecoder.h>
 #include <StringUtils.h>
+#include <UnicodeNormalizer.h>
 
 #include <algorithm>
+#include <deque>
+
 #include <assert.h>
 
 
@@ -42,10 +50,10 @@ namespace PCC
     // Modifies the given path by surrounding it with quotes.
     //
     // @param p_rPath Path to modify (in-place).
-    // @param p_pPluginProvider Optional object to access plugins.
+    // @param p_Context Context of the conversion, used to access plugins.
     //
     void QuotesPipelineElement::ModifyPath(std::wstring& p_rPath,
-                                           const PluginProvider* const /*p_pPluginProvider*/) const
+                                           const ConversionContext& /*p_Context*/) const
     {
         p_rPath.insert(p_rPath.begin(), 1, L'\"');
         p_rPath.append(1, L'\"');
@@ -64,10 +72,10 @@ namespace PCC
     // path contains spaces.
     //
     // @param p_rPath Path to modify (in-place).
-    // @param p_pPluginProvider Optional object to access plugins.
+    // @param p_Context Context of the conversion, used to access plugins.
     //
     void OptionalQuotesPipelineElement::ModifyPath(std::wstring& p_rPath,
-                                                   const PluginProvider* const /*p_pPluginProvider*/) const
+                                                   const ConversionContext& /*p_Context*/) const
     {
         if (p_rPath.find(' ') != std::wstring::npos) {
             p_rPath.insert(p_rPath.begin(), 1, L'\"');
@@ -87,10 +95,10 @@ namespace PCC
     // Modifies the given path by turning it into an e-mail link.
     //
     // @param p_rPath Path to modify (in-place).
-    // @param p_pPluginProvider Optional object to access plugins.
+    // @param p_Context Context of the conversion, used to access plugins.
     //
     void EmailLinksPipelineElement::ModifyPath(std::wstring& p_rPath,
-                                               const PluginProvider* const /*p_pPluginProvider*/) const
+                                               const ConversionContext& /*p_Context*/) const
     {
         p_rPath.insert(p_rPath.begin(), 1, L'<');
         p_rPath.append(1, L'>');
@@ -108,10 +116,10 @@ namespace PCC
     // Modifies the given path by encoding URI whitespace.
     //
     // @param p_rPath Path to modify (in-place).
-    // @param p_pPluginProvider Optional object to access plugins.
+    // @param p_Context Context of the conversion, used to access plugins.
     //
     void EncodeURIWhitespacePipelineElement::ModifyPath(std::wstring& p_rPath,
-                                                        const PluginProvider* const /*p_pPluginProvider*/) const
+                                                        const ConversionContext& /*p_Context*/) const
     {
         StringUtils::EncodeURICharacters(p_rPath, StringUtils::EncodeParam::Whitespace);
     }
@@ -128,10 +136,10 @@ namespace PCC
     // Modifies the given path by encoding invalid URI characters.
     //
     // @param p_rPath Path to modify (in-place).
-    // @param p_pPluginProvider Optional object to access plugins.
+    // @param p_Context Context of the conversion, used to access plugins.
     //
     void EncodeURICharsPipelineElement::ModifyPath(std::wstring& p_rPath,
-                                                   const PluginProvider* const /*p_pPluginProvider*/) const
+                                                   const ConversionContext& /*p_Context*/) const
     {
         StringUtils::EncodeURICharacters(p_rPath, StringUtils::EncodeParam::All);
     }
@@ -148,12 +156,12 @@ namespace PCC
     // Modifies the given path by replacing all backslashes by forward slashes.
     //
     // @param p_rPath Path to modify (in-place).
-    // @param p_pPluginProvider Optional object to access plugins.
+    // @param p_Context Context of the conversion, used to access plugins.
     //
     void BackToForwardSlashesPipelineElement::ModifyPath(std::wstring& p_rPath,
-                                                         const PluginProvider* const /*p_pPluginProvider*/) const
+                                                         const ConversionContext& /*p_Context*/) const
     {
-        std::replace(p_rPath.begin(), p_rPath.end(), L'\\', L'/');
+        StringUtils::ReplaceChar(p_rPath, L'\\', L'/');
     }
 
     //
@@ -168,12 +176,12 @@ namespace PCC
     // Modifies the given path by replacing all forward slashes by backslashes.
     //
     // @param p_rPath Path to modify (in-place).
-    // @param p_pPluginProvider Optional object to access plugins.
+    // @param p_Context Context of the conversion, used to access plugins.
     //
     void ForwardToBackslashesPipelineElement::ModifyPath(std::wstring& p_rPath,
-                                                         const PluginProvider* const /*p_pPluginProvider*/) const
+                                                         const ConversionContext& /*p_Context*/) const
     {
-        std::replace(p_rPath.begin(), p_rPath.end(), L'/', L'\\');
+        StringUtils::ReplaceChar(p_rPath, L'/', L'\\');
     }
 
     //
@@ -188,13 +196,71 @@ namespace PCC
     // Modified our path by removing any file extension at the end of it.
     //
     // @param p_rPath Path to modify (in-place).
-    // @param p_pPluginProvider Optional object to access plugins.
+    // @param p_Context Context of the conversion, used to access plugins.
     //
     void RemoveFileExtPipelineElement::ModifyPath(std::wstring& p_rPath,
-                                                  const PluginProvider* const /*p_pPluginProvider*/) const
+                                                  const ConversionContext& /*p_Context*/) const
+    {
+        // Look for the last dot in the path. It marks an extension if it is followed by
+        // at least one character, not followed by a separator and not preceded by one
+        // (e.g., "C:\Foo\.gitignore" has no extension). This used to be done
+        // with a regex: ^(.*[^\\/])(?:\.[^\\/.]+)$
+        const std::wstring::size_type dotPos = p_rPath.find_last_of(L"\\/.");
+        if (dotPos != std::wstring::npos && dotPos > 0 && dotPos + 1 < p_rPath.size() &&
+            p_rPath[dotPos] == L'.' && p_rPath[dotPos - 1] != L'\\' && p_rPath[dotPos - 1] != L'/') {
+
+            p_rPath.erase(dotPos);
+        }
+    }
+
+    //
+    // Constructor.
+    //
+    FinalPathPipelineElement::FinalPathPipelineElement()
+        : PipelineElement()
+    {
+    }
+
+    //
+    // Modifies the given path by resolving any reparse point it contains.
+    //
+    // @param p_rPath Path to modify (in-place).
+    // @param p_Context Context of the conversion, used to access plugins.
+    //
+    void FinalPathPipelineElement::ModifyPath(std::wstring& p_rPath,
+                                              const ConversionContext& p_Context) const
+    {
+        FinalPathResolver resolver(p_Context.GetMetadataCache());
+        resolver.Resolve(p_rPath);
+    }
+
+    //
+    // Modifies all paths of a selection by resolving any reparse point they
+    // contain. The same resolver is used for all paths, so directories shared
+    // by the files (usually their parent directory) are resolved only once.
+    //
+    // @param p_rvPaths Paths to modify (in-place).
+    // @param p_Context Context of the conversion, used to access plugins.
+    //
+    void FinalPathPipelineElement::ModifyPaths(WStringV& p_rvPaths,
+                                               const ConversionContext& p_Context) const
+    {
+        FinalPathResolver resolver(p_Context.GetMetadataCache());
+        for (std::wstring& path : p_rvPaths) {
+            resolver.Resolve(path);
+        }
+    }
+
+    //
+    // Returns the class of cost of the work performed by this pipeline element.
+    // We need to query the file system to find reparse points.
+    //
+    // @param p_Context Context in which the element is used, used to access plugins.
+    // @return PluginCost::FileSystem.
+    //
+    PluginCost FinalPathPipelineElement::CostClass(const ConversionContext& /*p_Context*/) const
     {
-        std::wregex extRegex(L"^(.*[^\\\\/])(?:\\.[^\\\\/.]+)$", std::regex_constants::ECMAScript);
-        p_rPath = std::regex_replace(p_rPath, extRegex, L"$1");
+        return PluginCost::FileSystem;
     }
 
     //
@@ -204,10 +270,13 @@ namespace PCC
     // @param p_NewValue Replacement value.
     //
     FindReplacePipelineElement::FindReplacePipelineElement(const std::wstring& p_OldValue,
-                                                           const std::wstring& p_NewValue)
+                                                           const std::wstring& p_NewValue,
+                                                           const bool p_IgnoreCase)
         : PipelineElement(),
           m_OldValue(p_OldValue),
-          m_NewValue(p_NewValue)
+          m_NewValue(p_NewValue),
+          m_IgnoreCase(p_IgnoreCase),
+          m_Replacer(p_OldValue, p_NewValue, p_IgnoreCase)
     {
     }
 
@@ -216,13 +285,191 @@ namespace PCC
     // with our new value.
     //
     // @param p_rPath Path to modify (in-place).
-    // @param p_pPluginProvider Optional object to access plugins.
+    // @param p_Context Context of the conversion, used to access plugins.
     //
     void FindReplacePipelineElement::ModifyPath(std::wstring& p_rPath,
-                                                const PluginProvider* const /*p_pPluginProvider*/) const
+                                                const ConversionContext& /*p_Context*/) const
+    {
+        m_Replacer.ReplaceAll(p_rPath);
+    }
+
+    //
+    // Returns the value replaced by this element.
+    //
+    // @return Value to replace.
+    //
+    const std::wstring& FindReplacePipelineElement::GetOldValue() const
+    {
+        return m_OldValue;
+    }
+
+    //
+    // Returns the replacement value used by this element.
+    //
+    // @return Replacement value.
+    //
+    const std::wstring& FindReplacePipelineElement::GetNewValue() const
+    {
+        return m_NewValue;
+    }
+
+    //
+    // Checks whether this element ignores case when looking for its old value.
+    //
+    // @return true if case is ignored.
+    //
+    bool FindReplacePipelineElement::GetIgnoreCase() const
+    {
+        return m_IgnoreCase;
+    }
+
+    //
+    // Constructor.
+    //
+    // @param p_mCharMap Map of replacement characters, per character to replace.
+    //
+    CharMapPipelineElement::CharMapPipelineElement(const CharM& p_mCharMap)
+        : PipelineElement(),
+          m_AsciiChars(),
+          m_mOtherChars()
+    {
+        for (wchar_t c = 0; c < 0x80; ++c) {
+            m_AsciiChars[c] = c;
+        }
+        for (const auto& charPair : p_mCharMap) {
+            if (charPair.first < 0x80) {
+                m_AsciiChars[charPair.first] = charPair.second;
+            } else if (charPair.first != charPair.second) {
+                m_mOtherChars.insert(charPair);
+            }
+        }
+    }
+
+    //
+    // Modifies the given path by replacing each character according to our map.
+    //
+    // @param p_rPath Path to modify (in-place).
+    // @param p_Context Context of the conversion, used to access plugins.
+    //
+    void CharMapPipelineElement::ModifyPath(std::wstring& p_rPath,
+                                            const ConversionContext& /*p_Context*/) const
+    {
+        const bool hasOtherChars = !m_mOtherChars.empty();
+        for (wchar_t& c : p_rPath) {
+            if (c < 0x80) {
+                c = m_AsciiChars[c];
+            } else if (hasOtherChars) {
+                auto it = m_mOtherChars.find(c);
+                if (it != m_mOtherChars.end()) {
+                    c = it->second;
+                }
+            }
+        }
+    }
+
+    const size_t MultiFindReplacePipelineElement::NO_PATTERN = static_cast<size_t>(-1);
+
+    //
+    // Constructor. Builds the Aho-Corasick automaton for all values to replace.
+    //
+    // @param p_vFindReplaces Values to replace and their replacement values.
+    //                        Values to replace cannot be empty and must not
+    //                        share characters with each other.
+    //
+    MultiFindReplacePipelineElement::MultiFindReplacePipelineElement(const FindReplacePairV& p_vFindReplaces)
+        : PipelineElement(),
+          m_vFindReplaces(p_vFindReplaces),
+          m_vStates(1, State { {}, 0, 0, NO_PATTERN })
+    {
+        // Build the trie of all values to replace.
+        for (size_t i = 0; i < m_vFindReplaces.size(); ++i) {
+            assert(!m_vFindReplaces[i].first.empty());
+            size_t state = 0;
+            for (const wchar_t c : m_vFindReplaces[i].first) {
+                auto it = m_vStates[state].m_mTransitions.find(c);
+                if (it != m_vStates[state].m_mTransitions.end()) {
+                    state = it->second;
+                } else {
+                    const size_t newState = m_vStates.size();
+                    m_vStates.push_back(State { {}, 0, m_vStates[state].m_Depth + 1, NO_PATTERN });
+                    m_vStates[state].m_mTransitions.emplace(c, newState);
+                    state = newState;
+                }
+            }
+            assert(m_vStates[state].m_Pattern == NO_PATTERN);
+            m_vStates[state].m_Pattern = i;
+        }
+
+        // Compute failure transitions, breadth-first.
+        std::deque<size_t> pendingStates;
+        for (const auto& transition : m_vStates[0].m_mTransitions) {
+            pendingStates.push_back(transition.second);
+        }
+        while (!pendingStates.empty()) {
+            const size_t state = pendingStates.front();
+            pendingStates.pop_front();
+            for (const auto& transition : m_vStates[state].m_mTransitions) {
+                m_vStates[transition.second].m_Failure = NextState(m_vStates[state].m_Failure, transition.first);
+                pendingStates.push_back(transition.second);
+            }
+        }
+    }
+
+    //
+    // Modifies the given path by replacing all instances of our values
+    // with their replacement values, in a single pass.
+    //
+    // @param p_rPath Path to modify (in-place).
+    // @param p_Context Context of the conversion, used to access plugins.
+    //
+    void MultiFindReplacePipelineElement::ModifyPath(std::wstring& p_rPath,
+                                                     const ConversionContext& /*p_Context*/) const
     {
-        if (!m_OldValue.empty()) {
-            StringUtils::ReplaceAll(p_rPath, m_OldValue, m_NewValue);
+        std::wstring result;
+        std::wstring::size_type from = 0;
+        size_t state = 0;
+        for (std::wstring::size_type i = 0; i < p_rPath.size(); ++i) {
+            state = NextState(state, p_rPath[i]);
+            const State& curState = m_vStates[state];
+            if (curState.m_Pattern != NO_PATTERN) {
+                // Found a match; since patterns do not share characters,
+                // it cannot overlap with another match.
+                if (result.empty()) {
+                    result.reserve(p_rPath.size());
+                }
+                const std::wstring::size_type matchPos = i + 1 - curState.m_Depth;
+                result.append(p_rPath, from, matchPos - from);
+                result.append(m_vFindReplaces[curState.m_Pattern].second);
+                from = i + 1;
+                state = 0;
+            }
+        }
+        if (from != 0) {
+            result.append(p_rPath, from, std::wstring::npos);
+            p_rPath = std::move(result);
+        }
+    }
+
+    //
+    // Computes the next state of the automaton.
+    //
+    // @param p_State Current state.
+    // @param p_Char Next character in the input.
+    // @return Next state.
+    //
+    size_t MultiFindReplacePipelineElement::NextState(size_t p_State,
+                                                      const wchar_t p_Char) const
+    {
+        for (;;) {
+            const State& state = m_vStates[p_State];
+            auto it = state.m_mTransitions.find(p_Char);
+            if (it != state.m_mTransitions.end()) {
+                return it->second;
+            }
+            if (p_State == 0) {
+                return 0;
+            }
+            p_State = state.m_Failure;
         }
     }
 
@@ -235,13 +482,17 @@ namespace PCC
     //
     RegexPipelineElement::RegexPipelineElement(const std::wstring& p_Regex,
                                                const std::wstring& p_Format,
-                                               const bool p_IgnoreCase)
+                                               const bool p_IgnoreCase,
+                                               const Engine p_Engine /*= Engine::Standard*/)
         : PipelineElement(),
           m_Regex(p_Regex),
           m_Format(p_Format),
           m_IgnoreCase(p_IgnoreCase),
-          m_upRegex(),
-          m_RegexTested(false)
+          m_Engine(p_Engine),
+          m_RequiredLiteral(FastRegex::GetRequiredLiteral(p_Regex, p_IgnoreCase)),
+          m_spRegex(),
+          m_spFastRegex(),
+          m_RegexInit()
     {
     }
 
@@ -250,17 +501,25 @@ namespace PCC
     // expression and replacing them using our format string.
     //
     // @param p_rPath Path to modify (in-place).
-    // @param p_pPluginProvider Optional object to access plugins.
+    // @param p_Context Context of the conversion, used to access plugins.
     //
     void RegexPipelineElement::ModifyPath(std::wstring& p_rPath,
-                                          const PluginProvider* const /*p_pPluginProvider*/) const
+                                          const ConversionContext& /*p_Context*/) const
     {
+        // If path does not contain the literal required by the regex, there can't be
+        // any match so we can leave it as-is without even compiling the regex.
+        if (!m_RequiredLiteral.empty() && !FastRegex::MayContainLiteral(p_rPath, m_RequiredLiteral, m_IgnoreCase)) {
+            return;
+        }
+
         // Check if regex is valid.
         InitRegex();
-        if (m_upRegex != nullptr) {
+        if (m_spFastRegex != nullptr) {
+            p_rPath = m_spFastRegex->Replace(p_rPath, m_Format);
+        } else if (m_spRegex != nullptr) {
             try {
                 // Perform the find-replace and return the modified string.
-                p_rPath = std::regex_replace(p_rPath, *m_upRegex, m_Format);
+                p_rPath = std::regex_replace(p_rPath, *m_spRegex, m_Format);
             } catch (const std::regex_error&) {
                 // Nothing much we can do, we didn't get this at init time...
                 // Probably a problem with the replacement expression.
@@ -269,6 +528,38 @@ namespace PCC
         }
     }
 
+    //
+    // Modifies a batch of paths using our regular expression. The regex is
+    // looked up and the engine is selected only once for the entire batch.
+    //
+    // @param p_rvPaths Paths to modify (in-place).
+    // @param p_Context Context of the conversion, used to access plugins.
+    //
+    void RegexPipelineElement::ModifyPaths(WStringV& p_rvPaths,
+                                           const ConversionContext& /*p_Context*/) const
+    {
+        InitRegex();
+        if (m_spFastRegex != nullptr) {
+            const FastRegex& fastRegex = *m_spFastRegex;
+            for (std::wstring& path : p_rvPaths) {
+                if (m_RequiredLiteral.empty() || FastRegex::MayContainLiteral(path, m_RequiredLiteral, m_IgnoreCase)) {
+                    path = fastRegex.Replace(path, m_Format);
+                }
+            }
+        } else if (m_spRegex != nullptr) {
+            const std::wregex& regex = *m_spRegex;
+            for (std::wstring& path : p_rvPaths) {
+                if (m_RequiredLiteral.empty() || FastRegex::MayContainLiteral(path, m_RequiredLiteral, m_IgnoreCase)) {
+                    try {
+                        path = std::regex_replace(path, regex, m_Format);
+                    } catch (const std::regex_error&) {
+                        // Leave path as-is, like ModifyPath.
+                    }
+                }
+            }
+        }
+    }
+
     //
     // Checks if a plugin using this pipeline element should be enabled or not.
     // In our case, we see if our regex is valid.
@@ -280,38 +571,318 @@ namespace PCC
     //
     bool RegexPipelineElement::ShouldBeEnabledFor(const std::wstring& /*p_ParentPath*/,
                                                   const std::wstring& /*p_File*/,
-                                                  const PluginProvider* const /*p_pPluginProvider*/) const
+                                                  const ConversionContext& /*p_Context*/) const
     {
         InitRegex();
-        return m_upRegex != nullptr;
+        return m_spFastRegex != nullptr || m_spRegex != nullptr;
     }
 
     //
-    // Initializes the m_apRegex member using the other members.
+    // Initializes the m_spRegex member using the other members.
     // Call this method before needing to access the regex object.
     //
-    // Note: m_apRegex will remain null if the regular expression is invalid.
+    // Note: m_spRegex will remain null if the regular expression is invalid.
+    // If we use the fast engine and it supports the regex, m_spFastRegex
+    // is set instead. Since pipelines can be shared between threads,
+    // this is thread-safe.
     //
     void RegexPipelineElement::InitRegex() const
     {
-        // Only init once.
-        if (!m_RegexTested) {
-            // Try creating regex. Keep null if the regex is invalid.
-            try {
-                if (!m_Regex.empty()) {
-                    std::regex_constants::syntax_option_type reOptions = std::regex_constants::ECMAScript;
-                    if (m_IgnoreCase) {
-                        reOptions |= std::regex_constants::icase;
-                    }
-                    m_upRegex = std::make_unique<std::wregex>(m_Regex, reOptions);
-                }
-            } catch (const std::regex_error&) {
-                assert(m_upRegex == nullptr);
+        // Only init once. The compiled regex is shared with other elements using the same one.
+        std::call_once(m_RegexInit, [this]() {
+            if (m_Engine == Engine::Fast) {
+                m_spFastRegex = RegexCache::GetFastRegex(m_Regex, m_IgnoreCase);
+            }
+            if (m_spFastRegex == nullptr) {
+                m_spRegex = RegexCache::GetRegex(m_Regex, m_IgnoreCase);
+            }
+        });
+    }
+
+    //
+    // Constructor.
+    //
+    // @param p_Source Source of the mapping table.
+    // @param p_Table Table contents if p_Source is PrefixMap::Source::Inline;
+    //                otherwise, path of the file or name of the registry
+    //                value containing the table.
+    // @param p_IgnoreCase Whether to ignore case when looking for prefixes.
+    //
+    PrefixMappingPipelineElement::PrefixMappingPipelineElement(const PrefixMap::Source p_Source,
+                                                               const std::wstring& p_Table,
+                                                               const bool p_IgnoreCase)
+        : PipelineElement(),
+          m_Source(p_Source),
+          m_Table(p_Table),
+          m_IgnoreCase(p_IgnoreCase),
+          m_spPrefixMap(),
+          m_PrefixMapInit()
+    {
+    }
+
+    //
+    // Modifies the given path by replacing its longest prefix found
+    // in our mapping table.
+    //
+    // @param p_rPath Path to modify (in-place).
+    // @param p_Context Context of the conversion, used to access plugins.
+    //
+    void PrefixMappingPipelineElement::ModifyPath(std::wstring& p_rPath,
+                                                  const ConversionContext& /*p_Context*/) const
+    {
+        // If table could not be loaded, leave path as-is.
+        InitPrefixMap();
+        if (m_spPrefixMap != nullptr) {
+            m_spPrefixMap->Apply(p_rPath);
+        }
+    }
+
+    //
+    // Modifies a batch of paths by replacing their longest prefix found in
+    // our mapping table. The table is looked up only once for the entire batch.
+    //
+    // @param p_rvPaths Paths to modify (in-place).
+    // @param p_Context Context of the conversion, used to access plugins.
+    //
+    void PrefixMappingPipelineElement::ModifyPaths(WStringV& p_rvPaths,
+                                                   const ConversionContext& /*p_Context*/) const
+    {
+        InitPrefixMap();
+        if (m_spPrefixMap != nullptr) {
+            const PrefixMap& prefixMap = *m_spPrefixMap;
+            for (std::wstring& path : p_rvPaths) {
+                prefixMap.Apply(path);
+            }
+        }
+    }
+
+    //
+    // Initializes the m_spPrefixMap member using the other members.
+    // Call this method before needing to access the table. Tables not
+    // stored inline are shared with other elements using them.
+    //
+    // Note: m_spPrefixMap will remain null if the table could not be loaded.
+    //
+    void PrefixMappingPipelineElement::InitPrefixMap() const
+    {
+        // Load table only once, even across threads.
+        std::call_once(m_PrefixMapInit, [this]() {
+            m_spPrefixMap = PrefixMap::GetPrefixMap(m_Source, m_Table, m_IgnoreCase);
+        });
+    }
+
+    //
+    // Constructor.
+    //
+    EnvironmentVariablesPipelineElement::EnvironmentVariablesPipelineElement()
+        : PipelineElement()
+    {
+    }
+
+    //
+    // Modifies the given path by replacing its beginning with the
+    // environment variable containing it, if any.
+    //
+    // @param p_rPath Path to modify (in-place).
+    // @param p_Context Context of the conversion, used to access plugins.
+    //
+    void EnvironmentVariablesPipelineElement::ModifyPath(std::wstring& p_rPath,
+                                                         const ConversionContext& /*p_Context*/) const
+    {
+        ReplaceVariable(p_rPath, *EnvironmentVariablesCache::GetReversePrefixMap());
+    }
+
+    //
+    // Modifies a batch of paths by replacing their beginning with the
+    // environment variable containing it, if any. The table of variables
+    // is fetched only once for the entire batch.
+    //
+    // @param p_rvPaths Paths to modify (in-place).
+    // @param p_Context Context of the conversion, used to access plugins.
+    //
+    void EnvironmentVariablesPipelineElement::ModifyPaths(WStringV& p_rvPaths,
+                                                          const ConversionContext& /*p_Context*/) const
+    {
+        const PrefixMap::PrefixMapSP spPrefixMap = EnvironmentVariablesCache::GetReversePrefixMap();
+        for (std::wstring& path : p_rvPaths) {
+            ReplaceVariable(path, *spPrefixMap);
+        }
+    }
+
+    //
+    // Replaces the beginning of a path using the table of environment variables.
+    //
+    // @param p_rPath Path to modify (in-place).
+    // @param p_PrefixMap Table returned by EnvironmentVariablesCache::GetReversePrefixMap.
+    //
+    void EnvironmentVariablesPipelineElement::ReplaceVariable(std::wstring& p_rPath,
+                                                              const PrefixMap& p_PrefixMap)
+    {
+        // Prefixes in the table end with a backslash and so do their replacements,
+        // so the one we append also matches a path that is exactly a variable's value.
+        p_rPath.push_back(L'\\');
+        p_PrefixMap.Apply(p_rPath);
+        p_rPath.pop_back();
+    }
+
+    //
+    // Constructor.
+    //
+    ContentHashPipelineElement::ContentHashPipelineElement()
+        : PipelineElement()
+    {
+    }
+
+    //
+    // Modifies the given path by prepending the hash of the file's content.
+    //
+    // @param p_rPath Path to modify (in-place).
+    // @param p_Context Context of the conversion, used to access plugins.
+    //
+    void ContentHashPipelineElement::ModifyPath(std::wstring& p_rPath,
+                                                const ConversionContext& p_Context) const
+    {
+        WStringV vPaths(1, p_rPath);
+        ModifyPaths(vPaths, p_Context);
+        p_rPath.swap(vPaths.front());
+    }
+
+    //
+    // Modifies all paths of a selection by prepending the hashes of the
+    // files' contents. Files are hashed in parallel, with progress shown
+    // if they are large (see FileHasher).
+    //
+    // @param p_rvPaths Paths to modify (in-place).
+    // @param p_Context Context of the conversion, used to access plugins.
+    // @throw FileHashingCancelledException If the user cancelled hashing.
+    //
+    void ContentHashPipelineElement::ModifyPaths(WStringV& p_rvPaths,
+                                                 const ConversionContext& /*p_Context*/) const
+    {
+        WStringV vHashes;
+        FileHasher::HashFiles(p_rvPaths, vHashes);
+        for (size_t i = 0; i < p_rvPaths.size(); ++i) {
+            if (!vHashes[i].empty()) {
+                p_rvPaths[i].insert(0, vHashes[i] + L"  ");
             }
-            m_RegexTested = true;
         }
     }
 
+    //
+    // Returns the class of cost of the work performed by this pipeline element.
+    // We need to read the entire content of files.
+    //
+    // @param p_Context Context in which the element is used, used to access plugins.
+    // @return PluginCost::FileSystem.
+    //
+    PluginCost ContentHashPipelineElement::CostClass(const ConversionContext& /*p_Context*/) const
+    {
+        return PluginCost::FileSystem;
+    }
+
+    //
+    // Constructor.
+    //
+    // @param p_Form Normalization form to convert paths to.
+    //
+    UnicodeNormalizationPipelineElement::UnicodeNormalizationPipelineElement(const NormalizationForm p_Form)
+        : PipelineElement(),
+          m_Form(p_Form)
+    {
+    }
+
+    //
+    // Modifies the given path by converting it to our normalization form.
+    // If normalization is not available, the path is left unchanged.
+    //
+    // @param p_rPath Path to modify (in-place).
+    // @param p_Context Context of the conversion, used to access plugins.
+    //
+    void UnicodeNormalizationPipelineElement::ModifyPath(std::wstring& p_rPath,
+                                                         const ConversionContext& /*p_Context*/) const
+    {
+        UnicodeNormalizer::Normalize(p_rPath, m_Form);
+    }
+
+    //
+    // Constructor.
+    //
+    // @param p_Value Value to look for in paths.
+    // @param p_Match How to look for p_Value in paths.
+    // @param p_IgnoreCase Whether to ignore case when looking for p_Value.
+    // @param p_Action What to do with paths that do not match.
+    //
+    GuardPipelineElement::GuardPipelineElement(const std::wstring& p_Value,
+                                               const Match p_Match,
+                                               const bool p_IgnoreCase,
+                                               const Action p_Action)
+        : PipelineElement(),
+          m_Value(p_Value),
+          m_Match(p_Match),
+          m_IgnoreCase(p_IgnoreCase),
+          m_Action(p_Action)
+    {
+    }
+
+    //
+    // Guards do not modify paths; they are checked by Pipeline
+    // before applying the elements that follow them.
+    //
+    // @param p_rPath Path to modify (in-place); unused.
+    // @param p_Context Context of the conversion; unused.
+    //
+    void GuardPipelineElement::ModifyPath(std::wstring& /*p_rPath*/,
+                                          const ConversionContext& /*p_Context*/) const
+    {
+    }
+
+    //
+    // Guards do not modify paths. Overridden so that batches
+    // are not scanned for nothing.
+    //
+    // @param p_rvPaths Paths to modify (in-place); unused.
+    // @param p_Context Context of the conversion; unused.
+    //
+    void GuardPipelineElement::ModifyPaths(WStringV& /*p_rvPaths*/,
+                                           const ConversionContext& /*p_Context*/) const
+    {
+    }
+
+    //
+    // Checks if the given path passes the guard and should go
+    // through the rest of the pipeline.
+    //
+    // @param p_Path Path to check.
+    // @return true if path matches our value.
+    //
+    bool GuardPipelineElement::Passes(const std::wstring& p_Path) const
+    {
+        bool passes;
+        if (m_Match == Match::Prefix) {
+            passes = p_Path.size() >= m_Value.size() &&
+                     (m_IgnoreCase ? ::_wcsnicmp(p_Path.c_str(), m_Value.c_str(), m_Value.size()) == 0
+                                   : p_Path.compare(0, m_Value.size(), m_Value) == 0);
+        } else if (!m_IgnoreCase) {
+            passes = p_Path.find(m_Value) != std::wstring::npos;
+        } else {
+            passes = std::search(p_Path.cbegin(), p_Path.cend(), m_Value.cbegin(), m_Value.cend(),
+                                 [](const wchar_t p_Left, const wchar_t p_Right) {
+                                     return ::towlower(p_Left) == ::towlower(p_Right);
+                                 }) != p_Path.cend();
+        }
+        return passes;
+    }
+
+    //
+    // Returns what to do with paths that do not pass the guard.
+    //
+    // @return Action for failed paths.
+    //
+    GuardPipelineElement::Action GuardPipelineElement::GetAction() const
+    {
+        return m_Action;
+    }
+
     //
     // Constructor.
     //
@@ -328,19 +899,13 @@ namespace PCC
     // to apply and call its GetPath method on our path.
     //
     // @param p_rPath Path to modify (in-place).
-    // @param p_pPluginProvider Optional object to access plugins.
+    // @param p_Context Context of the conversion, used to access plugins.
     //
     void ApplyPluginPipelineElement::ModifyPath(std::wstring& p_rPath,
-                                                const PluginProvider* const p_pPluginProvider) const
+                                                const ConversionContext& p_Context) const
     {
-        if (p_pPluginProvider != nullptr) {
-            // Try finding the plugin we need.
-            PluginSP spPlugin = p_pPluginProvider->GetPlugin(m_PluginId);
-            if (spPlugin != nullptr) {
-                // Success, call the plugin's GetPath method.
-                p_rPath = spPlugin->GetPath(p_rPath);
-            }
-        }
+        // Ask the plugin provider to apply the plugin we need, if it exists.
+        p_Context.GetPathWithPlugin(m_PluginId, p_rPath);
     }
 
     //
@@ -349,25 +914,232 @@ namespace PCC
     //
     // @param p_ParentPath Path of the parent folder for the file to check.
     // @param p_File Path of file to use for the check.
-    // @param p_pPluginProvider Optional object to access plugins.
+    // @param p_Context Context of the conversion, used to access plugins.
     // @return false if pipeline says plugin should be disabled for this path.
     //
     bool ApplyPluginPipelineElement::ShouldBeEnabledFor(const std::wstring& p_ParentPath,
                                                         const std::wstring& p_File,
-                                                        const PluginProvider* const p_pPluginProvider) const
+                                                        const ConversionContext& p_Context) const
     {
         bool enabled = false;
-        if (p_pPluginProvider != nullptr) {
+        if (p_Context.GetPluginProvider() != nullptr) {
             // Try finding the plugin we need.
-            PluginSP spPlugin = p_pPluginProvider->GetPlugin(m_PluginId);
+            PluginSP spPlugin = p_Context.GetPluginProvider()->GetPlugin(m_PluginId);
             if (spPlugin != nullptr) {
                 // Success, call the plugin's Enabled method.
-                enabled = spPlugin->Enabled(p_ParentPath, p_File);
+                enabled = spPlugin->Enabled(p_ParentPath, p_File, p_Context);
+            }
+        }
+        return enabled;
+    }
+
+    //
+    // Adds the ID of the plugin we apply to the given vector.
+    //
+    // @param p_rvPluginIds Where to add referenced plugin IDs.
+    //
+    void ApplyPluginPipelineElement::GetReferencedPlugins(GUIDV& p_rvPluginIds) const
+    {
+        p_rvPluginIds.push_back(m_PluginId);
+    }
+
+    //
+    // Returns the class of cost of the work performed by this pipeline element,
+    // which is the cost of the plugin we apply. If the plugin cannot be found
+    // (or is part of a reference cycle), we don't modify paths at all.
+    //
+    // @param p_Context Context in which the element is used, used to access plugins.
+    // @return Cost class of applied plugin.
+    //
+    PluginCost ApplyPluginPipelineElement::CostClass(const ConversionContext& p_Context) const
+    {
+        PluginCost cost = PluginCost::Pure;
+        if (p_Context.GetPluginProvider() != nullptr) {
+            PluginSP spPlugin = p_Context.GetPluginProvider()->GetPlugin(m_PluginId);
+            if (spPlugin != nullptr) {
+                cost = spPlugin->CostClass(p_Context);
+            }
+        }
+        return cost;
+    }
+
+    //
+    // Constructor. Compiles the template.
+    //
+    // @param p_Template Format template; see class description for syntax.
+    // @throws InvalidPipelineException if the template is invalid.
+    //
+    TemplatePipelineElement::TemplatePipelineElement(const std::wstring& p_Template)
+        : PipelineElement(),
+          m_vPluginIds(),
+          m_vParts(),
+          m_Suffix()
+    {
+        Compile(p_Template);
+    }
+
+    //
+    // Modifies the given path by formatting our template. Each referenced
+    // plugin is applied once to the path, then its output is used for all
+    // placeholders referencing it.
+    //
+    // @param p_rPath Path to modify (in-place).
+    // @param p_Context Context of the conversion, used to access plugins.
+    //
+    void TemplatePipelineElement::ModifyPath(std::wstring& p_rPath,
+                                             const ConversionContext& p_Context) const
+    {
+        // Apply all plugins first.
+        WStringV vPluginPaths(m_vPluginIds.size(), p_rPath);
+        for (size_t i = 0; i < m_vPluginIds.size(); ++i) {
+            p_Context.GetPathWithPlugin(m_vPluginIds[i], vPluginPaths[i]);
+        }
+
+        // Now format the template in a single buffer.
+        size_t length = m_Suffix.size();
+        for (const Part& part : m_vParts) {
+            length += part.m_Literal.size();
+            length += part.m_Placeholder != PATH_PLACEHOLDER ? vPluginPaths[part.m_Placeholder].size() : p_rPath.size();
+        }
+        std::wstring result;
+        result.reserve(length);
+        for (const Part& part : m_vParts) {
+            result += part.m_Literal;
+            result += part.m_Placeholder != PATH_PLACEHOLDER ? vPluginPaths[part.m_Placeholder] : p_rPath;
+        }
+        result += m_Suffix;
+        p_rPath = std::move(result);
+    }
+
+    //
+    // Checks if a plugin using this pipeline element should be enabled or not.
+    // In our case, all plugins referenced by our template must be enabled.
+    //
+    // @param p_ParentPath Path of the parent folder for the file to check.
+    // @param p_File Path of file to use for the check.
+    // @param p_Context Context of the conversion, used to access plugins.
+    // @return false if pipeline says plugin should be disabled for this path.
+    //
+    bool TemplatePipelineElement::ShouldBeEnabledFor(const std::wstring& p_ParentPath,
+                                                     const std::wstring& p_File,
+                                                     const ConversionContext& p_Context) const
+    {
+        bool enabled = true;
+        if (!m_vPluginIds.empty()) {
+            enabled = p_Context.GetPluginProvider() != nullptr;
+            for (auto it = m_vPluginIds.cbegin(); enabled && it != m_vPluginIds.cend(); ++it) {
+                PluginSP spPlugin = p_Context.GetPluginProvider()->GetPlugin(*it);
+                enabled = spPlugin != nullptr && spPlugin->Enabled(p_ParentPath, p_File, p_Context);
             }
         }
         return enabled;
     }
 
+    //
+    // Adds the IDs of the plugins referenced by our template to the given vector.
+    //
+    // @param p_rvPluginIds Where to add referenced plugin IDs.
+    //
+    void TemplatePipelineElement::GetReferencedPlugins(GUIDV& p_rvPluginIds) const
+    {
+        p_rvPluginIds.insert(p_rvPluginIds.end(), m_vPluginIds.cbegin(), m_vPluginIds.cend());
+    }
+
+    //
+    // Returns the class of cost of the work performed by this pipeline element,
+    // which is the cost of the most expensive plugin referenced by our template.
+    //
+    // @param p_Context Context in which the element is used, used to access plugins.
+    // @return Cost class of referenced plugins.
+    //
+    PluginCost TemplatePipelineElement::CostClass(const ConversionContext& p_Context) const
+    {
+        PluginCost cost = PluginCost::Pure;
+        if (p_Context.GetPluginProvider() != nullptr) {
+            for (const GUID& pluginId : m_vPluginIds) {
+                PluginSP spPlugin = p_Context.GetPluginProvider()->GetPlugin(pluginId);
+                if (spPlugin != nullptr) {
+                    cost = (std::max)(cost, spPlugin->CostClass(p_Context));
+                }
+            }
+        }
+        return cost;
+    }
+
+    //
+    // Compiles the given template into a list of parts, each made of literal
+    // text followed by a placeholder. Plugins referenced more than once are
+    // only stored once in m_vPluginIds.
+    //
+    // @param p_Template Format template to compile.
+    // @throws InvalidPipelineException if a placeholder is invalid or unterminated.
+    //
+    void TemplatePipelineElement::Compile(const std::wstring& p_Template)
+    {
+        static const std::wstring PATH_PLACEHOLDER_NAME(L"path");
+        static const std::wstring PLUGIN_PLACEHOLDER_PREFIX(L"plugin:");
+
+        std::wstring literal;
+        for (size_t i = 0; i < p_Template.size(); ++i) {
+            const wchar_t c = p_Template[i];
+            if ((c == L'{' || c == L'}') && i + 1 < p_Template.size() && p_Template[i + 1] == c) {
+                // Escaped brace.
+                literal += c;
+                ++i;
+            } else if (c == L'{') {
+                // Placeholder. Plugin IDs can be specified with or without their own braces.
+                const size_t idStart = i + 1 + PLUGIN_PLACEHOLDER_PREFIX.size();
+                size_t end = std::wstring::npos;
+                if (p_Template.compare(i + 1, PLUGIN_PLACEHOLDER_PREFIX.size(), PLUGIN_PLACEHOLDER_PREFIX) == 0 &&
+                    idStart < p_Template.size() && p_Template[idStart] == L'{') {
+
+                    end = p_Template.find(L'}', idStart);
+                    if (end != std::wstring::npos) {
+                        end = (end + 1 < p_Template.size() && p_Template[end + 1] == L'}') ? end + 1 : std::wstring::npos;
+                    }
+                } else {
+                    end = p_Template.find(L'}', i + 1);
+                }
+                if (end == std::wstring::npos) {
+                    throw InvalidPipelineException();
+                }
+                const std::wstring name = p_Template.substr(i + 1, end - i - 1);
+
+                Part part;
+                part.m_Literal = std::move(literal);
+                literal.clear();
+                if (name == PATH_PLACEHOLDER_NAME) {
+                    part.m_Placeholder = PATH_PLACEHOLDER;
+                } else if (name.compare(0, PLUGIN_PLACEHOLDER_PREFIX.size(), PLUGIN_PLACEHOLDER_PREFIX) == 0) {
+                    std::wstring guidString = name.substr(PLUGIN_PLACEHOLDER_PREFIX.size());
+                    if (guidString.empty() || guidString.front() != L'{') {
+                        guidString = L"{" + guidString + L"}";
+                    }
+                    GUID pluginId;
+                    if (guidString.size() != GUIDSTRING_MAX - 1 || FAILED(::CLSIDFromString(guidString.c_str(), &pluginId))) {
+                        throw InvalidPipelineException();
+                    }
+
+                    // Reuse the plugin's index if it's already referenced.
+                    auto idIt = std::find_if(m_vPluginIds.cbegin(), m_vPluginIds.cend(), [&](const GUID& p_Id) {
+                        return ::IsEqualGUID(p_Id, pluginId) != FALSE;
+                    });
+                    part.m_Placeholder = static_cast<size_t>(idIt - m_vPluginIds.cbegin());
+                    if (idIt == m_vPluginIds.cend()) {
+                        m_vPluginIds.push_back(pluginId);
+                    }
+                } else {
+                    throw InvalidPipelineException();
+                }
+                m_vParts.push_back(std::move(part));
+                i = end;
+            } else {
+                literal += c;
+            }
+        }
+        m_Suffix = std::move(literal);
+    }
+
     //
     // Constructor.
     //
@@ -383,10 +1155,10 @@ namespace PCC
     // Does not modify the path since this element only modifies pipeline options.
     //
     // @param p_rPath Path to modify (in-place).
-    // @param p_pPluginProvider Optional object to access plugins.
+    // @param p_Context Context of the conversion, used to access plugins.
     //
     void PathsSeparatorPipelineElement::ModifyPath(std::wstring& /*p_rPath*/,
-                                                   const PluginProvider* const /*p_pPluginProvider*/) const
+                                                   const ConversionContext& /*p_Context*/) const
     {
     }
 
@@ -416,10 +1188,10 @@ namespace PCC
     // Does not modify the path since this element only modifies pipeline options.
     //
     // @param p_rPath Path to modify (in-place).
-    // @param p_pPluginProvider Optional object to access plugins.
+    // @param p_Context Context of the conversion, used to access plugins.
     //
     void ExecutablePipelineElement::ModifyPath(std::wstring& /*p_rPath*/,
-                                               const PluginProvider* const /*p_pPluginProvider*/) const
+                                               const ConversionContext& /*p_Context*/) const
     {
     }
 
@@ -438,16 +1210,22 @@ namespace PCC
     // Constructor.
     //
     // @param p_Executable Path to executable to launch.
-    //
-    ExecutableWithFilelistPipelineElement::ExecutableWithFilelistPipelineElement(const std::wstring& p_Executable)
-        : ExecutablePipelineElement(p_Executable)
+    // @param p_FilelistEncoding Encoding to use for the filelist.
+    // @param p_FilelistDelivery How to deliver the filelist to the executable.
+    //
+    ExecutableWithFilelistPipelineElement::ExecutableWithFilelistPipelineElement(const std::wstring& p_Executable,
+                                                                                 const FilelistEncoding p_FilelistEncoding /*= FilelistEncoding::Ansi*/,
+                                                                                 const FilelistDelivery p_FilelistDelivery /*= FilelistDelivery::TempFile*/)
+        : ExecutablePipelineElement(p_Executable),
+          m_FilelistEncoding(p_FilelistEncoding),
+          m_FilelistDelivery(p_FilelistDelivery)
     {
     }
 
     //
     // Modifies global pipeline options by specifying the path of the
     // executable to launch, as well as specifying to launch it with
-    // filelist instead of paths directly.
+    // filelist instead of paths directly, and how to encode and deliver it.
     //
     // @param p_rOptions Global options to modify (in-place).
     //
@@ -455,6 +1233,206 @@ namespace PCC
     {
         ExecutablePipelineElement::ModifyOptions(p_rOptions);
         p_rOptions.SetUseFilelist(true);
+        p_rOptions.SetFilelistEncoding(m_FilelistEncoding);
+        p_rOptions.SetFilelistDelivery(m_FilelistDelivery);
+    }
+
+    //
+    // Constructor.
+    //
+    CopyMultipleFormatsPipelineElement::CopyMultipleFormatsPipelineElement()
+        : PipelineElement()
+    {
+    }
+
+    //
+    // Does not modify the path since this element only modifies pipeline options.
+    //
+    // @param p_rPath Path to modify (in-place).
+    // @param p_Context Context of the conversion, used to access plugins.
+    //
+    void CopyMultipleFormatsPipelineElement::ModifyPath(std::wstring& /*p_rPath*/,
+                                                        const ConversionContext& /*p_Context*/) const
+    {
+    }
+
+    //
+    // Modifies global pipeline options by specifying to copy paths
+    // to the clipboard in multiple formats.
+    //
+    // @param p_rOptions Global options to modify (in-place).
+    //
+    void CopyMultipleFormatsPipelineElement::ModifyOptions(PipelineOptions& p_rOptions) const
+    {
+        p_rOptions.SetCopyMultipleFormats(true);
+    }
+
+    //
+    // Constructor.
+    //
+    MemoizePipelineElement::MemoizePipelineElement()
+        : PipelineElement()
+    {
+    }
+
+    //
+    // Does not modify the path since this element only modifies pipeline options.
+    //
+    // @param p_rPath Path to modify (in-place).
+    // @param p_Context Context of the conversion, used to access plugins.
+    //
+    void MemoizePipelineElement::ModifyPath(std::wstring& /*p_rPath*/,
+                                            const ConversionContext& /*p_Context*/) const
+    {
+    }
+
+    //
+    // Modifies global pipeline options by specifying to memoize paths.
+    //
+    // @param p_rOptions Global options to modify (in-place).
+    //
+    void MemoizePipelineElement::ModifyOptions(PipelineOptions& p_rOptions) const
+    {
+        p_rOptions.SetMemoizePaths(true);
+    }
+
+    //
+    // Constructor.
+    //
+    // @param p_MaxParallelBatches Max number of batches to run at once.
+    //
+    BatchExecutablePipelineElement::BatchExecutablePipelineElement(const size_t p_MaxParallelBatches)
+        : PipelineElement(),
+          m_MaxParallelBatches(p_MaxParallelBatches)
+    {
+    }
+
+    //
+    // Does not modify the path since this element only modifies pipeline options.
+    //
+    // @param p_rPath Path to modify (in-place).
+    // @param p_Context Context of the conversion, used to access plugins.
+    //
+    void BatchExecutablePipelineElement::ModifyPath(std::wstring& /*p_rPath*/,
+                                                    const ConversionContext& /*p_Context*/) const
+    {
+    }
+
+    //
+    // Modifies global pipeline options by specifying to split paths
+    // in batches when launching an executable.
+    //
+    // @param p_rOptions Global options to modify (in-place).
+    //
+    void BatchExecutablePipelineElement::ModifyOptions(PipelineOptions& p_rOptions) const
+    {
+        p_rOptions.SetMaxParallelBatches(m_MaxParallelBatches);
+    }
+
+    //
+    // Constructor.
+    //
+    // @param p_Endpoint Type of endpoint used to reach running instance.
+    // @param p_EndpointName Name of pipe or window class of running instance.
+    //
+    RunningInstancePipelineElement::RunningInstancePipelineElement(const InstanceEndpoint p_Endpoint,
+                                                                   const std::wstring& p_EndpointName)
+        : PipelineElement(),
+          m_Endpoint(p_Endpoint),
+          m_EndpointName(p_EndpointName)
+    {
+    }
+
+    //
+    // Does not modify the path since this element only modifies pipeline options.
+    //
+    // @param p_rPath Path to modify (in-place).
+    // @param p_Context Context of the conversion, used to access plugins.
+    //
+    void RunningInstancePipelineElement::ModifyPath(std::wstring& /*p_rPath*/,
+                                                    const ConversionContext& /*p_Context*/) const
+    {
+    }
+
+    //
+    // Modifies global pipeline options by specifying how to reach
+    // a running instance of the executable to launch.
+    //
+    // @param p_rOptions Global options to modify (in-place).
+    //
+    void RunningInstancePipelineElement::ModifyOptions(PipelineOptions& p_rOptions) const
+    {
+        p_rOptions.SetInstanceEndpoint(m_Endpoint, m_EndpointName);
+    }
+
+    //
+    // Constructor.
+    //
+    // @param p_OutputFile Path of file to write paths to. Use an empty
+    //                     string to let the user choose one.
+    // @param p_Encoding Encoding of output file.
+    //
+    OutputFilePipelineElement::OutputFilePipelineElement(const std::wstring& p_OutputFile,
+                                                         const OutputEncoding p_Encoding)
+        : PipelineElement(),
+          m_OutputFile(p_OutputFile),
+          m_Encoding(p_Encoding)
+    {
+    }
+
+    //
+    // Does not modify the path since this element only modifies pipeline options.
+    //
+    // @param p_rPath Path to modify (in-place).
+    // @param p_Context Context of the conversion, used to access plugins.
+    //
+    void OutputFilePipelineElement::ModifyPath(std::wstring& /*p_rPath*/,
+                                               const ConversionContext& /*p_Context*/) const
+    {
+    }
+
+    //
+    // Modifies global pipeline options by specifying to write
+    // paths to a file instead of copying them to the clipboard.
+    //
+    // @param p_rOptions Global options to modify (in-place).
+    //
+    void OutputFilePipelineElement::ModifyOptions(PipelineOptions& p_rOptions) const
+    {
+        p_rOptions.SetOutputFile(m_OutputFile, m_Encoding);
+    }
+
+    //
+    // Constructor.
+    //
+    // @param p_Format Format of exported records.
+    //
+    ExportMetadataPipelineElement::ExportMetadataPipelineElement(const ExportFormat p_Format)
+        : PipelineElement(),
+          m_Format(p_Format)
+    {
+    }
+
+    //
+    // Does not modify the path since this element only modifies pipeline options.
+    //
+    // @param p_rPath Path to modify (in-place).
+    // @param p_Context Context of the conversion, used to access plugins.
+    //
+    void ExportMetadataPipelineElement::ModifyPath(std::wstring& /*p_rPath*/,
+                                                   const ConversionContext& /*p_Context*/) const
+    {
+    }
+
+    //
+    // Modifies global pipeline options by specifying to export
+    // paths along with the metadata of their files.
+    //
+    // @param p_rOptions Global options to modify (in-place).
+    //
+    void ExportMetadataPipelineElement::ModifyOptions(PipelineOptions& p_rOptions) const
+    {
+        p_rOptions.SetExportFormat(m_Format);
     }
 
 } // namespace PCC
@@ -0,0 +1,212 @@
+// PluginPipelineOptimizer.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <stdafx.h>
+#include <PluginPipelineOptimizer.h>
+#include <PluginPipelineElements.h>
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include <assert.h>
+
+
+namespace
+{
+    //
+    // Checks if a pipeline element replaces a single character with
+    // another one and returns the characters if so.
+    //
+    // @param p_spElement Element to check.
+    // @param p_rOldChar Where to store the character replaced.
+    // @param p_rNewChar Where to store the replacement character.
+    // @return true if p_spElement is a character-mapping element.
+    //
+    bool GetCharMapping(const PCC::PipelineElementSP& p_spElement,
+                        wchar_t& p_rOldChar,
+                        wchar_t& p_rNewChar)
+    {
+        bool isCharMapping = true;
+        if (std::dynamic_pointer_cast<PCC::BackToForwardSlashesPipelineElement>(p_spElement) != nullptr) {
+            p_rOldChar = L'\\';
+            p_rNewChar = L'/';
+        } else if (std::dynamic_pointer_cast<PCC::ForwardToBackslashesPipelineElement>(p_spElement) != nullptr) {
+            p_rOldChar = L'/';
+            p_rNewChar = L'\\';
+        } else {
+            auto spFindReplace = std::dynamic_pointer_cast<PCC::FindReplacePipelineElement>(p_spElement);
+            isCharMapping = spFindReplace != nullptr &&
+                            !spFindReplace->GetIgnoreCase() &&
+                            spFindReplace->GetOldValue().size() == 1 &&
+                            spFindReplace->GetNewValue().size() == 1;
+            if (isCharMapping) {
+                p_rOldChar = spFindReplace->GetOldValue().front();
+                p_rNewChar = spFindReplace->GetNewValue().front();
+            }
+        }
+        return isCharMapping;
+    }
+
+    //
+    // Checks if two strings have at least one character in common.
+    //
+    // @param p_First First string.
+    // @param p_Second Second string.
+    // @return true if strings share at least one character.
+    //
+    bool ShareChars(const std::wstring& p_First,
+                    const std::wstring& p_Second)
+    {
+        return p_First.find_first_of(p_Second) != std::wstring::npos;
+    }
+
+} // anonymous namespace
+
+namespace PCC
+{
+    //
+    // Optimizes a decoded pipeline by fusing adjacent elements when possible.
+    //
+    // @param p_rvspElements Pipeline elements. Will be modified in-place.
+    //
+    void PipelineOptimizer::OptimizePipeline(PipelineElementSPV& p_rvspElements)
+    {
+        PipelineElementSPV vspOptimized;
+        vspOptimized.reserve(p_rvspElements.size());
+        PipelineElementSPV vspPendingCharMaps;
+        PipelineElementSPV vspPendingFindReplaces;
+        for (const PipelineElementSP& spElement : p_rvspElements) {
+            wchar_t oldChar = 0, newChar = 0;
+            auto spFindReplace = std::dynamic_pointer_cast<FindReplacePipelineElement>(spElement);
+            if (spFindReplace != nullptr && spFindReplace->GetOldValue().empty()) {
+                // This element does nothing, skip it.
+            } else if (GetCharMapping(spElement, oldChar, newChar)) {
+                FlushFindReplaces(vspPendingFindReplaces, vspOptimized);
+                vspPendingCharMaps.push_back(spElement);
+            } else if (spFindReplace != nullptr && !spFindReplace->GetIgnoreCase()) {
+                FlushCharMaps(vspPendingCharMaps, vspOptimized);
+                if (!CanFuseFindReplace(vspPendingFindReplaces, spElement)) {
+                    FlushFindReplaces(vspPendingFindReplaces, vspOptimized);
+                }
+                vspPendingFindReplaces.push_back(spElement);
+            } else {
+                FlushCharMaps(vspPendingCharMaps, vspOptimized);
+                FlushFindReplaces(vspPendingFindReplaces, vspOptimized);
+                vspOptimized.push_back(spElement);
+            }
+        }
+        FlushCharMaps(vspPendingCharMaps, vspOptimized);
+        FlushFindReplaces(vspPendingFindReplaces, vspOptimized);
+
+        p_rvspElements = std::move(vspOptimized);
+    }
+
+    //
+    // Adds pending character-mapping elements to a pipeline, fusing them
+    // into a single CharMapPipelineElement if there are more than one.
+    //
+    // @param p_rvspPending Pending character-mapping elements. Will be
+    //                      cleared upon return.
+    // @param p_rvspElements Pipeline elements where to add the elements.
+    //
+    void PipelineOptimizer::FlushCharMaps(PipelineElementSPV& p_rvspPending,
+                                          PipelineElementSPV& p_rvspElements)
+    {
+        if (p_rvspPending.size() == 1) {
+            p_rvspElements.push_back(p_rvspPending.front());
+        } else if (!p_rvspPending.empty()) {
+            // Compose all mappings: each one is applied to the result of the previous ones.
+            CharMapPipelineElement::CharM mCharMap;
+            for (const PipelineElementSP& spElement : p_rvspPending) {
+                wchar_t oldChar = 0, newChar = 0;
+                const bool isCharMapping = GetCharMapping(spElement, oldChar, newChar);
+                assert(isCharMapping);
+                (void) isCharMapping;
+                for (auto& charPair : mCharMap) {
+                    if (charPair.second == oldChar) {
+                        charPair.second = newChar;
+                    }
+                }
+                mCharMap.emplace(oldChar, newChar);
+            }
+            p_rvspElements.push_back(std::make_shared<CharMapPipelineElement>(mCharMap));
+        }
+        p_rvspPending.clear();
+    }
+
+    //
+    // Adds pending find/replace elements to a pipeline, fusing them into
+    // a single MultiFindReplacePipelineElement if there are more than one.
+    //
+    // @param p_rvspPending Pending find/replace elements. Will be cleared upon return.
+    // @param p_rvspElements Pipeline elements where to add the elements.
+    //
+    void PipelineOptimizer::FlushFindReplaces(PipelineElementSPV& p_rvspPending,
+                                              PipelineElementSPV& p_rvspElements)
+    {
+        if (p_rvspPending.size() == 1) {
+            p_rvspElements.push_back(p_rvspPending.front());
+        } else if (!p_rvspPending.empty()) {
+            MultiFindReplacePipelineElement::FindReplacePairV vFindReplaces;
+            vFindReplaces.reserve(p_rvspPending.size());
+            for (const PipelineElementSP& spElement : p_rvspPending) {
+                auto spFindReplace = std::dynamic_pointer_cast<FindReplacePipelineElement>(spElement);
+                assert(spFindReplace != nullptr);
+                vFindReplaces.emplace_back(spFindReplace->GetOldValue(), spFindReplace->GetNewValue());
+            }
+            p_rvspElements.push_back(std::make_shared<MultiFindReplacePipelineElement>(vFindReplaces));
+        }
+        p_rvspPending.clear();
+    }
+
+    //
+    // Checks if a find/replace element can be fused with pending ones
+    // without changing the pipeline's semantics. Replacing successively is
+    // equivalent to replacing all values in a single pass if the new value
+    // to find does not share characters with any previous value to find
+    // or replacement value (so it cannot match text produced by previous
+    // elements, nor overlap their matches) and if previous replacement
+    // values are not empty (so removing text cannot create new matches).
+    //
+    // @param p_vspPending Pending find/replace elements.
+    // @param p_spElement Find/replace element to check.
+    // @return true if p_spElement can be fused with elements in p_vspPending.
+    //
+    bool PipelineOptimizer::CanFuseFindReplace(const PipelineElementSPV& p_vspPending,
+                                               const PipelineElementSP& p_spElement)
+    {
+        auto spFindReplace = std::dynamic_pointer_cast<FindReplacePipelineElement>(p_spElement);
+        assert(spFindReplace != nullptr);
+        const std::wstring& oldValue = spFindReplace->GetOldValue();
+        return std::all_of(p_vspPending.cbegin(), p_vspPending.cend(), [&](const PipelineElementSP& spPending) {
+            auto spPendingFindReplace = std::dynamic_pointer_cast<FindReplacePipelineElement>(spPending);
+            assert(spPendingFindReplace != nullptr);
+            return !spPendingFindReplace->GetNewValue().empty() &&
+                   !ShareChars(oldValue, spPendingFindReplace->GetOldValue()) &&
+                   !ShareChars(oldValue, spPendingFindReplace->GetNewValue());
+        });
+    }
+
+} // namespace PCC
@@ -21,6 +21,7 @@
 
 #include <stdafx.h>
 #include <PluginProvider.h>
+#include <Plugin.h>
 
 
 namespace PCC
@@ -32,4 +33,24 @@ namespace PCC
     {
     }
 
+    //
+    // Applies a specific plugin to a path. The default implementation
+    // looks for the plugin using GetPlugin and calls its GetPath method.
+    //
+    // @param p_PluginId ID of plugin to apply.
+    // @param p_rPath Path to modify (in-place).
+    // @param p_Context Context in which to apply the plugin.
+    // @return true if the plugin was found and applied.
+    //
+    bool PluginProvider::GetPathWithPlugin(const GUID& p_PluginId,
+                                           std::wstring& p_rPath,
+                                           const ConversionContext& p_Context) const
+    {
+        PluginSP spPlugin = GetPlugin(p_PluginId);
+        if (spPlugin != nullptr) {
+            p_rPath = spPlugin->GetPath(p_rPath, p_Context);
+        }
+        return spPlugin != nullptr;
+    }
+
 } // namespace PCC
@@ -54,9 +54,10 @@ namespace PCC
     // Placeholder description method that returns an empty string
     // since it is never called.
     //
+    // @param p_Context Context in which the plugin is used; unused.
     // @return Empty string.
     //
-    std::wstring PluginSeparator::Description() const
+    std::wstring PluginSeparator::Description(const ConversionContext& /*p_Context*/) const
     {
         return L"";
     }
@@ -65,9 +66,11 @@ namespace PCC
     // Placeholder path method that does nothing since it is never called.
     //
     // @param p_File File path; unused.
+    // @param p_Context Context of the conversion; unused.
     // @return Empty string.
     //
-    std::wstring PluginSeparator::GetPath(const std::wstring& /*p_File*/) const
+    std::wstring PluginSeparator::GetPath(const std::wstring& /*p_File*/,
+                                          const ConversionContext& /*p_Context*/) const
     {
         return L"";
     }
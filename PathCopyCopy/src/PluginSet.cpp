@@ -0,0 +1,171 @@
+// PluginSet.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <stdafx.h>
+#include <PluginSet.h>
+#include <Plugin.h>
+
+#include <algorithm>
+
+
+namespace PCC
+{
+    //
+    // Default constructor. Creates an empty set.
+    //
+    PluginSet::PluginSet()
+        : m_vspPlugins()
+    {
+    }
+
+    //
+    // Returns an iterator to the first plugin in the set.
+    //
+    // @return Iterator to first plugin.
+    //
+    PluginSet::const_iterator PluginSet::begin() const
+    {
+        return m_vspPlugins.cbegin();
+    }
+
+    //
+    // Returns an iterator past the last plugin in the set.
+    //
+    // @return End iterator.
+    //
+    PluginSet::const_iterator PluginSet::end() const
+    {
+        return m_vspPlugins.cend();
+    }
+
+    //
+    // Returns an iterator to the first plugin in the set.
+    //
+    // @return Iterator to first plugin.
+    //
+    PluginSet::const_iterator PluginSet::cbegin() const
+    {
+        return m_vspPlugins.cbegin();
+    }
+
+    //
+    // Returns an iterator past the last plugin in the set.
+    //
+    // @return End iterator.
+    //
+    PluginSet::const_iterator PluginSet::cend() const
+    {
+        return m_vspPlugins.cend();
+    }
+
+    //
+    // Returns the number of plugins in the set.
+    //
+    // @return Number of plugins.
+    //
+    size_t PluginSet::size() const
+    {
+        return m_vspPlugins.size();
+    }
+
+    //
+    // Checks if the set is empty.
+    //
+    // @return true if there are no plugins in the set.
+    //
+    bool PluginSet::empty() const
+    {
+        return m_vspPlugins.empty();
+    }
+
+    //
+    // Finds a plugin in the set by ID.
+    //
+    // @param p_PluginId ID of plugin to look for.
+    // @return Iterator to plugin, or end() if not found.
+    //
+    PluginSet::const_iterator PluginSet::find(const GUID& p_PluginId) const
+    {
+        auto it = std::lower_bound(m_vspPlugins.cbegin(), m_vspPlugins.cend(), p_PluginId,
+                                   [](const PluginSP& p_spPlugin, const GUID& p_Id) {
+                                       return p_spPlugin < p_Id;
+                                   });
+        return it != m_vspPlugins.cend() && !(p_PluginId < *it) ? it : m_vspPlugins.cend();
+    }
+
+    //
+    // Finds a plugin in the set with the same ID as another plugin.
+    //
+    // @param p_spPlugin Plugin whose ID to look for.
+    // @return Iterator to plugin, or end() if not found.
+    //
+    PluginSet::const_iterator PluginSet::find(const PluginSP& p_spPlugin) const
+    {
+        return find(p_spPlugin->Id());
+    }
+
+    //
+    // Inserts a plugin in the set, unless a plugin with the same ID is already in the set.
+    //
+    // @param p_spPlugin Plugin to insert.
+    // @return Pair containing an iterator to the plugin in the set with the plugin's ID
+    //         and a flag indicating if the plugin was inserted.
+    //
+    std::pair<PluginSet::const_iterator, bool> PluginSet::insert(const PluginSP& p_spPlugin)
+    {
+        auto it = std::lower_bound(m_vspPlugins.begin(), m_vspPlugins.end(), p_spPlugin,
+                                   [](const PluginSP& p_spPlugin1, const PluginSP& p_spPlugin2) {
+                                       return p_spPlugin1 < p_spPlugin2;
+                                   });
+        if (it != m_vspPlugins.end() && !(p_spPlugin < *it)) {
+            return std::make_pair(const_iterator(it), false);
+        }
+        return std::make_pair(const_iterator(m_vspPlugins.insert(it, p_spPlugin)), true);
+    }
+
+    //
+    // Removes all plugins from the set.
+    //
+    void PluginSet::clear()
+    {
+        m_vspPlugins.clear();
+    }
+
+    //
+    // Sorts plugins by ID and removes duplicates. Sorting is stable, so when
+    // plugins have the same ID, the first one (e.g. the one that was already
+    // in the set) is kept.
+    //
+    void PluginSet::Normalize()
+    {
+        auto less = [](const PluginSP& p_spPlugin1, const PluginSP& p_spPlugin2) {
+            return p_spPlugin1 < p_spPlugin2;
+        };
+        std::stable_sort(m_vspPlugins.begin(), m_vspPlugins.end(), less);
+        m_vspPlugins.erase(std::unique(m_vspPlugins.begin(), m_vspPlugins.end(),
+                                       [&](const PluginSP& p_spPlugin1, const PluginSP& p_spPlugin2) {
+                                           return !less(p_spPlugin1, p_spPlugin2) && !less(p_spPlugin2, p_spPlugin1);
+                                       }),
+                           m_vspPlugins.end());
+    }
+
+} // namespace PCC
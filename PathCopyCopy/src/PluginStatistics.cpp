@@ -0,0 +1,289 @@
+// PluginStatistics.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+
+#include <stdafx.h>
+#include <PluginStatistics.h>
+#include <PluginUtils.h>
+#include <ThreadPool.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+
+
+namespace
+{
+    // Statistics are stored outside of our settings key, since changes to that key
+    // are watched and invalidate all cached settings (see RegistryWatcher).
+    const wchar_t* const    PCC_STATISTICS_KEY      = L"Software\\clechasseur\\PathCopyCopyCache\\Statistics";
+
+    // Prefix of the name of the mutex serializing saves of statistics between
+    // processes. Created in the session namespace and per-user.
+    const wchar_t* const    SAVE_MUTEX_NAME_PREFIX  = L"Local\\PathCopyCopy.Statistics.";
+
+    // Time to wait for another process to finish saving its statistics, in milliseconds.
+    const DWORD             SAVE_MUTEX_TIMEOUT_MS   = 5000;
+
+    const wchar_t* const    ENABLED_PREFIX          = L"Enabled";   // Prefix of values storing statistics of calls to Enabled.
+    const wchar_t* const    GET_PATH_PREFIX         = L"GetPath";   // Prefix of values storing statistics of calls to GetPath.
+
+    const wchar_t* const    COUNT_SUFFIX            = L"Count";     // Suffix of value storing number of calls.
+    const wchar_t* const    FAILURES_SUFFIX         = L"Failures";  // Suffix of value storing number of failed calls.
+    const wchar_t* const    DURATIONS_SUFFIX        = L"Durations"; // Suffix of value storing durations of last calls, as an array of 32-bit microseconds.
+
+    const wchar_t* const    PATH_CACHE_HITS_VALUE   = L"PathCacheHits";     // Value storing number of paths found in the path cache.
+    const wchar_t* const    PATH_CACHE_MISSES_VALUE = L"PathCacheMisses";   // Value storing number of paths not found in the path cache.
+
+    const wchar_t* const    MENU_COUNT_VALUE        = L"MenuCount";                 // Value storing number of contextual menus built.
+    const wchar_t* const    MENU_BUDGET_EXCEEDED_COUNT_VALUE
+                                                    = L"MenuBudgetExceededCount";   // Value storing number of menus that exceeded their time budget.
+
+} // anonymous namespace
+
+namespace PCC
+{
+    // Static members of PluginStatistics
+    const size_t                    PluginStatistics::MAX_SAMPLES = 64;
+    PluginStatistics::StatisticsM   PluginStatistics::s_mStatistics;
+    DWORD                           PluginStatistics::s_MenuCount = 0;
+    DWORD                           PluginStatistics::s_MenuBudgetExceededCount = 0;
+    std::mutex                      PluginStatistics::s_Lock;
+
+    //
+    // Records the duration of a plugin operation. Statistics are kept in memory
+    // until Save is called. Can be called from any thread; never throws.
+    //
+    // @param p_PluginId ID of plugin that performed the operation.
+    // @param p_Operation Operation performed.
+    // @param p_Duration Duration of the operation.
+    // @param p_Count Number of items processed by the operation.
+    // @param p_Failed Whether the operation failed.
+    //
+    void PluginStatistics::Record(const GUID& p_PluginId,
+                                  const Operation p_Operation,
+                                  const std::chrono::microseconds p_Duration,
+                                  const size_t p_Count,
+                                  const bool p_Failed)
+    {
+        try {
+            const size_t count = (std::max<size_t>)(p_Count, 1);
+            const uint32_t duration = static_cast<uint32_t>((std::min<long long>)(p_Duration.count() / count, UINT32_MAX));
+
+            std::lock_guard<std::mutex> lock(s_Lock);
+            Statistics& rStatistics = s_mStatistics[p_PluginId];
+            OperationStatistics& rOperation = p_Operation == Operation::Enabled ? rStatistics.m_Enabled : rStatistics.m_GetPath;
+            rOperation.m_Count += static_cast<DWORD>(count);
+            if (p_Failed) {
+                ++rOperation.m_Failures;
+            }
+            if (rOperation.m_vDurations.size() >= MAX_SAMPLES) {
+                rOperation.m_vDurations.erase(rOperation.m_vDurations.begin());
+            }
+            rOperation.m_vDurations.push_back(duration);
+        } catch (...) {
+            // Statistics are not worth failing for.
+        }
+    }
+
+    //
+    // Records lookups of a plugin's paths in the PathResultCache. Can be
+    // called from any thread; never throws.
+    //
+    // @param p_PluginId ID of plugin whose paths were looked up.
+    // @param p_Hits Number of paths found in the cache.
+    // @param p_Misses Number of paths not found in the cache.
+    //
+    void PluginStatistics::RecordPathCacheLookups(const GUID& p_PluginId,
+                                                  const size_t p_Hits,
+                                                  const size_t p_Misses)
+    {
+        try {
+            std::lock_guard<std::mutex> lock(s_Lock);
+            Statistics& rStatistics = s_mStatistics[p_PluginId];
+            rStatistics.m_PathCacheHits += static_cast<DWORD>(p_Hits);
+            rStatistics.m_PathCacheMisses += static_cast<DWORD>(p_Misses);
+        } catch (...) {
+            // Statistics are not worth failing for.
+        }
+    }
+
+    //
+    // Records that a contextual menu has been built. Can be called from
+    // any thread; never throws.
+    //
+    // @param p_BudgetExceeded Whether building the menu exceeded its time budget.
+    //
+    void PluginStatistics::RecordMenu(const bool p_BudgetExceeded)
+    {
+        try {
+            std::lock_guard<std::mutex> lock(s_Lock);
+            ++s_MenuCount;
+            if (p_BudgetExceeded) {
+                ++s_MenuBudgetExceededCount;
+            }
+        } catch (...) {
+            // Statistics are not worth failing for.
+        }
+    }
+
+    //
+    // Merges statistics recorded since the last call into the registry. The
+    // registry is updated by a low-priority task of the ThreadPool so that the
+    // caller, usually the shell's UI thread, does not wait for it.
+    // Never throws; statistics that cannot be saved are lost.
+    //
+    void PluginStatistics::Save()
+    {
+        try {
+            auto spPending = std::make_shared<PendingStatistics>();
+            {
+                std::lock_guard<std::mutex> lock(s_Lock);
+                spPending->m_mStatistics.swap(s_mStatistics);
+                std::swap(spPending->m_MenuCount, s_MenuCount);
+                std::swap(spPending->m_MenuBudgetExceededCount, s_MenuBudgetExceededCount);
+            }
+            if (!spPending->m_mStatistics.empty() || spPending->m_MenuCount != 0) {
+                ThreadPool::Submit([spPending]() {
+                    SaveToRegistry(*spPending);
+                }, ThreadPool::Priority::Low);
+            }
+        } catch (...) {
+            // Statistics are not worth failing for.
+        }
+    }
+
+    //
+    // Merges statistics in the registry. Since merging reads saved values
+    // before updating them, other processes saving their own statistics at
+    // the same time are kept out using a per-user named mutex.
+    // Never throws; statistics that cannot be saved are lost.
+    //
+    // @param p_Pending Statistics to merge.
+    //
+    void PluginStatistics::SaveToRegistry(const PendingStatistics& p_Pending)
+    {
+        try {
+            const std::wstring userSid = PluginUtils::GetCurrentUserSid();
+            if (userSid.empty()) {
+                return;
+            }
+            const std::wstring mutexName = SAVE_MUTEX_NAME_PREFIX + userSid;
+            ATL::CHandle hMutex(::CreateMutexW(nullptr, FALSE, mutexName.c_str()));
+            if (hMutex == NULL) {
+                return;
+            }
+            const DWORD waitRes = ::WaitForSingleObject(hMutex, SAVE_MUTEX_TIMEOUT_MS);
+            if (waitRes != WAIT_OBJECT_0 && waitRes != WAIT_ABANDONED) {
+                return;
+            }
+
+            try {
+                ATL::CRegKey statisticsKey;
+                if (statisticsKey.Create(HKEY_CURRENT_USER, PCC_STATISTICS_KEY) == ERROR_SUCCESS) {
+                    SaveCounter(statisticsKey, MENU_COUNT_VALUE, p_Pending.m_MenuCount);
+                    SaveCounter(statisticsKey, MENU_BUDGET_EXCEEDED_COUNT_VALUE, p_Pending.m_MenuBudgetExceededCount);
+                    for (const auto& statisticsPair : p_Pending.m_mStatistics) {
+                        wchar_t pluginIdString[40];
+                        ATL::CRegKey pluginKey;
+                        if (::StringFromGUID2(statisticsPair.first, pluginIdString, sizeof(pluginIdString) / sizeof(wchar_t)) != 0 &&
+                            pluginKey.Create(statisticsKey, pluginIdString) == ERROR_SUCCESS) {
+
+                            SaveOperation(pluginKey, ENABLED_PREFIX, statisticsPair.second.m_Enabled);
+                            SaveOperation(pluginKey, GET_PATH_PREFIX, statisticsPair.second.m_GetPath);
+                            SaveCounter(pluginKey, PATH_CACHE_HITS_VALUE, statisticsPair.second.m_PathCacheHits);
+                            SaveCounter(pluginKey, PATH_CACHE_MISSES_VALUE, statisticsPair.second.m_PathCacheMisses);
+                        }
+                    }
+                }
+            } catch (...) {
+                // Make sure we release the mutex below.
+            }
+            ::ReleaseMutex(hMutex);
+        } catch (...) {
+            // Statistics are not worth failing for.
+        }
+    }
+
+    //
+    // Merges statistics of one plugin operation into the registry.
+    //
+    // @param p_rKey Registry key of the plugin.
+    // @param p_pPrefix Prefix of values storing the operation's statistics.
+    // @param p_Statistics Statistics to merge.
+    //
+    void PluginStatistics::SaveOperation(ATL::CRegKey& p_rKey,
+                                         const wchar_t* const p_pPrefix,
+                                         const OperationStatistics& p_Statistics)
+    {
+        if (p_Statistics.m_Count != 0) {
+            const std::wstring countName = std::wstring(p_pPrefix) + COUNT_SUFFIX;
+            const std::wstring failuresName = std::wstring(p_pPrefix) + FAILURES_SUFFIX;
+            const std::wstring durationsName = std::wstring(p_pPrefix) + DURATIONS_SUFFIX;
+
+            DWORD count = 0, failures = 0;
+            p_rKey.QueryDWORDValue(countName.c_str(), count);
+            p_rKey.QueryDWORDValue(failuresName.c_str(), failures);
+
+            // Append our durations to the saved ones, keeping only the last ones.
+            UInt32V vDurations(MAX_SAMPLES);
+            ULONG durationsSize = static_cast<ULONG>(vDurations.size() * sizeof(uint32_t));
+            if (p_rKey.QueryBinaryValue(durationsName.c_str(), vDurations.data(), &durationsSize) == ERROR_SUCCESS) {
+                vDurations.resize(durationsSize / sizeof(uint32_t));
+            } else {
+                vDurations.clear();
+            }
+            vDurations.insert(vDurations.end(), p_Statistics.m_vDurations.cbegin(), p_Statistics.m_vDurations.cend());
+            if (vDurations.size() > MAX_SAMPLES) {
+                vDurations.erase(vDurations.begin(), vDurations.end() - MAX_SAMPLES);
+            }
+
+            p_rKey.SetDWORDValue(countName.c_str(), count + p_Statistics.m_Count);
+            p_rKey.SetDWORDValue(failuresName.c_str(), failures + p_Statistics.m_Failures);
+            p_rKey.SetBinaryValue(durationsName.c_str(), vDurations.data(),
+                                  static_cast<ULONG>(vDurations.size() * sizeof(uint32_t)));
+        }
+    }
+
+    //
+    // Adds a count to a counter stored in the registry. Counters like path
+    // cache lookups grow by one per path converted and are never reset, so
+    // they are capped to INT32_MAX, the largest value the settings app can read.
+    //
+    // @param p_rKey Registry key storing the counter.
+    // @param p_pName Name of value storing the counter.
+    // @param p_Count Count to add.
+    //
+    void PluginStatistics::SaveCounter(ATL::CRegKey& p_rKey,
+                                       const wchar_t* const p_pName,
+                                       const DWORD p_Count)
+    {
+        if (p_Count != 0) {
+            DWORD savedCount = 0;
+            p_rKey.QueryDWORDValue(p_pName, savedCount);
+            const ULONGLONG newCount = static_cast<ULONGLONG>(savedCount) + p_Count;
+            p_rKey.SetDWORDValue(p_pName, static_cast<DWORD>((std::min<ULONGLONG>)(newCount, INT32_MAX)));
+        }
+    }
+
+} // namespace PCC
@@ -21,32 +21,196 @@
 
 #include <stdafx.h>
 #include <PluginUtils.h>
+#include <DriveConnectivityCache.h>
+#include <FileMetadataCache.h>
+#include <NetworkEnvironment.h>
+#include <PathResultCache.h>
 #include <PathCopyCopyPluginsRegistry.h>
+#include <Plugin.h>
 #include <PathCopyCopySettings.h>
+#include <PerformanceCounters.h>
+#include <PluginStatistics.h>
+#include <ShortNameSupportCache.h>
 #include <StringUtils.h>
+#include <Trace.h>
 
 #include <DefaultPlugin.h>
 
+#include <algorithm>
+#include <cwctype>
+#include <exception>
+#include <iterator>
 #include <memory>
 #include <sstream>
+#include <thread>
+#include <vector>
 
-#include <comutil.h>
 #include <lm.h>
+#include <sddl.h>
 
 
 namespace
 {
-    const DWORD         INITIAL_BUFFER_SIZE     = 1024;     // Initial size of buffer used to fetch UNC name.
-    const DWORD         MAX_REG_KEY_NAME_SIZE   = 255;      // Max size of a registry key's name.
+    const DWORD         MAPPED_DRIVE_CACHE_TTL_MS = 30 * 1000;  // Time during which network paths of mapped drives are cached, in milliseconds.
 
-    const std::wstring  SHARES_KEY_NAME     = L"SYSTEM\\CurrentControlSet\\Services\\Lanmanserver\\Shares"; // Name of key storing network shares
-    const std::wstring  SHARE_PATH_VALUE    = L"Path=";     // Part of a share key's value containing the share path.
-    const wchar_t       HIDDEN_SHARE_SUFFIX = L'$';         // Suffix used for hidden shares; we will not consider them unless specified.
+    const ULONG         REG_BUFFER_CHUNK_SIZE = 512;        // Size of chunks allocated to read the registry.
+    const DWORD         TEXT_READ_CHUNK_SIZE  = 64 * 1024;  // Size of chunks used when reading text from a file.
 
-    const std::wstring  HIDDEN_DRIVE_SHARES_REGEX   = L"^([A-Za-z])\\:((\\\\|/).*)$";   // Regex used to convert hidden drive shares.
-    const std::wstring  HIDDEN_DRIVE_SHARES_FORMAT  = L"$1$$$2";                        // Format string used to convert hidden drive shares.
+    const size_t        MIN_FILES_PER_THREAD            = 128;  // Minimum number of files converted by each thread when converting in parallel.
+    const size_t        MIN_PURE_FILES_PER_THREAD       = 2048; // Same, for plugins only manipulating strings, for which threads are costly in comparison.
+    const size_t        MIN_NETWORK_FILES_PER_THREAD    = 16;   // Same, for plugins querying the network, which mostly wait on it.
+    const size_t        MAX_CONVERSION_THREADS          = 8;    // Maximum number of threads used to convert files in parallel.
+    const size_t        CHUNK_ALIGNMENT_DIVISOR         = 4;    // Chunk boundaries can move by up to chunk size / this to fall between directories.
 
-    const ULONG         REG_BUFFER_CHUNK_SIZE = 512;        // Size of chunks allocated to read the registry.
+    const wchar_t       EXTENDED_LENGTH_PREFIX[]        = L"\\\\?\\";     // Prefix of extended-length paths, which can exceed MAX_PATH.
+    const wchar_t       EXTENDED_LENGTH_UNC_PREFIX[]    = L"\\\\?\\UNC\\";  // Prefix of extended-length UNC paths.
+    const wchar_t       UNC_PREFIX[]                    = L"\\\\";          // Prefix of UNC paths.
+
+    // Signature of Win32 functions converting a path, like GetShortPathNameW.
+    typedef DWORD (WINAPI *PathConversionFunc)(LPCWSTR, LPWSTR, DWORD);
+
+    //
+    // Checks if two files are in the same parent directory. Directories
+    // are compared without case, like the file system does.
+    //
+    // @param p_File1 Path of first file.
+    // @param p_File2 Path of second file.
+    // @return true if both files have the same parent directory.
+    //
+    bool HaveSameParent(const std::wstring& p_File1,
+                        const std::wstring& p_File2)
+    {
+        const std::wstring::size_type lastSep1 = p_File1.rfind(L'\\');
+        const std::wstring::size_type lastSep2 = p_File2.rfind(L'\\');
+        return lastSep1 == lastSep2 &&
+               (lastSep1 == std::wstring::npos || ::_wcsnicmp(p_File1.c_str(), p_File2.c_str(), lastSep1) == 0);
+    }
+
+    //
+    // Parses a GUID stored in its canonical registry format, e.g.
+    // {01234567-89AB-CDEF-0123-456789ABCDEF}. This is much faster than
+    // CLSIDFromString, which also supports ProgIDs and thus needs to
+    // check the registry for anything it can't parse.
+    //
+    // @param p_pBegin Pointer to the beginning of the string.
+    // @param p_pEnd Pointer past the end of the string.
+    // @param p_rGUID Where to store the parsed GUID.
+    // @return true if string contained a GUID in canonical format.
+    //
+    bool ParseCanonicalGUID(const wchar_t* const p_pBegin,
+                            const wchar_t* const p_pEnd,
+                            GUID& p_rGUID)
+    {
+        if (p_pEnd - p_pBegin != 38 || p_pBegin[0] != L'{' || p_pBegin[37] != L'}' ||
+            p_pBegin[9] != L'-' || p_pBegin[14] != L'-' || p_pBegin[19] != L'-' || p_pBegin[24] != L'-') {
+
+            return false;
+        }
+
+        // Parses p_Count hex digits starting at offset p_Offset.
+        bool valid = true;
+        auto parseHex = [&](const size_t p_Offset, const size_t p_Count) -> ULONG {
+            ULONG value = 0;
+            for (size_t i = p_Offset; i < p_Offset + p_Count; ++i) {
+                const wchar_t c = p_pBegin[i];
+                ULONG digit = 0;
+                if (c >= L'0' && c <= L'9') {
+                    digit = static_cast<ULONG>(c - L'0');
+                } else if (c >= L'a' && c <= L'f') {
+                    digit = static_cast<ULONG>(c - L'a' + 10);
+                } else if (c >= L'A' && c <= L'F') {
+                    digit = static_cast<ULONG>(c - L'A' + 10);
+                } else {
+                    valid = false;
+                }
+                value = (value << 4) | digit;
+            }
+            return value;
+        };
+
+        GUID guid = { 0 };
+        guid.Data1 = parseHex(1, 8);
+        guid.Data2 = static_cast<USHORT>(parseHex(10, 4));
+        guid.Data3 = static_cast<USHORT>(parseHex(15, 4));
+        guid.Data4[0] = static_cast<BYTE>(parseHex(20, 2));
+        guid.Data4[1] = static_cast<BYTE>(parseHex(22, 2));
+        for (size_t i = 0; i < 6; ++i) {
+            guid.Data4[2 + i] = static_cast<BYTE>(parseHex(25 + i * 2, 2));
+        }
+        if (valid) {
+            p_rGUID = guid;
+        }
+        return valid;
+    }
+
+    //
+    // Converts a path using a Win32 function like GetShortPathNameW, allocating
+    // a larger buffer if needed. Absolute paths exceeding MAX_PATH are converted
+    // to extended-length paths first so that the function accepts them; the
+    // prefix is removed from the result.
+    //
+    // Most conversions only need to copy the result once, in the storage
+    // already owned by p_rConvertedPath if it is large enough.
+    //
+    // @param p_pFunc Function used to convert the path.
+    // @param p_Path Path to convert.
+    // @param p_rConvertedPath Where to store the converted path. Untouched
+    //                         if the method returns false.
+    // @return true if path was converted, false otherwise.
+    //
+    bool ConvertPath(PathConversionFunc const p_pFunc,
+                     const std::wstring& p_Path,
+                     std::wstring& p_rConvertedPath)
+    {
+        // Add extended-length prefix if needed. Such paths are not normalized, so use backslashes only.
+        // Other paths are passed as-is, without copying them.
+        std::wstring extendedPath;
+        bool extended = false;
+        if (p_Path.size() >= MAX_PATH && p_Path.compare(0, StringUtils::LiteralLength(EXTENDED_LENGTH_PREFIX), EXTENDED_LENGTH_PREFIX) != 0) {
+            const bool isUNC = p_Path.compare(0, StringUtils::LiteralLength(UNC_PREFIX), UNC_PREFIX) == 0;
+            const bool isAbsolute = p_Path.size() >= 3 && p_Path[1] == L':' && (p_Path[2] == L'\\' || p_Path[2] == L'/');
+            if (isUNC || isAbsolute) {
+                extendedPath = p_Path;
+                std::replace(extendedPath.begin(), extendedPath.end(), L'/', L'\\');
+                if (isUNC) {
+                    extendedPath.replace(0, StringUtils::LiteralLength(UNC_PREFIX), EXTENDED_LENGTH_UNC_PREFIX);
+                } else {
+                    extendedPath.insert(0, EXTENDED_LENGTH_PREFIX);
+                }
+                extended = true;
+            }
+        }
+        const wchar_t* const pPath = extended ? extendedPath.c_str() : p_Path.c_str();
+
+        // Try with a buffer on the stack first since most paths are short.
+        // If it's too small, the function returns the required size.
+        wchar_t buffer[MAX_PATH + 1];
+        DWORD copied = p_pFunc(pPath, buffer, sizeof(buffer) / sizeof(wchar_t));
+        if (copied != 0 && copied < sizeof(buffer) / sizeof(wchar_t)) {
+            p_rConvertedPath.assign(buffer, copied);
+        } else if (copied != 0) {
+            const DWORD requiredSize = copied;
+            std::wstring convertedPath(requiredSize, L'\0');
+            copied = p_pFunc(pPath, &*convertedPath.begin(), requiredSize);
+            if (copied == 0 || copied >= requiredSize) {
+                return false;
+            }
+            convertedPath.resize(copied);
+            p_rConvertedPath.swap(convertedPath);
+        } else {
+            return false;
+        }
+
+        // Remove any prefix we added.
+        if (extended) {
+            if (p_rConvertedPath.compare(0, StringUtils::LiteralLength(EXTENDED_LENGTH_UNC_PREFIX), EXTENDED_LENGTH_UNC_PREFIX) == 0) {
+                p_rConvertedPath.replace(0, StringUtils::LiteralLength(EXTENDED_LENGTH_UNC_PREFIX), UNC_PREFIX);
+            } else if (p_rConvertedPath.compare(0, StringUtils::LiteralLength(EXTENDED_LENGTH_PREFIX), EXTENDED_LENGTH_PREFIX) == 0) {
+                p_rConvertedPath.erase(0, StringUtils::LiteralLength(EXTENDED_LENGTH_PREFIX));
+            }
+        }
+        return true;
+    }
 
 } // anonymous namespace
 
@@ -56,17 +220,33 @@ namespace PCC
     std::mutex      PluginUtils::s_Lock;
     std::wstring    PluginUtils::s_ComputerName;
     bool            PluginUtils::s_HasComputerName = false;
-    std::wregex     PluginUtils::s_HiddenDriveShareRegex(HIDDEN_DRIVE_SHARES_REGEX, std::regex_constants::ECMAScript);
+    ShareIndexSP    PluginUtils::s_spShareIndex;
+    std::mutex      PluginUtils::s_ShareIndexLock;
+    std::mutex      PluginUtils::s_DrivesLock;
+    PluginUtils::DriveUNCRootM
+                    PluginUtils::s_mDriveUNCRoots;
+    DWORD           PluginUtils::s_LogicalDrives = 0;
 
     //
     // Determines if the given path points to a directory or file.
+    // Uses the given FileMetadataCache, if any. Paths on unreachable
+    // drives are considered files (see DriveConnectivityCache).
     //
     // @param p_Path Path to check.
+    // @param p_pMetadataCache Optional cache of file metadata of the current operation.
     // @return true if path points to a directory.
     //
-    bool PluginUtils::IsDirectory(const std::wstring& p_Path)
+    bool PluginUtils::IsDirectory(const std::wstring& p_Path,
+                                  FileMetadataCache* const p_pMetadataCache)
     {
-        DWORD attribs = ::GetFileAttributesW(p_Path.c_str());
+        if (!DriveConnectivityCache::IsReachable(p_Path)) {
+            return false;
+        }
+
+        DWORD attribs = INVALID_FILE_ATTRIBUTES;
+        if (p_pMetadataCache == nullptr || !p_pMetadataCache->GetAttributes(p_Path, attribs)) {
+            attribs = ::GetFileAttributesW(p_Path.c_str());
+        }
         return attribs != INVALID_FILE_ATTRIBUTES &&
                (attribs & FILE_ATTRIBUTE_DIRECTORY) == FILE_ATTRIBUTE_DIRECTORY;
     }
@@ -97,6 +277,74 @@ namespace PCC
         return found;
     }
 
+    //
+    // Returns the short version of a path (using 8.3 names). Paths
+    // exceeding MAX_PATH are supported. Uses the given FileMetadataCache, if any.
+    // Paths on unreachable drives (see DriveConnectivityCache) or on volumes
+    // without short names (see ShortNameSupportCache) are not converted.
+    //
+    // @param p_Path Path to convert.
+    // @param p_pMetadataCache Optional cache of file metadata of the current operation.
+    // @return Short path, or p_Path if it could not be converted.
+    //
+    std::wstring PluginUtils::GetShortPath(const std::wstring& p_Path,
+                                           FileMetadataCache* const p_pMetadataCache)
+    {
+        std::wstring path(p_Path);
+        if (!DriveConnectivityCache::IsReachable(p_Path) || !ShortNameSupportCache::MayHaveShortNames(p_Path)) {
+            return path;
+        }
+        if ((p_pMetadataCache != nullptr && p_pMetadataCache->GetShortPath(p_Path, path)) ||
+            ConvertPath(&::GetShortPathNameW, p_Path, path)) {
+
+            ShortNameSupportCache::RecordConversion(p_Path, path);
+        }
+        return path;
+    }
+
+    //
+    // Returns the long version of a path (without 8.3 names). Paths
+    // exceeding MAX_PATH are supported. Uses the given FileMetadataCache, if any.
+    // Paths on unreachable drives are not converted (see DriveConnectivityCache).
+    //
+    // @param p_Path Path to convert.
+    // @param p_pMetadataCache Optional cache of file metadata of the current operation.
+    // @return Long path, or p_Path if it could not be converted.
+    //
+    std::wstring PluginUtils::GetLongPath(const std::wstring& p_Path,
+                                          FileMetadataCache* const p_pMetadataCache)
+    {
+        std::wstring path(p_Path);
+        if (!DriveConnectivityCache::IsReachable(p_Path)) {
+            return path;
+        }
+        if (p_pMetadataCache == nullptr || !p_pMetadataCache->GetLongPath(p_Path, path)) {
+            ConvertPath(&::GetLongPathNameW, p_Path, path);
+        }
+        return path;
+    }
+
+    //
+    // Returns the path of a file stored in an HDROP, as returned by
+    // DragQueryFileW. Paths exceeding MAX_PATH are supported.
+    //
+    // @param p_hDrop Handle to the dropped files structure.
+    // @param p_Index Index of the file to fetch.
+    // @return Path of file, or an empty string if it could not be fetched.
+    //
+    std::wstring PluginUtils::GetDroppedFile(HDROP const p_hDrop,
+                                             const UINT p_Index)
+    {
+        std::wstring file;
+        const UINT size = ::DragQueryFileW(p_hDrop, p_Index, nullptr, 0);
+        if (size != 0) {
+            file.resize(size + 1);
+            const UINT copied = ::DragQueryFileW(p_hDrop, p_Index, &*file.begin(), size + 1);
+            file.resize(copied);
+        }
+        return file;
+    }
+
     //
     // Checks if the given path is a UNC path in the form
     // \\server\share[\...]
@@ -114,28 +362,25 @@ namespace PCC
     // If it does, returns its corresponding network path.
     // Ex: N:\Data\File.txt -> \\server\share\Data\File.txt
     //
+    // The network path of each drive is cached (see GetMappedDriveUNCRoot).
+    //
     // @param p_rFilePath Local file path. Upon exit, will contain network path.
     // @return true if the file was on a mapped network drive and we fetched its network path.
     //
     bool PluginUtils::GetMappedDriveFilePath(std::wstring& p_rFilePath)
     {
-        // WNetGetUniversalName allows us to get the network path
-        // if file is on a mapped drive.
         bool converted = false;
-        DWORD bufferSize = INITIAL_BUFFER_SIZE;
-        std::unique_ptr<char[]> upBuffer;
-        DWORD ret = ERROR_MORE_DATA;
-        while (ret == ERROR_MORE_DATA) {
-            upBuffer.reset(new char[bufferSize]);
-            ret = ::WNetGetUniversalNameW(p_rFilePath.c_str(),
-                                          UNIVERSAL_NAME_INFO_LEVEL,
-                                          upBuffer.get(),
-                                          &bufferSize);
-        }
-        if (ret == NO_ERROR) {
-            // Got UNC path, return it.
-            p_rFilePath.assign(reinterpret_cast<UNIVERSAL_NAME_INFO*>(upBuffer.get())->lpUniversalName);
-            converted = true;
+        if (p_rFilePath.size() >= 3 && p_rFilePath[1] == L':' && (p_rFilePath[2] == L'\\' || p_rFilePath[2] == L'/') &&
+            std::iswalpha(p_rFilePath[0])) {
+
+            // Path starts with a drive letter: use the cached network path of the drive.
+            std::wstring uncRoot;
+            if (GetMappedDriveUNCRoot(p_rFilePath[0], uncRoot)) {
+                p_rFilePath = uncRoot + p_rFilePath.substr(2);
+                converted = true;
+            }
+        } else {
+            converted = GetUniversalName(p_rFilePath);
         }
         return converted;
     }
@@ -154,61 +399,25 @@ namespace PCC
     {
         bool converted = false;
 
-        // Scan registry to see if we can find a share that contains this path.
-        // Shares are stored in multi-string registry values in the Lanmanserver service keys.
-        ATL::CRegKey shareKey;
-        if (shareKey.Open(HKEY_LOCAL_MACHINE, SHARES_KEY_NAME.c_str(), KEY_READ) == ERROR_SUCCESS) {
-            // Iterate registry values to check each share.
-            wchar_t valueName[MAX_REG_KEY_NAME_SIZE + 1];
-            std::wstring multiStringValue;
-            std::wstring path;
-            LONG ret = 0;
-            DWORD i = 0;
-            do {
-                DWORD valueNameSize = MAX_REG_KEY_NAME_SIZE;
-                DWORD valueType = 0;
-                ret = ::RegEnumValue(shareKey, i, valueName, &valueNameSize, 0, &valueType, 0, 0);
-                if (ret == ERROR_SUCCESS && valueType == REG_MULTI_SZ) {
-                    // Get the multi-string values.
-                    ULONG bufferSize = INITIAL_BUFFER_SIZE;
-                    std::unique_ptr<wchar_t[]> buffer;
-                    do {
-                        buffer.reset(new wchar_t[bufferSize]);
-                        ret = shareKey.QueryMultiStringValue(valueName, buffer.get(), &bufferSize);
-                    } while (ret == ERROR_MORE_DATA);
-                    if (ret == ERROR_SUCCESS) {
-                        // Make sure this is not a hidden share (unless we use them).
-                        if (valueNameSize != 0 && (p_UseHiddenShares || valueName[valueNameSize - 1] != HIDDEN_SHARE_SUFFIX)) {
-                            // Find the "Path=" part of the mult-string. This contains the share path.
-                            multiStringValue.assign(buffer.get(), bufferSize);
-                            path = GetMultiStringLineBeginningWith(multiStringValue, SHARE_PATH_VALUE);
-                            if (!path.empty()) {
-                                // Check if our path is in that share.
-                                if (p_rFilePath.find(path) == 0) {
-                                    // Success: this is a share that contains our path.
-                                    // Replace the start of the path with the computer and share name.
-                                    std::wstringstream ss;
-                                    ss << L"\\\\" << GetLocalComputerName() << L"\\" << valueName;
-                                    if (*path.rbegin() == L'\\' || *path.rbegin() == L'/') {
-                                        // The substr below will remove the terminator if the share path
-                                        // ends with one (for example, for drives' administrative shares).
-                                        // We'll have to add an extra one manually.
-                                        ss << L'\\';
-                                    }
-                                    ss << p_rFilePath.substr(path.size());
-                                    std::wstring newPath = ss.str();
-                                    p_rFilePath = newPath;
-                                    converted = true;
-                                    break;
-                                }
-                            }
-                        }
-                    }
-                }
-
-                // Go to next share.
-                ++i;
-            } while (ret == ERROR_SUCCESS);
+        // Look for a share that contains this path in our index of network shares.
+        ShareIndexSP spShareIndex = GetShareIndex();
+        std::wstring path, shareName;
+        if (spShareIndex != nullptr && spShareIndex->FindShare(p_rFilePath, p_UseHiddenShares, path, shareName)) {
+            // Success: this is a share that contains our path.
+            // Replace the start of the path with the computer and share name.
+            const std::wstring& computerName = GetLocalComputerName();
+            std::wstring networkPath;
+            networkPath.reserve(3 + computerName.size() + shareName.size() + 1 + p_rFilePath.size() - path.size());
+            networkPath.append(L"\\\\").append(computerName).append(1, L'\\').append(shareName);
+            if (path.back() == L'\\' || path.back() == L'/') {
+                // Skipping the share path below will remove the terminator if the share path
+                // ends with one (for example, for drives' administrative shares).
+                // We'll have to add an extra one manually.
+                networkPath.push_back(L'\\');
+            }
+            networkPath.append(p_rFilePath, path.size(), std::wstring::npos);
+            p_rFilePath = std::move(networkPath);
+            converted = true;
         }
 
         return converted;
@@ -224,84 +433,114 @@ namespace PCC
     //
     bool PluginUtils::GetHiddenDriveShareFilePath(std::wstring& p_rFilePath)
     {
-        // Try to perform the replacement in one shot. If it works, the path is converted.
+        // Path must start with an ASCII drive letter followed by a colon and a separator.
+        // The drive letter followed by a '$' is the hidden drive share.
         bool converted = false;
+        const wchar_t drive = !p_rFilePath.empty() ? p_rFilePath[0] : L'\0';
+        if (p_rFilePath.size() >= 3 && ((drive >= L'A' && drive <= L'Z') || (drive >= L'a' && drive <= L'z')) &&
+            p_rFilePath[1] == L':' && (p_rFilePath[2] == L'\\' || p_rFilePath[2] == L'/')) {
 
-        try {
-            std::wstring replaced = std::regex_replace(p_rFilePath, s_HiddenDriveShareRegex, HIDDEN_DRIVE_SHARES_FORMAT);
-            if (!replaced.empty()) {
-                std::wstringstream ss;
-                ss << L"\\\\" << GetLocalComputerName() << L"\\" << replaced;
-                p_rFilePath = ss.str();
-                converted = true;
-            }
-        } catch (const std::regex_error&) {
-            // Didn't work.
+            const std::wstring& computerName = GetLocalComputerName();
+            std::wstring networkPath;
+            networkPath.reserve(2 + computerName.size() + 1 + p_rFilePath.size());
+            networkPath.append(L"\\\\").append(computerName).append(1, L'\\');
+            networkPath.append(1, drive).append(1, L'$').append(p_rFilePath, 2, std::wstring::npos);
+            p_rFilePath = std::move(networkPath);
+            converted = true;
         }
 
         return converted;
     }
 
     //
-    // Replaces the hostname in the given UNC path with a
-    // fully-qualified domain name (FQDN).
+    // Returns the name of the local computer.
     //
-    // @param p_rFilePath UNC path. Upon exit, host name will have been replaced.
+    // @return Name of local computer.
     //
-    void PluginUtils::ConvertUNCHostToFQDN(std::wstring& p_rFilePath)
+    const std::wstring& PluginUtils::GetLocalComputerName()
     {
-        // Find hostname in file path.
-        std::wstring hostname, restOfPath;
-        if (p_rFilePath.substr(0, 2) == L"\\\\") {
-            auto withoutPrefix = p_rFilePath.substr(2);
-            auto delimPos = withoutPrefix.find_first_of(L"\\/");
-            if (delimPos != std::wstring::npos) {
-                hostname = withoutPrefix.substr(0, delimPos);
-                restOfPath = withoutPrefix.substr(delimPos);
-            }
-        }
-        if (!hostname.empty()) {
-            // First initialize Winsock if it's not already initialized in the process.
-            WSADATA wsaData;
-            if (::WSAStartup(MAKEWORD(2, 2), &wsaData) == 0) {
-                // Try fetching info for the hostname
-                hostent* pHostEnt = gethostbyname(_bstr_t(hostname.c_str()));
-                if (pHostEnt != nullptr) {
-                    // Rebuild the path by replacing the hostname with its FQDN
-                    std::wstringstream wss;
-                    wss << L"\\\\"
-                        << _bstr_t(pHostEnt->h_name)
-                        << restOfPath;
-                    p_rFilePath = wss.str();
-                }
-
-                // Cleanup Winsock before returning.
-                ::WSACleanup();
+        if (!s_HasComputerName) {
+            std::lock_guard<std::mutex> lock(s_Lock);
+            if (!s_HasComputerName) {
+                std::wstring name = NetworkEnvironment::Current()->GetLocalComputerName();
+                std::transform(name.begin(), name.end(), name.begin(), std::towlower);
+                s_ComputerName = name;
+                s_HasComputerName = true;
             }
         }
+        return s_ComputerName;
     }
 
     //
-    // Returns the name of the local computer.
+    // Returns the string version of the current user's SID. Used to make
+    // sure objects shared between processes are never shared between users.
     //
-    // @return Name of local computer.
+    // @return User SID as a string, or an empty string if it cannot be determined.
     //
-    const std::wstring& PluginUtils::GetLocalComputerName()
+    std::wstring PluginUtils::GetCurrentUserSid()
     {
-        if (!s_HasComputerName) {
-            std::lock_guard<std::mutex> lock(s_Lock);
-            if (!s_HasComputerName) {
-                DWORD length = MAX_COMPUTERNAME_LENGTH + 1;
-                wchar_t name[MAX_COMPUTERNAME_LENGTH + 1];
-                if (::GetComputerNameW(name, &length) != FALSE) {
-                    if (::_wcslwr_s(name, length + 1) == 0) {
-                        s_ComputerName = name;
-                    }
+        return GetProcessUserSid(::GetCurrentProcess());
+    }
+
+    //
+    // Returns the string version of the SID of the user running a process.
+    //
+    // @param p_hProcess Handle to process. Must have the right to query
+    //                   limited information about the process.
+    // @return User SID as a string, or an empty string if it cannot be determined.
+    //
+    std::wstring PluginUtils::GetProcessUserSid(HANDLE p_hProcess)
+    {
+        std::wstring sidString;
+        HANDLE hToken = NULL;
+        if (::OpenProcessToken(p_hProcess, TOKEN_QUERY, &hToken)) {
+            ATL::CHandle token(hToken);
+            DWORD tokenInfoSize = 0;
+            ::GetTokenInformation(hToken, TokenUser, nullptr, 0, &tokenInfoSize);
+            if (tokenInfoSize != 0) {
+                std::unique_ptr<BYTE[]> upTokenInfo(new BYTE[tokenInfoSize]);
+                wchar_t* pSidString = nullptr;
+                if (::GetTokenInformation(hToken, TokenUser, upTokenInfo.get(), tokenInfoSize, &tokenInfoSize) &&
+                    ::ConvertSidToStringSidW(reinterpret_cast<TOKEN_USER*>(upTokenInfo.get())->User.Sid, &pSidString)) {
+
+                    sidString = pSidString;
+                    ::LocalFree(pSidString);
                 }
-                s_HasComputerName = true;
             }
         }
-        return s_ComputerName;
+        return sidString;
+    }
+
+    //
+    // Flushes network info cached by this class: the name of the local computer,
+    // the index of network shares and the network paths of mapped drives.
+    // Called when the NetworkEnvironment is replaced; must not be called while
+    // paths are being converted.
+    //
+    void PluginUtils::FlushNetworkCaches()
+    {
+        {
+            std::lock_guard<std::mutex> lock(s_Lock);
+            s_ComputerName.clear();
+            s_HasComputerName = false;
+        }
+        std::atomic_store(&s_spShareIndex, ShareIndexSP());
+        {
+            std::lock_guard<std::mutex> lock(s_DrivesLock);
+            s_mDriveUNCRoots.clear();
+            s_LogicalDrives = 0;
+        }
+    }
+
+    //
+    // Loads the network information cached for the lifetime of the process,
+    // like the local computer name and the index of network shares, so that
+    // the first conversions don't have to.
+    //
+    void PluginUtils::PrewarmNetworkCaches()
+    {
+        GetLocalComputerName();
+        GetShareIndex();
     }
 
     //
@@ -344,6 +583,97 @@ namespace PCC
         return lRes;
     }
 
+    //
+    // Reads the content of a binary registry value containing characters
+    // and returns it in a std::wstring. Unlike string values, binary values
+    // can contain any character, including nulls. Will take care of
+    // reallocating buffers as needed.
+    //
+    // @param p_Key Key containing the value to read.
+    // @param p_pValueName Name of value.
+    // @param p_rValue Upon exit, will contain the value.
+    // @return Error code, or ERROR_SUCCESS if all goes well.
+    //
+    long PluginUtils::ReadRegistryBinaryStringValue(const RegKey& p_Key,
+                                                    const wchar_t* const p_pValueName,
+                                                    std::wstring& p_rValue)
+    {
+        // Clear the content to assume value doesn't exist.
+        p_rValue.clear();
+
+        // Loop until we are able to read the value.
+        long lRes = ERROR_MORE_DATA;
+        ULONG curSize = 0;
+        while (lRes == ERROR_MORE_DATA) {
+            curSize += REG_BUFFER_CHUNK_SIZE;
+            std::unique_ptr<wchar_t[]> upBuffer(new wchar_t[curSize]);
+            DWORD valueType = REG_BINARY;
+            DWORD curSizeInBytes = curSize * sizeof(wchar_t);
+            lRes = p_Key.QueryValue(p_pValueName, &valueType, upBuffer.get(), &curSizeInBytes);
+            if (lRes == ERROR_SUCCESS) {
+                // Make sure it is binary data containing whole characters.
+                if (valueType == REG_BINARY && (curSizeInBytes % sizeof(wchar_t)) == 0) {
+                    // Success, copy resulting characters. Size is not null-terminated.
+                    p_rValue.assign(upBuffer.get(), curSizeInBytes / sizeof(wchar_t));
+                } else {
+                    lRes = ERROR_INVALID_DATATYPE;
+                }
+            }
+        }
+
+        return lRes;
+    }
+
+    //
+    // Reads all text from a file or pipe. The text can be stored in UTF-8
+    // (with or without BOM) or in UTF-16 (with BOM).
+    //
+    // @param p_hInput Handle of file or pipe to read from.
+    // @param p_rText Where to store the text read.
+    // @return true if the text could be read.
+    //
+    bool PluginUtils::ReadText(HANDLE const p_hInput,
+                               std::wstring& p_rText)
+    {
+        p_rText.clear();
+
+        // Read all data.
+        std::vector<char> vData;
+        DWORD read = 0;
+        do {
+            const size_t oldSize = vData.size();
+            vData.resize(oldSize + TEXT_READ_CHUNK_SIZE);
+            read = 0;
+            if (!::ReadFile(p_hInput, &vData[oldSize], TEXT_READ_CHUNK_SIZE, &read, nullptr)) {
+                // Broken pipes simply mean we've read everything.
+                read = 0;
+            }
+            vData.resize(oldSize + read);
+        } while (read != 0);
+
+        // Convert to a wide string.
+        if (vData.size() >= 2 && static_cast<BYTE>(vData[0]) == 0xFF && static_cast<BYTE>(vData[1]) == 0xFE) {
+            p_rText.assign(reinterpret_cast<const wchar_t*>(&vData[2]), (vData.size() - 2) / sizeof(wchar_t));
+        } else if (!vData.empty()) {
+            const char* pData = &vData[0];
+            int dataSize = static_cast<int>(vData.size());
+            if (dataSize >= 3 && static_cast<BYTE>(pData[0]) == 0xEF &&
+                static_cast<BYTE>(pData[1]) == 0xBB && static_cast<BYTE>(pData[2]) == 0xBF) {
+                pData += 3;
+                dataSize -= 3;
+            }
+            if (dataSize > 0) {
+                const int textSize = ::MultiByteToWideChar(CP_UTF8, 0, pData, dataSize, nullptr, 0);
+                if (textSize <= 0) {
+                    return false;
+                }
+                p_rText.resize(static_cast<size_t>(textSize));
+                ::MultiByteToWideChar(CP_UTF8, 0, pData, dataSize, &*p_rText.begin(), textSize);
+            }
+        }
+        return true;
+    }
+
     //
     // Given a multi-line string read from a REG_MULTI_SZ registry value,
     // finds a line that begins with a given prefix and returns it.
@@ -382,29 +712,36 @@ namespace PCC
 
     //
     // Converts a string containing a list of plugin unique identifiers
-    // to a vector of GUID structs.
+    // to a vector of GUID structs. IDs in canonical format are parsed
+    // directly; others are converted using CLSIDFromString.
     //
-    // @param p_rPluginIdsAsString String containing the plugin IDs. Upon return,
-    //                             this string is unusable.
+    // @param p_PluginIdsAsString String containing the plugin IDs.
     // @param p_Separator Character used to separate the plugin IDs in the string.
     // @return Vector of plugin IDs as GUID structs.
     //
-    GUIDV PluginUtils::StringToPluginIds(std::wstring& p_rPluginIdsAsString,
+    GUIDV PluginUtils::StringToPluginIds(const std::wstring& p_PluginIdsAsString,
                                          const wchar_t p_Separator)
     {
         // Assume there are no plugin IDs.
         GUIDV vPluginIds;
 
-        // First split the string.
-        WStringV vStringParts;
-        StringUtils::Split(p_rPluginIdsAsString, p_Separator, vStringParts);
-
-        // Scan parts and convert to GUIDs.
+        // Scan parts between separators and convert them to GUIDs.
+        const wchar_t* const pEnd = p_PluginIdsAsString.c_str() + p_PluginIdsAsString.size();
+        const wchar_t* pPartBegin = p_PluginIdsAsString.c_str();
         GUID onePluginId = { 0 };
-        for (const std::wstring& stringPart : vStringParts) {
-            if (SUCCEEDED(::CLSIDFromString(stringPart.c_str(), &onePluginId))) {
-                vPluginIds.push_back(onePluginId);
+        while (pPartBegin < pEnd) {
+            const wchar_t* pPartEnd = std::find(pPartBegin, pEnd, p_Separator);
+            if (pPartEnd != pPartBegin) {
+                if (ParseCanonicalGUID(pPartBegin, pPartEnd, onePluginId)) {
+                    vPluginIds.push_back(onePluginId);
+                } else {
+                    const std::wstring stringPart(pPartBegin, pPartEnd);
+                    if (SUCCEEDED(::CLSIDFromString(stringPart.c_str(), &onePluginId))) {
+                        vPluginIds.push_back(onePluginId);
+                    }
+                }
             }
+            pPartBegin = pPartEnd != pEnd ? pPartEnd + 1 : pEnd;
         }
 
         return vPluginIds;
@@ -499,19 +836,16 @@ namespace PCC
     }
 
     //
-    // Checks in the Path Copy Copy settings if a specific plugin
-    // is shown at all, whether in the main menu or in the submenu.
+    // Returns the set of plugins that are shown at all according to Path Copy
+    // Copy settings, whether in the main menu or in the submenu. When no submenu
+    // order is specified, this needs to load all plugins in default order, so
+    // calling Settings::IsPluginShown is preferable since it caches the result.
     //
     // @param p_Settings Object to access settings.
-    // @param p_PluginId ID of plugin to look for in the submenu.
-    // @return true if the plugin is displayed.
+    // @return Set of IDs of plugins that are displayed.
     //
-    bool PluginUtils::IsPluginShown(const Settings& p_Settings,
-                                    const GUID& p_PluginId)
+    GUIDS PluginUtils::GetShownPlugins(const Settings& p_Settings)
     {
-        // Assume it's shown.
-        bool shown = true;
-
         // Get list of plugins in main menu and submenu from settings.
         GUIDV vPluginsInMainMenu, vPluginsInSubmenu;
         if (!p_Settings.GetMainMenuPluginDisplayOrder(vPluginsInMainMenu)) {
@@ -526,18 +860,299 @@ namespace PCC
             }
         }
 
-        // Scan lists to find our plugin.
-        auto isOurPlugin = [&](const GUID& p_Id) -> bool {
-            return ::IsEqualGUID(p_Id, p_PluginId) != FALSE;
+        // Merge both lists.
+        GUIDS sShownPlugins(vPluginsInMainMenu.cbegin(), vPluginsInMainMenu.cend());
+        sShownPlugins.insert(vPluginsInSubmenu.cbegin(), vPluginsInSubmenu.cend());
+        return sShownPlugins;
+    }
+
+    //
+    // Returns the path of a file according to a plugin. If the plugin's paths
+    // can be cached, the path is looked up in the PathResultCache first.
+    //
+    // @param p_Plugin Plugin to use to convert path.
+    // @param p_File Full path to the file to get the path for.
+    // @param p_Context Context of the conversion.
+    // @return Path of the file according to plugin.
+    //
+    std::wstring PluginUtils::GetPathCached(const Plugin& p_Plugin,
+                                            const std::wstring& p_File,
+                                            const ConversionContext& p_Context)
+    {
+        const ULONGLONG generation = PathResultCache::GetGeneration(p_Plugin, p_Context, 1);
+        if (generation == 0) {
+            return p_Plugin.GetPath(p_File, p_Context);
+        }
+
+        const FilesV vFiles(1, p_File);
+        WStringV vPaths;
+        std::vector<bool> vFound;
+        PathResultCache::Lookup(p_Plugin.Id(), generation, vFiles, vPaths, vFound);
+        PerformanceCounters::CacheLookup(PerformanceCounters::Cache::PathResults, vFound.front());
+        PluginStatistics::RecordPathCacheLookups(p_Plugin.Id(), vFound.front() ? 1 : 0, vFound.front() ? 0 : 1);
+        if (!vFound.front()) {
+            vPaths.front() = p_Plugin.GetPath(p_File, p_Context);
+            PathResultCache::Store(p_Plugin.Id(), generation, p_Plugin.PathCacheTimeToLive(p_Context), vFiles, vPaths);
+        }
+        return vPaths.front();
+    }
+
+    //
+    // Returns the paths of the given files according to a plugin. If the
+    // plugin supports it and there are enough files, the files are split in
+    // contiguous chunks converted on separate threads; results are returned
+    // in the same order as the files. Otherwise, simply calls GetPaths.
+    //
+    // @param p_Plugin Plugin to use to convert paths.
+    // @param p_vFiles Full paths to the files to get the paths for.
+    // @param p_Context Context of the conversion, shared by all threads.
+    // @return Paths of the files according to plugin, in the same order.
+    //
+    WStringV PluginUtils::GetPathsInParallel(const Plugin& p_Plugin,
+                                             const FilesV& p_vFiles,
+                                             const ConversionContext& p_Context)
+    {
+        StTraceEvent traceEvent(L"Plugin::GetPaths", &p_Plugin.Id());
+        traceEvent.SetCount(p_vFiles.size());
+        PerformanceCounters::PathsConverted(p_vFiles.size());
+
+        // If plugin's paths can be cached, only convert files not found in the cache.
+        const ULONGLONG generation = PathResultCache::GetGeneration(p_Plugin, p_Context, p_vFiles.size());
+        if (generation != 0) {
+            WStringV vPaths;
+            std::vector<bool> vFound;
+            PathResultCache::Lookup(p_Plugin.Id(), generation, p_vFiles, vPaths, vFound);
+            FilesV vMissingFiles;
+            for (size_t i = 0; i < p_vFiles.size(); ++i) {
+                PerformanceCounters::CacheLookup(PerformanceCounters::Cache::PathResults, vFound[i]);
+                if (!vFound[i]) {
+                    vMissingFiles.push_back(p_vFiles[i]);
+                }
+            }
+            PluginStatistics::RecordPathCacheLookups(p_Plugin.Id(), p_vFiles.size() - vMissingFiles.size(), vMissingFiles.size());
+            if (!vMissingFiles.empty()) {
+                WStringV vMissingPaths = PluginStatistics::Measure(p_Plugin.Id(), PluginStatistics::Operation::GetPath, [&]() {
+                    return p_Plugin.GetPaths(vMissingFiles, p_Context);
+                }, vMissingFiles.size());
+                PathResultCache::Store(p_Plugin.Id(), generation, p_Plugin.PathCacheTimeToLive(p_Context), vMissingFiles, vMissingPaths);
+                if (vMissingFiles.size() == p_vFiles.size() || vMissingPaths.size() != vMissingFiles.size()) {
+                    // Nothing was found in cache (or plugin returned unexpected results); use plugin's paths as-is.
+                    return vMissingPaths;
+                }
+                auto missingIt = vMissingPaths.begin();
+                for (size_t i = 0; i < p_vFiles.size(); ++i) {
+                    if (!vFound[i]) {
+                        vPaths[i] = std::move(*missingIt++);
+                    }
+                }
+            }
+            return vPaths;
+        }
+
+        // Determine how many chunks we'll need.
+        // The cheaper the plugin, the more files each thread must convert to be worth it.
+        size_t numChunks = 1;
+        if (p_Plugin.CanGetPathsConcurrently(p_Context)) {
+            size_t minFilesPerThread = MIN_FILES_PER_THREAD;
+            switch (p_Plugin.CostClass(p_Context)) {
+                case PluginCost::Pure:
+                    minFilesPerThread = MIN_PURE_FILES_PER_THREAD;
+                    break;
+                case PluginCost::Network:
+                    minFilesPerThread = MIN_NETWORK_FILES_PER_THREAD;
+                    break;
+                default:
+                    break;
+            }
+            const size_t numCores = (std::max<size_t>)(std::thread::hardware_concurrency(), 1);
+            numChunks = (std::min)((std::min)(numCores, MAX_CONVERSION_THREADS),
+                                   (std::max<size_t>)(p_vFiles.size() / minFilesPerThread, 1));
+        }
+        if (numChunks == 1) {
+            return PluginStatistics::Measure(p_Plugin.Id(), PluginStatistics::Operation::GetPath, [&]() {
+                return p_Plugin.GetPaths(p_vFiles, p_Context);
+            }, p_vFiles.size());
+        }
+
+        // Split files into contiguous chunks. Each chunk is converted with a
+        // single call to GetPaths so that plugins can still share work. Since
+        // that work is mostly done per parent directory, chunk boundaries are
+        // moved a little if that keeps files of a directory in the same chunk.
+        std::vector<FilesV> vChunks(numChunks);
+        std::vector<WStringV> vChunkPaths(numChunks);
+        std::vector<std::exception_ptr> vChunkErrors(numChunks);
+        const size_t chunkSize = (p_vFiles.size() + numChunks - 1) / numChunks;
+        std::vector<size_t> vBoundaries(numChunks + 1, p_vFiles.size());
+        vBoundaries[0] = 0;
+        for (size_t i = 1; i < numChunks; ++i) {
+            const size_t boundary = (std::min)(i * chunkSize, p_vFiles.size());
+            const size_t maxBoundary = (std::min)(boundary + chunkSize / CHUNK_ALIGNMENT_DIVISOR, p_vFiles.size());
+            vBoundaries[i] = boundary;
+            for (size_t j = boundary; j > 0 && j < maxBoundary; ++j) {
+                if (!HaveSameParent(p_vFiles[j - 1], p_vFiles[j])) {
+                    vBoundaries[i] = j;
+                    break;
+                }
+            }
+        }
+        for (size_t i = 0; i < numChunks; ++i) {
+            vChunks[i].assign(p_vFiles.cbegin() + vBoundaries[i], p_vFiles.cbegin() + vBoundaries[i + 1]);
+        }
+        auto convertChunk = [&](const size_t p_Chunk) {
+            try {
+                vChunkPaths[p_Chunk] = PluginStatistics::Measure(p_Plugin.Id(), PluginStatistics::Operation::GetPath, [&]() {
+                    return p_Plugin.GetPaths(vChunks[p_Chunk], p_Context);
+                }, vChunks[p_Chunk].size());
+            } catch (...) {
+                vChunkErrors[p_Chunk] = std::current_exception();
+            }
         };
-        if (std::find_if(vPluginsInMainMenu.cbegin(), vPluginsInMainMenu.cend(), isOurPlugin) == vPluginsInMainMenu.cend() &&
-            std::find_if(vPluginsInSubmenu.cbegin(), vPluginsInSubmenu.cend(), isOurPlugin) == vPluginsInSubmenu.cend()) {
 
-            // The plugins is not shown.
-            shown = false;
+        // Convert the first chunk on this thread and the others on worker threads.
+        std::vector<std::thread> vThreads;
+        vThreads.reserve(numChunks - 1);
+        for (size_t i = 1; i < numChunks; ++i) {
+            vThreads.emplace_back(convertChunk, i);
+        }
+        convertChunk(0);
+        for (std::thread& thread : vThreads) {
+            thread.join();
+        }
+
+        // Reassemble paths in selection order, rethrowing the first error if any.
+        WStringV vPaths;
+        vPaths.reserve(p_vFiles.size());
+        for (size_t i = 0; i < numChunks; ++i) {
+            if (vChunkErrors[i] != nullptr) {
+                std::rethrow_exception(vChunkErrors[i]);
+            }
+            std::move(vChunkPaths[i].begin(), vChunkPaths[i].end(), std::back_inserter(vPaths));
+        }
+        return vPaths;
+    }
+
+    //
+    // Returns the network path of the root of a mapped network drive.
+    // Ex: N -> \\server\share
+    //
+    // Network paths are cached per drive letter, so that converting many files
+    // on the same drive only looks it up once. Cached info is dropped whenever
+    // the set of logical drives changes, or after a short while otherwise
+    // (to catch drives that are remapped to another share). Drives that are
+    // unreachable (see DriveConnectivityCache) are not looked up, since
+    // this could block until the network times out.
+    //
+    // @param p_Drive Drive letter.
+    // @param p_rUNCRoot Upon exit, will contain network path of drive root,
+    //                   without trailing separator.
+    // @return true if the drive is a mapped network drive.
+    //
+    bool PluginUtils::GetMappedDriveUNCRoot(const wchar_t p_Drive,
+                                            std::wstring& p_rUNCRoot)
+    {
+        const wchar_t drive = static_cast<wchar_t>(std::towupper(p_Drive));
+        const DWORD logicalDrives = ::GetLogicalDrives();
+        const DWORD now = ::GetTickCount();
+        bool found = false;
+        std::wstring uncRoot;
+        {
+            std::lock_guard<std::mutex> lock(s_DrivesLock);
+
+            if (logicalDrives != s_LogicalDrives) {
+                s_mDriveUNCRoots.clear();
+                s_LogicalDrives = logicalDrives;
+            }
+            auto it = s_mDriveUNCRoots.find(drive);
+            if (it != s_mDriveUNCRoots.end() && now - it->second.m_Timestamp < MAPPED_DRIVE_CACHE_TTL_MS) {
+                found = true;
+                uncRoot = it->second.m_UNCRoot;
+            }
+        }
+
+        if (!found) {
+            // Look up network path outside the lock, since it can be slow for disconnected drives.
+            std::wstring root{ drive, L':', L'\\' };
+            if (!DriveConnectivityCache::IsReachable(root)) {
+                return false;
+            }
+            if (GetUniversalName(root)) {
+                if (!root.empty() && (root.back() == L'\\' || root.back() == L'/')) {
+                    root.pop_back();
+                }
+                uncRoot = root;
+            }
+
+            std::lock_guard<std::mutex> lock(s_DrivesLock);
+            DriveUNCRoot& rDriveUNCRoot = s_mDriveUNCRoots[drive];
+            rDriveUNCRoot.m_UNCRoot = uncRoot;
+            rDriveUNCRoot.m_Timestamp = now;
+        }
+
+        const bool mapped = !uncRoot.empty();
+        if (mapped) {
+            p_rUNCRoot = uncRoot;
+        }
+        return mapped;
+    }
+
+    //
+    // Fetches the network path of a file on a mapped drive using the NetworkEnvironment.
+    //
+    // @param p_rFilePath Local file path. Upon exit, will contain network path.
+    // @return true if the file was on a mapped network drive and we fetched its network path.
+    //
+    bool PluginUtils::GetUniversalName(std::wstring& p_rFilePath)
+    {
+        std::wstring universalName;
+        bool converted = false;
+        if (NetworkEnvironment::Current()->GetUniversalName(p_rFilePath, universalName) == NO_ERROR) {
+            // Got UNC path, return it.
+            p_rFilePath = universalName;
+            converted = true;
+        }
+        return converted;
+    }
+
+    //
+    // Returns the index of network shares of the local computer. The index is
+    // built on first use and rebuilt whenever the shares registry key changes.
+    //
+    // The index is immutable, so it is read without locking. When shares change,
+    // a single thread builds a new index and swaps it in; meanwhile, other
+    // threads keep using the previous one instead of waiting.
+    //
+    // @return Index of network shares, or nullptr if shares cannot be read.
+    //
+    ShareIndexSP PluginUtils::GetShareIndex()
+    {
+        const NetworkEnvironmentSP spEnvironment = NetworkEnvironment::Current();
+        ShareIndexSP spShareIndex = std::atomic_load(&s_spShareIndex);
+
+        // Check if shares have changed since we last built the index.
+        const bool rebuild = spShareIndex == nullptr || spEnvironment->SharesChanged();
+        if (rebuild) {
+            // Only wait for another thread's rebuild if we have no index to use.
+            std::unique_lock<std::mutex> lock(s_ShareIndexLock, std::defer_lock);
+            if (spShareIndex == nullptr) {
+                lock.lock();
+            } else {
+                lock.try_lock();
+            }
+            if (lock.owns_lock()) {
+                // Check again in case another thread rebuilt it while we waited.
+                spShareIndex = std::atomic_load(&s_spShareIndex);
+                if (spShareIndex == nullptr || spEnvironment->SharesChanged()) {
+                    NetworkEnvironment::ShareInfoV vShares;
+                    if (spEnvironment->GetShares(vShares)) {
+                        spShareIndex = std::make_shared<ShareIndex>(vShares);
+                        std::atomic_store(&s_spShareIndex, spShareIndex);
+                    }
+                }
+            }
         }
+        PerformanceCounters::CacheLookup(PerformanceCounters::Cache::ShareIndex, !rebuild);
 
-        return shown;
+        return spShareIndex;
     }
 
 } // namespace PCC
@@ -0,0 +1,459 @@
+// PluginsSnapshot.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <stdafx.h>
+#include <PluginsSnapshot.h>
+#include <PathCopyCopyPluginsRegistry.h>
+#include <PathCopyCopySettings.h>
+#include <PerformanceCounters.h>
+#include <RegistryWatcher.h>
+#include <Trace.h>
+
+
+namespace
+{
+    //
+    // Thread-local storage slot allocated while our DLL is loaded. Implicit
+    // thread-local variables are not used because Windows XP does not
+    // support them in DLLs loaded dynamically.
+    //
+    class StTlsSlot final
+    {
+    public:
+        StTlsSlot()
+            : m_Index(::TlsAlloc())
+        {
+        }
+        ~StTlsSlot()
+        {
+            if (m_Index != TLS_OUT_OF_INDEXES) {
+                ::TlsFree(m_Index);
+            }
+        }
+        StTlsSlot(const StTlsSlot&) = delete;
+        StTlsSlot& operator=(const StTlsSlot&) = delete;
+
+        // Whether a slot could be allocated.
+        bool Valid() const
+        {
+            return m_Index != TLS_OUT_OF_INDEXES;
+        }
+
+        // Returns the value of the current thread; slot must be valid.
+        void* Get() const
+        {
+            return ::TlsGetValue(m_Index);
+        }
+
+        // Sets the value of the current thread; slot must be valid.
+        void Set(void* const p_pValue) const
+        {
+            ::TlsSetValue(m_Index, p_pValue);
+        }
+
+    private:
+        DWORD   m_Index;    // Index of slot, or TLS_OUT_OF_INDEXES if it could not be allocated.
+    };
+
+    // Slot pointing to the snapshot cached for each thread, if any. Snapshots
+    // are kept alive by the cache, in which a thread's entry is only replaced
+    // by that thread and only dropped once it has exited.
+    const StTlsSlot     s_CachedSnapshotSlot;
+
+} // anonymous namespace
+
+namespace PCC
+{
+    PluginsSnapshot::PluginsSnapshotM   PluginsSnapshot::s_mspSnapshots;
+    MeasuredMutex                       PluginsSnapshot::s_Lock(L"PluginsSnapshot::s_Lock");
+
+    //
+    // Returns a snapshot of all plugins for the current thread. If a snapshot
+    // has already been created and the settings haven't changed since, the
+    // cached snapshot is returned; otherwise, a new one is created.
+    //
+    // @return Snapshot of all plugins, bound to the current thread.
+    //
+    PluginsSnapshotSP PluginsSnapshot::Get()
+    {
+        ULONG generation = 0;
+        PluginsSnapshotSP spSnapshot = GetCached(generation);
+        PerformanceCounters::CacheLookup(PerformanceCounters::Cache::PluginsSnapshot, spSnapshot != nullptr);
+        if (spSnapshot == nullptr) {
+            // Create the snapshot outside the lock, since this will instantiate COM plugins.
+            {
+                StTraceEvent traceEvent(L"PluginsSnapshot::Create");
+                spSnapshot = std::make_shared<PluginsSnapshot>(generation);
+            }
+
+            // Cache the new snapshot if settings haven't changed in the meantime.
+            // This might release the previous snapshot for this thread, which
+            // is fine since it was created on this very thread. Without a handle
+            // to this thread, we couldn't tell when it exits, so don't cache.
+            const DWORD threadId = ::GetCurrentThreadId();
+            PluginsSnapshotM mspDropped;
+            std::lock_guard<MeasuredMutex> lock(s_Lock);
+            if (generation == RegistryWatcher::GetGeneration() && spSnapshot->m_hOwnerThread != NULL) {
+                // Drop snapshots created by threads that have since exited.
+                DropExitedThreadSnapshots(mspDropped);
+                s_mspSnapshots[threadId] = spSnapshot;
+                if (s_CachedSnapshotSlot.Valid()) {
+                    s_CachedSnapshotSlot.Set(const_cast<PluginsSnapshot*>(spSnapshot.get()));
+                }
+            }
+        }
+
+        return spSnapshot;
+    }
+
+    //
+    // Returns a snapshot that can be used to apply a specific plugin. If a snapshot
+    // of all plugins is cached for the current thread and is still up to date, it is
+    // returned; otherwise, a snapshot containing only the given plugin and the plugins
+    // it references is created. Such a snapshot is not cached and has no plugins to
+    // display in the menus, but is much faster to create.
+    //
+    // @param p_PluginId ID of plugin to use.
+    // @return Snapshot containing at least the given plugin, if it exists.
+    //
+    PluginsSnapshotSP PluginsSnapshot::GetForPlugin(const GUID& p_PluginId)
+    {
+        ULONG generation = 0;
+        PluginsSnapshotSP spSnapshot = GetCached(generation);
+        PerformanceCounters::CacheLookup(PerformanceCounters::Cache::PluginsSnapshot, spSnapshot != nullptr);
+        if (spSnapshot == nullptr) {
+            StTraceEvent traceEvent(L"PluginsSnapshot::Create");
+            spSnapshot = std::make_shared<PluginsSnapshot>(generation, p_PluginId);
+        }
+        return spSnapshot;
+    }
+
+    //
+    // Constructor. Creates all plugins, along with the context that binds
+    // them to the snapshot's settings object and plugin provider.
+    //
+    // @param p_Generation Generation of the settings at the time of creation.
+    //
+    PluginsSnapshot::PluginsSnapshot(const ULONG p_Generation)
+        : PluginsSnapshot(p_Generation, nullptr)
+    {
+    }
+
+    //
+    // Constructor for a snapshot containing only a specific plugin and the
+    // plugins it references. See GetForPlugin for details.
+    //
+    // @param p_Generation Generation of the settings at the time of creation.
+    // @param p_PluginId ID of plugin to load.
+    //
+    PluginsSnapshot::PluginsSnapshot(const ULONG p_Generation,
+                                     const GUID& p_PluginId)
+        : PluginsSnapshot(p_Generation, &p_PluginId)
+    {
+    }
+
+    //
+    // Constructor that performs the actual work of creating plugins.
+    //
+    // @param p_Generation Generation of the settings at the time of creation.
+    // @param p_pPluginId If set, only creates this plugin and the plugins it references.
+    //                    Otherwise, all plugins are created.
+    //
+    PluginsSnapshot::PluginsSnapshot(const ULONG p_Generation,
+                                     const GUID* const p_pPluginId)
+        : m_Generation(p_Generation),
+          m_hOwnerThread(),
+          m_spSettings(std::make_shared<Settings>()),
+          m_upSettingsSnapshot(),
+          m_vspPluginsInDefaultOrder(),
+          m_sspAllPlugins(),
+          m_PluginProvider(m_sspAllPlugins),
+          m_Context(),
+          m_HasMainMenuPluginIds(false),
+          m_vMainMenuPluginIds(),
+          m_vspMainMenuPlugins(),
+          m_vspSubmenuPlugins(),
+          m_mHelpTexts(),
+          m_HelpTextsLock()
+    {
+        // Keep a handle to the owner thread. As long as we hold it, the
+        // thread's ID cannot be reused by the system.
+        HANDLE hOwnerThread = NULL;
+        if (::DuplicateHandle(::GetCurrentProcess(), ::GetCurrentThread(), ::GetCurrentProcess(),
+                              &hOwnerThread, SYNCHRONIZE, FALSE, 0)) {
+            m_hOwnerThread.Attach(hOwnerThread);
+        }
+
+        // Load all settings at once; plugins read them often and the
+        // snapshot is recreated anyway when the registry keys change.
+        m_spSettings->Snapshot();
+        m_upSettingsSnapshot = std::make_unique<SettingsSnapshot>(*m_spSettings);
+        m_Context = ConversionContext(m_spSettings.get(), m_upSettingsSnapshot.get(), &m_PluginProvider);
+
+        if (p_pPluginId != nullptr) {
+            // Only get the requested plugin and the plugins it references. There's no default order.
+            m_sspAllPlugins = PluginsRegistry::GetPluginWithReferencedPlugins(
+                *p_pPluginId, m_spSettings.get(), m_spSettings.get(), false);
+        } else {
+            // Get all plugins in default order. Do not include temp pipeline plugins.
+            m_vspPluginsInDefaultOrder = PluginsRegistry::GetPluginsInDefaultOrder(
+                m_spSettings.get(), m_spSettings.get(), false);
+
+            // Get set of all plugins from the above vector.
+            m_sspAllPlugins.insert(m_vspPluginsInDefaultOrder.cbegin(), m_vspPluginsInDefaultOrder.cend());
+
+            // Order plugins to display in the menus now, since they won't change until the next snapshot.
+            OrderPluginsToDisplay();
+        }
+    }
+
+    //
+    // Returns the generation of the settings at the time the snapshot was
+    // created (see RegistryWatcher::GetGeneration).
+    //
+    // @return Settings generation.
+    //
+    ULONG PluginsSnapshot::GetGeneration() const
+    {
+        return m_Generation;
+    }
+
+    //
+    // Returns the settings object used with the snapshot's plugins.
+    //
+    // @return Reference to settings object.
+    //
+    Settings& PluginsSnapshot::GetSettings() const
+    {
+        return *m_spSettings;
+    }
+
+    //
+    // Returns the immutable copy of the settings used during conversions.
+    //
+    // @return Reference to settings snapshot.
+    //
+    const SettingsSnapshot& PluginsSnapshot::GetSettingsSnapshot() const
+    {
+        return *m_upSettingsSnapshot;
+    }
+
+    //
+    // Returns all plugins in the snapshot, in default order.
+    //
+    // @return Vector of all plugins in default order.
+    //
+    const PluginSPV& PluginsSnapshot::GetPluginsInDefaultOrder() const
+    {
+        return m_vspPluginsInDefaultOrder;
+    }
+
+    //
+    // Returns a set containing all plugins in the snapshot.
+    //
+    // @return Set of all plugins.
+    //
+    const PluginSPS& PluginsSnapshot::GetAllPlugins() const
+    {
+        return m_sspAllPlugins;
+    }
+
+    //
+    // Returns the plugin provider wrapping the snapshot's plugins.
+    //
+    // @return Plugin provider.
+    //
+    const PluginProvider& PluginsSnapshot::GetPluginProvider() const
+    {
+        return m_PluginProvider;
+    }
+
+    //
+    // Returns the context to pass to the snapshot's plugins when using them.
+    // It references the snapshot's settings object and plugin provider.
+    //
+    // @return Conversion context.
+    //
+    const ConversionContext& PluginsSnapshot::GetConversionContext() const
+    {
+        return m_Context;
+    }
+
+    //
+    // Returns the IDs of the plugins to display in the main menu, as
+    // specified in the settings.
+    //
+    // @return Pointer to vector of plugin IDs, or nullptr if the main
+    //         menu plugins have not been specified in the settings.
+    //
+    const GUIDV* PluginsSnapshot::GetMainMenuPluginIds() const
+    {
+        return m_HasMainMenuPluginIds ? &m_vMainMenuPluginIds : nullptr;
+    }
+
+    //
+    // Returns the plugins to display in the main menu, in display order.
+    // Empty if the main menu plugins have not been specified in the settings.
+    //
+    // @return Vector of main menu plugins.
+    //
+    const PluginSPV& PluginsSnapshot::GetMainMenuPlugins() const
+    {
+        return m_vspMainMenuPlugins;
+    }
+
+    //
+    // Returns the plugins to display in the submenu, in display order.
+    // If the submenu plugins have not been specified in the settings,
+    // this returns all plugins in default order.
+    //
+    // @return Vector of submenu plugins.
+    //
+    const PluginSPV& PluginsSnapshot::GetSubmenuPlugins() const
+    {
+        return m_vspSubmenuPlugins;
+    }
+
+    //
+    // Returns the help text of one of the snapshot's plugins. Help texts are
+    // displayed every time the user hovers over a menu item, and getting one
+    // can be expensive (especially for COM plugins), so each one is only
+    // fetched once per snapshot, the first time it is needed.
+    //
+    // @param p_Plugin Plugin whose help text to return.
+    // @return Plugin help text; remains valid as long as the snapshot.
+    //
+    const std::wstring& PluginsSnapshot::GetHelpText(const Plugin& p_Plugin) const
+    {
+        std::lock_guard<std::mutex> lock(m_HelpTextsLock);
+        auto it = m_mHelpTexts.find(p_Plugin.Id());
+        if (it == m_mHelpTexts.end()) {
+            it = m_mHelpTexts.emplace(p_Plugin.Id(), p_Plugin.HelpText()).first;
+        }
+        return it->second;
+    }
+
+    //
+    // Forgets paths memoized by the snapshot's plugin provider. Should be
+    // called before converting a new set of files.
+    //
+    void PluginsSnapshot::ClearCachedPaths() const
+    {
+        m_PluginProvider.ClearCachedPaths();
+    }
+
+    //
+    // Computes the ordered lists of plugins to display in the main menu and
+    // in the submenu. Unknown plugins are only computed once for both lists.
+    //
+    void PluginsSnapshot::OrderPluginsToDisplay()
+    {
+        GUIDV vUnknownPlugins;
+        const GUIDV* pvUnknownPlugins = nullptr;
+        GUIDV vKnownPlugins;
+        if (m_spSettings->GetKnownPlugins(vKnownPlugins)) {
+            vUnknownPlugins = PluginsRegistry::GetUnknownPlugins(m_sspAllPlugins, vKnownPlugins);
+            pvUnknownPlugins = &vUnknownPlugins;
+        }
+
+        m_HasMainMenuPluginIds = m_spSettings->GetMainMenuPluginDisplayOrder(m_vMainMenuPluginIds);
+        if (m_HasMainMenuPluginIds) {
+            m_vspMainMenuPlugins = PluginsRegistry::OrderPluginsToDisplayWithUnknownPlugins(
+                m_sspAllPlugins, m_vMainMenuPluginIds, pvUnknownPlugins, &m_vspPluginsInDefaultOrder);
+        }
+
+        GUIDV vSubmenuPluginIds;
+        m_spSettings->GetSubmenuPluginDisplayOrder(vSubmenuPluginIds);
+        if (!vSubmenuPluginIds.empty()) {
+            m_vspSubmenuPlugins = PluginsRegistry::OrderPluginsToDisplayWithUnknownPlugins(
+                m_sspAllPlugins, vSubmenuPluginIds, pvUnknownPlugins, &m_vspPluginsInDefaultOrder);
+        } else {
+            // No plugin specified, use all plugins in default order.
+            m_vspSubmenuPlugins = m_vspPluginsInDefaultOrder;
+        }
+    }
+
+    //
+    // Releases cached snapshots created by threads that have since exited.
+    // Snapshots of other threads are kept, since they hold COM plugins that
+    // must be released by the thread that created them. Used to trim our
+    // memory usage when idle.
+    //
+    void PluginsSnapshot::ReleaseUnused()
+    {
+        // Declared before the lock so that dropped snapshots are released after it.
+        PluginsSnapshotM mspDropped;
+        std::lock_guard<MeasuredMutex> lock(s_Lock);
+        DropExitedThreadSnapshots(mspDropped);
+    }
+
+    //
+    // Returns the snapshot of all plugins cached for the current thread, if
+    // it's still up to date. Called whenever a menu is built, so it does not
+    // lock unless no thread-local slot could be allocated.
+    //
+    // @param p_rGeneration Upon exit, will contain the current settings generation.
+    // @return Cached snapshot, or nullptr if there's none or it's stale.
+    //
+    PluginsSnapshotSP PluginsSnapshot::GetCached(ULONG& p_rGeneration)
+    {
+        p_rGeneration = RegistryWatcher::GetGeneration();
+
+        if (s_CachedSnapshotSlot.Valid()) {
+            const PluginsSnapshot* const pSnapshot = static_cast<const PluginsSnapshot*>(s_CachedSnapshotSlot.Get());
+            if (pSnapshot != nullptr && pSnapshot->m_Generation == p_rGeneration) {
+                return pSnapshot->shared_from_this();
+            }
+            return nullptr;
+        }
+
+        const DWORD threadId = ::GetCurrentThreadId();
+        std::lock_guard<MeasuredMutex> lock(s_Lock);
+        auto it = s_mspSnapshots.find(threadId);
+        if (it != s_mspSnapshots.end() && it->second->m_Generation == p_rGeneration) {
+            return it->second;
+        }
+        return nullptr;
+    }
+
+    //
+    // Drops snapshots created by threads that have since exited. Must be
+    // called with the lock held. If we can't tell whether a thread exited,
+    // it is assumed to be alive, since releasing its snapshot from another
+    // thread would release its COM plugins from the wrong apartment.
+    //
+    // @param p_rmspDropped Where to move the dropped snapshots, so that the
+    //                      caller can release them outside the lock.
+    //
+    void PluginsSnapshot::DropExitedThreadSnapshots(PluginsSnapshotM& p_rmspDropped)
+    {
+        for (auto it = s_mspSnapshots.begin(); it != s_mspSnapshots.end(); ) {
+            if (::WaitForSingleObject(it->second->m_hOwnerThread, 0) == WAIT_OBJECT_0) {
+                p_rmspDropped.insert(*it);
+                it = s_mspSnapshots.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+} // namespace PCC
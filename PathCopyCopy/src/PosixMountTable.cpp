@@ -0,0 +1,311 @@
+// PosixMountTable.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <stdafx.h>
+#include <PosixMountTable.h>
+#include <PluginUtils.h>
+#include <StringUtils.h>
+
+#include <algorithm>
+
+
+namespace
+{
+    // Registry key and value where Cygwin's setup stores the installation's root directory.
+    const wchar_t* const    CYGWIN_SETUP_KEY_NAME       = L"SOFTWARE\\Cygwin\\setup";
+    const wchar_t* const    CYGWIN_ROOT_DIR_VALUE       = L"rootdir";
+
+    // Usual root directories of MSYS2 installations, and a file found in all of them.
+    const wchar_t* const    MSYS_ROOT_DIRS[]            = { L"%SystemDrive%\\msys64", L"%SystemDrive%\\msys32" };
+    const wchar_t* const    MSYS_RUNTIME_PATH           = L"\\usr\\bin\\msys-2.0.dll";
+
+    // Path of fstab, relative to the installation's root directory.
+    const wchar_t* const    FSTAB_PATH                  = L"\\etc\\fstab";
+
+    // Type of fstab entry specifying the cygdrive prefix.
+    const wchar_t* const    CYGDRIVE_TYPE               = L"cygdrive";
+
+    // Default cygdrive prefixes. Cygwin uses /cygdrive/c, MSYS2 uses /c.
+    const wchar_t* const    CYGWIN_CYGDRIVE_PREFIX      = L"/cygdrive/";
+    const wchar_t* const    MSYS_CYGDRIVE_PREFIX        = L"/";
+
+    // Time after which we check if an installation or its fstab changed, in milliseconds.
+    const DWORD             CHECK_INTERVAL_MS           = 30 * 1000;
+
+    //
+    // Decodes the octal escapes used in fstab fields, like "\040" for a space.
+    //
+    // @param p_rField Field to decode (in-place).
+    //
+    void DecodeFstabField(std::wstring& p_rField)
+    {
+        std::wstring::size_type pos = p_rField.find(L'\\');
+        while (pos != std::wstring::npos) {
+            if (pos + 3 < p_rField.size() &&
+                std::all_of(p_rField.cbegin() + pos + 1, p_rField.cbegin() + pos + 4,
+                            [](const wchar_t c) { return c >= L'0' && c <= L'7'; })) {
+
+                const wchar_t decoded = static_cast<wchar_t>(((p_rField[pos + 1] - L'0') << 6) |
+                                                             ((p_rField[pos + 2] - L'0') << 3) |
+                                                             (p_rField[pos + 3] - L'0'));
+                p_rField.replace(pos, 4, 1, decoded);
+            }
+            pos = p_rField.find(L'\\', pos + 1);
+        }
+    }
+
+    //
+    // Makes sure a path ends with the given separator.
+    //
+    // @param p_rPath Path to modify (in-place).
+    // @param p_Separator Separator to add if missing.
+    //
+    void EnsureTrailingSeparator(std::wstring& p_rPath,
+                                 const wchar_t p_Separator)
+    {
+        if (p_rPath.empty() || p_rPath.back() != p_Separator) {
+            p_rPath.push_back(p_Separator);
+        }
+    }
+
+    //
+    // Checks if a path exists.
+    //
+    // @param p_Path Path to check.
+    // @return true if a file or directory exists at p_Path.
+    //
+    bool PathExists(const std::wstring& p_Path)
+    {
+        return ::GetFileAttributesW(p_Path.c_str()) != INVALID_FILE_ATTRIBUTES;
+    }
+
+} // anonymous namespace
+
+namespace PCC
+{
+    // Static members of PosixMountTable
+    PosixMountTable::EntryM PosixMountTable::s_mEntries;
+    std::mutex              PosixMountTable::s_Lock;
+
+    //
+    // Constructor. Parses the given fstab and builds the table.
+    //
+    // @param p_RootDir Root directory of the installation.
+    // @param p_Fstab Contents of the installation's /etc/fstab. Can be empty.
+    // @param p_DefaultCygdrivePrefix Cygdrive prefix to use if fstab does not specify one.
+    //
+    PosixMountTable::PosixMountTable(const std::wstring& p_RootDir,
+                                     const std::wstring& p_Fstab,
+                                     const std::wstring& p_DefaultCygdrivePrefix)
+        : m_Mounts(BuildTable(p_RootDir, p_Fstab, p_DefaultCygdrivePrefix), true)
+    {
+    }
+
+    //
+    // Converts the beginning of a Windows path to its POSIX equivalent, using
+    // the longest mount point containing the path. Mount points only match
+    // whole path components. The rest of the path is left as-is, so the
+    // caller still needs to replace backslashes by slashes.
+    //
+    // @param p_rPath Path to convert (in-place).
+    // @return true if a mount point contained the path.
+    //
+    bool PosixMountTable::Apply(std::wstring& p_rPath) const
+    {
+        // Mount points are stored with a trailing separator so that they only match
+        // whole path components. Add one to the path, too, in case it's a mount point.
+        const bool addSeparator = p_rPath.empty() || p_rPath.back() != L'\\';
+        if (addSeparator) {
+            p_rPath.push_back(L'\\');
+        }
+        const bool found = m_Mounts.Apply(p_rPath);
+        if (addSeparator && (p_rPath.size() > 1 || !found)) {
+            // Remove the separator we added, or the one ending the POSIX path if the path
+            // was the mount point itself. Keep it if the path is the POSIX root, however.
+            p_rPath.pop_back();
+        }
+        return found;
+    }
+
+    //
+    // Returns the mount table of an environment. Tables are loaded once and
+    // cached; every once in a while, we check if the environment's root
+    // directory or fstab changed and reload the table if needed.
+    //
+    // @param p_Environment Environment whose mount table to return.
+    // @return Mount table, or nullptr if the environment is not installed.
+    //
+    PosixMountTable::PosixMountTableSP PosixMountTable::Get(const Environment p_Environment)
+    {
+        std::lock_guard<std::mutex> lock(s_Lock);
+        Entry& rEntry = s_mEntries[p_Environment];
+        const DWORD now = ::GetTickCount();
+        if (rEntry.m_Timestamp == 0 || now - rEntry.m_Timestamp >= CHECK_INTERVAL_MS) {
+            const std::wstring rootDir = FindRootDir(p_Environment);
+            const std::wstring fstabPath = rootDir + FSTAB_PATH;
+            FILETIME fstabTime = { 0, 0 };
+            WIN32_FILE_ATTRIBUTE_DATA fstabData = { 0 };
+            const bool hasFstab = !rootDir.empty() &&
+                ::GetFileAttributesExW(fstabPath.c_str(), GetFileExInfoStandard, &fstabData) != FALSE;
+            if (hasFstab) {
+                fstabTime = fstabData.ftLastWriteTime;
+            }
+
+            if (rEntry.m_Timestamp == 0 || rootDir != rEntry.m_RootDir ||
+                ::CompareFileTime(&fstabTime, &rEntry.m_FstabTime) != 0) {
+
+                rEntry.m_spTable.reset();
+                if (!rootDir.empty()) {
+                    std::wstring fstab;
+                    if (hasFstab) {
+                        HANDLE hFile = ::CreateFileW(fstabPath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                                     OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+                        if (hFile != INVALID_HANDLE_VALUE) {
+                            ATL::CHandle hFstabFile(hFile);
+                            if (!PluginUtils::ReadText(hFstabFile, fstab)) {
+                                fstab.clear();
+                            }
+                        }
+                    }
+                    rEntry.m_spTable = std::make_shared<PosixMountTable>(rootDir, fstab,
+                        p_Environment == Environment::Cygwin ? CYGWIN_CYGDRIVE_PREFIX : MSYS_CYGDRIVE_PREFIX);
+                }
+                rEntry.m_RootDir = rootDir;
+                rEntry.m_FstabTime = fstabTime;
+            }
+
+            // Zero means the entry was never validated.
+            rEntry.m_Timestamp = now != 0 ? now : 1;
+        }
+        return rEntry.m_spTable;
+    }
+
+    //
+    // Builds the text of the PrefixMap storing mount points.
+    //
+    // @param p_RootDir Root directory of the installation.
+    // @param p_Fstab Contents of the installation's /etc/fstab.
+    // @param p_DefaultCygdrivePrefix Cygdrive prefix to use if fstab does not specify one.
+    // @return PrefixMap table text.
+    //
+    std::wstring PosixMountTable::BuildTable(const std::wstring& p_RootDir,
+                                             const std::wstring& p_Fstab,
+                                             const std::wstring& p_DefaultCygdrivePrefix)
+    {
+        std::wstring table;
+        auto addMount = [&](std::wstring p_WindowsPath, std::wstring p_PosixPath) {
+            EnsureTrailingSeparator(p_WindowsPath, L'\\');
+            EnsureTrailingSeparator(p_PosixPath, L'/');
+            table.append(p_WindowsPath).append(1, L'\t').append(p_PosixPath).append(1, L'\n');
+        };
+
+        // Explicit mounts come first, since PrefixMap uses the first entry for each prefix.
+        std::wstring cygdrivePrefix = p_DefaultCygdrivePrefix;
+        std::wstring fstab(p_Fstab);
+        WStringV vLines;
+        StringUtils::Split(fstab, L'\n', vLines);
+        for (const std::wstring& line : vLines) {
+            // Fields are separated by whitespace: Windows path, POSIX path, type and options.
+            WStringV vFields;
+            std::wstring::size_type fieldBegin = line.find_first_not_of(L" \t\r");
+            while (fieldBegin != std::wstring::npos && line[fieldBegin] != L'#' && vFields.size() < 3) {
+                const std::wstring::size_type fieldEnd = line.find_first_of(L" \t\r", fieldBegin);
+                vFields.push_back(line.substr(fieldBegin, fieldEnd - fieldBegin));
+                fieldBegin = fieldEnd != std::wstring::npos ? line.find_first_not_of(L" \t\r", fieldEnd) : fieldEnd;
+            }
+            if (vFields.size() == 3) {
+                for (std::wstring& field : vFields) {
+                    DecodeFstabField(field);
+                }
+                std::wstring& windowsPath = vFields[0];
+                const std::wstring& posixPath = vFields[1];
+                if (!posixPath.empty() && posixPath.front() == L'/') {
+                    if (vFields[2] == CYGDRIVE_TYPE) {
+                        cygdrivePrefix = posixPath;
+                    } else {
+                        StringUtils::ReplaceChar(windowsPath, L'/', L'\\');
+                        if (windowsPath.size() >= 2 && (windowsPath[1] == L':' || windowsPath.compare(0, 2, L"\\\\") == 0)) {
+                            addMount(windowsPath, posixPath);
+                        }
+                    }
+                }
+            }
+        }
+
+        // Implicit mounts of Cygwin and MSYS2.
+        addMount(p_RootDir + L"\\bin", L"/usr/bin");
+        addMount(p_RootDir + L"\\lib", L"/usr/lib");
+        addMount(p_RootDir, L"/");
+
+        // Cygdrive mounts of all drive letters.
+        EnsureTrailingSeparator(cygdrivePrefix, L'/');
+        for (wchar_t drive = L'a'; drive <= L'z'; ++drive) {
+            addMount(std::wstring(1, drive) + L':', cygdrivePrefix + drive);
+        }
+
+        return table;
+    }
+
+    //
+    // Finds the root directory of an environment's installation.
+    //
+    // @param p_Environment Environment to look for.
+    // @return Root directory, without trailing backslash, or an empty string if not installed.
+    //
+    std::wstring PosixMountTable::FindRootDir(const Environment p_Environment)
+    {
+        std::wstring rootDir;
+        if (p_Environment == Environment::Cygwin) {
+            // Setup stores the root directory in the registry, in the 64-bit view
+            // of HKLM for 64-bit installations or in HKCU for per-user installations.
+            const HKEY ROOT_KEYS[] = { HKEY_LOCAL_MACHINE, HKEY_LOCAL_MACHINE, HKEY_CURRENT_USER };
+            const REGSAM VIEWS[] = { KEY_WOW64_64KEY, KEY_WOW64_32KEY, 0 };
+            for (size_t i = 0; i < 3 && rootDir.empty(); ++i) {
+                ATL::CRegKey setupKey;
+                if (setupKey.Open(ROOT_KEYS[i], CYGWIN_SETUP_KEY_NAME, KEY_READ | VIEWS[i]) == ERROR_SUCCESS) {
+                    wchar_t value[MAX_PATH + 1];
+                    ULONG size = MAX_PATH + 1;
+                    if (setupKey.QueryStringValue(CYGWIN_ROOT_DIR_VALUE, value, &size) == ERROR_SUCCESS &&
+                        PathExists(value)) {
+
+                        rootDir = value;
+                    }
+                }
+            }
+        } else {
+            // MSYS2 does not register itself, so look for it in its default locations.
+            for (const wchar_t* const pRootDir : MSYS_ROOT_DIRS) {
+                wchar_t expanded[MAX_PATH + 1];
+                const DWORD size = ::ExpandEnvironmentStringsW(pRootDir, expanded, MAX_PATH + 1);
+                if (size != 0 && size <= MAX_PATH + 1 && PathExists(std::wstring(expanded) + MSYS_RUNTIME_PATH)) {
+                    rootDir = expanded;
+                    break;
+                }
+            }
+        }
+        while (!rootDir.empty() && (rootDir.back() == L'\\' || rootDir.back() == L'/')) {
+            rootDir.pop_back();
+        }
+        return rootDir;
+    }
+
+} // namespace PCC
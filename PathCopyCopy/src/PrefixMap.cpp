@@ -0,0 +1,268 @@
+// PrefixMap.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <stdafx.h>
+#include <PrefixMap.h>
+#include <PathCompare.h>
+#include <PluginUtils.h>
+#include <RegistryWatcher.h>
+#include <StringUtils.h>
+#include <UserOverrideableRegKey.h>
+
+#include <limits>
+#include <utility>
+
+#include <assert.h>
+#include <atlbase.h>
+
+
+namespace
+{
+    const wchar_t* const    PCC_PREFIX_MAPPINGS_KEY = L"Software\\clechasseur\\PathCopyCopy\\PrefixMappings";  // Key storing tables in the registry.
+
+    const wchar_t           TABLE_LINE_SEPARATOR    = L'\n';    // Separator between entries of a table.
+    const wchar_t           TABLE_VALUE_SEPARATOR   = L'\t';    // Separator between a prefix and its replacement.
+    const wchar_t           TABLE_COMMENT_CHAR      = L';';     // Character starting comment lines in a table.
+
+} // anonymous namespace
+
+namespace PCC
+{
+    // Static members of PrefixMap
+    const size_t            PrefixMap::NO_REPLACEMENT = (std::numeric_limits<size_t>::max)();
+    PrefixMap::PrefixMapM   PrefixMap::s_mspPrefixMaps;
+    std::mutex              PrefixMap::s_Lock;
+
+    //
+    // Constructor. Parses the given table and builds the trie.
+    //
+    // @param p_Table Table contents, one entry per line.
+    // @param p_IgnoreCase Whether to ignore case when looking for prefixes.
+    //
+    PrefixMap::PrefixMap(const std::wstring& p_Table,
+                         const bool p_IgnoreCase)
+        : m_vNodes(1, Node { {}, NO_REPLACEMENT }),
+          m_vReplacements(),
+          m_IgnoreCase(p_IgnoreCase)
+    {
+        std::wstring table(p_Table);
+        WStringV vLines;
+        StringUtils::Split(table, TABLE_LINE_SEPARATOR, vLines);
+        for (std::wstring& line : vLines) {
+            if (!line.empty() && line.back() == L'\r') {
+                line.pop_back();
+            }
+            if (!line.empty() && line.front() != TABLE_COMMENT_CHAR) {
+                const std::wstring::size_type sepPos = line.find(TABLE_VALUE_SEPARATOR);
+                if (sepPos != std::wstring::npos && sepPos != 0) {
+                    AddPrefix(line.substr(0, sepPos), line.substr(sepPos + 1));
+                }
+            }
+        }
+    }
+
+    //
+    // Replaces the longest prefix of the given path found in the table.
+    //
+    // @param p_rPath Path to modify (in-place).
+    // @return true if a prefix was found and replaced.
+    //
+    bool PrefixMap::Apply(std::wstring& p_rPath) const
+    {
+        std::wstring::size_type replacementLength = 0;
+        return Apply(p_rPath, replacementLength);
+    }
+
+    //
+    // Replaces the longest prefix of the given path found in the table and
+    // returns the length of the replacement value, so that callers can
+    // process the rest of the path separately.
+    //
+    // @param p_rPath Path to modify (in-place).
+    // @param p_rReplacementLength Where to store the length of the replacement
+    //                             value; set to 0 if no prefix was found.
+    // @return true if a prefix was found and replaced.
+    //
+    bool PrefixMap::Apply(std::wstring& p_rPath,
+                          std::wstring::size_type& p_rReplacementLength) const
+    {
+        // Walk down the trie as long as the path matches, remembering
+        // the deepest node where a prefix ends.
+        size_t node = 0;
+        size_t replacement = NO_REPLACEMENT;
+        std::wstring::size_type prefixLength = 0;
+        for (std::wstring::size_type i = 0; i < p_rPath.size(); ++i) {
+            const auto& mChildren = m_vNodes[node].m_mChildren;
+            const auto it = mChildren.find(GetKeyChar(p_rPath[i]));
+            if (it == mChildren.end()) {
+                break;
+            }
+            node = it->second;
+            if (m_vNodes[node].m_Replacement != NO_REPLACEMENT) {
+                replacement = m_vNodes[node].m_Replacement;
+                prefixLength = i + 1;
+            }
+        }
+
+        const bool found = replacement != NO_REPLACEMENT;
+        p_rReplacementLength = 0;
+        if (found) {
+            p_rPath.replace(0, prefixLength, m_vReplacements[replacement]);
+            p_rReplacementLength = m_vReplacements[replacement].size();
+        }
+        return found;
+    }
+
+    //
+    // Returns a prefix map for the given table. Tables loaded from files
+    // or from the registry are loaded only once and shared while in use;
+    // tables loaded from the registry are loaded again if settings change.
+    //
+    // @param p_Source Source of the table.
+    // @param p_Table Table contents if p_Source is Source::Inline;
+    //                otherwise, path of the file or name of the registry
+    //                value containing the table.
+    // @param p_IgnoreCase Whether to ignore case when looking for prefixes.
+    // @return Prefix map, or nullptr if the table could not be loaded.
+    //
+    PrefixMap::PrefixMapSP PrefixMap::GetPrefixMap(const Source p_Source,
+                                                   const std::wstring& p_Table,
+                                                   const bool p_IgnoreCase)
+    {
+        // Inline tables belong to their pipeline element, no need to cache them.
+        if (p_Source == Source::Inline) {
+            return std::make_shared<const PrefixMap>(p_Table, p_IgnoreCase);
+        }
+
+        PrefixMapSP spPrefixMap;
+        if (!p_Table.empty()) {
+            const ULONG generation = p_Source == Source::Registry ? RegistryWatcher::GetGeneration() : 0;
+            std::lock_guard<std::mutex> lock(s_Lock);
+
+            PrefixMapKey key(p_Source, p_Table, p_IgnoreCase);
+            auto it = s_mspPrefixMaps.find(key);
+            if (it != s_mspPrefixMaps.end() && it->second.m_Generation == generation) {
+                spPrefixMap = it->second.m_wpPrefixMap.lock();
+            }
+            if (spPrefixMap == nullptr) {
+                // Not loaded or no longer in use, load the table. We don't cache
+                // failures since the file or value could be created later.
+                std::wstring table;
+                if (ReadTable(p_Source, p_Table, table)) {
+                    spPrefixMap = std::make_shared<const PrefixMap>(table, p_IgnoreCase);
+
+                    // Take this opportunity to forget tables no longer in use.
+                    for (auto cacheIt = s_mspPrefixMaps.begin(); cacheIt != s_mspPrefixMaps.end(); ) {
+                        if (cacheIt->second.m_wpPrefixMap.expired()) {
+                            cacheIt = s_mspPrefixMaps.erase(cacheIt);
+                        } else {
+                            ++cacheIt;
+                        }
+                    }
+                    CachedPrefixMap& rCachedPrefixMap = s_mspPrefixMaps[key];
+                    rCachedPrefixMap.m_wpPrefixMap = spPrefixMap;
+                    rCachedPrefixMap.m_Generation = generation;
+                }
+            }
+        }
+        return spPrefixMap;
+    }
+
+    //
+    // Adds a prefix to the trie, unless it is already there.
+    //
+    // @param p_Prefix Prefix to add.
+    // @param p_Replacement Replacement value for p_Prefix.
+    //
+    void PrefixMap::AddPrefix(const std::wstring& p_Prefix,
+                              const std::wstring& p_Replacement)
+    {
+        size_t node = 0;
+        for (const wchar_t c : p_Prefix) {
+            const wchar_t keyChar = GetKeyChar(c);
+            const auto it = m_vNodes[node].m_mChildren.find(keyChar);
+            if (it != m_vNodes[node].m_mChildren.end()) {
+                node = it->second;
+            } else {
+                // Note: can't keep a reference to the current node here, since
+                // adding a node might reallocate the vector.
+                const size_t newNode = m_vNodes.size();
+                m_vNodes.push_back(Node { {}, NO_REPLACEMENT });
+                m_vNodes[node].m_mChildren.emplace(keyChar, newNode);
+                node = newNode;
+            }
+        }
+        if (m_vNodes[node].m_Replacement == NO_REPLACEMENT) {
+            m_vNodes[node].m_Replacement = m_vReplacements.size();
+            m_vReplacements.push_back(p_Replacement);
+        }
+    }
+
+    //
+    // Returns the character to use to look for a path character in the trie.
+    //
+    // @param p_Char Path character.
+    // @return Character to look for; case-folded if m_IgnoreCase is true.
+    //
+    wchar_t PrefixMap::GetKeyChar(const wchar_t p_Char) const
+    {
+        return m_IgnoreCase ? PathCompare::FoldCase(p_Char) : p_Char;
+    }
+
+    //
+    // Reads the contents of a table stored outside of a pipeline.
+    //
+    // @param p_Source Source of the table; cannot be Source::Inline.
+    // @param p_Location Path of the file or name of the registry value
+    //                   containing the table.
+    // @param p_rTable Where to store the table contents.
+    // @return true if the table could be read.
+    //
+    bool PrefixMap::ReadTable(const Source p_Source,
+                              const std::wstring& p_Location,
+                              std::wstring& p_rTable)
+    {
+        bool read = false;
+        switch (p_Source) {
+            case Source::File: {
+                HANDLE hFile = ::CreateFileW(p_Location.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                             OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+                if (hFile != INVALID_HANDLE_VALUE) {
+                    ATL::CHandle hTableFile(hFile);
+                    read = PluginUtils::ReadText(hTableFile, p_rTable);
+                }
+                break;
+            }
+            case Source::Registry: {
+                // Tables in the user key override those in the global key.
+                UserOverrideableRegKey key(PCC_PREFIX_MAPPINGS_KEY);
+                read = PluginUtils::ReadRegistryStringValue(key, p_Location.c_str(), p_rTable) == ERROR_SUCCESS;
+                break;
+            }
+            default:
+                assert(false);
+                break;
+        }
+        return read;
+    }
+
+} // namespace PCC
@@ -0,0 +1,241 @@
+// ReadOnlyMemoryStream.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <stdafx.h>
+#include <ReadOnlyMemoryStream.h>
+
+
+namespace PCC
+{
+    //
+    // Constructor. Use Create to create instances.
+    //
+    ReadOnlyMemoryStream::ReadOnlyMemoryStream()
+        : m_pData(nullptr),
+          m_Size(0),
+          m_Position(0)
+    {
+    }
+
+    //
+    // Creates a new stream over a block of memory.
+    //
+    // @param p_pData Pointer to memory block. Must remain valid for the lifetime of the stream.
+    // @param p_Size Size of memory block, in bytes.
+    // @param p_ppStream Where to store the new stream.
+    // @return S_OK if successful, otherwise an error code.
+    //
+    HRESULT ReadOnlyMemoryStream::Create(const void* const p_pData,
+                                         const ULONG p_Size,
+                                         IStream** const p_ppStream)
+    {
+        HRESULT hRes = E_POINTER;
+        if (p_ppStream != nullptr) {
+            *p_ppStream = nullptr;
+            if (p_pData != nullptr || p_Size == 0) {
+                ATL::CComObject<ReadOnlyMemoryStream>* pStream = nullptr;
+                hRes = ATL::CComObject<ReadOnlyMemoryStream>::CreateInstance(&pStream);
+                if (SUCCEEDED(hRes)) {
+                    pStream->m_pData = static_cast<const BYTE*>(p_pData);
+                    pStream->m_Size = p_Size;
+                    pStream->AddRef();
+                    *p_ppStream = pStream;
+                }
+            }
+        }
+        return hRes;
+    }
+
+    //
+    // ISequentialStream::Read
+    //
+    STDMETHODIMP ReadOnlyMemoryStream::Read(void* p_pBuffer,
+                                            ULONG p_Size,
+                                            ULONG* p_pRead)
+    {
+        HRESULT hRes = STG_E_INVALIDPOINTER;
+        if (p_pBuffer != nullptr) {
+            const ULONG toRead = (std::min)(p_Size, m_Size - m_Position);
+            ::memcpy(p_pBuffer, m_pData + m_Position, toRead);
+            m_Position += toRead;
+            if (p_pRead != nullptr) {
+                *p_pRead = toRead;
+            }
+            hRes = toRead == p_Size ? S_OK : S_FALSE;
+        }
+        return hRes;
+    }
+
+    //
+    // ISequentialStream::Write. Not supported, since stream is read-only.
+    //
+    STDMETHODIMP ReadOnlyMemoryStream::Write(const void* /*p_pBuffer*/,
+                                             ULONG /*p_Size*/,
+                                             ULONG* p_pWritten)
+    {
+        if (p_pWritten != nullptr) {
+            *p_pWritten = 0;
+        }
+        return STG_E_ACCESSDENIED;
+    }
+
+    //
+    // IStream::Seek
+    //
+    STDMETHODIMP ReadOnlyMemoryStream::Seek(LARGE_INTEGER p_Move,
+                                            DWORD p_Origin,
+                                            ULARGE_INTEGER* p_pNewPosition)
+    {
+        HRESULT hRes = S_OK;
+        LONGLONG newPosition = 0;
+        switch (p_Origin) {
+            case STREAM_SEEK_SET: {
+                newPosition = p_Move.QuadPart;
+                break;
+            }
+            case STREAM_SEEK_CUR: {
+                newPosition = static_cast<LONGLONG>(m_Position) + p_Move.QuadPart;
+                break;
+            }
+            case STREAM_SEEK_END: {
+                newPosition = static_cast<LONGLONG>(m_Size) + p_Move.QuadPart;
+                break;
+            }
+            default: {
+                hRes = STG_E_INVALIDFUNCTION;
+                break;
+            }
+        }
+        if (SUCCEEDED(hRes)) {
+            if (newPosition < 0 || newPosition > static_cast<LONGLONG>(m_Size)) {
+                hRes = STG_E_INVALIDFUNCTION;
+            } else {
+                m_Position = static_cast<ULONG>(newPosition);
+                if (p_pNewPosition != nullptr) {
+                    p_pNewPosition->QuadPart = m_Position;
+                }
+            }
+        }
+        return hRes;
+    }
+
+    //
+    // IStream::SetSize. Not supported, since stream is read-only.
+    //
+    STDMETHODIMP ReadOnlyMemoryStream::SetSize(ULARGE_INTEGER /*p_NewSize*/)
+    {
+        return STG_E_ACCESSDENIED;
+    }
+
+    //
+    // IStream::CopyTo
+    //
+    STDMETHODIMP ReadOnlyMemoryStream::CopyTo(IStream* p_pStream,
+                                              ULARGE_INTEGER p_Size,
+                                              ULARGE_INTEGER* p_pRead,
+                                              ULARGE_INTEGER* p_pWritten)
+    {
+        HRESULT hRes = STG_E_INVALIDPOINTER;
+        if (p_pStream != nullptr) {
+            const ULONG toCopy = static_cast<ULONG>((std::min)(p_Size.QuadPart,
+                static_cast<ULONGLONG>(m_Size - m_Position)));
+            ULONG written = 0;
+            hRes = p_pStream->Write(m_pData + m_Position, toCopy, &written);
+            m_Position += toCopy;
+            if (p_pRead != nullptr) {
+                p_pRead->QuadPart = toCopy;
+            }
+            if (p_pWritten != nullptr) {
+                p_pWritten->QuadPart = written;
+            }
+        }
+        return hRes;
+    }
+
+    //
+    // IStream::Commit. Nothing to commit in a read-only stream.
+    //
+    STDMETHODIMP ReadOnlyMemoryStream::Commit(DWORD /*p_Flags*/)
+    {
+        return S_OK;
+    }
+
+    //
+    // IStream::Revert. Nothing to revert in a read-only stream.
+    //
+    STDMETHODIMP ReadOnlyMemoryStream::Revert()
+    {
+        return S_OK;
+    }
+
+    //
+    // IStream::LockRegion. Not supported.
+    //
+    STDMETHODIMP ReadOnlyMemoryStream::LockRegion(ULARGE_INTEGER /*p_Offset*/,
+                                                  ULARGE_INTEGER /*p_Size*/,
+                                                  DWORD /*p_LockType*/)
+    {
+        return STG_E_INVALIDFUNCTION;
+    }
+
+    //
+    // IStream::UnlockRegion. Not supported.
+    //
+    STDMETHODIMP ReadOnlyMemoryStream::UnlockRegion(ULARGE_INTEGER /*p_Offset*/,
+                                                    ULARGE_INTEGER /*p_Size*/,
+                                                    DWORD /*p_LockType*/)
+    {
+        return STG_E_INVALIDFUNCTION;
+    }
+
+    //
+    // IStream::Stat
+    //
+    STDMETHODIMP ReadOnlyMemoryStream::Stat(STATSTG* p_pStatStg,
+                                            DWORD /*p_StatFlag*/)
+    {
+        HRESULT hRes = STG_E_INVALIDPOINTER;
+        if (p_pStatStg != nullptr) {
+            ::memset(p_pStatStg, 0, sizeof(STATSTG));
+            p_pStatStg->type = STGTY_STREAM;
+            p_pStatStg->cbSize.QuadPart = m_Size;
+            p_pStatStg->grfMode = STGM_READ;
+            hRes = S_OK;
+        }
+        return hRes;
+    }
+
+    //
+    // IStream::Clone
+    //
+    STDMETHODIMP ReadOnlyMemoryStream::Clone(IStream** p_ppStream)
+    {
+        HRESULT hRes = Create(m_pData, m_Size, p_ppStream);
+        if (SUCCEEDED(hRes)) {
+            LARGE_INTEGER position;
+            position.QuadPart = m_Position;
+            hRes = (*p_ppStream)->Seek(position, STREAM_SEEK_SET, nullptr);
+        }
+        return hRes;
+    }
+
+} // namespace PCC
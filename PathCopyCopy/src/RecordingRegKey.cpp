@@ -0,0 +1,266 @@
+// RecordingRegKey.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <stdafx.h>
+
+#ifdef PCC_BENCHMARKS
+
+#include <RecordingRegKey.h>
+
+
+//
+// Constructor.
+//
+// @param p_rKey Key to forward calls to. Must outlive this object.
+//
+RecordingRegKey::RecordingRegKey(RegKey& p_rKey)
+    : RegKey(),
+      m_rKey(p_rKey),
+      m_aCallCounts()
+{
+    ResetCallCounts();
+}
+
+//
+// Returns the number of calls made to an operation so far.
+//
+// @param p_Operation Operation to check.
+// @return Number of calls made.
+//
+unsigned long RecordingRegKey::GetCallCount(const Operation p_Operation) const
+{
+    return m_aCallCounts[static_cast<size_t>(p_Operation)];
+}
+
+//
+// Returns the number of calls made to operations that read values so far.
+// This corresponds to the number of registry round trips for a real key.
+//
+// @return Number of queries made.
+//
+unsigned long RecordingRegKey::GetQueryCount() const
+{
+    return GetCallCount(Operation::QueryDWORDValue) +
+           GetCallCount(Operation::QueryQWORDValue) +
+           GetCallCount(Operation::QueryGUIDValue) +
+           GetCallCount(Operation::QueryValue) +
+           GetCallCount(Operation::GetValues) +
+           GetCallCount(Operation::GetSubKeys);
+}
+
+//
+// Returns the number of calls made to all operations so far.
+//
+// @return Number of calls made.
+//
+unsigned long RecordingRegKey::GetTotalCallCount() const
+{
+    unsigned long total = 0;
+    for (const auto& callCount : m_aCallCounts) {
+        total += callCount;
+    }
+    return total;
+}
+
+//
+// Resets the call counts of all operations to zero.
+//
+void RecordingRegKey::ResetCallCounts()
+{
+    for (auto& callCount : m_aCallCounts) {
+        callCount = 0;
+    }
+}
+
+//
+// Checks if the wrapped key is valid.
+//
+// @return true if registry key is valid.
+//
+bool RecordingRegKey::Valid() const
+{
+    Record(Operation::Valid);
+    return m_rKey.Valid();
+}
+
+//
+// Loads a DWORD value from the wrapped key.
+//
+// @param p_pValueName Name of value to load.
+// @param p_rValue Where to store value.
+// @return Result code (ERROR_SUCCESS if it worked).
+//
+long RecordingRegKey::QueryDWORDValue(const wchar_t* const p_pValueName,
+                                      DWORD& p_rValue) const
+{
+    Record(Operation::QueryDWORDValue);
+    return m_rKey.QueryDWORDValue(p_pValueName, p_rValue);
+}
+
+//
+// Loads a QWORD value from the wrapped key.
+//
+// @param p_pValueName Name of value to load.
+// @param p_rValue Where to store value.
+// @return Result code (ERROR_SUCCESS if it worked).
+//
+long RecordingRegKey::QueryQWORDValue(const wchar_t* const p_pValueName,
+                                      ULONGLONG& p_rValue) const
+{
+    Record(Operation::QueryQWORDValue);
+    return m_rKey.QueryQWORDValue(p_pValueName, p_rValue);
+}
+
+//
+// Loads a GUID value from the wrapped key.
+//
+// @param p_pValueName Name of value to load.
+// @param p_rValue Where to store value.
+// @return Result code (ERROR_SUCCESS if it worked).
+//
+long RecordingRegKey::QueryGUIDValue(const wchar_t* const p_pValueName,
+                                     GUID& p_rValue) const
+{
+    Record(Operation::QueryGUIDValue);
+    return m_rKey.QueryGUIDValue(p_pValueName, p_rValue);
+}
+
+//
+// Loads a value from the wrapped key.
+//
+// @param p_pValueName Name of value to load.
+// @param p_pValueType If set, will receive the type of value.
+// @param p_pValue Pointer to buffer where to store value. Can be null.
+// @param p_pValueSize Pointer to variable containing the size of p_pValue.
+//                     Upon exit, will contain the actual size of the
+//                     value copied to p_pValue. Can be null only if p_pValue is too.
+// @return Result code (ERROR_SUCCESS if it worked).
+//
+long RecordingRegKey::QueryValue(const wchar_t* const p_pValueName,
+                                 DWORD* const p_pValueType,
+                                 void* const p_pValue,
+                                 DWORD* const p_pValueSize) const
+{
+    Record(Operation::QueryValue);
+    return m_rKey.QueryValue(p_pValueName, p_pValueType, p_pValue, p_pValueSize);
+}
+
+//
+// Returns a list of values in the wrapped key.
+//
+// @param p_rvValues Where to store information about the values.
+//
+void RecordingRegKey::GetValues(ValueInfoV& p_rvValues) const
+{
+    Record(Operation::GetValues);
+    m_rKey.GetValues(p_rvValues);
+}
+
+//
+// Returns a list of subkeys of the wrapped key.
+//
+// @param p_rvSubkeys Where to store information about the subkeys.
+//
+void RecordingRegKey::GetSubKeys(SubkeyInfoV& p_rvSubkeys) const
+{
+    Record(Operation::GetSubKeys);
+    m_rKey.GetSubKeys(p_rvSubkeys);
+}
+
+//
+// Saves a DWORD value in the wrapped key.
+//
+// @param p_pValueName Name of value to save.
+// @param p_pValue Value to save.
+// @return Result code (ERROR_SUCCESS if it worked).
+//
+long RecordingRegKey::SetDWORDValue(const wchar_t* const p_pValueName,
+                                    const DWORD p_Value)
+{
+    Record(Operation::SetDWORDValue);
+    return m_rKey.SetDWORDValue(p_pValueName, p_Value);
+}
+
+//
+// Saves a QWORD value in the wrapped key.
+//
+// @param p_pValueName Name of value to save.
+// @param p_pValue Value to save.
+// @return Result code (ERROR_SUCCESS if it worked).
+//
+long RecordingRegKey::SetQWORDValue(const wchar_t* const p_pValueName,
+                                    const ULONGLONG p_Value)
+{
+    Record(Operation::SetQWORDValue);
+    return m_rKey.SetQWORDValue(p_pValueName, p_Value);
+}
+
+//
+// Saves a GUID value in the wrapped key.
+//
+// @param p_pValueName Name of value to save.
+// @param p_pValue Value to save.
+// @return Result code (ERROR_SUCCESS if it worked).
+//
+long RecordingRegKey::SetGUIDValue(const wchar_t* const p_pValueName,
+                                   const GUID& p_Value)
+{
+    Record(Operation::SetGUIDValue);
+    return m_rKey.SetGUIDValue(p_pValueName, p_Value);
+}
+
+//
+// Saves a string value in the wrapped key.
+//
+// @param p_pValueName Name of value to save.
+// @param p_pValue Value to save.
+// @return Result code (ERROR_SUCCESS if it worked).
+//
+long RecordingRegKey::SetStringValue(const wchar_t* const p_pValueName,
+                                     const wchar_t* const p_pValue)
+{
+    Record(Operation::SetStringValue);
+    return m_rKey.SetStringValue(p_pValueName, p_pValue);
+}
+
+//
+// Deletes a value from the wrapped key.
+//
+// @param p_pValueName Name of value to delete.
+// @return Result code (ERROR_SUCCESS if it worked).
+//
+long RecordingRegKey::DeleteValue(const wchar_t* const p_pValueName)
+{
+    Record(Operation::DeleteValue);
+    return m_rKey.DeleteValue(p_pValueName);
+}
+
+//
+// Records a call to an operation.
+//
+// @param p_Operation Operation called.
+//
+void RecordingRegKey::Record(const Operation p_Operation) const
+{
+    ++m_aCallCounts[static_cast<size_t>(p_Operation)];
+}
+
+#endif // PCC_BENCHMARKS
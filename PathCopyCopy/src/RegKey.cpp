@@ -56,7 +56,8 @@ RegKey::ValueInfo::ValueInfo(HKEY const p_hKey,
 //
 RegKey::SubkeyInfo::SubkeyInfo()
     : m_hParent(NULL),
-      m_KeyName()
+      m_KeyName(),
+      m_LastWriteTime()
 {
 }
 
@@ -65,10 +66,13 @@ RegKey::SubkeyInfo::SubkeyInfo()
 //
 // @param p_hParent Handle of parent key.
 // @param p_pKeyName Name of subkey.
+// @param p_LastWriteTime Last write time of subkey, or zero if unknown.
 //
 RegKey::SubkeyInfo::SubkeyInfo(HKEY const p_hParent,
-                               const wchar_t* const p_pKeyName)
+                               const wchar_t* const p_pKeyName,
+                               const FILETIME& p_LastWriteTime /*= FILETIME()*/)
     : m_hParent(p_hParent),
-      m_KeyName(p_pKeyName)
+      m_KeyName(p_pKeyName),
+      m_LastWriteTime(p_LastWriteTime)
 {
 }
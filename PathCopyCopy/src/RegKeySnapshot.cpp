@@ -0,0 +1,830 @@
+// RegKeySnapshot.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <stdafx.h>
+#include <RegKeySnapshot.h>
+#include <PluginUtils.h>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <string.h>
+
+
+// Image base is provided by the linker. We can use it to locate our DLL. See GetModuleWriteTime().
+EXTERN_C IMAGE_DOS_HEADER __ImageBase;
+
+
+namespace
+{
+    // Prefix and size of shared memory sections storing shared snapshots.
+    // Sections are created in the session namespace and are per-user.
+    const wchar_t* const    SHARED_SECTION_NAME_PREFIX  = L"Local\\PathCopyCopy.RegKeySnapshot.";
+    const DWORD             SHARED_SECTION_SIZE         = 64 * 1024;
+
+    // Name of folder storing persisted snapshots, in the user's local application
+    // data folder, and extension of snapshot files.
+    const wchar_t* const    PERSISTED_FOLDER_NAME       = L"PathCopyCopy";
+    const wchar_t* const    PERSISTED_FILE_EXTENSION    = L".snapshot";
+
+    // Signature and format version stored in persisted snapshot files.
+    const DWORD             PERSISTED_SIGNATURE         = 0x53434350;   // "PCCS"
+    const DWORD             PERSISTED_FORMAT_VERSION    = 1;
+
+    // Flags stored in a shared snapshot's header.
+    const DWORD             SHARED_FLAG_HAS_DATA        = 0x1;
+    const DWORD             SHARED_FLAG_LOCKED          = 0x2;
+
+    //
+    // Header at the beginning of a shared memory section storing a snapshot.
+    // Its data, a sequence of values, follows immediately after.
+    //
+    struct SharedSnapshotHeader {
+        volatile LONG   m_Sequence;             // Incremented before and after writes; odd while writing.
+        DWORD           m_Flags;                // Combination of SHARED_FLAG_* values.
+        FILETIME        m_UserKeyWriteTime;     // Last write time of user key when snapshot was taken.
+        FILETIME        m_GlobalKeyWriteTime;   // Last write time of global key when snapshot was taken.
+        DWORD           m_DataSize;             // Size of data following header, in bytes.
+    };
+
+    //
+    // Header of a single value stored in a shared snapshot's data.
+    // It is followed by the value name (without terminating null) and data.
+    //
+    struct SharedValueHeader {
+        DWORD           m_NameSize;             // Size of value name, in characters.
+        DWORD           m_Type;                 // Type of value.
+        DWORD           m_DataSize;             // Size of value data, in bytes.
+        DWORD           m_FromUserKey;          // Whether value comes from user key (otherwise from global key).
+    };
+
+    //
+    // Header at the beginning of a file storing a persisted snapshot.
+    // Its data, in the same format as a shared snapshot, follows immediately after.
+    //
+    struct PersistedSnapshotHeader {
+        DWORD           m_Signature;            // Always PERSISTED_SIGNATURE.
+        DWORD           m_FormatVersion;        // Always PERSISTED_FORMAT_VERSION.
+        FILETIME        m_ModuleWriteTime;      // Last write time of our DLL when snapshot was persisted.
+        DWORD           m_Flags;                // Combination of SHARED_FLAG_* values.
+        FILETIME        m_UserKeyWriteTime;     // Last write time of user key when snapshot was taken.
+        FILETIME        m_GlobalKeyWriteTime;   // Last write time of global key when snapshot was taken.
+        DWORD           m_DataSize;             // Size of data following header, in bytes.
+    };
+
+    //
+    // Mapped view of a shared memory section. Kept open for the lifetime
+    // of the process so that the section survives while we're loaded.
+    //
+    struct SharedSection {
+        ATL::CHandle    m_hMapping;             // Handle to file mapping object.
+        void*           m_pView;                // Mapped view of the section.
+
+                        SharedSection() : m_hMapping(), m_pView(nullptr) { }
+                        SharedSection(const SharedSection&) = delete;
+        SharedSection&  operator=(const SharedSection&) = delete;
+                        ~SharedSection()
+                        {
+                            if (m_pView != nullptr) {
+                                ::UnmapViewOfFile(m_pView);
+                            }
+                        }
+    };
+
+    // Shared memory sections opened by this process, by snapshot name.
+    std::map<std::wstring, std::unique_ptr<SharedSection>>
+                            s_mupSharedSections;
+    std::wstring            s_UserSid;
+    bool                    s_UserSidFetched            = false;
+    std::mutex              s_SharedSectionsLock;
+    FILETIME                s_ModuleWriteTime           = FILETIME();
+    bool                    s_ModuleWriteTimeFetched    = false;
+    std::wstring            s_PersistedFolder;
+    bool                    s_PersistedFolderFetched    = false;
+
+    //
+    // Returns the header of the shared memory section with the given name,
+    // creating or opening it if needed.
+    //
+    // @param p_pSharedName Name of shared snapshot.
+    // @return Pointer to section header, or nullptr if section is not available.
+    //
+    SharedSnapshotHeader* GetSharedSection(const wchar_t* const p_pSharedName)
+    {
+        std::lock_guard<std::mutex> lock(s_SharedSectionsLock);
+        if (!s_UserSidFetched) {
+            s_UserSid = PCC::PluginUtils::GetCurrentUserSid();
+            s_UserSidFetched = true;
+        }
+        if (s_UserSid.empty()) {
+            return nullptr;
+        }
+
+        std::unique_ptr<SharedSection>& rupSection = s_mupSharedSections[p_pSharedName];
+        if (rupSection == nullptr) {
+            rupSection.reset(new SharedSection());
+            std::wstring sectionName = SHARED_SECTION_NAME_PREFIX;
+            sectionName += p_pSharedName;
+            sectionName += L'.';
+            sectionName += s_UserSid;
+            rupSection->m_hMapping.Attach(::CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                                               0, SHARED_SECTION_SIZE, sectionName.c_str()));
+            if (rupSection->m_hMapping != NULL) {
+                rupSection->m_pView = ::MapViewOfFile(rupSection->m_hMapping, FILE_MAP_READ | FILE_MAP_WRITE,
+                                                      0, 0, SHARED_SECTION_SIZE);
+            }
+        }
+        return static_cast<SharedSnapshotHeader*>(rupSection->m_pView);
+    }
+
+    //
+    // Returns the last write time of our DLL. Used to make sure persisted
+    // snapshots are not reused by another version of our code.
+    //
+    // @return Last write time of our DLL, or zero if it cannot be determined.
+    //
+    FILETIME GetModuleWriteTime()
+    {
+        std::lock_guard<std::mutex> lock(s_SharedSectionsLock);
+        if (!s_ModuleWriteTimeFetched) {
+            wchar_t dllPath[MAX_PATH + 1];
+            DWORD siz = ::GetModuleFileNameW((HINSTANCE)&__ImageBase, dllPath, MAX_PATH + 1);
+            WIN32_FILE_ATTRIBUTE_DATA attributes;
+            if (siz != 0 && siz <= MAX_PATH &&
+                ::GetFileAttributesExW(dllPath, GetFileExInfoStandard, &attributes)) {
+
+                s_ModuleWriteTime = attributes.ftLastWriteTime;
+            }
+            s_ModuleWriteTimeFetched = true;
+        }
+        return s_ModuleWriteTime;
+    }
+
+    //
+    // Returns the path to the file storing the persisted snapshot with the
+    // given name, creating its folder if needed.
+    //
+    // @param p_pSharedName Name of shared snapshot.
+    // @return Path to snapshot file, or an empty string if folder is not available.
+    //
+    std::wstring GetPersistedFilePath(const wchar_t* const p_pSharedName)
+    {
+        std::lock_guard<std::mutex> lock(s_SharedSectionsLock);
+        if (!s_PersistedFolderFetched) {
+            wchar_t appDataPath[MAX_PATH + 1];
+            if (SUCCEEDED(::SHGetFolderPathW(nullptr, CSIDL_LOCAL_APPDATA | CSIDL_FLAG_CREATE,
+                                             nullptr, SHGFP_TYPE_CURRENT, appDataPath))) {
+                std::wstring folder = appDataPath;
+                folder += L'\\';
+                folder += PERSISTED_FOLDER_NAME;
+                if (::CreateDirectoryW(folder.c_str(), nullptr) || ::GetLastError() == ERROR_ALREADY_EXISTS) {
+                    s_PersistedFolder = folder;
+                }
+            }
+            s_PersistedFolderFetched = true;
+        }
+        std::wstring filePath;
+        if (!s_PersistedFolder.empty()) {
+            filePath = s_PersistedFolder;
+            filePath += L'\\';
+            filePath += p_pSharedName;
+            filePath += PERSISTED_FILE_EXTENSION;
+        }
+        return filePath;
+    }
+
+    //
+    // Checks if two FILETIMEs are equal.
+    //
+    // @param p_Time1 First time.
+    // @param p_Time2 Second time.
+    // @return true if both times are equal.
+    //
+    bool FileTimesEqual(const FILETIME& p_Time1,
+                        const FILETIME& p_Time2)
+    {
+        return p_Time1.dwLowDateTime == p_Time2.dwLowDateTime &&
+               p_Time1.dwHighDateTime == p_Time2.dwHighDateTime;
+    }
+
+} // anonymous namespace
+
+
+//
+// Constructor. Loads all values of the user and global keys in memory.
+//
+// @param p_Key Key to take a snapshot of. Must outlive this object.
+// @param p_pSharedName If set, name of a snapshot shared with other processes.
+//                      If it is up to date, it will be loaded instead of the
+//                      registry keys; otherwise, it will be updated.
+//
+RegKeySnapshot::RegKeySnapshot(const UserOverrideableRegKey& p_Key,
+                               const wchar_t* const p_pSharedName /*= nullptr*/)
+    : RegKey(),
+      m_Key(p_Key),
+      m_mValues(),
+      m_Valid(p_Key.Valid()),
+      m_Locked(false)
+{
+    KeyStamp stamp = KeyStamp();
+    if (p_pSharedName != nullptr) {
+        stamp = GetKeyStamp();
+    }
+    if (p_pSharedName == nullptr || !LoadShared(p_pSharedName, stamp)) {
+        if (p_pSharedName != nullptr && LoadPersisted(p_pSharedName, stamp)) {
+            // Share what we loaded so that other processes don't have to read the file.
+            SaveShared(p_pSharedName, stamp);
+        } else {
+            // Load user values first; since map insertions do not replace
+            // existing values, they will take precedence over global values.
+            m_Locked = p_Key.Locked();
+            if (!m_Locked) {
+                LoadValues(p_Key.GetUserKey().GetHKEY());
+            }
+            LoadValues(p_Key.GetGlobalKey().GetHKEY());
+
+            if (p_pSharedName != nullptr) {
+                SaveShared(p_pSharedName, stamp);
+                SavePersisted(p_pSharedName, stamp);
+            }
+        }
+    }
+}
+
+//
+// Checks if the source registry key was valid when the snapshot was taken.
+//
+// @return true if registry key is valid.
+//
+bool RegKeySnapshot::Valid() const
+{
+    return m_Valid;
+}
+
+//
+// Checks whether the user registry key was locked in the global key
+// when the snapshot was taken.
+//
+// @return true if the user key is locked and cannot be edited.
+//
+bool RegKeySnapshot::Locked() const
+{
+    return m_Locked;
+}
+
+//
+// Tries to load a DWORD value from the snapshot.
+//
+// @param p_pValueName Name of value to load.
+// @param p_rValue Where to store value.
+// @return Result code (ERROR_SUCCESS if it worked).
+//
+long RegKeySnapshot::QueryDWORDValue(const wchar_t* const p_pValueName,
+                                     DWORD& p_rValue) const
+{
+    long res = ERROR_FILE_NOT_FOUND;
+    const ValueData* const pValue = FindValue(p_pValueName);
+    if (pValue != nullptr) {
+        if (pValue->m_Type == REG_DWORD && pValue->m_vData.size() == sizeof(DWORD)) {
+            ::memcpy(&p_rValue, pValue->m_vData.data(), sizeof(DWORD));
+            res = ERROR_SUCCESS;
+        } else {
+            res = ERROR_INVALID_DATA;
+        }
+    }
+    return res;
+}
+
+//
+// Tries to load a QWORD value from the snapshot.
+//
+// @param p_pValueName Name of value to load.
+// @param p_rValue Where to store value.
+// @return Result code (ERROR_SUCCESS if it worked).
+//
+long RegKeySnapshot::QueryQWORDValue(const wchar_t* const p_pValueName,
+                                     ULONGLONG& p_rValue) const
+{
+    long res = ERROR_FILE_NOT_FOUND;
+    const ValueData* const pValue = FindValue(p_pValueName);
+    if (pValue != nullptr) {
+        if (pValue->m_Type == REG_QWORD && pValue->m_vData.size() == sizeof(ULONGLONG)) {
+            ::memcpy(&p_rValue, pValue->m_vData.data(), sizeof(ULONGLONG));
+            res = ERROR_SUCCESS;
+        } else {
+            res = ERROR_INVALID_DATA;
+        }
+    }
+    return res;
+}
+
+//
+// Tries to load a GUID value from the snapshot (stored as a string).
+//
+// @param p_pValueName Name of value to load.
+// @param p_rValue Where to store value.
+// @return Result code (ERROR_SUCCESS if it worked).
+//
+long RegKeySnapshot::QueryGUIDValue(const wchar_t* const p_pValueName,
+                                    GUID& p_rValue) const
+{
+    long res = ERROR_FILE_NOT_FOUND;
+    const ValueData* const pValue = FindValue(p_pValueName);
+    if (pValue != nullptr) {
+        res = ERROR_INVALID_DATA;
+        if (pValue->m_Type == REG_SZ && (pValue->m_vData.size() % sizeof(wchar_t)) == 0) {
+            std::wstring guidAsString(reinterpret_cast<const wchar_t*>(pValue->m_vData.data()),
+                                      pValue->m_vData.size() / sizeof(wchar_t));
+            guidAsString.resize(::wcsnlen(guidAsString.c_str(), guidAsString.size()));
+            if (SUCCEEDED(::CLSIDFromString(guidAsString.c_str(), &p_rValue))) {
+                res = ERROR_SUCCESS;
+            }
+        }
+    }
+    return res;
+}
+
+//
+// Tries to load a value from the snapshot.
+//
+// @param p_pValueName Name of value to load.
+// @param p_pValueType If set, will receive the type of value.
+// @param p_pValue Pointer to buffer where to store value. Can be null.
+// @param p_pValueSize Pointer to variable containing the size of p_pValue.
+//                     Upon exit, will contain the actual size of the
+//                     value copied to p_pValue. Can be null only if p_pValue is too.
+// @return Result code (ERROR_SUCCESS if it worked).
+//
+long RegKeySnapshot::QueryValue(const wchar_t* const p_pValueName,
+                                DWORD* const p_pValueType,
+                                void* const p_pValue,
+                                DWORD* const p_pValueSize) const
+{
+    long res = ERROR_FILE_NOT_FOUND;
+    if (p_pValue != nullptr && p_pValueSize == nullptr) {
+        res = ERROR_INVALID_PARAMETER;
+    } else {
+        const ValueData* const pValue = FindValue(p_pValueName);
+        if (pValue != nullptr) {
+            const DWORD dataSize = static_cast<DWORD>(pValue->m_vData.size());
+            res = ERROR_SUCCESS;
+            if (p_pValue != nullptr) {
+                if (*p_pValueSize >= dataSize) {
+                    ::memcpy(p_pValue, pValue->m_vData.data(), dataSize);
+                } else {
+                    res = ERROR_MORE_DATA;
+                }
+            }
+            if (p_pValueType != nullptr) {
+                *p_pValueType = pValue->m_Type;
+            }
+            if (p_pValueSize != nullptr) {
+                *p_pValueSize = dataSize;
+            }
+        }
+    }
+    return res;
+}
+
+//
+// Returns a list of all values in the snapshot.
+//
+// @param p_rvValues Where to store information about the values.
+//
+void RegKeySnapshot::GetValues(ValueInfoV& p_rvValues) const
+{
+    p_rvValues.reserve(p_rvValues.size() + m_mValues.size());
+    for (const auto& nameAndValue : m_mValues) {
+        p_rvValues.emplace_back(nameAndValue.second.m_hKey, nameAndValue.first.c_str());
+    }
+}
+
+//
+// Returns a list of subkeys of the source key. Subkeys are not part
+// of the snapshot, so this is forwarded to the source key.
+//
+// @param p_rvSubkeys Where to store information about the subkeys.
+//
+void RegKeySnapshot::GetSubKeys(SubkeyInfoV& p_rvSubkeys) const
+{
+    m_Key.GetSubKeys(p_rvSubkeys);
+}
+
+//
+// Snapshots are read-only; cannot set values.
+//
+long RegKeySnapshot::SetDWORDValue(const wchar_t* const /*p_pValueName*/,
+                                   const DWORD /*p_Value*/)
+{
+    return ERROR_ACCESS_DENIED;
+}
+
+//
+// Snapshots are read-only; cannot set values.
+//
+long RegKeySnapshot::SetQWORDValue(const wchar_t* const /*p_pValueName*/,
+                                   const ULONGLONG /*p_Value*/)
+{
+    return ERROR_ACCESS_DENIED;
+}
+
+//
+// Snapshots are read-only; cannot set values.
+//
+long RegKeySnapshot::SetGUIDValue(const wchar_t* const /*p_pValueName*/,
+                                  const GUID& /*p_Value*/)
+{
+    return ERROR_ACCESS_DENIED;
+}
+
+//
+// Snapshots are read-only; cannot set values.
+//
+long RegKeySnapshot::SetStringValue(const wchar_t* const /*p_pValueName*/,
+                                    const wchar_t* const /*p_pValue*/)
+{
+    return ERROR_ACCESS_DENIED;
+}
+
+//
+// Snapshots are read-only; cannot delete values.
+//
+long RegKeySnapshot::DeleteValue(const wchar_t* const /*p_pValueName*/)
+{
+    return ERROR_ACCESS_DENIED;
+}
+
+//
+// Compares two value names, ignoring case.
+//
+// @param p_Name1 First value name.
+// @param p_Name2 Second value name.
+// @return true if p_Name1 is before p_Name2.
+//
+bool RegKeySnapshot::ValueNameLess::operator()(const std::wstring& p_Name1,
+                                               const std::wstring& p_Name2) const
+{
+    return ::_wcsicmp(p_Name1.c_str(), p_Name2.c_str()) < 0;
+}
+
+//
+// Enumerates all values in the given registry key and adds them to
+// our snapshot, unless a value with the same name is already there.
+//
+// @param p_hKey Handle of registry key to enumerate. Can be NULL.
+//
+void RegKeySnapshot::LoadValues(HKEY const p_hKey)
+{
+    if (p_hKey != NULL) {
+        // Find out how big our buffers need to be so that we can
+        // fetch each value's name and data in a single call.
+        DWORD maxValueNameSize = 0, maxValueDataSize = 0;
+        LONG res = ::RegQueryInfoKeyW(p_hKey, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+                                      nullptr, &maxValueNameSize, &maxValueDataSize, nullptr, nullptr);
+        std::unique_ptr<wchar_t[]> upValueName;
+        std::vector<BYTE> vValueData;
+        DWORD index = 0;
+        while (res == ERROR_SUCCESS) {
+            if (upValueName == nullptr) {
+                upValueName.reset(new wchar_t[maxValueNameSize + 1]);
+                vValueData.resize(maxValueDataSize);
+            }
+            DWORD valueNameSize = maxValueNameSize + 1;
+            DWORD valueType = REG_NONE;
+            DWORD valueDataSize = maxValueDataSize;
+            res = ::RegEnumValueW(p_hKey, index, upValueName.get(), &valueNameSize, nullptr, &valueType,
+                                  vValueData.empty() ? nullptr : vValueData.data(), &valueDataSize);
+            if (res == ERROR_SUCCESS) {
+                if (m_mValues.find(upValueName.get()) == m_mValues.end()) {
+                    ValueData& rValue = m_mValues[upValueName.get()];
+                    rValue.m_hKey = p_hKey;
+                    rValue.m_Type = valueType;
+                    rValue.m_vData.assign(vValueData.cbegin(), vValueData.cbegin() + valueDataSize);
+                }
+                ++index;
+            } else if (res == ERROR_MORE_DATA) {
+                // A value was modified while we enumerated; get new sizes and retry.
+                res = ::RegQueryInfoKeyW(p_hKey, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+                                         nullptr, &maxValueNameSize, &maxValueDataSize, nullptr, nullptr);
+                upValueName.reset();
+            }
+        }
+    }
+}
+
+//
+// Looks for a value in the snapshot.
+//
+// @param p_pValueName Name of value to look for. Can be null or empty to look for the default value.
+// @return Pointer to value data, or nullptr if value does not exist.
+//
+const RegKeySnapshot::ValueData* RegKeySnapshot::FindValue(const wchar_t* const p_pValueName) const
+{
+    auto it = m_mValues.find(p_pValueName != nullptr ? p_pValueName : L"");
+    return it != m_mValues.end() ? &it->second : nullptr;
+}
+
+//
+// Returns the last write times of the source keys. If any of them
+// changes, a shared snapshot taken before will no longer be valid.
+//
+// @return Stamp containing the last write times.
+//
+RegKeySnapshot::KeyStamp RegKeySnapshot::GetKeyStamp() const
+{
+    KeyStamp stamp = KeyStamp();
+    HKEY hUserKey = m_Key.GetUserKey().GetHKEY();
+    if (hUserKey != NULL) {
+        ::RegQueryInfoKeyW(hUserKey, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+                           nullptr, nullptr, nullptr, nullptr, &stamp.m_UserKeyWriteTime);
+    }
+    HKEY hGlobalKey = m_Key.GetGlobalKey().GetHKEY();
+    if (hGlobalKey != NULL) {
+        ::RegQueryInfoKeyW(hGlobalKey, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+                           nullptr, nullptr, nullptr, nullptr, &stamp.m_GlobalKeyWriteTime);
+    }
+    return stamp;
+}
+
+//
+// Attempts to load our values from a snapshot shared by another process.
+//
+// @param p_pSharedName Name of shared snapshot.
+// @param p_Stamp Current last write times of the source keys.
+// @return true if shared snapshot was up to date and was loaded.
+//
+bool RegKeySnapshot::LoadShared(const wchar_t* const p_pSharedName,
+                                const KeyStamp& p_Stamp)
+{
+    SharedSnapshotHeader* const pHeader = GetSharedSection(p_pSharedName);
+    if (pHeader == nullptr) {
+        return false;
+    }
+
+    // Copy the snapshot locally, making sure it wasn't modified while we copied it.
+    const LONG sequence = pHeader->m_Sequence;
+    ::MemoryBarrier();
+    if ((sequence & 1) != 0 || (pHeader->m_Flags & SHARED_FLAG_HAS_DATA) == 0 ||
+        !FileTimesEqual(pHeader->m_UserKeyWriteTime, p_Stamp.m_UserKeyWriteTime) ||
+        !FileTimesEqual(pHeader->m_GlobalKeyWriteTime, p_Stamp.m_GlobalKeyWriteTime)) {
+
+        return false;
+    }
+    const bool locked = (pHeader->m_Flags & SHARED_FLAG_LOCKED) != 0;
+    const DWORD dataSize = (std::min)(pHeader->m_DataSize,
+                                      static_cast<DWORD>(SHARED_SECTION_SIZE - sizeof(SharedSnapshotHeader)));
+    std::vector<BYTE> vData(reinterpret_cast<const BYTE*>(pHeader + 1),
+                            reinterpret_cast<const BYTE*>(pHeader + 1) + dataSize);
+    ::MemoryBarrier();
+    if (pHeader->m_Sequence != sequence) {
+        return false;
+    }
+
+    // Parse values.
+    ValueDataM mValues;
+    if (!ParseValues(vData.data(), vData.size(), mValues)) {
+        return false;
+    }
+
+    m_mValues = std::move(mValues);
+    m_Locked = locked;
+    return true;
+}
+
+//
+// Stores our values in a snapshot shared with other processes. If the
+// snapshot is too large or is being written by another process, this
+// does nothing.
+//
+// @param p_pSharedName Name of shared snapshot.
+// @param p_Stamp Last write times of the source keys before we loaded our values.
+//
+void RegKeySnapshot::SaveShared(const wchar_t* const p_pSharedName,
+                                const KeyStamp& p_Stamp) const
+{
+    SharedSnapshotHeader* const pHeader = GetSharedSection(p_pSharedName);
+    if (pHeader == nullptr) {
+        return;
+    }
+
+    // Serialize values first.
+    const std::vector<BYTE> vData = SerializeValues();
+    if (vData.size() > SHARED_SECTION_SIZE - sizeof(SharedSnapshotHeader)) {
+        return;
+    }
+
+    // Mark the section as being written; if another process is already writing, let it.
+    const LONG sequence = pHeader->m_Sequence;
+    if ((sequence & 1) != 0 || ::InterlockedCompareExchange(&pHeader->m_Sequence, sequence + 1, sequence) != sequence) {
+        return;
+    }
+    pHeader->m_Flags = SHARED_FLAG_HAS_DATA | (m_Locked ? SHARED_FLAG_LOCKED : 0);
+    pHeader->m_UserKeyWriteTime = p_Stamp.m_UserKeyWriteTime;
+    pHeader->m_GlobalKeyWriteTime = p_Stamp.m_GlobalKeyWriteTime;
+    pHeader->m_DataSize = static_cast<DWORD>(vData.size());
+    if (!vData.empty()) {
+        ::memcpy(pHeader + 1, vData.data(), vData.size());
+    }
+    ::InterlockedIncrement(&pHeader->m_Sequence);
+}
+
+//
+// Attempts to load our values from a snapshot persisted to disk by a
+// previous process. The file is mapped in memory and parsed in place.
+//
+// @param p_pSharedName Name of shared snapshot.
+// @param p_Stamp Current last write times of the source keys.
+// @return true if persisted snapshot was up to date and was loaded.
+//
+bool RegKeySnapshot::LoadPersisted(const wchar_t* const p_pSharedName,
+                                   const KeyStamp& p_Stamp)
+{
+    const std::wstring filePath = GetPersistedFilePath(p_pSharedName);
+    if (filePath.empty()) {
+        return false;
+    }
+    ATL::CHandle file(::CreateFileW(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                                    nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL));
+    if (file == INVALID_HANDLE_VALUE) {
+        file.Detach();
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    if (!::GetFileSizeEx(file, &fileSize) ||
+        fileSize.QuadPart < static_cast<LONGLONG>(sizeof(PersistedSnapshotHeader)) ||
+        fileSize.QuadPart > static_cast<LONGLONG>(sizeof(PersistedSnapshotHeader) + SHARED_SECTION_SIZE)) {
+
+        return false;
+    }
+
+    // Reuse the shared section helper to own the mapping and its view.
+    SharedSection mapping;
+    mapping.m_hMapping.Attach(::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr));
+    if (mapping.m_hMapping != NULL) {
+        mapping.m_pView = ::MapViewOfFile(mapping.m_hMapping, FILE_MAP_READ, 0, 0, 0);
+    }
+    if (mapping.m_pView == nullptr) {
+        return false;
+    }
+
+    // Validate header before parsing values.
+    const PersistedSnapshotHeader* const pHeader = static_cast<const PersistedSnapshotHeader*>(mapping.m_pView);
+    const FILETIME moduleWriteTime = GetModuleWriteTime();
+    if (pHeader->m_Signature != PERSISTED_SIGNATURE || pHeader->m_FormatVersion != PERSISTED_FORMAT_VERSION ||
+        (moduleWriteTime.dwLowDateTime == 0 && moduleWriteTime.dwHighDateTime == 0) ||
+        !FileTimesEqual(pHeader->m_ModuleWriteTime, moduleWriteTime) ||
+        (pHeader->m_Flags & SHARED_FLAG_HAS_DATA) == 0 ||
+        !FileTimesEqual(pHeader->m_UserKeyWriteTime, p_Stamp.m_UserKeyWriteTime) ||
+        !FileTimesEqual(pHeader->m_GlobalKeyWriteTime, p_Stamp.m_GlobalKeyWriteTime) ||
+        pHeader->m_DataSize != fileSize.QuadPart - sizeof(PersistedSnapshotHeader)) {
+
+        return false;
+    }
+    ValueDataM mValues;
+    if (!ParseValues(reinterpret_cast<const BYTE*>(pHeader + 1), pHeader->m_DataSize, mValues)) {
+        return false;
+    }
+
+    m_mValues = std::move(mValues);
+    m_Locked = (pHeader->m_Flags & SHARED_FLAG_LOCKED) != 0;
+    return true;
+}
+
+//
+// Persists our values to disk so that processes started later can load
+// them even if no shared snapshot exists anymore. The file is written
+// under a temporary name, then moved in place so that readers never see
+// a partial file. If anything fails, this does nothing.
+//
+// @param p_pSharedName Name of shared snapshot.
+// @param p_Stamp Last write times of the source keys before we loaded our values.
+//
+void RegKeySnapshot::SavePersisted(const wchar_t* const p_pSharedName,
+                                   const KeyStamp& p_Stamp) const
+{
+    const std::wstring filePath = GetPersistedFilePath(p_pSharedName);
+    const FILETIME moduleWriteTime = GetModuleWriteTime();
+    if (filePath.empty() || (moduleWriteTime.dwLowDateTime == 0 && moduleWriteTime.dwHighDateTime == 0)) {
+        return;
+    }
+    const std::vector<BYTE> vData = SerializeValues();
+    if (vData.size() > SHARED_SECTION_SIZE) {
+        return;
+    }
+
+    PersistedSnapshotHeader header;
+    header.m_Signature = PERSISTED_SIGNATURE;
+    header.m_FormatVersion = PERSISTED_FORMAT_VERSION;
+    header.m_ModuleWriteTime = moduleWriteTime;
+    header.m_Flags = SHARED_FLAG_HAS_DATA | (m_Locked ? SHARED_FLAG_LOCKED : 0);
+    header.m_UserKeyWriteTime = p_Stamp.m_UserKeyWriteTime;
+    header.m_GlobalKeyWriteTime = p_Stamp.m_GlobalKeyWriteTime;
+    header.m_DataSize = static_cast<DWORD>(vData.size());
+
+    // Use process ID to make sure two processes never write to the same temporary file.
+    const std::wstring tempFilePath = filePath + L"." + std::to_wstring(::GetCurrentProcessId()) + L".tmp";
+    bool written = false;
+    {
+        ATL::CHandle file(::CreateFileW(tempFilePath.c_str(), GENERIC_WRITE, 0, nullptr,
+                                        CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL));
+        if (file == INVALID_HANDLE_VALUE) {
+            file.Detach();
+            return;
+        }
+        DWORD headerWritten = 0, dataWritten = 0;
+        written = ::WriteFile(file, &header, sizeof(header), &headerWritten, nullptr) &&
+                  headerWritten == sizeof(header) &&
+                  (vData.empty() ||
+                   (::WriteFile(file, vData.data(), static_cast<DWORD>(vData.size()), &dataWritten, nullptr) &&
+                    dataWritten == vData.size()));
+    }
+    if (!written || !::MoveFileExW(tempFilePath.c_str(), filePath.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+        ::DeleteFileW(tempFilePath.c_str());
+    }
+}
+
+//
+// Serializes our values in the format used by shared and persisted snapshots.
+//
+// @return Serialized values.
+//
+std::vector<BYTE> RegKeySnapshot::SerializeValues() const
+{
+    HKEY hUserKey = m_Key.GetUserKey().GetHKEY();
+    std::vector<BYTE> vData;
+    for (const auto& nameAndValue : m_mValues) {
+        SharedValueHeader valueHeader;
+        valueHeader.m_NameSize = static_cast<DWORD>(nameAndValue.first.size());
+        valueHeader.m_Type = nameAndValue.second.m_Type;
+        valueHeader.m_DataSize = static_cast<DWORD>(nameAndValue.second.m_vData.size());
+        valueHeader.m_FromUserKey = (hUserKey != NULL && nameAndValue.second.m_hKey == hUserKey) ? 1 : 0;
+        const BYTE* const pValueHeader = reinterpret_cast<const BYTE*>(&valueHeader);
+        const BYTE* const pName = reinterpret_cast<const BYTE*>(nameAndValue.first.c_str());
+        vData.insert(vData.end(), pValueHeader, pValueHeader + sizeof(valueHeader));
+        vData.insert(vData.end(), pName, pName + nameAndValue.first.size() * sizeof(wchar_t));
+        vData.insert(vData.end(), nameAndValue.second.m_vData.cbegin(), nameAndValue.second.m_vData.cend());
+    }
+    return vData;
+}
+
+//
+// Parses values serialized by SerializeValues().
+//
+// @param p_pData Pointer to serialized values.
+// @param p_DataSize Size of serialized values, in bytes.
+// @param p_rmValues Where to store parsed values.
+// @return true if values were parsed, false if data is corrupted.
+//
+bool RegKeySnapshot::ParseValues(const BYTE* const p_pData,
+                                 const size_t p_DataSize,
+                                 ValueDataM& p_rmValues) const
+{
+    size_t offset = 0;
+    while (offset < p_DataSize) {
+        SharedValueHeader valueHeader;
+        if (p_DataSize - offset < sizeof(valueHeader)) {
+            return false;
+        }
+        ::memcpy(&valueHeader, p_pData + offset, sizeof(valueHeader));
+        offset += sizeof(valueHeader);
+        const size_t nameSizeInBytes = static_cast<size_t>(valueHeader.m_NameSize) * sizeof(wchar_t);
+        if (p_DataSize - offset < nameSizeInBytes ||
+            p_DataSize - offset - nameSizeInBytes < valueHeader.m_DataSize) {
+            return false;
+        }
+        std::wstring valueName(valueHeader.m_NameSize, L'\0');
+        if (nameSizeInBytes != 0) {
+            ::memcpy(&valueName[0], p_pData + offset, nameSizeInBytes);
+        }
+        offset += nameSizeInBytes;
+        ValueData& rValue = p_rmValues[valueName];
+        rValue.m_hKey = valueHeader.m_FromUserKey != 0 ? m_Key.GetUserKey().GetHKEY()
+                                                       : m_Key.GetGlobalKey().GetHKEY();
+        rValue.m_Type = valueHeader.m_Type;
+        rValue.m_vData.assign(p_pData + offset, p_pData + offset + valueHeader.m_DataSize);
+        offset += valueHeader.m_DataSize;
+    }
+    return true;
+}
@@ -0,0 +1,133 @@
+// RegexCache.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <stdafx.h>
+#include <RegexCache.h>
+
+
+namespace
+{
+    const size_t    MAX_CACHED_REGEXES  = 256;  // Maximum number of regexes in each cache before it is cleared.
+
+} // anonymous namespace
+
+namespace PCC
+{
+    // Static members of RegexCache
+    RegexCache::RegexM  RegexCache::s_mspRegexes;
+    RegexCache::FastRegexM
+                        RegexCache::s_mspFastRegexes;
+    std::mutex          RegexCache::s_Lock;
+
+    //
+    // Returns a compiled regex for the given pattern, compiling it
+    // only if it hasn't been compiled before in this process.
+    //
+    // @param p_Regex Regular expression pattern (ECMAScript syntax).
+    // @param p_IgnoreCase Whether to ignore case when looking for matches.
+    // @return Compiled regex, or nullptr if the pattern is empty or invalid.
+    //
+    RegexCache::WRegexSP RegexCache::GetRegex(const std::wstring& p_Regex,
+                                              const bool p_IgnoreCase)
+    {
+        WRegexSP spRegex;
+        if (!p_Regex.empty()) {
+            std::lock_guard<std::mutex> lock(s_Lock);
+
+            RegexKey key(p_Regex, p_IgnoreCase);
+            auto it = s_mspRegexes.find(key);
+            if (it != s_mspRegexes.end()) {
+                spRegex = it->second;
+            } else {
+                // Try creating regex. Keep null if the regex is invalid;
+                // we cache that as well to avoid trying again.
+                try {
+                    std::regex_constants::syntax_option_type reOptions = std::regex_constants::ECMAScript;
+                    if (p_IgnoreCase) {
+                        reOptions |= std::regex_constants::icase;
+                    }
+                    spRegex = std::make_shared<const std::wregex>(p_Regex, reOptions);
+                } catch (const std::regex_error&) {
+                    assert(spRegex == nullptr);
+                }
+                if (s_mspRegexes.size() >= MAX_CACHED_REGEXES) {
+                    s_mspRegexes.clear();
+                }
+                s_mspRegexes.emplace(std::move(key), spRegex);
+            }
+        }
+        return spRegex;
+    }
+
+    //
+    // Returns a compiled FastRegex for the given pattern, compiling it
+    // only if it hasn't been compiled before in this process.
+    //
+    // @param p_Regex Regular expression pattern (ECMAScript syntax).
+    // @param p_IgnoreCase Whether to ignore case when looking for matches.
+    // @return Compiled regex, or nullptr if the pattern is empty, invalid
+    //         or not supported by FastRegex.
+    //
+    RegexCache::FastRegexSP RegexCache::GetFastRegex(const std::wstring& p_Regex,
+                                                     const bool p_IgnoreCase)
+    {
+        FastRegexSP spRegex;
+        if (!p_Regex.empty()) {
+            std::lock_guard<std::mutex> lock(s_Lock);
+
+            RegexKey key(p_Regex, p_IgnoreCase);
+            auto it = s_mspFastRegexes.find(key);
+            if (it != s_mspFastRegexes.end()) {
+                spRegex = it->second;
+            } else {
+                try {
+                    spRegex = std::make_shared<const FastRegex>(p_Regex, p_IgnoreCase);
+                } catch (const std::regex_error&) {
+                    assert(spRegex == nullptr);
+                }
+                if (s_mspFastRegexes.size() >= MAX_CACHED_REGEXES) {
+                    s_mspFastRegexes.clear();
+                }
+                s_mspFastRegexes.emplace(std::move(key), spRegex);
+            }
+        }
+        return spRegex;
+    }
+
+    //
+    // Releases all compiled regexes. Regexes currently in use remain valid
+    // since they are reference-counted; they will be compiled again when
+    // next requested.
+    //
+    void RegexCache::Clear()
+    {
+        // Move regexes out of the caches so that they are released outside the lock.
+        RegexM mspRegexes;
+        FastRegexM mspFastRegexes;
+        {
+            std::lock_guard<std::mutex> lock(s_Lock);
+            mspRegexes.swap(s_mspRegexes);
+            mspFastRegexes.swap(s_mspFastRegexes);
+        }
+    }
+
+} // namespace PCC
@@ -0,0 +1,285 @@
+// RegistryWatcher.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <stdafx.h>
+#include <RegistryWatcher.h>
+
+
+namespace
+{
+    const wchar_t* const    PCC_SETTINGS_KEY        = L"Software\\clechasseur\\PathCopyCopy";
+    const DWORD             PCC_SETTINGS_NOTIFY     = REG_NOTIFY_CHANGE_NAME | REG_NOTIFY_CHANGE_LAST_SET;
+
+    // Subkeys of the settings keys that store settings and are watched recursively.
+    // Other subkeys are ignored, since they could store runtime data.
+    const wchar_t* const    WATCHED_SUBKEYS[]       = {
+        L"Icons",
+        L"Plugins",
+        L"PipelinePlugins",
+        L"TempPipelinePlugins",
+        L"PrefixMappings",
+    };
+
+    const DWORD             DEBOUNCE_DELAY_MS       = 250;      // Minimum delay between two increments of the generation.
+
+} // anonymous namespace
+
+namespace PCC
+{
+    ATL::CRegKey        RegistryWatcher::s_UserKey;
+    ATL::CRegKey        RegistryWatcher::s_GlobalKey;
+    ATL::CRegKey        RegistryWatcher::s_aUserSubkeys[RegistryWatcher::WATCHED_SUBKEY_COUNT];
+    ATL::CRegKey        RegistryWatcher::s_aGlobalSubkeys[RegistryWatcher::WATCHED_SUBKEY_COUNT];
+    ATL::CHandle        RegistryWatcher::s_hChangeEvent;
+    HANDLE              RegistryWatcher::s_hWait = NULL;
+    HANDLE              RegistryWatcher::s_hDebounceTimer = NULL;
+    DWORD               RegistryWatcher::s_LastChangeTime = 0;
+    std::atomic<bool>   RegistryWatcher::s_Watching(false);
+    std::atomic<ULONG>  RegistryWatcher::s_Generation(0);
+    std::mutex          RegistryWatcher::s_Lock;
+
+    //
+    // Returns the current generation of the PCC settings. If we are not
+    // watching for changes yet (or if we could not do so before), starts
+    // watching and increments the generation, since settings might have
+    // changed in the meantime.
+    //
+    // @return Current settings generation.
+    //
+    ULONG RegistryWatcher::GetGeneration()
+    {
+        if (!s_Watching) {
+            std::lock_guard<std::mutex> lock(s_Lock);
+            if (!s_Watching) {
+                ++s_Generation;
+                s_Watching = StartWatching();
+            }
+        }
+        return s_Generation;
+    }
+
+    //
+    // Stops watching for changes and releases our resources. Should be called
+    // before our DLL is unloaded, since the thread pool could otherwise call
+    // into it. Watching will resume on the next call to GetGeneration.
+    //
+    void RegistryWatcher::Stop()
+    {
+        // Unregister wait outside the lock, since callbacks need it.
+        HANDLE hWait = NULL;
+        {
+            std::lock_guard<std::mutex> lock(s_Lock);
+            s_Watching = false;
+            hWait = s_hWait;
+            s_hWait = NULL;
+        }
+        if (hWait != NULL) {
+            ::UnregisterWaitEx(hWait, INVALID_HANDLE_VALUE);
+        }
+
+        // Now that no more change can be handled, cancel any pending increment.
+        // There's no need to perform it: since we're no longer watching, the
+        // generation will be incremented anyway when we start watching again.
+        HANDLE hDebounceTimer = NULL;
+        {
+            std::lock_guard<std::mutex> lock(s_Lock);
+            hDebounceTimer = s_hDebounceTimer;
+            s_hDebounceTimer = NULL;
+        }
+        if (hDebounceTimer != NULL) {
+            ::DeleteTimerQueueTimer(NULL, hDebounceTimer, INVALID_HANDLE_VALUE);
+        }
+
+        // Close keys and event, unless we started watching again in the meantime.
+        std::lock_guard<std::mutex> lock(s_Lock);
+        if (s_hWait == NULL) {
+            for (size_t i = 0; i < WATCHED_SUBKEY_COUNT; ++i) {
+                s_aUserSubkeys[i].Close();
+                s_aGlobalSubkeys[i].Close();
+            }
+            s_UserKey.Close();
+            s_GlobalKey.Close();
+            s_hChangeEvent.Close();
+        }
+    }
+
+    //
+    // Arms registry change notifications and registers a thread pool wait
+    // to be notified of changes. Must be called with the lock held.
+    //
+    // @return true if we are watching for changes, false otherwise.
+    //
+    bool RegistryWatcher::StartWatching()
+    {
+        if (s_hChangeEvent == NULL) {
+            // Auto-reset event, so that the thread pool wait resets it.
+            s_hChangeEvent.Attach(::CreateEventW(nullptr, FALSE, FALSE, nullptr));
+            if (s_hChangeEvent == NULL) {
+                return false;
+            }
+        }
+        if (!ArmNotifications()) {
+            return false;
+        }
+
+        // Callbacks are executed in a persistent thread, so that notifications
+        // armed by OnChange are not signaled when the thread pool trims its threads.
+        if (s_hWait == NULL && !::RegisterWaitForSingleObject(&s_hWait, s_hChangeEvent, &RegistryWatcher::OnChange,
+                                                              nullptr, INFINITE, WT_EXECUTEINPERSISTENTTHREAD)) {
+
+            s_hWait = NULL;
+            return false;
+        }
+        return true;
+    }
+
+    //
+    // Arms registry change notifications on the PCC settings keys. Values of
+    // the settings keys are watched, along with the addition or removal of
+    // subkeys; the content of subkeys listed in WATCHED_SUBKEYS is watched
+    // recursively. Must be called with the lock held.
+    //
+    // Note: notifications are tied to the calling thread; if it exits, the
+    // event will be signaled, which will simply cause the generation to change.
+    //
+    // @return true if notifications are armed, false otherwise.
+    //
+    bool RegistryWatcher::ArmNotifications()
+    {
+        static_assert(ARRAYSIZE(WATCHED_SUBKEYS) == WATCHED_SUBKEY_COUNT, "WATCHED_SUBKEY_COUNT must match WATCHED_SUBKEYS");
+
+        // The user key is created if needed so that we always have something to watch.
+        // The global key is optional and is usually only created by administrators.
+        if (s_UserKey.m_hKey == NULL) {
+            s_UserKey.Create(HKEY_CURRENT_USER, PCC_SETTINGS_KEY, REG_NONE,
+                             REG_OPTION_NON_VOLATILE, KEY_NOTIFY);
+        }
+        if (s_GlobalKey.m_hKey == NULL) {
+            s_GlobalKey.Open(HKEY_LOCAL_MACHINE, PCC_SETTINGS_KEY, KEY_NOTIFY);
+        }
+
+        bool armed = s_UserKey.m_hKey != NULL &&
+            s_UserKey.NotifyChangeKeyValue(FALSE, PCC_SETTINGS_NOTIFY, s_hChangeEvent) == ERROR_SUCCESS;
+        if (armed && s_GlobalKey.m_hKey != NULL) {
+            armed = s_GlobalKey.NotifyChangeKeyValue(FALSE, PCC_SETTINGS_NOTIFY, s_hChangeEvent) == ERROR_SUCCESS;
+        }
+        for (size_t i = 0; armed && i < WATCHED_SUBKEY_COUNT; ++i) {
+            armed = ArmSubkeyNotifications(s_UserKey, WATCHED_SUBKEYS[i], s_aUserSubkeys[i]);
+            if (armed && s_GlobalKey.m_hKey != NULL) {
+                armed = ArmSubkeyNotifications(s_GlobalKey, WATCHED_SUBKEYS[i], s_aGlobalSubkeys[i]);
+            }
+        }
+        return armed;
+    }
+
+    //
+    // Arms recursive registry change notifications on a subkey of one of the
+    // PCC settings keys. If the subkey does not exist, there is nothing to
+    // watch: its creation will be notified through its parent key. Must be
+    // called with the lock held.
+    //
+    // @param p_ParentKey Settings key containing the subkey.
+    // @param p_pSubkeyName Name of subkey to watch.
+    // @param p_rSubkey Subkey, opened for notification. Will be opened if needed.
+    // @return true if notifications are armed or if subkey does not exist,
+    //         false otherwise.
+    //
+    bool RegistryWatcher::ArmSubkeyNotifications(const ATL::CRegKey& p_ParentKey,
+                                                 const wchar_t* const p_pSubkeyName,
+                                                 ATL::CRegKey& p_rSubkey)
+    {
+        if (p_rSubkey.m_hKey != NULL &&
+            p_rSubkey.NotifyChangeKeyValue(TRUE, PCC_SETTINGS_NOTIFY, s_hChangeEvent) == ERROR_SUCCESS) {
+
+            return true;
+        }
+
+        // Subkey was not opened yet or has been deleted since; (re)open it.
+        p_rSubkey.Close();
+        if (p_rSubkey.Open(p_ParentKey.m_hKey, p_pSubkeyName, KEY_NOTIFY) != ERROR_SUCCESS) {
+            return true;
+        }
+        return p_rSubkey.NotifyChangeKeyValue(TRUE, PCC_SETTINGS_NOTIFY, s_hChangeEvent) == ERROR_SUCCESS;
+    }
+
+    //
+    // Called by the thread pool when one of the settings keys changes.
+    // Re-arms notifications, then increments the generation right away
+    // if it hasn't been incremented recently; otherwise, schedules an
+    // increment at the end of the debounce delay.
+    //
+    // @param p_pContext Unused.
+    // @param p_TimedOut Unused; our wait has no timeout.
+    //
+    void CALLBACK RegistryWatcher::OnChange(PVOID /*p_pContext*/,
+                                            BOOLEAN /*p_TimedOut*/)
+    {
+        std::lock_guard<std::mutex> lock(s_Lock);
+        if (s_hWait == NULL) {
+            // We're being stopped.
+            return;
+        }
+
+        // Re-arm first so that changes made while we handle this one are not missed.
+        // If this fails, GetGeneration will try again.
+        if (!ArmNotifications()) {
+            s_Watching = false;
+        }
+
+        // If an increment is already scheduled, it will cover this change.
+        if (s_hDebounceTimer == NULL) {
+            const DWORD now = ::GetTickCount();
+            const DWORD elapsed = now - s_LastChangeTime;
+            if (elapsed >= DEBOUNCE_DELAY_MS) {
+                ++s_Generation;
+                s_LastChangeTime = now;
+            } else if (!::CreateTimerQueueTimer(&s_hDebounceTimer, NULL, &RegistryWatcher::OnDebounceElapsed,
+                                                nullptr, DEBOUNCE_DELAY_MS - elapsed, 0, WT_EXECUTEONLYONCE)) {
+
+                // Can't debounce, increment now.
+                s_hDebounceTimer = NULL;
+                ++s_Generation;
+                s_LastChangeTime = now;
+            }
+        }
+    }
+
+    //
+    // Called by the thread pool at the end of the debounce delay when
+    // changes occurred during it. Increments the generation.
+    //
+    // @param p_pContext Unused.
+    // @param p_TimedOut Unused; always TRUE for timers.
+    //
+    void CALLBACK RegistryWatcher::OnDebounceElapsed(PVOID /*p_pContext*/,
+                                                     BOOLEAN /*p_TimedOut*/)
+    {
+        std::lock_guard<std::mutex> lock(s_Lock);
+        if (s_hDebounceTimer != NULL) {
+            // We can't wait for our own callback to complete, so delete the timer asynchronously.
+            ::DeleteTimerQueueTimer(NULL, s_hDebounceTimer, NULL);
+            s_hDebounceTimer = NULL;
+            ++s_Generation;
+            s_LastChangeTime = ::GetTickCount();
+        }
+    }
+
+} // namespace PCC
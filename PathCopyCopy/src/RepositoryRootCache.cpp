@@ -0,0 +1,174 @@
+// RepositoryRootCache.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <stdafx.h>
+#include <RepositoryRootCache.h>
+#include <DriveConnectivityCache.h>
+#include <PluginUtils.h>
+
+
+namespace PCC
+{
+    // Static members of RepositoryRootCache
+    const DWORD                     RepositoryRootCache::TIME_TO_LIVE = 30 * 1000;
+    const size_t                    RepositoryRootCache::MAX_ENTRIES = 4096;
+    RepositoryRootCache::EntryM     RepositoryRootCache::s_mEntries;
+    WStringV                        RepositoryRootCache::s_vMarkers;
+    std::mutex                      RepositoryRootCache::s_Lock;
+
+    //
+    // Returns the root of the repository enclosing the given directory.
+    // Only directories that are not cached yet are checked for root markers.
+    //
+    // @param p_Directory Path of directory, without trailing backslash.
+    // @param p_vMarkers Names of files or folders marking a repository root.
+    // @return Path of repository root, without trailing backslash, or an
+    //         empty string if p_Directory is not in a repository.
+    //
+    std::wstring RepositoryRootCache::GetRepositoryRoot(const std::wstring& p_Directory,
+                                                        const WStringV& p_vMarkers)
+    {
+        if (p_Directory.empty() || p_vMarkers.empty() || !DriveConnectivityCache::IsReachable(p_Directory)) {
+            return std::wstring();
+        }
+        WStringV vAncestors;
+        GetAncestors(p_Directory, vAncestors);
+
+        // Find the closest ancestor whose root is cached.
+        std::wstring root;
+        size_t cachedAncestor = vAncestors.size();
+        {
+            std::lock_guard<std::mutex> lock(s_Lock);
+            if (s_vMarkers != p_vMarkers) {
+                s_mEntries.clear();
+                s_vMarkers = p_vMarkers;
+            }
+            const DWORD now = ::GetTickCount();
+            for (size_t i = 0; i < vAncestors.size(); ++i) {
+                const auto it = s_mEntries.find(vAncestors[i]);
+                if (it != s_mEntries.end() && now - it->second.m_Timestamp < TIME_TO_LIVE) {
+                    root = it->second.m_Root;
+                    cachedAncestor = i;
+                    break;
+                }
+            }
+        }
+
+        // Look for markers in ancestors below it, without holding the lock
+        // since this can hit the network.
+        size_t uncachedAncestors = cachedAncestor;
+        for (size_t i = 0; i < cachedAncestor; ++i) {
+            if (HasMarker(vAncestors[i], p_vMarkers)) {
+                root = vAncestors[i];
+                uncachedAncestors = i + 1;
+                break;
+            }
+        }
+
+        if (uncachedAncestors != 0) {
+            std::lock_guard<std::mutex> lock(s_Lock);
+            const DWORD now = ::GetTickCount();
+            if (s_mEntries.size() + uncachedAncestors > MAX_ENTRIES) {
+                Prune(now);
+            }
+            if (s_vMarkers == p_vMarkers) {
+                for (size_t i = 0; i < uncachedAncestors; ++i) {
+                    s_mEntries[vAncestors[i]] = Entry { root, now };
+                }
+            }
+        }
+        return root;
+    }
+
+    //
+    // Returns the given directory and its ancestors, from the directory
+    // itself up to the root of its drive or network share.
+    //
+    // @param p_Directory Path of directory.
+    // @param p_rvAncestors Where to store the directory and its ancestors.
+    //
+    void RepositoryRootCache::GetAncestors(const std::wstring& p_Directory,
+                                           WStringV& p_rvAncestors)
+    {
+        // Stop at the drive letter (C:) or at the share (\\server\share).
+        std::wstring::size_type rootEnd = 0;
+        if (PluginUtils::IsUNCPath(p_Directory)) {
+            rootEnd = p_Directory.find(L'\\', p_Directory.find(L'\\', 2) + 1);
+        } else {
+            rootEnd = p_Directory.find(L'\\');
+        }
+
+        std::wstring ancestor(p_Directory);
+        while (!ancestor.empty() && ancestor.back() == L'\\') {
+            ancestor.pop_back();
+        }
+        while (!ancestor.empty()) {
+            p_rvAncestors.push_back(ancestor);
+            const std::wstring::size_type lastSep = ancestor.rfind(L'\\');
+            if (rootEnd == std::wstring::npos || lastSep == std::wstring::npos || lastSep < rootEnd) {
+                break;
+            }
+            ancestor.erase(lastSep);
+        }
+    }
+
+    //
+    // Checks if a directory contains one of the root markers. Markers can be
+    // files or folders, since git uses a .git file in worktrees and submodules.
+    //
+    // @param p_Directory Path of directory.
+    // @param p_vMarkers Names of files or folders marking a repository root.
+    // @return true if p_Directory is the root of a repository.
+    //
+    bool RepositoryRootCache::HasMarker(const std::wstring& p_Directory,
+                                        const WStringV& p_vMarkers)
+    {
+        for (const std::wstring& marker : p_vMarkers) {
+            const std::wstring markerPath = p_Directory + L'\\' + marker;
+            if (::GetFileAttributesW(markerPath.c_str()) != INVALID_FILE_ATTRIBUTES) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    //
+    // Removes expired entries from the cache. If the cache is still too
+    // large afterwards, clears it. Must be called with the lock held.
+    //
+    // @param p_Now Current tick count.
+    //
+    void RepositoryRootCache::Prune(const DWORD p_Now)
+    {
+        for (auto it = s_mEntries.begin(); it != s_mEntries.end(); ) {
+            if (p_Now - it->second.m_Timestamp >= TIME_TO_LIVE) {
+                it = s_mEntries.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        if (s_mEntries.size() >= MAX_ENTRIES) {
+            s_mEntries.clear();
+        }
+    }
+
+} // namespace PCC
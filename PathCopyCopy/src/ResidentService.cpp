@@ -0,0 +1,640 @@
+// ResidentService.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <stdafx.h>
+#include <ResidentService.h>
+#include <COMPluginHostMessage.h>
+#include <PathCopyCopyContextMenuExt.h>
+#include <PathCopyCopySettings.h>
+#include <PluginsSnapshot.h>
+#include <PluginUtils.h>
+#include <StCoInitialize.h>
+
+#include <exdisp.h>
+#include <sddl.h>
+#include <shlguid.h>
+#include <shlobj.h>
+#include <wchar.h>
+
+
+EXTERN_C IMAGE_DOS_HEADER __ImageBase;
+
+namespace
+{
+    // Prefixes of the names of the pipe used to send requests to the service
+    // and of the mutex ensuring only one instance runs. Both are per-user;
+    // the pipe is also per-session since pipe names are global.
+    const wchar_t* const    PIPE_NAME_PREFIX            = L"\\\\.\\pipe\\PathCopyCopy.ResidentService.";
+    const wchar_t* const    INSTANCE_MUTEX_NAME_PREFIX  = L"Local\\PathCopyCopy.ResidentService.";
+
+    // Size of the pipe's buffers. Larger requests are read in chunks.
+    const DWORD             PIPE_BUFFER_SIZE            = 64 * 1024;
+
+    // Security descriptor of the pipe: only the user running the service
+    // (whose SID is appended, followed by ")") can connect, and never
+    // through a network logon.
+    const wchar_t* const    PIPE_SECURITY_DESCRIPTOR    = L"D:P(D;;GA;;;NU)(A;;GA;;;";
+
+    // Pipe mode flag that rejects remote clients (PIPE_REJECT_REMOTE_CLIENTS).
+    // Declared here because it is only supported starting with Windows Vista.
+    const DWORD             PIPE_REJECT_REMOTE_FLAG     = 0x00000008;
+
+    // Access right needed to query a process' token, available starting
+    // with Windows Vista (PROCESS_QUERY_LIMITED_INFORMATION).
+    const DWORD             PROCESS_QUERY_ACCESS        = 0x1000;
+
+    // Time to wait for the pipe to become available when the service is busy
+    // with another request, in milliseconds.
+    const DWORD             CONNECT_TIMEOUT             = 100;
+
+    // Time to wait for a request to be sent or received, in milliseconds.
+    // Requests are acknowledged before they are processed, so this can be short.
+    const DWORD             REQUEST_TIMEOUT             = 1000;
+
+    // Interval at which the service refreshes the network information it caches,
+    // in milliseconds, to pick up changes to mapped drives and shares.
+    const UINT              NETWORK_REFRESH_INTERVAL    = 5 * 60 * 1000;
+
+    // ID of the first hotkey registered by the service. Other hotkeys follow.
+    const int               FIRST_HOTKEY_ID             = 1;
+
+    // Registry key and value used to start the service at logon.
+    const wchar_t* const    RUN_KEY_NAME                = L"Software\\Microsoft\\Windows\\CurrentVersion\\Run";
+    const wchar_t* const    RUN_VALUE_NAME              = L"PathCopyCopyResidentService";
+
+    // Name of the rundll32 entry point hosting the service.
+    const wchar_t* const    RUNDLL32_ENTRY_POINT        = L"RunResidentServiceW";
+
+    // Signature of GetNamedPipeServerProcessId, which we load dynamically
+    // because it is only available starting with Windows Vista.
+    typedef BOOL (WINAPI *GetNamedPipeServerProcessIdFunc)(HANDLE, PULONG);
+
+} // anonymous namespace
+
+namespace PCC
+{
+    // Static members of ResidentService
+    bool    ResidentService::s_Running  = false;
+
+    //
+    // Forwards a request to copy the paths of files to the resident service,
+    // if it is running. Returns quickly if it isn't or if it is unresponsive,
+    // so that the caller can do the work itself.
+    //
+    // Since requests are acknowledged before they are processed, failures
+    // are not reported; only plugins whose action can't fail visibly
+    // should be forwarded (see PathAction::CanFailVisibly).
+    //
+    // @param p_PluginId ID of plugin to use to copy paths.
+    // @param p_vFiles Files whose paths to copy.
+    // @return true if the service accepted the request.
+    //
+    bool ResidentService::Forward(const GUID& p_PluginId,
+                                  const FilesV& p_vFiles)
+    {
+        // We can't forward requests to ourselves.
+        if (s_Running || p_vFiles.empty()) {
+            return false;
+        }
+
+        COMPluginHostMessage request;
+        request.WriteDWORD(CopyPaths).WriteGUID(p_PluginId).WriteDWORD(static_cast<DWORD>(p_vFiles.size()));
+        for (const std::wstring& file : p_vFiles) {
+            request.WriteString(file);
+        }
+        return SUCCEEDED(SendRequest(request));
+    }
+
+    //
+    // Runs the resident service until it is asked to stop (see Stop) or
+    // until the user logs off. Returns immediately if the service is
+    // already running for this user and session.
+    //
+    void ResidentService::Run()
+    {
+        const std::wstring instanceMutexName = INSTANCE_MUTEX_NAME_PREFIX + PluginUtils::GetCurrentUserSid();
+        ATL::CHandle hInstanceMutex(::CreateMutexW(nullptr, FALSE, instanceMutexName.c_str()));
+        if (hInstanceMutex == NULL || ::GetLastError() == ERROR_ALREADY_EXISTS) {
+            return;
+        }
+
+        // Create the pipe. Make sure nobody else created it first and that
+        // only the current user can connect to it, from this computer.
+        const std::wstring pipeSecurity = PIPE_SECURITY_DESCRIPTOR + PluginUtils::GetCurrentUserSid() + L")";
+        PSECURITY_DESCRIPTOR pSecurityDescriptor = nullptr;
+        if (!::ConvertStringSecurityDescriptorToSecurityDescriptorW(pipeSecurity.c_str(), SDDL_REVISION_1,
+                                                                    &pSecurityDescriptor, nullptr)) {
+            return;
+        }
+        SECURITY_ATTRIBUTES securityAttributes = SECURITY_ATTRIBUTES();
+        securityAttributes.nLength = sizeof(securityAttributes);
+        securityAttributes.lpSecurityDescriptor = pSecurityDescriptor;
+        auto createPipe = [&](const DWORD p_ExtraMode) {
+            return ::CreateNamedPipeW(GetPipeName().c_str(),
+                PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED | FILE_FLAG_FIRST_PIPE_INSTANCE,
+                PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE | PIPE_WAIT | p_ExtraMode,
+                1, PIPE_BUFFER_SIZE, PIPE_BUFFER_SIZE, 0, &securityAttributes);
+        };
+        HANDLE hNewPipe = createPipe(PIPE_REJECT_REMOTE_FLAG);
+        if (hNewPipe == INVALID_HANDLE_VALUE && ::GetLastError() == ERROR_INVALID_PARAMETER) {
+            // Before Windows Vista; the security descriptor denies network logons already.
+            hNewPipe = createPipe(0);
+        }
+        ::LocalFree(pSecurityDescriptor);
+        ATL::CHandle hEvent(::CreateEventW(nullptr, TRUE, FALSE, nullptr));
+        if (hEvent == NULL || hNewPipe == INVALID_HANDLE_VALUE) {
+            if (hNewPipe != INVALID_HANDLE_VALUE) {
+                ::CloseHandle(hNewPipe);
+            }
+            return;
+        }
+        ATL::CHandle hPipe(hNewPipe);
+
+        // Context menu handlers need an apartment, as do COM plugins.
+        StCoInitialize coInitialize(COINIT_APARTMENTTHREADED);
+        s_Running = true;
+
+        // Fill our caches right away. The snapshot is kept for the lifetime of
+        // the service (it is refreshed automatically when settings change).
+        PluginsSnapshotSP spPluginsSnapshot = PluginsSnapshot::Get();
+        PluginUtils::PrewarmNetworkCaches();
+        const UINT_PTR refreshTimerId = ::SetTimer(NULL, 0, NETWORK_REFRESH_INTERVAL, nullptr);
+
+        GUIDV vHotkeyPluginIds;
+        RegisterHotkeys(vHotkeyPluginIds);
+
+        // Helper that acts on files using a context menu handler, like the shell would.
+        auto actOnFiles = [](const GUID& p_PluginId, const FilesV* const p_pvFiles,
+                             IDataObject* const p_pDataObject, const HWND p_hWnd) {
+            ATL::CComObject<CPathCopyCopyContextMenuExt>* pContextMenuExt = nullptr;
+            if (SUCCEEDED(ATL::CComObject<CPathCopyCopyContextMenuExt>::CreateInstance(&pContextMenuExt))) {
+                ATL::CComPtr<IContextMenu> spContextMenuExt(pContextMenuExt);
+                const HRESULT hRes = p_pvFiles != nullptr
+                    ? pContextMenuExt->InitializeWithFiles(*p_pvFiles)
+                    : pContextMenuExt->Initialize(nullptr, p_pDataObject, NULL);
+                if (SUCCEEDED(hRes)) {
+                    pContextMenuExt->ActOnFilesWithPlugin(p_PluginId, p_hWnd);
+                }
+            }
+        };
+
+        // Start listening for requests.
+        OVERLAPPED overlapped = OVERLAPPED();
+        overlapped.hEvent = hEvent;
+        auto listen = [&]() {
+            ::ResetEvent(hEvent);
+            overlapped = OVERLAPPED();
+            overlapped.hEvent = hEvent;
+            if (!::ConnectNamedPipe(hPipe, &overlapped)) {
+                const DWORD error = ::GetLastError();
+                if (error == ERROR_PIPE_CONNECTED) {
+                    ::SetEvent(hEvent);
+                } else if (error != ERROR_IO_PENDING) {
+                    return false;
+                }
+            }
+            return true;
+        };
+        bool running = listen();
+
+        while (running) {
+            HANDLE hWaitEvent = hEvent;
+            const DWORD waitRes = ::MsgWaitForMultipleObjects(1, &hWaitEvent, FALSE, INFINITE, QS_ALLINPUT);
+            if (waitRes == WAIT_OBJECT_0) {
+                // A client connected; read its request and acknowledge it before
+                // processing it, so that it can return to what it was doing.
+                GUID pluginId = GUID_NULL;
+                FilesV vFiles;
+                DWORD bytes = 0;
+                Command command = static_cast<Command>(0);
+                if (::GetOverlappedResult(hPipe, &overlapped, &bytes, FALSE)) {
+                    command = ReceiveRequest(hPipe, hEvent, pluginId, vFiles);
+                }
+                ::DisconnectNamedPipe(hPipe);
+
+                if (command == CopyPaths) {
+                    actOnFiles(pluginId, &vFiles, nullptr, NULL);
+                } else if (command == Quit) {
+                    running = false;
+                }
+                if (running) {
+                    running = listen();
+                }
+            } else if (waitRes == WAIT_OBJECT_0 + 1) {
+                MSG msg;
+                while (::PeekMessageW(&msg, NULL, 0, 0, PM_REMOVE)) {
+                    if (msg.message == WM_QUIT) {
+                        running = false;
+                    } else if (msg.hwnd == NULL && msg.message == WM_HOTKEY) {
+                        // Apply the hotkey's plugin to the selection of the active Explorer window.
+                        const size_t index = static_cast<size_t>(msg.wParam) - FIRST_HOTKEY_ID;
+                        HWND hExplorerWnd = NULL;
+                        ATL::CComPtr<IDataObject> spDataObject;
+                        if (index < vHotkeyPluginIds.size() && GetExplorerSelection(hExplorerWnd, spDataObject)) {
+                            actOnFiles(vHotkeyPluginIds[index], nullptr, spDataObject, hExplorerWnd);
+                        }
+                    } else if (msg.hwnd == NULL && msg.message == WM_TIMER && msg.wParam == refreshTimerId) {
+                        PluginUtils::FlushNetworkCaches();
+                        PluginUtils::PrewarmNetworkCaches();
+                    } else {
+                        // Needed by windows used for delayed clipboard rendering, among others.
+                        ::TranslateMessage(&msg);
+                        ::DispatchMessageW(&msg);
+                    }
+                }
+
+                // Pick up changes to hotkeys.
+                if (running && spPluginsSnapshot != PluginsSnapshot::Get()) {
+                    spPluginsSnapshot = PluginsSnapshot::Get();
+                    UnregisterHotkeys(vHotkeyPluginIds);
+                    RegisterHotkeys(vHotkeyPluginIds);
+                }
+            } else {
+                running = false;
+            }
+        }
+
+        UnregisterHotkeys(vHotkeyPluginIds);
+        if (refreshTimerId != 0) {
+            ::KillTimer(NULL, refreshTimerId);
+        }
+        ::CancelIo(hPipe);
+        s_Running = false;
+    }
+
+    //
+    // Asks the resident service to stop, if it is running.
+    //
+    // @return true if the service was running and accepted the request.
+    //
+    bool ResidentService::Stop()
+    {
+        COMPluginHostMessage request;
+        request.WriteDWORD(Quit);
+        return SUCCEEDED(SendRequest(request));
+    }
+
+    //
+    // Installs or uninstalls the resident service so that it is started
+    // or not when the current user logs on. Does not start or stop it.
+    //
+    // @param p_Install true to install the service, false to uninstall it.
+    // @return true if the operation succeeded.
+    //
+    bool ResidentService::Install(const bool p_Install)
+    {
+        ATL::CRegKey runKey;
+        if (runKey.Open(HKEY_CURRENT_USER, RUN_KEY_NAME, KEY_SET_VALUE) != ERROR_SUCCESS) {
+            return false;
+        }
+        if (p_Install) {
+            const std::wstring runCommand = GetRunCommand();
+            return !runCommand.empty() && runKey.SetStringValue(RUN_VALUE_NAME, runCommand.c_str()) == ERROR_SUCCESS;
+        }
+        const LONG lRes = runKey.DeleteValue(RUN_VALUE_NAME);
+        return lRes == ERROR_SUCCESS || lRes == ERROR_FILE_NOT_FOUND;
+    }
+
+    //
+    // Returns the name of the pipe used to communicate with the service
+    // running for the current user in the current session.
+    //
+    // @return Pipe name.
+    //
+    std::wstring ResidentService::GetPipeName()
+    {
+        DWORD sessionId = 0;
+        ::ProcessIdToSessionId(::GetCurrentProcessId(), &sessionId);
+        return PIPE_NAME_PREFIX + PluginUtils::GetCurrentUserSid() + L"." + std::to_wstring(sessionId);
+    }
+
+    //
+    // Returns the command-line used to start the service at logon. It uses
+    // the rundll32 matching our DLL's bitness, even under WOW64.
+    //
+    // @return Command-line, or an empty string if it could not be determined.
+    //
+    std::wstring ResidentService::GetRunCommand()
+    {
+        std::wstring runCommand;
+
+        wchar_t systemDir[MAX_PATH + 1];
+        UINT systemDirSize = ::GetSystemWow64DirectoryW(systemDir, MAX_PATH + 1);
+        if (systemDirSize == 0 || systemDirSize > MAX_PATH) {
+            // Not under WOW64.
+            systemDirSize = ::GetSystemDirectoryW(systemDir, MAX_PATH + 1);
+        }
+        wchar_t dllPath[MAX_PATH + 1];
+        const DWORD dllPathSize = ::GetModuleFileNameW(reinterpret_cast<HINSTANCE>(&__ImageBase), dllPath, MAX_PATH + 1);
+        if (systemDirSize != 0 && systemDirSize <= MAX_PATH && dllPathSize != 0 && dllPathSize <= MAX_PATH) {
+            runCommand = L"\"" + std::wstring(systemDir, systemDirSize) + L"\\rundll32.exe\" \""
+                       + std::wstring(dllPath, dllPathSize) + L"\"," + RUNDLL32_ENTRY_POINT;
+        }
+
+        return runCommand;
+    }
+
+    //
+    // Sends a request to the service and waits for it to be acknowledged.
+    //
+    // @param p_Request Request to send.
+    // @return Response of the service, or an error code if the service
+    //         is not running or did not respond in time.
+    //
+    HRESULT ResidentService::SendRequest(const COMPluginHostMessage& p_Request)
+    {
+        // Connecting fails right away if the service is not running.
+        const std::wstring pipeName = GetPipeName();
+        HANDLE hNewPipe = ::CreateFileW(pipeName.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr,
+                                        OPEN_EXISTING, FILE_FLAG_OVERLAPPED, nullptr);
+        if (hNewPipe == INVALID_HANDLE_VALUE && ::GetLastError() == ERROR_PIPE_BUSY &&
+            ::WaitNamedPipeW(pipeName.c_str(), CONNECT_TIMEOUT)) {
+
+            hNewPipe = ::CreateFileW(pipeName.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr,
+                                     OPEN_EXISTING, FILE_FLAG_OVERLAPPED, nullptr);
+        }
+        if (hNewPipe == INVALID_HANDLE_VALUE) {
+            return HRESULT_FROM_WIN32(::GetLastError());
+        }
+        ATL::CHandle hPipe(hNewPipe);
+
+        // Make sure we're talking to our own service and not to
+        // another user's process that created the pipe first.
+        if (!IsServerTrusted(hPipe)) {
+            return E_ACCESSDENIED;
+        }
+
+        DWORD pipeMode = PIPE_READMODE_MESSAGE;
+        ATL::CHandle hEvent(::CreateEventW(nullptr, TRUE, FALSE, nullptr));
+        if (!::SetNamedPipeHandleState(hPipe, &pipeMode, nullptr, nullptr) || hEvent == NULL) {
+            return HRESULT_FROM_WIN32(::GetLastError());
+        }
+
+        const std::vector<BYTE>& vRequest = p_Request.Data();
+        OVERLAPPED overlapped = OVERLAPPED();
+        overlapped.hEvent = hEvent;
+        DWORD bytes = 0;
+        HRESULT hRes = CompleteIO(hPipe, ::WriteFile(hPipe, vRequest.data(), static_cast<DWORD>(vRequest.size()),
+                                                     nullptr, &overlapped),
+                                  overlapped, REQUEST_TIMEOUT, bytes);
+        if (SUCCEEDED(hRes)) {
+            HRESULT response = E_UNEXPECTED;
+            ::ResetEvent(hEvent);
+            overlapped = OVERLAPPED();
+            overlapped.hEvent = hEvent;
+            bytes = 0;
+            hRes = CompleteIO(hPipe, ::ReadFile(hPipe, &response, sizeof(response), nullptr, &overlapped),
+                              overlapped, REQUEST_TIMEOUT, bytes);
+            if (SUCCEEDED(hRes)) {
+                hRes = bytes == sizeof(response) ? response : E_UNEXPECTED;
+            }
+        }
+
+        return hRes;
+    }
+
+    //
+    // Checks whether the server end of a pipe belongs to a process running
+    // as the current user. If this can't be verified (for instance, before
+    // Windows Vista), the server is not trusted.
+    //
+    // @param p_hPipe Handle to client end of pipe.
+    // @return true if the server can be trusted with our requests.
+    //
+    bool ResidentService::IsServerTrusted(HANDLE p_hPipe)
+    {
+        bool trusted = false;
+
+        HMODULE hKernel32 = ::GetModuleHandleW(L"kernel32.dll");
+        GetNamedPipeServerProcessIdFunc pGetNamedPipeServerProcessId = hKernel32 != NULL
+            ? reinterpret_cast<GetNamedPipeServerProcessIdFunc>(::GetProcAddress(hKernel32, "GetNamedPipeServerProcessId"))
+            : nullptr;
+        ULONG serverProcessId = 0;
+        if (pGetNamedPipeServerProcessId != nullptr && pGetNamedPipeServerProcessId(p_hPipe, &serverProcessId)) {
+            ATL::CHandle hServerProcess(::OpenProcess(PROCESS_QUERY_ACCESS, FALSE, serverProcessId));
+            if (hServerProcess != NULL) {
+                const std::wstring serverSid = PluginUtils::GetProcessUserSid(hServerProcess);
+                trusted = !serverSid.empty() && serverSid == PluginUtils::GetCurrentUserSid();
+            }
+        }
+
+        return trusted;
+    }
+
+    //
+    // Reads a request sent to the service by a connected client and
+    // acknowledges it.
+    //
+    // @param p_hPipe Handle to pipe to which the client is connected.
+    // @param p_hEvent Event to use for overlapped I/O.
+    // @param p_rPluginId Where to store the plugin ID passed in a CopyPaths request.
+    // @param p_rvFiles Where to store the files passed in a CopyPaths request.
+    // @return Command of request, or 0 if request could not be read.
+    //
+    ResidentService::Command ResidentService::ReceiveRequest(HANDLE p_hPipe,
+                                                             HANDLE p_hEvent,
+                                                             GUID& p_rPluginId,
+                                                             FilesV& p_rvFiles)
+    {
+        // Read request, which can be larger than our buffer.
+        std::vector<BYTE> vRequest;
+        OVERLAPPED overlapped;
+        DWORD bytes = 0;
+        HRESULT hRes = HRESULT_FROM_WIN32(ERROR_MORE_DATA);
+        while (hRes == HRESULT_FROM_WIN32(ERROR_MORE_DATA)) {
+            const size_t offset = vRequest.size();
+            vRequest.resize(offset + PIPE_BUFFER_SIZE);
+            ::ResetEvent(p_hEvent);
+            overlapped = OVERLAPPED();
+            overlapped.hEvent = p_hEvent;
+            bytes = 0;
+            hRes = CompleteIO(p_hPipe, ::ReadFile(p_hPipe, &vRequest[offset], PIPE_BUFFER_SIZE, nullptr, &overlapped),
+                              overlapped, REQUEST_TIMEOUT, bytes);
+            vRequest.resize(offset + bytes);
+        }
+        if (FAILED(hRes)) {
+            return static_cast<Command>(0);
+        }
+
+        // Decode request.
+        COMPluginHostMessage request(std::move(vRequest));
+        DWORD command = 0;
+        HRESULT response = E_INVALIDARG;
+        if (request.ReadDWORD(command)) {
+            if (command == CopyPaths) {
+                DWORD fileCount = 0;
+                if (request.ReadGUID(p_rPluginId) && request.ReadDWORD(fileCount)) {
+                    p_rvFiles.clear();
+                    std::wstring file;
+                    while (p_rvFiles.size() < fileCount && request.ReadString(file)) {
+                        p_rvFiles.push_back(file);
+                    }
+                    if (!p_rvFiles.empty() && p_rvFiles.size() == fileCount) {
+                        response = S_OK;
+                    }
+                }
+            } else if (command == Quit) {
+                response = S_OK;
+            }
+        }
+
+        // Acknowledge request. Process it even if the client is gone by now.
+        ::ResetEvent(p_hEvent);
+        overlapped = OVERLAPPED();
+        overlapped.hEvent = p_hEvent;
+        bytes = 0;
+        CompleteIO(p_hPipe, ::WriteFile(p_hPipe, &response, sizeof(response), nullptr, &overlapped),
+                   overlapped, REQUEST_TIMEOUT, bytes);
+        ::FlushFileBuffers(p_hPipe);
+
+        return SUCCEEDED(response) ? static_cast<Command>(command) : static_cast<Command>(0);
+    }
+
+    //
+    // Waits for an overlapped I/O operation on a pipe to complete.
+    // If it doesn't complete in time, it is cancelled.
+    //
+    // @param p_hPipe Handle to pipe on which the operation was started.
+    // @param p_Result Result of the ReadFile/WriteFile call that started the operation.
+    // @param p_rOverlapped OVERLAPPED structure used to start the operation.
+    // @param p_Timeout Timeout, in milliseconds.
+    // @param p_rBytes Where to store the number of bytes transferred.
+    // @return Result code. For reads, returns HRESULT_FROM_WIN32(ERROR_MORE_DATA)
+    //         if message has more data to read.
+    //
+    HRESULT ResidentService::CompleteIO(HANDLE p_hPipe,
+                                        const BOOL p_Result,
+                                        OVERLAPPED& p_rOverlapped,
+                                        const DWORD p_Timeout,
+                                        DWORD& p_rBytes)
+    {
+        const DWORD error = p_Result ? ERROR_SUCCESS : ::GetLastError();
+        if (error != ERROR_SUCCESS && error != ERROR_IO_PENDING && error != ERROR_MORE_DATA) {
+            return HRESULT_FROM_WIN32(error);
+        }
+        if (::WaitForSingleObject(p_rOverlapped.hEvent, p_Timeout) != WAIT_OBJECT_0) {
+            ::CancelIo(p_hPipe);
+            ::GetOverlappedResult(p_hPipe, &p_rOverlapped, &p_rBytes, TRUE);
+            return HRESULT_FROM_WIN32(ERROR_TIMEOUT);
+        }
+        if (!::GetOverlappedResult(p_hPipe, &p_rOverlapped, &p_rBytes, FALSE)) {
+            return HRESULT_FROM_WIN32(::GetLastError());
+        }
+        return S_OK;
+    }
+
+    //
+    // Registers the global hotkeys configured in the settings. Hotkeys that
+    // can't be registered (because another application uses them, for
+    // instance) are skipped.
+    //
+    // @param p_rvPluginIds Where to store the IDs of the plugins to invoke
+    //                      for each hotkey, indexed by hotkey ID minus
+    //                      FIRST_HOTKEY_ID.
+    //
+    void ResidentService::RegisterHotkeys(GUIDV& p_rvPluginIds)
+    {
+        UInt32V vHotkeys;
+        if (!Settings().GetHotkeys(p_rvPluginIds, vHotkeys)) {
+            return;
+        }
+        for (size_t i = 0; i < vHotkeys.size(); ++i) {
+            const UINT virtualKey = vHotkeys[i] & 0xFF;
+            const UINT modifiers = (vHotkeys[i] >> 8) & (MOD_ALT | MOD_CONTROL | MOD_SHIFT | MOD_WIN);
+            if (virtualKey == 0 || !::RegisterHotKey(NULL, FIRST_HOTKEY_ID + static_cast<int>(i), modifiers, virtualKey)) {
+                p_rvPluginIds[i] = GUID_NULL;
+            }
+        }
+    }
+
+    //
+    // Unregisters hotkeys registered by RegisterHotkeys.
+    //
+    // @param p_vPluginIds IDs of plugins returned by RegisterHotkeys.
+    //
+    void ResidentService::UnregisterHotkeys(const GUIDV& p_vPluginIds)
+    {
+        for (size_t i = 0; i < p_vPluginIds.size(); ++i) {
+            if (p_vPluginIds[i] != GUID_NULL) {
+                ::UnregisterHotKey(NULL, FIRST_HOTKEY_ID + static_cast<int>(i));
+            }
+        }
+    }
+
+    //
+    // Returns the files selected in the active Explorer window, or on
+    // the desktop if it is active.
+    //
+    // @param p_rhWnd Where to store the handle of the Explorer window.
+    // @param p_rspDataObject Where to store the data object representing
+    //                        the selected files.
+    // @return true if files are selected in the active Explorer window.
+    //
+    bool ResidentService::GetExplorerSelection(HWND& p_rhWnd,
+                                               ATL::CComPtr<IDataObject>& p_rspDataObject)
+    {
+        p_rhWnd = ::GetForegroundWindow();
+        ATL::CComPtr<IShellWindows> spShellWindows;
+        if (p_rhWnd == NULL || FAILED(spShellWindows.CoCreateInstance(CLSID_ShellWindows))) {
+            return false;
+        }
+
+        // Find the shell window matching the active window.
+        ATL::CComPtr<IDispatch> spWindow;
+        wchar_t className[32];
+        if (::GetClassNameW(p_rhWnd, className, 32) != 0 &&
+            (::wcscmp(className, L"Progman") == 0 || ::wcscmp(className, L"WorkerW") == 0)) {
+
+            ATL::CComVariant vEmpty;
+            long desktopWnd = 0;
+            spShellWindows->FindWindowSW(&vEmpty, &vEmpty, SWC_DESKTOP, &desktopWnd, SWFO_NEEDDISPATCH, &spWindow);
+        } else {
+            long count = 0;
+            spShellWindows->get_Count(&count);
+            for (long i = 0; i < count && spWindow == nullptr; ++i) {
+                ATL::CComPtr<IDispatch> spDispatch;
+                ATL::CComVariant vIndex(i);
+                if (SUCCEEDED(spShellWindows->Item(vIndex, &spDispatch)) && spDispatch != nullptr) {
+                    ATL::CComQIPtr<IWebBrowserApp> spWebBrowserApp(spDispatch);
+                    SHANDLE_PTR hWnd = 0;
+                    if (spWebBrowserApp != nullptr && SUCCEEDED(spWebBrowserApp->get_HWND(&hWnd)) &&
+                        reinterpret_cast<HWND>(hWnd) == p_rhWnd) {
+
+                        spWindow = spDispatch;
+                    }
+                }
+            }
+        }
+
+        // Get the selection from the window's active view.
+        ATL::CComQIPtr<IServiceProvider> spServiceProvider(spWindow);
+        ATL::CComPtr<IShellBrowser> spShellBrowser;
+        ATL::CComPtr<IShellView> spShellView;
+        p_rspDataObject.Release();
+        return spServiceProvider != nullptr &&
+               SUCCEEDED(spServiceProvider->QueryService(SID_STopLevelBrowser, IID_PPV_ARGS(&spShellBrowser))) &&
+               SUCCEEDED(spShellBrowser->QueryActiveShellView(&spShellView)) &&
+               SUCCEEDED(spShellView->GetItemObject(SVGIO_SELECTION, IID_PPV_ARGS(&p_rspDataObject))) &&
+               p_rspDataObject != nullptr;
+    }
+
+} // namespace PCC
@@ -0,0 +1,199 @@
+// SettingsSnapshot.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <stdafx.h>
+#include <SettingsSnapshot.h>
+#include <PathCopyCopySettings.h>
+
+#include <algorithm>
+
+
+namespace PCC
+{
+    //
+    // Constructor. Reads all values from the given settings.
+    //
+    // @param p_Settings Settings to copy.
+    //
+    SettingsSnapshot::SettingsSnapshot(const Settings& p_Settings)
+        : m_UseHiddenShares(p_Settings.GetUseHiddenShares()),
+          m_UseFQDN(p_Settings.GetUseFQDN()),
+          m_AddQuotesAroundPaths(p_Settings.GetAddQuotesAroundPaths()),
+          m_AreQuotesOptional(p_Settings.GetAreQuotesOptional()),
+          m_MakePathsIntoEmailLinks(p_Settings.GetMakePathsIntoEmailLinks()),
+          m_EncodeParam(p_Settings.GetEncodeParam()),
+          m_AppendSeparatorForDirectories(p_Settings.GetAppendSeparatorForDirectories()),
+          m_DropRedundantWords(p_Settings.GetDropRedundantWords()),
+          m_PathsSeparator(p_Settings.GetPathsSeparator()),
+          m_CacheConvertedPaths(p_Settings.GetCacheConvertedPaths()),
+          m_ResolveDFSPaths(p_Settings.GetResolveDFSPaths()),
+          m_DisableShortNamesIfUnsupported(p_Settings.GetDisableShortNamesIfUnsupported()),
+          m_vProjectRootMarkers(p_Settings.GetProjectRootMarkers()),
+          m_mSambaServerAliases(p_Settings.GetSambaServerAliases()),
+          m_vPluginIconFiles(p_Settings.GetIconFilesForPlugins()),
+          m_Generation(p_Settings.GetGeneration())
+    {
+    }
+
+    //
+    // @return Whether to use hidden shares when computing UNC paths.
+    //
+    bool SettingsSnapshot::GetUseHiddenShares() const
+    {
+        return m_UseHiddenShares;
+    }
+
+    //
+    // @return Whether to use fully-qualified domain names in UNC paths.
+    //
+    bool SettingsSnapshot::GetUseFQDN() const
+    {
+        return m_UseFQDN;
+    }
+
+    //
+    // @return Whether to add quotes around copied paths.
+    //
+    bool SettingsSnapshot::GetAddQuotesAroundPaths() const
+    {
+        return m_AddQuotesAroundPaths;
+    }
+
+    //
+    // @return Whether quotes are only added around paths that contain spaces.
+    //
+    bool SettingsSnapshot::GetAreQuotesOptional() const
+    {
+        return m_AreQuotesOptional;
+    }
+
+    //
+    // @return Whether to turn copied paths into e-mail links.
+    //
+    bool SettingsSnapshot::GetMakePathsIntoEmailLinks() const
+    {
+        return m_MakePathsIntoEmailLinks;
+    }
+
+    //
+    // @return How to encode characters in copied paths.
+    //
+    StringUtils::EncodeParam SettingsSnapshot::GetEncodeParam() const
+    {
+        return m_EncodeParam;
+    }
+
+    //
+    // @return Whether to append a separator to the paths of directories.
+    //
+    bool SettingsSnapshot::GetAppendSeparatorForDirectories() const
+    {
+        return m_AppendSeparatorForDirectories;
+    }
+
+    //
+    // @return Whether to drop redundant words from plugin descriptions.
+    //
+    bool SettingsSnapshot::GetDropRedundantWords() const
+    {
+        return m_DropRedundantWords;
+    }
+
+    //
+    // @return Separator to use between multiple paths, or an empty string
+    //         to use the default separator.
+    //
+    const std::wstring& SettingsSnapshot::GetPathsSeparator() const
+    {
+        return m_PathsSeparator;
+    }
+
+    //
+    // @return Whether converted paths can be cached (see PathResultCache).
+    //
+    bool SettingsSnapshot::GetCacheConvertedPaths() const
+    {
+        return m_CacheConvertedPaths;
+    }
+
+    //
+    // @return Whether to resolve UNC paths in DFS namespaces to their targets.
+    //
+    bool SettingsSnapshot::GetResolveDFSPaths() const
+    {
+        return m_ResolveDFSPaths;
+    }
+
+    //
+    // @return Whether to disable short path plugins for volumes without short names.
+    //
+    bool SettingsSnapshot::GetDisableShortNamesIfUnsupported() const
+    {
+        return m_DisableShortNamesIfUnsupported;
+    }
+
+    //
+    // @return Names of files or folders marking the root of a repository or project.
+    //
+    const WStringV& SettingsSnapshot::GetProjectRootMarkers() const
+    {
+        return m_vProjectRootMarkers;
+    }
+
+    //
+    // @return Aliases of Windows servers in Samba paths, per lowercase server name.
+    //
+    const WStringWStringUM& SettingsSnapshot::GetSambaServerAliases() const
+    {
+        return m_mSambaServerAliases;
+    }
+
+    //
+    // Returns the icon file of a plugin, like Settings::GetIconFileForPlugin,
+    // but looks it up in the icon files read when the snapshot was taken.
+    //
+    // @param p_PluginId ID of plugin whose icon file we need.
+    // @return Path to icon file, empty string to use the default icon or
+    //         an empty optional value if plugin has no icon.
+    //
+    cl::optional<std::wstring> SettingsSnapshot::GetIconFileForPlugin(const CLSID& p_PluginId) const
+    {
+        cl::optional<std::wstring> iconFile;
+        const auto it = std::lower_bound(m_vPluginIconFiles.cbegin(), m_vPluginIconFiles.cend(), p_PluginId,
+                                         [](const GUIDWStringPairV::value_type& p_Pair, const CLSID& p_Id) {
+            return GUIDLess()(p_Pair.first, p_Id);
+        });
+        if (it != m_vPluginIconFiles.cend() && it->first == p_PluginId) {
+            iconFile = it->second;
+        }
+        return iconFile;
+    }
+
+    //
+    // @return Generation of the settings when the snapshot was taken.
+    //
+    ULONGLONG SettingsSnapshot::GetGeneration() const
+    {
+        return m_Generation;
+    }
+
+} // namespace PCC
@@ -0,0 +1,115 @@
+// ShareIndex.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <stdafx.h>
+#include <ShareIndex.h>
+
+
+namespace
+{
+    const wchar_t       HIDDEN_SHARE_SUFFIX = L'$';         // Suffix used for hidden shares.
+
+} // anonymous namespace
+
+namespace PCC
+{
+    //
+    // Constructor. Indexes the given shares.
+    //
+    // @param p_vShares Network shares of the local computer.
+    //
+    ShareIndex::ShareIndex(const NetworkEnvironment::ShareInfoV& p_vShares)
+        : m_AllShares(),
+          m_VisibleShares()
+    {
+        for (const NetworkEnvironment::ShareInfo& share : p_vShares) {
+            if (!share.m_Name.empty() && !share.m_Path.empty()) {
+                m_AllShares.Add(share.m_Path, share.m_Name);
+                if (share.m_Name.back() != HIDDEN_SHARE_SUFFIX) {
+                    m_VisibleShares.Add(share.m_Path, share.m_Name);
+                }
+            }
+        }
+    }
+
+    //
+    // Looks for the share containing the given path. If more than one share
+    // contains the path, the share with the longest path is returned.
+    //
+    // @param p_FilePath Local file path.
+    // @param p_UseHiddenShares Whether to consider hidden shares.
+    // @param p_rSharePath Upon exit, will contain the local path of the share.
+    // @param p_rShareName Upon exit, will contain the name of the share.
+    // @return true if a share containing the path was found.
+    //
+    bool ShareIndex::FindShare(const std::wstring& p_FilePath,
+                               const bool p_UseHiddenShares,
+                               std::wstring& p_rSharePath,
+                               std::wstring& p_rShareName) const
+    {
+        return (p_UseHiddenShares ? m_AllShares : m_VisibleShares).Find(p_FilePath, p_rSharePath, p_rShareName);
+    }
+
+    //
+    // Adds a share to the index. If a share already exists for
+    // this path, the first one is kept.
+    //
+    // @param p_SharePath Local path of the share.
+    // @param p_ShareName Name of the share.
+    //
+    void ShareIndex::Shares::Add(const std::wstring& p_SharePath,
+                                 const std::wstring& p_ShareName)
+    {
+        if (m_mShareNames.emplace(p_SharePath, p_ShareName).second) {
+            m_sPathLengths.insert(p_SharePath.size());
+        }
+    }
+
+    //
+    // Performs a longest-prefix lookup to find the share containing a path.
+    //
+    // @param p_FilePath Local file path.
+    // @param p_rSharePath Upon exit, will contain the local path of the share.
+    // @param p_rShareName Upon exit, will contain the name of the share.
+    // @return true if a share containing the path was found.
+    //
+    bool ShareIndex::Shares::Find(const std::wstring& p_FilePath,
+                                  std::wstring& p_rSharePath,
+                                  std::wstring& p_rShareName) const
+    {
+        // Only one lookup is needed per distinct share path length.
+        std::wstring prefix;
+        for (const std::wstring::size_type length : m_sPathLengths) {
+            if (length <= p_FilePath.size()) {
+                prefix.assign(p_FilePath, 0, length);
+                auto it = m_mShareNames.find(prefix);
+                if (it != m_mShareNames.end()) {
+                    p_rSharePath = it->first;
+                    p_rShareName = it->second;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+} // namespace PCC
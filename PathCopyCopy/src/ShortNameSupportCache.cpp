@@ -0,0 +1,247 @@
+// ShortNameSupportCache.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <stdafx.h>
+#include <ShortNameSupportCache.h>
+#include <DriveConnectivityCache.h>
+
+#include <cwchar>
+
+
+namespace
+{
+    // Number of long names that must be found without short names, with no
+    // short name found, before a volume is considered not to have short names.
+    const ULONG         MIN_LONG_NAMES_WITHOUT_SHORT_NAMES  = 16;
+
+    // Time during which a volume found not to have short names through
+    // conversions is remembered before support is learned again, in milliseconds.
+    const DWORD         UNSUPPORTED_TTL_MS                  = 10 * 60 * 1000;
+
+    // Maximum sizes of the parts of short names.
+    const size_t        MAX_SHORT_NAME_BASE_SIZE            = 8;
+    const size_t        MAX_SHORT_NAME_EXTENSION_SIZE       = 3;
+
+    // Characters that are not allowed in short names.
+    const wchar_t* const INVALID_SHORT_NAME_CHARS           = L" +,;=[]";
+
+    //
+    // Checks if a file name needs a short name to be accessed through an 8.3 path,
+    // e.g. if it does not follow the 8.3 format.
+    //
+    // @param p_Name File name, without path.
+    // @return true if name is a long name.
+    //
+    bool IsLongName(const std::wstring& p_Name)
+    {
+        if (p_Name.empty() || p_Name == L"." || p_Name == L"..") {
+            return false;
+        }
+        const auto dotPos = p_Name.find(L'.');
+        const size_t baseSize = dotPos != std::wstring::npos ? dotPos : p_Name.size();
+        const size_t extensionSize = dotPos != std::wstring::npos ? p_Name.size() - dotPos - 1 : 0;
+        return baseSize == 0 ||
+               baseSize > MAX_SHORT_NAME_BASE_SIZE ||
+               extensionSize > MAX_SHORT_NAME_EXTENSION_SIZE ||
+               (dotPos != std::wstring::npos && p_Name.find(L'.', dotPos + 1) != std::wstring::npos) ||
+               p_Name.find_first_of(INVALID_SHORT_NAME_CHARS) != std::wstring::npos;
+    }
+
+    //
+    // Checks if part of a path contains long names (see IsLongName).
+    //
+    // @param p_Path Path to check.
+    // @param p_Start Position where names start in p_Path (after the volume root).
+    // @return true if path contains at least one long name.
+    //
+    bool HasLongName(const std::wstring& p_Path,
+                     const std::wstring::size_type p_Start)
+    {
+        std::wstring::size_type nameStart = p_Start;
+        while (nameStart < p_Path.size()) {
+            auto nameEnd = p_Path.find_first_of(L"\\/", nameStart);
+            if (nameEnd == std::wstring::npos) {
+                nameEnd = p_Path.size();
+            }
+            if (IsLongName(p_Path.substr(nameStart, nameEnd - nameStart))) {
+                return true;
+            }
+            nameStart = nameEnd + 1;
+        }
+        return false;
+    }
+
+} // anonymous namespace
+
+namespace PCC
+{
+    // Static members of ShortNameSupportCache
+    ShortNameSupportCache::EntryM   ShortNameSupportCache::s_mEntries;
+    std::mutex                      ShortNameSupportCache::s_Lock;
+
+    //
+    // Checks whether the volume of the given path may have short names. If
+    // support for short names is not cached for the volume, it is detected
+    // from its file system; this is done once per volume.
+    //
+    // @param p_Path Path of file or directory.
+    // @return false if volume is known not to have short names, true otherwise.
+    //
+    bool ShortNameSupportCache::MayHaveShortNames(const std::wstring& p_Path)
+    {
+        std::wstring volumeRoot;
+        if (!GetVolumeRoot(p_Path, volumeRoot)) {
+            return true;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(s_Lock);
+            auto it = s_mEntries.find(volumeRoot);
+            if (it != s_mEntries.end()) {
+                Entry& rEntry = it->second;
+                if (rEntry.m_Support == Support::Unsupported && rEntry.m_LongNamesCount != 0 &&
+                    ::GetTickCount() - rEntry.m_Timestamp >= UNSUPPORTED_TTL_MS) {
+
+                    // Support was learned; learn it again in case short name generation was turned on.
+                    rEntry.m_Support = Support::Unknown;
+                    rEntry.m_LongNamesCount = 0;
+                }
+                return rEntry.m_Support != Support::Unsupported;
+            }
+        }
+
+        // Detect support outside the lock, since it can require a network round trip.
+        Entry entry;
+        entry.m_Support = DetectSupport(volumeRoot);
+        entry.m_LongNamesCount = 0;
+        entry.m_Timestamp = ::GetTickCount();
+
+        std::lock_guard<std::mutex> lock(s_Lock);
+        return s_mEntries.emplace(volumeRoot, entry).first->second.m_Support != Support::Unsupported;
+    }
+
+    //
+    // Records the result of the conversion of a path to its short version.
+    // Used to learn whether volumes have short names, if it could not be
+    // determined from their file system.
+    //
+    // @param p_Path Path that was converted.
+    // @param p_ShortPath Short version of p_Path.
+    //
+    void ShortNameSupportCache::RecordConversion(const std::wstring& p_Path,
+                                                 const std::wstring& p_ShortPath)
+    {
+        std::wstring volumeRoot;
+        if (!GetVolumeRoot(p_Path, volumeRoot)) {
+            return;
+        }
+        const bool converted = ::_wcsicmp(p_Path.c_str(), p_ShortPath.c_str()) != 0;
+        if (!converted && !HasLongName(p_Path, volumeRoot.size())) {
+            // Nothing to learn from a path made of short names only.
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(s_Lock);
+        auto it = s_mEntries.find(volumeRoot);
+        if (it != s_mEntries.end() && it->second.m_Support == Support::Unknown) {
+            Entry& rEntry = it->second;
+            if (converted) {
+                rEntry.m_Support = Support::Supported;
+                rEntry.m_Timestamp = ::GetTickCount();
+            } else if (++rEntry.m_LongNamesCount >= MIN_LONG_NAMES_WITHOUT_SHORT_NAMES) {
+                rEntry.m_Support = Support::Unsupported;
+                rEntry.m_Timestamp = ::GetTickCount();
+            }
+        }
+    }
+
+    //
+    // Flushes all cached info about volumes.
+    //
+    void ShortNameSupportCache::Flush()
+    {
+        std::lock_guard<std::mutex> lock(s_Lock);
+        s_mEntries.clear();
+    }
+
+    //
+    // Returns the root of the volume of a path, as used to identify the volume
+    // in the cache: the root of a drive (like c:\) or of a network share (like
+    // \\server\share\). Volumes mounted in folders are not identified separately.
+    //
+    // @param p_Path Path of file or directory.
+    // @param p_rVolumeRoot Where to store the lowercase volume root, with trailing separator.
+    // @return true if volume root could be determined.
+    //
+    bool ShortNameSupportCache::GetVolumeRoot(const std::wstring& p_Path,
+                                              std::wstring& p_rVolumeRoot)
+    {
+        std::wstring::size_type rootSize = 0;
+        if (p_Path.size() >= 3 && p_Path[1] == L':' && (p_Path[2] == L'\\' || p_Path[2] == L'/')) {
+            rootSize = 3;
+        } else if (p_Path.size() > 2 && p_Path[0] == L'\\' && p_Path[1] == L'\\' && p_Path[2] != L'?' && p_Path[2] != L'.') {
+            const auto shareStart = p_Path.find_first_of(L"\\/", 2);
+            if (shareStart != std::wstring::npos && shareStart > 2) {
+                const auto shareEnd = p_Path.find_first_of(L"\\/", shareStart + 1);
+                if (shareEnd != std::wstring::npos && shareEnd > shareStart + 1) {
+                    rootSize = shareEnd + 1;
+                }
+            }
+        }
+        if (rootSize == 0) {
+            return false;
+        }
+
+        p_rVolumeRoot.assign(p_Path, 0, rootSize);
+        p_rVolumeRoot.back() = L'\\';
+        ::CharLowerBuffW(&*p_rVolumeRoot.begin(), static_cast<DWORD>(p_rVolumeRoot.size()));
+        return true;
+    }
+
+    //
+    // Detects whether a volume has short names from its file system. FAT
+    // volumes always have short names, while some file systems never do.
+    // For others, like NTFS, short name generation can be disabled per volume,
+    // so support must be learned from conversions.
+    //
+    // @param p_VolumeRoot Root of volume, with trailing separator.
+    // @return Whether volume has short names, or Support::Unknown if it cannot be determined.
+    //
+    ShortNameSupportCache::Support ShortNameSupportCache::DetectSupport(const std::wstring& p_VolumeRoot)
+    {
+        Support support = Support::Unknown;
+        wchar_t fileSystemName[MAX_PATH + 1];
+        if (DriveConnectivityCache::IsReachable(p_VolumeRoot) &&
+            ::GetVolumeInformationW(p_VolumeRoot.c_str(), nullptr, 0, nullptr, nullptr, nullptr,
+                                    fileSystemName, MAX_PATH + 1) != FALSE) {
+
+            if (::_wcsicmp(fileSystemName, L"FAT") == 0 || ::_wcsicmp(fileSystemName, L"FAT32") == 0) {
+                support = Support::Supported;
+            } else if (::_wcsicmp(fileSystemName, L"ReFS") == 0 || ::_wcsicmp(fileSystemName, L"exFAT") == 0 ||
+                       ::_wcsicmp(fileSystemName, L"UDF") == 0) {
+
+                support = Support::Unsupported;
+            }
+        }
+        return support;
+    }
+
+} // namespace PCC
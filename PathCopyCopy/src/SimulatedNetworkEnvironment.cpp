@@ -0,0 +1,318 @@
+// SimulatedNetworkEnvironment.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <stdafx.h>
+
+#ifdef PCC_BENCHMARKS
+
+#include <SimulatedNetworkEnvironment.h>
+#include <PathCompare.h>
+
+#include <cwctype>
+#include <sstream>
+#include <thread>
+
+
+namespace
+{
+    const wchar_t* const    DEFAULT_COMPUTER_NAME   = L"simulated";         // Default simulated computer name.
+    const wchar_t* const    DEFAULT_DNS_SUFFIX      = L"corp.example.com";  // Default simulated DNS suffix.
+    const DWORD             DFS_TIME_TO_LIVE        = 300;                  // Time to live of simulated DFS referrals, in seconds.
+
+} // anonymous namespace
+
+namespace PCC
+{
+    //
+    // Constructor. By default, the environment has no mapped drives, shares
+    // nor DFS namespaces, DNS lookups succeed and no latency is simulated.
+    //
+    SimulatedNetworkEnvironment::SimulatedNetworkEnvironment()
+        : NetworkEnvironment(),
+          m_aLatencies(),
+          m_aCallCounts(),
+          m_mDriveUNCRoots(),
+          m_vShares(),
+          m_DNSBehavior(DNSBehavior::Resolve),
+          m_DNSSuffix(DEFAULT_DNS_SUFFIX),
+          m_vDFSLinks(),
+          m_ComputerName(DEFAULT_COMPUTER_NAME),
+          m_SharesChanged(false)
+    {
+        for (auto& callCount : m_aCallCounts) {
+            callCount = 0;
+        }
+    }
+
+    //
+    // Sets the time each call to an operation will take.
+    //
+    // @param p_Operation Operation to slow down.
+    // @param p_Latency Simulated latency.
+    //
+    void SimulatedNetworkEnvironment::SetLatency(const Operation p_Operation,
+                                                 const std::chrono::microseconds& p_Latency)
+    {
+        m_aLatencies[static_cast<size_t>(p_Operation)] = p_Latency;
+    }
+
+    //
+    // Adds a simulated mapped network drive.
+    //
+    // @param p_Drive Drive letter.
+    // @param p_UNCRoot Network path of the root of the drive, without trailing separator.
+    //                  Ex: \\server\share
+    //
+    void SimulatedNetworkEnvironment::AddMappedDrive(const wchar_t p_Drive,
+                                                     const std::wstring& p_UNCRoot)
+    {
+        m_mDriveUNCRoots[static_cast<wchar_t>(std::towupper(p_Drive))] = p_UNCRoot;
+    }
+
+    //
+    // Adds a simulated share of the local computer.
+    //
+    // @param p_Name Name of share. Hidden shares end with a '$'.
+    // @param p_Path Local path of share.
+    //
+    void SimulatedNetworkEnvironment::AddShare(const std::wstring& p_Name,
+                                               const std::wstring& p_Path)
+    {
+        m_vShares.emplace_back(p_Name, p_Path);
+    }
+
+    //
+    // Adds many simulated shares, named "Share1", "Share2", etc. and
+    // pointing to folders of the same name in the given root path.
+    //
+    // @param p_Count Number of shares to add.
+    // @param p_RootPath Root folder of shares, with a trailing separator (ex: C:\Shares\).
+    //
+    void SimulatedNetworkEnvironment::AddGeneratedShares(const size_t p_Count,
+                                                         const std::wstring& p_RootPath)
+    {
+        m_vShares.reserve(m_vShares.size() + p_Count);
+        for (size_t i = 1; i <= p_Count; ++i) {
+            std::wstringstream wss;
+            wss << L"Share" << i;
+            const std::wstring name = wss.str();
+            m_vShares.emplace_back(name, p_RootPath + name);
+        }
+    }
+
+    //
+    // Sets how simulated DNS lookups behave.
+    //
+    // @param p_Behavior Behavior of DNS lookups.
+    // @param p_DNSSuffix Suffix appended to host names by successful lookups.
+    //
+    void SimulatedNetworkEnvironment::SetDNSBehavior(const DNSBehavior p_Behavior,
+                                                     const std::wstring& p_DNSSuffix)
+    {
+        m_DNSBehavior = p_Behavior;
+        m_DNSSuffix = p_DNSSuffix;
+    }
+
+    //
+    // Adds a simulated DFS root or link.
+    //
+    // @param p_EntryPath Path of DFS root or link, without trailing separator.
+    //                    Ex: \\corp\Namespace\Link
+    // @param p_Target Network path of target, without trailing separator.
+    //                 Ex: \\server\share
+    //
+    void SimulatedNetworkEnvironment::AddDFSLink(const std::wstring& p_EntryPath,
+                                                 const std::wstring& p_Target)
+    {
+        DFSReferral referral;
+        referral.m_EntryPath = p_EntryPath;
+        referral.m_Target = p_Target;
+        referral.m_TimeToLive = DFS_TIME_TO_LIVE;
+        m_vDFSLinks.push_back(referral);
+    }
+
+    //
+    // Sets the simulated name of the local computer.
+    //
+    // @param p_ComputerName Name of local computer.
+    //
+    void SimulatedNetworkEnvironment::SetLocalComputerName(const std::wstring& p_ComputerName)
+    {
+        m_ComputerName = p_ComputerName;
+    }
+
+    //
+    // Sets whether SharesChanged returns true. Can be used while the environment
+    // is installed to measure the cost of rebuilding the index of shares.
+    //
+    // @param p_Changed Whether shares should be reported as changed.
+    //
+    void SimulatedNetworkEnvironment::SetSharesChanged(const bool p_Changed)
+    {
+        m_SharesChanged = p_Changed;
+    }
+
+    //
+    // Returns the number of calls made to an operation so far. Can be used
+    // to measure the effectiveness of caches and batching.
+    //
+    // @param p_Operation Operation to check.
+    // @return Number of calls made.
+    //
+    unsigned long SimulatedNetworkEnvironment::GetCallCount(const Operation p_Operation) const
+    {
+        return m_aCallCounts[static_cast<size_t>(p_Operation)];
+    }
+
+    //
+    // Returns the network path of a file on a simulated mapped drive.
+    //
+    // @param p_FilePath Local file path.
+    // @param p_rUniversalName Upon success, will contain the network path.
+    // @return NO_ERROR if the file is on a simulated mapped drive,
+    //         otherwise ERROR_NOT_CONNECTED.
+    //
+    DWORD SimulatedNetworkEnvironment::GetUniversalName(const std::wstring& p_FilePath,
+                                                        std::wstring& p_rUniversalName)
+    {
+        Call(Operation::UniversalName);
+
+        DWORD ret = ERROR_NOT_CONNECTED;
+        if (p_FilePath.size() >= 2 && p_FilePath[1] == L':') {
+            auto it = m_mDriveUNCRoots.find(static_cast<wchar_t>(std::towupper(p_FilePath[0])));
+            if (it != m_mDriveUNCRoots.end()) {
+                p_rUniversalName = it->second + p_FilePath.substr(2);
+                ret = NO_ERROR;
+            }
+        }
+        return ret;
+    }
+
+    //
+    // Returns the simulated shares of the local computer.
+    //
+    // @param p_rvShares Upon exit, will contain the shares.
+    // @return Always true.
+    //
+    bool SimulatedNetworkEnvironment::GetShares(ShareInfoV& p_rvShares)
+    {
+        Call(Operation::Shares);
+        p_rvShares = m_vShares;
+        return true;
+    }
+
+    //
+    // Checks whether simulated shares are reported as changed.
+    //
+    // @return Value set with SetSharesChanged.
+    //
+    bool SimulatedNetworkEnvironment::SharesChanged()
+    {
+        return m_SharesChanged;
+    }
+
+    //
+    // Performs a simulated DNS lookup.
+    //
+    // @param p_Hostname Host name.
+    // @param p_rFQDN Upon success, will contain the host name with the DNS suffix.
+    // @return true if lookups are set to succeed.
+    //
+    bool SimulatedNetworkEnvironment::GetFQDN(const std::wstring& p_Hostname,
+                                              std::wstring& p_rFQDN)
+    {
+        Call(Operation::FQDN);
+
+        const bool resolved = m_DNSBehavior == DNSBehavior::Resolve;
+        if (resolved) {
+            p_rFQDN = m_DNSSuffix.empty() ? p_Hostname : p_Hostname + L"." + m_DNSSuffix;
+        }
+        return resolved;
+    }
+
+    //
+    // Returns the referral of the simulated DFS root or link containing a path.
+    //
+    // @param p_UNCPath Network path.
+    // @param p_rReferral Upon success, will contain the referral of the
+    //                    longest simulated root or link containing the path.
+    // @return true if the path is in a simulated DFS namespace.
+    //
+    bool SimulatedNetworkEnvironment::GetDFSReferral(const std::wstring& p_UNCPath,
+                                                     DFSReferral& p_rReferral)
+    {
+        Call(Operation::DFSReferral);
+
+        const DFSReferral* pFound = nullptr;
+        for (const DFSReferral& link : m_vDFSLinks) {
+            const std::wstring::size_type size = link.m_EntryPath.size();
+            if (PathCompare::StartsWith(p_UNCPath, link.m_EntryPath) &&
+                (p_UNCPath.size() == size || p_UNCPath[size] == L'\\' || p_UNCPath[size] == L'/') &&
+                (pFound == nullptr || size > pFound->m_EntryPath.size())) {
+
+                pFound = &link;
+            }
+        }
+        if (pFound != nullptr) {
+            p_rReferral = *pFound;
+        }
+        return pFound != nullptr;
+    }
+
+    //
+    // Returns the simulated name of the local computer.
+    //
+    // @return Name of local computer.
+    //
+    std::wstring SimulatedNetworkEnvironment::GetLocalComputerName()
+    {
+        return m_ComputerName;
+    }
+
+    //
+    // Checks whether a drive can currently be accessed. Simulated mapped
+    // drives are always reachable.
+    //
+    // @param p_Drive Drive letter.
+    // @return Always true.
+    //
+    bool SimulatedNetworkEnvironment::IsDriveReachable(const wchar_t /*p_Drive*/)
+    {
+        return true;
+    }
+
+    //
+    // Records a call to an operation and waits for its simulated latency.
+    //
+    // @param p_Operation Operation called.
+    //
+    void SimulatedNetworkEnvironment::Call(const Operation p_Operation)
+    {
+        ++m_aCallCounts[static_cast<size_t>(p_Operation)];
+        const std::chrono::microseconds& latency = m_aLatencies[static_cast<size_t>(p_Operation)];
+        if (latency.count() > 0) {
+            std::this_thread::sleep_for(latency);
+        }
+    }
+
+} // namespace PCC
+
+#endif // PCC_BENCHMARKS
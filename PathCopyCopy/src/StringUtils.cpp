@@ -22,9 +22,59 @@
 #include <stdafx.h>
 #include <StringUtils.h>
 
+#include <algorithm>
 #include <assert.h>
-#include <functional>
-#include <sstream>
+
+// SSE2 is always available on x64 and when compiling for x86 with /arch:SSE2 (the default).
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   define PCC_STRINGUTILS_USE_SSE2
+#   include <emmintrin.h>
+#endif
+
+
+namespace
+{
+    // Encoding levels stored in URI_ENCODE_LEVELS for each character.
+    const unsigned char ENCODE_LEVEL_NEVER      = 0;    // Character is never encoded.
+    const unsigned char ENCODE_LEVEL_WHITESPACE = 1;    // Character is encoded if encoding whitespace or all.
+    const unsigned char ENCODE_LEVEL_ALL        = 2;    // Character is encoded only if encoding all.
+
+    // Encoding level of each ASCII character. Characters above 0x7F are never encoded.
+    const unsigned char URI_ENCODE_LEVELS[0x80] = {
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,   // 0x00-0x0F
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,   // 0x10-0x1F
+        1, 0, 2, 2, 0, 2, 0, 0, 0, 0, 0, 2, 0, 0, 0, 0,   // 0x20-0x2F
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 2, 0,   // 0x30-0x3F
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   // 0x40-0x4F
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 2, 2, 2, 0,   // 0x50-0x5F
+        2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   // 0x60-0x6F
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 2, 2, 0, 1,   // 0x70-0x7F
+    };
+
+    //
+    // Returns the number of characters needed to output the given character
+    // once URI-encoded. Encoded characters are output as a percent sign
+    // followed by their value in hexadecimal, without padding.
+    //
+    // @param p_Char Character to encode.
+    // @param p_MaxLevel Maximum encoding level of characters to encode.
+    // @return Number of characters needed to output p_Char.
+    //
+    inline std::wstring::size_type GetEncodedCharSize(const wchar_t p_Char,
+                                                      const unsigned char p_MaxLevel)
+    {
+        const unsigned int val = static_cast<unsigned int>(p_Char);
+        std::wstring::size_type size = 1;
+        if (val < 0x80) {
+            const unsigned char level = URI_ENCODE_LEVELS[val];
+            if (level != ENCODE_LEVEL_NEVER && level <= p_MaxLevel) {
+                size = val >= 0x10 ? 3 : 2;
+            }
+        }
+        return size;
+    }
+
+} // anonymous namespace
 
 
 //
@@ -38,19 +88,113 @@ void StringUtils::ReplaceAll(std::wstring& p_rString,
                              const std::wstring& p_OldValue,
                              const std::wstring& p_NewValue)
 {
-    std::wstring::size_type pos;
-    std::wstring::size_type from = 0;
-    do {
-        // Look for the next instance of the old value.
-        pos = p_rString.find(p_OldValue, from);
-        if (pos != std::wstring::npos) {
-            // Replace this instance with our replacement value.
-            p_rString.replace(pos, p_OldValue.size(), p_NewValue);
-
-            // Start looking after the replacement next time.
-            from = pos + p_NewValue.size();
+    if (p_OldValue.empty()) {
+        // Nothing to look for.
+    } else if (p_OldValue.size() == 1 && p_NewValue.size() == 1) {
+        // Single-character replacement, use the fast path.
+        ReplaceChar(p_rString, p_OldValue.front(), p_NewValue.front());
+    } else if (p_OldValue.size() == p_NewValue.size()) {
+        // Same length, we can overwrite each instance in-place.
+        std::wstring::size_type pos = p_rString.find(p_OldValue);
+        while (pos != std::wstring::npos) {
+            std::copy(p_NewValue.cbegin(), p_NewValue.cend(), p_rString.begin() + pos);
+            pos = p_rString.find(p_OldValue, pos + p_OldValue.size());
+        }
+    } else {
+        // Count instances first so that we can build the result in one allocation.
+        std::wstring::size_type count = 0;
+        std::wstring::size_type pos = p_rString.find(p_OldValue);
+        const std::wstring::size_type firstPos = pos;
+        while (pos != std::wstring::npos) {
+            ++count;
+            pos = p_rString.find(p_OldValue, pos + p_OldValue.size());
         }
-    } while (pos != std::wstring::npos);
+        if (count != 0) {
+            std::wstring result;
+            result.reserve(p_rString.size() - (count * p_OldValue.size()) + (count * p_NewValue.size()));
+            std::wstring::size_type from = 0;
+            pos = firstPos;
+            while (pos != std::wstring::npos) {
+                result.append(p_rString, from, pos - from);
+                result.append(p_NewValue);
+                from = pos + p_OldValue.size();
+                pos = p_rString.find(p_OldValue, from);
+            }
+            result.append(p_rString, from, std::wstring::npos);
+            p_rString = std::move(result);
+        }
+    }
+}
+
+//
+// Replaces all instances of a character in p_rString with another character.
+// This is faster than calling ReplaceAll with single-character strings.
+//
+// @param p_rString String to modify (in-place).
+// @param p_OldChar Character to look for.
+// @param p_NewChar Replacement character.
+//
+void StringUtils::ReplaceChar(std::wstring& p_rString,
+                              const wchar_t p_OldChar,
+                              const wchar_t p_NewChar)
+{
+    const std::wstring::size_type size = p_rString.size();
+    std::wstring::size_type i = 0;
+    if (size != 0) {
+        wchar_t* const pChars = &p_rString[0];
+#ifdef PCC_STRINGUTILS_USE_SSE2
+        // Process 8 characters at a time, only writing back blocks that contain the old char.
+        static_assert(sizeof(wchar_t) == sizeof(short), "SSE2 ReplaceChar implementation assumes 16-bit wchar_t");
+        const __m128i oldChars = _mm_set1_epi16(static_cast<short>(p_OldChar));
+        const __m128i newChars = _mm_set1_epi16(static_cast<short>(p_NewChar));
+        for (; i + 8 <= size; i += 8) {
+            __m128i* const pBlock = reinterpret_cast<__m128i*>(pChars + i);
+            const __m128i block = _mm_loadu_si128(pBlock);
+            const __m128i mask = _mm_cmpeq_epi16(block, oldChars);
+            if (_mm_movemask_epi8(mask) != 0) {
+                _mm_storeu_si128(pBlock, _mm_or_si128(_mm_and_si128(mask, newChars),
+                                                      _mm_andnot_si128(mask, block)));
+            }
+        }
+#endif // PCC_STRINGUTILS_USE_SSE2
+        for (; i < size; ++i) {
+            if (pChars[i] == p_OldChar) {
+                pChars[i] = p_NewChar;
+            }
+        }
+    }
+}
+
+//
+// Checks if a string contains only ASCII characters. This is meant to
+// skip costly processing that does not affect ASCII strings.
+//
+// @param p_String String to check.
+// @return true if all characters of p_String are below 0x80.
+//
+bool StringUtils::IsASCII(const std::wstring& p_String)
+{
+    const std::wstring::size_type size = p_String.size();
+    const wchar_t* const pChars = p_String.c_str();
+    std::wstring::size_type i = 0;
+#ifdef PCC_STRINGUTILS_USE_SSE2
+    // Check 8 characters at a time, accumulating their high bits.
+    static_assert(sizeof(wchar_t) == sizeof(short), "SSE2 IsASCII implementation assumes 16-bit wchar_t");
+    const __m128i nonASCIIMask = _mm_set1_epi16(static_cast<short>(~0x7F));
+    __m128i highBits = _mm_setzero_si128();
+    for (; i + 8 <= size; i += 8) {
+        highBits = _mm_or_si128(highBits, _mm_loadu_si128(reinterpret_cast<const __m128i*>(pChars + i)));
+    }
+    if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(highBits, nonASCIIMask), _mm_setzero_si128())) != 0xFFFF) {
+        return false;
+    }
+#endif // PCC_STRINGUTILS_USE_SSE2
+    for (; i < size; ++i) {
+        if (pChars[i] > 0x7F) {
+            return false;
+        }
+    }
+    return true;
 }
 
 //
@@ -97,40 +241,41 @@ void StringUtils::EncodeURICharacters(std::wstring& p_rString,
     // https://pathcopycopy.codeplex.com/workitem/11374
 
     if (p_EncodeParam != EncodeParam::None) {
-        // Choose function to identify characters to encode.
-        std::function<bool(wchar_t)> identifyFunc;
-        switch (p_EncodeParam) {
-            case EncodeParam::Whitespace: {
-                identifyFunc = [](const wchar_t p_Char) {
-                    const unsigned int val = static_cast<unsigned int>(p_Char);
-                    return val <= 0x1F || val == 0x20 || val == 0x7F;
-                };
-                break;
-            }
-            case EncodeParam::All: {
-                identifyFunc = [](const wchar_t p_Char) {
-                    const unsigned int val = static_cast<unsigned int>(p_Char);
-                    return val <= 0x1F || val == 0x20 || val == 0x7F || p_Char == L'<' || p_Char == L'>' ||
-                        p_Char == L'#' || p_Char == L'%' || p_Char == L'"' || p_Char == L'{' ||
-                        p_Char == L'}' || p_Char == L'|' || p_Char == L'\\' || p_Char == L'^' ||
-                        p_Char == L'[' || p_Char == L']' || p_Char == L'`' || p_Char == L'+';
-                };
-                break;
-            }
-            default:
-                assert(false);
-        }
+        const unsigned char maxLevel = p_EncodeParam == EncodeParam::All ? ENCODE_LEVEL_ALL : ENCODE_LEVEL_WHITESPACE;
+        assert(p_EncodeParam == EncodeParam::All || p_EncodeParam == EncodeParam::Whitespace);
 
-        std::wstringstream wss;
-        wss << std::hex;
-        for (std::wstring::const_iterator it = p_rString.cbegin(); it != p_rString.cend(); ++it) {
-            const wchar_t curChar = *it;
-            if (identifyFunc(curChar)) {
-                wss << L"%" << static_cast<unsigned int>(curChar);
-            } else {
-                wss << curChar;
+        // First compute the size of the encoded string, so that we can skip
+        // strings that do not need encoding and allocate only once otherwise.
+        std::wstring::size_type encodedSize = 0;
+        for (const wchar_t curChar : p_rString) {
+            encodedSize += GetEncodedCharSize(curChar, maxLevel);
+        }
+        if (encodedSize != p_rString.size()) {
+            static const wchar_t HEX_DIGITS[] = L"0123456789abcdef";
+            std::wstring encoded;
+            encoded.reserve(encodedSize);
+            for (const wchar_t curChar : p_rString) {
+                const unsigned int val = static_cast<unsigned int>(curChar);
+                switch (GetEncodedCharSize(curChar, maxLevel)) {
+                    case 3: {
+                        encoded.push_back(L'%');
+                        encoded.push_back(HEX_DIGITS[val >> 4]);
+                        encoded.push_back(HEX_DIGITS[val & 0xF]);
+                        break;
+                    }
+                    case 2: {
+                        encoded.push_back(L'%');
+                        encoded.push_back(HEX_DIGITS[val]);
+                        break;
+                    }
+                    default: {
+                        encoded.push_back(curChar);
+                        break;
+                    }
+                }
             }
+            assert(encoded.size() == encodedSize);
+            p_rString = std::move(encoded);
         }
-        p_rString = wss.str();
     }
 }
@@ -0,0 +1,376 @@
+// SystemNetworkEnvironment.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <stdafx.h>
+#include <SystemNetworkEnvironment.h>
+#include <MachineNetworkCache.h>
+#include <PluginUtils.h>
+
+#include <memory>
+
+#include <lm.h>
+
+
+namespace
+{
+    const DWORD         UNC_NAME_INITIAL_BUFFER_SIZE    = 1024; // Initial size of buffer used to fetch UNC name.
+    const DWORD         SHARE_INFO_INITIAL_BUFFER_SIZE  = 1024; // Initial size of buffer used to read share info.
+    const DWORD         MAX_REG_KEY_NAME_SIZE           = 255;  // Max size of a registry key's name.
+
+    const wchar_t       SHARES_KEY_NAME[]   = L"SYSTEM\\CurrentControlSet\\Services\\Lanmanserver\\Shares"; // Name of key storing network shares
+    const wchar_t       SHARE_PATH_VALUE[]  = L"Path=";     // Part of a share key's value containing the share path.
+
+} // anonymous namespace
+
+namespace PCC
+{
+    //
+    // Constructor.
+    //
+    // @param p_UseMachineCache Whether to use info published by the MachineNetworkCache,
+    //                          if available. The cache's writer itself does not.
+    //
+    SystemNetworkEnvironment::SystemNetworkEnvironment(const bool p_UseMachineCache /*= true*/)
+        : NetworkEnvironment(),
+          m_UseMachineCache(p_UseMachineCache),
+          m_SharesKey(),
+          m_hSharesChangeEvent(),
+          m_WatchingShares(false),
+          m_SharesLock(),
+          m_WinsockStarted(false),
+          m_WinsockLock()
+    {
+    }
+
+    //
+    // Fetches the network path of a file on a mapped drive using WNetGetUniversalName.
+    //
+    // @param p_FilePath Local file path.
+    // @param p_rUniversalName Upon success, will contain the network path.
+    // @return NO_ERROR if successful, otherwise a Win32 error code.
+    //
+    DWORD SystemNetworkEnvironment::GetUniversalName(const std::wstring& p_FilePath,
+                                                     std::wstring& p_rUniversalName)
+    {
+        // Try with a buffer on the stack first; most network paths fit in it.
+        union {
+            UNIVERSAL_NAME_INFOW    m_Info;
+            char                    m_Buffer[UNC_NAME_INITIAL_BUFFER_SIZE];
+        } stackBuffer;
+        DWORD bufferSize = sizeof(stackBuffer);
+        std::unique_ptr<char[]> upBuffer;
+        void* pBuffer = &stackBuffer;
+        DWORD ret = ::WNetGetUniversalNameW(p_FilePath.c_str(),
+                                            UNIVERSAL_NAME_INFO_LEVEL,
+                                            pBuffer,
+                                            &bufferSize);
+        while (ret == ERROR_MORE_DATA) {
+            // bufferSize now contains the required size.
+            upBuffer.reset(new char[bufferSize]);
+            pBuffer = upBuffer.get();
+            ret = ::WNetGetUniversalNameW(p_FilePath.c_str(),
+                                          UNIVERSAL_NAME_INFO_LEVEL,
+                                          pBuffer,
+                                          &bufferSize);
+        }
+        if (ret == NO_ERROR) {
+            p_rUniversalName.assign(static_cast<UNIVERSAL_NAME_INFOW*>(pBuffer)->lpUniversalName);
+        }
+        return ret;
+    }
+
+    //
+    // Enumerates the network shares of the local computer with NetShareEnum.
+    // If it is not allowed (it requires administrative rights), shares are read
+    // from the Lanmanserver registry key instead. Change notification on that
+    // key is armed before enumerating so that SharesChanged does not miss any change.
+    //
+    // @param p_rvShares Upon success, will contain the shares.
+    // @return true if shares could be enumerated.
+    //
+    bool SystemNetworkEnvironment::GetShares(ShareInfoV& p_rvShares)
+    {
+        FILETIME sharesWriteTime;
+        return GetShares(p_rvShares, sharesWriteTime);
+    }
+
+    //
+    // Enumerates the network shares of the local computer like the other
+    // overload, also returning the last write time of the Lanmanserver registry
+    // key when they were enumerated. If the MachineNetworkCache published
+    // shares since that time, they are returned instead.
+    //
+    // @param p_rvShares Upon success, will contain the shares.
+    // @param p_rSharesWriteTime Upon exit, will contain the last write time of the
+    //                           shares registry key, or zero if it doesn't exist.
+    // @return true if shares could be enumerated.
+    //
+    bool SystemNetworkEnvironment::GetShares(ShareInfoV& p_rvShares,
+                                             FILETIME& p_rSharesWriteTime)
+    {
+        std::lock_guard<std::mutex> lock(m_SharesLock);
+
+        if (m_SharesKey.m_hKey == NULL) {
+            m_SharesKey.Open(HKEY_LOCAL_MACHINE, SHARES_KEY_NAME, KEY_READ);
+        }
+
+        if (m_hSharesChangeEvent == NULL) {
+            m_hSharesChangeEvent.Attach(::CreateEventW(nullptr, TRUE, FALSE, nullptr));
+        } else {
+            ::ResetEvent(m_hSharesChangeEvent);
+        }
+        // If we can't watch for changes, SharesChanged will always return true.
+        m_WatchingShares = m_hSharesChangeEvent != NULL && m_SharesKey.m_hKey != NULL &&
+                           m_SharesKey.NotifyChangeKeyValue(FALSE, REG_NOTIFY_CHANGE_NAME | REG_NOTIFY_CHANGE_LAST_SET,
+                                                            m_hSharesChangeEvent) == ERROR_SUCCESS;
+
+        p_rSharesWriteTime = FILETIME();
+        if (m_SharesKey.m_hKey != NULL) {
+            ::RegQueryInfoKeyW(m_SharesKey, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+                               nullptr, nullptr, nullptr, nullptr, &p_rSharesWriteTime);
+        }
+
+        p_rvShares.clear();
+        if (m_UseMachineCache && MachineNetworkCache::GetShares(p_rSharesWriteTime, p_rvShares)) {
+            return true;
+        }
+        return EnumerateShares(p_rvShares) || ReadRegistryShares(p_rvShares);
+    }
+
+    //
+    // Enumerates the disk shares of the local computer with a single call to
+    // NetShareEnum. Special shares (like C$ or ADMIN$) are skipped, since hidden
+    // drive shares are handled separately (see PluginUtils::GetHiddenDriveShareFilePath).
+    //
+    // Must be called with m_SharesLock held.
+    //
+    // @param p_rvShares Upon success, will contain the shares.
+    // @return true if shares could be enumerated.
+    //
+    bool SystemNetworkEnvironment::EnumerateShares(ShareInfoV& p_rvShares)
+    {
+        PSHARE_INFO_2 pShares = nullptr;
+        DWORD read = 0, total = 0;
+        const NET_API_STATUS status = ::NetShareEnum(nullptr, 2, reinterpret_cast<LPBYTE*>(&pShares),
+                                                     MAX_PREFERRED_LENGTH, &read, &total, nullptr);
+        const bool enumerated = status == NERR_Success;
+        if (enumerated && pShares != nullptr) {
+            p_rvShares.reserve(read);
+            for (DWORD i = 0; i < read; ++i) {
+                const SHARE_INFO_2& share = pShares[i];
+                if ((share.shi2_type & STYPE_MASK) == STYPE_DISKTREE && (share.shi2_type & STYPE_SPECIAL) == 0 &&
+                    share.shi2_netname != nullptr && share.shi2_path != nullptr && share.shi2_path[0] != L'\0') {
+
+                    p_rvShares.emplace_back(share.shi2_netname, share.shi2_path);
+                }
+            }
+        }
+        if (pShares != nullptr) {
+            ::NetApiBufferFree(pShares);
+        }
+        return enumerated;
+    }
+
+    //
+    // Enumerates the network shares of the local computer found in the
+    // Lanmanserver registry key. Used when NetShareEnum is not allowed.
+    //
+    // Must be called with m_SharesLock held.
+    //
+    // @param p_rvShares Upon success, will contain the shares.
+    // @return true if shares could be enumerated.
+    //
+    bool SystemNetworkEnvironment::ReadRegistryShares(ShareInfoV& p_rvShares)
+    {
+        if (m_SharesKey.m_hKey == NULL) {
+            return false;
+        }
+
+        // Shares are stored in multi-string registry values in the Lanmanserver service keys.
+        // The buffer used to read them is reused for all values and only grows when needed.
+        wchar_t valueName[MAX_REG_KEY_NAME_SIZE + 1];
+        ULONG bufferCapacity = SHARE_INFO_INITIAL_BUFFER_SIZE;
+        std::unique_ptr<wchar_t[]> buffer(new wchar_t[bufferCapacity]);
+        std::wstring multiStringValue;
+        LONG ret = 0;
+        DWORD i = 0;
+        do {
+            DWORD valueNameSize = MAX_REG_KEY_NAME_SIZE;
+            DWORD valueType = 0;
+            ret = ::RegEnumValue(m_SharesKey, i, valueName, &valueNameSize, 0, &valueType, 0, 0);
+            if (ret == ERROR_SUCCESS && valueType == REG_MULTI_SZ) {
+                // Get the multi-string values.
+                ULONG bufferSize = bufferCapacity;
+                ret = m_SharesKey.QueryMultiStringValue(valueName, buffer.get(), &bufferSize);
+                while (ret == ERROR_MORE_DATA) {
+                    bufferCapacity = bufferSize;
+                    buffer.reset(new wchar_t[bufferCapacity]);
+                    ret = m_SharesKey.QueryMultiStringValue(valueName, buffer.get(), &bufferSize);
+                }
+                if (ret == ERROR_SUCCESS && valueNameSize != 0) {
+                    // Find the "Path=" part of the mult-string. This contains the share path.
+                    multiStringValue.assign(buffer.get(), bufferSize);
+                    std::wstring path = PluginUtils::GetMultiStringLineBeginningWith(multiStringValue, SHARE_PATH_VALUE);
+                    if (!path.empty()) {
+                        p_rvShares.emplace_back(valueName, path);
+                    }
+                }
+            }
+
+            // Go to next share.
+            ++i;
+        } while (ret == ERROR_SUCCESS);
+
+        return true;
+    }
+
+    //
+    // Checks whether the Lanmanserver shares registry key has changed
+    // since GetShares was last called. Does not lock, so that callers
+    // don't wait for shares being enumerated by another thread.
+    //
+    // @return true if shares have changed or if we cannot watch for changes.
+    //
+    bool SystemNetworkEnvironment::SharesChanged()
+    {
+        return !m_WatchingShares || ::WaitForSingleObject(m_hSharesChangeEvent, 0) != WAIT_TIMEOUT;
+    }
+
+    //
+    // Looks up the fully-qualified domain name (FQDN) of a host using Winsock.
+    // Winsock is initialized on first use and then kept initialized for the lifetime of the process.
+    //
+    // @param p_Hostname Host name.
+    // @param p_rFQDN Upon success, will contain the FQDN of the host.
+    // @return true if the lookup succeeded.
+    //
+    bool SystemNetworkEnvironment::GetFQDN(const std::wstring& p_Hostname,
+                                           std::wstring& p_rFQDN)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_WinsockLock);
+            if (!m_WinsockStarted) {
+                WSADATA wsaData;
+                m_WinsockStarted = ::WSAStartup(MAKEWORD(2, 2), &wsaData) == 0;
+            }
+            if (!m_WinsockStarted) {
+                return false;
+            }
+        }
+
+        bool resolved = false;
+        ADDRINFOW hints = { 0 };
+        hints.ai_flags = AI_CANONNAME;
+        hints.ai_family = AF_UNSPEC;
+        PADDRINFOW pAddrInfo = nullptr;
+        if (::GetAddrInfoW(p_Hostname.c_str(), nullptr, &hints, &pAddrInfo) == 0) {
+            if (pAddrInfo != nullptr && pAddrInfo->ai_canonname != nullptr && pAddrInfo->ai_canonname[0] != L'\0') {
+                p_rFQDN = pAddrInfo->ai_canonname;
+                resolved = true;
+            }
+            ::FreeAddrInfoW(pAddrInfo);
+        }
+        return resolved;
+    }
+
+    //
+    // Fetches the DFS referral of a network path using NetDfsGetClientInfo.
+    // If the root or link has many targets, the active one is used.
+    //
+    // @param p_UNCPath Network path.
+    // @param p_rReferral Upon success, will contain the referral.
+    // @return true if the path is in a DFS namespace.
+    //
+    bool SystemNetworkEnvironment::GetDFSReferral(const std::wstring& p_UNCPath,
+                                                  DFSReferral& p_rReferral)
+    {
+        bool found = false;
+        PDFS_INFO_4 pInfo = nullptr;
+        if (::NetDfsGetClientInfo(const_cast<LPWSTR>(p_UNCPath.c_str()), nullptr, nullptr,
+                                  4, reinterpret_cast<LPBYTE*>(&pInfo)) == NERR_Success) {
+            if (pInfo != nullptr && pInfo->EntryPath != nullptr && pInfo->NumberOfStorages != 0) {
+                const DFS_STORAGE_INFO* pStorage = pInfo->Storage;
+                for (DWORD i = 0; i < pInfo->NumberOfStorages; ++i) {
+                    if ((pInfo->Storage[i].State & DFS_STORAGE_STATE_ACTIVE) != 0) {
+                        pStorage = &pInfo->Storage[i];
+                        break;
+                    }
+                }
+                if (pStorage->ServerName != nullptr && pStorage->ShareName != nullptr) {
+                    p_rReferral.m_EntryPath = pInfo->EntryPath;
+                    p_rReferral.m_Target = L"\\\\";
+                    p_rReferral.m_Target.append(pStorage->ServerName).append(1, L'\\').append(pStorage->ShareName);
+                    p_rReferral.m_TimeToLive = pInfo->Timeout;
+                    found = true;
+                }
+            }
+        }
+        if (pInfo != nullptr) {
+            ::NetApiBufferFree(pInfo);
+        }
+        return found;
+    }
+
+    //
+    // Returns the name of the local computer using GetComputerName.
+    //
+    // @return Name of local computer, or an empty string if it cannot be fetched.
+    //
+    std::wstring SystemNetworkEnvironment::GetLocalComputerName()
+    {
+        std::wstring computerName;
+        DWORD length = MAX_COMPUTERNAME_LENGTH + 1;
+        wchar_t name[MAX_COMPUTERNAME_LENGTH + 1];
+        if (::GetComputerNameW(name, &length) != FALSE) {
+            computerName.assign(name, length);
+        }
+        return computerName;
+    }
+
+    //
+    // Checks whether a drive can currently be accessed. Local drives are
+    // always considered reachable. For mapped network drives, the connection
+    // state is checked using WNetGetConnection, which does not go to the network;
+    // if the drive is connected, its root is then probed, which can block
+    // until the network times out if the server is unreachable.
+    //
+    // @param p_Drive Drive letter.
+    // @return true if drive is reachable or is not a network drive.
+    //
+    bool SystemNetworkEnvironment::IsDriveReachable(const wchar_t p_Drive)
+    {
+        // Remembered connections that are disconnected do not always report as remote drives.
+        const std::wstring root{ p_Drive, L':', L'\\' };
+        const UINT driveType = ::GetDriveTypeW(root.c_str());
+        if (driveType != DRIVE_REMOTE && driveType != DRIVE_NO_ROOT_DIR) {
+            return true;
+        }
+
+        const std::wstring localName{ p_Drive, L':' };
+        wchar_t remoteName[UNC_NAME_INITIAL_BUFFER_SIZE];
+        DWORD remoteNameSize = UNC_NAME_INITIAL_BUFFER_SIZE;
+        if (::WNetGetConnectionW(localName.c_str(), remoteName, &remoteNameSize) == ERROR_CONNECTION_UNAVAIL) {
+            return false;
+        }
+        return driveType != DRIVE_REMOTE || ::GetFileAttributesW(root.c_str()) != INVALID_FILE_ATTRIBUTES;
+    }
+
+} // namespace PCC
@@ -0,0 +1,246 @@
+// ThreadPool.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <stdafx.h>
+#include <ThreadPool.h>
+
+#include <algorithm>
+
+#include <assert.h>
+
+
+namespace
+{
+    const unsigned int  MIN_WORKER_THREADS  = 4;    // Minimum number of worker threads; tasks often wait for the network.
+    const unsigned int  MAX_WORKER_THREADS  = 8;    // Maximum number of worker threads.
+
+} // anonymous namespace
+
+namespace PCC
+{
+    // Static members of ThreadPool
+    ThreadPool::WorkerUPV           ThreadPool::s_vupWorkers;
+    std::vector<std::thread>        ThreadPool::s_vThreads;
+    std::atomic<size_t>             ThreadPool::s_NextWorker(0);
+    size_t                          ThreadPool::s_PendingTasks = 0;
+    bool                            ThreadPool::s_Stopping = false;
+    std::mutex                      ThreadPool::s_Lock;
+    std::condition_variable         ThreadPool::s_TaskPending;
+    std::mutex                      ThreadPool::s_StartStopLock;
+
+    //
+    // Constructor.
+    //
+    // @param p_Function Function to run.
+    //
+    ThreadPool::Task::Task(const std::function<void()>& p_Function)
+        : m_Function(p_Function),
+          m_Cancelled(false)
+    {
+    }
+
+    //
+    // Cancels the task. If it hasn't started yet, it will not run;
+    // otherwise, the task can check Cancelled to stop early.
+    //
+    void ThreadPool::Task::Cancel()
+    {
+        m_Cancelled = true;
+    }
+
+    //
+    // Checks if the task has been cancelled.
+    //
+    // @return true if Cancel has been called.
+    //
+    bool ThreadPool::Task::Cancelled() const
+    {
+        return m_Cancelled;
+    }
+
+    //
+    // Submits a task to run on a worker thread. Starts the worker threads
+    // if they are not running.
+    //
+    // @param p_Function Function to run.
+    // @param p_Priority Priority of the task.
+    // @return Handle to the task, which can be used to cancel it.
+    // @throw std::system_error if no worker thread could be started.
+    //
+    ThreadPool::TaskSP ThreadPool::Submit(const std::function<void()>& p_Function,
+                                          const Priority p_Priority /*= Priority::Normal*/)
+    {
+        std::lock_guard<std::mutex> startStopLock(s_StartStopLock);
+
+        if (s_vThreads.empty()) {
+            const unsigned int numThreads = (std::min)((std::max)(std::thread::hardware_concurrency(), MIN_WORKER_THREADS),
+                                                       MAX_WORKER_THREADS);
+            s_vupWorkers.clear();
+            for (unsigned int i = 0; i < numThreads; ++i) {
+                s_vupWorkers.emplace_back(new Worker);
+            }
+            try {
+                for (unsigned int i = 0; i < numThreads; ++i) {
+                    s_vThreads.emplace_back(&ThreadPool::Run, static_cast<size_t>(i));
+                }
+            } catch (...) {
+                if (s_vThreads.empty()) {
+                    throw;
+                }
+            }
+        }
+
+        // The task will be done after our caller is gone, so make sure our DLL is not unloaded before.
+        TaskSP spTask(new Task(p_Function));
+        ATL::_pAtlModule->Lock();
+        Worker& rWorker = *s_vupWorkers[s_NextWorker++ % s_vThreads.size()];
+        {
+            std::lock_guard<std::mutex> lock(rWorker.m_Lock);
+            rWorker.m_dqspTasks[static_cast<size_t>(p_Priority)].push_back(spTask);
+        }
+        {
+            std::lock_guard<std::mutex> lock(s_Lock);
+            ++s_PendingTasks;
+        }
+        s_TaskPending.notify_one();
+        return spTask;
+    }
+
+    //
+    // Stops the worker threads, waiting for them to exit. Should only be
+    // called when our DLL can be unloaded, e.g. when no task is pending.
+    // Worker threads will be started again if another task is submitted.
+    //
+    void ThreadPool::Stop()
+    {
+        std::lock_guard<std::mutex> startStopLock(s_StartStopLock);
+
+        if (!s_vThreads.empty()) {
+            {
+                std::lock_guard<std::mutex> lock(s_Lock);
+                s_Stopping = true;
+            }
+            s_TaskPending.notify_all();
+            for (std::thread& thread : s_vThreads) {
+                thread.join();
+            }
+            s_vThreads.clear();
+
+            // Tasks left in the queues cannot be run anymore; the DLL can't be
+            // unloadable if there are some, but release their locks just in case.
+            for (const std::unique_ptr<Worker>& upWorker : s_vupWorkers) {
+                for (std::deque<TaskSP>& dqspTasks : upWorker->m_dqspTasks) {
+                    for (size_t i = 0; i < dqspTasks.size(); ++i) {
+                        ATL::_pAtlModule->Unlock();
+                    }
+                }
+            }
+            s_vupWorkers.clear();
+
+            std::lock_guard<std::mutex> lock(s_Lock);
+            s_PendingTasks = 0;
+            s_Stopping = false;
+        }
+    }
+
+    //
+    // Main function of worker threads. Waits for tasks and runs them until stopped.
+    //
+    // @param p_WorkerIndex Index of the thread's worker in s_vupWorkers.
+    //
+    void ThreadPool::Run(const size_t p_WorkerIndex)
+    {
+        for (;;) {
+            // Claim a pending task; this guarantees that one of the queues has a task for us.
+            {
+                std::unique_lock<std::mutex> lock(s_Lock);
+                s_TaskPending.wait(lock, []() {
+                    return s_Stopping || s_PendingTasks != 0;
+                });
+                if (s_Stopping) {
+                    break;
+                }
+                --s_PendingTasks;
+            }
+
+            TaskSP spTask = TakeTask(p_WorkerIndex);
+            assert(spTask != nullptr);
+            if (spTask != nullptr) {
+                RunTask(spTask);
+            }
+        }
+    }
+
+    //
+    // Takes the task with the highest priority from a worker's queues, or
+    // steals one from another worker if the worker has no task at that priority.
+    // A worker runs its own tasks in order, while stolen tasks are taken from
+    // the end of the queues.
+    //
+    // @param p_WorkerIndex Index of the worker in s_vupWorkers.
+    // @return Task to run, or nullptr if there are none.
+    //
+    ThreadPool::TaskSP ThreadPool::TakeTask(const size_t p_WorkerIndex)
+    {
+        TaskSP spTask;
+        const size_t numWorkers = s_vupWorkers.size();
+        for (size_t priority = 0; spTask == nullptr && priority < PRIORITY_COUNT; ++priority) {
+            for (size_t i = 0; spTask == nullptr && i < numWorkers; ++i) {
+                Worker& rWorker = *s_vupWorkers[(p_WorkerIndex + i) % numWorkers];
+                std::lock_guard<std::mutex> lock(rWorker.m_Lock);
+                std::deque<TaskSP>& dqspTasks = rWorker.m_dqspTasks[priority];
+                if (!dqspTasks.empty()) {
+                    if (i == 0) {
+                        spTask = std::move(dqspTasks.front());
+                        dqspTasks.pop_front();
+                    } else {
+                        spTask = std::move(dqspTasks.back());
+                        dqspTasks.pop_back();
+                    }
+                }
+            }
+        }
+        return spTask;
+    }
+
+    //
+    // Runs a task unless it has been cancelled, then releases its lock on our DLL.
+    //
+    // @param p_spTask Task to run.
+    //
+    void ThreadPool::RunTask(const TaskSP& p_spTask)
+    {
+        // Clear the function once done, since the state it captures might
+        // refer to the task's handle.
+        std::function<void()> function;
+        function.swap(p_spTask->m_Function);
+        if (!p_spTask->Cancelled()) {
+            try {
+                function();
+            } catch (...) {
+                // Tasks should handle their own errors; don't let them end our thread.
+            }
+        }
+        function = nullptr;
+        ATL::_pAtlModule->Unlock();
+    }
+
+} // namespace PCC
@@ -0,0 +1,152 @@
+// Trace.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+
+#include <stdafx.h>
+#include <Trace.h>
+
+#include <cwchar>
+
+
+namespace
+{
+    const UCHAR         TRACE_LEVEL_INFO        = 4;        // Level of our events (TRACE_LEVEL_INFORMATION).
+    const ULONG         CONTROL_CODE_DISABLE    = 0;        // Control code passed to enable callback when provider is disabled (EVENT_CONTROL_CODE_DISABLE_PROVIDER).
+    const ULONG         CONTROL_CODE_ENABLE     = 1;        // Control code passed to enable callback when provider is enabled (EVENT_CONTROL_CODE_ENABLE_PROVIDER).
+
+    // Signatures of ETW functions we load dynamically. They are declared here
+    // because evntprov.h only declares them when targeting Windows Vista.
+    typedef ULONGLONG   TraceRegHandle;
+    typedef void (NTAPI *TraceEnableCallbackFunc)(LPCGUID, ULONG, UCHAR, ULONGLONG, ULONGLONG, PVOID, PVOID);
+    typedef ULONG (WINAPI *EventRegisterFunc)(LPCGUID, TraceEnableCallbackFunc, PVOID, TraceRegHandle*);
+    typedef ULONG (WINAPI *EventUnregisterFunc)(TraceRegHandle);
+    typedef ULONG (WINAPI *EventWriteStringFunc)(TraceRegHandle, UCHAR, ULONGLONG, PCWSTR);
+
+    TraceRegHandle          g_RegHandle         = 0;        // Handle to our registered provider.
+    EventUnregisterFunc     g_pEventUnregister  = nullptr;  // Pointer to EventUnregister, if available.
+    EventWriteStringFunc    g_pEventWriteString = nullptr;  // Pointer to EventWriteString, if available.
+
+} // anonymous namespace
+
+namespace PCC
+{
+    // {B0D0CAE2-5CF5-42BC-A59B-B71EC8670DC9}
+    const GUID Trace::PROVIDER_ID = { 0xb0d0cae2, 0x5cf5, 0x42bc, { 0xa5, 0x9b, 0xb7, 0x1e, 0xc8, 0x67, 0xd, 0xc9 } };
+
+    // Static members of Trace
+    std::atomic<bool> Trace::s_Enabled(false);
+
+    //
+    // Registers our ETW provider. Should be called when the DLL is loaded.
+    // Does nothing if ETW providers are not supported.
+    //
+    void Trace::Register()
+    {
+        HMODULE hAdvapi32 = ::GetModuleHandleW(L"advapi32.dll");
+        if (hAdvapi32 != NULL && g_RegHandle == 0) {
+            EventRegisterFunc pEventRegister = reinterpret_cast<EventRegisterFunc>(::GetProcAddress(hAdvapi32, "EventRegister"));
+            EventUnregisterFunc pEventUnregister = reinterpret_cast<EventUnregisterFunc>(::GetProcAddress(hAdvapi32, "EventUnregister"));
+            EventWriteStringFunc pEventWriteString = reinterpret_cast<EventWriteStringFunc>(::GetProcAddress(hAdvapi32, "EventWriteString"));
+            if (pEventRegister != nullptr && pEventUnregister != nullptr && pEventWriteString != nullptr) {
+                g_pEventUnregister = pEventUnregister;
+                g_pEventWriteString = pEventWriteString;
+                if (pEventRegister(&PROVIDER_ID, &Trace::EnableCallback, nullptr, &g_RegHandle) != ERROR_SUCCESS) {
+                    g_RegHandle = 0;
+                }
+            }
+        }
+    }
+
+    //
+    // Unregisters our ETW provider. Must be called before the DLL is unloaded.
+    //
+    void Trace::Unregister()
+    {
+        if (g_RegHandle != 0) {
+            s_Enabled = false;
+            g_pEventUnregister(g_RegHandle);
+            g_RegHandle = 0;
+        }
+    }
+
+    //
+    // Writes an event for an operation. Should only be called if Enabled
+    // returns true; StTraceEvent can be used to do this automatically.
+    //
+    // @param p_pName Name of operation.
+    // @param p_pId Optional ID of object the operation is about (like a plugin).
+    // @param p_Duration Duration of operation.
+    // @param p_Count Number of items processed during operation.
+    //
+    void Trace::WriteEvent(const wchar_t* const p_pName,
+                           const GUID* const p_pId,
+                           const std::chrono::microseconds p_Duration,
+                           const size_t p_Count)
+    {
+        if (DiagnosticLog::Enabled()) {
+            DiagnosticLog::Record(p_pName, p_pId, p_Duration, p_Count);
+        }
+        if (FlightRecorder::Recording()) {
+            FlightRecorder::RecordPhase(p_pName, p_Duration);
+        }
+        if (g_RegHandle != 0 && s_Enabled.load(std::memory_order_relaxed)) {
+            wchar_t id[40] = { 0 };
+            if (p_pId != nullptr) {
+                ::StringFromGUID2(*p_pId, id, sizeof(id) / sizeof(wchar_t));
+            }
+            wchar_t message[256];
+            if (std::swprintf(message, sizeof(message) / sizeof(wchar_t), L"%ls%ls%ls duration_us=%lld count=%llu",
+                              p_pName, p_pId != nullptr ? L" id=" : L"", id,
+                              static_cast<long long>(p_Duration.count()),
+                              static_cast<unsigned long long>(p_Count)) > 0) {
+                g_pEventWriteString(g_RegHandle, TRACE_LEVEL_INFO, 0, message);
+            }
+        }
+    }
+
+    //
+    // Called by ETW when a trace session enables or disables our provider.
+    //
+    // @param p_pSourceId ID of trace session; unused.
+    // @param p_IsEnabled Control code indicating whether provider is enabled.
+    // @param p_Level Level of events requested by session; unused.
+    // @param p_MatchAnyKeyword Keywords requested by session; unused.
+    // @param p_MatchAllKeyword Keywords requested by session; unused.
+    // @param p_pFilterData Filter data of session; unused.
+    // @param p_pCallbackContext Context passed when registering; unused.
+    //
+    void NTAPI Trace::EnableCallback(LPCGUID /*p_pSourceId*/,
+                                     ULONG p_IsEnabled,
+                                     UCHAR /*p_Level*/,
+                                     ULONGLONG /*p_MatchAnyKeyword*/,
+                                     ULONGLONG /*p_MatchAllKeyword*/,
+                                     PVOID /*p_pFilterData*/,
+                                     PVOID /*p_pCallbackContext*/)
+    {
+        if (p_IsEnabled == CONTROL_CODE_ENABLE) {
+            s_Enabled = true;
+        } else if (p_IsEnabled == CONTROL_CODE_DISABLE) {
+            s_Enabled = false;
+        }
+    }
+
+} // namespace PCC
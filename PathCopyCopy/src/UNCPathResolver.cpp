@@ -0,0 +1,217 @@
+// UNCPathResolver.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <stdafx.h>
+#include <UNCPathResolver.h>
+#include <DFSReferralCache.h>
+#include <DriveConnectivityCache.h>
+#include <FileMetadataCache.h>
+#include <FQDNCache.h>
+#include <PluginUtils.h>
+
+#include <memory>
+
+
+namespace PCC
+{
+    //
+    // Constructor.
+    //
+    // @param p_pMetadataCache Optional cache of file metadata of the current operation.
+    //
+    UNCPathResolver::UNCPathResolver(FileMetadataCache* const p_pMetadataCache)
+        : m_mHostFQDNs(),
+          m_mUNCPaths(),
+          m_pMetadataCache(p_pMetadataCache)
+    {
+    }
+
+    //
+    // Converts a local path to a UNC path, by looking for a mapped network
+    // drive, then for a network share of the local computer and finally,
+    // if allowed, for a hidden drive share. If a UNC path is found, it can be
+    // resolved to its DFS target and, if FQDNs must be used, the host name
+    // is replaced with its FQDN.
+    //
+    // If the path is a file, its parent directory is converted instead (once
+    // for all files in that directory) and the file name is appended to it.
+    //
+    // @param p_rFilePath Local path, without trailing separator. Upon exit,
+    //                    will contain the UNC path if there is one.
+    // @param p_UseHiddenShares Whether hidden drive shares can be used.
+    // @param p_UseFQDN Whether to replace host names with FQDNs.
+    // @param p_ResolveDFS Whether to resolve paths in DFS namespaces to their targets.
+    // @return true if path was converted to a UNC path.
+    //
+    bool UNCPathResolver::ConvertToUNCPath(std::wstring& p_rFilePath,
+                                           const bool p_UseHiddenShares,
+                                           const bool p_UseFQDN,
+                                           const bool p_ResolveDFS)
+    {
+        const UNCPath& uncPath = GetUNCPath(p_rFilePath, p_UseHiddenShares, p_UseFQDN, p_ResolveDFS);
+        if (uncPath.m_Converted) {
+            p_rFilePath = uncPath.m_Path;
+        }
+        return uncPath.m_Converted;
+    }
+
+    //
+    // Replaces the hostname in the given UNC path with a
+    // fully-qualified domain name (FQDN).
+    //
+    // The FQDN of each host is only looked up once.
+    //
+    // @param p_rFilePath UNC path. Upon exit, host name will have been replaced.
+    //
+    void UNCPathResolver::ConvertUNCHostToFQDN(std::wstring& p_rFilePath)
+    {
+        // Find hostname in file path.
+        const auto delimPos = p_rFilePath.compare(0, 2, L"\\\\") == 0
+            ? p_rFilePath.find_first_of(L"\\/", 2)
+            : std::wstring::npos;
+        if (delimPos != std::wstring::npos && delimPos > 2) {
+            const std::wstring hostname = p_rFilePath.substr(2, delimPos - 2);
+            auto it = m_mHostFQDNs.find(hostname);
+            if (it == m_mHostFQDNs.end()) {
+                // Fetch FQDN from the process-wide cache. If it fails, it returns the hostname.
+                it = m_mHostFQDNs.emplace(hostname, FQDNCache::GetFQDN(hostname)).first;
+            }
+
+            // Replace the hostname with its FQDN in place.
+            p_rFilePath.replace(2, delimPos - 2, it->second);
+        }
+    }
+
+    //
+    // Resolves a UNC path in a DFS namespace to the network path of its
+    // target, like \\server\share\Folder for \\domain\Namespace\Folder.
+    // Referrals are cached per directory, so the DFS client is only queried
+    // once for all files in the same folder.
+    //
+    // @param p_rUNCPath UNC path, without trailing separator. Upon exit,
+    //                   will contain the path on the DFS target, if any.
+    // @return true if the path was in a DFS namespace and was resolved.
+    //
+    bool UNCPathResolver::ResolveDFSPath(std::wstring& p_rUNCPath)
+    {
+        return DFSReferralCache::Resolve(p_rUNCPath);
+    }
+
+    //
+    // Returns the result of the conversion of a path to a UNC path,
+    // converting it if this hasn't been done yet. See ConvertToUNCPath.
+    //
+    // @param p_FilePath Local path, without trailing separator.
+    // @param p_UseHiddenShares Whether hidden drive shares can be used.
+    // @param p_UseFQDN Whether to replace host names with FQDNs.
+    // @param p_ResolveDFS Whether to resolve paths in DFS namespaces to their targets.
+    // @return Result of the conversion.
+    //
+    const UNCPathResolver::UNCPath& UNCPathResolver::GetUNCPath(const std::wstring& p_FilePath,
+                                                                const bool p_UseHiddenShares,
+                                                                const bool p_UseFQDN,
+                                                                const bool p_ResolveDFS)
+    {
+        auto it = m_mUNCPaths.find(p_FilePath);
+        if (it == m_mUNCPaths.end()) {
+            UNCPath uncPath;
+            uncPath.m_Path = p_FilePath;
+            if (CanReuseParent(p_FilePath)) {
+                // Convert parent directory and append file name.
+                const auto delimPos = p_FilePath.find_last_of(L"\\/");
+                const UNCPath& parentPath = GetUNCPath(p_FilePath.substr(0, delimPos),
+                                                       p_UseHiddenShares, p_UseFQDN, p_ResolveDFS);
+                uncPath.m_Converted = parentPath.m_Converted;
+                if (uncPath.m_Converted) {
+                    uncPath.m_Path = parentPath.m_Path;
+                    if (uncPath.m_Path.empty() || (uncPath.m_Path.back() != L'\\' && uncPath.m_Path.back() != L'/')) {
+                        uncPath.m_Path += p_FilePath[delimPos];
+                    }
+                    uncPath.m_Path.append(p_FilePath, delimPos + 1, std::wstring::npos);
+                }
+            } else {
+                // Try to get path on mapped network drive.
+                uncPath.m_Converted = PluginUtils::GetMappedDriveFilePath(uncPath.m_Path);
+
+                // If it wasn't on a mapped drive, check if it's in a network share.
+                if (!uncPath.m_Converted) {
+                    uncPath.m_Converted = PluginUtils::GetNetworkShareFilePath(uncPath.m_Path, p_UseHiddenShares);
+                }
+
+                // If it wasn't in a defined network share, use a hidden drive share if we're allowed.
+                if (!uncPath.m_Converted && p_UseHiddenShares) {
+                    uncPath.m_Converted = PluginUtils::GetHiddenDriveShareFilePath(uncPath.m_Path);
+                }
+
+                // If we got a path in a DFS namespace, resolve it if we must. This is
+                // done before using the FQDN, since the DFS target is on another host.
+                if (uncPath.m_Converted && p_ResolveDFS) {
+                    ResolveDFSPath(uncPath.m_Path);
+                }
+
+                // If we got a path and we must use FQDN, convert it.
+                if (uncPath.m_Converted && p_UseFQDN) {
+                    ConvertUNCHostToFQDN(uncPath.m_Path);
+                }
+                if (!uncPath.m_Converted) {
+                    uncPath.m_Path = p_FilePath;
+                }
+            }
+
+            it = m_mUNCPaths.emplace(p_FilePath, uncPath).first;
+        }
+        return it->second;
+    }
+
+    //
+    // Checks if the UNC path of a file can be formed from the UNC path of its
+    // parent directory. This is the case for regular files in a directory that
+    // is not the root of a drive. Directories and reparse points (junctions,
+    // mount points, symbolic links) are converted on their own, since they
+    // could be shared themselves or point to another volume entirely.
+    //
+    // @param p_FilePath Local path, without trailing separator.
+    // @return true if UNC path of parent directory can be reused.
+    //
+    bool UNCPathResolver::CanReuseParent(const std::wstring& p_FilePath) const
+    {
+        const auto delimPos = p_FilePath.find_last_of(L"\\/");
+        if (delimPos == std::wstring::npos || delimPos + 1 >= p_FilePath.size() ||
+            p_FilePath.find_first_of(L"\\/") == delimPos) {
+
+            // No parent, or parent is the root of a drive.
+            return false;
+        }
+        if (!DriveConnectivityCache::IsReachable(p_FilePath)) {
+            // Don't block on the drive; the path will not be converted anyway.
+            return false;
+        }
+
+        DWORD attribs = INVALID_FILE_ATTRIBUTES;
+        if (m_pMetadataCache == nullptr || !m_pMetadataCache->GetAttributes(p_FilePath, attribs)) {
+            attribs = ::GetFileAttributesW(p_FilePath.c_str());
+        }
+        return attribs != INVALID_FILE_ATTRIBUTES &&
+               (attribs & (FILE_ATTRIBUTE_DIRECTORY | FILE_ATTRIBUTE_REPARSE_POINT)) == 0;
+    }
+
+} // namespace PCC
@@ -0,0 +1,113 @@
+// UnicodeNormalizer.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <stdafx.h>
+#include <UnicodeNormalizer.h>
+#include <StringUtils.h>
+
+
+namespace
+{
+    // Number of times we retry normalizing a string if the buffer was too small.
+    const int   MAX_NORMALIZE_ATTEMPTS  = 10;
+
+} // anonymous namespace
+
+namespace PCC
+{
+    // Static members of UnicodeNormalizer
+    UnicodeNormalizer::NormalizeStringFunc
+                    UnicodeNormalizer::s_pNormalizeString = nullptr;
+    std::once_flag  UnicodeNormalizer::s_NormalizeStringInit;
+
+    //
+    // Converts a string to the given Unicode normalization form.
+    //
+    // @param p_rString String to normalize (in-place).
+    // @param p_Form Normalization form to use.
+    // @return true if p_rString is normalized, false if normalization
+    //         could not be performed. In the latter case, p_rString
+    //         is left unchanged.
+    //
+    bool UnicodeNormalizer::Normalize(std::wstring& p_rString,
+                                      const NormalizationForm p_Form)
+    {
+        // ASCII characters are not affected by canonical normalization.
+        if (StringUtils::IsASCII(p_rString)) {
+            return true;
+        }
+
+        NormalizeStringFunc pNormalizeString = GetNormalizeString();
+        if (pNormalizeString == nullptr) {
+            return false;
+        }
+
+        // NormalizeString only returns an estimate of the required size,
+        // so we must be ready to retry with a larger buffer.
+        const int srcLength = static_cast<int>(p_rString.size());
+        int bufferSize = pNormalizeString(static_cast<int>(p_Form), p_rString.c_str(), srcLength, nullptr, 0);
+        std::wstring normalized;
+        for (int attempt = 0; bufferSize > 0 && attempt < MAX_NORMALIZE_ATTEMPTS; ++attempt) {
+            normalized.resize(bufferSize);
+            const int length = pNormalizeString(static_cast<int>(p_Form), p_rString.c_str(), srcLength,
+                                                &normalized[0], bufferSize);
+            if (length > 0) {
+                normalized.resize(length);
+                p_rString.swap(normalized);
+                return true;
+            }
+            if (length == 0 || ::GetLastError() != ERROR_INSUFFICIENT_BUFFER) {
+                break;
+            }
+            // On error, the returned value is the negated estimate of the required size.
+            bufferSize = -length;
+        }
+        return false;
+    }
+
+    //
+    // Loads NormalizeString on first use. It is exported by kernel32 starting
+    // with Windows 7 and by normaliz.dll on Vista, or on XP if the IDN
+    // mitigation APIs have been installed.
+    //
+    // @return Pointer to NormalizeString, or nullptr if it is not available.
+    //
+    UnicodeNormalizer::NormalizeStringFunc UnicodeNormalizer::GetNormalizeString()
+    {
+        std::call_once(s_NormalizeStringInit, []() {
+            HMODULE hKernel32 = ::GetModuleHandleW(L"kernel32.dll");
+            if (hKernel32 != NULL) {
+                s_pNormalizeString = reinterpret_cast<NormalizeStringFunc>(
+                    ::GetProcAddress(hKernel32, "NormalizeString"));
+            }
+            if (s_pNormalizeString == nullptr) {
+                // The library is never freed since we keep a pointer to its function.
+                HMODULE hNormaliz = ::LoadLibraryW(L"normaliz.dll");
+                if (hNormaliz != NULL) {
+                    s_pNormalizeString = reinterpret_cast<NormalizeStringFunc>(
+                        ::GetProcAddress(hNormaliz, "NormalizeString"));
+                }
+            }
+        });
+        return s_pNormalizeString;
+    }
+
+} // namespace PCC
@@ -48,7 +48,8 @@ UserOverrideableRegKey::UserOverrideableRegKey(const wchar_t* const p_pKeyPath,
     : RegKey(),
       m_GlobalKey(HKEY_LOCAL_MACHINE, p_pKeyPath, false, KEY_QUERY_VALUE | KEY_ENUMERATE_SUB_KEYS),
       m_UserKey(HKEY_CURRENT_USER, p_pUserKeyPath != nullptr ? p_pUserKeyPath : p_pKeyPath, true,
-                KEY_QUERY_VALUE | KEY_SET_VALUE | KEY_CREATE_SUB_KEY | KEY_ENUMERATE_SUB_KEYS)
+                KEY_QUERY_VALUE | KEY_SET_VALUE | KEY_CREATE_SUB_KEY | KEY_ENUMERATE_SUB_KEYS),
+      m_Locked()
 {
 }
 
@@ -67,17 +68,21 @@ bool UserOverrideableRegKey::Valid() const
 //
 // Checks whether the user registry key is currently locked in the global key.
 // This allows administrators to set options and disallow changing them.
+// The lock state is read on the first call, then cached.
 //
 // @return true if the user key is locked and cannot be edited.
 //
 bool UserOverrideableRegKey::Locked() const
 {
-    bool locked = false;
-    DWORD regLocked = 0;
-    if (m_GlobalKey.Valid() && m_GlobalKey.QueryDWORDValue(VALUE_NAME_LOCKED_OUT, regLocked) == ERROR_SUCCESS) {
-        locked = regLocked != 0;
+    if (!m_Locked.has_value()) {
+        bool locked = false;
+        DWORD regLocked = 0;
+        if (m_GlobalKey.Valid() && m_GlobalKey.QueryDWORDValue(VALUE_NAME_LOCKED_OUT, regLocked) == ERROR_SUCCESS) {
+            locked = regLocked != 0;
+        }
+        m_Locked = locked;
     }
-    return locked;
+    return *m_Locked;
 }
 
 //
@@ -86,7 +91,7 @@ bool UserOverrideableRegKey::Locked() const
 // @return Reference to global key. This key might be invalid if user does not have proper
 //         access or if the key does not exist.
 //
-const RegKey& UserOverrideableRegKey::GetGlobalKey() const
+const AtlRegKey& UserOverrideableRegKey::GetGlobalKey() const
 {
     return m_GlobalKey;
 }
@@ -96,7 +101,7 @@ const RegKey& UserOverrideableRegKey::GetGlobalKey() const
 //
 // @return Reference to user key.
 //
-const RegKey& UserOverrideableRegKey::GetUserKey() const
+const AtlRegKey& UserOverrideableRegKey::GetUserKey() const
 {
     return m_UserKey;
 }
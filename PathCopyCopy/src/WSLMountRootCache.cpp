@@ -0,0 +1,259 @@
+// WSLMountRootCache.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <stdafx.h>
+#include <WSLMountRootCache.h>
+#include <PluginUtils.h>
+
+#include <chrono>
+#include <thread>
+
+
+namespace
+{
+    // Root used by WSL to mount Windows drives when wsl.conf does not specify one.
+    const wchar_t* const    DEFAULT_MOUNT_ROOT          = L"/mnt/";
+
+    // Registry key and values where WSL stores information about installed distributions.
+    const wchar_t* const    LXSS_KEY_NAME               = L"Software\\Microsoft\\Windows\\CurrentVersion\\Lxss";
+    const wchar_t* const    DEFAULT_DISTRIBUTION_VALUE  = L"DefaultDistribution";
+    const wchar_t* const    DISTRIBUTION_NAME_VALUE     = L"DistributionName";
+
+    // Path of a distribution's wsl.conf, relative to its \\wsl$\<distribution> share.
+    const wchar_t* const    WSL_SHARE_PREFIX            = L"\\\\wsl$\\";
+    const wchar_t* const    WSL_CONF_PATH               = L"\\etc\\wsl.conf";
+
+    // Section and key of wsl.conf containing the mount root.
+    const wchar_t* const    AUTOMOUNT_SECTION           = L"[automount]";
+    const wchar_t* const    ROOT_KEY                    = L"root";
+
+    // Time to wait for wsl.conf to be read the first time, in milliseconds.
+    // If it takes longer, the default mount root is used until it's read.
+    const DWORD             LOOKUP_TIMEOUT_MS           = 500;
+
+    // Time after which we check if wsl.conf has changed, in milliseconds.
+    const DWORD             REFRESH_INTERVAL_MS         = 5 * 60 * 1000;
+
+    //
+    // Returns a copy of a string without leading or trailing whitespace.
+    //
+    // @param p_String String to trim.
+    // @return Trimmed string.
+    //
+    std::wstring Trim(const std::wstring& p_String)
+    {
+        const wchar_t* const WHITESPACE = L" \t\r\n";
+        const std::wstring::size_type begin = p_String.find_first_not_of(WHITESPACE);
+        if (begin == std::wstring::npos) {
+            return std::wstring();
+        }
+        return p_String.substr(begin, p_String.find_last_not_of(WHITESPACE) - begin + 1);
+    }
+
+} // anonymous namespace
+
+namespace PCC
+{
+    // Static members of WSLMountRootCache
+    WSLMountRootCache::EntryM       WSLMountRootCache::s_mEntries;
+    std::mutex                      WSLMountRootCache::s_Lock;
+    std::condition_variable         WSLMountRootCache::s_Refreshed;
+
+    //
+    // Returns the root under which WSL mounts Windows drives in the default
+    // distribution. If it is not cached yet, wsl.conf is read on a worker
+    // thread and we wait for it for a limited time only.
+    //
+    // @return Mount root, ending with a slash, like "/mnt/".
+    //
+    std::wstring WSLMountRootCache::GetMountRoot()
+    {
+        const std::wstring distribution = GetDefaultDistribution();
+        if (distribution.empty()) {
+            return DEFAULT_MOUNT_ROOT;
+        }
+
+        std::unique_lock<std::mutex> lock(s_Lock);
+        bool wait = false;
+        auto it = s_mEntries.find(distribution);
+        if (it == s_mEntries.end()) {
+            Entry entry = { DEFAULT_MOUNT_ROOT, { 0, 0 }, 0, false };
+            it = s_mEntries.emplace(distribution, entry).first;
+            wait = true;
+        }
+        Entry& rEntry = it->second;
+        if (!rEntry.m_Refreshing && (wait || ::GetTickCount() - rEntry.m_Timestamp >= REFRESH_INTERVAL_MS)) {
+            // The worker thread can outlive our caller, so make sure
+            // our DLL is not unloaded before it completes.
+            rEntry.m_Refreshing = true;
+            ATL::_pAtlModule->Lock();
+            try {
+                std::thread(&WSLMountRootCache::Refresh, distribution).detach();
+            } catch (...) {
+                ATL::_pAtlModule->Unlock();
+                rEntry.m_Refreshing = false;
+                wait = false;
+            }
+        }
+
+        // The first time, wait for the mount root to be read, but not for too long.
+        if (wait) {
+            s_Refreshed.wait_for(lock, std::chrono::milliseconds(LOOKUP_TIMEOUT_MS), [&]() {
+                auto refreshedIt = s_mEntries.find(distribution);
+                return refreshedIt == s_mEntries.end() || !refreshedIt->second.m_Refreshing;
+            });
+        }
+        it = s_mEntries.find(distribution);
+        return it != s_mEntries.end() ? it->second.m_MountRoot : DEFAULT_MOUNT_ROOT;
+    }
+
+    //
+    // Returns the name of the default WSL distribution of the current user.
+    //
+    // @return Distribution name, or an empty string if WSL is not installed.
+    //
+    std::wstring WSLMountRootCache::GetDefaultDistribution()
+    {
+        std::wstring distribution;
+        ATL::CRegKey lxssKey;
+        if (lxssKey.Open(HKEY_CURRENT_USER, LXSS_KEY_NAME, KEY_READ) == ERROR_SUCCESS) {
+            wchar_t distributionId[40];
+            ULONG size = 40;
+            if (lxssKey.QueryStringValue(DEFAULT_DISTRIBUTION_VALUE, distributionId, &size) == ERROR_SUCCESS) {
+                ATL::CRegKey distributionKey;
+                if (distributionKey.Open(lxssKey, distributionId, KEY_READ) == ERROR_SUCCESS) {
+                    wchar_t name[MAX_PATH + 1];
+                    size = MAX_PATH + 1;
+                    if (distributionKey.QueryStringValue(DISTRIBUTION_NAME_VALUE, name, &size) == ERROR_SUCCESS) {
+                        distribution = name;
+                    }
+                }
+            }
+        }
+        return distribution;
+    }
+
+    //
+    // Reads the mount root of a distribution from its wsl.conf if it changed
+    // since it was last read. Called on a worker thread. Upon completion,
+    // the result is cached and waiting callers are notified.
+    //
+    // @param p_Distribution Name of distribution.
+    //
+    void WSLMountRootCache::Refresh(const std::wstring& p_Distribution)
+    {
+        const std::wstring confPath = WSL_SHARE_PREFIX + p_Distribution + WSL_CONF_PATH;
+        FILETIME confTime = { 0, 0 };
+        WIN32_FILE_ATTRIBUTE_DATA confData = { 0 };
+        const bool found = ::GetFileAttributesExW(confPath.c_str(), GetFileExInfoStandard, &confData) != FALSE;
+        if (found) {
+            confTime = confData.ftLastWriteTime;
+        }
+
+        // Only read the file if it changed since last time.
+        bool changed = true;
+        {
+            std::lock_guard<std::mutex> lock(s_Lock);
+            auto it = s_mEntries.find(p_Distribution);
+            if (it != s_mEntries.end() && it->second.m_Timestamp != 0) {
+                changed = ::CompareFileTime(&it->second.m_ConfTime, &confTime) != 0;
+            }
+        }
+        std::wstring mountRoot = DEFAULT_MOUNT_ROOT;
+        if (changed && found) {
+            HANDLE hFile = ::CreateFileW(confPath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                         OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+            if (hFile != INVALID_HANDLE_VALUE) {
+                ATL::CHandle hConfFile(hFile);
+                std::wstring contents;
+                if (PluginUtils::ReadText(hConfFile, contents)) {
+                    mountRoot = ParseWSLConf(contents);
+                }
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(s_Lock);
+            Entry& rEntry = s_mEntries[p_Distribution];
+            if (changed) {
+                rEntry.m_MountRoot = mountRoot;
+                rEntry.m_ConfTime = confTime;
+            }
+            rEntry.m_Timestamp = ::GetTickCount();
+            if (rEntry.m_Timestamp == 0) {
+                // Zero means the entry was never validated.
+                rEntry.m_Timestamp = 1;
+            }
+            rEntry.m_Refreshing = false;
+        }
+        s_Refreshed.notify_all();
+
+        ATL::_pAtlModule->Unlock();
+    }
+
+    //
+    // Parses the contents of a wsl.conf file to find the mount root.
+    //
+    // @param p_Contents Contents of wsl.conf.
+    // @return Mount root, ending with a slash. If not specified, returns the default.
+    //
+    std::wstring WSLMountRootCache::ParseWSLConf(const std::wstring& p_Contents)
+    {
+        std::wstring mountRoot;
+        bool inAutomount = false;
+        std::wstring::size_type lineBegin = 0;
+        while (lineBegin < p_Contents.size()) {
+            std::wstring::size_type lineEnd = p_Contents.find(L'\n', lineBegin);
+            if (lineEnd == std::wstring::npos) {
+                lineEnd = p_Contents.size();
+            }
+            const std::wstring line = Trim(p_Contents.substr(lineBegin, lineEnd - lineBegin));
+            lineBegin = lineEnd + 1;
+
+            if (line.empty() || line[0] == L'#' || line[0] == L';') {
+                // Comment or empty line.
+            } else if (line[0] == L'[') {
+                inAutomount = ::_wcsicmp(line.c_str(), AUTOMOUNT_SECTION) == 0;
+            } else if (inAutomount) {
+                const std::wstring::size_type equalPos = line.find(L'=');
+                if (equalPos != std::wstring::npos && Trim(line.substr(0, equalPos)) == ROOT_KEY) {
+                    // Value can be quoted and followed by a comment.
+                    std::wstring value = Trim(line.substr(equalPos + 1));
+                    if (!value.empty() && value[0] == L'"') {
+                        value = value.substr(1, value.find(L'"', 1) - 1);
+                    } else {
+                        value = Trim(value.substr(0, value.find_first_of(L"#;")));
+                    }
+                    mountRoot = value;
+                }
+            }
+        }
+
+        if (mountRoot.empty() || mountRoot.front() != L'/') {
+            mountRoot = DEFAULT_MOUNT_ROOT;
+        } else if (mountRoot.back() != L'/') {
+            mountRoot.push_back(L'/');
+        }
+        return mountRoot;
+    }
+
+} // namespace PCC
@@ -24,8 +24,9 @@
 #include <dlldatax.h>
 #include <PathCopyCopy_i.h>
 
-#include <AtlRegKey.h>
+#include <PerformanceCounters.h>
 #include <StAtlPerUserOverride.h>
+#include <Trace.h>
 
 namespace {
 
@@ -48,26 +49,8 @@ HRESULT CPathCopyCopyModule::DllRegisterServer(BOOL p_RegisterTypeLib /*= TRUE*/
     StAtlPerUserOverride perUserOverride;
     HRESULT hRes = perUserOverride.Succeeded() ? S_OK : E_FAIL;
     if (SUCCEEDED(hRes)) {
+        // Our shell extensions are registered (and approved) by PathCopyCopyLoader.
         hRes = ATL::CAtlDllModuleT<CPathCopyCopyModule>::DllRegisterServer(p_RegisterTypeLib);
-        if (SUCCEEDED(hRes)) {
-            // Register our shell extensions as "approved". We do this here so that
-            // it can work in per-user installations.
-            AtlRegKey approvedKey;
-            LONG regRes = approvedKey.Open(perUserOverride.Overridden() ? HKEY_CURRENT_USER : HKEY_LOCAL_MACHINE,
-                                           L"Software\\Microsoft\\Windows\\CurrentVersion\\Extensions\\Approved",
-                                           true, KEY_QUERY_VALUE | KEY_SET_VALUE);
-            if (regRes == ERROR_SUCCESS) {
-                regRes = approvedKey.SetStringValue(L"{82CB99A2-2F18-4D5D-9476-54347E3B6720}",
-                                                    L"PathCopyCopy Contextual Menu Handler");
-            }
-            if (regRes == ERROR_SUCCESS) {
-                regRes = approvedKey.SetStringValue(L"{16170CA5-25CA-4e6d-928C-7A3A974F4B56}",
-                                                    L"PathCopyCopy Data Handler");
-            }
-            if (regRes != ERROR_SUCCESS) {
-                hRes = HRESULT_FROM_WIN32(regRes);
-            }
-        }
     }
     return hRes;
 }
@@ -87,21 +70,6 @@ HRESULT CPathCopyCopyModule::DllUnregisterServer(BOOL p_UnregisterTypeLib /*= TR
     HRESULT hRes = perUserOverride.Succeeded() ? S_OK : E_FAIL;
     if (SUCCEEDED(hRes)) {
         hRes = ATL::CAtlDllModuleT<CPathCopyCopyModule>::DllUnregisterServer(p_UnregisterTypeLib);
-        if (SUCCEEDED(hRes)) {
-            // Unregister our approved shell extensions. We do this here so that
-            // it can work in per-user installations.
-            // Note that if it doesn't exist, we consider it a success.
-            AtlRegKey approvedKey;
-            LONG regRes = approvedKey.Open(perUserOverride.Overridden() ? HKEY_CURRENT_USER : HKEY_LOCAL_MACHINE,
-                                           L"Software\\Microsoft\\Windows\\CurrentVersion\\Extensions\\Approved",
-                                           false, KEY_QUERY_VALUE | KEY_SET_VALUE);
-            if (regRes != ERROR_SUCCESS && regRes != ERROR_FILE_NOT_FOUND) {
-                hRes = HRESULT_FROM_WIN32(regRes);
-            } else if (regRes == ERROR_SUCCESS) {
-                approvedKey.DeleteValue(L"{82CB99A2-2F18-4D5D-9476-54347E3B6720}");
-                approvedKey.DeleteValue(L"{16170CA5-25CA-4e6d-928C-7A3A974F4B56}");
-            }
-        }
     }
     return hRes;
 }
@@ -128,5 +96,14 @@ extern "C" BOOL WINAPI DllMain(HINSTANCE hInstance, DWORD dwReason, LPVOID lpRes
 		return FALSE;
 #endif
 	g_hInstance = hInstance;
+
+    // Register our ETW provider while we're loaded so that we can be profiled.
+    if (dwReason == DLL_PROCESS_ATTACH) {
+        PCC::Trace::Register();
+    } else if (dwReason == DLL_PROCESS_DETACH) {
+        PCC::PerformanceCounters::Stop();
+        PCC::Trace::Unregister();
+    }
+
 	return _AtlModule.DllMain(dwReason, lpReserved); 
 }
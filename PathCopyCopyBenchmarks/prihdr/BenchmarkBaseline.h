@@ -0,0 +1,55 @@
+// BenchmarkBaseline.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <windows.h>
+
+
+//
+// Samples measured for one benchmark with a given corpus size. Each sample
+// is the time taken to process the entire corpus once, in microseconds.
+//
+struct BenchmarkSamples final
+{
+    std::wstring        m_Name;             // Name of benchmark.
+    ULONG               m_CorpusSize;       // Number of paths in the corpus used.
+    std::vector<double> m_vMicroseconds;    // Durations measured, in microseconds.
+};
+typedef std::vector<BenchmarkSamples> BenchmarkSamplesV;
+
+void AddBenchmarkSample(BenchmarkSamplesV& p_rvSamples,
+                        const std::wstring& p_Name,
+                        const ULONG p_CorpusSize,
+                        const double p_Microseconds);
+
+bool SaveBenchmarkSamples(const std::wstring& p_FilePath,
+                          const BenchmarkSamplesV& p_vSamples);
+
+bool LoadBenchmarkSamples(const std::wstring& p_FilePath,
+                          BenchmarkSamplesV& p_rvSamples);
+
+size_t CompareBenchmarkSamples(const BenchmarkSamplesV& p_vBaseline,
+                               const BenchmarkSamplesV& p_vCurrent);
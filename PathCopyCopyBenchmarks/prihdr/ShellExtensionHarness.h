@@ -0,0 +1,83 @@
+// ShellExtensionHarness.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include <string>
+
+#include <windows.h>
+
+
+//
+// Runs the end-to-end shell extension latency harness. Creates the PCC
+// contextual menu extension through the DLL's class factory and times its
+// Initialize, QueryContextMenu and InvokeCommand methods for synthetic
+// file selections, first normally and then with slow test plugins.
+//
+// @param p_hDll Handle of the loaded PCC DLL.
+// @param argc Number of harness arguments received.
+// @param argv Array of harness arguments.
+// @return Process exit code.
+//
+int RunShellExtensionHarness(HMODULE p_hDll,
+                             int argc,
+                             wchar_t* argv[]);
+
+//
+// Runs the multi-threaded contention benchmark of the shell extension.
+// Builds and invokes contextual menus concurrently on an increasing number
+// of threads, then prints throughput, latencies and lock wait times.
+//
+// @param p_hDll Handle of the loaded PCC DLL.
+// @param argc Number of benchmark arguments received.
+// @param argv Array of benchmark arguments.
+// @return Process exit code.
+//
+int RunContentionBenchmark(HMODULE p_hDll,
+                           int argc,
+                           wchar_t* argv[]);
+
+//
+// Runs the cold and warm startup benchmark of the shell extension. Starts
+// fresh processes that load the PCC DLL and time each phase until the first
+// contextual menu is built, then prints results for each phase.
+//
+// @param p_ExePath Path to this executable, used to start child processes.
+// @param argc Number of benchmark arguments received.
+// @param argv Array of benchmark arguments.
+// @return Process exit code.
+//
+int RunStartupBenchmark(const std::wstring& p_ExePath,
+                        int argc,
+                        wchar_t* argv[]);
+
+//
+// Runs one iteration of the startup benchmark in a child process started
+// by RunStartupBenchmark. The PCC DLL must not have been loaded yet.
+//
+// @param p_DllPath Path to the PCC DLL to load.
+// @param argc Number of arguments received.
+// @param argv Array of arguments.
+// @return Process exit code.
+//
+int RunStartupBenchmarkChild(const std::wstring& p_DllPath,
+                             int argc,
+                             wchar_t* argv[]);
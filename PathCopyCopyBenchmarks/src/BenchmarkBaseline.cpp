@@ -0,0 +1,504 @@
+// BenchmarkBaseline.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "stdafx.h"
+#include <BenchmarkBaseline.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cwctype>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+
+
+namespace
+{
+    // Version of the format of files storing benchmark results.
+    const int               RESULTS_FORMAT_VERSION          = 1;
+
+    // Minimum relative change in mean duration for a difference to be reported,
+    // even if statistically significant. Avoids flagging negligible changes.
+    const double            MIN_RELATIVE_CHANGE             = 0.05;
+
+    // Critical values of Student's t-distribution for a one-tailed test at the
+    // 95% confidence level, per degrees of freedom (starting at 1).
+    const double            T_CRITICAL_VALUES[]             = {
+        6.314, 2.920, 2.353, 2.132, 2.015, 1.943, 1.895, 1.860, 1.833, 1.812,
+        1.796, 1.782, 1.771, 1.761, 1.753, 1.746, 1.740, 1.734, 1.729, 1.725,
+        1.721, 1.717, 1.714, 1.711, 1.708, 1.706, 1.703, 1.701, 1.699, 1.697,
+    };
+
+    // Critical value used when there are more degrees of freedom than in T_CRITICAL_VALUES.
+    const double            T_CRITICAL_VALUE_INFINITE       = 1.645;
+
+    //
+    // Writes a string to a JSON stream, quoted and escaped. All non-ASCII
+    // characters are escaped so that the stream only contains ASCII.
+    //
+    // @param p_rStream Stream to write to.
+    // @param p_String String to write.
+    //
+    void WriteJSONString(std::ostream& p_rStream,
+                         const std::wstring& p_String)
+    {
+        p_rStream << '"';
+        for (const wchar_t c : p_String) {
+            if (c == L'"' || c == L'\\') {
+                p_rStream << '\\' << static_cast<char>(c);
+            } else if (c < 0x20 || c > 0x7E) {
+                p_rStream << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+                          << static_cast<unsigned int>(c) << std::dec << std::setfill(' ');
+            } else {
+                p_rStream << static_cast<char>(c);
+            }
+        }
+        p_rStream << '"';
+    }
+
+    //
+    // Minimal JSON reader that can parse files written by SaveBenchmarkSamples.
+    // Unknown members are skipped, so that newer files can be read.
+    //
+    class ResultsReader final
+    {
+    public:
+        //
+        // Constructor.
+        //
+        // @param p_Text JSON text to parse. Must outlive this object.
+        //
+        explicit ResultsReader(const std::wstring& p_Text)
+            : m_Text(p_Text),
+              m_Pos(0)
+        {
+        }
+
+        ResultsReader(const ResultsReader&) = delete;
+        ResultsReader& operator=(const ResultsReader&) = delete;
+
+        //
+        // Parses benchmark results.
+        //
+        // @param p_rvSamples Where to store parsed results.
+        // @return true if text could be parsed.
+        //
+        bool ReadResults(BenchmarkSamplesV& p_rvSamples)
+        {
+            return ReadObject([&](const std::wstring& p_Key) {
+                bool read = false;
+                if (p_Key == L"results") {
+                    read = ReadArray([&]() {
+                        BenchmarkSamples samples;
+                        samples.m_CorpusSize = 0;
+                        const bool readSamples = ReadSamples(samples);
+                        if (readSamples) {
+                            p_rvSamples.push_back(samples);
+                        }
+                        return readSamples;
+                    });
+                } else {
+                    read = SkipValue();
+                }
+                return read;
+            });
+        }
+
+    private:
+        const std::wstring& m_Text;     // Text being parsed.
+        size_t              m_Pos;      // Current position in m_Text.
+
+        //
+        // Parses the results of one benchmark.
+        //
+        // @param p_rSamples Where to store parsed results.
+        // @return true if results could be parsed.
+        //
+        bool ReadSamples(BenchmarkSamples& p_rSamples)
+        {
+            return ReadObject([&](const std::wstring& p_Key) {
+                bool read = false;
+                double value = 0.0;
+                if (p_Key == L"name") {
+                    read = ReadString(p_rSamples.m_Name);
+                } else if (p_Key == L"corpusSize") {
+                    read = ReadNumber(value);
+                    p_rSamples.m_CorpusSize = static_cast<ULONG>(value);
+                } else if (p_Key == L"samples") {
+                    read = ReadArray([&]() {
+                        const bool readSample = ReadNumber(value);
+                        if (readSample) {
+                            p_rSamples.m_vMicroseconds.push_back(value);
+                        }
+                        return readSample;
+                    });
+                } else {
+                    read = SkipValue();
+                }
+                return read;
+            });
+        }
+
+        //
+        // Skips whitespace at the current position.
+        //
+        void SkipWhitespace()
+        {
+            while (m_Pos < m_Text.size() && std::iswspace(m_Text[m_Pos])) {
+                ++m_Pos;
+            }
+        }
+
+        //
+        // Skips whitespace, then consumes the given character if it is next.
+        //
+        // @param p_Char Character to consume.
+        // @return true if character was consumed.
+        //
+        bool Consume(const wchar_t p_Char)
+        {
+            SkipWhitespace();
+            const bool consumed = m_Pos < m_Text.size() && m_Text[m_Pos] == p_Char;
+            if (consumed) {
+                ++m_Pos;
+            }
+            return consumed;
+        }
+
+        //
+        // Parses an object, calling a function to parse the value of each member.
+        //
+        // @param p_ReadMember Function parsing the value of a member, given its key.
+        // @return true if object could be parsed.
+        //
+        template<typename ReadMember>
+        bool ReadObject(const ReadMember& p_ReadMember)
+        {
+            bool read = Consume(L'{');
+            if (read && !Consume(L'}')) {
+                do {
+                    std::wstring key;
+                    read = ReadString(key) && Consume(L':') && p_ReadMember(key);
+                } while (read && Consume(L','));
+                read = read && Consume(L'}');
+            }
+            return read;
+        }
+
+        //
+        // Parses an array, calling a function to parse each element.
+        //
+        // @param p_ReadElement Function parsing one element.
+        // @return true if array could be parsed.
+        //
+        template<typename ReadElement>
+        bool ReadArray(const ReadElement& p_ReadElement)
+        {
+            bool read = Consume(L'[');
+            if (read && !Consume(L']')) {
+                do {
+                    read = p_ReadElement();
+                } while (read && Consume(L','));
+                read = read && Consume(L']');
+            }
+            return read;
+        }
+
+        //
+        // Parses a string.
+        //
+        // @param p_rString Where to store the parsed string.
+        // @return true if string could be parsed.
+        //
+        bool ReadString(std::wstring& p_rString)
+        {
+            bool read = Consume(L'"');
+            p_rString.clear();
+            while (read && m_Pos < m_Text.size() && m_Text[m_Pos] != L'"') {
+                wchar_t c = m_Text[m_Pos++];
+                if (c == L'\\' && m_Pos < m_Text.size()) {
+                    c = m_Text[m_Pos++];
+                    if (c == L'u' && m_Pos + 4 <= m_Text.size()) {
+                        c = static_cast<wchar_t>(std::wcstoul(m_Text.substr(m_Pos, 4).c_str(), nullptr, 16));
+                        m_Pos += 4;
+                    } else if (c == L'n') {
+                        c = L'\n';
+                    } else if (c == L't') {
+                        c = L'\t';
+                    } else if (c == L'r') {
+                        c = L'\r';
+                    }
+                }
+                p_rString.push_back(c);
+            }
+            return read && Consume(L'"');
+        }
+
+        //
+        // Parses a number.
+        //
+        // @param p_rNumber Where to store the parsed number.
+        // @return true if number could be parsed.
+        //
+        bool ReadNumber(double& p_rNumber)
+        {
+            SkipWhitespace();
+            const wchar_t* const pStart = m_Text.c_str() + m_Pos;
+            wchar_t* pEnd = nullptr;
+            p_rNumber = std::wcstod(pStart, &pEnd);
+            m_Pos += static_cast<size_t>(pEnd - pStart);
+            return pEnd != pStart;
+        }
+
+        //
+        // Skips a value of any type.
+        //
+        // @return true if value could be parsed.
+        //
+        bool SkipValue()
+        {
+            SkipWhitespace();
+            bool read = m_Pos < m_Text.size();
+            if (read) {
+                const wchar_t c = m_Text[m_Pos];
+                std::wstring ignoredString;
+                double ignoredNumber = 0.0;
+                if (c == L'"') {
+                    read = ReadString(ignoredString);
+                } else if (c == L'{') {
+                    read = ReadObject([&](const std::wstring&) { return SkipValue(); });
+                } else if (c == L'[') {
+                    read = ReadArray([&]() { return SkipValue(); });
+                } else if (std::iswalpha(c)) {
+                    // true, false or null
+                    while (m_Pos < m_Text.size() && std::iswalpha(m_Text[m_Pos])) {
+                        ++m_Pos;
+                    }
+                } else {
+                    read = ReadNumber(ignoredNumber);
+                }
+            }
+            return read;
+        }
+    };
+
+    //
+    // Computes the mean and variance of samples.
+    //
+    // @param p_vSamples Samples. Must not be empty.
+    // @param p_rMean Where to store the mean.
+    // @param p_rVariance Where to store the sample variance (0 if there is only one sample).
+    //
+    void ComputeStatistics(const std::vector<double>& p_vSamples,
+                           double& p_rMean,
+                           double& p_rVariance)
+    {
+        double sum = 0.0;
+        for (const double sample : p_vSamples) {
+            sum += sample;
+        }
+        p_rMean = sum / p_vSamples.size();
+        double squaredDeviations = 0.0;
+        for (const double sample : p_vSamples) {
+            squaredDeviations += (sample - p_rMean) * (sample - p_rMean);
+        }
+        p_rVariance = p_vSamples.size() > 1 ? squaredDeviations / (p_vSamples.size() - 1) : 0.0;
+    }
+
+    //
+    // Checks if the difference between the means of two sets of samples is
+    // statistically significant, using Welch's t-test. Both sets must have
+    // at least two samples.
+    //
+    // @param p_vBaseline Baseline samples.
+    // @param p_vCurrent Current samples.
+    // @return true if the difference is significant at the 95% confidence level.
+    //
+    bool IsSignificant(const std::vector<double>& p_vBaseline,
+                       const std::vector<double>& p_vCurrent)
+    {
+        double baselineMean = 0.0, baselineVariance = 0.0, currentMean = 0.0, currentVariance = 0.0;
+        ComputeStatistics(p_vBaseline, baselineMean, baselineVariance);
+        ComputeStatistics(p_vCurrent, currentMean, currentVariance);
+        const double baselineError = baselineVariance / p_vBaseline.size();
+        const double currentError = currentVariance / p_vCurrent.size();
+        const double standardError = std::sqrt(baselineError + currentError);
+        bool significant = false;
+        if (standardError == 0.0) {
+            // No variance at all; any difference is significant.
+            significant = currentMean != baselineMean;
+        } else {
+            const double t = std::fabs(currentMean - baselineMean) / standardError;
+            const double degreesOfFreedom = (baselineError + currentError) * (baselineError + currentError) /
+                                            (baselineError * baselineError / (p_vBaseline.size() - 1) +
+                                             currentError * currentError / (p_vCurrent.size() - 1));
+            const size_t df = static_cast<size_t>(degreesOfFreedom);
+            const double criticalValue = df == 0 ? T_CRITICAL_VALUES[0]
+                                       : df <= ARRAYSIZE(T_CRITICAL_VALUES) ? T_CRITICAL_VALUES[df - 1]
+                                       : T_CRITICAL_VALUE_INFINITE;
+            significant = t > criticalValue;
+        }
+        return significant;
+    }
+
+} // anonymous namespace
+
+//
+// Adds a sample to the results of a benchmark, creating them if needed.
+//
+// @param p_rvSamples Results of all benchmarks.
+// @param p_Name Name of benchmark.
+// @param p_CorpusSize Number of paths in the corpus used.
+// @param p_Microseconds Time taken to process the entire corpus, in microseconds.
+//
+void AddBenchmarkSample(BenchmarkSamplesV& p_rvSamples,
+                        const std::wstring& p_Name,
+                        const ULONG p_CorpusSize,
+                        const double p_Microseconds)
+{
+    auto it = std::find_if(p_rvSamples.begin(), p_rvSamples.end(), [&](const BenchmarkSamples& p_Samples) {
+        return p_Samples.m_Name == p_Name && p_Samples.m_CorpusSize == p_CorpusSize;
+    });
+    if (it == p_rvSamples.end()) {
+        BenchmarkSamples samples;
+        samples.m_Name = p_Name;
+        samples.m_CorpusSize = p_CorpusSize;
+        it = p_rvSamples.insert(p_rvSamples.end(), samples);
+    }
+    it->m_vMicroseconds.push_back(p_Microseconds);
+}
+
+//
+// Saves benchmark results to a JSON file, so that they can be used as a
+// baseline (see CompareBenchmarkSamples) or processed by other tools.
+//
+// @param p_FilePath Path of file to create.
+// @param p_vSamples Results of all benchmarks.
+// @return true if file was saved.
+//
+bool SaveBenchmarkSamples(const std::wstring& p_FilePath,
+                          const BenchmarkSamplesV& p_vSamples)
+{
+    std::ofstream file(p_FilePath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (file) {
+        file << "{\n  \"version\": " << RESULTS_FORMAT_VERSION << ",\n  \"results\": [";
+        file << std::fixed << std::setprecision(3);
+        for (auto it = p_vSamples.cbegin(); it != p_vSamples.cend(); ++it) {
+            file << (it == p_vSamples.cbegin() ? "\n" : ",\n") << "    {\"name\": ";
+            WriteJSONString(file, it->m_Name);
+            file << ", \"corpusSize\": " << it->m_CorpusSize << ", \"samples\": [";
+            for (auto sampleIt = it->m_vMicroseconds.cbegin(); sampleIt != it->m_vMicroseconds.cend(); ++sampleIt) {
+                file << (sampleIt == it->m_vMicroseconds.cbegin() ? "" : ", ") << *sampleIt;
+            }
+            file << "]}";
+        }
+        file << "\n  ]\n}\n";
+    }
+    return static_cast<bool>(file);
+}
+
+//
+// Loads benchmark results saved by SaveBenchmarkSamples.
+//
+// @param p_FilePath Path of file to load.
+// @param p_rvSamples Where to store results of all benchmarks.
+// @return true if file was loaded.
+//
+bool LoadBenchmarkSamples(const std::wstring& p_FilePath,
+                          BenchmarkSamplesV& p_rvSamples)
+{
+    std::ifstream file(p_FilePath.c_str(), std::ios::in | std::ios::binary);
+    const std::string utf8Text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    bool loaded = static_cast<bool>(file) || file.eof();
+    if (loaded && !utf8Text.empty()) {
+        // Files we write only contain ASCII, but they could have been edited.
+        const int textSize = ::MultiByteToWideChar(CP_UTF8, 0, utf8Text.data(), static_cast<int>(utf8Text.size()), nullptr, 0);
+        std::wstring text(static_cast<size_t>(textSize), L'\0');
+        ::MultiByteToWideChar(CP_UTF8, 0, utf8Text.data(), static_cast<int>(utf8Text.size()), &text[0], textSize);
+        p_rvSamples.clear();
+        ResultsReader reader(text);
+        loaded = reader.ReadResults(p_rvSamples);
+    } else {
+        loaded = false;
+    }
+    return loaded;
+}
+
+//
+// Compares benchmark results with a baseline and prints the differences to
+// the standard output. A benchmark is reported as a regression (or an
+// improvement) if its mean duration changed by at least 5% and the change
+// is statistically significant, which requires at least two samples on
+// each side (see the --repeat argument of the benchmarks executable).
+//
+// @param p_vBaseline Baseline results.
+// @param p_vCurrent Current results.
+// @return Number of regressions found.
+//
+size_t CompareBenchmarkSamples(const BenchmarkSamplesV& p_vBaseline,
+                               const BenchmarkSamplesV& p_vCurrent)
+{
+    size_t regressions = 0;
+    std::wcout << std::left << std::setw(64) << L"Benchmark" << std::right
+               << std::setw(8) << L"Size"
+               << std::setw(16) << L"Baseline (ms)"
+               << std::setw(16) << L"Current (ms)"
+               << std::setw(10) << L"Change" << std::endl;
+    for (const BenchmarkSamples& current : p_vCurrent) {
+        const auto baselineIt = std::find_if(p_vBaseline.cbegin(), p_vBaseline.cend(), [&](const BenchmarkSamples& p_Baseline) {
+            return p_Baseline.m_Name == current.m_Name && p_Baseline.m_CorpusSize == current.m_CorpusSize;
+        });
+        std::wcout << std::left << std::setw(64) << current.m_Name
+                   << std::right << std::setw(8) << current.m_CorpusSize
+                   << std::fixed << std::setprecision(3);
+        double currentMean = 0.0, currentVariance = 0.0;
+        ComputeStatistics(current.m_vMicroseconds, currentMean, currentVariance);
+        if (baselineIt != p_vBaseline.cend() && !baselineIt->m_vMicroseconds.empty()) {
+            double baselineMean = 0.0, baselineVariance = 0.0;
+            ComputeStatistics(baselineIt->m_vMicroseconds, baselineMean, baselineVariance);
+            const double change = baselineMean != 0.0 ? (currentMean - baselineMean) / baselineMean : 0.0;
+            std::wcout << std::setw(16) << baselineMean / 1000.0
+                       << std::setw(16) << currentMean / 1000.0
+                       << std::setprecision(1) << std::showpos << std::setw(9) << change * 100.0 << L'%' << std::noshowpos;
+            if (baselineIt->m_vMicroseconds.size() < 2 || current.m_vMicroseconds.size() < 2) {
+                std::wcout << L"  (not enough samples)";
+            } else if (std::fabs(change) >= MIN_RELATIVE_CHANGE &&
+                       IsSignificant(baselineIt->m_vMicroseconds, current.m_vMicroseconds)) {
+                if (change > 0.0) {
+                    std::wcout << L"  REGRESSION";
+                    ++regressions;
+                } else {
+                    std::wcout << L"  improvement";
+                }
+            }
+        } else {
+            std::wcout << std::setw(16) << L"n/a"
+                       << std::setw(16) << currentMean / 1000.0
+                       << std::setw(10) << L"" << L"  (new)";
+        }
+        std::wcout << std::endl;
+    }
+    std::wcout << std::endl << regressions << L" regression(s) found" << std::endl;
+    return regressions;
+}
@@ -0,0 +1,353 @@
+// PathCopyCopyBenchmarks.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "stdafx.h"
+#include <PathCopyCopyBenchmarks.h>
+#include <BenchmarkBaseline.h>
+#include <ShellExtensionHarness.h>
+
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+
+namespace
+{
+    // Name of the PCC DLL to benchmark. It must be in the same folder as this executable.
+    const wchar_t* const    PCC_DLL_NAME            = L"PathCopyCopy.dll";
+
+    // Command-line switch used to run the shell extension harness instead of benchmarks.
+    const wchar_t* const    SHELL_HARNESS_SWITCH    = L"--shell";
+
+    // Command-line switch used to run the multi-threaded contention benchmark instead of benchmarks.
+    const wchar_t* const    CONTENTION_SWITCH       = L"--contention";
+
+    // Command-line switches used to run the startup benchmark, and one of
+    // its iterations in a child process (see RunStartupBenchmarkChild).
+    const wchar_t* const    STARTUP_SWITCH          = L"--startup";
+    const wchar_t* const    STARTUP_CHILD_SWITCH    = L"--startup-child";
+
+    // Command-line switches used to run benchmarks multiple times, to save their
+    // results to a JSON file and to compare them with a baseline saved previously.
+    const wchar_t* const    REPEAT_SWITCH           = L"--repeat";
+    const wchar_t* const    JSON_SWITCH             = L"--json";
+    const wchar_t* const    COMPARE_SWITCH          = L"--compare";
+
+    // Command-line switch used to choose the corpus used by benchmarks (see PathCorpus).
+    const wchar_t* const    CORPUS_SWITCH           = L"--corpus";
+
+    // Command-line switch used to generate a corpus instead of running benchmarks.
+    const wchar_t* const    GENERATE_SWITCH         = L"--generate";
+
+    // Number of times benchmarks are run by default when their results are saved
+    // or compared, so that changes can be checked for statistical significance.
+    const ULONG             DEFAULT_RECORDED_REPEAT = 5;
+
+    // Exit code returned when regressions are found compared with a baseline.
+    const int               REGRESSIONS_EXIT_CODE   = 2;
+
+    // Separator between corpus sizes on the command line.
+    const wchar_t           CORPUS_SIZES_SEPARATOR  = L',';
+
+    //
+    // Prints a benchmark result to the standard output.
+    // Called by the PCC DLL when each benchmark completes.
+    //
+    // @param p_pBenchmarkName Name of benchmark that was run.
+    // @param p_CorpusSize Number of paths in the corpus used.
+    // @param p_Microseconds Time taken to process the entire corpus, in microseconds.
+    // @param p_Allocations Number of heap allocations performed, or -1 if not counted.
+    // @param p_AllocatedBytes Number of bytes allocated, or -1 if not counted.
+    // @param p_pContext Pointer to a BenchmarkSamplesV where to record the result.
+    //
+    void CALLBACK PrintBenchmarkResult(LPCWSTR p_pBenchmarkName,
+                                       ULONG p_CorpusSize,
+                                       double p_Microseconds,
+                                       LONGLONG p_Allocations,
+                                       LONGLONG p_AllocatedBytes,
+                                       LPVOID p_pContext)
+    {
+        AddBenchmarkSample(*static_cast<BenchmarkSamplesV*>(p_pContext), p_pBenchmarkName, p_CorpusSize, p_Microseconds);
+
+        const double nanosecondsPerPath = p_CorpusSize != 0 ? p_Microseconds * 1000.0 / p_CorpusSize : 0.0;
+        std::wcout << std::left << std::setw(64) << p_pBenchmarkName
+                   << std::right << std::setw(8) << p_CorpusSize
+                   << std::fixed << std::setprecision(3)
+                   << std::setw(16) << p_Microseconds / 1000.0 << L" ms"
+                   << std::setw(16) << nanosecondsPerPath << L" ns/path";
+        if (p_Allocations >= 0 && p_CorpusSize != 0) {
+            // Only available in instrumented builds of the DLL.
+            std::wcout << std::setw(12) << static_cast<double>(p_Allocations) / p_CorpusSize << L" allocs/path"
+                       << std::setw(12) << static_cast<double>(p_AllocatedBytes) / p_CorpusSize << L" B/path";
+        }
+        std::wcout << std::endl;
+    }
+
+    //
+    // Writes a generated path to a stream, encoded in UTF-8.
+    // Called by the PCC DLL for each path of a corpus.
+    //
+    // @param p_pPath Generated path.
+    // @param p_pContext Pointer to the std::ostream to write to.
+    //
+    void CALLBACK WriteCorpusPath(LPCWSTR p_pPath,
+                                  LPVOID p_pContext)
+    {
+        const int pathSize = ::WideCharToMultiByte(CP_UTF8, 0, p_pPath, -1, nullptr, 0, nullptr, nullptr);
+        std::vector<char> utf8Path(static_cast<size_t>((std::max)(pathSize, 1)));
+        ::WideCharToMultiByte(CP_UTF8, 0, p_pPath, -1, utf8Path.data(), pathSize, nullptr, nullptr);
+        *static_cast<std::ostream*>(p_pContext) << utf8Path.data() << '\n';
+    }
+
+    //
+    // Generates a corpus of paths and writes it to a file or to the standard output.
+    //
+    // @param p_hDll Handle of the loaded PCC DLL.
+    // @param argc Number of arguments received (excluding the --generate switch).
+    // @param argv Array of arguments.
+    // @return Process exit code.
+    //
+    int GenerateCorpus(HMODULE const p_hDll,
+                       int argc,
+                       wchar_t* argv[])
+    {
+        wchar_t* pEnd = nullptr;
+        const ULONG size = argc > 1 ? std::wcstoul(argv[1], &pEnd, 10) : 0;
+        if (argc < 2 || argv[1][0] == L'\0' || *pEnd != L'\0') {
+            std::wcerr << L"Invalid corpus arguments" << std::endl;
+            return 1;
+        }
+
+        int exitCode = 1;
+        typedef HRESULT (WINAPI* GenerateCorpusProc)(LPCWSTR, ULONG, PCCCORPUSPATHPROC, LPVOID);
+        auto pGenerateCorpus = reinterpret_cast<GenerateCorpusProc>(::GetProcAddress(p_hDll, "GenerateCorpusW"));
+        if (pGenerateCorpus != nullptr) {
+            std::ofstream file;
+            if (argc > 2) {
+                file.open(argv[2], std::ios::out | std::ios::binary | std::ios::trunc);
+            }
+            std::ostream& stream = argc > 2 ? static_cast<std::ostream&>(file) : std::cout;
+            const HRESULT hRes = pGenerateCorpus(argv[0], size, &WriteCorpusPath, &stream);
+            if (SUCCEEDED(hRes) && stream) {
+                exitCode = 0;
+            } else {
+                std::wcerr << L"Could not generate corpus: 0x" << std::hex << hRes << std::endl;
+            }
+        } else {
+            std::wcerr << L"GenerateCorpusW not found" << std::endl;
+        }
+        return exitCode;
+    }
+
+    //
+    // Parses a list of corpus sizes separated by commas.
+    //
+    // @param p_SizesList List of sizes.
+    // @param p_rvSizes Where to store the parsed sizes.
+    // @return true if all sizes could be parsed.
+    //
+    bool ParseCorpusSizes(const std::wstring& p_SizesList,
+                          std::vector<ULONG>& p_rvSizes)
+    {
+        std::wstringstream wss(p_SizesList);
+        std::wstring size;
+        while (std::getline(wss, size, CORPUS_SIZES_SEPARATOR)) {
+            wchar_t* pEnd = nullptr;
+            const unsigned long value = std::wcstoul(size.c_str(), &pEnd, 10);
+            if (size.empty() || *pEnd != L'\0') {
+                return false;
+            }
+            p_rvSizes.push_back(value);
+        }
+        return !p_rvSizes.empty();
+    }
+
+} // anonymous namespace
+
+//
+// Main program entry point. Loads the PCC DLL found next to the executable
+// and runs its benchmarks, printing results as they are available. The DLL
+// must be a benchmark build (built with /p:PCCBenchmarks=true), since other
+// builds do not include nor export benchmarks. Call like this:
+//
+// PathCopyCopyBenchmarks.exe [filter] [size1,size2,...] [--corpus name] [--repeat count] [--json file] [--compare file]
+//
+// If a filter is specified, only benchmarks whose name contains it are run
+// (use "" to run all benchmarks with custom sizes). Sizes are the number
+// of paths in each synthetic corpus; by default, 10, 1000 and 100000.
+// When the DLL is an instrumented build (see AllocationTracker), heap
+// allocations per path are reported next to timings. By default, paths
+// are taken from a mix of all corpora generated by the DLL; --corpus
+// selects one of them instead (see PathCorpus::Kind for their names).
+//
+// Benchmarks are run the given number of times; by default, once, or five
+// times if results are saved or compared. --json saves the results to a JSON
+// file that can be used as a baseline; --compare compares the results with
+// a baseline and reports statistically significant regressions (see
+// CompareBenchmarkSamples), returning exit code 2 if any are found.
+//
+// To measure the end-to-end latency of the shell extension instead, call:
+//
+// PathCopyCopyBenchmarks.exe --shell [selectionSize] [iterations] [slowDelayMs] [folder]
+//
+// See RunShellExtensionHarness for details. To measure how building menus
+// on several threads at once scales, call:
+//
+// PathCopyCopyBenchmarks.exe --contention [maxThreads] [iterations] [selectionSize] [folder]
+//
+// See RunContentionBenchmark for details. To measure the cold and warm
+// startup of the shell extension in fresh processes, call:
+//
+// PathCopyCopyBenchmarks.exe --startup [runs] [warmIterations] [folder]
+//
+// See RunStartupBenchmark for details. To write the paths of a corpus to
+// a file (one per line, in UTF-8) or to the standard output, call:
+//
+// PathCopyCopyBenchmarks.exe --generate name size [file]
+//
+// @param argc Number of command-line arguments received
+// @param argv Array of command-line arguments
+// @return Process exit code
+//
+int wmain(int argc, wchar_t* argv[])
+{
+    const std::wstring firstArg = argc > 1 ? argv[1] : L"";
+    const bool runShellHarness = firstArg == SHELL_HARNESS_SWITCH;
+    const bool runContention = firstArg == CONTENTION_SWITCH;
+    const bool runStartup = firstArg == STARTUP_SWITCH;
+    const bool runStartupChild = firstArg == STARTUP_CHILD_SWITCH;
+    const bool runGenerate = firstArg == GENERATE_SWITCH;
+    const bool runBenchmarks = !runShellHarness && !runContention && !runStartup && !runStartupChild && !runGenerate;
+    std::vector<std::wstring> vPositionalArgs;
+    std::wstring corpusName, jsonPath, comparePath, repeatArg;
+    if (runBenchmarks) {
+        for (int i = 1; i < argc; ++i) {
+            const std::wstring arg = argv[i];
+            if (arg == CORPUS_SWITCH && i + 1 < argc) {
+                corpusName = argv[++i];
+            } else if (arg == REPEAT_SWITCH && i + 1 < argc) {
+                repeatArg = argv[++i];
+            } else if (arg == JSON_SWITCH && i + 1 < argc) {
+                jsonPath = argv[++i];
+            } else if (arg == COMPARE_SWITCH && i + 1 < argc) {
+                comparePath = argv[++i];
+            } else {
+                vPositionalArgs.push_back(arg);
+            }
+        }
+    }
+    const std::wstring filter = !vPositionalArgs.empty() ? vPositionalArgs[0] : L"";
+    std::vector<ULONG> vCorpusSizes;
+    if (vPositionalArgs.size() > 1 && !ParseCorpusSizes(vPositionalArgs[1], vCorpusSizes)) {
+        std::wcerr << L"Invalid corpus sizes: " << vPositionalArgs[1] << std::endl;
+        return 1;
+    }
+    ULONG repeat = jsonPath.empty() && comparePath.empty() ? 1 : DEFAULT_RECORDED_REPEAT;
+    if (!repeatArg.empty()) {
+        wchar_t* pEnd = nullptr;
+        repeat = std::wcstoul(repeatArg.c_str(), &pEnd, 10);
+        if (*pEnd != L'\0' || repeat == 0) {
+            std::wcerr << L"Invalid repeat count: " << repeatArg << std::endl;
+            return 1;
+        }
+    }
+    BenchmarkSamplesV vBaseline;
+    if (!comparePath.empty() && !LoadBenchmarkSamples(comparePath, vBaseline)) {
+        std::wcerr << L"Could not load baseline " << comparePath << std::endl;
+        return 1;
+    }
+
+    // Load the DLL from our own folder so that we benchmark the matching build.
+    std::vector<wchar_t> modulePath(MAX_PATH + 1);
+    DWORD modulePathSize = ::GetModuleFileNameW(nullptr, modulePath.data(), static_cast<DWORD>(modulePath.size()));
+    const std::wstring exePath(modulePath.data(), modulePathSize);
+    std::wstring dllPath(exePath);
+    dllPath.erase(dllPath.find_last_of(L'\\') + 1);
+    dllPath += PCC_DLL_NAME;
+    if (runStartup) {
+        // Child processes will load the DLL themselves.
+        return RunStartupBenchmark(exePath, argc - 2, argv + 2);
+    } else if (runStartupChild) {
+        return RunStartupBenchmarkChild(dllPath, argc - 2, argv + 2);
+    }
+    // Time the load since it runs the DLL's static initializers, like Explorer would.
+    const auto loadStart = std::chrono::steady_clock::now();
+    HMODULE hDll = ::LoadLibraryW(dllPath.c_str());
+    const double loadMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+    if (hDll == NULL) {
+        std::wcerr << L"Could not load " << dllPath << std::endl;
+        return 1;
+    }
+    if (!runGenerate) {
+        // Generated corpora can be written to the standard output; keep it clean.
+        std::wcout << L"Loaded " << PCC_DLL_NAME << L" in "
+                   << std::fixed << std::setprecision(3) << loadMilliseconds << L" ms" << std::endl << std::endl;
+    }
+
+    int exitCode = 1;
+    if (runShellHarness) {
+        exitCode = RunShellExtensionHarness(hDll, argc - 2, argv + 2);
+    } else if (runContention) {
+        exitCode = RunContentionBenchmark(hDll, argc - 2, argv + 2);
+    } else if (runGenerate) {
+        exitCode = GenerateCorpus(hDll, argc - 2, argv + 2);
+    } else {
+        typedef HRESULT (WINAPI* RunCorpusBenchmarksProc)(LPCWSTR, LPCWSTR, const ULONG*, ULONG, PCCBENCHMARKRESULTPROC, LPVOID);
+        auto pRunBenchmarks = reinterpret_cast<RunCorpusBenchmarksProc>(::GetProcAddress(hDll, "RunCorpusBenchmarksW"));
+        if (pRunBenchmarks != nullptr) {
+            BenchmarkSamplesV vSamples;
+            HRESULT hRes = S_OK;
+            for (ULONG i = 0; SUCCEEDED(hRes) && i < repeat; ++i) {
+                hRes = pRunBenchmarks(corpusName.c_str(),
+                                      filter.c_str(),
+                                      vCorpusSizes.empty() ? nullptr : vCorpusSizes.data(),
+                                      static_cast<ULONG>(vCorpusSizes.size()),
+                                      &PrintBenchmarkResult,
+                                      &vSamples);
+            }
+            if (SUCCEEDED(hRes)) {
+                exitCode = 0;
+                if (!jsonPath.empty() && !SaveBenchmarkSamples(jsonPath, vSamples)) {
+                    std::wcerr << L"Could not save results to " << jsonPath << std::endl;
+                    exitCode = 1;
+                }
+                if (!comparePath.empty()) {
+                    std::wcout << std::endl;
+                    if (CompareBenchmarkSamples(vBaseline, vSamples) != 0 && exitCode == 0) {
+                        exitCode = REGRESSIONS_EXIT_CODE;
+                    }
+                }
+            } else {
+                std::wcerr << L"Benchmarks failed: 0x" << std::hex << hRes << std::endl;
+            }
+        } else {
+            std::wcerr << L"RunCorpusBenchmarksW not found in " << dllPath
+                       << L" (build it with /p:PCCBenchmarks=true)" << std::endl;
+        }
+    }
+
+    ::FreeLibrary(hDll);
+    return exitCode;
+}
@@ -0,0 +1,1224 @@
+// ShellExtensionHarness.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "stdafx.h"
+#include <ShellExtensionHarness.h>
+#include <PathCopyCopyBenchmarks.h>
+#include <PathCopyCopy_i.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+
+namespace
+{
+    // Default number of files in the synthetic selection.
+    const ULONG             DEFAULT_SELECTION_SIZE          = 1;
+
+    // Default number of times each phase is measured.
+    const ULONG             DEFAULT_ITERATIONS              = 100;
+
+    // Default delay added to test plugin calls during the slow pass, in milliseconds.
+    const ULONG             DEFAULT_SLOW_PLUGIN_DELAY_MS    = 100;
+
+    // Default number of processes started by the startup benchmark for each pass.
+    const ULONG             DEFAULT_STARTUP_RUNS            = 10;
+
+    // Command-line switch used to run one iteration of the startup benchmark in a child process.
+    const wchar_t* const    STARTUP_CHILD_SWITCH            = L"--startup-child";
+
+    // Folder storing registry snapshots persisted by the PCC DLL, in the user's
+    // local application data folder, and pattern of snapshot files. See RegKeySnapshot.
+    const wchar_t* const    PERSISTED_SNAPSHOTS_FOLDER_NAME = L"PathCopyCopy";
+    const wchar_t* const    PERSISTED_SNAPSHOTS_PATTERN     = L"*.snapshot";
+
+    // Environment variable read by the test plugins to simulate slow plugins.
+    // See Testing\TestPlugins.
+    const wchar_t* const    TEST_PLUGINS_DELAY_ENV_VAR_NAME = L"PCC_TEST_PLUGINS_DELAY_MS";
+
+    // Name of the DLL export used to create COM objects without registration.
+    const char* const       DLL_GET_CLASS_OBJECT_NAME       = "DllGetClassObject";
+
+    // Name of the DLL export used to get allocations per phase, in instrumented builds.
+    const char* const       GET_ALLOCATION_PHASES_NAME      = "GetAllocationPhasesW";
+
+    // Name of the DLL export used to get contention statistics of shared locks.
+    const char* const       GET_LOCK_STATISTICS_NAME        = "GetLockStatisticsW";
+
+    // Name of the DLL export used to generate corpora of paths, and name of the
+    // corpus whose file names are used for synthetic selections. See PathCorpus.
+    const char* const       GENERATE_CORPUS_NAME            = "GenerateCorpusW";
+    const wchar_t* const    SELECTION_CORPUS_NAME           = L"FlatFolder";
+
+    // First command ID passed to QueryContextMenu, like Explorer does.
+    const UINT              FIRST_CMD_ID                    = 1;
+
+    // Last command ID passed to QueryContextMenu.
+    const UINT              LAST_CMD_ID                     = 0x7FFF;
+
+    typedef std::vector<double>         DurationsV;     // Vector of durations, in milliseconds.
+
+    typedef HRESULT (STDAPICALLTYPE* DllGetClassObjectProc)(REFCLSID, REFIID, LPVOID*);
+
+    typedef HRESULT (WINAPI* GetAllocationPhasesProc)(PCCALLOCATIONPHASEPROC, LPVOID, BOOL);
+
+    typedef HRESULT (WINAPI* GetLockStatisticsProc)(PCCLOCKSTATISTICSPROC, LPVOID, BOOL);
+
+    typedef HRESULT (WINAPI* GenerateCorpusProc)(LPCWSTR, ULONG, PCCCORPUSPATHPROC, LPVOID);
+
+    //
+    // Minimal data object providing a list of files in CF_HDROP format,
+    // like the one passed by Explorer to contextual menu extensions.
+    //
+    class HDropDataObject final : public IDataObject
+    {
+    public:
+        //
+        // Constructor.
+        //
+        // @param p_vFiles Files to provide.
+        //
+        explicit HDropDataObject(const std::vector<std::wstring>& p_vFiles)
+            : m_RefCount(1),
+              m_vDropFiles()
+        {
+            // Build the DROPFILES structure once; it will be copied for each request.
+            std::vector<wchar_t> vFileList;
+            for (const auto& file : p_vFiles) {
+                vFileList.insert(vFileList.end(), file.cbegin(), file.cend());
+                vFileList.push_back(L'\0');
+            }
+            vFileList.push_back(L'\0');
+
+            m_vDropFiles.resize(sizeof(DROPFILES) + vFileList.size() * sizeof(wchar_t));
+            DROPFILES* pDropFiles = reinterpret_cast<DROPFILES*>(m_vDropFiles.data());
+            pDropFiles->pFiles = sizeof(DROPFILES);
+            pDropFiles->fWide = TRUE;
+            std::memcpy(m_vDropFiles.data() + sizeof(DROPFILES), vFileList.data(), vFileList.size() * sizeof(wchar_t));
+        }
+
+        HDropDataObject(const HDropDataObject&) = delete;
+        HDropDataObject& operator=(const HDropDataObject&) = delete;
+
+        // IUnknown methods
+        STDMETHOD(QueryInterface)(REFIID p_IID, void** p_ppObject)
+        {
+            HRESULT hRes = S_OK;
+            if (p_ppObject == nullptr) {
+                hRes = E_POINTER;
+            } else if (p_IID == IID_IUnknown || p_IID == IID_IDataObject) {
+                *p_ppObject = static_cast<IDataObject*>(this);
+                AddRef();
+            } else {
+                *p_ppObject = nullptr;
+                hRes = E_NOINTERFACE;
+            }
+            return hRes;
+        }
+        STDMETHOD_(ULONG, AddRef)()
+        {
+            return static_cast<ULONG>(::InterlockedIncrement(&m_RefCount));
+        }
+        STDMETHOD_(ULONG, Release)()
+        {
+            const ULONG refCount = static_cast<ULONG>(::InterlockedDecrement(&m_RefCount));
+            if (refCount == 0) {
+                delete this;
+            }
+            return refCount;
+        }
+
+        // IDataObject methods
+        STDMETHOD(GetData)(FORMATETC* p_pFormatEtc, STGMEDIUM* p_pMedium)
+        {
+            HRESULT hRes = QueryGetData(p_pFormatEtc);
+            if (SUCCEEDED(hRes)) {
+                if (p_pMedium == nullptr) {
+                    hRes = E_POINTER;
+                } else {
+                    // Caller owns the medium, so give it its own copy.
+                    HGLOBAL hGlobal = ::GlobalAlloc(GMEM_MOVEABLE, m_vDropFiles.size());
+                    void* pData = hGlobal != NULL ? ::GlobalLock(hGlobal) : nullptr;
+                    if (pData != nullptr) {
+                        std::memcpy(pData, m_vDropFiles.data(), m_vDropFiles.size());
+                        ::GlobalUnlock(hGlobal);
+                        p_pMedium->tymed = TYMED_HGLOBAL;
+                        p_pMedium->hGlobal = hGlobal;
+                        p_pMedium->pUnkForRelease = nullptr;
+                    } else {
+                        if (hGlobal != NULL) {
+                            ::GlobalFree(hGlobal);
+                        }
+                        hRes = E_OUTOFMEMORY;
+                    }
+                }
+            }
+            return hRes;
+        }
+        STDMETHOD(GetDataHere)(FORMATETC* /*p_pFormatEtc*/, STGMEDIUM* /*p_pMedium*/)
+        {
+            return E_NOTIMPL;
+        }
+        STDMETHOD(QueryGetData)(FORMATETC* p_pFormatEtc)
+        {
+            HRESULT hRes = S_OK;
+            if (p_pFormatEtc == nullptr) {
+                hRes = E_POINTER;
+            } else if (p_pFormatEtc->cfFormat != CF_HDROP) {
+                hRes = DV_E_FORMATETC;
+            } else if ((p_pFormatEtc->tymed & TYMED_HGLOBAL) == 0) {
+                hRes = DV_E_TYMED;
+            }
+            return hRes;
+        }
+        STDMETHOD(GetCanonicalFormatEtc)(FORMATETC* /*p_pFormatEtcIn*/, FORMATETC* p_pFormatEtcOut)
+        {
+            if (p_pFormatEtcOut != nullptr) {
+                p_pFormatEtcOut->ptd = nullptr;
+            }
+            return E_NOTIMPL;
+        }
+        STDMETHOD(SetData)(FORMATETC* /*p_pFormatEtc*/, STGMEDIUM* /*p_pMedium*/, BOOL /*p_Release*/)
+        {
+            return E_NOTIMPL;
+        }
+        STDMETHOD(EnumFormatEtc)(DWORD /*p_Direction*/, IEnumFORMATETC** p_ppEnumFormatEtc)
+        {
+            if (p_ppEnumFormatEtc != nullptr) {
+                *p_ppEnumFormatEtc = nullptr;
+            }
+            return E_NOTIMPL;
+        }
+        STDMETHOD(DAdvise)(FORMATETC* /*p_pFormatEtc*/, DWORD /*p_Advf*/, IAdviseSink* /*p_pAdvSink*/, DWORD* /*p_pConnection*/)
+        {
+            return OLE_E_ADVISENOTSUPPORTED;
+        }
+        STDMETHOD(DUnadvise)(DWORD /*p_Connection*/)
+        {
+            return OLE_E_ADVISENOTSUPPORTED;
+        }
+        STDMETHOD(EnumDAdvise)(IEnumSTATDATA** p_ppEnumAdvise)
+        {
+            if (p_ppEnumAdvise != nullptr) {
+                *p_ppEnumAdvise = nullptr;
+            }
+            return OLE_E_ADVISENOTSUPPORTED;
+        }
+
+    private:
+        LONG                m_RefCount;     // Reference count of this object.
+        std::vector<char>   m_vDropFiles;   // DROPFILES structure followed by the file list.
+
+        // Private destructor, use Release instead.
+        ~HDropDataObject() = default;
+    };
+
+    //
+    // Durations of each measured phase of the shell extension's lifetime.
+    //
+    struct PhaseDurations final
+    {
+        DurationsV  m_vInitialize;          // Durations of IShellExtInit::Initialize.
+        DurationsV  m_vQueryContextMenu;    // Durations of IContextMenu::QueryContextMenu.
+        DurationsV  m_vInvokeCommand;       // Durations of IContextMenu::InvokeCommand.
+    };
+
+    //
+    // Parses an optional numeric argument.
+    //
+    // @param argc Number of arguments.
+    // @param argv Array of arguments.
+    // @param p_Index Index of argument to parse.
+    // @param p_Default Value to use if argument is not present.
+    // @param p_rValue Where to store the parsed value.
+    // @return true if argument was absent or could be parsed.
+    //
+    bool ParseArgument(int argc,
+                       wchar_t* argv[],
+                       const int p_Index,
+                       const ULONG p_Default,
+                       ULONG& p_rValue)
+    {
+        bool parsed = true;
+        p_rValue = p_Default;
+        if (argc > p_Index) {
+            wchar_t* pEnd = nullptr;
+            p_rValue = std::wcstoul(argv[p_Index], &pEnd, 10);
+            parsed = argv[p_Index][0] != L'\0' && *pEnd == L'\0';
+        }
+        return parsed;
+    }
+
+    //
+    // Returns the elapsed time since the given time point, in milliseconds.
+    //
+    // @param p_Start Start time.
+    // @return Elapsed time, in milliseconds.
+    //
+    double ElapsedMilliseconds(const std::chrono::steady_clock::time_point& p_Start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - p_Start).count();
+    }
+
+    //
+    // Returns a percentile of a sorted list of durations, using the nearest-rank method.
+    //
+    // @param p_vSortedDurations Sorted durations. Must not be empty.
+    // @param p_Percentile Percentile to return, between 0 and 100.
+    // @return Duration at the given percentile.
+    //
+    double Percentile(const DurationsV& p_vSortedDurations,
+                      const double p_Percentile)
+    {
+        const size_t rank = static_cast<size_t>(std::ceil(p_Percentile / 100.0 * p_vSortedDurations.size()));
+        return p_vSortedDurations[(std::max)(rank, static_cast<size_t>(1)) - 1];
+    }
+
+    //
+    // Prints the statistics of one phase to the standard output.
+    //
+    // @param p_pPhaseName Name of measured phase.
+    // @param p_vDurations Durations measured for that phase.
+    //
+    void PrintPhase(const wchar_t* const p_pPhaseName,
+                    DurationsV p_vDurations)
+    {
+        std::wcout << std::left << std::setw(24) << p_pPhaseName << std::right;
+        if (!p_vDurations.empty()) {
+            std::sort(p_vDurations.begin(), p_vDurations.end());
+            std::wcout << std::fixed << std::setprecision(3)
+                       << std::setw(12) << Percentile(p_vDurations, 50.0)
+                       << std::setw(12) << Percentile(p_vDurations, 90.0)
+                       << std::setw(12) << Percentile(p_vDurations, 99.0)
+                       << std::setw(12) << p_vDurations.back();
+        } else {
+            std::wcout << std::setw(12) << L"n/a";
+        }
+        std::wcout << std::endl;
+    }
+
+    //
+    // Prints the allocations performed by one phase of our operations to the
+    // standard output. Called by the PCC DLL for each phase.
+    //
+    // @param p_pPhaseName Name of phase.
+    // @param p_Calls Number of times the phase was performed.
+    // @param p_Allocations Number of heap allocations performed during all calls.
+    // @param p_AllocatedBytes Number of bytes allocated during all calls.
+    // @param p_pContext Unused.
+    //
+    void CALLBACK PrintAllocationPhase(LPCWSTR p_pPhaseName,
+                                       ULONGLONG p_Calls,
+                                       ULONGLONG p_Allocations,
+                                       ULONGLONG p_AllocatedBytes,
+                                       LPVOID /*p_pContext*/)
+    {
+        if (p_Calls != 0) {
+            std::wcout << L"  " << std::left << std::setw(46) << p_pPhaseName << std::right
+                       << std::setw(10) << p_Calls
+                       << std::fixed << std::setprecision(1)
+                       << std::setw(12) << static_cast<double>(p_Allocations) / p_Calls
+                       << std::setw(12) << static_cast<double>(p_AllocatedBytes) / p_Calls << std::endl;
+        }
+    }
+
+    //
+    // Discards allocations reported by the PCC DLL. Used to reset totals.
+    //
+    void CALLBACK IgnoreAllocationPhase(LPCWSTR, ULONGLONG, ULONGLONG, ULONGLONG, LPVOID)
+    {
+    }
+
+    //
+    // Adds a path generated by the PCC DLL to a vector of paths.
+    //
+    // @param p_pPath Generated path.
+    // @param p_pContext Pointer to the std::vector<std::wstring> to add the path to.
+    //
+    void CALLBACK AddCorpusPath(LPCWSTR p_pPath,
+                                LPVOID p_pContext)
+    {
+        static_cast<std::vector<std::wstring>*>(p_pContext)->push_back(p_pPath);
+    }
+
+    //
+    // Generates the files of a synthetic selection in a folder. File names are
+    // taken from the flat folder corpus of the PCC DLL, so that the selection
+    // uses the same names as the benchmarks; older DLLs get numbered names.
+    //
+    // @param p_hDll Handle of the loaded PCC DLL.
+    // @param p_Folder Folder containing the files, ending with a backslash.
+    // @param p_SelectionSize Number of files to generate.
+    // @return Paths of selected files.
+    //
+    std::vector<std::wstring> GenerateSelection(HMODULE const p_hDll,
+                                                const std::wstring& p_Folder,
+                                                const ULONG p_SelectionSize)
+    {
+        std::vector<std::wstring> vCorpus;
+        auto pGenerateCorpus = reinterpret_cast<GenerateCorpusProc>(::GetProcAddress(p_hDll, GENERATE_CORPUS_NAME));
+        if (pGenerateCorpus != nullptr) {
+            pGenerateCorpus(SELECTION_CORPUS_NAME, p_SelectionSize, &AddCorpusPath, &vCorpus);
+        }
+
+        std::vector<std::wstring> vFiles;
+        vFiles.reserve(p_SelectionSize);
+        for (ULONG i = 0; i < p_SelectionSize; ++i) {
+            if (i < vCorpus.size()) {
+                vFiles.push_back(p_Folder + vCorpus[i].substr(vCorpus[i].find_last_of(L'\\') + 1));
+            } else {
+                std::wstringstream wss;
+                wss << p_Folder << L"Synthetic file " << i << L".txt";
+                vFiles.push_back(wss.str());
+            }
+        }
+        return vFiles;
+    }
+
+    //
+    // Finds the offset of the first plugin command in the menu built by the
+    // extension. Plugins are always added before the settings menu item.
+    //
+    // @param p_pContextMenu Contextual menu extension.
+    // @param p_CmdCount Number of commands added by the extension.
+    // @return Offset of the first valid command, or p_CmdCount if none were found.
+    //
+    UINT FindFirstCommandOffset(IContextMenu* const p_pContextMenu,
+                                const UINT p_CmdCount)
+    {
+        UINT cmdOffset = 0;
+        while (cmdOffset < p_CmdCount &&
+               p_pContextMenu->GetCommandString(cmdOffset, GCS_VALIDATEW, nullptr, nullptr, 0) != S_OK) {
+            ++cmdOffset;
+        }
+        return cmdOffset;
+    }
+
+    //
+    // Runs one pass of the harness, creating an extension for each iteration
+    // and measuring the time taken by each phase.
+    //
+    // @param p_pClassFactory Class factory of the PCC contextual menu extension.
+    // @param p_pDataObject Data object containing selected files.
+    // @param p_Iterations Number of iterations to run.
+    // @param p_rDurations Where to store measured durations.
+    // @return S_OK if successful, otherwise an error code.
+    //
+    HRESULT RunPass(IClassFactory* const p_pClassFactory,
+                    IDataObject* const p_pDataObject,
+                    const ULONG p_Iterations,
+                    PhaseDurations& p_rDurations)
+    {
+        HRESULT hRes = S_OK;
+        for (ULONG i = 0; SUCCEEDED(hRes) && i < p_Iterations; ++i) {
+            IShellExtInit* pShellExtInit = nullptr;
+            hRes = p_pClassFactory->CreateInstance(nullptr, IID_IShellExtInit, reinterpret_cast<void**>(&pShellExtInit));
+            if (SUCCEEDED(hRes)) {
+                auto start = std::chrono::steady_clock::now();
+                hRes = pShellExtInit->Initialize(nullptr, p_pDataObject, NULL);
+                p_rDurations.m_vInitialize.push_back(ElapsedMilliseconds(start));
+
+                IContextMenu* pContextMenu = nullptr;
+                if (SUCCEEDED(hRes)) {
+                    hRes = pShellExtInit->QueryInterface(IID_IContextMenu, reinterpret_cast<void**>(&pContextMenu));
+                }
+                if (SUCCEEDED(hRes)) {
+                    HMENU hMenu = ::CreatePopupMenu();
+                    start = std::chrono::steady_clock::now();
+                    hRes = pContextMenu->QueryContextMenu(hMenu, 0, FIRST_CMD_ID, LAST_CMD_ID, CMF_NORMAL);
+                    p_rDurations.m_vQueryContextMenu.push_back(ElapsedMilliseconds(start));
+
+                    if (SUCCEEDED(hRes)) {
+                        // QueryContextMenu returns the number of commands added.
+                        const UINT cmdCount = HRESULT_CODE(hRes);
+                        const UINT cmdOffset = FindFirstCommandOffset(pContextMenu, cmdCount);
+                        if (cmdOffset < cmdCount) {
+                            CMINVOKECOMMANDINFO commandInfo = { 0 };
+                            commandInfo.cbSize = sizeof(commandInfo);
+                            commandInfo.lpVerb = MAKEINTRESOURCEA(cmdOffset);
+                            commandInfo.nShow = SW_SHOWNORMAL;
+                            start = std::chrono::steady_clock::now();
+                            hRes = pContextMenu->InvokeCommand(&commandInfo);
+                            p_rDurations.m_vInvokeCommand.push_back(ElapsedMilliseconds(start));
+                        }
+                    }
+
+                    ::DestroyMenu(hMenu);
+                    pContextMenu->Release();
+                }
+                pShellExtInit->Release();
+            }
+        }
+        return hRes;
+    }
+
+    //
+    // Runs one pass of the harness and prints its results.
+    //
+    // @param p_pPassName Name of the pass.
+    // @param p_pClassFactory Class factory of the PCC contextual menu extension.
+    // @param p_pDataObject Data object containing selected files.
+    // @param p_Iterations Number of iterations to run.
+    // @param p_pGetAllocationPhases Function returning allocations per phase;
+    //                               nullptr if not exported by the PCC DLL.
+    // @return S_OK if successful, otherwise an error code.
+    //
+    HRESULT RunAndPrintPass(const wchar_t* const p_pPassName,
+                            IClassFactory* const p_pClassFactory,
+                            IDataObject* const p_pDataObject,
+                            const ULONG p_Iterations,
+                            GetAllocationPhasesProc const p_pGetAllocationPhases)
+    {
+        PhaseDurations durations;
+        const HRESULT hRes = RunPass(p_pClassFactory, p_pDataObject, p_Iterations, durations);
+        std::wcout << p_pPassName << std::endl
+                   << std::left << std::setw(24) << L"  (ms)" << std::right
+                   << std::setw(12) << L"p50"
+                   << std::setw(12) << L"p90"
+                   << std::setw(12) << L"p99"
+                   << std::setw(12) << L"max" << std::endl;
+        PrintPhase(L"  Initialize", durations.m_vInitialize);
+        PrintPhase(L"  QueryContextMenu", durations.m_vQueryContextMenu);
+        PrintPhase(L"  InvokeCommand", durations.m_vInvokeCommand);
+        if (p_pGetAllocationPhases != nullptr &&
+            p_pGetAllocationPhases(&IgnoreAllocationPhase, nullptr, FALSE) == S_OK) {
+
+            // Instrumented build: print allocations of each traced phase. Nested phases are
+            // also included in the totals of their parent phases.
+            std::wcout << std::left << std::setw(48) << L"  (per call)" << std::right
+                       << std::setw(10) << L"calls"
+                       << std::setw(12) << L"allocs"
+                       << std::setw(12) << L"bytes" << std::endl;
+            p_pGetAllocationPhases(&PrintAllocationPhase, nullptr, TRUE);
+        }
+        if (FAILED(hRes)) {
+            std::wcerr << L"Pass failed: 0x" << std::hex << hRes << std::dec << std::endl;
+        }
+        return hRes;
+    }
+
+    //
+    // Durations of each phase of the shell extension's startup, measured
+    // in a fresh process by RunStartupBenchmarkChild.
+    //
+    struct StartupDurations final
+    {
+        DurationsV  m_vLoad;                    // Durations of LoadLibrary, including static initialization.
+        DurationsV  m_vGetClassObject;          // Durations of DllGetClassObject.
+        DurationsV  m_vCreateInstance;          // Durations of the first IClassFactory::CreateInstance.
+        DurationsV  m_vInitialize;              // Durations of the first IShellExtInit::Initialize.
+        DurationsV  m_vQueryContextMenu;        // Durations of the first IContextMenu::QueryContextMenu.
+        DurationsV  m_vWarmInitialize;          // Median durations of subsequent Initialize calls.
+        DurationsV  m_vWarmQueryContextMenu;    // Median durations of subsequent QueryContextMenu calls.
+    };
+
+    //
+    // Returns the median of a list of durations.
+    //
+    // @param p_vDurations Durations. Must not be empty.
+    // @return Median duration.
+    //
+    double Median(DurationsV p_vDurations)
+    {
+        std::sort(p_vDurations.begin(), p_vDurations.end());
+        return Percentile(p_vDurations, 50.0);
+    }
+
+    //
+    // Deletes the registry snapshots persisted to disk by the PCC DLL (see
+    // RegKeySnapshot), so that the next process has to read the registry.
+    //
+    void DeletePersistedSnapshots()
+    {
+        wchar_t appDataPath[MAX_PATH + 1];
+        if (SUCCEEDED(::SHGetFolderPathW(nullptr, CSIDL_LOCAL_APPDATA, nullptr, SHGFP_TYPE_CURRENT, appDataPath))) {
+            const std::wstring folder = std::wstring(appDataPath) + L'\\' + PERSISTED_SNAPSHOTS_FOLDER_NAME + L'\\';
+            WIN32_FIND_DATAW findData;
+            HANDLE hFind = ::FindFirstFileW((folder + PERSISTED_SNAPSHOTS_PATTERN).c_str(), &findData);
+            if (hFind != INVALID_HANDLE_VALUE) {
+                do {
+                    ::DeleteFileW((folder + findData.cFileName).c_str());
+                } while (::FindNextFileW(hFind, &findData));
+                ::FindClose(hFind);
+            }
+        }
+    }
+
+    //
+    // Runs the startup benchmark once in a fresh process and collects the
+    // durations it reports on its standard output.
+    //
+    // @param p_CommandLine Command line of the child process.
+    // @param p_rDurations Where to add measured durations.
+    // @return S_OK if successful, otherwise an error code.
+    //
+    HRESULT RunStartupChild(std::wstring p_CommandLine,
+                            StartupDurations& p_rDurations)
+    {
+        SECURITY_ATTRIBUTES securityAttributes = { 0 };
+        securityAttributes.nLength = sizeof(securityAttributes);
+        securityAttributes.bInheritHandle = TRUE;
+        HANDLE hReadPipe = NULL, hWritePipe = NULL;
+        if (!::CreatePipe(&hReadPipe, &hWritePipe, &securityAttributes, 0)) {
+            return HRESULT_FROM_WIN32(::GetLastError());
+        }
+        ::SetHandleInformation(hReadPipe, HANDLE_FLAG_INHERIT, 0);
+
+        STARTUPINFOW startupInfo = { 0 };
+        startupInfo.cb = sizeof(startupInfo);
+        startupInfo.dwFlags = STARTF_USESTDHANDLES;
+        startupInfo.hStdInput = ::GetStdHandle(STD_INPUT_HANDLE);
+        startupInfo.hStdOutput = hWritePipe;
+        startupInfo.hStdError = ::GetStdHandle(STD_ERROR_HANDLE);
+        PROCESS_INFORMATION processInfo = { 0 };
+        HRESULT hRes = S_OK;
+        if (::CreateProcessW(nullptr, &p_CommandLine[0], nullptr, nullptr, TRUE, 0,
+                             nullptr, nullptr, &startupInfo, &processInfo)) {
+            // Close our copy of the write end so that reads end when the child exits.
+            ::CloseHandle(hWritePipe);
+            hWritePipe = NULL;
+
+            std::string output;
+            char buffer[512];
+            DWORD read = 0;
+            while (::ReadFile(hReadPipe, buffer, sizeof(buffer), &read, nullptr) && read != 0) {
+                output.append(buffer, read);
+            }
+            ::WaitForSingleObject(processInfo.hProcess, INFINITE);
+            DWORD exitCode = 1;
+            ::GetExitCodeProcess(processInfo.hProcess, &exitCode);
+            ::CloseHandle(processInfo.hThread);
+            ::CloseHandle(processInfo.hProcess);
+
+            // Child prints all durations on a single line.
+            std::istringstream iss(output);
+            double load = 0.0, getClassObject = 0.0, createInstance = 0.0, initialize = 0.0,
+                   queryContextMenu = 0.0, warmInitialize = 0.0, warmQueryContextMenu = 0.0;
+            if (exitCode == 0 && (iss >> load >> getClassObject >> createInstance >> initialize
+                                      >> queryContextMenu >> warmInitialize >> warmQueryContextMenu)) {
+                p_rDurations.m_vLoad.push_back(load);
+                p_rDurations.m_vGetClassObject.push_back(getClassObject);
+                p_rDurations.m_vCreateInstance.push_back(createInstance);
+                p_rDurations.m_vInitialize.push_back(initialize);
+                p_rDurations.m_vQueryContextMenu.push_back(queryContextMenu);
+                p_rDurations.m_vWarmInitialize.push_back(warmInitialize);
+                p_rDurations.m_vWarmQueryContextMenu.push_back(warmQueryContextMenu);
+            } else {
+                hRes = E_FAIL;
+            }
+        } else {
+            hRes = HRESULT_FROM_WIN32(::GetLastError());
+        }
+        if (hWritePipe != NULL) {
+            ::CloseHandle(hWritePipe);
+        }
+        ::CloseHandle(hReadPipe);
+        return hRes;
+    }
+
+    //
+    // Runs the startup benchmark in fresh processes and prints its results.
+    //
+    // @param p_pPassName Name of the pass.
+    // @param p_CommandLine Command line of child processes.
+    // @param p_Runs Number of child processes to run.
+    // @param p_KeepPersistedSnapshots Whether to keep snapshots persisted by previous
+    //                                 processes; if false, they are deleted before each run.
+    // @return S_OK if successful, otherwise an error code.
+    //
+    HRESULT RunAndPrintStartupPass(const wchar_t* const p_pPassName,
+                                   const std::wstring& p_CommandLine,
+                                   const ULONG p_Runs,
+                                   const bool p_KeepPersistedSnapshots)
+    {
+        StartupDurations durations;
+        HRESULT hRes = S_OK;
+        if (p_KeepPersistedSnapshots) {
+            // Make sure snapshots are persisted before the first measured run.
+            StartupDurations primingDurations;
+            hRes = RunStartupChild(p_CommandLine, primingDurations);
+        }
+        for (ULONG i = 0; SUCCEEDED(hRes) && i < p_Runs; ++i) {
+            if (!p_KeepPersistedSnapshots) {
+                DeletePersistedSnapshots();
+            }
+            hRes = RunStartupChild(p_CommandLine, durations);
+        }
+        std::wcout << p_pPassName << std::endl
+                   << std::left << std::setw(24) << L"  (ms)" << std::right
+                   << std::setw(12) << L"p50"
+                   << std::setw(12) << L"p90"
+                   << std::setw(12) << L"p99"
+                   << std::setw(12) << L"max" << std::endl;
+        PrintPhase(L"  LoadLibrary", durations.m_vLoad);
+        PrintPhase(L"  DllGetClassObject", durations.m_vGetClassObject);
+        PrintPhase(L"  CreateInstance", durations.m_vCreateInstance);
+        PrintPhase(L"  First Initialize", durations.m_vInitialize);
+        PrintPhase(L"  First QueryContextMenu", durations.m_vQueryContextMenu);
+        PrintPhase(L"  Warm Initialize", durations.m_vWarmInitialize);
+        PrintPhase(L"  Warm QueryContextMenu", durations.m_vWarmQueryContextMenu);
+        if (FAILED(hRes)) {
+            std::wcerr << L"Pass failed: 0x" << std::hex << hRes << std::dec << std::endl;
+        }
+        return hRes;
+    }
+
+    //
+    // State shared by the threads of one pass of the contention benchmark,
+    // used to start measuring on all threads at once.
+    //
+    struct ContentionPassState final
+    {
+        std::mutex  m_Lock;             // Lock protecting members.
+        std::condition_variable
+                    m_Changed;          // Signaled when members change.
+        ULONG       m_ReadyThreads;     // Number of threads ready to be measured.
+        bool        m_Started;          // Whether threads can start being measured.
+    };
+
+    //
+    // Runs one thread of the contention benchmark. Like Explorer windows, each
+    // thread initializes COM and gets its own class factory and extensions.
+    // Once warmed up, the thread waits for all others before being measured.
+    //
+    // @param p_pDllGetClassObject DllGetClassObject export of the PCC DLL.
+    // @param p_vFiles Files to select.
+    // @param p_Iterations Number of iterations to run once all threads are ready.
+    // @param p_rState State shared by all threads of the pass.
+    // @param p_rDurations Where to store measured durations.
+    // @param p_rhRes Where to store the result of the thread.
+    //
+    void RunContentionThread(DllGetClassObjectProc const p_pDllGetClassObject,
+                             const std::vector<std::wstring>& p_vFiles,
+                             const ULONG p_Iterations,
+                             ContentionPassState& p_rState,
+                             PhaseDurations& p_rDurations,
+                             HRESULT& p_rhRes)
+    {
+        HRESULT hRes = ::CoInitialize(nullptr);
+        const bool coInitialized = SUCCEEDED(hRes);
+        IClassFactory* pClassFactory = nullptr;
+        HDropDataObject* pDataObject = nullptr;
+        if (SUCCEEDED(hRes)) {
+            hRes = p_pDllGetClassObject(__uuidof(PathCopyCopyContextMenuExt), IID_IClassFactory, reinterpret_cast<LPVOID*>(&pClassFactory));
+        }
+        if (SUCCEEDED(hRes)) {
+            // Warm up the caches of this thread before measuring.
+            pDataObject = new HDropDataObject(p_vFiles);
+            PhaseDurations warmUpDurations;
+            hRes = RunPass(pClassFactory, pDataObject, 1, warmUpDurations);
+        }
+
+        // Wait for all threads, even if we failed, so that the pass can end.
+        {
+            std::unique_lock<std::mutex> lock(p_rState.m_Lock);
+            ++p_rState.m_ReadyThreads;
+            p_rState.m_Changed.notify_all();
+            p_rState.m_Changed.wait(lock, [&]() { return p_rState.m_Started; });
+        }
+        if (SUCCEEDED(hRes)) {
+            hRes = RunPass(pClassFactory, pDataObject, p_Iterations, p_rDurations);
+        }
+
+        if (pDataObject != nullptr) {
+            pDataObject->Release();
+        }
+        if (pClassFactory != nullptr) {
+            pClassFactory->Release();
+        }
+        if (coInitialized) {
+            ::CoUninitialize();
+        }
+        p_rhRes = hRes;
+    }
+
+    //
+    // Prints the contention statistics of one lock of the PCC DLL to the
+    // standard output. Called by the PCC DLL for each lock.
+    //
+    // @param p_pLockName Name of lock.
+    // @param p_Acquisitions Number of times the lock was acquired.
+    // @param p_Contentions Number of acquisitions that had to wait.
+    // @param p_WaitMicroseconds Total time spent waiting, in microseconds.
+    // @param p_MaxWaitMicroseconds Longest wait, in microseconds.
+    // @param p_pContext Unused.
+    //
+    void CALLBACK PrintLockStatistics(LPCWSTR p_pLockName,
+                                      ULONGLONG p_Acquisitions,
+                                      ULONGLONG p_Contentions,
+                                      ULONGLONG p_WaitMicroseconds,
+                                      ULONGLONG p_MaxWaitMicroseconds,
+                                      LPVOID /*p_pContext*/)
+    {
+        if (p_Acquisitions != 0) {
+            std::wcout << L"  " << std::left << std::setw(52) << p_pLockName << std::right
+                       << std::setw(10) << p_Acquisitions
+                       << std::fixed << std::setprecision(2)
+                       << std::setw(12) << 100.0 * p_Contentions / p_Acquisitions
+                       << std::setprecision(3)
+                       << std::setw(12) << p_WaitMicroseconds / 1000.0
+                       << std::setw(12) << p_MaxWaitMicroseconds / 1000.0 << std::endl;
+        }
+    }
+
+    //
+    // Discards lock statistics reported by the PCC DLL. Used to reset them.
+    //
+    void CALLBACK IgnoreLockStatistics(LPCWSTR, ULONGLONG, ULONGLONG, ULONGLONG, ULONGLONG, LPVOID)
+    {
+    }
+
+    //
+    // Runs one pass of the contention benchmark on the given number of
+    // threads and prints its results.
+    //
+    // @param p_pDllGetClassObject DllGetClassObject export of the PCC DLL.
+    // @param p_pGetLockStatistics Function returning lock statistics;
+    //                             nullptr if not exported by the PCC DLL.
+    // @param p_vFiles Files to select.
+    // @param p_Threads Number of threads to run concurrently.
+    // @param p_Iterations Number of iterations to run on each thread.
+    // @param p_rSingleThreadThroughput Throughput of a single thread, in menus per
+    //                                  second; set by the pass using one thread.
+    // @return S_OK if successful, otherwise an error code.
+    //
+    HRESULT RunAndPrintContentionPass(DllGetClassObjectProc const p_pDllGetClassObject,
+                                      GetLockStatisticsProc const p_pGetLockStatistics,
+                                      const std::vector<std::wstring>& p_vFiles,
+                                      const ULONG p_Threads,
+                                      const ULONG p_Iterations,
+                                      double& p_rSingleThreadThroughput)
+    {
+        ContentionPassState state;
+        state.m_ReadyThreads = 0;
+        state.m_Started = false;
+        std::vector<PhaseDurations> vDurations(p_Threads);
+        std::vector<HRESULT> vResults(p_Threads, S_OK);
+        std::vector<std::thread> vThreads;
+        vThreads.reserve(p_Threads);
+        for (ULONG i = 0; i < p_Threads; ++i) {
+            vThreads.emplace_back(&RunContentionThread, p_pDllGetClassObject, std::cref(p_vFiles), p_Iterations,
+                                  std::ref(state), std::ref(vDurations[i]), std::ref(vResults[i]));
+        }
+
+        // Once all threads are warmed up, reset lock statistics and start measuring.
+        std::chrono::steady_clock::time_point start;
+        {
+            std::unique_lock<std::mutex> lock(state.m_Lock);
+            state.m_Changed.wait(lock, [&]() { return state.m_ReadyThreads == p_Threads; });
+            if (p_pGetLockStatistics != nullptr) {
+                p_pGetLockStatistics(&IgnoreLockStatistics, nullptr, TRUE);
+            }
+            start = std::chrono::steady_clock::now();
+            state.m_Started = true;
+            state.m_Changed.notify_all();
+        }
+        for (auto& thread : vThreads) {
+            thread.join();
+        }
+        const double elapsedSeconds = ElapsedMilliseconds(start) / 1000.0;
+
+        HRESULT hRes = S_OK;
+        PhaseDurations durations;
+        for (ULONG i = 0; i < p_Threads; ++i) {
+            if (FAILED(vResults[i]) && SUCCEEDED(hRes)) {
+                hRes = vResults[i];
+            }
+            durations.m_vInitialize.insert(durations.m_vInitialize.end(),
+                                           vDurations[i].m_vInitialize.cbegin(), vDurations[i].m_vInitialize.cend());
+            durations.m_vQueryContextMenu.insert(durations.m_vQueryContextMenu.end(),
+                                                 vDurations[i].m_vQueryContextMenu.cbegin(), vDurations[i].m_vQueryContextMenu.cend());
+            durations.m_vInvokeCommand.insert(durations.m_vInvokeCommand.end(),
+                                              vDurations[i].m_vInvokeCommand.cbegin(), vDurations[i].m_vInvokeCommand.cend());
+        }
+
+        // Throughput is the number of menus built and invoked per second on all threads.
+        const double throughput = elapsedSeconds > 0.0 ? durations.m_vQueryContextMenu.size() / elapsedSeconds : 0.0;
+        if (p_Threads == 1) {
+            p_rSingleThreadThroughput = throughput;
+        }
+        std::wcout << p_Threads << L" thread(s): " << std::fixed << std::setprecision(1)
+                   << throughput << L" menus/s";
+        if (p_rSingleThreadThroughput > 0.0) {
+            std::wcout << L", " << 100.0 * throughput / (p_rSingleThreadThroughput * p_Threads)
+                       << L"% of linear scaling";
+        }
+        std::wcout << std::endl
+                   << std::left << std::setw(24) << L"  (ms)" << std::right
+                   << std::setw(12) << L"p50"
+                   << std::setw(12) << L"p90"
+                   << std::setw(12) << L"p99"
+                   << std::setw(12) << L"max" << std::endl;
+        PrintPhase(L"  Initialize", durations.m_vInitialize);
+        PrintPhase(L"  QueryContextMenu", durations.m_vQueryContextMenu);
+        PrintPhase(L"  InvokeCommand", durations.m_vInvokeCommand);
+        if (p_pGetLockStatistics != nullptr) {
+            std::wcout << std::left << std::setw(54) << L"  (locks)" << std::right
+                       << std::setw(10) << L"acquired"
+                       << std::setw(12) << L"waited %"
+                       << std::setw(12) << L"wait ms"
+                       << std::setw(12) << L"max ms" << std::endl;
+            p_pGetLockStatistics(&PrintLockStatistics, nullptr, TRUE);
+        }
+        if (FAILED(hRes)) {
+            std::wcerr << L"Pass failed: 0x" << std::hex << hRes << std::dec << std::endl;
+        }
+        return hRes;
+    }
+
+} // anonymous namespace
+
+//
+// Runs the end-to-end shell extension latency harness. Call like this:
+//
+// PathCopyCopyBenchmarks.exe --shell [selectionSize] [iterations] [slowDelayMs] [folder]
+//
+// The extension is created through the PCC DLL's class factory, so it does
+// not need to be registered, but it uses the current user's settings and
+// plugins. To measure the impact of slow COM plugins, register the plugins in
+// Testing\TestPlugins first: the second pass sets the delay they will add to
+// each of their calls. Selected files are in the given folder, which can be
+// the Testing folder (by default, the current directory), and are named like
+// the files of the flat folder corpus (see PathCorpus).
+// Note that invoking a command copies paths to the clipboard.
+//
+// @param p_hDll Handle of the loaded PCC DLL.
+// @param argc Number of harness arguments received (excluding the --shell switch).
+// @param argv Array of harness arguments.
+// @return Process exit code.
+//
+int RunShellExtensionHarness(HMODULE p_hDll,
+                             int argc,
+                             wchar_t* argv[])
+{
+    ULONG selectionSize = 0, iterations = 0, slowDelayMs = 0;
+    if (!ParseArgument(argc, argv, 0, DEFAULT_SELECTION_SIZE, selectionSize) ||
+        !ParseArgument(argc, argv, 1, DEFAULT_ITERATIONS, iterations) ||
+        !ParseArgument(argc, argv, 2, DEFAULT_SLOW_PLUGIN_DELAY_MS, slowDelayMs)) {
+
+        std::wcerr << L"Invalid harness arguments" << std::endl;
+        return 1;
+    }
+    std::wstring folder;
+    if (argc > 3) {
+        folder = argv[3];
+    } else {
+        std::vector<wchar_t> currentDirectory(MAX_PATH + 1);
+        folder.assign(currentDirectory.data(),
+                      ::GetCurrentDirectoryW(static_cast<DWORD>(currentDirectory.size()), currentDirectory.data()));
+    }
+    if (!folder.empty() && folder.back() != L'\\') {
+        folder += L'\\';
+    }
+
+    auto pDllGetClassObject = reinterpret_cast<DllGetClassObjectProc>(::GetProcAddress(p_hDll, DLL_GET_CLASS_OBJECT_NAME));
+    if (pDllGetClassObject == nullptr) {
+        std::wcerr << L"DllGetClassObject not found" << std::endl;
+        return 1;
+    }
+
+    // Only exported by recent DLLs; only reports phases in instrumented builds.
+    auto pGetAllocationPhases = reinterpret_cast<GetAllocationPhasesProc>(::GetProcAddress(p_hDll, GET_ALLOCATION_PHASES_NAME));
+
+    int exitCode = 1;
+    HRESULT hRes = ::CoInitialize(nullptr);
+    if (SUCCEEDED(hRes)) {
+        IClassFactory* pClassFactory = nullptr;
+        hRes = pDllGetClassObject(__uuidof(PathCopyCopyContextMenuExt), IID_IClassFactory, reinterpret_cast<LPVOID*>(&pClassFactory));
+        if (SUCCEEDED(hRes)) {
+            HDropDataObject* pDataObject = new HDropDataObject(GenerateSelection(p_hDll, folder, selectionSize));
+
+            std::wcout << L"Selection of " << selectionSize << L" file(s), "
+                       << iterations << L" iteration(s)" << std::endl << std::endl;
+            ::SetEnvironmentVariableW(TEST_PLUGINS_DELAY_ENV_VAR_NAME, nullptr);
+            if (pGetAllocationPhases != nullptr) {
+                // Don't include allocations performed while loading the DLL.
+                pGetAllocationPhases(&IgnoreAllocationPhase, nullptr, TRUE);
+            }
+            hRes = RunAndPrintPass(L"Normal plugins", pClassFactory, pDataObject, iterations, pGetAllocationPhases);
+            if (SUCCEEDED(hRes) && slowDelayMs != 0) {
+                std::wstringstream wss;
+                wss << slowDelayMs;
+                ::SetEnvironmentVariableW(TEST_PLUGINS_DELAY_ENV_VAR_NAME, wss.str().c_str());
+                std::wcout << std::endl;
+                hRes = RunAndPrintPass((L"Test plugins slowed by " + wss.str() + L" ms").c_str(),
+                                       pClassFactory, pDataObject, iterations, pGetAllocationPhases);
+                ::SetEnvironmentVariableW(TEST_PLUGINS_DELAY_ENV_VAR_NAME, nullptr);
+            }
+            if (SUCCEEDED(hRes)) {
+                exitCode = 0;
+            }
+
+            pDataObject->Release();
+            pClassFactory->Release();
+        } else {
+            std::wcerr << L"Could not get class factory: 0x" << std::hex << hRes << std::endl;
+        }
+        ::CoUninitialize();
+    }
+    return exitCode;
+}
+
+//
+// Runs the cold and warm startup benchmark of the shell extension. Call like this:
+//
+// PathCopyCopyBenchmarks.exe --startup [runs] [warmIterations] [folder]
+//
+// Each run starts a fresh process (see RunStartupBenchmarkChild) that loads
+// the PCC DLL and times each phase leading to the first contextual menu, then
+// the same calls once the extension is warm. Phases are reported separately,
+// first without the registry snapshots persisted by PCC (like the first
+// right-click after settings have changed), then with them (like the first
+// right-click after logon). For results to be cold, no other process must
+// have the DLL loaded; otherwise, snapshots will be loaded from shared memory.
+//
+// @param p_ExePath Path to this executable, used to start child processes.
+// @param argc Number of benchmark arguments received (excluding the --startup switch).
+// @param argv Array of benchmark arguments.
+// @return Process exit code.
+//
+int RunStartupBenchmark(const std::wstring& p_ExePath,
+                        int argc,
+                        wchar_t* argv[])
+{
+    ULONG runs = 0, warmIterations = 0;
+    if (!ParseArgument(argc, argv, 0, DEFAULT_STARTUP_RUNS, runs) ||
+        !ParseArgument(argc, argv, 1, DEFAULT_ITERATIONS, warmIterations)) {
+
+        std::wcerr << L"Invalid startup benchmark arguments" << std::endl;
+        return 1;
+    }
+    std::wstringstream commandLine;
+    commandLine << L'"' << p_ExePath << L"\" " << STARTUP_CHILD_SWITCH << L' ' << warmIterations;
+    if (argc > 2) {
+        commandLine << L" \"" << argv[2] << L'"';
+    }
+
+    std::wcout << runs << L" run(s), " << warmIterations << L" warm iteration(s)" << std::endl << std::endl;
+    HRESULT hRes = RunAndPrintStartupPass(L"Without persisted snapshots", commandLine.str(), runs, false);
+    if (SUCCEEDED(hRes)) {
+        std::wcout << std::endl;
+        hRes = RunAndPrintStartupPass(L"With persisted snapshots", commandLine.str(), runs, true);
+    }
+    return SUCCEEDED(hRes) ? 0 : 1;
+}
+
+//
+// Runs one iteration of the startup benchmark in this process, which must not
+// have loaded the PCC DLL yet. Called in a child process by RunStartupBenchmark
+// with the following arguments:
+//
+// PathCopyCopyBenchmarks.exe --startup-child warmIterations [folder]
+//
+// Prints the durations of all phases, in milliseconds, on a single line.
+//
+// @param p_DllPath Path to the PCC DLL to load.
+// @param argc Number of arguments received (excluding the --startup-child switch).
+// @param argv Array of arguments.
+// @return Process exit code.
+//
+int RunStartupBenchmarkChild(const std::wstring& p_DllPath,
+                             int argc,
+                             wchar_t* argv[])
+{
+    ULONG warmIterations = 0;
+    if (!ParseArgument(argc, argv, 0, DEFAULT_ITERATIONS, warmIterations) || warmIterations == 0) {
+        std::wcerr << L"Invalid startup benchmark arguments" << std::endl;
+        return 1;
+    }
+    std::wstring folder;
+    if (argc > 1) {
+        folder = argv[1];
+    } else {
+        std::vector<wchar_t> currentDirectory(MAX_PATH + 1);
+        folder.assign(currentDirectory.data(),
+                      ::GetCurrentDirectoryW(static_cast<DWORD>(currentDirectory.size()), currentDirectory.data()));
+    }
+    if (!folder.empty() && folder.back() != L'\\') {
+        folder += L'\\';
+    }
+
+    // Explorer initializes COM before loading extensions.
+    int exitCode = 1;
+    HRESULT hRes = ::CoInitialize(nullptr);
+    if (SUCCEEDED(hRes)) {
+        auto start = std::chrono::steady_clock::now();
+        HMODULE hDll = ::LoadLibraryW(p_DllPath.c_str());
+        const double load = ElapsedMilliseconds(start);
+        auto pDllGetClassObject = hDll != NULL
+            ? reinterpret_cast<DllGetClassObjectProc>(::GetProcAddress(hDll, DLL_GET_CLASS_OBJECT_NAME))
+            : nullptr;
+        if (pDllGetClassObject != nullptr) {
+            IClassFactory* pClassFactory = nullptr;
+            start = std::chrono::steady_clock::now();
+            hRes = pDllGetClassObject(__uuidof(PathCopyCopyContextMenuExt), IID_IClassFactory, reinterpret_cast<LPVOID*>(&pClassFactory));
+            const double getClassObject = ElapsedMilliseconds(start);
+            if (SUCCEEDED(hRes)) {
+                HDropDataObject* pDataObject = new HDropDataObject(GenerateSelection(hDll, folder, 1));
+                double createInstance = 0.0, initialize = 0.0, queryContextMenu = 0.0;
+                DurationsV vWarmInitialize, vWarmQueryContextMenu;
+                for (ULONG i = 0; SUCCEEDED(hRes) && i <= warmIterations; ++i) {
+                    IShellExtInit* pShellExtInit = nullptr;
+                    start = std::chrono::steady_clock::now();
+                    hRes = pClassFactory->CreateInstance(nullptr, IID_IShellExtInit, reinterpret_cast<void**>(&pShellExtInit));
+                    if (i == 0) {
+                        createInstance = ElapsedMilliseconds(start);
+                    }
+                    if (SUCCEEDED(hRes)) {
+                        start = std::chrono::steady_clock::now();
+                        hRes = pShellExtInit->Initialize(nullptr, pDataObject, NULL);
+                        const double initializeDuration = ElapsedMilliseconds(start);
+                        if (i == 0) {
+                            initialize = initializeDuration;
+                        } else {
+                            vWarmInitialize.push_back(initializeDuration);
+                        }
+
+                        IContextMenu* pContextMenu = nullptr;
+                        if (SUCCEEDED(hRes)) {
+                            hRes = pShellExtInit->QueryInterface(IID_IContextMenu, reinterpret_cast<void**>(&pContextMenu));
+                        }
+                        if (SUCCEEDED(hRes)) {
+                            HMENU hMenu = ::CreatePopupMenu();
+                            start = std::chrono::steady_clock::now();
+                            hRes = pContextMenu->QueryContextMenu(hMenu, 0, FIRST_CMD_ID, LAST_CMD_ID, CMF_NORMAL);
+                            const double queryContextMenuDuration = ElapsedMilliseconds(start);
+                            if (i == 0) {
+                                queryContextMenu = queryContextMenuDuration;
+                            } else {
+                                vWarmQueryContextMenu.push_back(queryContextMenuDuration);
+                            }
+                            ::DestroyMenu(hMenu);
+                            pContextMenu->Release();
+                        }
+                        pShellExtInit->Release();
+                    }
+                }
+                if (SUCCEEDED(hRes)) {
+                    std::wcout << std::fixed << std::setprecision(6)
+                               << load << L' ' << getClassObject << L' ' << createInstance << L' '
+                               << initialize << L' ' << queryContextMenu << L' '
+                               << Median(vWarmInitialize) << L' ' << Median(vWarmQueryContextMenu) << std::endl;
+                    exitCode = 0;
+                } else {
+                    std::wcerr << L"Startup benchmark failed: 0x" << std::hex << hRes << std::endl;
+                }
+
+                pDataObject->Release();
+                pClassFactory->Release();
+            } else {
+                std::wcerr << L"Could not get class factory: 0x" << std::hex << hRes << std::endl;
+            }
+        } else if (hDll != NULL) {
+            std::wcerr << L"DllGetClassObject not found" << std::endl;
+        } else {
+            std::wcerr << L"Could not load " << p_DllPath << std::endl;
+        }
+        ::CoUninitialize();
+        if (hDll != NULL) {
+            ::FreeLibrary(hDll);
+        }
+    }
+    return exitCode;
+}
+
+//
+// Runs the multi-threaded contention benchmark of the shell extension. Call like this:
+//
+// PathCopyCopyBenchmarks.exe --contention [maxThreads] [iterations] [selectionSize] [folder]
+//
+// Builds and invokes contextual menus concurrently on 1, 2, 4... threads, up
+// to the given maximum (by default, the number of processors). Each thread
+// uses its own extensions, like Explorer windows do, so that threads only
+// compete for the caches shared by all extensions. For each pass, prints the
+// throughput compared to linear scaling, the latency of each phase and, if
+// exported by the DLL, how often each shared lock had to be waited for and
+// for how long (see GetLockStatisticsW). Selected files are in the given
+// folder, like for RunShellExtensionHarness.
+// Note that invoking commands copies paths to the clipboard.
+//
+// @param p_hDll Handle of the loaded PCC DLL.
+// @param argc Number of benchmark arguments received (excluding the --contention switch).
+// @param argv Array of benchmark arguments.
+// @return Process exit code.
+//
+int RunContentionBenchmark(HMODULE p_hDll,
+                           int argc,
+                           wchar_t* argv[])
+{
+    SYSTEM_INFO systemInfo = { 0 };
+    ::GetSystemInfo(&systemInfo);
+    ULONG maxThreads = 0, iterations = 0, selectionSize = 0;
+    if (!ParseArgument(argc, argv, 0, systemInfo.dwNumberOfProcessors, maxThreads) ||
+        !ParseArgument(argc, argv, 1, DEFAULT_ITERATIONS, iterations) ||
+        !ParseArgument(argc, argv, 2, DEFAULT_SELECTION_SIZE, selectionSize) ||
+        maxThreads == 0) {
+
+        std::wcerr << L"Invalid contention benchmark arguments" << std::endl;
+        return 1;
+    }
+    std::wstring folder;
+    if (argc > 3) {
+        folder = argv[3];
+    } else {
+        std::vector<wchar_t> currentDirectory(MAX_PATH + 1);
+        folder.assign(currentDirectory.data(),
+                      ::GetCurrentDirectoryW(static_cast<DWORD>(currentDirectory.size()), currentDirectory.data()));
+    }
+    if (!folder.empty() && folder.back() != L'\\') {
+        folder += L'\\';
+    }
+
+    auto pDllGetClassObject = reinterpret_cast<DllGetClassObjectProc>(::GetProcAddress(p_hDll, DLL_GET_CLASS_OBJECT_NAME));
+    if (pDllGetClassObject == nullptr) {
+        std::wcerr << L"DllGetClassObject not found" << std::endl;
+        return 1;
+    }
+
+    // Only exported by recent DLLs.
+    auto pGetLockStatistics = reinterpret_cast<GetLockStatisticsProc>(::GetProcAddress(p_hDll, GET_LOCK_STATISTICS_NAME));
+
+    const std::vector<std::wstring> vFiles = GenerateSelection(p_hDll, folder, selectionSize);
+    std::wcout << L"Selection of " << selectionSize << L" file(s), " << iterations
+               << L" iteration(s) per thread, up to " << maxThreads << L" thread(s)" << std::endl;
+    ::SetEnvironmentVariableW(TEST_PLUGINS_DELAY_ENV_VAR_NAME, nullptr);
+    HRESULT hRes = S_OK;
+    double singleThreadThroughput = 0.0;
+    ULONG threads = 1;
+    for (;;) {
+        std::wcout << std::endl;
+        hRes = RunAndPrintContentionPass(pDllGetClassObject, pGetLockStatistics, vFiles,
+                                         threads, iterations, singleThreadThroughput);
+        if (FAILED(hRes) || threads == maxThreads) {
+            break;
+        }
+        threads = (std::min)(threads * 2, maxThreads);
+    }
+    return SUCCEEDED(hRes) ? 0 : 1;
+}
@@ -0,0 +1,178 @@
+// PathCopyCopyCLI.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "stdafx.h"
+
+
+namespace
+{
+    // Names of the PCC DLL to use, as built and as installed by the setup.
+    // It must be in the same folder as this executable.
+    const wchar_t* const    PCC_DLL_NAME            = L"PathCopyCopy.dll";
+#ifdef _WIN64
+    const wchar_t* const    PCC_INSTALLED_DLL_NAME  = L"PCC64.dll";
+#else
+    const wchar_t* const    PCC_INSTALLED_DLL_NAME  = L"PCC32.dll";
+#endif
+
+    // Command-line switches.
+    const wchar_t* const    INPUT_SWITCH            = L"--input";
+    const wchar_t* const    SEPARATOR_SWITCH        = L"--separator";
+
+    // Default separator written after each converted path.
+    const wchar_t* const    DEFAULT_SEPARATOR       = L"\r\n";
+
+    // Exit codes.
+    const int               EXIT_CODE_SUCCESS       = 0;
+    const int               EXIT_CODE_ERROR         = 1;
+    const int               EXIT_CODE_USAGE         = 2;
+    const int               EXIT_CODE_NO_PLUGIN     = 3;
+
+    //
+    // Replaces escape sequences in a separator passed on the command line
+    // by the characters they represent. Supports \n, \r, \t and \\.
+    //
+    // @param p_Separator Separator to unescape.
+    // @return Unescaped separator.
+    //
+    std::wstring UnescapeSeparator(const std::wstring& p_Separator)
+    {
+        std::wstring separator;
+        separator.reserve(p_Separator.size());
+        for (size_t i = 0; i < p_Separator.size(); ++i) {
+            wchar_t c = p_Separator[i];
+            if (c == L'\\' && i + 1 < p_Separator.size()) {
+                switch (p_Separator[i + 1]) {
+                    case L'n':  c = L'\n'; ++i; break;
+                    case L'r':  c = L'\r'; ++i; break;
+                    case L't':  c = L'\t'; ++i; break;
+                    case L'\\': c = L'\\'; ++i; break;
+                    default:    break;
+                }
+            }
+            separator += c;
+        }
+        return separator;
+    }
+
+    //
+    // Prints usage information to the standard error.
+    //
+    void PrintUsage()
+    {
+        std::wcerr << L"Usage: pcc.exe <plugin> [" << INPUT_SWITCH << L" <file>] ["
+                   << SEPARATOR_SWITCH << L" <separator>]" << std::endl
+                   << std::endl
+                   << L"Converts paths read from the standard input (or from a file), one per line," << std::endl
+                   << L"and writes the results to the standard output, each one followed by the" << std::endl
+                   << L"separator (by default, a newline). <plugin> is the plugin's ID or its name" << std::endl
+                   << L"as shown in the contextual menu. The separator can contain \\n, \\r and \\t." << std::endl;
+    }
+
+} // anonymous namespace
+
+//
+// Main program entry point. Loads the PCC DLL found next to the executable
+// and uses it to convert paths in a streaming fashion. Call like this:
+//
+// pcc.exe <plugin> [--input <file>] [--separator <separator>]
+//
+// See PrintUsage for details.
+//
+// @param argc Number of command-line arguments received
+// @param argv Array of command-line arguments
+// @return Process exit code
+//
+int wmain(int argc, wchar_t* argv[])
+{
+    // Parse command line.
+    std::wstring plugin, inputFile;
+    std::wstring separator = DEFAULT_SEPARATOR;
+    for (int i = 1; i < argc; ++i) {
+        const std::wstring arg(argv[i]);
+        if (arg == INPUT_SWITCH && i + 1 < argc) {
+            inputFile = argv[++i];
+        } else if (arg == SEPARATOR_SWITCH && i + 1 < argc) {
+            separator = UnescapeSeparator(argv[++i]);
+        } else if (plugin.empty() && !arg.empty() && arg[0] != L'-') {
+            plugin = arg;
+        } else {
+            PrintUsage();
+            return EXIT_CODE_USAGE;
+        }
+    }
+    if (plugin.empty()) {
+        PrintUsage();
+        return EXIT_CODE_USAGE;
+    }
+
+    // Open input.
+    HANDLE hInput = ::GetStdHandle(STD_INPUT_HANDLE);
+    if (!inputFile.empty()) {
+        hInput = ::CreateFileW(inputFile.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                               OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (hInput == INVALID_HANDLE_VALUE) {
+            std::wcerr << L"Could not open " << inputFile << std::endl;
+            return EXIT_CODE_ERROR;
+        }
+    }
+
+    // Load the DLL from our own folder so that we use the matching build.
+    std::vector<wchar_t> modulePath(MAX_PATH + 1);
+    DWORD modulePathSize = ::GetModuleFileNameW(nullptr, modulePath.data(), static_cast<DWORD>(modulePath.size()));
+    std::wstring dllPath(modulePath.data(), modulePathSize);
+    dllPath.erase(dllPath.find_last_of(L'\\') + 1);
+    const std::wstring dllFolder = dllPath;
+    dllPath += PCC_DLL_NAME;
+    HMODULE hDll = ::LoadLibraryW(dllPath.c_str());
+    if (hDll == NULL) {
+        dllPath = dllFolder + PCC_INSTALLED_DLL_NAME;
+        hDll = ::LoadLibraryW(dllPath.c_str());
+    }
+    if (hDll == NULL) {
+        std::wcerr << L"Could not load " << dllPath << std::endl;
+        return EXIT_CODE_ERROR;
+    }
+
+    int exitCode = EXIT_CODE_ERROR;
+    typedef HRESULT (WINAPI* ConvertPathStreamProc)(LPCWSTR, HANDLE, HANDLE, LPCWSTR);
+    auto pConvertPathStream = reinterpret_cast<ConvertPathStreamProc>(::GetProcAddress(hDll, "ConvertPathStreamW"));
+    if (pConvertPathStream != nullptr) {
+        const HRESULT hRes = pConvertPathStream(plugin.c_str(), hInput, ::GetStdHandle(STD_OUTPUT_HANDLE), separator.c_str());
+        if (SUCCEEDED(hRes)) {
+            exitCode = EXIT_CODE_SUCCESS;
+        } else if (hRes == HRESULT_FROM_WIN32(ERROR_NOT_FOUND)) {
+            std::wcerr << L"Plugin not found: " << plugin << std::endl;
+            exitCode = EXIT_CODE_NO_PLUGIN;
+        } else {
+            std::wcerr << L"Conversion failed: 0x" << std::hex << hRes << std::endl;
+        }
+    } else {
+        std::wcerr << L"ConvertPathStreamW not found in " << dllPath << std::endl;
+    }
+
+    ::FreeLibrary(hDll);
+    if (!inputFile.empty()) {
+        ::CloseHandle(hInput);
+    }
+    return exitCode;
+}
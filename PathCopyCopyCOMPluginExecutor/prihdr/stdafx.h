@@ -29,6 +29,7 @@
 #define _ATL_CSTRING_EXPLICIT_CONSTRUCTORS      // some CString constructors will be explicit
 
 #include <atlbase.h>
+#include <atlsafe.h>
 #include <atlstr.h>
 #include <windows.h>
 
@@ -37,7 +38,9 @@
 #include <assert.h>
 
 #include <iostream>
+#include <map>
 #include <string>
 #include <sstream>
+#include <vector>
 
 #include <resource.h>
@@ -21,10 +21,40 @@
 
 #include "stdafx.h"
 
+#include <COMPluginHostMessage.h>
 #include <StCoInitialize.h>
 #include <PathCopyCopy_i.h>
 
 
+// Predicate used to store CLSIDs in maps.
+struct CLSIDLess {
+    bool operator()(const CLSID& p_Left, const CLSID& p_Right) const {
+        return ::memcmp(&p_Left, &p_Right, sizeof(CLSID)) < 0;
+    }
+};
+
+// Map of plugins loaded in host mode, per CLSID.
+typedef std::map<CLSID, ATL::CComPtr<IPathCopyCopyPlugin>, CLSIDLess> PluginM;
+
+// Size of chunks used to read requests in host mode.
+const DWORD HOST_READ_CHUNK_SIZE = 64 * 1024;
+
+// Command-line switch used to launch the program in server mode.
+const wchar_t* const SERVER_SWITCH = L"/server";
+
+// Command returning all plugin properties at once, one output line per property.
+const wchar_t* const GET_ALL_COMMAND = L"get_All";
+
+// Commands executed by GET_ALL_COMMAND, in output order.
+const wchar_t* const GET_ALL_SUBCOMMANDS[] = {
+    L"get_Description",
+    L"get_HelpText",
+    L"get_GroupId",
+    L"get_GroupPosition",
+    L"get_IconFile",
+    L"get_UseDefaultIcon",
+};
+
 // Functions in this file
 int GetDescription(IPathCopyCopyPlugin* p_pPlugin, std::wstring& p_rOutput);
 int GetHelpText(IPathCopyCopyPlugin* p_pPlugin, std::wstring& p_rOutput);
@@ -32,17 +62,37 @@ int GetGroupId(IPathCopyCopyPlugin* p_pPlugin, std::wstring& p_rOutput);
 int GetGroupPosition(IPathCopyCopyPlugin* p_pPlugin, std::wstring& p_rOutput);
 int GetIconFile(IPathCopyCopyPlugin* p_pPlugin, std::wstring& p_rOutput);
 int GetUseDefaultIcon(IPathCopyCopyPlugin* p_pPlugin, std::wstring& p_rOutput);
+int ExecuteCommand(IPathCopyCopyPlugin* p_pPlugin, const std::wstring& p_Command, std::wstring& p_rOutput);
+int RunServer();
+int RunHost(const wchar_t* p_pPipeName);
+bool ReadHostRequest(HANDLE p_hPipe, std::vector<BYTE>& p_rvRequest);
+void ExecuteHostRequest(COMPluginHostMessage& p_rRequest, COMPluginHostMessage& p_rResponse, PluginM& p_rmPlugins);
+HRESULT HostGetMetadata(IPathCopyCopyPlugin* p_pPlugin, COMPluginHostMessage& p_rResponse);
+HRESULT HostGetHelpText(IPathCopyCopyPlugin* p_pPlugin, COMPluginHostMessage& p_rResponse);
+HRESULT HostEnabled(IPathCopyCopyPlugin* p_pPlugin, COMPluginHostMessage& p_rRequest, COMPluginHostMessage& p_rResponse);
+HRESULT HostGetPaths(IPathCopyCopyPlugin* p_pPlugin, COMPluginHostMessage& p_rRequest, COMPluginHostMessage& p_rResponse);
 
 
 //
 // Main program entry point.
 //
+// If launched with "/host <pipe name>", runs in host mode (see RunHost).
+// If launched with "/server", runs in server mode (see RunServer).
+// Otherwise, reads a plugin ID and command from standard input.
+//
 // @param argc Number of command-line arguments received
 // @param argv Array of command-line arguments
 // @return Process exit code
 //
-int wmain(int /*argc*/, wchar_t* /*argv*/[])
+int wmain(int argc, wchar_t* argv[])
 {
+    if (argc == 3 && ::wcscmp(argv[1], COMPluginHostMessage::HostSwitch()) == 0) {
+        return RunHost(argv[2]);
+    }
+    if (argc == 2 && ::wcscmp(argv[1], SERVER_SWITCH) == 0) {
+        return RunServer();
+    }
+
     // Assume we'll fail.
     int retVal = -1;
 
@@ -67,23 +117,9 @@ int wmain(int /*argc*/, wchar_t* /*argv*/[])
             ATL::CComPtr<IPathCopyCopyPlugin> cpPlugin;
             hRes = cpPlugin.CoCreateInstance(pluginId);
             if (SUCCEEDED(hRes)) {
-                // Check the command.
+                // Execute the command.
                 std::wstring output;
-                if (command == L"get_Description") {
-                    retVal = GetDescription(cpPlugin, output);
-                } else if (command == L"get_HelpText") {
-                    retVal = GetHelpText(cpPlugin, output);
-                } else if (command == L"get_GroupId") {
-                    retVal =  GetGroupId(cpPlugin, output);
-                } else if (command == L"get_GroupPosition") {
-                    retVal = GetGroupPosition(cpPlugin, output);
-                } else if (command == L"get_IconFile") {
-                    retVal = GetIconFile(cpPlugin, output);
-                } else if (command == L"get_UseDefaultIcon") {
-                    retVal = GetUseDefaultIcon(cpPlugin, output);
-                } else {
-                    std::wcout << L"ERROR! Invalid command: " << command << std::endl;
-                }
+                retVal = ExecuteCommand(cpPlugin, command, output);
 
                 // If everything went fine, write output.
                 if (retVal >= 0) {
@@ -102,6 +138,93 @@ int wmain(int /*argc*/, wchar_t* /*argv*/[])
 	return retVal;
 }
 
+//
+// Executes a single command on a COM plugin. If the command is invalid,
+// outputs an error.
+//
+// @param p_pPlugin Plugin to query.
+// @param p_Command Command to execute.
+// @param p_rOutput Where to store output.
+// @return Result code to return as program exit code.
+//
+int ExecuteCommand(IPathCopyCopyPlugin* p_pPlugin, const std::wstring& p_Command, std::wstring& p_rOutput)
+{
+    int retVal = -1;
+    if (p_Command == L"get_Description") {
+        retVal = GetDescription(p_pPlugin, p_rOutput);
+    } else if (p_Command == L"get_HelpText") {
+        retVal = GetHelpText(p_pPlugin, p_rOutput);
+    } else if (p_Command == L"get_GroupId") {
+        retVal =  GetGroupId(p_pPlugin, p_rOutput);
+    } else if (p_Command == L"get_GroupPosition") {
+        retVal = GetGroupPosition(p_pPlugin, p_rOutput);
+    } else if (p_Command == L"get_IconFile") {
+        retVal = GetIconFile(p_pPlugin, p_rOutput);
+    } else if (p_Command == L"get_UseDefaultIcon") {
+        retVal = GetUseDefaultIcon(p_pPlugin, p_rOutput);
+    } else {
+        std::wcout << L"ERROR! Invalid command: " << p_Command << std::endl;
+    }
+    return retVal;
+}
+
+//
+// Runs in server mode: reads pairs of lines (plugin ID and command) from
+// standard input until an empty plugin ID or the end of input is reached.
+// Each command outputs one "Output:" line or one "ERROR!" line, except for
+// get_All, which outputs one "Output:" line per property of the plugin
+// (see GET_ALL_SUBCOMMANDS). Plugins are created on first use and kept alive.
+//
+// @return Result code to return as program exit code.
+//
+int RunServer()
+{
+    StCoInitialize initCom;
+    if (FAILED(initCom.GetInitResult())) {
+        std::wcout << L"ERROR! Could not initialize COM: 0x" << std::hex << initCom.GetInitResult() << std::endl;
+        return -1;
+    }
+
+    PluginM mPlugins;
+    std::wstring pluginIdString, command;
+    while (std::getline(std::wcin, pluginIdString) && !pluginIdString.empty() && std::getline(std::wcin, command)) {
+        // Convert the plugin ID to a CLSID.
+        CLSID pluginId = { 0 };
+        HRESULT hRes = ::CLSIDFromString(pluginIdString.c_str(), &pluginId);
+        if (FAILED(hRes)) {
+            std::wcout << L"ERROR! Invalid plugin ID: 0x" << std::hex << hRes << std::dec << std::endl;
+            continue;
+        }
+
+        // Create the COM plugin if it's the first time we use it.
+        ATL::CComPtr<IPathCopyCopyPlugin>& rcpPlugin = mPlugins[pluginId];
+        if (rcpPlugin == NULL) {
+            hRes = rcpPlugin.CoCreateInstance(pluginId);
+            if (FAILED(hRes)) {
+                mPlugins.erase(pluginId);
+                std::wcout << L"ERROR! Failed to create plugin: 0x" << std::hex << hRes << std::dec << std::endl;
+                continue;
+            }
+        }
+
+        // Execute the command(s).
+        if (command == GET_ALL_COMMAND) {
+            for (const wchar_t* const subcommand : GET_ALL_SUBCOMMANDS) {
+                std::wstring output;
+                ExecuteCommand(rcpPlugin, subcommand, output);
+                std::wcout << L"Output: " << output << std::endl;
+            }
+        } else {
+            std::wstring output;
+            if (ExecuteCommand(rcpPlugin, command, output) >= 0) {
+                std::wcout << L"Output: " << output << std::endl;
+            }
+        }
+    }
+
+    return 0;
+}
+
 //
 // Called to get the description for a COM plugin. Command: get_Description
 //
@@ -249,3 +372,331 @@ int GetUseDefaultIcon(IPathCopyCopyPlugin* p_pPlugin, std::wstring& p_rOutput)
     
     return 0;
 }
+
+//
+// Runs in host mode: connects to the given named pipe created by Path Copy Copy
+// and executes requests received until the pipe is closed. Plugins are created
+// on first use and kept alive for subsequent requests.
+//
+// @param p_pPipeName Name of pipe to connect to.
+// @return Result code to return as program exit code.
+//
+int RunHost(const wchar_t* p_pPipeName)
+{
+    assert(p_pPipeName != nullptr);
+
+    StCoInitialize initCom;
+    if (FAILED(initCom.GetInitResult())) {
+        return -1;
+    }
+
+    ATL::CHandle hPipe(::CreateFileW(p_pPipeName, GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, 0, nullptr));
+    if (hPipe == INVALID_HANDLE_VALUE) {
+        hPipe.Detach();
+        return -1;
+    }
+    DWORD pipeMode = PIPE_READMODE_MESSAGE;
+    if (!::SetNamedPipeHandleState(hPipe, &pipeMode, nullptr, nullptr)) {
+        return -1;
+    }
+
+    // Serve requests until Path Copy Copy closes its end of the pipe.
+    PluginM mPlugins;
+    std::vector<BYTE> vRequest;
+    while (ReadHostRequest(hPipe, vRequest)) {
+        COMPluginHostMessage request(std::move(vRequest));
+        COMPluginHostMessage response;
+        ExecuteHostRequest(request, response, mPlugins);
+
+        const std::vector<BYTE>& vResponse = response.Data();
+        DWORD written = 0;
+        if (!::WriteFile(hPipe, vResponse.data(), static_cast<DWORD>(vResponse.size()), &written, nullptr)) {
+            break;
+        }
+        vRequest = std::vector<BYTE>();
+    }
+
+    return 0;
+}
+
+//
+// Reads an entire request message from the host pipe.
+//
+// @param p_hPipe Handle to pipe.
+// @param p_rvRequest Where to store request data.
+// @return true if a request was read, false if pipe was closed.
+//
+bool ReadHostRequest(HANDLE p_hPipe, std::vector<BYTE>& p_rvRequest)
+{
+    p_rvRequest.clear();
+    for (;;) {
+        const size_t offset = p_rvRequest.size();
+        p_rvRequest.resize(offset + HOST_READ_CHUNK_SIZE);
+        DWORD read = 0;
+        const BOOL success = ::ReadFile(p_hPipe, &p_rvRequest[offset], HOST_READ_CHUNK_SIZE, &read, nullptr);
+        p_rvRequest.resize(offset + read);
+        if (success) {
+            return true;
+        }
+        if (::GetLastError() != ERROR_MORE_DATA) {
+            return false;
+        }
+    }
+}
+
+//
+// Executes a request received in host mode. See COMPluginHostMessage for format.
+//
+// @param p_rRequest Request to execute.
+// @param p_rResponse Where to write response.
+// @param p_rmPlugins Map of plugins created so far.
+//
+void ExecuteHostRequest(COMPluginHostMessage& p_rRequest, COMPluginHostMessage& p_rResponse, PluginM& p_rmPlugins)
+{
+    // Build response separately since result code comes first.
+    COMPluginHostMessage results;
+    DWORD command = 0;
+    CLSID pluginId = { 0 };
+    HRESULT hRes = E_INVALIDARG;
+    if (p_rRequest.ReadDWORD(command) && p_rRequest.ReadGUID(pluginId)) {
+        // Create plugin if it's the first time we use it.
+        ATL::CComPtr<IPathCopyCopyPlugin>& rcpPlugin = p_rmPlugins[pluginId];
+        hRes = S_OK;
+        if (rcpPlugin == NULL) {
+            hRes = rcpPlugin.CoCreateInstance(pluginId);
+            if (SUCCEEDED(hRes) && rcpPlugin == NULL) {
+                hRes = E_FAIL;
+            }
+            if (FAILED(hRes)) {
+                p_rmPlugins.erase(pluginId);
+            }
+        }
+
+        if (SUCCEEDED(hRes)) {
+            IPathCopyCopyPlugin* pPlugin = rcpPlugin;
+            switch (command) {
+                case COMPluginHostMessage::GetMetadata: {
+                    hRes = HostGetMetadata(pPlugin, results);
+                    break;
+                }
+                case COMPluginHostMessage::GetHelpText: {
+                    hRes = HostGetHelpText(pPlugin, results);
+                    break;
+                }
+                case COMPluginHostMessage::Enabled: {
+                    hRes = HostEnabled(pPlugin, p_rRequest, results);
+                    break;
+                }
+                case COMPluginHostMessage::GetPaths: {
+                    hRes = HostGetPaths(pPlugin, p_rRequest, results);
+                    break;
+                }
+                default: {
+                    hRes = E_NOTIMPL;
+                    break;
+                }
+            }
+        }
+    }
+
+    p_rResponse.WriteDWORD(static_cast<DWORD>(hRes));
+    if (SUCCEEDED(hRes)) {
+        p_rResponse.Append(results);
+    }
+}
+
+//
+// Returns the metadata of a plugin in host mode. Command: GetMetadata
+//
+// @param p_pPlugin Plugin to query.
+// @param p_rResponse Where to write results.
+// @return Result code.
+//
+HRESULT HostGetMetadata(IPathCopyCopyPlugin* p_pPlugin, COMPluginHostMessage& p_rResponse)
+{
+    assert(p_pPlugin != nullptr);
+
+    // Description is mandatory.
+    ATL::CComBSTR bstrDescription;
+    HRESULT hRes = p_pPlugin->get_Description(&bstrDescription);
+    if (FAILED(hRes)) {
+        return hRes;
+    }
+    if (bstrDescription == NULL || bstrDescription.Length() == 0) {
+        return E_UNEXPECTED;
+    }
+
+    // Other info is optional; keep defaults if not supported.
+    ULONG groupId = 0, groupPos = 0;
+    ATL::CComQIPtr<IPathCopyCopyPluginGroupInfo> cpPluginGroupInfo(p_pPlugin);
+    if (cpPluginGroupInfo.p != nullptr) {
+        if (FAILED(cpPluginGroupInfo->get_GroupId(&groupId))) {
+            groupId = 0;
+        }
+        if (FAILED(cpPluginGroupInfo->get_GroupPosition(&groupPos))) {
+            groupPos = 0;
+        }
+    }
+    ATL::CComBSTR bstrIconFile;
+    VARIANT_BOOL useDefaultIconVar = VARIANT_FALSE;
+    ATL::CComQIPtr<IPathCopyCopyPluginIconInfo> cpPluginIconInfo(p_pPlugin);
+    if (cpPluginIconInfo.p != nullptr) {
+        if (FAILED(cpPluginIconInfo->get_IconFile(&bstrIconFile))) {
+            bstrIconFile.Empty();
+        }
+        if (FAILED(cpPluginIconInfo->get_UseDefaultIcon(&useDefaultIconVar))) {
+            useDefaultIconVar = VARIANT_FALSE;
+        }
+    }
+    ULONG enabledScope = 0;
+    ATL::CComQIPtr<IPathCopyCopyPluginStateScope> cpPluginStateScope(p_pPlugin);
+    if (cpPluginStateScope.p != nullptr) {
+        if (FAILED(cpPluginStateScope->get_EnabledScope(&enabledScope))) {
+            enabledScope = 0;
+        }
+    }
+    ULONG pathCacheTimeToLive = 0;
+    ATL::CComQIPtr<IPathCopyCopyPluginPathCaching> cpPluginPathCaching(p_pPlugin);
+    if (cpPluginPathCaching.p != nullptr) {
+        if (FAILED(cpPluginPathCaching->get_PathCacheTimeToLive(&pathCacheTimeToLive))) {
+            pathCacheTimeToLive = 0;
+        }
+    }
+
+    p_rResponse.WriteString(bstrDescription.m_str, bstrDescription.Length())
+               .WriteDWORD(groupId)
+               .WriteDWORD(groupPos)
+               .WriteString(bstrIconFile.m_str, bstrIconFile.Length())
+               .WriteDWORD(useDefaultIconVar != VARIANT_FALSE ? 1 : 0)
+               .WriteDWORD(enabledScope)
+               .WriteDWORD(pathCacheTimeToLive);
+    return S_OK;
+}
+
+//
+// Returns the help text of a plugin in host mode. Command: GetHelpText
+//
+// @param p_pPlugin Plugin to query.
+// @param p_rResponse Where to write results.
+// @return Result code.
+//
+HRESULT HostGetHelpText(IPathCopyCopyPlugin* p_pPlugin, COMPluginHostMessage& p_rResponse)
+{
+    assert(p_pPlugin != nullptr);
+
+    ATL::CComBSTR bstrHelpText;
+    HRESULT hRes = p_pPlugin->get_HelpText(&bstrHelpText);
+    if (SUCCEEDED(hRes)) {
+        p_rResponse.WriteString(bstrHelpText.m_str, bstrHelpText.Length());
+    }
+    return hRes;
+}
+
+//
+// Checks if a plugin should be enabled in host mode. Command: Enabled
+//
+// @param p_pPlugin Plugin to query.
+// @param p_rRequest Request containing arguments.
+// @param p_rResponse Where to write results.
+// @return Result code.
+//
+HRESULT HostEnabled(IPathCopyCopyPlugin* p_pPlugin, COMPluginHostMessage& p_rRequest, COMPluginHostMessage& p_rResponse)
+{
+    assert(p_pPlugin != nullptr);
+
+    std::wstring parentPath, file;
+    if (!p_rRequest.ReadString(parentPath) || !p_rRequest.ReadString(file)) {
+        return E_INVALIDARG;
+    }
+
+    // Plugins that do not support state changes are always enabled.
+    // If an error code is returned, do not enable the plugin.
+    bool enabled = true;
+    ATL::CComQIPtr<IPathCopyCopyPluginStateInfo> cpPluginStateInfo(p_pPlugin);
+    if (cpPluginStateInfo.p != nullptr) {
+        ATL::CComBSTR bstrParentPath(parentPath.c_str());
+        ATL::CComBSTR bstrFile(file.c_str());
+        VARIANT_BOOL enabledVar = VARIANT_FALSE;
+        HRESULT hRes = cpPluginStateInfo->Enabled(bstrParentPath, bstrFile, &enabledVar);
+        enabled = SUCCEEDED(hRes) && hRes != S_FALSE && enabledVar != VARIANT_FALSE;
+    }
+
+    p_rResponse.WriteDWORD(enabled ? 1 : 0);
+    return S_OK;
+}
+
+//
+// Transforms paths using a plugin in host mode. Command: GetPaths
+// Uses the plugin's batch interface if supported.
+//
+// @param p_pPlugin Plugin to use.
+// @param p_rRequest Request containing arguments.
+// @param p_rResponse Where to write results.
+// @return Result code.
+//
+HRESULT HostGetPaths(IPathCopyCopyPlugin* p_pPlugin, COMPluginHostMessage& p_rRequest, COMPluginHostMessage& p_rResponse)
+{
+    assert(p_pPlugin != nullptr);
+
+    DWORD numFiles = 0;
+    if (!p_rRequest.ReadDWORD(numFiles)) {
+        return E_INVALIDARG;
+    }
+    std::vector<std::wstring> vFiles(numFiles);
+    for (std::wstring& file : vFiles) {
+        if (!p_rRequest.ReadString(file)) {
+            return E_INVALIDARG;
+        }
+    }
+
+    // Try batch interface first. If not supported, go file by file.
+    std::vector<std::wstring> vPaths;
+    HRESULT hRes = E_NOTIMPL;
+    ATL::CComQIPtr<IPathCopyCopyPluginBatch> cpPluginBatch(p_pPlugin);
+    if (cpPluginBatch.p != nullptr && numFiles > 1) {
+        ATL::CComSafeArray<BSTR> saFiles(numFiles);
+        for (DWORD i = 0; i < numFiles; ++i) {
+            saFiles.SetAt(static_cast<LONG>(i), ATL::CComBSTR(vFiles[i].c_str()).Detach(), FALSE);
+        }
+        SAFEARRAY* pNewPaths = nullptr;
+        hRes = cpPluginBatch->GetPaths(saFiles, &pNewPaths);
+        if (SUCCEEDED(hRes)) {
+            ATL::CComSafeArray<BSTR> saNewPaths;
+            if (pNewPaths == nullptr || FAILED(saNewPaths.Attach(pNewPaths))) {
+                if (pNewPaths != nullptr) {
+                    ::SafeArrayDestroy(pNewPaths);
+                }
+                return E_UNEXPECTED;
+            }
+            if (saNewPaths.GetCount() != numFiles) {
+                return E_UNEXPECTED;
+            }
+            const LONG lowerBound = saNewPaths.GetLowerBound();
+            for (DWORD i = 0; i < numFiles; ++i) {
+                BSTR bstrNewPath = saNewPaths.GetAt(lowerBound + static_cast<LONG>(i));
+                vPaths.push_back(bstrNewPath != NULL && ::SysStringLen(bstrNewPath) > 0
+                                 ? std::wstring(bstrNewPath, ::SysStringLen(bstrNewPath)) : vFiles[i]);
+            }
+        }
+    }
+    if (hRes == E_NOTIMPL) {
+        hRes = S_OK;
+        for (const std::wstring& file : vFiles) {
+            ATL::CComBSTR bstrPath(file.c_str());
+            ATL::CComBSTR bstrNewPath;
+            hRes = p_pPlugin->GetPath(bstrPath, &bstrNewPath);
+            if (FAILED(hRes)) {
+                break;
+            }
+            vPaths.push_back(bstrNewPath != NULL && bstrNewPath.Length() > 0 ? std::wstring(bstrNewPath.m_str) : file);
+        }
+    }
+
+    if (SUCCEEDED(hRes)) {
+        p_rResponse.WriteDWORD(static_cast<DWORD>(vPaths.size()));
+        for (const std::wstring& path : vPaths) {
+            p_rResponse.WriteString(path);
+        }
+    }
+    return hRes;
+}
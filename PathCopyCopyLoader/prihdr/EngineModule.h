@@ -0,0 +1,60 @@
+// EngineModule.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include <mutex>
+
+#include <windows.h>
+
+
+namespace PCC
+{
+    //
+    // EngineModule
+    //
+    // Static class that owns the Path Copy Copy engine DLL, which contains the
+    // actual shell extensions along with plugins, settings and everything they
+    // need. The engine is loaded from our own folder the first time one of its
+    // objects is needed, and freed when the shell asks whether we can be unloaded
+    // and the engine agrees.
+    //
+    class EngineModule final
+    {
+    public:
+                        EngineModule() = delete;
+                        ~EngineModule() = delete;
+
+        static HRESULT  CreateInstance(REFCLSID p_CLSID,
+                                       REFIID p_IID,
+                                       void** p_ppObject);
+        static HRESULT  CanUnloadNow();
+        static bool     IsLoaded();
+
+    private:
+        static HMODULE  s_hEngine;          // Handle of the engine DLL, if loaded.
+        static std::mutex
+                        s_Lock;             // Lock protecting the engine handle.
+
+        static HMODULE  LoadEngine();
+    };
+
+} // namespace PCC
@@ -0,0 +1,121 @@
+// PathCopyCopyContextMenuExtLoader.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include <PathCopyCopy_i.h>
+#include "resource.h"
+
+#include <atlbase.h>
+#include <atlcom.h>
+#include <shlobj.h>
+#include <windows.h>
+
+
+//
+// CPathCopyCopyContextMenuExtLoader
+//
+// Lightweight stand-in for the engine's CPathCopyCopyContextMenuExt, registered
+// under its CLSID. The shell creates and initializes contextual menu handlers in
+// every process that shows a file menu, even when the menu is only built to find
+// the default verb. Unless the engine is already loaded, we only remember how we
+// were initialized and create the engine's object once our items are actually
+// needed; calls are then forwarded.
+//
+class ATL_NO_VTABLE CPathCopyCopyContextMenuExtLoader :
+    public ATL::CComObjectRootEx<ATL::CComSingleThreadModel>,
+    public ATL::CComCoClass<CPathCopyCopyContextMenuExtLoader, &__uuidof(PathCopyCopyContextMenuExt)>,
+    public IPathCopyCopyContextMenuExt2,
+    public IShellExtInit,
+    public IContextMenu3
+{
+public:
+    CPathCopyCopyContextMenuExtLoader();
+    ~CPathCopyCopyContextMenuExtLoader();
+
+    DECLARE_REGISTRY_RESOURCEID(IDR_PATHCOPYCOPYCONTEXTMENUEXT)
+
+    DECLARE_NOT_AGGREGATABLE(CPathCopyCopyContextMenuExtLoader)
+
+    BEGIN_COM_MAP(CPathCopyCopyContextMenuExtLoader)
+        COM_INTERFACE_ENTRY(IPathCopyCopyContextMenuExt)
+        COM_INTERFACE_ENTRY(IPathCopyCopyContextMenuExt2)
+        COM_INTERFACE_ENTRY(IShellExtInit)
+        COM_INTERFACE_ENTRY(IContextMenu)
+        COM_INTERFACE_ENTRY(IContextMenu2)
+        COM_INTERFACE_ENTRY(IContextMenu3)
+    END_COM_MAP()
+
+    DECLARE_PROTECT_FINAL_CONSTRUCT()
+
+    HRESULT FinalConstruct()
+    {
+        return S_OK;
+    }
+
+    void FinalRelease()
+    {
+    }
+
+public:
+    // IPathCopyCopyContextMenuExt methods
+    STDMETHOD(RegisterPlugin)(REFCLSID p_CLSID);
+    STDMETHOD(UnregisterPlugin)(REFCLSID p_CLSID);
+
+    // IPathCopyCopyContextMenuExt2 methods
+    STDMETHOD(RegisterPlugin2)(REFCLSID p_CLSID, VARIANT_BOOL p_User);
+    STDMETHOD(UnregisterPlugin2)(REFCLSID p_CLSID, VARIANT_BOOL p_User);
+
+    // IShellExtInit methods
+    STDMETHOD(Initialize)(PCIDLIST_ABSOLUTE p_pFolderPIDL, IDataObject *p_pDataObject, HKEY p_hKeyFileClass);
+
+    // IContextMenu methods
+    STDMETHOD(QueryContextMenu)(HMENU p_hMenu, UINT p_Index, UINT p_FirstCmdId,
+                                UINT p_LastCmdId, UINT p_Flags);
+    STDMETHOD(InvokeCommand)(CMINVOKECOMMANDINFO* p_pCommandInfo);
+    STDMETHOD(GetCommandString)(UINT_PTR p_CmdId, UINT p_Flags, UINT* p_pReserved,
+                                LPSTR p_pBuffer, UINT p_BufferSize);
+
+    // IContextMenu2 methods
+    STDMETHOD(HandleMenuMsg)(UINT p_Msg, WPARAM p_wParam, LPARAM p_lParam);
+
+    // IContextMenu3 methods
+    STDMETHOD(HandleMenuMsg2)(UINT p_Msg, WPARAM p_wParam, LPARAM p_lParam, LRESULT* p_pResult);
+
+private:
+    ATL::CComPtr<IUnknown>
+                        m_spEngine;         // Engine's contextual menu extension, once created.
+    bool                m_Initialized;      // Whether the shell initialized us.
+    PIDLIST_ABSOLUTE    m_pFolderPIDL;      // Copy of the folder ID list we were initialized with, if any.
+    ATL::CComPtr<IDataObject>
+                        m_spDataObject;     // Data object we were initialized with, if any.
+
+    HRESULT             GetEngine(REFIID p_IID,
+                                  void** p_ppEngine);
+    template<typename I>
+    HRESULT             GetEngine(I** p_ppEngine)
+                        {
+                            return GetEngine(__uuidof(I), reinterpret_cast<void**>(p_ppEngine));
+                        }
+    HRESULT             InitializeEngine();
+};
+
+OBJECT_ENTRY_AUTO(__uuidof(PathCopyCopyContextMenuExt), CPathCopyCopyContextMenuExtLoader)
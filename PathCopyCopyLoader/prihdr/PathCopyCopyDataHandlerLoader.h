@@ -0,0 +1,106 @@
+// PathCopyCopyDataHandlerLoader.h
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include <PathCopyCopy_i.h>
+#include "resource.h"
+
+#include <string>
+
+#include <atlbase.h>
+#include <atlcom.h>
+#include <shlobj.h>
+#include <windows.h>
+
+
+//
+// CPathCopyCopyDataHandlerLoader
+//
+// Lightweight stand-in for the engine's CPathCopyCopyDataHandler, registered
+// under its CLSID. The shell creates data handlers for files being dragged or
+// copied in any process, and usually only asks which formats they support.
+// We answer that ourselves and only create the engine's object when the path
+// text is actually requested.
+//
+class ATL_NO_VTABLE CPathCopyCopyDataHandlerLoader :
+    public ATL::CComObjectRootEx<ATL::CComSingleThreadModel>,
+    public ATL::CComCoClass<CPathCopyCopyDataHandlerLoader, &__uuidof(PathCopyCopyDataHandler)>,
+    public IPathCopyCopyDataHandler,
+    public IPersistFile,
+    public IDataObject
+{
+public:
+    CPathCopyCopyDataHandlerLoader();
+
+    DECLARE_REGISTRY_RESOURCEID(IDR_PATHCOPYCOPYDATAHANDLER)
+
+    DECLARE_NOT_AGGREGATABLE(CPathCopyCopyDataHandlerLoader)
+
+    BEGIN_COM_MAP(CPathCopyCopyDataHandlerLoader)
+        COM_INTERFACE_ENTRY(IPathCopyCopyDataHandler)
+        COM_INTERFACE_ENTRY(IPersistFile)
+        COM_INTERFACE_ENTRY(IPersist)
+        COM_INTERFACE_ENTRY(IDataObject)
+    END_COM_MAP()
+
+    DECLARE_PROTECT_FINAL_CONSTRUCT()
+
+    HRESULT FinalConstruct()
+    {
+        return S_OK;
+    }
+
+    void FinalRelease()
+    {
+    }
+
+public:
+    // IPersistFile interface
+    STDMETHOD(IsDirty)();
+    STDMETHOD(Load)(LPCOLESTR pszFileName, DWORD dwMode);
+    STDMETHOD(Save)(LPCOLESTR pszFileName, BOOL fRemember);
+    STDMETHOD(SaveCompleted)(LPCOLESTR pszFileName);
+    STDMETHOD(GetCurFile)(LPOLESTR *ppszFileName);
+
+    // IPersist interface
+    STDMETHOD(GetClassID)(CLSID *pClassID);
+
+    // IDataObject interface
+    STDMETHOD(GetData)(FORMATETC *pformatetcIn, STGMEDIUM *pmedium);
+    STDMETHOD(GetDataHere)(FORMATETC *pformatetc, STGMEDIUM *pmedium);
+    STDMETHOD(QueryGetData)(FORMATETC *pformatetc);
+    STDMETHOD(GetCanonicalFormatEtc)(FORMATETC *pformatectIn, FORMATETC *pformatetcOut);
+    STDMETHOD(SetData)(FORMATETC *pformatetc, STGMEDIUM *pmedium, BOOL fRelease);
+    STDMETHOD(EnumFormatEtc)(DWORD dwDirection, IEnumFORMATETC **ppenumFormatEtc);
+    STDMETHOD(DAdvise)(FORMATETC *pformatetc, DWORD advf, IAdviseSink *pAdvSink, DWORD *pdwConnection);
+    STDMETHOD(DUnadvise)(DWORD dwConnection);
+    STDMETHOD(EnumDAdvise)(IEnumSTATDATA **ppenumAdvise);
+
+private:
+    ATL::CComPtr<IDataObject>
+                        m_spEngine;         // Engine's data handler, once created.
+    std::wstring        m_FileName;         // File we were loaded with, if any.
+
+    HRESULT             GetEngine(IDataObject** p_ppEngine);
+};
+
+OBJECT_ENTRY_AUTO(__uuidof(PathCopyCopyDataHandler), CPathCopyCopyDataHandlerLoader)
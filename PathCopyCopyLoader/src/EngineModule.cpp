@@ -0,0 +1,150 @@
+// EngineModule.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <stdafx.h>
+#include <EngineModule.h>
+#include <dllmain.h>
+
+#include <vector>
+
+
+namespace
+{
+    // Names of the engine DLL, as built and as installed by the setup.
+    // It must be in the same folder as this module.
+    const wchar_t* const    ENGINE_DLL_NAME             = L"PathCopyCopy.dll";
+#ifdef _WIN64
+    const wchar_t* const    ENGINE_INSTALLED_DLL_NAME   = L"PCC64.dll";
+#else
+    const wchar_t* const    ENGINE_INSTALLED_DLL_NAME   = L"PCC32.dll";
+#endif
+
+    typedef HRESULT (STDAPICALLTYPE* DllGetClassObjectProc)(REFCLSID, REFIID, LPVOID*);
+    typedef HRESULT (STDAPICALLTYPE* DllCanUnloadNowProc)();
+
+} // anonymous namespace
+
+namespace PCC
+{
+    // Static members of EngineModule
+    HMODULE         EngineModule::s_hEngine = NULL;
+    std::mutex      EngineModule::s_Lock;
+
+    //
+    // Creates an instance of one of the engine's classes, loading
+    // the engine first if needed.
+    //
+    // @param p_CLSID ID of class to instantiate.
+    // @param p_IID ID of interface to return.
+    // @param p_ppObject Where to store the new object.
+    // @return S_OK if successful, otherwise an error code.
+    //
+    HRESULT EngineModule::CreateInstance(REFCLSID p_CLSID,
+                                         REFIID p_IID,
+                                         void** p_ppObject)
+    {
+        HRESULT hRes = E_POINTER;
+        if (p_ppObject != nullptr) {
+            *p_ppObject = nullptr;
+
+            std::lock_guard<std::mutex> lock(s_Lock);
+            HMODULE hEngine = LoadEngine();
+            if (hEngine != NULL) {
+                auto pDllGetClassObject = reinterpret_cast<DllGetClassObjectProc>(::GetProcAddress(hEngine, "DllGetClassObject"));
+                if (pDllGetClassObject != nullptr) {
+                    ATL::CComPtr<IClassFactory> cpClassFactory;
+                    hRes = pDllGetClassObject(p_CLSID, IID_IClassFactory, reinterpret_cast<LPVOID*>(&cpClassFactory));
+                    if (SUCCEEDED(hRes)) {
+                        hRes = cpClassFactory->CreateInstance(nullptr, p_IID, p_ppObject);
+                    }
+                } else {
+                    hRes = CLASS_E_CLASSNOTAVAILABLE;
+                }
+            } else {
+                hRes = HRESULT_FROM_WIN32(ERROR_MOD_NOT_FOUND);
+            }
+        }
+        return hRes;
+    }
+
+    //
+    // Checks whether the engine can be unloaded, and if so, frees it.
+    // Must only be called once our own objects have all been released.
+    //
+    // @return S_OK if the engine is not loaded anymore, S_FALSE if it is still in use.
+    //
+    HRESULT EngineModule::CanUnloadNow()
+    {
+        HRESULT hRes = S_OK;
+        std::lock_guard<std::mutex> lock(s_Lock);
+        if (s_hEngine != NULL) {
+            // Let the engine release its own resources before it is unloaded.
+            auto pDllCanUnloadNow = reinterpret_cast<DllCanUnloadNowProc>(::GetProcAddress(s_hEngine, "DllCanUnloadNow"));
+            if (pDllCanUnloadNow != nullptr) {
+                hRes = pDllCanUnloadNow();
+            }
+            if (hRes == S_OK) {
+                ::FreeLibrary(s_hEngine);
+                s_hEngine = NULL;
+            }
+        }
+        return hRes;
+    }
+
+    //
+    // Checks whether the engine is currently loaded. If it is, creating
+    // its objects is cheap.
+    //
+    // @return true if the engine DLL is loaded.
+    //
+    bool EngineModule::IsLoaded()
+    {
+        std::lock_guard<std::mutex> lock(s_Lock);
+        return s_hEngine != NULL;
+    }
+
+    //
+    // Loads the engine DLL from our own folder if it's not loaded yet.
+    // Must be called with the lock held.
+    //
+    // @return Handle of the engine DLL, or NULL if it could not be loaded.
+    //
+    HMODULE EngineModule::LoadEngine()
+    {
+        if (s_hEngine == NULL) {
+            std::vector<wchar_t> modulePath(MAX_PATH + 1);
+            DWORD modulePathSize = ::GetModuleFileNameW(CPathCopyCopyLoaderModule::HInstance(), modulePath.data(),
+                                                        static_cast<DWORD>(modulePath.size()));
+            if (modulePathSize != 0 && modulePathSize < modulePath.size()) {
+                std::wstring engineFolder(modulePath.data(), modulePathSize);
+                engineFolder.erase(engineFolder.find_last_of(L'\\') + 1);
+
+                // Altered search path makes the engine's own dependencies resolve from its folder.
+                s_hEngine = ::LoadLibraryExW((engineFolder + ENGINE_INSTALLED_DLL_NAME).c_str(), NULL, LOAD_WITH_ALTERED_SEARCH_PATH);
+                if (s_hEngine == NULL) {
+                    s_hEngine = ::LoadLibraryExW((engineFolder + ENGINE_DLL_NAME).c_str(), NULL, LOAD_WITH_ALTERED_SEARCH_PATH);
+                }
+            }
+        }
+        return s_hEngine;
+    }
+
+} // namespace PCC
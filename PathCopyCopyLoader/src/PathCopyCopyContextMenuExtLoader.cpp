@@ -0,0 +1,322 @@
+// PathCopyCopyContextMenuExtLoader.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <stdafx.h>
+#include <PathCopyCopyContextMenuExtLoader.h>
+#include <EngineModule.h>
+
+
+// CPathCopyCopyContextMenuExtLoader
+
+//
+// Constructor.
+//
+CPathCopyCopyContextMenuExtLoader::CPathCopyCopyContextMenuExtLoader()
+    : m_spEngine(),
+      m_Initialized(false),
+      m_pFolderPIDL(nullptr),
+      m_spDataObject()
+{
+}
+
+//
+// Destructor.
+//
+CPathCopyCopyContextMenuExtLoader::~CPathCopyCopyContextMenuExtLoader()
+{
+    if (m_pFolderPIDL != nullptr) {
+        ::ILFree(m_pFolderPIDL);
+        m_pFolderPIDL = nullptr;
+    }
+}
+
+//
+// IPathCopyCopyContextMenuExt::RegisterPlugin
+//
+// Forwarded to the engine.
+//
+STDMETHODIMP CPathCopyCopyContextMenuExtLoader::RegisterPlugin(
+    REFCLSID p_CLSID)
+{
+    ATL::CComPtr<IPathCopyCopyContextMenuExt> spEngineExt;
+    HRESULT hRes = GetEngine(&spEngineExt);
+    if (SUCCEEDED(hRes)) {
+        hRes = spEngineExt->RegisterPlugin(p_CLSID);
+    }
+    return hRes;
+}
+
+//
+// IPathCopyCopyContextMenuExt::UnregisterPlugin
+//
+// Forwarded to the engine.
+//
+STDMETHODIMP CPathCopyCopyContextMenuExtLoader::UnregisterPlugin(
+    REFCLSID p_CLSID)
+{
+    ATL::CComPtr<IPathCopyCopyContextMenuExt> spEngineExt;
+    HRESULT hRes = GetEngine(&spEngineExt);
+    if (SUCCEEDED(hRes)) {
+        hRes = spEngineExt->UnregisterPlugin(p_CLSID);
+    }
+    return hRes;
+}
+
+//
+// IPathCopyCopyContextMenuExt2::RegisterPlugin2
+//
+// Forwarded to the engine.
+//
+STDMETHODIMP CPathCopyCopyContextMenuExtLoader::RegisterPlugin2(
+    REFCLSID p_CLSID,
+    VARIANT_BOOL p_User)
+{
+    ATL::CComPtr<IPathCopyCopyContextMenuExt2> spEngineExt;
+    HRESULT hRes = GetEngine(&spEngineExt);
+    if (SUCCEEDED(hRes)) {
+        hRes = spEngineExt->RegisterPlugin2(p_CLSID, p_User);
+    }
+    return hRes;
+}
+
+//
+// IPathCopyCopyContextMenuExt2::UnregisterPlugin2
+//
+// Forwarded to the engine.
+//
+STDMETHODIMP CPathCopyCopyContextMenuExtLoader::UnregisterPlugin2(
+    REFCLSID p_CLSID,
+    VARIANT_BOOL p_User)
+{
+    ATL::CComPtr<IPathCopyCopyContextMenuExt2> spEngineExt;
+    HRESULT hRes = GetEngine(&spEngineExt);
+    if (SUCCEEDED(hRes)) {
+        hRes = spEngineExt->UnregisterPlugin2(p_CLSID, p_User);
+    }
+    return hRes;
+}
+
+//
+// IShellExtInit::Initialize
+//
+// Invoked by the shell to initialize our contextual menu extension.
+// We keep what we need to initialize the engine later. If the engine
+// is already loaded in this process, its extension is created and
+// initialized right away instead, so that it can start prefetching
+// paths while the menu is being built; only a cold process waits
+// until our items are actually needed to load it.
+//
+// @param p_pFolderPIDL ID list of the folder whose background was clicked, if any.
+// @param p_pDataObject Data object containing the selected files, if any.
+// @param p_hKeyFileClass Registry key of selection's file class. Unused.
+// @return S_OK if successful, otherwise an error code.
+//
+STDMETHODIMP CPathCopyCopyContextMenuExtLoader::Initialize(
+    PCIDLIST_ABSOLUTE p_pFolderPIDL,
+    IDataObject *p_pDataObject,
+    HKEY /*p_hKeyFileClass*/)
+{
+    HRESULT hRes = E_POINTER;
+    if (p_pDataObject != nullptr || p_pFolderPIDL != nullptr) {
+        hRes = S_OK;
+        if (m_pFolderPIDL != nullptr) {
+            ::ILFree(m_pFolderPIDL);
+            m_pFolderPIDL = nullptr;
+        }
+        if (p_pFolderPIDL != nullptr) {
+            m_pFolderPIDL = ::ILCloneFull(p_pFolderPIDL);
+            if (m_pFolderPIDL == nullptr) {
+                hRes = E_OUTOFMEMORY;
+            }
+        }
+        m_spDataObject = p_pDataObject;
+        m_Initialized = SUCCEEDED(hRes);
+
+        if (m_Initialized && m_spEngine != nullptr) {
+            hRes = InitializeEngine();
+        } else if (m_Initialized && PCC::EngineModule::IsLoaded()) {
+            ATL::CComPtr<IUnknown> spEngine;
+            hRes = GetEngine(&spEngine);
+        }
+    }
+    return hRes;
+}
+
+//
+// IContextMenu::QueryContextMenu
+//
+// Invoked by the shell to let us add our items to the contextual menu.
+// This is where the engine is created, unless the shell only wants the
+// default verb, in which case we have nothing to add.
+//
+// @param p_hMenu Handle of contextual menu.
+// @param p_Index Index where to add our items.
+// @param p_FirstCmdId First command ID we can use.
+// @param p_LastCmdId Last command ID we can use.
+// @param p_Flags Flags telling us what kind of menu is built.
+// @return Success code containing the number of command IDs used, otherwise an error code.
+//
+STDMETHODIMP CPathCopyCopyContextMenuExtLoader::QueryContextMenu(
+    HMENU p_hMenu,
+    UINT p_Index,
+    UINT p_FirstCmdId,
+    UINT p_LastCmdId,
+    UINT p_Flags)
+{
+    HRESULT hRes = MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_NULL, 0);
+    if ((p_Flags & CMF_DEFAULTONLY) == 0) {
+        ATL::CComPtr<IContextMenu> spEngineMenu;
+        hRes = GetEngine(&spEngineMenu);
+        if (SUCCEEDED(hRes)) {
+            hRes = spEngineMenu->QueryContextMenu(p_hMenu, p_Index, p_FirstCmdId, p_LastCmdId, p_Flags);
+        }
+    }
+    return hRes;
+}
+
+//
+// IContextMenu::InvokeCommand
+//
+// Forwarded to the engine. If it wasn't created, we do not
+// have menu items, so we can't invoke anything.
+//
+STDMETHODIMP CPathCopyCopyContextMenuExtLoader::InvokeCommand(
+    CMINVOKECOMMANDINFO* p_pCommandInfo)
+{
+    HRESULT hRes = E_INVALIDARG;
+    if (m_spEngine != nullptr) {
+        ATL::CComPtr<IContextMenu> spEngineMenu;
+        hRes = GetEngine(&spEngineMenu);
+        if (SUCCEEDED(hRes)) {
+            hRes = spEngineMenu->InvokeCommand(p_pCommandInfo);
+        }
+    }
+    return hRes;
+}
+
+//
+// IContextMenu::GetCommandString
+//
+// Forwarded to the engine. If it wasn't created, we do not
+// have menu items, so there's no command to describe.
+//
+STDMETHODIMP CPathCopyCopyContextMenuExtLoader::GetCommandString(
+    UINT_PTR p_CmdId,
+    UINT p_Flags,
+    UINT* p_pReserved,
+    LPSTR p_pBuffer,
+    UINT p_BufferSize)
+{
+    HRESULT hRes = E_INVALIDARG;
+    if (m_spEngine != nullptr) {
+        ATL::CComPtr<IContextMenu> spEngineMenu;
+        hRes = GetEngine(&spEngineMenu);
+        if (SUCCEEDED(hRes)) {
+            hRes = spEngineMenu->GetCommandString(p_CmdId, p_Flags, p_pReserved, p_pBuffer, p_BufferSize);
+        }
+    }
+    return hRes;
+}
+
+//
+// IContextMenu2::HandleMenuMsg
+//
+// Forwards to HandleMenuMsg2.
+//
+STDMETHODIMP CPathCopyCopyContextMenuExtLoader::HandleMenuMsg(
+    UINT p_Msg,
+    WPARAM p_wParam,
+    LPARAM p_lParam)
+{
+    LRESULT result = 0;
+    return HandleMenuMsg2(p_Msg, p_wParam, p_lParam, &result);
+}
+
+//
+// IContextMenu3::HandleMenuMsg2
+//
+// Forwarded to the engine. If it wasn't created, the
+// message can't be about one of our menu items.
+//
+STDMETHODIMP CPathCopyCopyContextMenuExtLoader::HandleMenuMsg2(
+    UINT p_Msg,
+    WPARAM p_wParam,
+    LPARAM p_lParam,
+    LRESULT* p_pResult)
+{
+    HRESULT hRes = S_OK;
+    if (m_spEngine != nullptr) {
+        ATL::CComPtr<IContextMenu3> spEngineMenu;
+        hRes = GetEngine(&spEngineMenu);
+        if (SUCCEEDED(hRes)) {
+            hRes = spEngineMenu->HandleMenuMsg2(p_Msg, p_wParam, p_lParam, p_pResult);
+        }
+    } else if (p_pResult != nullptr) {
+        *p_pResult = 0;
+    }
+    return hRes;
+}
+
+//
+// Returns an interface of the engine's contextual menu extension.
+// The extension is created the first time it is needed and initialized
+// like we were, if the shell initialized us.
+//
+// @param p_IID ID of interface to return.
+// @param p_ppEngine Where to store the interface pointer.
+// @return S_OK if successful, otherwise an error code.
+//
+HRESULT CPathCopyCopyContextMenuExtLoader::GetEngine(REFIID p_IID,
+                                                     void** p_ppEngine)
+{
+    HRESULT hRes = S_OK;
+    if (m_spEngine == nullptr) {
+        hRes = PCC::EngineModule::CreateInstance(__uuidof(PathCopyCopyContextMenuExt), IID_IUnknown,
+                                                 reinterpret_cast<void**>(&m_spEngine));
+        if (SUCCEEDED(hRes) && m_Initialized) {
+            hRes = InitializeEngine();
+        }
+        if (FAILED(hRes)) {
+            m_spEngine.Release();
+        }
+    }
+    if (SUCCEEDED(hRes)) {
+        hRes = m_spEngine->QueryInterface(p_IID, p_ppEngine);
+    }
+    return hRes;
+}
+
+//
+// Initializes the engine's contextual menu extension with the
+// folder and data object we were initialized with.
+//
+// @return S_OK if successful, otherwise an error code.
+//
+HRESULT CPathCopyCopyContextMenuExtLoader::InitializeEngine()
+{
+    ATL::CComQIPtr<IShellExtInit> spEngineInit(m_spEngine);
+    HRESULT hRes = spEngineInit != nullptr ? S_OK : E_NOINTERFACE;
+    if (SUCCEEDED(hRes)) {
+        // The engine doesn't use the file class key.
+        hRes = spEngineInit->Initialize(m_pFolderPIDL, m_spDataObject, NULL);
+    }
+    return hRes;
+}
@@ -0,0 +1,299 @@
+// PathCopyCopyDataHandlerLoader.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <stdafx.h>
+#include <PathCopyCopyDataHandlerLoader.h>
+#include <EngineModule.h>
+
+
+// CPathCopyCopyDataHandlerLoader
+
+//
+// Constructor.
+//
+CPathCopyCopyDataHandlerLoader::CPathCopyCopyDataHandlerLoader()
+    : m_spEngine(),
+      m_FileName()
+{
+}
+
+//
+// IPersistFile::IsDirty
+// This method is unused for shell data handlers.
+//
+STDMETHODIMP CPathCopyCopyDataHandlerLoader::IsDirty()
+{
+    return E_NOTIMPL;
+}
+
+//
+// IPersistFile::Load
+// This method is called by the Windows Shell to initialize
+// the data handler for a particular file. We note the file name
+// to pass it to the engine later; if the engine has already been
+// created, we pass it right away.
+//
+// @param pszFileName Name of the file to act upon.
+// @param dwMode File open mode.
+// @return S_OK if successful, otherwise an error code.
+//
+STDMETHODIMP CPathCopyCopyDataHandlerLoader::Load(
+    LPCOLESTR pszFileName,
+    DWORD dwMode)
+{
+    HRESULT hRes = E_POINTER;
+    if (pszFileName != nullptr) {
+        try {
+            m_FileName = pszFileName;
+            hRes = S_OK;
+        } catch (...) {
+            hRes = E_UNEXPECTED;
+            m_FileName.clear();
+        }
+        if (SUCCEEDED(hRes) && m_spEngine != nullptr) {
+            ATL::CComQIPtr<IPersistFile> spEngineFile(m_spEngine);
+            hRes = spEngineFile != nullptr ? spEngineFile->Load(pszFileName, dwMode) : E_NOINTERFACE;
+        }
+    }
+    return hRes;
+}
+
+//
+// IPersistFile::Save
+// This method is unused for shell data handlers.
+//
+STDMETHODIMP CPathCopyCopyDataHandlerLoader::Save(
+    LPCOLESTR /*pszFileName*/,
+    BOOL /*fRemember*/)
+{
+    return E_NOTIMPL;
+}
+
+//
+// IPersistFile::SaveCompleted
+// This method is unused for shell data handlers.
+//
+STDMETHODIMP CPathCopyCopyDataHandlerLoader::SaveCompleted(
+    LPCOLESTR /*pszFileName*/)
+{
+    return E_NOTIMPL;
+}
+
+//
+// IPersistFile::GetCurFile
+// This method is unused for shell data handlers.
+//
+STDMETHODIMP CPathCopyCopyDataHandlerLoader::GetCurFile(
+    LPOLESTR* /*ppszFileName*/)
+{
+    return E_NOTIMPL;
+}
+
+//
+// IPersist::GetClassID
+// Must return the CLSID of the class capable of handling the data.
+// We will return our own CLSID, which is also the engine's.
+//
+// @param pClassID Where to store our CLSID.
+// @return S_OK if successful, otherwise an error code.
+//
+STDMETHODIMP CPathCopyCopyDataHandlerLoader::GetClassID(
+    CLSID *pClassID)
+{
+    HRESULT hRes = E_INVALIDARG;
+    if (pClassID != nullptr) {
+        *pClassID = __uuidof(PathCopyCopyDataHandler);
+        hRes = S_OK;
+    }
+    return hRes;
+}
+
+//
+// IDataObject::GetData
+// Called by the shell when data is actually required.
+// Forwarded to the engine, which is created if needed.
+//
+// @param pformatetcIn Format descriptor for the format requested.
+// @param pmedium Where to save the storage medium containing our data.
+// @return S_OK if successful, otherwise an error code.
+//
+STDMETHODIMP CPathCopyCopyDataHandlerLoader::GetData(
+    FORMATETC *pformatetcIn,
+    STGMEDIUM *pmedium)
+{
+    // Only create the engine if it can provide what's requested.
+    HRESULT hRes = pmedium != nullptr ? this->QueryGetData(pformatetcIn) : E_INVALIDARG;
+    if (SUCCEEDED(hRes)) {
+        ATL::CComPtr<IDataObject> spEngine;
+        hRes = GetEngine(&spEngine);
+        if (SUCCEEDED(hRes)) {
+            hRes = spEngine->GetData(pformatetcIn, pmedium);
+        }
+    }
+    return hRes;
+}
+
+//
+// IDataObject::GetDataHere
+// This method is unused for shell data handlers.
+//
+STDMETHODIMP CPathCopyCopyDataHandlerLoader::GetDataHere(
+    FORMATETC* /*pformatetc*/,
+    STGMEDIUM* /*pmedium*/)
+{
+    return E_NOTIMPL;
+}
+
+//
+// IDataObject::QueryGetData
+// Method called by the shell to validate whether we
+// can provide data in a specific format. Like the engine,
+// we only supply text through an HGLOBAL.
+//
+// @param pformatetc Pointer to a FORMATETC struct describing the format.
+// @return S_OK if we support the format, otherwise an error code.
+//
+STDMETHODIMP CPathCopyCopyDataHandlerLoader::QueryGetData(
+    FORMATETC *pformatetc)
+{
+    HRESULT hRes = E_INVALIDARG;
+    if (pformatetc != nullptr) {
+        if (pformatetc->lindex != -1) {
+            hRes = DV_E_LINDEX;
+        } else if (pformatetc->dwAspect != DVASPECT_CONTENT) {
+            hRes = DV_E_DVASPECT;
+        } else if (pformatetc->cfFormat != CF_UNICODETEXT) {
+            hRes = DV_E_CLIPFORMAT;
+        } else if (pformatetc->tymed != TYMED_HGLOBAL) {
+            hRes = DV_E_TYMED;
+        } else {
+            // Caller is asking for text in the proper format, it will work.
+            hRes = S_OK;
+        }
+    }
+    return hRes;
+}
+
+//
+// IDataObject::GetCanonicalFormatEtc
+// This method is unused for shell data handlers.
+//
+STDMETHODIMP CPathCopyCopyDataHandlerLoader::GetCanonicalFormatEtc(
+    FORMATETC* /*pformatectIn*/,
+    FORMATETC* /*pformatetcOut*/)
+{
+    return E_NOTIMPL;
+}
+
+//
+// IDataObject::SetData
+// This method is unused for shell data handlers.
+//
+STDMETHODIMP CPathCopyCopyDataHandlerLoader::SetData(
+    FORMATETC* /*pformatetc*/,
+    STGMEDIUM* /*pmedium*/,
+    BOOL /*fRelease*/)
+{
+    return E_NOTIMPL;
+}
+
+//
+// IDataObject::EnumFormatEtc
+// Called by the shell to enumerate the formats we support.
+//
+// @param dwDirection Whether to return formats supported for setting or for getting.
+// @param ppenumFormatEtc Pointer to location where to store an IEnumFORMATETC implementation
+//                        that will provide all formats we support.
+// @return S_OK if successful, otherwise an error code.
+//
+STDMETHODIMP CPathCopyCopyDataHandlerLoader::EnumFormatEtc(
+    DWORD dwDirection,
+    IEnumFORMATETC **ppenumFormatEtc)
+{
+    // Supported formats are saved in the registry with our CLSID.
+    HRESULT hRes = E_INVALIDARG;
+    if (ppenumFormatEtc != nullptr) {
+        hRes = ::OleRegEnumFormatEtc(__uuidof(PathCopyCopyDataHandler), dwDirection, ppenumFormatEtc);
+    }
+    return hRes;
+}
+
+//
+// IDataObject::DAdvise
+// This method is unused for shell data handlers.
+//
+STDMETHODIMP CPathCopyCopyDataHandlerLoader::DAdvise(
+    FORMATETC* /*pformatetc*/,
+    DWORD /*advf*/,
+    IAdviseSink* /*pAdvSink*/,
+    DWORD* /*pdwConnection*/)
+{
+    return E_NOTIMPL;
+}
+
+//
+// IDataObject::DUnadvise
+// This method is unused for shell data handlers.
+//
+STDMETHODIMP CPathCopyCopyDataHandlerLoader::DUnadvise(
+    DWORD /*dwConnection*/)
+{
+    return E_NOTIMPL;
+}
+
+//
+// IDataObject::EnumDAdvise
+// This method is unused for shell data handlers.
+//
+STDMETHODIMP CPathCopyCopyDataHandlerLoader::EnumDAdvise(
+    IEnumSTATDATA** /*ppenumAdvise*/)
+{
+    return E_NOTIMPL;
+}
+
+//
+// Returns the engine's data handler. It is created the first time
+// it is needed and initialized with our file.
+//
+// @param p_ppEngine Where to store the engine's data handler.
+// @return S_OK if successful, otherwise an error code.
+//
+HRESULT CPathCopyCopyDataHandlerLoader::GetEngine(IDataObject** p_ppEngine)
+{
+    HRESULT hRes = S_OK;
+    if (m_spEngine == nullptr) {
+        hRes = PCC::EngineModule::CreateInstance(__uuidof(PathCopyCopyDataHandler), IID_IDataObject,
+                                                 reinterpret_cast<void**>(&m_spEngine));
+        if (SUCCEEDED(hRes)) {
+            if (!m_FileName.empty()) {
+                ATL::CComQIPtr<IPersistFile> spEngineFile(m_spEngine);
+                hRes = spEngineFile != nullptr ? spEngineFile->Load(m_FileName.c_str(), STGM_READ) : E_NOINTERFACE;
+            }
+        }
+        if (FAILED(hRes)) {
+            m_spEngine.Release();
+        }
+    }
+    if (SUCCEEDED(hRes)) {
+        hRes = m_spEngine.CopyTo(p_ppEngine);
+    }
+    return hRes;
+}
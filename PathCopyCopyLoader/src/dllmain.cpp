@@ -0,0 +1,192 @@
+// dllmain.cpp
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <stdafx.h>
+#include <dllmain.h>
+#include <EngineModule.h>
+#include <PathCopyCopy_i.h>
+#include <PathCopyCopyContextMenuExtLoader.h>
+#include <PathCopyCopyDataHandlerLoader.h>
+
+#include <StAtlPerUserOverride.h>
+
+#include <string.h>
+
+namespace {
+
+// Keeps the global instance passed to DllMain.
+HINSTANCE g_hInstance = NULL;
+
+// Key where approved shell extensions are registered.
+const wchar_t* const    APPROVED_EXTENSIONS_KEY = L"Software\\Microsoft\\Windows\\CurrentVersion\\Extensions\\Approved";
+
+} // anonymous namespace
+
+//
+// CPathCopyCopyLoaderModule::DllRegisterServer
+//
+// Registers this module's classes. The type library is
+// registered by the engine, which contains it.
+//
+// @param p_RegisterTypeLib Whether to register type libraries.
+// @return Result code.
+//
+HRESULT CPathCopyCopyLoaderModule::DllRegisterServer(BOOL p_RegisterTypeLib /*= FALSE*/) throw()
+{
+    // Setup per-user registration if needed.
+    StAtlPerUserOverride perUserOverride;
+    HRESULT hRes = perUserOverride.Succeeded() ? S_OK : E_FAIL;
+    if (SUCCEEDED(hRes)) {
+        hRes = ATL::CAtlDllModuleT<CPathCopyCopyLoaderModule>::DllRegisterServer(p_RegisterTypeLib);
+        if (SUCCEEDED(hRes)) {
+            // Register our shell extensions as "approved". We do this here so that
+            // it can work in per-user installations.
+            ATL::CRegKey approvedKey;
+            LONG regRes = approvedKey.Create(perUserOverride.Overridden() ? HKEY_CURRENT_USER : HKEY_LOCAL_MACHINE,
+                                             APPROVED_EXTENSIONS_KEY, nullptr, REG_OPTION_NON_VOLATILE,
+                                             KEY_QUERY_VALUE | KEY_SET_VALUE);
+            if (regRes == ERROR_SUCCESS) {
+                regRes = approvedKey.SetStringValue(L"{82CB99A2-2F18-4D5D-9476-54347E3B6720}",
+                                                    L"PathCopyCopy Contextual Menu Handler");
+            }
+            if (regRes == ERROR_SUCCESS) {
+                regRes = approvedKey.SetStringValue(L"{16170CA5-25CA-4e6d-928C-7A3A974F4B56}",
+                                                    L"PathCopyCopy Data Handler");
+            }
+            if (regRes != ERROR_SUCCESS) {
+                hRes = HRESULT_FROM_WIN32(regRes);
+            }
+        }
+    }
+    return hRes;
+}
+
+//
+// CPathCopyCopyLoaderModule::DllUnregisterServer
+//
+// Unregisters this module's classes.
+//
+// @param p_UnregisterTypeLib Whether to unregister type libraries.
+// @return Result code.
+//
+HRESULT CPathCopyCopyLoaderModule::DllUnregisterServer(BOOL p_UnregisterTypeLib /*= FALSE*/) throw()
+{
+    // Setup per-user unregistration if needed.
+    StAtlPerUserOverride perUserOverride;
+    HRESULT hRes = perUserOverride.Succeeded() ? S_OK : E_FAIL;
+    if (SUCCEEDED(hRes)) {
+        hRes = ATL::CAtlDllModuleT<CPathCopyCopyLoaderModule>::DllUnregisterServer(p_UnregisterTypeLib);
+        if (SUCCEEDED(hRes)) {
+            // Unregister our approved shell extensions. We do this here so that
+            // it can work in per-user installations.
+            // Note that if it doesn't exist, we consider it a success.
+            ATL::CRegKey approvedKey;
+            LONG regRes = approvedKey.Open(perUserOverride.Overridden() ? HKEY_CURRENT_USER : HKEY_LOCAL_MACHINE,
+                                           APPROVED_EXTENSIONS_KEY, KEY_QUERY_VALUE | KEY_SET_VALUE);
+            if (regRes != ERROR_SUCCESS && regRes != ERROR_FILE_NOT_FOUND) {
+                hRes = HRESULT_FROM_WIN32(regRes);
+            } else if (regRes == ERROR_SUCCESS) {
+                approvedKey.DeleteValue(L"{82CB99A2-2F18-4D5D-9476-54347E3B6720}");
+                approvedKey.DeleteValue(L"{16170CA5-25CA-4e6d-928C-7A3A974F4B56}");
+            }
+        }
+    }
+    return hRes;
+}
+
+//
+// CPathCopyCopyLoaderModule::HInstance
+//
+// Returns the instance handle passed to our module's /DllMain/.
+//
+// @return Module instance handle.
+//
+HINSTANCE CPathCopyCopyLoaderModule::HInstance()
+{
+    return g_hInstance;
+}
+
+CPathCopyCopyLoaderModule _AtlModule;
+
+// DLL Entry Point
+extern "C" BOOL WINAPI DllMain(HINSTANCE hInstance, DWORD dwReason, LPVOID lpReserved)
+{
+    g_hInstance = hInstance;
+    return _AtlModule.DllMain(dwReason, lpReserved);
+}
+
+
+// Used to determine whether the DLL can be unloaded by OLE
+STDAPI DllCanUnloadNow(void)
+{
+    HRESULT hRes = _AtlModule.DllCanUnloadNow();
+    if (hRes == S_OK) {
+        // None of our objects are alive; we can go if the engine can.
+        hRes = PCC::EngineModule::CanUnloadNow();
+    }
+    return hRes;
+}
+
+
+// Returns a class factory to create an object of the requested type
+STDAPI DllGetClassObject(REFCLSID rclsid, REFIID riid, LPVOID* ppv)
+{
+    return _AtlModule.DllGetClassObject(rclsid, riid, ppv);
+}
+
+
+// DllRegisterServer - Adds entries to the system registry
+STDAPI DllRegisterServer(void)
+{
+    return _AtlModule.DllRegisterServer();
+}
+
+
+// DllUnregisterServer - Removes entries from the system registry
+STDAPI DllUnregisterServer(void)
+{
+    return _AtlModule.DllUnregisterServer();
+}
+
+// DllInstall - Adds/Removes entries to the system registry per user
+//              per machine.
+STDAPI DllInstall(BOOL bInstall, LPCWSTR pszCmdLine)
+{
+    HRESULT hr = E_FAIL;
+    static const wchar_t szUserSwitch[] = L"user";
+
+    if (pszCmdLine != NULL) {
+        if (_wcsnicmp(pszCmdLine, szUserSwitch, _countof(szUserSwitch)) == 0) {
+            ATL::AtlSetPerUserRegistration(true);
+        }
+    }
+
+    if (bInstall) {
+        hr = DllRegisterServer();
+        if (FAILED(hr)) {
+            DllUnregisterServer();
+        }
+    } else {
+        hr = DllUnregisterServer();
+    }
+
+    return hr;
+}
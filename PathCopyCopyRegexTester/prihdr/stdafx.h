@@ -22,6 +22,10 @@
 #pragma once
 
 #include "targetver.h"
+
+// Use the same std::wregex step limit as the main project (see its stdafx.h),
+// so that regexes too complex for pipeline plugins are reported as such.
+#define _REGEX_MAX_COMPLEXITY_COUNT 1000000L
 #include "resource.h"
 
 #include <iostream>
@@ -20,19 +20,149 @@
 // THE SOFTWARE.
 
 #include "stdafx.h"
+#include <FastRegex.h>
 
+#include <chrono>
+#include <cstdlib>
+#include <cwchar>
+#include <functional>
+#include <map>
+#include <memory>
 #include <regex>
+#include <string>
+#include <utility>
+#include <vector>
 
 
+namespace
+{
+    const wchar_t* const    SERVER_MODE_ARG         = L"--server";  // Command-line argument to run as a server
+    const size_t            MAX_CACHED_REGEXES      = 64;           // Max number of compiled regexes kept in server mode
+    const wchar_t* const    END_OF_RESULTS          = L"End of results";    // Line output after each server request
+
+    // Map of compiled regexes, per regex string and ignore case flag.
+    typedef std::map<std::pair<std::wstring, bool>, std::shared_ptr<std::wregex>> RegexesM;
+
+    //
+    // Measures the average time taken by an operation.
+    //
+    // @param p_Iterations Number of times to perform the operation.
+    // @param p_Operation Operation to perform.
+    // @return Average time per operation, in microseconds.
+    //
+    double MeasureMicroseconds(const int p_Iterations,
+                               const std::function<void()>& p_Operation)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < p_Iterations; ++i) {
+            p_Operation();
+        }
+        const std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() / p_Iterations;
+    }
+
+    //
+    // Runs the tester as a server, reading requests from standard input until
+    // it is closed. This allows the settings app to keep a single tester process
+    // alive instead of starting a new one for each test.
+    //
+    // Each request is made of the following lines:
+    //   Regex
+    //   Format
+    //   Ignore case (y/n)
+    //   Number of sample strings
+    //   Sample strings, one per line
+    //
+    // For each sample string, the modified string and the time taken by the
+    // replacement are output. If the regex is invalid, a single error line is
+    // output instead. Each response ends with a line containing END_OF_RESULTS.
+    //
+    // Compiled regexes are cached between requests, since the same regex is
+    // usually tested with several sample strings.
+    //
+    void RunServer()
+    {
+        RegexesM mspRegexes;
+        std::wstring regex, format, ignoreCase, countStr, sample;
+        while (std::getline(std::wcin, regex) && std::getline(std::wcin, format) &&
+               std::getline(std::wcin, ignoreCase) && std::getline(std::wcin, countStr)) {
+
+            const int count = _wtoi(countStr.c_str());
+            std::vector<std::wstring> vSamples;
+            for (int i = 0; i < count && std::getline(std::wcin, sample); ++i) {
+                vSamples.push_back(sample);
+            }
+
+            // Get compiled regex from cache, compiling it if needed. This must be
+            // similar to the way this is done in RegexPipelineElement in the main project.
+            const auto key = std::make_pair(regex, ignoreCase == L"y");
+            std::shared_ptr<std::wregex> spRegex;
+            auto it = mspRegexes.find(key);
+            if (it != mspRegexes.end()) {
+                spRegex = it->second;
+            } else {
+                try {
+                    std::regex_constants::syntax_option_type reOptions = std::regex_constants::ECMAScript;
+                    if (key.second) {
+                        reOptions |= std::regex_constants::icase;
+                    }
+                    spRegex = std::make_shared<std::wregex>(regex, reOptions);
+                } catch (const std::regex_error&) {
+                    // Invalid regex, reported below. Cache it anyway to avoid compiling it again.
+                }
+                if (mspRegexes.size() >= MAX_CACHED_REGEXES) {
+                    mspRegexes.clear();
+                }
+                mspRegexes.emplace(key, spRegex);
+            }
+
+            if (spRegex != nullptr) {
+                try {
+                    for (const std::wstring& curSample : vSamples) {
+                        std::wstring modified;
+                        const double elapsed = MeasureMicroseconds(1, [&]() {
+                            modified = std::regex_replace(curSample, *spRegex, format);
+                        });
+                        std::wcout << L"Modified string: " << modified << L"\n"
+                                   << L"Match time: " << elapsed << L" us" << L"\n";
+                    }
+                } catch (const std::regex_error& err) {
+                    // Can happen if the format is invalid or if the regex is too complex.
+                    if (err.code() == std::regex_constants::error_complexity ||
+                        err.code() == std::regex_constants::error_stack) {
+                        std::wcout << L"ERROR: regular expression too complex, paths would be left as-is." << L"\n";
+                    } else {
+                        std::wcout << L"ERROR: invalid regular expression detected!" << L"\n";
+                    }
+                }
+            } else {
+                std::wcout << L"ERROR: invalid regular expression detected!" << L"\n";
+            }
+            std::wcout << END_OF_RESULTS << std::endl;
+        }
+    }
+
+} // anonymous namespace
+
 //
-// Main program entry point.
+// Main program entry point. If a number is passed on the command line,
+// the replacement is performed that many times with each regex engine
+// and the average time per replacement is output. If --server is passed
+// instead, requests are processed until standard input is closed (see RunServer).
 //
 // @param argc Number of command-line arguments received
 // @param argv Array of command-line arguments
 // @return Process exit code
 //
-int wmain(int /*argc*/, wchar_t* /*argv*/[])
+int wmain(int argc, wchar_t* argv[])
 {
+    if (argc > 1 && std::wcscmp(argv[1], SERVER_MODE_ARG) == 0) {
+        RunServer();
+        return 0;
+    }
+
+    const int iterations = argc > 1 ? _wtoi(argv[1]) : 0;
+
     // Ask user to provide sample string, regex and replacement format.
     std::wstring sample, regex, format;
     std::wcout << L"Sample string: ";
@@ -62,6 +192,31 @@ int wmain(int /*argc*/, wchar_t* /*argv*/[])
 
         // Output modified string:
         std::wcout << L"Modified string: " << modified << std::endl;
+
+        // Perform the same replacement with the fast regex engine so that results can be compared.
+        std::unique_ptr<PCC::FastRegex> upFastRegex;
+        try {
+            upFastRegex.reset(new PCC::FastRegex(regex, ignoreCase == L'y'));
+        } catch (const std::regex_error&) {
+            std::wcout << L"Fast engine: regular expression not supported, std::wregex would be used." << std::endl;
+        }
+        if (upFastRegex != nullptr) {
+            std::wstring fastModified = upFastRegex->Replace(sample, format);
+            std::wcout << L"Fast engine modified string: " << fastModified << std::endl;
+            std::wcout << L"Results identical: " << (fastModified == modified ? L"yes" : L"NO") << std::endl;
+        }
+
+        // Compare speed of both engines if requested.
+        if (iterations > 0) {
+            std::wcout << L"std::wregex: "
+                       << MeasureMicroseconds(iterations, [&]() { std::regex_replace(sample, re, format); })
+                       << L" us per replacement" << std::endl;
+            if (upFastRegex != nullptr) {
+                std::wcout << L"Fast engine: "
+                           << MeasureMicroseconds(iterations, [&]() { upFastRegex->Replace(sample, format); })
+                           << L" us per replacement" << std::endl;
+            }
+        }
     } catch (const std::regex_error&) {
         std::wcout << L"ERROR: invalid regular expression detected!" << std::endl;
     }
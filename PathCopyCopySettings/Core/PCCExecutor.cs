@@ -20,22 +20,175 @@
 // THE SOFTWARE.
 
 using System;
+using System.Collections.Generic;
 using System.Diagnostics;
+using System.Globalization;
 using System.IO;
 using System.Reflection;
+using System.Runtime.InteropServices;
 using Microsoft.Win32;
 using PathCopyCopy.Settings.Properties;
 
 namespace PathCopyCopy.Settings.Core
 {
     /// <summary>
-    /// Wrapper for executing Path Copy Copy DLL functions through rundll32.
+    /// Wrapper for executing Path Copy Copy DLL functions through rundll32,
+    /// or directly in-process when possible.
     /// </summary>
     public sealed class PCCExecutor
     {
         /// Name of rundll32 executable file.
         private const string RUNDLL32_EXE_NAME = "rundll32.exe";
+
+        /// Name of the DLL function used to evaluate pipelines in-process.
+        private const string GET_PATHS_WITH_PIPELINE_FUNCTION_NAME = "GetPathsWithPipelineW";
+
+        /// Name of the DLL function used to profile pipelines in-process.
+        private const string PROFILE_PIPELINE_FUNCTION_NAME = "ProfilePipelineW";
+
+        /// Separator used between paths passed to/returned by GetPathsWithPipelineW.
+        private const char PIPELINE_PATHS_SEPARATOR = '\n';
+
+        /// Separator used between the fields of each element returned by ProfilePipelineW.
+        private const char PROFILE_FIELDS_SEPARATOR = '\t';
+
+        /// Signature of the GetPathsWithPipelineW function exported by the PCC DLL.
+        [UnmanagedFunctionPointer(CallingConvention.StdCall)]
+        private delegate int GetPathsWithPipelineFunction(
+            [MarshalAs(UnmanagedType.LPWStr)] string encodedElements,
+            [MarshalAs(UnmanagedType.LPWStr)] string paths,
+            [MarshalAs(UnmanagedType.BStr)] out string results);
+
+        /// Signature of the ProfilePipelineW function exported by the PCC DLL.
+        [UnmanagedFunctionPointer(CallingConvention.StdCall)]
+        private delegate int ProfilePipelineFunction(
+            [MarshalAs(UnmanagedType.LPWStr)] string encodedElements,
+            [MarshalAs(UnmanagedType.LPWStr)] string paths,
+            uint iterations,
+            [MarshalAs(UnmanagedType.BStr)] out string results);
+
+        /// Lock protecting the in-process DLL and its functions.
+        private static readonly object getPathsWithPipelineLock = new object();
+
+        /// Handle of the PCC DLL loaded in-process, loaded on first use.
+        private static IntPtr pccDllModule = IntPtr.Zero;
+
+        /// In-process DLL function, loaded on first use.
+        private static GetPathsWithPipelineFunction getPathsWithPipeline;
+
+        /// In-process DLL function used to profile pipelines, loaded on first use.
+        private static ProfilePipelineFunction profilePipeline;
+
+        /// <summary>
+        /// Whether pipelines can be evaluated in-process via
+        /// <see cref="GetPathsWithPipeline"/>. This is only possible when our
+        /// process has the same bitness as the settings we edit, since we need
+        /// to load the matching PCC DLL.
+        /// </summary>
+        public static bool CanEvaluatePipelinesInProcess
+        {
+            get {
+                return !PCCEnvironment.IsWow64;
+            }
+        }
         
+        /// <summary>
+        /// Uses the Path Copy Copy DLL loaded in-process to evaluate a pipeline
+        /// on a batch of paths. The pipeline does not need to be saved to the
+        /// registry. Can only be called if <see cref="CanEvaluatePipelinesInProcess"/>
+        /// is <c>true</c>.
+        /// </summary>
+        /// <param name="encodedElements">Encoded elements of the pipeline.</param>
+        /// <param name="paths">Paths to pass to the pipeline. Cannot contain newlines.</param>
+        /// <returns>Paths returned by the pipeline, in the same order as
+        /// <paramref name="paths"/>.</returns>
+        /// <exception cref="PCCExecutorException">Thrown when execution fails
+        /// for some reason.</exception>
+        public string[] GetPathsWithPipeline(string encodedElements, string[] paths)
+        {
+            Debug.Assert(encodedElements != null);
+            Debug.Assert(paths != null);
+            Debug.Assert(CanEvaluatePipelinesInProcess);
+
+            GetPathsWithPipelineFunction function = GetPathsWithPipelineInProcess();
+            string results;
+            int hRes = function(encodedElements,
+                String.Join(PIPELINE_PATHS_SEPARATOR.ToString(), paths), out results);
+            if (hRes < 0) {
+                throw new PCCExecutorException(Marshal.GetExceptionForHR(hRes));
+            }
+
+            string[] resultingPaths = (results ?? String.Empty).Split(PIPELINE_PATHS_SEPARATOR);
+            if (resultingPaths.Length != paths.Length) {
+                throw new PCCExecutorException("Pipeline returned {0} paths instead of {1}",
+                    resultingPaths.Length, paths.Length);
+            }
+            return resultingPaths;
+        }
+
+        /// <summary>
+        /// Uses the Path Copy Copy DLL loaded in-process to evaluate a pipeline
+        /// on a single path. See <see cref="GetPathsWithPipeline"/> for details.
+        /// </summary>
+        /// <param name="encodedElements">Encoded elements of the pipeline.</param>
+        /// <param name="path">Path to pass to the pipeline.</param>
+        /// <returns>Path returned by the pipeline.</returns>
+        /// <exception cref="PCCExecutorException">Thrown when execution fails
+        /// for some reason.</exception>
+        public string GetPathWithPipeline(string encodedElements, string path)
+        {
+            Debug.Assert(path != null);
+
+            return GetPathsWithPipeline(encodedElements, new string[] { path })[0];
+        }
+        
+        /// <summary>
+        /// Uses the Path Copy Copy DLL loaded in-process to measure the time
+        /// spent in each element of a pipeline when converting sample paths.
+        /// Can only be called if <see cref="CanEvaluatePipelinesInProcess"/>
+        /// is <c>true</c>.
+        /// </summary>
+        /// <param name="encodedElements">Encoded elements of the pipeline.</param>
+        /// <param name="paths">Sample paths to convert. Cannot contain newlines.</param>
+        /// <param name="iterations">Number of times to convert each path.</param>
+        /// <returns>Profile of each element of the pipeline, in order.</returns>
+        /// <exception cref="PCCExecutorException">Thrown when execution fails
+        /// for some reason.</exception>
+        public PipelineElementProfile[] ProfilePipeline(string encodedElements, string[] paths, int iterations)
+        {
+            Debug.Assert(encodedElements != null);
+            Debug.Assert(paths != null);
+            Debug.Assert(iterations > 0);
+            Debug.Assert(CanEvaluatePipelinesInProcess);
+
+            ProfilePipelineFunction function = ProfilePipelineInProcess();
+            string results;
+            int hRes = function(encodedElements,
+                String.Join(PIPELINE_PATHS_SEPARATOR.ToString(), paths), (uint) iterations, out results);
+            if (hRes < 0) {
+                throw new PCCExecutorException(Marshal.GetExceptionForHR(hRes));
+            }
+
+            List<PipelineElementProfile> profiles = new List<PipelineElementProfile>();
+            if (!String.IsNullOrEmpty(results)) {
+                int runs = iterations * paths.Length;
+                foreach (string result in results.Split(PIPELINE_PATHS_SEPARATOR)) {
+                    string[] fields = result.Split(PROFILE_FIELDS_SEPARATOR);
+                    long microseconds, allocations;
+                    if (fields.Length != 2 ||
+                        !Int64.TryParse(fields[0], NumberStyles.Integer, CultureInfo.InvariantCulture, out microseconds) ||
+                        !Int64.TryParse(fields[1], NumberStyles.Integer, CultureInfo.InvariantCulture, out allocations)) {
+
+                        throw new PCCExecutorException("Invalid pipeline profile: {0}", result);
+                    }
+                    profiles.Add(new PipelineElementProfile(
+                        TimeSpan.FromTicks(microseconds * (TimeSpan.TicksPerMillisecond / 1000)),
+                        allocations >= 0 ? (double?) allocations / runs : null));
+                }
+            }
+            return profiles.ToArray();
+        }
+
         /// <summary>
         /// Uses the Path Copy Copy DLL to execute the GetPath function for a
         /// given plugin.
@@ -89,21 +242,7 @@ namespace PathCopyCopy.Settings.Core
             Debug.Assert(!String.IsNullOrEmpty(functionName));
             Debug.Assert(commandLine != null);
 
-            // Find path to PCC DLL. It's right beside our own executable.
-            // In debug settings, it has the default name Visual Studio gave it.
-            // When installed, it has a different name depending on bittage.
-            string assemblyDir = Path.GetDirectoryName(new Uri(Assembly.GetEntryAssembly().CodeBase).LocalPath);
-            string pccDllPath = Path.Combine(assemblyDir, Resources.PCC_EXECUTOR_DLL_NAME_DEV);
-            if (!File.Exists(pccDllPath)) {
-                if (PCCEnvironment.Is64Bit && !PCCEnvironment.IsWow64) {
-                    pccDllPath = Path.Combine(assemblyDir, Resources.PCC_EXECUTOR_DLL_NAME_64);
-                } else {
-                    pccDllPath = Path.Combine(assemblyDir, Resources.PCC_EXECUTOR_DLL_NAME_32);
-                }
-            }
-            if (!File.Exists(pccDllPath)) {
-                throw new PCCExecutorException("Could not find Path Copy Copy DLL at: {0}", pccDllPath);
-            }
+            string pccDllPath = GetPCCDllPath();
 
             // Execute rundll32. See documentation for rundll32 for details on the
             // way to pass it command-line arguments. Also note that we do not need
@@ -123,6 +262,95 @@ namespace PathCopyCopy.Settings.Core
                 throw new PCCExecutorException(e);
             }
         }
+
+        /// <summary>
+        /// Returns the path to the Path Copy Copy DLL. It's right beside our own
+        /// executable. In debug settings, it has the default name Visual Studio
+        /// gave it. When installed, it has a different name depending on bittage.
+        /// </summary>
+        /// <returns>Path to PCC DLL.</returns>
+        /// <exception cref="PCCExecutorException">Thrown if the DLL cannot
+        /// be found.</exception>
+        private static string GetPCCDllPath()
+        {
+            string assemblyDir = Path.GetDirectoryName(new Uri(Assembly.GetEntryAssembly().CodeBase).LocalPath);
+            string pccDllPath = Path.Combine(assemblyDir, Resources.PCC_EXECUTOR_DLL_NAME_DEV);
+            if (!File.Exists(pccDllPath)) {
+                if (PCCEnvironment.Is64Bit && !PCCEnvironment.IsWow64) {
+                    pccDllPath = Path.Combine(assemblyDir, Resources.PCC_EXECUTOR_DLL_NAME_64);
+                } else {
+                    pccDllPath = Path.Combine(assemblyDir, Resources.PCC_EXECUTOR_DLL_NAME_32);
+                }
+            }
+            if (!File.Exists(pccDllPath)) {
+                throw new PCCExecutorException("Could not find Path Copy Copy DLL at: {0}", pccDllPath);
+            }
+            return pccDllPath;
+        }
+
+        /// <summary>
+        /// Loads the Path Copy Copy DLL in our process and returns a delegate
+        /// for its <c>GetPathsWithPipelineW</c> function. The DLL is loaded once
+        /// and kept loaded for the lifetime of the process.
+        /// </summary>
+        /// <returns>Delegate for the DLL function.</returns>
+        /// <exception cref="PCCExecutorException">Thrown if the DLL or the
+        /// function cannot be loaded.</exception>
+        private static GetPathsWithPipelineFunction GetPathsWithPipelineInProcess()
+        {
+            lock (getPathsWithPipelineLock) {
+                if (getPathsWithPipeline == null) {
+                    getPathsWithPipeline = (GetPathsWithPipelineFunction) Marshal.GetDelegateForFunctionPointer(
+                        GetFunctionInProcess(GET_PATHS_WITH_PIPELINE_FUNCTION_NAME), typeof(GetPathsWithPipelineFunction));
+                }
+                return getPathsWithPipeline;
+            }
+        }
+
+        /// <summary>
+        /// Loads the Path Copy Copy DLL in our process and returns a delegate
+        /// for its <c>ProfilePipelineW</c> function. See
+        /// <see cref="GetPathsWithPipelineInProcess"/> for details.
+        /// </summary>
+        /// <returns>Delegate for the DLL function.</returns>
+        /// <exception cref="PCCExecutorException">Thrown if the DLL or the
+        /// function cannot be loaded.</exception>
+        private static ProfilePipelineFunction ProfilePipelineInProcess()
+        {
+            lock (getPathsWithPipelineLock) {
+                if (profilePipeline == null) {
+                    profilePipeline = (ProfilePipelineFunction) Marshal.GetDelegateForFunctionPointer(
+                        GetFunctionInProcess(PROFILE_PIPELINE_FUNCTION_NAME), typeof(ProfilePipelineFunction));
+                }
+                return profilePipeline;
+            }
+        }
+
+        /// <summary>
+        /// Returns the address of a function exported by the Path Copy Copy DLL,
+        /// loading the DLL in our process if needed. Must be called with
+        /// <see cref="getPathsWithPipelineLock"/> held.
+        /// </summary>
+        /// <param name="functionName">Name of function to look for.</param>
+        /// <returns>Address of the DLL function.</returns>
+        /// <exception cref="PCCExecutorException">Thrown if the DLL or the
+        /// function cannot be loaded.</exception>
+        private static IntPtr GetFunctionInProcess(string functionName)
+        {
+            if (pccDllModule == IntPtr.Zero) {
+                string pccDllPath = GetPCCDllPath();
+                pccDllModule = NativeMethods.LoadLibrary(pccDllPath);
+                if (pccDllModule == IntPtr.Zero) {
+                    throw new PCCExecutorException("Could not load Path Copy Copy DLL at: {0}", pccDllPath);
+                }
+            }
+            IntPtr pFunction = NativeMethods.GetProcAddress(pccDllModule, functionName);
+            if (pFunction == IntPtr.Zero) {
+                throw new PCCExecutorException("Could not find function {0} in Path Copy Copy DLL",
+                    functionName);
+            }
+            return pFunction;
+        }
         
         /// <summary>
         /// Wrapper for the output of the <c>RegGetPathWithPlugin</c> function
@@ -134,7 +362,7 @@ namespace PathCopyCopy.Settings.Core
         private sealed class RegistryOutput : IDisposable
         {
             /// Path to registry key containing rundll32 outputs in CURRENT_USER.
-            private const string PCC_RUNDLL32_OUTPUT_KEY = @"Software\clechasseur\PathCopyCopy\Rundll32Output";
+            private const string PCC_RUNDLL32_OUTPUT_KEY = @"Software\clechasseur\PathCopyCopyCache\Rundll32Output";
 
             /// Registry key wrapper to access the rundll32 output.
             private RegistryKey rundll32OutputKey = Registry.CurrentUser.CreateSubKey(PCC_RUNDLL32_OUTPUT_KEY);
@@ -194,6 +422,56 @@ namespace PathCopyCopy.Settings.Core
                 }
             }
         }
+
+        /// <summary>
+        /// Wrapper for Win32 functions used to load the PCC DLL in-process.
+        /// </summary>
+        private static class NativeMethods
+        {
+            [DllImport("kernel32.dll", CharSet = CharSet.Unicode, SetLastError = true)]
+            public static extern IntPtr LoadLibrary(string lpFileName);
+
+            [DllImport("kernel32.dll", CharSet = CharSet.Ansi, SetLastError = true, BestFitMapping = false)]
+            public static extern IntPtr GetProcAddress(IntPtr hModule, string lpProcName);
+        }
+    }
+    
+    /// <summary>
+    /// Profile of one pipeline element, as measured by
+    /// <see cref="PCCExecutor.ProfilePipeline"/>.
+    /// </summary>
+    public sealed class PipelineElementProfile
+    {
+        /// <summary>
+        /// Total time spent in the element for all conversions.
+        /// </summary>
+        public TimeSpan Duration
+        {
+            get;
+            private set;
+        }
+
+        /// <summary>
+        /// Average number of allocations performed by the element per
+        /// conversion, or <c>null</c> if allocations could not be counted.
+        /// </summary>
+        public double? AllocationsPerPath
+        {
+            get;
+            private set;
+        }
+
+        /// <summary>
+        /// Constructor.
+        /// </summary>
+        /// <param name="duration">Total time spent in the element.</param>
+        /// <param name="allocationsPerPath">Average number of allocations per
+        /// conversion, or <c>null</c> if unknown.</param>
+        public PipelineElementProfile(TimeSpan duration, double? allocationsPerPath)
+        {
+            Duration = duration;
+            AllocationsPerPath = allocationsPerPath;
+        }
     }
     
     /// <summary>
@@ -34,7 +34,12 @@ namespace PathCopyCopy.Settings.Core.Plugins
     /// of the executor depending on whether we need to call a 32-bit or
     /// 64-bit COM plugin.
     /// </summary>
-    public sealed class COMPluginExecutor
+    /// <remarks>
+    /// The executor program is launched once in server mode and reused for
+    /// all calls; plugins stay instantiated between calls. It exits when this
+    /// object is disposed of.
+    /// </remarks>
+    public sealed class COMPluginExecutor : IDisposable
     {
         /// Regex used to extract the output of the COM plugin executor program.
         private static readonly Regex OUTPUT_REGEX = new Regex(String.Format(@"^{0}(.*)$",
@@ -48,7 +53,44 @@ namespace PathCopyCopy.Settings.Core.Plugins
 
         /// Output returned by the COM plugin executor for a command that returns a boolean "false" result.
         private const string EXECUTOR_FALSE_OUTPUT = "false";
-        
+
+        /// Command-line argument used to launch the COM plugin executor in server mode.
+        private const string EXECUTOR_SERVER_ARGUMENT = "/server";
+
+        /// Command returning all properties of a plugin at once, one output line per property.
+        private const string EXECUTOR_GET_ALL_COMMAND = "get_All";
+
+        /// Number of output lines returned by <see cref="EXECUTOR_GET_ALL_COMMAND"/>.
+        private const int EXECUTOR_GET_ALL_OUTPUT_COUNT = 6;
+
+        /// Time to wait for the executor program to exit when disposing, in milliseconds.
+        private const int EXECUTOR_EXIT_TIMEOUT = 1000;
+
+        /// COM plugin executor program running in server mode, or <c>null</c> if not started yet.
+        private Process executor;
+
+        /// <summary>
+        /// Invokes the COM plugin executor program to get all properties of a
+        /// COM plugin at once.
+        /// </summary>
+        /// <param name="pluginId">ID of plugin to invoke.</param>
+        /// <returns>Plugin properties.</returns>
+        /// <exception cref="COMPluginExecutorException">Thrown when execution
+        /// fails for some reason.</exception>
+        public COMPluginProperties GetAll(Guid pluginId)
+        {
+            string[] outputs = Call(pluginId, EXECUTOR_GET_ALL_COMMAND, EXECUTOR_GET_ALL_OUTPUT_COUNT);
+            int groupId, groupPosition;
+            return new COMPluginProperties {
+                Description = outputs[0],
+                HelpText = outputs[1],
+                GroupId = Int32.TryParse(outputs[2], out groupId) ? groupId : 0,
+                GroupPosition = Int32.TryParse(outputs[3], out groupPosition) ? groupPosition : 0,
+                IconFile = outputs[4],
+                UseDefaultIcon = outputs[5] == EXECUTOR_TRUE_OUTPUT,
+            };
+        }
+
         /// <summary>
         /// Invokes the COM plugin executor program to get the description for a
         /// COM plugin.
@@ -140,7 +182,75 @@ namespace PathCopyCopy.Settings.Core.Plugins
         /// fails for some reason.</exception>
         private string Call(Guid pluginId, string command)
         {
-            string output = null;
+            return Call(pluginId, command, 1)[0];
+        }
+
+        /// <summary>
+        /// Invokes the COM plugin executor program to execute the given command
+        /// and returns the results.
+        /// </summary>
+        /// <param name="pluginId">ID of plugin to invoke.</param>
+        /// <param name="command">Command to execute.</param>
+        /// <param name="outputCount">Number of output lines returned by the command.</param>
+        /// <returns>Results of the execution, one per output line.</returns>
+        /// <exception cref="COMPluginExecutorException">Thrown when execution
+        /// fails for some reason.</exception>
+        private string[] Call(Guid pluginId, string command, int outputCount)
+        {
+            string[] outputs = new string[outputCount];
+
+            try {
+                StartExecutor();
+
+                // Send the arguments on standard input.
+                StreamWriter cin = executor.StandardInput;
+                cin.WriteLine(pluginId.ToString("B"));
+                cin.WriteLine(command);
+                cin.Flush();
+
+                // Get standard output, parse lines and get command output.
+                StreamReader cout = executor.StandardOutput;
+                int outputIndex = 0;
+                while (outputIndex < outputCount) {
+                    string line = cout.ReadLine();
+                    if (line == null) {
+                        // Executor exited before returning output.
+                        StopExecutor();
+                        throw new COMPluginExecutorException("COM plugin execution did not return expected output.");
+                    }
+                    Match match = OUTPUT_REGEX.Match(line);
+                    if (match.Success) {
+                        // We got a command output.
+                        outputs[outputIndex++] = match.Groups[1].Value;
+                    } else if (line.StartsWith(EXECUTOR_ERROR_PREFIX)) {
+                        // An error occured during execution.
+                        throw new COMPluginExecutorException("COM plugin execution failed. Error: {0}", line);
+                    }
+                }
+            } catch (COMPluginExecutorException) {
+                throw;
+            } catch (Exception e) {
+                StopExecutor();
+                throw new COMPluginExecutorException(e);
+            }
+
+            // Return the outputs to user.
+            Debug.Assert(Array.TrueForAll(outputs, output => output != null));
+            return outputs;
+        }
+
+        /// <summary>
+        /// Launches the COM plugin executor program in server mode
+        /// if it's not running.
+        /// </summary>
+        /// <exception cref="COMPluginExecutorException">Thrown if the
+        /// executor program cannot be found.</exception>
+        private void StartExecutor()
+        {
+            if (executor != null && !executor.HasExited) {
+                return;
+            }
+            StopExecutor();
 
             // Find path to executor program. It's right beside our own executable.
             string assemblyPath = new Uri(Assembly.GetEntryAssembly().CodeBase).LocalPath;
@@ -155,62 +265,115 @@ namespace PathCopyCopy.Settings.Core.Plugins
                 throw new COMPluginExecutorException("Could not find COM plugin executor program at: {0}", executorPath);
             }
 
-            // Launch tester program, grabbing input and output.
-            ProcessStartInfo startInfo = new ProcessStartInfo(executorPath) {
+            // Launch executor program, grabbing input and output.
+            ProcessStartInfo startInfo = new ProcessStartInfo(executorPath, EXECUTOR_SERVER_ARGUMENT) {
                 CreateNoWindow = true,
                 RedirectStandardError = true,
                 RedirectStandardInput = true,
                 RedirectStandardOutput = true,
                 UseShellExecute = false,
             };
-            try {
-                using (Process executor = Process.Start(startInfo)) {
-                    // Get standard input and enter the arguments.
-                    StreamWriter cin = executor.StandardInput;
-                    cin.WriteLine(pluginId.ToString("B"));
-                    cin.WriteLine(command);
+            executor = Process.Start(startInfo);
+        }
 
-                    // Get standard output, parse lines and get command output.
-                    StreamReader cout = executor.StandardOutput;
-                    string line = cout.ReadLine();
-                    while (line != null) {
-                        Match match = OUTPUT_REGEX.Match(line);
-                        if (match.Success) {
-                            // We got our command output.
-                            output = match.Groups[1].Value;
-                            break;
-                        } else if (line.StartsWith(EXECUTOR_ERROR_PREFIX)) {
-                            // An error occured during execution.
-                            throw new COMPluginExecutorException("COM plugin execution failed. Error: {0}", line);
+        /// <summary>
+        /// Stops the COM plugin executor program if it's running.
+        /// </summary>
+        private void StopExecutor()
+        {
+            if (executor != null) {
+                try {
+                    if (!executor.HasExited) {
+                        // Closing standard input tells the executor to exit.
+                        executor.StandardInput.Close();
+                        if (!executor.WaitForExit(EXECUTOR_EXIT_TIMEOUT)) {
+                            executor.Kill();
                         }
-
-                        // Read next line.
-                        line = cout.ReadLine();
                     }
+                } catch (InvalidOperationException) {
+                    // Process already exited.
+                } catch (IOException) {
+                    // Pipe already closed.
+                } catch (System.ComponentModel.Win32Exception) {
+                    // Process could not be killed; nothing more we can do.
+                } finally {
+                    executor.Dispose();
+                    executor = null;
+                }
+            }
+        }
 
-                    // Wait for the process to end.
-                    executor.WaitForExit();
+        #region IDisposable Members
 
-                    // Throw if the execution failed.
-                    if (executor.ExitCode < 0) {
-                        throw new COMPluginExecutorException("COM plugin execution failed. Exit code: {0}.", executor.ExitCode);
-                    }
+        /// <summary>
+        /// Called when the object is disposed of. We stop the executor program.
+        /// </summary>
+        public void Dispose()
+        {
+            StopExecutor();
+        }
 
-                    // Make sure we found output.
-                    if (output == null) {
-                        throw new COMPluginExecutorException("COM plugin execution did not return expected output. " +
-                            "Exit code: {0}.", executor.ExitCode);
-                    }
-                }
-            } catch (COMPluginExecutorException) {
-                throw;
-            } catch (Exception e) {
-                throw new COMPluginExecutorException(e);
-            }
+        #endregion
+    }
+
+    /// <summary>
+    /// Bean containing all properties of a COM plugin, as returned by
+    /// <see cref="COMPluginExecutor.GetAll"/>.
+    /// </summary>
+    public sealed class COMPluginProperties
+    {
+        /// <summary>
+        /// Plugin description.
+        /// </summary>
+        public string Description
+        {
+            get;
+            set;
+        }
+
+        /// <summary>
+        /// Plugin help text.
+        /// </summary>
+        public string HelpText
+        {
+            get;
+            set;
+        }
 
-            // Return the output to user.
-            Debug.Assert(output != null);
-            return output;
+        /// <summary>
+        /// ID of group for the plugin.
+        /// </summary>
+        public int GroupId
+        {
+            get;
+            set;
+        }
+
+        /// <summary>
+        /// Group position for the plugin.
+        /// </summary>
+        public int GroupPosition
+        {
+            get;
+            set;
+        }
+
+        /// <summary>
+        /// Icon file for the plugin.
+        /// </summary>
+        public string IconFile
+        {
+            get;
+            set;
+        }
+
+        /// <summary>
+        /// Whether the plugin wants to use the default icon.
+        /// </summary>
+        public bool UseDefaultIcon
+        {
+            get;
+            set;
         }
     }
     
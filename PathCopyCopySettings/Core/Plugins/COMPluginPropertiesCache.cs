@@ -0,0 +1,255 @@
+﻿// COMPluginPropertiesCache.cs
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+using System;
+using System.IO;
+using System.Security;
+using Microsoft.Win32;
+
+namespace PathCopyCopy.Settings.Core.Plugins
+{
+    /// <summary>
+    /// Persistent cache of COM plugin properties, used to avoid having to
+    /// probe every COM plugin through the <see cref="COMPluginExecutor"/>
+    /// each time the settings app starts. Entries are keyed by plugin ID
+    /// and are only valid as long as the plugin's server binary is unchanged.
+    /// </summary>
+    /// <remarks>
+    /// This is similar to the <c>COMPluginMetadataCache</c> class in C++ code,
+    /// but uses its own key since it stores the properties as returned by
+    /// the executor program.
+    /// </remarks>
+    public static class COMPluginPropertiesCache
+    {
+        /// Path of the key storing cached COM plugin properties in the registry.
+        private const string PCC_COM_PLUGINS_CACHE_KEY = @"Software\clechasseur\PathCopyCopyCache\SettingsCOMPlugins";
+
+        /// Path of the key containing COM class registrations, relative to HKCR.
+        private const string CLSID_KEY = "CLSID";
+
+        /// Name of the subkey storing the registration of an in-process COM server.
+        private const string INPROC_SERVER_SUBKEY = "InprocServer32";
+
+        /// Name of the subkey storing the registration of a local COM server.
+        private const string LOCAL_SERVER_SUBKEY = "LocalServer32";
+
+        /// Name of the value storing the code base of a .NET COM server.
+        private const string CODE_BASE_VALUE = "CodeBase";
+
+        /// Value storing the plugin's description.
+        private const string DESCRIPTION_VALUE = "Description";
+
+        /// Value storing the plugin's help text.
+        private const string HELP_TEXT_VALUE = "HelpText";
+
+        /// Value storing the plugin's group ID.
+        private const string GROUP_ID_VALUE = "GroupId";
+
+        /// Value storing the plugin's position in its group.
+        private const string GROUP_POSITION_VALUE = "GroupPosition";
+
+        /// Value storing the plugin's icon file.
+        private const string ICON_FILE_VALUE = "IconFile";
+
+        /// Value storing whether the plugin wants to use the default icon.
+        private const string USE_DEFAULT_ICON_VALUE = "UseDefaultIcon";
+
+        /// Value storing the path of the plugin's server binary when it was probed.
+        private const string SERVER_PATH_VALUE = "ServerPath";
+
+        /// Value storing the last write time of the plugin's server binary when it was probed.
+        private const string SERVER_STAMP_VALUE = "ServerStamp";
+
+        /// <summary>
+        /// Fetches cached properties of a COM plugin, if they are still valid.
+        /// </summary>
+        /// <param name="pluginId">ID of COM plugin.</param>
+        /// <returns>Cached plugin properties, or <c>null</c> if the plugin is
+        /// not in the cache or if its server binary changed since.</returns>
+        public static COMPluginProperties Get(Guid pluginId)
+        {
+            COMPluginProperties properties = null;
+            string serverPath;
+            long serverStamp;
+            if (GetServerStamp(pluginId, out serverPath, out serverStamp)) {
+                try {
+                    using (RegistryKey pluginKey = Registry.CurrentUser.OpenSubKey(GetCacheKeyPath(pluginId))) {
+                        // Stamps are written last, so a partially-written entry will not match.
+                        if (pluginKey != null &&
+                            String.Equals(pluginKey.GetValue(SERVER_PATH_VALUE) as string, serverPath, StringComparison.OrdinalIgnoreCase) &&
+                            pluginKey.GetValue(SERVER_STAMP_VALUE) is long &&
+                            (long) pluginKey.GetValue(SERVER_STAMP_VALUE) == serverStamp) {
+
+                            string description = pluginKey.GetValue(DESCRIPTION_VALUE) as string;
+                            if (!String.IsNullOrEmpty(description)) {
+                                properties = new COMPluginProperties {
+                                    Description = description,
+                                    HelpText = pluginKey.GetValue(HELP_TEXT_VALUE) as string ?? String.Empty,
+                                    GroupId = Convert.ToInt32(pluginKey.GetValue(GROUP_ID_VALUE, 0)),
+                                    GroupPosition = Convert.ToInt32(pluginKey.GetValue(GROUP_POSITION_VALUE, 0)),
+                                    IconFile = pluginKey.GetValue(ICON_FILE_VALUE) as string ?? String.Empty,
+                                    UseDefaultIcon = Convert.ToInt32(pluginKey.GetValue(USE_DEFAULT_ICON_VALUE, 0)) != 0,
+                                };
+                            }
+                        }
+                    }
+                } catch (SecurityException) {
+                    properties = null;
+                } catch (IOException) {
+                    properties = null;
+                } catch (InvalidCastException) {
+                    properties = null;
+                }
+            }
+            return properties;
+        }
+
+        /// <summary>
+        /// Stores properties of a COM plugin in the cache. Should be called with
+        /// properties fetched from the plugin through the <see cref="COMPluginExecutor"/>.
+        /// </summary>
+        /// <param name="pluginId">ID of COM plugin.</param>
+        /// <param name="properties">Plugin properties.</param>
+        public static void Update(Guid pluginId, COMPluginProperties properties)
+        {
+            if (properties == null) {
+                throw new ArgumentNullException(nameof(properties));
+            }
+
+            string serverPath;
+            long serverStamp;
+            if (GetServerStamp(pluginId, out serverPath, out serverStamp)) {
+                try {
+                    using (RegistryKey pluginKey = Registry.CurrentUser.CreateSubKey(GetCacheKeyPath(pluginId))) {
+                        pluginKey.DeleteValue(SERVER_STAMP_VALUE, false);
+                        pluginKey.SetValue(DESCRIPTION_VALUE, properties.Description ?? String.Empty);
+                        pluginKey.SetValue(HELP_TEXT_VALUE, properties.HelpText ?? String.Empty);
+                        pluginKey.SetValue(GROUP_ID_VALUE, properties.GroupId, RegistryValueKind.DWord);
+                        pluginKey.SetValue(GROUP_POSITION_VALUE, properties.GroupPosition, RegistryValueKind.DWord);
+                        pluginKey.SetValue(ICON_FILE_VALUE, properties.IconFile ?? String.Empty);
+                        pluginKey.SetValue(USE_DEFAULT_ICON_VALUE, properties.UseDefaultIcon ? 1 : 0, RegistryValueKind.DWord);
+                        pluginKey.SetValue(SERVER_PATH_VALUE, serverPath);
+                        pluginKey.SetValue(SERVER_STAMP_VALUE, serverStamp, RegistryValueKind.QWord);
+                    }
+                } catch (SecurityException) {
+                    // Can't write to cache; plugin will simply be probed again next time.
+                } catch (UnauthorizedAccessException) {
+                    // Same as above.
+                } catch (IOException) {
+                    // Same as above.
+                }
+            }
+        }
+
+        /// <summary>
+        /// Removes cached properties of a COM plugin.
+        /// </summary>
+        /// <param name="pluginId">ID of COM plugin.</param>
+        public static void Remove(Guid pluginId)
+        {
+            try {
+                Registry.CurrentUser.DeleteSubKeyTree(GetCacheKeyPath(pluginId), false);
+            } catch (SecurityException) {
+                // Can't access cache, skip.
+            } catch (UnauthorizedAccessException) {
+                // Same as above.
+            } catch (IOException) {
+                // Same as above.
+            }
+        }
+
+        /// <summary>
+        /// Returns the path of the cache key of a COM plugin, relative to HKCU.
+        /// </summary>
+        /// <param name="pluginId">ID of COM plugin.</param>
+        /// <returns>Path of cache key.</returns>
+        private static string GetCacheKeyPath(Guid pluginId)
+        {
+            return PCC_COM_PLUGINS_CACHE_KEY + @"\" + pluginId.ToString("B");
+        }
+
+        /// <summary>
+        /// Finds the server binary of a COM plugin and returns its last write time.
+        /// If either the server path or its last write time change, cached properties
+        /// of the plugin are no longer considered valid.
+        /// </summary>
+        /// <param name="pluginId">ID of COM plugin.</param>
+        /// <param name="serverPath">Where to store the path of the server binary.</param>
+        /// <param name="serverStamp">Where to store the last write time of the
+        /// server binary, as a file time.</param>
+        /// <returns><c>true</c> if the server binary could be found.</returns>
+        private static bool GetServerStamp(Guid pluginId, out string serverPath, out long serverStamp)
+        {
+            serverPath = null;
+            serverStamp = 0;
+
+            try {
+                string clsidKeyPath = CLSID_KEY + @"\" + pluginId.ToString("B");
+                using (RegistryKey inProcKey = Registry.ClassesRoot.OpenSubKey(clsidKeyPath + @"\" + INPROC_SERVER_SUBKEY)) {
+                    if (inProcKey != null) {
+                        // For .NET plugins, the in-process server is the runtime;
+                        // use the assembly's code base when available.
+                        string codeBase = inProcKey.GetValue(CODE_BASE_VALUE) as string;
+                        Uri codeBaseUri;
+                        if (!String.IsNullOrEmpty(codeBase) && Uri.TryCreate(codeBase, UriKind.Absolute, out codeBaseUri) &&
+                            codeBaseUri.IsFile) {
+
+                            serverPath = codeBaseUri.LocalPath;
+                        } else {
+                            serverPath = inProcKey.GetValue(null) as string;
+                        }
+                    }
+                }
+                if (serverPath == null) {
+                    using (RegistryKey localKey = Registry.ClassesRoot.OpenSubKey(clsidKeyPath + @"\" + LOCAL_SERVER_SUBKEY)) {
+                        if (localKey != null) {
+                            // For local servers, the value is a command line that can include arguments.
+                            serverPath = localKey.GetValue(null) as string;
+                            if (serverPath != null && serverPath.StartsWith("\"")) {
+                                int closingQuotePos = serverPath.IndexOf('"', 1);
+                                serverPath = closingQuotePos >= 0 ? serverPath.Substring(1, closingQuotePos - 1)
+                                                                  : serverPath.Substring(1);
+                            } else if (serverPath != null && serverPath.IndexOf(' ') >= 0) {
+                                serverPath = serverPath.Substring(0, serverPath.IndexOf(' '));
+                            }
+                        }
+                    }
+                }
+                if (!String.IsNullOrEmpty(serverPath)) {
+                    serverPath = Environment.ExpandEnvironmentVariables(serverPath);
+                    if (File.Exists(serverPath)) {
+                        serverStamp = File.GetLastWriteTimeUtc(serverPath).ToFileTimeUtc();
+                        return true;
+                    }
+                }
+            } catch (SecurityException) {
+                // Can't read registration, plugin can't be cached.
+            } catch (UnauthorizedAccessException) {
+                // Same as above.
+            } catch (IOException) {
+                // Same as above.
+            } catch (ArgumentException) {
+                // Server path is invalid.
+            }
+            return false;
+        }
+    }
+}
@@ -80,10 +80,15 @@ namespace PathCopyCopy.Settings.Core.Plugins
             Debug.Assert(userSettings != null);
 
             // Since this plugin might have been modified from its official
-            // version (or it could not exist at all), we'll create a temp
-            // copy, save it to user settings and ask the PCCExecutor to use
-            // this temp copy to get the preview. We also do not cache the
-            // preview since we could change during the lifetime of the app.
+            // version (or it could not exist at all), we cannot use its ID to
+            // get the preview. If possible, we'll ask the PCCExecutor to evaluate
+            // the pipeline in-process. Otherwise, we'll create a temp copy, save
+            // it to user settings and ask the PCCExecutor to use this temp copy
+            // to get the preview. We also do not cache the preview since we
+            // could change during the lifetime of the app.
+            if (PCCExecutor.CanEvaluatePipelinesInProcess) {
+                return new PCCExecutor().GetPathWithPipeline(Info.EncodedElements, Plugin.PREVIEW_PATH);
+            }
             PipelinePluginInfo tempInfo = Info.CreateTemp();
             using (new TempPipelinePluginSaver(tempInfo, userSettings)) {
                 return new PCCExecutor().GetPathWithPlugin(tempInfo.Id, Plugin.PREVIEW_PATH);
@@ -251,6 +256,17 @@ namespace PathCopyCopy.Settings.Core.Plugins
             set;
         }
 
+        /// <summary>
+        /// Name of the nested submenu in which to display this plugin, or
+        /// <c>null</c> to display it directly in the submenu.
+        /// </summary>
+        [XmlElement]
+        public string Folder
+        {
+            get;
+            set;
+        }
+
         /// <summary>
         /// How the pipeline plugin was last edited in the UI.
         /// </summary>
@@ -490,6 +506,9 @@ namespace PathCopyCopy.Settings.Core.Plugins
         /// Lock used to protect creation of XmlSerializer objects.
         private static readonly object xmlSerializersLock = new Object();
 
+        /// XML serializer used to read individual pipeline plugins. Late-created.
+        private static XmlSerializer pluginInfoXmlSerializer;
+
         /// List storing the pipeline plugins in the collection.
         private List<PipelinePluginInfo> infos = new List<PipelinePluginInfo>();
 
@@ -570,6 +589,49 @@ namespace PathCopyCopy.Settings.Core.Plugins
                 return (PipelinePluginCollection) GetXmlSerializer(PipelinePluginXmlSerializerVersion.V3).Deserialize(reader);
             }
         }
+
+        /// <summary>
+        /// Reads pipeline plugins from XML data produced by <see cref="ToXML"/>,
+        /// one at a time. Unlike <see cref="FromXML"/>, each plugin is returned
+        /// as soon as it is read, so callers can process large files in a single
+        /// pass without first building a collection.
+        /// </summary>
+        /// <param name="stream"><see cref="T:Stream"/> containing the XML.</param>
+        /// <returns>Pipeline plugins found in the XML, in order.</returns>
+        /// <exception cref="InvalidOperationException">Thrown while enumerating
+        /// if the XML does not contain a pipeline plugin collection or if a plugin
+        /// cannot be deserialized.</exception>
+        /// <exception cref="XmlException">Thrown while enumerating if the XML
+        /// is malformed.</exception>
+        public static IEnumerable<PipelinePluginInfo> ReadPluginsFromXML(Stream stream)
+        {
+            Debug.Assert(stream != null);
+
+            XmlSerializer infoSerializer = GetPluginInfoXmlSerializer();
+            XmlReaderSettings readerSettings = new XmlReaderSettings {
+                IgnoreComments = true,
+                IgnoreProcessingInstructions = true,
+                IgnoreWhitespace = true,
+            };
+            using (XmlReader reader = XmlReader.Create(stream, readerSettings)) {
+                // Validate the root element like the serializer used by FromXML would.
+                reader.MoveToContent();
+                if (reader.LocalName != nameof(PipelinePluginCollection) || reader.NamespaceURI != PIPELINE_PLUGINS_XML_NAMESPACE) {
+                    throw new InvalidOperationException("XML does not contain a pipeline plugin collection");
+                }
+                if (reader.ReadToDescendant(nameof(Plugins), PIPELINE_PLUGINS_XML_NAMESPACE) && !reader.IsEmptyElement) {
+                    reader.ReadStartElement();
+                    while (reader.MoveToContent() == XmlNodeType.Element) {
+                        if (reader.LocalName == nameof(PipelinePluginInfo) && reader.NamespaceURI == PIPELINE_PLUGINS_XML_NAMESPACE) {
+                            // Deserializing moves the reader past the plugin's element.
+                            yield return (PipelinePluginInfo) infoSerializer.Deserialize(reader);
+                        } else {
+                            reader.Skip();
+                        }
+                    }
+                }
+            }
+        }
         
         /// <summary>
         /// Returns an <see cref="XmlSerializer"/> to use for XML
@@ -613,6 +675,25 @@ namespace PathCopyCopy.Settings.Core.Plugins
             Debug.Assert(xmlSerializer != null);
             return xmlSerializer;
         }
+
+        /// <summary>
+        /// Returns an <see cref="XmlSerializer"/> to use to deserialize individual
+        /// pipeline plugins found in a serialized collection.
+        /// </summary>
+        /// <returns>Global <see cref="XmlSerializer"/> instance.</returns>
+        private static XmlSerializer GetPluginInfoXmlSerializer()
+        {
+            lock (xmlSerializersLock) {
+                // Serializers created with an XmlRootAttribute are not cached by the
+                // framework and generate a new assembly each time, so keep ours.
+                if (pluginInfoXmlSerializer == null) {
+                    pluginInfoXmlSerializer = new XmlSerializer(typeof(PipelinePluginInfo), null, new Type[0],
+                        new XmlRootAttribute(nameof(PipelinePluginInfo)) { Namespace = PIPELINE_PLUGINS_XML_NAMESPACE },
+                        PIPELINE_PLUGINS_XML_NAMESPACE);
+                }
+                return pluginInfoXmlSerializer;
+            }
+        }
     }
     
     /// <summary>
@@ -664,6 +745,21 @@ namespace PathCopyCopy.Settings.Core.Plugins
         /// <returns>Return value summary</returns>
         abstract public string Encode();
 
+        /// <summary>
+        /// Encodes the data of the element in binary format. This is the same
+        /// data that is returned by <see cref="Encode"/>, but where each field
+        /// is encoded using the <c>EncodeBinaryXXX</c> methods.
+        /// </summary>
+        /// <returns>Encoded element data.</returns>
+        /// <remarks>
+        /// By default, this method encodes no data. Subclasses that have
+        /// data to encode must override this.
+        /// </remarks>
+        public virtual string EncodeBinary()
+        {
+            return String.Empty;
+        }
+
         /// <summary>
         /// Returns a user control to edit this pipeline element. The control
         /// must be data-bound to the element somehow.
@@ -717,6 +813,57 @@ namespace PathCopyCopy.Settings.Core.Plugins
             // Encode as 0 or 1.
             return toEncode ? "1" : "0";
         }
+
+        /// <summary>
+        /// Encodes the specified int value in binary format, suitable to be
+        /// included in binary-encoded element data.
+        /// </summary>
+        /// <param name="toEncode">Int value to encode.</param>
+        /// <returns>Encoded string.</returns>
+        public static string EncodeBinaryInt(int toEncode)
+        {
+            // Encode as two characters: low 16 bits then high 16 bits.
+            return new string(new char[] { (char) (toEncode & 0xFFFF), (char) ((toEncode >> 16) & 0xFFFF) });
+        }
+
+        /// <summary>
+        /// Encodes the specified string in binary format, suitable to be
+        /// included in binary-encoded element data.
+        /// </summary>
+        /// <param name="toEncode">String to encode.</param>
+        /// <returns>Encoded string.</returns>
+        public static string EncodeBinaryString(string toEncode)
+        {
+            // First write the string length, then the string content.
+            return EncodeBinaryInt(toEncode.Length) + toEncode;
+        }
+
+        /// <summary>
+        /// Encodes the specified boolean in binary format, suitable to be
+        /// included in binary-encoded element data.
+        /// </summary>
+        /// <param name="toEncode">Bool to encode.</param>
+        /// <returns>Encoded string.</returns>
+        public static string EncodeBinaryBool(bool toEncode)
+        {
+            // Encode as a character with value 0 or 1.
+            return toEncode ? "\u0001" : "\0";
+        }
+
+        /// <summary>
+        /// Encodes the specified GUID in binary format, suitable to be
+        /// included in binary-encoded element data.
+        /// </summary>
+        /// <param name="toEncode">GUID to encode.</param>
+        /// <returns>Encoded string.</returns>
+        public static string EncodeBinaryGuid(Guid toEncode)
+        {
+            // Encode the GUID's bytes as-is, as they are laid out in memory in C++.
+            byte[] guidBytes = toEncode.ToByteArray();
+            char[] guidChars = new char[guidBytes.Length / sizeof(char)];
+            Buffer.BlockCopy(guidBytes, 0, guidChars, 0, guidBytes.Length);
+            return new string(guidChars);
+        }
     }
     
     /// <summary>
@@ -729,6 +876,30 @@ namespace PathCopyCopy.Settings.Core.Plugins
     /// encoding/decoding work.</remarks>
     public sealed class Pipeline
     {
+        /// <summary>
+        /// Character found at the start of pipelines encoded in binary format.
+        /// Pipelines encoded in text format start with a digit instead.
+        /// </summary>
+        public const char BINARY_FORMAT_SIGNATURE = '\u0001';
+
+        /// <summary>
+        /// Version of the binary format used to encode pipelines.
+        /// </summary>
+        public const char BINARY_FORMAT_VERSION = '\u0001';
+
+        /// <summary>
+        /// Maximum number of elements that can be stored in the two-character
+        /// element count at the start of pipelines encoded in text format.
+        /// </summary>
+        public const int MAX_TWO_CHAR_COUNT_ELEMENTS = 99;
+
+        /// <summary>
+        /// Character found at the start of pipelines encoded in text format
+        /// that have more than <see cref="MAX_TWO_CHAR_COUNT_ELEMENTS"/> elements.
+        /// It is followed by the number of elements, encoded as a string.
+        /// </summary>
+        public const char ELEMENT_COUNT_STRING_PREFIX = '+';
+
         /// List containing all pipeline elements.
         private List<PipelineElement> pipelineElements = new List<PipelineElement>();
 
@@ -745,11 +916,15 @@ namespace PathCopyCopy.Settings.Core.Plugins
         /// <summary>
         /// Minimum version of Path Copy Copy required to use this pipeline. This
         /// amounts to the highest required version of all its pipeline elements.
+        /// Pipelines with many elements also require a version supporting them.
         /// </summary>
         public Version RequiredVersion
         {
             get {
                 Version reqdVersion = PipelinePluginInfo.DEFAULT_REQUIRED_VERSION;
+                if (pipelineElements.Count > MAX_TWO_CHAR_COUNT_ELEMENTS) {
+                    reqdVersion = new Version(18, 0, 0, 0);
+                }
                 foreach (PipelineElement element in pipelineElements) {
                     if (element.RequiredVersion.CompareTo(reqdVersion) > 0) {
                         reqdVersion = element.RequiredVersion;
@@ -766,9 +941,14 @@ namespace PathCopyCopy.Settings.Core.Plugins
         public string Encode()
         {
             // First write the number of elements in the pipeline as a two-char number.
-            Debug.Assert(Elements.Count < 100);
+            // If there are too many elements for this, write it as a string instead.
             StringBuilder encodedElements = new StringBuilder();
-            encodedElements.Append(Elements.Count.ToString("D2"));
+            if (Elements.Count > MAX_TWO_CHAR_COUNT_ELEMENTS) {
+                encodedElements.Append(ELEMENT_COUNT_STRING_PREFIX);
+                encodedElements.Append(PipelineElement.EncodeString(Elements.Count.ToString()));
+            } else {
+                encodedElements.Append(Elements.Count.ToString("D2"));
+            }
 
             // Encode each pipeline element by first appending its code then
             // asking the element itself to encode its data.
@@ -779,6 +959,30 @@ namespace PathCopyCopy.Settings.Core.Plugins
 
             return encodedElements.ToString();
         }
+
+        /// <summary>
+        /// Encodes the pipeline's elements in binary format. Binary-encoded
+        /// pipelines are stored in binary registry values and are faster to
+        /// decode than pipelines encoded in text format.
+        /// </summary>
+        /// <returns>Encoded pipeline elements.</returns>
+        public string EncodeBinary()
+        {
+            // First write the signature and version, then the number of elements.
+            StringBuilder encodedElements = new StringBuilder();
+            encodedElements.Append(BINARY_FORMAT_SIGNATURE);
+            encodedElements.Append(BINARY_FORMAT_VERSION);
+            encodedElements.Append(PipelineElement.EncodeBinaryInt(Elements.Count));
+
+            // Encode each pipeline element by first appending its code then
+            // asking the element itself to encode its data.
+            foreach (PipelineElement element in Elements) {
+                encodedElements.Append(element.Code);
+                encodedElements.Append(element.EncodeBinary());
+            }
+
+            return encodedElements.ToString();
+        }
         
         /// <summary>
         /// Clears the pipeline of all its elements.
@@ -1220,14 +1424,15 @@ namespace PathCopyCopy.Settings.Core.Plugins
     }
     
     /// <summary>
-    /// Pipeline element that performs a find & replace operation in the path.
+    /// Pipeline element that resolves junctions and symbolic links found in
+    /// the path to get the final path to the file.
     /// </summary>
-    public class FindReplacePipelineElement : PipelineElement
+    public class FinalPathPipelineElement : PipelineElement
     {
         /// <summary>
         /// Code representing this pipeline element type.
         /// </summary>
-        public const char CODE = '?';
+        public const char CODE = 'l';
 
         /// <summary>
         /// Code representing this pipeline element type.
@@ -1245,89 +1450,171 @@ namespace PathCopyCopy.Settings.Core.Plugins
         public override string DisplayValue
         {
             get {
-                return Resources.PipelineElement_FindReplace;
+                return Resources.PipelineElement_FinalPath;
             }
         }
 
         /// <summary>
-        /// Value to look for in the path.
+        /// Minumum version of Path Copy Copy required to use this pipeline element.
         /// </summary>
-        /// <seealso cref="NewValue"/>
-        public string OldValue
+        public override Version RequiredVersion
         {
-            get;
-            set;
+            get {
+                return new Version(18, 0, 0, 0);
+            }
         }
 
         /// <summary>
-        /// Replacement value.
+        /// Encodes this pipeline element in a string.
         /// </summary>
-        /// <seealso cref="OldValue"/>
-        public string NewValue
+        /// <returns>Encoded element data.</returns>
+        public override string Encode()
         {
-            get;
-            set;
+            // No other data to encode.
+            return String.Empty;
         }
-        
+    }
+    
+    /// <summary>
+    /// Pipeline element that replaces the beginning of the path with the
+    /// environment variable containing it, like %APPDATA%.
+    /// </summary>
+    public class EnvironmentVariablesPipelineElement : PipelineElement
+    {
         /// <summary>
-        /// Default constructor.
+        /// Code representing this pipeline element type.
         /// </summary>
-        public FindReplacePipelineElement()
+        public const char CODE = 'v';
+
+        /// <summary>
+        /// Code representing this pipeline element type.
+        /// </summary>
+        public override char Code
         {
-            OldValue = String.Empty;
-            NewValue = String.Empty;
+            get {
+                return CODE;
+            }
         }
-        
+
         /// <summary>
-        /// Constructor with old and new values.
+        /// Pipeline element display value for the UI.
         /// </summary>
-        /// <param name="oldValue">Value to look for.</param>
-        /// <param name="newValue">Replacement value.</param>
-        public FindReplacePipelineElement(string oldValue, string newValue)
+        public override string DisplayValue
         {
-            OldValue = oldValue;
-            NewValue = newValue;
+            get {
+                return Resources.PipelineElement_EnvironmentVariables;
+            }
         }
-        
+
+        /// <summary>
+        /// Minumum version of Path Copy Copy required to use this pipeline element.
+        /// </summary>
+        public override Version RequiredVersion
+        {
+            get {
+                return new Version(18, 0, 0, 0);
+            }
+        }
+
         /// <summary>
         /// Encodes this pipeline element in a string.
         /// </summary>
         /// <returns>Encoded element data.</returns>
         public override string Encode()
         {
-            // Encode old and new value one after the other.
-            return EncodeString(OldValue) + EncodeString(NewValue);
+            // No other data to encode.
+            return String.Empty;
         }
+    }
+    
+    /// <summary>
+    /// Pipeline element that prepends the SHA-256 hash of the file's content
+    /// to the path, in the format used by sha256sum.
+    /// </summary>
+    public class ContentHashPipelineElement : PipelineElement
+    {
+        /// <summary>
+        /// Code representing this pipeline element type.
+        /// </summary>
+        public const char CODE = 'h';
 
         /// <summary>
-        /// Returns a user control to configure this pipeline element.
+        /// Code representing this pipeline element type.
         /// </summary>
-        /// <returns>User control.</returns>
-        public override PipelineElementUserControl GetEditingControl()
+        public override char Code
         {
-            return new FindReplacePipelineElementUserControl(this);
+            get {
+                return CODE;
+            }
+        }
+
+        /// <summary>
+        /// Pipeline element display value for the UI.
+        /// </summary>
+        public override string DisplayValue
+        {
+            get {
+                return Resources.PipelineElement_ContentHash;
+            }
+        }
+
+        /// <summary>
+        /// Minumum version of Path Copy Copy required to use this pipeline element.
+        /// </summary>
+        public override Version RequiredVersion
+        {
+            get {
+                return new Version(18, 0, 0, 0);
+            }
+        }
+
+        /// <summary>
+        /// Encodes this pipeline element in a string.
+        /// </summary>
+        /// <returns>Encoded element data.</returns>
+        public override string Encode()
+        {
+            // No other data to encode.
+            return String.Empty;
         }
     }
     
     /// <summary>
-    /// Pipeline element that performs find/replace operations using regex.
+    /// Unicode normalization forms that can be applied to paths by a
+    /// <see cref="UnicodeNormalizationPipelineElement"/>.
     /// </summary>
-    public class RegexPipelineElement : PipelineElement
+    public enum NormalizationForm
     {
         /// <summary>
-        /// Version number used to identify encoded data.
+        /// Canonical composition, used by most Linux tools.
         /// </summary>
-        public const int INITIAL_VERSION = 1;
+        NFC = 1,
 
         /// <summary>
-        /// Maximum data version understood by this code.
+        /// Canonical decomposition, used by macOS file systems.
         /// </summary>
-        public const int MAX_VERSION = INITIAL_VERSION;
+        NFD = 2,
+    }
 
+    /// <summary>
+    /// Pipeline element that converts the path to a Unicode normalization form.
+    /// </summary>
+    public class UnicodeNormalizationPipelineElement : PipelineElement
+    {
         /// <summary>
         /// Code representing this pipeline element type.
         /// </summary>
-        public const char CODE = '^';
+        public const char CODE = 'n';
+
+        /// <summary>
+        /// Version number used to identify encoded data for this element.
+        /// </summary>
+        public const int INITIAL_VERSION = 1;
+
+        /// <summary>
+        /// Max version number supported by this element.
+        /// </summary>
+        public const int MAX_VERSION = INITIAL_VERSION;
 
         /// <summary>
         /// Code representing this pipeline element type.
@@ -1345,112 +1632,1447 @@ namespace PathCopyCopy.Settings.Core.Plugins
         public override string DisplayValue
         {
             get {
-                return Resources.PipelineElement_Regex;
+                return Form == NormalizationForm.NFD ? Resources.PipelineElement_NormalizeNFD
+                                                     : Resources.PipelineElement_NormalizeNFC;
             }
         }
 
         /// <summary>
-        /// Minumum version of Path Copy Copy required to use this pipeline element.
+        /// Minimum version of Path Copy Copy required to use this pipeline element.
         /// </summary>
         public override Version RequiredVersion
         {
             get {
-                return new Version(10, 0, 0, 0);
+                return new Version(18, 0, 0, 0);
             }
         }
 
         /// <summary>
-        /// Regular expression to use to find matches.
+        /// Normalization form to convert paths to.
         /// </summary>
-        /// <remarks>
-        /// The shell extension doesn't use the .NET regex syntax since it
-        /// uses the std::regex class to perform matches. It uses the
-        /// ECMAScript regex syntax.
-        /// </remarks>
-        public string Regex
+        public NormalizationForm Form
         {
             get;
             set;
         }
 
         /// <summary>
-        /// Format of replacement string.
+        /// Default constructor.
         /// </summary>
-        public string Format
+        public UnicodeNormalizationPipelineElement()
+            : this(NormalizationForm.NFC)
         {
-            get;
-            set;
         }
 
         /// <summary>
-        /// Whether to ignore case when looking for matches.
+        /// Constructor with arguments.
         /// </summary>
-        public bool IgnoreCase
+        /// <param name="form">Normalization form to convert paths to.</param>
+        public UnicodeNormalizationPipelineElement(NormalizationForm form)
         {
-            get;
-            set;
+            Form = form;
         }
-        
+
         /// <summary>
-        /// Default constructor.
+        /// Encodes this pipeline element in a string.
         /// </summary>
-        public RegexPipelineElement()
+        /// <returns>Encoded element data.</returns>
+        public override string Encode()
         {
-            Regex = String.Empty;
-            Format = String.Empty;
+            // Version number first, then normalization form.
+            StringBuilder encoder = new StringBuilder();
+            encoder.Append(EncodeInt(INITIAL_VERSION));
+            encoder.Append(EncodeInt((int) Form));
+            return encoder.ToString();
         }
-        
+
+        /// <summary>
+        /// Encodes this pipeline element in binary format.
+        /// </summary>
+        /// <returns>Encoded element data.</returns>
+        public override string EncodeBinary()
+        {
+            // Same data as in text format.
+            StringBuilder encoder = new StringBuilder();
+            encoder.Append(EncodeBinaryInt(INITIAL_VERSION));
+            encoder.Append(EncodeBinaryInt((int) Form));
+            return encoder.ToString();
+        }
+    }
+    
+    /// <summary>
+    /// How a <see cref="GuardPipelineElement"/> compares paths with its value.
+    /// </summary>
+    public enum GuardMatch
+    {
+        /// <summary>
+        /// Path must start with the value.
+        /// </summary>
+        Prefix = 1,
+
+        /// <summary>
+        /// Path must contain the value.
+        /// </summary>
+        Contains = 2,
+    }
+
+    /// <summary>
+    /// What a <see cref="GuardPipelineElement"/> does with paths that do not match.
+    /// </summary>
+    public enum GuardAction
+    {
+        /// <summary>
+        /// Skip the rest of the pipeline; the path is copied as-is.
+        /// </summary>
+        Skip = 1,
+
+        /// <summary>
+        /// Skip the rest of the pipeline and disable the command.
+        /// </summary>
+        Disable = 2,
+    }
+
+    /// <summary>
+    /// Pipeline element that checks whether the path starts with or contains
+    /// a value. Paths that do not match skip the rest of the pipeline.
+    /// </summary>
+    public class GuardPipelineElement : PipelineElement
+    {
+        /// <summary>
+        /// Code representing this pipeline element type.
+        /// </summary>
+        public const char CODE = 'g';
+
+        /// <summary>
+        /// Version number used to identify encoded data for this element.
+        /// </summary>
+        public const int INITIAL_VERSION = 1;
+
+        /// <summary>
+        /// Max version number supported by this element.
+        /// </summary>
+        public const int MAX_VERSION = INITIAL_VERSION;
+
+        /// <summary>
+        /// Code representing this pipeline element type.
+        /// </summary>
+        public override char Code
+        {
+            get {
+                return CODE;
+            }
+        }
+
+        /// <summary>
+        /// Pipeline element display value for the UI.
+        /// </summary>
+        public override string DisplayValue
+        {
+            get {
+                return Resources.PipelineElement_Guard;
+            }
+        }
+
+        /// <summary>
+        /// Minimum version of Path Copy Copy required to use this pipeline element.
+        /// </summary>
+        public override Version RequiredVersion
+        {
+            get {
+                return new Version(18, 0, 0, 0);
+            }
+        }
+
+        /// <summary>
+        /// Value to look for in paths.
+        /// </summary>
+        public string Value
+        {
+            get;
+            set;
+        }
+
+        /// <summary>
+        /// How to look for <see cref="Value"/> in paths.
+        /// </summary>
+        public GuardMatch Match
+        {
+            get;
+            set;
+        }
+
+        /// <summary>
+        /// Whether to ignore case when looking for <see cref="Value"/>.
+        /// </summary>
+        public bool IgnoreCase
+        {
+            get;
+            set;
+        }
+
+        /// <summary>
+        /// What to do with paths that do not match.
+        /// </summary>
+        public GuardAction Action
+        {
+            get;
+            set;
+        }
+
+        /// <summary>
+        /// Default constructor.
+        /// </summary>
+        public GuardPipelineElement()
+            : this(String.Empty, GuardMatch.Prefix, true, GuardAction.Skip)
+        {
+        }
+
         /// <summary>
         /// Constructor with arguments.
         /// </summary>
-        /// <param name="regex">Regular expression to use.</param>
-        /// <param name="format">Format of replacement string.</param>
+        /// <param name="value">Value to look for in paths.</param>
+        /// <param name="match">How to look for <paramref name="value"/>.</param>
         /// <param name="ignoreCase">Whether to ignore case when looking for
-        /// matches.</param>
-        public RegexPipelineElement(string regex, string format, bool ignoreCase)
+        /// <paramref name="value"/>.</param>
+        /// <param name="action">What to do with paths that do not match.</param>
+        public GuardPipelineElement(string value, GuardMatch match, bool ignoreCase, GuardAction action)
         {
-            Regex = regex;
-            Format = format;
+            Value = value;
+            Match = match;
             IgnoreCase = ignoreCase;
+            Action = action;
         }
-        
+
         /// <summary>
         /// Encodes this pipeline element in a string.
         /// </summary>
         /// <returns>Encoded element data.</returns>
         public override string Encode()
         {
-            // First write currently-used version number.
+            // Version number first, then value, match, ignore case and action.
             StringBuilder encoder = new StringBuilder();
             encoder.Append(EncodeInt(INITIAL_VERSION));
-
-            // Now encode regex, format string and ignore case flag.
-            encoder.Append(EncodeString(Regex));
-            encoder.Append(EncodeString(Format));
+            encoder.Append(EncodeString(Value));
+            encoder.Append(EncodeInt((int) Match));
             encoder.Append(EncodeBool(IgnoreCase));
+            encoder.Append(EncodeInt((int) Action));
+            return encoder.ToString();
+        }
 
+        /// <summary>
+        /// Encodes this pipeline element in binary format.
+        /// </summary>
+        /// <returns>Encoded element data.</returns>
+        public override string EncodeBinary()
+        {
+            // Same data as in text format.
+            StringBuilder encoder = new StringBuilder();
+            encoder.Append(EncodeBinaryInt(INITIAL_VERSION));
+            encoder.Append(EncodeBinaryString(Value));
+            encoder.Append(EncodeBinaryInt((int) Match));
+            encoder.Append(EncodeBinaryBool(IgnoreCase));
+            encoder.Append(EncodeBinaryInt((int) Action));
+            return encoder.ToString();
+        }
+
+        /// <summary>
+        /// Returns a user control to configure this pipeline element.
+        /// </summary>
+        /// <returns>User control instance.</returns>
+        public override PipelineElementUserControl GetEditingControl()
+        {
+            return new GuardPipelineElementUserControl(this);
+        }
+    }
+    
+    /// <summary>
+    /// Pipeline element that performs a find & replace operation in the path.
+    /// </summary>
+    public class FindReplacePipelineElement : PipelineElement
+    {
+        /// <summary>
+        /// Code representing this pipeline element type.
+        /// </summary>
+        public const char CODE = '?';
+
+        /// <summary>
+        /// Code representing this pipeline element type when ignoring case.
+        /// </summary>
+        public const char IGNORE_CASE_CODE = 'i';
+
+        /// <summary>
+        /// Code representing this pipeline element type.
+        /// </summary>
+        public override char Code
+        {
+            get {
+                return IgnoreCase ? IGNORE_CASE_CODE : CODE;
+            }
+        }
+
+        /// <summary>
+        /// Pipeline element display value for the UI.
+        /// </summary>
+        public override string DisplayValue
+        {
+            get {
+                return Resources.PipelineElement_FindReplace;
+            }
+        }
+
+        /// <summary>
+        /// Minumum version of Path Copy Copy required to use this pipeline element.
+        /// </summary>
+        /// <remarks>
+        /// Ignoring case requires a newer version, since it uses another element code.
+        /// </remarks>
+        public override Version RequiredVersion
+        {
+            get {
+                return IgnoreCase ? new Version(18, 0, 0, 0) : base.RequiredVersion;
+            }
+        }
+
+        /// <summary>
+        /// Value to look for in the path.
+        /// </summary>
+        /// <seealso cref="NewValue"/>
+        public string OldValue
+        {
+            get;
+            set;
+        }
+
+        /// <summary>
+        /// Replacement value.
+        /// </summary>
+        /// <seealso cref="OldValue"/>
+        public string NewValue
+        {
+            get;
+            set;
+        }
+
+        /// <summary>
+        /// Whether to ignore case when looking for <see cref="OldValue"/>.
+        /// </summary>
+        public bool IgnoreCase
+        {
+            get;
+            set;
+        }
+        
+        /// <summary>
+        /// Default constructor.
+        /// </summary>
+        public FindReplacePipelineElement()
+        {
+            OldValue = String.Empty;
+            NewValue = String.Empty;
+        }
+        
+        /// <summary>
+        /// Constructor with old and new values.
+        /// </summary>
+        /// <param name="oldValue">Value to look for.</param>
+        /// <param name="newValue">Replacement value.</param>
+        public FindReplacePipelineElement(string oldValue, string newValue)
+            : this(oldValue, newValue, false)
+        {
+        }
+        
+        /// <summary>
+        /// Constructor with old and new values and case sensitivity.
+        /// </summary>
+        /// <param name="oldValue">Value to look for.</param>
+        /// <param name="newValue">Replacement value.</param>
+        /// <param name="ignoreCase">Whether to ignore case when looking
+        /// for <paramref name="oldValue"/>.</param>
+        public FindReplacePipelineElement(string oldValue, string newValue, bool ignoreCase)
+        {
+            OldValue = oldValue;
+            NewValue = newValue;
+            IgnoreCase = ignoreCase;
+        }
+        
+        /// <summary>
+        /// Encodes this pipeline element in a string.
+        /// </summary>
+        /// <returns>Encoded element data.</returns>
+        public override string Encode()
+        {
+            // Encode old and new value one after the other.
+            return EncodeString(OldValue) + EncodeString(NewValue);
+        }
+
+        /// <summary>
+        /// Encodes this pipeline element in binary format.
+        /// </summary>
+        /// <returns>Encoded element data.</returns>
+        public override string EncodeBinary()
+        {
+            return EncodeBinaryString(OldValue) + EncodeBinaryString(NewValue);
+        }
+
+        /// <summary>
+        /// Returns a user control to configure this pipeline element.
+        /// </summary>
+        /// <returns>User control.</returns>
+        public override PipelineElementUserControl GetEditingControl()
+        {
+            return new FindReplacePipelineElementUserControl(this);
+        }
+    }
+    
+    /// <summary>
+    /// Regex engines that can be used by a <see cref="RegexPipelineElement"/>.
+    /// </summary>
+    public enum RegexEngine
+    {
+        /// <summary>
+        /// Standard regex engine (std::wregex).
+        /// </summary>
+        Standard = 0,
+
+        /// <summary>
+        /// Fast regex engine supporting a subset of the syntax. Falls back to
+        /// the standard engine for unsupported regular expressions.
+        /// </summary>
+        Fast = 1,
+    }
+
+    /// <summary>
+    /// Pipeline element that performs find/replace operations using regex.
+    /// </summary>
+    public class RegexPipelineElement : PipelineElement
+    {
+        /// <summary>
+        /// Version number used to identify encoded data.
+        /// </summary>
+        public const int INITIAL_VERSION = 1;
+
+        /// <summary>
+        /// Version number of encoded data including the regex engine to use.
+        /// </summary>
+        public const int ENGINE_VERSION = 2;
+
+        /// <summary>
+        /// Maximum data version understood by this code.
+        /// </summary>
+        public const int MAX_VERSION = ENGINE_VERSION;
+
+        /// <summary>
+        /// Code representing this pipeline element type.
+        /// </summary>
+        public const char CODE = '^';
+
+        /// <summary>
+        /// Code representing this pipeline element type.
+        /// </summary>
+        public override char Code
+        {
+            get {
+                return CODE;
+            }
+        }
+
+        /// <summary>
+        /// Pipeline element display value for the UI.
+        /// </summary>
+        public override string DisplayValue
+        {
+            get {
+                return Resources.PipelineElement_Regex;
+            }
+        }
+
+        /// <summary>
+        /// Minumum version of Path Copy Copy required to use this pipeline element.
+        /// </summary>
+        /// <remarks>
+        /// Using the fast regex engine requires a newer version.
+        /// </remarks>
+        public override Version RequiredVersion
+        {
+            get {
+                return Engine != RegexEngine.Standard ? new Version(18, 0, 0, 0) : new Version(10, 0, 0, 0);
+            }
+        }
+
+        /// <summary>
+        /// Regular expression to use to find matches.
+        /// </summary>
+        /// <remarks>
+        /// The shell extension doesn't use the .NET regex syntax since it
+        /// uses the std::regex class to perform matches. It uses the
+        /// ECMAScript regex syntax.
+        /// </remarks>
+        public string Regex
+        {
+            get;
+            set;
+        }
+
+        /// <summary>
+        /// Format of replacement string.
+        /// </summary>
+        public string Format
+        {
+            get;
+            set;
+        }
+
+        /// <summary>
+        /// Whether to ignore case when looking for matches.
+        /// </summary>
+        public bool IgnoreCase
+        {
+            get;
+            set;
+        }
+
+        /// <summary>
+        /// Regex engine to use to perform find/replace operations.
+        /// </summary>
+        public RegexEngine Engine
+        {
+            get;
+            set;
+        }
+        
+        /// <summary>
+        /// Default constructor.
+        /// </summary>
+        public RegexPipelineElement()
+        {
+            Regex = String.Empty;
+            Format = String.Empty;
+            Engine = RegexEngine.Standard;
+        }
+        
+        /// <summary>
+        /// Constructor with arguments.
+        /// </summary>
+        /// <param name="regex">Regular expression to use.</param>
+        /// <param name="format">Format of replacement string.</param>
+        /// <param name="ignoreCase">Whether to ignore case when looking for
+        /// matches.</param>
+        public RegexPipelineElement(string regex, string format, bool ignoreCase)
+            : this(regex, format, ignoreCase, RegexEngine.Standard)
+        {
+        }
+        
+        /// <summary>
+        /// Constructor with arguments including regex engine.
+        /// </summary>
+        /// <param name="regex">Regular expression to use.</param>
+        /// <param name="format">Format of replacement string.</param>
+        /// <param name="ignoreCase">Whether to ignore case when looking for
+        /// matches.</param>
+        /// <param name="engine">Regex engine to use.</param>
+        public RegexPipelineElement(string regex, string format, bool ignoreCase, RegexEngine engine)
+        {
+            Regex = regex;
+            Format = format;
+            IgnoreCase = ignoreCase;
+            Engine = engine;
+        }
+        
+        /// <summary>
+        /// Encodes this pipeline element in a string.
+        /// </summary>
+        /// <returns>Encoded element data.</returns>
+        public override string Encode()
+        {
+            // First write currently-used version number. We only use the
+            // engine version if needed, so that older versions can still
+            // decode elements using the standard engine.
+            StringBuilder encoder = new StringBuilder();
+            encoder.Append(EncodeInt(Engine != RegexEngine.Standard ? ENGINE_VERSION : INITIAL_VERSION));
+
+            // Now encode regex, format string and ignore case flag.
+            encoder.Append(EncodeString(Regex));
+            encoder.Append(EncodeString(Format));
+            encoder.Append(EncodeBool(IgnoreCase));
+
+            // Engine version: encode regex engine.
+            if (Engine != RegexEngine.Standard) {
+                encoder.Append(EncodeInt((int) Engine));
+            }
+
+            return encoder.ToString();
+        }
+
+        /// <summary>
+        /// Encodes this pipeline element in binary format.
+        /// </summary>
+        /// <returns>Encoded element data.</returns>
+        public override string EncodeBinary()
+        {
+            // Same data as in text format.
+            StringBuilder encoder = new StringBuilder();
+            encoder.Append(EncodeBinaryInt(Engine != RegexEngine.Standard ? ENGINE_VERSION : INITIAL_VERSION));
+            encoder.Append(EncodeBinaryString(Regex));
+            encoder.Append(EncodeBinaryString(Format));
+            encoder.Append(EncodeBinaryBool(IgnoreCase));
+            if (Engine != RegexEngine.Standard) {
+                encoder.Append(EncodeBinaryInt((int) Engine));
+            }
+            return encoder.ToString();
+        }
+
+        /// <summary>
+        /// Returns a user control to configure this pipeline element.
+        /// </summary>
+        /// <returns>User control.</returns>
+        public override PipelineElementUserControl GetEditingControl()
+        {
+            return new RegexPipelineElementUserControl(this);
+        }
+    }
+    
+    /// <summary>
+    /// Possible sources of the table used by a <see cref="PrefixMappingPipelineElement"/>.
+    /// </summary>
+    public enum PrefixMappingSource
+    {
+        /// <summary>
+        /// Table is stored in the pipeline element itself.
+        /// </summary>
+        Inline = 0,
+
+        /// <summary>
+        /// Table is stored in a text file.
+        /// </summary>
+        File = 1,
+
+        /// <summary>
+        /// Table is stored in a string value in the PrefixMappings registry key.
+        /// </summary>
+        Registry = 2,
+    }
+
+    /// <summary>
+    /// Pipeline element that replaces the longest prefix of the path found
+    /// in a table of prefixes and replacement values.
+    /// </summary>
+    /// <remarks>
+    /// Tables contain one entry per line. Each line contains a prefix and its
+    /// replacement, separated by a tab. Empty lines and lines starting with
+    /// a semicolon are ignored.
+    /// </remarks>
+    public class PrefixMappingPipelineElement : PipelineElement
+    {
+        /// <summary>
+        /// Version number used to identify encoded data.
+        /// </summary>
+        public const int INITIAL_VERSION = 1;
+
+        /// <summary>
+        /// Maximum data version understood by this code.
+        /// </summary>
+        public const int MAX_VERSION = INITIAL_VERSION;
+
+        /// <summary>
+        /// Code representing this pipeline element type.
+        /// </summary>
+        public const char CODE = 'm';
+
+        /// <summary>
+        /// Code representing this pipeline element type.
+        /// </summary>
+        public override char Code
+        {
+            get {
+                return CODE;
+            }
+        }
+
+        /// <summary>
+        /// Pipeline element display value for the UI.
+        /// </summary>
+        public override string DisplayValue
+        {
+            get {
+                return Resources.PipelineElement_PrefixMapping;
+            }
+        }
+
+        /// <summary>
+        /// Minumum version of Path Copy Copy required to use this pipeline element.
+        /// </summary>
+        public override Version RequiredVersion
+        {
+            get {
+                return new Version(18, 0, 0, 0);
+            }
+        }
+
+        /// <summary>
+        /// Source of the mapping table.
+        /// </summary>
+        public PrefixMappingSource Source
+        {
+            get;
+            set;
+        }
+
+        /// <summary>
+        /// Contents of the mapping table if <see cref="Source"/> is
+        /// <see cref="PrefixMappingSource.Inline"/>; otherwise, path of the
+        /// file or name of the registry value containing the table.
+        /// </summary>
+        public string Table
+        {
+            get;
+            set;
+        }
+
+        /// <summary>
+        /// Whether to ignore case when looking for prefixes.
+        /// </summary>
+        public bool IgnoreCase
+        {
+            get;
+            set;
+        }
+
+        /// <summary>
+        /// Default constructor.
+        /// </summary>
+        public PrefixMappingPipelineElement()
+        {
+            Source = PrefixMappingSource.Inline;
+            Table = String.Empty;
+        }
+
+        /// <summary>
+        /// Constructor with arguments.
+        /// </summary>
+        /// <param name="source">Source of the mapping table.</param>
+        /// <param name="table">Contents of the mapping table, or its location
+        /// if <paramref name="source"/> is not <see cref="PrefixMappingSource.Inline"/>.</param>
+        /// <param name="ignoreCase">Whether to ignore case when looking for
+        /// prefixes.</param>
+        public PrefixMappingPipelineElement(PrefixMappingSource source, string table, bool ignoreCase)
+        {
+            Source = source;
+            Table = table;
+            IgnoreCase = ignoreCase;
+        }
+
+        /// <summary>
+        /// Encodes this pipeline element in a string.
+        /// </summary>
+        /// <returns>Encoded element data.</returns>
+        public override string Encode()
+        {
+            // Version number first, then source, table and ignore case flag.
+            StringBuilder encoder = new StringBuilder();
+            encoder.Append(EncodeInt(INITIAL_VERSION));
+            encoder.Append(EncodeInt((int) Source));
+            encoder.Append(EncodeString(Table));
+            encoder.Append(EncodeBool(IgnoreCase));
+            return encoder.ToString();
+        }
+
+        /// <summary>
+        /// Encodes this pipeline element in binary format.
+        /// </summary>
+        /// <returns>Encoded element data.</returns>
+        public override string EncodeBinary()
+        {
+            // Same data as in text format.
+            StringBuilder encoder = new StringBuilder();
+            encoder.Append(EncodeBinaryInt(INITIAL_VERSION));
+            encoder.Append(EncodeBinaryInt((int) Source));
+            encoder.Append(EncodeBinaryString(Table));
+            encoder.Append(EncodeBinaryBool(IgnoreCase));
+            return encoder.ToString();
+        }
+
+        /// <summary>
+        /// Returns a user control to configure this pipeline element.
+        /// </summary>
+        /// <returns>User control.</returns>
+        public override PipelineElementUserControl GetEditingControl()
+        {
+            return new PrefixMappingPipelineElementUserControl(this);
+        }
+    }
+    
+    /// <summary>
+    /// Pipeline element that applies the effect of another plugin on the path.
+    /// </summary>
+    public class ApplyPluginPipelineElement : PipelineElement
+    {
+        /// <summary>
+        /// Code representing this pipeline element type.
+        /// </summary>
+        public const char CODE = '{';
+
+        /// <summary>
+        /// Code representing this pipeline element type.
+        /// </summary>
+        public override char Code
+        {
+            get {
+                return CODE;
+            }
+        }
+
+        /// <summary>
+        /// Pipeline element display value for the UI.
+        /// </summary>
+        public override string DisplayValue
+        {
+            get {
+                return Resources.PipelineElement_ApplyPlugin;
+            }
+        }
+
+        /// <summary>
+        /// ID of plugin to apply to the path.
+        /// </summary>
+        public Guid PluginID
+        {
+            get;
+            set;
+        }
+        
+        /// <summary>
+        /// Default constructor.
+        /// </summary>
+        public ApplyPluginPipelineElement()
+        {
+            PluginID = Guid.Empty;
+        }
+        
+        /// <summary>
+        /// Constructor with plugin ID.
+        /// </summary>
+        /// <param name="pluginId">ID of plugin to apply to the path.</param>
+        public ApplyPluginPipelineElement(Guid pluginId)
+        {
+            PluginID = pluginId;
+        }
+        
+        /// <summary>
+        /// Encodes this pipeline element in a string.
+        /// </summary>
+        /// <returns>Encoded element data.</returns>
+        public override string Encode()
+        {
+            // We encode our guid without length info, since the C++
+            // side will know how many characters to read.
+            return PluginID.ToString("B");
+        }
+
+        /// <summary>
+        /// Encodes this pipeline element in binary format.
+        /// </summary>
+        /// <returns>Encoded element data.</returns>
+        public override string EncodeBinary()
+        {
+            return EncodeBinaryGuid(PluginID);
+        }
+
+        /// <summary>
+        /// Returns a user control to configure this pipeline element.
+        /// </summary>
+        /// <returns>User control.</returns>
+        public override PipelineElementUserControl GetEditingControl()
+        {
+            return new ApplyPluginPipelineElementUserControl(this);
+        }
+    }
+
+    /// <summary>
+    /// Pipeline element that replaces the path with a format template
+    /// combining literal text and the outputs of other plugins.
+    /// </summary>
+    /// <remarks>
+    /// Plugins are referenced with <c>{plugin:id}</c> placeholders, where
+    /// <c>id</c> is the plugin's ID. <c>{path}</c> is replaced by the path as
+    /// it was before the element; <c>{{</c> and <c>}}</c> produce literal braces.
+    /// Each referenced plugin is applied only once per path.
+    /// </remarks>
+    public class TemplatePipelineElement : PipelineElement
+    {
+        /// <summary>
+        /// Version number used to identify encoded data.
+        /// </summary>
+        public const int INITIAL_VERSION = 1;
+
+        /// <summary>
+        /// Maximum data version understood by this code.
+        /// </summary>
+        public const int MAX_VERSION = INITIAL_VERSION;
+
+        /// <summary>
+        /// Code representing this pipeline element type.
+        /// </summary>
+        public const char CODE = 't';
+
+        /// <summary>
+        /// Placeholder replaced by the path as it was before the element.
+        /// </summary>
+        public const string PATH_PLACEHOLDER = "{path}";
+
+        /// <summary>
+        /// Code representing this pipeline element type.
+        /// </summary>
+        public override char Code
+        {
+            get {
+                return CODE;
+            }
+        }
+
+        /// <summary>
+        /// Pipeline element display value for the UI.
+        /// </summary>
+        public override string DisplayValue
+        {
+            get {
+                return Resources.PipelineElement_Template;
+            }
+        }
+
+        /// <summary>
+        /// Minumum version of Path Copy Copy required to use this pipeline element.
+        /// </summary>
+        public override Version RequiredVersion
+        {
+            get {
+                return new Version(18, 0, 0, 0);
+            }
+        }
+
+        /// <summary>
+        /// Format template used to build the path.
+        /// </summary>
+        public string Template
+        {
+            get;
+            set;
+        }
+
+        /// <summary>
+        /// Default constructor.
+        /// </summary>
+        public TemplatePipelineElement()
+        {
+            Template = PATH_PLACEHOLDER;
+        }
+
+        /// <summary>
+        /// Constructor with arguments.
+        /// </summary>
+        /// <param name="template">Format template used to build the path.</param>
+        public TemplatePipelineElement(string template)
+        {
+            Template = template;
+        }
+
+        /// <summary>
+        /// Returns the placeholder to use in a template to insert the
+        /// output of the given plugin.
+        /// </summary>
+        /// <param name="pluginId">ID of plugin to reference.</param>
+        /// <returns>Placeholder referencing the plugin.</returns>
+        public static string GetPluginPlaceholder(Guid pluginId)
+        {
+            return "{plugin:" + pluginId.ToString("B") + "}";
+        }
+
+        /// <summary>
+        /// Encodes this pipeline element in a string.
+        /// </summary>
+        /// <returns>Encoded element data.</returns>
+        public override string Encode()
+        {
+            // Version number first, then template.
+            StringBuilder encoder = new StringBuilder();
+            encoder.Append(EncodeInt(INITIAL_VERSION));
+            encoder.Append(EncodeString(Template));
+            return encoder.ToString();
+        }
+
+        /// <summary>
+        /// Encodes this pipeline element in binary format.
+        /// </summary>
+        /// <returns>Encoded element data.</returns>
+        public override string EncodeBinary()
+        {
+            // Same data as in text format.
+            StringBuilder encoder = new StringBuilder();
+            encoder.Append(EncodeBinaryInt(INITIAL_VERSION));
+            encoder.Append(EncodeBinaryString(Template));
+            return encoder.ToString();
+        }
+
+        /// <summary>
+        /// Returns a user control to configure this pipeline element.
+        /// </summary>
+        /// <returns>User control.</returns>
+        public override PipelineElementUserControl GetEditingControl()
+        {
+            return new TemplatePipelineElementUserControl(this);
+        }
+    }
+
+    /// <summary>
+    /// Pipeline element that does not modify the path but changes the
+    /// separator used between multiple copied paths.
+    /// </summary>
+    public class PathsSeparatorPipelineElement : PipelineElement
+    {
+        /// <summary>
+        /// Code representing this pipeline element type.
+        /// </summary>
+        public const char CODE = ',';
+
+        /// <summary>
+        /// Code representing this pipeline element type.
+        /// </summary>
+        public override char Code
+        {
+            get {
+                return CODE;
+            }
+        }
+
+        /// <summary>
+        /// Pipeline element display value for the UI.
+        /// </summary>
+        public override string DisplayValue
+        {
+            get {
+                return Resources.PipelineElement_PathsSeparator;
+            }
+        }
+
+        /// <summary>
+        /// Minumum version of Path Copy Copy required to use this pipeline element.
+        /// </summary>
+        public override Version RequiredVersion
+        {
+            get {
+                return new Version(13, 0, 0, 0);
+            }
+        }
+
+        /// <summary>
+        /// Separator to use between multiple paths.
+        /// </summary>
+        public string PathsSeparator
+        {
+            get;
+            set;
+        }
+
+        /// <summary>
+        /// Default constructor.
+        /// </summary>
+        public PathsSeparatorPipelineElement()
+        {
+            PathsSeparator = String.Empty;
+        }
+
+        /// <summary>
+        /// Constructor with arguments.
+        /// </summary>
+        /// <param name="pathsSeparator">Separator to use between multiple paths.</param>
+        public PathsSeparatorPipelineElement(string pathsSeparator)
+        {
+            PathsSeparator = pathsSeparator;
+        }
+
+        /// <summary>
+        /// Encodes this pipeline element in a string.
+        /// </summary>
+        /// <returns>Encoded element data.</returns>
+        public override string Encode()
+        {
+            // Encode the paths separator.
+            return EncodeString(PathsSeparator);
+        }
+
+        /// <summary>
+        /// Encodes this pipeline element in binary format.
+        /// </summary>
+        /// <returns>Encoded element data.</returns>
+        public override string EncodeBinary()
+        {
+            return EncodeBinaryString(PathsSeparator);
+        }
+
+        /// <summary>
+        /// Returns a user control to configure this pipeline element.
+        /// </summary>
+        /// <returns>User control.</returns>
+        public override PipelineElementUserControl GetEditingControl()
+        {
+            return new PathsSeparatorPipelineElementUserControl(this);
+        }
+    }
+
+    /// <summary>
+    /// Abstract subclass of <see cref="PipelineElement"/> that has a
+    /// single data member: an executable path. Used to be able to edit
+    /// both types of executable-based pipeline elements in a common way.
+    /// </summary>
+    abstract public class PipelineElementWithExecutable : PipelineElement
+    {
+        /// <summary>
+        /// Path to executable.
+        /// </summary>
+        public string Executable
+        {
+            get;
+            set;
+        }
+
+        /// <summary>
+        /// Default constructor.
+        /// </summary>
+        public PipelineElementWithExecutable()
+        {
+            Executable = String.Empty;
+        }
+
+        /// <summary>
+        /// Constructor with arguments.
+        /// </summary>
+        /// <param name="executable">Path to executable.</param>
+        public PipelineElementWithExecutable(string executable)
+        {
+            Executable = executable;
+        }
+
+        /// <summary>
+        /// Encodes this pipeline element in a string.
+        /// </summary>
+        /// <returns>Encoded element data.</returns>
+        public override string Encode()
+        {
+            // Encode the executable path.
+            return EncodeString(Executable);
+        }
+
+        /// <summary>
+        /// Encodes this pipeline element in binary format.
+        /// </summary>
+        /// <returns>Encoded element data.</returns>
+        public override string EncodeBinary()
+        {
+            return EncodeBinaryString(Executable);
+        }
+
+        /// <summary>
+        /// Returns a user control to configure this pipeline element.
+        /// </summary>
+        /// <returns>User control.</returns>
+        public override PipelineElementUserControl GetEditingControl()
+        {
+            return new PipelineElementWithExecutableUserControl(this);
+        }
+    }
+
+    /// <summary>
+    /// Pipeline element that does not modify the path but instructs
+    /// Path Copy Copy to launch an executable with path(s) as argument
+    /// instead of copying them to the clipboard.
+    /// </summary>
+    public class ExecutablePipelineElement : PipelineElementWithExecutable
+    {
+        /// <summary>
+        /// Code representing this pipeline element type.
+        /// </summary>
+        public const char CODE = 'x';
+
+        /// <summary>
+        /// Code representing this pipeline element type.
+        /// </summary>
+        public override char Code
+        {
+            get {
+                return CODE;
+            }
+        }
+
+        /// <summary>
+        /// Pipeline element display value for the UI.
+        /// </summary>
+        public override string DisplayValue
+        {
+            get {
+                return Resources.PipelineElement_Executable;
+            }
+        }
+
+        /// <summary>
+        /// Minumum version of Path Copy Copy required to use this pipeline element.
+        /// </summary>
+        public override Version RequiredVersion
+        {
+            get {
+                return new Version(15, 0, 0, 0);
+            }
+        }
+
+        /// <summary>
+        /// Default constructor.
+        /// </summary>
+        public ExecutablePipelineElement()
+            : base()
+        {
+        }
+
+        /// <summary>
+        /// Constructor with arguments.
+        /// </summary>
+        /// <param name="executable">Path to executable.</param>
+        public ExecutablePipelineElement(string executable)
+            : base(executable)
+        {
+        }
+    }
+
+    /// <summary>
+    /// Possible encodings of the filelist written for an
+    /// <see cref="ExecutableWithFilelistPipelineElement"/>.
+    /// </summary>
+    public enum FilelistEncoding
+    {
+        /// <summary>
+        /// Filelist is encoded using the system's ANSI code page.
+        /// </summary>
+        Ansi = 0,
+
+        /// <summary>
+        /// Filelist is encoded in UTF-8, without BOM.
+        /// </summary>
+        Utf8 = 1,
+
+        /// <summary>
+        /// Filelist is encoded in UTF-16 little-endian, with BOM.
+        /// </summary>
+        Utf16LE = 2,
+    }
+
+    /// <summary>
+    /// Possible ways of delivering the filelist to the executable launched
+    /// for an <see cref="ExecutableWithFilelistPipelineElement"/>.
+    /// </summary>
+    public enum FilelistDelivery
+    {
+        /// <summary>
+        /// Filelist is written to a temporary file whose path is passed as argument.
+        /// </summary>
+        TempFile = 0,
+
+        /// <summary>
+        /// Filelist is written to the executable's standard input through a pipe.
+        /// </summary>
+        StdinPipe = 1,
+    }
+
+    /// <summary>
+    /// Pipeline element that does not modify the path but instructs
+    /// Path Copy Copy to launch an executable with filelist as argument
+    /// instead of copying them to the clipboard.
+    /// </summary>
+    public class ExecutableWithFilelistPipelineElement : PipelineElementWithExecutable
+    {
+        /// <summary>
+        /// Code representing this pipeline element type.
+        /// </summary>
+        public const char CODE = 'f';
+
+        /// <summary>
+        /// Code representing this pipeline element type when using
+        /// a filelist encoding other than <see cref="FilelistEncoding.Ansi"/>
+        /// or a delivery other than <see cref="FilelistDelivery.TempFile"/>.
+        /// </summary>
+        public const char ENCODED_FILELIST_CODE = 'F';
+
+        /// <summary>
+        /// Version number used to identify encoded data when using
+        /// <see cref="ENCODED_FILELIST_CODE"/>.
+        /// </summary>
+        public const int INITIAL_VERSION = 1;
+
+        /// <summary>
+        /// Version number where the filelist delivery was added when using
+        /// <see cref="ENCODED_FILELIST_CODE"/>.
+        /// </summary>
+        public const int DELIVERY_VERSION = 2;
+
+        /// <summary>
+        /// Max version number supported by this element when using
+        /// <see cref="ENCODED_FILELIST_CODE"/>.
+        /// </summary>
+        public const int MAX_VERSION = DELIVERY_VERSION;
+
+        /// <summary>
+        /// Code representing this pipeline element type.
+        /// </summary>
+        /// <remarks>
+        /// ANSI filelists passed as temporary files use the original
+        /// code, so that older versions can still decode them.
+        /// </remarks>
+        public override char Code
+        {
+            get {
+                return UsesEncodedFilelistCode ? ENCODED_FILELIST_CODE : CODE;
+            }
+        }
+
+        /// <summary>
+        /// Pipeline element display value for the UI.
+        /// </summary>
+        public override string DisplayValue
+        {
+            get {
+                return Resources.PipelineElement_ExecutableWithFilelist;
+            }
+        }
+
+        /// <summary>
+        /// Minumum version of Path Copy Copy required to use this pipeline element.
+        /// </summary>
+        public override Version RequiredVersion
+        {
+            get {
+                return UsesEncodedFilelistCode ? new Version(18, 0, 0, 0) : new Version(17, 0, 0, 0);
+            }
+        }
+
+        /// <summary>
+        /// Encoding of the filelist.
+        /// </summary>
+        public FilelistEncoding Encoding
+        {
+            get;
+            set;
+        }
+
+        /// <summary>
+        /// How the filelist is delivered to the executable.
+        /// </summary>
+        public FilelistDelivery Delivery
+        {
+            get;
+            set;
+        }
+
+        /// <summary>
+        /// Whether this element needs to be encoded using <see cref="ENCODED_FILELIST_CODE"/>.
+        /// </summary>
+        private bool UsesEncodedFilelistCode
+        {
+            get {
+                return Encoding != FilelistEncoding.Ansi || Delivery != FilelistDelivery.TempFile;
+            }
+        }
+
+        /// <summary>
+        /// Default constructor.
+        /// </summary>
+        public ExecutableWithFilelistPipelineElement()
+            : base()
+        {
+            Encoding = FilelistEncoding.Ansi;
+            Delivery = FilelistDelivery.TempFile;
+        }
+
+        /// <summary>
+        /// Constructor with arguments.
+        /// </summary>
+        /// <param name="executable">Path to executable.</param>
+        public ExecutableWithFilelistPipelineElement(string executable)
+            : this(executable, FilelistEncoding.Ansi)
+        {
+        }
+
+        /// <summary>
+        /// Constructor with arguments including filelist encoding.
+        /// </summary>
+        /// <param name="executable">Path to executable.</param>
+        /// <param name="encoding">Encoding of the filelist.</param>
+        public ExecutableWithFilelistPipelineElement(string executable, FilelistEncoding encoding)
+            : this(executable, encoding, FilelistDelivery.TempFile)
+        {
+        }
+
+        /// <summary>
+        /// Constructor with arguments including filelist encoding and delivery.
+        /// </summary>
+        /// <param name="executable">Path to executable.</param>
+        /// <param name="encoding">Encoding of the filelist.</param>
+        /// <param name="delivery">How to deliver the filelist to the executable.</param>
+        public ExecutableWithFilelistPipelineElement(string executable, FilelistEncoding encoding,
+            FilelistDelivery delivery)
+            : base(executable)
+        {
+            Encoding = encoding;
+            Delivery = delivery;
+        }
+
+        /// <summary>
+        /// Encodes this pipeline element in a string.
+        /// </summary>
+        /// <returns>Encoded element data.</returns>
+        public override string Encode()
+        {
+            // When using an encoding or delivery, they are stored first, preceded by a version number.
+            // Delivery is only stored when needed so that builds predating it can still read the rest.
+            StringBuilder encoder = new StringBuilder();
+            if (UsesEncodedFilelistCode) {
+                bool storeDelivery = Delivery != FilelistDelivery.TempFile;
+                encoder.Append(EncodeInt(storeDelivery ? DELIVERY_VERSION : INITIAL_VERSION));
+                encoder.Append(EncodeInt((int) Encoding));
+                if (storeDelivery) {
+                    encoder.Append(EncodeInt((int) Delivery));
+                }
+            }
+            encoder.Append(base.Encode());
             return encoder.ToString();
         }
 
         /// <summary>
-        /// Returns a user control to configure this pipeline element.
+        /// Encodes this pipeline element in binary format.
         /// </summary>
-        /// <returns>User control.</returns>
-        public override PipelineElementUserControl GetEditingControl()
+        /// <returns>Encoded element data.</returns>
+        public override string EncodeBinary()
         {
-            return new RegexPipelineElementUserControl(this);
+            // Same data as in text format.
+            StringBuilder encoder = new StringBuilder();
+            if (UsesEncodedFilelistCode) {
+                bool storeDelivery = Delivery != FilelistDelivery.TempFile;
+                encoder.Append(EncodeBinaryInt(storeDelivery ? DELIVERY_VERSION : INITIAL_VERSION));
+                encoder.Append(EncodeBinaryInt((int) Encoding));
+                if (storeDelivery) {
+                    encoder.Append(EncodeBinaryInt((int) Delivery));
+                }
+            }
+            encoder.Append(base.EncodeBinary());
+            return encoder.ToString();
         }
     }
-    
+
     /// <summary>
-    /// Pipeline element that applies the effect of another plugin on the path.
+    /// Pipeline element that instructs Path Copy Copy to copy paths to the
+    /// clipboard in multiple formats at once: text, HTML links and files.
     /// </summary>
-    public class ApplyPluginPipelineElement : PipelineElement
+    public class CopyMultipleFormatsPipelineElement : PipelineElement
     {
         /// <summary>
         /// Code representing this pipeline element type.
         /// </summary>
-        public const char CODE = '{';
+        public const char CODE = 'c';
 
         /// <summary>
         /// Code representing this pipeline element type.
@@ -1468,67 +3090,105 @@ namespace PathCopyCopy.Settings.Core.Plugins
         public override string DisplayValue
         {
             get {
-                return Resources.PipelineElement_ApplyPlugin;
+                return Resources.PipelineElement_CopyMultipleFormats;
             }
         }
 
         /// <summary>
-        /// ID of plugin to apply to the path.
+        /// Minimum version of Path Copy Copy required to use this pipeline element.
         /// </summary>
-        public Guid PluginID
+        public override Version RequiredVersion
         {
-            get;
-            set;
+            get {
+                return new Version(18, 0, 0, 0);
+            }
         }
         
         /// <summary>
-        /// Default constructor.
+        /// Encodes this pipeline element in a string.
         /// </summary>
-        public ApplyPluginPipelineElement()
+        /// <returns>Encoded element data.</returns>
+        public override string Encode()
         {
-            PluginID = Guid.Empty;
+            // No other data to encode.
+            return String.Empty;
         }
-        
+    }
+
+    /// <summary>
+    /// Pipeline element that instructs Path Copy Copy to cache the paths
+    /// returned by the pipeline and reuse them for the same files until
+    /// settings change.
+    /// </summary>
+    public class MemoizePipelineElement : PipelineElement
+    {
         /// <summary>
-        /// Constructor with plugin ID.
+        /// Code representing this pipeline element type.
         /// </summary>
-        /// <param name="pluginId">ID of plugin to apply to the path.</param>
-        public ApplyPluginPipelineElement(Guid pluginId)
+        public const char CODE = 'M';
+
+        /// <summary>
+        /// Code representing this pipeline element type.
+        /// </summary>
+        public override char Code
         {
-            PluginID = pluginId;
+            get {
+                return CODE;
+            }
         }
-        
+
         /// <summary>
-        /// Encodes this pipeline element in a string.
+        /// Pipeline element display value for the UI.
         /// </summary>
-        /// <returns>Encoded element data.</returns>
-        public override string Encode()
+        public override string DisplayValue
         {
-            // We encode our guid without length info, since the C++
-            // side will know how many characters to read.
-            return PluginID.ToString("B");
+            get {
+                return Resources.PipelineElement_Memoize;
+            }
         }
 
         /// <summary>
-        /// Returns a user control to configure this pipeline element.
+        /// Minimum version of Path Copy Copy required to use this pipeline element.
         /// </summary>
-        /// <returns>User control.</returns>
-        public override PipelineElementUserControl GetEditingControl()
+        public override Version RequiredVersion
         {
-            return new ApplyPluginPipelineElementUserControl(this);
+            get {
+                return new Version(18, 0, 0, 0);
+            }
+        }
+        
+        /// <summary>
+        /// Encodes this pipeline element in a string.
+        /// </summary>
+        /// <returns>Encoded element data.</returns>
+        public override string Encode()
+        {
+            // No other data to encode.
+            return String.Empty;
         }
     }
 
     /// <summary>
-    /// Pipeline element that does not modify the path but changes the
-    /// separator used between multiple copied paths.
+    /// Pipeline element that instructs Path Copy Copy to split paths in
+    /// batches that fit on a command line when launching an executable,
+    /// launching it once per batch.
     /// </summary>
-    public class PathsSeparatorPipelineElement : PipelineElement
+    public class BatchExecutablePipelineElement : PipelineElement
     {
         /// <summary>
         /// Code representing this pipeline element type.
         /// </summary>
-        public const char CODE = ',';
+        public const char CODE = 'b';
+
+        /// <summary>
+        /// Version number used to identify encoded data for this element.
+        /// </summary>
+        public const int INITIAL_VERSION = 1;
+
+        /// <summary>
+        /// Max version number supported by this element.
+        /// </summary>
+        public const int MAX_VERSION = INITIAL_VERSION;
 
         /// <summary>
         /// Code representing this pipeline element type.
@@ -1546,24 +3206,24 @@ namespace PathCopyCopy.Settings.Core.Plugins
         public override string DisplayValue
         {
             get {
-                return Resources.PipelineElement_PathsSeparator;
+                return Resources.PipelineElement_BatchExecutable;
             }
         }
 
         /// <summary>
-        /// Minumum version of Path Copy Copy required to use this pipeline element.
+        /// Minimum version of Path Copy Copy required to use this pipeline element.
         /// </summary>
         public override Version RequiredVersion
         {
             get {
-                return new Version(13, 0, 0, 0);
+                return new Version(18, 0, 0, 0);
             }
         }
 
         /// <summary>
-        /// Separator to use between multiple paths.
+        /// Maximum number of batches running at once.
         /// </summary>
-        public string PathsSeparator
+        public int MaxParallelBatches
         {
             get;
             set;
@@ -1572,18 +3232,18 @@ namespace PathCopyCopy.Settings.Core.Plugins
         /// <summary>
         /// Default constructor.
         /// </summary>
-        public PathsSeparatorPipelineElement()
+        public BatchExecutablePipelineElement()
+            : this(1)
         {
-            PathsSeparator = String.Empty;
         }
 
         /// <summary>
         /// Constructor with arguments.
         /// </summary>
-        /// <param name="pathsSeparator">Separator to use between multiple paths.</param>
-        public PathsSeparatorPipelineElement(string pathsSeparator)
+        /// <param name="maxParallelBatches">Maximum number of batches running at once.</param>
+        public BatchExecutablePipelineElement(int maxParallelBatches)
         {
-            PathsSeparator = pathsSeparator;
+            MaxParallelBatches = maxParallelBatches;
         }
 
         /// <summary>
@@ -1592,8 +3252,24 @@ namespace PathCopyCopy.Settings.Core.Plugins
         /// <returns>Encoded element data.</returns>
         public override string Encode()
         {
-            // Encode the paths separator.
-            return EncodeString(PathsSeparator);
+            // Version number first, then the max number of batches.
+            StringBuilder encoder = new StringBuilder();
+            encoder.Append(EncodeInt(INITIAL_VERSION));
+            encoder.Append(EncodeInt(MaxParallelBatches));
+            return encoder.ToString();
+        }
+
+        /// <summary>
+        /// Encodes this pipeline element in binary format.
+        /// </summary>
+        /// <returns>Encoded element data.</returns>
+        public override string EncodeBinary()
+        {
+            // Same data as in text format.
+            StringBuilder encoder = new StringBuilder();
+            encoder.Append(EncodeBinaryInt(INITIAL_VERSION));
+            encoder.Append(EncodeBinaryInt(MaxParallelBatches));
+            return encoder.ToString();
         }
 
         /// <summary>
@@ -1602,21 +3278,93 @@ namespace PathCopyCopy.Settings.Core.Plugins
         /// <returns>User control.</returns>
         public override PipelineElementUserControl GetEditingControl()
         {
-            return new PathsSeparatorPipelineElementUserControl(this);
+            return new BatchExecutablePipelineElementUserControl(this);
         }
     }
 
     /// <summary>
-    /// Abstract subclass of <see cref="PipelineElement"/> that has a
-    /// single data member: an executable path. Used to be able to edit
-    /// both types of executable-based pipeline elements in a common way.
+    /// Possible endpoints used by a <see cref="RunningInstancePipelineElement"/>
+    /// to send paths to a running instance of an executable.
     /// </summary>
-    abstract public class PipelineElementWithExecutable : PipelineElement
+    public enum InstanceEndpoint
     {
         /// <summary>
-        /// Path to executable.
+        /// Paths are written to a named pipe opened by the running instance.
         /// </summary>
-        public string Executable
+        NamedPipe = 1,
+
+        /// <summary>
+        /// Paths are sent via <c>WM_COPYDATA</c> to a window of the running
+        /// instance, identified by its class name.
+        /// </summary>
+        WindowClass = 2,
+    }
+
+    /// <summary>
+    /// Pipeline element that instructs Path Copy Copy to send paths to a
+    /// running instance of the executable to launch, if it can be reached,
+    /// instead of launching a new instance.
+    /// </summary>
+    public class RunningInstancePipelineElement : PipelineElement
+    {
+        /// <summary>
+        /// Code representing this pipeline element type.
+        /// </summary>
+        public const char CODE = 'r';
+
+        /// <summary>
+        /// Version number used to identify encoded data for this element.
+        /// </summary>
+        public const int INITIAL_VERSION = 1;
+
+        /// <summary>
+        /// Max version number supported by this element.
+        /// </summary>
+        public const int MAX_VERSION = INITIAL_VERSION;
+
+        /// <summary>
+        /// Code representing this pipeline element type.
+        /// </summary>
+        public override char Code
+        {
+            get {
+                return CODE;
+            }
+        }
+
+        /// <summary>
+        /// Pipeline element display value for the UI.
+        /// </summary>
+        public override string DisplayValue
+        {
+            get {
+                return Resources.PipelineElement_RunningInstance;
+            }
+        }
+
+        /// <summary>
+        /// Minimum version of Path Copy Copy required to use this pipeline element.
+        /// </summary>
+        public override Version RequiredVersion
+        {
+            get {
+                return new Version(18, 0, 0, 0);
+            }
+        }
+
+        /// <summary>
+        /// Type of endpoint used to reach the running instance.
+        /// </summary>
+        public InstanceEndpoint Endpoint
+        {
+            get;
+            set;
+        }
+
+        /// <summary>
+        /// Name of the pipe or window class used to reach the running instance.
+        /// </summary>
+        public string EndpointName
         {
             get;
             set;
@@ -1625,18 +3373,21 @@ namespace PathCopyCopy.Settings.Core.Plugins
         /// <summary>
         /// Default constructor.
         /// </summary>
-        public PipelineElementWithExecutable()
+        public RunningInstancePipelineElement()
+            : this(InstanceEndpoint.NamedPipe, String.Empty)
         {
-            Executable = String.Empty;
         }
 
         /// <summary>
         /// Constructor with arguments.
         /// </summary>
-        /// <param name="executable">Path to executable.</param>
-        public PipelineElementWithExecutable(string executable)
+        /// <param name="endpoint">Type of endpoint used to reach the running instance.</param>
+        /// <param name="endpointName">Name of the pipe or window class used to
+        /// reach the running instance.</param>
+        public RunningInstancePipelineElement(InstanceEndpoint endpoint, string endpointName)
         {
-            Executable = executable;
+            Endpoint = endpoint;
+            EndpointName = endpointName;
         }
 
         /// <summary>
@@ -1645,8 +3396,26 @@ namespace PathCopyCopy.Settings.Core.Plugins
         /// <returns>Encoded element data.</returns>
         public override string Encode()
         {
-            // Encode the executable path.
-            return EncodeString(Executable);
+            // Version number first, then endpoint type and name.
+            StringBuilder encoder = new StringBuilder();
+            encoder.Append(EncodeInt(INITIAL_VERSION));
+            encoder.Append(EncodeInt((int) Endpoint));
+            encoder.Append(EncodeString(EndpointName));
+            return encoder.ToString();
+        }
+
+        /// <summary>
+        /// Encodes this pipeline element in binary format.
+        /// </summary>
+        /// <returns>Encoded element data.</returns>
+        public override string EncodeBinary()
+        {
+            // Same data as in text format.
+            StringBuilder encoder = new StringBuilder();
+            encoder.Append(EncodeBinaryInt(INITIAL_VERSION));
+            encoder.Append(EncodeBinaryInt((int) Endpoint));
+            encoder.Append(EncodeBinaryString(EndpointName));
+            return encoder.ToString();
         }
 
         /// <summary>
@@ -1655,21 +3424,30 @@ namespace PathCopyCopy.Settings.Core.Plugins
         /// <returns>User control.</returns>
         public override PipelineElementUserControl GetEditingControl()
         {
-            return new PipelineElementWithExecutableUserControl(this);
+            return new RunningInstancePipelineElementUserControl(this);
         }
     }
 
     /// <summary>
-    /// Pipeline element that does not modify the path but instructs
-    /// Path Copy Copy to launch an executable with path(s) as argument
-    /// instead of copying them to the clipboard.
+    /// Pipeline element that instructs Path Copy Copy to write paths to
+    /// a file, one per line, instead of copying them to the clipboard.
     /// </summary>
-    public class ExecutablePipelineElement : PipelineElementWithExecutable
+    public class OutputFilePipelineElement : PipelineElement
     {
         /// <summary>
         /// Code representing this pipeline element type.
         /// </summary>
-        public const char CODE = 'x';
+        public const char CODE = 'o';
+
+        /// <summary>
+        /// Version number used to identify encoded data for this element.
+        /// </summary>
+        public const int INITIAL_VERSION = 1;
+
+        /// <summary>
+        /// Max version number supported by this element.
+        /// </summary>
+        public const int MAX_VERSION = INITIAL_VERSION;
 
         /// <summary>
         /// Code representing this pipeline element type.
@@ -1687,49 +3465,134 @@ namespace PathCopyCopy.Settings.Core.Plugins
         public override string DisplayValue
         {
             get {
-                return Resources.PipelineElement_Executable;
+                return Resources.PipelineElement_OutputFile;
+            }
+        }
+
+        /// <summary>
+        /// Minimum version of Path Copy Copy required to use this pipeline element.
+        /// </summary>
+        public override Version RequiredVersion
+        {
+            get {
+                return new Version(18, 0, 0, 0);
             }
         }
 
         /// <summary>
-        /// Minumum version of Path Copy Copy required to use this pipeline element.
+        /// Path of the file to write paths to. If empty, the user will
+        /// be asked to choose a file each time.
+        /// </summary>
+        public string OutputFile
+        {
+            get;
+            set;
+        }
+
+        /// <summary>
+        /// Encoding used to write paths to the file.
+        /// </summary>
+        public FilelistEncoding Encoding
+        {
+            get;
+            set;
+        }
+
+        /// <summary>
+        /// Default constructor.
+        /// </summary>
+        public OutputFilePipelineElement()
+            : this(String.Empty, FilelistEncoding.Utf8)
+        {
+        }
+
+        /// <summary>
+        /// Constructor with arguments.
+        /// </summary>
+        /// <param name="outputFile">Path of the file to write paths to.</param>
+        /// <param name="encoding">Encoding used to write paths to the file.</param>
+        public OutputFilePipelineElement(string outputFile, FilelistEncoding encoding)
+        {
+            OutputFile = outputFile;
+            Encoding = encoding;
+        }
+
+        /// <summary>
+        /// Encodes this pipeline element in a string.
+        /// </summary>
+        /// <returns>Encoded element data.</returns>
+        public override string Encode()
+        {
+            // Version number first, then encoding and file path.
+            StringBuilder encoder = new StringBuilder();
+            encoder.Append(EncodeInt(INITIAL_VERSION));
+            encoder.Append(EncodeInt((int) Encoding));
+            encoder.Append(EncodeString(OutputFile));
+            return encoder.ToString();
+        }
+
+        /// <summary>
+        /// Encodes this pipeline element in binary format.
         /// </summary>
-        public override Version RequiredVersion
+        /// <returns>Encoded element data.</returns>
+        public override string EncodeBinary()
         {
-            get {
-                return new Version(15, 0, 0, 0);
-            }
+            // Same data as in text format.
+            StringBuilder encoder = new StringBuilder();
+            encoder.Append(EncodeBinaryInt(INITIAL_VERSION));
+            encoder.Append(EncodeBinaryInt((int) Encoding));
+            encoder.Append(EncodeBinaryString(OutputFile));
+            return encoder.ToString();
         }
 
         /// <summary>
-        /// Default constructor.
+        /// Returns a user control to configure this pipeline element.
         /// </summary>
-        public ExecutablePipelineElement()
-            : base()
+        /// <returns>User control.</returns>
+        public override PipelineElementUserControl GetEditingControl()
         {
+            return new OutputFilePipelineElementUserControl(this);
         }
+    }
 
+    /// <summary>
+    /// Formats in which an <see cref="ExportMetadataPipelineElement"/>
+    /// can export paths along with the metadata of their files.
+    /// </summary>
+    public enum ExportFormat
+    {
         /// <summary>
-        /// Constructor with arguments.
+        /// One comma-separated record per file, after a header row.
         /// </summary>
-        /// <param name="executable">Path to executable.</param>
-        public ExecutablePipelineElement(string executable)
-            : base(executable)
-        {
-        }
+        CSV = 1,
+
+        /// <summary>
+        /// Array of JSON objects, one per file.
+        /// </summary>
+        JSON = 2,
     }
 
     /// <summary>
-    /// Pipeline element that does not modify the path but instructs
-    /// Path Copy Copy to launch an executable with filelist as argument
-    /// instead of copying them to the clipboard.
+    /// Pipeline element that instructs Path Copy Copy to output paths as
+    /// CSV or JSON records including the size, timestamps and attributes
+    /// of their files.
     /// </summary>
-    public class ExecutableWithFilelistPipelineElement : PipelineElementWithExecutable
+    public class ExportMetadataPipelineElement : PipelineElement
     {
         /// <summary>
         /// Code representing this pipeline element type.
         /// </summary>
-        public const char CODE = 'f';
+        public const char CODE = 'e';
+
+        /// <summary>
+        /// Version number used to identify encoded data for this element.
+        /// </summary>
+        public const int INITIAL_VERSION = 1;
+
+        /// <summary>
+        /// Max version number supported by this element.
+        /// </summary>
+        public const int MAX_VERSION = INITIAL_VERSION;
 
         /// <summary>
         /// Code representing this pipeline element type.
@@ -1747,35 +3610,71 @@ namespace PathCopyCopy.Settings.Core.Plugins
         public override string DisplayValue
         {
             get {
-                return Resources.PipelineElement_ExecutableWithFilelist;
+                return Format == ExportFormat.JSON ? Resources.PipelineElement_ExportJSON
+                                                   : Resources.PipelineElement_ExportCSV;
             }
         }
 
         /// <summary>
-        /// Minumum version of Path Copy Copy required to use this pipeline element.
+        /// Minimum version of Path Copy Copy required to use this pipeline element.
         /// </summary>
         public override Version RequiredVersion
         {
             get {
-                return new Version(17, 0, 0, 0);
+                return new Version(18, 0, 0, 0);
             }
         }
 
+        /// <summary>
+        /// Format in which paths are exported.
+        /// </summary>
+        public ExportFormat Format
+        {
+            get;
+            set;
+        }
+
         /// <summary>
         /// Default constructor.
         /// </summary>
-        public ExecutableWithFilelistPipelineElement()
-            : base()
+        public ExportMetadataPipelineElement()
+            : this(ExportFormat.CSV)
         {
         }
 
         /// <summary>
         /// Constructor with arguments.
         /// </summary>
-        /// <param name="executable">Path to executable.</param>
-        public ExecutableWithFilelistPipelineElement(string executable)
-            : base(executable)
+        /// <param name="format">Format in which paths are exported.</param>
+        public ExportMetadataPipelineElement(ExportFormat format)
+        {
+            Format = format;
+        }
+
+        /// <summary>
+        /// Encodes this pipeline element in a string.
+        /// </summary>
+        /// <returns>Encoded element data.</returns>
+        public override string Encode()
+        {
+            // Version number first, then format.
+            StringBuilder encoder = new StringBuilder();
+            encoder.Append(EncodeInt(INITIAL_VERSION));
+            encoder.Append(EncodeInt((int) Format));
+            return encoder.ToString();
+        }
+
+        /// <summary>
+        /// Encodes this pipeline element in binary format.
+        /// </summary>
+        /// <returns>Encoded element data.</returns>
+        public override string EncodeBinary()
         {
+            // Same data as in text format.
+            StringBuilder encoder = new StringBuilder();
+            encoder.Append(EncodeBinaryInt(INITIAL_VERSION));
+            encoder.Append(EncodeBinaryInt((int) Format));
+            return encoder.ToString();
         }
     }
 
@@ -1785,6 +3684,23 @@ namespace PathCopyCopy.Settings.Core.Plugins
     /// </summary>
     public static class PipelineDecoder
     {
+        /// <summary>
+        /// Formats that can be used to encode pipelines.
+        /// </summary>
+        private enum EncodingFormat
+        {
+            /// <summary>
+            /// Legacy format where all fields are stored as text.
+            /// </summary>
+            Text,
+
+            /// <summary>
+            /// Compact format where fields are stored as-is.
+            /// Starts with <see cref="Pipeline.BINARY_FORMAT_SIGNATURE"/>.
+            /// </summary>
+            Binary,
+        }
+
         /// <summary>
         /// Decodes the content of a pipeline using encoded element data.
         /// </summary>
@@ -1798,16 +3714,36 @@ namespace PathCopyCopy.Settings.Core.Plugins
             Pipeline pipeline = new Pipeline();
 
             try {
-                // The first two characters of the string should be the number of elements.
-                if (encodedElements.Length < 2) {
-                    throw new InvalidPipelineException();
+                int numElements;
+                int curChar = 2;
+                EncodingFormat encodingFormat;
+                if (encodedElements.Length > 0 && encodedElements[0] == Pipeline.BINARY_FORMAT_SIGNATURE) {
+                    // Binary format: signature, format version, then number of elements.
+                    if (encodedElements.Length < 2 || encodedElements[1] > Pipeline.BINARY_FORMAT_VERSION) {
+                        throw new InvalidPipelineException();
+                    }
+                    encodingFormat = EncodingFormat.Binary;
+                    numElements = DecodeInt(encodedElements, ref curChar, encodingFormat);
+                    if (numElements < 0) {
+                        throw new InvalidPipelineException();
+                    }
+                } else if (encodedElements.Length > 0 && encodedElements[0] == Pipeline.ELEMENT_COUNT_STRING_PREFIX) {
+                    // Large pipeline: number of elements is encoded as a string.
+                    encodingFormat = EncodingFormat.Text;
+                    curChar = 1;
+                    numElements = Int32.Parse(DecodeString(encodedElements, ref curChar, encodingFormat));
+                } else {
+                    // The first two characters of the string should be the number of elements.
+                    if (encodedElements.Length < 2) {
+                        throw new InvalidPipelineException();
+                    }
+                    encodingFormat = EncodingFormat.Text;
+                    numElements = Int32.Parse(encodedElements.Substring(0, 2));
                 }
-                int numElements = Int32.Parse(encodedElements.Substring(0, 2));
 
                 // Loop to read each element.
-                int curChar = 2;
                 for (int i = 0; i < numElements; ++i) {
-                    pipeline.Elements.Add(DecodeElement(encodedElements, ref curChar));
+                    pipeline.Elements.Add(DecodeElement(encodedElements, ref curChar, encodingFormat));
                 }
                 if (curChar < encodedElements.Length) {
                     throw new InvalidPipelineException();
@@ -1826,8 +3762,9 @@ namespace PathCopyCopy.Settings.Core.Plugins
         /// <param name="encodedElements">String of encoded elements data.</param>
         /// <param name="curChar">Position where the element data is located.
         /// Upon return, this value will point just after the element data.</param>
+        /// <param name="encodingFormat">Format of the encoded string.</param>
         /// <returns>New <see cref="PipelineElement"/> instance.</returns>
-        private static PipelineElement DecodeElement(string encodedElements, ref int curChar)
+        private static PipelineElement DecodeElement(string encodedElements, ref int curChar, EncodingFormat encodingFormat)
         {
             PipelineElement element = null;
 
@@ -1869,25 +3806,79 @@ namespace PathCopyCopy.Settings.Core.Plugins
                     element = new RemoveExtPipelineElement();
                     break;
                 }
-                case FindReplacePipelineElement.CODE: {
-                    element = DecodeFindReplaceElement(encodedElements, ref curChar);
+                case FinalPathPipelineElement.CODE: {
+                    element = new FinalPathPipelineElement();
+                    break;
+                }
+                case EnvironmentVariablesPipelineElement.CODE: {
+                    element = new EnvironmentVariablesPipelineElement();
+                    break;
+                }
+                case ContentHashPipelineElement.CODE: {
+                    element = new ContentHashPipelineElement();
+                    break;
+                }
+                case UnicodeNormalizationPipelineElement.CODE: {
+                    element = DecodeUnicodeNormalizationElement(encodedElements, ref curChar, encodingFormat);
+                    break;
+                }
+                case GuardPipelineElement.CODE: {
+                    element = DecodeGuardElement(encodedElements, ref curChar, encodingFormat);
+                    break;
+                }
+                case FindReplacePipelineElement.CODE:
+                case FindReplacePipelineElement.IGNORE_CASE_CODE: {
+                    element = DecodeFindReplaceElement(elementCode, encodedElements, ref curChar, encodingFormat);
                     break;
                 }
                 case RegexPipelineElement.CODE: {
-                    element = DecodeRegexPipelineElement(encodedElements, ref curChar);
+                    element = DecodeRegexPipelineElement(encodedElements, ref curChar, encodingFormat);
+                    break;
+                }
+                case PrefixMappingPipelineElement.CODE: {
+                    element = DecodePrefixMappingElement(encodedElements, ref curChar, encodingFormat);
                     break;
                 }
                 case ApplyPluginPipelineElement.CODE: {
-                    element = DecodeApplyPluginElement(encodedElements, ref curChar);
+                    element = DecodeApplyPluginElement(encodedElements, ref curChar, encodingFormat);
+                    break;
+                }
+                case TemplatePipelineElement.CODE: {
+                    element = DecodeTemplateElement(encodedElements, ref curChar, encodingFormat);
                     break;
                 }
                 case PathsSeparatorPipelineElement.CODE: {
-                    element = DecodePathsSeparatorElement(encodedElements, ref curChar);
+                    element = DecodePathsSeparatorElement(encodedElements, ref curChar, encodingFormat);
                     break;
                 }
                 case ExecutablePipelineElement.CODE:
-                case ExecutableWithFilelistPipelineElement.CODE: {
-                    element = DecodeExecutableElement(elementCode, encodedElements, ref curChar);
+                case ExecutableWithFilelistPipelineElement.CODE:
+                case ExecutableWithFilelistPipelineElement.ENCODED_FILELIST_CODE: {
+                    element = DecodeExecutableElement(elementCode, encodedElements, ref curChar, encodingFormat);
+                    break;
+                }
+                case BatchExecutablePipelineElement.CODE: {
+                    element = DecodeBatchExecutableElement(encodedElements, ref curChar, encodingFormat);
+                    break;
+                }
+                case RunningInstancePipelineElement.CODE: {
+                    element = DecodeRunningInstanceElement(encodedElements, ref curChar, encodingFormat);
+                    break;
+                }
+                case OutputFilePipelineElement.CODE: {
+                    element = DecodeOutputFileElement(encodedElements, ref curChar, encodingFormat);
+                    break;
+                }
+                case ExportMetadataPipelineElement.CODE: {
+                    element = DecodeExportMetadataElement(encodedElements, ref curChar, encodingFormat);
+                    break;
+                }
+                case CopyMultipleFormatsPipelineElement.CODE: {
+                    element = new CopyMultipleFormatsPipelineElement();
+                    break;
+                }
+                case MemoizePipelineElement.CODE: {
+                    element = new MemoizePipelineElement();
                     break;
                 }
                 default:
@@ -1903,17 +3894,21 @@ namespace PathCopyCopy.Settings.Core.Plugins
         /// Decodes a <see cref="FindReplacePipelineElement"/> from an encoded
         /// element string.
         /// </summary>
+        /// <param name="elementCode">Code of element to decode.</param>
         /// <param name="encodedElements">String of encoded elements data.</param>
         /// <param name="curChar">Position where the element data is to be found
         /// in the string (not counting the element code). Upon return, this will
         /// point just after the element data.</param>
-        private static FindReplacePipelineElement DecodeFindReplaceElement(string encodedElements,
-            ref int curChar)
+        /// <param name="encodingFormat">Format of the encoded string.</param>
+        private static FindReplacePipelineElement DecodeFindReplaceElement(char elementCode,
+            string encodedElements, ref int curChar, EncodingFormat encodingFormat)
         {
             // The element data contains the old and new value.
-            string oldValue = DecodeString(encodedElements, ref curChar);
-            string newValue = DecodeString(encodedElements, ref curChar);
-            return new FindReplacePipelineElement(oldValue, newValue);
+            // Whether to ignore case is determined by the element code.
+            string oldValue = DecodeString(encodedElements, ref curChar, encodingFormat);
+            string newValue = DecodeString(encodedElements, ref curChar, encodingFormat);
+            return new FindReplacePipelineElement(oldValue, newValue,
+                elementCode == FindReplacePipelineElement.IGNORE_CASE_CODE);
         }
         
         /// <summary>
@@ -1924,22 +3919,62 @@ namespace PathCopyCopy.Settings.Core.Plugins
         /// <param name="curChar">Position where the element data is to be found
         /// in the string (not counting the element code). Upon return, this will
         /// point just after the element data.</param>
+        /// <param name="encodingFormat">Format of the encoded string.</param>
         private static RegexPipelineElement DecodeRegexPipelineElement(string encodedElements,
-            ref int curChar)
+            ref int curChar, EncodingFormat encodingFormat)
         {
             // First read version number and validate.
-            int version = DecodeInt(encodedElements, ref curChar);
+            int version = DecodeInt(encodedElements, ref curChar, encodingFormat);
             if (version > RegexPipelineElement.MAX_VERSION) {
                 throw new InvalidPipelineException();
             }
 
             // Read initial version data: regex, format and ignore case flag.
-            string regex = DecodeString(encodedElements, ref curChar);
-            string format = DecodeString(encodedElements, ref curChar);
-            bool ignoreCase = DecodeBool(encodedElements, ref curChar);
+            string regex = DecodeString(encodedElements, ref curChar, encodingFormat);
+            string format = DecodeString(encodedElements, ref curChar, encodingFormat);
+            bool ignoreCase = DecodeBool(encodedElements, ref curChar, encodingFormat);
+
+            // Read engine version data: regex engine.
+            RegexEngine engine = RegexEngine.Standard;
+            if (version >= RegexPipelineElement.ENGINE_VERSION) {
+                engine = (RegexEngine) DecodeInt(encodedElements, ref curChar, encodingFormat);
+                if (!Enum.IsDefined(typeof(RegexEngine), engine)) {
+                    throw new InvalidPipelineException();
+                }
+            }
+
+            // Create and return element object.
+            return new RegexPipelineElement(regex, format, ignoreCase, engine);
+        }
+        
+        /// <summary>
+        /// Decodes a <see cref="PrefixMappingPipelineElement"/> from an encoded
+        /// element string.
+        /// </summary>
+        /// <param name="encodedElements">String of encoded elements data.</param>
+        /// <param name="curChar">Position where the element data is to be found
+        /// in the string (not counting the element code). Upon return, this will
+        /// point just after the element data.</param>
+        /// <param name="encodingFormat">Format of the encoded string.</param>
+        private static PrefixMappingPipelineElement DecodePrefixMappingElement(string encodedElements,
+            ref int curChar, EncodingFormat encodingFormat)
+        {
+            // First read version number and validate.
+            int version = DecodeInt(encodedElements, ref curChar, encodingFormat);
+            if (version > PrefixMappingPipelineElement.MAX_VERSION) {
+                throw new InvalidPipelineException();
+            }
+
+            // Read initial version data: source, table and ignore case flag.
+            PrefixMappingSource source = (PrefixMappingSource) DecodeInt(encodedElements, ref curChar, encodingFormat);
+            if (!Enum.IsDefined(typeof(PrefixMappingSource), source)) {
+                throw new InvalidPipelineException();
+            }
+            string table = DecodeString(encodedElements, ref curChar, encodingFormat);
+            bool ignoreCase = DecodeBool(encodedElements, ref curChar, encodingFormat);
 
             // Create and return element object.
-            return new RegexPipelineElement(regex, format, ignoreCase);
+            return new PrefixMappingPipelineElement(source, table, ignoreCase);
         }
         
         /// <summary>
@@ -1950,10 +3985,24 @@ namespace PathCopyCopy.Settings.Core.Plugins
         /// <param name="curChar">Position where the element data is to be found
         /// in the string (not counting the element code). Upon return, this will
         /// point just after the element data.</param>
+        /// <param name="encodingFormat">Format of the encoded string.</param>
         private static ApplyPluginPipelineElement DecodeApplyPluginElement(string encodedElements,
-            ref int curChar)
+            ref int curChar, EncodingFormat encodingFormat)
         {
-            // The element data is the ID of the plugin to apply. There's no length saved
+            // In binary format, the element data is the ID of the plugin to apply, as-is.
+            if (encodingFormat == EncodingFormat.Binary) {
+                int guidChars = Guid.Empty.ToByteArray().Length / sizeof(char);
+                if (curChar > (encodedElements.Length - guidChars)) {
+                    throw new InvalidPipelineException();
+                }
+                byte[] guidBytes = new byte[guidChars * sizeof(char)];
+                Buffer.BlockCopy(encodedElements.Substring(curChar, guidChars).ToCharArray(), 0,
+                    guidBytes, 0, guidBytes.Length);
+                curChar += guidChars;
+                return new ApplyPluginPipelineElement(new Guid(guidBytes));
+            }
+
+            // In text format, the element data is the ID of the plugin to apply. There's no length saved
             // for this since it's always the same length. Format is as follows:
             // {xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx}
             int guidLength = Guid.Empty.ToString("B").Length;
@@ -1965,6 +4014,31 @@ namespace PathCopyCopy.Settings.Core.Plugins
             return new ApplyPluginPipelineElement(pluginId);
         }
 
+        /// <summary>
+        /// Decodes a <see cref="TemplatePipelineElement"/> from an encoded
+        /// element string.
+        /// </summary>
+        /// <param name="encodedElements">String of encoded elements data.</param>
+        /// <param name="curChar">Position where the element data is to be found
+        /// in the string (not counting the element code). Upon return, this will
+        /// point just after the element data.</param>
+        /// <param name="encodingFormat">Format of the encoded string.</param>
+        private static TemplatePipelineElement DecodeTemplateElement(string encodedElements,
+            ref int curChar, EncodingFormat encodingFormat)
+        {
+            // First read version number and validate.
+            int version = DecodeInt(encodedElements, ref curChar, encodingFormat);
+            if (version > TemplatePipelineElement.MAX_VERSION) {
+                throw new InvalidPipelineException();
+            }
+
+            // Read initial version data: template.
+            string template = DecodeString(encodedElements, ref curChar, encodingFormat);
+
+            // Create and return element object.
+            return new TemplatePipelineElement(template);
+        }
+
         /// <summary>
         /// Decodes a <see cref="PathsSeparatorPipelineElement"/> from an encoded
         /// element string.
@@ -1973,14 +4047,166 @@ namespace PathCopyCopy.Settings.Core.Plugins
         /// <param name="curChar">Position where the element data is to be found
         /// in the string (not counting the element code). Upon return, this will
         /// point just after the element data.</param>
+        /// <param name="encodingFormat">Format of the encoded string.</param>
         private static PathsSeparatorPipelineElement DecodePathsSeparatorElement(
-            string encodedElements, ref int curChar)
+            string encodedElements, ref int curChar, EncodingFormat encodingFormat)
         {
             // The element data contains the paths separator.
-            string pathsSeparator = DecodeString(encodedElements, ref curChar);
+            string pathsSeparator = DecodeString(encodedElements, ref curChar, encodingFormat);
             return new PathsSeparatorPipelineElement(pathsSeparator);
         }
 
+        /// <summary>
+        /// Decodes a <see cref="BatchExecutablePipelineElement"/> from an
+        /// encoded element string.
+        /// </summary>
+        /// <param name="encodedElements">String of encoded elements data.</param>
+        /// <param name="curChar">Position where the element data is to be found
+        /// in the string (not counting the element code). Upon return, this will
+        /// point just after the element data.</param>
+        /// <param name="encodingFormat">Format of the encoded string.</param>
+        private static BatchExecutablePipelineElement DecodeBatchExecutableElement(
+            string encodedElements, ref int curChar, EncodingFormat encodingFormat)
+        {
+            // Version number first, then the max number of batches.
+            int version = DecodeInt(encodedElements, ref curChar, encodingFormat);
+            if (version > BatchExecutablePipelineElement.MAX_VERSION) {
+                throw new InvalidPipelineException();
+            }
+            int maxParallelBatches = DecodeInt(encodedElements, ref curChar, encodingFormat);
+            if (maxParallelBatches < 1) {
+                throw new InvalidPipelineException();
+            }
+            return new BatchExecutablePipelineElement(maxParallelBatches);
+        }
+
+        /// <summary>
+        /// Decodes a <see cref="RunningInstancePipelineElement"/> from an
+        /// encoded element string.
+        /// </summary>
+        /// <param name="encodedElements">String of encoded elements data.</param>
+        /// <param name="curChar">Position where the element data is to be found
+        /// in the string (not counting the element code). Upon return, this will
+        /// point just after the element data.</param>
+        /// <param name="encodingFormat">Format of the encoded string.</param>
+        private static RunningInstancePipelineElement DecodeRunningInstanceElement(
+            string encodedElements, ref int curChar, EncodingFormat encodingFormat)
+        {
+            // Version number first, then endpoint type and name.
+            int version = DecodeInt(encodedElements, ref curChar, encodingFormat);
+            if (version > RunningInstancePipelineElement.MAX_VERSION) {
+                throw new InvalidPipelineException();
+            }
+            int endpointValue = DecodeInt(encodedElements, ref curChar, encodingFormat);
+            if (!Enum.IsDefined(typeof(InstanceEndpoint), endpointValue)) {
+                throw new InvalidPipelineException();
+            }
+            string endpointName = DecodeString(encodedElements, ref curChar, encodingFormat);
+            return new RunningInstancePipelineElement((InstanceEndpoint) endpointValue, endpointName);
+        }
+
+        /// <summary>
+        /// Decodes an <see cref="OutputFilePipelineElement"/> from an
+        /// encoded element string.
+        /// </summary>
+        /// <param name="encodedElements">String of encoded elements data.</param>
+        /// <param name="curChar">Position where the element data is to be found
+        /// in the string (not counting the element code). Upon return, this will
+        /// point just after the element data.</param>
+        /// <param name="encodingFormat">Format of the encoded string.</param>
+        private static OutputFilePipelineElement DecodeOutputFileElement(
+            string encodedElements, ref int curChar, EncodingFormat encodingFormat)
+        {
+            // Version number first, then encoding and file path.
+            int version = DecodeInt(encodedElements, ref curChar, encodingFormat);
+            if (version > OutputFilePipelineElement.MAX_VERSION) {
+                throw new InvalidPipelineException();
+            }
+            int encodingValue = DecodeInt(encodedElements, ref curChar, encodingFormat);
+            if (!Enum.IsDefined(typeof(FilelistEncoding), encodingValue)) {
+                throw new InvalidPipelineException();
+            }
+            string outputFile = DecodeString(encodedElements, ref curChar, encodingFormat);
+            return new OutputFilePipelineElement(outputFile, (FilelistEncoding) encodingValue);
+        }
+
+        /// <summary>
+        /// Decodes an <see cref="ExportMetadataPipelineElement"/> from an
+        /// encoded element string.
+        /// </summary>
+        /// <param name="encodedElements">String of encoded elements data.</param>
+        /// <param name="curChar">Position where the element data is to be found
+        /// in the string (not counting the element code). Upon return, this will
+        /// point just after the element data.</param>
+        /// <param name="encodingFormat">Format of the encoded string.</param>
+        private static ExportMetadataPipelineElement DecodeExportMetadataElement(
+            string encodedElements, ref int curChar, EncodingFormat encodingFormat)
+        {
+            // Version number first, then format.
+            int version = DecodeInt(encodedElements, ref curChar, encodingFormat);
+            if (version > ExportMetadataPipelineElement.MAX_VERSION) {
+                throw new InvalidPipelineException();
+            }
+            int formatValue = DecodeInt(encodedElements, ref curChar, encodingFormat);
+            if (!Enum.IsDefined(typeof(ExportFormat), formatValue)) {
+                throw new InvalidPipelineException();
+            }
+            return new ExportMetadataPipelineElement((ExportFormat) formatValue);
+        }
+
+        /// <summary>
+        /// Decodes a <see cref="UnicodeNormalizationPipelineElement"/> from an
+        /// encoded element string.
+        /// </summary>
+        /// <param name="encodedElements">String of encoded elements data.</param>
+        /// <param name="curChar">Position where the element data is to be found
+        /// in the string (not counting the element code). Upon return, this will
+        /// point just after the element data.</param>
+        /// <param name="encodingFormat">Format of the encoded string.</param>
+        private static UnicodeNormalizationPipelineElement DecodeUnicodeNormalizationElement(
+            string encodedElements, ref int curChar, EncodingFormat encodingFormat)
+        {
+            // Version number first, then normalization form.
+            int version = DecodeInt(encodedElements, ref curChar, encodingFormat);
+            if (version > UnicodeNormalizationPipelineElement.MAX_VERSION) {
+                throw new InvalidPipelineException();
+            }
+            int formValue = DecodeInt(encodedElements, ref curChar, encodingFormat);
+            if (!Enum.IsDefined(typeof(NormalizationForm), formValue)) {
+                throw new InvalidPipelineException();
+            }
+            return new UnicodeNormalizationPipelineElement((NormalizationForm) formValue);
+        }
+
+        /// <summary>
+        /// Decodes a <see cref="GuardPipelineElement"/> from an encoded element string.
+        /// </summary>
+        /// <param name="encodedElements">String of encoded elements data.</param>
+        /// <param name="curChar">Position where the element data is to be found
+        /// in the string (not counting the element code). Upon return, this will
+        /// point just after the element data.</param>
+        /// <param name="encodingFormat">Format of the encoded string.</param>
+        private static GuardPipelineElement DecodeGuardElement(string encodedElements,
+            ref int curChar, EncodingFormat encodingFormat)
+        {
+            // Version number first, then value, match, ignore case and action.
+            int version = DecodeInt(encodedElements, ref curChar, encodingFormat);
+            if (version > GuardPipelineElement.MAX_VERSION) {
+                throw new InvalidPipelineException();
+            }
+            string value = DecodeString(encodedElements, ref curChar, encodingFormat);
+            int matchValue = DecodeInt(encodedElements, ref curChar, encodingFormat);
+            if (!Enum.IsDefined(typeof(GuardMatch), matchValue)) {
+                throw new InvalidPipelineException();
+            }
+            bool ignoreCase = DecodeBool(encodedElements, ref curChar, encodingFormat);
+            int actionValue = DecodeInt(encodedElements, ref curChar, encodingFormat);
+            if (!Enum.IsDefined(typeof(GuardAction), actionValue)) {
+                throw new InvalidPipelineException();
+            }
+            return new GuardPipelineElement(value, (GuardMatch) matchValue, ignoreCase, (GuardAction) actionValue);
+        }
+
         /// <summary>
         /// Decodes an <see cref="ExecutablePipelineElement"/> or
         /// <see cref="ExecutableWithFilelistPipelineElement"/> from
@@ -1991,17 +4217,42 @@ namespace PathCopyCopy.Settings.Core.Plugins
         /// <param name="curChar">Position where the element data is to be found
         /// in the string (not counting the element code). Upon return, this will
         /// point just after the element data.</param>
+        /// <param name="encodingFormat">Format of the encoded string.</param>
         private static PipelineElement DecodeExecutableElement(
-            char elementCode, string encodedElements, ref int curChar)
-        {
-            // The element data contains the executable path.
-            string executable = DecodeString(encodedElements, ref curChar);
+            char elementCode, string encodedElements, ref int curChar, EncodingFormat encodingFormat)
+        {
+            // Elements with encoded filelist start with a version number and the encoding.
+            // Starting with the delivery version, the encoding is followed by the delivery.
+            FilelistEncoding encoding = FilelistEncoding.Ansi;
+            FilelistDelivery delivery = FilelistDelivery.TempFile;
+            if (elementCode == ExecutableWithFilelistPipelineElement.ENCODED_FILELIST_CODE) {
+                int version = DecodeInt(encodedElements, ref curChar, encodingFormat);
+                if (version > ExecutableWithFilelistPipelineElement.MAX_VERSION) {
+                    throw new InvalidPipelineException();
+                }
+                int encodingValue = DecodeInt(encodedElements, ref curChar, encodingFormat);
+                if (!Enum.IsDefined(typeof(FilelistEncoding), encodingValue)) {
+                    throw new InvalidPipelineException();
+                }
+                encoding = (FilelistEncoding) encodingValue;
+                if (version >= ExecutableWithFilelistPipelineElement.DELIVERY_VERSION) {
+                    int deliveryValue = DecodeInt(encodedElements, ref curChar, encodingFormat);
+                    if (!Enum.IsDefined(typeof(FilelistDelivery), deliveryValue)) {
+                        throw new InvalidPipelineException();
+                    }
+                    delivery = (FilelistDelivery) deliveryValue;
+                }
+            }
+
+            // Then comes the executable path.
+            string executable = DecodeString(encodedElements, ref curChar, encodingFormat);
             switch (elementCode) {
                 case ExecutablePipelineElement.CODE: {
                     return new ExecutablePipelineElement(executable);
                 }
-                case ExecutableWithFilelistPipelineElement.CODE: {
-                    return new ExecutableWithFilelistPipelineElement(executable);
+                case ExecutableWithFilelistPipelineElement.CODE:
+                case ExecutableWithFilelistPipelineElement.ENCODED_FILELIST_CODE: {
+                    return new ExecutableWithFilelistPipelineElement(executable, encoding, delivery);
                 }
                 default:
                     throw new InvalidPipelineException();
@@ -2015,10 +4266,21 @@ namespace PathCopyCopy.Settings.Core.Plugins
         /// <param name="curChar">Position where the integer data is to be found
         /// in <paramref name="encodedElements"/>. Upon return, this will point
         /// just after the integer data.</param>
+        /// <param name="encodingFormat">Format of the encoded string.</param>
         /// <returns>Decoded integer value.</returns>
-        private static int DecodeInt(string encodedElements, ref int curChar)
+        private static int DecodeInt(string encodedElements, ref int curChar, EncodingFormat encodingFormat)
         {
-            // Encoded as four characters.
+            // In binary format, encoded as two characters: low 16 bits then high 16 bits.
+            if (encodingFormat == EncodingFormat.Binary) {
+                if (curChar > (encodedElements.Length - 2)) {
+                    throw new InvalidPipelineException();
+                }
+                int binaryValue = encodedElements[curChar] | (encodedElements[curChar + 1] << 16);
+                curChar += 2;
+                return binaryValue;
+            }
+
+            // In text format, encoded as four characters.
             if (curChar > (encodedElements.Length - 4)) {
                 throw new InvalidPipelineException();
             }
@@ -2034,14 +4296,15 @@ namespace PathCopyCopy.Settings.Core.Plugins
         /// <param name="curChar">Position where the string data is to be found
         /// in <paramref name="encodedElements"/>. Upon return, this will point
         /// just after the string data.</param>
+        /// <param name="encodingFormat">Format of the encoded string.</param>
         /// <returns>Decoded string.</returns>
-        private static string DecodeString(string encodedElements, ref int curChar)
+        private static string DecodeString(string encodedElements, ref int curChar, EncodingFormat encodingFormat)
         {
             // Read string length.
-            int stringLength = DecodeInt(encodedElements, ref curChar);
+            int stringLength = DecodeInt(encodedElements, ref curChar, encodingFormat);
 
             // Return string content.
-            if (curChar > (encodedElements.Length - stringLength)) {
+            if (stringLength < 0 || curChar > (encodedElements.Length - stringLength)) {
                 throw new InvalidPipelineException();
             }
             int prevChar = curChar;
@@ -2056,17 +4319,20 @@ namespace PathCopyCopy.Settings.Core.Plugins
         /// <param name="curChar">Position where the boolean data is to be found
         /// in <paramref name="encodedElements"/>. Upon return, this will point
         /// just after the boolean data.</param>
+        /// <param name="encodingFormat">Format of the encoded string.</param>
         /// <returns>Decoded boolean value.</returns>
-        private static bool DecodeBool(string encodedElements, ref int curChar)
+        private static bool DecodeBool(string encodedElements, ref int curChar, EncodingFormat encodingFormat)
         {
-            // Encoded as 0 or 1.
+            // Encoded as 0 or 1 (as characters in text format).
+            char falseValue = encodingFormat == EncodingFormat.Binary ? '\0' : '0';
+            char trueValue = encodingFormat == EncodingFormat.Binary ? '\u0001' : '1';
             if (curChar == encodedElements.Length) {
                 throw new InvalidPipelineException();
             }
-            if (encodedElements[curChar] != '0' && encodedElements[curChar] != '1') {
+            if (encodedElements[curChar] != falseValue && encodedElements[curChar] != trueValue) {
                 throw new InvalidPipelineException();
             }
-            return encodedElements[curChar++] == '1';
+            return encodedElements[curChar++] == trueValue;
         }
     }
     
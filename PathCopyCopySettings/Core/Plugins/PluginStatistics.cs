@@ -0,0 +1,212 @@
+﻿// PluginStatistics.cs
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+using System;
+using System.Collections.Generic;
+using Microsoft.Win32;
+
+namespace PathCopyCopy.Settings.Core.Plugins
+{
+    /// <summary>
+    /// Statistics recorded by the shell extension about how long a plugin
+    /// takes to determine if it is enabled and to compute paths.
+    /// Akin to the <c>PluginStatistics</c> class in C++ code.
+    /// </summary>
+    public sealed class PluginStatistics
+    {
+        /// Path of the key storing plugin statistics in the registry.
+        private const string PCC_STATISTICS_KEY = @"Software\clechasseur\PathCopyCopyCache\Statistics";
+
+        /// Prefix of values storing statistics of calls to <c>Enabled</c>.
+        private const string ENABLED_PREFIX = "Enabled";
+
+        /// Prefix of values storing statistics of calls to <c>GetPath</c>.
+        private const string GET_PATH_PREFIX = "GetPath";
+
+        /// Suffix of value storing number of calls.
+        private const string COUNT_SUFFIX = "Count";
+
+        /// Suffix of value storing number of failed calls.
+        private const string FAILURES_SUFFIX = "Failures";
+
+        /// Suffix of value storing durations of last calls, as an array of 32-bit microseconds.
+        private const string DURATIONS_SUFFIX = "Durations";
+
+        /// Value storing number of paths found in the path cache.
+        private const string PATH_CACHE_HITS_VALUE = "PathCacheHits";
+
+        /// Value storing number of paths looked up in the path cache but not found.
+        private const string PATH_CACHE_MISSES_VALUE = "PathCacheMisses";
+
+        /// <summary>
+        /// Statistics of calls to the plugin's <c>Enabled</c> method.
+        /// </summary>
+        public OperationStatistics Enabled
+        {
+            get;
+            private set;
+        }
+
+        /// <summary>
+        /// Statistics of calls to the plugin's <c>GetPath</c> method.
+        /// </summary>
+        public OperationStatistics GetPath
+        {
+            get;
+            private set;
+        }
+
+        /// <summary>
+        /// Number of paths found in the shell extension's path cache.
+        /// </summary>
+        public int PathCacheHits
+        {
+            get;
+            private set;
+        }
+
+        /// <summary>
+        /// Number of paths looked up in the shell extension's path cache but not found.
+        /// </summary>
+        public int PathCacheMisses
+        {
+            get;
+            private set;
+        }
+
+        /// <summary>
+        /// Loads statistics of the given plugin from the registry.
+        /// </summary>
+        /// <param name="pluginId">ID of plugin whose statistics to load.</param>
+        /// <returns>Plugin statistics, or <c>null</c> if none were recorded.</returns>
+        public static PluginStatistics Load(Guid pluginId)
+        {
+            PluginStatistics statistics = null;
+            try {
+                using (RegistryKey pluginKey = Registry.CurrentUser.OpenSubKey(
+                    PCC_STATISTICS_KEY + @"\" + pluginId.ToString("B"))) {
+
+                    if (pluginKey != null) {
+                        statistics = new PluginStatistics();
+                        statistics.Enabled = OperationStatistics.Load(pluginKey, ENABLED_PREFIX);
+                        statistics.GetPath = OperationStatistics.Load(pluginKey, GET_PATH_PREFIX);
+                        statistics.PathCacheHits = Convert.ToInt32(pluginKey.GetValue(PATH_CACHE_HITS_VALUE, 0));
+                        statistics.PathCacheMisses = Convert.ToInt32(pluginKey.GetValue(PATH_CACHE_MISSES_VALUE, 0));
+                    }
+                }
+            } catch (Exception) {
+                // Statistics are only informative, ignore.
+                statistics = null;
+            }
+            return statistics;
+        }
+
+        /// <summary>
+        /// Statistics recorded for one operation of a plugin.
+        /// </summary>
+        public sealed class OperationStatistics
+        {
+            /// <summary>
+            /// Number of calls.
+            /// </summary>
+            public int Count
+            {
+                get;
+                private set;
+            }
+
+            /// <summary>
+            /// Number of calls that failed.
+            /// </summary>
+            public int Failures
+            {
+                get;
+                private set;
+            }
+
+            /// <summary>
+            /// Median duration of the last calls.
+            /// </summary>
+            public TimeSpan P50
+            {
+                get;
+                private set;
+            }
+
+            /// <summary>
+            /// 99th percentile of the duration of the last calls.
+            /// </summary>
+            public TimeSpan P99
+            {
+                get;
+                private set;
+            }
+
+            /// <summary>
+            /// Loads statistics of one operation from a plugin's registry key.
+            /// </summary>
+            /// <param name="pluginKey">Registry key of the plugin.</param>
+            /// <param name="prefix">Prefix of values storing the operation's statistics.</param>
+            /// <returns>Operation statistics.</returns>
+            internal static OperationStatistics Load(RegistryKey pluginKey, string prefix)
+            {
+                OperationStatistics statistics = new OperationStatistics();
+                statistics.Count = Convert.ToInt32(pluginKey.GetValue(prefix + COUNT_SUFFIX, 0));
+                statistics.Failures = Convert.ToInt32(pluginKey.GetValue(prefix + FAILURES_SUFFIX, 0));
+
+                byte[] durationBytes = pluginKey.GetValue(prefix + DURATIONS_SUFFIX) as byte[];
+                if (durationBytes != null && durationBytes.Length >= sizeof(uint)) {
+                    List<uint> durations = new List<uint>();
+                    for (int i = 0; i + sizeof(uint) <= durationBytes.Length; i += sizeof(uint)) {
+                        durations.Add(BitConverter.ToUInt32(durationBytes, i));
+                    }
+                    durations.Sort();
+                    statistics.P50 = MicrosecondsToTimeSpan(Percentile(durations, 50));
+                    statistics.P99 = MicrosecondsToTimeSpan(Percentile(durations, 99));
+                }
+                return statistics;
+            }
+
+            /// <summary>
+            /// Returns a percentile of a sorted list of durations, using the nearest-rank method.
+            /// </summary>
+            /// <param name="sortedDurations">Sorted durations; must not be empty.</param>
+            /// <param name="percentile">Percentile to compute, between 1 and 100.</param>
+            /// <returns>Percentile value.</returns>
+            private static uint Percentile(List<uint> sortedDurations, int percentile)
+            {
+                int rank = (int) Math.Ceiling(percentile / 100.0 * sortedDurations.Count);
+                return sortedDurations[Math.Max(rank, 1) - 1];
+            }
+
+            /// <summary>
+            /// Converts a duration in microseconds to a <see cref="TimeSpan"/>.
+            /// </summary>
+            /// <param name="microseconds">Duration in microseconds.</param>
+            /// <returns><see cref="TimeSpan"/> instance.</returns>
+            private static TimeSpan MicrosecondsToTimeSpan(uint microseconds)
+            {
+                return TimeSpan.FromTicks(microseconds * (TimeSpan.TicksPerMillisecond / 1000));
+            }
+        }
+    }
+}
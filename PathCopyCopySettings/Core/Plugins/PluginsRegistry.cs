@@ -23,6 +23,7 @@ using System;
 using System.Collections.Generic;
 using System.Diagnostics;
 using System.Security;
+using System.Threading.Tasks;
 using Microsoft.Win32;
 using PathCopyCopy.Settings.Properties;
 
@@ -44,6 +45,9 @@ namespace PathCopyCopy.Settings.Core.Plugins
         /// We skip that if it exists.
         private const string LEGACY_COM_PLUGINS_LAST_UPDATE_VALUE_NAME = "LastUpdate";
 
+        /// Maximum number of COM plugin executors to run in parallel when probing plugins.
+        private const int MAX_COM_PLUGIN_EXECUTORS = 4;
+
         /// Bean containing info about a COM plugin.
         private sealed class COMPluginInfo
         {
@@ -77,6 +81,37 @@ namespace PathCopyCopy.Settings.Core.Plugins
             }
         }
 
+        /// Bean containing info about a COM plugin to probe.
+        private sealed class COMPluginProbe
+        {
+            /// <summary>
+            /// COM plugin's ID.
+            /// </summary>
+            public Guid Id
+            {
+                get;
+                set;
+            }
+
+            /// <summary>
+            /// Whether the plugin is registered globally.
+            /// </summary>
+            public bool Global
+            {
+                get;
+                set;
+            }
+
+            /// <summary>
+            /// Plugin properties, or <c>null</c> if they could not be fetched.
+            /// </summary>
+            public COMPluginProperties Properties
+            {
+                get;
+                set;
+            }
+        }
+
         /// Bean containing info about a registry key that contains COM plugins.
         private sealed class COMPluginsRegKeyInfo
         {
@@ -282,12 +317,16 @@ namespace PathCopyCopy.Settings.Core.Plugins
             plugins.Add(separator);
             plugins.Add(CreateDefaultPlugin(Resources.INTERNET_PATH_PLUGIN_ID, Resources.INTERNET_PATH_PLUGIN_DESCRIPTION, settings));
             plugins.Add(CreateDefaultPlugin(Resources.SAMBA_PATH_PLUGIN_ID, Resources.SAMBA_PATH_PLUGIN_DESCRIPTION, settings));
+            plugins.Add(CreateDefaultPlugin(Resources.ONEDRIVE_URL_PLUGIN_ID, Resources.ONEDRIVE_URL_PLUGIN_DESCRIPTION, settings));
 
             plugins.Add(separator);
             plugins.Add(CreateDefaultPlugin(Resources.UNIX_PATH_PLUGIN_ID, Resources.UNIX_PATH_PLUGIN_DESCRIPTION, settings));
             plugins.Add(CreateDefaultPlugin(Resources.CYGWIN_PATH_PLUGIN_ID, Resources.CYGWIN_PATH_PLUGIN_DESCRIPTION, settings));
             plugins.Add(CreateDefaultPlugin(Resources.WSL_PATH_PLUGIN_ID, Resources.WSL_PATH_PLUGIN_DESCRIPTION, settings));
             plugins.Add(CreateDefaultPlugin(Resources.MSYS_PATH_PLUGIN_ID, Resources.MSYS_PATH_PLUGIN_DESCRIPTION, settings));
+
+            plugins.Add(separator);
+            plugins.Add(CreateDefaultPlugin(Resources.REPOSITORY_PATH_PLUGIN_ID, Resources.REPOSITORY_PATH_PLUGIN_DESCRIPTION, settings));
         }
 
         /// <summary>
@@ -314,10 +353,8 @@ namespace PathCopyCopy.Settings.Core.Plugins
                 KeyPath = PCC_COM_PLUGINS_KEY
             });
 
-            // Create executor to be able to fetch info for COM plugins.
-            COMPluginExecutor executor = new COMPluginExecutor();
-
-            // Scan each registry key in turn.
+            // Scan each registry key in turn to find the IDs of all COM plugins.
+            List<COMPluginProbe> probes = new List<COMPluginProbe>();
             foreach (COMPluginsRegKeyInfo regKeyInfo in regKeyInfos) {
                 try {
                     using (RegistryKey pluginsKey = regKeyInfo.Root.OpenSubKey(regKeyInfo.KeyPath)) {
@@ -339,37 +376,10 @@ namespace PathCopyCopy.Settings.Core.Plugins
                                     idAsGuid = null;
                                 }
                                 if (idAsGuid != null) {
-                                    // Fetch plugin infos using executor.
-                                    string description = null;
-                                    int groupId = 0;
-                                    int groupPosition = 0;
-                                    string iconFile = null;
-                                    try {
-                                        description = executor.GetDescription(idAsGuid.Value);
-                                        groupId = executor.GetGroupId(idAsGuid.Value);
-                                        groupPosition = executor.GetGroupPosition(idAsGuid.Value);
-
-                                        if (executor.GetUseDefaultIcon(idAsGuid.Value)) {
-                                            iconFile = String.Empty;
-                                        } else {
-                                            iconFile = executor.GetIconFile(idAsGuid.Value);
-                                            if (String.IsNullOrEmpty(iconFile)) {
-                                                // No icon file specified, assume no icon.
-                                                iconFile = null;
-                                            }
-                                        }
-                                    } catch (COMPluginExecutorException) {
-                                        // Failed to fetch information, skip this plugin.
-                                        idAsGuid = null;
-                                    }
-                                    if (idAsGuid != null) {
-                                        // Construct bean for this plugin and add it to the list.
-                                        comPluginInfos.Add(new COMPluginInfo {
-                                            Plugin = new COMPlugin(idAsGuid.Value, description, iconFile, regKeyInfo.Global),
-                                            GroupId = groupId,
-                                            GroupPosition = groupPosition,
-                                        });
-                                    }
+                                    probes.Add(new COMPluginProbe {
+                                        Id = idAsGuid.Value,
+                                        Global = regKeyInfo.Global,
+                                    });
                                 }
                             }
                         }
@@ -381,6 +391,57 @@ namespace PathCopyCopy.Settings.Core.Plugins
                 }
             }
 
+            // Fetch properties of plugins from the cache when possible. Plugins whose
+            // server binary changed since they were cached need to be probed again.
+            List<COMPluginProbe> probesToExecute = new List<COMPluginProbe>();
+            foreach (COMPluginProbe probe in probes) {
+                probe.Properties = COMPluginPropertiesCache.Get(probe.Id);
+                if (probe.Properties == null) {
+                    probesToExecute.Add(probe);
+                }
+            }
+
+            // Probe remaining plugins using executors. Since each executor handles a single
+            // call at a time, we create one per worker; they will be stopped afterwards.
+            if (probesToExecute.Count > 0) {
+                ParallelOptions options = new ParallelOptions {
+                    MaxDegreeOfParallelism = Math.Min(Environment.ProcessorCount, MAX_COM_PLUGIN_EXECUTORS),
+                };
+                Parallel.ForEach(probesToExecute, options, () => new COMPluginExecutor(),
+                    (probe, loopState, executor) => {
+                        try {
+                            probe.Properties = executor.GetAll(probe.Id);
+                            COMPluginPropertiesCache.Update(probe.Id, probe.Properties);
+                        } catch (COMPluginExecutorException) {
+                            // Failed to fetch information, skip this plugin.
+                            probe.Properties = null;
+                        }
+                        return executor;
+                    },
+                    executor => executor.Dispose());
+            }
+
+            // Construct beans for all plugins we could fetch information for.
+            foreach (COMPluginProbe probe in probes) {
+                if (probe.Properties != null) {
+                    string iconFile;
+                    if (probe.Properties.UseDefaultIcon) {
+                        iconFile = String.Empty;
+                    } else {
+                        iconFile = probe.Properties.IconFile;
+                        if (String.IsNullOrEmpty(iconFile)) {
+                            // No icon file specified, assume no icon.
+                            iconFile = null;
+                        }
+                    }
+                    comPluginInfos.Add(new COMPluginInfo {
+                        Plugin = new COMPlugin(probe.Id, probe.Properties.Description, iconFile, probe.Global),
+                        GroupId = probe.Properties.GroupId,
+                        GroupPosition = probe.Properties.GroupPosition,
+                    });
+                }
+            }
+
             // Sort list of COM plugins by IDs and remove duplicates, since a plugin might be
             // registered both globally and for the current user.
             if (comPluginInfos.Count > 1) {
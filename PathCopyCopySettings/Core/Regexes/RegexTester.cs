@@ -20,26 +20,49 @@
 // THE SOFTWARE.
 
 using System;
+using System.Collections.Generic;
 using System.Diagnostics;
+using System.Globalization;
 using System.IO;
 using System.Reflection;
 using System.Text.RegularExpressions;
+using System.Threading.Tasks;
 using PathCopyCopy.Settings.Properties;
 
 namespace PathCopyCopy.Settings.Core.Regexes
 {
     /// <summary>
     /// Wrapper for the regex tester program used to test regular expressions.
+    /// The program is started once in server mode and reused for all tests
+    /// performed through the same instance; dispose of it to stop the program.
     /// </summary>
-    public sealed class RegexTester
+    public sealed class RegexTester : IDisposable
     {
         /// Line prefix used by the regex tester program to indicate an error.
         private const string REGEX_TESTER_ERROR_PREFIX = "ERROR:";
 
+        /// Command-line argument used to start the regex tester program in server mode.
+        private const string REGEX_TESTER_SERVER_MODE_ARG = "--server";
+
+        /// Line output by the regex tester program at the end of each response.
+        private const string REGEX_TESTER_END_OF_RESULTS = "End of results";
+
+        /// Time to wait for the regex tester program to respond, in milliseconds.
+        /// If a regex takes longer than this, it is most likely backtracking
+        /// catastrophically and the program is terminated.
+        private const int REGEX_TESTER_TIMEOUT_MS = 5000;
+
         /// Regex used to identify the modified string output by the regex tester program.
         private static readonly Regex MODIFIED_STRING_REGEX = new Regex(String.Format(@"^{0}(.*)$",
                 Resources.REGEX_TESTER_MODIFIED_STRING_PREFIX), RegexOptions.Compiled);
-        
+
+        /// Regex used to identify the match time output by the regex tester program.
+        private static readonly Regex MATCH_TIME_REGEX = new Regex(@"^Match time: (.*) us$",
+                RegexOptions.Compiled);
+
+        /// Regex tester program running in server mode, if started.
+        private Process tester;
+
         /// <summary>
         /// Invokes the regex tester program with the given arguments and returns
         /// the modified string.
@@ -52,66 +75,192 @@ namespace PathCopyCopy.Settings.Core.Regexes
         /// <returns>Modified string, as returned by the tester program.</returns>
         public string ModifyWithRegex(string sample, string regex, string format, bool ignoreCase)
         {
-            string modified = null;
+            return TestRegex(new string[] { sample }, regex, format, ignoreCase)[0].Modified;
+        }
 
-            // Find path to tester program. It's right beside our own executable.
-            string assemblyPath = new Uri(Assembly.GetEntryAssembly().CodeBase).LocalPath;
-            string testerPath = Path.Combine(Path.GetDirectoryName(assemblyPath), Resources.REGEX_TESTER_EXE_NAME);
-            if (!File.Exists(testerPath)) {
-                throw new RegexTesterException("Could not find regex tester program at: {0}", testerPath);
+        /// <summary>
+        /// Invokes the regex tester program to apply the same regex to several
+        /// sample strings and returns the modified strings, along with the
+        /// time taken by each replacement.
+        /// </summary>
+        /// <param name="samples">Sample strings to modify.</param>
+        /// <param name="regex">Regex used to find matches.</param>
+        /// <param name="format">Format of replacement string.</param>
+        /// <param name="ignoreCase">Whether to ignore case when looking for
+        /// matches.</param>
+        /// <returns>Results for each sample string, in order.</returns>
+        public IList<RegexTestResult> TestRegex(IList<string> samples, string regex,
+            string format, bool ignoreCase)
+        {
+            if (samples == null) {
+                throw new ArgumentNullException(nameof(samples));
             }
 
-            // Launch tester program, grabbing input and output.
-            ProcessStartInfo startInfo = new ProcessStartInfo(testerPath) {
-                CreateNoWindow = true,
-                RedirectStandardError = true,
-                RedirectStandardInput = true,
-                RedirectStandardOutput = true,
-                UseShellExecute = false,
-            };
+            List<RegexTestResult> results = new List<RegexTestResult>();
+            bool invalid = false;
             try {
-                using (Process tester = Process.Start(startInfo)) {
-                    // Get standard input and enter the arguments.
-                    StreamWriter cin = tester.StandardInput;
+                StartTester();
+
+                // Enter the request on standard input.
+                StreamWriter cin = tester.StandardInput;
+                cin.WriteLine(regex);
+                cin.WriteLine(format);
+                cin.WriteLine(ignoreCase ? 'y' : 'n');
+                cin.WriteLine(samples.Count);
+                foreach (string sample in samples) {
                     cin.WriteLine(sample);
-                    cin.WriteLine(regex);
-                    cin.WriteLine(format);
-                    cin.WriteLine(ignoreCase ? 'y' : 'n');
+                }
+                cin.Flush();
 
-                    // Get standard output, parse lines and get modified string.
-                    StreamReader cout = tester.StandardOutput;
+                // Parse the response lines in the background so that we can stop
+                // waiting for them if the regex takes too long.
+                StreamReader cout = tester.StandardOutput;
+                Task<bool> readTask = Task.Factory.StartNew(() => {
                     string line = cout.ReadLine();
-                    while (line != null) {
+                    while (line != null && line != REGEX_TESTER_END_OF_RESULTS) {
                         Match match = MODIFIED_STRING_REGEX.Match(line);
                         if (match.Success) {
-                            // We got our modified string.
-                            modified = match.Groups[1].Value;
-                            break;
-                        } else if (line.StartsWith(REGEX_TESTER_ERROR_PREFIX)) {
+                            results.Add(new RegexTestResult(match.Groups[1].Value));
+                        } else if (line.StartsWith(REGEX_TESTER_ERROR_PREFIX, StringComparison.Ordinal)) {
                             // This indicates an invalid regular expression.
-                            throw new RegexTesterException("Invalid regular expression.");
+                            invalid = true;
+                        } else {
+                            match = MATCH_TIME_REGEX.Match(line);
+                            double microseconds;
+                            if (match.Success && results.Count != 0 && Double.TryParse(match.Groups[1].Value,
+                                NumberStyles.Float, CultureInfo.InvariantCulture, out microseconds)) {
+
+                                results[results.Count - 1].MatchTime = TimeSpan.FromTicks(
+                                    (long) (microseconds * TimeSpan.TicksPerMillisecond / 1000));
+                            }
                         }
 
                         // Read next line.
                         line = cout.ReadLine();
                     }
-
-                    // Wait for the process to end.
-                    tester.WaitForExit();
+                    return line != null;
+                });
+                if (!readTask.Wait(REGEX_TESTER_TIMEOUT_MS)) {
+                    StopTester();
+                    throw new RegexTesterException("Regular expression took more than {0} ms to execute.",
+                        REGEX_TESTER_TIMEOUT_MS);
+                }
+                if (!readTask.Result) {
+                    StopTester();
+                    throw new RegexTesterException("Regex tester program exited unexpectedly.");
                 }
             } catch (RegexTesterException) {
                 throw;
             } catch (Exception e) {
+                StopTester();
                 throw new RegexTesterException(e);
             }
 
-            // Make sure we found the modified string.
-            if (modified == null) {
-                throw new RegexTesterException("Could not find modified string in regex tester program output.");
+            if (invalid) {
+                throw new RegexTesterException("Invalid regular expression.");
+            }
+
+            // Make sure we found all modified strings.
+            if (results.Count != samples.Count) {
+                throw new RegexTesterException("Could not find modified strings in regex tester program output.");
             }
+            return results;
+        }
 
-            // Return modified string as provided by the program.
-            return modified;
+        /// <summary>
+        /// Stops the regex tester program if it was started.
+        /// </summary>
+        public void Dispose()
+        {
+            StopTester();
+        }
+
+        /// <summary>
+        /// Starts the regex tester program in server mode, unless it's
+        /// already running.
+        /// </summary>
+        private void StartTester()
+        {
+            if (tester != null && !tester.HasExited) {
+                return;
+            }
+            StopTester();
+
+            // Find path to tester program. It's right beside our own executable.
+            string assemblyPath = new Uri(Assembly.GetEntryAssembly().CodeBase).LocalPath;
+            string testerPath = Path.Combine(Path.GetDirectoryName(assemblyPath), Resources.REGEX_TESTER_EXE_NAME);
+            if (!File.Exists(testerPath)) {
+                throw new RegexTesterException("Could not find regex tester program at: {0}", testerPath);
+            }
+
+            // Launch tester program, grabbing input and output.
+            ProcessStartInfo startInfo = new ProcessStartInfo(testerPath, REGEX_TESTER_SERVER_MODE_ARG) {
+                CreateNoWindow = true,
+                RedirectStandardError = true,
+                RedirectStandardInput = true,
+                RedirectStandardOutput = true,
+                UseShellExecute = false,
+            };
+            tester = Process.Start(startInfo);
+        }
+
+        /// <summary>
+        /// Stops the regex tester program if it is running.
+        /// </summary>
+        private void StopTester()
+        {
+            if (tester != null) {
+                try {
+                    if (!tester.HasExited) {
+                        // Closing standard input lets the program exit by itself;
+                        // if it's stuck executing a regex, we have to kill it.
+                        tester.StandardInput.Close();
+                        if (!tester.WaitForExit(100)) {
+                            tester.Kill();
+                        }
+                    }
+                } catch (InvalidOperationException) {
+                    // Process already exited.
+                } catch (System.ComponentModel.Win32Exception) {
+                    // Process could not be killed, probably because it is exiting.
+                } catch (IOException) {
+                    // Standard input pipe already broken.
+                }
+                tester.Dispose();
+                tester = null;
+            }
+        }
+    }
+
+    /// <summary>
+    /// Result of applying a regex to a sample string through the <see cref="RegexTester"/>.
+    /// </summary>
+    public sealed class RegexTestResult
+    {
+        /// <summary>
+        /// Modified string.
+        /// </summary>
+        public string Modified
+        {
+            get;
+        }
+
+        /// <summary>
+        /// Time taken by the regex tester program to perform the replacement.
+        /// </summary>
+        public TimeSpan MatchTime
+        {
+            get;
+            internal set;
+        }
+
+        /// <summary>
+        /// Constructor.
+        /// </summary>
+        /// <param name="modified">Modified string.</param>
+        public RegexTestResult(string modified)
+        {
+            Modified = modified;
         }
     }
     
@@ -0,0 +1,177 @@
+﻿// RegistryValuesSnapshot.cs
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Linq;
+using Microsoft.Win32;
+
+namespace PathCopyCopy.Settings.Core
+{
+    /// <summary>
+    /// Snapshot of the values of a registry key, loaded in bulk the first time
+    /// one of them is needed. Akin to the <c>SettingsSnapshot</c> class in C++
+    /// code: reading settings afterwards does not require any registry call.
+    /// Writes go to the registry right away and update the snapshot, so the
+    /// snapshot can also tell if a write is needed without reading the value.
+    /// </summary>
+    /// <remarks>
+    /// Changes made to the key by other processes or objects are not seen
+    /// until <see cref="Reload"/> is called.
+    /// </remarks>
+    internal sealed class RegistryValuesSnapshot
+    {
+        /// Registry key whose values we cache.
+        private readonly RegistryKey regKey;
+
+        /// Lock protecting our values, since settings can be used by background tasks.
+        private readonly object valuesLock = new object();
+
+        /// Values of the key, not expanded, per name. <c>null</c> until loaded.
+        private Dictionary<string, object> values;
+
+        /// Kinds of the values of the key, per name. <c>null</c> until loaded.
+        private Dictionary<string, RegistryValueKind> kinds;
+
+        /// <summary>
+        /// Constructor. Values are not loaded until needed.
+        /// </summary>
+        /// <param name="regKey">Registry key whose values to cache.</param>
+        public RegistryValuesSnapshot(RegistryKey regKey)
+        {
+            Debug.Assert(regKey != null);
+
+            this.regKey = regKey;
+        }
+
+        /// <summary>
+        /// Returns the value with the given name. Like with
+        /// <see cref="RegistryKey.GetValue(string)"/>, environment
+        /// variables in <c>REG_EXPAND_SZ</c> values are expanded.
+        /// </summary>
+        /// <param name="name">Name of value to fetch.</param>
+        /// <returns>Value, or <c>null</c> if the value does not exist.</returns>
+        public object GetValue(string name)
+        {
+            lock (valuesLock) {
+                EnsureLoaded();
+                values.TryGetValue(name, out object value);
+                if (value is string && kinds[name] == RegistryValueKind.ExpandString) {
+                    value = Environment.ExpandEnvironmentVariables((string) value);
+                }
+                return value;
+            }
+        }
+
+        /// <summary>
+        /// Sets a registry value, unless it already contains the same data.
+        /// Every write triggers registry change notifications, which cause
+        /// all running instances of the contextual menu extension to reload
+        /// their settings, so we avoid writing values that did not change.
+        /// </summary>
+        /// <param name="name">Name of registry value to set.</param>
+        /// <param name="value">Value to store. Like with <see cref="RegistryKey.SetValue(string, object)"/>,
+        /// the kind of registry value depends on the type of this object
+        /// (<c>int</c>, <c>string</c> or <c>byte[]</c>).</param>
+        public void SetValueIfChanged(string name, object value)
+        {
+            Debug.Assert(value != null);
+
+            lock (valuesLock) {
+                EnsureLoaded();
+                bool changed;
+                if (values.TryGetValue(name, out object currentValue)) {
+                    if (currentValue is byte[] && value is byte[]) {
+                        changed = !((byte[]) currentValue).SequenceEqual((byte[]) value);
+                    } else {
+                        // This also detects values of a different kind, like a string
+                        // containing "1" where we want to store a DWORD.
+                        changed = !value.Equals(currentValue);
+                    }
+                    if (!changed && currentValue is string && kinds[name] != RegistryValueKind.String) {
+                        // Same data, but stored as another kind of string (e.g. REG_EXPAND_SZ).
+                        changed = true;
+                    }
+                } else {
+                    changed = true;
+                }
+                if (changed) {
+                    regKey.SetValue(name, value);
+                    values[name] = value;
+                    kinds[name] = value is int ? RegistryValueKind.DWord
+                                               : (value is byte[] ? RegistryValueKind.Binary
+                                                                  : RegistryValueKind.String);
+                }
+            }
+        }
+
+        /// <summary>
+        /// Deletes a registry value if it exists.
+        /// </summary>
+        /// <param name="name">Name of registry value to delete.</param>
+        public void DeleteValue(string name)
+        {
+            lock (valuesLock) {
+                EnsureLoaded();
+                if (values.Remove(name)) {
+                    kinds.Remove(name);
+                    regKey.DeleteValue(name, false);
+                }
+            }
+        }
+
+        /// <summary>
+        /// Drops the cached values so that they are loaded again from
+        /// the registry the next time they are needed.
+        /// </summary>
+        public void Reload()
+        {
+            lock (valuesLock) {
+                values = null;
+                kinds = null;
+            }
+        }
+
+        /// <summary>
+        /// Loads all values of the key in one pass if not already done.
+        /// Must be called with <see cref="valuesLock"/> held.
+        /// </summary>
+        private void EnsureLoaded()
+        {
+            if (values == null) {
+                // Registry names are case-insensitive.
+                string[] names = regKey.GetValueNames();
+                var newValues = new Dictionary<string, object>(names.Length, StringComparer.OrdinalIgnoreCase);
+                var newKinds = new Dictionary<string, RegistryValueKind>(names.Length, StringComparer.OrdinalIgnoreCase);
+                foreach (string name in names) {
+                    object value = regKey.GetValue(name, null, RegistryValueOptions.DoNotExpandEnvironmentNames);
+                    if (value != null) {
+                        newValues[name] = value;
+                        newKinds[name] = regKey.GetValueKind(name);
+                    }
+                }
+                values = newValues;
+                kinds = newKinds;
+            }
+        }
+    }
+}
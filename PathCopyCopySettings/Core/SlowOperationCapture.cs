@@ -0,0 +1,238 @@
+﻿// SlowOperationCapture.cs
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+using System;
+using System.Collections.Generic;
+using System.Globalization;
+using System.Text;
+using Microsoft.Win32;
+
+namespace PathCopyCopy.Settings.Core
+{
+    /// <summary>
+    /// Phases of a slow operation of the shell extension, captured by
+    /// its flight recorder. Akin to the <c>FlightRecorder</c> class in C++ code.
+    /// </summary>
+    public sealed class SlowOperationCapture
+    {
+        /// Path of the key storing slow operations in the registry.
+        private const string PCC_SLOW_OPERATIONS_KEY = @"Software\clechasseur\PathCopyCopyCache\SlowOperations";
+
+        /// Value storing the name of the captured operation.
+        private const string OPERATION_VALUE = "Operation";
+
+        /// Value storing the duration of the operation, in microseconds.
+        private const string DURATION_VALUE = "Duration";
+
+        /// Value storing the phases of the operation.
+        private const string PHASES_VALUE = "Phases";
+
+        /// Number of hex digits at the start of a capture's key name storing its start time.
+        private const int START_TIME_DIGITS = 16;
+
+        /// <summary>
+        /// Time at which the operation started.
+        /// </summary>
+        public DateTime StartTime
+        {
+            get;
+            private set;
+        }
+
+        /// <summary>
+        /// Name of the operation: <c>Menu</c> or <c>Invoke</c>.
+        /// </summary>
+        public string Operation
+        {
+            get;
+            private set;
+        }
+
+        /// <summary>
+        /// Duration of the operation.
+        /// </summary>
+        public TimeSpan Duration
+        {
+            get;
+            private set;
+        }
+
+        /// <summary>
+        /// Phases of the operation, in order of first appearance.
+        /// </summary>
+        public List<Phase> Phases
+        {
+            get;
+            private set;
+        }
+
+        /// <summary>
+        /// Loads all captured slow operations from the registry.
+        /// </summary>
+        /// <returns>Captured operations, from most recent to oldest.</returns>
+        public static List<SlowOperationCapture> LoadAll()
+        {
+            List<SlowOperationCapture> captures = new List<SlowOperationCapture>();
+            try {
+                using (RegistryKey slowOperationsKey = Registry.CurrentUser.OpenSubKey(PCC_SLOW_OPERATIONS_KEY)) {
+                    if (slowOperationsKey != null) {
+                        List<string> keyNames = new List<string>(slowOperationsKey.GetSubKeyNames());
+                        keyNames.Sort(StringComparer.Ordinal);
+                        keyNames.Reverse();
+                        foreach (string keyName in keyNames) {
+                            using (RegistryKey captureKey = slowOperationsKey.OpenSubKey(keyName)) {
+                                SlowOperationCapture capture = Load(keyName, captureKey);
+                                if (capture != null) {
+                                    captures.Add(capture);
+                                }
+                            }
+                        }
+                    }
+                }
+            } catch (Exception) {
+                // Captures are only informative, ignore.
+            }
+            return captures;
+        }
+
+        /// <summary>
+        /// Deletes all captured slow operations from the registry.
+        /// </summary>
+        public static void DeleteAll()
+        {
+            try {
+                Registry.CurrentUser.DeleteSubKeyTree(PCC_SLOW_OPERATIONS_KEY);
+            } catch (ArgumentException) {
+                // Key does not exist, nothing to delete.
+            }
+        }
+
+        /// <summary>
+        /// Returns a textual report of the capture, suitable for export.
+        /// </summary>
+        /// <returns>Report listing the operation and its phases.</returns>
+        public override string ToString()
+        {
+            StringBuilder builder = new StringBuilder();
+            builder.AppendFormat(CultureInfo.InvariantCulture, "{0:u} {1} {2:F1} ms",
+                StartTime.ToUniversalTime(), Operation, Duration.TotalMilliseconds).AppendLine();
+            foreach (Phase phase in Phases) {
+                builder.AppendFormat(CultureInfo.InvariantCulture, "\t{0}\t{1:F1} ms\t{2}",
+                    phase.Name, phase.Duration.TotalMilliseconds, phase.Count).AppendLine();
+            }
+            return builder.ToString();
+        }
+
+        /// <summary>
+        /// Loads one captured slow operation from its registry key.
+        /// </summary>
+        /// <param name="keyName">Name of the capture's key.</param>
+        /// <param name="captureKey">Registry key of the capture. Can be <c>null</c>.</param>
+        /// <returns>Captured operation, or <c>null</c> if it could not be loaded.</returns>
+        private static SlowOperationCapture Load(string keyName, RegistryKey captureKey)
+        {
+            long fileTime;
+            if (captureKey == null || keyName.Length < START_TIME_DIGITS ||
+                !Int64.TryParse(keyName.Substring(0, START_TIME_DIGITS), NumberStyles.AllowHexSpecifier,
+                                CultureInfo.InvariantCulture, out fileTime)) {
+                return null;
+            }
+
+            SlowOperationCapture capture = new SlowOperationCapture();
+            capture.StartTime = DateTime.FromFileTime(fileTime);
+            capture.Operation = captureKey.GetValue(OPERATION_VALUE) as string ?? String.Empty;
+            capture.Duration = MicrosecondsToTimeSpan(Convert.ToInt64(captureKey.GetValue(DURATION_VALUE, 0L)));
+            capture.Phases = new List<Phase>();
+            string[] phases = captureKey.GetValue(PHASES_VALUE) as string[];
+            if (phases != null) {
+                foreach (string phaseLine in phases) {
+                    string[] fields = phaseLine.Split('\t');
+                    long duration;
+                    int count;
+                    if (fields.Length == 3 &&
+                        Int64.TryParse(fields[1], NumberStyles.Integer, CultureInfo.InvariantCulture, out duration) &&
+                        Int32.TryParse(fields[2], NumberStyles.Integer, CultureInfo.InvariantCulture, out count)) {
+
+                        capture.Phases.Add(new Phase(fields[0], MicrosecondsToTimeSpan(duration), count));
+                    }
+                }
+            }
+            return capture;
+        }
+
+        /// <summary>
+        /// Converts a duration in microseconds to a <see cref="TimeSpan"/>.
+        /// </summary>
+        /// <param name="microseconds">Duration in microseconds.</param>
+        /// <returns><see cref="TimeSpan"/> instance.</returns>
+        private static TimeSpan MicrosecondsToTimeSpan(long microseconds)
+        {
+            return TimeSpan.FromTicks(microseconds * (TimeSpan.TicksPerMillisecond / 1000));
+        }
+
+        /// <summary>
+        /// Cumulative duration of one phase of a slow operation.
+        /// </summary>
+        public sealed class Phase
+        {
+            /// <summary>
+            /// Name of the phase, as traced by the shell extension.
+            /// </summary>
+            public string Name
+            {
+                get;
+                private set;
+            }
+
+            /// <summary>
+            /// Total duration of the phase.
+            /// </summary>
+            public TimeSpan Duration
+            {
+                get;
+                private set;
+            }
+
+            /// <summary>
+            /// Number of times the phase occurred.
+            /// </summary>
+            public int Count
+            {
+                get;
+                private set;
+            }
+
+            /// <summary>
+            /// Constructor.
+            /// </summary>
+            /// <param name="name">Name of the phase.</param>
+            /// <param name="duration">Total duration of the phase.</param>
+            /// <param name="count">Number of times the phase occurred.</param>
+            internal Phase(string name, TimeSpan duration, int count)
+            {
+                Name = name;
+                Duration = duration;
+                Count = count;
+            }
+        }
+    }
+}
@@ -23,6 +23,9 @@ using System;
 using System.Collections.Generic;
 using System.Diagnostics;
 using System.Drawing;
+using System.Linq;
+using System.Runtime.InteropServices;
+using System.Text;
 using Microsoft.Win32;
 using PathCopyCopy.Settings.Core.Plugins;
 using PathCopyCopy.Settings.Properties;
@@ -129,6 +132,15 @@ namespace PathCopyCopy.Settings.Core
         /// Name of registry value containing the plugins that are known to the settings app.
         private const string KNOWN_PLUGINS_VALUE_NAME = "KnownPlugins";
 
+        /// Name of registry value containing a packed version of the main menu display order.
+        private const string MAIN_MENU_DISPLAY_ORDER_PACKED_VALUE_NAME = "MainMenuDisplayOrderPacked";
+
+        /// Name of registry value containing a packed version of the submenu display order.
+        private const string SUBMENU_DISPLAY_ORDER_PACKED_VALUE_NAME = "SubmenuDisplayOrderPacked";
+
+        /// Name of registry value containing a packed version of the known plugins.
+        private const string KNOWN_PLUGINS_PACKED_VALUE_NAME = "KnownPluginsPacked";
+
         /// Name of registry value containing the last ignored software update version.
         private const string IGNORED_UPDATE_VALUE_NAME = "IgnoredUpdate";
 
@@ -150,6 +162,9 @@ namespace PathCopyCopy.Settings.Core
         /// Name of registry value containing the path to a pipeline plugin's icon file.
         private const string PIPELINE_PLUGIN_ICON_VALUE_NAME = "IconFile";
 
+        /// Name of registry value containing the name of a pipeline plugin's nested submenu.
+        private const string PIPELINE_PLUGIN_FOLDER_VALUE_NAME = "Folder";
+
         /// Name of registry value containing the minimum required version for a pipeline plugin.
         private const string PIPELINE_PLUGIN_REQUIRED_VERSION_VALUE_NAME = "RequiredVersion";
 
@@ -159,6 +174,10 @@ namespace PathCopyCopy.Settings.Core
         /// Name of registry value containing the order in which to display pipeline plugins.
         private const string PIPELINE_PLUGINS_DISPLAY_ORDER_VALUE_NAME = "DisplayOrder";
 
+        /// Name of registry value containing all pipeline plugins of a key, packed
+        /// in a single binary value so that they can be loaded in one registry call.
+        private const string PIPELINE_PLUGINS_PACKED_VALUE_NAME = "PackedPlugins";
+
         /// Name of registry value containing a form's position's X coordinate.
         private const string FORMS_POS_X_VALUE_NAME = "X";
 
@@ -236,6 +255,9 @@ namespace PathCopyCopy.Settings.Core
         /// Separator used between pipeline plugins in the display order string.
         private const char PIPELINE_PLUGINS_DISPLAY_ORDER_SEPARATOR = ',';
 
+        /// Signature of the packed pipeline plugins value. Must match the C++ code.
+        private const char PIPELINE_PLUGINS_PACKED_SIGNATURE = '\u0003';
+
         /// Defaut value for all size and position components of a form.
         private const int FORMS_POS_SIZE_DEFAULT_VALUE = -1;
 
@@ -263,6 +285,18 @@ namespace PathCopyCopy.Settings.Core
         /// Registry key containing information on forms. They are always user-specific.
         private RegistryKey userFormsKey;
 
+        /// Snapshot of the values of the global key. Can be null for portable installations.
+        private RegistryValuesSnapshot globalValues;
+
+        /// Snapshot of the values of the user key.
+        private RegistryValuesSnapshot userValues;
+
+        /// Snapshot of the values of the global icons key. Can be null for portable installations.
+        private RegistryValuesSnapshot globalIconsValues;
+
+        /// Snapshot of the values of the user icons key.
+        private RegistryValuesSnapshot userIconsValues;
+
         /// <summary>
         /// Whether the UNC plugins should use hidden shares or not.
         /// </summary>
@@ -272,7 +306,7 @@ namespace PathCopyCopy.Settings.Core
                 return ((int) GetUserOrGlobalValue(USE_HIDDEN_SHARES_VALUE_NAME, USE_HIDDEN_SHARES_DEFAULT_VALUE)) != 0;
             }
             set {
-                userKey.SetValue(USE_HIDDEN_SHARES_VALUE_NAME, value ? 1 : 0);
+                userValues.SetValueIfChanged(USE_HIDDEN_SHARES_VALUE_NAME, value ? 1 : 0);
             }
         }
 
@@ -285,7 +319,7 @@ namespace PathCopyCopy.Settings.Core
                 return ((int) GetUserOrGlobalValue(USE_FQDN_VALUE_NAME, USE_FQDN_DEFAULT_VALUE)) != 0;
             }
             set {
-                userKey.SetValue(USE_FQDN_VALUE_NAME, value ? 1 : 0);
+                userValues.SetValueIfChanged(USE_FQDN_VALUE_NAME, value ? 1 : 0);
             }
         }
 
@@ -298,7 +332,7 @@ namespace PathCopyCopy.Settings.Core
                 return ((int) GetUserOrGlobalValue(ADD_QUOTES_VALUE_NAME, ADD_QUOTES_DEFAULT_VALUE)) != 0;
             }
             set {
-                userKey.SetValue(ADD_QUOTES_VALUE_NAME, value ? 1 : 0);
+                userValues.SetValueIfChanged(ADD_QUOTES_VALUE_NAME, value ? 1 : 0);
             }
         }
 
@@ -311,7 +345,7 @@ namespace PathCopyCopy.Settings.Core
                 return ((int) GetUserOrGlobalValue(ARE_QUOTES_OPTIONAL_VALUE_NAME, ARE_QUOTES_OPTIONAL_DEFAULT_VALUE)) != 0;
             }
             set {
-                userKey.SetValue(ARE_QUOTES_OPTIONAL_VALUE_NAME, value ? 1 : 0);
+                userValues.SetValueIfChanged(ARE_QUOTES_OPTIONAL_VALUE_NAME, value ? 1 : 0);
             }
         }
 
@@ -324,7 +358,7 @@ namespace PathCopyCopy.Settings.Core
                 return ((int) GetUserOrGlobalValue(MAKE_EMAIL_LINKS_VALUE_NAME, MAKE_EMAIL_LINKS_DEFAULT_VALUE)) != 0;
             }
             set {
-                userKey.SetValue(MAKE_EMAIL_LINKS_VALUE_NAME, value ? 1 : 0);
+                userValues.SetValueIfChanged(MAKE_EMAIL_LINKS_VALUE_NAME, value ? 1 : 0);
             }
         }
 
@@ -344,7 +378,7 @@ namespace PathCopyCopy.Settings.Core
                 }
             }
             set {
-                userKey.SetValue(ENCODE_PARAM_VALUE_NAME, value.ToString());
+                userValues.SetValueIfChanged(ENCODE_PARAM_VALUE_NAME, value.ToString());
             }
         }
 
@@ -357,7 +391,7 @@ namespace PathCopyCopy.Settings.Core
                 return ((int) GetUserOrGlobalValue(APPEND_SEPARATOR_FOR_DIRECTORIES_VALUE_NAME, APPEND_SEPARATOR_FOR_DIRECTORIES_DEFAULT_VALUE)) != 0;
             }
             set {
-                userKey.SetValue(APPEND_SEPARATOR_FOR_DIRECTORIES_VALUE_NAME, value ? 1 : 0);
+                userValues.SetValueIfChanged(APPEND_SEPARATOR_FOR_DIRECTORIES_VALUE_NAME, value ? 1 : 0);
             }
         }
 
@@ -370,7 +404,7 @@ namespace PathCopyCopy.Settings.Core
                 return ((int) GetUserOrGlobalValue(USE_ICON_FOR_DEFAULT_PLUGIN_VALUE_NAME, USE_ICON_FOR_DEFAULT_PLUGIN_DEFAULT_VALUE)) != 0;
             }
             set {
-                userKey.SetValue(USE_ICON_FOR_DEFAULT_PLUGIN_VALUE_NAME, value ? 1 : 0);
+                userValues.SetValueIfChanged(USE_ICON_FOR_DEFAULT_PLUGIN_VALUE_NAME, value ? 1 : 0);
             }
         }
 
@@ -383,7 +417,7 @@ namespace PathCopyCopy.Settings.Core
                 return ((int) GetUserOrGlobalValue(USE_ICON_FOR_SUBMENU_VALUE_NAME, USE_ICON_FOR_SUBMENU_DEFAULT_VALUE)) != 0;
             }
             set {
-                userKey.SetValue(USE_ICON_FOR_SUBMENU_VALUE_NAME, value ? 1 : 0);
+                userValues.SetValueIfChanged(USE_ICON_FOR_SUBMENU_VALUE_NAME, value ? 1 : 0);
             }
         }
 
@@ -396,7 +430,7 @@ namespace PathCopyCopy.Settings.Core
                 return ((int) GetUserOrGlobalValue(USE_PREVIEW_MODE_VALUE_NAME, USE_PREVIEW_MODE_DEFAULT_VALUE)) != 0;
             }
             set {
-                userKey.SetValue(USE_PREVIEW_MODE_VALUE_NAME, value ? 1 : 0);
+                userValues.SetValueIfChanged(USE_PREVIEW_MODE_VALUE_NAME, value ? 1 : 0);
             }
         }
 
@@ -409,7 +443,7 @@ namespace PathCopyCopy.Settings.Core
                 return ((int) GetUserOrGlobalValue(USE_PREVIEW_MODE_IN_MAIN_MENU_VALUE_NAME, USE_PREVIEW_MODE_IN_MAIN_MENU_DEFAULT_VALUE)) != 0;
             }
             set {
-                userKey.SetValue(USE_PREVIEW_MODE_IN_MAIN_MENU_VALUE_NAME, value ? 1 : 0);
+                userValues.SetValueIfChanged(USE_PREVIEW_MODE_IN_MAIN_MENU_VALUE_NAME, value ? 1 : 0);
             }
         }
 
@@ -422,7 +456,7 @@ namespace PathCopyCopy.Settings.Core
                 return ((int) GetUserOrGlobalValue(DROP_REDUNDANT_WORDS_VALUE_NAME, DROP_REDUNDANT_WORDS_DEFAULT_VALUE)) != 0;
             }
             set {
-                userKey.SetValue(DROP_REDUNDANT_WORDS_VALUE_NAME, value ? 1 : 0);
+                userValues.SetValueIfChanged(DROP_REDUNDANT_WORDS_VALUE_NAME, value ? 1 : 0);
             }
         }
 
@@ -436,7 +470,7 @@ namespace PathCopyCopy.Settings.Core
                 return ((int) GetUserOrGlobalValue(ALWAYS_SHOW_SUBMENU_VALUE_NAME, ALWAYS_SHOW_SUBMENU_DEFAULT_VALUE)) != 0;
             }
             set {
-                userKey.SetValue(ALWAYS_SHOW_SUBMENU_VALUE_NAME, value ? 1 : 0);
+                userValues.SetValueIfChanged(ALWAYS_SHOW_SUBMENU_VALUE_NAME, value ? 1 : 0);
             }
         }
 
@@ -451,10 +485,10 @@ namespace PathCopyCopy.Settings.Core
             }
             set {
                 if (!String.IsNullOrEmpty(value)) {
-                    userKey.SetValue(PATHS_SEPARATOR_VALUE_NAME, value);
+                    userValues.SetValueIfChanged(PATHS_SEPARATOR_VALUE_NAME, value);
                 } else {
                     // Delete the value to use default.
-                    userKey.DeleteValue(PATHS_SEPARATOR_VALUE_NAME, false);
+                    userValues.DeleteValue(PATHS_SEPARATOR_VALUE_NAME);
                 }
             }
         }
@@ -468,7 +502,7 @@ namespace PathCopyCopy.Settings.Core
                 return ((int) GetUserOrGlobalValue(DISABLE_SOFTWARE_UPDATE_VALUE_NAME, DISABLE_SOFTWARE_UPDATE_DEFAULT_VALUE)) != 0;
             }
             set {
-                userKey.SetValue(DISABLE_SOFTWARE_UPDATE_VALUE_NAME, value ? 1 : 0);
+                userValues.SetValueIfChanged(DISABLE_SOFTWARE_UPDATE_VALUE_NAME, value ? 1 : 0);
             }
         }
 
@@ -503,7 +537,7 @@ namespace PathCopyCopy.Settings.Core
                     SavePluginsInValue(CTRL_KEY_PLUGIN_VALUE_NAME, pluginIds);
                 } else {
                     // Delete the value in the registry instead.
-                    userKey.DeleteValue(CTRL_KEY_PLUGIN_VALUE_NAME, false);
+                    userValues.DeleteValue(CTRL_KEY_PLUGIN_VALUE_NAME);
                 }
             }
         }
@@ -519,10 +553,11 @@ namespace PathCopyCopy.Settings.Core
             }
             set {
                 if (value != null) {
-                    SavePluginsInValue(MAIN_MENU_DISPLAY_ORDER_VALUE_NAME, value);
+                    SavePluginsInValue(MAIN_MENU_DISPLAY_ORDER_VALUE_NAME, value, MAIN_MENU_DISPLAY_ORDER_PACKED_VALUE_NAME);
                 } else {
-                    // Delete the value in the registry instead.
-                    userKey.DeleteValue(MAIN_MENU_DISPLAY_ORDER_VALUE_NAME, false);
+                    // Delete the values in the registry instead.
+                    userValues.DeleteValue(MAIN_MENU_DISPLAY_ORDER_VALUE_NAME);
+                    userValues.DeleteValue(MAIN_MENU_DISPLAY_ORDER_PACKED_VALUE_NAME);
                 }
             }
         }
@@ -538,10 +573,11 @@ namespace PathCopyCopy.Settings.Core
             }
             set {
                 if (value != null) {
-                    SavePluginsInValue(SUBMENU_DISPLAY_ORDER_VALUE_NAME, value);
+                    SavePluginsInValue(SUBMENU_DISPLAY_ORDER_VALUE_NAME, value, SUBMENU_DISPLAY_ORDER_PACKED_VALUE_NAME);
                 } else {
-                    // Delete the value in the registry instead.
-                    userKey.DeleteValue(SUBMENU_DISPLAY_ORDER_VALUE_NAME, false);
+                    // Delete the values in the registry instead.
+                    userValues.DeleteValue(SUBMENU_DISPLAY_ORDER_VALUE_NAME);
+                    userValues.DeleteValue(SUBMENU_DISPLAY_ORDER_PACKED_VALUE_NAME);
                 }
             }
         }
@@ -560,7 +596,7 @@ namespace PathCopyCopy.Settings.Core
                     SavePluginsInValue(UI_DISPLAY_ORDER_VALUE_NAME, value);
                 } else {
                     // Delete the value in the registry instead.
-                    userKey.DeleteValue(UI_DISPLAY_ORDER_VALUE_NAME, false);
+                    userValues.DeleteValue(UI_DISPLAY_ORDER_VALUE_NAME);
                 }
             }
         }
@@ -577,10 +613,11 @@ namespace PathCopyCopy.Settings.Core
             }
             set {
                 if (value != null) {
-                    SavePluginsInValue(KNOWN_PLUGINS_VALUE_NAME, value);
+                    SavePluginsInValue(KNOWN_PLUGINS_VALUE_NAME, value, KNOWN_PLUGINS_PACKED_VALUE_NAME);
                 } else {
-                    // Delete the value in the registry instead.
-                    userKey.DeleteValue(KNOWN_PLUGINS_VALUE_NAME, false);
+                    // Delete the values in the registry instead.
+                    userValues.DeleteValue(KNOWN_PLUGINS_VALUE_NAME);
+                    userValues.DeleteValue(KNOWN_PLUGINS_PACKED_VALUE_NAME);
                 }
             }
         }
@@ -609,9 +646,9 @@ namespace PathCopyCopy.Settings.Core
             }
             set {
                 if (value != null) {
-                    userKey.SetValue(IGNORED_UPDATE_VALUE_NAME, value.ToString());
+                    userValues.SetValueIfChanged(IGNORED_UPDATE_VALUE_NAME, value.ToString());
                 } else {
-                    userKey.DeleteValue(IGNORED_UPDATE_VALUE_NAME, false);
+                    userValues.DeleteValue(IGNORED_UPDATE_VALUE_NAME);
                 }
             }
         }
@@ -625,7 +662,7 @@ namespace PathCopyCopy.Settings.Core
                 return (int) GetUserOrGlobalValue(SETTINGS_FORM_POS_X_VALUE_NAME, SETTINGS_FORM_POS_SIZE_DEFAULT_VALUE);
             }
             set {
-                userKey.SetValue(SETTINGS_FORM_POS_X_VALUE_NAME, value);
+                userValues.SetValueIfChanged(SETTINGS_FORM_POS_X_VALUE_NAME, value);
             }
         }
 
@@ -638,7 +675,7 @@ namespace PathCopyCopy.Settings.Core
                 return (int) GetUserOrGlobalValue(SETTINGS_FORM_POS_Y_VALUE_NAME, SETTINGS_FORM_POS_SIZE_DEFAULT_VALUE);
             }
             set {
-                userKey.SetValue(SETTINGS_FORM_POS_Y_VALUE_NAME, value);
+                userValues.SetValueIfChanged(SETTINGS_FORM_POS_Y_VALUE_NAME, value);
             }
         }
 
@@ -651,7 +688,7 @@ namespace PathCopyCopy.Settings.Core
                 return (int) GetUserOrGlobalValue(SETTINGS_FORM_SIZE_WIDTH_VALUE_NAME, SETTINGS_FORM_POS_SIZE_DEFAULT_VALUE);
             }
             set {
-                userKey.SetValue(SETTINGS_FORM_SIZE_WIDTH_VALUE_NAME, value);
+                userValues.SetValueIfChanged(SETTINGS_FORM_SIZE_WIDTH_VALUE_NAME, value);
             }
         }
 
@@ -664,7 +701,7 @@ namespace PathCopyCopy.Settings.Core
                 return (int) GetUserOrGlobalValue(SETTINGS_FORM_SIZE_HEIGHT_VALUE_NAME, SETTINGS_FORM_POS_SIZE_DEFAULT_VALUE);
             }
             set {
-                userKey.SetValue(SETTINGS_FORM_SIZE_HEIGHT_VALUE_NAME, value);
+                userValues.SetValueIfChanged(SETTINGS_FORM_SIZE_HEIGHT_VALUE_NAME, value);
             }
         }
 
@@ -675,7 +712,7 @@ namespace PathCopyCopy.Settings.Core
         public bool EditingDisabled
         {
             get {
-                object keyLockValue = globalKey != null ? globalKey.GetValue(EDITING_DISABLED_VALUE_NAME) : null;
+                object keyLockValue = globalValues?.GetValue(EDITING_DISABLED_VALUE_NAME);
                 return keyLockValue != null ? ((int) keyLockValue) != 0 : false;
             }
         }
@@ -686,14 +723,16 @@ namespace PathCopyCopy.Settings.Core
         public string UpdateChannel
         {
             get {
-                object channelValue = globalKey != null ? globalKey.GetValue(UPDATE_CHANNEL_VALUE_NAME) : null;
+                object channelValue = globalValues?.GetValue(UPDATE_CHANNEL_VALUE_NAME);
                 return channelValue != null ? (string) channelValue : Resources.UserSettings_DefaultUpdateChannel;
             }
         }
         
         /// <summary>
         /// Constructor. Creates the registry key right away to read the settings,
-        /// both global and user-specific.
+        /// both global and user-specific. Values of the main keys are loaded in
+        /// bulk the first time one of them is needed and kept in snapshots, so
+        /// that reading settings afterwards does not require registry calls.
         /// </summary>
         public UserSettings()
         {
@@ -729,6 +768,12 @@ namespace PathCopyCopy.Settings.Core
 
             // Open the forms key for reading and writing. They are always user-specific.
             userFormsKey = userKey.CreateSubKey(PCC_FORMS_KEY);
+
+            // Create snapshots of values that are read one by one by our properties.
+            globalValues = globalKey != null ? new RegistryValuesSnapshot(globalKey) : null;
+            userValues = new RegistryValuesSnapshot(userKey);
+            globalIconsValues = globalIconsKey != null ? new RegistryValuesSnapshot(globalIconsKey) : null;
+            userIconsValues = new RegistryValuesSnapshot(userIconsKey);
         }
         
         /// <summary>
@@ -746,6 +791,19 @@ namespace PathCopyCopy.Settings.Core
             globalKey?.Close();
         }
 
+        /// <summary>
+        /// Drops the cached values of settings so that they are read again from
+        /// the registry when needed. Must be called to see changes made by other
+        /// <see cref="UserSettings"/> instances or processes.
+        /// </summary>
+        public void Reload()
+        {
+            globalValues?.Reload();
+            userValues.Reload();
+            globalIconsValues?.Reload();
+            userIconsValues.Reload();
+        }
+
         /// <summary>
         /// Uses the <c>reg</c> command to export the contents of the user key to a file.
         /// </summary>
@@ -799,9 +857,9 @@ namespace PathCopyCopy.Settings.Core
         {
             string pluginIdAsString = pluginId.ToString("B");
             if (iconFile != null) {
-                userIconsKey.SetValue(pluginIdAsString, iconFile);
-            } else if (userIconsKey.GetValue(pluginIdAsString) != null) {
-                userIconsKey.DeleteValue(pluginIdAsString);
+                userIconsValues.SetValueIfChanged(pluginIdAsString, iconFile);
+            } else {
+                userIconsValues.DeleteValue(pluginIdAsString);
             }
         }
         
@@ -831,6 +889,7 @@ namespace PathCopyCopy.Settings.Core
             } catch (ArgumentException) {
                 // The subkey did not exist, so no need to "remove" it.
             }
+            DeletePackedPipelinePlugins(userTempPipelinePluginsKey);
         }
 
         /// <summary>
@@ -867,12 +926,12 @@ namespace PathCopyCopy.Settings.Core
 
             using (RegistryKey formKey = userFormsKey.CreateSubKey(formName)) {
                 if (position.HasValue) {
-                    formKey.SetValue(FORMS_POS_X_VALUE_NAME, position.Value.X);
-                    formKey.SetValue(FORMS_POS_Y_VALUE_NAME, position.Value.Y);
+                    SetValueIfChanged(formKey, FORMS_POS_X_VALUE_NAME, position.Value.X);
+                    SetValueIfChanged(formKey, FORMS_POS_Y_VALUE_NAME, position.Value.Y);
                 }
                 if (size.HasValue) {
-                    formKey.SetValue(FORMS_SIZE_WIDTH_VALUE_NAME, size.Value.Width);
-                    formKey.SetValue(FORMS_SIZE_HEIGHT_VALUE_NAME, size.Value.Height);
+                    SetValueIfChanged(formKey, FORMS_SIZE_WIDTH_VALUE_NAME, size.Value.Width);
+                    SetValueIfChanged(formKey, FORMS_SIZE_HEIGHT_VALUE_NAME, size.Value.Height);
                 }
             }
         }
@@ -918,7 +977,11 @@ namespace PathCopyCopy.Settings.Core
         /// </summary>
         /// <param name="valueName">Name of registry value where to save plugins.</param>
         /// <param name="plugins">List of plugins to save.</param>
-        private void SavePluginsInValue(string valueName, List<Guid> plugins)
+        /// <param name="packedValueName">If set, name of registry value where to
+        /// also save plugins in packed binary form, to avoid having to parse the
+        /// string value in the contextual menu extension.</param>
+        private void SavePluginsInValue(string valueName, List<Guid> plugins,
+            string packedValueName = null)
         {
             // Scan guids and build a registry value.
             string regValue = String.Empty;
@@ -931,7 +994,22 @@ namespace PathCopyCopy.Settings.Core
             }
 
             // Save this value content in the registry.
-            userKey.SetValue(valueName, regValue);
+            userValues.SetValueIfChanged(valueName, regValue);
+
+            if (packedValueName != null) {
+                // Packed value starts with a hash of the string value so that the
+                // contextual menu extension can tell if it's stale. Must match
+                // HashPluginIdsString in PathCopyCopySettings.cpp (32-bit FNV-1a).
+                uint hash = 2166136261u;
+                foreach (char c in regValue) {
+                    hash = unchecked((hash ^ c) * 16777619u);
+                }
+                List<byte> packedValue = new List<byte>(BitConverter.GetBytes(hash));
+                foreach (Guid id in plugins) {
+                    packedValue.AddRange(id.ToByteArray());
+                }
+                userValues.SetValueIfChanged(packedValueName, packedValue.ToArray());
+            }
         }
         
         /// <summary>
@@ -1016,7 +1094,7 @@ namespace PathCopyCopy.Settings.Core
                 // Build display order string and save it.
                 List<string> idsAsString = pipelinePlugins.ConvertAll(plugin => plugin.Id.ToString("B"));
                 string displayOrder = String.Join(PIPELINE_PLUGINS_DISPLAY_ORDER_SEPARATOR.ToString(), idsAsString.ToArray());
-                regKey.SetValue(PIPELINE_PLUGINS_DISPLAY_ORDER_VALUE_NAME, displayOrder);
+                SetValueIfChanged(regKey, PIPELINE_PLUGINS_DISPLAY_ORDER_VALUE_NAME, displayOrder);
             }
 
             // Here's the algo to save the plugins:
@@ -1034,19 +1112,24 @@ namespace PathCopyCopy.Settings.Core
                 if (!pluginInfo.Global) {
                     // 2a.
                     using (RegistryKey pluginKey = regKey.CreateSubKey(pluginInfo.Id.ToString("B"))) {
-                        pluginKey.SetValue(PIPELINE_PLUGIN_DESCRIPTION_VALUE_NAME, pluginInfo.Description);
+                        SetValueIfChanged(pluginKey, PIPELINE_PLUGIN_DESCRIPTION_VALUE_NAME, pluginInfo.Description);
                         if (pluginInfo.IconFile != null) {
-                            pluginKey.SetValue(PIPELINE_PLUGIN_ICON_VALUE_NAME, pluginInfo.IconFile);
+                            SetValueIfChanged(pluginKey, PIPELINE_PLUGIN_ICON_VALUE_NAME, pluginInfo.IconFile);
                         } else if (pluginKey.GetValue(PIPELINE_PLUGIN_ICON_VALUE_NAME) != null) {
                             pluginKey.DeleteValue(PIPELINE_PLUGIN_ICON_VALUE_NAME);
                         }
-                        pluginKey.SetValue(PIPELINE_PLUGIN_REQUIRED_VERSION_VALUE_NAME, pluginInfo.RequiredVersionAsString);
+                        if (!String.IsNullOrEmpty(pluginInfo.Folder)) {
+                            SetValueIfChanged(pluginKey, PIPELINE_PLUGIN_FOLDER_VALUE_NAME, pluginInfo.Folder);
+                        } else if (pluginKey.GetValue(PIPELINE_PLUGIN_FOLDER_VALUE_NAME) != null) {
+                            pluginKey.DeleteValue(PIPELINE_PLUGIN_FOLDER_VALUE_NAME);
+                        }
+                        SetValueIfChanged(pluginKey, PIPELINE_PLUGIN_REQUIRED_VERSION_VALUE_NAME, pluginInfo.RequiredVersionAsString);
                         if (pluginInfo.EditMode.HasValue) {
-                            pluginKey.SetValue(PIPELINE_PLUGIN_EDIT_MODE_VALUE_NAME, pluginInfo.EditMode.Value.ToString());
+                            SetValueIfChanged(pluginKey, PIPELINE_PLUGIN_EDIT_MODE_VALUE_NAME, pluginInfo.EditMode.Value.ToString());
                         } else if (pluginKey.GetValue(PIPELINE_PLUGIN_EDIT_MODE_VALUE_NAME) != null) {
                             pluginKey.DeleteValue(PIPELINE_PLUGIN_EDIT_MODE_VALUE_NAME);
                         }
-                        pluginKey.SetValue(null, pluginInfo.EncodedElements);
+                        SetValueIfChanged(pluginKey, null, EncodedElementsToRegistryValue(pluginInfo.EncodedElements));
                     }
                 }
             }
@@ -1054,13 +1137,109 @@ namespace PathCopyCopy.Settings.Core
             // 3.
             if (removeObsolete) {
                 Debug.Assert(existingPlugins != null);
+                HashSet<string> pluginKeyNames = new HashSet<string>();
+                pipelinePlugins.ForEach(plugin => pluginKeyNames.Add(plugin.Id.ToString("B")));
                 foreach (string existingPlugin in existingPlugins) {
-                    if (!pipelinePlugins.Exists(plugin => plugin.Id.ToString("B").Equals(existingPlugin))) {
+                    if (!pluginKeyNames.Contains(existingPlugin)) {
                         // 3a.
                         regKey.DeleteSubKeyTree(existingPlugin);
                     }
                 }
             }
+
+            // The packed value must contain all plugins in the key. We only know
+            // them all when obsolete plugins are removed; otherwise, drop the packed
+            // value so that the C++ code falls back to reading the subkeys.
+            if (removeObsolete) {
+                SetValueIfChanged(regKey, PIPELINE_PLUGINS_PACKED_VALUE_NAME,
+                    PackPipelinePlugins(pipelinePlugins.FindAll(plugin => !plugin.Global),
+                                        ComputePipelinePluginsStamp(regKey)));
+            } else {
+                DeletePackedPipelinePlugins(regKey);
+            }
+        }
+
+        /// <summary>
+        /// Packs pipeline plugins in a single binary value that the C++ code
+        /// can load in one registry call instead of reading each plugin's subkey.
+        /// </summary>
+        /// <param name="pipelinePlugins">Pipeline plugins to pack.</param>
+        /// <param name="stamp">Stamp of the pipeline plugins' subkeys; see
+        /// <see cref="ComputePipelinePluginsStamp"/>.</param>
+        /// <returns>Packed binary value.</returns>
+        /// <remarks>
+        /// Please refer to the C++ code in "PathCopyCopySettings.cpp" to see
+        /// the opposite side of the encoding/decoding work.</remarks>
+        private static byte[] PackPipelinePlugins(List<PipelinePluginInfo> pipelinePlugins,
+            string stamp)
+        {
+            Debug.Assert(pipelinePlugins != null);
+            Debug.Assert(stamp != null);
+
+            StringBuilder packed = new StringBuilder();
+            packed.Append(PIPELINE_PLUGINS_PACKED_SIGNATURE);
+            packed.Append(stamp);
+            packed.Append(PipelineElement.EncodeBinaryInt(pipelinePlugins.Count));
+            foreach (PipelinePluginInfo pluginInfo in pipelinePlugins) {
+                packed.Append(PipelineElement.EncodeBinaryGuid(pluginInfo.Id));
+                packed.Append(PipelineElement.EncodeBinaryString(pluginInfo.Description));
+                packed.Append(PipelineElement.EncodeBinaryString(
+                    ToBinaryEncodedElements(pluginInfo.EncodedElements) ?? pluginInfo.EncodedElements));
+                packed.Append(PipelineElement.EncodeBinaryBool(pluginInfo.IconFile != null));
+                if (pluginInfo.IconFile != null) {
+                    packed.Append(PipelineElement.EncodeBinaryString(pluginInfo.IconFile));
+                }
+                packed.Append(PipelineElement.EncodeBinaryString(pluginInfo.Folder ?? String.Empty));
+            }
+
+            string packedAsString = packed.ToString();
+            byte[] bytes = new byte[packedAsString.Length * sizeof(char)];
+            Buffer.BlockCopy(packedAsString.ToCharArray(), 0, bytes, 0, bytes.Length);
+            return bytes;
+        }
+
+        /// <summary>
+        /// Computes the stamp of the pipeline plugins stored as subkeys of the
+        /// given registry key: their number and the most recent of their last
+        /// write times. The C++ code compares it with the subkeys' current stamp
+        /// to make sure the packed value is up to date.
+        /// </summary>
+        /// <param name="regKey">Registry key containing pipeline plugins.</param>
+        /// <returns>Stamp, encoded like in the packed value.</returns>
+        /// <remarks>
+        /// Must match <c>ComputePipelinePluginsStamp</c> in "PathCopyCopySettings.cpp".
+        /// </remarks>
+        private static string ComputePipelinePluginsStamp(RegistryKey regKey)
+        {
+            Debug.Assert(regKey != null);
+
+            string[] subKeyNames = regKey.GetSubKeyNames();
+            long lastWriteTime = 0;
+            foreach (string subKeyName in subKeyNames) {
+                using (RegistryKey subKey = regKey.OpenSubKey(subKeyName)) {
+                    long subKeyLastWriteTime;
+                    if (subKey != null && NativeMethods.RegQueryInfoKey(subKey.Handle, IntPtr.Zero, IntPtr.Zero,
+                        IntPtr.Zero, IntPtr.Zero, IntPtr.Zero, IntPtr.Zero, IntPtr.Zero, IntPtr.Zero,
+                        IntPtr.Zero, IntPtr.Zero, out subKeyLastWriteTime) == 0) {
+
+                        lastWriteTime = Math.Max(lastWriteTime, subKeyLastWriteTime);
+                    }
+                }
+            }
+            return PipelineElement.EncodeBinaryInt(subKeyNames.Length) +
+                PipelineElement.EncodeBinaryInt((int) (lastWriteTime & 0xFFFFFFFF)) +
+                PipelineElement.EncodeBinaryInt((int) ((lastWriteTime >> 32) & 0xFFFFFFFF));
+        }
+
+        /// <summary>
+        /// Deletes the packed pipeline plugins value from the given registry key, if any.
+        /// </summary>
+        /// <param name="regKey">Registry key containing pipeline plugins.</param>
+        private static void DeletePackedPipelinePlugins(RegistryKey regKey)
+        {
+            Debug.Assert(regKey != null);
+
+            regKey.DeleteValue(PIPELINE_PLUGINS_PACKED_VALUE_NAME, false);
         }
         
         /// <summary>
@@ -1085,14 +1264,15 @@ namespace PathCopyCopy.Settings.Core
                     Guid id = new Guid(idAsString);
 
                     // Open the subkey and read values for the description,
-                    // encoded elements, icon file and required version.
-                    string description, encodedElements, iconFile, minVersionAsString, editModeAsString;
+                    // encoded elements, icon file, folder and required version.
+                    string description, encodedElements, iconFile, folder, minVersionAsString, editModeAsString;
                     using (RegistryKey subKey = regKey.OpenSubKey(idAsString, false)) {
                         description = (string) subKey.GetValue(PIPELINE_PLUGIN_DESCRIPTION_VALUE_NAME);
                         iconFile = (string) subKey.GetValue(PIPELINE_PLUGIN_ICON_VALUE_NAME);
+                        folder = (string) subKey.GetValue(PIPELINE_PLUGIN_FOLDER_VALUE_NAME);
                         minVersionAsString = (string) subKey.GetValue(PIPELINE_PLUGIN_REQUIRED_VERSION_VALUE_NAME);
                         editModeAsString = (string) subKey.GetValue(PIPELINE_PLUGIN_EDIT_MODE_VALUE_NAME);
-                        encodedElements = (string) subKey.GetValue(null);
+                        encodedElements = RegistryValueToEncodedElements(subKey.GetValue(null));
                     }
 
                     // If we don't have min version in the registry, try to compute it now.
@@ -1118,14 +1298,85 @@ namespace PathCopyCopy.Settings.Core
                     }
 
                     // If we made it here we have the plugin info, add it to the list.
-                    pipelinePlugins.Add(new PipelinePluginInfo(id, description, encodedElements,
-                        iconFile, editMode, isGlobal, minVersion));
+                    PipelinePluginInfo pluginInfo = new PipelinePluginInfo(id, description, encodedElements,
+                        iconFile, editMode, isGlobal, minVersion);
+                    pluginInfo.Folder = folder;
+                    pipelinePlugins.Add(pluginInfo);
                 } catch (FormatException) {
                 } catch (OverflowException) {
                 }
             }
         }
         
+        /// <summary>
+        /// Converts encoded pipeline elements to the value to store in the
+        /// registry. Pipelines are stored in binary format when possible,
+        /// since it's faster to decode.
+        /// </summary>
+        /// <param name="encodedElements">Encoded pipeline elements.</param>
+        /// <returns>Binary value containing the pipeline encoded in binary
+        /// format, or <paramref name="encodedElements"/> if the pipeline
+        /// cannot be decoded.</returns>
+        private static object EncodedElementsToRegistryValue(string encodedElements)
+        {
+            string binaryEncodedElements = ToBinaryEncodedElements(encodedElements);
+
+            object value = encodedElements;
+            if (binaryEncodedElements != null) {
+                byte[] bytes = new byte[binaryEncodedElements.Length * sizeof(char)];
+                Buffer.BlockCopy(binaryEncodedElements.ToCharArray(), 0, bytes, 0, bytes.Length);
+                value = bytes;
+            }
+            return value;
+        }
+
+        /// <summary>
+        /// Converts encoded pipeline elements to binary format.
+        /// </summary>
+        /// <param name="encodedElements">Encoded pipeline elements.</param>
+        /// <returns>Pipeline encoded in binary format, or <c>null</c> if
+        /// the pipeline cannot be decoded.</returns>
+        private static string ToBinaryEncodedElements(string encodedElements)
+        {
+            string binaryEncodedElements = null;
+            if (encodedElements.Length != 0 && encodedElements[0] == Pipeline.BINARY_FORMAT_SIGNATURE) {
+                binaryEncodedElements = encodedElements;
+            } else {
+                try {
+                    binaryEncodedElements = PipelineDecoder.DecodePipeline(encodedElements).EncodeBinary();
+                } catch (InvalidPipelineException) {
+                    // Can't convert.
+                }
+            }
+            return binaryEncodedElements;
+        }
+
+        /// <summary>
+        /// Converts a pipeline value stored in the registry to encoded
+        /// pipeline elements in text format, which is the format used
+        /// everywhere else in the settings application.
+        /// </summary>
+        /// <param name="value">Registry value, either a string or binary.</param>
+        /// <returns>Encoded pipeline elements; if a binary value cannot be
+        /// decoded, it is returned in binary format.</returns>
+        private static string RegistryValueToEncodedElements(object value)
+        {
+            byte[] bytes = value as byte[];
+            if (bytes == null) {
+                return (string) value;
+            }
+
+            char[] chars = new char[bytes.Length / sizeof(char)];
+            Buffer.BlockCopy(bytes, 0, chars, 0, chars.Length * sizeof(char));
+            string encodedElements = new string(chars);
+            try {
+                encodedElements = PipelineDecoder.DecodePipeline(encodedElements).Encode();
+            } catch (InvalidPipelineException) {
+                // Probably from a more recent version; keep as-is so that it is saved back unchanged.
+            }
+            return encodedElements;
+        }
+
         /// <summary>
         /// Reads a registry value from the user key first, and if not found,
         /// from the global key.
@@ -1134,7 +1385,7 @@ namespace PathCopyCopy.Settings.Core
         /// <returns>Value, or <c>null</c> if the value is not found.</returns>
         private object GetUserOrGlobalValue(string name)
         {
-            return userKey.GetValue(name) ?? globalKey?.GetValue(name);
+            return userValues.GetValue(name) ?? globalValues?.GetValue(name);
         }
         
         /// <summary>
@@ -1158,9 +1409,9 @@ namespace PathCopyCopy.Settings.Core
         /// was found.</returns>
         private string GetUserOrGlobalIconFile(string pluginId)
         {
-            object value = userIconsKey.GetValue(pluginId);
-            if ((value == null || !(value is string)) && globalIconsKey != null) {
-                value = globalIconsKey.GetValue(pluginId);
+            object value = userIconsValues.GetValue(pluginId);
+            if ((value == null || !(value is string)) && globalIconsValues != null) {
+                value = globalIconsValues.GetValue(pluginId);
             }
             if (value != null && !(value is string)) {
                 value = null;
@@ -1168,6 +1419,41 @@ namespace PathCopyCopy.Settings.Core
             return (string) value;
         }
 
+        /// <summary>
+        /// Sets a registry value, unless it already contains the same data.
+        /// Every write triggers registry change notifications, which cause
+        /// all running instances of the contextual menu extension to reload
+        /// their settings, so we avoid writing values that did not change.
+        /// </summary>
+        /// <param name="regKey">Registry key containing the value.</param>
+        /// <param name="valueName">Name of registry value to set, or <c>null</c>
+        /// for the key's default value.</param>
+        /// <param name="value">Value to store. Like with <see cref="RegistryKey.SetValue(string, object)"/>,
+        /// the kind of registry value depends on the type of this object
+        /// (<c>int</c>, <c>string</c> or <c>byte[]</c>).</param>
+        private static void SetValueIfChanged(RegistryKey regKey, string valueName, object value)
+        {
+            Debug.Assert(regKey != null);
+            Debug.Assert(value != null);
+
+            object currentValue = regKey.GetValue(valueName, null, RegistryValueOptions.DoNotExpandEnvironmentNames);
+            bool changed;
+            if (currentValue is byte[] && value is byte[]) {
+                changed = !((byte[]) currentValue).SequenceEqual((byte[]) value);
+            } else {
+                // This also detects values of a different kind, like a string
+                // containing "1" where we want to store a DWORD.
+                changed = !value.Equals(currentValue);
+            }
+            if (!changed && currentValue is string && regKey.GetValueKind(valueName) != RegistryValueKind.String) {
+                // Same data, but stored as another kind of string (e.g. REG_EXPAND_SZ).
+                changed = true;
+            }
+            if (changed) {
+                regKey.SetValue(valueName, value);
+            }
+        }
+
         /// <summary>
         /// Attempts to read a registry key value containing form information.
         /// </summary>
@@ -1187,5 +1473,18 @@ namespace PathCopyCopy.Settings.Core
             }
             return value;
         }
+
+        /// <summary>
+        /// Wrapper for Win32 functions used to read registry key information.
+        /// </summary>
+        private static class NativeMethods
+        {
+            [DllImport("advapi32.dll", CharSet = CharSet.Unicode)]
+            public static extern int RegQueryInfoKey(Microsoft.Win32.SafeHandles.SafeRegistryHandle hKey,
+                IntPtr lpClass, IntPtr lpcchClass, IntPtr lpReserved, IntPtr lpcSubKeys,
+                IntPtr lpcbMaxSubKeyLen, IntPtr lpcbMaxClassLen, IntPtr lpcValues,
+                IntPtr lpcbMaxValueNameLen, IntPtr lpcbMaxValueLen, IntPtr lpcbSecurityDescriptor,
+                out long lpftLastWriteTime);
+        }
     }
 }
@@ -397,6 +397,17 @@ namespace PathCopyCopy.Settings.Properties {
             }
         }
         
+        /// <summary>
+        ///   Looks up a localized string similar to Enabled: {0} calls, p50 {1:0.###} ms, p99 {2:0.###} ms, {3} failures
+        ///Path: {4} calls, p50 {5:0.###} ms, p99 {6:0.###} ms, {7} failures
+        ///Cache: {8} hits, {9} misses.
+        /// </summary>
+        internal static string MainForm_PluginsDataGrid_StatisticsToolTipText {
+            get {
+                return ResourceManager.GetString("MainForm_PluginsDataGrid_StatisticsToolTipText", resourceCulture);
+            }
+        }
+        
         /// <summary>
         ///   Looks up a localized string similar to Copy MSYS/MSYS2 Path.
         /// </summary>
@@ -415,6 +426,24 @@ namespace PathCopyCopy.Settings.Properties {
             }
         }
         
+        /// <summary>
+        ///   Looks up a localized string similar to Copy OneDrive/SharePoint URL.
+        /// </summary>
+        internal static string ONEDRIVE_URL_PLUGIN_DESCRIPTION {
+            get {
+                return ResourceManager.GetString("ONEDRIVE_URL_PLUGIN_DESCRIPTION", resourceCulture);
+            }
+        }
+        
+        /// <summary>
+        ///   Looks up a localized string similar to {D97DA1A7-2660-40CD-AD2F-257B7740CAE1}.
+        /// </summary>
+        internal static string ONEDRIVE_URL_PLUGIN_ID {
+            get {
+                return ResourceManager.GetString("ONEDRIVE_URL_PLUGIN_ID", resourceCulture);
+            }
+        }
+        
         /// <summary>
         ///   Looks up a localized string similar to PCC32.dll.
         /// </summary>
@@ -478,6 +507,78 @@ namespace PathCopyCopy.Settings.Properties {
             }
         }
         
+        /// <summary>
+        ///   Looks up a localized string similar to Launch Executable in Batches.
+        /// </summary>
+        internal static string PipelineElement_BatchExecutable {
+            get {
+                return ResourceManager.GetString("PipelineElement_BatchExecutable", resourceCulture);
+            }
+        }
+        
+        /// <summary>
+        ///   Looks up a localized string similar to When launching an executable, split paths in batches that fit on a command line and launch the executable once per batch, optionally running multiple batches at once.
+        /// </summary>
+        internal static string PipelineElement_BatchExecutable_HelpText {
+            get {
+                return ResourceManager.GetString("PipelineElement_BatchExecutable_HelpText", resourceCulture);
+            }
+        }
+        
+        /// <summary>
+        ///   Looks up a localized string similar to Prepend Content Hash.
+        /// </summary>
+        internal static string PipelineElement_ContentHash {
+            get {
+                return ResourceManager.GetString("PipelineElement_ContentHash", resourceCulture);
+            }
+        }
+        
+        /// <summary>
+        ///   Looks up a localized string similar to Prepend the SHA-256 hash of the file's content to the path, like sha256sum (place after elements producing a path that can be opened on this computer).
+        /// </summary>
+        internal static string PipelineElement_ContentHash_HelpText {
+            get {
+                return ResourceManager.GetString("PipelineElement_ContentHash_HelpText", resourceCulture);
+            }
+        }
+        
+        /// <summary>
+        ///   Looks up a localized string similar to Copy Paths in Multiple Clipboard Formats.
+        /// </summary>
+        internal static string PipelineElement_CopyMultipleFormats {
+            get {
+                return ResourceManager.GetString("PipelineElement_CopyMultipleFormats", resourceCulture);
+            }
+        }
+        
+        /// <summary>
+        ///   Looks up a localized string similar to Copy paths to the clipboard as text, HTML links and files all at once, so that they can be pasted in different kinds of applications.
+        /// </summary>
+        internal static string PipelineElement_CopyMultipleFormats_HelpText {
+            get {
+                return ResourceManager.GetString("PipelineElement_CopyMultipleFormats_HelpText", resourceCulture);
+            }
+        }
+        
+        /// <summary>
+        ///   Looks up a localized string similar to Remember Paths Until Settings Change.
+        /// </summary>
+        internal static string PipelineElement_Memoize {
+            get {
+                return ResourceManager.GetString("PipelineElement_Memoize", resourceCulture);
+            }
+        }
+        
+        /// <summary>
+        ///   Looks up a localized string similar to Cache the paths returned by this command and reuse them for the same files until settings change (only use if the result depends solely on the file's path).
+        /// </summary>
+        internal static string PipelineElement_Memoize_HelpText {
+            get {
+                return ResourceManager.GetString("PipelineElement_Memoize_HelpText", resourceCulture);
+            }
+        }
+        
         /// <summary>
         ///   Looks up a localized string similar to Create Email Links.
         /// </summary>
@@ -532,6 +633,24 @@ namespace PathCopyCopy.Settings.Properties {
             }
         }
         
+        /// <summary>
+        ///   Looks up a localized string similar to Use Environment Variables.
+        /// </summary>
+        internal static string PipelineElement_EnvironmentVariables {
+            get {
+                return ResourceManager.GetString("PipelineElement_EnvironmentVariables", resourceCulture);
+            }
+        }
+        
+        /// <summary>
+        ///   Looks up a localized string similar to Replace the beginning of the path with the environment variable containing it (like %APPDATA%) to make the path portable across machines.
+        /// </summary>
+        internal static string PipelineElement_EnvironmentVariables_HelpText {
+            get {
+                return ResourceManager.GetString("PipelineElement_EnvironmentVariables_HelpText", resourceCulture);
+            }
+        }
+        
         /// <summary>
         ///   Looks up a localized string similar to Option: Launch Executable.
         /// </summary>
@@ -568,6 +687,78 @@ namespace PathCopyCopy.Settings.Properties {
             }
         }
         
+        /// <summary>
+        ///   Looks up a localized string similar to Export as CSV with Metadata.
+        /// </summary>
+        internal static string PipelineElement_ExportCSV {
+            get {
+                return ResourceManager.GetString("PipelineElement_ExportCSV", resourceCulture);
+            }
+        }
+        
+        /// <summary>
+        ///   Looks up a localized string similar to Output paths as CSV records including the size, timestamps and attributes of their files, after a header row.
+        /// </summary>
+        internal static string PipelineElement_ExportCSV_HelpText {
+            get {
+                return ResourceManager.GetString("PipelineElement_ExportCSV_HelpText", resourceCulture);
+            }
+        }
+        
+        /// <summary>
+        ///   Looks up a localized string similar to Export as JSON with Metadata.
+        /// </summary>
+        internal static string PipelineElement_ExportJSON {
+            get {
+                return ResourceManager.GetString("PipelineElement_ExportJSON", resourceCulture);
+            }
+        }
+        
+        /// <summary>
+        ///   Looks up a localized string similar to Output paths as an array of JSON objects including the size, timestamps and attributes of their files.
+        /// </summary>
+        internal static string PipelineElement_ExportJSON_HelpText {
+            get {
+                return ResourceManager.GetString("PipelineElement_ExportJSON_HelpText", resourceCulture);
+            }
+        }
+        
+        /// <summary>
+        ///   Looks up a localized string similar to Template.
+        /// </summary>
+        internal static string PipelineElement_Template {
+            get {
+                return ResourceManager.GetString("PipelineElement_Template", resourceCulture);
+            }
+        }
+        
+        /// <summary>
+        ///   Looks up a localized string similar to Replace the path with a template combining text and the outputs of other commands: use {plugin:ID} for the output of a command and {path} for the path itself.
+        /// </summary>
+        internal static string PipelineElement_Template_HelpText {
+            get {
+                return ResourceManager.GetString("PipelineElement_Template_HelpText", resourceCulture);
+            }
+        }
+        
+        /// <summary>
+        ///   Looks up a localized string similar to Resolve Links.
+        /// </summary>
+        internal static string PipelineElement_FinalPath {
+            get {
+                return ResourceManager.GetString("PipelineElement_FinalPath", resourceCulture);
+            }
+        }
+        
+        /// <summary>
+        ///   Looks up a localized string similar to Replace junctions and symbolic links found in the path with their targets to get the final path to the file.
+        /// </summary>
+        internal static string PipelineElement_FinalPath_HelpText {
+            get {
+                return ResourceManager.GetString("PipelineElement_FinalPath_HelpText", resourceCulture);
+            }
+        }
+        
         /// <summary>
         ///   Looks up a localized string similar to Find / Replace.
         /// </summary>
@@ -604,6 +795,60 @@ namespace PathCopyCopy.Settings.Properties {
             }
         }
         
+        /// <summary>
+        ///   Looks up a localized string similar to Skip Unless Path Matches.
+        /// </summary>
+        internal static string PipelineElement_Guard {
+            get {
+                return ResourceManager.GetString("PipelineElement_Guard", resourceCulture);
+            }
+        }
+        
+        /// <summary>
+        ///   Looks up a localized string similar to Apply the following elements only to paths starting with or containing a value; other paths are copied as-is or the command is disabled.
+        /// </summary>
+        internal static string PipelineElement_Guard_HelpText {
+            get {
+                return ResourceManager.GetString("PipelineElement_Guard_HelpText", resourceCulture);
+            }
+        }
+        
+        /// <summary>
+        ///   Looks up a localized string similar to Normalize Unicode (NFC).
+        /// </summary>
+        internal static string PipelineElement_NormalizeNFC {
+            get {
+                return ResourceManager.GetString("PipelineElement_NormalizeNFC", resourceCulture);
+            }
+        }
+        
+        /// <summary>
+        ///   Looks up a localized string similar to Convert accented characters in the path to their composed form, as expected by most Linux tools and Samba servers.
+        /// </summary>
+        internal static string PipelineElement_NormalizeNFC_HelpText {
+            get {
+                return ResourceManager.GetString("PipelineElement_NormalizeNFC_HelpText", resourceCulture);
+            }
+        }
+        
+        /// <summary>
+        ///   Looks up a localized string similar to Normalize Unicode (NFD).
+        /// </summary>
+        internal static string PipelineElement_NormalizeNFD {
+            get {
+                return ResourceManager.GetString("PipelineElement_NormalizeNFD", resourceCulture);
+            }
+        }
+        
+        /// <summary>
+        ///   Looks up a localized string similar to Convert accented characters in the path to their decomposed form, as used by macOS file systems.
+        /// </summary>
+        internal static string PipelineElement_NormalizeNFD_HelpText {
+            get {
+                return ResourceManager.GetString("PipelineElement_NormalizeNFD_HelpText", resourceCulture);
+            }
+        }
+        
         /// <summary>
         ///   Looks up a localized string similar to Add Quotes If Needed.
         /// </summary>
@@ -622,6 +867,24 @@ namespace PathCopyCopy.Settings.Properties {
             }
         }
         
+        /// <summary>
+        ///   Looks up a localized string similar to Write Paths to File.
+        /// </summary>
+        internal static string PipelineElement_OutputFile {
+            get {
+                return ResourceManager.GetString("PipelineElement_OutputFile", resourceCulture);
+            }
+        }
+        
+        /// <summary>
+        ///   Looks up a localized string similar to Write paths to a file, one per line, instead of copying them to the clipboard; leave the file empty to choose it each time..
+        /// </summary>
+        internal static string PipelineElement_OutputFile_HelpText {
+            get {
+                return ResourceManager.GetString("PipelineElement_OutputFile_HelpText", resourceCulture);
+            }
+        }
+        
         /// <summary>
         ///   Looks up a localized string similar to Option: Paths Separator.
         /// </summary>
@@ -640,6 +903,24 @@ namespace PathCopyCopy.Settings.Properties {
             }
         }
         
+        /// <summary>
+        ///   Looks up a localized string similar to Replace Path Prefixes Using a Mapping Table.
+        /// </summary>
+        internal static string PipelineElement_PrefixMapping {
+            get {
+                return ResourceManager.GetString("PipelineElement_PrefixMapping", resourceCulture);
+            }
+        }
+        
+        /// <summary>
+        ///   Looks up a localized string similar to Replace the longest prefix of the path found in a table of prefixes and replacement values.
+        /// </summary>
+        internal static string PipelineElement_PrefixMapping_HelpText {
+            get {
+                return ResourceManager.GetString("PipelineElement_PrefixMapping_HelpText", resourceCulture);
+            }
+        }
+        
         /// <summary>
         ///   Looks up a localized string similar to Add Quotes.
         /// </summary>
@@ -694,6 +975,24 @@ namespace PathCopyCopy.Settings.Properties {
             }
         }
         
+        /// <summary>
+        ///   Looks up a localized string similar to Send Paths to Running Instance.
+        /// </summary>
+        internal static string PipelineElement_RunningInstance {
+            get {
+                return ResourceManager.GetString("PipelineElement_RunningInstance", resourceCulture);
+            }
+        }
+        
+        /// <summary>
+        ///   Looks up a localized string similar to When launching an executable, first try to send paths to an already-running instance through a named pipe or window, launching the executable only if it cannot be reached.
+        /// </summary>
+        internal static string PipelineElement_RunningInstance_HelpText {
+            get {
+                return ResourceManager.GetString("PipelineElement_RunningInstance_HelpText", resourceCulture);
+            }
+        }
+        
         /// <summary>
         ///   Looks up a localized string similar to Please enter a name for the custom command..
         /// </summary>
@@ -730,6 +1029,35 @@ namespace PathCopyCopy.Settings.Properties {
             }
         }
         
+        /// <summary>
+        ///   Looks up a localized string similar to n/a.
+        /// </summary>
+        internal static string PipelineProfileForm_AllocationsUnavailable {
+            get {
+                return ResourceManager.GetString("PipelineProfileForm_AllocationsUnavailable", resourceCulture);
+            }
+        }
+        
+        /// <summary>
+        ///   Looks up a localized string similar to An error occured while profiling the custom command:
+///
+///{0}.
+        /// </summary>
+        internal static string PipelineProfileForm_Msg_ProfilingFailed {
+            get {
+                return ResourceManager.GetString("PipelineProfileForm_Msg_ProfilingFailed", resourceCulture);
+            }
+        }
+        
+        /// <summary>
+        ///   Looks up a localized string similar to Total: {0} µs per path ({1} sample paths converted {2} times each).
+        /// </summary>
+        internal static string PipelineProfileForm_Total {
+            get {
+                return ResourceManager.GetString("PipelineProfileForm_Total", resourceCulture);
+            }
+        }
+        
         /// <summary>
         ///   Looks up a localized string similar to #ERROR#.
         /// </summary>
@@ -739,6 +1067,24 @@ namespace PathCopyCopy.Settings.Properties {
             }
         }
         
+        /// <summary>
+        ///   Looks up a localized string similar to Match time: {0:0.###} ms.
+        /// </summary>
+        internal static string RegexTesterForm_MatchTime {
+            get {
+                return ResourceManager.GetString("RegexTesterForm_MatchTime", resourceCulture);
+            }
+        }
+        
+        /// <summary>
+        ///   Looks up a localized string similar to Slow regular expression: {0:0.###} ms.
+        /// </summary>
+        internal static string RegexTesterForm_SlowMatchTime {
+            get {
+                return ResourceManager.GetString("RegexTesterForm_SlowMatchTime", resourceCulture);
+            }
+        }
+        
         /// <summary>
         ///   Looks up a localized string similar to PathCopyCopyRegexTester.exe.
         /// </summary>
@@ -775,6 +1121,24 @@ namespace PathCopyCopy.Settings.Properties {
             }
         }
         
+        /// <summary>
+        ///   Looks up a localized string similar to Copy Repository Path.
+        /// </summary>
+        internal static string REPOSITORY_PATH_PLUGIN_DESCRIPTION {
+            get {
+                return ResourceManager.GetString("REPOSITORY_PATH_PLUGIN_DESCRIPTION", resourceCulture);
+            }
+        }
+        
+        /// <summary>
+        ///   Looks up a localized string similar to {7D1CEF53-4459-4FC9-885F-AB4D21CE762B}.
+        /// </summary>
+        internal static string REPOSITORY_PATH_PLUGIN_ID {
+            get {
+                return ResourceManager.GetString("REPOSITORY_PATH_PLUGIN_ID", resourceCulture);
+            }
+        }
+        
         /// <summary>
         ///   Looks up a localized string similar to Copy Samba Path.
         /// </summary>
@@ -883,6 +1247,24 @@ namespace PathCopyCopy.Settings.Properties {
             }
         }
         
+        /// <summary>
+        ///   Looks up a localized string similar to An error occured while exporting slow operations to &quot;{0}&quot;..
+        /// </summary>
+        internal static string SlowOperationsForm_Msg_NotExported {
+            get {
+                return ResourceManager.GetString("SlowOperationsForm_Msg_NotExported", resourceCulture);
+            }
+        }
+        
+        /// <summary>
+        ///   Looks up a localized string similar to Slow Operations Not Exported.
+        /// </summary>
+        internal static string SlowOperationsForm_Msg_NotExportedMsgTitle {
+            get {
+                return ResourceManager.GetString("SlowOperationsForm_Msg_NotExportedMsgTitle", resourceCulture);
+            }
+        }
+        
         /// <summary>
         ///   Looks up a localized string similar to Copy Unix Path.
         /// </summary>
@@ -32,8 +32,11 @@
             this.CancelBtn = new System.Windows.Forms.Button();
             this.OKBtn = new System.Windows.Forms.Button();
             this.SwitchBtn = new System.Windows.Forms.Button();
+            this.ProfileBtn = new System.Windows.Forms.Button();
             this.AdvancedPipelinePluginToolTip = new System.Windows.Forms.ToolTip(this.components);
             this.NameTxt = new System.Windows.Forms.TextBox();
+            this.FolderLbl = new System.Windows.Forms.Label();
+            this.FolderTxt = new System.Windows.Forms.TextBox();
             this.ElementsLst = new System.Windows.Forms.ListBox();
             this.NewElementBtn = new System.Windows.Forms.Button();
             this.ElementsImageList = new System.Windows.Forms.ImageList(this.components);
@@ -55,7 +58,7 @@
             this.CancelBtn.Location = new System.Drawing.Point(551, 395);
             this.CancelBtn.Name = "CancelBtn";
             this.CancelBtn.Size = new System.Drawing.Size(75, 23);
-            this.CancelBtn.TabIndex = 13;
+            this.CancelBtn.TabIndex = 16;
             this.CancelBtn.Text = "Cancel";
             this.AdvancedPipelinePluginToolTip.SetToolTip(this.CancelBtn, "Do not save this custom command and close the window");
             this.CancelBtn.UseVisualStyleBackColor = true;
@@ -67,7 +70,7 @@
             this.OKBtn.Location = new System.Drawing.Point(470, 395);
             this.OKBtn.Name = "OKBtn";
             this.OKBtn.Size = new System.Drawing.Size(75, 23);
-            this.OKBtn.TabIndex = 12;
+            this.OKBtn.TabIndex = 15;
             this.OKBtn.Text = "OK";
             this.AdvancedPipelinePluginToolTip.SetToolTip(this.OKBtn, "Save this custom command and close the window");
             this.OKBtn.UseVisualStyleBackColor = true;
@@ -79,21 +82,52 @@
             this.SwitchBtn.Location = new System.Drawing.Point(12, 395);
             this.SwitchBtn.Name = "SwitchBtn";
             this.SwitchBtn.Size = new System.Drawing.Size(94, 23);
-            this.SwitchBtn.TabIndex = 11;
+            this.SwitchBtn.TabIndex = 13;
             this.SwitchBtn.Text = "Simple Mode";
             this.AdvancedPipelinePluginToolTip.SetToolTip(this.SwitchBtn, "Switch to Simple Mode, which is easier to use but has less customzation options");
             this.SwitchBtn.UseVisualStyleBackColor = true;
             // 
+            // ProfileBtn
+            // 
+            this.ProfileBtn.Anchor = ((System.Windows.Forms.AnchorStyles)((System.Windows.Forms.AnchorStyles.Bottom | System.Windows.Forms.AnchorStyles.Left)));
+            this.ProfileBtn.Location = new System.Drawing.Point(112, 395);
+            this.ProfileBtn.Name = "ProfileBtn";
+            this.ProfileBtn.Size = new System.Drawing.Size(75, 23);
+            this.ProfileBtn.TabIndex = 14;
+            this.ProfileBtn.Text = "&Profile...";
+            this.AdvancedPipelinePluginToolTip.SetToolTip(this.ProfileBtn, "Measure the time spent in each element of this custom command");
+            this.ProfileBtn.UseVisualStyleBackColor = true;
+            this.ProfileBtn.Click += new System.EventHandler(this.ProfileBtn_Click);
+            // 
             // NameTxt
             // 
             this.NameTxt.Anchor = ((System.Windows.Forms.AnchorStyles)(((System.Windows.Forms.AnchorStyles.Top | System.Windows.Forms.AnchorStyles.Left) 
             | System.Windows.Forms.AnchorStyles.Right)));
             this.NameTxt.Location = new System.Drawing.Point(56, 12);
             this.NameTxt.Name = "NameTxt";
-            this.NameTxt.Size = new System.Drawing.Size(570, 20);
+            this.NameTxt.Size = new System.Drawing.Size(420, 20);
             this.NameTxt.TabIndex = 1;
             this.AdvancedPipelinePluginToolTip.SetToolTip(this.NameTxt, "Name of this custom command");
             // 
+            // FolderLbl
+            // 
+            this.FolderLbl.Anchor = ((System.Windows.Forms.AnchorStyles)((System.Windows.Forms.AnchorStyles.Top | System.Windows.Forms.AnchorStyles.Right)));
+            this.FolderLbl.AutoSize = true;
+            this.FolderLbl.Location = new System.Drawing.Point(482, 15);
+            this.FolderLbl.Name = "FolderLbl";
+            this.FolderLbl.Size = new System.Drawing.Size(39, 13);
+            this.FolderLbl.TabIndex = 2;
+            this.FolderLbl.Text = "Fol&der:";
+            // 
+            // FolderTxt
+            // 
+            this.FolderTxt.Anchor = ((System.Windows.Forms.AnchorStyles)((System.Windows.Forms.AnchorStyles.Top | System.Windows.Forms.AnchorStyles.Right)));
+            this.FolderTxt.Location = new System.Drawing.Point(527, 12);
+            this.FolderTxt.Name = "FolderTxt";
+            this.FolderTxt.Size = new System.Drawing.Size(99, 20);
+            this.FolderTxt.TabIndex = 3;
+            this.AdvancedPipelinePluginToolTip.SetToolTip(this.FolderTxt, "Name of the nested submenu in which to display this custom command. Leave empty to display it directly in the submenu.");
+            // 
             // ElementsLst
             // 
             this.ElementsLst.Anchor = ((System.Windows.Forms.AnchorStyles)(((System.Windows.Forms.AnchorStyles.Top | System.Windows.Forms.AnchorStyles.Bottom) 
@@ -103,7 +137,7 @@
             this.ElementsLst.Location = new System.Drawing.Point(12, 67);
             this.ElementsLst.Name = "ElementsLst";
             this.ElementsLst.Size = new System.Drawing.Size(238, 316);
-            this.ElementsLst.TabIndex = 3;
+            this.ElementsLst.TabIndex = 5;
             this.AdvancedPipelinePluginToolTip.SetToolTip(this.ElementsLst, "List of elements in this custom command");
             this.ElementsLst.SelectedIndexChanged += new System.EventHandler(this.ElementsLst_SelectedIndexChanged);
             // 
@@ -114,7 +148,7 @@
             this.NewElementBtn.Location = new System.Drawing.Point(140, 38);
             this.NewElementBtn.Name = "NewElementBtn";
             this.NewElementBtn.Size = new System.Drawing.Size(23, 23);
-            this.NewElementBtn.TabIndex = 4;
+            this.NewElementBtn.TabIndex = 6;
             this.AdvancedPipelinePluginToolTip.SetToolTip(this.NewElementBtn, "Add a new element to this custom command");
             this.NewElementBtn.UseVisualStyleBackColor = true;
             this.NewElementBtn.Click += new System.EventHandler(this.NewElementBtn_Click);
@@ -136,7 +170,7 @@
             this.DeleteElementBtn.Location = new System.Drawing.Point(169, 38);
             this.DeleteElementBtn.Name = "DeleteElementBtn";
             this.DeleteElementBtn.Size = new System.Drawing.Size(23, 23);
-            this.DeleteElementBtn.TabIndex = 5;
+            this.DeleteElementBtn.TabIndex = 7;
             this.AdvancedPipelinePluginToolTip.SetToolTip(this.DeleteElementBtn, "Remove the selected element from this custom command");
             this.DeleteElementBtn.UseVisualStyleBackColor = true;
             this.DeleteElementBtn.Click += new System.EventHandler(this.DeleteElementBtn_Click);
@@ -149,7 +183,7 @@
             this.MoveElementUpBtn.Location = new System.Drawing.Point(198, 38);
             this.MoveElementUpBtn.Name = "MoveElementUpBtn";
             this.MoveElementUpBtn.Size = new System.Drawing.Size(23, 23);
-            this.MoveElementUpBtn.TabIndex = 6;
+            this.MoveElementUpBtn.TabIndex = 8;
             this.AdvancedPipelinePluginToolTip.SetToolTip(this.MoveElementUpBtn, "Move the selected element up one position");
             this.MoveElementUpBtn.UseVisualStyleBackColor = true;
             this.MoveElementUpBtn.Click += new System.EventHandler(this.MoveElementUpBtn_Click);
@@ -162,7 +196,7 @@
             this.MoveElementDownBtn.Location = new System.Drawing.Point(227, 38);
             this.MoveElementDownBtn.Name = "MoveElementDownBtn";
             this.MoveElementDownBtn.Size = new System.Drawing.Size(23, 23);
-            this.MoveElementDownBtn.TabIndex = 7;
+            this.MoveElementDownBtn.TabIndex = 9;
             this.AdvancedPipelinePluginToolTip.SetToolTip(this.MoveElementDownBtn, "Move the selected element down one position");
             this.MoveElementDownBtn.UseVisualStyleBackColor = true;
             this.MoveElementDownBtn.Click += new System.EventHandler(this.MoveElementDownBtn_Click);
@@ -182,7 +216,7 @@
             this.ElementsLbl.Location = new System.Drawing.Point(12, 48);
             this.ElementsLbl.Name = "ElementsLbl";
             this.ElementsLbl.Size = new System.Drawing.Size(53, 13);
-            this.ElementsLbl.TabIndex = 2;
+            this.ElementsLbl.TabIndex = 4;
             this.ElementsLbl.Text = "&Elements:";
             // 
             // SelectElementLbl
@@ -191,7 +225,7 @@
             this.SelectElementLbl.Location = new System.Drawing.Point(256, 67);
             this.SelectElementLbl.Name = "SelectElementLbl";
             this.SelectElementLbl.Size = new System.Drawing.Size(266, 13);
-            this.SelectElementLbl.TabIndex = 8;
+            this.SelectElementLbl.TabIndex = 10;
             this.SelectElementLbl.Text = "Please select an element in the list to edit its properties.";
             // 
             // NewElementContextMenuStrip
@@ -207,7 +241,7 @@
             this.PreviewCtrl.Name = "PreviewCtrl";
             this.PreviewCtrl.Plugin = null;
             this.PreviewCtrl.Size = new System.Drawing.Size(370, 53);
-            this.PreviewCtrl.TabIndex = 10;
+            this.PreviewCtrl.TabIndex = 12;
             // 
             // UserControlPlacementPanel
             // 
@@ -217,7 +251,7 @@
             this.UserControlPlacementPanel.Location = new System.Drawing.Point(256, 67);
             this.UserControlPlacementPanel.Name = "UserControlPlacementPanel";
             this.UserControlPlacementPanel.Size = new System.Drawing.Size(370, 257);
-            this.UserControlPlacementPanel.TabIndex = 9;
+            this.UserControlPlacementPanel.TabIndex = 11;
             this.UserControlPlacementPanel.Visible = false;
             // 
             // AdvancedPipelinePluginForm
@@ -235,8 +269,11 @@
             this.Controls.Add(this.NewElementBtn);
             this.Controls.Add(this.ElementsLst);
             this.Controls.Add(this.ElementsLbl);
+            this.Controls.Add(this.FolderTxt);
+            this.Controls.Add(this.FolderLbl);
             this.Controls.Add(this.NameTxt);
             this.Controls.Add(this.NameLbl);
+            this.Controls.Add(this.ProfileBtn);
             this.Controls.Add(this.SwitchBtn);
             this.Controls.Add(this.OKBtn);
             this.Controls.Add(this.CancelBtn);
@@ -263,9 +300,12 @@
         private System.Windows.Forms.Button CancelBtn;
         private System.Windows.Forms.Button OKBtn;
         private System.Windows.Forms.Button SwitchBtn;
+        private System.Windows.Forms.Button ProfileBtn;
         private System.Windows.Forms.ToolTip AdvancedPipelinePluginToolTip;
         private System.Windows.Forms.Label NameLbl;
         private System.Windows.Forms.TextBox NameTxt;
+        private System.Windows.Forms.Label FolderLbl;
+        private System.Windows.Forms.TextBox FolderTxt;
         private System.Windows.Forms.Label ElementsLbl;
         private System.Windows.Forms.ListBox ElementsLst;
         private System.Windows.Forms.Button NewElementBtn;
@@ -24,6 +24,7 @@ using System.ComponentModel;
 using System.Diagnostics;
 using System.Drawing;
 using System.Windows.Forms;
+using PathCopyCopy.Settings.Core;
 using PathCopyCopy.Settings.Core.Plugins;
 using PathCopyCopy.Settings.Properties;
 using PathCopyCopy.Settings.UI.UserControls;
@@ -124,10 +125,32 @@ namespace PathCopyCopy.Settings.UI.Forms
             AddNewElementMenuItem(Resources.PipelineElement_ApplyPlugin,
                 Resources.PipelineElement_ApplyPlugin_HelpText,
                 () => new ApplyPluginPipelineElement(new Guid(Resources.LONG_PATH_PLUGIN_ID)));
+            AddNewElementMenuItem(Resources.PipelineElement_Template,
+                Resources.PipelineElement_Template_HelpText,
+                () => new TemplatePipelineElement(TemplatePipelineElement.PATH_PLACEHOLDER + " " +
+                    TemplatePipelineElement.GetPluginPlaceholder(new Guid(Resources.LONG_PATH_PLUGIN_ID))));
             AddNewElementMenuItem("-", null, null);
             AddNewElementMenuItem(Resources.PipelineElement_RemoveExt,
                 Resources.PipelineElement_RemoveExt_HelpText,
                 () => new RemoveExtPipelineElement());
+            AddNewElementMenuItem(Resources.PipelineElement_FinalPath,
+                Resources.PipelineElement_FinalPath_HelpText,
+                () => new FinalPathPipelineElement());
+            AddNewElementMenuItem(Resources.PipelineElement_EnvironmentVariables,
+                Resources.PipelineElement_EnvironmentVariables_HelpText,
+                () => new EnvironmentVariablesPipelineElement());
+            AddNewElementMenuItem(Resources.PipelineElement_ContentHash,
+                Resources.PipelineElement_ContentHash_HelpText,
+                () => new ContentHashPipelineElement());
+            AddNewElementMenuItem(Resources.PipelineElement_Guard,
+                Resources.PipelineElement_Guard_HelpText,
+                () => new GuardPipelineElement());
+            AddNewElementMenuItem(Resources.PipelineElement_NormalizeNFC,
+                Resources.PipelineElement_NormalizeNFC_HelpText,
+                () => new UnicodeNormalizationPipelineElement(NormalizationForm.NFC));
+            AddNewElementMenuItem(Resources.PipelineElement_NormalizeNFD,
+                Resources.PipelineElement_NormalizeNFD_HelpText,
+                () => new UnicodeNormalizationPipelineElement(NormalizationForm.NFD));
             AddNewElementMenuItem(Resources.PipelineElement_Quotes,
                 Resources.PipelineElement_Quotes_HelpText,
                 () => new QuotesPipelineElement());
@@ -157,6 +180,9 @@ namespace PathCopyCopy.Settings.UI.Forms
             AddNewElementMenuItem(Resources.PipelineElement_Regex,
                 Resources.PipelineElement_Regex_HelpText,
                 () => new RegexPipelineElement());
+            AddNewElementMenuItem(Resources.PipelineElement_PrefixMapping,
+                Resources.PipelineElement_PrefixMapping_HelpText,
+                () => new PrefixMappingPipelineElement());
             AddNewElementMenuItem("-", null, null);
             AddNewElementMenuItem(Resources.PipelineElement_PathsSeparator,
                 Resources.PipelineElement_PathsSeparator_HelpText,
@@ -167,6 +193,27 @@ namespace PathCopyCopy.Settings.UI.Forms
             AddNewElementMenuItem(Resources.PipelineElement_ExecutableWithFilelist,
                 Resources.PipelineElement_ExecutableWithFilelist_HelpText,
                 () => new ExecutableWithFilelistPipelineElement());
+            AddNewElementMenuItem(Resources.PipelineElement_BatchExecutable,
+                Resources.PipelineElement_BatchExecutable_HelpText,
+                () => new BatchExecutablePipelineElement());
+            AddNewElementMenuItem(Resources.PipelineElement_RunningInstance,
+                Resources.PipelineElement_RunningInstance_HelpText,
+                () => new RunningInstancePipelineElement());
+            AddNewElementMenuItem(Resources.PipelineElement_OutputFile,
+                Resources.PipelineElement_OutputFile_HelpText,
+                () => new OutputFilePipelineElement());
+            AddNewElementMenuItem(Resources.PipelineElement_CopyMultipleFormats,
+                Resources.PipelineElement_CopyMultipleFormats_HelpText,
+                () => new CopyMultipleFormatsPipelineElement());
+            AddNewElementMenuItem(Resources.PipelineElement_Memoize,
+                Resources.PipelineElement_Memoize_HelpText,
+                () => new MemoizePipelineElement());
+            AddNewElementMenuItem(Resources.PipelineElement_ExportCSV,
+                Resources.PipelineElement_ExportCSV_HelpText,
+                () => new ExportMetadataPipelineElement(ExportFormat.CSV));
+            AddNewElementMenuItem(Resources.PipelineElement_ExportJSON,
+                Resources.PipelineElement_ExportJSON_HelpText,
+                () => new ExportMetadataPipelineElement(ExportFormat.JSON));
 
             if (oldPipeline != null) {
                 // Copy pipeline elements from the pipeline to a list that supports data binding.
@@ -178,11 +225,15 @@ namespace PathCopyCopy.Settings.UI.Forms
 
             // Populate our controls.
             NameTxt.Text = oldPluginInfo?.Description ?? String.Empty;
+            FolderTxt.Text = oldPluginInfo?.Folder ?? String.Empty;
             ElementsLst.DataSource = elements;
 
             // Update initial controls.
             UpdateControls();
 
+            // Profiling is only possible if we can load the DLL in-process.
+            ProfileBtn.Enabled = PCCExecutor.CanEvaluatePipelinesInProcess;
+
             // Immediately update plugin info so that preview box is initially filled.
             UpdatePluginInfo();
         }
@@ -201,6 +252,7 @@ namespace PathCopyCopy.Settings.UI.Forms
             PipelinePluginInfo pluginInfo = new PipelinePluginInfo();
             pluginInfo.Id = pluginId;
             pluginInfo.Description = NameTxt.Text;
+            pluginInfo.Folder = !String.IsNullOrEmpty(FolderTxt.Text) ? FolderTxt.Text : null;
             pluginInfo.EncodedElements = pipeline.Encode();
             pluginInfo.RequiredVersion = pipeline.RequiredVersion;
             pluginInfo.EditMode = PipelinePluginEditMode.Expert;
@@ -439,6 +491,20 @@ namespace PathCopyCopy.Settings.UI.Forms
             UpdatePluginInfo();
         }
 
+        /// <summary>
+        /// Called when the user clicks the button to profile the pipeline.
+        /// We show a form displaying the time spent in each element.
+        /// </summary>
+        /// <param name="sender">Event sender.</param>
+        /// <param name="e">Event arguments.</param>
+        private void ProfileBtn_Click(object sender, EventArgs e)
+        {
+            UpdatePluginInfo();
+            using (PipelineProfileForm profileForm = new PipelineProfileForm()) {
+                profileForm.ShowProfile(this, newPipeline);
+            }
+        }
+
         /// <summary>
         /// Called when the user presses the Help button in the form's caption bar.
         /// We navigate to the wiki to show help in such a case.
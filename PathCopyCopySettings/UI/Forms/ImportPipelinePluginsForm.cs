@@ -82,22 +82,19 @@ namespace PathCopyCopy.Settings.UI.Forms
 
             PipelinePluginsLst.BeginUpdate();
             try {
-                // Populate the list with given plugins.
-                foreach (PipelinePluginInfo pluginInfo in pluginCollection.Plugins) {
-                    PipelinePluginsLst.Items.Add(new PluginToImportDisplayInfo {
-                        PluginInfo = pluginInfo,
-                        Importable = true,
-                    });
-                }
-
-                // Disable any plugin that would overwrite a global one set by the administrator.
-                for (int i = 0; i < PipelinePluginsLst.Items.Count; ++i) {
-                    PluginToImportDisplayInfo newPlugin = (PluginToImportDisplayInfo) PipelinePluginsLst.Items[i];
+                // Populate the list with given plugins, disabling any plugin that would
+                // overwrite a global one set by the administrator. Items are added in one
+                // go since import files can contain hundreds of plugins.
+                PluginToImportDisplayInfo[] items = new PluginToImportDisplayInfo[pluginCollection.Plugins.Count];
+                for (int i = 0; i < items.Length; ++i) {
+                    PipelinePluginInfo pluginInfo = pluginCollection.Plugins[i];
                     ImportedPipelinePluginOverwrites.OverwriteInfo overwriteInfo;
-                    if (pluginOverwrites.OverwriteInfos.TryGetValue(newPlugin.PluginInfo, out overwriteInfo) && overwriteInfo.OldInfo.Global) {
-                        newPlugin.Importable = false;
-                    }
+                    items[i] = new PluginToImportDisplayInfo {
+                        PluginInfo = pluginInfo,
+                        Importable = !(pluginOverwrites.OverwriteInfos.TryGetValue(pluginInfo, out overwriteInfo) && overwriteInfo.OldInfo.Global),
+                    };
                 }
+                PipelinePluginsLst.Items.AddRange(items);
 
                 // Default is to want to select them all importable, compatible plugins.
                 reselecting = true;
@@ -163,7 +160,7 @@ namespace PathCopyCopy.Settings.UI.Forms
             if (listItemRegularBrush != null) {
                 PluginToImportDisplayInfo pluginDisplayInfo = (PluginToImportDisplayInfo) PipelinePluginsLst.Items[e.Index];
                 Brush foreBrush = listItemRegularBrush;
-                if (PipelinePluginsLst.SelectedIndices.Contains(e.Index)) {
+                if ((e.State & DrawItemState.Selected) != 0) {
                     foreBrush = listItemSelectedBrush;
                 } else if (!pluginDisplayInfo.Importable) {
                     foreBrush = listItemDisabledBrush;
@@ -191,11 +188,14 @@ namespace PathCopyCopy.Settings.UI.Forms
                     PipelinePluginsLst.BeginUpdate();
                     try {
                         // Deselect any non-importable plugins and warn about any
-                        // non-compatible plugins.
-                        for (int i = 0; i < PipelinePluginsLst.Items.Count; ++i) {
+                        // non-compatible plugins. Only selected plugins need to be
+                        // checked; copy their indexes since we change the selection.
+                        int[] selectedIndices = new int[PipelinePluginsLst.SelectedIndices.Count];
+                        PipelinePluginsLst.SelectedIndices.CopyTo(selectedIndices, 0);
+                        foreach (int i in selectedIndices) {
                             if (!((PluginToImportDisplayInfo) PipelinePluginsLst.Items[i]).Importable) {
                                 // If this is the first time user does this, warn him/her.
-                                if (!warnedAboutGlobalOverwrites && PipelinePluginsLst.SelectedIndices.Contains(i)) {
+                                if (!warnedAboutGlobalOverwrites) {
                                     MessageBox.Show(this, Resources.ImportPipelinePluginsForm_CantOverwriteGlobalMsg,
                                         Resources.ImportPipelinePluginsForm_MsgTitle, MessageBoxButtons.OK, MessageBoxIcon.Information);
                                     warnedAboutGlobalOverwrites = true;
@@ -204,7 +204,7 @@ namespace PathCopyCopy.Settings.UI.Forms
                             }
                             if (!((PluginToImportDisplayInfo) PipelinePluginsLst.Items[i]).Compatible) {
                                 // If this is the first time user does this, warn him/her.
-                                if (!warnedAboutIncompatiblePlugins && PipelinePluginsLst.SelectedIndices.Contains(i)) {
+                                if (!warnedAboutIncompatiblePlugins) {
                                     MessageBox.Show(this, Resources.ImportPipelinePluginsForm_IncompatiblePluginsMsg,
                                         Resources.ImportPipelinePluginsForm_MsgTitle, MessageBoxButtons.OK, MessageBoxIcon.Information);
                                     warnedAboutIncompatiblePlugins = true;
@@ -84,6 +84,7 @@
             this.ChoosePluginIconOpenDlg = new System.Windows.Forms.OpenFileDialog();
             this.ExportUserSettingsSaveDlg = new System.Windows.Forms.SaveFileDialog();
             this.ExportUserSettingsBtn = new System.Windows.Forms.Button();
+            this.SlowOperationsBtn = new System.Windows.Forms.Button();
             this.MainToolTip = new System.Windows.Forms.ToolTip(this.components);
             this.PreviewCtrl = new PathCopyCopy.Settings.UI.UserControls.PluginPreviewUserControl();
             this.MainTabCtrl.SuspendLayout();
@@ -103,7 +104,7 @@
             this.ApplyBtn.Location = new System.Drawing.Point(410, 563);
             this.ApplyBtn.Name = "ApplyBtn";
             this.ApplyBtn.Size = new System.Drawing.Size(75, 23);
-            this.ApplyBtn.TabIndex = 4;
+            this.ApplyBtn.TabIndex = 5;
             this.ApplyBtn.Text = "&Apply";
             this.MainToolTip.SetToolTip(this.ApplyBtn, "Save changes made to the settings so far, leaving the window open");
             this.ApplyBtn.UseVisualStyleBackColor = true;
@@ -115,7 +116,7 @@
             this.OKBtn.Location = new System.Drawing.Point(248, 563);
             this.OKBtn.Name = "OKBtn";
             this.OKBtn.Size = new System.Drawing.Size(75, 23);
-            this.OKBtn.TabIndex = 2;
+            this.OKBtn.TabIndex = 3;
             this.OKBtn.Text = "OK";
             this.MainToolTip.SetToolTip(this.OKBtn, "Save changes to settings and close the window");
             this.OKBtn.UseVisualStyleBackColor = true;
@@ -128,7 +129,7 @@
             this.CancelBtn.Location = new System.Drawing.Point(329, 563);
             this.CancelBtn.Name = "CancelBtn";
             this.CancelBtn.Size = new System.Drawing.Size(75, 23);
-            this.CancelBtn.TabIndex = 3;
+            this.CancelBtn.TabIndex = 4;
             this.CancelBtn.Text = "&Cancel";
             this.MainToolTip.SetToolTip(this.CancelBtn, "Cancel all changes made so far and close the window");
             this.CancelBtn.UseVisualStyleBackColor = true;
@@ -789,6 +790,18 @@
             this.ExportUserSettingsBtn.UseVisualStyleBackColor = true;
             this.ExportUserSettingsBtn.Click += new System.EventHandler(this.ExportUserSettingsBtn_Click);
             // 
+            // SlowOperationsBtn
+            // 
+            this.SlowOperationsBtn.Anchor = ((System.Windows.Forms.AnchorStyles)((System.Windows.Forms.AnchorStyles.Bottom | System.Windows.Forms.AnchorStyles.Left)));
+            this.SlowOperationsBtn.Location = new System.Drawing.Point(125, 563);
+            this.SlowOperationsBtn.Name = "SlowOperationsBtn";
+            this.SlowOperationsBtn.Size = new System.Drawing.Size(107, 23);
+            this.SlowOperationsBtn.TabIndex = 2;
+            this.SlowOperationsBtn.Text = "Slow &Operations...";
+            this.MainToolTip.SetToolTip(this.SlowOperationsBtn, "Display the slow operations recorded by the contextual menu");
+            this.SlowOperationsBtn.UseVisualStyleBackColor = true;
+            this.SlowOperationsBtn.Click += new System.EventHandler(this.SlowOperationsBtn_Click);
+            // 
             // PreviewCtrl
             // 
             this.PreviewCtrl.Anchor = ((System.Windows.Forms.AnchorStyles)(((System.Windows.Forms.AnchorStyles.Bottom | System.Windows.Forms.AnchorStyles.Left) 
@@ -806,6 +819,7 @@
             this.AutoScaleMode = System.Windows.Forms.AutoScaleMode.Font;
             this.CancelButton = this.CancelBtn;
             this.ClientSize = new System.Drawing.Size(497, 598);
+            this.Controls.Add(this.SlowOperationsBtn);
             this.Controls.Add(this.ExportUserSettingsBtn);
             this.Controls.Add(this.MainTabCtrl);
             this.Controls.Add(this.CancelBtn);
@@ -875,6 +889,7 @@
         private System.Windows.Forms.CheckBox EncodeURICharsChk;
         private System.Windows.Forms.SaveFileDialog ExportUserSettingsSaveDlg;
         private System.Windows.Forms.Button ExportUserSettingsBtn;
+        private System.Windows.Forms.Button SlowOperationsBtn;
         private System.Windows.Forms.ToolTip MainToolTip;
         private System.Windows.Forms.Label PluginsExplanationLbl2;
         private System.Windows.Forms.DataGridView PluginsDataGrid;
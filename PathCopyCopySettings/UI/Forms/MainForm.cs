@@ -27,6 +27,7 @@ using System.Drawing;
 using System.IO;
 using System.Reflection;
 using System.Windows.Forms;
+using System.Xml;
 using PathCopyCopy.Settings.Core;
 using PathCopyCopy.Settings.Core.Plugins;
 using PathCopyCopy.Settings.Properties;
@@ -339,6 +340,10 @@ namespace PathCopyCopy.Settings.UI.Forms
             Debug.Assert(settings != null);
             Debug.Assert(pluginDisplayInfos != null);
 
+            // Compare against the current registry values, in case they were changed elsewhere
+            // since we loaded them; only values that differ are written.
+            settings.Reload();
+
             // Build list of plugin IDs to save in config for main menu.
             // This is easy: we jolt down the plugins marked as display
             // in main menu without worrying about separators.
@@ -694,6 +699,18 @@ namespace PathCopyCopy.Settings.UI.Forms
                 }
             }
         }
+
+        /// <summary>
+        /// Called when user presses the button to display slow operations.
+        /// </summary>
+        /// <param name="sender">Event sender.</param>
+        /// <param name="e">Event arguments.</param>
+        private void SlowOperationsBtn_Click(object sender, EventArgs e)
+        {
+            using (SlowOperationsForm form = new SlowOperationsForm()) {
+                form.ShowDialog(this);
+            }
+        }
         
         /// <summary>
         /// Called when the user checks or unchecks a checkbox in the Options tab.
@@ -878,6 +895,20 @@ namespace PathCopyCopy.Settings.UI.Forms
                     row.Cells[InSubmenuCol.Index] = new DataGridViewTextBoxCell();
                     row.ReadOnly = true;
                 }
+
+                // Show statistics recorded by the shell extension, if any, as the plugin cell's tooltip.
+                if (!(rowPlugin is SeparatorPlugin)) {
+                    PluginStatistics statistics = PluginStatistics.Load(rowPlugin.Id);
+                    if (statistics != null) {
+                        row.Cells[PluginCol.Index].ToolTipText = String.Format(
+                            Resources.MainForm_PluginsDataGrid_StatisticsToolTipText,
+                            statistics.Enabled.Count, statistics.Enabled.P50.TotalMilliseconds,
+                            statistics.Enabled.P99.TotalMilliseconds, statistics.Enabled.Failures,
+                            statistics.GetPath.Count, statistics.GetPath.P50.TotalMilliseconds,
+                            statistics.GetPath.P99.TotalMilliseconds, statistics.GetPath.Failures,
+                            statistics.PathCacheHits, statistics.PathCacheMisses);
+                    }
+                }
             }
         }
 
@@ -1214,15 +1245,28 @@ namespace PathCopyCopy.Settings.UI.Forms
         {
             // Ask user to select a file.
             if (ImportPipelinePluginsOpenDlg.ShowDialog(this) == DialogResult.OK) {
-                // Open the file for reading and deserialize a collection of pipeline plugins.
-                PipelinePluginCollection collection = null;
+                // Index existing pipeline plugins so that we can locate plugin overwrites
+                // while reading the file.
+                Dictionary<Guid, int> existingIndexes = new Dictionary<Guid, int>();
+                for (int i = 0; i < pluginDisplayInfos.Count; ++i) {
+                    PipelinePluginInfo existingInfo = (pluginDisplayInfos[i].Plugin as PipelinePlugin)?.Info;
+                    if (existingInfo != null) {
+                        existingIndexes[existingInfo.Id] = i;
+                    }
+                }
+
+                // Open the file for reading and stream the pipeline plugins it contains.
+                // Import files can contain hundreds of plugins, so they are processed
+                // in a single pass as they are read.
+                PipelinePluginCollection collection = new PipelinePluginCollection();
+                ImportedPipelinePluginOverwrites pluginOverwrites = new ImportedPipelinePluginOverwrites();
+                bool legacyFile = PIPELINE_PLUGINS_EXT_TO_SERIALIZER_VERSION[Path.GetExtension(
+                    ImportPipelinePluginsOpenDlg.FileName).ToLower()] == PipelinePluginXmlSerializerVersion.V1;
                 using (FileStream fstream = new FileStream(ImportPipelinePluginsOpenDlg.FileName, FileMode.Open)) {
                     try {
-                        collection = PipelinePluginCollection.FromXML(fstream);
-
-                        // If this is a legacy file without required versions, compute them now.
-                        if (PIPELINE_PLUGINS_EXT_TO_SERIALIZER_VERSION[Path.GetExtension(ImportPipelinePluginsOpenDlg.FileName).ToLower()] == PipelinePluginXmlSerializerVersion.V1) {
-                            foreach (PipelinePluginInfo info in collection.Plugins) {
+                        foreach (PipelinePluginInfo info in PipelinePluginCollection.ReadPluginsFromXML(fstream)) {
+                            // If this is a legacy file without required versions, compute them now.
+                            if (legacyFile) {
                                 try {
                                     Pipeline pipeline = PipelineDecoder.DecodePipeline(info.EncodedElements);
                                     info.RequiredVersion = pipeline.RequiredVersion;
@@ -1231,26 +1275,24 @@ namespace PathCopyCopy.Settings.UI.Forms
                                     // of something legacy? Regardless, there's not much we can do.
                                 }
                             }
+
+                            // Check if this plugin will overwrite an existing one.
+                            if (existingIndexes.TryGetValue(info.Id, out int existingIndex)) {
+                                pluginOverwrites.OverwriteInfos[info] = new ImportedPipelinePluginOverwrites.OverwriteInfo(
+                                    ((PipelinePlugin) pluginDisplayInfos[existingIndex].Plugin).Info, existingIndex);
+                            }
+
+                            collection.Plugins.Add(info);
                         }
                     } catch (InvalidOperationException) {
-                        Debug.Assert(collection == null);
+                        collection = null;
+                    } catch (XmlException) {
+                        collection = null;
                     }
                 }
 
                 // Make sure it worked.
                 if (collection != null && collection.Plugins.Count > 0) {
-                    // Go through list of plugins and locate any plugin overwrites.
-                    ImportedPipelinePluginOverwrites pluginOverwrites = new ImportedPipelinePluginOverwrites();
-                    for (int i = 0; i < pluginDisplayInfos.Count; ++i) {
-                        PipelinePluginInfo existingInfo = (pluginDisplayInfos[i].Plugin as PipelinePlugin)?.Info;
-                        if (existingInfo != null) {
-                            PipelinePluginInfo newInfo = collection.Plugins.Find(pl => pl.Equals(existingInfo));
-                            if (newInfo != null) {
-                                pluginOverwrites.OverwriteInfos[newInfo] =
-                                    new ImportedPipelinePluginOverwrites.OverwriteInfo(existingInfo, i);
-                            }
-                        }
-                    }
 
                     // Popup a form asking the user which plugins to import.
                     bool shouldContinue;
@@ -1270,8 +1312,10 @@ namespace PathCopyCopy.Settings.UI.Forms
                             collection.Plugins.ForEach(pl => pl.Global = false);
 
                             // Scan plugins to import. If the plugin already exists, overwrite the existing
-                            // one, otherwise add it at the end.
+                            // one, otherwise add it at the end. Notifications are suspended while we do
+                            // this so that the grid is refreshed only once, even for large imports.
                             bool addedNewPlugins = false;
+                            pluginDisplayInfos.RaiseListChangedEvents = false;
                             foreach (var newPluginInfo in collection.Plugins) {
                                 Plugin newPlugin = newPluginInfo.ToPlugin();
                                 ImportedPipelinePluginOverwrites.OverwriteInfo overwriteInfo;
@@ -1285,6 +1329,8 @@ namespace PathCopyCopy.Settings.UI.Forms
                                     addedNewPlugins = true;
                                 }
                             }
+                            pluginDisplayInfos.RaiseListChangedEvents = true;
+                            pluginDisplayInfos.ResetBindings();
 
                             // If we added new plugins, select the last one.
                             if (addedNewPlugins) {
@@ -30,6 +30,8 @@
             this.components = new System.ComponentModel.Container();
             this.NameLbl = new System.Windows.Forms.Label();
             this.NameTxt = new System.Windows.Forms.TextBox();
+            this.FolderLbl = new System.Windows.Forms.Label();
+            this.FolderTxt = new System.Windows.Forms.TextBox();
             this.MainTabControl = new System.Windows.Forms.TabControl();
             this.BasePluginPage = new System.Windows.Forms.TabPage();
             this.BasePluginLst = new System.Windows.Forms.ListBox();
@@ -92,10 +94,29 @@
             | System.Windows.Forms.AnchorStyles.Right)));
             this.NameTxt.Location = new System.Drawing.Point(56, 12);
             this.NameTxt.Name = "NameTxt";
-            this.NameTxt.Size = new System.Drawing.Size(338, 20);
+            this.NameTxt.Size = new System.Drawing.Size(188, 20);
             this.NameTxt.TabIndex = 1;
             this.PipelinePluginToolTip.SetToolTip(this.NameTxt, "Name of this custom command");
             // 
+            // FolderLbl
+            // 
+            this.FolderLbl.Anchor = ((System.Windows.Forms.AnchorStyles)((System.Windows.Forms.AnchorStyles.Top | System.Windows.Forms.AnchorStyles.Right)));
+            this.FolderLbl.AutoSize = true;
+            this.FolderLbl.Location = new System.Drawing.Point(250, 15);
+            this.FolderLbl.Name = "FolderLbl";
+            this.FolderLbl.Size = new System.Drawing.Size(39, 13);
+            this.FolderLbl.TabIndex = 2;
+            this.FolderLbl.Text = "Fol&der:";
+            // 
+            // FolderTxt
+            // 
+            this.FolderTxt.Anchor = ((System.Windows.Forms.AnchorStyles)((System.Windows.Forms.AnchorStyles.Top | System.Windows.Forms.AnchorStyles.Right)));
+            this.FolderTxt.Location = new System.Drawing.Point(295, 12);
+            this.FolderTxt.Name = "FolderTxt";
+            this.FolderTxt.Size = new System.Drawing.Size(99, 20);
+            this.FolderTxt.TabIndex = 3;
+            this.PipelinePluginToolTip.SetToolTip(this.FolderTxt, "Name of the nested submenu in which to display this custom command. Leave empty to display it directly in the submenu.");
+            // 
             // MainTabControl
             // 
             this.MainTabControl.Anchor = ((System.Windows.Forms.AnchorStyles)((((System.Windows.Forms.AnchorStyles.Top | System.Windows.Forms.AnchorStyles.Bottom) 
@@ -107,7 +128,7 @@
             this.MainTabControl.Name = "MainTabControl";
             this.MainTabControl.SelectedIndex = 0;
             this.MainTabControl.Size = new System.Drawing.Size(382, 534);
-            this.MainTabControl.TabIndex = 2;
+            this.MainTabControl.TabIndex = 4;
             // 
             // BasePluginPage
             // 
@@ -292,14 +313,12 @@
             // IgnoreCaseChk
             // 
             this.IgnoreCaseChk.AutoSize = true;
-            this.IgnoreCaseChk.Enabled = false;
             this.IgnoreCaseChk.Location = new System.Drawing.Point(153, 75);
             this.IgnoreCaseChk.Name = "IgnoreCaseChk";
             this.IgnoreCaseChk.Size = new System.Drawing.Size(82, 17);
             this.IgnoreCaseChk.TabIndex = 5;
             this.IgnoreCaseChk.Text = "&Ignore case";
-            this.PipelinePluginToolTip.SetToolTip(this.IgnoreCaseChk, "Whether to ignore case when performing regular expression-based find/replace oper" +
-        "ations");
+            this.PipelinePluginToolTip.SetToolTip(this.IgnoreCaseChk, "Whether to ignore case when performing find/replace operations");
             this.IgnoreCaseChk.UseVisualStyleBackColor = true;
             this.IgnoreCaseChk.CheckedChanged += new System.EventHandler(this.PipelinePluginForm_UpdatePreview);
             // 
@@ -510,7 +529,7 @@
             this.OKBtn.Location = new System.Drawing.Point(238, 637);
             this.OKBtn.Name = "OKBtn";
             this.OKBtn.Size = new System.Drawing.Size(75, 23);
-            this.OKBtn.TabIndex = 5;
+            this.OKBtn.TabIndex = 7;
             this.OKBtn.Text = "OK";
             this.PipelinePluginToolTip.SetToolTip(this.OKBtn, "Save this custom command and close the window");
             this.OKBtn.UseVisualStyleBackColor = true;
@@ -522,7 +541,7 @@
             this.CancelBtn.Location = new System.Drawing.Point(319, 637);
             this.CancelBtn.Name = "CancelBtn";
             this.CancelBtn.Size = new System.Drawing.Size(75, 23);
-            this.CancelBtn.TabIndex = 6;
+            this.CancelBtn.TabIndex = 8;
             this.CancelBtn.Text = "Cancel";
             this.PipelinePluginToolTip.SetToolTip(this.CancelBtn, "Do not save this custom command and close the window");
             this.CancelBtn.UseVisualStyleBackColor = true;
@@ -539,7 +558,7 @@
             this.SwitchBtn.Location = new System.Drawing.Point(12, 637);
             this.SwitchBtn.Name = "SwitchBtn";
             this.SwitchBtn.Size = new System.Drawing.Size(94, 23);
-            this.SwitchBtn.TabIndex = 4;
+            this.SwitchBtn.TabIndex = 6;
             this.SwitchBtn.Text = "Expert Mode";
             this.PipelinePluginToolTip.SetToolTip(this.SwitchBtn, "Switch to Expert Mode, which allows more customization options but is more comple" +
         "x to use");
@@ -553,7 +572,7 @@
             this.PreviewCtrl.Name = "PreviewCtrl";
             this.PreviewCtrl.Plugin = null;
             this.PreviewCtrl.Size = new System.Drawing.Size(380, 53);
-            this.PreviewCtrl.TabIndex = 3;
+            this.PreviewCtrl.TabIndex = 5;
             // 
             // PipelinePluginForm
             // 
@@ -567,6 +586,8 @@
             this.Controls.Add(this.CancelBtn);
             this.Controls.Add(this.OKBtn);
             this.Controls.Add(this.MainTabControl);
+            this.Controls.Add(this.FolderTxt);
+            this.Controls.Add(this.FolderLbl);
             this.Controls.Add(this.NameTxt);
             this.Controls.Add(this.NameLbl);
             this.HelpButton = true;
@@ -602,6 +623,8 @@
 
         private System.Windows.Forms.Label NameLbl;
         private System.Windows.Forms.TextBox NameTxt;
+        private System.Windows.Forms.Label FolderLbl;
+        private System.Windows.Forms.TextBox FolderTxt;
         private System.Windows.Forms.TabControl MainTabControl;
         private System.Windows.Forms.TabPage BasePluginPage;
         private System.Windows.Forms.TabPage OptionsPage;
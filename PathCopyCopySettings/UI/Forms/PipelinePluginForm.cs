@@ -47,6 +47,18 @@ namespace PathCopyCopy.Settings.UI.Forms
         /// Separator to use between multiple paths. Used to remember non-standard values (see Load).
         private string oldPathsSeparator;
 
+        /// Regex engine of the initial plugin's regex element. Not editable in this
+        /// form, so we remember it to preserve it (see Load).
+        private RegexEngine oldRegexEngine = RegexEngine.Standard;
+
+        /// Filelist encoding of the initial plugin's executable element. Not editable
+        /// in this form, so we remember it to preserve it (see Load).
+        private FilelistEncoding oldFilelistEncoding = FilelistEncoding.Ansi;
+
+        /// Filelist delivery of the initial plugin's executable element. Not editable
+        /// in this form, so we remember it to preserve it (see Load).
+        private FilelistDelivery oldFilelistDelivery = FilelistDelivery.TempFile;
+
         /// ID of the plugin we're editing. Will be generated
         /// if we're creating a new pipeline plugin.
         private Guid pluginId;
@@ -128,6 +140,7 @@ namespace PathCopyCopy.Settings.UI.Forms
 
                 // Populate our controls.
                 NameTxt.Text = oldPluginInfo.Description;
+                FolderTxt.Text = oldPluginInfo.Folder ?? String.Empty;
                 PipelineElement element = oldPipeline.Elements.Find(el => el is ApplyPluginPipelineElement);
                 if (element != null) {
                     basePluginId = ((ApplyPluginPipelineElement) element).PluginID;
@@ -156,19 +169,20 @@ namespace PathCopyCopy.Settings.UI.Forms
                 element = oldPipeline.Elements.Find(el => el is RegexPipelineElement);
                 if (element != null) {
                     UseRegexChk.Checked = true;
-                    IgnoreCaseChk.Enabled = true;
                     TestRegexBtn.Enabled = true;
                     RegexPipelineElement regexElement = (RegexPipelineElement) element;
                     FindTxt.Text = regexElement.Regex;
                     ReplaceTxt.Text = regexElement.Format;
                     IgnoreCaseChk.Checked = regexElement.IgnoreCase;
+                    oldRegexEngine = regexElement.Engine;
                 } else {
-                    Debug.Assert(!IgnoreCaseChk.Enabled);
                     Debug.Assert(!TestRegexBtn.Enabled);
                     element = oldPipeline.Elements.Find(el => el is FindReplacePipelineElement);
                     if (element != null) {
-                        FindTxt.Text = ((FindReplacePipelineElement) element).OldValue;
-                        ReplaceTxt.Text = ((FindReplacePipelineElement) element).NewValue;
+                        FindReplacePipelineElement findReplaceElement = (FindReplacePipelineElement) element;
+                        FindTxt.Text = findReplaceElement.OldValue;
+                        ReplaceTxt.Text = findReplaceElement.NewValue;
+                        IgnoreCaseChk.Checked = findReplaceElement.IgnoreCase;
                     }
                 }
 
@@ -191,6 +205,8 @@ namespace PathCopyCopy.Settings.UI.Forms
                         LaunchExecutableChk.Checked = true;
                         WithFilelistChk.Checked = true;
                         ExecutableTxt.Text = ((ExecutableWithFilelistPipelineElement) element).Executable;
+                        oldFilelistEncoding = ((ExecutableWithFilelistPipelineElement) element).Encoding;
+                        oldFilelistDelivery = ((ExecutableWithFilelistPipelineElement) element).Delivery;
                     } else {
                         Debug.Assert(!ExecutableLbl.Enabled);
                         Debug.Assert(!ExecutableTxt.Enabled);
@@ -239,7 +255,8 @@ namespace PathCopyCopy.Settings.UI.Forms
             Pipeline pipeline = new Pipeline();
             if (LaunchExecutableChk.Checked) {
                 if (WithFilelistChk.Checked) {
-                    pipeline.Elements.Add(new ExecutableWithFilelistPipelineElement(ExecutableTxt.Text));
+                    pipeline.Elements.Add(new ExecutableWithFilelistPipelineElement(ExecutableTxt.Text,
+                        oldFilelistEncoding, oldFilelistDelivery));
                 } else {
                     pipeline.Elements.Add(new ExecutablePipelineElement(ExecutableTxt.Text));
                 }
@@ -259,9 +276,10 @@ namespace PathCopyCopy.Settings.UI.Forms
             }
             if (FindTxt.Text.Length > 0) {
                 if (UseRegexChk.Checked) {
-                    pipeline.Elements.Add(new RegexPipelineElement(FindTxt.Text, ReplaceTxt.Text, IgnoreCaseChk.Checked));
+                    pipeline.Elements.Add(new RegexPipelineElement(FindTxt.Text, ReplaceTxt.Text,
+                        IgnoreCaseChk.Checked, oldRegexEngine));
                 } else {
-                    pipeline.Elements.Add(new FindReplacePipelineElement(FindTxt.Text, ReplaceTxt.Text));
+                    pipeline.Elements.Add(new FindReplacePipelineElement(FindTxt.Text, ReplaceTxt.Text, IgnoreCaseChk.Checked));
                 }
             }
             if (BackToForwardSlashesRadio.Checked) {
@@ -292,6 +310,7 @@ namespace PathCopyCopy.Settings.UI.Forms
             PipelinePluginInfo pluginInfo = new PipelinePluginInfo();
             pluginInfo.Id = pluginId;
             pluginInfo.Description = NameTxt.Text;
+            pluginInfo.Folder = !String.IsNullOrEmpty(FolderTxt.Text) ? FolderTxt.Text : null;
             pluginInfo.EncodedElements = pipeline.Encode();
             pluginInfo.RequiredVersion = pipeline.RequiredVersion;
             pluginInfo.EditMode = PipelinePluginEditMode.Simple;
@@ -366,14 +385,13 @@ namespace PathCopyCopy.Settings.UI.Forms
         
         /// <summary>
         /// Called when the user checks or unchecks the "Use regular expressions"
-        /// checkbox. We need to enable or disable the "ignore case" checkbox
-        /// when this occurs, as this flag is only used with regular expressions.
+        /// checkbox. We need to enable or disable the "test regex" button
+        /// when this occurs, as it is only used with regular expressions.
         /// </summary>
         /// <param name="sender">Event sender.</param>
         /// <param name="e">Event arguments.</param>
         private void UseRegexChk_CheckedChanged(object sender, EventArgs e)
         {
-            IgnoreCaseChk.Enabled = UseRegexChk.Checked;
             TestRegexBtn.Enabled = UseRegexChk.Checked;
             UpdatePluginInfo();
         }
@@ -0,0 +1,162 @@
+﻿namespace PathCopyCopy.Settings.UI.Forms
+{
+    partial class PipelineProfileForm
+    {
+        /// <summary>
+        /// Required designer variable.
+        /// </summary>
+        private System.ComponentModel.IContainer components = null;
+
+        /// <summary>
+        /// Clean up any resources being used.
+        /// </summary>
+        /// <param name="disposing">true if managed resources should be disposed; otherwise, false.</param>
+        protected override void Dispose(bool disposing)
+        {
+            if (disposing && (components != null)) {
+                components.Dispose();
+            }
+            base.Dispose(disposing);
+        }
+
+        #region Windows Form Designer generated code
+
+        /// <summary>
+        /// Required method for Designer support - do not modify
+        /// the contents of this method with the code editor.
+        /// </summary>
+        private void InitializeComponent()
+        {
+            this.ElementsLbl = new System.Windows.Forms.Label();
+            this.ElementsLstView = new System.Windows.Forms.ListView();
+            this.ElementCol = ((System.Windows.Forms.ColumnHeader)(new System.Windows.Forms.ColumnHeader()));
+            this.TimeCol = ((System.Windows.Forms.ColumnHeader)(new System.Windows.Forms.ColumnHeader()));
+            this.ShareCol = ((System.Windows.Forms.ColumnHeader)(new System.Windows.Forms.ColumnHeader()));
+            this.AllocationsCol = ((System.Windows.Forms.ColumnHeader)(new System.Windows.Forms.ColumnHeader()));
+            this.TotalLbl = new System.Windows.Forms.Label();
+            this.ProfileAgainBtn = new System.Windows.Forms.Button();
+            this.CloseBtn = new System.Windows.Forms.Button();
+            this.SuspendLayout();
+            // 
+            // ElementsLbl
+            // 
+            this.ElementsLbl.AutoSize = true;
+            this.ElementsLbl.Location = new System.Drawing.Point(12, 9);
+            this.ElementsLbl.Name = "ElementsLbl";
+            this.ElementsLbl.Size = new System.Drawing.Size(257, 13);
+            this.ElementsLbl.TabIndex = 0;
+            this.ElementsLbl.Text = "Time spent in each element when converting paths:";
+            // 
+            // ElementsLstView
+            // 
+            this.ElementsLstView.Anchor = ((System.Windows.Forms.AnchorStyles)((((System.Windows.Forms.AnchorStyles.Top | System.Windows.Forms.AnchorStyles.Bottom) 
+            | System.Windows.Forms.AnchorStyles.Left) 
+            | System.Windows.Forms.AnchorStyles.Right)));
+            this.ElementsLstView.Columns.AddRange(new System.Windows.Forms.ColumnHeader[] {
+            this.ElementCol,
+            this.TimeCol,
+            this.ShareCol,
+            this.AllocationsCol});
+            this.ElementsLstView.FullRowSelect = true;
+            this.ElementsLstView.HideSelection = false;
+            this.ElementsLstView.Location = new System.Drawing.Point(12, 25);
+            this.ElementsLstView.MultiSelect = false;
+            this.ElementsLstView.Name = "ElementsLstView";
+            this.ElementsLstView.Size = new System.Drawing.Size(558, 295);
+            this.ElementsLstView.TabIndex = 1;
+            this.ElementsLstView.UseCompatibleStateImageBehavior = false;
+            this.ElementsLstView.View = System.Windows.Forms.View.Details;
+            // 
+            // ElementCol
+            // 
+            this.ElementCol.Text = "Element";
+            this.ElementCol.Width = 260;
+            // 
+            // TimeCol
+            // 
+            this.TimeCol.Text = "Time per path (µs)";
+            this.TimeCol.TextAlign = System.Windows.Forms.HorizontalAlignment.Right;
+            this.TimeCol.Width = 110;
+            // 
+            // ShareCol
+            // 
+            this.ShareCol.Text = "Share (%)";
+            this.ShareCol.TextAlign = System.Windows.Forms.HorizontalAlignment.Right;
+            this.ShareCol.Width = 70;
+            // 
+            // AllocationsCol
+            // 
+            this.AllocationsCol.Text = "Allocations per path";
+            this.AllocationsCol.TextAlign = System.Windows.Forms.HorizontalAlignment.Right;
+            this.AllocationsCol.Width = 110;
+            // 
+            // TotalLbl
+            // 
+            this.TotalLbl.Anchor = ((System.Windows.Forms.AnchorStyles)(((System.Windows.Forms.AnchorStyles.Bottom | System.Windows.Forms.AnchorStyles.Left) 
+            | System.Windows.Forms.AnchorStyles.Right)));
+            this.TotalLbl.AutoEllipsis = true;
+            this.TotalLbl.Location = new System.Drawing.Point(12, 327);
+            this.TotalLbl.Name = "TotalLbl";
+            this.TotalLbl.Size = new System.Drawing.Size(558, 13);
+            this.TotalLbl.TabIndex = 2;
+            // 
+            // ProfileAgainBtn
+            // 
+            this.ProfileAgainBtn.Anchor = ((System.Windows.Forms.AnchorStyles)((System.Windows.Forms.AnchorStyles.Bottom | System.Windows.Forms.AnchorStyles.Left)));
+            this.ProfileAgainBtn.Location = new System.Drawing.Point(12, 345);
+            this.ProfileAgainBtn.Name = "ProfileAgainBtn";
+            this.ProfileAgainBtn.Size = new System.Drawing.Size(94, 23);
+            this.ProfileAgainBtn.TabIndex = 3;
+            this.ProfileAgainBtn.Text = "&Profile Again";
+            this.ProfileAgainBtn.UseVisualStyleBackColor = true;
+            this.ProfileAgainBtn.Click += new System.EventHandler(this.ProfileAgainBtn_Click);
+            // 
+            // CloseBtn
+            // 
+            this.CloseBtn.Anchor = ((System.Windows.Forms.AnchorStyles)((System.Windows.Forms.AnchorStyles.Bottom | System.Windows.Forms.AnchorStyles.Right)));
+            this.CloseBtn.DialogResult = System.Windows.Forms.DialogResult.Cancel;
+            this.CloseBtn.Location = new System.Drawing.Point(495, 345);
+            this.CloseBtn.Name = "CloseBtn";
+            this.CloseBtn.Size = new System.Drawing.Size(75, 23);
+            this.CloseBtn.TabIndex = 4;
+            this.CloseBtn.Text = "&Close";
+            this.CloseBtn.UseVisualStyleBackColor = true;
+            // 
+            // PipelineProfileForm
+            // 
+            this.AutoScaleDimensions = new System.Drawing.SizeF(6F, 13F);
+            this.AutoScaleMode = System.Windows.Forms.AutoScaleMode.Font;
+            this.CancelButton = this.CloseBtn;
+            this.ClientSize = new System.Drawing.Size(582, 380);
+            this.Controls.Add(this.CloseBtn);
+            this.Controls.Add(this.ProfileAgainBtn);
+            this.Controls.Add(this.TotalLbl);
+            this.Controls.Add(this.ElementsLstView);
+            this.Controls.Add(this.ElementsLbl);
+            this.MaximizeBox = false;
+            this.MinimizeBox = false;
+            this.MinimumSize = new System.Drawing.Size(598, 419);
+            this.Name = "PipelineProfileForm";
+            this.ShowIcon = false;
+            this.ShowInTaskbar = false;
+            this.StartPosition = System.Windows.Forms.FormStartPosition.CenterParent;
+            this.Text = "Custom command profile";
+            this.Shown += new System.EventHandler(this.PipelineProfileForm_Shown);
+            this.ResumeLayout(false);
+            this.PerformLayout();
+
+        }
+
+        #endregion
+
+        private System.Windows.Forms.Label ElementsLbl;
+        private System.Windows.Forms.ListView ElementsLstView;
+        private System.Windows.Forms.ColumnHeader ElementCol;
+        private System.Windows.Forms.ColumnHeader TimeCol;
+        private System.Windows.Forms.ColumnHeader ShareCol;
+        private System.Windows.Forms.ColumnHeader AllocationsCol;
+        private System.Windows.Forms.Label TotalLbl;
+        private System.Windows.Forms.Button ProfileAgainBtn;
+        private System.Windows.Forms.Button CloseBtn;
+    }
+}
\ No newline at end of file
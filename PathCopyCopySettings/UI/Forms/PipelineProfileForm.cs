@@ -0,0 +1,156 @@
+﻿// PipelineProfileForm.cs
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+using System;
+using System.Diagnostics;
+using System.Globalization;
+using System.IO;
+using System.Windows.Forms;
+using PathCopyCopy.Settings.Core;
+using PathCopyCopy.Settings.Core.Plugins;
+using PathCopyCopy.Settings.Properties;
+using PathCopyCopy.Settings.UI.Utils;
+
+namespace PathCopyCopy.Settings.UI.Forms
+{
+    /// <summary>
+    /// Form displaying the time spent in each element of a pipeline when
+    /// converting sample paths. To use, create the form and call the
+    /// <see cref="ShowProfile"/> method.
+    /// </summary>
+    public partial class PipelineProfileForm : Form
+    {
+        /// Number of times each sample path is converted.
+        private const int ITERATIONS = 200;
+
+        /// Pipeline to profile.
+        private Pipeline pipeline;
+
+        /// <summary>
+        /// Constructor.
+        /// </summary>
+        public PipelineProfileForm()
+        {
+            InitializeComponent();
+        }
+
+        /// <summary>
+        /// Shows the form as a modal dialog and displays the profile of
+        /// the given pipeline.
+        /// </summary>
+        /// <param name="owner">Window owner. Can be <c>null</c>.</param>
+        /// <param name="pipelineToProfile">Pipeline to profile.</param>
+        public void ShowProfile(IWin32Window owner, Pipeline pipelineToProfile)
+        {
+            Debug.Assert(pipelineToProfile != null);
+
+            pipeline = pipelineToProfile;
+            ShowDialog(owner);
+        }
+
+        /// <summary>
+        /// Returns the sample paths converted by the pipeline.
+        /// </summary>
+        /// <returns>Sample paths.</returns>
+        private static string[] GetSamplePaths()
+        {
+            return new string[] {
+                Plugin.PREVIEW_PATH,
+                Path.GetDirectoryName(Plugin.PREVIEW_PATH),
+                Environment.SystemDirectory,
+            };
+        }
+
+        /// <summary>
+        /// Called when the form is first shown. We profile the pipeline here
+        /// so that the user sees the form while waiting.
+        /// </summary>
+        /// <param name="sender">Event sender.</param>
+        /// <param name="e">Event arguments.</param>
+        private void PipelineProfileForm_Shown(object sender, EventArgs e)
+        {
+            Profile();
+        }
+
+        /// <summary>
+        /// Called when the user presses the button to profile the pipeline again.
+        /// </summary>
+        /// <param name="sender">Event sender.</param>
+        /// <param name="e">Event arguments.</param>
+        private void ProfileAgainBtn_Click(object sender, EventArgs e)
+        {
+            Profile();
+        }
+
+        /// <summary>
+        /// Profiles the pipeline and displays the results.
+        /// </summary>
+        private void Profile()
+        {
+            ElementsLstView.Items.Clear();
+            string[] samplePaths = GetSamplePaths();
+            PipelineElementProfile[] profiles;
+            try {
+                using (new CursorChanger(this, Cursors.WaitCursor)) {
+                    profiles = new PCCExecutor().ProfilePipeline(pipeline.Encode(), samplePaths, ITERATIONS);
+                }
+            } catch (PCCExecutorException ex) {
+                MessageBox.Show(this, String.Format(Resources.PipelineProfileForm_Msg_ProfilingFailed, ex.Message),
+                    Resources.PipelinePluginForm_MsgTitle, MessageBoxButtons.OK, MessageBoxIcon.Error);
+                return;
+            }
+
+            double totalMicroseconds = 0;
+            foreach (PipelineElementProfile profile in profiles) {
+                totalMicroseconds += profile.Duration.TotalMilliseconds * 1000;
+            }
+            int runs = samplePaths.Length * ITERATIONS;
+            ElementsLstView.BeginUpdate();
+            try {
+                ListViewItem slowestItem = null;
+                double slowestMicroseconds = -1;
+                for (int i = 0; i < profiles.Length; ++i) {
+                    double microseconds = profiles[i].Duration.TotalMilliseconds * 1000;
+                    ListViewItem item = new ListViewItem(i < pipeline.Elements.Count
+                        ? pipeline.Elements[i].DisplayValue : (i + 1).ToString(CultureInfo.CurrentCulture));
+                    item.SubItems.Add((microseconds / runs).ToString("F2", CultureInfo.CurrentCulture));
+                    item.SubItems.Add((totalMicroseconds > 0 ? microseconds * 100 / totalMicroseconds : 0).ToString(
+                        "F1", CultureInfo.CurrentCulture));
+                    item.SubItems.Add(profiles[i].AllocationsPerPath.HasValue
+                        ? profiles[i].AllocationsPerPath.Value.ToString("F1", CultureInfo.CurrentCulture)
+                        : Resources.PipelineProfileForm_AllocationsUnavailable);
+                    ElementsLstView.Items.Add(item);
+                    if (microseconds > slowestMicroseconds) {
+                        slowestItem = item;
+                        slowestMicroseconds = microseconds;
+                    }
+                }
+                if (slowestItem != null) {
+                    slowestItem.Selected = true;
+                }
+            } finally {
+                ElementsLstView.EndUpdate();
+            }
+            TotalLbl.Text = String.Format(Resources.PipelineProfileForm_Total,
+                (totalMicroseconds / runs).ToString("F2", CultureInfo.CurrentCulture), samplePaths.Length, ITERATIONS);
+        }
+    }
+}
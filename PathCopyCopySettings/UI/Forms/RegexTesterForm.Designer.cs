@@ -36,6 +36,7 @@
             this.RegexLbl = new System.Windows.Forms.Label();
             this.ExecutionGroupBox = new System.Windows.Forms.GroupBox();
             this.InvalidNoticeLbl = new System.Windows.Forms.Label();
+            this.MatchTimeLbl = new System.Windows.Forms.Label();
             this.TestBtn = new System.Windows.Forms.Button();
             this.ResultLbl = new System.Windows.Forms.Label();
             this.ResultTxt = new System.Windows.Forms.TextBox();
@@ -122,6 +123,7 @@
             // 
             this.ExecutionGroupBox.Anchor = ((System.Windows.Forms.AnchorStyles)(((System.Windows.Forms.AnchorStyles.Top | System.Windows.Forms.AnchorStyles.Left) 
             | System.Windows.Forms.AnchorStyles.Right)));
+            this.ExecutionGroupBox.Controls.Add(this.MatchTimeLbl);
             this.ExecutionGroupBox.Controls.Add(this.InvalidNoticeLbl);
             this.ExecutionGroupBox.Controls.Add(this.TestBtn);
             this.ExecutionGroupBox.Controls.Add(this.ResultLbl);
@@ -147,6 +149,16 @@
             this.InvalidNoticeLbl.TabIndex = 5;
             this.InvalidNoticeLbl.Text = "Invalid regular expression";
             this.InvalidNoticeLbl.Visible = false;
+            // 
+            // MatchTimeLbl
+            // 
+            this.MatchTimeLbl.AutoSize = true;
+            this.MatchTimeLbl.Location = new System.Drawing.Point(164, 98);
+            this.MatchTimeLbl.Name = "MatchTimeLbl";
+            this.MatchTimeLbl.Size = new System.Drawing.Size(0, 13);
+            this.MatchTimeLbl.TabIndex = 7;
+            this.RegexToolTip.SetToolTip(this.MatchTimeLbl, "Time taken by the find/replace operation. Slow regular expressions can make copyi" +
+        "ng paths slow");
             // 
             // TestBtn
             // 
@@ -306,6 +318,7 @@
             this.StartPosition = System.Windows.Forms.FormStartPosition.CenterParent;
             this.Text = "Regular Expression Testing";
             this.HelpButtonClicked += new System.ComponentModel.CancelEventHandler(this.RegexTesterForm_HelpButtonClicked);
+            this.FormClosed += new System.Windows.Forms.FormClosedEventHandler(this.RegexTesterForm_FormClosed);
             this.ParamsGroupBox.ResumeLayout(false);
             this.ParamsGroupBox.PerformLayout();
             this.ExecutionGroupBox.ResumeLayout(false);
@@ -331,6 +344,7 @@
         private System.Windows.Forms.TextBox ResultTxt;
         private System.Windows.Forms.Button TestBtn;
         private System.Windows.Forms.Label InvalidNoticeLbl;
+        private System.Windows.Forms.Label MatchTimeLbl;
         private System.Windows.Forms.Label RegexSyntaxHelpLbl1;
         private System.Windows.Forms.Label RegexSyntaxHelpLbl2;
         private System.Windows.Forms.LinkLabel RegexSyntaxHelpLinkLbl1;
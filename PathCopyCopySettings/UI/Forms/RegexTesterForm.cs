@@ -19,8 +19,10 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 // THE SOFTWARE.
 
+using System;
 using System.ComponentModel;
 using System.Diagnostics;
+using System.Drawing;
 using System.Windows.Forms;
 using PathCopyCopy.Settings.Core.Regexes;
 using PathCopyCopy.Settings.Properties;
@@ -36,6 +38,12 @@ namespace PathCopyCopy.Settings.UI.Forms
     /// <seealso cref="T:RegexTester"/>
     public partial class RegexTesterForm : PositionPersistedForm
     {
+        /// Match time above which a regular expression is reported as slow, in milliseconds.
+        private const double SLOW_MATCH_TIME_MS = 10.0;
+
+        /// Regex tester used to perform tests, kept for the lifetime of the form.
+        private RegexTester tester;
+
         /// <summary>
         /// Constructor.
         /// </summary>
@@ -108,16 +116,28 @@ namespace PathCopyCopy.Settings.UI.Forms
         private void TestBtn_Click(object sender, System.EventArgs e)
         {
             try {
-                RegexTester tester = new RegexTester();
+                if (tester == null) {
+                    tester = new RegexTester();
+                }
+                RegexTestResult result;
                 using (new CursorChanger(this, Cursors.WaitCursor)) {
-                    ResultTxt.Text = tester.ModifyWithRegex(SampleTxt.Text, RegexTxt.Text,
-                        ReplacementTxt.Text, IgnoreCaseChk.Checked);
+                    result = tester.TestRegex(new string[] { SampleTxt.Text }, RegexTxt.Text,
+                        ReplacementTxt.Text, IgnoreCaseChk.Checked)[0];
                 }
+                ResultTxt.Text = result.Modified;
+
                 // If we made it here, the regular expression is valid.
+                // Show how long it took, so that slow ones can be spotted.
                 InvalidNoticeLbl.Visible = false;
+                double matchTimeMs = result.MatchTime.TotalMilliseconds;
+                bool slow = matchTimeMs >= SLOW_MATCH_TIME_MS;
+                MatchTimeLbl.Text = String.Format(slow ? Resources.RegexTesterForm_SlowMatchTime
+                    : Resources.RegexTesterForm_MatchTime, matchTimeMs);
+                MatchTimeLbl.ForeColor = slow ? Color.Red : SystemColors.ControlText;
             } catch (RegexTesterException) {
-                // Invalid regular expression.
+                // Invalid regular expression, or one that took too long.
                 ResultTxt.Clear();
+                MatchTimeLbl.Text = String.Empty;
                 InvalidNoticeLbl.Visible = true;
             }
         }
@@ -133,6 +153,18 @@ namespace PathCopyCopy.Settings.UI.Forms
             Process.Start((sender as LinkLabel).Text);
         }
 
+        /// <summary>
+        /// Called when the form is closed. We stop the regex tester program
+        /// if we started it.
+        /// </summary>
+        /// <param name="sender">Event sender.</param>
+        /// <param name="e">Event arguments.</param>
+        private void RegexTesterForm_FormClosed(object sender, FormClosedEventArgs e)
+        {
+            tester?.Dispose();
+            tester = null;
+        }
+
         /// <summary>
         /// Called when the user presses the Help button in the form's caption bar.
         /// We navigate to the wiki to show help in such a case.
@@ -0,0 +1,216 @@
+﻿namespace PathCopyCopy.Settings.UI.Forms
+{
+    partial class SlowOperationsForm
+    {
+        /// <summary>
+        /// Required designer variable.
+        /// </summary>
+        private System.ComponentModel.IContainer components = null;
+
+        /// <summary>
+        /// Clean up any resources being used.
+        /// </summary>
+        /// <param name="disposing">true if managed resources should be disposed; otherwise, false.</param>
+        protected override void Dispose(bool disposing)
+        {
+            if (disposing && (components != null)) {
+                components.Dispose();
+            }
+            base.Dispose(disposing);
+        }
+
+        #region Windows Form Designer generated code
+
+        /// <summary>
+        /// Required method for Designer support - do not modify
+        /// the contents of this method with the code editor.
+        /// </summary>
+        private void InitializeComponent()
+        {
+            this.CapturesLbl = new System.Windows.Forms.Label();
+            this.CapturesLstView = new System.Windows.Forms.ListView();
+            this.TimeCol = ((System.Windows.Forms.ColumnHeader)(new System.Windows.Forms.ColumnHeader()));
+            this.OperationCol = ((System.Windows.Forms.ColumnHeader)(new System.Windows.Forms.ColumnHeader()));
+            this.DurationCol = ((System.Windows.Forms.ColumnHeader)(new System.Windows.Forms.ColumnHeader()));
+            this.PhasesLbl = new System.Windows.Forms.Label();
+            this.PhasesLstView = new System.Windows.Forms.ListView();
+            this.PhaseCol = ((System.Windows.Forms.ColumnHeader)(new System.Windows.Forms.ColumnHeader()));
+            this.PhaseDurationCol = ((System.Windows.Forms.ColumnHeader)(new System.Windows.Forms.ColumnHeader()));
+            this.PhaseCountCol = ((System.Windows.Forms.ColumnHeader)(new System.Windows.Forms.ColumnHeader()));
+            this.ExportBtn = new System.Windows.Forms.Button();
+            this.ClearBtn = new System.Windows.Forms.Button();
+            this.CloseBtn = new System.Windows.Forms.Button();
+            this.ExportSaveDlg = new System.Windows.Forms.SaveFileDialog();
+            this.SuspendLayout();
+            // 
+            // CapturesLbl
+            // 
+            this.CapturesLbl.AutoSize = true;
+            this.CapturesLbl.Location = new System.Drawing.Point(12, 9);
+            this.CapturesLbl.Name = "CapturesLbl";
+            this.CapturesLbl.Size = new System.Drawing.Size(266, 13);
+            this.CapturesLbl.TabIndex = 0;
+            this.CapturesLbl.Text = "Slow operations recorded by the contextual menu:";
+            // 
+            // CapturesLstView
+            // 
+            this.CapturesLstView.Anchor = ((System.Windows.Forms.AnchorStyles)(((System.Windows.Forms.AnchorStyles.Top | System.Windows.Forms.AnchorStyles.Left) 
+            | System.Windows.Forms.AnchorStyles.Right)));
+            this.CapturesLstView.Columns.AddRange(new System.Windows.Forms.ColumnHeader[] {
+            this.TimeCol,
+            this.OperationCol,
+            this.DurationCol});
+            this.CapturesLstView.FullRowSelect = true;
+            this.CapturesLstView.HideSelection = false;
+            this.CapturesLstView.Location = new System.Drawing.Point(12, 25);
+            this.CapturesLstView.MultiSelect = false;
+            this.CapturesLstView.Name = "CapturesLstView";
+            this.CapturesLstView.Size = new System.Drawing.Size(458, 130);
+            this.CapturesLstView.TabIndex = 1;
+            this.CapturesLstView.UseCompatibleStateImageBehavior = false;
+            this.CapturesLstView.View = System.Windows.Forms.View.Details;
+            this.CapturesLstView.SelectedIndexChanged += new System.EventHandler(this.CapturesLstView_SelectedIndexChanged);
+            // 
+            // TimeCol
+            // 
+            this.TimeCol.Text = "Time";
+            this.TimeCol.Width = 200;
+            // 
+            // OperationCol
+            // 
+            this.OperationCol.Text = "Operation";
+            this.OperationCol.Width = 120;
+            // 
+            // DurationCol
+            // 
+            this.DurationCol.Text = "Duration (ms)";
+            this.DurationCol.TextAlign = System.Windows.Forms.HorizontalAlignment.Right;
+            this.DurationCol.Width = 110;
+            // 
+            // PhasesLbl
+            // 
+            this.PhasesLbl.AutoSize = true;
+            this.PhasesLbl.Location = new System.Drawing.Point(12, 164);
+            this.PhasesLbl.Name = "PhasesLbl";
+            this.PhasesLbl.Size = new System.Drawing.Size(44, 13);
+            this.PhasesLbl.TabIndex = 2;
+            this.PhasesLbl.Text = "Phases:";
+            // 
+            // PhasesLstView
+            // 
+            this.PhasesLstView.Anchor = ((System.Windows.Forms.AnchorStyles)((((System.Windows.Forms.AnchorStyles.Top | System.Windows.Forms.AnchorStyles.Bottom) 
+            | System.Windows.Forms.AnchorStyles.Left) 
+            | System.Windows.Forms.AnchorStyles.Right)));
+            this.PhasesLstView.Columns.AddRange(new System.Windows.Forms.ColumnHeader[] {
+            this.PhaseCol,
+            this.PhaseDurationCol,
+            this.PhaseCountCol});
+            this.PhasesLstView.FullRowSelect = true;
+            this.PhasesLstView.Location = new System.Drawing.Point(12, 180);
+            this.PhasesLstView.Name = "PhasesLstView";
+            this.PhasesLstView.Size = new System.Drawing.Size(458, 159);
+            this.PhasesLstView.TabIndex = 3;
+            this.PhasesLstView.UseCompatibleStateImageBehavior = false;
+            this.PhasesLstView.View = System.Windows.Forms.View.Details;
+            // 
+            // PhaseCol
+            // 
+            this.PhaseCol.Text = "Phase";
+            this.PhaseCol.Width = 260;
+            // 
+            // PhaseDurationCol
+            // 
+            this.PhaseDurationCol.Text = "Duration (ms)";
+            this.PhaseDurationCol.TextAlign = System.Windows.Forms.HorizontalAlignment.Right;
+            this.PhaseDurationCol.Width = 110;
+            // 
+            // PhaseCountCol
+            // 
+            this.PhaseCountCol.Text = "Count";
+            this.PhaseCountCol.TextAlign = System.Windows.Forms.HorizontalAlignment.Right;
+            this.PhaseCountCol.Width = 60;
+            // 
+            // ExportBtn
+            // 
+            this.ExportBtn.Anchor = ((System.Windows.Forms.AnchorStyles)((System.Windows.Forms.AnchorStyles.Bottom | System.Windows.Forms.AnchorStyles.Left)));
+            this.ExportBtn.Location = new System.Drawing.Point(12, 345);
+            this.ExportBtn.Name = "ExportBtn";
+            this.ExportBtn.Size = new System.Drawing.Size(75, 23);
+            this.ExportBtn.TabIndex = 4;
+            this.ExportBtn.Text = "E&xport...";
+            this.ExportBtn.UseVisualStyleBackColor = true;
+            this.ExportBtn.Click += new System.EventHandler(this.ExportBtn_Click);
+            // 
+            // ClearBtn
+            // 
+            this.ClearBtn.Anchor = ((System.Windows.Forms.AnchorStyles)((System.Windows.Forms.AnchorStyles.Bottom | System.Windows.Forms.AnchorStyles.Left)));
+            this.ClearBtn.Location = new System.Drawing.Point(93, 345);
+            this.ClearBtn.Name = "ClearBtn";
+            this.ClearBtn.Size = new System.Drawing.Size(75, 23);
+            this.ClearBtn.TabIndex = 5;
+            this.ClearBtn.Text = "C&lear";
+            this.ClearBtn.UseVisualStyleBackColor = true;
+            this.ClearBtn.Click += new System.EventHandler(this.ClearBtn_Click);
+            // 
+            // CloseBtn
+            // 
+            this.CloseBtn.Anchor = ((System.Windows.Forms.AnchorStyles)((System.Windows.Forms.AnchorStyles.Bottom | System.Windows.Forms.AnchorStyles.Right)));
+            this.CloseBtn.DialogResult = System.Windows.Forms.DialogResult.Cancel;
+            this.CloseBtn.Location = new System.Drawing.Point(395, 345);
+            this.CloseBtn.Name = "CloseBtn";
+            this.CloseBtn.Size = new System.Drawing.Size(75, 23);
+            this.CloseBtn.TabIndex = 6;
+            this.CloseBtn.Text = "&Close";
+            this.CloseBtn.UseVisualStyleBackColor = true;
+            // 
+            // ExportSaveDlg
+            // 
+            this.ExportSaveDlg.DefaultExt = "txt";
+            this.ExportSaveDlg.Filter = "Text files (*.txt)|*.txt";
+            this.ExportSaveDlg.Title = "Export Slow Operations As";
+            // 
+            // SlowOperationsForm
+            // 
+            this.AutoScaleDimensions = new System.Drawing.SizeF(6F, 13F);
+            this.AutoScaleMode = System.Windows.Forms.AutoScaleMode.Font;
+            this.CancelButton = this.CloseBtn;
+            this.ClientSize = new System.Drawing.Size(482, 380);
+            this.Controls.Add(this.CloseBtn);
+            this.Controls.Add(this.ClearBtn);
+            this.Controls.Add(this.ExportBtn);
+            this.Controls.Add(this.PhasesLstView);
+            this.Controls.Add(this.PhasesLbl);
+            this.Controls.Add(this.CapturesLstView);
+            this.Controls.Add(this.CapturesLbl);
+            this.MaximizeBox = false;
+            this.MinimizeBox = false;
+            this.MinimumSize = new System.Drawing.Size(498, 419);
+            this.Name = "SlowOperationsForm";
+            this.ShowIcon = false;
+            this.ShowInTaskbar = false;
+            this.StartPosition = System.Windows.Forms.FormStartPosition.CenterParent;
+            this.Text = "Path Copy Copy slow operations";
+            this.Load += new System.EventHandler(this.SlowOperationsForm_Load);
+            this.ResumeLayout(false);
+            this.PerformLayout();
+
+        }
+
+        #endregion
+
+        private System.Windows.Forms.Label CapturesLbl;
+        private System.Windows.Forms.ListView CapturesLstView;
+        private System.Windows.Forms.ColumnHeader TimeCol;
+        private System.Windows.Forms.ColumnHeader OperationCol;
+        private System.Windows.Forms.ColumnHeader DurationCol;
+        private System.Windows.Forms.Label PhasesLbl;
+        private System.Windows.Forms.ListView PhasesLstView;
+        private System.Windows.Forms.ColumnHeader PhaseCol;
+        private System.Windows.Forms.ColumnHeader PhaseDurationCol;
+        private System.Windows.Forms.ColumnHeader PhaseCountCol;
+        private System.Windows.Forms.Button ExportBtn;
+        private System.Windows.Forms.Button ClearBtn;
+        private System.Windows.Forms.Button CloseBtn;
+        private System.Windows.Forms.SaveFileDialog ExportSaveDlg;
+    }
+}
\ No newline at end of file
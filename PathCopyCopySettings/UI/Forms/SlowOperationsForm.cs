@@ -0,0 +1,147 @@
+﻿// SlowOperationsForm.cs
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+using System;
+using System.Collections.Generic;
+using System.Globalization;
+using System.IO;
+using System.Text;
+using System.Windows.Forms;
+using PathCopyCopy.Settings.Core;
+using PathCopyCopy.Settings.Properties;
+
+namespace PathCopyCopy.Settings.UI.Forms
+{
+    /// <summary>
+    /// Form displaying the slow operations captured by the flight recorder
+    /// of the shell extension, along with their phases.
+    /// </summary>
+    public partial class SlowOperationsForm : Form
+    {
+        /// Captured slow operations, from most recent to oldest.
+        private List<SlowOperationCapture> captures;
+
+        /// <summary>
+        /// Constructor.
+        /// </summary>
+        public SlowOperationsForm()
+        {
+            InitializeComponent();
+        }
+
+        /// <summary>
+        /// Called when the form is first loaded. We load captures here.
+        /// </summary>
+        /// <param name="sender">Event sender.</param>
+        /// <param name="e">Event arguments.</param>
+        private void SlowOperationsForm_Load(object sender, EventArgs e)
+        {
+            LoadCaptures();
+        }
+
+        /// <summary>
+        /// Loads captured slow operations from the registry and displays them.
+        /// </summary>
+        private void LoadCaptures()
+        {
+            captures = SlowOperationCapture.LoadAll();
+            CapturesLstView.BeginUpdate();
+            try {
+                CapturesLstView.Items.Clear();
+                foreach (SlowOperationCapture capture in captures) {
+                    ListViewItem item = new ListViewItem(capture.StartTime.ToString(CultureInfo.CurrentCulture));
+                    item.SubItems.Add(capture.Operation);
+                    item.SubItems.Add(capture.Duration.TotalMilliseconds.ToString("F1", CultureInfo.CurrentCulture));
+                    item.Tag = capture;
+                    CapturesLstView.Items.Add(item);
+                }
+            } finally {
+                CapturesLstView.EndUpdate();
+            }
+            if (CapturesLstView.Items.Count != 0) {
+                CapturesLstView.Items[0].Selected = true;
+            } else {
+                PhasesLstView.Items.Clear();
+            }
+            ExportBtn.Enabled = ClearBtn.Enabled = captures.Count != 0;
+        }
+
+        /// <summary>
+        /// Called when the selected capture changes. We display its phases.
+        /// </summary>
+        /// <param name="sender">Event sender.</param>
+        /// <param name="e">Event arguments.</param>
+        private void CapturesLstView_SelectedIndexChanged(object sender, EventArgs e)
+        {
+            PhasesLstView.BeginUpdate();
+            try {
+                PhasesLstView.Items.Clear();
+                if (CapturesLstView.SelectedItems.Count == 1) {
+                    SlowOperationCapture capture = (SlowOperationCapture) CapturesLstView.SelectedItems[0].Tag;
+                    foreach (SlowOperationCapture.Phase phase in capture.Phases) {
+                        ListViewItem item = new ListViewItem(phase.Name);
+                        item.SubItems.Add(phase.Duration.TotalMilliseconds.ToString("F1", CultureInfo.CurrentCulture));
+                        item.SubItems.Add(phase.Count.ToString(CultureInfo.CurrentCulture));
+                        PhasesLstView.Items.Add(item);
+                    }
+                }
+            } finally {
+                PhasesLstView.EndUpdate();
+            }
+        }
+
+        /// <summary>
+        /// Called when the user presses the Export button. We save a
+        /// report of all captures to a text file.
+        /// </summary>
+        /// <param name="sender">Event sender.</param>
+        /// <param name="e">Event arguments.</param>
+        private void ExportBtn_Click(object sender, EventArgs e)
+        {
+            if (ExportSaveDlg.ShowDialog(this) == DialogResult.OK) {
+                StringBuilder report = new StringBuilder();
+                foreach (SlowOperationCapture capture in captures) {
+                    report.AppendLine(capture.ToString());
+                }
+                try {
+                    File.WriteAllText(ExportSaveDlg.FileName, report.ToString(), Encoding.UTF8);
+                } catch (Exception) {
+                    MessageBox.Show(this, String.Format(Resources.SlowOperationsForm_Msg_NotExported,
+                        ExportSaveDlg.FileName), Resources.SlowOperationsForm_Msg_NotExportedMsgTitle,
+                        MessageBoxButtons.OK, MessageBoxIcon.Error);
+                }
+            }
+        }
+
+        /// <summary>
+        /// Called when the user presses the Clear button. We delete all
+        /// captures from the registry.
+        /// </summary>
+        /// <param name="sender">Event sender.</param>
+        /// <param name="e">Event arguments.</param>
+        private void ClearBtn_Click(object sender, EventArgs e)
+        {
+            SlowOperationCapture.DeleteAll();
+            LoadCaptures();
+        }
+    }
+}
@@ -0,0 +1,91 @@
+﻿namespace PathCopyCopy.Settings.UI.UserControls
+{
+    partial class BatchExecutablePipelineElementUserControl
+    {
+        /// <summary> 
+        /// Required designer variable.
+        /// </summary>
+        private System.ComponentModel.IContainer components = null;
+
+        /// <summary> 
+        /// Clean up any resources being used.
+        /// </summary>
+        /// <param name="disposing">true if managed resources should be disposed; otherwise, false.</param>
+        protected override void Dispose(bool disposing)
+        {
+            if (disposing && (components != null)) {
+                components.Dispose();
+            }
+            base.Dispose(disposing);
+        }
+
+        #region Component Designer generated code
+
+        /// <summary> 
+        /// Required method for Designer support - do not modify 
+        /// the contents of this method with the code editor.
+        /// </summary>
+        private void InitializeComponent()
+        {
+            this.components = new System.ComponentModel.Container();
+            this.MaxParallelBatchesLbl = new System.Windows.Forms.Label();
+            this.MaxParallelBatchesNumUpDown = new System.Windows.Forms.NumericUpDown();
+            this.BatchToolTip = new System.Windows.Forms.ToolTip(this.components);
+            ((System.ComponentModel.ISupportInitialize)(this.MaxParallelBatchesNumUpDown)).BeginInit();
+            this.SuspendLayout();
+            // 
+            // MaxParallelBatchesLbl
+            // 
+            this.MaxParallelBatchesLbl.AutoSize = true;
+            this.MaxParallelBatchesLbl.Location = new System.Drawing.Point(-3, 3);
+            this.MaxParallelBatchesLbl.Name = "MaxParallelBatchesLbl";
+            this.MaxParallelBatchesLbl.Size = new System.Drawing.Size(131, 13);
+            this.MaxParallelBatchesLbl.TabIndex = 0;
+            this.MaxParallelBatchesLbl.Text = "&Max batches run at once:";
+            // 
+            // MaxParallelBatchesNumUpDown
+            // 
+            this.MaxParallelBatchesNumUpDown.Location = new System.Drawing.Point(134, 0);
+            this.MaxParallelBatchesNumUpDown.Maximum = new decimal(new int[] {
+            64,
+            0,
+            0,
+            0});
+            this.MaxParallelBatchesNumUpDown.Minimum = new decimal(new int[] {
+            1,
+            0,
+            0,
+            0});
+            this.MaxParallelBatchesNumUpDown.Name = "MaxParallelBatchesNumUpDown";
+            this.MaxParallelBatchesNumUpDown.Size = new System.Drawing.Size(60, 20);
+            this.MaxParallelBatchesNumUpDown.TabIndex = 1;
+            this.BatchToolTip.SetToolTip(this.MaxParallelBatchesNumUpDown, "Maximum number of instances of the executable running at once when paths " +
+        "do not fit on a single command line");
+            this.MaxParallelBatchesNumUpDown.Value = new decimal(new int[] {
+            1,
+            0,
+            0,
+            0});
+            this.MaxParallelBatchesNumUpDown.ValueChanged += new System.EventHandler(this.MaxParallelBatchesNumUpDown_ValueChanged);
+            // 
+            // BatchExecutablePipelineElementUserControl
+            // 
+            this.AutoScaleDimensions = new System.Drawing.SizeF(6F, 13F);
+            this.AutoScaleMode = System.Windows.Forms.AutoScaleMode.Font;
+            this.Controls.Add(this.MaxParallelBatchesNumUpDown);
+            this.Controls.Add(this.MaxParallelBatchesLbl);
+            this.Name = "BatchExecutablePipelineElementUserControl";
+            this.Size = new System.Drawing.Size(231, 20);
+            ((System.ComponentModel.ISupportInitialize)(this.MaxParallelBatchesNumUpDown)).EndInit();
+            this.ResumeLayout(false);
+            this.PerformLayout();
+
+        }
+
+        #endregion
+
+        private System.Windows.Forms.Label MaxParallelBatchesLbl;
+        private System.Windows.Forms.NumericUpDown MaxParallelBatchesNumUpDown;
+        private System.Windows.Forms.ToolTip BatchToolTip;
+    }
+}
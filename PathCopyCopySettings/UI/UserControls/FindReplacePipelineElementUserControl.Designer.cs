@@ -32,6 +32,7 @@
             this.ReplaceLbl = new System.Windows.Forms.Label();
             this.ReplaceTxt = new System.Windows.Forms.TextBox();
             this.FindTxt = new System.Windows.Forms.TextBox();
+            this.IgnoreCaseChk = new System.Windows.Forms.CheckBox();
             this.FindReplaceToolTip = new System.Windows.Forms.ToolTip(this.components);
             this.SuspendLayout();
             // 
@@ -75,16 +76,29 @@
             this.FindReplaceToolTip.SetToolTip(this.FindTxt, "Character string to look for and replace in the path");
             this.FindTxt.TextChanged += new System.EventHandler(this.FindTxt_TextChanged);
             // 
+            // IgnoreCaseChk
+            // 
+            this.IgnoreCaseChk.AutoSize = true;
+            this.IgnoreCaseChk.Location = new System.Drawing.Point(0, 53);
+            this.IgnoreCaseChk.Name = "IgnoreCaseChk";
+            this.IgnoreCaseChk.Size = new System.Drawing.Size(82, 17);
+            this.IgnoreCaseChk.TabIndex = 4;
+            this.IgnoreCaseChk.Text = "&Ignore case";
+            this.FindReplaceToolTip.SetToolTip(this.IgnoreCaseChk, "Whether to ignore case when looking for the character string in the path");
+            this.IgnoreCaseChk.UseVisualStyleBackColor = true;
+            this.IgnoreCaseChk.CheckedChanged += new System.EventHandler(this.IgnoreCaseChk_CheckedChanged);
+            // 
             // FindReplacePipelineElementUserControl
             // 
             this.AutoScaleDimensions = new System.Drawing.SizeF(6F, 13F);
             this.AutoScaleMode = System.Windows.Forms.AutoScaleMode.Font;
+            this.Controls.Add(this.IgnoreCaseChk);
             this.Controls.Add(this.FindTxt);
             this.Controls.Add(this.ReplaceTxt);
             this.Controls.Add(this.ReplaceLbl);
             this.Controls.Add(this.FindLbl);
             this.Name = "FindReplacePipelineElementUserControl";
-            this.Size = new System.Drawing.Size(229, 47);
+            this.Size = new System.Drawing.Size(229, 70);
             this.ResumeLayout(false);
             this.PerformLayout();
 
@@ -96,6 +110,7 @@
         private System.Windows.Forms.Label ReplaceLbl;
         private System.Windows.Forms.TextBox ReplaceTxt;
         private System.Windows.Forms.TextBox FindTxt;
+        private System.Windows.Forms.CheckBox IgnoreCaseChk;
         private System.Windows.Forms.ToolTip FindReplaceToolTip;
     }
 }
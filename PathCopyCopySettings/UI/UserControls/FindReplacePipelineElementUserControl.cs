@@ -56,6 +56,7 @@ namespace PathCopyCopy.Settings.UI.UserControls
             base.OnLoad(e);
             FindTxt.Text = element.OldValue;
             ReplaceTxt.Text = element.NewValue;
+            IgnoreCaseChk.Checked = element.IgnoreCase;
         }
 
         /// <summary>
@@ -81,5 +82,17 @@ namespace PathCopyCopy.Settings.UI.UserControls
             element.NewValue = ReplaceTxt.Text;
             OnPipelineElementChanged(EventArgs.Empty);
         }
+
+        /// <summary>
+        /// Called when the user checks or unchecks the Ignore Case checkbox.
+        /// We update our associated pipeline element here.
+        /// </summary>
+        /// <param name="sender">Event sender.</param>
+        /// <param name="e">Event arguments.</param>
+        private void IgnoreCaseChk_CheckedChanged(object sender, EventArgs e)
+        {
+            element.IgnoreCase = IgnoreCaseChk.Checked;
+            OnPipelineElementChanged(EventArgs.Empty);
+        }
     }
 }
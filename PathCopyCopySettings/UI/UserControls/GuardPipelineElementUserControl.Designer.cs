@@ -0,0 +1,138 @@
+﻿namespace PathCopyCopy.Settings.UI.UserControls
+{
+    partial class GuardPipelineElementUserControl
+    {
+        /// <summary> 
+        /// Required designer variable.
+        /// </summary>
+        private System.ComponentModel.IContainer components = null;
+
+        /// <summary> 
+        /// Clean up any resources being used.
+        /// </summary>
+        /// <param name="disposing">true if managed resources should be disposed; otherwise, false.</param>
+        protected override void Dispose(bool disposing)
+        {
+            if (disposing && (components != null)) {
+                components.Dispose();
+            }
+            base.Dispose(disposing);
+        }
+
+        #region Component Designer generated code
+
+        /// <summary> 
+        /// Required method for Designer support - do not modify 
+        /// the contents of this method with the code editor.
+        /// </summary>
+        private void InitializeComponent()
+        {
+            this.components = new System.ComponentModel.Container();
+            this.MatchLbl = new System.Windows.Forms.Label();
+            this.MatchCombo = new System.Windows.Forms.ComboBox();
+            this.ValueTxt = new System.Windows.Forms.TextBox();
+            this.IgnoreCaseChk = new System.Windows.Forms.CheckBox();
+            this.ActionLbl = new System.Windows.Forms.Label();
+            this.ActionCombo = new System.Windows.Forms.ComboBox();
+            this.GuardToolTip = new System.Windows.Forms.ToolTip(this.components);
+            this.SuspendLayout();
+            // 
+            // MatchLbl
+            // 
+            this.MatchLbl.AutoSize = true;
+            this.MatchLbl.Location = new System.Drawing.Point(-3, 4);
+            this.MatchLbl.Name = "MatchLbl";
+            this.MatchLbl.Size = new System.Drawing.Size(32, 13);
+            this.MatchLbl.TabIndex = 0;
+            this.MatchLbl.Text = "&Path:";
+            // 
+            // MatchCombo
+            // 
+            this.MatchCombo.DropDownStyle = System.Windows.Forms.ComboBoxStyle.DropDownList;
+            this.MatchCombo.FormattingEnabled = true;
+            this.MatchCombo.Items.AddRange(new object[] {
+            "Starts with",
+            "Contains"});
+            this.MatchCombo.Location = new System.Drawing.Point(75, 0);
+            this.MatchCombo.Name = "MatchCombo";
+            this.MatchCombo.Size = new System.Drawing.Size(90, 21);
+            this.MatchCombo.TabIndex = 1;
+            this.GuardToolTip.SetToolTip(this.MatchCombo, "How to look for the character string in the path");
+            this.MatchCombo.SelectedIndexChanged += new System.EventHandler(this.MatchCombo_SelectedIndexChanged);
+            // 
+            // ValueTxt
+            // 
+            this.ValueTxt.Anchor = ((System.Windows.Forms.AnchorStyles)(((System.Windows.Forms.AnchorStyles.Top | System.Windows.Forms.AnchorStyles.Left) 
+            | System.Windows.Forms.AnchorStyles.Right)));
+            this.ValueTxt.Location = new System.Drawing.Point(171, 0);
+            this.ValueTxt.Name = "ValueTxt";
+            this.ValueTxt.Size = new System.Drawing.Size(147, 20);
+            this.ValueTxt.TabIndex = 2;
+            this.GuardToolTip.SetToolTip(this.ValueTxt, "Character string paths must start with or contain to go through the following elements");
+            this.ValueTxt.TextChanged += new System.EventHandler(this.ValueTxt_TextChanged);
+            // 
+            // IgnoreCaseChk
+            // 
+            this.IgnoreCaseChk.AutoSize = true;
+            this.IgnoreCaseChk.Location = new System.Drawing.Point(0, 27);
+            this.IgnoreCaseChk.Name = "IgnoreCaseChk";
+            this.IgnoreCaseChk.Size = new System.Drawing.Size(82, 17);
+            this.IgnoreCaseChk.TabIndex = 3;
+            this.IgnoreCaseChk.Text = "&Ignore case";
+            this.GuardToolTip.SetToolTip(this.IgnoreCaseChk, "Whether to ignore case when looking for the character string in the path");
+            this.IgnoreCaseChk.UseVisualStyleBackColor = true;
+            this.IgnoreCaseChk.CheckedChanged += new System.EventHandler(this.IgnoreCaseChk_CheckedChanged);
+            // 
+            // ActionLbl
+            // 
+            this.ActionLbl.AutoSize = true;
+            this.ActionLbl.Location = new System.Drawing.Point(-3, 53);
+            this.ActionLbl.Name = "ActionLbl";
+            this.ActionLbl.Size = new System.Drawing.Size(72, 13);
+            this.ActionLbl.TabIndex = 4;
+            this.ActionLbl.Text = "&Otherwise:";
+            // 
+            // ActionCombo
+            // 
+            this.ActionCombo.Anchor = ((System.Windows.Forms.AnchorStyles)(((System.Windows.Forms.AnchorStyles.Top | System.Windows.Forms.AnchorStyles.Left) 
+            | System.Windows.Forms.AnchorStyles.Right)));
+            this.ActionCombo.DropDownStyle = System.Windows.Forms.ComboBoxStyle.DropDownList;
+            this.ActionCombo.FormattingEnabled = true;
+            this.ActionCombo.Items.AddRange(new object[] {
+            "Copy path as-is, skipping the following elements",
+            "Disable command (only if this is the first element)"});
+            this.ActionCombo.Location = new System.Drawing.Point(75, 50);
+            this.ActionCombo.Name = "ActionCombo";
+            this.ActionCombo.Size = new System.Drawing.Size(243, 21);
+            this.ActionCombo.TabIndex = 5;
+            this.GuardToolTip.SetToolTip(this.ActionCombo, "What to do with paths that do not match");
+            this.ActionCombo.SelectedIndexChanged += new System.EventHandler(this.ActionCombo_SelectedIndexChanged);
+            // 
+            // GuardPipelineElementUserControl
+            // 
+            this.AutoScaleDimensions = new System.Drawing.SizeF(6F, 13F);
+            this.AutoScaleMode = System.Windows.Forms.AutoScaleMode.Font;
+            this.Controls.Add(this.ActionCombo);
+            this.Controls.Add(this.ActionLbl);
+            this.Controls.Add(this.IgnoreCaseChk);
+            this.Controls.Add(this.ValueTxt);
+            this.Controls.Add(this.MatchCombo);
+            this.Controls.Add(this.MatchLbl);
+            this.Name = "GuardPipelineElementUserControl";
+            this.Size = new System.Drawing.Size(318, 71);
+            this.ResumeLayout(false);
+            this.PerformLayout();
+
+        }
+
+        #endregion
+
+        private System.Windows.Forms.Label MatchLbl;
+        private System.Windows.Forms.ComboBox MatchCombo;
+        private System.Windows.Forms.TextBox ValueTxt;
+        private System.Windows.Forms.CheckBox IgnoreCaseChk;
+        private System.Windows.Forms.Label ActionLbl;
+        private System.Windows.Forms.ComboBox ActionCombo;
+        private System.Windows.Forms.ToolTip GuardToolTip;
+    }
+}
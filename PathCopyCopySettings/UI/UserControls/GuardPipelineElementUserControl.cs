@@ -0,0 +1,111 @@
+﻿// GuardPipelineElementUserControl.cs
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+using System;
+using System.Diagnostics;
+using System.Windows.Forms;
+using PathCopyCopy.Settings.Core.Plugins;
+
+namespace PathCopyCopy.Settings.UI.UserControls
+{
+    /// <summary>
+    /// UserControl used to configure a guard pipeline element.
+    /// </summary>
+    public partial class GuardPipelineElementUserControl : PipelineElementUserControl
+    {
+        /// Element we're configuring.
+        private GuardPipelineElement element;
+
+        /// <summary>
+        /// Constructor.
+        /// </summary>
+        /// <param name="element">Pipeline element to configure.</param>
+        public GuardPipelineElementUserControl(GuardPipelineElement element)
+        {
+            Debug.Assert(element != null);
+
+            this.element = element;
+
+            InitializeComponent();
+        }
+
+        /// <summary>
+        /// Called when the control is initially loaded. We populate our controls here.
+        /// </summary>
+        /// <param name="e">Event arguments.</param>
+        protected override void OnLoad(EventArgs e)
+        {
+            base.OnLoad(e);
+            MatchCombo.SelectedIndex = (int) element.Match - 1;
+            ValueTxt.Text = element.Value;
+            IgnoreCaseChk.Checked = element.IgnoreCase;
+            ActionCombo.SelectedIndex = (int) element.Action - 1;
+        }
+
+        /// <summary>
+        /// Called when the selected match type changes. We update
+        /// our associated pipeline element here.
+        /// </summary>
+        /// <param name="sender">Event sender.</param>
+        /// <param name="e">Event arguments.</param>
+        private void MatchCombo_SelectedIndexChanged(object sender, EventArgs e)
+        {
+            element.Match = (GuardMatch) (MatchCombo.SelectedIndex + 1);
+            OnPipelineElementChanged(EventArgs.Empty);
+        }
+
+        /// <summary>
+        /// Called when the text of the value textbox changes. We update
+        /// our associated pipeline element here.
+        /// </summary>
+        /// <param name="sender">Event sender.</param>
+        /// <param name="e">Event arguments.</param>
+        private void ValueTxt_TextChanged(object sender, EventArgs e)
+        {
+            element.Value = ValueTxt.Text;
+            OnPipelineElementChanged(EventArgs.Empty);
+        }
+
+        /// <summary>
+        /// Called when the user checks or unchecks the Ignore Case checkbox.
+        /// We update our associated pipeline element here.
+        /// </summary>
+        /// <param name="sender">Event sender.</param>
+        /// <param name="e">Event arguments.</param>
+        private void IgnoreCaseChk_CheckedChanged(object sender, EventArgs e)
+        {
+            element.IgnoreCase = IgnoreCaseChk.Checked;
+            OnPipelineElementChanged(EventArgs.Empty);
+        }
+
+        /// <summary>
+        /// Called when the selected action changes. We update
+        /// our associated pipeline element here.
+        /// </summary>
+        /// <param name="sender">Event sender.</param>
+        /// <param name="e">Event arguments.</param>
+        private void ActionCombo_SelectedIndexChanged(object sender, EventArgs e)
+        {
+            element.Action = (GuardAction) (ActionCombo.SelectedIndex + 1);
+            OnPipelineElementChanged(EventArgs.Empty);
+        }
+    }
+}
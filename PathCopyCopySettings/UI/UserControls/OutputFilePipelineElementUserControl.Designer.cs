@@ -0,0 +1,128 @@
+﻿namespace PathCopyCopy.Settings.UI.UserControls
+{
+    partial class OutputFilePipelineElementUserControl
+    {
+        /// <summary> 
+        /// Required designer variable.
+        /// </summary>
+        private System.ComponentModel.IContainer components = null;
+
+        /// <summary> 
+        /// Clean up any resources being used.
+        /// </summary>
+        /// <param name="disposing">true if managed resources should be disposed; otherwise, false.</param>
+        protected override void Dispose(bool disposing)
+        {
+            if (disposing && (components != null)) {
+                components.Dispose();
+            }
+            base.Dispose(disposing);
+        }
+
+        #region Component Designer generated code
+
+        /// <summary> 
+        /// Required method for Designer support - do not modify 
+        /// the contents of this method with the code editor.
+        /// </summary>
+        private void InitializeComponent()
+        {
+            this.components = new System.ComponentModel.Container();
+            this.OutputFileLbl = new System.Windows.Forms.Label();
+            this.OutputFileTxt = new System.Windows.Forms.TextBox();
+            this.BrowseForOutputFileBtn = new System.Windows.Forms.Button();
+            this.EncodingLbl = new System.Windows.Forms.Label();
+            this.EncodingCombo = new System.Windows.Forms.ComboBox();
+            this.ChooseOutputFileSaveDlg = new System.Windows.Forms.SaveFileDialog();
+            this.OutputFileToolTip = new System.Windows.Forms.ToolTip(this.components);
+            this.SuspendLayout();
+            // 
+            // OutputFileLbl
+            // 
+            this.OutputFileLbl.AutoSize = true;
+            this.OutputFileLbl.Location = new System.Drawing.Point(-3, 5);
+            this.OutputFileLbl.Name = "OutputFileLbl";
+            this.OutputFileLbl.Size = new System.Drawing.Size(26, 13);
+            this.OutputFileLbl.TabIndex = 0;
+            this.OutputFileLbl.Text = "&File:";
+            // 
+            // OutputFileTxt
+            // 
+            this.OutputFileTxt.Anchor = ((System.Windows.Forms.AnchorStyles)(((System.Windows.Forms.AnchorStyles.Top | System.Windows.Forms.AnchorStyles.Left) 
+            | System.Windows.Forms.AnchorStyles.Right)));
+            this.OutputFileTxt.Location = new System.Drawing.Point(67, 2);
+            this.OutputFileTxt.Name = "OutputFileTxt";
+            this.OutputFileTxt.Size = new System.Drawing.Size(165, 20);
+            this.OutputFileTxt.TabIndex = 1;
+            this.OutputFileToolTip.SetToolTip(this.OutputFileTxt, "Path of the file to write paths to; can contain environment variables. Leave empty to choose the file each time");
+            this.OutputFileTxt.TextChanged += new System.EventHandler(this.OutputFileTxt_TextChanged);
+            // 
+            // BrowseForOutputFileBtn
+            // 
+            this.BrowseForOutputFileBtn.Anchor = ((System.Windows.Forms.AnchorStyles)((System.Windows.Forms.AnchorStyles.Top | System.Windows.Forms.AnchorStyles.Right)));
+            this.BrowseForOutputFileBtn.Location = new System.Drawing.Point(238, 0);
+            this.BrowseForOutputFileBtn.Name = "BrowseForOutputFileBtn";
+            this.BrowseForOutputFileBtn.Size = new System.Drawing.Size(80, 23);
+            this.BrowseForOutputFileBtn.TabIndex = 2;
+            this.BrowseForOutputFileBtn.Text = "&Browse";
+            this.OutputFileToolTip.SetToolTip(this.BrowseForOutputFileBtn, "Open a dialog to choose the file to write paths to");
+            this.BrowseForOutputFileBtn.UseVisualStyleBackColor = true;
+            this.BrowseForOutputFileBtn.Click += new System.EventHandler(this.BrowseForOutputFileBtn_Click);
+            // 
+            // EncodingLbl
+            // 
+            this.EncodingLbl.AutoSize = true;
+            this.EncodingLbl.Location = new System.Drawing.Point(-3, 32);
+            this.EncodingLbl.Name = "EncodingLbl";
+            this.EncodingLbl.Size = new System.Drawing.Size(55, 13);
+            this.EncodingLbl.TabIndex = 3;
+            this.EncodingLbl.Text = "E&ncoding:";
+            // 
+            // EncodingCombo
+            // 
+            this.EncodingCombo.Anchor = ((System.Windows.Forms.AnchorStyles)(((System.Windows.Forms.AnchorStyles.Top | System.Windows.Forms.AnchorStyles.Left) 
+            | System.Windows.Forms.AnchorStyles.Right)));
+            this.EncodingCombo.DropDownStyle = System.Windows.Forms.ComboBoxStyle.DropDownList;
+            this.EncodingCombo.FormattingEnabled = true;
+            this.EncodingCombo.Items.AddRange(new object[] {
+            "ANSI (system code page)",
+            "UTF-8",
+            "UTF-16 (little-endian, with BOM)"});
+            this.EncodingCombo.Location = new System.Drawing.Point(67, 29);
+            this.EncodingCombo.Name = "EncodingCombo";
+            this.EncodingCombo.Size = new System.Drawing.Size(251, 21);
+            this.EncodingCombo.TabIndex = 4;
+            this.OutputFileToolTip.SetToolTip(this.EncodingCombo, "Encoding used to write paths to the file");
+            this.EncodingCombo.SelectedIndexChanged += new System.EventHandler(this.EncodingCombo_SelectedIndexChanged);
+            // 
+            // ChooseOutputFileSaveDlg
+            // 
+            this.ChooseOutputFileSaveDlg.Filter = "Text files (*.txt)|*.txt|All files (*.*)|*.*";
+            // 
+            // OutputFilePipelineElementUserControl
+            // 
+            this.AutoScaleDimensions = new System.Drawing.SizeF(6F, 13F);
+            this.AutoScaleMode = System.Windows.Forms.AutoScaleMode.Font;
+            this.Controls.Add(this.EncodingCombo);
+            this.Controls.Add(this.EncodingLbl);
+            this.Controls.Add(this.BrowseForOutputFileBtn);
+            this.Controls.Add(this.OutputFileTxt);
+            this.Controls.Add(this.OutputFileLbl);
+            this.Name = "OutputFilePipelineElementUserControl";
+            this.Size = new System.Drawing.Size(318, 50);
+            this.ResumeLayout(false);
+            this.PerformLayout();
+
+        }
+
+        #endregion
+
+        private System.Windows.Forms.Label OutputFileLbl;
+        private System.Windows.Forms.TextBox OutputFileTxt;
+        private System.Windows.Forms.Button BrowseForOutputFileBtn;
+        private System.Windows.Forms.Label EncodingLbl;
+        private System.Windows.Forms.ComboBox EncodingCombo;
+        private System.Windows.Forms.SaveFileDialog ChooseOutputFileSaveDlg;
+        private System.Windows.Forms.ToolTip OutputFileToolTip;
+    }
+}
@@ -33,6 +33,10 @@
             this.BrowseForExecutableBtn = new System.Windows.Forms.Button();
             this.ChooseExecutableOpenDlg = new System.Windows.Forms.OpenFileDialog();
             this.ExecutableToolTip = new System.Windows.Forms.ToolTip(this.components);
+            this.FilelistEncodingLbl = new System.Windows.Forms.Label();
+            this.FilelistEncodingCombo = new System.Windows.Forms.ComboBox();
+            this.FilelistDeliveryLbl = new System.Windows.Forms.Label();
+            this.FilelistDeliveryCombo = new System.Windows.Forms.ComboBox();
             this.SuspendLayout();
             // 
             // ExecutableLbl
@@ -67,6 +71,61 @@
             this.BrowseForExecutableBtn.UseVisualStyleBackColor = true;
             this.BrowseForExecutableBtn.Click += new System.EventHandler(this.BrowseForExecutableBtn_Click);
             // 
+            // FilelistEncodingLbl
+            // 
+            this.FilelistEncodingLbl.AutoSize = true;
+            this.FilelistEncodingLbl.Location = new System.Drawing.Point(-3, 32);
+            this.FilelistEncodingLbl.Name = "FilelistEncodingLbl";
+            this.FilelistEncodingLbl.Size = new System.Drawing.Size(55, 13);
+            this.FilelistEncodingLbl.TabIndex = 3;
+            this.FilelistEncodingLbl.Text = "E&ncoding:";
+            this.FilelistEncodingLbl.Visible = false;
+            // 
+            // FilelistEncodingCombo
+            // 
+            this.FilelistEncodingCombo.Anchor = ((System.Windows.Forms.AnchorStyles)(((System.Windows.Forms.AnchorStyles.Top | System.Windows.Forms.AnchorStyles.Left) 
+            | System.Windows.Forms.AnchorStyles.Right)));
+            this.FilelistEncodingCombo.DropDownStyle = System.Windows.Forms.ComboBoxStyle.DropDownList;
+            this.FilelistEncodingCombo.FormattingEnabled = true;
+            this.FilelistEncodingCombo.Items.AddRange(new object[] {
+            "ANSI (system code page)",
+            "UTF-8",
+            "UTF-16 (little-endian, with BOM)"});
+            this.FilelistEncodingCombo.Location = new System.Drawing.Point(67, 29);
+            this.FilelistEncodingCombo.Name = "FilelistEncodingCombo";
+            this.FilelistEncodingCombo.Size = new System.Drawing.Size(251, 21);
+            this.FilelistEncodingCombo.TabIndex = 4;
+            this.ExecutableToolTip.SetToolTip(this.FilelistEncodingCombo, "Encoding used to write paths in the filelist");
+            this.FilelistEncodingCombo.Visible = false;
+            this.FilelistEncodingCombo.SelectedIndexChanged += new System.EventHandler(this.FilelistEncodingCombo_SelectedIndexChanged);
+            // 
+            // FilelistDeliveryLbl
+            // 
+            this.FilelistDeliveryLbl.AutoSize = true;
+            this.FilelistDeliveryLbl.Location = new System.Drawing.Point(-3, 59);
+            this.FilelistDeliveryLbl.Name = "FilelistDeliveryLbl";
+            this.FilelistDeliveryLbl.Size = new System.Drawing.Size(48, 13);
+            this.FilelistDeliveryLbl.TabIndex = 5;
+            this.FilelistDeliveryLbl.Text = "&Deliver:";
+            this.FilelistDeliveryLbl.Visible = false;
+            // 
+            // FilelistDeliveryCombo
+            // 
+            this.FilelistDeliveryCombo.Anchor = ((System.Windows.Forms.AnchorStyles)(((System.Windows.Forms.AnchorStyles.Top | System.Windows.Forms.AnchorStyles.Left) 
+            | System.Windows.Forms.AnchorStyles.Right)));
+            this.FilelistDeliveryCombo.DropDownStyle = System.Windows.Forms.ComboBoxStyle.DropDownList;
+            this.FilelistDeliveryCombo.FormattingEnabled = true;
+            this.FilelistDeliveryCombo.Items.AddRange(new object[] {
+            "Temporary file passed as argument",
+            "Standard input (pipe)"});
+            this.FilelistDeliveryCombo.Location = new System.Drawing.Point(67, 56);
+            this.FilelistDeliveryCombo.Name = "FilelistDeliveryCombo";
+            this.FilelistDeliveryCombo.Size = new System.Drawing.Size(251, 21);
+            this.FilelistDeliveryCombo.TabIndex = 6;
+            this.ExecutableToolTip.SetToolTip(this.FilelistDeliveryCombo, "How the filelist is passed to the executable");
+            this.FilelistDeliveryCombo.Visible = false;
+            this.FilelistDeliveryCombo.SelectedIndexChanged += new System.EventHandler(this.FilelistDeliveryCombo_SelectedIndexChanged);
+            // 
             // ChooseExecutableOpenDlg
             // 
             this.ChooseExecutableOpenDlg.Filter = "Executable files (*.exe;*.com;*.bat;*.cmd)|*.exe;*.com;*.bat;*.cmd|All files (*.*" +
@@ -76,11 +135,15 @@
             // 
             this.AutoScaleDimensions = new System.Drawing.SizeF(6F, 13F);
             this.AutoScaleMode = System.Windows.Forms.AutoScaleMode.Font;
+            this.Controls.Add(this.FilelistDeliveryCombo);
+            this.Controls.Add(this.FilelistDeliveryLbl);
+            this.Controls.Add(this.FilelistEncodingCombo);
+            this.Controls.Add(this.FilelistEncodingLbl);
             this.Controls.Add(this.BrowseForExecutableBtn);
             this.Controls.Add(this.ExecutableTxt);
             this.Controls.Add(this.ExecutableLbl);
             this.Name = "PipelineElementWithExecutableUserControl";
-            this.Size = new System.Drawing.Size(318, 24);
+            this.Size = new System.Drawing.Size(318, 77);
             this.ResumeLayout(false);
             this.PerformLayout();
 
@@ -93,5 +156,9 @@
         private System.Windows.Forms.Button BrowseForExecutableBtn;
         private System.Windows.Forms.OpenFileDialog ChooseExecutableOpenDlg;
         private System.Windows.Forms.ToolTip ExecutableToolTip;
+        private System.Windows.Forms.Label FilelistEncodingLbl;
+        private System.Windows.Forms.ComboBox FilelistEncodingCombo;
+        private System.Windows.Forms.Label FilelistDeliveryLbl;
+        private System.Windows.Forms.ComboBox FilelistDeliveryCombo;
     }
 }
@@ -35,6 +35,9 @@ namespace PathCopyCopy.Settings.UI.UserControls
         /// Element we're configuring.
         private PipelineElementWithExecutable element;
 
+        /// Element we're configuring, if it uses a filelist (otherwise null).
+        private ExecutableWithFilelistPipelineElement filelistElement;
+
         /// <summary>
         /// Constructor.
         /// </summary>
@@ -44,6 +47,7 @@ namespace PathCopyCopy.Settings.UI.UserControls
             Debug.Assert(element != null);
 
             this.element = element;
+            filelistElement = element as ExecutableWithFilelistPipelineElement;
 
             InitializeComponent();
         }
@@ -56,6 +60,16 @@ namespace PathCopyCopy.Settings.UI.UserControls
         {
             base.OnLoad(e);
             ExecutableTxt.Text = element.Executable;
+
+            // Filelist encoding and delivery are only available for elements using a filelist.
+            if (filelistElement != null) {
+                FilelistEncodingCombo.SelectedIndex = (int) filelistElement.Encoding;
+                FilelistEncodingLbl.Visible = true;
+                FilelistEncodingCombo.Visible = true;
+                FilelistDeliveryCombo.SelectedIndex = (int) filelistElement.Delivery;
+                FilelistDeliveryLbl.Visible = true;
+                FilelistDeliveryCombo.Visible = true;
+            }
         }
         
         /// <summary>
@@ -70,6 +84,34 @@ namespace PathCopyCopy.Settings.UI.UserControls
             OnPipelineElementChanged(EventArgs.Empty);
         }
 
+        /// <summary>
+        /// Called when the selected filelist encoding changes. We update
+        /// our associated pipeline element here.
+        /// </summary>
+        /// <param name="sender">Event sender.</param>
+        /// <param name="e">Event arguments.</param>
+        private void FilelistEncodingCombo_SelectedIndexChanged(object sender, EventArgs e)
+        {
+            if (filelistElement != null) {
+                filelistElement.Encoding = (FilelistEncoding) FilelistEncodingCombo.SelectedIndex;
+                OnPipelineElementChanged(EventArgs.Empty);
+            }
+        }
+
+        /// <summary>
+        /// Called when the selected filelist delivery changes. We update
+        /// our associated pipeline element here.
+        /// </summary>
+        /// <param name="sender">Event sender.</param>
+        /// <param name="e">Event arguments.</param>
+        private void FilelistDeliveryCombo_SelectedIndexChanged(object sender, EventArgs e)
+        {
+            if (filelistElement != null) {
+                filelistElement.Delivery = (FilelistDelivery) FilelistDeliveryCombo.SelectedIndex;
+                OnPipelineElementChanged(EventArgs.Empty);
+            }
+        }
+
         /// <summary>
         /// Called when the user presses the button to browse for an executable.
         /// We will show an open dialog allowing user to pick one.
@@ -19,6 +19,9 @@
             base.Dispose(disposing);
 
             // Code not generated by Component Designer
+            if (disposing) {
+                CancelPreview();
+            }
             settings?.Dispose();
             settings = null;
         }
@@ -31,8 +34,10 @@
         /// </summary>
         private void InitializeComponent()
         {
+            this.components = new System.ComponentModel.Container();
             this.PreviewGroupBox = new System.Windows.Forms.GroupBox();
             this.PreviewTxt = new System.Windows.Forms.TextBox();
+            this.PreviewTimer = new System.Windows.Forms.Timer(this.components);
             this.PreviewGroupBox.SuspendLayout();
             this.SuspendLayout();
             // 
@@ -57,6 +62,11 @@
             this.PreviewTxt.Size = new System.Drawing.Size(357, 20);
             this.PreviewTxt.TabIndex = 0;
             // 
+            // PreviewTimer
+            // 
+            this.PreviewTimer.Interval = 200;
+            this.PreviewTimer.Tick += new System.EventHandler(this.PreviewTimer_Tick);
+            // 
             // PluginPreviewUserControl
             // 
             this.AutoScaleDimensions = new System.Drawing.SizeF(6F, 13F);
@@ -74,5 +84,6 @@
 
         private System.Windows.Forms.GroupBox PreviewGroupBox;
         private System.Windows.Forms.TextBox PreviewTxt;
+        private System.Windows.Forms.Timer PreviewTimer;
     }
 }
@@ -19,9 +19,13 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 // THE SOFTWARE.
 
+using System;
+using System.Threading;
+using System.Threading.Tasks;
 using System.Windows.Forms;
 using PathCopyCopy.Settings.Core;
 using PathCopyCopy.Settings.Core.Plugins;
+using PathCopyCopy.Settings.Properties;
 
 namespace PathCopyCopy.Settings.UI.UserControls
 {
@@ -29,13 +33,29 @@ namespace PathCopyCopy.Settings.UI.UserControls
     /// User control that can be used to display a preview for
     /// a specific <see cref="Plugin"/>.
     /// </summary>
+    /// <remarks>
+    /// Previews can be slow to compute, so they are computed on a background
+    /// task once the plugin has stopped changing for a short while. Previews
+    /// are computed one at a time; previews that are out of date by the time
+    /// they are ready are discarded.
+    /// </remarks>
     public partial class PluginPreviewUserControl : UserControl
     {
+        /// Lock used to compute previews one at a time.
+        private static readonly object previewLock = new object();
+
         /// Plugin we're currently previewing.
         private Plugin plugin;
 
         /// Object used to access user settings.
         private UserSettings settings;
+
+        /// Source used to cancel the preview being computed, if any.
+        private CancellationTokenSource previewCancellationSource;
+
+        /// Incremented every time a new preview is requested, to
+        /// discard previews that are out of date when they are ready.
+        private int previewGeneration;
         
         /// <summary>
         /// Plugin to preview. Change this to update the preview displayed.
@@ -64,16 +84,69 @@ namespace PathCopyCopy.Settings.UI.UserControls
         }
 
         /// <summary>
-        /// Updates the preview displayed in the control.
+        /// Updates the preview displayed in the control. The preview
+        /// will be computed after a short delay.
         /// </summary>
         private void UpdatePreview()
         {
+            // Whatever is being computed is now out of date.
+            CancelPreview();
+            PreviewTimer.Stop();
             if (plugin != null && !(plugin is SeparatorPlugin)) {
-                PreviewTxt.Text = plugin.GetPreview(settings);
+                PreviewTimer.Start();
             } else {
                 // Clear content of preview textbox.
                 PreviewTxt.Clear();
             }
         }
+
+        /// <summary>
+        /// Cancels the preview being computed, if any.
+        /// </summary>
+        private void CancelPreview()
+        {
+            ++previewGeneration;
+            if (previewCancellationSource != null) {
+                previewCancellationSource.Cancel();
+                previewCancellationSource.Dispose();
+                previewCancellationSource = null;
+            }
+        }
+
+        /// <summary>
+        /// Called when the plugin has stopped changing for a while. We start
+        /// computing its preview on a background task.
+        /// </summary>
+        /// <param name="sender">Event sender.</param>
+        /// <param name="e">Event arguments.</param>
+        private void PreviewTimer_Tick(object sender, EventArgs e)
+        {
+            PreviewTimer.Stop();
+            if (plugin == null) {
+                return;
+            }
+
+            CancelPreview();
+            previewCancellationSource = new CancellationTokenSource();
+            CancellationToken cancellationToken = previewCancellationSource.Token;
+            int generation = previewGeneration;
+            Plugin pluginToPreview = plugin;
+            UserSettings previewSettings = settings;
+            Task.Factory.StartNew(() => {
+                lock (previewLock) {
+                    // Skip previews that went out of date while waiting for the lock.
+                    cancellationToken.ThrowIfCancellationRequested();
+                    try {
+                        return pluginToPreview.GetPreview(previewSettings);
+                    } catch (PCCExecutorException) {
+                        return Resources.Plugin_PreviewError;
+                    }
+                }
+            }, cancellationToken).ContinueWith(previewTask => {
+                if (!IsDisposed && generation == previewGeneration && previewTask.Status == TaskStatus.RanToCompletion) {
+                    PreviewTxt.Text = previewTask.Result;
+                }
+            }, CancellationToken.None, TaskContinuationOptions.None, TaskScheduler.FromCurrentSynchronizationContext());
+        }
     }
 }
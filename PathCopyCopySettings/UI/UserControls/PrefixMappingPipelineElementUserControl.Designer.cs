@@ -0,0 +1,149 @@
+﻿namespace PathCopyCopy.Settings.UI.UserControls
+{
+    partial class PrefixMappingPipelineElementUserControl
+    {
+        /// <summary> 
+        /// Required designer variable.
+        /// </summary>
+        private System.ComponentModel.IContainer components = null;
+
+        /// <summary> 
+        /// Clean up any resources being used.
+        /// </summary>
+        /// <param name="disposing">true if managed resources should be disposed; otherwise, false.</param>
+        protected override void Dispose(bool disposing)
+        {
+            if (disposing && (components != null)) {
+                components.Dispose();
+            }
+            base.Dispose(disposing);
+        }
+
+        #region Component Designer generated code
+
+        /// <summary> 
+        /// Required method for Designer support - do not modify 
+        /// the contents of this method with the code editor.
+        /// </summary>
+        private void InitializeComponent()
+        {
+            this.components = new System.ComponentModel.Container();
+            this.SourceLbl = new System.Windows.Forms.Label();
+            this.SourceCombo = new System.Windows.Forms.ComboBox();
+            this.TableLbl = new System.Windows.Forms.Label();
+            this.TableTxt = new System.Windows.Forms.TextBox();
+            this.BrowseForFileBtn = new System.Windows.Forms.Button();
+            this.IgnoreCaseChk = new System.Windows.Forms.CheckBox();
+            this.ChooseFileOpenDlg = new System.Windows.Forms.OpenFileDialog();
+            this.PrefixMappingToolTip = new System.Windows.Forms.ToolTip(this.components);
+            this.SuspendLayout();
+            // 
+            // SourceLbl
+            // 
+            this.SourceLbl.AutoSize = true;
+            this.SourceLbl.Location = new System.Drawing.Point(-3, 3);
+            this.SourceLbl.Name = "SourceLbl";
+            this.SourceLbl.Size = new System.Drawing.Size(44, 13);
+            this.SourceLbl.TabIndex = 0;
+            this.SourceLbl.Text = "&Source:";
+            // 
+            // SourceCombo
+            // 
+            this.SourceCombo.Anchor = ((System.Windows.Forms.AnchorStyles)(((System.Windows.Forms.AnchorStyles.Top | System.Windows.Forms.AnchorStyles.Left) 
+            | System.Windows.Forms.AnchorStyles.Right)));
+            this.SourceCombo.DropDownStyle = System.Windows.Forms.ComboBoxStyle.DropDownList;
+            this.SourceCombo.FormattingEnabled = true;
+            this.SourceCombo.Items.AddRange(new object[] {
+            "Table entered below",
+            "Table stored in a file",
+            "Table stored in a registry value"});
+            this.SourceCombo.Location = new System.Drawing.Point(67, 0);
+            this.SourceCombo.Name = "SourceCombo";
+            this.SourceCombo.Size = new System.Drawing.Size(251, 21);
+            this.SourceCombo.TabIndex = 1;
+            this.PrefixMappingToolTip.SetToolTip(this.SourceCombo, "Where the table of prefixes and replacement values is stored");
+            this.SourceCombo.SelectedIndexChanged += new System.EventHandler(this.SourceCombo_SelectedIndexChanged);
+            // 
+            // TableLbl
+            // 
+            this.TableLbl.AutoSize = true;
+            this.TableLbl.Location = new System.Drawing.Point(-3, 30);
+            this.TableLbl.Name = "TableLbl";
+            this.TableLbl.Size = new System.Drawing.Size(37, 13);
+            this.TableLbl.TabIndex = 2;
+            this.TableLbl.Text = "&Table:";
+            // 
+            // TableTxt
+            // 
+            this.TableTxt.AcceptsReturn = true;
+            this.TableTxt.AcceptsTab = true;
+            this.TableTxt.Anchor = ((System.Windows.Forms.AnchorStyles)(((System.Windows.Forms.AnchorStyles.Top | System.Windows.Forms.AnchorStyles.Left) 
+            | System.Windows.Forms.AnchorStyles.Right)));
+            this.TableTxt.Location = new System.Drawing.Point(67, 27);
+            this.TableTxt.Multiline = true;
+            this.TableTxt.Name = "TableTxt";
+            this.TableTxt.ScrollBars = System.Windows.Forms.ScrollBars.Both;
+            this.TableTxt.Size = new System.Drawing.Size(251, 80);
+            this.TableTxt.TabIndex = 3;
+            this.TableTxt.WordWrap = false;
+            this.PrefixMappingToolTip.SetToolTip(this.TableTxt, "Table of prefixes and replacement values, one per line and separated by a tab; or" +
+        " path of the file or name of the registry value containing it");
+            this.TableTxt.TextChanged += new System.EventHandler(this.TableTxt_TextChanged);
+            // 
+            // BrowseForFileBtn
+            // 
+            this.BrowseForFileBtn.Anchor = ((System.Windows.Forms.AnchorStyles)((System.Windows.Forms.AnchorStyles.Top | System.Windows.Forms.AnchorStyles.Right)));
+            this.BrowseForFileBtn.Location = new System.Drawing.Point(238, 113);
+            this.BrowseForFileBtn.Name = "BrowseForFileBtn";
+            this.BrowseForFileBtn.Size = new System.Drawing.Size(80, 23);
+            this.BrowseForFileBtn.TabIndex = 5;
+            this.BrowseForFileBtn.Text = "&Browse";
+            this.PrefixMappingToolTip.SetToolTip(this.BrowseForFileBtn, "Open a dialog to choose the file containing the table on disk");
+            this.BrowseForFileBtn.UseVisualStyleBackColor = true;
+            this.BrowseForFileBtn.Click += new System.EventHandler(this.BrowseForFileBtn_Click);
+            // 
+            // IgnoreCaseChk
+            // 
+            this.IgnoreCaseChk.AutoSize = true;
+            this.IgnoreCaseChk.Location = new System.Drawing.Point(0, 117);
+            this.IgnoreCaseChk.Name = "IgnoreCaseChk";
+            this.IgnoreCaseChk.Size = new System.Drawing.Size(82, 17);
+            this.IgnoreCaseChk.TabIndex = 4;
+            this.IgnoreCaseChk.Text = "&Ignore case";
+            this.PrefixMappingToolTip.SetToolTip(this.IgnoreCaseChk, "Whether to ignore case when looking for prefixes");
+            this.IgnoreCaseChk.UseVisualStyleBackColor = true;
+            this.IgnoreCaseChk.CheckedChanged += new System.EventHandler(this.IgnoreCaseChk_CheckedChanged);
+            // 
+            // ChooseFileOpenDlg
+            // 
+            this.ChooseFileOpenDlg.Filter = "Text files (*.txt;*.tsv)|*.txt;*.tsv|All files (*.*)|*.*";
+            // 
+            // PrefixMappingPipelineElementUserControl
+            // 
+            this.AutoScaleDimensions = new System.Drawing.SizeF(6F, 13F);
+            this.AutoScaleMode = System.Windows.Forms.AutoScaleMode.Font;
+            this.Controls.Add(this.BrowseForFileBtn);
+            this.Controls.Add(this.IgnoreCaseChk);
+            this.Controls.Add(this.TableTxt);
+            this.Controls.Add(this.TableLbl);
+            this.Controls.Add(this.SourceCombo);
+            this.Controls.Add(this.SourceLbl);
+            this.Name = "PrefixMappingPipelineElementUserControl";
+            this.Size = new System.Drawing.Size(318, 137);
+            this.ResumeLayout(false);
+            this.PerformLayout();
+
+        }
+
+        #endregion
+
+        private System.Windows.Forms.Label SourceLbl;
+        private System.Windows.Forms.ComboBox SourceCombo;
+        private System.Windows.Forms.Label TableLbl;
+        private System.Windows.Forms.TextBox TableTxt;
+        private System.Windows.Forms.Button BrowseForFileBtn;
+        private System.Windows.Forms.CheckBox IgnoreCaseChk;
+        private System.Windows.Forms.OpenFileDialog ChooseFileOpenDlg;
+        private System.Windows.Forms.ToolTip PrefixMappingToolTip;
+    }
+}
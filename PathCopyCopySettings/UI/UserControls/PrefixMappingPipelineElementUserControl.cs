@@ -0,0 +1,130 @@
+﻿// PrefixMappingPipelineElementUserControl.cs
+// (c) 2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+using System;
+using System.Diagnostics;
+using System.IO;
+using System.Windows.Forms;
+using PathCopyCopy.Settings.Core.Plugins;
+
+namespace PathCopyCopy.Settings.UI.UserControls
+{
+    /// <summary>
+    /// UserControl used to configure a prefix mapping pipeline element.
+    /// </summary>
+    public partial class PrefixMappingPipelineElementUserControl : PipelineElementUserControl
+    {
+        /// Element we're configuring.
+        private PrefixMappingPipelineElement element;
+
+        /// <summary>
+        /// Constructor.
+        /// </summary>
+        /// <param name="element">Pipeline element to configure.</param>
+        public PrefixMappingPipelineElementUserControl(PrefixMappingPipelineElement element)
+        {
+            Debug.Assert(element != null);
+
+            this.element = element;
+
+            InitializeComponent();
+        }
+
+        /// <summary>
+        /// Called when the control is initially loaded. We populate our controls here.
+        /// </summary>
+        /// <param name="e">Event arguments.</param>
+        protected override void OnLoad(EventArgs e)
+        {
+            base.OnLoad(e);
+            SourceCombo.SelectedIndex = (int) element.Source;
+            TableTxt.Text = element.Table;
+            IgnoreCaseChk.Checked = element.IgnoreCase;
+            UpdateControls();
+        }
+
+        /// <summary>
+        /// Updates the state of controls that depend on the table source.
+        /// </summary>
+        private void UpdateControls()
+        {
+            BrowseForFileBtn.Enabled = element.Source == PrefixMappingSource.File;
+        }
+
+        /// <summary>
+        /// Called when the user selects a different table source. We update
+        /// our associated pipeline element here.
+        /// </summary>
+        /// <param name="sender">Event sender.</param>
+        /// <param name="e">Event arguments.</param>
+        private void SourceCombo_SelectedIndexChanged(object sender, EventArgs e)
+        {
+            element.Source = (PrefixMappingSource) SourceCombo.SelectedIndex;
+            UpdateControls();
+            OnPipelineElementChanged(EventArgs.Empty);
+        }
+
+        /// <summary>
+        /// Called when the text of the Table textbox changes. We update
+        /// our associated pipeline element here.
+        /// </summary>
+        /// <param name="sender">Event sender.</param>
+        /// <param name="e">Event arguments.</param>
+        private void TableTxt_TextChanged(object sender, EventArgs e)
+        {
+            element.Table = TableTxt.Text;
+            OnPipelineElementChanged(EventArgs.Empty);
+        }
+
+        /// <summary>
+        /// Called when the user checks or unchecks the Ignore Case checkbox.
+        /// We update our associated pipeline element here.
+        /// </summary>
+        /// <param name="sender">Event sender.</param>
+        /// <param name="e">Event arguments.</param>
+        private void IgnoreCaseChk_CheckedChanged(object sender, EventArgs e)
+        {
+            element.IgnoreCase = IgnoreCaseChk.Checked;
+            OnPipelineElementChanged(EventArgs.Empty);
+        }
+
+        /// <summary>
+        /// Called when the user presses the button to browse for a table file.
+        /// We will show an open dialog allowing user to pick one.
+        /// </summary>
+        /// <param name="sender">Event sender.</param>
+        /// <param name="e">Event arguments.</param>
+        private void BrowseForFileBtn_Click(object sender, EventArgs e)
+        {
+            // Show browse box, using the current filename as hint.
+            try {
+                ChooseFileOpenDlg.InitialDirectory = Path.GetDirectoryName(TableTxt.Text);
+                ChooseFileOpenDlg.FileName = Path.GetFileName(TableTxt.Text);
+            } catch {
+                // Bad format or something, simply don't use.
+            }
+            if (ChooseFileOpenDlg.ShowDialog(this) == DialogResult.OK) {
+                // User chose a new file, copy its path back in our control.
+                TableTxt.Text = ChooseFileOpenDlg.FileName;
+            }
+        }
+    }
+}
@@ -33,6 +33,7 @@
             this.ReplaceTxt = new System.Windows.Forms.TextBox();
             this.FindTxt = new System.Windows.Forms.TextBox();
             this.IgnoreCaseChk = new System.Windows.Forms.CheckBox();
+            this.FastEngineChk = new System.Windows.Forms.CheckBox();
             this.TestBtn = new System.Windows.Forms.Button();
             this.RegexToolTip = new System.Windows.Forms.ToolTip(this.components);
             this.SuspendLayout();
@@ -90,13 +91,25 @@
             this.IgnoreCaseChk.UseVisualStyleBackColor = true;
             this.IgnoreCaseChk.CheckedChanged += new System.EventHandler(this.IgnoreCaseChk_CheckedChanged);
             // 
+            // FastEngineChk
+            // 
+            this.FastEngineChk.AutoSize = true;
+            this.FastEngineChk.Location = new System.Drawing.Point(88, 56);
+            this.FastEngineChk.Name = "FastEngineChk";
+            this.FastEngineChk.Size = new System.Drawing.Size(102, 17);
+            this.FastEngineChk.TabIndex = 5;
+            this.FastEngineChk.Text = "Use &fast engine";
+            this.RegexToolTip.SetToolTip(this.FastEngineChk, "Whether to use a faster regex engine that supports a subset of the syntax (falls back to the standard engine if needed)");
+            this.FastEngineChk.UseVisualStyleBackColor = true;
+            this.FastEngineChk.CheckedChanged += new System.EventHandler(this.FastEngineChk_CheckedChanged);
+            // 
             // TestBtn
             // 
             this.TestBtn.Anchor = ((System.Windows.Forms.AnchorStyles)((System.Windows.Forms.AnchorStyles.Top | System.Windows.Forms.AnchorStyles.Right)));
             this.TestBtn.Location = new System.Drawing.Point(215, 52);
             this.TestBtn.Name = "TestBtn";
             this.TestBtn.Size = new System.Drawing.Size(75, 23);
-            this.TestBtn.TabIndex = 5;
+            this.TestBtn.TabIndex = 6;
             this.TestBtn.Text = "&Test...";
             this.RegexToolTip.SetToolTip(this.TestBtn, "Open a window to test the current regular/replacement expressions");
             this.TestBtn.UseVisualStyleBackColor = true;
@@ -107,6 +120,7 @@
             this.AutoScaleDimensions = new System.Drawing.SizeF(6F, 13F);
             this.AutoScaleMode = System.Windows.Forms.AutoScaleMode.Font;
             this.Controls.Add(this.TestBtn);
+            this.Controls.Add(this.FastEngineChk);
             this.Controls.Add(this.IgnoreCaseChk);
             this.Controls.Add(this.FindTxt);
             this.Controls.Add(this.ReplaceTxt);
@@ -126,6 +140,7 @@
         private System.Windows.Forms.TextBox ReplaceTxt;
         private System.Windows.Forms.TextBox FindTxt;
         private System.Windows.Forms.CheckBox IgnoreCaseChk;
+        private System.Windows.Forms.CheckBox FastEngineChk;
         private System.Windows.Forms.Button TestBtn;
         private System.Windows.Forms.ToolTip RegexToolTip;
     }
@@ -58,6 +58,7 @@ namespace PathCopyCopy.Settings.UI.UserControls
             FindTxt.Text = element.Regex;
             ReplaceTxt.Text = element.Format;
             IgnoreCaseChk.Checked = element.IgnoreCase;
+            FastEngineChk.Checked = element.Engine == RegexEngine.Fast;
         }
 
         /// <summary>
@@ -96,6 +97,18 @@ namespace PathCopyCopy.Settings.UI.UserControls
             OnPipelineElementChanged(EventArgs.Empty);
         }
 
+        /// <summary>
+        /// Called when the user checks or unchecks the Fast Engine checkbox.
+        /// We update our associated pipeline element here.
+        /// </summary>
+        /// <param name="sender">Event sender.</param>
+        /// <param name="e">Event arguments.</param>
+        private void FastEngineChk_CheckedChanged(object sender, EventArgs e)
+        {
+            element.Engine = FastEngineChk.Checked ? RegexEngine.Fast : RegexEngine.Standard;
+            OnPipelineElementChanged(EventArgs.Empty);
+        }
+
         /// <summary>
         /// Called when the user presses the button to test a regular expression.
         /// We will show a dialog allowing the user to test the currently-provided
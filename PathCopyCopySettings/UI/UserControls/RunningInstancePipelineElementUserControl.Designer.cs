@@ -0,0 +1,107 @@
+﻿namespace PathCopyCopy.Settings.UI.UserControls
+{
+    partial class RunningInstancePipelineElementUserControl
+    {
+        /// <summary> 
+        /// Required designer variable.
+        /// </summary>
+        private System.ComponentModel.IContainer components = null;
+
+        /// <summary> 
+        /// Clean up any resources being used.
+        /// </summary>
+        /// <param name="disposing">true if managed resources should be disposed; otherwise, false.</param>
+        protected override void Dispose(bool disposing)
+        {
+            if (disposing && (components != null)) {
+                components.Dispose();
+            }
+            base.Dispose(disposing);
+        }
+
+        #region Component Designer generated code
+
+        /// <summary> 
+        /// Required method for Designer support - do not modify 
+        /// the contents of this method with the code editor.
+        /// </summary>
+        private void InitializeComponent()
+        {
+            this.components = new System.ComponentModel.Container();
+            this.EndpointLbl = new System.Windows.Forms.Label();
+            this.EndpointCombo = new System.Windows.Forms.ComboBox();
+            this.EndpointNameLbl = new System.Windows.Forms.Label();
+            this.EndpointNameTxt = new System.Windows.Forms.TextBox();
+            this.EndpointToolTip = new System.Windows.Forms.ToolTip(this.components);
+            this.SuspendLayout();
+            // 
+            // EndpointLbl
+            // 
+            this.EndpointLbl.AutoSize = true;
+            this.EndpointLbl.Location = new System.Drawing.Point(-3, 3);
+            this.EndpointLbl.Name = "EndpointLbl";
+            this.EndpointLbl.Size = new System.Drawing.Size(52, 13);
+            this.EndpointLbl.TabIndex = 0;
+            this.EndpointLbl.Text = "&Endpoint:";
+            // 
+            // EndpointCombo
+            // 
+            this.EndpointCombo.Anchor = ((System.Windows.Forms.AnchorStyles)(((System.Windows.Forms.AnchorStyles.Top | System.Windows.Forms.AnchorStyles.Left) 
+            | System.Windows.Forms.AnchorStyles.Right)));
+            this.EndpointCombo.DropDownStyle = System.Windows.Forms.ComboBoxStyle.DropDownList;
+            this.EndpointCombo.FormattingEnabled = true;
+            this.EndpointCombo.Items.AddRange(new object[] {
+            "Named pipe",
+            "Window (WM_COPYDATA)"});
+            this.EndpointCombo.Location = new System.Drawing.Point(59, 0);
+            this.EndpointCombo.Name = "EndpointCombo";
+            this.EndpointCombo.Size = new System.Drawing.Size(172, 21);
+            this.EndpointCombo.TabIndex = 1;
+            this.EndpointToolTip.SetToolTip(this.EndpointCombo, "How to send paths to a running instance of the executable");
+            this.EndpointCombo.SelectedIndexChanged += new System.EventHandler(this.EndpointCombo_SelectedIndexChanged);
+            // 
+            // EndpointNameLbl
+            // 
+            this.EndpointNameLbl.AutoSize = true;
+            this.EndpointNameLbl.Location = new System.Drawing.Point(-3, 30);
+            this.EndpointNameLbl.Name = "EndpointNameLbl";
+            this.EndpointNameLbl.Size = new System.Drawing.Size(38, 13);
+            this.EndpointNameLbl.TabIndex = 2;
+            this.EndpointNameLbl.Text = "&Name:";
+            // 
+            // EndpointNameTxt
+            // 
+            this.EndpointNameTxt.Anchor = ((System.Windows.Forms.AnchorStyles)(((System.Windows.Forms.AnchorStyles.Top | System.Windows.Forms.AnchorStyles.Left) 
+            | System.Windows.Forms.AnchorStyles.Right)));
+            this.EndpointNameTxt.Location = new System.Drawing.Point(59, 27);
+            this.EndpointNameTxt.Name = "EndpointNameTxt";
+            this.EndpointNameTxt.Size = new System.Drawing.Size(172, 20);
+            this.EndpointNameTxt.TabIndex = 3;
+            this.EndpointToolTip.SetToolTip(this.EndpointNameTxt, "Name of the pipe (e.g. \\\\.\\pipe\\MyEditor) or window class used to reach " +
+        "the running instance");
+            this.EndpointNameTxt.TextChanged += new System.EventHandler(this.EndpointNameTxt_TextChanged);
+            // 
+            // RunningInstancePipelineElementUserControl
+            // 
+            this.AutoScaleDimensions = new System.Drawing.SizeF(6F, 13F);
+            this.AutoScaleMode = System.Windows.Forms.AutoScaleMode.Font;
+            this.Controls.Add(this.EndpointNameTxt);
+            this.Controls.Add(this.EndpointNameLbl);
+            this.Controls.Add(this.EndpointCombo);
+            this.Controls.Add(this.EndpointLbl);
+            this.Name = "RunningInstancePipelineElementUserControl";
+            this.Size = new System.Drawing.Size(231, 47);
+            this.ResumeLayout(false);
+            this.PerformLayout();
+
+        }
+
+        #endregion
+
+        private System.Windows.Forms.Label EndpointLbl;
+        private System.Windows.Forms.ComboBox EndpointCombo;
+        private System.Windows.Forms.Label EndpointNameLbl;
+        private System.Windows.Forms.TextBox EndpointNameTxt;
+        private System.Windows.Forms.ToolTip EndpointToolTip;
+    }
+}
@@ -0,0 +1,76 @@
+﻿namespace PathCopyCopy.Settings.UI.UserControls
+{
+    partial class TemplatePipelineElementUserControl
+    {
+        /// <summary> 
+        /// Required designer variable.
+        /// </summary>
+        private System.ComponentModel.IContainer components = null;
+
+        /// <summary> 
+        /// Clean up any resources being used.
+        /// </summary>
+        /// <param name="disposing">true if managed resources should be disposed; otherwise, false.</param>
+        protected override void Dispose(bool disposing)
+        {
+            if (disposing && (components != null)) {
+                components.Dispose();
+            }
+            base.Dispose(disposing);
+        }
+
+        #region Component Designer generated code
+
+        /// <summary> 
+        /// Required method for Designer support - do not modify 
+        /// the contents of this method with the code editor.
+        /// </summary>
+        private void InitializeComponent()
+        {
+            this.components = new System.ComponentModel.Container();
+            this.TemplateLbl = new System.Windows.Forms.Label();
+            this.TemplateTxt = new System.Windows.Forms.TextBox();
+            this.TemplateToolTip = new System.Windows.Forms.ToolTip(this.components);
+            this.SuspendLayout();
+            // 
+            // TemplateLbl
+            // 
+            this.TemplateLbl.AutoSize = true;
+            this.TemplateLbl.Location = new System.Drawing.Point(-3, 3);
+            this.TemplateLbl.Name = "TemplateLbl";
+            this.TemplateLbl.Size = new System.Drawing.Size(54, 13);
+            this.TemplateLbl.TabIndex = 0;
+            this.TemplateLbl.Text = "&Template:";
+            // 
+            // TemplateTxt
+            // 
+            this.TemplateTxt.Anchor = ((System.Windows.Forms.AnchorStyles)(((System.Windows.Forms.AnchorStyles.Top | System.Windows.Forms.AnchorStyles.Left) 
+            | System.Windows.Forms.AnchorStyles.Right)));
+            this.TemplateTxt.Location = new System.Drawing.Point(59, 0);
+            this.TemplateTxt.Name = "TemplateTxt";
+            this.TemplateTxt.Size = new System.Drawing.Size(172, 20);
+            this.TemplateTxt.TabIndex = 1;
+            this.TemplateToolTip.SetToolTip(this.TemplateTxt, "Text to replace the path with; use {plugin:ID} for the output of a command, {path" +
+        "} for the path itself and {{ or }} for literal braces");
+            this.TemplateTxt.TextChanged += new System.EventHandler(this.TemplateTxt_TextChanged);
+            // 
+            // TemplatePipelineElementUserControl
+            // 
+            this.AutoScaleDimensions = new System.Drawing.SizeF(6F, 13F);
+            this.AutoScaleMode = System.Windows.Forms.AutoScaleMode.Font;
+            this.Controls.Add(this.TemplateTxt);
+            this.Controls.Add(this.TemplateLbl);
+            this.Name = "TemplatePipelineElementUserControl";
+            this.Size = new System.Drawing.Size(231, 20);
+            this.ResumeLayout(false);
+            this.PerformLayout();
+
+        }
+
+        #endregion
+
+        private System.Windows.Forms.Label TemplateLbl;
+        private System.Windows.Forms.TextBox TemplateTxt;
+        private System.Windows.Forms.ToolTip TemplateToolTip;
+    }
+}
@@ -73,9 +73,10 @@ namespace PathCopyCopy.Settings.UI.Utils
             Debug.Assert(pipeline != null);
 
             // All elements must be of different types, and pipeline must contain
-            // an ApplyPlugin element.
+            // an ApplyPlugin element. Templates can only be edited in the advanced form.
             return pipeline.Elements.Distinct(new PipelineElementEqualityComparerByClassType()).Count() == pipeline.Elements.Count &&
-                pipeline.Elements.Find(el => el is ApplyPluginPipelineElement) != null;
+                pipeline.Elements.Find(el => el is ApplyPluginPipelineElement) != null &&
+                pipeline.Elements.Find(el => el is TemplatePipelineElement) == null;
         }
 
         /// <summary>
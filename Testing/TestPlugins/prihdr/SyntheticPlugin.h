@@ -0,0 +1,127 @@
+// SyntheticPlugin.h
+// (c) 2011-2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include <PathCopyCopy_i.h>
+
+#include <vector>
+
+
+// Synthetic plugins
+//
+// Configurable plugins used to measure how Path Copy Copy scales with the number
+// of COM plugins. Any number of them can be registered, each with its own CLSID
+// (see SyntheticPluginId). The number of plugins to register and their default
+// parameters are read from environment variables when the module is registered:
+//
+// PCC_TEST_PLUGINS_SYNTHETIC_COUNT: number of plugins to register (default 0).
+// PCC_TEST_PLUGINS_SYNTHETIC_ACTIVATION_MS: delay added when a plugin is created.
+// PCC_TEST_PLUGINS_SYNTHETIC_CALL_MS: delay added to GetPath and Enabled calls.
+// PCC_TEST_PLUGINS_SYNTHETIC_FAILURE_PERCENT: percentage of calls that fail.
+// PCC_TEST_PLUGINS_SYNTHETIC_THREADING: threading model of plugins: Apartment
+//     (default), Free, Both or Mixed (alternates between the three).
+//
+// Parameters are stored in each plugin's CLSID key (see the value names in
+// SyntheticPlugin.cpp) and can be edited afterwards to vary them per plugin.
+
+// Parameters of a synthetic plugin, read from its CLSID key.
+struct SyntheticPluginParams final
+{
+    DWORD               m_Index;                // Index of plugin, used in its CLSID.
+    DWORD               m_ActivationDelayMs;    // Delay when plugin is created, in milliseconds.
+    DWORD               m_CallDelayMs;          // Delay when plugin is called, in milliseconds.
+    DWORD               m_FailurePercent;       // Percentage of calls that return an error.
+};
+
+
+// CSyntheticPlugin
+
+class ATL_NO_VTABLE CSyntheticPlugin :
+    public ATL::CComObjectRootEx<ATL::CComMultiThreadModel>,
+    public IPathCopyCopyPlugin,
+    public IPathCopyCopyPluginStateInfo
+{
+public:
+    CSyntheticPlugin()
+        : m_Params(),
+          m_Calls(0)
+    {
+    }
+
+DECLARE_NOT_AGGREGATABLE(CSyntheticPlugin)
+
+BEGIN_COM_MAP(CSyntheticPlugin)
+    COM_INTERFACE_ENTRY(IPathCopyCopyPlugin)
+    COM_INTERFACE_ENTRY(IPathCopyCopyPluginStateInfo)
+END_COM_MAP()
+
+    DECLARE_PROTECT_FINAL_CONSTRUCT()
+
+    void SetParams(const SyntheticPluginParams& p_Params);
+
+    static CLSID SyntheticPluginId(DWORD p_Index);
+    static HRESULT GetClassObject(REFCLSID p_CLSID, REFIID p_IID, LPVOID* p_ppv);
+    static HRESULT Register(std::vector<CLSID>& p_rvPluginIds);
+    static HRESULT Unregister(std::vector<CLSID>& p_rvPluginIds);
+
+    // IPathCopyCopyPlugin interface
+    STDMETHOD(get_Description)(BSTR *p_ppDescription);
+    STDMETHOD(get_HelpText)(BSTR *p_ppHelpText);
+    STDMETHOD(GetPath)(BSTR p_pPath, BSTR *p_ppNewPath);
+
+    // IPathCopyCopyPluginStateInfo
+    STDMETHOD(Enabled)(BSTR p_pParentPath, BSTR p_pFile, VARIANT_BOOL *p_pEnabled);
+
+private:
+    SyntheticPluginParams m_Params;     // Parameters of this plugin.
+    volatile LONG       m_Calls;        // Number of calls made to this plugin.
+
+    bool SimulateCall();
+};
+
+
+// CSyntheticPluginFactory
+
+class ATL_NO_VTABLE CSyntheticPluginFactory :
+    public ATL::CComObjectRootEx<ATL::CComMultiThreadModel>,
+    public IClassFactory
+{
+public:
+    CSyntheticPluginFactory()
+        : m_Params()
+    {
+    }
+
+BEGIN_COM_MAP(CSyntheticPluginFactory)
+    COM_INTERFACE_ENTRY(IClassFactory)
+END_COM_MAP()
+
+    void SetParams(const SyntheticPluginParams& p_Params);
+
+    // IClassFactory interface
+    STDMETHOD(CreateInstance)(IUnknown* p_pUnkOuter, REFIID p_IID, void** p_ppvObject);
+    STDMETHOD(LockServer)(BOOL p_Lock);
+
+private:
+    SyntheticPluginParams m_Params;     // Parameters of plugins we create.
+};
@@ -29,6 +29,7 @@ public :
     HRESULT DllUnregisterServer(BOOL bUnRegTypeLib = TRUE) throw();
 
     static HINSTANCE HInstance();
+    static void SimulateLatency();
 };
 
 extern class CTestPluginsModule _AtlModule;
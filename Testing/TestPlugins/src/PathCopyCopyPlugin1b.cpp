@@ -22,6 +22,8 @@
 #include "stdafx.h"
 #include "PathCopyCopyPlugin1b.h"
 
+#include <dllmain.h>
+
 
 // CPathCopyCopyPlugin1b
 
@@ -43,6 +45,7 @@ STDMETHODIMP CPathCopyCopyPlugin1b::get_HelpText(BSTR *p_ppHelpText)
 // Method that must return the path, with plugin-specific alteration.
 STDMETHODIMP CPathCopyCopyPlugin1b::GetPath(BSTR p_pPath, BSTR *p_ppNewPath)
 {
+    CTestPluginsModule::SimulateLatency();
     std::wstring newPath(p_pPath);
     newPath += L"1b";
     *p_ppNewPath = ::SysAllocString(newPath.c_str());
@@ -72,6 +75,7 @@ STDMETHODIMP CPathCopyCopyPlugin1b::Enabled(BSTR /*p_pParentPath*/,
                                             BSTR /*p_pFile*/,
                                             VARIANT_BOOL *p_pEnabled)
 {
+    CTestPluginsModule::SimulateLatency();
     *p_pEnabled = VARIANT_TRUE;
     return S_OK;
 }
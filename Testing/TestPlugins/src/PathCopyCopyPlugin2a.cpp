@@ -22,6 +22,8 @@
 #include "stdafx.h"
 #include "PathCopyCopyPlugin2a.h"
 
+#include <dllmain.h>
+
 
 // CPathCopyCopyPlugin2a
 
@@ -43,6 +45,7 @@ STDMETHODIMP CPathCopyCopyPlugin2a::get_HelpText(BSTR *p_ppHelpText)
 // Method that must return the path, with plugin-specific alteration.
 STDMETHODIMP CPathCopyCopyPlugin2a::GetPath(BSTR p_pPath, BSTR *p_ppNewPath)
 {
+    CTestPluginsModule::SimulateLatency();
     std::wstring newPath(p_pPath);
     newPath += L"2a";
     *p_ppNewPath = ::SysAllocString(newPath.c_str());
@@ -72,6 +75,7 @@ STDMETHODIMP CPathCopyCopyPlugin2a::Enabled(BSTR /*p_pParentPath*/,
                                             BSTR /*p_pFile*/,
                                             VARIANT_BOOL *p_pEnabled)
 {
+    CTestPluginsModule::SimulateLatency();
     *p_pEnabled = VARIANT_FALSE;
     return S_OK;
 }
@@ -45,6 +45,7 @@ STDMETHODIMP CPathCopyCopyPlugin2b::get_HelpText(BSTR *p_ppHelpText)
 // Method that must return the path, with plugin-specific alteration.
 STDMETHODIMP CPathCopyCopyPlugin2b::GetPath(BSTR p_pPath, BSTR *p_ppNewPath)
 {
+    CTestPluginsModule::SimulateLatency();
     std::wstring newPath(p_pPath);
     newPath += L"2b";
     *p_ppNewPath = ::SysAllocString(newPath.c_str());
@@ -74,6 +75,7 @@ STDMETHODIMP CPathCopyCopyPlugin2b::Enabled(BSTR /*p_pParentPath*/,
                                             BSTR /*p_pFile*/,
                                             VARIANT_BOOL *p_pEnabled)
 {
+    CTestPluginsModule::SimulateLatency();
     *p_pEnabled = VARIANT_TRUE;
     return S_OK;
 }
@@ -0,0 +1,316 @@
+// SyntheticPlugin.cpp
+// (c) 2011-2019, Charles Lechasseur
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "stdafx.h"
+#include "SyntheticPlugin.h"
+#include "TestPlugins_i.h"
+
+#include <dllmain.h>
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+
+// CLSID of the first synthetic plugin. The index of each plugin is stored
+// in the last two bytes of its CLSID.
+const CLSID BASE_SYNTHETIC_PLUGIN_ID = { 0x3e9c4a70, 0x52d8, 0x4b61, { 0x9a, 0x0f, 0x7c, 0x13, 0xb5, 0xe2, 0x00, 0x00 } };
+
+// Maximum number of synthetic plugins; limited by the bytes in their CLSID.
+const DWORD MAX_SYNTHETIC_PLUGINS = 0x10000;
+
+// Environment variables read when registering synthetic plugins.
+const wchar_t* const COUNT_ENV_VAR_NAME = L"PCC_TEST_PLUGINS_SYNTHETIC_COUNT";
+const wchar_t* const ACTIVATION_DELAY_ENV_VAR_NAME = L"PCC_TEST_PLUGINS_SYNTHETIC_ACTIVATION_MS";
+const wchar_t* const CALL_DELAY_ENV_VAR_NAME = L"PCC_TEST_PLUGINS_SYNTHETIC_CALL_MS";
+const wchar_t* const FAILURE_PERCENT_ENV_VAR_NAME = L"PCC_TEST_PLUGINS_SYNTHETIC_FAILURE_PERCENT";
+const wchar_t* const THREADING_ENV_VAR_NAME = L"PCC_TEST_PLUGINS_SYNTHETIC_THREADING";
+
+// Names of values storing parameters in the CLSID key of synthetic plugins.
+const wchar_t* const INDEX_VALUE_NAME = L"SyntheticPluginIndex";
+const wchar_t* const ACTIVATION_DELAY_VALUE_NAME = L"ActivationDelayMs";
+const wchar_t* const CALL_DELAY_VALUE_NAME = L"CallDelayMs";
+const wchar_t* const FAILURE_PERCENT_VALUE_NAME = L"FailurePercent";
+
+// Threading models that can be used by synthetic plugins.
+const wchar_t* const THREADING_MODELS[] = { L"Apartment", L"Free", L"Both" };
+
+// Special threading model alternating between all THREADING_MODELS.
+const wchar_t* const MIXED_THREADING_MODEL = L"Mixed";
+
+// Reads a number from an environment variable, returning the
+// given default value if the variable does not exist.
+DWORD ReadEnvironmentDWORD(const wchar_t* const p_pName,
+                           const DWORD p_Default)
+{
+    DWORD result = p_Default;
+    wchar_t value[16] = { 0 };
+    const DWORD valueSize = ::GetEnvironmentVariableW(p_pName, value, ARRAYSIZE(value));
+    if (valueSize != 0 && valueSize < ARRAYSIZE(value)) {
+        result = static_cast<DWORD>(std::wcstoul(value, nullptr, 10));
+    }
+    return result;
+}
+
+// Returns the name of the key of a CLSID under HKEY_CLASSES_ROOT\CLSID.
+std::wstring CLSIDKeyName(REFCLSID p_CLSID)
+{
+    wchar_t clsid[64] = { 0 };
+    ::StringFromGUID2(p_CLSID, clsid, ARRAYSIZE(clsid));
+    return clsid;
+}
+
+// Returns the path of the key of a CLSID in HKEY_CLASSES_ROOT.
+std::wstring CLSIDKeyPath(REFCLSID p_CLSID)
+{
+    return L"CLSID\\" + CLSIDKeyName(p_CLSID);
+}
+
+} // anonymous namespace
+
+
+// CSyntheticPlugin
+
+// Sets the parameters of this plugin. Called by our class factory after creating it.
+void CSyntheticPlugin::SetParams(const SyntheticPluginParams& p_Params)
+{
+    m_Params = p_Params;
+}
+
+// Returns the CLSID of the synthetic plugin with the given index.
+CLSID CSyntheticPlugin::SyntheticPluginId(DWORD p_Index)
+{
+    CLSID pluginId = BASE_SYNTHETIC_PLUGIN_ID;
+    pluginId.Data4[6] = static_cast<unsigned char>((p_Index >> 8) & 0xFF);
+    pluginId.Data4[7] = static_cast<unsigned char>(p_Index & 0xFF);
+    return pluginId;
+}
+
+// Returns a class factory for a synthetic plugin. Returns CLASS_E_CLASSNOTAVAILABLE
+// if the CLSID is not that of a registered synthetic plugin.
+HRESULT CSyntheticPlugin::GetClassObject(REFCLSID p_CLSID, REFIID p_IID, LPVOID* p_ppv)
+{
+    if (p_ppv == nullptr) {
+        return E_POINTER;
+    }
+    *p_ppv = nullptr;
+    if (::memcmp(&p_CLSID, &BASE_SYNTHETIC_PLUGIN_ID, sizeof(CLSID) - 2) != 0) {
+        return CLASS_E_CLASSNOTAVAILABLE;
+    }
+
+    // Read plugin parameters from its CLSID key.
+    SyntheticPluginParams params = { 0 };
+    ATL::CRegKey clsidKey;
+    if (clsidKey.Open(HKEY_CLASSES_ROOT, CLSIDKeyPath(p_CLSID).c_str(), KEY_QUERY_VALUE) != ERROR_SUCCESS ||
+        clsidKey.QueryDWORDValue(INDEX_VALUE_NAME, params.m_Index) != ERROR_SUCCESS) {
+
+        return CLASS_E_CLASSNOTAVAILABLE;
+    }
+    clsidKey.QueryDWORDValue(ACTIVATION_DELAY_VALUE_NAME, params.m_ActivationDelayMs);
+    clsidKey.QueryDWORDValue(CALL_DELAY_VALUE_NAME, params.m_CallDelayMs);
+    clsidKey.QueryDWORDValue(FAILURE_PERCENT_VALUE_NAME, params.m_FailurePercent);
+
+    ATL::CComObject<CSyntheticPluginFactory>* pFactory = nullptr;
+    HRESULT hRes = ATL::CComObject<CSyntheticPluginFactory>::CreateInstance(&pFactory);
+    if (SUCCEEDED(hRes)) {
+        ATL::CComPtr<IUnknown> cpFactory(pFactory->GetUnknown());
+        pFactory->SetParams(params);
+        hRes = cpFactory->QueryInterface(p_IID, p_ppv);
+    }
+    return hRes;
+}
+
+// Registers the synthetic plugins specified in the PCC_TEST_PLUGINS_SYNTHETIC_*
+// environment variables as COM objects and returns their CLSIDs. They must
+// still be registered with Path Copy Copy afterwards.
+HRESULT CSyntheticPlugin::Register(std::vector<CLSID>& p_rvPluginIds)
+{
+    p_rvPluginIds.clear();
+    const DWORD count = (std::min)(ReadEnvironmentDWORD(COUNT_ENV_VAR_NAME, 0), MAX_SYNTHETIC_PLUGINS);
+    if (count == 0) {
+        return S_OK;
+    }
+
+    const DWORD activationDelayMs = ReadEnvironmentDWORD(ACTIVATION_DELAY_ENV_VAR_NAME, 0);
+    const DWORD callDelayMs = ReadEnvironmentDWORD(CALL_DELAY_ENV_VAR_NAME, 0);
+    const DWORD failurePercent = (std::min)(ReadEnvironmentDWORD(FAILURE_PERCENT_ENV_VAR_NAME, 0), static_cast<DWORD>(100));
+    wchar_t threading[16] = { 0 };
+    const DWORD threadingSize = ::GetEnvironmentVariableW(THREADING_ENV_VAR_NAME, threading, ARRAYSIZE(threading));
+    if (threadingSize == 0 || threadingSize >= ARRAYSIZE(threading)) {
+        ::wcscpy_s(threading, THREADING_MODELS[0]);
+    }
+    const bool mixedThreading = _wcsicmp(threading, MIXED_THREADING_MODEL) == 0;
+
+    wchar_t modulePath[MAX_PATH + 1] = { 0 };
+    if (::GetModuleFileNameW(CTestPluginsModule::HInstance(), modulePath, ARRAYSIZE(modulePath)) == 0) {
+        return HRESULT_FROM_WIN32(::GetLastError());
+    }
+
+    HRESULT hRes = S_OK;
+    p_rvPluginIds.reserve(count);
+    for (DWORD i = 0; SUCCEEDED(hRes) && i < count; ++i) {
+        const CLSID pluginId = SyntheticPluginId(i);
+        const std::wstring description = L"PathCopyCopySyntheticPlugin" + std::to_wstring(i) + L" Class";
+        const wchar_t* const pThreadingModel = mixedThreading ? THREADING_MODELS[i % ARRAYSIZE(THREADING_MODELS)] : threading;
+
+        ATL::CRegKey clsidKey, serverKey;
+        LONG res = clsidKey.Create(HKEY_CLASSES_ROOT, CLSIDKeyPath(pluginId).c_str());
+        if (res == ERROR_SUCCESS) {
+            clsidKey.SetStringValue(nullptr, description.c_str());
+            clsidKey.SetDWORDValue(INDEX_VALUE_NAME, i);
+            clsidKey.SetDWORDValue(ACTIVATION_DELAY_VALUE_NAME, activationDelayMs);
+            clsidKey.SetDWORDValue(CALL_DELAY_VALUE_NAME, callDelayMs);
+            clsidKey.SetDWORDValue(FAILURE_PERCENT_VALUE_NAME, failurePercent);
+            res = serverKey.Create(clsidKey, L"InprocServer32");
+        }
+        if (res == ERROR_SUCCESS) {
+            serverKey.SetStringValue(nullptr, modulePath);
+            res = serverKey.SetStringValue(L"ThreadingModel", pThreadingModel);
+        }
+        if (res == ERROR_SUCCESS) {
+            p_rvPluginIds.push_back(pluginId);
+        } else {
+            hRes = HRESULT_FROM_WIN32(res);
+        }
+    }
+    return hRes;
+}
+
+// Removes the COM registration of all synthetic plugins that have been registered
+// and returns their CLSIDs. They must still be unregistered from Path Copy Copy.
+HRESULT CSyntheticPlugin::Unregister(std::vector<CLSID>& p_rvPluginIds)
+{
+    p_rvPluginIds.clear();
+    ATL::CRegKey clsidsKey;
+    LONG res = clsidsKey.Open(HKEY_CLASSES_ROOT, L"CLSID", KEY_READ | KEY_WRITE);
+    for (DWORD i = 0; res == ERROR_SUCCESS && i < MAX_SYNTHETIC_PLUGINS; ++i) {
+        const CLSID pluginId = SyntheticPluginId(i);
+        const std::wstring clsidKeyName = CLSIDKeyName(pluginId);
+        ATL::CRegKey clsidKey;
+        if (clsidKey.Open(clsidsKey, clsidKeyName.c_str(), KEY_READ) != ERROR_SUCCESS) {
+            // Plugins are registered with consecutive indexes, so we're done.
+            break;
+        }
+        clsidKey.Close();
+        res = clsidsKey.RecurseDeleteKey(clsidKeyName.c_str());
+        if (res == ERROR_SUCCESS) {
+            p_rvPluginIds.push_back(pluginId);
+        }
+    }
+    return HRESULT_FROM_WIN32(res);
+}
+
+// Sleeps for the plugin's call delay, then determines whether the call should fail
+// according to the plugin's failure rate. Failures are spread evenly between calls.
+bool CSyntheticPlugin::SimulateCall()
+{
+    if (m_Params.m_CallDelayMs != 0) {
+        ::Sleep(m_Params.m_CallDelayMs);
+    }
+    const ULONGLONG call = static_cast<ULONGLONG>(::InterlockedIncrement(&m_Calls));
+    return (call * m_Params.m_FailurePercent) % 100 >= m_Params.m_FailurePercent;
+}
+
+// Method that must return the plugin description, displayed in the contextual menu.
+STDMETHODIMP CSyntheticPlugin::get_Description(BSTR *p_ppDescription)
+{
+    const std::wstring description = L"PCC Synthetic Plugin " + std::to_wstring(m_Params.m_Index);
+    *p_ppDescription = ::SysAllocString(description.c_str());
+    return S_OK;
+}
+
+// Method that can return a help text to be displayed in the status bar when the cursor is over the plugin's menu item.
+// It is legal to return NULL or an empty string if no help text can be provided.
+STDMETHODIMP CSyntheticPlugin::get_HelpText(BSTR *p_ppHelpText)
+{
+    *p_ppHelpText = ::SysAllocString(L"Path Copy Copy synthetic test plugin. Will return the path, appended with the plugin index.");
+    return S_OK;
+}
+
+// Method that must return the path, with plugin-specific alteration.
+STDMETHODIMP CSyntheticPlugin::GetPath(BSTR p_pPath, BSTR *p_ppNewPath)
+{
+    if (!SimulateCall()) {
+        return E_FAIL;
+    }
+    std::wstring newPath(p_pPath);
+    newPath += L"#" + std::to_wstring(m_Params.m_Index);
+    *p_ppNewPath = ::SysAllocString(newPath.c_str());
+    return S_OK;
+}
+
+// Method that determines whether the plugin should be enabled in the contextual menu.
+// The method must return VARIANT_TRUE otherwise it will be grayed out.
+STDMETHODIMP CSyntheticPlugin::Enabled(BSTR /*p_pParentPath*/,
+                                       BSTR /*p_pFile*/,
+                                       VARIANT_BOOL *p_pEnabled)
+{
+    if (!SimulateCall()) {
+        return E_FAIL;
+    }
+    *p_pEnabled = VARIANT_TRUE;
+    return S_OK;
+}
+
+
+// CSyntheticPluginFactory
+
+// Sets the parameters of plugins created by this factory.
+void CSyntheticPluginFactory::SetParams(const SyntheticPluginParams& p_Params)
+{
+    m_Params = p_Params;
+}
+
+// Creates a synthetic plugin, after sleeping for its activation delay.
+STDMETHODIMP CSyntheticPluginFactory::CreateInstance(IUnknown* p_pUnkOuter, REFIID p_IID, void** p_ppvObject)
+{
+    if (p_ppvObject == nullptr) {
+        return E_POINTER;
+    }
+    *p_ppvObject = nullptr;
+    if (p_pUnkOuter != nullptr) {
+        return CLASS_E_NOAGGREGATION;
+    }
+
+    if (m_Params.m_ActivationDelayMs != 0) {
+        ::Sleep(m_Params.m_ActivationDelayMs);
+    }
+    ATL::CComObject<CSyntheticPlugin>* pPlugin = nullptr;
+    HRESULT hRes = ATL::CComObject<CSyntheticPlugin>::CreateInstance(&pPlugin);
+    if (SUCCEEDED(hRes)) {
+        ATL::CComPtr<IUnknown> cpPlugin(pPlugin->GetUnknown());
+        pPlugin->SetParams(m_Params);
+        hRes = cpPlugin->QueryInterface(p_IID, p_ppvObject);
+    }
+    return hRes;
+}
+
+// Locks or unlocks our module in memory.
+STDMETHODIMP CSyntheticPluginFactory::LockServer(BOOL p_Lock)
+{
+    if (p_Lock) {
+        _pAtlModule->Lock();
+    } else {
+        _pAtlModule->Unlock();
+    }
+    return S_OK;
+}
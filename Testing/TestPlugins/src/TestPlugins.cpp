@@ -24,6 +24,7 @@
 #include "TestPlugins_i.h"
 #include "dllmain.h"
 #include "dlldatax.h"
+#include "SyntheticPlugin.h"
 
 // Used to determine whether the DLL can be unloaded by OLE
 STDAPI DllCanUnloadNow(void)
@@ -44,7 +45,10 @@ STDAPI DllGetClassObject(REFCLSID rclsid, REFIID riid, LPVOID* ppv)
     if (PrxDllGetClassObject(rclsid, riid, ppv) == S_OK)
         return S_OK;
 #endif
-    return _AtlModule.DllGetClassObject(rclsid, riid, ppv);
+    HRESULT hr = _AtlModule.DllGetClassObject(rclsid, riid, ppv);
+    if (hr == CLASS_E_CLASSNOTAVAILABLE)
+        hr = CSyntheticPlugin::GetClassObject(rclsid, riid, ppv);
+    return hr;
 }
 
 
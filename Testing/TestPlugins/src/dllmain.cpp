@@ -25,14 +25,21 @@
 #include <PathCopyCopy_i.h>
 #include "dllmain.h"
 #include "dlldatax.h"
+#include "SyntheticPlugin.h"
 
 #include <StAtlPerUserOverride.h>
 
+#include <cstdlib>
+
 namespace {
 
 // Keeps the global instance passed to DllMain.
 HINSTANCE g_hInstance = NULL;
 
+// Environment variable that can contain a delay, in milliseconds, to add
+// to plugin calls. Used to measure the impact of slow plugins on PCC.
+const wchar_t* const DELAY_ENV_VAR_NAME = L"PCC_TEST_PLUGINS_DELAY_MS";
+
 } // anonymous namespace
 
 CTestPluginsModule _AtlModule;
@@ -54,8 +61,12 @@ HRESULT CTestPluginsModule::DllRegisterServer(BOOL bRegTypeLib /*= TRUE*/) throw
             hRes = E_NOTIMPL;
         }
         if (SUCCEEDED(hRes)) {
-            // First perform DLL registration.
+            // First perform DLL registration, including synthetic plugins if requested.
+            std::vector<CLSID> vSyntheticPluginIds;
             hRes = ATL::CAtlDllModuleT<CTestPluginsModule>::DllRegisterServer(bRegTypeLib);
+            if (SUCCEEDED(hRes)) {
+                hRes = CSyntheticPlugin::Register(vSyntheticPluginIds);
+            }
             if (SUCCEEDED(hRes)) {
                 // Perform per-user registration if available, otherwise fall back to
                 // the default interface. We'll have verified that this is OK before.
@@ -70,6 +81,9 @@ HRESULT CTestPluginsModule::DllRegisterServer(BOOL bRegTypeLib /*= TRUE*/) throw
                     registerPlugin(__uuidof(PathCopyCopyPlugin1b));
                     registerPlugin(__uuidof(PathCopyCopyPlugin2a));
                     registerPlugin(__uuidof(PathCopyCopyPlugin2b));
+                    for (const CLSID& syntheticPluginId : vSyntheticPluginIds) {
+                        registerPlugin(syntheticPluginId);
+                    }
                 } else {
                     auto registerPlugin = [&](REFCLSID p_CLSID) {
                         if (SUCCEEDED(hRes)) {
@@ -80,6 +94,9 @@ HRESULT CTestPluginsModule::DllRegisterServer(BOOL bRegTypeLib /*= TRUE*/) throw
                     registerPlugin(__uuidof(PathCopyCopyPlugin1b));
                     registerPlugin(__uuidof(PathCopyCopyPlugin2a));
                     registerPlugin(__uuidof(PathCopyCopyPlugin2b));
+                    for (const CLSID& syntheticPluginId : vSyntheticPluginIds) {
+                        registerPlugin(syntheticPluginId);
+                    }
                 }
             }
         }
@@ -94,8 +111,12 @@ HRESULT CTestPluginsModule::DllUnregisterServer(BOOL bUnRegTypeLib /*= TRUE*/) t
     StAtlPerUserOverride perUserOverride;
     HRESULT hRes = perUserOverride.Succeeded() ? S_OK : E_FAIL;
     if (SUCCEEDED(hRes)) {
-        // First perform DLL unregistration.
+        // First perform DLL unregistration, including synthetic plugins if any.
+        std::vector<CLSID> vSyntheticPluginIds;
         hRes = ATL::CAtlDllModuleT<CTestPluginsModule>::DllUnregisterServer(bUnRegTypeLib);
+        if (SUCCEEDED(hRes)) {
+            hRes = CSyntheticPlugin::Unregister(vSyntheticPluginIds);
+        }
         if (SUCCEEDED(hRes)) {
             // Create PathCopyCopy registration object and check if it supports per-user uninstall.
             ATL::CComPtr<IPathCopyCopyContextMenuExt> cpPccExt;
@@ -121,6 +142,9 @@ HRESULT CTestPluginsModule::DllUnregisterServer(BOOL bUnRegTypeLib /*= TRUE*/) t
                         unregisterPlugin(__uuidof(PathCopyCopyPlugin1b));
                         unregisterPlugin(__uuidof(PathCopyCopyPlugin2a));
                         unregisterPlugin(__uuidof(PathCopyCopyPlugin2b));
+                        for (const CLSID& syntheticPluginId : vSyntheticPluginIds) {
+                            unregisterPlugin(syntheticPluginId);
+                        }
                     } else {
                         auto unregisterPlugin = [&](REFCLSID p_CLSID) {
                             if (SUCCEEDED(hRes)) {
@@ -131,6 +155,9 @@ HRESULT CTestPluginsModule::DllUnregisterServer(BOOL bUnRegTypeLib /*= TRUE*/) t
                         unregisterPlugin(__uuidof(PathCopyCopyPlugin1b));
                         unregisterPlugin(__uuidof(PathCopyCopyPlugin2a));
                         unregisterPlugin(__uuidof(PathCopyCopyPlugin2b));
+                        for (const CLSID& syntheticPluginId : vSyntheticPluginIds) {
+                            unregisterPlugin(syntheticPluginId);
+                        }
                     }
                 }
             }
@@ -145,6 +172,22 @@ HINSTANCE CTestPluginsModule::HInstance()
     return g_hInstance;
 }
 
+// Sleeps for the delay specified in the PCC_TEST_PLUGINS_DELAY_MS
+// environment variable, if any. Called by our plugins to simulate slow
+// plugins; since the variable is inherited, this also works when plugins
+// are run in the COM plugin executor.
+void CTestPluginsModule::SimulateLatency()
+{
+    wchar_t delay[16] = { 0 };
+    const DWORD delaySize = ::GetEnvironmentVariableW(DELAY_ENV_VAR_NAME, delay, ARRAYSIZE(delay));
+    if (delaySize != 0 && delaySize < ARRAYSIZE(delay)) {
+        const DWORD delayMs = static_cast<DWORD>(std::wcstoul(delay, nullptr, 10));
+        if (delayMs != 0) {
+            ::Sleep(delayMs);
+        }
+    }
+}
+
 // DLL Entry Point
 extern "C" BOOL WINAPI DllMain(HINSTANCE hInstance, DWORD dwReason, LPVOID lpReserved)
 {